@@ -4,11 +4,19 @@
 
 #include "base/message_loop/message_pump_epoll.h"
 
+#include <errno.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <utility>
 
@@ -24,6 +32,7 @@
 #include "base/threading/thread_checker.h"
 #include "base/time/time.h"
 #include "base/trace_event/base_tracing.h"
+#include "build/build_config.h"
 
 namespace base {
 
@@ -35,6 +44,46 @@ BASE_FEATURE(kBatchNativeEventsInMessagePumpEpoll,
 
 // Caches the state of the "BatchNativeEventsInMessagePumpEpoll".
 std::atomic_bool g_use_batched_version = false;
+
+// See MessagePumpEpoll::SetBusyPollDuration().
+std::atomic<int64_t> g_busy_poll_microseconds = 0;
+
+// See MessagePumpEpoll::GetWakeUpCount().
+std::atomic<uint64_t> g_wake_up_count = 0;
+
+#if BUILDFLAG(IS_LINUX) && defined(__NR_epoll_pwait2)
+// Cleared once epoll_pwait2() turns out to be missing, before Linux 5.11, or
+// filtered out by seccomp.
+std::atomic_bool g_has_epoll_pwait2 = true;
+#endif
+
+// Waits like epoll_wait() for up to `timeout`, with microsecond resolution
+// where epoll_pwait2() is available, so delayed tasks such as QUIC pacing
+// alarms run on time instead of up to a millisecond late.
+int EpollWait(int epoll_fd,
+              epoll_event* events,
+              int max_events,
+              TimeDelta timeout) {
+#if BUILDFLAG(IS_LINUX) && defined(__NR_epoll_pwait2)
+  if (timeout.is_positive() && !timeout.is_max() &&
+      g_has_epoll_pwait2.load(std::memory_order_relaxed)) {
+    const struct timespec ts = timeout.ToTimeSpec();
+    int rv = static_cast<int>(syscall(__NR_epoll_pwait2, epoll_fd, events,
+                                      max_events, &ts, nullptr, 0));
+    if (rv >= 0 || (errno != ENOSYS && errno != EPERM)) {
+      return rv;
+    }
+    g_has_epoll_pwait2.store(false, std::memory_order_relaxed);
+  }
+#endif
+
+  // Otherwise `timeout` is rounded up to the integral milliseconds that
+  // epoll_wait() takes.
+  const int epoll_timeout =
+      timeout.is_max() ? -1
+                       : saturated_cast<int>(timeout.InMillisecondsRoundedUp());
+  return epoll_wait(epoll_fd, events, max_events, epoll_timeout);
+}
 }  // namespace
 
 MessagePumpEpoll::MessagePumpEpoll() {
@@ -58,6 +107,17 @@ void MessagePumpEpoll::InitializeFeatures() {
       std::memory_order_relaxed);
 }
 
+// static
+void MessagePumpEpoll::SetBusyPollDuration(TimeDelta duration) {
+  g_busy_poll_microseconds.store(duration.InMicroseconds(),
+                                 std::memory_order_relaxed);
+}
+
+// static
+uint64_t MessagePumpEpoll::GetWakeUpCount() {
+  return g_wake_up_count.load(std::memory_order_relaxed);
+}
+
 bool MessagePumpEpoll::WatchFileDescriptor(int fd,
                                            bool persistent,
                                            int mode,
@@ -70,13 +130,22 @@ bool MessagePumpEpoll::WatchFileDescriptor(int fd,
 
   const InterestParams params{
       .fd = fd,
-      .read = (mode == WATCH_READ || mode == WATCH_READ_WRITE),
-      .write = (mode == WATCH_WRITE || mode == WATCH_READ_WRITE),
+      .read = (mode & WATCH_READ) != 0,
+      .write = (mode & WATCH_WRITE) != 0,
       .one_shot = !persistent,
+      .edge_triggered = !persistent && (mode & WATCH_EDGE_TRIGGERED) != 0,
   };
 
-  auto [it, is_new_fd_entry] = entries_.emplace(fd, fd);
-  EpollEventEntry& entry = it->second;
+  DCHECK_GE(fd, 0);
+  const size_t index = checked_cast<size_t>(fd);
+  if (index >= entries_.size()) {
+    entries_.resize(index + 1);
+  }
+  const bool is_new_fd_entry = !entries_[index];
+  if (is_new_fd_entry) {
+    entries_[index] = std::make_unique<EpollEventEntry>(fd);
+  }
+  EpollEventEntry& entry = *entries_[index];
   scoped_refptr<Interest> existing_interest = controller->epoll_interest();
   if (existing_interest && existing_interest->params().IsEqual(params)) {
     // WatchFileDescriptor() has already been called for this controller at
@@ -157,7 +226,16 @@ void MessagePumpEpoll::Run(Delegate* delegate) {
       timeout = next_work_info.remaining_delay();
     }
     delegate->BeforeWait();
+    if (BusyPollForEpollEvents(timeout)) {
+      if (run_state.should_quit) {
+        break;
+      }
+      continue;
+    }
     WaitForEpollEvents(timeout);
+    if (timeout.is_positive()) {
+      g_wake_up_count.fetch_add(1, std::memory_order_relaxed);
+    }
     if (run_state.should_quit) {
       break;
     }
@@ -226,11 +304,10 @@ void MessagePumpEpoll::UnregisterInterest(
     const scoped_refptr<Interest>& interest) {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
 
-  const int fd = interest->params().fd;
-  auto entry_it = entries_.find(fd);
-  CHECK(entry_it != entries_.end(), base::NotFatalUntil::M125);
+  const size_t index = checked_cast<size_t>(interest->params().fd);
+  CHECK(index < entries_.size() && entries_[index], base::NotFatalUntil::M125);
 
-  EpollEventEntry& entry = entry_it->second;
+  EpollEventEntry& entry = *entries_[index];
   auto& interests = entry.interests;
   auto* it = ranges::find(interests, interest);
   CHECK(it != interests.end(), base::NotFatalUntil::M125);
@@ -238,35 +315,68 @@ void MessagePumpEpoll::UnregisterInterest(
 
   if (interests.empty()) {
     StopEpollEvent(entry);
-    entries_.erase(entry_it);
+    entries_[index].reset();
   } else {
     UpdateEpollEvent(entry);
   }
 }
 
+bool MessagePumpEpoll::BusyPollForEpollEvents(TimeDelta& timeout) {
+  const TimeDelta duration = std::min(
+      Microseconds(g_busy_poll_microseconds.load(std::memory_order_relaxed)),
+      timeout);
+  if (!duration.is_positive()) {
+    return false;
+  }
+
+  const TimeTicks start = TimeTicks::Now();
+  const TimeTicks end = start + duration;
+  TimeTicks now = start;
+  do {
+    if (WaitForEpollEvents(TimeDelta())) {
+      // These events skipped the wakeup latency of a sleeping wait. Records
+      // how long they took to come, for tuning the duration.
+      UMA_HISTOGRAM_CUSTOM_MICROSECONDS_TIMES(
+          "MessagePumpEpoll.BusyPollTimeToEvent", TimeTicks::Now() - start,
+          Microseconds(1), Milliseconds(10), 50);
+      return true;
+    }
+    now = TimeTicks::Now();
+  } while (now < end);
+
+  if (!timeout.is_max()) {
+    timeout = std::max(timeout - (now - start), TimeDelta());
+  }
+  return false;
+}
+
 bool MessagePumpEpoll::WaitForEpollEvents(TimeDelta timeout) {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
 
-  // `timeout` has microsecond resolution, but timeouts accepted by epoll_wait()
-  // are integral milliseconds. Round up to the next millisecond.
-  // TODO(crbug.com/40245876): Consider higher-resolution timeouts.
-  const int epoll_timeout =
-      timeout.is_max() ? -1
-                       : saturated_cast<int>(timeout.InMillisecondsRoundedUp());
-  epoll_event events[16];
+  // On the stack, as nested run loops wait while the events of the outer one
+  // are being dispatched. Sized for the largest batch and left uninitialized,
+  // so no wait allocates or clears memory, however large the batch.
+  std::array<epoll_event, kMaxEventBatchSize> events;
   const int epoll_result =
-      epoll_wait(epoll_.get(), events, std::size(events), epoll_timeout);
+      EpollWait(epoll_.get(), events.data(),
+                checked_cast<int>(event_batch_size_), timeout);
   if (epoll_result < 0) {
     DPCHECK(errno == EINTR);
     return false;
   }
 
-  if (epoll_result == 0) {
+  const size_t num_ready = checked_cast<size_t>(epoll_result);
+  if (num_ready == event_batch_size_) {
+    event_batch_size_ = std::min(event_batch_size_ * 2, kMaxEventBatchSize);
+  } else if (num_ready < event_batch_size_ / 4) {
+    event_batch_size_ = std::max(event_batch_size_ / 2, kMinEventBatchSize);
+  }
+
+  if (num_ready == 0) {
     return false;
   }
 
-  const span<epoll_event> ready_events =
-      span(events).first(base::checked_cast<size_t>(epoll_result));
+  const span<epoll_event> ready_events = span(events).first(num_ready);
   for (auto& e : ready_events) {
     if (e.data.ptr == &wake_event_) {
       // Wake-up events are always safe to handle immediately. Unlike other
@@ -311,6 +421,10 @@ void MessagePumpEpoll::OnEpollEvent(EpollEventEntry& entry, uint32_t events) {
   const bool disconnected = (events & (EPOLLHUP | EPOLLERR)) != 0;
   DCHECK(readable || writable || disconnected);
 
+  // `entry` may be destroyed by the event handlers.
+  const int fd = entry.fd;
+  bool update_after_handlers = false;
+
   // Copy the set of Interests, since interests may be added to or removed from
   // `entry` during the loop below. This copy is inexpensive in practice
   // because the size of this vector is expected to be very small (<= 2).
@@ -343,20 +457,34 @@ void MessagePumpEpoll::OnEpollEvent(EpollEventEntry& entry, uint32_t events) {
     if (interest->params().one_shot) {
       // This is a one-shot event watch which is about to be triggered. We
       // deactivate the interest and update epoll immediately. The event handler
-      // may reactivate it.
+      // may reactivate it. Edge-triggered handlers usually do so before they
+      // return, so their registration is updated once after all of them.
       interest->set_active(false);
-      UpdateEpollEvent(entry);
+      if (interest->params().edge_triggered) {
+        update_after_handlers = true;
+      } else {
+        UpdateEpollEvent(entry);
+      }
     }
 
     if (!interest->was_controller_destroyed()) {
-      HandleEvent(entry.fd, can_read, can_write, interest->controller());
+      HandleEvent(fd, can_read, can_write, interest->controller());
       event_handled = true;
     }
   }
 
+  if (update_after_handlers) {
+    const size_t index = checked_cast<size_t>(fd);
+    if (index < entries_.size() && entries_[index]) {
+      UpdateEpollEvent(*entries_[index]);
+    }
+  }
+
   // Stop `EpollEventEntry` for disconnected file descriptor without active
-  // interests.
-  if (disconnected && !event_handled) {
+  // interests. Edge-triggered entries do not report it again until something
+  // changes, and may be waited on again for errors queued on the socket.
+  if (disconnected && !event_handled &&
+      !(entry.registered_events & EPOLLET)) {
     StopEpollEvent(entry);
   }
 
@@ -436,6 +564,21 @@ MessagePumpEpoll::EpollEventEntry::~EpollEventEntry() {
 }
 
 uint32_t MessagePumpEpoll::EpollEventEntry::ComputeActiveEvents() {
+  // Active or not, edge-triggered interests only get the edges that happen
+  // while they are active, so writes stay registered. Reads are registered
+  // only while one is awaited, so that data left unread for a while, as when
+  // a tunnel waits for its other side, does not wake the thread up.
+  if (!interests.empty() &&
+      ranges::all_of(interests, [](const scoped_refptr<Interest>& interest) {
+        return interest->params().edge_triggered;
+      })) {
+    const bool read =
+        ranges::any_of(interests, [](const scoped_refptr<Interest>& interest) {
+          return interest->active() && interest->params().read;
+        });
+    return (read ? EPOLLIN : 0) | EPOLLOUT | EPOLLET;
+  }
+
   uint32_t events = 0;
   bool one_shot = true;
   for (const auto& interest : interests) {
@@ -7,8 +7,10 @@
 
 #include <sys/epoll.h>
 
+#include <cstddef>
 #include <cstdint>
-#include <map>
+#include <memory>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/files/scoped_file.h"
@@ -43,6 +45,16 @@ class BASE_EXPORT MessagePumpEpoll : public MessagePump,
   // Initializes features for this class. See `base::features::Init()`.
   static void InitializeFeatures();
 
+  // Makes Run() of all pumps poll for events without sleeping for up to
+  // `duration` before each wait that would sleep, so events arriving then are
+  // handled without the latency of a wakeup, at the cost of the CPU time spent
+  // polling. Zero, the default, disables it.
+  static void SetBusyPollDuration(TimeDelta duration);
+
+  // Returns how many times Run() of all pumps woke up from a wait that
+  // slept, for an event or a delayed task, since the process started.
+  static uint64_t GetWakeUpCount();
+
   bool WatchFileDescriptor(int fd,
                            bool persistent,
                            int mode,
@@ -60,6 +72,9 @@ class BASE_EXPORT MessagePumpEpoll : public MessagePump,
   friend class MessagePumpLibevent;
   friend class MessagePumpLibeventTest;
 
+  static constexpr size_t kMinEventBatchSize = 16;
+  static constexpr size_t kMaxEventBatchSize = 512;
+
   // The WatchFileDescriptor API supports multiple FdWatchControllers watching
   // the same file descriptor, potentially for different events; but the epoll
   // API only supports a single interest list entry per unique file descriptor.
@@ -84,6 +99,9 @@ class BASE_EXPORT MessagePumpEpoll : public MessagePump,
     //   - EPOLLIN is set if any active Interest wants to `read`.
     //   - EPOLLOUT is set if any active Interest wants to `write`.
     //   - EPOLLONESHOT is set if all active Interests are one-shot.
+    // Unless all Interests, active or not, are edge-triggered, in which case
+    // it is EPOLLOUT | EPOLLET, plus EPOLLIN if any active Interest wants to
+    // `read`.
     uint32_t ComputeActiveEvents();
 
     // The file descriptor to which this entry pertains.
@@ -129,6 +147,10 @@ class BASE_EXPORT MessagePumpEpoll : public MessagePump,
   void StopEpollEvent(EpollEventEntry& entry);
   void UnregisterInterest(const scoped_refptr<Interest>& interest);
   bool WaitForEpollEvents(TimeDelta timeout);
+  // Polls for events without sleeping for up to the busy poll duration, but
+  // not longer than `timeout`. Returns whether there were events. Otherwise
+  // `timeout` is reduced by the time spent polling.
+  bool BusyPollForEpollEvents(TimeDelta& timeout);
   void OnEpollEvent(EpollEventEntry& entry, uint32_t events);
   void HandleEvent(int fd,
                    bool can_read,
@@ -146,11 +168,18 @@ class BASE_EXPORT MessagePumpEpoll : public MessagePump,
   // `DoWork()` call. See crbug.com/1500295.
   bool native_work_started_ = false;
 
-  // Mapping of all file descriptors currently watched by this message pump.
-  // std::map was chosen because (1) the number of elements can vary widely,
-  // (2) we don't do frequent lookups, and (3) values need stable addresses
-  // across insertion or removal of other elements.
-  std::map<int, EpollEventEntry> entries_;
+  // All file descriptors currently watched by this message pump, indexed by
+  // descriptor. The kernel hands out the lowest free descriptors, so the table
+  // stays about as large as the number of open descriptors, while lookups on
+  // every watch and unwatch take constant time with tens of thousands of
+  // sockets. Entries are allocated separately because epoll keeps their
+  // addresses, which must stay stable as the table grows.
+  std::vector<std::unique_ptr<EpollEventEntry>> entries_;
+
+  // The number of events WaitForEpollEvents() asks epoll_wait() for. Doubled
+  // when a wait fills it, up to kMaxEventBatchSize, so a busy pump takes fewer
+  // waits, and halved when a wait uses less than a quarter of it.
+  size_t event_batch_size_ = kMinEventBatchSize;
 
   // The epoll instance used by this message pump to monitor file descriptors.
   ScopedFD epoll_;
@@ -334,14 +334,7 @@ bool MessagePumpKqueue::WatchFileDescriptor(int fd,
     events.push_back(base_event);
   }
 
-  int rv = HANDLE_EINTR(kevent64(kqueue_.get(), events.data(),
-                                 checked_cast<int>(events.size()), nullptr, 0,
-                                 0, nullptr));
-  if (rv < 0) {
-    DPLOG(ERROR) << "WatchFileDescriptor kevent64";
-    return false;
-  }
-
+  pending_changes_.insert(pending_changes_.end(), events.begin(), events.end());
   event_count_ += events.size();
   controller->Init(weak_factory_.GetWeakPtr(), fd, mode, delegate);
 
@@ -426,10 +419,7 @@ bool MessagePumpKqueue::StopWatchingFileDescriptor(
     events.push_back(base_event);
   }
 
-  int rv = HANDLE_EINTR(kevent64(kqueue_.get(), events.data(),
-                                 checked_cast<int>(events.size()), nullptr, 0,
-                                 0, nullptr));
-  DPLOG_IF(ERROR, rv < 0) << "StopWatchingFileDescriptor kevent64";
+  pending_changes_.insert(pending_changes_.end(), events.begin(), events.end());
 
   // The keys for the IDMap aren't recorded anywhere (they're attached to the
   // kevent object in the kernel), so locate the entries by controller pointer.
@@ -442,15 +432,11 @@ bool MessagePumpKqueue::StopWatchingFileDescriptor(
 
   event_count_ -= events.size();
 
-  return rv >= 0;
+  return true;
 }
 
 bool MessagePumpKqueue::DoInternalWork(Delegate* delegate,
                                        Delegate::NextWorkInfo* next_work_info) {
-  if (events_.size() < event_count_) {
-    events_.resize(event_count_);
-  }
-
   bool immediate = next_work_info == nullptr;
   unsigned int flags = immediate ? KEVENT_FLAG_IMMEDIATE : 0;
 
@@ -461,9 +447,22 @@ bool MessagePumpKqueue::DoInternalWork(Delegate* delegate,
     delegate->BeforeWait();
   }
 
-  int rv =
-      HANDLE_EINTR(kevent64(kqueue_.get(), nullptr, 0, events_.data(),
-                            checked_cast<int>(events_.size()), flags, nullptr));
+  // The changes that fail come back as events, so there must be room for
+  // them too.
+  if (events_.size() < event_count_ + pending_changes_.size()) {
+    events_.resize(event_count_ + pending_changes_.size());
+  }
+
+  int rv = kevent64(kqueue_.get(), pending_changes_.data(),
+                    checked_cast<int>(pending_changes_.size()), events_.data(),
+                    checked_cast<int>(events_.size()), flags, nullptr);
+  // The changes are applied before the wait, so a wait interrupted by a
+  // signal is retried without them.
+  while (rv < 0 && errno == EINTR) {
+    rv = kevent64(kqueue_.get(), nullptr, 0, events_.data(),
+                  checked_cast<int>(events_.size()), flags, nullptr);
+  }
+  pending_changes_.clear();
   if (rv == 0) {
     // No events to dispatch so no need to call ProcessEvents().
     return false;
@@ -479,6 +478,35 @@ bool MessagePumpKqueue::ProcessEvents(Delegate* delegate, size_t count) {
   delegate->BeginNativeWorkBeforeDoWork();
   for (size_t i = 0; i < count; ++i) {
     auto* event = &events_[i];
+    if (event->flags & EV_ERROR) {
+      // A change of pending_changes_ that failed. Deleting a watch fails
+      // harmlessly when its descriptor was closed first.
+      if (event->flags & EV_DELETE)
+        continue;
+      CHECK(event->filter == EVFILT_READ || event->filter == EVFILT_WRITE)
+          << "kevent64, set timer: "
+          << logging::SystemErrorCodeToString(
+                 static_cast<logging::SystemErrorCode>(event->data));
+      FdWatchController* controller = fd_controllers_.Lookup(event->udata);
+      if (!controller)
+        continue;
+      DLOG(ERROR) << "WatchFileDescriptor kevent64: "
+                  << logging::SystemErrorCodeToString(
+                         static_cast<logging::SystemErrorCode>(event->data));
+      did_work = true;
+      FdWatcher* fd_watcher = controller->watcher();
+      StopWatchingFileDescriptor(controller);
+      // The read or write the watcher retries fails with the error.
+      auto scoped_do_work_item = delegate->BeginWorkItem();
+      if (event->filter == EVFILT_READ) {
+        fd_watcher->OnFileCanReadWithoutBlocking(
+            static_cast<int>(event->ident));
+      } else {
+        fd_watcher->OnFileCanWriteWithoutBlocking(
+            static_cast<int>(event->ident));
+      }
+      continue;
+    }
     if (event->filter == EVFILT_READ || event->filter == EVFILT_WRITE) {
       did_work = true;
 
@@ -568,16 +596,14 @@ void MessagePumpKqueue::MaybeUpdateWakeupTimer(
       // Clear the timer.
       kevent64_s timer{};
       SetWakeupTimerEvent(wakeup_time, leeway, &timer);
-      int rv = ChangeOneEvent(kqueue_, &timer);
-      PCHECK(rv == 0) << "kevent64, delete timer";
+      pending_changes_.push_back(timer);
       --event_count_;
     }
   } else {
     // Set/reset the timer.
     kevent64_s timer{};
     SetWakeupTimerEvent(wakeup_time, leeway, &timer);
-    int rv = ChangeOneEvent(kqueue_, &timer);
-    PCHECK(rv == 0) << "kevent64, set timer";
+    pending_changes_.push_back(timer);
 
     // Bump the event count if we just added the timer.
     if (scheduled_wakeup_time_ == base::TimeTicks::Max())
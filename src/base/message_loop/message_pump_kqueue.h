@@ -129,6 +129,9 @@ class BASE_EXPORT MessagePumpKqueue : public MessagePump,
                             MachPortWatcher* delegate);
 
   // WatchableIOMessagePumpPosix:
+  // The watch is added to the kqueue with the next wait for events, which
+  // comes before the pump sleeps. If adding it fails, the |delegate| is told
+  // that |fd| is ready, so that the read or write it retries finds the error.
   bool WatchFileDescriptor(int fd,
                            bool persistent,
                            int mode,
@@ -194,6 +197,9 @@ class BASE_EXPORT MessagePumpKqueue : public MessagePump,
   // Buffer used by DoInternalWork() to be notified of triggered events. This
   // is always at least |event_count_|-sized.
   std::vector<kevent64_s> events_{event_count_};
+  // Changes to the watched descriptors and the wakeup timer, submitted with
+  // the next kevent64() in DoInternalWork() instead of one call each.
+  std::vector<kevent64_s> pending_changes_;
 
   WeakPtrFactory<MessagePumpKqueue> weak_factory_;
 };
@@ -53,9 +53,14 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump,
     // must be automatically deactivated every time it triggers an epoll event.
     bool one_shot;
 
+    // Indicates that the interest allows an edge-triggered registration. See
+    // WATCH_EDGE_TRIGGERED.
+    bool edge_triggered = false;
+
     bool IsEqual(const EpollInterestParams& rhs) const {
-      return std::tie(fd, read, write, one_shot) ==
-             std::tie(rhs.fd, rhs.read, rhs.write, rhs.one_shot);
+      return std::tie(fd, read, write, one_shot, edge_triggered) ==
+             std::tie(rhs.fd, rhs.read, rhs.write, rhs.one_shot,
+                      rhs.edge_triggered);
     }
   };
 
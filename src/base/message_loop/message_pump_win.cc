@@ -5,6 +5,7 @@
 #include "base/message_loop/message_pump_win.h"
 
 #include <winbase.h>
+#include <winternl.h>
 
 #include <algorithm>
 #include <atomic>
@@ -857,23 +858,37 @@ bool MessagePumpForIO::WaitForIOCompletion(DWORD timeout) {
   return true;
 }
 
-// Asks the OS for another IO completion result.
+// Asks the OS for another IO completion result. The completions are
+// dequeued up to kMaxIOEntries at a time, so a busy thread makes one call per
+// batch rather than one per completion, and handled one per call.
 bool MessagePumpForIO::GetIOItem(DWORD timeout, IOItem* item) {
   DCHECK_CALLED_ON_VALID_THREAD(bound_thread_);
 
   memset(item, 0, sizeof(*item));
-  ULONG_PTR key = reinterpret_cast<ULONG_PTR>(nullptr);
-  OVERLAPPED* overlapped = nullptr;
-  if (!::GetQueuedCompletionStatus(port_.get(), &item->bytes_transfered, &key,
-                                   &overlapped, timeout)) {
-    if (!overlapped)
+  if (next_io_entry_ == num_io_entries_) {
+    next_io_entry_ = 0;
+    num_io_entries_ = 0;
+    ULONG count = 0;
+    if (!::GetQueuedCompletionStatusEx(port_.get(), io_entries_.data(),
+                                       kMaxIOEntries, &count, timeout,
+                                       /*fAlertable=*/FALSE)) {
       return false;  // Nothing in the queue.
-    item->error = GetLastError();
+    }
+    num_io_entries_ = count;
+  }
+  const OVERLAPPED_ENTRY& entry = io_entries_[next_io_entry_++];
+
+  item->bytes_transfered = entry.dwNumberOfBytesTransferred;
+  // The entries have the NTSTATUS of the completion where
+  // GetQueuedCompletionStatus() sets the Win32 error of a failed one.
+  NTSTATUS status = static_cast<NTSTATUS>(entry.Internal);
+  if (status < 0) {
+    item->error = ::RtlNtStatusToDosError(status);
     item->bytes_transfered = 0;
   }
 
-  item->handler = reinterpret_cast<IOHandler*>(key);
-  item->context = reinterpret_cast<IOContext*>(overlapped);
+  item->handler = reinterpret_cast<IOHandler*>(entry.lpCompletionKey);
+  item->context = reinterpret_cast<IOContext*>(entry.lpOverlapped);
   return true;
 }
 
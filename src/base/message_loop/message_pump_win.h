@@ -7,6 +7,7 @@
 
 #include <windows.h>
 
+#include <array>
 #include <atomic>
 #include <memory>
 #include <optional>
@@ -302,6 +303,9 @@ class BASE_EXPORT MessagePumpForIO : public MessagePumpWin {
   bool RegisterJobObject(HANDLE job_handle, IOHandler* handler);
 
  private:
+  // Completions dequeued at once by GetIOItem().
+  static constexpr ULONG kMaxIOEntries = 64;
+
   struct IOItem {
     raw_ptr<IOHandler> handler;
     raw_ptr<IOContext> context;
@@ -322,6 +326,12 @@ class BASE_EXPORT MessagePumpForIO : public MessagePumpWin {
 
   // The completion port associated with this thread.
   win::ScopedHandle port_;
+
+  // The completions dequeued but not yet handled are
+  // `io_entries_[next_io_entry_, num_io_entries_)`.
+  std::array<OVERLAPPED_ENTRY, kMaxIOEntries> io_entries_;
+  ULONG num_io_entries_ = 0;
+  ULONG next_io_entry_ = 0;
 };
 
 }  // namespace base
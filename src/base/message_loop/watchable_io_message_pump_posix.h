@@ -57,7 +57,14 @@ class WatchableIOMessagePumpPosix {
   enum Mode {
     WATCH_READ = 1 << 0,
     WATCH_WRITE = 1 << 1,
-    WATCH_READ_WRITE = WATCH_READ | WATCH_WRITE
+    WATCH_READ_WRITE = WATCH_READ | WATCH_WRITE,
+    // Added to one-shot watches by callers that only wait after a read or
+    // write failed with EAGAIN. The epoll pump then keeps the descriptor
+    // registered edge-triggered for writing for as long as it only has such
+    // watches, and for reading while a read watch is active. Firing a watch
+    // and renewing it from its handler do not change the registration. Only
+    // used on Linux, where libevent ignores it.
+    WATCH_EDGE_TRIGGERED = 1 << 2,
   };
 
   // Every subclass of WatchableIOMessagePumpPosix must provide a
@@ -129,6 +129,7 @@
   X("midi")                                                              \
   X("mojom")                                                             \
   X("mus")                                                               \
+  X("naive")                                                             \
   X("native")                                                            \
   X("navigation")                                                        \
   X("navigation.debug")                                                  \
@@ -0,0 +1,72 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/io_buffer_chain.h"
+
+#include <limits>
+#include <utility>
+
+#include "base/check_op.h"
+
+namespace net {
+
+IOBufferChain::Slice::Slice(scoped_refptr<IOBuffer> buffer,
+                            int offset,
+                            int size)
+    : buffer(std::move(buffer)), offset(offset), size(size) {}
+
+IOBufferChain::Slice::Slice(Slice&&) = default;
+
+IOBufferChain::Slice& IOBufferChain::Slice::operator=(Slice&&) = default;
+
+IOBufferChain::Slice::~Slice() = default;
+
+IOBufferChain::IOBufferChain() = default;
+
+IOBufferChain::~IOBufferChain() = default;
+
+void IOBufferChain::Append(scoped_refptr<IOBuffer> buffer,
+                           int offset,
+                           int size) {
+  CHECK_GE(offset, 0);
+  CHECK_GE(size, 0);
+  CHECK_LE(offset, buffer->size() - size);
+  CHECK_LE(bytes_remaining_, std::numeric_limits<int>::max() - size);
+  if (size == 0)
+    return;
+  bytes_remaining_ += size;
+  slices_.emplace_back(std::move(buffer), offset, size);
+}
+
+void IOBufferChain::Append(scoped_refptr<IOBuffer> buffer) {
+  int size = buffer->size();
+  Append(std::move(buffer), 0, size);
+}
+
+void IOBufferChain::DidConsume(int bytes) {
+  CHECK_GE(bytes, 0);
+  CHECK_LE(bytes, bytes_remaining_);
+  bytes_remaining_ -= bytes;
+  while (bytes > 0) {
+    Slice& front = slices_.front();
+    if (bytes < front.size) {
+      front.offset += bytes;
+      front.size -= bytes;
+      return;
+    }
+    bytes -= front.size;
+    slices_.pop_front();
+  }
+}
+
+void IOBufferChain::CopyTo(base::span<char> dest) const {
+  CHECK_GE(dest.size(), static_cast<size_t>(bytes_remaining_));
+  for (const Slice& slice : slices_) {
+    base::span<const char> data = slice.span();
+    dest.first(data.size()).copy_from(data);
+    dest = dest.subspan(data.size());
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,83 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_IO_BUFFER_CHAIN_H_
+#define NET_BASE_IO_BUFFER_CHAIN_H_
+
+#include <stddef.h>
+
+#include "base/containers/circular_deque.h"
+#include "base/containers/span.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_export.h"
+
+namespace net {
+
+// A reference counted sequence of slices of IOBuffers, to be written with
+// StreamSocket::WriteV() as if they were one buffer, such as a frame header,
+// its payload in a buffer of the caller and its padding. The slices keep
+// their buffers alive until they are consumed. Like DrainableIOBuffer, the
+// chain is drained progressively:
+//
+// while (chain->BytesRemaining() > 0) {
+//   int bytes_written = socket->WriteV(chain.get(), ...);
+//   chain->DidConsume(bytes_written);
+// }
+class NET_EXPORT IOBufferChain
+    : public base::RefCountedThreadSafe<IOBufferChain> {
+ public:
+  struct Slice {
+    Slice(scoped_refptr<IOBuffer> buffer, int offset, int size);
+    Slice(Slice&&);
+    Slice& operator=(Slice&&);
+    ~Slice();
+
+    base::span<const char> span() const {
+      return buffer->span().subspan(static_cast<size_t>(offset),
+                                    static_cast<size_t>(size));
+    }
+
+    scoped_refptr<IOBuffer> buffer;
+    int offset;
+    int size;
+  };
+
+  IOBufferChain();
+  IOBufferChain(const IOBufferChain&) = delete;
+  IOBufferChain& operator=(const IOBufferChain&) = delete;
+
+  // Appends the |size| bytes of |buffer| from |offset|. Empty slices are
+  // skipped.
+  void Append(scoped_refptr<IOBuffer> buffer, int offset, int size);
+  void Append(scoped_refptr<IOBuffer> buffer);
+
+  // Drops the first |bytes| unconsumed bytes, releasing the buffers of the
+  // slices they used up.
+  void DidConsume(int bytes);
+
+  // Returns the number of unconsumed bytes.
+  int BytesRemaining() const { return bytes_remaining_; }
+
+  // The slices with unconsumed bytes. The first one starts at the first
+  // unconsumed byte.
+  size_t num_slices() const { return slices_.size(); }
+  const Slice& slice(size_t i) const { return slices_[i]; }
+
+  // Copies the unconsumed bytes into |dest|, which must hold them.
+  void CopyTo(base::span<char> dest) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<IOBufferChain>;
+
+  ~IOBufferChain();
+
+  base::circular_deque<Slice> slices_;
+  int bytes_remaining_ = 0;
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_IO_BUFFER_CHAIN_H_
@@ -5,6 +5,9 @@
 #ifndef NET_BASE_PROXY_DELEGATE_H_
 #define NET_BASE_PROXY_DELEGATE_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <string>
 
 #include "net/base/net_errors.h"
@@ -78,6 +81,16 @@ class NET_EXPORT ProxyDelegate {
       size_t chain_index,
       const HttpResponseHeaders& response_headers) = 0;
 
+  // Called after a tunnel through the proxy server at position `chain_index`
+  // in `proxy_chain` was established over HTTP/2. Returns the
+  // SETTINGS_MAX_FRAME_SIZE to announce on the session to that proxy server
+  // so that it sends larger DATA frames, or 0 to keep the protocol default.
+  // The session then also sends larger frames if the proxy server allows.
+  virtual uint32_t GetTunnelMaxFrameSize(const ProxyChain& proxy_chain,
+                                         size_t chain_index) {
+    return 0;
+  }
+
   // Associates a `ProxyResolutionService` with this `ProxyDelegate`.
   // `proxy_resolution_service` must outlive `this`.
   virtual void SetProxyResolutionService(
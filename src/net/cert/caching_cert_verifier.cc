@@ -42,15 +42,26 @@ int CachingCertVerifier::Verify(const CertVerifier::RequestParams& params,
 
   requests_++;
 
+  base::Time start_time = base::Time::Now();
   const CertVerificationCache::value_type* cached_entry =
-      cache_.Get(params, CacheValidityPeriod(base::Time::Now()));
+      cache_.Get(params, CacheValidityPeriod(start_time));
   if (cached_entry) {
     ++cache_hits_;
     *verify_result = cached_entry->result;
     return cached_entry->error;
   }
 
-  base::Time start_time = base::Time::Now();
+  if (store_ && store_->Lookup(params, start_time, verify_result)) {
+    ++cache_hits_;
+    CachedResult cached_result;
+    cached_result.error = OK;
+    cached_result.result = *verify_result;
+    cache_.Put(
+        params, cached_result, CacheValidityPeriod(start_time),
+        CacheValidityPeriod(start_time, start_time + base::Seconds(kTTLSecs)));
+    return OK;
+  }
+
   // Unretained is safe here as `verifier_` is owned by `this`. If `this` is
   // deleted, `verifier_' will also be deleted and guarantees that any
   // outstanding callbacks won't be called. (See CertVerifier::Verify comments.)
@@ -180,6 +191,8 @@ void CachingCertVerifier::AddResultToCache(
   cache_.Put(
       params, cached_result, CacheValidityPeriod(start_time),
       CacheValidityPeriod(start_time, start_time + base::Seconds(kTTLSecs)));
+  if (store_ && error == OK)
+    store_->Save(params, start_time, verify_result);
 }
 
 void CachingCertVerifier::OnCertVerifierChanged() {
@@ -194,6 +207,8 @@ void CachingCertVerifier::OnTrustStoreChanged() {
 
 void CachingCertVerifier::ClearCache() {
   cache_.Clear();
+  if (store_)
+    store_->Clear();
 }
 
 size_t CachingCertVerifier::GetCacheSize() const {
@@ -8,6 +8,7 @@
 #include <memory>
 
 #include "base/gtest_prod_util.h"
+#include "base/memory/raw_ptr.h"
 #include "base/time/time.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/expiring_cache.h"
@@ -38,6 +39,26 @@ class NET_EXPORT CachingCertVerifier : public CertVerifier,
                                        public CertVerifier::Observer,
                                        public CertDatabase::Observer {
  public:
+  // Keeps successful verifications beyond the life of the cache, as across
+  // restarts. It is given each one added to the cache and serves lookups
+  // that miss the cache.
+  class NET_EXPORT Store {
+   public:
+    virtual ~Store() = default;
+
+    // Saves |result| of |params|, verified at |verification_time|.
+    virtual void Save(const RequestParams& params,
+                      base::Time verification_time,
+                      const CertVerifyResult& result) = 0;
+    // Fills |result| with a saved verification of |params| that is still
+    // good at |now| and returns true, or returns false if there is none.
+    virtual bool Lookup(const RequestParams& params,
+                        base::Time now,
+                        CertVerifyResult* result) = 0;
+    // Drops all saved verifications, as when the trust store changes.
+    virtual void Clear() = 0;
+  };
+
   // Creates a CachingCertVerifier that will use |verifier| to perform the
   // actual verifications if they're not already cached or if the cached
   // item has expired.
@@ -58,6 +79,10 @@ class NET_EXPORT CachingCertVerifier : public CertVerifier,
   void AddObserver(CertVerifier::Observer* observer) override;
   void RemoveObserver(CertVerifier::Observer* observer) override;
 
+  // Sets the store backing the cache, or nullptr for none. |store| must
+  // outlive the verifier.
+  void set_store(Store* store) { store_ = store; }
+
  private:
   FRIEND_TEST_ALL_PREFIXES(CachingCertVerifierTest, CacheHit);
   FRIEND_TEST_ALL_PREFIXES(CachingCertVerifierTest, CacheHitCTResultsCached);
@@ -136,6 +161,7 @@ class NET_EXPORT CachingCertVerifier : public CertVerifier,
   uint64_t requests() const { return requests_; }
 
   std::unique_ptr<CertVerifier> verifier_;
+  raw_ptr<Store> store_ = nullptr;
 
   uint32_t config_id_ = 0u;
   CertVerificationCache cache_;
@@ -134,6 +134,8 @@ class NET_EXPORT CertVerifier {
     int flags() const { return flags_; }
     const std::string& ocsp_response() const { return ocsp_response_; }
     const std::string& sct_list() const { return sct_list_; }
+    // A SHA-256 hash of all of the above, which tells requests apart.
+    const std::string& key() const { return key_; }
 
     bool operator==(const RequestParams& other) const;
     bool operator<(const RequestParams& other) const;
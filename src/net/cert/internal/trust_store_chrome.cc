@@ -4,11 +4,17 @@
 
 #include "net/cert/internal/trust_store_chrome.h"
 
+#include <algorithm>
+#include <array>
+#include <iterator>
 #include <optional>
 
 #include "base/containers/span.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
+#include "base/no_destructor.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
 #include "net/cert/root_store_proto_lite/root_store.pb.h"
 #include "net/cert/x509_certificate.h"
 #include "net/cert/x509_util.h"
@@ -20,6 +26,57 @@ namespace net {
 
 namespace {
 #include "net/data/ssl/chrome_root_store/chrome-root-store-inc.cc"
+
+std::shared_ptr<const bssl::ParsedCertificate> ParseStaticAnchor(
+    const ChromeRootCertInfo& cert_info) {
+  bssl::CertErrors errors;
+  auto parsed = bssl::ParsedCertificate::Create(
+      x509_util::CreateCryptoBufferFromStaticDataUnsafe(
+          cert_info.root_cert_der),
+      x509_util::DefaultParseCertificateOptions(), &errors);
+  // There should always be a valid cert, because we should be parsing Chrome
+  // Root Store static data compiled in.
+  CHECK(parsed);
+  return parsed;
+}
+
+// The compiled-in anchors parsed so far, shared by the TrustStoreChrome of
+// every verifier in the process.
+class CompiledAnchorCache {
+ public:
+  static CompiledAnchorCache& Get() {
+    static base::NoDestructor<CompiledAnchorCache> cache;
+    return *cache;
+  }
+
+  std::shared_ptr<const bssl::ParsedCertificate> GetAnchor(size_t index) {
+    base::AutoLock lock(lock_);
+    std::shared_ptr<const bssl::ParsedCertificate>& anchor = anchors_[index];
+    if (!anchor) {
+      anchor = ParseStaticAnchor(kChromeRootCertList[index]);
+    }
+    return anchor;
+  }
+
+ private:
+  base::Lock lock_;
+  std::array<std::shared_ptr<const bssl::ParsedCertificate>,
+             std::size(kChromeRootCertList)>
+      anchors_ GUARDED_BY(lock_);
+};
+
+// Whether root_store_tool gave the subjects of the compiled-in anchors.
+bool HasStaticSubjects() {
+  return std::ranges::none_of(kChromeRootCertList,
+                              [](const ChromeRootCertInfo& cert_info) {
+                                return cert_info.normalized_subject.empty();
+                              });
+}
+
+std::string_view AsStringView(base::span<const uint8_t> bytes) {
+  return std::string_view(reinterpret_cast<const char*>(bytes.data()),
+                          bytes.size());
+}
 }  // namespace
 
 ChromeRootCertConstraints::ChromeRootCertConstraints(
@@ -151,6 +208,31 @@ TrustStoreChrome::TrustStoreChrome(base::span<const ChromeRootCertInfo> certs,
       std::pair<std::string_view, std::vector<ChromeRootCertConstraints>>>
       constraints;
 
+  // The compiled-in roots are indexed without parsing them, so that
+  // creating a verifier costs little, and each one is parsed once for the
+  // whole process when a verification first needs it.
+  if (certs_are_static && certs.data() == std::data(kChromeRootCertList) &&
+      HasStaticSubjects()) {
+    for (size_t i = 0; i < certs.size(); ++i) {
+      const ChromeRootCertInfo& cert_info = certs[i];
+      lazy_anchors_.emplace_back(AsStringView(cert_info.normalized_subject),
+                                 i);
+      if (!cert_info.constraints.empty()) {
+        std::vector<ChromeRootCertConstraints> cert_constraints;
+        for (const auto& constraint : cert_info.constraints) {
+          cert_constraints.emplace_back(constraint);
+        }
+        constraints.emplace_back(AsStringView(cert_info.root_cert_der),
+                                 std::move(cert_constraints));
+      }
+    }
+    std::ranges::stable_sort(lazy_anchors_, {},
+                             &std::pair<std::string_view, size_t>::first);
+    constraints_ = base::flat_map(std::move(constraints));
+    version_ = version;
+    return;
+  }
+
   // TODO(hchao, sleevi): Explore keeping a CRYPTO_BUFFER of just the DER
   // certificate and subject name. This would hopefully save memory compared
   // to keeping the full parsed representation in memory, especially when
@@ -211,16 +293,47 @@ TrustStoreChrome::~TrustStoreChrome() = default;
 
 void TrustStoreChrome::SyncGetIssuersOf(const bssl::ParsedCertificate* cert,
                                         bssl::ParsedCertificateList* issuers) {
-  trust_store_.SyncGetIssuersOf(cert, issuers);
+  if (lazy_anchors_.empty()) {
+    trust_store_.SyncGetIssuersOf(cert, issuers);
+    return;
+  }
+  auto range = std::ranges::equal_range(
+      lazy_anchors_, cert->normalized_issuer().AsStringView(), {},
+      &std::pair<std::string_view, size_t>::first);
+  for (const auto& [subject, index] : range) {
+    issuers->push_back(CompiledAnchorCache::Get().GetAnchor(index));
+  }
 }
 
 bssl::CertificateTrust TrustStoreChrome::GetTrust(
     const bssl::ParsedCertificate* cert) {
-  return trust_store_.GetTrust(cert);
+  if (lazy_anchors_.empty()) {
+    return trust_store_.GetTrust(cert);
+  }
+  return FindLazyAnchor(cert) >= 0 ? bssl::CertificateTrust::ForTrustAnchor()
+                                   : bssl::CertificateTrust::ForUnspecified();
 }
 
 bool TrustStoreChrome::Contains(const bssl::ParsedCertificate* cert) const {
-  return trust_store_.Contains(cert);
+  if (lazy_anchors_.empty()) {
+    return trust_store_.Contains(cert);
+  }
+  return FindLazyAnchor(cert) >= 0;
+}
+
+int TrustStoreChrome::FindLazyAnchor(
+    const bssl::ParsedCertificate* cert) const {
+  // Matched by DER, as bssl::TrustStoreInMemory does, which needs no parse.
+  auto range = std::ranges::equal_range(
+      lazy_anchors_, cert->normalized_subject().AsStringView(), {},
+      &std::pair<std::string_view, size_t>::first);
+  for (const auto& [subject, index] : range) {
+    if (AsStringView(kChromeRootCertList[index].root_cert_der) ==
+        cert->der_cert().AsStringView()) {
+      return static_cast<int>(index);
+    }
+  }
+  return -1;
 }
 
 base::span<const ChromeRootCertConstraints>
@@ -248,20 +361,14 @@ int64_t CompiledChromeRootStoreVersion() {
 
 std::vector<ChromeRootStoreData::Anchor> CompiledChromeRootStoreAnchors() {
   std::vector<ChromeRootStoreData::Anchor> anchors;
-  for (const auto& cert_info : kChromeRootCertList) {
-    bssl::UniquePtr<CRYPTO_BUFFER> cert =
-        x509_util::CreateCryptoBufferFromStaticDataUnsafe(
-            cert_info.root_cert_der);
-    bssl::CertErrors errors;
-    auto parsed = bssl::ParsedCertificate::Create(
-        std::move(cert), x509_util::DefaultParseCertificateOptions(), &errors);
-    DCHECK(parsed);
-
+  for (size_t i = 0; i < std::size(kChromeRootCertList); ++i) {
+    const ChromeRootCertInfo& cert_info = kChromeRootCertList[i];
     std::vector<ChromeRootCertConstraints> cert_constraints;
     for (const auto& constraint : cert_info.constraints) {
       cert_constraints.emplace_back(constraint);
     }
-    anchors.emplace_back(std::move(parsed), std::move(cert_constraints));
+    anchors.emplace_back(CompiledAnchorCache::Get().GetAnchor(i),
+                         std::move(cert_constraints));
   }
 
   return anchors;
@@ -39,6 +39,10 @@ struct StaticChromeRootCertConstraints {
 struct ChromeRootCertInfo {
   base::span<const uint8_t> root_cert_der;
   base::span<const StaticChromeRootCertConstraints> constraints;
+  // The normalized subject of the certificate, precomputed by
+  // root_store_tool so that the compiled-in roots are only parsed once a
+  // verification needs them. Empty if not known.
+  base::span<const uint8_t> normalized_subject;
 };
 
 struct NET_EXPORT ChromeRootCertConstraints {
@@ -141,6 +145,16 @@ class NET_EXPORT TrustStoreChrome : public bssl::TrustStore {
   TrustStoreChrome(base::span<const ChromeRootCertInfo> certs,
                    bool certs_are_static,
                    int64_t version);
+
+  // Returns the index in the compiled-in list of the anchor that is `cert`,
+  // or -1. Only with `lazy_anchors_`.
+  int FindLazyAnchor(const bssl::ParsedCertificate* cert) const;
+
+  // The compiled-in anchors by normalized subject, in order, and their index
+  // in the compiled-in list. They are parsed on first use and shared by all
+  // instances, rather than parsed into `trust_store_` up front by each.
+  // Empty otherwise.
+  std::vector<std::pair<std::string_view, size_t>> lazy_anchors_;
   bssl::TrustStoreInMemory trust_store_;
   // Map from certificate DER bytes to additional constraints (if any) for that
   // certificate. The DER bytes of the key are owned by the ParsedCertificate
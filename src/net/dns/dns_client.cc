@@ -121,6 +121,13 @@ class DnsClientImpl : public DnsClient {
     can_query_additional_types_via_insecure_ = additional_types_enabled;
   }
 
+  void SetUdpSocketPoolSize(size_t max_idle_sockets) override {
+    udp_socket_pool_size_ = max_idle_sockets;
+    if (session_) {
+      session_->udp_socket_pool()->set_max_idle_sockets(max_idle_sockets);
+    }
+  }
+
   bool FallbackFromSecureTransactionPreferred(
       ResolveContext* context) const override {
     if (!CanUseSecureDnsTransactions())
@@ -302,6 +309,7 @@ class DnsClientImpl : public DnsClient {
       session_ = base::MakeRefCounted<DnsSession>(
           std::move(new_effective_config).value(), rand_int_callback_,
           net_log_);
+      session_->udp_socket_pool()->set_max_idle_sockets(udp_socket_pool_size_);
       factory_ = DnsTransactionFactory::CreateFactory(session_.get());
     }
   }
@@ -309,6 +317,7 @@ class DnsClientImpl : public DnsClient {
   bool insecure_enabled_ = false;
   bool can_query_additional_types_via_insecure_ = false;
   int insecure_fallback_failures_ = 0;
+  size_t udp_socket_pool_size_ = 0;
 
   std::optional<DnsConfig> system_config_;
   DnsConfigOverrides config_overrides_;
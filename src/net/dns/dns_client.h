@@ -53,6 +53,11 @@ class NET_EXPORT DnsClient {
   virtual void SetInsecureEnabled(bool enabled,
                                   bool additional_types_enabled) = 0;
 
+  // Keeps up to `max_idle_sockets` UDP sockets per nameserver for reuse by
+  // insecure transactions. See DnsUdpSocketPool. Zero, the default, opens a
+  // socket for each query.
+  virtual void SetUdpSocketPoolSize(size_t max_idle_sockets) = 0;
+
   // When true, DoH should not be used in AUTOMATIC mode since no DoH servers
   // have a successful probe state.
   virtual bool FallbackFromSecureTransactionPreferred(
@@ -13,6 +13,7 @@
 #include "net/base/net_export.h"
 #include "net/base/rand_callback.h"
 #include "net/dns/dns_config.h"
+#include "net/dns/dns_udp_socket_pool.h"
 #include "net/dns/dns_udp_tracker.h"
 
 namespace net {
@@ -41,6 +42,7 @@ class NET_EXPORT_PRIVATE DnsSession : public base::RefCounted<DnsSession> {
 
   const DnsConfig& config() const { return config_; }
   DnsUdpTracker* udp_tracker() { return &udp_tracker_; }
+  DnsUdpSocketPool* udp_socket_pool() { return &udp_socket_pool_; }
   NetLog* net_log() const { return net_log_; }
 
   // Return the next random query ID.
@@ -63,6 +65,7 @@ class NET_EXPORT_PRIVATE DnsSession : public base::RefCounted<DnsSession> {
 
   const DnsConfig config_;
   DnsUdpTracker udp_tracker_;
+  DnsUdpSocketPool udp_socket_pool_;
   RandCallback rand_callback_;
   raw_ptr<NetLog> net_log_;
 
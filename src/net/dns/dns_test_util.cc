@@ -749,6 +749,8 @@ void MockDnsClient::SetInsecureEnabled(bool enabled,
   additional_types_enabled_ = additional_types_enabled;
 }
 
+void MockDnsClient::SetUdpSocketPoolSize(size_t max_idle_sockets) {}
+
 bool MockDnsClient::FallbackFromSecureTransactionPreferred(
     ResolveContext* context) const {
   bool doh_server_available =
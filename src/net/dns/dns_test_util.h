@@ -406,6 +406,7 @@ class MockDnsClient : public DnsClient {
   bool CanUseInsecureDnsTransactions() const override;
   bool CanQueryAdditionalTypesViaInsecureDns() const override;
   void SetInsecureEnabled(bool enabled, bool additional_types_enabled) override;
+  void SetUdpSocketPoolSize(size_t max_idle_sockets) override;
   bool FallbackFromSecureTransactionPreferred(
       ResolveContext* resolve_context) const override;
   bool FallbackFromInsecureTransactionPreferred() const override;
@@ -55,6 +55,7 @@
 #include "net/dns/dns_response_result_extractor.h"
 #include "net/dns/dns_server_iterator.h"
 #include "net/dns/dns_session.h"
+#include "net/dns/dns_udp_socket_pool.h"
 #include "net/dns/dns_udp_tracker.h"
 #include "net/dns/dns_util.h"
 #include "net/dns/host_cache.h"
@@ -206,25 +207,42 @@ class DnsAttempt {
 class DnsUDPAttempt : public DnsAttempt {
  public:
   DnsUDPAttempt(size_t server_index,
-                std::unique_ptr<DatagramClientSocket> socket,
+                DnsUdpSocketPool::Entry socket,
                 const IPEndPoint& server,
                 std::unique_ptr<DnsQuery> query,
-                DnsUdpTracker* udp_tracker)
+                DnsUdpTracker* udp_tracker,
+                DnsUdpSocketPool* socket_pool)
       : DnsAttempt(server_index),
-        socket_(std::move(socket)),
+        socket_(std::move(socket.socket)),
+        socket_queries_(socket.queries),
         server_(server),
         query_(std::move(query)),
-        udp_tracker_(udp_tracker) {}
+        udp_tracker_(udp_tracker),
+        socket_pool_(socket_pool) {}
 
   DnsUDPAttempt(const DnsUDPAttempt&) = delete;
   DnsUDPAttempt& operator=(const DnsUDPAttempt&) = delete;
 
+  ~DnsUDPAttempt() override {
+    if (socket_reusable_) {
+      DnsUdpSocketPool::Entry entry;
+      entry.socket = std::move(socket_);
+      entry.queries = socket_queries_;
+      socket_pool_->Return(server_index(), std::move(entry));
+    }
+  }
+
   // DnsAttempt methods.
 
   int Start(CompletionOnceCallback callback) override {
     DCHECK_EQ(STATE_NONE, next_state_);
     callback_ = std::move(callback);
     start_time_ = base::TimeTicks::Now();
+    if (IsSocketReused()) {
+      // Already connected.
+      next_state_ = STATE_SEND_QUERY;
+      return DoLoop(OK);
+    }
     next_state_ = STATE_CONNECT_COMPLETE;
 
     int rv = socket_->ConnectAsync(
@@ -265,6 +283,11 @@ class DnsUDPAttempt : public DnsAttempt {
     STATE_NONE,
   };
 
+  // A socket from the pool sent queries before, from the same port, so the
+  // query is not recorded as one from a new port, and the responses to those
+  // queries may still come.
+  bool IsSocketReused() const { return socket_queries_ > 1; }
+
   int DoLoop(int result) {
     CHECK_NE(STATE_NONE, next_state_);
     int rv = result;
@@ -351,11 +374,19 @@ class DnsUDPAttempt : public DnsAttempt {
     read_size_ = rv;
 
     bool parse_result = response_->InitParse(rv, *query_);
+    if (IsSocketReused() && response_->id() &&
+        response_->id().value() != query_->id()) {
+      // A late response to an earlier query on the socket.
+      next_state_ = STATE_READ_RESPONSE;
+      return OK;
+    }
     if (response_->id())
       udp_tracker_->RecordResponseId(query_->id(), response_->id().value());
 
     if (!parse_result)
       return ERR_DNS_MALFORMED_RESPONSE;
+    // Nothing more is expected on the socket.
+    socket_reusable_ = true;
     if (response_->flags() & dns_protocol::kFlagTC)
       return ERR_DNS_SERVER_REQUIRES_TCP;
     if (response_->rcode() == dns_protocol::kRcodeNXDOMAIN)
@@ -376,12 +407,16 @@ class DnsUDPAttempt : public DnsAttempt {
   base::TimeTicks start_time_;
 
   std::unique_ptr<DatagramClientSocket> socket_;
+  // Queries sent on `socket_`, counting this one.
+  const int socket_queries_;
+  bool socket_reusable_ = false;
   IPEndPoint server_;
   std::unique_ptr<DnsQuery> query_;
 
   // Should be owned by the DnsSession, to which the transaction should own a
   // reference.
   const raw_ptr<DnsUdpTracker> udp_tracker_;
+  const raw_ptr<DnsUdpSocketPool> socket_pool_;
 
   std::unique_ptr<DnsResponse> response_;
   int read_size_ = 0;
@@ -1412,16 +1447,21 @@ class DnsTransactionImpl final : public DnsTransaction {
     DCHECK_LT(server_index, config.nameservers.size());
     size_t attempt_number = attempts_.size();
 
-    std::unique_ptr<DatagramClientSocket> socket =
-        resolve_context_->url_request_context()
-            ->GetNetworkSessionContext()
-            ->client_socket_factory->CreateDatagramClientSocket(
-                DatagramSocket::RANDOM_BIND, net_log_.net_log(),
-                net_log_.source());
+    DnsUdpSocketPool::Entry socket =
+        session_->udp_socket_pool()->Take(server_index);
+    if (!socket.socket) {
+      socket.socket =
+          resolve_context_->url_request_context()
+              ->GetNetworkSessionContext()
+              ->client_socket_factory->CreateDatagramClientSocket(
+                  DatagramSocket::RANDOM_BIND, net_log_.net_log(),
+                  net_log_.source());
+    }
 
     attempts_.push_back(std::make_unique<DnsUDPAttempt>(
         server_index, std::move(socket), config.nameservers[server_index],
-        std::move(query), session_->udp_tracker()));
+        std::move(query), session_->udp_tracker(),
+        session_->udp_socket_pool()));
     ++attempts_count_;
 
     DnsAttempt* attempt = attempts_.back().get();
@@ -0,0 +1,74 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/dns/dns_udp_socket_pool.h"
+
+#include <atomic>
+#include <utility>
+
+#include "base/check.h"
+#include "net/socket/datagram_client_socket.h"
+
+namespace net {
+
+namespace {
+
+std::atomic<uint64_t> g_queries = 0;
+std::atomic<uint64_t> g_sockets = 0;
+
+}  // namespace
+
+DnsUdpSocketPool::Entry::Entry() = default;
+DnsUdpSocketPool::Entry::Entry(Entry&&) = default;
+DnsUdpSocketPool::Entry& DnsUdpSocketPool::Entry::operator=(Entry&&) =
+    default;
+DnsUdpSocketPool::Entry::~Entry() = default;
+
+DnsUdpSocketPool::DnsUdpSocketPool() = default;
+
+DnsUdpSocketPool::~DnsUdpSocketPool() = default;
+
+void DnsUdpSocketPool::set_max_idle_sockets(size_t max_idle_sockets) {
+  max_idle_sockets_ = max_idle_sockets;
+  for (auto& [server_index, sockets] : idle_sockets_) {
+    if (sockets.size() > max_idle_sockets_) {
+      sockets.resize(max_idle_sockets_);
+    }
+  }
+}
+
+DnsUdpSocketPool::Entry DnsUdpSocketPool::Take(size_t server_index) {
+  g_queries.fetch_add(1, std::memory_order_relaxed);
+  Entry entry;
+  auto it = idle_sockets_.find(server_index);
+  if (it != idle_sockets_.end() && !it->second.empty()) {
+    entry = std::move(it->second.back());
+    it->second.pop_back();
+  } else {
+    g_sockets.fetch_add(1, std::memory_order_relaxed);
+  }
+  entry.queries++;
+  return entry;
+}
+
+void DnsUdpSocketPool::Return(size_t server_index, Entry entry) {
+  DCHECK(entry.socket);
+  if (entry.queries >= kMaxQueriesPerSocket) {
+    return;
+  }
+  std::vector<Entry>& sockets = idle_sockets_[server_index];
+  if (sockets.size() < max_idle_sockets_) {
+    sockets.push_back(std::move(entry));
+  }
+}
+
+// static
+DnsUdpSocketPool::Stats DnsUdpSocketPool::GetStats() {
+  Stats stats;
+  stats.queries = g_queries.load(std::memory_order_relaxed);
+  stats.sockets = g_sockets.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace net
@@ -0,0 +1,76 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DNS_DNS_UDP_SOCKET_POOL_H_
+#define NET_DNS_DNS_UDP_SOCKET_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "base/containers/flat_map.h"
+#include "net/base/net_export.h"
+
+namespace net {
+
+class DatagramClientSocket;
+
+// Connected UDP sockets to the nameservers of a DnsSession, kept between
+// queries, so that a resolver answering many queries does not open, bind and
+// close a socket for each, nor run out of local ports. A socket is bound to a
+// random port as a fresh one would be, and sends one query at a time. It is
+// closed after kMaxQueriesPerSocket queries, so that the ports keep rotating
+// and an off-path attacker has little time to find one to spoof answers to.
+// Owned by a DnsSession. Keeps no socket until set_max_idle_sockets().
+class NET_EXPORT_PRIVATE DnsUdpSocketPool {
+ public:
+  static constexpr int kMaxQueriesPerSocket = 64;
+
+  // A socket, or none, and the queries it sent, counting the one it is
+  // taken for.
+  struct NET_EXPORT_PRIVATE Entry {
+    Entry();
+    Entry(Entry&&);
+    Entry& operator=(Entry&&);
+    ~Entry();
+
+    std::unique_ptr<DatagramClientSocket> socket;
+    int queries = 0;
+  };
+
+  // Process-wide counts of UDP queries and of the sockets opened for them.
+  struct Stats {
+    uint64_t queries = 0;
+    uint64_t sockets = 0;
+  };
+
+  DnsUdpSocketPool();
+  DnsUdpSocketPool(const DnsUdpSocketPool&) = delete;
+  DnsUdpSocketPool& operator=(const DnsUdpSocketPool&) = delete;
+  ~DnsUdpSocketPool();
+
+  // Keeps up to `max_idle_sockets` idle sockets per nameserver. Zero, the
+  // default, closes the sockets as they are given back.
+  void set_max_idle_sockets(size_t max_idle_sockets);
+
+  // Returns an idle socket connected to the nameserver at `server_index`, or
+  // an entry without a socket to open a new one into.
+  Entry Take(size_t server_index);
+
+  // Gives back the socket of `entry`, taken for the nameserver at
+  // `server_index`, once the response to its query was read.
+  void Return(size_t server_index, Entry entry);
+
+  static Stats GetStats();
+
+ private:
+  size_t max_idle_sockets_ = 0;
+  // By nameserver index. The last socket given back is taken first.
+  base::flat_map<size_t, std::vector<Entry>> idle_sockets_;
+};
+
+}  // namespace net
+
+#endif  // NET_DNS_DNS_UDP_SOCKET_POOL_H_
@@ -685,6 +685,8 @@ const HostCache::EntryStaleness HostCache::kNotStale = {base::Seconds(-1), 0,
 
 HostCache::HostCache(size_t max_entries)
     : max_entries_(max_entries),
+      eviction_batch_size_(
+          std::max<size_t>(1, max_entries / kEntriesPerEviction)),
       tick_clock_(base::DefaultTickClock::GetInstance()) {}
 
 HostCache::~HostCache() {
@@ -774,6 +776,10 @@ std::pair<const HostCache::Key, HostCache::Entry>*
 HostCache::LookupInternalIgnoringFields(const Key& initial_key,
                                         base::TimeTicks now,
                                         bool ignore_secure) {
+  // Before any lookup, as it may evict entries. With `ignore_secure`, the
+  // other key is only looked up in this cache.
+  if (store_)
+    CopyFromStore(initial_key, now);
   std::pair<const HostCache::Key, HostCache::Entry>* preferred_result =
       LookupInternal(initial_key);
 
@@ -793,6 +799,21 @@ std::pair<const HostCache::Key, HostCache::Entry>* HostCache::LookupInternal(
   return (it != entries_.end()) ? &*it : nullptr;
 }
 
+void HostCache::CopyFromStore(const Key& key, base::TimeTicks now) {
+  if (entries_.contains(key))
+    return;
+  std::optional<Entry> entry = store_->Find(key);
+  if (!entry)
+    return;
+  // Only network changes seen by this cache make the entry stale, as the
+  // store is cleared on those.
+  entry->network_changes_ = network_changes_;
+  entry->set_pinning(false);
+  while (size() >= max_entries_ && EvictEntries(now)) {
+  }
+  AddEntry(key, std::move(*entry));
+}
+
 void HostCache::Set(const Key& key,
                     const Entry& entry,
                     base::TimeTicks now,
@@ -818,13 +839,15 @@ void HostCache::Set(const Key& key,
     // O(max_entries_).  It only runs more than once if the cache was over-full
     // due to pinned entries, and this is the first call to Set() after
     // Invalidate().  The amortized cost remains O(size()) per call to Set().
-    while (size() >= max_entries_ && EvictOneEntry(now)) {
+    while (size() >= max_entries_ && EvictEntries(now)) {
     }
   }
 
   Entry entry_for_cache(entry, now, ttl, network_changes_);
   entry_for_cache.set_pinning(entry.pinning().value_or(has_active_pin));
   entry_for_cache.PrepareForCacheInsertion();
+  if (store_)
+    store_->Save(key, entry_for_cache);
   AddEntry(key, std::move(entry_for_cache));
 
   if (delegate_ && result_changed)
@@ -858,6 +881,8 @@ void HostCache::AddEntry(const Key& key, Entry&& entry) {
 
 void HostCache::Invalidate() {
   ++network_changes_;
+  if (store_)
+    store_->Clear();
 }
 
 void HostCache::set_persistence_delegate(PersistenceDelegate* delegate) {
@@ -904,6 +929,25 @@ void HostCache::ClearForHosts(
     delegate_->ScheduleWrite();
 }
 
+void HostCache::ClearStaleEntries() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+  base::TimeTicks now = tick_clock_->NowTicks();
+  bool changed = false;
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (!HasActivePin(it->second) &&
+        it->second.IsStale(now, network_changes_)) {
+      it = entries_.erase(it);
+      changed = true;
+    } else {
+      ++it;
+    }
+  }
+
+  if (delegate_ && changed)
+    delegate_->ScheduleWrite();
+}
+
 void HostCache::GetList(base::Value::List& entry_list,
                         bool include_staleness,
                         SerializationType serialization_type) const {
@@ -1208,6 +1252,34 @@ bool HostCache::EvictOneEntry(base::TimeTicks now) {
   return false;
 }
 
+bool HostCache::EvictEntries(base::TimeTicks now) {
+  if (eviction_batch_size_ == 1)
+    return EvictOneEntry(now);
+
+  std::vector<EntryMap::iterator> candidates;
+  candidates.reserve(entries_.size());
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (!HasActivePin(it->second))
+      candidates.push_back(it);
+  }
+  if (candidates.empty())
+    return false;
+
+  size_t count = std::min(eviction_batch_size_, candidates.size());
+  std::nth_element(
+      candidates.begin(), candidates.begin() + (count - 1), candidates.end(),
+      [&](EntryMap::iterator a, EntryMap::iterator b) {
+        bool a_stale = a->second.IsStale(now, network_changes_);
+        bool b_stale = b->second.IsStale(now, network_changes_);
+        if (a_stale != b_stale)
+          return a_stale;
+        return a->second.expires() < b->second.expires();
+      });
+  for (size_t i = 0; i < count; ++i)
+    entries_.erase(candidates[i]);
+  return true;
+}
+
 bool HostCache::HasActivePin(const Entry& entry) {
   return entry.pinning().value_or(false) &&
          entry.network_changes() == network_changes();
@@ -378,6 +378,19 @@ class NET_EXPORT HostCache {
     virtual void ScheduleWrite() = 0;
   };
 
+  // Shares entries between the caches of several threads, like
+  // SSLClientSessionCache::Store. Set() saves the entry to the store, and a
+  // lookup of a key missing from the cache copies the entry of the store
+  // into it. Invalidate() clears the store. Must be thread-safe.
+  class Store {
+   public:
+    virtual ~Store() = default;
+
+    virtual void Save(const Key& key, const Entry& entry) = 0;
+    virtual std::optional<Entry> Find(const Key& key) = 0;
+    virtual void Clear() = 0;
+  };
+
   using EntryMap = std::map<Key, Entry>;
 
   // The two ways to serialize the cache to a value.
@@ -395,6 +408,11 @@ class NET_EXPORT HostCache {
   // A HostCache::EntryStaleness representing a non-stale (fresh) cache entry.
   static const HostCache::EntryStaleness kNotStale;
 
+  // A full cache of more than this many entries per evicted entry evicts
+  // several at once, so a large cache does not scan all of its entries on
+  // every insertion.
+  static constexpr size_t kEntriesPerEviction = 1024;
+
   // Constructs a HostCache that stores up to |max_entries|.
   explicit HostCache(size_t max_entries);
 
@@ -444,6 +462,8 @@ class NET_EXPORT HostCache {
 
   void set_persistence_delegate(PersistenceDelegate* delegate);
 
+  void set_store(Store* store) { store_ = store; }
+
   void set_tick_clock_for_testing(const base::TickClock* tick_clock) {
     tick_clock_ = tick_clock;
   }
@@ -455,6 +475,9 @@ class NET_EXPORT HostCache {
   void ClearForHosts(
       const base::RepeatingCallback<bool(const std::string&)>& host_filter);
 
+  // Clears the stale entries that are not pinned, as under memory pressure.
+  void ClearStaleEntries();
+
   // Fills the provided base::Value with the contents of the cache for
   // serialization. `entry_list` must be non-null list, and will be cleared
   // before adding the cache contents.
@@ -505,11 +528,17 @@ class NET_EXPORT HostCache {
   // match for |key| is required.
   std::pair<const Key, Entry>* LookupInternal(const Key& key);
 
+  // Adds the entry of `key` in `store_`, if this cache has none.
+  void CopyFromStore(const Key& key, base::TimeTicks now);
+
   // Returns true if this HostCache can contain no entries.
   bool caching_is_disabled() const { return max_entries_ == 0; }
 
   // Returns true if an entry was removed.
   bool EvictOneEntry(base::TimeTicks now);
+  // Removes up to |eviction_batch_size_| entries, stale and older ones
+  // first. Returns true if any was removed.
+  bool EvictEntries(base::TimeTicks now);
   // Helper to check if an Entry is currently pinned in the cache.
   bool HasActivePin(const Entry& entry);
   // Helper to insert an Entry into the cache.
@@ -519,12 +548,14 @@ class NET_EXPORT HostCache {
   // a resolved result entry.
   EntryMap entries_;
   size_t max_entries_;
+  size_t eviction_batch_size_;
   int network_changes_ = 0;
   // Number of cache entries that were restored in the last call to
   // RestoreFromListValue(). Used in histograms.
   size_t restore_size_ = 0;
 
   raw_ptr<PersistenceDelegate> delegate_ = nullptr;
+  raw_ptr<Store> store_ = nullptr;
   // Shared tick clock, overridden for testing.
   raw_ptr<const base::TickClock> tick_clock_;
 
@@ -383,12 +383,14 @@ HostResolver::CreateStandaloneContextResolver(
     NetLog* net_log,
     std::optional<ManagerOptions> options,
     bool enable_caching) {
+  auto manager_options = std::move(options).value_or(ManagerOptions());
   auto resolve_context = std::make_unique<ResolveContext>(
-      nullptr /* url_request_context */, enable_caching);
+      nullptr /* url_request_context */, enable_caching,
+      manager_options.host_cache_size);
 
   return std::make_unique<ContextHostResolver>(
       std::make_unique<HostResolverManager>(
-          std::move(options).value_or(ManagerOptions()),
+          std::move(manager_options),
           NetworkChangeNotifier::GetSystemDnsConfigNotifier(), net_log),
       std::move(resolve_context));
 }
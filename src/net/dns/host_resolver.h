@@ -333,6 +333,14 @@ class NET_EXPORT HostResolver {
     // An experimental options for features::kUseDnsHttpsSvcb
     // and features::kUseDnsHttpsSvcbAlpn.
     std::optional<HostResolver::HttpsSvcbOptions> https_svcb_options;
+
+    // Maximum entries of the HostCache of a standalone resolver, or 0 for the
+    // default size.
+    size_t host_cache_size = 0;
+
+    // UDP sockets per nameserver kept for reuse by the built-in DnsClient.
+    // See DnsClient::SetUdpSocketPoolSize().
+    size_t dns_udp_socket_pool_size = 0;
   };
 
   // Factory class. Useful for classes that need to inject and override resolver
@@ -466,6 +466,7 @@ HostResolverManager::HostResolverManager(
   dns_client_->SetInsecureEnabled(
       options.insecure_dns_client_enabled,
       options.additional_types_via_insecure_dns_enabled);
+  dns_client_->SetUdpSocketPoolSize(options.dns_udp_socket_pool_size);
   dns_client_->SetConfigOverrides(options.dns_config_overrides);
 #else
   DCHECK(options.dns_config_overrides == DnsConfigOverrides());
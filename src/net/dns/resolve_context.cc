@@ -124,9 +124,11 @@ constexpr size_t kDefaultCacheSize = 1000;
 constexpr size_t kDefaultCacheSize = 100;
 #endif
 
-std::unique_ptr<HostCache> CreateHostCache(bool enable_caching) {
+std::unique_ptr<HostCache> CreateHostCache(bool enable_caching,
+                                           size_t cache_size) {
   if (enable_caching) {
-    return std::make_unique<HostCache>(kDefaultCacheSize);
+    return std::make_unique<HostCache>(cache_size ? cache_size
+                                                  : kDefaultCacheSize);
   } else {
     return nullptr;
   }
@@ -153,8 +155,15 @@ ResolveContext::ServerStats::~ServerStats() = default;
 
 ResolveContext::ResolveContext(URLRequestContext* url_request_context,
                                bool enable_caching)
+    : ResolveContext(url_request_context,
+                     enable_caching,
+                     /*host_cache_size=*/0) {}
+
+ResolveContext::ResolveContext(URLRequestContext* url_request_context,
+                               bool enable_caching,
+                               size_t host_cache_size)
     : url_request_context_(url_request_context),
-      host_cache_(CreateHostCache(enable_caching)),
+      host_cache_(CreateHostCache(enable_caching, host_cache_size)),
       host_resolver_cache_(CreateHostResolverCache(enable_caching)),
       isolation_info_(IsolationInfo::CreateTransient()) {
   max_fallback_period_ = GetMaxFallbackPeriod();
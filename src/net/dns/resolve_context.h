@@ -85,6 +85,11 @@ class NET_EXPORT_PRIVATE ResolveContext : public base::CheckedObserver {
   };
 
   ResolveContext(URLRequestContext* url_request_context, bool enable_caching);
+  // With a HostCache of up to `host_cache_size` entries if caching, or the
+  // default size if 0.
+  ResolveContext(URLRequestContext* url_request_context,
+                 bool enable_caching,
+                 size_t host_cache_size);
 
   ResolveContext(const ResolveContext&) = delete;
   ResolveContext& operator=(const ResolveContext&) = delete;
@@ -145,6 +145,7 @@ HttpNetworkSession::HttpNetworkSession(const HttpNetworkSessionParams& params,
                           context.transport_security_state,
                           &ssl_client_session_cache_,
                           context.sct_auditing_delegate),
+      proxy_connect_race_(params.proxy_connect_race_width),
       quic_session_pool_(context.net_log,
                          context.host_resolver,
                          context.ssl_config_service,
@@ -185,6 +186,10 @@ HttpNetworkSession::HttpNetworkSession(const HttpNetworkSessionParams& params,
   CHECK(http_server_properties_);
   DCHECK(context_.client_socket_factory);
 
+  if (params.enable_proxy_key_share_tuning) {
+    ssl_client_context_.set_key_share_tuner(&ssl_key_share_tuner_);
+  }
+
   normal_socket_pool_manager_ = std::make_unique<ClientSocketPoolManagerImpl>(
       CreateCommonConnectJobParams(false /* for_websockets */),
       CreateCommonConnectJobParams(true /* for_websockets */),
@@ -376,7 +381,13 @@ CommonConnectJobParams HttpNetworkSession::CreateCommonConnectJobParams(
       context_.network_quality_estimator, context_.net_log,
       for_websockets ? &websocket_endpoint_lock_manager_ : nullptr,
       context_.http_server_properties, &next_protos_, &application_settings_,
-      &params_.ignore_certificate_errors, &params_.enable_early_data);
+      &params_.ignore_certificate_errors, &params_.enable_early_data,
+      &params_.enable_proxy_early_data, &params_.enable_proxy_kernel_tls,
+      &params_.enable_socks5_pipelining,
+      &params_.enable_connect_while_resolving,
+      // WebSocket connections lock their endpoints one at a time.
+      !for_websockets && proxy_connect_race_.width() > 1 ? &proxy_connect_race_
+                                                         : nullptr);
 }
 
 ClientSocketPoolManager* HttpNetworkSession::GetSocketPoolManager(
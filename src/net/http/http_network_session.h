@@ -34,9 +34,11 @@
 #include "net/quic/quic_session_pool.h"
 #include "net/socket/connect_job.h"
 #include "net/socket/next_proto.h"
+#include "net/socket/transport_connect_race.h"
 #include "net/socket/websocket_endpoint_lock_manager.h"
 #include "net/spdy/spdy_session_pool.h"
 #include "net/ssl/ssl_client_session_cache.h"
+#include "net/ssl/ssl_key_share_tuner.h"
 #include "net/third_party/quiche/src/quiche/spdy/core/spdy_protocol.h"
 
 namespace base {
@@ -143,6 +145,25 @@ struct NET_EXPORT HttpNetworkSessionParams {
 
   // Enables 0-RTT support.
   bool enable_early_data;
+  // Enables 0-RTT on TLS connections to HTTPS proxies, sending the CONNECT
+  // of the first tunnel of a resumed session as early data, which may be
+  // replayed.
+  bool enable_proxy_early_data = false;
+  // Lets the kernel encrypt the records written on TLS connections to HTTPS
+  // proxies, where supported. See SSLConfig::kernel_tls_enabled.
+  bool enable_proxy_kernel_tls = false;
+  // Writes the CONNECT request of SOCKS5 proxies with the greeting, without
+  // waiting for its reply. See SOCKS5ClientSocket.
+  bool enable_socks5_pipelining = false;
+  // Connects directly to hosts over the first address family resolved, while
+  // the other is still being resolved. See TransportConnectJob.
+  bool enable_connect_while_resolving = false;
+  // Connects to up to this many addresses of a proxy at once, and tries the
+  // fastest one first next time. See TransportConnectRace.
+  size_t proxy_connect_race_width = 1;
+  // Chooses per HTTPS proxy whether to offer the post-quantum key share, by
+  // the measured handshake times. See SSLKeyShareTuner.
+  bool enable_proxy_key_share_tuning = false;
 
   // Enables QUIC support.
   bool enable_quic = true;
@@ -221,6 +242,9 @@ class NET_EXPORT HttpNetworkSession {
 
   HttpAuthCache* http_auth_cache() { return &http_auth_cache_; }
   SSLClientContext* ssl_client_context() { return &ssl_client_context_; }
+  SSLClientSessionCache* ssl_client_session_cache() {
+    return &ssl_client_session_cache_;
+  }
 
   void StartResponseDrainer(std::unique_ptr<HttpResponseBodyDrainer> drainer);
 
@@ -331,8 +355,10 @@ class NET_EXPORT HttpNetworkSession {
 
   HttpAuthCache http_auth_cache_;
   SSLClientSessionCache ssl_client_session_cache_;
+  SSLKeyShareTuner ssl_key_share_tuner_;
   SSLClientContext ssl_client_context_;
   WebSocketEndpointLockManager websocket_endpoint_lock_manager_;
+  TransportConnectRace proxy_connect_race_;
   std::unique_ptr<ClientSocketPoolManager> normal_socket_pool_manager_;
   std::unique_ptr<ClientSocketPoolManager> websocket_socket_pool_manager_;
   QuicSessionPool quic_session_pool_;
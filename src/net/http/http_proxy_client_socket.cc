@@ -151,6 +151,10 @@ void HttpProxyClientSocket::ApplySocketTag(const SocketTag& tag) {
   return socket_->ApplySocketTag(tag);
 }
 
+int HttpProxyClientSocket::SetDiffServCodePoint(DiffServCodePoint dscp) {
+  return socket_->SetDiffServCodePoint(dscp);
+}
+
 int HttpProxyClientSocket::Read(IOBuffer* buf,
                                 int buf_len,
                                 CompletionOnceCallback callback) {
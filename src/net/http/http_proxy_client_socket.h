@@ -74,6 +74,7 @@ class NET_EXPORT_PRIVATE HttpProxyClientSocket : public ProxyClientSocket {
   bool GetSSLInfo(SSLInfo* ssl_info) override;
   int64_t GetTotalReceivedBytes() const override;
   void ApplySocketTag(const SocketTag& tag) override;
+  int SetDiffServCodePoint(DiffServCodePoint dscp) override;
 
   // Socket implementation.
   int Read(IOBuffer* buf,
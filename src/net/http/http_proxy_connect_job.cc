@@ -638,6 +638,10 @@ int HttpProxyConnectJob::DoHttpProxyConnectComplete(int result) {
     return ERR_PROXY_HTTP_1_1_REQUIRED;
   }
 
+  if (RestartAfterEarlyDataRejected(result)) {
+    return OK;
+  }
+
   // In TLS 1.2 with False Start or TLS 1.3, alerts from the server rejecting
   // our client certificate are received at the first Read(), not Connect(), so
   // the error mapping in DoTransportConnectComplete does not apply. Repeat the
@@ -689,7 +693,8 @@ int HttpProxyConnectJob::DoSpdyProxyCreateStream() {
   return spdy_stream_request_->StartRequest(
       SPDY_BIDIRECTIONAL_STREAM, spdy_session,
       GURL("https://" + params_->endpoint().ToString()),
-      false /* no early data */, kH2QuicTunnelPriority, socket_tag(),
+      *common_connect_job_params()->enable_proxy_early_data,
+      kH2QuicTunnelPriority, socket_tag(),
       spdy_session->net_log(),
       base::BindOnce(&HttpProxyConnectJob::OnIOComplete,
                      base::Unretained(this)),
@@ -707,6 +712,9 @@ int HttpProxyConnectJob::DoSpdyProxyCreateStreamComplete(int result) {
     }
 
     spdy_stream_request_.reset();
+    if (RestartAfterEarlyDataRejected(result)) {
+      return OK;
+    }
     return result;
   }
 
@@ -863,6 +871,21 @@ int HttpProxyConnectJob::DoRestartWithAuthComplete(int result) {
   return result;
 }
 
+bool HttpProxyConnectJob::RestartAfterEarlyDataRejected(int result) {
+  if (has_restarted_after_early_data_ ||
+      (result != ERR_EARLY_DATA_REJECTED &&
+       result != ERR_WRONG_VERSION_ON_EARLY_DATA)) {
+    return false;
+  }
+  // The request sent as early data was lost. The session cache no longer
+  // offers early data for the proxy, so the new connection waits for the
+  // handshake.
+  has_restarted_after_early_data_ = true;
+  transport_socket_.reset();
+  next_state_ = STATE_BEGIN_CONNECT;
+  return true;
+}
+
 void HttpProxyConnectJob::ChangePriorityInternal(RequestPriority priority) {
   // Do not set the priority on |spdy_stream_request_| or
   // |quic_session_request_|, since those should always use
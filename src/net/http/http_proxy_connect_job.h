@@ -269,6 +269,10 @@ class NET_EXPORT_PRIVATE HttpProxyConnectJob : public ConnectJob,
   int DoRestartWithAuth();
   int DoRestartWithAuthComplete(int result);
 
+  // If `result` means the proxy rejected the 0-RTT data of the connection,
+  // prepares to connect once more and returns true.
+  bool RestartAfterEarlyDataRejected(int result);
+
   // ConnectJob implementation.
   void ChangePriorityInternal(RequestPriority priority) override;
   void OnTimedOutInternal() override;
@@ -288,6 +292,7 @@ class NET_EXPORT_PRIVATE HttpProxyConnectJob : public ConnectJob,
   State next_state_ = STATE_NONE;
 
   bool has_restarted_ = false;
+  bool has_restarted_after_early_data_ = false;
 
   // Set to true once a connection has been successfully established. Remains
   // true even if a new socket is being connected to retry with auth.
@@ -87,6 +87,12 @@ uint32_t NetLog::NextID() {
 
 void NetLog::AddObserver(NetLog::ThreadSafeObserver* observer,
                          NetLogCaptureMode capture_mode) {
+  AddObserver(observer, capture_mode, NetLogEventTypeSet().set());
+}
+
+void NetLog::AddObserver(NetLog::ThreadSafeObserver* observer,
+                         NetLogCaptureMode capture_mode,
+                         const NetLogEventTypeSet& event_types) {
   base::AutoLock lock(lock_);
 
   DCHECK(!observer->net_log_);
@@ -97,6 +103,7 @@ void NetLog::AddObserver(NetLog::ThreadSafeObserver* observer,
 
   observer->net_log_ = this;
   observer->capture_mode_ = capture_mode;
+  observer->event_types_ = event_types;
   UpdateObserverCaptureModes();
 }
 
@@ -111,6 +118,7 @@ void NetLog::RemoveObserver(NetLog::ThreadSafeObserver* observer) {
 
   observer->net_log_ = nullptr;
   observer->capture_mode_ = NetLogCaptureMode::kDefault;
+  observer->event_types_.reset();
   UpdateObserverCaptureModes();
 }
 
@@ -144,11 +152,23 @@ void NetLog::UpdateObserverCaptureModes() {
   lock_.AssertAcquired();
 
   NetLogCaptureModeSet capture_mode_set = 0;
+  NetLogEventTypeSet event_types;
   for (const net::NetLog::ThreadSafeObserver* observer : observers_) {
     NetLogCaptureModeSetAdd(observer->capture_mode_, &capture_mode_set);
+    event_types |= observer->event_types_;
   }
 
   base::subtle::NoBarrier_Store(&observer_capture_modes_, capture_mode_set);
+  for (size_t i = 0; i < kNumEventTypeWords; ++i) {
+    uint32_t word = 0;
+    for (size_t j = 0; j < kEventTypeWordBits; ++j) {
+      size_t index = i * kEventTypeWordBits + j;
+      if (index < event_types.size() && event_types.test(index))
+        word |= 1u << j;
+    }
+    base::subtle::NoBarrier_Store(&observed_event_types_[i],
+                                  static_cast<base::subtle::Atomic32>(word));
+  }
 
   // Notify any capture mode observers with the new |capture_mode_set|.
   for (net::NetLog::ThreadSafeCaptureModeObserver* capture_mode_observer :
@@ -252,8 +272,10 @@ void NetLog::AddEntryInternal(NetLogEventType type,
     // Notify all of the log observers with |capture_mode|.
     base::AutoLock lock(lock_);
     for (net::NetLog::ThreadSafeObserver* observer : observers_) {
-      if (observer->capture_mode() == capture_mode)
+      if (observer->capture_mode() == capture_mode &&
+          observer->event_types_.test(static_cast<size_t>(type))) {
         observer->OnAddEntry(entry);
+      }
     }
   }
 }
@@ -276,7 +298,8 @@ void NetLog::AddEntryAtTimeWithMaterializedParams(NetLogEventType type,
   // Notify all of the log observers, regardless of capture mode.
   base::AutoLock lock(lock_);
   for (net::NetLog::ThreadSafeObserver* observer : observers_) {
-    observer->OnAddEntry(entry);
+    if (observer->event_types_.test(static_cast<size_t>(type)))
+      observer->OnAddEntry(entry);
   }
 }
 
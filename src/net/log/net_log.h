@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+#include <array>
+#include <bitset>
 #include <string>
 #include <vector>
 
@@ -30,6 +32,10 @@ namespace net {
 
 class NetLogWithSource;
 
+// A set of event types, indexed by NetLogEventType.
+using NetLogEventTypeSet =
+    std::bitset<static_cast<size_t>(NetLogEventType::COUNT)>;
+
 // NetLog is the destination for log messages generated by the network stack.
 // Each log message has a "source" field which identifies the specific entity
 // that generated the message (for example, which URLRequest or which
@@ -133,9 +139,10 @@ class NET_EXPORT NetLog {
    private:
     friend class NetLog;
 
-    // Both of these values are only modified by the NetLog.
+    // These values are only modified by the NetLog.
     NetLogCaptureMode capture_mode_ = NetLogCaptureMode::kDefault;
     raw_ptr<NetLog> net_log_ = nullptr;
+    NetLogEventTypeSet event_types_;
   };
 
   // An observer that is notified of changes in the capture mode set, and has
@@ -226,7 +233,7 @@ class NET_EXPORT NetLog {
            const NetLogSource& source,
            NetLogEventPhase phase,
            const ParametersCallback& get_params) {
-    if (LIKELY(!IsCapturing()))
+    if (LIKELY(!IsCapturingEventType(type)))
       return;
 
     AddEntryWithMaterializedParams(type, source, phase, get_params());
@@ -243,7 +250,7 @@ class NET_EXPORT NetLog {
            const NetLogSource& source,
            NetLogEventPhase phase,
            const ParametersCallback& get_params) {
-    if (LIKELY(!IsCapturing()))
+    if (LIKELY(!IsCapturingEventType(type)))
       return;
 
     // Indirect through virtual dispatch to reduce code bloat, as this is
@@ -293,6 +300,16 @@ class NET_EXPORT NetLog {
     return GetObserverCaptureModes() != 0;
   }
 
+  // Returns true if any observer attached to the NetLog wants entries of
+  // |type|. Entries of other types are dropped before their parameters are
+  // materialized.
+  bool IsCapturingEventType(NetLogEventType type) const {
+    size_t index = static_cast<size_t>(type);
+    uint32_t word = static_cast<uint32_t>(base::subtle::NoBarrier_Load(
+        &observed_event_types_[index / kEventTypeWordBits]));
+    return (word >> (index % kEventTypeWordBits)) & 1;
+  }
+
   // Adds an observer and sets its log capture mode.  The observer must not be
   // watching any NetLog, including this one, when this is called.
   //
@@ -308,6 +325,13 @@ class NET_EXPORT NetLog {
   void AddObserver(ThreadSafeObserver* observer,
                    NetLogCaptureMode capture_mode);
 
+  // Like AddObserver(), but the observer is only notified of entries whose
+  // type is in |event_types|. If no observer wants a type, entries of that
+  // type cost a single atomic load.
+  void AddObserver(ThreadSafeObserver* observer,
+                   NetLogCaptureMode capture_mode,
+                   const NetLogEventTypeSet& event_types);
+
   // Removes an observer.
   //
   // For thread safety reasons, it is recommended that this not be called in
@@ -347,6 +371,11 @@ class NET_EXPORT NetLog {
   static const char* EventPhaseToString(NetLogEventPhase event_phase);
 
  private:
+  static constexpr size_t kEventTypeWordBits = 32;
+  static constexpr size_t kNumEventTypeWords =
+      (static_cast<size_t>(NetLogEventType::COUNT) + kEventTypeWordBits - 1) /
+      kEventTypeWordBits;
+
   class GetParamsInterface {
    public:
     virtual base::Value::Dict GetParams(NetLogCaptureMode mode) const = 0;
@@ -386,7 +415,8 @@ class NET_EXPORT NetLog {
                                             base::Value::Dict params);
 
   // Called whenever an observer is added or removed, to update
-  // |observer_capture_modes_|. Must have acquired |lock_| prior to calling.
+  // |observer_capture_modes_| and |observed_event_types_|. Must have acquired
+  // |lock_| prior to calling.
   void UpdateObserverCaptureModes();
 
   // Returns true if |observer| is watching this NetLog. Must
@@ -406,6 +436,11 @@ class NET_EXPORT NetLog {
   // accessed and updated more efficiently.
   base::subtle::Atomic32 observer_capture_modes_ = 0;
 
+  // Holds the union of the event types that observers want, as a bitmap
+  // indexed by NetLogEventType. Is all 0 when there are no observers.
+  std::array<base::subtle::Atomic32, kNumEventTypeWords>
+      observed_event_types_ = {};
+
   // |observers_| is a list of observers, ordered by when they were added.
   // Pointers contained in |observers_| are non-owned, and must
   // remain valid.
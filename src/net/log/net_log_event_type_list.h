@@ -602,6 +602,9 @@ EVENT_TYPE(SOCKS_UNKNOWN_ADDRESS_TYPE)
 //    "cipher_suite": <Integer code for the cipher suite>,
 //    "is_resumed": <Whether we resumed a session>,
 //    "next_proto": <The next protocol negotiated via ALPN>,
+//    "key_exchange_group": <The key exchange group negotiated>,
+//    "post_quantum_offered": <Whether the ClientHello offered the
+//                             post-quantum key share>,
 //  }
 EVENT_TYPE(SSL_CONNECT)
 
@@ -718,6 +721,16 @@ EVENT_TYPE(SOCKET_CLOSED)
 //  }
 EVENT_TYPE(SSL_CERTIFICATES_RECEIVED)
 
+// The SSL server sent its certificates compressed (RFC 8879), before they are
+// decompressed. The following
+// parameters are attached to the event:
+//  {
+//    "algorithm": <The compression algorithm, as an integer>,
+//    "compressed_bytes": <Size of the compressed certificates>,
+//    "uncompressed_bytes": <Size of the certificates>,
+//  }
+EVENT_TYPE(SSL_COMPRESSED_CERTIFICATES_RECEIVED)
+
 // Signed Certificate Timestamps were received from the server.
 // The following parameters are attached to the event:
 // {
@@ -2251,6 +2264,15 @@ EVENT_TYPE(QUIC_SESSION_CRYPTO_HANDSHAKE_MESSAGE_SENT)
 //   }
 EVENT_TYPE(QUIC_SESSION_TRANSPORT_PARAMETERS_RECEIVED)
 
+// A QUIC session set up its congestion control from the negotiated config.
+//   {
+//     "congestion_control": <Name of the send algorithm>,
+//     "initial_congestion_window": <In packets>,
+//     "max_packet_length": <In bytes>,
+//     "max_pacing_rate": <In bits per second, zero for no limit>,
+//   }
+EVENT_TYPE(QUIC_SESSION_CONGESTION_CONTROL)
+
 // A QUIC connection sent transport parameters.
 //   {
 //     "quic_transport_parameters": <Human readable view of the transport
@@ -2746,6 +2768,15 @@ EVENT_TYPE(QUIC_SUCCESSFULLY_MIGRATED_TO_SERVER_PREFERRED_ADDRESS)
 //   }
 EVENT_TYPE(QUIC_READ_ERROR)
 
+// The kernel dropped QUIC packets for a full socket receive buffer.
+// The following parameters are attached to the event:
+//   {
+//     "dropped": <Packets dropped since the last event>,
+//     "total": <Packets dropped on the socket>,
+//     "receive_buffer_size": <Size of the receive buffer from now on>,
+//   }
+EVENT_TYPE(QUIC_READ_DROPS)
+
 // ------------------------------------------------------------------------
 // HttpStreamParser
 // ------------------------------------------------------------------------
@@ -8,6 +8,7 @@
 #include "base/functional/bind.h"
 #include "base/location.h"
 #include "base/memory/raw_ptr.h"
+#include "base/message_loop/message_pump.h"
 #include "base/task/sequenced_task_runner.h"
 #include "base/time/tick_clock.h"
 #include "base/time/time.h"
@@ -30,19 +31,30 @@ class QuicChromeAlarm : public quic::QuicAlarm, public base::TickClock {
         on_alarm_callback_(base::BindRepeating(&QuicChromeAlarm::OnAlarm,
                                                base::Unretained(this))),
         timer_(std::make_unique<base::OneShotTimer>(this)) {
-    timer_->SetTaskRunner(std::move(task_runner));
+    timer_->SetTaskRunner(task_runner);
+    precise_timer_.SetTaskRunner(std::move(task_runner));
   }
 
  protected:
   void SetImpl() override {
     DCHECK(deadline().IsInitialized());
     const int64_t delay_us = (deadline() - clock_->Now()).ToMicroseconds();
+    // While wake-ups are aligned to save power, the alarms still fire on
+    // time, as they pace, acknowledge and retransmit packets. The deadline is
+    // taken from `clock_`, as for `timer_`.
+    if (base::MessagePump::GetAlignWakeUpsEnabled()) {
+      precise_timer_.Start(FROM_HERE, NowTicks() + base::Microseconds(delay_us),
+                           on_alarm_callback_,
+                           base::subtle::DelayPolicy::kPrecise);
+      return;
+    }
     timer_->Start(FROM_HERE, base::Microseconds(delay_us), on_alarm_callback_);
   }
 
   void CancelImpl() override {
     DCHECK(!deadline().IsInitialized());
     timer_->Stop();
+    precise_timer_.Stop();
   }
 
  private:
@@ -70,6 +82,7 @@ class QuicChromeAlarm : public quic::QuicAlarm, public base::TickClock {
   const raw_ptr<const quic::QuicClock> clock_;
   base::RepeatingClosure on_alarm_callback_;
   const std::unique_ptr<base::OneShotTimer> timer_;
+  base::DeadlineTimer precise_timer_;
 };
 
 }  // namespace
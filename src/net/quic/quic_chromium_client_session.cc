@@ -985,6 +985,11 @@ QuicChromiumClientSession::QuicChromiumClientSession(
   packet_readers_.push_back(std::make_unique<QuicChromiumPacketReader>(
       std::move(socket), clock, this, yield_after_packets, yield_after_duration,
       report_ecn, net_log_));
+  if (session_pool_) {
+    packet_readers_.back()->set_receive_buffer_limits(
+        session_pool_->socket_receive_buffer_size(),
+        session_pool_->max_socket_receive_buffer_size());
+  }
   crypto_stream_ = crypto_client_stream_factory->CreateQuicCryptoClientStream(
       session_key.server_id(), this,
       std::make_unique<ProofVerifyContextChromium>(cert_verify_flags, net_log_),
@@ -1614,8 +1619,27 @@ quic::QuicSSLConfig QuicChromiumClientSession::GetSSLConfig() const {
   return config;
 }
 
+bool QuicChromiumClientSession::ShouldKeepConnectionAlive() const {
+  return keep_alive_when_idle_ ||
+         quic::QuicSpdyClientSessionBase::ShouldKeepConnectionAlive();
+}
+
 void QuicChromiumClientSession::OnConfigNegotiated() {
   quic::QuicSpdyClientSessionBase::OnConfigNegotiated();
+  net_log_.AddEvent(NetLogEventType::QUIC_SESSION_CONGESTION_CONTROL, [&] {
+    const quic::QuicSentPacketManager& manager =
+        connection()->sent_packet_manager();
+    return base::Value::Dict()
+        .Set("congestion_control",
+             quic::CongestionControlTypeToString(
+                 manager.GetSendAlgorithm()->GetCongestionControlType()))
+        .Set("initial_congestion_window",
+             NetLogNumberValue(manager.initial_congestion_window()))
+        .Set("max_packet_length",
+             NetLogNumberValue(connection()->max_packet_length()))
+        .Set("max_pacing_rate",
+             NetLogNumberValue(manager.MaxPacingRate().ToBitsPerSecond()));
+  });
   if (!session_pool_ || !session_pool_->allow_server_migration()) {
     return;
   }
@@ -2989,6 +3013,14 @@ void QuicChromiumClientSession::MaybeMigrateToDifferentPortOnPathDegrading() {
   net_log_.EndEvent(NetLogEventType::QUIC_PORT_MIGRATION_TRIGGERED);
 }
 
+void QuicChromiumClientSession::MigrateToNewPortOnIPAddressChange() {
+  if (!allow_port_migration_ || migrate_session_early_v2_ ||
+      !session_key_.proxy_chain().is_direct() || !session_pool_) {
+    return;
+  }
+  MaybeMigrateToDifferentPortOnPathDegrading();
+}
+
 void QuicChromiumClientSession::
     MaybeMigrateToAlternateNetworkOnPathDegrading() {
   net_log_.AddEvent(
@@ -3385,6 +3417,13 @@ void QuicChromiumClientSession::ResetNonMigratableStreams() {
   });
 }
 
+void QuicChromiumClientSession::ReleaseEmptyStreamBuffers() {
+  PerformActionOnActiveStreams([](quic::QuicStream* stream) {
+    static_cast<QuicChromiumClientStream*>(stream)->ReleaseReadBufferIfEmpty();
+    return true;
+  });
+}
+
 void QuicChromiumClientSession::LogMetricsOnNetworkDisconnected() {
   if (most_recent_path_degrading_timestamp_ != base::TimeTicks()) {
     most_recent_network_disconnected_timestamp_ = tick_clock_->NowTicks();
@@ -3559,6 +3598,12 @@ base::Value::Dict QuicChromiumClientSession::GetInfoAsValue(
   dict.Set("packets_sent", static_cast<int>(stats.packets_sent));
   dict.Set("packets_received", static_cast<int>(stats.packets_received));
   dict.Set("packets_lost", static_cast<int>(stats.packets_lost));
+  uint64_t receive_drops = 0;
+  for (const auto& reader : packet_readers_)
+    receive_drops += reader->receive_drops();
+  dict.Set("receive_drops", NetLogNumberValue(receive_drops));
+  dict.Set("blocked_frames_sent", logger_->num_blocked_frames_sent());
+  dict.Set("blocked_frames_received", logger_->num_blocked_frames_received());
   SSLInfo ssl_info;
 
   base::Value::List alias_list;
@@ -3811,6 +3856,9 @@ void QuicChromiumClientSession::FinishMigrate(
   auto new_reader = std::make_unique<QuicChromiumPacketReader>(
       std::move(socket), clock_, this, yield_after_packets_,
       yield_after_duration_, session_pool_->report_ecn(), net_log_);
+  new_reader->set_receive_buffer_limits(
+      session_pool_->socket_receive_buffer_size(),
+      session_pool_->max_socket_receive_buffer_size());
   new_reader->StartReading();
   auto new_writer = std::make_unique<QuicChromiumPacketWriter>(
       new_reader->socket(), task_runner_);
@@ -3875,6 +3923,9 @@ bool QuicChromiumClientSession::MigrateToSocket(
   }
 
   packet_readers_.push_back(std::move(reader));
+  if (dscp_ != DSCP_NO_CHANGE) {
+    packet_readers_.back()->socket()->SetTos(dscp_, ECN_NO_CHANGE);
+  }
   // Force the writer to be blocked to prevent it being used until
   // WriteToNewSocket completes.
   DVLOG(1) << "Force blocking the packet writer";
@@ -3913,6 +3964,12 @@ const DatagramClientSocket* QuicChromiumClientSession::GetDefaultSocket()
   return packet_readers_.back()->socket();
 }
 
+int QuicChromiumClientSession::SetDiffServCodePoint(DiffServCodePoint dscp) {
+  dscp_ = dscp;
+  // The ECN bits are left to the packet writer.
+  return packet_readers_.back()->socket()->SetTos(dscp, ECN_NO_CHANGE);
+}
+
 handles::NetworkHandle QuicChromiumClientSession::GetCurrentNetwork() const {
   // If connection migration is enabled, alternate network interface may be
   // used to send packet, it is identified as the bound network of the default
@@ -3977,6 +4034,40 @@ QuicChromiumClientSession::Handle::GetGuaranteedLargestMessagePayload() const {
   return session_->GetGuaranteedLargestMessagePayload();
 }
 
+bool QuicChromiumClientSession::Handle::GetPathQuality(
+    base::TimeDelta* smoothed_rtt,
+    int64_t* bandwidth) const {
+  if (!session_ || !session_->connection()) {
+    return false;
+  }
+  const quic::QuicSentPacketManager& sent_packet_manager =
+      session_->connection()->sent_packet_manager();
+  *smoothed_rtt = base::Microseconds(
+      sent_packet_manager.GetRttStats()->smoothed_rtt().ToMicroseconds());
+  *bandwidth = sent_packet_manager.BandwidthEstimate().ToBytesPerSecond();
+  return true;
+}
+
+bool QuicChromiumClientSession::Handle::GetPacketCounts(
+    uint64_t* packets_sent,
+    uint64_t* packets_lost) const {
+  if (!session_ || !session_->connection()) {
+    return false;
+  }
+  const quic::QuicConnectionStats& stats = session_->connection()->GetStats();
+  *packets_sent = stats.packets_sent;
+  *packets_lost = stats.packets_lost;
+  return true;
+}
+
+int QuicChromiumClientSession::Handle::SetDiffServCodePoint(
+    DiffServCodePoint dscp) {
+  if (!session_) {
+    return ERR_CONNECTION_CLOSED;
+  }
+  return session_->SetDiffServCodePoint(dscp);
+}
+
 #if BUILDFLAG(ENABLE_WEBSOCKETS)
 std::unique_ptr<WebSocketQuicStreamAdapter>
 QuicChromiumClientSession::CreateWebSocketQuicStreamAdapterImpl(
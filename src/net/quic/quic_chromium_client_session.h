@@ -43,6 +43,7 @@
 #include "net/quic/quic_crypto_client_config_handle.h"
 #include "net/quic/quic_http3_logger.h"
 #include "net/quic/quic_session_key.h"
+#include "net/socket/diff_serv_code_point.h"
 #include "net/socket/socket_performance_watcher.h"
 #include "net/spdy/http2_priority_dependencies.h"
 #include "net/spdy/multiplexed_session.h"
@@ -304,6 +305,20 @@ class NET_EXPORT_PRIVATE QuicChromiumClientSession
     // closed.
     quic::QuicPacketLength GetGuaranteedLargestMessagePayload() const;
 
+    // Copies the smoothed RTT and the bandwidth estimate of the congestion
+    // controller, in bytes per second, of the connection. Returns false if
+    // the session is closed.
+    bool GetPathQuality(base::TimeDelta* smoothed_rtt,
+                        int64_t* bandwidth) const;
+
+    // Copies the packets sent and those declared lost over the lifetime of
+    // the connection. Returns false if the session is closed.
+    bool GetPacketCounts(uint64_t* packets_sent, uint64_t* packets_lost) const;
+
+    // See QuicChromiumClientSession::SetDiffServCodePoint(). Returns
+    // ERR_CONNECTION_CLOSED if the session is closed.
+    int SetDiffServCodePoint(DiffServCodePoint dscp);
+
 #if BUILDFLAG(ENABLE_WEBSOCKETS)
     // This method returns nullptr on failure, such as when a new bidirectional
     // stream could not be made.
@@ -727,6 +742,7 @@ class NET_EXPORT_PRIVATE QuicChromiumClientSession
   void OnGoAway(const quic::QuicGoAwayFrame& frame) override;
   void OnCanCreateNewOutgoingStream(bool unidirectional) override;
   quic::QuicSSLConfig GetSSLConfig() const override;
+  bool ShouldKeepConnectionAlive() const override;
 
   // QuicSpdyClientSessionBase methods:
   void OnConfigNegotiated() override;
@@ -855,6 +871,12 @@ class NET_EXPORT_PRIVATE QuicChromiumClientSession
 
   void DoMigrationCallback(MigrationCallback callback, MigrationResult rv);
 
+  // Probes a new port after a local IP address change and migrates to it on
+  // success, as on path degrading. Without network handles the new socket
+  // follows the default route, so this moves the session to the new
+  // network. Does nothing unless port migration is allowed.
+  void MigrateToNewPortOnIPAddressChange();
+
   // Migrates session onto new socket, i.e., sets |writer| to be the new
   // default writer and post a task to write to |socket|. |reader| *must*
   // has been started reading from the socket. Returns true if
@@ -896,6 +918,10 @@ class NET_EXPORT_PRIVATE QuicChromiumClientSession
   // returned socket.
   const DatagramClientSocket* GetDefaultSocket() const;
 
+  // Marks the packets of the session with `dscp`, on the default socket and
+  // on the sockets it migrates to.
+  int SetDiffServCodePoint(DiffServCodePoint dscp);
+
   // Returns the network interface that is currently used to send packets.
   // If handles::NetworkHandle is not supported, always return
   // handles::kInvalidNetworkHandle.
@@ -912,6 +938,15 @@ class NET_EXPORT_PRIVATE QuicChromiumClientSession
 
   bool require_confirmation() const { return require_confirmation_; }
 
+  // Sends keepalive PINGs while the session has no streams too, instead of
+  // letting it idle out.
+  void set_keep_alive_when_idle(bool keep_alive) {
+    keep_alive_when_idle_ = keep_alive;
+  }
+
+  // Frees the receive buffers of the streams that hold no data.
+  void ReleaseEmptyStreamBuffers();
+
   // Retrieves any DNS aliases for the given session key from the map stored
   // in `session_pool_`. Includes all known aliases, e.g. from A, AAAA, or
   // HTTPS, not just from the address used for the connection, in no particular
@@ -1093,6 +1128,7 @@ class NET_EXPORT_PRIVATE QuicChromiumClientSession
   raw_ptr<QuicSessionPool> session_pool_;
   base::ObserverList<ConnectivityObserver> connectivity_observer_list_;
   std::vector<std::unique_ptr<QuicChromiumPacketReader>> packet_readers_;
+  DiffServCodePoint dscp_ = DSCP_NO_CHANGE;
   raw_ptr<TransportSecurityState> transport_security_state_;
   raw_ptr<SSLConfigService> ssl_config_service_;
   std::unique_ptr<QuicServerInfo> server_info_;
@@ -1113,6 +1149,7 @@ class NET_EXPORT_PRIVATE QuicChromiumClientSession
   // True when the session is going away, and streams may no longer be created
   // on this session. Existing stream will continue to be processed.
   bool going_away_ = false;
+  bool keep_alive_when_idle_ = false;
   // True when the session receives a go away from server due to port migration.
   bool port_migration_detected_ = false;
   bool quic_connection_migration_attempted_ = false;
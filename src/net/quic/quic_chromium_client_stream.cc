@@ -4,6 +4,7 @@
 
 #include "net/quic/quic_chromium_client_stream.h"
 
+#include <algorithm>
 #include <string_view>
 #include <utility>
 
@@ -103,7 +104,14 @@ void QuicChromiumClientStream::Handle::OnDataAvailable() {
   if (!read_body_callback_)
     return;  // Wait for ReadBody to be called.
 
-  DCHECK(read_body_buffer_);
+  if (!read_body_buffer_) {
+    // Waiting to lend the body.
+    if (!stream_->HasBytesToRead() && !stream_->IsDoneReading())
+      return;
+    ResetAndRun(std::move(read_body_callback_), OK);
+    return;
+  }
+
   DCHECK_GT(read_body_buffer_len_, 0);
 
   int rv = stream_->Read(read_body_buffer_.get(), read_body_buffer_len_);
@@ -229,6 +237,36 @@ int QuicChromiumClientStream::Handle::ReadBody(
   return ERR_IO_PENDING;
 }
 
+int QuicChromiumClientStream::Handle::LendBody(
+    int max_len,
+    base::span<const char>* data,
+    CompletionOnceCallback callback) {
+  ScopedBoolSaver saver(&may_invoke_callbacks_, false);
+  if (IsDoneReading())
+    return OK;
+
+  if (!stream_)
+    return net_error_;
+
+  if (stream_->read_side_closed()) {
+    return OK;
+  }
+
+  int rv = stream_->PeekBody(max_len, data);
+  if (rv != ERR_IO_PENDING)
+    return rv;
+
+  SetCallback(std::move(callback), &read_body_callback_);
+  read_body_buffer_ = nullptr;
+  read_body_buffer_len_ = 0;
+  return ERR_IO_PENDING;
+}
+
+void QuicChromiumClientStream::Handle::MarkBodyConsumed(int len) {
+  if (stream_ && len > 0)
+    stream_->MarkConsumed(len);
+}
+
 int QuicChromiumClientStream::Handle::ReadTrailingHeaders(
     spdy::Http2HeaderBlock* header_block,
     CompletionOnceCallback callback) {
@@ -463,6 +501,12 @@ bool QuicChromiumClientStream::Handle::IsFirstStream() const {
   return stream_->IsFirstStream();
 }
 
+size_t QuicChromiumClientStream::Handle::EstimateMemoryUsage() const {
+  if (!stream_)
+    return 0;
+  return stream_->EstimateMemoryUsage();
+}
+
 bool QuicChromiumClientStream::Handle::can_migrate_to_cellular_network() {
   if (!stream_)
     return false;
@@ -767,6 +811,35 @@ int QuicChromiumClientStream::Read(IOBuffer* buf, int buf_len) {
   return bytes_read;
 }
 
+int QuicChromiumClientStream::PeekBody(int max_len,
+                                       base::span<const char>* data) {
+  DCHECK_GT(max_len, 0);
+
+  if (IsDoneReading())
+    return 0;  // EOF
+
+  if (!HasBytesToRead())
+    return ERR_IO_PENDING;
+
+  // Only the first region is lent, as regions are not contiguous.
+  iovec iov;
+  int num_regions = GetReadableRegions(&iov, 1);
+  DCHECK_EQ(1, num_regions);
+  size_t len = std::min(iov.iov_len, static_cast<size_t>(max_len));
+  *data = base::make_span(static_cast<const char*>(iov.iov_base), len);
+  return static_cast<int>(len);
+}
+
+void QuicChromiumClientStream::ReleaseReadBufferIfEmpty() {
+  sequencer()->ReleaseBufferIfEmpty();
+}
+
+size_t QuicChromiumClientStream::EstimateMemoryUsage() const {
+  // Written data is copied into the send buffer until it is acked.
+  return sizeof(*this) + sequencer()->NumBytesAllocated() +
+         BufferedDataBytes() + send_buffer().stream_bytes_outstanding();
+}
+
 void QuicChromiumClientStream::NotifyHandleOfInitialHeadersAvailableLater() {
   DCHECK(handle_);
   base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "base/containers/circular_deque.h"
+#include "base/containers/span.h"
 #include "base/functional/callback_forward.h"
 #include "base/memory/raw_ptr.h"
 #include "base/memory/scoped_refptr.h"
@@ -70,6 +71,18 @@ class NET_EXPORT_PRIVATE QuicChromiumClientStream
                  int buffer_len,
                  CompletionOnceCallback callback);
 
+    // Like ReadBody(), but sets |data| to at most |max_len| bytes of body
+    // still in the receive buffer of the stream instead of copying them. They
+    // stay there, and |data| valid, until MarkBodyConsumed() or until the
+    // stream is used again. If body is not available, returns ERR_IO_PENDING
+    // and will invoke |callback| with OK asynchronously when data arrive.
+    int LendBody(int max_len,
+                 base::span<const char>* data,
+                 CompletionOnceCallback callback);
+
+    // Consumes |len| bytes of body from the receive buffer of the stream.
+    void MarkBodyConsumed(int len);
+
     // Reads trailing headers into |header_block| and returns the length of
     // the HEADERS frame which contained them. If headers are not available,
     // returns ERR_IO_PENDING and will invoke |callback| asynchronously when
@@ -144,6 +157,8 @@ class NET_EXPORT_PRIVATE QuicChromiumClientStream
     bool HasBytesToRead() const;
     bool IsDoneReading() const;
     bool IsFirstStream() const;
+    // Zero once the stream is closed.
+    size_t EstimateMemoryUsage() const;
 
     base::TimeTicks first_early_hints_time() const {
       return first_early_hints_time_;
@@ -302,6 +317,18 @@ class NET_EXPORT_PRIVATE QuicChromiumClientStream
   // Reads at most |buf_len| bytes into |buf|. Returns the number of bytes read.
   int Read(IOBuffer* buf, int buf_len);
 
+  // Sets |data| to at most |max_len| bytes of body at the start of the
+  // receive buffer, without consuming them. Returns their number, 0 on EOF,
+  // or ERR_IO_PENDING if no body is available.
+  int PeekBody(int max_len, base::span<const char>* data);
+
+  // Frees the receive buffer if it holds no data. Its block index stays
+  // sized for the largest offset buffered so far until then.
+  void ReleaseReadBufferIfEmpty();
+
+  // Estimates the bytes held by the stream and the data it buffers.
+  size_t EstimateMemoryUsage() const;
+
   const NetLogWithSource& net_log() const { return net_log_; }
 
   // Prevents this stream from migrating to a cellular network. May be reset
@@ -4,12 +4,17 @@
 
 #include "net/quic/quic_chromium_packet_reader.h"
 
+#include <algorithm>
+
 #include "base/functional/bind.h"
 #include "base/location.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/task/single_thread_task_runner.h"
+#include "base/values.h"
 #include "net/base/features.h"
 #include "net/base/net_errors.h"
+#include "net/log/net_log_event_type.h"
+#include "net/log/net_log_values.h"
 #include "net/quic/address_utils.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_clock.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_types.h"
@@ -21,6 +26,8 @@ namespace {
 // when the packet length is equal to the read buffer size.
 const size_t kReadBufferSize =
     static_cast<size_t>(quic::kMaxIncomingPacketSize + 1);
+// Coalesced packets take up to the payload of one UDP datagram.
+const size_t kCoalescedReadBufferSize = 65535;
 }  // namespace
 
 QuicChromiumPacketReader::QuicChromiumPacketReader(
@@ -37,7 +44,9 @@ QuicChromiumPacketReader::QuicChromiumPacketReader(
       yield_after_packets_(yield_after_packets),
       yield_after_duration_(yield_after_duration),
       yield_after_(quic::QuicTime::Infinite()),
-      read_buffer_(base::MakeRefCounted<IOBufferWithSize>(kReadBufferSize)),
+      coalesced_reads_(socket_->EnableCoalescedReads() == OK),
+      read_buffer_(base::MakeRefCounted<IOBufferWithSize>(
+          coalesced_reads_ ? kCoalescedReadBufferSize : kReadBufferSize)),
       net_log_(net_log),
       report_ecn_(report_ecn) {}
 
@@ -53,17 +62,24 @@ void QuicChromiumPacketReader::StartReading() {
 
     CHECK(socket_);
     read_pending_ = true;
-    int rv =
-        socket_->Read(read_buffer_.get(), read_buffer_->size(),
-                      base::BindOnce(&QuicChromiumPacketReader::OnReadComplete,
-                                     weak_factory_.GetWeakPtr()));
+    auto callback = base::BindOnce(&QuicChromiumPacketReader::OnReadComplete,
+                                   weak_factory_.GetWeakPtr());
+    int rv;
+    if (coalesced_reads_) {
+      rv = socket_->ReadCoalesced(read_buffer_.get(), read_buffer_->size(),
+                                  &read_segment_size_, std::move(callback));
+    } else {
+      rv = socket_->Read(read_buffer_.get(), read_buffer_->size(),
+                         std::move(callback));
+    }
     UMA_HISTOGRAM_BOOLEAN("Net.QuicSession.AsyncRead", rv == ERR_IO_PENDING);
     if (rv == ERR_IO_PENDING) {
       num_packets_read_ = 0;
       return;
     }
 
-    if (++num_packets_read_ > yield_after_packets_ ||
+    num_packets_read_ += CountPackets(rv);
+    if (num_packets_read_ > yield_after_packets_ ||
         clock_->Now() > yield_after_) {
       num_packets_read_ = 0;
       // Data was read, process it.
@@ -108,28 +124,68 @@ bool QuicChromiumPacketReader::ProcessReadResult(int result) {
     // Report all other errors to the visitor.
     return visitor_->OnReadError(result, socket_.get());
   }
+  CheckReceiveDrops();
 
   quic::QuicEcnCodepoint ecn = quic::ECN_NOT_ECT;
   if (report_ecn_) {
     DscpAndEcn tos = socket_->GetLastTos();
     ecn = static_cast<quic::QuicEcnCodepoint>(tos.ecn);
   }
-  quic::QuicReceivedPacket packet(read_buffer_->data(), result, clock_->Now(),
-                                  /*owns_buffer=*/false, /*ttl=*/0,
-                                  /*ttl_valid=*/true,
-                                  /*packet_headers=*/nullptr,
-                                  /*headers_length=*/0,
-                                  /*owns_header_buffer=*/false, ecn);
   IPEndPoint local_address;
   IPEndPoint peer_address;
   socket_->GetLocalAddress(&local_address);
   socket_->GetPeerAddress(&peer_address);
+  quic::QuicSocketAddress quic_local_address =
+      ToQuicSocketAddress(local_address);
+  quic::QuicSocketAddress quic_peer_address = ToQuicSocketAddress(peer_address);
+  quic::QuicTime now = clock_->Now();
+  int packet_size = coalesced_reads_ && read_segment_size_ > 0
+                        ? read_segment_size_
+                        : result;
   auto self = weak_factory_.GetWeakPtr();
-  // Notifies the visitor that |this| reader gets a new packet, which may delete
-  // |this| if |this| is a connectivity probing reader.
-  return visitor_->OnPacket(packet, ToQuicSocketAddress(local_address),
-                            ToQuicSocketAddress(peer_address)) &&
-         self;
+  for (int offset = 0; offset < result; offset += packet_size) {
+    quic::QuicReceivedPacket packet(
+        read_buffer_->data() + offset, std::min(packet_size, result - offset),
+        now, /*owns_buffer=*/false, /*ttl=*/0, /*ttl_valid=*/true,
+        /*packet_headers=*/nullptr, /*headers_length=*/0,
+        /*owns_header_buffer=*/false, ecn);
+    // Notifies the visitor that |this| reader gets a new packet, which may
+    // delete |this| if |this| is a connectivity probing reader.
+    if (!visitor_->OnPacket(packet, quic_local_address, quic_peer_address) ||
+        !self) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void QuicChromiumPacketReader::CheckReceiveDrops() {
+  uint32_t drop_count = socket_->GetReceiveDropCount();
+  if (drop_count == last_receive_drop_count_)
+    return;
+  // Unsigned arithmetic takes care of the count wrapping around.
+  uint32_t dropped = drop_count - last_receive_drop_count_;
+  last_receive_drop_count_ = drop_count;
+  receive_drops_ += dropped;
+  if (receive_buffer_size_ > 0 &&
+      receive_buffer_size_ < max_receive_buffer_size_) {
+    int32_t size = static_cast<int32_t>(std::min<int64_t>(
+        int64_t{receive_buffer_size_} * 2, max_receive_buffer_size_));
+    if (socket_->SetReceiveBufferSize(size) == OK)
+      receive_buffer_size_ = size;
+  }
+  net_log_.AddEvent(NetLogEventType::QUIC_READ_DROPS, [&] {
+    return base::Value::Dict()
+        .Set("dropped", NetLogNumberValue(dropped))
+        .Set("total", NetLogNumberValue(receive_drops_))
+        .Set("receive_buffer_size", receive_buffer_size_);
+  });
+}
+
+int QuicChromiumPacketReader::CountPackets(int result) const {
+  if (!coalesced_reads_ || result <= 0 || read_segment_size_ <= 0)
+    return 1;
+  return (result + read_segment_size_ - 1) / read_segment_size_;
 }
 
 void QuicChromiumPacketReader::OnReadComplete(int result) {
@@ -6,6 +6,8 @@
 #ifndef NET_QUIC_QUIC_CHROMIUM_PACKET_READER_H_
 #define NET_QUIC_QUIC_CHROMIUM_PACKET_READER_H_
 
+#include <stdint.h>
+
 #include "base/memory/raw_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "net/base/io_buffer.h"
@@ -43,6 +45,10 @@ class NET_EXPORT_PRIVATE QuicChromiumPacketReader {
   // If |report_ecn| is true, then the reader will call GetLastTos() on the
   // socket after each read and report the ECN codepoint in the
   // QuicReceivedPacket.
+  //
+  // If the socket supports coalesced reads, each read takes all the packets
+  // of the same size that the kernel has coalesced, and hands them to the
+  // visitor one by one.
   // TODO(crbug.com/332924003): When the relevant config flags are deprecated,
   // this argument can be removed.
   QuicChromiumPacketReader(std::unique_ptr<DatagramClientSocket> socket,
@@ -64,6 +70,17 @@ class NET_EXPORT_PRIVATE QuicChromiumPacketReader {
 
   DatagramClientSocket* socket() { return socket_.get(); }
 
+  // Doubles the receive buffer of the socket, from |size| up to |max_size|,
+  // whenever the kernel drops packets for lack of room.
+  void set_receive_buffer_limits(int32_t size, int32_t max_size) {
+    receive_buffer_size_ = size;
+    max_receive_buffer_size_ = max_size;
+  }
+
+  // Returns the packets the kernel dropped on the socket for a full receive
+  // buffer, if the socket counts them.
+  uint64_t receive_drops() const { return receive_drops_; }
+
   void CloseSocket();
 
  private:
@@ -71,6 +88,11 @@ class NET_EXPORT_PRIVATE QuicChromiumPacketReader {
   void OnReadComplete(int result);
   // Return true if reading should continue.
   bool ProcessReadResult(int result);
+  // Returns the number of packets in a successful read of |result| bytes.
+  int CountPackets(int result) const;
+  // Accounts for drops reported by the last read and grows the receive
+  // buffer if allowed.
+  void CheckReceiveDrops();
 
   std::unique_ptr<DatagramClientSocket> socket_;
 
@@ -81,7 +103,15 @@ class NET_EXPORT_PRIVATE QuicChromiumPacketReader {
   int yield_after_packets_;
   quic::QuicTime::Delta yield_after_duration_;
   quic::QuicTime yield_after_;
+  // Set if the socket accepted EnableCoalescedReads().
+  const bool coalesced_reads_;
   scoped_refptr<IOBufferWithSize> read_buffer_;
+  // Size of the packets of a coalesced read but the last.
+  int read_segment_size_ = 0;
+  uint32_t last_receive_drop_count_ = 0;
+  uint64_t receive_drops_ = 0;
+  int32_t receive_buffer_size_ = 0;
+  int32_t max_receive_buffer_size_ = 0;
   NetLogWithSource net_log_;
   // Stores whether receiving ECN is in the feature list to avoid accessing
   // the feature list for every packet.
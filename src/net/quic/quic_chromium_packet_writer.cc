@@ -4,6 +4,8 @@
 
 #include "net/quic/quic_chromium_packet_writer.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <utility>
 
@@ -16,6 +18,7 @@
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
 #include "net/quic/quic_chromium_client_session.h"
+#include "net/socket/diff_serv_code_point.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
 
 namespace net {
@@ -31,6 +34,11 @@ enum NotReusableReason {
 
 const int kMaxRetries = 12;  // 2^12 = 4 seconds, which should be a LOT.
 
+// Linux limits segmented writes to 64 segments and to the payload of one
+// UDP datagram over IPv4.
+const int kMaxBatchPackets = 64;
+const size_t kMaxBatchSize = 65507;
+
 void RecordNotReusableReason(NotReusableReason reason) {
   UMA_HISTOGRAM_ENUMERATION("Net.QuicSession.WritePacketNotReusable", reason,
                             NUM_NOT_REUSABLE_REASONS);
@@ -82,12 +90,18 @@ void QuicChromiumPacketWriter::ReusableIOBuffer::Set(const char* buffer,
   std::memcpy(data(), buffer, buf_len);
 }
 
+void QuicChromiumPacketWriter::ReusableIOBuffer::set_size(size_t size) {
+  CHECK_LE(size, capacity_);
+  size_ = size;
+}
+
 QuicChromiumPacketWriter::QuicChromiumPacketWriter(
     DatagramClientSocket* socket,
     base::SequencedTaskRunner* task_runner)
     : socket_(socket),
+      batch_mode_(socket->SupportsSegmentedWrites()),
       packet_(base::MakeRefCounted<ReusableIOBuffer>(
-          quic::kMaxOutgoingPacketSize)) {
+          batch_mode_ ? kMaxBatchSize : quic::kMaxOutgoingPacketSize)) {
   retry_timer_.SetTaskRunner(task_runner);
   write_callback_ = base::BindRepeating(
       &QuicChromiumPacketWriter::OnWriteComplete, weak_factory_.GetWeakPtr());
@@ -126,16 +140,111 @@ quic::WriteResult QuicChromiumPacketWriter::WritePacket(
     const quic::QuicIpAddress& self_address,
     const quic::QuicSocketAddress& peer_address,
     quic::PerPacketOptions* /*options*/,
-    const quic::QuicPacketWriterParams& /*params*/) {
+    const quic::QuicPacketWriterParams& params) {
   CHECK(!IsWriteBlocked());
+  if (params.ecn_codepoint != ecn_codepoint_) {
+    // The packets of a batch are sent with one codepoint.
+    if (batch_mode_) {
+      quic::WriteResult result = FlushBatch();
+      if (result.status != quic::WRITE_STATUS_OK)
+        return result;
+    }
+    SetEcnCodepoint(params.ecn_codepoint);
+  }
+  if (batch_mode_)
+    return WritePacketToBatch(buffer, buf_len);
   SetPacket(buffer, buf_len);
   return WritePacketToSocketImpl();
 }
 
+void QuicChromiumPacketWriter::SetEcnCodepoint(
+    quic::QuicEcnCodepoint ecn_codepoint) {
+  CHECK(socket_);
+  // The codepoints of QUIC and of the socket have the same values.
+  int rv = socket_->SetTos(DSCP_NO_CHANGE,
+                           static_cast<EcnCodePoint>(ecn_codepoint));
+  if (rv != OK) {
+    // The connection stops marking once SupportsEcn() returns false.
+    ecn_supported_ = false;
+    return;
+  }
+  ecn_codepoint_ = ecn_codepoint;
+}
+
+void QuicChromiumPacketWriter::PrepareBatchBuffer() {
+  if (batch_packets_ > 0)
+    return;
+  if (!packet_ || !packet_->HasOneRef() || packet_->capacity() < kMaxBatchSize)
+    packet_ = base::MakeRefCounted<ReusableIOBuffer>(kMaxBatchSize);
+}
+
+quic::WriteResult QuicChromiumPacketWriter::WritePacketToBatch(
+    const char* buffer,
+    size_t buf_len) {
+  // A packet longer than the segments, or one that does not fit, starts a
+  // new batch. If the flush blocks, the connection keeps the packet.
+  if (batch_packets_ > 0 && (buf_len > batch_segment_size_ ||
+                             batch_size_ + buf_len > packet_->capacity())) {
+    quic::WriteResult result = FlushBatch();
+    if (result.status != quic::WRITE_STATUS_OK)
+      return result;
+  }
+
+  PrepareBatchBuffer();
+  CHECK_LE(batch_size_ + buf_len, packet_->capacity());
+  // |buffer| is at the end of the batch if it came from
+  // GetNextWriteLocation(), and may overlap it after a flush.
+  char* location = packet_->data() + batch_size_;
+  if (buffer != location)
+    std::memmove(location, buffer, buf_len);
+  if (batch_packets_ == 0)
+    batch_segment_size_ = buf_len;
+  batch_size_ += buf_len;
+  ++batch_packets_;
+
+  if (buf_len == batch_segment_size_ && batch_packets_ < kMaxBatchPackets &&
+      batch_size_ + batch_segment_size_ <= packet_->capacity()) {
+    return quic::WriteResult(quic::WRITE_STATUS_OK, 0);
+  }
+  quic::WriteResult result = FlushBatch();
+  // The packet is part of the write in flight.
+  if (result.status == quic::WRITE_STATUS_BLOCKED)
+    result.status = quic::WRITE_STATUS_BLOCKED_DATA_BUFFERED;
+  return result;
+}
+
+quic::WriteResult QuicChromiumPacketWriter::FlushBatch() {
+  if (batch_packets_ == 0)
+    return quic::WriteResult(quic::WRITE_STATUS_OK, 0);
+  packet_->set_size(batch_size_);
+  write_segment_size_ =
+      batch_packets_ > 1 ? static_cast<int>(batch_segment_size_) : 0;
+  batch_size_ = 0;
+  batch_segment_size_ = 0;
+  batch_packets_ = 0;
+  quic::WriteResult result = WritePacketToSocketImpl();
+  // The write in flight holds the packets, so nothing is left to buffer.
+  if (quic::IsWriteBlockedStatus(result.status))
+    result.status = quic::WRITE_STATUS_BLOCKED;
+  return result;
+}
+
+void QuicChromiumPacketWriter::TrimToFirstSegment() {
+  if (write_segment_size_ == 0)
+    return;
+  packet_->set_size(write_segment_size_);
+  write_segment_size_ = 0;
+}
+
 void QuicChromiumPacketWriter::WritePacketToSocket(
     scoped_refptr<ReusableIOBuffer> packet) {
   CHECK(!force_write_blocked_);
   CHECK(!IsWriteBlocked());
+  // A rewritten packet replaces any batch, which is left to loss recovery.
+  batch_size_ = 0;
+  batch_segment_size_ = 0;
+  batch_packets_ = 0;
+  write_segment_size_ = 0;
   packet_ = std::move(packet);
   quic::WriteResult result = WritePacketToSocketImpl();
   if (result.error_code != ERR_IO_PENDING)
@@ -148,13 +257,23 @@ quic::WriteResult QuicChromiumPacketWriter::WritePacketToSocketImpl() {
   // When the connection is closed, the socket is cleaned up. If socket is
   // invalidated, packets should not be written to the socket.
   CHECK(socket_);
-  int rv = socket_->Write(packet_.get(), packet_->size(), write_callback_,
-                          kTrafficAnnotation);
+  int rv;
+  if (write_segment_size_ > 0) {
+    rv = socket_->WriteSegmented(packet_.get(), packet_->size(),
+                                 write_segment_size_, write_callback_,
+                                 kTrafficAnnotation);
+  } else {
+    rv = socket_->Write(packet_.get(), packet_->size(), write_callback_,
+                        kTrafficAnnotation);
+  }
 
   if (MaybeRetryAfterWriteError(rv))
     return quic::WriteResult(quic::WRITE_STATUS_BLOCKED_DATA_BUFFERED,
                              ERR_IO_PENDING);
 
+  if (rv != ERR_IO_PENDING)
+    TrimToFirstSegment();
+
   if (rv < 0 && rv != ERR_IO_PENDING && delegate_ != nullptr) {
     // If write error, then call delegate's HandleWriteError, which
     // may be able to migrate and rewrite packet on a new socket.
@@ -208,6 +327,8 @@ std::optional<int> QuicChromiumPacketWriter::MessageTooBigErrorCode() const {
 void QuicChromiumPacketWriter::OnWriteComplete(int rv) {
   DCHECK_NE(rv, ERR_IO_PENDING);
   write_in_progress_ = false;
+  if (rv >= 0)
+    write_segment_size_ = 0;
   if (delegate_ == nullptr)
     return;
 
@@ -215,6 +336,7 @@ void QuicChromiumPacketWriter::OnWriteComplete(int rv) {
     if (MaybeRetryAfterWriteError(rv))
       return;
 
+    TrimToFirstSegment();
     // If write error, then call delegate's HandleWriteError, which
     // may be able to migrate and rewrite packet on a new socket.
     // HandleWriteError returns the outcome of that rewrite attempt.
@@ -267,21 +389,27 @@ bool QuicChromiumPacketWriter::SupportsReleaseTime() const {
 }
 
 bool QuicChromiumPacketWriter::IsBatchMode() const {
-  return false;
+  return batch_mode_;
 }
 
 bool QuicChromiumPacketWriter::SupportsEcn() const {
-  return false;
+  return ecn_supported_;
 }
 
 quic::QuicPacketBuffer QuicChromiumPacketWriter::GetNextWriteLocation(
     const quic::QuicIpAddress& self_address,
     const quic::QuicSocketAddress& peer_address) {
-  return {nullptr, nullptr};
+  if (!batch_mode_ || IsWriteBlocked())
+    return {nullptr, nullptr};
+  PrepareBatchBuffer();
+  // Packets are written here only if one of any size still fits.
+  if (batch_size_ + quic::kMaxOutgoingPacketSize > packet_->capacity())
+    return {nullptr, nullptr};
+  return {packet_->data() + batch_size_, nullptr};
 }
 
 quic::WriteResult QuicChromiumPacketWriter::Flush() {
-  return quic::WriteResult(quic::WRITE_STATUS_OK, 0);
+  return FlushBatch();
 }
 
 bool QuicChromiumPacketWriter::OnSocketClosed(DatagramClientSocket* socket) {
@@ -23,6 +23,11 @@
 namespace net {
 
 // Chrome specific packet writer which uses a datagram Socket for writing data.
+//
+// If the socket supports segmented writes, the writer is in batch mode:
+// packets of the same size are buffered back to back and written with one
+// WriteSegmented() when the batch is full, a shorter packet ends it, or the
+// connection calls Flush().
 class NET_EXPORT_PRIVATE QuicChromiumPacketWriter
     : public quic::QuicPacketWriter {
  public:
@@ -42,6 +47,10 @@ class NET_EXPORT_PRIVATE QuicChromiumPacketWriter
     // capacity()| must be true, |HasOneRef()| must be true.
     void Set(const char* buffer, size_t buf_len);
 
+    // Sets the size of contents written into this->data() directly.
+    // |size <= capacity()| must be true.
+    void set_size(size_t size);
+
    private:
     ~ReusableIOBuffer() override;
     size_t capacity_;
@@ -115,15 +124,39 @@ class NET_EXPORT_PRIVATE QuicChromiumPacketWriter
 
  private:
   void SetPacket(const char* buffer, size_t buf_len);
+  // Marks the packets written from now on with `ecn_codepoint`.
+  void SetEcnCodepoint(quic::QuicEcnCodepoint ecn_codepoint);
+  // Makes |packet_| large enough for a batch, unless one is being buffered.
+  void PrepareBatchBuffer();
+  quic::WriteResult WritePacketToBatch(const char* buffer, size_t buf_len);
+  // Writes the packets buffered in |packet_| and starts a new batch.
+  quic::WriteResult FlushBatch();
+  // Leaves only the first packet of a segmented write in |packet_|, for the
+  // delegate to rewrite. The others are left to loss recovery.
+  void TrimToFirstSegment();
   bool MaybeRetryAfterWriteError(int rv);
   void RetryPacketAfterNoBuffers();
   quic::WriteResult WritePacketToSocketImpl();
   raw_ptr<DatagramClientSocket> socket_;  // Unowned.
   raw_ptr<Delegate> delegate_ = nullptr;  // Unowned.
+  const bool batch_mode_;
   // Reused for every packet write for the lifetime of the writer.  Is
   // moved to the delegate in the case of a write error.
   scoped_refptr<ReusableIOBuffer> packet_;
 
+  // The batch being buffered in |packet_|. All its packets are
+  // |batch_segment_size_| bytes except possibly the last.
+  size_t batch_size_ = 0;
+  size_t batch_segment_size_ = 0;
+  int batch_packets_ = 0;
+  // Segment size of the write of |packet_|, or zero if it is one packet.
+  int write_segment_size_ = 0;
+
+  // The ECN codepoint the socket marks packets with, as set by the
+  // connection. Cleared if the socket cannot set it.
+  quic::QuicEcnCodepoint ecn_codepoint_ = quic::ECN_NOT_ECT;
+  bool ecn_supported_ = true;
+
   // Whether a write is currently in progress: true if an asynchronous write is
   // in flight, or a retry of a previous write is in progress, or session is
   // handling write error of a previous write.
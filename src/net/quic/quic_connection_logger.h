@@ -40,6 +40,13 @@ class NET_EXPORT_PRIVATE QuicConnectionLogger
 
   ~QuicConnectionLogger() override;
 
+  // BLOCKED frames are sent while flow control of the peer stalls sending,
+  // and received while that of this side stalls the peer.
+  int num_blocked_frames_sent() const { return num_blocked_frames_sent_; }
+  int num_blocked_frames_received() const {
+    return num_blocked_frames_received_;
+  }
+
   // quic::QuicPacketCreator::DebugDelegateInterface
   void OnFrameAddedToPacket(const quic::QuicFrame& frame) override;
   void OnStreamFrameCoalesced(const quic::QuicStreamFrame& frame) override;
@@ -13,6 +13,7 @@
 #include "net/base/features.h"
 #include "net/base/host_port_pair.h"
 #include "net/third_party/quiche/src/quiche/quic/core/crypto/quic_crypto_client_config.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_bandwidth.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_connection.h"
 
 namespace net {
@@ -96,6 +97,10 @@ const int64_t kMaxMigrationsToNonDefaultNetworkOnPathDegrading = 5;
 // and does not consume "too much" memory.
 const int32_t kQuicSocketReceiveBufferSize = 1024 * 1024;  // 1MB
 
+// The default maximum receive window sizes for QUIC sessions and streams.
+const int32_t kQuicSessionMaxRecvWindowSize = 15 * 1024 * 1024;  // 15 MB
+const int32_t kQuicStreamMaxRecvWindowSize = 6 * 1024 * 1024;    // 6 MB
+
 // Structure containing simple configuration options and experiments for QUIC.
 struct NET_EXPORT QuicParams {
   QuicParams();
@@ -151,6 +156,19 @@ struct NET_EXPORT QuicParams {
   // wire. Set to zero if not specified and no retransmittable PING will be
   // sent to peer when the wire has no retransmittable packets.
   base::TimeDelta retransmittable_on_wire_timeout;
+  // If nonzero, sessions carrying proxy traffic send a PING after this long
+  // without sending, and do so while they have no streams too, so that idle
+  // ones survive NAT timeouts.
+  base::TimeDelta proxy_keep_alive_interval;
+  // If true, sessions carrying proxy traffic probe the path MTU for packets
+  // of up to quic::kMtuDiscoveryTargetPacketSizeHigh bytes, and go back to
+  // the last validated size if the larger packets are later lost.
+  bool proxy_mtu_discovery = false;
+  // If true, sessions carrying proxy traffic accept ACK_FREQUENCY frames
+  // from the proxy, and both ends ACK by the ACK decimation delay rather
+  // than every quic::kMaxRetransmittablePacketsBeforeAck packets, cutting
+  // the ACKs sent on the reverse path of bulk transfers.
+  bool proxy_ack_decimation = false;
   // Maximum time the session can be alive before crypto handshake is
   // finished.
   base::TimeDelta max_time_before_crypto_handshake =
@@ -178,6 +196,12 @@ struct NET_EXPORT QuicParams {
   // If true, sessions with open streams will attempt to migrate to a different
   // port when the current path is poor.
   bool allow_port_migration = true;
+  // If true and network handles are not supported, sessions attempt to
+  // migrate to a different port when any local IP address changes, instead
+  // of staying on the old path. Requires |allow_port_migration|, and is
+  // exclusive with |close_sessions_on_ip_change| and
+  // |goaway_sessions_on_ip_change|.
+  bool migrate_sessions_on_ip_change = false;
   // A session can be migrated if its idle time is within this period.
   base::TimeDelta idle_session_migration_period =
       kDefaultIdleSessionMigrationPeriod;
@@ -231,6 +255,17 @@ struct NET_EXPORT QuicParams {
   // If true, read Explicit Congestion Notification (ECN) marks from QUIC
   // sockets and report them to the peer.
   bool report_ecn = false;
+  // Receive buffer size of QUIC sockets.
+  int32_t socket_receive_buffer_size = kQuicSocketReceiveBufferSize;
+  // If above |socket_receive_buffer_size|, receive buffers are doubled up to
+  // this size whenever the kernel drops packets for lack of room.
+  int32_t max_socket_receive_buffer_size = 0;
+  // Receive windows announced to the peer for the session and for each
+  // stream. The client does not auto-tune them.
+  int32_t session_max_recv_window_size = kQuicSessionMaxRecvWindowSize;
+  int32_t stream_max_recv_window_size = kQuicStreamMaxRecvWindowSize;
+  // Upper bound of the pacing rate of connections. Zero for no limit.
+  quic::QuicBandwidth max_pacing_rate = quic::QuicBandwidth::Zero();
 };
 
 // QuicContext contains QUIC-related variables that are shared across all of the
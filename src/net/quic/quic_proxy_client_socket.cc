@@ -84,7 +84,12 @@ int QuicProxyClientSocket::RestartWithAuth(CompletionOnceCallback callback) {
 //
 // TODO(mmenke):  Use a single priority value for all QuicProxyClientSockets,
 // regardless of what priority they're created with.
-void QuicProxyClientSocket::SetStreamPriority(RequestPriority priority) {}
+void QuicProxyClientSocket::SetStreamPriority(RequestPriority priority) {
+  // Sends a PRIORITY_UPDATE frame and orders the writes of the session.
+  stream_->SetPriority(quic::QuicStreamPriority(quic::HttpStreamPriority{
+      ConvertRequestPriorityToQuicPriority(priority),
+      kDefaultPriorityIncremental}));
+}
 
 // Sends a HEADERS frame to the proxy with a CONNECT request
 // for the specified endpoint.  Waits for the server to send back
@@ -118,6 +123,34 @@ void QuicProxyClientSocket::Disconnect() {
   stream_->Reset(quic::QUIC_STREAM_CANCELLED);
 }
 
+int QuicProxyClientSocket::ShutdownWrite() {
+  DCHECK(write_callback_.is_null());
+  if (next_state_ != STATE_CONNECT_COMPLETE)
+    return ERR_SOCKET_NOT_CONNECTED;
+
+  // Sends FIN. The stream stays open for reading until the peer sends FIN too.
+  int rv = stream_->WriteStreamData(std::string_view(), /*fin=*/true,
+                                    base::DoNothing());
+  // A pending FIN is sent after the buffered data.
+  return rv == ERR_IO_PENDING ? OK : rv;
+}
+
+bool QuicProxyClientSocket::GetSessionQuality(SessionQuality* quality) const {
+  // The estimates are of the sending direction.
+  if (!session_->GetPathQuality(&quality->smoothed_rtt, &quality->bandwidth))
+    return false;
+  session_->GetPacketCounts(&quality->packets_sent, &quality->packets_lost);
+  return true;
+}
+
+int QuicProxyClientSocket::SetDiffServCodePoint(DiffServCodePoint dscp) {
+  return session_->SetDiffServCodePoint(dscp);
+}
+
+size_t QuicProxyClientSocket::EstimateMemoryUsage() const {
+  return sizeof(*this) + sizeof(*stream_) + stream_->EstimateMemoryUsage();
+}
+
 bool QuicProxyClientSocket::IsConnected() const {
   return next_state_ == STATE_CONNECT_COMPLETE && stream_->IsOpen();
 }
@@ -193,13 +226,54 @@ int QuicProxyClientSocket::Read(IOBuffer* buf,
   return rv;
 }
 
+int QuicProxyClientSocket::LendReadBuffer(int max_len,
+                                          base::span<const char>* data,
+                                          CompletionOnceCallback callback) {
+  DCHECK(connect_callback_.is_null());
+  DCHECK(read_callback_.is_null());
+  DCHECK(!read_buf_);
+  DCHECK(lent_data_.empty());
+
+  if (next_state_ == STATE_DISCONNECTED)
+    return ERR_SOCKET_NOT_CONNECTED;
+
+  if (!stream_->IsOpen()) {
+    return 0;
+  }
+
+  // Completes with OK once body arrives, as a pending ReadIfReady() would.
+  int rv =
+      stream_->LendBody(max_len, data,
+                        base::BindOnce(&QuicProxyClientSocket::OnReadComplete,
+                                       weak_factory_.GetWeakPtr()));
+  if (rv == ERR_IO_PENDING) {
+    read_callback_ = std::move(callback);
+  } else if (rv == 0) {
+    net_log_.AddByteTransferEvent(NetLogEventType::SOCKET_BYTES_RECEIVED, 0,
+                                  nullptr);
+  } else if (rv > 0) {
+    lent_data_ = *data;
+  }
+  return rv;
+}
+
+void QuicProxyClientSocket::ConsumeLentBuffer(int len) {
+  DCHECK_LE(static_cast<size_t>(len), lent_data_.size());
+  if (len > 0) {
+    net_log_.AddByteTransferEvent(NetLogEventType::SOCKET_BYTES_RECEIVED, len,
+                                  lent_data_.data());
+  }
+  lent_data_ = base::span<const char>();
+  stream_->MarkBodyConsumed(len);
+}
+
 void QuicProxyClientSocket::OnReadComplete(int rv) {
   if (!stream_->IsOpen())
     rv = 0;
 
   if (!read_callback_.is_null()) {
-    DCHECK(read_buf_);
-    if (rv >= 0) {
+    // There is no buffer while waiting to lend one.
+    if (read_buf_ && rv >= 0) {
       net_log_.AddByteTransferEvent(NetLogEventType::SOCKET_BYTES_RECEIVED, rv,
                                     read_buf_->data());
     }
@@ -9,6 +9,7 @@
 #include <memory>
 #include <string>
 
+#include "base/containers/span.h"
 #include "base/memory/raw_ptr.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/proxy_chain.h"
@@ -57,6 +58,14 @@ class NET_EXPORT_PRIVATE QuicProxyClientSocket : public ProxyClientSocket {
   // StreamSocket implementation.
   int Connect(CompletionOnceCallback callback) override;
   void Disconnect() override;
+  int ShutdownWrite() override;
+  int LendReadBuffer(int max_len,
+                     base::span<const char>* data,
+                     CompletionOnceCallback callback) override;
+  void ConsumeLentBuffer(int len) override;
+  bool GetSessionQuality(SessionQuality* quality) const override;
+  int SetDiffServCodePoint(DiffServCodePoint dscp) override;
+  size_t EstimateMemoryUsage() const override;
   bool IsConnected() const override;
   bool IsConnectedAndIdle() const override;
   const NetLogWithSource& NetLog() const override;
@@ -121,6 +130,8 @@ class NET_EXPORT_PRIVATE QuicProxyClientSocket : public ProxyClientSocket {
   CompletionOnceCallback read_callback_;
   // Stores the read buffer pointer for Read().
   raw_ptr<IOBuffer> read_buf_ = nullptr;
+  // Bytes lent by LendReadBuffer() until ConsumeLentBuffer().
+  base::span<const char> lent_data_;
   // Stores the callback for Write().
   CompletionOnceCallback write_callback_;
   // Stores the write buffer length for Write().
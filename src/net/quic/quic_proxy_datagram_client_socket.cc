@@ -83,6 +83,12 @@ int QuicProxyDatagramClientSocket::ConnectViaStream(
   return rv;
 }
 
+void QuicProxyDatagramClientSocket::SetExtraRequestHeaders(
+    const HttpRequestHeaders& headers) {
+  DCHECK_EQ(STATE_DISCONNECTED, next_state_);
+  request_.extra_headers.MergeFrom(headers);
+}
+
 int QuicProxyDatagramClientSocket::Connect(const IPEndPoint& address) {
   NOTREACHED_IN_MIGRATION();
   return ERR_NOT_IMPLEMENTED;
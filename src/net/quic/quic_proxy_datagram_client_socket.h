@@ -69,6 +69,10 @@ class NET_EXPORT_PRIVATE QuicProxyDatagramClientSocket
                        std::unique_ptr<QuicChromiumClientStream::Handle> stream,
                        CompletionOnceCallback callback);
 
+  // Adds headers, such as Proxy-Authorization, to the CONNECT-UDP request.
+  // Must be called before ConnectViaStream().
+  void SetExtraRequestHeaders(const HttpRequestHeaders& headers);
+
   // DatagramClientSocket implementation.
   int Connect(const IPEndPoint& address) override;
   int ConnectUsingNetwork(handles::NetworkHandle network,
@@ -123,8 +127,10 @@ class NET_EXPORT_PRIVATE QuicProxyDatagramClientSocket
   static constexpr char kMaxQueueSizeHistogram[] =
       "Net.QuicProxyDatagramClientSocket.MaxQueueSizeReached";
 
-  // Upper bound for datagrams in queue.
-  static constexpr size_t kMaxDatagramQueueSize = 16;
+  // Upper bound for datagrams in queue. A QUIC connection nested in this
+  // socket reads its packets in bursts, between which a round of its peer's
+  // congestion window arrives, so this holds more than a few datagrams.
+  static constexpr size_t kMaxDatagramQueueSize = 256;
 
  private:
   enum State {
@@ -498,7 +498,8 @@ QuicSessionPool::~QuicSessionPool() {
   CertDatabase::GetInstance()->RemoveObserver(this);
   cert_verifier_->RemoveObserver(this);
   if (params_.close_sessions_on_ip_change ||
-      params_.goaway_sessions_on_ip_change) {
+      params_.goaway_sessions_on_ip_change ||
+      params_.migrate_sessions_on_ip_change) {
     NetworkChangeNotifier::RemoveIPAddressObserver(this);
   }
   if (NetworkChangeNotifier::AreNetworkHandlesSupported()) {
@@ -631,6 +632,13 @@ void QuicSessionPool::OnSessionGoingAway(QuicChromiumClientSession* session) {
 
 void QuicSessionPool::OnSessionClosed(QuicChromiumClientSession* session) {
   DCHECK_EQ(0u, session->GetNumActiveStreams());
+  if (!session->OneRttKeysAvailable())
+    MaybeForgetProxyMaxPacketLength(session);
+  auto it = all_sessions_.find(session);
+  if (it != all_sessions_.end() &&
+      it->second.session_key().session_usage() == SessionUsage::kProxy) {
+    AddProxyAckStats(session, &closed_proxy_ack_stats_);
+  }
   OnSessionGoingAway(session);
   delete session;
   all_sessions_.erase(session);
@@ -642,6 +650,23 @@ void QuicSessionPool::OnBlackholeAfterHandshakeConfirmed(
   if (ping_timeout_ > reduced_ping_timeout_) {
     ping_timeout_ = reduced_ping_timeout_;
   }
+  MaybeForgetProxyMaxPacketLength(session);
+}
+
+void QuicSessionPool::MaybeForgetProxyMaxPacketLength(
+    QuicChromiumClientSession* session) {
+  if (proxy_max_packet_length_ == 0 ||
+      session->connection()->max_packet_length() < proxy_max_packet_length_) {
+    return;
+  }
+  auto it = all_sessions_.find(session);
+  if (it == all_sessions_.end() ||
+      it->second.session_key().session_usage() != SessionUsage::kProxy) {
+    return;
+  }
+  DVLOG(1) << "Forgetting proxy max packet length "
+           << proxy_max_packet_length_;
+  proxy_max_packet_length_ = 0;
 }
 
 void QuicSessionPool::CancelRequest(QuicSessionRequest* request) {
@@ -758,13 +783,16 @@ void QuicSessionPool::FinishConnectAndConfigureSocket(
 
   socket->ApplySocketTag(socket_tag);
 
-  rv = socket->SetReceiveBufferSize(kQuicSocketReceiveBufferSize);
+  rv = socket->SetReceiveBufferSize(params_.socket_receive_buffer_size);
   if (rv != OK) {
     OnFinishConnectAndConfigureSocketError(
         std::move(callback), CREATION_ERROR_SETTING_RECEIVE_BUFFER, rv);
     return;
   }
 
+  // Not implemented on all platforms, and only informative.
+  socket->EnableReceiveDropCount();
+
   rv = socket->SetDoNotFragment();
   // SetDoNotFragment is not implemented on all platforms, so ignore errors.
   if (rv != OK && rv != ERR_NOT_IMPLEMENTED) {
@@ -853,12 +881,15 @@ int QuicSessionPool::ConfigureSocket(DatagramClientSocket* socket,
 
   socket->ApplySocketTag(socket_tag);
 
-  rv = socket->SetReceiveBufferSize(kQuicSocketReceiveBufferSize);
+  rv = socket->SetReceiveBufferSize(params_.socket_receive_buffer_size);
   if (rv != OK) {
     HistogramCreateSessionFailure(CREATION_ERROR_SETTING_RECEIVE_BUFFER);
     return rv;
   }
 
+  // Not implemented on all platforms, and only informative.
+  socket->EnableReceiveDropCount();
+
   rv = socket->SetDoNotFragment();
   // SetDoNotFragment is not implemented on all platforms, so ignore errors.
   if (rv != OK && rv != ERR_NOT_IMPLEMENTED) {
@@ -939,6 +970,19 @@ void QuicSessionPool::OnIPAddressChanged() {
   connectivity_monitor_.OnIPAddressChanged();
 
   set_is_quic_known_to_work_on_current_network(false);
+  if (params_.migrate_sessions_on_ip_change) {
+    // Sessions may go away while migrating.
+    std::vector<QuicChromiumClientSession*> sessions;
+    for (const auto& [session, alias_key] : all_sessions_) {
+      sessions.push_back(session);
+    }
+    for (QuicChromiumClientSession* session : sessions) {
+      if (all_sessions_.contains(session)) {
+        session->MigrateToNewPortOnIPAddressChange();
+      }
+    }
+    return;
+  }
   if (params_.close_sessions_on_ip_change) {
     CloseAllSessions(ERR_NETWORK_CHANGED, quic::QUIC_IP_ADDRESS_CHANGED);
   } else {
@@ -1067,6 +1111,48 @@ void QuicSessionPool::set_is_quic_known_to_work_on_current_network(
   }
 }
 
+quic::QuicByteCount QuicSessionPool::GetDiscoveredProxyMaxPacketLength()
+    const {
+  const quic::QuicByteCount default_length =
+      params_.max_packet_length + params_.additional_proxy_packet_length;
+  quic::QuicByteCount length = 0;
+  for (const auto& [key, session] : active_sessions_) {
+    if (key.session_usage() != SessionUsage::kProxy)
+      continue;
+    const quic::QuicConnection* connection = session->connection();
+    if (connection->mtu_probe_count() > 0 &&
+        connection->max_packet_length() > default_length) {
+      length = std::max(length, connection->max_packet_length());
+    }
+  }
+  return length;
+}
+
+QuicSessionPool::ProxyAckStats QuicSessionPool::GetProxyAckStats() const {
+  ProxyAckStats stats = closed_proxy_ack_stats_;
+  for (const auto& [session, key] : all_sessions_) {
+    if (key.session_key().session_usage() == SessionUsage::kProxy)
+      AddProxyAckStats(session, &stats);
+  }
+  return stats;
+}
+
+void QuicSessionPool::ReleaseEmptyProxyStreamBuffers() {
+  for (const auto& [session, key] : all_sessions_) {
+    if (key.session_key().session_usage() == SessionUsage::kProxy)
+      session->ReleaseEmptyStreamBuffers();
+  }
+}
+
+// static
+void QuicSessionPool::AddProxyAckStats(QuicChromiumClientSession* session,
+                                       ProxyAckStats* stats) {
+  const quic::QuicConnectionStats& connection_stats =
+      session->connection()->GetStats();
+  stats->ack_frames_sent += connection_stats.num_ack_frames_sent;
+  stats->bytes_received += connection_stats.bytes_received;
+}
+
 base::TimeDelta QuicSessionPool::GetTimeDelayForWaitingJob(
     const QuicSessionKey& session_key) {
   // If |is_quic_known_to_work_on_current_network_| is false, then one of the
@@ -1486,13 +1572,24 @@ bool QuicSessionPool::CreateSessionHelper(
       ToQuicSocketAddress(peer_address), helper_.get(), alarm_factory_.get(),
       writer, true /* owns_writer */, quic::Perspective::IS_CLIENT,
       {quic_version}, connection_id_generator_);
-  connection->set_keep_alive_ping_timeout(ping_timeout_);
+  const bool keep_alive_when_idle =
+      key.session_key().session_usage() == SessionUsage::kProxy &&
+      params_.proxy_keep_alive_interval.is_positive();
+  if (keep_alive_when_idle) {
+    quic::QuicTime::Delta interval = quic::QuicTime::Delta::FromMicroseconds(
+        params_.proxy_keep_alive_interval.InMicroseconds());
+    connection->set_keep_alive_ping_timeout(std::min(ping_timeout_, interval));
+  } else {
+    connection->set_keep_alive_ping_timeout(ping_timeout_);
+  }
 
   // Calculate the max packet length for this connection. If the session is
   // carrying proxy traffic, add the `additional_proxy_packet_length`.
   size_t max_packet_length = params_.max_packet_length;
   if (key.session_key().session_usage() == SessionUsage::kProxy) {
     max_packet_length += params_.additional_proxy_packet_length;
+    max_packet_length = std::max(
+        max_packet_length, static_cast<size_t>(proxy_max_packet_length_));
   }
   // Restrict that length by the session maximum, if given.
   if (session_max_packet_length > 0) {
@@ -1502,8 +1599,31 @@ bool QuicSessionPool::CreateSessionHelper(
   DVLOG(1) << "Session to " << key.destination().Serialize()
            << " has max packet length " << max_packet_length;
   connection->SetMaxPacketLength(max_packet_length);
+  if (!params_.max_pacing_rate.IsZero()) {
+    connection->SetMaxPacingRate(params_.max_pacing_rate);
+  }
 
   quic::QuicConfig config = config_;
+  if (key.session_key().session_usage() == SessionUsage::kProxy &&
+      params_.proxy_mtu_discovery) {
+    quic::QuicTagVector options = config.ClientRequestedIndependentOptions(
+        quic::Perspective::IS_CLIENT);
+    options.push_back(quic::kMTUH);
+    config.SetClientConnectionOptions(options);
+  }
+  if (key.session_key().session_usage() == SessionUsage::kProxy &&
+      params_.proxy_ack_decimation) {
+    quic::QuicTagVector options = config.ClientRequestedIndependentOptions(
+        quic::Perspective::IS_CLIENT);
+    options.push_back(quic::kAFFE);
+    config.SetClientConnectionOptions(options);
+    // Sent to the proxy, so it also applies to the ACKs of uploads.
+    quic::QuicTagVector connection_options;
+    if (config.HasSendConnectionOptions())
+      connection_options = config.SendConnectionOptions();
+    connection_options.push_back(quic::kAKDU);
+    config.SetConnectionOptionsToSend(connection_options);
+  }
   ConfigureInitialRttEstimate(
       server_id, key.session_key().network_anonymization_key(), &config);
 
@@ -1542,6 +1662,8 @@ bool QuicSessionPool::CreateSessionHelper(
       std::move(socket_performance_watcher), metadata, params_.report_ecn,
       net_log);
 
+  (*session)->set_keep_alive_when_idle(keep_alive_when_idle);
+
   all_sessions_[*session] = std::move(key);  // owning pointer
   writer->set_delegate(*session);
   (*session)->AddConnectivityObserver(&connectivity_monitor_);
@@ -1692,6 +1814,18 @@ void QuicSessionPool::InitializeMigrationOptions() {
     NetworkChangeNotifier::AddIPAddressObserver(this);
   }
 
+  // Port migration stands in for network change migration where network
+  // handles are not supported.
+  if (params_.migrate_sessions_on_ip_change) {
+    DCHECK(!handle_ip_change);
+    if (allow_port_migration &&
+        !NetworkChangeNotifier::AreNetworkHandlesSupported()) {
+      NetworkChangeNotifier::AddIPAddressObserver(this);
+    } else {
+      params_.migrate_sessions_on_ip_change = false;
+    }
+  }
+
   if (allow_port_migration) {
     params_.allow_port_migration = true;
     if (migrate_idle_sessions) {
@@ -1875,13 +2009,17 @@ QuicSessionPool::CreateCryptoConfigHandle(
 
   // Otherwise, create a new QuicCryptoClientConfigOwner and add it to
   // |active_crypto_config_map_|.
+  std::unique_ptr<quic::QuicClientSessionCache> session_cache =
+      session_cache_factory_
+          ? session_cache_factory_.Run()
+          : std::make_unique<quic::QuicClientSessionCache>();
   std::unique_ptr<QuicCryptoClientConfigOwner> crypto_config_owner =
       std::make_unique<QuicCryptoClientConfigOwner>(
           std::make_unique<ProofVerifierChromium>(
               cert_verifier_, transport_security_state_, sct_auditing_delegate_,
               HostsFromOrigins(params_.origins_to_force_quic_on),
               actual_network_anonymization_key),
-          std::make_unique<quic::QuicClientSessionCache>(), this);
+          std::move(session_cache), this);
 
   quic::QuicCryptoClientConfig* crypto_config = crypto_config_owner->config();
   crypto_config->AddCanonicalSuffix(".c.youtube.com");
@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "base/containers/lru_cache.h"
+#include "base/functional/callback.h"
 #include "base/gtest_prod_util.h"
 #include "base/memory/memory_pressure_monitor.h"
 #include "base/memory/raw_ptr.h"
@@ -463,6 +464,13 @@ class NET_EXPORT_PRIVATE QuicSessionPool
     return params_.disable_gquic_zero_rtt;
   }
 
+  int32_t socket_receive_buffer_size() const {
+    return params_.socket_receive_buffer_size;
+  }
+  int32_t max_socket_receive_buffer_size() const {
+    return params_.max_socket_receive_buffer_size;
+  }
+
   // Returns true if QuicSessionPool is configured to report incoming ECN marks.
   bool report_ecn() const {
     return report_ecn_;
@@ -471,6 +479,42 @@ class NET_EXPORT_PRIVATE QuicSessionPool
   void set_is_quic_known_to_work_on_current_network(
       bool is_quic_known_to_work_on_current_network);
 
+  // Creates the TLS session caches of crypto configs created from now on,
+  // instead of in-memory quic::QuicClientSessionCaches.
+  using SessionCacheFactory = base::RepeatingCallback<
+      std::unique_ptr<quic::QuicClientSessionCache>()>;
+  void set_session_cache_factory(SessionCacheFactory factory) {
+    session_cache_factory_ = std::move(factory);
+  }
+
+  // Sets the max packet length sessions carrying proxy traffic start at,
+  // such as one discovered by earlier ones on the same network, if it is
+  // larger than that of the params. Zero keeps that of the params. It is
+  // reset to zero once such a session blackholes or closes before its
+  // handshake completes, as the path MTU may have shrunk.
+  void set_proxy_max_packet_length(quic::QuicByteCount length) {
+    proxy_max_packet_length_ = length;
+  }
+  quic::QuicByteCount proxy_max_packet_length() const {
+    return proxy_max_packet_length_;
+  }
+
+  // Returns the largest max packet length of the active sessions carrying
+  // proxy traffic if path MTU discovery raised it, or zero.
+  quic::QuicByteCount GetDiscoveredProxyMaxPacketLength() const;
+
+  // Counters of the sessions carrying proxy traffic, closed and open.
+  struct ProxyAckStats {
+    uint64_t ack_frames_sent = 0;
+    uint64_t bytes_received = 0;
+  };
+  ProxyAckStats GetProxyAckStats() const;
+
+  // Frees the receive buffers of the streams of the sessions carrying proxy
+  // traffic that hold no data, so idle tunnels do not keep the block
+  // indexes their bulk transfers grew.
+  void ReleaseEmptyProxyStreamBuffers();
+
   // It returns the amount of time waiting job should be delayed.
   base::TimeDelta GetTimeDelayForWaitingJob(const QuicSessionKey& session_key);
 
@@ -649,6 +693,13 @@ class NET_EXPORT_PRIVATE QuicSessionPool
                                const quic::QuicServerId& server_id,
                                bool was_session_active);
 
+  // Resets `proxy_max_packet_length_` if `session` carries proxy traffic in
+  // packets of that length.
+  void MaybeForgetProxyMaxPacketLength(QuicChromiumClientSession* session);
+
+  static void AddProxyAckStats(QuicChromiumClientSession* session,
+                               ProxyAckStats* stats);
+
   // Insert the given alias `key` in the AliasSet for the given `session` in
   // the map `session_aliases_`, and add the given `dns_aliases` for
   // `key.session_key()` in `dns_aliases_by_session_key_`.
@@ -701,6 +752,11 @@ class NET_EXPORT_PRIVATE QuicSessionPool
   // the broken alternative service map in HttpServerProperties.
   bool is_quic_known_to_work_on_current_network_ = false;
 
+  SessionCacheFactory session_cache_factory_;
+
+  quic::QuicByteCount proxy_max_packet_length_ = 0;
+  ProxyAckStats closed_proxy_ack_stats_;
+
   NetLogWithSource net_log_;
   const raw_ptr<HostResolver> host_resolver_;
   const raw_ptr<ClientSocketFactory> client_socket_factory_;
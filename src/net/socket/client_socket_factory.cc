@@ -58,6 +58,19 @@ static base::LazyInstance<DefaultClientSocketFactory>::Leaky
 
 }  // namespace
 
+std::unique_ptr<TransportClientSocket>
+ClientSocketFactory::CreateTransportClientSocketForSession(
+    const AddressList& addresses,
+    std::unique_ptr<SocketPerformanceWatcher> socket_performance_watcher,
+    NetworkQualityEstimator* network_quality_estimator,
+    NetLog* net_log,
+    const NetLogSource& source,
+    const NetworkAnonymizationKey& network_anonymization_key) {
+  return CreateTransportClientSocket(
+      addresses, std::move(socket_performance_watcher),
+      network_quality_estimator, net_log, source);
+}
+
 // static
 ClientSocketFactory* ClientSocketFactory::GetDefaultFactory() {
   return g_default_client_socket_factory.Pointer();
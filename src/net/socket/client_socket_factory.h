@@ -22,6 +22,7 @@ class DatagramClientSocket;
 class HostPortPair;
 class NetLog;
 struct NetLogSource;
+class NetworkAnonymizationKey;
 class SSLClientContext;
 class SSLClientSocket;
 struct SSLConfig;
@@ -50,6 +51,18 @@ class NET_EXPORT ClientSocketFactory {
       NetLog* net_log,
       const NetLogSource& source) = 0;
 
+  // As CreateTransportClientSocket(), for a connection made for the sessions
+  // of `network_anonymization_key`, which the factory may open differently
+  // for different keys. By default the key is ignored.
+  virtual std::unique_ptr<TransportClientSocket>
+  CreateTransportClientSocketForSession(
+      const AddressList& addresses,
+      std::unique_ptr<SocketPerformanceWatcher> socket_performance_watcher,
+      NetworkQualityEstimator* network_quality_estimator,
+      NetLog* net_log,
+      const NetLogSource& source,
+      const NetworkAnonymizationKey& network_anonymization_key);
+
   // It is allowed to pass in a StreamSocket that is not obtained from a
   // socket pool. The caller could create a StreamSocket directly.
   virtual std::unique_ptr<SSLClientSocket> CreateSSLClientSocket(
@@ -12,6 +12,7 @@
 #include "base/check_op.h"
 #include "base/feature_list.h"
 #include "base/functional/bind.h"
+#include "base/hash/hash.h"
 #include "base/strings/strcat.h"
 #include "net/base/features.h"
 #include "net/base/host_port_pair.h"
@@ -102,7 +103,8 @@ ClientSocketPool::SocketParams::CreateForHttpForTesting() {
 }
 
 ClientSocketPool::GroupId::GroupId()
-    : privacy_mode_(PrivacyMode::PRIVACY_MODE_DISABLED) {}
+    : privacy_mode_(PrivacyMode::PRIVACY_MODE_DISABLED),
+      hash_(ComputeHash()) {}
 
 ClientSocketPool::GroupId::GroupId(
     url::SchemeHostPort destination,
@@ -117,7 +119,8 @@ ClientSocketPool::GroupId::GroupId(
               ? std::move(network_anonymization_key)
               : NetworkAnonymizationKey()),
       secure_dns_policy_(secure_dns_policy),
-      disable_cert_network_fetches_(disable_cert_network_fetches) {
+      disable_cert_network_fetches_(disable_cert_network_fetches),
+      hash_(ComputeHash()) {
   DCHECK(destination_.IsValid());
 
   // ClientSocketPool only expected to be used for HTTP/HTTPS/WS/WSS cases, and
@@ -136,6 +139,16 @@ ClientSocketPool::GroupId& ClientSocketPool::GroupId::operator=(
 ClientSocketPool::GroupId& ClientSocketPool::GroupId::operator=(
     GroupId&& group_id) = default;
 
+size_t ClientSocketPool::GroupId::ComputeHash() const {
+  size_t hash = base::FastHash(destination_.host());
+  hash = base::HashInts(hash, base::FastHash(destination_.scheme()));
+  return base::HashInts(
+      hash, (uint32_t{destination_.port()} << 16) |
+                (static_cast<uint32_t>(privacy_mode_) << 8) |
+                (static_cast<uint32_t>(secure_dns_policy_) << 1) |
+                (disable_cert_network_fetches_ ? 1u : 0u));
+}
+
 std::string ClientSocketPool::GroupId::ToString() const {
   return base::StrCat(
       {disable_cert_network_fetches_ ? "disable_cert_network_fetches/" : "",
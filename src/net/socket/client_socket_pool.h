@@ -128,8 +128,11 @@ class NET_EXPORT ClientSocketPool : public LowerLayeredPool {
     // Returns the group ID as a string, for logging.
     std::string ToString() const;
 
+    // Compares the hashes first, so that distinct groups rarely get to
+    // compare their strings.
     bool operator==(const GroupId& other) const {
-      return std::tie(destination_, privacy_mode_, network_anonymization_key_,
+      return hash_ == other.hash_ &&
+             std::tie(destination_, privacy_mode_, network_anonymization_key_,
                       secure_dns_policy_, disable_cert_network_fetches_) ==
              std::tie(other.destination_, other.privacy_mode_,
                       other.network_anonymization_key_,
@@ -138,6 +141,8 @@ class NET_EXPORT ClientSocketPool : public LowerLayeredPool {
     }
 
     bool operator<(const GroupId& other) const {
+      if (hash_ != other.hash_)
+        return hash_ < other.hash_;
       return std::tie(destination_, privacy_mode_, network_anonymization_key_,
                       secure_dns_policy_, disable_cert_network_fetches_) <
              std::tie(other.destination_, other.privacy_mode_,
@@ -147,6 +152,9 @@ class NET_EXPORT ClientSocketPool : public LowerLayeredPool {
     }
 
    private:
+    // Hashes the fields except the network anonymization key.
+    size_t ComputeHash() const;
+
     // The endpoint of the final destination (not the proxy).
     url::SchemeHostPort destination_;
 
@@ -157,12 +165,16 @@ class NET_EXPORT ClientSocketPool : public LowerLayeredPool {
     NetworkAnonymizationKey network_anonymization_key_;
 
     // Controls the Secure DNS behavior to use when creating this socket.
-    SecureDnsPolicy secure_dns_policy_;
+    SecureDnsPolicy secure_dns_policy_ = SecureDnsPolicy::kAllow;
 
     // Whether cert validation-related network fetches are allowed. Should only
     // be true for a very limited number of network-configuration related
     // scripts (e.g., PAC fetches).
-    bool disable_cert_network_fetches_;
+    bool disable_cert_network_fetches_ = false;
+
+    // Of the fields above, computed once as groups are looked up by
+    // every socket request.
+    size_t hash_;
   };
 
   // Parameters that, in combination with GroupId, proxy, websocket information,
@@ -46,7 +46,12 @@ CommonConnectJobParams::CommonConnectJobParams(
     const NextProtoVector* alpn_protos,
     const SSLConfig::ApplicationSettings* application_settings,
     const bool* ignore_certificate_errors,
-    const bool* enable_early_data)
+    const bool* enable_early_data,
+    const bool* enable_proxy_early_data,
+    const bool* enable_proxy_kernel_tls,
+    const bool* enable_socks5_pipelining,
+    const bool* enable_connect_while_resolving,
+    TransportConnectRace* proxy_connect_race)
     : client_socket_factory(client_socket_factory),
       host_resolver(host_resolver),
       http_auth_cache(http_auth_cache),
@@ -65,7 +70,12 @@ CommonConnectJobParams::CommonConnectJobParams(
       alpn_protos(alpn_protos),
       application_settings(application_settings),
       ignore_certificate_errors(ignore_certificate_errors),
-      enable_early_data(enable_early_data) {}
+      enable_early_data(enable_early_data),
+      enable_proxy_early_data(enable_proxy_early_data),
+      enable_proxy_kernel_tls(enable_proxy_kernel_tls),
+      enable_socks5_pipelining(enable_socks5_pipelining),
+      enable_connect_while_resolving(enable_connect_while_resolving),
+      proxy_connect_race(proxy_connect_race) {}
 
 CommonConnectJobParams::CommonConnectJobParams(
     const CommonConnectJobParams& other) = default;
@@ -52,6 +52,7 @@ class SocketTag;
 class SpdySessionPool;
 class SSLCertRequestInfo;
 class StreamSocket;
+class TransportConnectRace;
 class WebSocketEndpointLockManager;
 
 // Immutable socket parameters intended for shared use by all ConnectJob types.
@@ -81,7 +82,12 @@ struct NET_EXPORT_PRIVATE CommonConnectJobParams {
       const NextProtoVector* alpn_protos,
       const SSLConfig::ApplicationSettings* application_settings,
       const bool* ignore_certificate_errors,
-      const bool* enable_early_data);
+      const bool* enable_early_data,
+      const bool* enable_proxy_early_data,
+      const bool* enable_proxy_kernel_tls,
+      const bool* enable_socks5_pipelining,
+      const bool* enable_connect_while_resolving,
+      TransportConnectRace* proxy_connect_race);
   CommonConnectJobParams(const CommonConnectJobParams& other);
   ~CommonConnectJobParams();
 
@@ -110,6 +116,12 @@ struct NET_EXPORT_PRIVATE CommonConnectJobParams {
   raw_ptr<const SSLConfig::ApplicationSettings> application_settings;
   raw_ptr<const bool> ignore_certificate_errors;
   raw_ptr<const bool> enable_early_data;
+  raw_ptr<const bool> enable_proxy_early_data;
+  raw_ptr<const bool> enable_proxy_kernel_tls;
+  raw_ptr<const bool> enable_socks5_pipelining;
+  raw_ptr<const bool> enable_connect_while_resolving;
+  // If not null, TransportConnectJobs to proxies race their addresses.
+  raw_ptr<TransportConnectRace> proxy_connect_race;
 };
 
 // When a host resolution completes, OnHostResolutionCallback() is invoked. If
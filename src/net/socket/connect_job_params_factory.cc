@@ -194,6 +194,11 @@ ConnectJobParams CreateProxyParams(
     // Any proxy-specific SSL behavior here should also be configured for
     // QUIC proxies.
     proxy_server_ssl_config.disable_cert_verification_network_fetches = true;
+    proxy_server_ssl_config.early_data_enabled =
+        *common_connect_job_params->enable_proxy_early_data;
+    proxy_server_ssl_config.kernel_tls_enabled =
+        *common_connect_job_params->enable_proxy_kernel_tls;
+    proxy_server_ssl_config.tune_key_shares = true;
     ConfigureAlpn(url::SchemeHostPort(url::kHttpsScheme,
                                       proxy_server.host_port_pair().host(),
                                       proxy_server.host_port_pair().port()),
@@ -231,7 +236,9 @@ ConnectJobParams CreateProxyParams(
     params = ConnectJobParams(base::MakeRefCounted<TransportSocketParams>(
         proxy_server.host_port_pair(), proxy_dns_network_anonymization_key,
         secure_dns_policy, resolution_callback,
-        SupportedProtocolsFromSSLConfig(proxy_server_ssl_config)));
+        SupportedProtocolsFromSSLConfig(proxy_server_ssl_config),
+        /*race_connects=*/true,
+        /*session_network_anonymization_key=*/network_anonymization_key));
   } else {
     params = CreateProxyParams(
         proxy_server.host_port_pair(), true, endpoint, proxy_chain,
@@ -313,7 +320,9 @@ ConnectJobParams ConstructConnectJobParams(
     params = ConnectJobParams(base::MakeRefCounted<TransportSocketParams>(
         ToTransportEndpoint(endpoint), endpoint_network_anonymization_key,
         secure_dns_policy, resolution_callback,
-        SupportedProtocolsFromSSLConfig(ssl_config)));
+        SupportedProtocolsFromSSLConfig(ssl_config), /*race_connects=*/false,
+        /*session_network_anonymization_key=*/
+        endpoint_network_anonymization_key));
   } else {
     bool should_tunnel = force_tunnel || UsingSsl(endpoint) ||
                          !proxy_chain.is_get_to_proxy_allowed();
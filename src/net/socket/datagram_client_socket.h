@@ -6,6 +6,7 @@
 #define NET_SOCKET_DATAGRAM_CLIENT_SOCKET_H_
 
 #include "net/base/datagram_buffer.h"
+#include "net/base/net_errors.h"
 #include "net/base/net_export.h"
 #include "net/base/network_handle.h"
 #include "net/socket/datagram_socket.h"
@@ -87,6 +88,46 @@ class NET_EXPORT_PRIVATE DatagramClientSocket : public DatagramSocket,
   // Set iOS Network Service Type for socket option SO_NET_SERVICE_TYPE.
   // No-op by default.
   virtual void SetIOSNetworkServiceType(int ios_network_service_type) {}
+
+  // Returns whether WriteSegmented() is supported. False by default.
+  virtual bool SupportsSegmentedWrites() const { return false; }
+
+  // Writes |buf_len| bytes of |buf| as datagrams of |segment_size| bytes,
+  // the last of which may be shorter, with a single system call. Otherwise
+  // the same as Write(). Returns ERR_NOT_IMPLEMENTED by default.
+  virtual int WriteSegmented(
+      IOBuffer* buf,
+      int buf_len,
+      int segment_size,
+      CompletionOnceCallback callback,
+      const NetworkTrafficAnnotationTag& traffic_annotation) {
+    return ERR_NOT_IMPLEMENTED;
+  }
+
+  // Lets the kernel coalesce received datagrams of the same size, to be read
+  // with ReadCoalesced() instead of Read() from then on. Returns a network
+  // error code, ERR_NOT_IMPLEMENTED by default.
+  virtual int EnableCoalescedReads() { return ERR_NOT_IMPLEMENTED; }
+
+  // Reads one or more datagrams back to back into |buf|. All but the last
+  // are |*segment_size| bytes. |segment_size| must stay valid until the
+  // read completes. Otherwise the same as Read(). Returns
+  // ERR_NOT_IMPLEMENTED by default.
+  virtual int ReadCoalesced(IOBuffer* buf,
+                            int buf_len,
+                            int* segment_size,
+                            CompletionOnceCallback callback) {
+    return ERR_NOT_IMPLEMENTED;
+  }
+
+  // Lets reads report the datagrams the kernel dropped for a full receive
+  // buffer, see GetReceiveDropCount(). Returns a network error code,
+  // ERR_NOT_IMPLEMENTED by default.
+  virtual int EnableReceiveDropCount() { return ERR_NOT_IMPLEMENTED; }
+
+  // Returns the number of datagrams dropped since the socket was opened, as
+  // of the last read. The count wraps around. Zero by default.
+  virtual uint32_t GetReceiveDropCount() const { return 0; }
 };
 
 }  // namespace net
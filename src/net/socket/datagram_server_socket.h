@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include "net/base/completion_once_callback.h"
+#include "net/base/net_errors.h"
 #include "net/base/net_export.h"
 #include "net/socket/datagram_socket.h"
 #include "net/socket/diff_serv_code_point.h"
@@ -125,6 +126,38 @@ class NET_EXPORT DatagramServerSocket : public DatagramSocket {
 
   // Resets the thread to be used for thread-safety checks.
   virtual void DetachFromThread() = 0;
+
+  // Returns whether SendToSegmented() is supported. False by default.
+  virtual bool SupportsSegmentedWrites() const { return false; }
+
+  // Sends |buf_len| bytes of |buf| to |address| as datagrams of
+  // |segment_size| bytes, the last of which may be shorter, with a single
+  // system call. Otherwise the same as SendTo(). Returns ERR_NOT_IMPLEMENTED
+  // by default.
+  virtual int SendToSegmented(IOBuffer* buf,
+                              int buf_len,
+                              int segment_size,
+                              const IPEndPoint& address,
+                              CompletionOnceCallback callback) {
+    return ERR_NOT_IMPLEMENTED;
+  }
+
+  // Lets the kernel coalesce received datagrams of the same size and
+  // sender, to be read with RecvFromCoalesced() instead of RecvFrom() from
+  // then on. Returns a network error code, ERR_NOT_IMPLEMENTED by default.
+  virtual int EnableCoalescedReads() { return ERR_NOT_IMPLEMENTED; }
+
+  // Reads one or more datagrams of one sender back to back into |buf|. All
+  // but the last are |*segment_size| bytes. |segment_size| must stay valid
+  // until the read completes. Otherwise the same as RecvFrom(). Returns
+  // ERR_NOT_IMPLEMENTED by default.
+  virtual int RecvFromCoalesced(IOBuffer* buf,
+                                int buf_len,
+                                int* segment_size,
+                                IPEndPoint* address,
+                                CompletionOnceCallback callback) {
+    return ERR_NOT_IMPLEMENTED;
+  }
 };
 
 }  // namespace net
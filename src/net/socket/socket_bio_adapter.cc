@@ -68,6 +68,10 @@ SocketBIOAdapter::SocketBIOAdapter(StreamSocket* socket,
                                    int write_buffer_capacity,
                                    Delegate* delegate)
     : socket_(socket),
+      min_read_buffer_capacity_(read_buffer_capacity),
+      min_write_buffer_capacity_(write_buffer_capacity),
+      max_buffer_capacity_(
+          std::max(read_buffer_capacity, write_buffer_capacity)),
       read_buffer_capacity_(read_buffer_capacity),
       write_buffer_capacity_(write_buffer_capacity),
       delegate_(delegate) {
@@ -97,13 +101,29 @@ size_t SocketBIOAdapter::GetAllocationSize() const {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   size_t buffer_size = 0;
   if (read_buffer_)
-    buffer_size += read_buffer_capacity_;
+    buffer_size += read_buffer_->size();
 
   if (write_buffer_)
-    buffer_size += write_buffer_capacity_;
+    buffer_size += write_buffer_->capacity();
   return buffer_size;
 }
 
+void SocketBIOAdapter::EnableAdaptiveBuffers(int max_buffer_capacity) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  max_buffer_capacity_ = std::max(max_buffer_capacity, max_buffer_capacity_);
+}
+
+bool SocketBIOAdapter::HasPendingWriteData() const {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  return write_buffer_used_ > 0;
+}
+
+void SocketBIOAdapter::StopWrites() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  CHECK_EQ(0, write_buffer_used_);
+  writes_stopped_ = true;
+}
+
 int SocketBIOAdapter::BIORead(char* out, int len) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   if (len <= 0)
@@ -186,6 +206,7 @@ void SocketBIOAdapter::HandleSocketReadResult(int result) {
     result = ERR_CONNECTION_CLOSED;
 
   read_result_ = result;
+  AdaptReadBufferCapacity(result);
 
   // The read buffer is no longer needed.
   if (read_result_ <= 0)
@@ -220,6 +241,12 @@ int SocketBIOAdapter::BIOWrite(const char* in, int len) {
   // it.
   CHECK(write_buffer_used_ == 0 || write_error_ == ERR_IO_PENDING);
 
+  // Records written by BoringSSL would now be encrypted twice.
+  if (writes_stopped_) {
+    OpenSSLPutNetError(FROM_HERE, ERR_UNEXPECTED);
+    return -1;
+  }
+
   // If a previous Write() failed, report the error.
   if (write_error_ != OK && write_error_ != ERR_IO_PENDING) {
     OpenSSLPutNetError(FROM_HERE, write_error_);
@@ -233,8 +260,11 @@ int SocketBIOAdapter::BIOWrite(const char* in, int len) {
     write_buffer_->SetCapacity(write_buffer_capacity_);
   }
 
-  // If the ring buffer is full, inform the caller to try again later.
+  // If the ring buffer is full, inform the caller to try again later. The
+  // next buffer is larger, as the transport is behind.
   if (write_buffer_used_ == write_buffer_->capacity()) {
+    write_buffer_capacity_ =
+        std::min(write_buffer_capacity_ * 2, max_buffer_capacity_);
     BIO_set_retry_write(bio());
     return -1;
   }
@@ -268,6 +298,7 @@ int SocketBIOAdapter::BIOWrite(const char* in, int len) {
 
   // Either the buffer is now full or there is no more input.
   CHECK(len == 0 || write_buffer_used_ == write_buffer_->capacity());
+  write_buffer_peak_ = std::max(write_buffer_peak_, write_buffer_used_);
 
   // Schedule a socket Write() if necessary. (The ring buffer may previously
   // have been empty.)
@@ -333,6 +364,7 @@ void SocketBIOAdapter::HandleSocketWriteResult(int result) {
     // The write buffer is no longer needed.
     write_buffer_ = nullptr;
     write_buffer_used_ = 0;
+    write_buffer_peak_ = 0;
     return;
   }
 
@@ -345,9 +377,16 @@ void SocketBIOAdapter::HandleSocketWriteResult(int result) {
     write_buffer_->set_offset(0);
   write_error_ = OK;
 
-  // Release the write buffer if empty.
-  if (write_buffer_used_ == 0)
+  // Release the write buffer if empty, and shrink the next one if this one
+  // was mostly unused.
+  if (write_buffer_used_ == 0) {
+    if (write_buffer_peak_ <= write_buffer_->capacity() / 4) {
+      write_buffer_capacity_ =
+          std::max(write_buffer_capacity_ / 2, min_write_buffer_capacity_);
+    }
     write_buffer_ = nullptr;
+    write_buffer_peak_ = 0;
+  }
 }
 
 void SocketBIOAdapter::OnSocketWriteComplete(int result) {
@@ -375,6 +414,19 @@ void SocketBIOAdapter::OnSocketWriteComplete(int result) {
     delegate_->OnReadReady();
 }
 
+void SocketBIOAdapter::AdaptReadBufferCapacity(int result) {
+  if (result <= 0)
+    return;
+  // A full read suggests more data was waiting in the transport.
+  if (result == read_buffer_capacity_) {
+    read_buffer_capacity_ =
+        std::min(read_buffer_capacity_ * 2, max_buffer_capacity_);
+  } else if (result <= read_buffer_capacity_ / 4) {
+    read_buffer_capacity_ =
+        std::max(read_buffer_capacity_ / 2, min_read_buffer_capacity_);
+  }
+}
+
 void SocketBIOAdapter::CallOnReadReady() {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   if (read_result_ == ERR_IO_PENDING)
@@ -88,6 +88,21 @@ class NET_EXPORT_PRIVATE SocketBIOAdapter {
   // Returns the allocation size estimate in bytes.
   size_t GetAllocationSize() const;
 
+  // Lets the buffer capacities grow up to |max_buffer_capacity| while the
+  // transport keeps filling them, so bulk transfers move several records per
+  // socket operation, and shrink back once it does not. The capacities given
+  // at construction are the minimums.
+  void EnableAdaptiveBuffers(int max_buffer_capacity);
+
+  // Returns true if data written to the BIO is waiting to be written to the
+  // StreamSocket.
+  bool HasPendingWriteData() const;
+
+  // Makes later BIO writes fail, once the StreamSocket is written to without
+  // the BIO, as when the kernel encrypts the records. There must not be any
+  // pending write data.
+  void StopWrites();
+
  private:
   int BIORead(char* out, int len);
   void HandleSocketReadResult(int result);
@@ -99,6 +114,8 @@ class NET_EXPORT_PRIVATE SocketBIOAdapter {
   void HandleSocketWriteResult(int result);
   void OnSocketWriteComplete(int result);
   void CallOnReadReady();
+  // Adapts |read_buffer_capacity_| to a socket Read() of |result| bytes.
+  void AdaptReadBufferCapacity(int result);
 
   static SocketBIOAdapter* GetAdapter(BIO* bio);
   static int BIOReadWrapper(BIO* bio, char* out, int len);
@@ -116,6 +133,12 @@ class NET_EXPORT_PRIVATE SocketBIOAdapter {
   CompletionRepeatingCallback read_callback_;
   CompletionRepeatingCallback write_callback_;
 
+  // The minimum and maximum buffer capacities. They are equal unless
+  // EnableAdaptiveBuffers() is called.
+  int min_read_buffer_capacity_;
+  int min_write_buffer_capacity_;
+  int max_buffer_capacity_;
+
   // The capacity of the read buffer.
   int read_buffer_capacity_;
   // A buffer containing data from the most recent socket Read(). The buffer is
@@ -136,6 +159,10 @@ class NET_EXPORT_PRIVATE SocketBIOAdapter {
   scoped_refptr<GrowableIOBuffer> write_buffer_;
   // The number of bytes of data in write_buffer_.
   int write_buffer_used_ = 0;
+  // The most bytes in write_buffer_ since it was allocated.
+  int write_buffer_peak_ = 0;
+  // Whether StopWrites() was called.
+  bool writes_stopped_ = false;
   // The most recent socket Write() error. If ERR_IO_PENDING, there is a socket
   // Write() in progress. If OK, there is no socket Write() in progress and none
   // have failed.
@@ -5,6 +5,7 @@
 #include "net/socket/socket_options.h"
 
 #include <cerrno>
+#include <iterator>
 
 #include "build/build_config.h"
 #include "net/base/net_errors.h"
@@ -18,6 +19,10 @@
 #include <sys/socket.h>
 #endif
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+#include <linux/filter.h>
+#endif
+
 namespace net {
 
 int SetTCPNoDelay(SocketDescriptor fd, bool no_delay) {
@@ -86,6 +91,116 @@ int SetSocketSendBufferSize(SocketDescriptor fd, int32_t size) {
   return net_error;
 }
 
+int SetTCPNotSentLowWatermark(SocketDescriptor fd, int bytes) {
+#if defined(TCP_NOTSENT_LOWAT)
+  int rv = setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+                      reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+  int net_error = (rv == -1) ? MapSystemError(errno) : OK;
+  if (net_error != OK) {
+    DLOG(ERROR) << "Could not set TCP not sent low watermark: " << net_error;
+  }
+  return net_error;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int SetTCPFastOpen(SocketDescriptor fd, int queue_length) {
+#if !BUILDFLAG(IS_WIN) && defined(TCP_FASTOPEN)
+  int rv = setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &queue_length,
+                      sizeof(queue_length));
+  int net_error = (rv == -1) ? MapSystemError(errno) : OK;
+  if (net_error != OK) {
+    DLOG(ERROR) << "Could not set TCP fast open: " << net_error;
+  }
+  return net_error;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int SetTCPFastOpenConnect(SocketDescriptor fd, bool enable) {
+#if defined(TCP_FASTOPEN_CONNECT)
+  int on = enable ? 1 : 0;
+  int rv = setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &on, sizeof(on));
+  int net_error = (rv == -1) ? MapSystemError(errno) : OK;
+  if (net_error != OK) {
+    DLOG(ERROR) << "Could not set TCP fast open connect: " << net_error;
+  }
+  return net_error;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int SetSocketBusyPoll(SocketDescriptor fd, int usec) {
+#if !BUILDFLAG(IS_WIN) && defined(SO_BUSY_POLL)
+  int rv = setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec));
+  int net_error = (rv == -1) ? MapSystemError(errno) : OK;
+  if (net_error != OK) {
+    DLOG(ERROR) << "Could not set busy poll: " << net_error;
+  }
+  return net_error;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int GetSocketIncomingCpu(SocketDescriptor fd, int* cpu) {
+#if !BUILDFLAG(IS_WIN) && defined(SO_INCOMING_CPU)
+  socklen_t len = sizeof(*cpu);
+  int rv = getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, cpu, &len);
+  return rv == -1 ? MapSystemError(errno) : OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int SetReusePortCpuSteering(SocketDescriptor fd, int group_size) {
+#if (BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || \
+     BUILDFLAG(IS_ANDROID)) &&                           \
+    defined(SO_ATTACH_REUSEPORT_CBPF)
+  // A = raw_smp_processor_id() % group_size; return A.
+  sock_filter code[] = {
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0,
+       static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(group_size)},
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  sock_fprog prog = {static_cast<unsigned short>(std::size(code)), code};
+  int rv = setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog,
+                      sizeof(prog));
+  int net_error = (rv == -1) ? MapSystemError(errno) : OK;
+  if (net_error != OK) {
+    DLOG(ERROR) << "Could not attach reuseport CPU steering: " << net_error;
+  }
+  return net_error;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int SetSocketDiffServCodePoint(SocketDescriptor fd, DiffServCodePoint dscp) {
+#if !BUILDFLAG(IS_WIN)
+  if (dscp == DSCP_NO_CHANGE) {
+    return OK;
+  }
+  int tos = dscp << 2;
+  // A dual-stack socket takes both options, an IPv4 one only the first, and
+  // an IPv6-only one only the second, so either succeeding is enough.
+  int rv = setsockopt(fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+  int rv6 = setsockopt(fd, IPPROTO_IPV6, IPV6_TCLASS, &tos, sizeof(tos));
+  if (rv == -1 && rv6 == -1) {
+    int net_error = MapSystemError(errno);
+    DLOG(ERROR) << "Could not set DSCP: " << net_error;
+    return net_error;
+  }
+  return OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
 int SetIPv6Only(SocketDescriptor fd, bool ipv6_only) {
 #if BUILDFLAG(IS_WIN)
   DWORD on = ipv6_only ? 1 : 0;
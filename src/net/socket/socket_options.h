@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include "net/base/net_export.h"
+#include "net/socket/diff_serv_code_point.h"
 #include "net/socket/socket_descriptor.h"
 
 namespace net {
@@ -57,6 +58,53 @@ int SetSocketReceiveBufferSize(SocketDescriptor fd, int32_t size);
 // returns a net error code, on success returns OK.
 int SetSocketSendBufferSize(SocketDescriptor fd, int32_t size);
 
+// SetTCPNotSentLowWatermark() sets the TCP_NOTSENT_LOWAT socket option, so
+// the socket takes no more writes while |bytes| or more are unsent, instead
+// of filling its send buffer. Returns ERR_NOT_IMPLEMENTED where the option
+// does not exist. On error returns a net error code, on success returns OK.
+int SetTCPNotSentLowWatermark(SocketDescriptor fd, int bytes);
+
+// SetTCPFastOpen() sets the TCP_FASTOPEN socket option on a listening
+// socket, so it accepts data in the SYN of up to |queue_length| pending
+// connections. Returns ERR_NOT_IMPLEMENTED where the option does not exist.
+// On error returns a net error code, on success returns OK.
+int SetTCPFastOpen(SocketDescriptor fd, int queue_length);
+
+// SetTCPFastOpenConnect() sets the TCP_FASTOPEN_CONNECT socket option before
+// connecting, so connect() completes at once and the first write goes out
+// in the SYN when the kernel has a cookie for the peer. Returns
+// ERR_NOT_IMPLEMENTED where the option does not exist. On error returns a
+// net error code, on success returns OK.
+int SetTCPFastOpenConnect(SocketDescriptor fd, bool enable);
+
+// SetSocketBusyPoll() sets the SO_BUSY_POLL socket option, so blocking reads
+// with nothing received poll the device queue for up to |usec| microseconds
+// before sleeping. Raising it above the net.core.busy_read sysctl needs
+// CAP_NET_ADMIN. Returns ERR_NOT_IMPLEMENTED where the option does not
+// exist. On error returns a net error code, on success returns OK.
+int SetSocketBusyPoll(SocketDescriptor fd, int usec);
+
+// GetSocketIncomingCpu() reads the SO_INCOMING_CPU socket option into |cpu|,
+// the CPU that last processed packets received by the socket. Returns
+// ERR_NOT_IMPLEMENTED where the option does not exist. On error returns a
+// net error code, on success returns OK.
+int GetSocketIncomingCpu(SocketDescriptor fd, int* cpu);
+
+// SetReusePortCpuSteering() attaches a classic BPF program to the
+// SO_REUSEPORT group of the listening socket |fd|, so that each connection
+// goes to the socket of index |cpu| % |group_size| in the group, |cpu| being
+// the CPU that received its SYN. Sockets are indexed in the order they joined
+// the group. Returns ERR_NOT_IMPLEMENTED outside Linux. On error returns a
+// net error code, on success returns OK.
+int SetReusePortCpuSteering(SocketDescriptor fd, int group_size);
+
+// SetSocketDiffServCodePoint() sets the DSCP bits of the IP_TOS and
+// IPV6_TCLASS socket options, whichever the socket has, so its packets are
+// marked with |dscp|. The kernel keeps managing the ECN bits of TCP
+// sockets. Returns ERR_NOT_IMPLEMENTED on Windows, which ignores IP_TOS. On
+// error returns a net error code, on success returns OK.
+int SetSocketDiffServCodePoint(SocketDescriptor fd, DiffServCodePoint dscp);
+
 // SetIPv6Only() sets the IPV6_V6ONLY socket option. On error
 // returns a net error code, on success returns OK.
 int SetIPv6Only(SocketDescriptor fd, bool ipv6_only);
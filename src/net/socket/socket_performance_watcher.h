@@ -5,11 +5,10 @@
 #ifndef NET_SOCKET_SOCKET_PERFORMANCE_WATCHER_H_
 #define NET_SOCKET_SOCKET_PERFORMANCE_WATCHER_H_
 
-#include "net/base/net_export.h"
+#include <cstdint>
 
-namespace base {
-class TimeDelta;
-}  // namespace base
+#include "base/time/time.h"
+#include "net/base/net_export.h"
 
 namespace net {
 
@@ -18,6 +17,17 @@ namespace net {
 // thread.
 class NET_EXPORT_PRIVATE SocketPerformanceWatcher {
  public:
+  // Counters of a TCP connection from TCP_INFO. The segment counts are over
+  // the life of the connection.
+  struct TcpStats {
+    base::TimeDelta rtt;
+    base::TimeDelta rtt_variance;
+    uint64_t segments_sent = 0;
+    uint64_t segments_retransmitted = 0;
+    // In segments.
+    uint32_t congestion_window = 0;
+  };
+
   virtual ~SocketPerformanceWatcher() = default;
 
   // Returns true if |this| SocketPerformanceWatcher is interested in receiving
@@ -32,6 +42,11 @@ class NET_EXPORT_PRIVATE SocketPerformanceWatcher {
   // OnUpdatedRTTAvailable call for various reasons, including performance.
   virtual void OnUpdatedRTTAvailable(const base::TimeDelta& rtt) = 0;
 
+  // Notifies |this| SocketPerformanceWatcher of the counters of its TCP
+  // socket, right after OnUpdatedRTTAvailable(), on platforms where TCP_INFO
+  // has them.
+  virtual void OnUpdatedTcpStats(const TcpStats& stats) {}
+
   // Notifies that |this| watcher will be reused to watch a socket that belongs
   // to a different transport layer connection. Note: The new connection shares
   // the same protocol as the previously watched socket.
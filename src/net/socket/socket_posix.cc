@@ -7,18 +7,26 @@
 #include <errno.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <utility>
 
+#include "base/containers/circular_deque.h"
 #include "base/files/file_util.h"
 #include "base/functional/bind.h"
 #include "base/functional/callback_helpers.h"
 #include "base/logging.h"
 #include "base/posix/eintr_wrapper.h"
 #include "base/task/current_thread.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "build/build_config.h"
 #include "net/base/io_buffer.h"
+#include "net/base/io_buffer_chain.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
 #include "net/base/sockaddr_storage.h"
@@ -31,10 +39,149 @@
 #include <sys/ioctl.h>
 #endif  // BUILDFLAG(IS_FUCHSIA)
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+#include <linux/errqueue.h>
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && \
+    defined(SO_EE_ORIGIN_ZEROCOPY)
+#define SOCKET_ZERO_COPY 1
+#endif
+#endif
+
 namespace net {
 
+// The buffers of the MSG_ZEROCOPY sends of a socket the kernel may still
+// read, by the notification ID the kernel gives each successful send.
+class ZeroCopySends {
+ public:
+  // Beyond this many outstanding buffers, writes are copied until the
+  // notifications catch up.
+  static constexpr size_t kMaxBuffers = 64;
+
+  ZeroCopySends() = default;
+  ZeroCopySends(const ZeroCopySends&) = delete;
+  ZeroCopySends& operator=(const ZeroCopySends&) = delete;
+
+  bool empty() const { return buffers_.empty(); }
+
+  bool CanSend(int buf_len) const {
+    return buf_len >= SocketPosix::kZeroCopyMinWriteSize && !copied_ &&
+           buffers_.size() < kMaxBuffers;
+  }
+
+  void Add(scoped_refptr<IOBuffer> buf) {
+    buffers_.emplace_back(next_id_++, std::move(buf));
+  }
+
+  // Releases the buffers of the sends completed, as reported on the error
+  // queue of `fd`.
+  void Reap(SocketDescriptor fd);
+
+ private:
+  uint32_t next_id_ = 0;
+  base::circular_deque<std::pair<uint32_t, scoped_refptr<IOBuffer>>> buffers_;
+  // The kernel copied a send anyway, as it does on loopback, so later ones
+  // are copied without the notification.
+  bool copied_ = false;
+};
+
+void ZeroCopySends::Reap(SocketDescriptor fd) {
+#if defined(SOCKET_ZERO_COPY)
+  while (!buffers_.empty()) {
+    // An extended error, followed by the address of its origin.
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err) +
+                                             sizeof(sockaddr_in6))];
+    msghdr msg = {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    // Fails with EAGAIN when the queue is empty.
+    if (HANDLE_EINTR(recvmsg(fd, &msg, MSG_ERRQUEUE)) < 0)
+      return;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (!(cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR) &&
+          !(cmsg->cmsg_level == IPPROTO_IPV6 &&
+            cmsg->cmsg_type == IPV6_RECVERR)) {
+        continue;
+      }
+      sock_extended_err err;
+      memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+      if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+        continue;
+      if (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+        copied_ = true;
+      // The sends from ee_info to ee_data, wrapping around.
+      uint32_t first = err.ee_info;
+      uint32_t count = err.ee_data - first;
+      base::EraseIf(buffers_, [first, count](const auto& entry) {
+        return entry.first - first <= count;
+      });
+    }
+  }
+#endif
+}
+
 namespace {
 
+#if defined(SOCKET_ZERO_COPY)
+// Keeps the zero-copy sends of a closed socket until the kernel is done with
+// them, then closes its descriptor. Deletes itself.
+class ZeroCopyLinger {
+ public:
+  static constexpr base::TimeDelta kPollInterval = base::Milliseconds(100);
+  static constexpr base::TimeDelta kTimeout = base::Minutes(1);
+
+  // `fd`: The descriptor of the closed socket, now owned by the linger. If
+  //   the peer does not take the rest of the data in kTimeout, the socket is
+  //   reset, which drops the data the kernel still has to send and frees the
+  //   buffers. kInvalidSocket if the socket was released to another owner,
+  //   in which case the buffers are kept for kTimeout.
+  static void Start(SocketDescriptor fd, std::unique_ptr<ZeroCopySends> sends) {
+    new ZeroCopyLinger(fd, std::move(sends));
+  }
+
+ private:
+  ZeroCopyLinger(SocketDescriptor fd, std::unique_ptr<ZeroCopySends> sends)
+      : fd_(fd),
+        sends_(std::move(sends)),
+        deadline_(base::TimeTicks::Now() + kTimeout) {
+    // The peer gets the FIN after the data queued, as with close().
+    if (fd_ != kInvalidSocket)
+      shutdown(fd_, SHUT_WR);
+    timer_.Start(
+        FROM_HERE, kPollInterval,
+        base::BindRepeating(&ZeroCopyLinger::Poll, base::Unretained(this)));
+  }
+
+  ~ZeroCopyLinger() {
+    if (fd_ != kInvalidSocket && IGNORE_EINTR(close(fd_)) < 0)
+      DPLOG(ERROR) << "close() failed";
+  }
+
+  void Poll() {
+    if (fd_ != kInvalidSocket) {
+      sends_->Reap(fd_);
+      if (sends_->empty()) {
+        delete this;
+        return;
+      }
+    }
+    if (base::TimeTicks::Now() < deadline_)
+      return;
+    if (fd_ != kInvalidSocket) {
+      struct linger reset = {.l_onoff = 1, .l_linger = 0};
+      setsockopt(fd_, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+    }
+    delete this;
+  }
+
+  const SocketDescriptor fd_;
+  const std::unique_ptr<ZeroCopySends> sends_;
+  const base::TimeTicks deadline_;
+  base::RepeatingTimer timer_;
+};
+#endif  // defined(SOCKET_ZERO_COPY)
+
 int MapAcceptError(int os_error) {
   switch (os_error) {
     // If the client aborts the connection before the server calls accept,
@@ -131,6 +278,7 @@ int SocketPosix::AdoptUnconnectedSocket(SocketDescriptor socket) {
 SocketDescriptor SocketPosix::ReleaseConnectedSocket() {
   // It's not safe to release a socket with a pending write.
   DCHECK(!write_buf_);
+  DCHECK(!write_chain_);
 
   StopWatchingAndCleanUp(false /* close_socket */);
   SocketDescriptor socket_fd = socket_fd_;
@@ -138,6 +286,33 @@ SocketDescriptor SocketPosix::ReleaseConnectedSocket() {
   return socket_fd;
 }
 
+void SocketPosix::EnableEdgeTriggeredWatches() {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  DCHECK(write_callback_.is_null());
+  DCHECK(read_if_ready_callback_.is_null());
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  edge_triggered_watches_ = true;
+#endif
+}
+
+int SocketPosix::EnableZeroCopy() {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  DCHECK_NE(kInvalidSocket, socket_fd_);
+
+#if defined(SOCKET_ZERO_COPY)
+  if (zero_copy_sends_)
+    return OK;
+  int on = 1;
+  if (setsockopt(socket_fd_, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) < 0)
+    return MapSystemError(errno);
+  zero_copy_sends_ = std::make_unique<ZeroCopySends>();
+  return OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
 int SocketPosix::Bind(const SockaddrStorage& address) {
   DCHECK(thread_checker_.CalledOnValidThread());
   DCHECK_NE(kInvalidSocket, socket_fd_);
@@ -233,6 +408,16 @@ int SocketPosix::Connect(const SockaddrStorage& address,
   return ERR_IO_PENDING;
 }
 
+int SocketPosix::ShutdownWrite() {
+  DCHECK(thread_checker_.CalledOnValidThread());
+
+  if (socket_fd_ == kInvalidSocket || waiting_connect_)
+    return ERR_SOCKET_NOT_CONNECTED;
+  if (shutdown(socket_fd_, SHUT_WR) != 0)
+    return MapSystemError(errno);
+  return OK;
+}
+
 bool SocketPosix::IsConnected() const {
   DCHECK(thread_checker_.CalledOnValidThread());
 
@@ -298,9 +483,7 @@ int SocketPosix::ReadIfReady(IOBuffer* buf,
   if (rv != ERR_IO_PENDING)
     return rv;
 
-  if (!base::CurrentIOThread::Get()->WatchFileDescriptor(
-          socket_fd_, true, base::MessagePumpForIO::WATCH_READ,
-          &read_socket_watcher_, this)) {
+  if (!WatchSocket(base::MessagePumpForIO::WATCH_READ, &read_socket_watcher_)) {
     PLOG(ERROR) << "WatchFileDescriptor failed on read";
     return MapSystemError(errno);
   }
@@ -338,6 +521,33 @@ int SocketPosix::Write(
   return rv;
 }
 
+int SocketPosix::WriteV(
+    IOBufferChain* chain,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& /* traffic_annotation */) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  CHECK_NE(kInvalidSocket, socket_fd_);
+  CHECK(!waiting_connect_);
+  CHECK(write_callback_.is_null());
+  // Synchronous operation not supported
+  CHECK(!callback.is_null());
+  CHECK_LT(0, chain->BytesRemaining());
+
+  int rv = DoWriteV(chain);
+  if (rv != ERR_IO_PENDING)
+    return rv;
+
+  if (!WatchSocket(base::MessagePumpForIO::WATCH_WRITE,
+                   &write_socket_watcher_)) {
+    PLOG(ERROR) << "WatchFileDescriptor failed on write";
+    return MapSystemError(errno);
+  }
+
+  write_chain_ = chain;
+  write_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
 int SocketPosix::WaitForWrite(IOBuffer* buf,
                               int buf_len,
                               CompletionOnceCallback callback) {
@@ -348,9 +558,8 @@ int SocketPosix::WaitForWrite(IOBuffer* buf,
   DCHECK(!callback.is_null());
   DCHECK_LT(0, buf_len);
 
-  if (!base::CurrentIOThread::Get()->WatchFileDescriptor(
-          socket_fd_, true, base::MessagePumpForIO::WATCH_WRITE,
-          &write_socket_watcher_, this)) {
+  if (!WatchSocket(base::MessagePumpForIO::WATCH_WRITE,
+                   &write_socket_watcher_)) {
     PLOG(ERROR) << "WatchFileDescriptor failed on write";
     return MapSystemError(errno);
   }
@@ -409,9 +618,27 @@ void SocketPosix::DetachFromThread() {
   thread_checker_.DetachFromThread();
 }
 
+bool SocketPosix::WatchSocket(
+    base::MessagePumpForIO::Mode mode,
+    base::MessagePumpForIO::FdWatchController* controller) {
+  if (edge_triggered_watches_) {
+    return base::CurrentIOThread::Get()->WatchFileDescriptor(
+        socket_fd_, /*persistent=*/false,
+        static_cast<base::MessagePumpForIO::Mode>(
+            mode | base::MessagePumpForIO::WATCH_EDGE_TRIGGERED),
+        controller, this);
+  }
+  return base::CurrentIOThread::Get()->WatchFileDescriptor(
+      socket_fd_, /*persistent=*/true, mode, controller, this);
+}
+
 void SocketPosix::OnFileCanReadWithoutBlocking(int fd) {
   TRACE_EVENT0(NetTracingCategory(),
                "SocketPosix::OnFileCanReadWithoutBlocking");
+  // Zero-copy notifications on the error queue wake up the watchers until
+  // they are read.
+  if (zero_copy_sends_)
+    zero_copy_sends_->Reap(socket_fd_);
   if (!accept_callback_.is_null()) {
     AcceptCompleted();
   } else {
@@ -422,6 +649,8 @@ void SocketPosix::OnFileCanReadWithoutBlocking(int fd) {
 
 void SocketPosix::OnFileCanWriteWithoutBlocking(int fd) {
   DCHECK(!write_callback_.is_null());
+  if (zero_copy_sends_)
+    zero_copy_sends_->Reap(socket_fd_);
   if (waiting_connect_) {
     ConnectCompleted();
   } else {
@@ -431,9 +660,17 @@ void SocketPosix::OnFileCanWriteWithoutBlocking(int fd) {
 
 int SocketPosix::DoAccept(std::unique_ptr<SocketPosix>* socket) {
   SockaddrStorage new_peer_address;
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  // Sets O_NONBLOCK in the same system call, so AdoptConnectedSocket() only
+  // has to check it.
+  int new_socket = HANDLE_EINTR(
+      accept4(socket_fd_, new_peer_address.addr, &new_peer_address.addr_len,
+              SOCK_NONBLOCK | SOCK_CLOEXEC));
+#else
   int new_socket = HANDLE_EINTR(accept(socket_fd_,
                                        new_peer_address.addr,
                                        &new_peer_address.addr_len));
+#endif
   if (new_socket < 0)
     return MapAcceptError(errno);
 
@@ -510,9 +747,21 @@ void SocketPosix::RetryRead(int rv) {
 void SocketPosix::ReadCompleted() {
   DCHECK(read_if_ready_callback_);
 
-  bool ok = read_socket_watcher_.StopWatchingFileDescriptor();
-  DCHECK(ok);
+  if (edge_triggered_watches_) {
+    // The one-shot watch is done, and stays registered for the next one.
+    std::move(read_if_ready_callback_).Run(OK);
+    return;
+  }
+
+  // Keeps watching while the callback runs. A read it starts that has to wait
+  // then keeps the registration of the descriptor with the message pump,
+  // instead of removing and adding it again with two epoll_ctl() calls.
+  base::WeakPtr<SocketPosix> self = weak_ptr_factory_.GetWeakPtr();
   std::move(read_if_ready_callback_).Run(OK);
+  if (self && read_if_ready_callback_.is_null()) {
+    bool ok = read_socket_watcher_.StopWatchingFileDescriptor();
+    DCHECK(ok);
+  }
 }
 
 int SocketPosix::DoWrite(IOBuffer* buf, int buf_len) {
@@ -521,7 +770,26 @@ int SocketPosix::DoWrite(IOBuffer* buf, int buf_len) {
   // SIGPIPE, the net stack may be used in other consumers which do not do
   // this. MSG_NOSIGNAL is a Linux-only API. On OS X, this is a setsockopt on
   // socket creation.
-  int rv = HANDLE_EINTR(send(socket_fd_, buf->data(), buf_len, MSG_NOSIGNAL));
+  int flags = MSG_NOSIGNAL;
+#if defined(SOCKET_ZERO_COPY)
+  bool zero_copy = false;
+  if (zero_copy_sends_) {
+    zero_copy_sends_->Reap(socket_fd_);
+    zero_copy = zero_copy_sends_->CanSend(buf_len);
+    if (zero_copy)
+      flags |= MSG_ZEROCOPY;
+  }
+#endif
+  int rv = HANDLE_EINTR(send(socket_fd_, buf->data(), buf_len, flags));
+#if defined(SOCKET_ZERO_COPY)
+  if (zero_copy && rv < 0 && errno == ENOBUFS) {
+    // Out of socket memory for the notification. The send is copied.
+    zero_copy = false;
+    rv = HANDLE_EINTR(send(socket_fd_, buf->data(), buf_len, MSG_NOSIGNAL));
+  }
+  if (zero_copy && rv > 0)
+    zero_copy_sends_->Add(buf);
+#endif
 #else
   int rv = HANDLE_EINTR(write(socket_fd_, buf->data(), buf_len));
 #endif
@@ -531,16 +799,57 @@ int SocketPosix::DoWrite(IOBuffer* buf, int buf_len) {
   return rv >= 0 ? rv : MapSystemError(errno);
 }
 
+int SocketPosix::DoWriteV(IOBufferChain* chain) {
+  struct iovec iov[kMaxWriteVSlices];
+  size_t count = std::min(chain->num_slices(), kMaxWriteVSlices);
+  for (size_t i = 0; i < count; ++i) {
+    base::span<const char> data = chain->slice(i).span();
+    iov[i].iov_base = const_cast<char*>(data.data());
+    iov[i].iov_len = data.size();
+  }
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  // As in DoWrite().
+  struct msghdr msg = {};
+  msg.msg_iov = iov;
+  msg.msg_iovlen = count;
+  int rv = HANDLE_EINTR(sendmsg(socket_fd_, &msg, MSG_NOSIGNAL));
+#else
+  int rv = HANDLE_EINTR(writev(socket_fd_, iov, count));
+#endif
+  if (rv >= 0) {
+    CHECK_LE(rv, chain->BytesRemaining());
+  }
+  return rv >= 0 ? rv : MapSystemError(errno);
+}
+
 void SocketPosix::WriteCompleted() {
-  int rv = DoWrite(write_buf_.get(), write_buf_len_);
-  if (rv == ERR_IO_PENDING)
-    return;
+  int rv = write_chain_ ? DoWriteV(write_chain_.get())
+                        : DoWrite(write_buf_.get(), write_buf_len_);
+  if (rv == ERR_IO_PENDING) {
+    // The one-shot watch is renewed for the next edge.
+    if (edge_triggered_watches_ &&
+        !WatchSocket(base::MessagePumpForIO::WATCH_WRITE,
+                     &write_socket_watcher_)) {
+      rv = MapSystemError(errno);
+    } else {
+      return;
+    }
+  }
 
-  bool ok = write_socket_watcher_.StopWatchingFileDescriptor();
-  DCHECK(ok);
   write_buf_.reset();
   write_buf_len_ = 0;
+  write_chain_.reset();
+  if (edge_triggered_watches_) {
+    std::move(write_callback_).Run(rv);
+    return;
+  }
+  // As in ReadCompleted().
+  base::WeakPtr<SocketPosix> self = weak_ptr_factory_.GetWeakPtr();
   std::move(write_callback_).Run(rv);
+  if (self && write_callback_.is_null()) {
+    bool ok = write_socket_watcher_.StopWatchingFileDescriptor();
+    DCHECK(ok);
+  }
 }
 
 void SocketPosix::StopWatchingAndCleanUp(bool close_socket) {
@@ -551,6 +860,22 @@ void SocketPosix::StopWatchingAndCleanUp(bool close_socket) {
   ok = write_socket_watcher_.StopWatchingFileDescriptor();
   DCHECK(ok);
 
+#if defined(SOCKET_ZERO_COPY)
+  // The kernel may still read the buffers of zero-copy sends after the socket
+  // is closed or released.
+  if (zero_copy_sends_) {
+    if (socket_fd_ != kInvalidSocket)
+      zero_copy_sends_->Reap(socket_fd_);
+    if (!zero_copy_sends_->empty()) {
+      ZeroCopyLinger::Start(close_socket ? socket_fd_ : kInvalidSocket,
+                            std::move(zero_copy_sends_));
+      if (close_socket)
+        socket_fd_ = kInvalidSocket;
+    }
+    zero_copy_sends_.reset();
+  }
+#endif
+
   // These needs to be done after the StopWatchingFileDescriptor() calls, but
   // before deleting the write buffer.
   if (close_socket) {
@@ -577,6 +902,7 @@ void SocketPosix::StopWatchingAndCleanUp(bool close_socket) {
   if (!write_callback_.is_null()) {
     write_buf_.reset();
     write_buf_len_ = 0;
+    write_chain_.reset();
     write_callback_.Reset();
   }
 
@@ -10,6 +10,7 @@
 #include "base/compiler_specific.h"
 #include "base/memory/raw_ptr.h"
 #include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
 #include "base/message_loop/message_pump_for_io.h"
 #include "base/threading/thread_checker.h"
 #include "net/base/completion_once_callback.h"
@@ -20,13 +21,20 @@
 namespace net {
 
 class IOBuffer;
+class IOBufferChain;
 struct SockaddrStorage;
+class ZeroCopySends;
 
 // Socket class to provide asynchronous read/write operations on top of the
 // posix socket api. It supports AF_INET, AF_INET6, and AF_UNIX addresses.
 class NET_EXPORT_PRIVATE SocketPosix
     : public base::MessagePumpForIO::FdWatcher {
  public:
+  // Below this, notifying the completion costs more than the copy saved.
+  static constexpr int kZeroCopyMinWriteSize = 32 * 1024;
+  // Slices a WriteV() passes to the kernel at once.
+  static constexpr size_t kMaxWriteVSlices = 16;
+
   SocketPosix();
 
   SocketPosix(const SocketPosix&) = delete;
@@ -64,6 +72,7 @@ class NET_EXPORT_PRIVATE SocketPosix
   // TODO(byungchul): Need more robust way to pass system errno.
   int Connect(const SockaddrStorage& address, CompletionOnceCallback callback);
   bool IsConnected() const;
+  int ShutdownWrite();
   bool IsConnectedAndIdle() const;
 
   // Multiple outstanding requests of the same type are not supported.
@@ -84,6 +93,12 @@ class NET_EXPORT_PRIVATE SocketPosix
             int buf_len,
             CompletionOnceCallback callback,
             const NetworkTrafficAnnotationTag& traffic_annotation);
+  // Writes up to kMaxWriteVSlices slices of |chain| with one writev(). The
+  // slices are never sent with MSG_ZEROCOPY. Holds on to |chain| while
+  // pending, without consuming it.
+  int WriteV(IOBufferChain* chain,
+             CompletionOnceCallback callback,
+             const NetworkTrafficAnnotationTag& traffic_annotation);
 
   // Waits for next write event. This is called by TCPSocketPosix for TCP
   // fastopen after sending first data. Returns ERR_IO_PENDING if it starts
@@ -91,6 +106,22 @@ class NET_EXPORT_PRIVATE SocketPosix
   // It must not be called after Write() because Write() calls it internally.
   int WaitForWrite(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
 
+  // Sends writes of kZeroCopyMinWriteSize bytes or more with MSG_ZEROCOPY,
+  // so the kernel reads them from their buffers instead of copying them.
+  // Their buffers are kept until the kernel reports it is done with them,
+  // even past Close(), so their memory must not be reused while referenced.
+  // Smaller writes, and writes when the kernel runs short of memory for the
+  // notifications, are copied as usual. Returns ERR_NOT_IMPLEMENTED where
+  // MSG_ZEROCOPY does not exist. Must be called on an open socket.
+  int EnableZeroCopy();
+
+  // Makes later reads and writes that have to wait use one-shot watches that
+  // the message pump may register edge-triggered, so waiting again from a
+  // completion callback takes no epoll_ctl() calls. Meant for sockets that
+  // keep relaying for their whole life. No effect outside Linux. Must not be
+  // called while a read or write is pending.
+  void EnableEdgeTriggeredWatches();
+
   int GetLocalAddress(SockaddrStorage* address) const;
   int GetPeerAddress(SockaddrStorage* address) const;
   void SetPeerAddress(const SockaddrStorage& address);
@@ -122,8 +153,14 @@ class NET_EXPORT_PRIVATE SocketPosix
   void ReadCompleted();
 
   int DoWrite(IOBuffer* buf, int buf_len);
+  int DoWriteV(IOBufferChain* chain);
   void WriteCompleted();
 
+  // Watches the socket for reads or writes, as EnableEdgeTriggeredWatches()
+  // selects.
+  bool WatchSocket(base::MessagePumpForIO::Mode mode,
+                   base::MessagePumpForIO::FdWatchController* controller);
+
   // |close_socket| indicates whether the socket should also be closed.
   void StopWatchingAndCleanUp(bool close_socket);
 
@@ -146,6 +183,8 @@ class NET_EXPORT_PRIVATE SocketPosix
   base::MessagePumpForIO::FdWatchController write_socket_watcher_;
   scoped_refptr<IOBuffer> write_buf_;
   int write_buf_len_ = 0;
+  // Non-null instead of |write_buf_| when a WriteV() is in progress.
+  scoped_refptr<IOBufferChain> write_chain_;
   // External callback; called when write or connect is complete.
   CompletionOnceCallback write_callback_;
 
@@ -155,7 +194,14 @@ class NET_EXPORT_PRIVATE SocketPosix
 
   std::unique_ptr<SockaddrStorage> peer_address_;
 
+  bool edge_triggered_watches_ = false;
+
+  // Non-null once EnableZeroCopy() succeeds.
+  std::unique_ptr<ZeroCopySends> zero_copy_sends_;
+
   base::ThreadChecker thread_checker_;
+
+  base::WeakPtrFactory<SocketPosix> weak_ptr_factory_{this};
 };
 
 }  // namespace net
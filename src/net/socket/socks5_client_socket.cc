@@ -39,12 +39,14 @@ static_assert(sizeof(struct in6_addr) == 16, "incorrect system size of IPv6");
 SOCKS5ClientSocket::SOCKS5ClientSocket(
     std::unique_ptr<StreamSocket> transport_socket,
     const HostPortPair& destination,
-    const NetworkTrafficAnnotationTag& traffic_annotation)
+    const NetworkTrafficAnnotationTag& traffic_annotation,
+    bool pipeline_handshake)
     : io_callback_(base::BindRepeating(&SOCKS5ClientSocket::OnIOComplete,
                                        base::Unretained(this))),
       transport_socket_(std::move(transport_socket)),
       read_header_size(kReadHeaderSize),
       destination_(destination),
+      pipeline_handshake_(pipeline_handshake),
       net_log_(transport_socket_->NetLog()),
       traffic_annotation_(traffic_annotation) {}
 
@@ -269,6 +271,13 @@ int SOCKS5ClientSocket::DoGreetWrite() {
   if (buffer_.empty()) {
     buffer_ =
         std::string(kSOCKS5GreetWriteData, std::size(kSOCKS5GreetWriteData));
+    if (pipeline_handshake_) {
+      std::string handshake;
+      int rv = BuildHandshakeWriteBuffer(&handshake);
+      if (rv != OK)
+        return rv;
+      buffer_.append(handshake);
+    }
     bytes_sent_ = 0;
   }
 
@@ -334,7 +343,10 @@ int SOCKS5ClientSocket::DoGreetReadComplete(int result) {
   }
 
   buffer_.clear();
-  next_state_ = STATE_HANDSHAKE_WRITE;
+  // The reads take no more than each reply, so the reply to a pipelined
+  // request is still to be read.
+  next_state_ =
+      pipeline_handshake_ ? STATE_HANDSHAKE_READ : STATE_HANDSHAKE_WRITE;
   return OK;
 }
 
@@ -35,9 +35,16 @@ class NET_EXPORT_PRIVATE SOCKS5ClientSocket : public StreamSocket {
   // Although SOCKS 5 supports 3 different modes of addressing, we will
   // always pass it a hostname. This means the DNS resolving is done
   // proxy side.
+  //
+  // With |pipeline_handshake|, the CONNECT request is written with the
+  // greeting instead of after its reply, so the handshake takes one round
+  // trip instead of two. This is safe as only the no authentication method
+  // is offered, but some servers drop a request that arrives before they
+  // reply to the greeting.
   SOCKS5ClientSocket(std::unique_ptr<StreamSocket> transport_socket,
                      const HostPortPair& destination,
-                     const NetworkTrafficAnnotationTag& traffic_annotation);
+                     const NetworkTrafficAnnotationTag& traffic_annotation,
+                     bool pipeline_handshake = false);
 
   SOCKS5ClientSocket(const SOCKS5ClientSocket&) = delete;
   SOCKS5ClientSocket& operator=(const SOCKS5ClientSocket&) = delete;
@@ -152,6 +159,8 @@ class NET_EXPORT_PRIVATE SOCKS5ClientSocket : public StreamSocket {
 
   const HostPortPair destination_;
 
+  const bool pipeline_handshake_;
+
   NetLogWithSource net_log_;
 
   // Traffic annotation for socket control.
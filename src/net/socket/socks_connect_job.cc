@@ -181,7 +181,8 @@ int SOCKSConnectJob::DoSOCKSConnect() {
   if (socks_params_->is_socks_v5()) {
     socket_ = std::make_unique<SOCKS5ClientSocket>(
         transport_connect_job_->PassSocket(), socks_params_->destination(),
-        socks_params_->traffic_annotation());
+        socks_params_->traffic_annotation(),
+        *common_connect_job_params()->enable_socks5_pipelining);
   } else {
     auto socks_socket = std::make_unique<SOCKSClientSocket>(
         transport_connect_job_->PassSocket(), socks_params_->destination(),
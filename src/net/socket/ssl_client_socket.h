@@ -28,6 +28,7 @@ class SCTAuditingDelegate;
 class SSLClientSessionCache;
 struct SSLConfig;
 class SSLKeyLogger;
+class SSLKeyShareTuner;
 class StreamSocket;
 class TransportSecurityState;
 
@@ -141,6 +142,14 @@ class NET_EXPORT SSLClientContext : public SSLConfigService::Observer,
     return sct_auditing_delegate_;
   }
 
+  // If set, connections whose SSLConfig has `tune_key_shares` set let it
+  // choose whether to offer the post-quantum key share. It must outlive the
+  // context.
+  SSLKeyShareTuner* key_share_tuner() { return key_share_tuner_; }
+  void set_key_share_tuner(SSLKeyShareTuner* key_share_tuner) {
+    key_share_tuner_ = key_share_tuner;
+  }
+
   // Creates a new SSLClientSocket which can then be used to establish an SSL
   // connection to |host_and_port| over the already-connected |stream_socket|.
   std::unique_ptr<SSLClientSocket> CreateSSLClientSocket(
@@ -230,6 +239,7 @@ class NET_EXPORT SSLClientContext : public SSLConfigService::Observer,
   raw_ptr<TransportSecurityState> transport_security_state_;
   raw_ptr<SSLClientSessionCache> ssl_client_session_cache_;
   raw_ptr<SCTAuditingDelegate> sct_auditing_delegate_;
+  raw_ptr<SSLKeyShareTuner> key_share_tuner_ = nullptr;
 
   SSLClientAuthCache ssl_client_auth_cache_;
 
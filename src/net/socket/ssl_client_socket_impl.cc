@@ -62,6 +62,7 @@
 #include "net/ssl/ssl_handshake_details.h"
 #include "net/ssl/ssl_info.h"
 #include "net/ssl/ssl_key_logger.h"
+#include "net/ssl/ssl_key_share_tuner.h"
 #include "net/ssl/ssl_private_key.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
 #include "third_party/boringssl/src/include/openssl/bio.h"
@@ -71,6 +72,22 @@
 #include "third_party/boringssl/src/include/openssl/mem.h"
 #include "third_party/boringssl/src/include/openssl/ssl.h"
 
+#if BUILDFLAG(IS_LINUX)
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "third_party/boringssl/src/include/openssl/hkdf.h"
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#endif  // BUILDFLAG(IS_LINUX)
+
 namespace net {
 
 namespace {
@@ -92,6 +109,123 @@ MIRACLE_PARAMETER_FOR_INT(GetDefaultOpenSSLBufferSize,
                           "DefaultOpenSSLBufferSize",
                           17 * 1024)
 
+// Size the internal BoringSSL buffers may grow to while the transport keeps
+// filling them, so bulk transfers read several records per socket read.
+MIRACLE_PARAMETER_FOR_INT(GetMaxOpenSSLBufferSize,
+                          kDefaultOpenSSLBufferSizeFeature,
+                          "MaxOpenSSLBufferSize",
+                          8 * 17 * 1024)
+
+// Parses a CompressedCertificate handshake message, with its header. See
+// RFC 8879, section 4.
+bool ParseCompressedCertificate(const void* buf,
+                                size_t len,
+                                uint16_t* algorithm,
+                                uint32_t* uncompressed_len,
+                                size_t* compressed_len) {
+  CBS cbs, body, compressed;
+  uint8_t type;
+  CBS_init(&cbs, reinterpret_cast<const uint8_t*>(buf), len);
+  if (!CBS_get_u8(&cbs, &type) || type != SSL3_MT_COMPRESSED_CERTIFICATE ||
+      !CBS_get_u24_length_prefixed(&cbs, &body) ||
+      !CBS_get_u16(&body, algorithm) ||
+      !CBS_get_u24(&body, uncompressed_len) ||
+      !CBS_get_u24_length_prefixed(&body, &compressed)) {
+    return false;
+  }
+  *compressed_len = CBS_len(&compressed);
+  return true;
+}
+
+#if BUILDFLAG(IS_LINUX)
+// Derives `out` from a TLS 1.3 traffic secret with HKDF-Expand-Label and an
+// empty context. See RFC 8446, section 7.1.
+bool Tls13ExpandLabel(const EVP_MD* digest,
+                      base::span<const uint8_t> secret,
+                      std::string_view label,
+                      base::span<uint8_t> out) {
+  static constexpr std::string_view kLabelPrefix = "tls13 ";
+  bssl::ScopedCBB cbb;
+  CBB child;
+  if (!CBB_init(cbb.get(), 2 + 1 + kLabelPrefix.size() + label.size() + 1) ||
+      !CBB_add_u16(cbb.get(), static_cast<uint16_t>(out.size())) ||
+      !CBB_add_u8_length_prefixed(cbb.get(), &child) ||
+      !CBB_add_bytes(&child,
+                     reinterpret_cast<const uint8_t*>(kLabelPrefix.data()),
+                     kLabelPrefix.size()) ||
+      !CBB_add_bytes(&child, reinterpret_cast<const uint8_t*>(label.data()),
+                     label.size()) ||
+      !CBB_add_u8(cbb.get(), 0) || !CBB_flush(cbb.get())) {
+    return false;
+  }
+  return HKDF_expand(out.data(), out.size(), digest, secret.data(),
+                     secret.size(), CBB_data(cbb.get()), CBB_len(cbb.get()));
+}
+
+// Sets the kernel TLS state of the write direction of `fd`, for the TLS 1.3
+// AES-GCM keys of `write_secret`, starting at record `sequence`.
+template <typename CryptoInfo>
+bool SetKernelTlsTx(SocketDescriptor fd,
+                    uint16_t cipher_type,
+                    const EVP_MD* digest,
+                    base::span<const uint8_t> write_secret,
+                    uint64_t sequence) {
+  CryptoInfo info = {};
+  info.info.version = TLS_1_3_VERSION;
+  info.info.cipher_type = cipher_type;
+  // The kernel forms the nonce from the salt and the IV, as the static IV of
+  // TLS 1.3.
+  uint8_t iv[sizeof(info.salt) + sizeof(info.iv)];
+  bool ok = Tls13ExpandLabel(digest, write_secret, "key", info.key) &&
+            Tls13ExpandLabel(digest, write_secret, "iv", iv);
+  if (ok) {
+    memcpy(info.salt, iv, sizeof(info.salt));
+    memcpy(info.iv, iv + sizeof(info.salt), sizeof(info.iv));
+    for (size_t i = 0; i < sizeof(info.rec_seq); ++i) {
+      info.rec_seq[i] = static_cast<uint8_t>(
+          sequence >> (8 * (sizeof(info.rec_seq) - 1 - i)));
+    }
+    ok = setsockopt(fd, SOL_TLS, TLS_TX, &info, sizeof(info)) == 0;
+  }
+  OPENSSL_cleanse(&info, sizeof(info));
+  OPENSSL_cleanse(iv, sizeof(iv));
+  return ok;
+}
+
+// Hands the encryption of the records written after now on `ssl` to the
+// kernel socket `fd`. Returns false if the connection or the kernel does not
+// support it.
+bool EnableKernelTlsTx(const SSL* ssl, SocketDescriptor fd) {
+  if (SSL_version(ssl) != TLS1_3_VERSION)
+    return false;
+  const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl);
+  uint16_t cipher_id = SSL_CIPHER_get_protocol_id(cipher);
+  if (cipher_id != (TLS1_3_CK_AES_128_GCM_SHA256 & 0xffff) &&
+      cipher_id != (TLS1_3_CK_AES_256_GCM_SHA384 & 0xffff)) {
+    return false;
+  }
+  bssl::Span<const uint8_t> read_secret;
+  bssl::Span<const uint8_t> write_secret;
+  if (!bssl::SSL_get_traffic_secrets(ssl, &read_secret, &write_secret))
+    return false;
+
+  // A socket with the TLS ULP but no keys is still a plain TCP socket, so
+  // failing after this leaves the connection usable.
+  static constexpr char kTlsUlp[] = "tls";
+  if (setsockopt(fd, IPPROTO_TCP, TCP_ULP, kTlsUlp, sizeof(kTlsUlp)) != 0)
+    return false;
+  const EVP_MD* digest = SSL_CIPHER_get_handshake_digest(cipher);
+  uint64_t sequence = SSL_get_write_sequence(ssl);
+  base::span<const uint8_t> secret(write_secret.data(), write_secret.size());
+  if (cipher_id == (TLS1_3_CK_AES_128_GCM_SHA256 & 0xffff)) {
+    return SetKernelTlsTx<tls12_crypto_info_aes_gcm_128>(
+        fd, TLS_CIPHER_AES_GCM_128, digest, secret, sequence);
+  }
+  return SetKernelTlsTx<tls12_crypto_info_aes_gcm_256>(
+      fd, TLS_CIPHER_AES_GCM_256, digest, secret, sequence);
+}
+#endif  // BUILDFLAG(IS_LINUX)
+
 base::Value::Dict NetLogPrivateKeyOperationParams(uint16_t algorithm,
                                                   SSLPrivateKey* key) {
   return base::Value::Dict()
@@ -543,6 +677,10 @@ void SSLClientSocketImpl::ApplySocketTag(const SocketTag& tag) {
   return stream_socket_->ApplySocketTag(tag);
 }
 
+int SSLClientSocketImpl::SetDiffServCodePoint(DiffServCodePoint dscp) {
+  return stream_socket_->SetDiffServCodePoint(dscp);
+}
+
 int SSLClientSocketImpl::Read(IOBuffer* buf,
                               int buf_len,
                               CompletionOnceCallback callback) {
@@ -591,6 +729,16 @@ int SSLClientSocketImpl::Write(
     int buf_len,
     CompletionOnceCallback callback,
     const NetworkTrafficAnnotationTag& traffic_annotation) {
+#if BUILDFLAG(IS_LINUX)
+  if (ssl_config_.kernel_tls_enabled && !kernel_tls_checked_)
+    MaybeEnableKernelTls();
+  if (kernel_tls_tx_) {
+    was_ever_used_ = true;
+    return stream_socket_->Write(buf, buf_len, std::move(callback),
+                                 traffic_annotation);
+  }
+#endif
+
   user_write_buf_ = buf;
   user_write_buf_len_ = buf_len;
 
@@ -654,6 +802,14 @@ int SSLClientSocketImpl::Init() {
   }
 
   if (context_->config().PostQuantumKeyAgreementEnabled()) {
+    offered_post_quantum_ = true;
+    if (ssl_config_.tune_key_shares && context_->key_share_tuner()) {
+      key_share_tuned_ = true;
+      offered_post_quantum_ =
+          context_->key_share_tuner()->ShouldOfferPostQuantum(host_and_port_);
+    }
+  }
+  if (offered_post_quantum_) {
     static const int kCurves[] = {NID_X25519Kyber768Draft00, NID_X25519,
                                   NID_X9_62_prime256v1, NID_secp384r1};
     if (!SSL_set1_curves(ssl_.get(), kCurves, std::size(kCurves))) {
@@ -682,6 +838,7 @@ int SSLClientSocketImpl::Init() {
   const int kBufferSize = GetDefaultOpenSSLBufferSize();
   transport_adapter_ = std::make_unique<SocketBIOAdapter>(
       stream_socket_.get(), kBufferSize, kBufferSize, this);
+  transport_adapter_->EnableAdaptiveBuffers(GetMaxOpenSSLBufferSize());
   BIO* transport_bio = transport_adapter_->bio();
 
   BIO_up_ref(transport_bio);  // SSL_set0_rbio takes ownership.
@@ -915,6 +1072,15 @@ int SSLClientSocketImpl::DoHandshakeComplete(int result) {
 
   RecordNegotiatedProtocol();
 
+  // Handshakes with early data end before the server's flight, so they do
+  // not say how long the key shares took.
+  if (key_share_tuned_ && !client_hello_time_.is_null() &&
+      !SSL_in_early_data(ssl_.get())) {
+    context_->key_share_tuner()->OnHandshakeComplete(
+        host_and_port_, offered_post_quantum_,
+        base::TimeTicks::Now() - client_hello_time_);
+  }
+
   const uint8_t* ocsp_response_raw;
   size_t ocsp_response_len;
   SSL_get0_ocsp_response(ssl_.get(), &ocsp_response_raw, &ocsp_response_len);
@@ -1382,6 +1548,24 @@ int SSLClientSocketImpl::DoPayloadWrite() {
   return net_error;
 }
 
+#if BUILDFLAG(IS_LINUX)
+void SSLClientSocketImpl::MaybeEnableKernelTls() {
+  // The kernel must start at the write sequence of BoringSSL, so wait until
+  // the handshake is confirmed and all it wrote is flushed.
+  if (!completed_connect_ || SSL_in_early_data(ssl_.get()) ||
+      transport_adapter_->HasPendingWriteData()) {
+    return;
+  }
+  kernel_tls_checked_ = true;
+
+  SocketDescriptor fd = stream_socket_->GetKernelSocketDescriptor();
+  if (fd == kInvalidSocket || !EnableKernelTlsTx(ssl_.get(), fd))
+    return;
+  transport_adapter_->StopWrites();
+  kernel_tls_tx_ = true;
+}
+#endif  // BUILDFLAG(IS_LINUX)
+
 void SSLClientSocketImpl::DoPeek() {
   if (!completed_connect_) {
     return;
@@ -1671,12 +1855,37 @@ void SSLClientSocketImpl::MessageCallback(int is_write,
                         [&] { return NetLogSSLAlertParams(buf, len); });
       break;
     case SSL3_RT_HANDSHAKE:
+      if (is_write && len > 0 &&
+          static_cast<const uint8_t*>(buf)[0] == SSL3_MT_CLIENT_HELLO &&
+          client_hello_time_.is_null()) {
+        client_hello_time_ = base::TimeTicks::Now();
+      }
       net_log_.AddEvent(
           is_write ? NetLogEventType::SSL_HANDSHAKE_MESSAGE_SENT
                    : NetLogEventType::SSL_HANDSHAKE_MESSAGE_RECEIVED,
           [&](NetLogCaptureMode capture_mode) {
             return NetLogSSLMessageParams(!!is_write, buf, len, capture_mode);
           });
+      if (!is_write) {
+        uint16_t algorithm;
+        uint32_t uncompressed_len;
+        size_t compressed_len;
+        if (ParseCompressedCertificate(buf, len, &algorithm, &uncompressed_len,
+                                       &compressed_len)) {
+          base::UmaHistogramSparse("Net.SSLCertCompressionAlgorithm",
+                                   algorithm);
+          base::UmaHistogramCounts100000("Net.SSLCompressedCertificateSize",
+                                         static_cast<int>(compressed_len));
+          auto params = [&] {
+            return base::Value::Dict()
+                .Set("algorithm", algorithm)
+                .Set("compressed_bytes", static_cast<int>(compressed_len))
+                .Set("uncompressed_bytes", static_cast<int>(uncompressed_len));
+          };
+          net_log_.AddEvent(
+              NetLogEventType::SSL_COMPRESSED_CERTIFICATES_RECEIVED, params);
+        }
+      }
       break;
     case SSL3_RT_CLIENT_HELLO_INNER:
       DCHECK(is_write);
@@ -1695,8 +1904,10 @@ void SSLClientSocketImpl::LogConnectEndEvent(int rv) {
     return;
   }
 
-  net_log_.EndEvent(NetLogEventType::SSL_CONNECT,
-                    [&] { return NetLogSSLInfoParams(this); });
+  net_log_.EndEvent(NetLogEventType::SSL_CONNECT, [&] {
+    return NetLogSSLInfoParams(this).Set("post_quantum_offered",
+                                         offered_post_quantum_);
+  });
 }
 
 void SSLClientSocketImpl::RecordNegotiatedProtocol() const {
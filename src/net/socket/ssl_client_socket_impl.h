@@ -19,6 +19,8 @@
 #include "base/memory/raw_ptr.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/io_buffer.h"
@@ -99,6 +101,7 @@ class SSLClientSocketImpl : public SSLClientSocket,
       SSLCertRequestInfo* cert_request_info) const override;
 
   void ApplySocketTag(const SocketTag& tag) override;
+  int SetDiffServCodePoint(DiffServCodePoint dscp) override;
 
   // Socket implementation.
   int Read(IOBuffer* buf,
@@ -140,6 +143,11 @@ class SSLClientSocketImpl : public SSLClientSocket,
   int DoPayloadRead(IOBuffer* buf, int buf_len);
   int DoPayloadWrite();
   void DoPeek();
+#if BUILDFLAG(IS_LINUX)
+  // Lets the kernel encrypt the records of Write() from now on, if
+  // ssl_config_.kernel_tls_enabled and the connection allows it.
+  void MaybeEnableKernelTls();
+#endif
 
   // Called when an asynchronous event completes which may have blocked the
   // pending Connect, Read or Write calls, if any. Retries all state machines
@@ -223,6 +231,19 @@ class SSLClientSocketImpl : public SSLClientSocket,
   scoped_refptr<IOBuffer> user_write_buf_;
   int user_write_buf_len_;
   bool first_post_handshake_write_ = true;
+#if BUILDFLAG(IS_LINUX)
+  // Whether MaybeEnableKernelTls() has decided, and whether the kernel now
+  // encrypts the records written.
+  bool kernel_tls_checked_ = false;
+  bool kernel_tls_tx_ = false;
+#endif
+
+  // Whether the ClientHello offered the post-quantum key share, and whether
+  // the SSLKeyShareTuner of the context chose that.
+  bool offered_post_quantum_ = false;
+  bool key_share_tuned_ = false;
+  // When the first ClientHello was written.
+  base::TimeTicks client_hello_time_;
 
   // True if we've already handled the result of our attempt to use early data.
   bool handled_early_data_result_ = false;
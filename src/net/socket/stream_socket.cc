@@ -5,8 +5,13 @@
 #include "net/socket/stream_socket.h"
 
 #include <string_view>
+#include <utility>
 
+#include "base/check_op.h"
 #include "base/notreached.h"
+#include "net/base/io_buffer.h"
+#include "net/base/io_buffer_chain.h"
+#include "net/base/net_errors.h"
 
 namespace net {
 
@@ -29,4 +34,56 @@ int StreamSocket::ConfirmHandshake(CompletionOnceCallback callback) {
   return OK;
 }
 
+int StreamSocket::ShutdownWrite() {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int StreamSocket::WriteV(
+    IOBufferChain* chain,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  int len = chain->BytesRemaining();
+  CHECK_LT(0, len);
+  scoped_refptr<IOBuffer> buf;
+  if (chain->num_slices() == 1 && chain->slice(0).offset == 0) {
+    buf = chain->slice(0).buffer;
+  } else {
+    buf = base::MakeRefCounted<IOBufferWithSize>(len);
+    chain->CopyTo(buf->span());
+  }
+  return Write(buf.get(), len, std::move(callback), traffic_annotation);
+}
+
+int StreamSocket::ReadBuffer(int max_len,
+                             scoped_refptr<IOBuffer>* buf,
+                             CompletionOnceCallback callback) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int StreamSocket::LendReadBuffer(int max_len,
+                                 base::span<const char>* data,
+                                 CompletionOnceCallback callback) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+void StreamSocket::ConsumeLentBuffer(int len) {
+  NOTREACHED_IN_MIGRATION();
+}
+
+SocketDescriptor StreamSocket::GetKernelSocketDescriptor() const {
+  return kInvalidSocket;
+}
+
+bool StreamSocket::GetSessionQuality(SessionQuality* quality) const {
+  return false;
+}
+
+int StreamSocket::SetDiffServCodePoint(DiffServCodePoint dscp) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+size_t StreamSocket::EstimateMemoryUsage() const {
+  return 0;
+}
+
 }  // namespace net
@@ -5,20 +5,27 @@
 #ifndef NET_SOCKET_STREAM_SOCKET_H_
 #define NET_SOCKET_STREAM_SOCKET_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <optional>
 #include <string_view>
 
+#include "base/containers/span.h"
 #include "base/functional/bind.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/time/time.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_export.h"
 #include "net/dns/public/resolve_error_info.h"
+#include "net/socket/diff_serv_code_point.h"
 #include "net/socket/next_proto.h"
 #include "net/socket/socket.h"
+#include "net/socket/socket_descriptor.h"
 
 namespace net {
 
+class IOBufferChain;
 class IPEndPoint;
 class NetLogWithSource;
 class SSLCertRequestInfo;
@@ -84,6 +91,79 @@ class NET_EXPORT StreamSocket : public Socket {
   // will not be called.
   virtual void Disconnect() = 0;
 
+  // Shuts down the sending side of the connection, like shutdown(SHUT_WR) on
+  // a TCP socket, while reading continues. Must not be called while a Write
+  // is pending. Returns a network error code, or ERR_NOT_IMPLEMENTED if the
+  // socket cannot half-close.
+  virtual int ShutdownWrite();
+
+  // Like Write(), but writes the unconsumed bytes of `chain` as if they were
+  // one buffer. Returns the number of bytes written, which the caller then
+  // consumes from `chain`, or a network error code. The default writes a
+  // single slice starting its buffer as is and copies several into one
+  // buffer, so sockets that frame each write, such as TLS or tunnel sockets,
+  // still frame them once. Sockets over a kernel socket gather them with
+  // writev() instead.
+  virtual int WriteV(IOBufferChain* chain,
+                     CompletionOnceCallback callback,
+                     const NetworkTrafficAnnotationTag& traffic_annotation);
+
+  // Like ReadIfReady(), but instead of copying data into a caller buffer,
+  // sets `*buf` to a buffer of the socket holding the next up to `max_len`
+  // bytes, which stays valid after the socket is gone. Returns the number of
+  // bytes, 0 on EOF, or a network error code. Returns ERR_NOT_IMPLEMENTED if
+  // the socket cannot lend its buffers, in which case the caller should use
+  // ReadIfReady() or Read(). A pending call is canceled with
+  // CancelReadIfReady().
+  virtual int ReadBuffer(int max_len,
+                         scoped_refptr<IOBuffer>* buf,
+                         CompletionOnceCallback callback);
+
+  // Like ReadBuffer(), but sets `*data` to the next up to `max_len` bytes in
+  // the receive buffer of the socket itself, without copying them. They stay
+  // there until ConsumeLentBuffer() is called with the number of them used,
+  // which must happen before the socket is used again or control returns to
+  // the message loop, and `*data` is only valid until then. Returns
+  // ERR_NOT_IMPLEMENTED if the socket cannot lend its receive buffer.
+  virtual int LendReadBuffer(int max_len,
+                             base::span<const char>* data,
+                             CompletionOnceCallback callback);
+  virtual void ConsumeLentBuffer(int len);
+
+  // Returns the descriptor of the kernel socket that carries the bytes of
+  // this socket unchanged, so the kernel can be told to process them, as
+  // with kernel TLS. Returns kInvalidSocket if there is none, as for sockets
+  // that frame or relay the bytes.
+  virtual SocketDescriptor GetKernelSocketDescriptor() const;
+
+  // Path estimates of the session that a multiplexed socket, such as a
+  // tunnel through an HTTP/2 or QUIC proxy, is carried over.
+  struct SessionQuality {
+    // Zero if not sampled yet.
+    base::TimeDelta smoothed_rtt;
+    // Estimated bytes per second, or zero if unknown.
+    int64_t bandwidth = 0;
+    // Packets sent and declared lost by the session so far, or zero if the
+    // session does not count them.
+    uint64_t packets_sent = 0;
+    uint64_t packets_lost = 0;
+  };
+
+  // Fills in `quality` and returns true if the socket is carried over such
+  // a session that is still open.
+  virtual bool GetSessionQuality(SessionQuality* quality) const;
+
+  // Marks the packets carrying the bytes of this socket with `dscp`. For a
+  // socket carried over a multiplexed session, this marks the packets of the
+  // whole session. Returns ERR_NOT_IMPLEMENTED if the socket cannot mark its
+  // packets.
+  virtual int SetDiffServCodePoint(DiffServCodePoint dscp);
+
+  // Estimates the bytes this socket holds in memory, with its stream on the
+  // session if it is carried over a multiplexed one. Sockets it wraps and
+  // the session itself are not counted. Zero if the socket does not tell.
+  virtual size_t EstimateMemoryUsage() const;
+
   // Called to test if the connection is still alive.  Returns false if a
   // connection wasn't established or the connection is dead.  True is returned
   // if the connection was terminated, but there is unread data in the incoming
@@ -358,6 +358,10 @@ void TCPClientSocket::DoDisconnect() {
   weak_ptr_factory_.InvalidateWeakPtrs();
 }
 
+int TCPClientSocket::ShutdownWrite() {
+  return socket_->ShutdownWrite();
+}
+
 bool TCPClientSocket::IsConnected() const {
   return socket_->IsConnected();
 }
@@ -444,6 +448,30 @@ int TCPClientSocket::Write(
   return result;
 }
 
+int TCPClientSocket::WriteV(
+    IOBufferChain* chain,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  DCHECK(!callback.is_null());
+  DCHECK(write_callback_.is_null());
+
+  if (was_disconnected_on_suspend_)
+    return ERR_NETWORK_IO_SUSPENDED;
+
+  // As in Write().
+  CompletionOnceCallback complete_write_callback = base::BindOnce(
+      &TCPClientSocket::DidCompleteWrite, base::Unretained(this));
+  int result = socket_->WriteV(chain, std::move(complete_write_callback),
+                               traffic_annotation);
+  if (result == ERR_IO_PENDING) {
+    write_callback_ = std::move(callback);
+  } else if (result > 0) {
+    was_ever_used_ = true;
+  }
+
+  return result;
+}
+
 int TCPClientSocket::SetReceiveBufferSize(int32_t size) {
   return socket_->SetReceiveBufferSize(size);
 }
@@ -452,6 +480,46 @@ int TCPClientSocket::SetSendBufferSize(int32_t size) {
   return socket_->SetSendBufferSize(size);
 }
 
+int TCPClientSocket::SetNotSentLowWatermark(int bytes) {
+  return socket_->SetNotSentLowWatermark(bytes);
+}
+
+int TCPClientSocket::SetFastOpenConnect(bool enable) {
+  return socket_->SetFastOpenConnect(enable);
+}
+
+void TCPClientSocket::SetMultipath(bool enable) {
+  multipath_ = enable;
+}
+
+int TCPClientSocket::SetBusyPoll(int usec) {
+  return socket_->SetBusyPoll(usec);
+}
+
+int TCPClientSocket::GetIncomingCpu(int* cpu) {
+  return socket_->GetIncomingCpu(cpu);
+}
+
+int TCPClientSocket::EnableZeroCopy() {
+  return socket_->EnableZeroCopy();
+}
+
+void TCPClientSocket::EnableEdgeTriggeredWatches() {
+  socket_->EnableEdgeTriggeredWatches();
+}
+
+void TCPClientSocket::EnableCompletionPort() {
+  socket_->EnableCompletionPort();
+}
+
+SocketDescriptor TCPClientSocket::GetKernelSocketDescriptor() const {
+  return socket_->GetSocketDescriptor();
+}
+
+int TCPClientSocket::SetDiffServCodePoint(DiffServCodePoint dscp) {
+  return socket_->SetDiffServCodePoint(dscp);
+}
+
 SocketDescriptor TCPClientSocket::SocketDescriptorForTesting() const {
   return socket_->SocketDescriptorForTesting();
 }
@@ -542,7 +610,8 @@ void TCPClientSocket::DidCompleteReadWrite(CompletionOnceCallback callback,
 int TCPClientSocket::OpenSocket(AddressFamily family) {
   DCHECK(!socket_->IsValid());
 
-  int result = socket_->Open(family);
+  int result =
+      multipath_ ? socket_->OpenMultipath(family) : socket_->Open(family);
   if (result != OK)
     return result;
 
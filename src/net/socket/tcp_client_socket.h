@@ -98,6 +98,7 @@ class NET_EXPORT TCPClientSocket : public TransportClientSocket,
       const BeforeConnectCallback& before_connect_callback) override;
   int Connect(CompletionOnceCallback callback) override;
   void Disconnect() override;
+  int ShutdownWrite() override;
   bool IsConnected() const override;
   bool IsConnectedAndIdle() const override;
   int GetPeerAddress(IPEndPoint* address) const override;
@@ -108,6 +109,8 @@ class NET_EXPORT TCPClientSocket : public TransportClientSocket,
   bool GetSSLInfo(SSLInfo* ssl_info) override;
   int64_t GetTotalReceivedBytes() const override;
   void ApplySocketTag(const SocketTag& tag) override;
+  SocketDescriptor GetKernelSocketDescriptor() const override;
+  int SetDiffServCodePoint(DiffServCodePoint dscp) override;
 
   // Socket implementation.
   // Multiple outstanding requests are not supported.
@@ -123,8 +126,28 @@ class NET_EXPORT TCPClientSocket : public TransportClientSocket,
             int buf_len,
             CompletionOnceCallback callback,
             const NetworkTrafficAnnotationTag& traffic_annotation) override;
+  int WriteV(IOBufferChain* chain,
+             CompletionOnceCallback callback,
+             const NetworkTrafficAnnotationTag& traffic_annotation) override;
   int SetReceiveBufferSize(int32_t size) override;
   int SetSendBufferSize(int32_t size) override;
+  // See SetTCPNotSentLowWatermark().
+  int SetNotSentLowWatermark(int bytes);
+  // See SetTCPFastOpenConnect(). The socket only exists while connecting, so
+  // this is meant to be called from the BeforeConnectCallback.
+  int SetFastOpenConnect(bool enable);
+  // Makes later connects open the socket with TCPSocket::OpenMultipath().
+  void SetMultipath(bool enable);
+  // See SetSocketBusyPoll().
+  int SetBusyPoll(int usec);
+  // See GetSocketIncomingCpu().
+  int GetIncomingCpu(int* cpu);
+  // See SocketPosix::EnableZeroCopy(). ERR_NOT_IMPLEMENTED on Windows.
+  int EnableZeroCopy();
+  // See SocketPosix::EnableEdgeTriggeredWatches(). No effect on Windows.
+  void EnableEdgeTriggeredWatches();
+  // See TCPSocketWin::EnableCompletionPort(). No effect outside Windows.
+  void EnableCompletionPort();
 
   // Exposes the underlying socket descriptor for testing its state. Does not
   // release ownership of the descriptor.
@@ -225,6 +248,8 @@ class NET_EXPORT TCPClientSocket : public TransportClientSocket,
 
   BeforeConnectCallback before_connect_callback_;
 
+  bool multipath_ = false;
+
   bool was_ever_used_ = false;
 
   // Set to true if the socket was disconnected due to entering suspend mode.
@@ -113,6 +113,29 @@ int TCPServerSocket::Accept(std::unique_ptr<StreamSocket>* socket,
   return result;
 }
 
+int TCPServerSocket::AcceptSocket(std::unique_ptr<TCPSocket>* socket,
+                                  CompletionOnceCallback callback,
+                                  IPEndPoint* peer_address) {
+  DCHECK(socket);
+  DCHECK(peer_address);
+  DCHECK(!callback.is_null());
+  DCHECK(!pending_accept_);
+
+  return socket_->Accept(socket, peer_address, std::move(callback));
+}
+
+int TCPServerSocket::SetFastOpen(int queue_length) {
+  return socket_->SetFastOpen(queue_length);
+}
+
+int TCPServerSocket::SetReusePortCpuSteering(int group_size) {
+  return socket_->SetReusePortCpuSteering(group_size);
+}
+
+SocketDescriptor TCPServerSocket::GetSocketDescriptor() const {
+  return socket_->GetSocketDescriptor();
+}
+
 void TCPServerSocket::DetachFromThread() {
   socket_->DetachFromThread();
 }
@@ -49,6 +49,23 @@ class NET_EXPORT TCPServerSocket : public ServerSocket {
              CompletionOnceCallback callback,
              IPEndPoint* peer_address) override;
 
+  // Like Accept(), but gives the accepted socket as is, so it can be
+  // detached from the thread and adopted by a TCPClientSocket on another.
+  // |socket| and |peer_address| must stay valid until |callback| runs.
+  int AcceptSocket(std::unique_ptr<TCPSocket>* socket,
+                   CompletionOnceCallback callback,
+                   IPEndPoint* peer_address);
+
+  // See SetTCPFastOpen(). Must be called after Listen().
+  int SetFastOpen(int queue_length);
+
+  // See SetReusePortCpuSteering(). Must be called after Listen().
+  int SetReusePortCpuSteering(int group_size);
+
+  // Returns the underlying socket descriptor, for handing it to another
+  // process.
+  SocketDescriptor GetSocketDescriptor() const;
+
   // Detaches from the current thread, to allow the socket to be transferred to
   // a new thread. Should only be called when the object is no longer used by
   // the old thread.
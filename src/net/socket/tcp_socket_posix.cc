@@ -39,6 +39,7 @@
 #include "net/log/net_log_values.h"
 #include "net/socket/socket_net_log_params.h"
 #include "net/socket/socket_options.h"
+#include "net/socket/socket_performance_watcher.h"
 #include "net/socket/socket_posix.h"
 #include "net/socket/socket_tag.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
@@ -52,6 +53,11 @@
 #define TCPI_OPT_SYN_DATA 32
 #endif
 
+// If we don't have a definition for IPPROTO_MPTCP, create one.
+#if !defined(IPPROTO_MPTCP)
+#define IPPROTO_MPTCP 262
+#endif
+
 // Fuchsia defines TCP_INFO, but it's not implemented.
 // TODO(crbug.com/42050612): Enable TCP_INFO on Fuchsia once it's implemented
 // there (see NET-160).
@@ -104,8 +110,11 @@ bool SetTCPKeepAlive(int fd, bool enable, int delay) {
 }
 
 #if defined(HAVE_TCP_INFO)
-// Returns a zero value if the transport RTT is unavailable.
-base::TimeDelta GetTransportRtt(SocketDescriptor fd) {
+// Returns a zero value if the transport RTT is unavailable. Otherwise
+// |*info| and |*info_len| are what getsockopt(TCP_INFO) returned.
+base::TimeDelta GetTransportRtt(SocketDescriptor fd,
+                                tcp_info* info,
+                                socklen_t* info_len) {
   // It is possible for the value returned by getsockopt(TCP_INFO) to be
   // legitimately zero due to the way the RTT is calculated where fractions are
   // rounded down. This is specially true for virtualized environments with
@@ -116,26 +125,44 @@ base::TimeDelta GetTransportRtt(SocketDescriptor fd) {
   // value so that callers can assume that no packets defy the laws of physics.
   constexpr uint32_t kMinValidRttMicros = 1;
 
-  tcp_info info;
   // Reset |tcpi_rtt| to verify if getsockopt() actually updates |tcpi_rtt|.
-  info.tcpi_rtt = 0;
+  info->tcpi_rtt = 0;
 
-  socklen_t info_len = sizeof(tcp_info);
-  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &info_len) != 0)
+  *info_len = sizeof(tcp_info);
+  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, info, info_len) != 0)
     return base::TimeDelta();
 
   // Verify that |tcpi_rtt| in tcp_info struct was updated. Note that it's
   // possible that |info_len| is shorter than |sizeof(tcp_info)| which implies
   // that only a subset of values in |info| may have been updated by
   // getsockopt().
-  if (info_len < static_cast<socklen_t>(offsetof(tcp_info, tcpi_rtt) +
-                                        sizeof(info.tcpi_rtt))) {
+  if (*info_len < static_cast<socklen_t>(offsetof(tcp_info, tcpi_rtt) +
+                                         sizeof(info->tcpi_rtt))) {
     return base::TimeDelta();
   }
 
-  return base::Microseconds(std::max(info.tcpi_rtt, kMinValidRttMicros));
+  return base::Microseconds(std::max(info->tcpi_rtt, kMinValidRttMicros));
 }
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+// Returns false if |info| is from a kernel too old to count segments.
+bool GetTcpStats(const tcp_info& info,
+                 socklen_t info_len,
+                 base::TimeDelta rtt,
+                 SocketPerformanceWatcher::TcpStats* stats) {
+  if (info_len < static_cast<socklen_t>(offsetof(tcp_info, tcpi_segs_out) +
+                                        sizeof(info.tcpi_segs_out))) {
+    return false;
+  }
+  stats->rtt = rtt;
+  stats->rtt_variance = base::Microseconds(info.tcpi_rttvar);
+  stats->segments_sent = info.tcpi_segs_out;
+  stats->segments_retransmitted = info.tcpi_total_retrans;
+  stats->congestion_window = info.tcpi_snd_cwnd;
+  return true;
+}
+#endif
+
 #endif  // defined(TCP_INFO)
 
 }  // namespace
@@ -175,6 +202,23 @@ int TCPSocketPosix::Open(AddressFamily family) {
   return rv;
 }
 
+int TCPSocketPosix::OpenMultipath(AddressFamily family) {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  DCHECK(!socket_);
+  SocketDescriptor fd = CreatePlatformSocket(ConvertAddressFamily(family),
+                                             SOCK_STREAM, IPPROTO_MPTCP);
+  if (fd == kInvalidSocket) {
+    // Kernels before 5.6, or with MPTCP disabled by net.mptcp.enabled.
+    if (errno == EPROTONOSUPPORT || errno == ENOPROTOOPT || errno == EINVAL)
+      return Open(family);
+    return MapSystemError(errno);
+  }
+  return AdoptUnconnectedSocket(fd);
+#else
+  return Open(family);
+#endif
+}
+
 int TCPSocketPosix::BindToNetwork(handles::NetworkHandle network) {
   DCHECK(IsValid());
   DCHECK(!IsConnected());
@@ -274,6 +318,13 @@ int TCPSocketPosix::Connect(const IPEndPoint& address,
   return rv;
 }
 
+int TCPSocketPosix::ShutdownWrite() {
+  if (!socket_)
+    return ERR_SOCKET_NOT_CONNECTED;
+
+  return socket_->ShutdownWrite();
+}
+
 bool TCPSocketPosix::IsConnected() const {
   if (!socket_)
     return false;
@@ -350,6 +401,25 @@ int TCPSocketPosix::Write(
   return rv;
 }
 
+int TCPSocketPosix::WriteV(
+    IOBufferChain* chain,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  DCHECK(socket_);
+  DCHECK(!callback.is_null());
+
+  // |socket_| holds on to |chain| while pending.
+  CompletionOnceCallback write_callback =
+      base::BindOnce(&TCPSocketPosix::WriteVCompleted, base::Unretained(this),
+                     std::move(callback));
+  int rv =
+      socket_->WriteV(chain, std::move(write_callback), traffic_annotation);
+
+  if (rv != ERR_IO_PENDING)
+    rv = HandleWriteCompleted(nullptr, rv);
+  return rv;
+}
+
 int TCPSocketPosix::GetLocalAddress(IPEndPoint* address) const {
   DCHECK(address);
 
@@ -444,6 +514,64 @@ int TCPSocketPosix::SetSendBufferSize(int32_t size) {
   return SetSocketSendBufferSize(socket_->socket_fd(), size);
 }
 
+int TCPSocketPosix::SetNotSentLowWatermark(int bytes) {
+  DCHECK(socket_);
+
+  return SetTCPNotSentLowWatermark(socket_->socket_fd(), bytes);
+}
+
+int TCPSocketPosix::SetFastOpen(int queue_length) {
+  DCHECK(socket_);
+
+  return SetTCPFastOpen(socket_->socket_fd(), queue_length);
+}
+
+int TCPSocketPosix::SetFastOpenConnect(bool enable) {
+  DCHECK(socket_);
+
+  return SetTCPFastOpenConnect(socket_->socket_fd(), enable);
+}
+
+int TCPSocketPosix::SetBusyPoll(int usec) {
+  DCHECK(socket_);
+
+  return SetSocketBusyPoll(socket_->socket_fd(), usec);
+}
+
+int TCPSocketPosix::GetIncomingCpu(int* cpu) {
+  DCHECK(socket_);
+
+  return GetSocketIncomingCpu(socket_->socket_fd(), cpu);
+}
+
+int TCPSocketPosix::SetReusePortCpuSteering(int group_size) {
+  DCHECK(socket_);
+
+  return net::SetReusePortCpuSteering(socket_->socket_fd(), group_size);
+}
+
+int TCPSocketPosix::SetDiffServCodePoint(DiffServCodePoint dscp) {
+  DCHECK(socket_);
+
+  return SetSocketDiffServCodePoint(socket_->socket_fd(), dscp);
+}
+
+int TCPSocketPosix::EnableZeroCopy() {
+  DCHECK(socket_);
+
+  return socket_->EnableZeroCopy();
+}
+
+void TCPSocketPosix::EnableEdgeTriggeredWatches() {
+  DCHECK(socket_);
+
+  socket_->EnableEdgeTriggeredWatches();
+}
+
+void TCPSocketPosix::EnableCompletionPort() {
+  DCHECK(socket_);
+}
+
 bool TCPSocketPosix::SetKeepAlive(bool enable, int delay) {
   if (!socket_)
     return false;
@@ -506,6 +634,10 @@ SocketDescriptor TCPSocketPosix::SocketDescriptorForTesting() const {
   return socket_->socket_fd();
 }
 
+SocketDescriptor TCPSocketPosix::GetSocketDescriptor() const {
+  return socket_ ? socket_->socket_fd() : kInvalidSocket;
+}
+
 void TCPSocketPosix::ApplySocketTag(const SocketTag& tag) {
   if (IsValid() && tag != tag_) {
     tag.Apply(socket_->socket_fd());
@@ -653,6 +785,12 @@ void TCPSocketPosix::WriteCompleted(const scoped_refptr<IOBuffer>& buf,
   std::move(callback).Run(HandleWriteCompleted(buf.get(), rv));
 }
 
+void TCPSocketPosix::WriteVCompleted(CompletionOnceCallback callback,
+                                     int rv) {
+  DCHECK_NE(ERR_IO_PENDING, rv);
+  std::move(callback).Run(HandleWriteCompleted(nullptr, rv));
+}
+
 int TCPSocketPosix::HandleWriteCompleted(IOBuffer* buf, int rv) {
   if (rv < 0) {
     NetLogSocketError(net_log_, NetLogEventType::SOCKET_WRITE_ERROR, rv, errno);
@@ -663,6 +801,11 @@ int TCPSocketPosix::HandleWriteCompleted(IOBuffer* buf, int rv) {
   if (rv > 0)
     NotifySocketPerformanceWatcher();
 
+  if (!buf) {
+    net_log_.AddEventWithIntParams(NetLogEventType::SOCKET_BYTES_SENT,
+                                   "byte_count", rv);
+    return rv;
+  }
   net_log_.AddByteTransferEvent(NetLogEventType::SOCKET_BYTES_SENT, rv,
                                 buf->data());
   return rv;
@@ -677,11 +820,18 @@ void TCPSocketPosix::NotifySocketPerformanceWatcher() {
     return;
   }
 
-  base::TimeDelta rtt = GetTransportRtt(socket_->socket_fd());
+  tcp_info info;
+  socklen_t info_len;
+  base::TimeDelta rtt = GetTransportRtt(socket_->socket_fd(), &info, &info_len);
   if (rtt.is_zero())
     return;
 
   socket_performance_watcher_->OnUpdatedRTTAvailable(rtt);
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  SocketPerformanceWatcher::TcpStats stats;
+  if (GetTcpStats(info, info_len, rtt, &stats))
+    socket_performance_watcher_->OnUpdatedTcpStats(stats);
+#endif
 #endif  // defined(TCP_INFO)
 }
 
@@ -691,7 +841,9 @@ bool TCPSocketPosix::GetEstimatedRoundTripTime(base::TimeDelta* out_rtt) const {
     return false;
 
 #if defined(HAVE_TCP_INFO)
-  base::TimeDelta rtt = GetTransportRtt(socket_->socket_fd());
+  tcp_info info;
+  socklen_t info_len;
+  base::TimeDelta rtt = GetTransportRtt(socket_->socket_fd(), &info, &info_len);
   if (rtt.is_zero())
     return false;
   *out_rtt = rtt;
@@ -15,6 +15,7 @@
 #include "net/base/net_export.h"
 #include "net/base/network_handle.h"
 #include "net/log/net_log_with_source.h"
+#include "net/socket/diff_serv_code_point.h"
 #include "net/socket/socket_descriptor.h"
 #include "net/socket/socket_performance_watcher.h"
 #include "net/socket/socket_tag.h"
@@ -28,6 +29,7 @@ namespace net {
 
 class AddressList;
 class IOBuffer;
+class IOBufferChain;
 class IPEndPoint;
 class SocketPosix;
 class NetLog;
@@ -56,6 +58,13 @@ class NET_EXPORT TCPSocketPosix {
   // Returns a net error code.
   int Open(AddressFamily family);
 
+  // Opens the socket as Multipath TCP on Linux and Android, so the kernel
+  // may add subflows over other interfaces and move the connection between
+  // them. Servers without MPTCP get a plain TCP connection. Opens a plain
+  // TCP socket where the kernel lacks MPTCP, and elsewhere.
+  // Returns a net error code.
+  int OpenMultipath(AddressFamily family);
+
   // Takes ownership of |socket|, which is known to already be connected to the
   // given peer address. However, peer address may be the empty address, for
   // compatibility. The given peer address will be returned by GetPeerAddress.
@@ -86,6 +95,7 @@ class NET_EXPORT TCPSocketPosix {
   // Returns a net error code.
   int Connect(const IPEndPoint& address, CompletionOnceCallback callback);
   bool IsConnected() const;
+  int ShutdownWrite();
   bool IsConnectedAndIdle() const;
 
   // IO:
@@ -104,6 +114,9 @@ class NET_EXPORT TCPSocketPosix {
             int buf_len,
             CompletionOnceCallback callback,
             const NetworkTrafficAnnotationTag& traffic_annotation);
+  int WriteV(IOBufferChain* chain,
+             CompletionOnceCallback callback,
+             const NetworkTrafficAnnotationTag& traffic_annotation);
 
   // Copies the local tcp address into |address| and returns a net error code.
   int GetLocalAddress(IPEndPoint* address) const;
@@ -122,6 +135,17 @@ class NET_EXPORT TCPSocketPosix {
   int AllowAddressReuse();
   int SetReceiveBufferSize(int32_t size);
   int SetSendBufferSize(int32_t size);
+  int SetNotSentLowWatermark(int bytes);
+  int SetFastOpen(int queue_length);
+  int SetFastOpenConnect(bool enable);
+  int SetBusyPoll(int usec);
+  int GetIncomingCpu(int* cpu);
+  int SetReusePortCpuSteering(int group_size);
+  int SetDiffServCodePoint(DiffServCodePoint dscp);
+  int EnableZeroCopy();
+  void EnableEdgeTriggeredWatches();
+  // See TCPSocketWin::EnableCompletionPort(). No effect here.
+  void EnableCompletionPort();
   bool SetKeepAlive(bool enable, int delay);
   bool SetNoDelay(bool no_delay);
   int SetIPv6Only(bool ipv6_only);
@@ -164,6 +188,11 @@ class NET_EXPORT TCPSocketPosix {
   // release ownership of the descriptor.
   SocketDescriptor SocketDescriptorForTesting() const;
 
+  // Returns the underlying socket descriptor, or kInvalidSocket if there is
+  // none, for handing it to another process. Does not release ownership of
+  // the descriptor.
+  SocketDescriptor GetSocketDescriptor() const;
+
   // Apply |tag| to this socket.
   void ApplySocketTag(const SocketTag& tag);
 
@@ -205,6 +234,8 @@ class NET_EXPORT TCPSocketPosix {
   void WriteCompleted(const scoped_refptr<IOBuffer>& buf,
                       CompletionOnceCallback callback,
                       int rv);
+  void WriteVCompleted(CompletionOnceCallback callback, int rv);
+  // |buf| is null for WriteV(), whose bytes are not logged.
   int HandleWriteCompleted(IOBuffer* buf, int rv);
 
   // Notifies |socket_performance_watcher_| of the latest RTT estimate available
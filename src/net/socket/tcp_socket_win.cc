@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/check_op.h"
 #include "base/feature_list.h"
@@ -22,10 +23,13 @@
 #include "base/functional/callback_helpers.h"
 #include "base/logging.h"
 #include "base/memory/raw_ptr.h"
+#include "base/message_loop/message_pump_for_io.h"
+#include "base/task/current_thread.h"
 #include "base/win/windows_version.h"
 #include "net/base/address_list.h"
 #include "net/base/features.h"
 #include "net/base/io_buffer.h"
+#include "net/base/io_buffer_chain.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
 #include "net/base/network_activity_monitor.h"
@@ -103,6 +107,33 @@ bool SetNonBlockingAndGetError(int fd, int* os_error) {
   return ret;
 }
 
+// Whether reads and writes on TCP sockets that complete at once can skip
+// the completion port. Layered service providers that do not hand out
+// kernel handles may post a completion for them anyway.
+bool CanSkipCompletionPortOnSuccess() {
+  static const bool can_skip = [] {
+    DWORD size = 0;
+    if (WSAEnumProtocolsW(nullptr, nullptr, &size) != SOCKET_ERROR ||
+        WSAGetLastError() != WSAENOBUFS) {
+      return false;
+    }
+    std::vector<WSAPROTOCOL_INFOW> protocols(size / sizeof(WSAPROTOCOL_INFOW) +
+                                             1);
+    size = static_cast<DWORD>(protocols.size() * sizeof(WSAPROTOCOL_INFOW));
+    int count = WSAEnumProtocolsW(nullptr, protocols.data(), &size);
+    if (count == SOCKET_ERROR)
+      return false;
+    for (int i = 0; i < count; ++i) {
+      if (protocols[i].iProtocol == IPPROTO_TCP &&
+          !(protocols[i].dwServiceFlags1 & XP1_IFS_HANDLES)) {
+        return false;
+      }
+    }
+    return true;
+  }();
+  return can_skip;
+}
+
 }  // namespace
 
 //-----------------------------------------------------------------------------
@@ -112,7 +143,8 @@ bool SetNonBlockingAndGetError(int fd, int* os_error) {
 // destroyed while an operation is in progress, the Core is detached and it
 // lives until the operation completes and the OS doesn't reference any resource
 // declared on this class anymore.
-class TCPSocketWin::Core : public base::RefCounted<Core> {
+class TCPSocketWin::Core : public base::RefCounted<Core>,
+                           public base::MessagePumpForIO::IOHandler {
  public:
   explicit Core(TCPSocketWin* socket);
 
@@ -123,6 +155,19 @@ class TCPSocketWin::Core : public base::RefCounted<Core> {
   void WatchForRead();
   void WatchForWrite();
 
+  // With the completion port, starts a zero-byte receive on `socket` that
+  // completes once there is data or the end of the stream to read. Returns
+  // 0 if it completed at once, WSA_IO_PENDING if it or an earlier one is
+  // pending, or another Winsock error.
+  int WatchForReadOnCompletionPort(SOCKET socket);
+  // With the completion port, waits for `write_context_` to complete.
+  void WatchForWriteOnCompletionPort();
+
+  // base::MessagePumpForIO::IOHandler:
+  void OnIOCompleted(base::MessagePumpForIO::IOContext* context,
+                     DWORD bytes_transfered,
+                     DWORD error) override;
+
   // Stops watching for read.
   void StopWatchingForRead();
 
@@ -138,6 +183,9 @@ class TCPSocketWin::Core : public base::RefCounted<Core> {
   // negative perf impact.
   OVERLAPPED write_overlapped_;
 
+  // Used in place of `write_overlapped_` with the completion port.
+  base::MessagePumpForIO::IOContext write_context_;
+
   // The buffers used in Read() and Write().
   scoped_refptr<IOBuffer> read_iobuffer_;
   scoped_refptr<IOBuffer> write_iobuffer_;
@@ -187,10 +235,16 @@ class TCPSocketWin::Core : public base::RefCounted<Core> {
   base::win::ObjectWatcher read_watcher_;
   // |write_watcher_| watches for events from Write();
   base::win::ObjectWatcher write_watcher_;
+
+  // The zero-byte receive of WatchForReadOnCompletionPort(). It is left
+  // pending when the read is canceled, and waited for by the next one.
+  base::MessagePumpForIO::IOContext read_context_;
+  bool read_context_pending_ = false;
 };
 
 TCPSocketWin::Core::Core(TCPSocketWin* socket)
-    : read_event_(WSACreateEvent()),
+    : base::MessagePumpForIO::IOHandler(FROM_HERE),
+      read_event_(WSACreateEvent()),
       socket_(socket),
       reader_(this),
       writer_(this) {
@@ -222,6 +276,63 @@ void TCPSocketWin::Core::WatchForWrite() {
   write_watcher_.StartWatchingOnce(write_overlapped_.hEvent, &writer_);
 }
 
+int TCPSocketWin::Core::WatchForReadOnCompletionPort(SOCKET socket) {
+  if (read_context_pending_)
+    return WSA_IO_PENDING;
+  memset(&read_context_.overlapped, 0, sizeof(read_context_.overlapped));
+  WSABUF buffer = {0, nullptr};
+  DWORD num = 0;
+  DWORD flags = 0;
+  if (WSARecv(socket, &buffer, 1, &num, &flags, &read_context_.overlapped,
+              nullptr) == 0) {
+    return 0;
+  }
+  int os_error = WSAGetLastError();
+  if (os_error != WSA_IO_PENDING)
+    return os_error;
+  read_context_pending_ = true;
+  // Balanced in OnIOCompleted(). closesocket() completes the receive too.
+  AddRef();
+  return WSA_IO_PENDING;
+}
+
+void TCPSocketWin::Core::WatchForWriteOnCompletionPort() {
+  // Balanced in OnIOCompleted().
+  AddRef();
+}
+
+void TCPSocketWin::Core::OnIOCompleted(
+    base::MessagePumpForIO::IOContext* context,
+    DWORD bytes_transfered,
+    DWORD error) {
+  if (context == &read_context_) {
+    read_context_pending_ = false;
+    if (socket_)
+      socket_->DidCompleteReadWait();
+  } else {
+    DCHECK_EQ(context, &write_context_);
+    if (socket_) {
+      int os_error = 0;
+      if (error != ERROR_SUCCESS) {
+        // The port only has the status mapped to a Win32 error, which
+        // MapSystemError() knows less of than the Winsock one.
+        DWORD num_bytes, flags;
+        if (!WSAGetOverlappedResult(socket_->socket_,
+                                    &write_context_.overlapped, &num_bytes,
+                                    FALSE, &flags)) {
+          os_error = WSAGetLastError();
+        }
+        if (os_error == 0)
+          os_error = static_cast<int>(error);
+      }
+      socket_->DidFinishWrite(error == ERROR_SUCCESS, bytes_transfered,
+                              os_error);
+    }
+  }
+  // Matches the AddRef() when the operation was started.
+  Release();
+}
+
 void TCPSocketWin::Core::StopWatchingForRead() {
   DCHECK(!socket_->waiting_connect_);
 
@@ -311,6 +422,10 @@ int TCPSocketWin::Open(AddressFamily family) {
   return OK;
 }
 
+int TCPSocketWin::OpenMultipath(AddressFamily family) {
+  return Open(family);
+}
+
 int TCPSocketWin::AdoptConnectedSocket(SocketDescriptor socket,
                                        const IPEndPoint& peer_address) {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
@@ -452,6 +567,16 @@ int TCPSocketWin::Connect(const IPEndPoint& address,
   return rv;
 }
 
+int TCPSocketWin::ShutdownWrite() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+  if (socket_ == INVALID_SOCKET || waiting_connect_)
+    return ERR_SOCKET_NOT_CONNECTED;
+  if (shutdown(socket_, SD_SEND) != 0)
+    return MapSystemError(WSAGetLastError());
+  return OK;
+}
+
 bool TCPSocketWin::IsConnected() const {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
 
@@ -521,29 +646,40 @@ int TCPSocketWin::ReadIfReady(IOBuffer* buf,
   DCHECK(!waiting_read_);
   DCHECK(read_if_ready_callback_.is_null());
 
-  if (!core_->non_blocking_reads_initialized_) {
+  if (!completion_port_ && !core_->non_blocking_reads_initialized_) {
     WSAEventSelect(socket_, core_->read_event_, FD_READ | FD_CLOSE);
     core_->non_blocking_reads_initialized_ = true;
   }
-  int rv = recv(socket_, buf->data(), buf_len, 0);
-  int os_error = WSAGetLastError();
-  if (rv == SOCKET_ERROR) {
+  for (;;) {
+    int rv = recv(socket_, buf->data(), buf_len, 0);
+    int os_error = WSAGetLastError();
+    if (rv != SOCKET_ERROR) {
+      net_log_.AddByteTransferEvent(NetLogEventType::SOCKET_BYTES_RECEIVED, rv,
+                                    buf->data());
+      activity_monitor::IncrementBytesReceived(rv);
+      return rv;
+    }
+    if (os_error == WSAEWOULDBLOCK && completion_port_) {
+      os_error = core_->WatchForReadOnCompletionPort(socket_);
+      // Data or the end of the stream arrived since the recv().
+      if (os_error == 0)
+        continue;
+      if (os_error == WSA_IO_PENDING)
+        break;
+    }
     if (os_error != WSAEWOULDBLOCK) {
       int net_error = MapSystemError(os_error);
       NetLogSocketError(net_log_, NetLogEventType::SOCKET_READ_ERROR, net_error,
                         os_error);
       return net_error;
     }
-  } else {
-    net_log_.AddByteTransferEvent(NetLogEventType::SOCKET_BYTES_RECEIVED, rv,
-                                  buf->data());
-    activity_monitor::IncrementBytesReceived(rv);
-    return rv;
+    break;
   }
 
   waiting_read_ = true;
   read_if_ready_callback_ = std::move(callback);
-  core_->WatchForRead();
+  if (!completion_port_)
+    core_->WatchForRead();
   return ERR_IO_PENDING;
 }
 
@@ -552,7 +688,10 @@ int TCPSocketWin::CancelReadIfReady() {
   DCHECK(!read_if_ready_callback_.is_null());
   DCHECK(waiting_read_);
 
-  core_->StopWatchingForRead();
+  // A zero-byte receive on the completion port is left to complete, and
+  // then ignored.
+  if (!completion_port_)
+    core_->StopWatchingForRead();
   read_if_ready_callback_.Reset();
   waiting_read_ = false;
   return net::OK;
@@ -574,12 +713,18 @@ int TCPSocketWin::Write(
   write_buffer.len = buf_len;
   write_buffer.buf = buf->data();
 
+  OVERLAPPED* overlapped = &core_->write_overlapped_;
+  if (completion_port_) {
+    overlapped = &core_->write_context_.overlapped;
+    memset(overlapped, 0, sizeof(*overlapped));
+  }
   DWORD num;
-  int rv = WSASend(socket_, &write_buffer, 1, &num, 0,
-                   &core_->write_overlapped_, nullptr);
+  int rv = WSASend(socket_, &write_buffer, 1, &num, 0, overlapped, nullptr);
   int os_error = WSAGetLastError();
   if (rv == 0) {
-    if (ResetEventIfSignaled(core_->write_overlapped_.hEvent)) {
+    // A send that completes at once posts no completion to the port.
+    if (completion_port_ ||
+        ResetEventIfSignaled(core_->write_overlapped_.hEvent)) {
       rv = static_cast<int>(num);
       if (rv > buf_len || rv < 0) {
         // It seems that some winsock interceptors report that more was written
@@ -604,10 +749,23 @@ int TCPSocketWin::Write(
   write_callback_ = std::move(callback);
   core_->write_iobuffer_ = buf;
   core_->write_buffer_length_ = buf_len;
-  core_->WatchForWrite();
+  if (completion_port_)
+    core_->WatchForWriteOnCompletionPort();
+  else
+    core_->WatchForWrite();
   return ERR_IO_PENDING;
 }
 
+int TCPSocketWin::WriteV(
+    IOBufferChain* chain,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  int len = chain->BytesRemaining();
+  auto buf = base::MakeRefCounted<IOBufferWithSize>(len);
+  chain->CopyTo(buf->span());
+  return Write(buf.get(), len, std::move(callback), traffic_annotation);
+}
+
 int TCPSocketWin::GetLocalAddress(IPEndPoint* address) const {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
   DCHECK(address);
@@ -677,6 +835,74 @@ int TCPSocketWin::SetSendBufferSize(int32_t size) {
   return SetSocketSendBufferSize(socket_, size);
 }
 
+int TCPSocketWin::SetNotSentLowWatermark(int bytes) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  return SetTCPNotSentLowWatermark(socket_, bytes);
+}
+
+int TCPSocketWin::SetFastOpen(int queue_length) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  return SetTCPFastOpen(socket_, queue_length);
+}
+
+int TCPSocketWin::SetFastOpenConnect(bool enable) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  return SetTCPFastOpenConnect(socket_, enable);
+}
+
+int TCPSocketWin::SetBusyPoll(int usec) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  return SetSocketBusyPoll(socket_, usec);
+}
+
+int TCPSocketWin::GetIncomingCpu(int* cpu) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  return GetSocketIncomingCpu(socket_, cpu);
+}
+
+int TCPSocketWin::SetReusePortCpuSteering(int group_size) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  return net::SetReusePortCpuSteering(socket_, group_size);
+}
+
+int TCPSocketWin::SetDiffServCodePoint(DiffServCodePoint dscp) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  return SetSocketDiffServCodePoint(socket_, dscp);
+}
+
+int TCPSocketWin::EnableZeroCopy() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  return ERR_NOT_IMPLEMENTED;
+}
+
+void TCPSocketWin::EnableEdgeTriggeredWatches() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+}
+
+void TCPSocketWin::EnableCompletionPort() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  DCHECK(!waiting_read_);
+  DCHECK(!waiting_write_);
+
+  if (completion_port_ || !core_ || waiting_connect_ ||
+      !base::CurrentIOThread::IsSet() || !CanSkipCompletionPortOnSuccess()) {
+    return;
+  }
+  HANDLE handle = reinterpret_cast<HANDLE>(socket_);
+  // Without skipping, a read or write that completes at once would complete
+  // again on the port.
+  if (!SetFileCompletionNotificationModes(
+          handle, FILE_SKIP_COMPLETION_PORT_ON_SUCCESS |
+                      FILE_SKIP_SET_EVENT_ON_HANDLE) ||
+      FAILED(base::CurrentIOThread::Get()->RegisterIOHandler(handle,
+                                                             core_.get()))) {
+    return;
+  }
+  // The socket stays non-blocking.
+  WSAEventSelect(socket_, nullptr, 0);
+  completion_port_ = true;
+}
+
 bool TCPSocketWin::SetKeepAlive(bool enable, int delay) {
   if (socket_ == INVALID_SOCKET)
     return false;
@@ -741,6 +967,7 @@ void TCPSocketWin::Close() {
   waiting_connect_ = false;
   waiting_read_ = false;
   waiting_write_ = false;
+  completion_port_ = false;
 
   read_callback_.Reset();
   read_if_ready_callback_.Reset();
@@ -783,6 +1010,10 @@ SocketDescriptor TCPSocketWin::SocketDescriptorForTesting() const {
   return socket_;
 }
 
+SocketDescriptor TCPSocketWin::GetSocketDescriptor() const {
+  return socket_;
+}
+
 int TCPSocketWin::AcceptInternal(std::unique_ptr<TCPSocketWin>* socket,
                                  IPEndPoint* address) {
   SockaddrStorage storage;
@@ -996,6 +1227,13 @@ void TCPSocketWin::DidCompleteWrite() {
                                    &num_bytes, FALSE, &flags);
   int os_error = WSAGetLastError();
   WSAResetEvent(core_->write_overlapped_.hEvent);
+  DidFinishWrite(ok, num_bytes, os_error);
+}
+
+void TCPSocketWin::DidFinishWrite(bool ok, DWORD num_bytes, int os_error) {
+  DCHECK(waiting_write_);
+  DCHECK(!write_callback_.is_null());
+
   waiting_write_ = false;
   int rv;
   if (!ok) {
@@ -1063,6 +1301,18 @@ void TCPSocketWin::DidSignalRead() {
   std::move(read_if_ready_callback_).Run(rv);
 }
 
+void TCPSocketWin::DidCompleteReadWait() {
+  // The read was canceled.
+  if (read_if_ready_callback_.is_null())
+    return;
+  DCHECK(waiting_read_);
+
+  // As with FD_CLOSE in DidSignalRead(), errors are left to the recv() of
+  // the retried read, which reports them more accurately.
+  waiting_read_ = false;
+  std::move(read_if_ready_callback_).Run(OK);
+}
+
 bool TCPSocketWin::GetEstimatedRoundTripTime(base::TimeDelta* out_rtt) const {
   DCHECK(out_rtt);
   // TODO(bmcquade): Consider implementing using
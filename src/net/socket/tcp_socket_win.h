@@ -20,6 +20,7 @@
 #include "net/base/net_export.h"
 #include "net/base/network_handle.h"
 #include "net/log/net_log_with_source.h"
+#include "net/socket/diff_serv_code_point.h"
 #include "net/socket/socket_descriptor.h"
 #include "net/socket/socket_performance_watcher.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
@@ -28,6 +29,7 @@ namespace net {
 
 class AddressList;
 class IOBuffer;
+class IOBufferChain;
 class IPEndPoint;
 class NetLog;
 struct NetLogSource;
@@ -50,6 +52,8 @@ class NET_EXPORT TCPSocketWin : public base::win::ObjectWatcher::Delegate {
   ~TCPSocketWin() override;
 
   int Open(AddressFamily family);
+  // Opens a plain TCP socket, as Windows has no Multipath TCP.
+  int OpenMultipath(AddressFamily family);
 
   // Takes ownership of |socket|, which is known to already be connected to the
   // given peer address. However, peer address may be the empty address, for
@@ -71,6 +75,7 @@ class NET_EXPORT TCPSocketWin : public base::win::ObjectWatcher::Delegate {
 
   int Connect(const IPEndPoint& address, CompletionOnceCallback callback);
   bool IsConnected() const;
+  int ShutdownWrite();
   bool IsConnectedAndIdle() const;
 
   // Multiple outstanding requests are not supported.
@@ -82,6 +87,10 @@ class NET_EXPORT TCPSocketWin : public base::win::ObjectWatcher::Delegate {
             int buf_len,
             CompletionOnceCallback callback,
             const NetworkTrafficAnnotationTag& traffic_annotation);
+  // Copies the slices of |chain| into one buffer for Write().
+  int WriteV(IOBufferChain* chain,
+             CompletionOnceCallback callback,
+             const NetworkTrafficAnnotationTag& traffic_annotation);
 
   int GetLocalAddress(IPEndPoint* address) const;
   int GetPeerAddress(IPEndPoint* address) const;
@@ -97,6 +106,22 @@ class NET_EXPORT TCPSocketWin : public base::win::ObjectWatcher::Delegate {
   int SetExclusiveAddrUse();
   int SetReceiveBufferSize(int32_t size);
   int SetSendBufferSize(int32_t size);
+  int SetNotSentLowWatermark(int bytes);
+  int SetFastOpen(int queue_length);
+  int SetFastOpenConnect(bool enable);
+  int SetBusyPoll(int usec);
+  int GetIncomingCpu(int* cpu);
+  int SetReusePortCpuSteering(int group_size);
+  int SetDiffServCodePoint(DiffServCodePoint dscp);
+  int EnableZeroCopy();
+  void EnableEdgeTriggeredWatches();
+  // Moves the reads and writes of a connected socket from event objects to
+  // the completion port of the current IO thread, with no read or write
+  // pending. A read waits with a zero-byte overlapped receive, which pins no
+  // buffer, and reads and writes that complete at once post no completion.
+  // No effect if a layered service provider may still post those
+  // completions, or outside an IO thread.
+  void EnableCompletionPort();
   bool SetKeepAlive(bool enable, int delay);
   bool SetNoDelay(bool no_delay);
   int SetIPv6Only(bool ipv6_only);
@@ -138,6 +163,11 @@ class NET_EXPORT TCPSocketWin : public base::win::ObjectWatcher::Delegate {
   // release ownership of the descriptor.
   SocketDescriptor SocketDescriptorForTesting() const;
 
+  // Returns the underlying socket descriptor, or kInvalidSocket if there is
+  // none, for handing it to another process. Does not release ownership of
+  // the descriptor.
+  SocketDescriptor GetSocketDescriptor() const;
+
   // Apply |tag| to this socket.
   void ApplySocketTag(const SocketTag& tag);
 
@@ -167,7 +197,9 @@ class NET_EXPORT TCPSocketWin : public base::win::ObjectWatcher::Delegate {
   void RetryRead(int rv);
   void DidCompleteConnect();
   void DidCompleteWrite();
+  void DidFinishWrite(bool ok, DWORD num_bytes, int os_error);
   void DidSignalRead();
+  void DidCompleteReadWait();
 
   SOCKET socket_;
 
@@ -185,6 +217,8 @@ class NET_EXPORT TCPSocketWin : public base::win::ObjectWatcher::Delegate {
   bool waiting_connect_ = false;
   bool waiting_read_ = false;
   bool waiting_write_ = false;
+  // Reads and writes complete on the completion port.
+  bool completion_port_ = false;
 
   // The core of the socket that can live longer than the socket itself. We pass
   // resources to the Windows async IO functions and we have to make sure that
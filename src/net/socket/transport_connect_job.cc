@@ -4,8 +4,10 @@
 
 #include "net/socket/transport_connect_job.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/check_op.h"
 #include "base/feature_list.h"
@@ -26,6 +28,7 @@
 #include "net/dns/public/secure_dns_policy.h"
 #include "net/log/net_log_event_type.h"
 #include "net/socket/socket_tag.h"
+#include "net/socket/transport_connect_race.h"
 #include "net/socket/transport_connect_sub_job.h"
 #include "third_party/abseil-cpp/absl/types/variant.h"
 #include "url/scheme_host_port.h"
@@ -55,12 +58,17 @@ TransportSocketParams::TransportSocketParams(
     NetworkAnonymizationKey network_anonymization_key,
     SecureDnsPolicy secure_dns_policy,
     OnHostResolutionCallback host_resolution_callback,
-    base::flat_set<std::string> supported_alpns)
+    base::flat_set<std::string> supported_alpns,
+    bool race_connects,
+    NetworkAnonymizationKey session_network_anonymization_key)
     : destination_(std::move(destination)),
       network_anonymization_key_(std::move(network_anonymization_key)),
       secure_dns_policy_(secure_dns_policy),
       host_resolution_callback_(std::move(host_resolution_callback)),
-      supported_alpns_(std::move(supported_alpns)) {
+      supported_alpns_(std::move(supported_alpns)),
+      race_connects_(race_connects),
+      session_network_anonymization_key_(
+          std::move(session_network_anonymization_key)) {
 #if DCHECK_IS_ON()
   auto* scheme_host_port = absl::get_if<url::SchemeHostPort>(&destination_);
   if (scheme_host_port) {
@@ -148,6 +156,7 @@ LoadState TransportConnectJob::GetLoadState() const {
     case STATE_RESOLVE_HOST:
     case STATE_RESOLVE_HOST_COMPLETE:
     case STATE_RESOLVE_HOST_CALLBACK_COMPLETE:
+    case STATE_RESOLVE_SERVICE_ENDPOINTS_COMPLETE:
       return LOAD_STATE_RESOLVING_HOST;
     case STATE_TRANSPORT_CONNECT:
     case STATE_TRANSPORT_CONNECT_COMPLETE: {
@@ -162,6 +171,11 @@ LoadState TransportConnectJob::GetLoadState() const {
           load_state != LOAD_STATE_CONNECTING) {
         load_state = ipv4_job_->GetLoadState();
       }
+      for (const auto& job : race_jobs_) {
+        if (job->started() && load_state != LOAD_STATE_CONNECTING) {
+          load_state = job->GetLoadState();
+        }
+      }
       return load_state;
     }
     case STATE_NONE:
@@ -189,6 +203,52 @@ TransportConnectJob::GetHostResolverEndpointResult() const {
   return endpoint_results_[current_endpoint_result_];
 }
 
+void TransportConnectJob::OnServiceEndpointsUpdated() {
+  switch (next_state_) {
+    case STATE_RESOLVE_SERVICE_ENDPOINTS_COMPLETE:
+      if (CheckServiceEndpoints()) {
+        OnIOComplete(OK);  // May delete |this|
+      }
+      break;
+    case STATE_TRANSPORT_CONNECT_COMPLETE: {
+      int result = StartLateSubJobs();
+      if (result != ERR_IO_PENDING) {
+        OnIOComplete(result);  // Deletes |this|
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void TransportConnectJob::OnServiceEndpointRequestFinished(int rv) {
+  switch (next_state_) {
+    case STATE_RESOLVE_SERVICE_ENDPOINTS_COMPLETE:
+      service_endpoints_resolved_ = true;
+      OnIOComplete(rv);  // May delete |this|
+      break;
+    case STATE_TRANSPORT_CONNECT_COMPLETE: {
+      // Only the addresses are of use, not the result: a sub-job may already
+      // be connecting.
+      int result = StartLateSubJobs();
+      if (result == ERR_IO_PENDING) {
+        dns_aliases_ = service_endpoint_request_->GetDnsAliasResults();
+        service_endpoint_request_.reset();
+        if (!ipv4_job_ && !ipv6_job_) {
+          result = last_sub_job_error_;
+        }
+      }
+      if (result != ERR_IO_PENDING) {
+        OnIOComplete(result);  // Deletes |this|
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
 base::TimeDelta TransportConnectJob::ConnectionTimeout() {
   // TODO(eroman): The use of this constant needs to be re-evaluated. The time
   // needed for TCPClientSocketXXX::Connect() can be arbitrarily long, since
@@ -224,6 +284,9 @@ int TransportConnectJob::DoLoop(int result) {
         DCHECK_EQ(OK, rv);
         rv = DoResolveHostCallbackComplete();
         break;
+      case STATE_RESOLVE_SERVICE_ENDPOINTS_COMPLETE:
+        rv = DoResolveServiceEndpointsComplete(rv);
+        break;
       case STATE_TRANSPORT_CONNECT:
         DCHECK_EQ(OK, rv);
         rv = DoTransportConnect();
@@ -251,11 +314,25 @@ int TransportConnectJob::DoResolveHost() {
     return OK;
   }
 
-  next_state_ = STATE_RESOLVE_HOST_COMPLETE;
-
   HostResolver::ResolveHostParameters parameters;
   parameters.initial_priority = priority();
   parameters.secure_dns_policy = params_->secure_dns_policy();
+
+  if (ConnectsWhileResolving()) {
+    next_state_ = STATE_RESOLVE_SERVICE_ENDPOINTS_COMPLETE;
+    service_endpoint_request_ = host_resolver()->CreateServiceEndpointRequest(
+        HostResolver::Host(params_->destination()),
+        params_->network_anonymization_key(), net_log(), parameters);
+    int rv = service_endpoint_request_->Start(this);
+    if (rv != ERR_IO_PENDING) {
+      service_endpoints_resolved_ = true;
+      return rv;
+    }
+    // The first answers may already be in.
+    return CheckServiceEndpoints() ? OK : ERR_IO_PENDING;
+  }
+
+  next_state_ = STATE_RESOLVE_HOST_COMPLETE;
   if (absl::holds_alternative<url::SchemeHostPort>(params_->destination())) {
     request_ = host_resolver()->CreateRequest(
         absl::get<url::SchemeHostPort>(params_->destination()),
@@ -351,11 +428,55 @@ int TransportConnectJob::DoResolveHostCallbackComplete() {
   return OK;
 }
 
+int TransportConnectJob::DoResolveServiceEndpointsComplete(int result) {
+  connect_timing_.domain_lookup_end = base::TimeTicks::Now();
+  connect_timing_.connect_start = connect_timing_.domain_lookup_end;
+  resolution_delay_timer_.Stop();
+  resolve_error_info_ = service_endpoint_request_->GetResolveErrorInfo();
+  dns_aliases_ = service_endpoint_request_->GetDnsAliasResults();
+
+  std::vector<IPEndPoint> ipv4_addresses, ipv6_addresses;
+  if (result == OK) {
+    GetServiceEndpoints(&ipv4_addresses, &ipv6_addresses, /*take=*/true);
+  }
+  if (service_endpoints_resolved_) {
+    // No more addresses will come.
+    service_endpoint_request_.reset();
+  }
+
+  if (result != OK) {
+    // If hostname resolution failed, record an empty endpoint and the result.
+    connection_attempts_.push_back(ConnectionAttempt(IPEndPoint(), result));
+    return result;
+  }
+  if (ipv4_addresses.empty() && ipv6_addresses.empty()) {
+    DCHECK(!service_endpoint_request_);
+    return ERR_NAME_NOT_RESOLVED;
+  }
+
+  // Which is connected to first is up to `DoTransportConnect`.
+  HostResolverEndpointResult endpoint_result;
+  endpoint_result.ip_endpoints = std::move(ipv6_addresses);
+  endpoint_result.ip_endpoints.insert(endpoint_result.ip_endpoints.end(),
+                                      ipv4_addresses.begin(),
+                                      ipv4_addresses.end());
+  endpoint_results_ = {std::move(endpoint_result)};
+  next_state_ = STATE_TRANSPORT_CONNECT;
+  return OK;
+}
+
 int TransportConnectJob::DoTransportConnect() {
   next_state_ = STATE_TRANSPORT_CONNECT_COMPLETE;
 
   const HostResolverEndpointResult& endpoint =
       GetEndpointResultForCurrentSubJobs();
+  const TransportConnectRace* race =
+      common_connect_job_params()->proxy_connect_race;
+  if (params_->race_connects() && race && race->width() > 1 &&
+      endpoint.ip_endpoints.size() > 1) {
+    return DoRaceConnect(endpoint.ip_endpoints);
+  }
+
   std::vector<IPEndPoint> ipv4_addresses, ipv6_addresses;
   for (const auto& ip_endpoint : endpoint.ip_endpoints) {
     switch (ip_endpoint.GetFamily()) {
@@ -403,11 +524,52 @@ int TransportConnectJob::DoTransportConnect() {
   return ERR_IO_PENDING;
 }
 
+int TransportConnectJob::DoRaceConnect(std::vector<IPEndPoint> addresses) {
+  TransportConnectRace* race = common_connect_job_params()->proxy_connect_race;
+  HostPortPair destination =
+      ToLegacyDestinationEndpoint(params_->destination());
+  race->SortAddresses(destination, &addresses);
+
+  // Deals the addresses in turn, so the first `width` ones, the last winner
+  // ahead, are tried at once and each sub-job falls back over its share.
+  size_t width = std::min(race->width(), addresses.size());
+  std::vector<std::vector<IPEndPoint>> shares(width);
+  for (size_t i = 0; i < addresses.size(); ++i) {
+    shares[i % width].push_back(addresses[i]);
+  }
+  for (auto& share : shares) {
+    race_jobs_.push_back(std::make_unique<TransportConnectSubJob>(
+        std::move(share), this, SUB_JOB_RACE));
+  }
+
+  // A sub-job completing synchronously removes itself from `race_jobs_`.
+  for (size_t i = 0; i < race_jobs_.size();) {
+    TransportConnectSubJob* job = race_jobs_[i].get();
+    if (job->started()) {
+      ++i;
+      continue;
+    }
+    int result = job->Start();
+    if (result == ERR_IO_PENDING) {
+      ++i;
+      continue;
+    }
+    result = HandleSubJobComplete(result, job);
+    if (result != ERR_IO_PENDING) {
+      return result;
+    }
+    i = 0;
+  }
+  return ERR_IO_PENDING;
+}
+
 int TransportConnectJob::DoTransportConnectComplete(int result) {
   // Make sure nothing else calls back into this object.
   ipv4_job_.reset();
   ipv6_job_.reset();
+  race_jobs_.clear();
   fallback_timer_.Stop();
+  service_endpoint_request_.reset();
 
   if (result == OK) {
     DCHECK(!connect_timing_.connect_start.is_null());
@@ -442,6 +604,16 @@ int TransportConnectJob::HandleSubJobComplete(int result,
                                               TransportConnectSubJob* job) {
   DCHECK_NE(result, ERR_IO_PENDING);
   if (result == OK) {
+    if (job->type() == SUB_JOB_RACE) {
+      IPEndPoint winner;
+      if (job->socket()->GetPeerAddress(&winner) == OK) {
+        common_connect_job_params()->proxy_connect_race->OnRaceWon(
+            ToLegacyDestinationEndpoint(params_->destination()), winner);
+      }
+    }
+    if (service_endpoint_request_) {
+      dns_aliases_ = service_endpoint_request_->GetDnsAliasResults();
+    }
     SetSocket(job->PassSocket(), dns_aliases_);
     return result;
   }
@@ -467,13 +639,25 @@ int TransportConnectJob::HandleSubJobComplete(int result,
         }
       }
       break;
+
+    case SUB_JOB_RACE:
+      std::erase_if(race_jobs_, [job](const auto& race_job) {
+        return race_job.get() == job;
+      });
+      break;
   }
 
-  if (ipv4_job_ || ipv6_job_) {
+  if (ipv4_job_ || ipv6_job_ || !race_jobs_.empty()) {
     // Wait for the other job to complete, rather than reporting |result|.
     return ERR_IO_PENDING;
   }
 
+  if (service_endpoint_request_) {
+    // Wait for the addresses still being resolved.
+    last_sub_job_error_ = result;
+    return ERR_IO_PENDING;
+  }
+
   return result;
 }
 
@@ -493,6 +677,111 @@ void TransportConnectJob::StartIPv4JobAsync() {
     OnSubJobComplete(result, ipv4_job_.get());
 }
 
+bool TransportConnectJob::ConnectsWhileResolving() const {
+  const bool* enabled =
+      common_connect_job_params()->enable_connect_while_resolving;
+  // Only for plain A/AAAA connects, without SVCB/HTTPS routes to choose
+  // between, nor the complete results to give to a callback or a race.
+  return enabled && *enabled && !has_dns_override_ &&
+         params_->host_resolution_callback().is_null() &&
+         params_->supported_alpns().empty() && !params_->race_connects();
+}
+
+bool TransportConnectJob::CheckServiceEndpoints() {
+  std::vector<IPEndPoint> ipv4_addresses, ipv6_addresses;
+  GetServiceEndpoints(&ipv4_addresses, &ipv6_addresses, /*take=*/false);
+  if (!ipv6_addresses.empty()) {
+    return true;
+  }
+  if (!ipv4_addresses.empty() && !resolution_delay_timer_.IsRunning()) {
+    // This use of base::Unretained is safe because |resolution_delay_timer_|
+    // is owned by this object.
+    resolution_delay_timer_.Start(
+        FROM_HERE, kResolutionDelay,
+        base::BindOnce(&TransportConnectJob::OnIOComplete,
+                       base::Unretained(this), OK));
+  }
+  return false;
+}
+
+void TransportConnectJob::GetServiceEndpoints(
+    std::vector<IPEndPoint>* ipv4_addresses,
+    std::vector<IPEndPoint>* ipv6_addresses,
+    bool take) {
+  for (const ServiceEndpoint& endpoint :
+       service_endpoint_request_->GetEndpointResults()) {
+    // As `IsEndpointResultUsable` without ALPN protocols.
+    if (!endpoint.metadata.supported_protocol_alpns.empty()) {
+      continue;
+    }
+    if (!ipv4_addresses_taken_) {
+      ipv4_addresses->insert(ipv4_addresses->end(),
+                             endpoint.ipv4_endpoints.begin(),
+                             endpoint.ipv4_endpoints.end());
+    }
+    if (!ipv6_addresses_taken_) {
+      ipv6_addresses->insert(ipv6_addresses->end(),
+                             endpoint.ipv6_endpoints.begin(),
+                             endpoint.ipv6_endpoints.end());
+    }
+  }
+  if (take) {
+    ipv4_addresses_taken_ |= !ipv4_addresses->empty();
+    ipv6_addresses_taken_ |= !ipv6_addresses->empty();
+  }
+}
+
+int TransportConnectJob::StartLateSubJobs() {
+  std::vector<IPEndPoint> ipv4_addresses, ipv6_addresses;
+  GetServiceEndpoints(&ipv4_addresses, &ipv6_addresses, /*take=*/true);
+  std::vector<IPEndPoint>& ip_endpoints =
+      endpoint_results_[current_endpoint_result_].ip_endpoints;
+
+  if (!ipv6_addresses.empty()) {
+    DCHECK(!ipv6_job_);
+    ip_endpoints.insert(ip_endpoints.end(), ipv6_addresses.begin(),
+                        ipv6_addresses.end());
+    ipv6_job_ = std::make_unique<TransportConnectSubJob>(
+        std::move(ipv6_addresses), this, SUB_JOB_IPV6);
+    int result = ipv6_job_->Start();
+    if (result != ERR_IO_PENDING) {
+      result = HandleSubJobComplete(result, ipv6_job_.get());
+      if (result != ERR_IO_PENDING) {
+        return result;
+      }
+    }
+  }
+
+  if (!ipv4_addresses.empty()) {
+    DCHECK(!ipv4_job_);
+    ip_endpoints.insert(ip_endpoints.end(), ipv4_addresses.begin(),
+                        ipv4_addresses.end());
+    ipv4_job_ = std::make_unique<TransportConnectSubJob>(
+        std::move(ipv4_addresses), this, SUB_JOB_IPV4);
+    // IPv6 keeps its head start, counted from when connecting started.
+    base::TimeDelta delay;
+    if (ipv6_job_) {
+      delay = kIPv6FallbackTime -
+              (base::TimeTicks::Now() - connect_timing_.connect_start);
+    }
+    if (delay.is_positive()) {
+      // This use of base::Unretained is safe because |fallback_timer_| is
+      // owned by this object.
+      fallback_timer_.Start(
+          FROM_HERE, delay,
+          base::BindOnce(&TransportConnectJob::StartIPv4JobAsync,
+                         base::Unretained(this)));
+    } else {
+      int result = ipv4_job_->Start();
+      if (result != ERR_IO_PENDING) {
+        return HandleSubJobComplete(result, ipv4_job_.get());
+      }
+    }
+  }
+
+  return ERR_IO_PENDING;
+}
+
 int TransportConnectJob::ConnectInternal() {
   next_state_ = STATE_RESOLVE_HOST;
   return DoLoop(OK);
@@ -504,6 +793,9 @@ void TransportConnectJob::ChangePriorityInternal(RequestPriority priority) {
     // Change the request priority in the host resolver.
     request_->ChangeRequestPriority(priority);
   }
+  if (service_endpoint_request_) {
+    service_endpoint_request_->ChangeRequestPriority(priority);
+  }
 }
 
 bool TransportConnectJob::IsSvcbOptional(
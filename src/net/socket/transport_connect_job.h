@@ -18,6 +18,7 @@
 #include "base/time/time.h"
 #include "base/timer/timer.h"
 #include "net/base/host_port_pair.h"
+#include "net/base/net_errors.h"
 #include "net/base/net_export.h"
 #include "net/base/network_anonymization_key.h"
 #include "net/dns/host_resolver.h"
@@ -50,12 +51,20 @@ class NET_EXPORT_PRIVATE TransportSocketParams
   // then the connection will be aborted with that value. `supported_alpns`
   // specifies ALPN protocols for selecting HTTPS/SVCB records. If empty,
   // addresses from HTTPS/SVCB records will be ignored and only A/AAAA will be
-  // used.
-  TransportSocketParams(Endpoint destination,
-                        NetworkAnonymizationKey network_anonymization_key,
-                        SecureDnsPolicy secure_dns_policy,
-                        OnHostResolutionCallback host_resolution_callback,
-                        base::flat_set<std::string> supported_alpns);
+  // used. If `race_connects` is true, the addresses are raced as set by
+  // CommonConnectJobParams::proxy_connect_race, if any.
+  // `session_network_anonymization_key` is the key of the session the
+  // connection is made for, passed to the ClientSocketFactory, which may
+  // open the socket differently for it. It is not used for the resolution.
+  TransportSocketParams(
+      Endpoint destination,
+      NetworkAnonymizationKey network_anonymization_key,
+      SecureDnsPolicy secure_dns_policy,
+      OnHostResolutionCallback host_resolution_callback,
+      base::flat_set<std::string> supported_alpns,
+      bool race_connects = false,
+      NetworkAnonymizationKey session_network_anonymization_key =
+          NetworkAnonymizationKey());
 
   TransportSocketParams(const TransportSocketParams&) = delete;
   TransportSocketParams& operator=(const TransportSocketParams&) = delete;
@@ -71,6 +80,10 @@ class NET_EXPORT_PRIVATE TransportSocketParams
   const base::flat_set<std::string>& supported_alpns() const {
     return supported_alpns_;
   }
+  bool race_connects() const { return race_connects_; }
+  const NetworkAnonymizationKey& session_network_anonymization_key() const {
+    return session_network_anonymization_key_;
+  }
 
  private:
   friend class base::RefCounted<TransportSocketParams>;
@@ -81,6 +94,8 @@ class NET_EXPORT_PRIVATE TransportSocketParams
   const SecureDnsPolicy secure_dns_policy_;
   const OnHostResolutionCallback host_resolution_callback_;
   const base::flat_set<std::string> supported_alpns_;
+  const bool race_connects_;
+  const NetworkAnonymizationKey session_network_anonymization_key_;
 };
 
 // TransportConnectJob handles the host resolution necessary for socket creation
@@ -91,7 +106,20 @@ class NET_EXPORT_PRIVATE TransportSocketParams
 // (kIPv6FallbackTime) and start a connect() to a IPv4 address if the timer
 // fires. Then we race the IPv4 connect() against the IPv6 connect() (which has
 // a headstart) and return the one that completes first to the socket pool.
-class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
+//
+// When the addresses are raced, they are instead dealt over up to
+// TransportConnectRace::width() sub-jobs, all started at once, and the first
+// to connect wins.
+//
+// With CommonConnectJobParams::enable_connect_while_resolving, plain A/AAAA
+// connects do not wait for both answers. The host is resolved with a
+// ServiceEndpointRequest, and connecting starts as soon as IPv6 addresses
+// are known, or kResolutionDelay after only IPv4 ones are (RFC 8305). The
+// other family joins when it is resolved: IPv6 at once, and IPv4 no earlier
+// than kIPv6FallbackTime after connecting started.
+class NET_EXPORT_PRIVATE TransportConnectJob
+    : public ConnectJob,
+      public HostResolver::ServiceEndpointRequest::Delegate {
  public:
   class NET_EXPORT_PRIVATE Factory {
    public:
@@ -116,6 +144,10 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
   // they don't synchronize.
   static constexpr base::TimeDelta kIPv6FallbackTime = base::Milliseconds(300);
 
+  // When connecting while resolving, how long IPv4 addresses wait for IPv6
+  // ones before they are connected to.
+  static constexpr base::TimeDelta kResolutionDelay = base::Milliseconds(50);
+
   struct NET_EXPORT_PRIVATE EndpointResultOverride {
     EndpointResultOverride(HostResolverEndpointResult result,
                            std::set<std::string> dns_aliases);
@@ -151,6 +183,10 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
   std::optional<HostResolverEndpointResult> GetHostResolverEndpointResult()
       const override;
 
+  // HostResolver::ServiceEndpointRequest::Delegate methods.
+  void OnServiceEndpointsUpdated() override;
+  void OnServiceEndpointRequestFinished(int rv) override;
+
   static base::TimeDelta ConnectionTimeout();
 
  private:
@@ -160,6 +196,7 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
     STATE_RESOLVE_HOST,
     STATE_RESOLVE_HOST_COMPLETE,
     STATE_RESOLVE_HOST_CALLBACK_COMPLETE,
+    STATE_RESOLVE_SERVICE_ENDPOINTS_COMPLETE,
     STATE_TRANSPORT_CONNECT,
     STATE_TRANSPORT_CONNECT_COMPLETE,
     STATE_NONE,
@@ -167,7 +204,7 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
 
   // Although it is not strictly necessary, it makes the code simpler if each
   // subjob knows what type it is.
-  enum SubJobType { SUB_JOB_IPV4, SUB_JOB_IPV6 };
+  enum SubJobType { SUB_JOB_IPV4, SUB_JOB_IPV6, SUB_JOB_RACE };
 
   void OnIOComplete(int result);
   int DoLoop(int result);
@@ -175,7 +212,10 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
   int DoResolveHost();
   int DoResolveHostComplete(int result);
   int DoResolveHostCallbackComplete();
+  int DoResolveServiceEndpointsComplete(int result);
   int DoTransportConnect();
+  // Starts the sub-jobs of a race, as DoTransportConnect().
+  int DoRaceConnect(std::vector<IPEndPoint> addresses);
   int DoTransportConnectComplete(int result);
 
   // Helper method called called when a SubJob completes, synchronously
@@ -191,6 +231,21 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
   // Called from |fallback_timer_|.
   void StartIPv4JobAsync();
 
+  // Whether the host is resolved with `service_endpoint_request_`, and
+  // connected to while it is.
+  bool ConnectsWhileResolving() const;
+  // Returns whether enough addresses are resolved to start connecting. For
+  // IPv4 addresses alone, starts `resolution_delay_timer_` instead.
+  bool CheckServiceEndpoints();
+  // Gets the A/AAAA addresses of `service_endpoint_request_` of the families
+  // not yet taken, and with `take`, marks those families as taken.
+  void GetServiceEndpoints(std::vector<IPEndPoint>* ipv4_addresses,
+                           std::vector<IPEndPoint>* ipv6_addresses,
+                           bool take);
+  // Starts sub-jobs for the families resolved after connecting started.
+  // Returns as HandleSubJobComplete().
+  int StartLateSubJobs();
+
   // Begins the host resolution and the TCP connect.  Returns OK on success
   // and ERR_IO_PENDING if it cannot immediately service the request.
   // Otherwise, it returns a net error code.
@@ -213,6 +268,15 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
 
   scoped_refptr<TransportSocketParams> params_;
   std::unique_ptr<HostResolver::ResolveHostRequest> request_;
+  // Alive while more addresses may come when connecting while resolving.
+  std::unique_ptr<HostResolver::ServiceEndpointRequest>
+      service_endpoint_request_;
+  bool service_endpoints_resolved_ = false;
+  bool ipv4_addresses_taken_ = false;
+  bool ipv6_addresses_taken_ = false;
+  base::OneShotTimer resolution_delay_timer_;
+  // Of the last sub-job to fail while `service_endpoint_request_` was alive.
+  int last_sub_job_error_ = ERR_NAME_NOT_RESOLVED;
   std::vector<HostResolverEndpointResult> endpoint_results_;
   size_t current_endpoint_result_ = 0;
   std::set<std::string> dns_aliases_;
@@ -227,6 +291,8 @@ class NET_EXPORT_PRIVATE TransportConnectJob : public ConnectJob {
   // other one is launched if needed, and we wait for it to complete.
   std::unique_ptr<TransportConnectSubJob> ipv4_job_;
   std::unique_ptr<TransportConnectSubJob> ipv6_job_;
+  // The sub-jobs still running when racing.
+  std::vector<std::unique_ptr<TransportConnectSubJob>> race_jobs_;
 
   base::OneShotTimer fallback_timer_;
 
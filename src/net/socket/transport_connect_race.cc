@@ -0,0 +1,39 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/transport_connect_race.h"
+
+#include <algorithm>
+
+namespace net {
+
+namespace {
+
+// Proxies are few, so this only bounds a misuse.
+constexpr size_t kMaxWinners = 64;
+
+}  // namespace
+
+TransportConnectRace::TransportConnectRace(size_t width)
+    : width_(std::clamp<size_t>(width, 1, kMaxWidth)), winners_(kMaxWinners) {}
+
+TransportConnectRace::~TransportConnectRace() = default;
+
+void TransportConnectRace::SortAddresses(
+    const HostPortPair& destination,
+    std::vector<IPEndPoint>* addresses) const {
+  auto winner = winners_.Peek(destination);
+  if (winner == winners_.end())
+    return;
+  auto it = std::find(addresses->begin(), addresses->end(), winner->second);
+  if (it != addresses->end())
+    std::rotate(addresses->begin(), it, it + 1);
+}
+
+void TransportConnectRace::OnRaceWon(const HostPortPair& destination,
+                                     const IPEndPoint& winner) {
+  winners_.Put(destination, winner);
+}
+
+}  // namespace net
@@ -0,0 +1,52 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SOCKET_TRANSPORT_CONNECT_RACE_H_
+#define NET_SOCKET_TRANSPORT_CONNECT_RACE_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "base/containers/lru_cache.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_export.h"
+
+namespace net {
+
+// Lets TransportConnectJobs to proxies connect to up to `width` addresses of
+// the proxy at once instead of falling back from one to the next, and keeps
+// the address that connected first for each proxy, so later connects start
+// with it. It is owned by the HttpNetworkSession and, like it, used on one
+// thread.
+class NET_EXPORT_PRIVATE TransportConnectRace {
+ public:
+  static constexpr size_t kMaxWidth = 8;
+
+  explicit TransportConnectRace(size_t width);
+
+  TransportConnectRace(const TransportConnectRace&) = delete;
+  TransportConnectRace& operator=(const TransportConnectRace&) = delete;
+
+  ~TransportConnectRace();
+
+  size_t width() const { return width_; }
+
+  // Moves the address that last won for `destination` to the front of
+  // `addresses`, if it is there.
+  void SortAddresses(const HostPortPair& destination,
+                     std::vector<IPEndPoint>* addresses) const;
+
+  // Records that `winner` connected first for `destination`.
+  void OnRaceWon(const HostPortPair& destination, const IPEndPoint& winner);
+
+ private:
+  const size_t width_;
+  base::LRUCache<HostPortPair, IPEndPoint> winners_;
+};
+
+}  // namespace net
+
+#endif  // NET_SOCKET_TRANSPORT_CONNECT_RACE_H_
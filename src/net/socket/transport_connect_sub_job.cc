@@ -215,10 +215,12 @@ int TransportConnectSubJob::DoEndpointLockComplete() {
 
   const NetLogWithSource& net_log = parent_job_->net_log();
   transport_socket_ =
-      parent_job_->client_socket_factory()->CreateTransportClientSocket(
-          one_address, std::move(socket_performance_watcher),
-          parent_job_->network_quality_estimator(), net_log.net_log(),
-          net_log.source());
+      parent_job_->client_socket_factory()
+          ->CreateTransportClientSocketForSession(
+              one_address, std::move(socket_performance_watcher),
+              parent_job_->network_quality_estimator(), net_log.net_log(),
+              net_log.source(),
+              parent_job_->params_->session_network_anonymization_key());
 
   net_log.AddEvent(NetLogEventType::TRANSPORT_CONNECT_JOB_CONNECT_ATTEMPT, [&] {
     auto dict = base::Value::Dict().Set("address", CurrentAddress().ToString());
@@ -257,6 +257,64 @@ void UDPClientSocket::SetIOSNetworkServiceType(int ios_network_service_type) {
 #endif
 }
 
+bool UDPClientSocket::SupportsSegmentedWrites() const {
+#if BUILDFLAG(IS_POSIX)
+  return socket_.SupportsSegmentedWrites();
+#else
+  return false;
+#endif
+}
+
+int UDPClientSocket::WriteSegmented(
+    IOBuffer* buf,
+    int buf_len,
+    int segment_size,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+#if BUILDFLAG(IS_POSIX)
+  return socket_.WriteSegmented(buf, buf_len, segment_size,
+                                std::move(callback), traffic_annotation);
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int UDPClientSocket::EnableCoalescedReads() {
+#if BUILDFLAG(IS_POSIX)
+  return socket_.EnableCoalescedReads();
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int UDPClientSocket::ReadCoalesced(IOBuffer* buf,
+                                   int buf_len,
+                                   int* segment_size,
+                                   CompletionOnceCallback callback) {
+#if BUILDFLAG(IS_POSIX)
+  return socket_.ReadCoalesced(buf, buf_len, segment_size,
+                               std::move(callback));
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int UDPClientSocket::EnableReceiveDropCount() {
+#if BUILDFLAG(IS_POSIX)
+  return socket_.EnableReceiveDropCount();
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+uint32_t UDPClientSocket::GetReceiveDropCount() const {
+#if BUILDFLAG(IS_POSIX)
+  return socket_.receive_drop_count();
+#else
+  return 0;
+#endif
+}
+
 int UDPClientSocket::AdoptOpenedSocket(AddressFamily address_family,
                                        SocketDescriptor socket) {
   int rv = socket_.AdoptOpenedSocket(address_family, socket);
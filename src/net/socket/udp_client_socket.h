@@ -50,6 +50,8 @@ class NET_EXPORT_PRIVATE UDPClientSocket : public DatagramClientSocket {
   int ConnectUsingNetworkAsync(handles::NetworkHandle network,
                                const IPEndPoint& address,
                                CompletionOnceCallback callback) override;
+  int EnableReceiveDropCount() override;
+  uint32_t GetReceiveDropCount() const override;
   int ConnectUsingDefaultNetworkAsync(const IPEndPoint& address,
                                       CompletionOnceCallback callback) override;
   DscpAndEcn GetLastTos() const override;
@@ -63,6 +65,11 @@ class NET_EXPORT_PRIVATE UDPClientSocket : public DatagramClientSocket {
             int buf_len,
             CompletionOnceCallback callback,
             const NetworkTrafficAnnotationTag& traffic_annotation) override;
+  int EnableCoalescedReads() override;
+  int ReadCoalesced(IOBuffer* buf,
+                    int buf_len,
+                    int* segment_size,
+                    CompletionOnceCallback callback) override;
 
   void Close() override;
   int GetPeerAddress(IPEndPoint* address) const override;
@@ -81,6 +88,13 @@ class NET_EXPORT_PRIVATE UDPClientSocket : public DatagramClientSocket {
 
   int SetMulticastInterface(uint32_t interface_index) override;
   void SetIOSNetworkServiceType(int ios_network_service_type) override;
+  bool SupportsSegmentedWrites() const override;
+  int WriteSegmented(
+      IOBuffer* buf,
+      int buf_len,
+      int segment_size,
+      CompletionOnceCallback callback,
+      const NetworkTrafficAnnotationTag& traffic_annotation) override;
 
   // Takes ownership of an opened but unconnected and unbound `socket`. This
   // method must be called after UseNonBlockingIO, otherwise the adopted socket
@@ -147,6 +147,59 @@ DscpAndEcn UDPServerSocket::GetLastTos() const {
   return socket_.GetLastTos();
 }
 
+bool UDPServerSocket::SupportsSegmentedWrites() const {
+#if BUILDFLAG(IS_POSIX)
+  return socket_.SupportsSegmentedWrites();
+#else
+  return false;
+#endif
+}
+
+int UDPServerSocket::SendToSegmented(IOBuffer* buf,
+                                     int buf_len,
+                                     int segment_size,
+                                     const IPEndPoint& address,
+                                     CompletionOnceCallback callback) {
+#if BUILDFLAG(IS_POSIX)
+  return socket_.SendToSegmented(buf, buf_len, segment_size, address,
+                                 std::move(callback));
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int UDPServerSocket::EnableCoalescedReads() {
+#if BUILDFLAG(IS_POSIX)
+  return socket_.EnableCoalescedReads();
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int UDPServerSocket::RecvFromCoalesced(IOBuffer* buf,
+                                       int buf_len,
+                                       int* segment_size,
+                                       IPEndPoint* address,
+                                       CompletionOnceCallback callback) {
+#if BUILDFLAG(IS_POSIX)
+  return socket_.RecvFromCoalesced(buf, buf_len, segment_size, address,
+                                   std::move(callback));
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+#if !BUILDFLAG(IS_WIN)
+int UDPServerSocket::AdoptOpenedSocket(AddressFamily address_family,
+                                       SocketDescriptor socket) {
+  return socket_.AdoptOpenedSocket(address_family, socket);
+}
+
+SocketDescriptor UDPServerSocket::GetSocketDescriptor() const {
+  return socket_.GetSocketDescriptor();
+}
+#endif  // !BUILDFLAG(IS_WIN)
+
 void UDPServerSocket::UseNonBlockingIO() {
 #if BUILDFLAG(IS_WIN)
   socket_.UseNonBlockingIO();
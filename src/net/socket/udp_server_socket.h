@@ -7,9 +7,12 @@
 
 #include <stdint.h>
 
+#include "build/build_config.h"
+#include "net/base/address_family.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/net_export.h"
 #include "net/socket/datagram_server_socket.h"
+#include "net/socket/socket_descriptor.h"
 #include "net/socket/udp_socket.h"
 
 namespace net {
@@ -61,6 +64,30 @@ class NET_EXPORT UDPServerSocket : public DatagramServerSocket {
   int SetTos(DiffServCodePoint dscp, EcnCodePoint ecn) override;
   void DetachFromThread() override;
   DscpAndEcn GetLastTos() const override;
+  bool SupportsSegmentedWrites() const override;
+  int SendToSegmented(IOBuffer* buf,
+                      int buf_len,
+                      int segment_size,
+                      const IPEndPoint& address,
+                      CompletionOnceCallback callback) override;
+  int EnableCoalescedReads() override;
+  int RecvFromCoalesced(IOBuffer* buf,
+                        int buf_len,
+                        int* segment_size,
+                        IPEndPoint* address,
+                        CompletionOnceCallback callback) override;
+
+#if !BUILDFLAG(IS_WIN)
+  // Takes ownership of an opened `socket`, which may already be bound, e.g.
+  // one inherited from another process. This method must be called after
+  // UseNonBlockingIO, otherwise the adopted socket will not have the
+  // non-blocking IO flag set.
+  int AdoptOpenedSocket(AddressFamily address_family, SocketDescriptor socket);
+
+  // Returns the underlying socket descriptor, for handing it to another
+  // process.
+  SocketDescriptor GetSocketDescriptor() const;
+#endif  // !BUILDFLAG(IS_WIN)
 
  private:
   UDPSocket socket_;
@@ -25,6 +25,8 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 
 #include "base/debug/alias.h"
@@ -57,6 +59,23 @@
 #include "net/socket/udp_net_log_parameters.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+#include <netinet/udp.h>
+#include <sys/uio.h>
+
+// Since Linux 4.18. Older headers lack these.
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+// Since Linux 5.0.
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
+
 #if BUILDFLAG(IS_ANDROID)
 #include "base/native_library.h"
 #include "net/android/network_library.h"
@@ -279,6 +298,56 @@ int UDPSocketPosix::Read(IOBuffer* buf,
   return RecvFrom(buf, buf_len, nullptr, std::move(callback));
 }
 
+int UDPSocketPosix::EnableCoalescedReads() {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  DCHECK_NE(kInvalidSocket, socket_);
+  int value = 1;
+  if (setsockopt(socket_, SOL_UDP, UDP_GRO, &value, sizeof(value)) != 0)
+    return MapSystemError(errno);
+  coalesced_reads_enabled_ = true;
+  return OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int UDPSocketPosix::EnableReceiveDropCount() {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  DCHECK_NE(kInvalidSocket, socket_);
+  int value = 1;
+  if (setsockopt(socket_, SOL_SOCKET, SO_RXQ_OVFL, &value, sizeof(value)) !=
+      0) {
+    return MapSystemError(errno);
+  }
+  receive_drop_count_enabled_ = true;
+  return OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int UDPSocketPosix::ReadCoalesced(IOBuffer* buf,
+                                  int buf_len,
+                                  int* segment_size,
+                                  CompletionOnceCallback callback) {
+  return RecvFromCoalesced(buf, buf_len, segment_size, nullptr,
+                           std::move(callback));
+}
+
+int UDPSocketPosix::RecvFromCoalesced(IOBuffer* buf,
+                                      int buf_len,
+                                      int* segment_size,
+                                      IPEndPoint* address,
+                                      CompletionOnceCallback callback) {
+  DCHECK(coalesced_reads_enabled_);
+  DCHECK(segment_size);
+  read_segment_size_ = segment_size;
+  int rv = RecvFrom(buf, buf_len, address, std::move(callback));
+  if (rv != ERR_IO_PENDING)
+    read_segment_size_ = nullptr;
+  return rv;
+}
+
 int UDPSocketPosix::RecvFrom(IOBuffer* buf,
                              int buf_len,
                              IPEndPoint* address,
@@ -318,6 +387,48 @@ int UDPSocketPosix::Write(
   return SendToOrWrite(buf, buf_len, nullptr, std::move(callback));
 }
 
+bool UDPSocketPosix::SupportsSegmentedWrites() const {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  if (!segmented_writes_supported_.has_value()) {
+    int value = 0;
+    socklen_t value_len = sizeof(value);
+    segmented_writes_supported_ =
+        getsockopt(socket_, SOL_UDP, UDP_SEGMENT, &value, &value_len) == 0;
+  }
+  return *segmented_writes_supported_;
+#else
+  return false;
+#endif
+}
+
+int UDPSocketPosix::WriteSegmented(
+    IOBuffer* buf,
+    int buf_len,
+    int segment_size,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  DCHECK(is_connected_);
+  DCHECK_GT(segment_size, 0);
+  write_segment_size_ = segment_size;
+  int rv = SendToOrWrite(buf, buf_len, nullptr, std::move(callback));
+  if (rv != ERR_IO_PENDING)
+    write_segment_size_ = 0;
+  return rv;
+}
+
+int UDPSocketPosix::SendToSegmented(IOBuffer* buf,
+                                    int buf_len,
+                                    int segment_size,
+                                    const IPEndPoint& address,
+                                    CompletionOnceCallback callback) {
+  DCHECK_GT(segment_size, 0);
+  write_segment_size_ = segment_size;
+  int rv = SendToOrWrite(buf, buf_len, &address, std::move(callback));
+  if (rv != ERR_IO_PENDING)
+    write_segment_size_ = 0;
+  return rv;
+}
+
 int UDPSocketPosix::SendTo(IOBuffer* buf,
                            int buf_len,
                            const IPEndPoint& address,
@@ -517,12 +628,16 @@ int UDPSocketPosix::SetRecvTos() {
       return MapSystemError(errno);
     }
     if (v6_only) {
+      recv_tos_enabled_ = true;
       return OK;
     }
   }
 
   int rv = setsockopt(socket_, IPPROTO_IP, IP_RECVTOS, &ecn, sizeof(ecn));
-  return rv == 0 ? OK : MapSystemError(errno);
+  if (rv != 0)
+    return MapSystemError(errno);
+  recv_tos_enabled_ = true;
+  return OK;
 }
 
 void UDPSocketPosix::SetMsgConfirm(bool confirm) {
@@ -624,6 +739,7 @@ void UDPSocketPosix::DidCompleteRead() {
     read_buf_.reset();
     read_buf_len_ = 0;
     recv_from_address_ = nullptr;
+    read_segment_size_ = nullptr;
     bool ok = read_socket_watcher_.StopWatchingFileDescriptor();
     DCHECK(ok);
     DoReadCallback(result);
@@ -660,6 +776,7 @@ void UDPSocketPosix::DidCompleteWrite() {
   if (result != ERR_IO_PENDING) {
     write_buf_.reset();
     write_buf_len_ = 0;
+    write_segment_size_ = 0;
     send_to_address_.reset();
     write_socket_watcher_.StopWatchingFileDescriptor();
     DoWriteCallback(result);
@@ -680,18 +797,16 @@ void UDPSocketPosix::LogWrite(int result,
   }
 }
 
-// TODO(crbug.com/40285166): Because InternalRecvFromConnectedSocket() uses
-// recvfrom() instead of recvmsg(), it cannot report received ECN marks for
-// QUIC ACK-ECN frames. It might be time to deprecate
-// experimental_recv_optimization_enabled_ if that experiment has run its
-// course.
 int UDPSocketPosix::InternalRecvFrom(IOBuffer* buf,
                                      int buf_len,
                                      IPEndPoint* address) {
   // If the socket is connected and the remote address is known
   // use the more efficient method that uses read() instead of recvmsg().
+  // Coalesced reads, drop counts and received TOS need the control messages
+  // of recvmsg().
   if (experimental_recv_optimization_enabled_ && is_connected_ &&
-      remote_address_) {
+      remote_address_ && !read_segment_size_ &&
+      !receive_drop_count_enabled_ && !recv_tos_enabled_) {
     return InternalRecvFromConnectedSocket(buf, buf_len, address);
   }
   return InternalRecvFromNonConnectedSocket(buf, buf_len, address);
@@ -768,9 +883,27 @@ int UDPSocketPosix::InternalRecvFromNonConnectedSocket(IOBuffer* buf,
       result = bytes_transferred;
     }
     last_tos_ = 0;
+    // Datagrams that were not coalesced come without UDP_GRO.
+    if (read_segment_size_)
+      *read_segment_size_ = bytes_transferred;
     if (bytes_transferred > 0 && msg.msg_controllen > 0) {
       for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
            cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+        if (read_segment_size_ && cmsg->cmsg_level == SOL_UDP &&
+            cmsg->cmsg_type == UDP_GRO) {
+          int segment_size;
+          std::memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+          *read_segment_size_ = segment_size;
+          continue;
+        }
+        // Only there once the kernel has dropped datagrams.
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+          std::memcpy(&receive_drop_count_, CMSG_DATA(cmsg),
+                      sizeof(receive_drop_count_));
+          continue;
+        }
+#endif
 #if BUILDFLAG(IS_APPLE)
         if ((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVTOS) ||
             (cmsg->cmsg_level == IPPROTO_IPV6 &&
@@ -793,6 +926,9 @@ int UDPSocketPosix::InternalRecvFromNonConnectedSocket(IOBuffer* buf,
 int UDPSocketPosix::InternalSendTo(IOBuffer* buf,
                                    int buf_len,
                                    const IPEndPoint* address) {
+  if (write_segment_size_ > 0 && buf_len > write_segment_size_)
+    return InternalSendSegmented(buf, buf_len, address);
+
   SockaddrStorage storage;
   struct sockaddr* addr = storage.addr;
   if (!address) {
@@ -815,6 +951,77 @@ int UDPSocketPosix::InternalSendTo(IOBuffer* buf,
   return result;
 }
 
+int UDPSocketPosix::InternalSendSegmented(IOBuffer* buf,
+                                          int buf_len,
+                                          const IPEndPoint* address) {
+  SockaddrStorage storage;
+  struct sockaddr* addr = nullptr;
+  socklen_t addr_len = 0;
+  if (address) {
+    if (!address->ToSockAddr(storage.addr, &storage.addr_len)) {
+      int result = ERR_ADDRESS_INVALID;
+      LogWrite(result, nullptr, nullptr);
+      return result;
+    }
+    addr = storage.addr;
+    addr_len = storage.addr_len;
+  }
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  if (segmented_writes_supported_.value_or(false)) {
+    struct iovec iov = {buf->data(), static_cast<size_t>(buf_len)};
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+    struct msghdr msg = {};
+    msg.msg_name = addr;
+    msg.msg_namelen = addr_len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    uint16_t segment_size = static_cast<uint16_t>(write_segment_size_);
+    std::memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+
+    int result = HANDLE_EINTR(sendmsg(socket_, &msg, sendto_flags_));
+    // EIO is returned by devices without checksum offload, and EINVAL by
+    // paths whose MTU is below the segment size. Writing the datagrams one
+    // by one works for the former and reports the latter properly.
+    if (result >= 0 || (errno != EIO && errno != EINVAL)) {
+      if (result < 0)
+        result = MapSystemError(errno);
+      if (result != ERR_IO_PENDING)
+        LogWrite(result, buf->data(), address);
+      return result;
+    }
+    DVPLOG(1) << "Segmented write failed, writing datagrams one by one";
+    segmented_writes_supported_ = false;
+  }
+#endif
+
+  int sent = 0;
+  while (sent < buf_len) {
+    int len = std::min(write_segment_size_, buf_len - sent);
+    int result = HANDLE_EINTR(sendto(socket_, buf->data() + sent, len,
+                                     sendto_flags_, addr, addr_len));
+    if (result < 0) {
+      result = MapSystemError(errno);
+      // Datagrams that do not fit once some are written are dropped, as if
+      // lost on the path, rather than retried.
+      if (sent > 0)
+        break;
+      if (result != ERR_IO_PENDING)
+        LogWrite(result, nullptr, nullptr);
+      return result;
+    }
+    sent += len;
+  }
+  LogWrite(sent, buf->data(), address);
+  return sent;
+}
+
 int UDPSocketPosix::SetMulticastOptions() {
   if (!(socket_options_ & SOCKET_OPTION_MULTICAST_LOOP)) {
     int rv;
@@ -10,6 +10,7 @@
 #include <sys/types.h>
 
 #include <memory>
+#include <optional>
 
 #include "base/logging.h"
 #include "base/memory/raw_ptr.h"
@@ -99,6 +100,59 @@ class NET_EXPORT UDPSocketPosix {
             CompletionOnceCallback callback,
             const NetworkTrafficAnnotationTag& traffic_annotation);
 
+  // Returns whether the kernel segments writes with UDP_SEGMENT. Always
+  // false outside Linux and Android.
+  bool SupportsSegmentedWrites() const;
+
+  // Writes |buf_len| bytes of |buf| as datagrams of |segment_size| bytes,
+  // the last of which may be shorter, with a single sendmsg(). If the
+  // kernel or the device turns out unable to segment, writes the datagrams
+  // one by one from then on. Only usable after the socket has been
+  // connected.
+  int WriteSegmented(IOBuffer* buf,
+                     int buf_len,
+                     int segment_size,
+                     CompletionOnceCallback callback,
+                     const NetworkTrafficAnnotationTag& traffic_annotation);
+
+  // Same as WriteSegmented(), but to |address|, for unconnected sockets.
+  int SendToSegmented(IOBuffer* buf,
+                      int buf_len,
+                      int segment_size,
+                      const IPEndPoint& address,
+                      CompletionOnceCallback callback);
+
+  // Enables UDP_GRO, so the kernel coalesces received datagrams of the same
+  // size. Reads must use ReadCoalesced() from then on. Returns
+  // ERR_NOT_IMPLEMENTED outside Linux and Android.
+  int EnableCoalescedReads();
+
+  // Reads one or more datagrams coalesced by the kernel into |buf|. All but
+  // the last are |*segment_size| bytes. The caller must keep
+  // |segment_size| alive until the callback is called. Only usable after
+  // the socket has been connected.
+  int ReadCoalesced(IOBuffer* buf,
+                    int buf_len,
+                    int* segment_size,
+                    CompletionOnceCallback callback);
+
+  // Same as ReadCoalesced(), but also receives the sender in |address|, for
+  // unconnected sockets. The caller must keep |address| alive until the
+  // callback is called.
+  int RecvFromCoalesced(IOBuffer* buf,
+                        int buf_len,
+                        int* segment_size,
+                        IPEndPoint* address,
+                        CompletionOnceCallback callback);
+
+  // Enables SO_RXQ_OVFL, so reads update receive_drop_count(). Returns
+  // ERR_NOT_IMPLEMENTED outside Linux and Android.
+  int EnableReceiveDropCount();
+
+  // Returns the number of datagrams the kernel dropped for a full receive
+  // buffer since the socket was opened, as of the last read.
+  uint32_t receive_drop_count() const { return receive_drop_count_; }
+
   // Reads from a socket and receive sender address information.
   // |buf| is the buffer to read data into.
   // |buf_len| is the maximum amount of data to read.
@@ -245,6 +299,11 @@ class NET_EXPORT UDPSocketPosix {
   // release ownership of the descriptor.
   SocketDescriptor SocketDescriptorForTesting() const { return socket_; }
 
+  // Returns the underlying socket descriptor, or kInvalidSocket if there is
+  // none, for handing it to another process. Does not release ownership of
+  // the descriptor.
+  SocketDescriptor GetSocketDescriptor() const { return socket_; }
+
   // Resets the thread to be used for thread-safety checks.
   void DetachFromThread();
 
@@ -361,6 +420,11 @@ class NET_EXPORT UDPSocketPosix {
                                          int buf_len,
                                          IPEndPoint* address);
   int InternalSendTo(IOBuffer* buf, int buf_len, const IPEndPoint* address);
+  // Writes in datagrams of |write_segment_size_| bytes to |address|, or to
+  // the connected peer if it is null.
+  int InternalSendSegmented(IOBuffer* buf,
+                            int buf_len,
+                            const IPEndPoint* address);
 
   // Applies |socket_options_| to |socket_|. Should be called before
   // Bind().
@@ -389,6 +453,22 @@ class NET_EXPORT UDPSocketPosix {
   // Flags passed to sendto().
   int sendto_flags_ = 0;
 
+  // Set by EnableCoalescedReads().
+  bool coalesced_reads_enabled_ = false;
+  // Set by EnableReceiveDropCount().
+  bool receive_drop_count_enabled_ = false;
+  uint32_t receive_drop_count_ = 0;
+  // Set by SetRecvTos().
+  bool recv_tos_enabled_ = false;
+  // Receives the segment size of the read in progress, if it is coalesced.
+  raw_ptr<int> read_segment_size_ = nullptr;
+
+  // Segment size of the write in progress, or zero if it is not segmented.
+  int write_segment_size_ = 0;
+  // Unset until probed by SupportsSegmentedWrites(), and cleared when a
+  // segmented write fails for lack of support.
+  mutable std::optional<bool> segmented_writes_supported_;
+
   // Multicast interface.
   uint32_t multicast_interface_ = 0;
 
@@ -313,6 +313,24 @@ std::unique_ptr<spdy::SpdySerializedFrame> BufferedSpdyFramer::CreatePriority(
       spdy_framer_.SerializePriority(priority_ir));
 }
 
+void BufferedSpdyFramer::SetMaxFrameSize(size_t max_frame_size) {
+  deframer_.SetMaxFrameSize(max_frame_size);
+}
+
+void BufferedSpdyFramer::SetHpackUnindexedHeaders(
+    base::flat_set<std::string> names) {
+  spdy_framer_.SetHpackIndexingPolicy(
+      [names = std::move(names)](std::string_view name, std::string_view) {
+        // As HpackEncoder::DefaultPolicy(), except for the names and
+        // :method.
+        if (name.empty())
+          return false;
+        if (name[0] == ':')
+          return name == ":authority" || name == ":method";
+        return !names.contains(name);
+      });
+}
+
 void BufferedSpdyFramer::UpdateHeaderEncoderTableSize(uint32_t value) {
   spdy_framer_.UpdateHeaderEncoderTableSize(value);
 }
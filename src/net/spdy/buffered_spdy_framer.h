@@ -12,6 +12,7 @@
 #include <string>
 #include <string_view>
 
+#include "base/containers/flat_set.h"
 #include "base/memory/raw_ptr.h"
 #include "base/time/time.h"
 #include "net/base/net_export.h"
@@ -250,6 +251,13 @@ class NET_EXPORT_PRIVATE BufferedSpdyFramer
 
   // Updates the maximum size of the header encoder compression table.
   void UpdateHeaderEncoderTableSize(uint32_t value);
+
+  // Accepts incoming frames with payloads up to |max_frame_size|.
+  void SetMaxFrameSize(size_t max_frame_size);
+  // Sends headers named in |names| as literals without indexing, so values
+  // that never repeat do not evict others from the encoder table. Also
+  // indexes :method, whose CONNECT value is not in the static table.
+  void SetHpackUnindexedHeaders(base::flat_set<std::string> names);
   // Returns the maximum size of the header encoder compression table.
   uint32_t header_encoder_table_size() const;
 
@@ -16,6 +16,7 @@
 #include "base/functional/callback.h"
 #include "base/trace_event/memory_usage_estimator.h"
 #include "net/base/io_buffer.h"
+#include "net/spdy/spdy_buffer_pool.h"
 #include "net/third_party/quiche/src/quiche/spdy/core/spdy_protocol.h"
 
 namespace net {
@@ -42,6 +43,39 @@ std::unique_ptr<spdy::SpdySerializedFrame> MakeSpdySerializedFrame(
 
 }  // namespace
 
+class SpdyBuffer::SharedFrame
+    : public base::RefCountedThreadSafe<SharedFrame> {
+ public:
+  explicit SharedFrame(std::unique_ptr<spdy::SpdySerializedFrame> frame)
+      : frame_(std::move(frame)) {}
+
+  SharedFrame(base::HeapArray<char> block,
+              size_t size,
+              base::WeakPtr<SpdyBufferPool> pool)
+      : block_(std::move(block)), size_(size), pool_(std::move(pool)) {
+    CHECK_LE(size_, block_.size());
+  }
+
+  SharedFrame(const SharedFrame&) = delete;
+  SharedFrame& operator=(const SharedFrame&) = delete;
+
+  char* data() { return frame_ ? frame_->data() : block_.data(); }
+  size_t size() const { return frame_ ? frame_->size() : size_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<SharedFrame>;
+
+  ~SharedFrame() {
+    if (!block_.empty() && pool_)
+      pool_->ReturnBlock(std::move(block_));
+  }
+
+  std::unique_ptr<spdy::SpdySerializedFrame> frame_;
+  base::HeapArray<char> block_;
+  size_t size_ = 0;
+  base::WeakPtr<SpdyBufferPool> pool_;
+};
+
 // This class is an IOBuffer implementation that simply holds a
 // reference to a SharedFrame object and a fixed offset. Used by
 // SpdyBuffer::GetIOBufferForRemainingData().
@@ -49,7 +83,8 @@ class SpdyBuffer::SharedFrameIOBuffer : public IOBuffer {
  public:
   SharedFrameIOBuffer(const scoped_refptr<SharedFrame>& shared_frame,
                       size_t offset)
-      : IOBuffer(base::make_span(*shared_frame->data).subspan(offset)),
+      : IOBuffer(base::span<char>(shared_frame->data(), shared_frame->size())
+                     .subspan(offset)),
         shared_frame_(shared_frame) {}
 
   SharedFrameIOBuffer(const SharedFrameIOBuffer&) = delete;
@@ -71,10 +106,19 @@ SpdyBuffer::SpdyBuffer(std::unique_ptr<spdy::SpdySerializedFrame> frame)
 // The given data may not be strictly a SPDY frame; we (ab)use
 // |frame_| just as a container.
 SpdyBuffer::SpdyBuffer(const char* data, size_t size)
-    : shared_frame_(base::MakeRefCounted<SharedFrame>()) {
+    : shared_frame_(base::MakeRefCounted<SharedFrame>(
+          MakeSpdySerializedFrame(data, size))) {
   CHECK_GT(size, 0u);
   CHECK_LE(size, kMaxSpdyFrameSize);
-  shared_frame_->data = MakeSpdySerializedFrame(data, size);
+}
+
+SpdyBuffer::SpdyBuffer(base::HeapArray<char> block,
+                       size_t size,
+                       base::WeakPtr<SpdyBufferPool> pool)
+    : shared_frame_(base::MakeRefCounted<SharedFrame>(std::move(block),
+                                                      size,
+                                                      std::move(pool))) {
+  CHECK_GT(size, 0u);
 }
 
 SpdyBuffer::~SpdyBuffer() {
@@ -83,11 +127,11 @@ SpdyBuffer::~SpdyBuffer() {
 }
 
 const char* SpdyBuffer::GetRemainingData() const {
-  return shared_frame_->data->data() + offset_;
+  return shared_frame_->data() + offset_;
 }
 
 size_t SpdyBuffer::GetRemainingSize() const {
-  return shared_frame_->data->size() - offset_;
+  return shared_frame_->size() - offset_;
 }
 
 void SpdyBuffer::AddConsumeCallback(const ConsumeCallback& consume_callback) {
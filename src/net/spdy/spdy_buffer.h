@@ -9,8 +9,10 @@
 #include <memory>
 #include <vector>
 
+#include "base/containers/heap_array.h"
 #include "base/functional/callback_forward.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "net/base/net_export.h"
 
 namespace spdy {
@@ -20,6 +22,7 @@ class SpdySerializedFrame;
 namespace net {
 
 class IOBuffer;
+class SpdyBufferPool;
 
 // SpdyBuffer is a class to hold data read from or to be written to a
 // SPDY connection. It is similar to a DrainableIOBuffer but is not
@@ -89,12 +92,19 @@ class NET_EXPORT_PRIVATE SpdyBuffer {
   scoped_refptr<IOBuffer> GetIOBufferForRemainingData();
 
  private:
+  friend class SpdyBufferPool;
+
+  // Construct with the first |size| bytes of |block|, which is given back to
+  // |pool| once no longer referred to.
+  SpdyBuffer(base::HeapArray<char> block,
+             size_t size,
+             base::WeakPtr<SpdyBufferPool> pool);
+
   void ConsumeHelper(size_t consume_size, ConsumeSource consume_source);
 
-  // Ref-count the passed-in spdy::SpdySerializedFrame to support the semantics
-  // of |GetIOBufferForRemainingData()|.
-  typedef base::RefCountedData<std::unique_ptr<spdy::SpdySerializedFrame>>
-      SharedFrame;
+  // Ref-counts the data, held by a spdy::SpdySerializedFrame or a pooled
+  // block, to support the semantics of |GetIOBufferForRemainingData()|.
+  class SharedFrame;
 
   class SharedFrameIOBuffer;
 
@@ -0,0 +1,109 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/spdy_buffer_pool.h"
+
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/memory/ptr_util.h"
+#include "net/spdy/spdy_buffer.h"
+
+namespace net {
+
+namespace {
+
+// Smaller buffers take less than this part of a block and are allocated as
+// usual.
+constexpr size_t kMinBlockFraction = 4;
+
+// Writes the header of an unpadded DATA frame (RFC 9113, section 4.1).
+void WriteDataFrameHeader(base::span<char> frame,
+                          spdy::SpdyStreamId stream_id,
+                          size_t len,
+                          bool fin) {
+  frame[0] = static_cast<char>(len >> 16);
+  frame[1] = static_cast<char>(len >> 8);
+  frame[2] = static_cast<char>(len);
+  frame[3] = static_cast<char>(spdy::SerializeFrameType(
+      spdy::SpdyFrameType::DATA));
+  frame[4] = static_cast<char>(fin ? spdy::DATA_FLAG_FIN
+                                   : spdy::DATA_FLAG_NONE);
+  frame[5] = static_cast<char>((stream_id >> 24) & 0x7f);
+  frame[6] = static_cast<char>(stream_id >> 16);
+  frame[7] = static_cast<char>(stream_id >> 8);
+  frame[8] = static_cast<char>(stream_id);
+}
+
+}  // namespace
+
+SpdyBufferPool::SpdyBufferPool()
+    : block_size_(spdy::kFrameHeaderSize +
+                  spdy::kHttp2DefaultFramePayloadLimit) {}
+
+SpdyBufferPool::~SpdyBufferPool() = default;
+
+void SpdyBufferPool::set_block_size(size_t block_size) {
+  if (block_size == block_size_)
+    return;
+  block_size_ = block_size;
+  free_blocks_.clear();
+}
+
+void SpdyBufferPool::ReleaseFreeBlocks() {
+  free_blocks_.clear();
+  free_blocks_.shrink_to_fit();
+}
+
+std::unique_ptr<SpdyBuffer> SpdyBufferPool::CreateBuffer(
+    base::span<const char> data) {
+  base::HeapArray<char> block = TakeBlock(data.size());
+  if (block.empty())
+    return std::make_unique<SpdyBuffer>(data.data(), data.size());
+  block.first(data.size()).copy_from(data);
+  return MakeBuffer(std::move(block), data.size());
+}
+
+std::unique_ptr<SpdyBuffer> SpdyBufferPool::CreateDataFrame(
+    spdy::SpdyStreamId stream_id,
+    base::span<const char> data,
+    bool fin) {
+  CHECK_LE(data.size(), spdy::kSpdyMaxFrameSizeLimit);
+  size_t size = spdy::kDataFrameMinimumSize + data.size();
+  base::HeapArray<char> block = TakeBlock(size);
+  // A block of another size is not taken back by ReturnBlock().
+  if (block.empty())
+    block = base::HeapArray<char>::Uninit(size);
+  WriteDataFrameHeader(block.first(spdy::kDataFrameMinimumSize), stream_id,
+                       data.size(), fin);
+  block.subspan(spdy::kDataFrameMinimumSize, data.size()).copy_from(data);
+  return MakeBuffer(std::move(block), size);
+}
+
+base::HeapArray<char> SpdyBufferPool::TakeBlock(size_t size) {
+  if (size > block_size_ || size < block_size_ / kMinBlockFraction)
+    return {};
+  if (free_blocks_.empty())
+    return base::HeapArray<char>::Uninit(block_size_);
+  base::HeapArray<char> block = std::move(free_blocks_.back());
+  free_blocks_.pop_back();
+  return block;
+}
+
+void SpdyBufferPool::ReturnBlock(base::HeapArray<char> block) {
+  if (block.size() != block_size_ ||
+      (free_blocks_.size() + 1) * block_size_ > kMaxFreeBytes) {
+    return;
+  }
+  free_blocks_.push_back(std::move(block));
+}
+
+std::unique_ptr<SpdyBuffer> SpdyBufferPool::MakeBuffer(
+    base::HeapArray<char> block,
+    size_t size) {
+  return base::WrapUnique(
+      new SpdyBuffer(std::move(block), size, weak_factory_.GetWeakPtr()));
+}
+
+}  // namespace net
@@ -0,0 +1,75 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SPDY_SPDY_BUFFER_POOL_H_
+#define NET_SPDY_SPDY_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "base/containers/heap_array.h"
+#include "base/containers/span.h"
+#include "base/memory/weak_ptr.h"
+#include "net/base/net_export.h"
+#include "net/third_party/quiche/src/quiche/spdy/core/spdy_protocol.h"
+
+namespace net {
+
+class SpdyBuffer;
+
+// Recycles the memory of the DATA frames a session sends and of the data it
+// receives, which is otherwise allocated and freed once per frame. Blocks
+// are sized for the largest frame of the session; buffers much smaller than
+// a block are allocated as usual. Owned by a SpdySession and used on its
+// sequence. Buffers may outlive the pool, and then free their blocks.
+class NET_EXPORT_PRIVATE SpdyBufferPool {
+ public:
+  // Bound on the memory kept in free blocks.
+  static constexpr size_t kMaxFreeBytes = 512 * 1024;
+
+  SpdyBufferPool();
+  ~SpdyBufferPool();
+  SpdyBufferPool(const SpdyBufferPool&) = delete;
+  SpdyBufferPool& operator=(const SpdyBufferPool&) = delete;
+
+  // Sets the block size, dropping the free blocks of the previous size.
+  // Starts as a frame header plus the default maximum payload.
+  void set_block_size(size_t block_size);
+  size_t block_size() const { return block_size_; }
+  size_t num_free_blocks() const { return free_blocks_.size(); }
+
+  // Frees the free blocks, as under memory pressure.
+  void ReleaseFreeBlocks();
+
+  // Returns a buffer holding a copy of |data|, which must not be empty.
+  std::unique_ptr<SpdyBuffer> CreateBuffer(base::span<const char> data);
+
+  // Returns an unpadded DATA frame for |stream_id| carrying |data|, like
+  // BufferedSpdyFramer::CreateDataFrame().
+  std::unique_ptr<SpdyBuffer> CreateDataFrame(spdy::SpdyStreamId stream_id,
+                                              base::span<const char> data,
+                                              bool fin);
+
+ private:
+  friend class SpdyBuffer;
+
+  // Returns a block for |size| bytes, or an empty one if |size| is not worth
+  // a block.
+  base::HeapArray<char> TakeBlock(size_t size);
+  // Called by SpdyBuffer once nothing refers to the data in |block|.
+  void ReturnBlock(base::HeapArray<char> block);
+
+  std::unique_ptr<SpdyBuffer> MakeBuffer(base::HeapArray<char> block,
+                                         size_t size);
+
+  size_t block_size_;
+  std::vector<base::HeapArray<char>> free_blocks_;
+
+  base::WeakPtrFactory<SpdyBufferPool> weak_factory_{this};
+};
+
+}  // namespace net
+
+#endif  // NET_SPDY_SPDY_BUFFER_POOL_H_
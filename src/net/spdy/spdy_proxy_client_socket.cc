@@ -91,7 +91,12 @@ int SpdyProxyClientSocket::RestartWithAuth(CompletionOnceCallback callback) {
 //
 // TODO(mmenke):  Use a single priority value for all SpdyProxyClientSockets,
 // regardless of what priority they're created with.
-void SpdyProxyClientSocket::SetStreamPriority(RequestPriority priority) {}
+void SpdyProxyClientSocket::SetStreamPriority(RequestPriority priority) {
+  // Ordering the writes of the session is what matters for a tunnel, and the
+  // proxy may follow the PRIORITY frame for its writes as well.
+  if (spdy_stream_)
+    spdy_stream_->SetPriority(priority);
+}
 
 // Sends a HEADERS frame to the proxy with a CONNECT request
 // for the specified endpoint.  Waits for the server to send back
@@ -136,6 +141,22 @@ void SpdyProxyClientSocket::Disconnect() {
   }
 }
 
+int SpdyProxyClientSocket::ShutdownWrite() {
+  DCHECK(write_callback_.is_null());
+  if (next_state_ != STATE_OPEN)
+    return ERR_SOCKET_NOT_CONNECTED;
+  if (end_stream_sent_)
+    return OK;
+
+  // Sends END_STREAM, the equivalent of the TCP FIN bit. The stream stays
+  // open for reading until the peer sends END_STREAM too.
+  DCHECK(spdy_stream_.get());
+  auto buffer = base::MakeRefCounted<IOBufferWithSize>(/*buffer_size=*/0);
+  spdy_stream_->SendData(buffer.get(), /*length=*/0, NO_MORE_DATA_TO_SEND);
+  end_stream_sent_ = true;
+  return OK;
+}
+
 bool SpdyProxyClientSocket::IsConnected() const {
   return next_state_ == STATE_OPEN;
 }
@@ -203,7 +224,7 @@ int SpdyProxyClientSocket::ReadIfReady(IOBuffer* buf,
   if (next_state_ == STATE_DISCONNECTED)
     return ERR_SOCKET_NOT_CONNECTED;
 
-  if (next_state_ == STATE_CLOSED && read_buffer_queue_.IsEmpty()) {
+  if (IsReadClosed() && read_buffer_queue_.IsEmpty()) {
     return 0;
   }
 
@@ -224,6 +245,53 @@ int SpdyProxyClientSocket::CancelReadIfReady() {
   return OK;
 }
 
+int SpdyProxyClientSocket::ReadBuffer(int max_len,
+                                      scoped_refptr<IOBuffer>* buf,
+                                      CompletionOnceCallback callback) {
+  DCHECK(!read_callback_);
+  DCHECK(!user_buffer_);
+  DCHECK_GT(max_len, 0);
+
+  if (next_state_ == STATE_DISCONNECTED)
+    return ERR_SOCKET_NOT_CONNECTED;
+
+  if (read_buffer_queue_.IsEmpty()) {
+    if (IsReadClosed())
+      return 0;
+    // Completes like a pending ReadIfReady().
+    read_callback_ = std::move(callback);
+    return ERR_IO_PENDING;
+  }
+
+  DCHECK(next_state_ == STATE_OPEN || next_state_ == STATE_CLOSED);
+  // The SpdyBuffer is consumed now, so its flow control window is returned
+  // as with a copy.
+  return read_buffer_queue_.DequeueBuffer(max_len, buf);
+}
+
+bool SpdyProxyClientSocket::GetSessionQuality(SessionQuality* quality) const {
+  if (!spdy_stream_ || !spdy_stream_->session())
+    return false;
+  const SpdySession* session = spdy_stream_->session();
+  quality->smoothed_rtt = session->smoothed_rtt();
+  quality->bandwidth = session->recv_bandwidth();
+  return true;
+}
+
+int SpdyProxyClientSocket::SetDiffServCodePoint(DiffServCodePoint dscp) {
+  if (!spdy_stream_ || !spdy_stream_->session())
+    return ERR_SOCKET_NOT_CONNECTED;
+  return spdy_stream_->session()->SetDiffServCodePoint(dscp);
+}
+
+size_t SpdyProxyClientSocket::EstimateMemoryUsage() const {
+  // The data being sent is that of the caller.
+  size_t usage = sizeof(*this) + read_buffer_queue_.GetTotalSize();
+  if (spdy_stream_)
+    usage += sizeof(SpdyStream);
+  return usage;
+}
+
 size_t SpdyProxyClientSocket::PopulateUserReadBuffer(char* data, size_t len) {
   return read_buffer_queue_.Dequeue(data, len);
 }
@@ -236,7 +304,7 @@ int SpdyProxyClientSocket::Write(
   DCHECK(write_callback_.is_null());
   if (next_state_ != STATE_OPEN)
     return ERR_SOCKET_NOT_CONNECTED;
-  if (end_stream_state_ == EndStreamState::kEndStreamSent)
+  if (end_stream_sent_)
     return ERR_CONNECTION_CLOSED;
 
   DCHECK(spdy_stream_.get());
@@ -278,17 +346,6 @@ void SpdyProxyClientSocket::RunWriteCallback(int result) {
   if (write_callback_) {
     std::move(write_callback_).Run(result);
   }
-  if (!weak_ptr) {
-    // `this` was already destroyed while running `write_callback_`. Must
-    // return immediately without touching any field member.
-    return;
-  }
-
-  if (end_stream_state_ == EndStreamState::kEndStreamReceived) {
-    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
-        FROM_HERE, base::BindOnce(&SpdyProxyClientSocket::MaybeSendEndStream,
-                                  weak_factory_.GetMutableWeakPtr()));
-  }
 }
 
 void SpdyProxyClientSocket::OnIOComplete(int result) {
@@ -456,6 +513,12 @@ int SpdyProxyClientSocket::DoReadReplyComplete(int result) {
   switch (response_.headers->response_code()) {
     case 200:  // OK
       next_state_ = STATE_OPEN;
+      if (proxy_delegate_ && spdy_stream_ && spdy_stream_->session()) {
+        uint32_t max_frame_size = proxy_delegate_->GetTunnelMaxFrameSize(
+            proxy_chain_, proxy_chain_index_);
+        if (max_frame_size > 0)
+          spdy_stream_->session()->EnableLargeFrames(max_frame_size);
+      }
       return OK;
 
     case 407:  // Proxy Authentication Required
@@ -511,14 +574,9 @@ void SpdyProxyClientSocket::OnDataReceived(std::unique_ptr<SpdyBuffer> buffer) {
   } else {
     net_log_.AddByteTransferEvent(NetLogEventType::SOCKET_BYTES_RECEIVED, 0,
                                   nullptr);
-
-    if (end_stream_state_ == EndStreamState::kNone) {
-      // The peer sent END_STREAM. Schedule a DATA frame with END_STREAM.
-      end_stream_state_ = EndStreamState::kEndStreamReceived;
-      base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
-          FROM_HERE, base::BindOnce(&SpdyProxyClientSocket::MaybeSendEndStream,
-                                    weak_factory_.GetWeakPtr()));
-    }
+    // The peer sent END_STREAM. Reads return EOF from now on, and writes
+    // stay open until ShutdownWrite().
+    end_stream_received_ = true;
   }
 
   if (read_callback_) {
@@ -536,7 +594,7 @@ void SpdyProxyClientSocket::OnDataReceived(std::unique_ptr<SpdyBuffer> buffer) {
 }
 
 void SpdyProxyClientSocket::OnDataSent() {
-  if (end_stream_state_ == EndStreamState::kEndStreamSent) {
+  if (end_stream_sent_) {
     CHECK(write_callback_.is_null());
     return;
   }
@@ -596,21 +654,4 @@ NetLogSource SpdyProxyClientSocket::source_dependency() const {
   return source_dependency_;
 }
 
-void SpdyProxyClientSocket::MaybeSendEndStream() {
-  DCHECK_NE(end_stream_state_, EndStreamState::kNone);
-  if (end_stream_state_ == EndStreamState::kEndStreamSent)
-    return;
-
-  if (!spdy_stream_)
-    return;
-
-  // When there is a pending write, wait until the write completes.
-  if (write_callback_)
-    return;
-
-  auto buffer = base::MakeRefCounted<IOBufferWithSize>(/*buffer_size=*/0);
-  spdy_stream_->SendData(buffer.get(), /*length=*/0, NO_MORE_DATA_TO_SEND);
-  end_stream_state_ = EndStreamState::kEndStreamSent;
-}
-
 }  // namespace net
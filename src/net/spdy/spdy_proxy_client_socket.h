@@ -70,6 +70,7 @@ class NET_EXPORT_PRIVATE SpdyProxyClientSocket : public ProxyClientSocket,
   // StreamSocket implementation.
   int Connect(CompletionOnceCallback callback) override;
   void Disconnect() override;
+  int ShutdownWrite() override;
   bool IsConnected() const override;
   bool IsConnectedAndIdle() const override;
   const NetLogWithSource& NetLog() const override;
@@ -87,6 +88,12 @@ class NET_EXPORT_PRIVATE SpdyProxyClientSocket : public ProxyClientSocket,
                   int buf_len,
                   CompletionOnceCallback callback) override;
   int CancelReadIfReady() override;
+  int ReadBuffer(int max_len,
+                 scoped_refptr<IOBuffer>* buf,
+                 CompletionOnceCallback callback) override;
+  bool GetSessionQuality(SessionQuality* quality) const override;
+  int SetDiffServCodePoint(DiffServCodePoint dscp) override;
+  size_t EstimateMemoryUsage() const override;
   int Write(IOBuffer* buf,
             int buf_len,
             CompletionOnceCallback callback,
@@ -137,8 +144,10 @@ class NET_EXPORT_PRIVATE SpdyProxyClientSocket : public ProxyClientSocket,
   // and returns the number of bytes read.
   size_t PopulateUserReadBuffer(char* out, size_t len);
 
-  // Called when the peer sent END_STREAM.
-  void MaybeSendEndStream();
+  // Returns true once nothing more can be read than what is queued.
+  bool IsReadClosed() const {
+    return next_state_ == STATE_CLOSED || end_stream_received_;
+  }
 
   State next_state_ = STATE_DISCONNECTED;
 
@@ -187,16 +196,11 @@ class NET_EXPORT_PRIVATE SpdyProxyClientSocket : public ProxyClientSocket,
   const NetLogWithSource net_log_;
   const NetLogSource source_dependency_;
 
-  // State for handling END_STREAM. When the peer sends a DATA frame with
-  // END_STREAM, it should be treated as being equivalent to the TCP FIN bit.
-  // We should send a DATA frame with END_STREAM after receiving END_STREAM
-  // as the spec requires.
-  enum class EndStreamState {
-    kNone,
-    kEndStreamReceived,
-    kEndStreamSent,
-  };
-  EndStreamState end_stream_state_ = EndStreamState::kNone;
+  // END_STREAM is the equivalent of the TCP FIN bit, and each direction is
+  // closed on its own. Reads return EOF once the data before the peer's
+  // END_STREAM is read, while writes go on until ShutdownWrite() sends ours.
+  bool end_stream_received_ = false;
+  bool end_stream_sent_ = false;
 
   base::WeakPtrFactory<SpdyProxyClientSocket> weak_factory_{this};
 };
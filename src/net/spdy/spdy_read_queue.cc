@@ -13,6 +13,7 @@
 #include <utility>
 
 #include "base/check_op.h"
+#include "net/base/io_buffer.h"
 #include "net/spdy/spdy_buffer.h"
 
 namespace net {
@@ -56,6 +57,20 @@ size_t SpdyReadQueue::Dequeue(char* out, size_t len) {
   return bytes_copied;
 }
 
+size_t SpdyReadQueue::DequeueBuffer(size_t len, scoped_refptr<IOBuffer>* out) {
+  DCHECK_GT(len, 0u);
+  DCHECK(!queue_.empty());
+  SpdyBuffer* buffer = queue_.front().get();
+  size_t bytes = std::min(len, buffer->GetRemainingSize());
+  *out = buffer->GetIOBufferForRemainingData();
+  if (bytes == buffer->GetRemainingSize())
+    queue_.pop_front();
+  else
+    buffer->Consume(bytes);
+  total_size_ -= bytes;
+  return bytes;
+}
+
 void SpdyReadQueue::Clear() {
   queue_.clear();
   total_size_ = 0;
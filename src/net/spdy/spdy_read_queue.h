@@ -9,10 +9,12 @@
 #include <memory>
 
 #include "base/containers/circular_deque.h"
+#include "base/memory/scoped_refptr.h"
 #include "net/base/net_export.h"
 
 namespace net {
 
+class IOBuffer;
 class SpdyBuffer;
 
 // A FIFO queue of incoming data from a SPDY connection. Useful for
@@ -39,6 +41,11 @@ class NET_EXPORT_PRIVATE SpdyReadQueue {
   // |out|. Returns the number of bytes dequeued.
   size_t Dequeue(char* out, size_t len);
 
+  // Dequeues up to |len| (which must be positive) bytes of the first buffer
+  // without copying them. Sets |out| to a buffer holding them and returns
+  // their number.
+  size_t DequeueBuffer(size_t len, scoped_refptr<IOBuffer>* out);
+
   // Removes all bytes from the queue.
   void Clear();
 
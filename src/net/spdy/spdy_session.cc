@@ -9,6 +9,7 @@
 
 #include "net/spdy/spdy_session.h"
 
+#include <algorithm>
 #include <limits>
 #include <map>
 #include <string>
@@ -99,6 +100,12 @@ constexpr net::NetworkTrafficAnnotationTag
     )");
 
 const int kReadBufferSize = 8 * 1024;
+// Small reads in a row before a grown read buffer halves.
+const int kReadBufferShrinkReads = 16;
+// Frames queued behind a smaller write are copied together into one socket
+// write of about this size, so that many streams sending small DATA frames
+// do not cost a TLS record and a syscall each.
+const size_t kMaxCoalescedWriteSize = 64 * 1024;
 const int kDefaultConnectionAtRiskOfLossSeconds = 10;
 const int kHungIntervalSeconds = 10;
 
@@ -107,6 +114,17 @@ const uint32_t kDefaultInitialHeaderTableSize = 4096;
 const uint32_t kDefaultInitialEnablePush = 1;
 const uint32_t kDefaultInitialInitialWindowSize = 65535;
 const uint32_t kDefaultInitialMaxFrameSize = 16384;
+// Weight of a new sample in smoothed estimates, as for TCP SRTT.
+const int kRttSmoothing = 8;
+// Oldest RTT sample kept while streams transfer data.
+constexpr base::TimeDelta kRttSampleInterval = base::Seconds(10);
+constexpr base::TimeDelta kBandwidthSampleInterval = base::Seconds(1);
+// Keepalive PINGs are answered within a little over two RTTs on a live
+// path, and within this on jittery ones.
+constexpr int kKeepaliveRttFactor = 3;
+constexpr base::TimeDelta kMinKeepaliveTimeout = base::Seconds(1);
+// Largest SETTINGS_MAX_FRAME_SIZE allowed by RFC 9113.
+const uint32_t kMaxFrameSizeLimit = (1 << 24) - 1;
 
 // These values are persisted to logs. Entries should not be renumbered, and
 // numeric values should never be reused.
@@ -1112,7 +1130,7 @@ std::unique_ptr<SpdyBuffer> SpdySession::CreateDataBuffer(
     return nullptr;
   }
 
-  *effective_len = std::min(len, kMaxSpdyFrameChunkSize);
+  *effective_len = std::min(len, max_data_frame_size());
 
   bool send_stalled_by_stream = (stream->send_window_size() <= 0);
   bool send_stalled_by_session = IsSendStalled();
@@ -1179,13 +1197,10 @@ std::unique_ptr<SpdyBuffer> SpdySession::CreateDataBuffer(
     MaybeSendPrefacePing();
 
   // TODO(mbelshe): reduce memory copies here.
-  DCHECK(buffered_spdy_framer_.get());
-  std::unique_ptr<spdy::SpdySerializedFrame> frame(
-      buffered_spdy_framer_->CreateDataFrame(
-          stream_id, data->data(), static_cast<uint32_t>(*effective_len),
-          flags));
-
-  auto data_buffer = std::make_unique<SpdyBuffer>(std::move(frame));
+  std::unique_ptr<SpdyBuffer> data_buffer = buffer_pool_.CreateDataFrame(
+      stream_id,
+      base::span(data->data(), static_cast<size_t>(*effective_len)),
+      (flags & spdy::DATA_FLAG_FIN) != 0);
 
   // Send window size is based on payload size, so nothing to do if this is
   // just a FIN with no payload.
@@ -1556,6 +1571,10 @@ void SpdySession::InitializeInternal(SpdySessionPool* pool) {
   buffered_spdy_framer_->set_visitor(this);
   buffered_spdy_framer_->set_debug_visitor(this);
   buffered_spdy_framer_->UpdateHeaderDecoderTableSize(max_header_table_size_);
+  if (!hpack_unindexed_headers_.empty()) {
+    buffered_spdy_framer_->SetHpackUnindexedHeaders(
+        std::move(hpack_unindexed_headers_));
+  }
 
   net_log_.AddEvent(NetLogEventType::HTTP2_SESSION_INITIALIZED, [&] {
     return NetLogSpdyInitializedParams(socket_->NetLog().source());
@@ -1908,9 +1927,17 @@ int SpdySession::DoRead() {
 
   CHECK(socket_);
   read_state_ = READ_STATE_DO_READ_COMPLETE;
-  read_buffer_ = base::MakeRefCounted<IOBufferWithSize>(kReadBufferSize);
+  if (max_read_buffer_size_ > 0) {
+    if (!reusable_read_buffer_) {
+      reusable_read_buffer_ =
+          base::MakeRefCounted<IOBufferWithSize>(kReadBufferSize);
+    }
+    read_buffer_ = reusable_read_buffer_;
+  } else {
+    read_buffer_ = base::MakeRefCounted<IOBufferWithSize>(kReadBufferSize);
+  }
   int rv = socket_->ReadIfReady(
-      read_buffer_.get(), kReadBufferSize,
+      read_buffer_.get(), read_buffer_->size(),
       base::BindOnce(&SpdySession::PumpReadLoop, weak_factory_.GetWeakPtr(),
                      READ_STATE_DO_READ));
   if (rv == ERR_IO_PENDING) {
@@ -1921,7 +1948,7 @@ int SpdySession::DoRead() {
   if (rv == ERR_READ_IF_READY_NOT_IMPLEMENTED) {
     // Fallback to regular Read().
     return socket_->Read(
-        read_buffer_.get(), kReadBufferSize,
+        read_buffer_.get(), read_buffer_->size(),
         base::BindOnce(&SpdySession::PumpReadLoop, weak_factory_.GetWeakPtr(),
                        READ_STATE_DO_READ_COMPLETE));
   }
@@ -1933,7 +1960,7 @@ int SpdySession::DoReadComplete(int result) {
   CHECK(in_io_loop_);
 
   // Parse a frame.  For now this code requires that the frame fit into our
-  // buffer (kReadBufferSize).
+  // buffer (read_buffer_->size()).
   // TODO(mbelshe): support arbitrarily large frames!
 
   if (result == 0) {
@@ -1947,9 +1974,17 @@ int SpdySession::DoReadComplete(int result) {
         base::StringPrintf("Error %d reading from socket.", -result));
     return result;
   }
-  CHECK_LE(result, kReadBufferSize);
+  CHECK_LE(result, read_buffer_->size());
 
   last_read_time_ = time_func_();
+  if (!keepalive_interval_.is_zero() && !keepalive_timer_.IsRunning()) {
+    StartKeepaliveTimer(keepalive_interval_);
+  }
+  // The frames are parsed out of `read_buffer_`, which keeps the buffer
+  // alive if it is replaced.
+  if (max_read_buffer_size_ > 0) {
+    AdaptReadBuffer(result);
+  }
 
   DCHECK(buffered_spdy_framer_.get());
   char* data = read_buffer_->data();
@@ -1972,6 +2007,23 @@ int SpdySession::DoReadComplete(int result) {
   return OK;
 }
 
+void SpdySession::AdaptReadBuffer(int bytes_read) {
+  int size = reusable_read_buffer_->size();
+  if (bytes_read == size && size < max_read_buffer_size_) {
+    reusable_read_buffer_ = base::MakeRefCounted<IOBufferWithSize>(
+        std::min(size * 2, max_read_buffer_size_));
+    small_reads_ = 0;
+  } else if (bytes_read < size / 4 && size > kReadBufferSize) {
+    if (++small_reads_ >= kReadBufferShrinkReads) {
+      reusable_read_buffer_ = base::MakeRefCounted<IOBufferWithSize>(
+          std::max(size / 2, kReadBufferSize));
+      small_reads_ = 0;
+    }
+  } else {
+    small_reads_ = 0;
+  }
+}
+
 void SpdySession::PumpWriteLoop(WriteState expected_write_state, int result) {
   CHECK(!in_io_loop_);
   DCHECK_EQ(write_state_, expected_write_state);
@@ -2041,46 +2093,57 @@ int SpdySession::DoWrite() {
   if (in_flight_write_) {
     DCHECK_GT(in_flight_write_->GetRemainingSize(), 0u);
   } else {
+    // Pending window updates ride along with this write.
+    if (!pending_window_updates_.empty())
+      FlushWindowUpdates();
+
     // Grab the next frame to send.
-    spdy::SpdyFrameType frame_type = spdy::SpdyFrameType::DATA;
-    std::unique_ptr<SpdyBufferProducer> producer;
-    base::WeakPtr<SpdyStream> stream;
-    if (!write_queue_.Dequeue(&frame_type, &producer, &stream,
-                              &in_flight_write_traffic_annotation_)) {
+    std::unique_ptr<SpdyBuffer> buffer;
+    if (!DequeueWriteFrame(&buffer, &in_flight_write_traffic_annotation_)) {
       write_state_ = WRITE_STATE_IDLE;
       return ERR_IO_PENDING;
     }
+    if (!buffer) {
+      NOTREACHED_IN_MIGRATION();
+      in_flight_write_frames_.clear();
+      return ERR_UNEXPECTED;
+    }
 
-    if (stream.get())
-      CHECK(!stream->IsClosed());
-
-    // Activate the stream only when sending the HEADERS frame to
-    // guarantee monotonically-increasing stream IDs.
-    if (frame_type == spdy::SpdyFrameType::HEADERS) {
-      CHECK(stream.get());
-      CHECK_EQ(stream->stream_id(), 0u);
-      std::unique_ptr<SpdyStream> owned_stream =
-          ActivateCreatedStream(stream.get());
-      InsertActivatedStream(std::move(owned_stream));
-
-      if (stream_hi_water_mark_ > kLastStreamId) {
-        CHECK_EQ(stream->stream_id(), kLastStreamId);
-        // We've exhausted the stream ID space, and no new streams may be
-        // created after this one.
-        MakeUnavailable();
-        StartGoingAway(kLastStreamId, ERR_HTTP2_PROTOCOL_ERROR);
+    // Coalesces the frames queued behind it. The write takes the traffic
+    // annotation of its first frame.
+    std::vector<std::unique_ptr<SpdyBuffer>> buffers;
+    size_t total_size = buffer->GetRemainingSize();
+    buffers.push_back(std::move(buffer));
+    MutableNetworkTrafficAnnotationTag traffic_annotation;
+    while (total_size < kMaxCoalescedWriteSize &&
+           DequeueWriteFrame(&buffer, &traffic_annotation)) {
+      if (!buffer) {
+        NOTREACHED_IN_MIGRATION();
+        in_flight_write_frames_.clear();
+        return ERR_UNEXPECTED;
       }
+      total_size += buffer->GetRemainingSize();
+      buffers.push_back(std::move(buffer));
     }
 
-    in_flight_write_ = producer->ProduceBuffer();
-    if (!in_flight_write_) {
-      NOTREACHED_IN_MIGRATION();
-      return ERR_UNEXPECTED;
+    if (buffers.size() == 1) {
+      in_flight_write_ = std::move(buffers.front());
+    } else {
+      auto data = std::make_unique<char[]>(total_size);
+      size_t offset = 0;
+      for (const auto& frame_buffer : buffers) {
+        size_t size = frame_buffer->GetRemainingSize();
+        memcpy(data.get() + offset, frame_buffer->GetRemainingData(), size);
+        offset += size;
+        // Consumes rather than discards the copied frames, which would give
+        // their flow control windows back. A failed write drains the session
+        // anyway.
+        frame_buffer->Consume(size);
+      }
+      in_flight_write_ = std::make_unique<SpdyBuffer>(
+          std::make_unique<spdy::SpdySerializedFrame>(std::move(data),
+                                                      total_size));
     }
-    in_flight_write_frame_type_ = frame_type;
-    in_flight_write_frame_size_ = in_flight_write_->GetRemainingSize();
-    DCHECK_GE(in_flight_write_frame_size_, spdy::kFrameMinimumSize);
-    in_flight_write_stream_ = stream;
   }
 
   write_state_ = WRITE_STATE_DO_WRITE_COMPLETE;
@@ -2094,6 +2157,50 @@ int SpdySession::DoWrite() {
       NetworkTrafficAnnotationTag(in_flight_write_traffic_annotation_));
 }
 
+bool SpdySession::DequeueWriteFrame(
+    std::unique_ptr<SpdyBuffer>* buffer,
+    MutableNetworkTrafficAnnotationTag* traffic_annotation) {
+  spdy::SpdyFrameType frame_type = spdy::SpdyFrameType::DATA;
+  std::unique_ptr<SpdyBufferProducer> producer;
+  base::WeakPtr<SpdyStream> stream;
+  if (!write_queue_.Dequeue(&frame_type, &producer, &stream,
+                            traffic_annotation)) {
+    return false;
+  }
+
+  if (stream.get())
+    CHECK(!stream->IsClosed());
+
+  // Activate the stream only when sending the HEADERS frame to
+  // guarantee monotonically-increasing stream IDs.
+  if (frame_type == spdy::SpdyFrameType::HEADERS) {
+    CHECK(stream.get());
+    CHECK_EQ(stream->stream_id(), 0u);
+    std::unique_ptr<SpdyStream> owned_stream =
+        ActivateCreatedStream(stream.get());
+    InsertActivatedStream(std::move(owned_stream));
+
+    if (stream_hi_water_mark_ > kLastStreamId) {
+      CHECK_EQ(stream->stream_id(), kLastStreamId);
+      // We've exhausted the stream ID space, and no new streams may be
+      // created after this one.
+      MakeUnavailable();
+      StartGoingAway(kLastStreamId, ERR_HTTP2_PROTOCOL_ERROR);
+    }
+  }
+
+  *buffer = producer->ProduceBuffer();
+  if (!*buffer)
+    return true;
+  InFlightFrame& frame = in_flight_write_frames_.emplace_back();
+  frame.type = frame_type;
+  frame.size = (*buffer)->GetRemainingSize();
+  DCHECK_GE(frame.size, spdy::kFrameMinimumSize);
+  frame.remaining = frame.size;
+  frame.stream = stream;
+  return true;
+}
+
 int SpdySession::DoWriteComplete(int result) {
   CHECK(in_io_loop_);
   DCHECK_NE(result, ERR_IO_PENDING);
@@ -2102,9 +2209,7 @@ int SpdySession::DoWriteComplete(int result) {
   if (result < 0) {
     DCHECK_NE(result, ERR_IO_PENDING);
     in_flight_write_.reset();
-    in_flight_write_frame_type_ = spdy::SpdyFrameType::DATA;
-    in_flight_write_frame_size_ = 0;
-    in_flight_write_stream_.reset();
+    in_flight_write_frames_.clear();
     in_flight_write_traffic_annotation_.reset();
     write_state_ = WRITE_STATE_DO_WRITE;
     DoDrainSession(static_cast<Error>(result), "Write error");
@@ -2117,24 +2222,34 @@ int SpdySession::DoWriteComplete(int result) {
 
   if (result > 0) {
     in_flight_write_->Consume(static_cast<size_t>(result));
-    if (in_flight_write_stream_.get())
-      in_flight_write_stream_->AddRawSentBytes(static_cast<size_t>(result));
-
-    // We only notify the stream when we've fully written the pending frame.
     if (in_flight_write_->GetRemainingSize() == 0) {
+      // Cleanup the write which just completed.
+      in_flight_write_.reset();
+    }
+
+    // Attributes the written bytes to the frames they belong to.
+    size_t bytes = static_cast<size_t>(result);
+    while (bytes > 0) {
+      DCHECK(!in_flight_write_frames_.empty());
+      InFlightFrame& frame = in_flight_write_frames_.front();
+      size_t frame_bytes = std::min(bytes, frame.remaining);
+      bytes -= frame_bytes;
+      frame.remaining -= frame_bytes;
+      if (frame.stream.get())
+        frame.stream->AddRawSentBytes(frame_bytes);
+      if (frame.remaining > 0)
+        break;
+
+      // We only notify the stream when we've fully written the frame.
+      InFlightFrame written_frame = std::move(frame);
+      in_flight_write_frames_.pop_front();
       // It is possible that the stream was cancelled while we were
       // writing to the socket.
-      if (in_flight_write_stream_.get()) {
-        DCHECK_GT(in_flight_write_frame_size_, 0u);
-        in_flight_write_stream_->OnFrameWriteComplete(
-            in_flight_write_frame_type_, in_flight_write_frame_size_);
+      if (written_frame.stream.get()) {
+        DCHECK_GT(written_frame.size, 0u);
+        written_frame.stream->OnFrameWriteComplete(written_frame.type,
+                                                   written_frame.size);
       }
-
-      // Cleanup the write which just completed.
-      in_flight_write_.reset();
-      in_flight_write_frame_type_ = spdy::SpdyFrameType::DATA;
-      in_flight_write_frame_size_ = 0;
-      in_flight_write_stream_.reset();
     }
   }
 
@@ -2267,6 +2382,11 @@ void SpdySession::HandleSetting(uint32_t id, uint32_t value) {
           "delta_window_size", delta_window_size);
       break;
     }
+    case spdy::SETTINGS_MAX_FRAME_SIZE:
+      // Larger DATA frames are only sent once the peer allows them. See
+      // max_data_frame_size().
+      peer_max_frame_size_ = value;
+      break;
     case spdy::SETTINGS_ENABLE_CONNECT_PROTOCOL:
       if ((value != 0 && value != 1) || (support_websocket_ && value == 0)) {
         DoDrainSession(
@@ -2356,6 +2476,25 @@ void SpdySession::SendWindowUpdateFrame(spdy::SpdyStreamId stream_id,
     CHECK_EQ(stream_id, spdy::kSessionFlowControlStreamId);
   }
 
+  if (window_update_batch_delay_.is_zero()) {
+    EnqueueWindowUpdateFrame(stream_id, delta_window_size, priority);
+    return;
+  }
+  // Updates of a stream add up to at most its receive window.
+  PendingWindowUpdate& pending = pending_window_updates_[stream_id];
+  pending.delta_window_size += delta_window_size;
+  pending.priority = priority;
+  if (!window_update_batch_timer_.IsRunning()) {
+    window_update_batch_timer_.Start(
+        FROM_HERE, window_update_batch_delay_,
+        base::BindOnce(&SpdySession::FlushWindowUpdates,
+                       base::Unretained(this)));
+  }
+}
+
+void SpdySession::EnqueueWindowUpdateFrame(spdy::SpdyStreamId stream_id,
+                                           uint32_t delta_window_size,
+                                           RequestPriority priority) {
   net_log_.AddEvent(NetLogEventType::HTTP2_SESSION_SEND_WINDOW_UPDATE, [&] {
     return NetLogSpdyWindowUpdateFrameParams(stream_id, delta_window_size);
   });
@@ -2367,6 +2506,21 @@ void SpdySession::SendWindowUpdateFrame(spdy::SpdyStreamId stream_id,
                       std::move(window_update_frame));
 }
 
+void SpdySession::FlushWindowUpdates() {
+  window_update_batch_timer_.Stop();
+  std::map<spdy::SpdyStreamId, PendingWindowUpdate> pending_window_updates;
+  pending_window_updates.swap(pending_window_updates_);
+  for (const auto& [stream_id, pending] : pending_window_updates) {
+    // Closed streams take no more data.
+    if (stream_id != spdy::kSessionFlowControlStreamId &&
+        !base::Contains(active_streams_, stream_id)) {
+      continue;
+    }
+    EnqueueWindowUpdateFrame(stream_id, pending.delta_window_size,
+                             pending.priority);
+  }
+}
+
 void SpdySession::WritePingFrame(spdy::SpdyPingId unique_id, bool is_ack) {
   DCHECK(buffered_spdy_framer_.get());
   std::unique_ptr<spdy::SpdySerializedFrame> ping_frame(
@@ -2518,12 +2672,13 @@ void SpdySession::InsertActivatedStream(std::unique_ptr<SpdyStream> stream) {
 }
 
 void SpdySession::DeleteStream(std::unique_ptr<SpdyStream> stream, int status) {
-  if (in_flight_write_stream_.get() == stream.get()) {
-    // If we're deleting the stream for the in-flight write, we still
-    // need to let the write complete, so we clear
-    // |in_flight_write_stream_| and let the write finish on its own
-    // without notifying |in_flight_write_stream_|.
-    in_flight_write_stream_.reset();
+  for (InFlightFrame& frame : in_flight_write_frames_) {
+    if (frame.stream.get() == stream.get()) {
+      // If we're deleting the stream of an in-flight frame, we still
+      // need to let the write complete, so we clear its stream and let
+      // the write finish on its own without notifying the stream.
+      frame.stream.reset();
+    }
   }
 
   write_queue_.RemovePendingWritesForStream(stream.get());
@@ -2711,6 +2866,12 @@ void SpdySession::OnPing(spdy::SpdyPingId unique_id, bool is_ack) {
 
   // Record RTT in histogram when there are no more pings in flight.
   base::TimeDelta ping_duration = time_func_() - last_ping_sent_time_;
+  last_ping_rtt_ = ping_duration;
+  if (smoothed_rtt_.is_zero()) {
+    smoothed_rtt_ = ping_duration;
+  } else {
+    smoothed_rtt_ += (ping_duration - smoothed_rtt_) / kRttSmoothing;
+  }
   if (network_quality_estimator_) {
     network_quality_estimator_->RecordSpdyPingLatency(host_port_pair(),
                                                       ping_duration);
@@ -2781,6 +2942,10 @@ void SpdySession::OnGoAway(spdy::SpdyStreamId last_accepted_stream_id,
     DoDrainSession(ERR_HTTP_1_1_REQUIRED, "HTTP_1_1_REQUIRED for stream.");
   } else if (error_code == spdy::ERROR_CODE_NO_ERROR) {
     StartGoingAway(last_accepted_stream_id, ERR_HTTP2_SERVER_REFUSED_STREAM);
+    // A graceful shutdown lets the accepted streams finish, so the pool may
+    // connect a replacement meanwhile.
+    if (!active_streams_.empty())
+      pool_->OnSessionDraining(spdy_session_key_);
   } else {
     StartGoingAway(last_accepted_stream_id, ERR_HTTP2_PROTOCOL_ERROR);
   }
@@ -2827,8 +2992,9 @@ void SpdySession::OnStreamFrameData(spdy::SpdyStreamId stream_id,
   std::unique_ptr<SpdyBuffer> buffer;
   if (data) {
     DCHECK_GT(len, 0u);
-    CHECK_LE(len, static_cast<size_t>(kReadBufferSize));
-    buffer = std::make_unique<SpdyBuffer>(data, len);
+    CHECK_LE(len, static_cast<size_t>(
+                      std::max(kReadBufferSize, max_read_buffer_size_)));
+    buffer = buffer_pool_.CreateBuffer(base::span(data, len));
 
     DecreaseRecvWindowSize(static_cast<int32_t>(len));
     buffer->AddConsumeCallback(base::BindRepeating(
@@ -2949,6 +3115,9 @@ void SpdySession::OnWindowUpdate(spdy::SpdyStreamId stream_id,
     }
 
     IncreaseSendWindowSize(delta_window_size);
+    // Samples uploads, which bring session WINDOW_UPDATEs.
+    if (rtt_sampling_enabled_)
+      MaybeSendRttPing();
   } else {
     // WINDOW_UPDATE for a stream.
     auto it = active_streams_.find(stream_id);
@@ -3143,7 +3312,7 @@ void SpdySession::DecreaseSendWindowSize(int32_t delta_window_size) {
   // We only call this method when sending a frame. Therefore,
   // |delta_window_size| should be within the valid frame size range.
   DCHECK_GE(delta_window_size, 1);
-  DCHECK_LE(delta_window_size, kMaxSpdyFrameChunkSize);
+  DCHECK_LE(delta_window_size, max_data_frame_size());
 
   // |send_window_size_| should have been at least |delta_window_size| for
   // this call to happen.
@@ -3188,10 +3357,22 @@ void SpdySession::IncreaseRecvWindowSize(int32_t delta_window_size) {
   // if too much time has elapsed since the last update to deal with
   // slow-reading clients so the server doesn't think the session is idle.
   session_unacked_recv_window_bytes_ += delta_window_size;
+  if (rtt_sampling_enabled_) {
+    SampleRecvBandwidth(delta_window_size);
+    MaybeSendRttPing();
+  }
   const base::TimeDelta elapsed =
       base::TimeTicks::Now() - last_recv_window_update_;
   if (session_unacked_recv_window_bytes_ > session_max_recv_window_size_ / 2 ||
       elapsed >= time_to_buffer_small_window_updates_) {
+    // The extra window is granted with this update.
+    int32_t new_max_recv_window_size =
+        AutoTuneRecvWindowSize(session_max_recv_window_size_, elapsed);
+    int32_t growth = new_max_recv_window_size - session_max_recv_window_size_;
+    session_max_recv_window_size_ = new_max_recv_window_size;
+    session_recv_window_size_ += growth;
+    session_unacked_recv_window_bytes_ += growth;
+
     last_recv_window_update_ = base::TimeTicks::Now();
     SendWindowUpdateFrame(spdy::kSessionFlowControlStreamId,
                           session_unacked_recv_window_bytes_, HIGHEST);
@@ -3199,6 +3380,138 @@ void SpdySession::IncreaseRecvWindowSize(int32_t delta_window_size) {
   }
 }
 
+void SpdySession::EnableLargeFrames(uint32_t max_frame_size) {
+  DCHECK_GE(max_frame_size, kDefaultInitialMaxFrameSize);
+  DCHECK_LE(max_frame_size, kMaxFrameSizeLimit);
+  if (max_frame_size <= large_frame_size_ ||
+      availability_state_ == STATE_DRAINING) {
+    return;
+  }
+  large_frame_size_ = max_frame_size;
+
+  // The peer may send larger frames as soon as it reads the setting.
+  buffered_spdy_framer_->SetMaxFrameSize(max_frame_size);
+  buffer_pool_.set_block_size(spdy::kFrameHeaderSize + max_frame_size);
+  spdy::SettingsMap settings_map;
+  settings_map[spdy::SETTINGS_MAX_FRAME_SIZE] = max_frame_size;
+  net_log_.AddEvent(NetLogEventType::HTTP2_SESSION_SEND_SETTINGS, [&] {
+    return NetLogSpdySendSettingsParams(&settings_map);
+  });
+  EnqueueSessionWrite(HIGHEST, spdy::SpdyFrameType::SETTINGS,
+                      buffered_spdy_framer_->CreateSettings(settings_map));
+}
+
+int SpdySession::max_data_frame_size() const {
+  if (large_frame_size_ == 0 ||
+      peer_max_frame_size_ <= static_cast<uint32_t>(kMaxSpdyFrameChunkSize)) {
+    return kMaxSpdyFrameChunkSize;
+  }
+  return static_cast<int>(std::min(large_frame_size_, peer_max_frame_size_));
+}
+
+int32_t SpdySession::AutoTuneRecvWindowSize(int32_t window_size,
+                                            base::TimeDelta elapsed) {
+  if (window_size >= max_auto_tuned_recv_window_size_)
+    return window_size;
+
+  MaybeSendRttPing();
+  if (last_ping_rtt_.is_zero() || elapsed >= 2 * last_ping_rtt_)
+    return window_size;
+
+  int32_t new_window_size = static_cast<int32_t>(
+      std::min<int64_t>(int64_t{window_size} * 2,
+                        max_auto_tuned_recv_window_size_));
+  net_log_.AddEventWithIntParams(
+      NetLogEventType::HTTP2_SESSION_UPDATE_RECV_WINDOW, "auto_tuned_window",
+      new_window_size);
+  return new_window_size;
+}
+
+void SpdySession::MaybeSendRttPing() {
+  // Reads go on during transfers, so the ping cannot fail the session while
+  // data arrive.
+  if (!ping_in_flight_ &&
+      (last_ping_rtt_.is_zero() ||
+       time_func_() - last_ping_sent_time_ >= kRttSampleInterval)) {
+    WritePingFrame(next_ping_id_, false);
+  }
+}
+
+void SpdySession::CheckKeepalive() {
+  CHECK(!in_io_loop_);
+  if (availability_state_ == STATE_DRAINING)
+    return;
+
+  const base::TimeTicks now = time_func_();
+  if (!keepalive_ping_time_.is_null()) {
+    if (last_read_time_ < keepalive_ping_time_) {
+      // Lets the pool connect a replacement rather than wait for the next
+      // tunnel to find the session gone.
+      pool_->OnSessionDraining(spdy_session_key_);
+      DoDrainSession(ERR_HTTP2_PING_FAILED, "Keepalive ping timed out.");
+      return;
+    }
+    keepalive_ping_time_ = base::TimeTicks();
+  }
+
+  const base::TimeDelta idle = now - last_read_time_;
+  // Sessions due before the next slot are pinged in this one.
+  if (idle < keepalive_interval_ - keepalive_batch_slot_) {
+    StartKeepaliveTimer(keepalive_interval_ - idle);
+    return;
+  }
+
+  // A PING already in flight serves as well.
+  if (!ping_in_flight_)
+    WritePingFrame(next_ping_id_, false);
+  keepalive_ping_time_ = now;
+  base::TimeDelta timeout = keepalive_max_timeout_;
+  if (!smoothed_rtt_.is_zero()) {
+    timeout = std::min(
+        std::max(smoothed_rtt_ * kKeepaliveRttFactor, kMinKeepaliveTimeout),
+        keepalive_max_timeout_);
+  }
+  keepalive_timer_.Start(FROM_HERE, timeout, this,
+                         &SpdySession::CheckKeepalive);
+}
+
+void SpdySession::StartKeepaliveTimer(base::TimeDelta delay) {
+  if (keepalive_batch_slot_.is_positive()) {
+    const base::TimeTicks now = time_func_();
+    delay = (now + delay).SnappedToNextTick(base::TimeTicks(),
+                                            keepalive_batch_slot_) -
+            now;
+  }
+  keepalive_timer_.Start(FROM_HERE, delay, this, &SpdySession::CheckKeepalive);
+}
+
+void SpdySession::SampleRecvBandwidth(int32_t bytes) {
+  base::TimeTicks now = time_func_();
+  if (recv_bandwidth_sample_start_.is_null()) {
+    recv_bandwidth_sample_start_ = now;
+    recv_bandwidth_sample_bytes_ = 0;
+  }
+  recv_bandwidth_sample_bytes_ += bytes;
+  base::TimeDelta elapsed = now - recv_bandwidth_sample_start_;
+  if (elapsed < kBandwidthSampleInterval)
+    return;
+
+  // Intervals that took much longer were mostly idle and say little about
+  // the path.
+  if (elapsed < 2 * kBandwidthSampleInterval) {
+    int64_t sample = recv_bandwidth_sample_bytes_ *
+                     base::Time::kMicrosecondsPerSecond /
+                     elapsed.InMicroseconds();
+    if (recv_bandwidth_ == 0) {
+      recv_bandwidth_ = sample;
+    } else {
+      recv_bandwidth_ += (sample - recv_bandwidth_) / kRttSmoothing;
+    }
+  }
+  recv_bandwidth_sample_start_ = now;
+  recv_bandwidth_sample_bytes_ = 0;
+}
+
 void SpdySession::DecreaseRecvWindowSize(int32_t delta_window_size) {
   CHECK(in_io_loop_);
   DCHECK_GE(delta_window_size, 1);
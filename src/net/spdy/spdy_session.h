@@ -14,9 +14,11 @@
 #include <set>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "base/containers/circular_deque.h"
+#include "base/containers/flat_set.h"
 #include "base/feature_list.h"
 #include "base/gtest_prod_util.h"
 #include "base/memory/raw_ptr.h"
@@ -45,6 +47,7 @@
 #include "net/spdy/http2_priority_dependencies.h"
 #include "net/spdy/multiplexed_session.h"
 #include "net/spdy/spdy_buffer.h"
+#include "net/spdy/spdy_buffer_pool.h"
 #include "net/spdy/spdy_session_pool.h"
 #include "net/spdy/spdy_stream.h"
 #include "net/spdy/spdy_write_queue.h"
@@ -510,6 +513,90 @@ class NET_EXPORT SpdySession
     return time_to_buffer_small_window_updates_;
   }
 
+  // Announces SETTINGS_MAX_FRAME_SIZE |max_frame_size| to a peer known to
+  // handle large frames, and sends DATA frames up to that size or the
+  // SETTINGS_MAX_FRAME_SIZE of the peer, whichever is smaller. Does nothing
+  // if frames at least that large were enabled before.
+  void EnableLargeFrames(uint32_t max_frame_size);
+
+  // Returns the largest payload of the DATA frames this session sends.
+  int max_data_frame_size() const;
+
+  // Lets the session and stream receive windows grow up to `max_size` when
+  // the peer fills them within two round trips, as measured with PINGs.
+  // Zero disables auto-tuning.
+  void set_max_auto_tuned_recv_window_size(int32_t max_size) {
+    max_auto_tuned_recv_window_size_ = max_size;
+  }
+
+  // Sends PINGs to sample the round trip time while streams transfer data,
+  // at most one every 10 seconds, and estimates the receive bandwidth.
+  void set_rtt_sampling_enabled(bool enabled) {
+    rtt_sampling_enabled_ = enabled;
+  }
+
+  // Reads into one buffer kept across reads, which doubles up to
+  // `max_size` bytes while reads fill it and halves again after a run of
+  // small reads. Zero allocates a buffer of the default size per read.
+  void set_max_read_buffer_size(int max_size) {
+    max_read_buffer_size_ = max_size;
+  }
+
+  // Holds WINDOW_UPDATE frames for up to `delay`, so that those of all
+  // streams go out together in one write, or with the next write of the
+  // session if it comes first. Zero sends each right away.
+  void set_window_update_batch_delay(base::TimeDelta delay) {
+    window_update_batch_delay_ = delay;
+  }
+
+  // Sends a PING after `interval` without reads, so that the NAT mappings
+  // and firewall states of an idle session do not time out, and takes the
+  // session as lost if nothing is read within a timeout of it: three
+  // smoothed RTTs, within kMinKeepaliveTimeout and `max_timeout`, or
+  // `max_timeout` while the RTT is unknown. A lost session tells the pool
+  // it is draining before it closes, so a replacement can be connected.
+  // Zero `interval` disables keepalives. A positive `batch_slot` batches the
+  // PINGs of all sessions: the checks run at multiples of it, shared by the
+  // sessions of all threads, and a PING goes out up to `batch_slot` early,
+  // so that idle sessions wake the device once per slot rather than once
+  // each.
+  void set_keepalive(base::TimeDelta interval,
+                     base::TimeDelta max_timeout,
+                     base::TimeDelta batch_slot = base::TimeDelta()) {
+    keepalive_interval_ = interval;
+    keepalive_max_timeout_ = max_timeout;
+    keepalive_batch_slot_ = batch_slot;
+  }
+
+  // See BufferedSpdyFramer::SetHpackUnindexedHeaders(). Must be called
+  // before the session is initialized.
+  void set_hpack_unindexed_headers(base::flat_set<std::string> names) {
+    hpack_unindexed_headers_ = std::move(names);
+  }
+
+  // Returns the smoothed round trip time of PINGs, or zero if none was
+  // acknowledged yet.
+  base::TimeDelta smoothed_rtt() const { return smoothed_rtt_; }
+
+  // Returns the smoothed rate in bytes per second at which the streams
+  // consumed received data over busy one-second intervals, or zero if
+  // unknown. Only estimated with RTT sampling.
+  int64_t recv_bandwidth() const { return recv_bandwidth_; }
+
+  // Marks the packets of the session with `dscp`. See
+  // StreamSocket::SetDiffServCodePoint().
+  int SetDiffServCodePoint(DiffServCodePoint dscp) {
+    return socket_->SetDiffServCodePoint(dscp);
+  }
+
+  // Frees the blocks kept for the frames of the session.
+  void ReleaseFreeBuffers() { buffer_pool_.ReleaseFreeBlocks(); }
+
+  // Returns the receive window that replaces `window_size` after the
+  // window was half consumed in `elapsed`, which is `window_size` unless
+  // auto-tuning finds the peer limited by it.
+  int32_t AutoTuneRecvWindowSize(int32_t window_size, base::TimeDelta elapsed);
+
   // Accessors for the session's availability state.
   bool IsAvailable() const { return availability_state_ == STATE_AVAILABLE; }
   bool IsGoingAway() const { return availability_state_ == STATE_GOING_AWAY; }
@@ -730,6 +817,9 @@ class NET_EXPORT SpdySession
   // The implementations of the states of the ReadState state machine.
   int DoRead();
   int DoReadComplete(int result);
+  // Resizes `reusable_read_buffer_` for the next read after a read of
+  // `bytes_read` bytes.
+  void AdaptReadBuffer(int bytes_read);
 
   // Calls DoWriteLoop. If |availability_state_| is STATE_DRAINING and no
   // writes remain, the session is removed from the session pool and
@@ -751,6 +841,12 @@ class NET_EXPORT SpdySession
   // The implementations of the states of the WriteState state machine.
   int DoWrite();
   int DoWriteComplete(int result);
+  // Takes the next frame off the write queue and adds it to
+  // |in_flight_write_frames_|. Returns false if the queue is empty. Sets
+  // |buffer| to null if the frame cannot be produced.
+  bool DequeueWriteFrame(
+      std::unique_ptr<SpdyBuffer>* buffer,
+      MutableNetworkTrafficAnnotationTag* traffic_annotation);
 
   void NotifyRequestsOfConfirmation(int rv);
 
@@ -784,10 +880,17 @@ class NET_EXPORT SpdySession
   // and too long time has passed since last read from server.
   void MaybeSendPrefacePing();
 
-  // Send a single WINDOW_UPDATE frame.
+  // Send a single WINDOW_UPDATE frame, or add it to the pending batch.
   void SendWindowUpdateFrame(spdy::SpdyStreamId stream_id,
                              uint32_t delta_window_size,
                              RequestPriority priority);
+  void EnqueueWindowUpdateFrame(spdy::SpdyStreamId stream_id,
+                                uint32_t delta_window_size,
+                                RequestPriority priority);
+
+  // Enqueues the pending WINDOW_UPDATE frames of the session and of the
+  // streams still active.
+  void FlushWindowUpdates();
 
   // Send the PING frame.
   void WritePingFrame(spdy::SpdyPingId unique_id, bool is_ack);
@@ -940,7 +1043,7 @@ class NET_EXPORT SpdySession
   // If session flow control is turned on, called by CreateDataFrame()
   // (which is in turn called by a stream) to decrease this session's
   // send window size by |delta_window_size|, which must be at least 1
-  // and at most kMaxSpdyFrameChunkSize.  |delta_window_size| must not
+  // and at most max_data_frame_size().  |delta_window_size| must not
   // cause this session's send window size to go negative.
   //
   // If session flow control is turned off, this must not be called.
@@ -963,6 +1066,18 @@ class NET_EXPORT SpdySession
   // If session flow control is turned off, this must not be called.
   void IncreaseRecvWindowSize(int32_t delta_window_size);
 
+  // Sends a PING if the last RTT sample is missing or stale.
+  void MaybeSendRttPing();
+  // Sends a keepalive PING if the session has read nothing for the
+  // keepalive interval, or drains it if nothing was read since the last one
+  // within its timeout.
+  void CheckKeepalive();
+  // Runs CheckKeepalive() after `delay`, or at the end of the batch slot it
+  // falls in.
+  void StartKeepaliveTimer(base::TimeDelta delay);
+  // Adds |bytes| consumed by the streams to the bandwidth estimate.
+  void SampleRecvBandwidth(int32_t bytes);
+
   // Called by OnStreamFrameData (which is in turn called by the
   // framer) to decrease this session's receive window size by
   // |delta_window_size|, which must be at least 1 and must not cause
@@ -1061,20 +1176,29 @@ class NET_EXPORT SpdySession
   // |created_streams_| owns all its SpdyStream objects.
   CreatedStreamSet created_streams_;
 
+  // Recycles the memory of the DATA frames sent and the data received.
+  SpdyBufferPool buffer_pool_;
+
   // The write queue.
   SpdyWriteQueue write_queue_;
 
   // Data for the frame we are currently sending.
 
-  // The buffer we're currently writing.
+  struct InFlightFrame {
+    spdy::SpdyFrameType type = spdy::SpdyFrameType::DATA;
+    size_t size = 0;
+    // Bytes of the frame not written yet.
+    size_t remaining = 0;
+    // The stream to notify when the frame has been written to the socket
+    // completely.
+    base::WeakPtr<SpdyStream> stream;
+  };
+
+  // The buffer we're currently writing. Holds one frame, or several
+  // frames copied together to be sent in one socket write.
   std::unique_ptr<SpdyBuffer> in_flight_write_;
-  // The type of the frame in |in_flight_write_|.
-  spdy::SpdyFrameType in_flight_write_frame_type_ = spdy::SpdyFrameType::DATA;
-  // The size of the frame in |in_flight_write_|.
-  size_t in_flight_write_frame_size_ = 0;
-  // The stream to notify when |in_flight_write_| has been written to
-  // the socket completely.
-  base::WeakPtr<SpdyStream> in_flight_write_stream_;
+  // The frames in |in_flight_write_| not written completely yet, in order.
+  base::circular_deque<InFlightFrame> in_flight_write_frames_;
 
   // Traffic annotation for the write in progress.
   MutableNetworkTrafficAnnotationTag in_flight_write_traffic_annotation_;
@@ -1209,6 +1333,48 @@ class NET_EXPORT SpdySession
   // Time to accumilate small receive window updates for.
   base::TimeDelta time_to_buffer_small_window_updates_;
 
+  // SETTINGS_MAX_FRAME_SIZE announced by EnableLargeFrames(), or zero.
+  uint32_t large_frame_size_ = 0;
+  // SETTINGS_MAX_FRAME_SIZE of the peer, or zero for the protocol default.
+  uint32_t peer_max_frame_size_ = 0;
+
+  // Upper bound of auto-tuned receive windows, or zero.
+  int32_t max_auto_tuned_recv_window_size_ = 0;
+
+  // Header names kept out of the HPACK encoder table.
+  base::flat_set<std::string> hpack_unindexed_headers_;
+
+  // Round trip time of the last acknowledged PING, or zero.
+  base::TimeDelta last_ping_rtt_;
+  base::TimeDelta smoothed_rtt_;
+
+  bool rtt_sampling_enabled_ = false;
+  int64_t recv_bandwidth_ = 0;
+  base::TimeTicks recv_bandwidth_sample_start_;
+  int64_t recv_bandwidth_sample_bytes_ = 0;
+
+  // Upper bound of `reusable_read_buffer_`, or zero if not reused.
+  int max_read_buffer_size_ = 0;
+  scoped_refptr<IOBufferWithSize> reusable_read_buffer_;
+  // Consecutive reads that filled less than a quarter of it.
+  int small_reads_ = 0;
+
+  struct PendingWindowUpdate {
+    uint32_t delta_window_size = 0;
+    RequestPriority priority = IDLE;
+  };
+  base::TimeDelta window_update_batch_delay_;
+  // Keyed by stream ID, so that the session's update goes out first.
+  std::map<spdy::SpdyStreamId, PendingWindowUpdate> pending_window_updates_;
+  base::OneShotTimer window_update_batch_timer_;
+
+  base::TimeDelta keepalive_interval_;
+  base::TimeDelta keepalive_max_timeout_;
+  base::TimeDelta keepalive_batch_slot_;
+  // When the keepalive PING awaiting a read went out, or null.
+  base::TimeTicks keepalive_ping_time_;
+  base::OneShotTimer keepalive_timer_;
+
   // Initial send window size for this session's streams. Can be
   // changed by an arriving SETTINGS frame. Newly created streams use
   // this value for the initial send window size.
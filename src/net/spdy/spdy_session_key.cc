@@ -8,6 +8,7 @@
 #include <tuple>
 
 #include "base/feature_list.h"
+#include "base/hash/hash.h"
 #include "base/logging.h"
 #include "base/trace_event/memory_usage_estimator.h"
 #include "net/base/features.h"
@@ -19,7 +20,7 @@
 
 namespace net {
 
-SpdySessionKey::SpdySessionKey() = default;
+SpdySessionKey::SpdySessionKey() : hash_(ComputeHash()) {}
 
 SpdySessionKey::SpdySessionKey(
     const HostPortPair& host_port_pair,
@@ -40,7 +41,8 @@ SpdySessionKey::SpdySessionKey(
               : NetworkAnonymizationKey()),
       secure_dns_policy_(secure_dns_policy),
       disable_cert_verification_network_fetches_(
-          disable_cert_verification_network_fetches) {
+          disable_cert_verification_network_fetches),
+      hash_(ComputeHash()) {
   DVLOG(1) << "SpdySessionKey(host=" << host_port_pair.ToString()
            << ", proxy_chain=" << proxy_chain << ", privacy=" << privacy_mode;
   DCHECK(disable_cert_verification_network_fetches_ ||
@@ -54,6 +56,8 @@ SpdySessionKey::SpdySessionKey(const SpdySessionKey& other) = default;
 SpdySessionKey::~SpdySessionKey() = default;
 
 bool SpdySessionKey::operator<(const SpdySessionKey& other) const {
+  if (hash_ != other.hash_)
+    return hash_ < other.hash_;
   return std::tie(privacy_mode_, host_port_proxy_pair_.first,
                   host_port_proxy_pair_.second, session_usage_,
                   network_anonymization_key_, secure_dns_policy_,
@@ -66,7 +70,7 @@ bool SpdySessionKey::operator<(const SpdySessionKey& other) const {
 }
 
 bool SpdySessionKey::operator==(const SpdySessionKey& other) const {
-  return privacy_mode_ == other.privacy_mode_ &&
+  return hash_ == other.hash_ && privacy_mode_ == other.privacy_mode_ &&
          host_port_proxy_pair_.first.Equals(
              other.host_port_proxy_pair_.first) &&
          host_port_proxy_pair_.second == other.host_port_proxy_pair_.second &&
@@ -82,6 +86,27 @@ bool SpdySessionKey::operator!=(const SpdySessionKey& other) const {
   return !(*this == other);
 }
 
+size_t SpdySessionKey::ComputeHash() const {
+  size_t hash = base::FastHash(host_port_pair().host());
+  hash = base::HashInts(
+      hash, (uint32_t{host_port_pair().port()} << 16) |
+                (static_cast<uint32_t>(privacy_mode_) << 8) |
+                (static_cast<uint32_t>(session_usage_) << 4) |
+                (static_cast<uint32_t>(secure_dns_policy_) << 1) |
+                (disable_cert_verification_network_fetches_ ? 1u : 0u));
+  const ProxyChain& chain = proxy_chain();
+  if (!chain.IsValid())
+    return hash;
+  for (const ProxyServer& proxy_server : chain.proxy_servers()) {
+    const HostPortPair& proxy = proxy_server.host_port_pair();
+    hash = base::HashInts(hash, base::FastHash(proxy.host()));
+    hash = base::HashInts(
+        hash, (uint32_t{proxy.port()} << 8) |
+                  static_cast<uint32_t>(proxy_server.scheme()));
+  }
+  return base::HashInts(hash, chain.length());
+}
+
 SpdySessionKey::CompareForAliasingResult SpdySessionKey::CompareForAliasing(
     const SpdySessionKey& other) const {
   CompareForAliasingResult result;
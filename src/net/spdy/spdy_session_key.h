@@ -5,6 +5,7 @@
 #ifndef NET_SPDY_SPDY_SESSION_KEY_H_
 #define NET_SPDY_SPDY_SESSION_KEY_H_
 
+#include <cstddef>
 #include <optional>
 
 #include "net/base/net_export.h"
@@ -40,13 +41,24 @@ class NET_EXPORT_PRIVATE SpdySessionKey {
 
   ~SpdySessionKey();
 
-  // Comparator function so this can be placed in a std::map.
+  // Comparator function so this can be placed in a std::map. Orders by
+  // hash() first.
   bool operator<(const SpdySessionKey& other) const;
 
   // Equality tests of contents.
   bool operator==(const SpdySessionKey& other) const;
   bool operator!=(const SpdySessionKey& other) const;
 
+  // Hash of the fields except the socket tag and the network anonymization
+  // key, computed once, and compared first so that distinct keys rarely
+  // get to compare their strings.
+  size_t hash() const { return hash_; }
+
+  // So this can be placed in a std::unordered_map.
+  struct Hasher {
+    size_t operator()(const SpdySessionKey& key) const { return key.hash(); }
+  };
+
   // Struct returned by CompareForAliasing().
   struct CompareForAliasingResult {
     // True if the two SpdySessionKeys match, except possibly for their
@@ -96,16 +108,19 @@ class NET_EXPORT_PRIVATE SpdySessionKey {
   }
 
  private:
+  size_t ComputeHash() const;
+
   HostPortProxyPair host_port_proxy_pair_;
   // If enabled, then session cannot be tracked by the server.
   PrivacyMode privacy_mode_ = PRIVACY_MODE_DISABLED;
-  SessionUsage session_usage_;
+  SessionUsage session_usage_ = SessionUsage::kDestination;
   SocketTag socket_tag_;
   // Used to separate requests made in different contexts. If network state
   // partitioning is disabled this will be set to an empty key.
   NetworkAnonymizationKey network_anonymization_key_;
-  SecureDnsPolicy secure_dns_policy_;
-  bool disable_cert_verification_network_fetches_;
+  SecureDnsPolicy secure_dns_policy_ = SecureDnsPolicy::kAllow;
+  bool disable_cert_verification_network_fetches_ = false;
+  size_t hash_;
 };
 
 }  // namespace net
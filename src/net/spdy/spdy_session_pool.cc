@@ -445,6 +445,13 @@ void SpdySessionPool::MakeSessionUnavailable(
   DCHECK(!IsSessionAvailable(available_session));
 }
 
+void SpdySessionPool::OnSessionDraining(const SpdySessionKey& key) {
+  if (session_draining_callback_.is_null())
+    return;
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(session_draining_callback_, key));
+}
+
 void SpdySessionPool::RemoveUnavailableSession(
     const base::WeakPtr<SpdySession>& unavailable_session) {
   DCHECK(!IsSessionAvailable(unavailable_session));
@@ -488,10 +495,22 @@ void SpdySessionPool::MakeCurrentSessionsGoingAway(Error error) {
       continue;
     }
 
-    session->MakeUnavailable();
-    session->StartGoingAway(kLastStreamId, error);
-    session->MaybeFinishGoingAway();
-    DCHECK(!IsSessionAvailable(session));
+    MakeSessionGoingAway(session.get(), error);
+  }
+}
+
+void SpdySessionPool::MakeSessionGoingAway(SpdySession* session,
+                                           Error error) {
+  base::WeakPtr<SpdySession> weak_session = session->GetWeakPtr();
+  session->MakeUnavailable();
+  session->StartGoingAway(kLastStreamId, error);
+  session->MaybeFinishGoingAway();
+  DCHECK(!IsSessionAvailable(weak_session));
+}
+
+void SpdySessionPool::ReleaseFreeBuffers() {
+  for (const auto& session : sessions_) {
+    session->ReleaseFreeBuffers();
   }
 }
 
@@ -701,7 +720,7 @@ std::unique_ptr<SpdySession> SpdySessionPool::CreateSession(
     RemoveAliases(key);
   }
 
-  return std::make_unique<SpdySession>(
+  auto session = std::make_unique<SpdySession>(
       key, http_server_properties_, transport_security_state_,
       ssl_client_context_ ? ssl_client_context_->ssl_config_service() : nullptr,
       quic_supported_versions_, enable_sending_initial_data_,
@@ -711,6 +730,15 @@ std::unique_ptr<SpdySession> SpdySessionPool::CreateSession(
       enable_http2_settings_grease_, greased_http2_frame_,
       http2_end_stream_with_data_frame_, enable_priority_update_, time_func_,
       network_quality_estimator_, net_log);
+  session->set_max_auto_tuned_recv_window_size(
+      max_auto_tuned_recv_window_size_);
+  session->set_max_read_buffer_size(max_read_buffer_size_);
+  session->set_window_update_batch_delay(window_update_batch_delay_);
+  session->set_rtt_sampling_enabled(rtt_sampling_enabled_);
+  session->set_keepalive(keepalive_interval_, keepalive_max_timeout_,
+                         keepalive_batch_slot_);
+  session->set_hpack_unindexed_headers(hpack_unindexed_headers_);
+  return session;
 }
 
 base::expected<base::WeakPtr<SpdySession>, int> SpdySessionPool::InsertSession(
@@ -13,8 +13,12 @@
 #include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "base/containers/flat_set.h"
+#include "base/functional/callback.h"
 #include "base/memory/raw_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/types/expected.h"
@@ -284,6 +288,17 @@ class NET_EXPORT SpdySessionPool
   // Mark all current sessions as going away.
   void MakeCurrentSessionsGoingAway(Error error);
 
+  // Marks `session` as going away, as MakeCurrentSessionsGoingAway() does
+  // to each of them.
+  void MakeSessionGoingAway(SpdySession* session, Error error);
+
+  // Get a copy of the current sessions as a list of WeakPtrs.
+  std::vector<base::WeakPtr<SpdySession>> GetCurrentSessions() const;
+
+  // Frees the blocks the sessions keep for their frames, as under memory
+  // pressure.
+  void ReleaseFreeBuffers();
+
   // Creates a Value summary of the state of the spdy session pool.
   std::unique_ptr<base::Value> SpdySessionPoolInfoToValue() const;
 
@@ -315,6 +330,59 @@ class NET_EXPORT SpdySessionPool
     network_quality_estimator_ = network_quality_estimator;
   }
 
+  // See SpdySession::set_max_auto_tuned_recv_window_size(). Applies to
+  // sessions created afterwards.
+  void set_max_auto_tuned_recv_window_size(int32_t max_size) {
+    max_auto_tuned_recv_window_size_ = max_size;
+  }
+
+  // See SpdySession::set_max_read_buffer_size(). Applies to sessions
+  // created afterwards.
+  void set_max_read_buffer_size(int max_size) {
+    max_read_buffer_size_ = max_size;
+  }
+
+  // See SpdySession::set_window_update_batch_delay(). Applies to sessions
+  // created afterwards.
+  void set_window_update_batch_delay(base::TimeDelta delay) {
+    window_update_batch_delay_ = delay;
+  }
+
+  // See SpdySession::set_rtt_sampling_enabled(). Applies to sessions
+  // created afterwards.
+  void set_rtt_sampling_enabled(bool enabled) {
+    rtt_sampling_enabled_ = enabled;
+  }
+
+  // See SpdySession::set_keepalive(). Applies to sessions created
+  // afterwards.
+  void set_keepalive(base::TimeDelta interval,
+                     base::TimeDelta max_timeout,
+                     base::TimeDelta batch_slot = base::TimeDelta()) {
+    keepalive_interval_ = interval;
+    keepalive_max_timeout_ = max_timeout;
+    keepalive_batch_slot_ = batch_slot;
+  }
+
+  // See SpdySession::set_hpack_unindexed_headers(). Applies to sessions
+  // created afterwards.
+  void set_hpack_unindexed_headers(base::flat_set<std::string> names) {
+    hpack_unindexed_headers_ = std::move(names);
+  }
+
+  // Runs `callback` from a posted task with the key of each session that
+  // receives a graceful GOAWAY while it still has active streams, or that
+  // misses a keepalive PING, so a replacement can be connected while they
+  // drain.
+  void set_session_draining_callback(
+      base::RepeatingCallback<void(const SpdySessionKey&)> callback) {
+    session_draining_callback_ = std::move(callback);
+  }
+
+  // Called by the session of `key` on a graceful GOAWAY with active streams,
+  // or before it drains on a missed keepalive PING.
+  void OnSessionDraining(const SpdySessionKey& key);
+
   // Returns the stored DNS aliases for the session key.
   std::set<std::string> GetDnsAliasesForSessionKey(
       const SpdySessionKey& key) const;
@@ -324,8 +392,10 @@ class NET_EXPORT SpdySessionPool
 
   using SessionSet = std::set<raw_ptr<SpdySession, SetExperimental>>;
   using WeakSessionList = std::vector<base::WeakPtr<SpdySession>>;
-  using AvailableSessionMap =
-      std::map<SpdySessionKey, base::WeakPtr<SpdySession>>;
+  // Looked up by every new stream, so hashed.
+  using AvailableSessionMap = std::unordered_map<SpdySessionKey,
+                                                 base::WeakPtr<SpdySession>,
+                                                 SpdySessionKey::Hasher>;
   using AliasMap = std::multimap<IPEndPoint, SpdySessionKey>;
   using DnsAliasesBySessionKeyMap =
       std::map<SpdySessionKey, std::set<std::string>>;
@@ -374,10 +444,6 @@ class NET_EXPORT SpdySessionPool
   // Remove all aliases for |key| from the aliases table.
   void RemoveAliases(const SpdySessionKey& key);
 
-  // Get a copy of the current sessions as a list of WeakPtrs. Used by
-  // CloseCurrentSessionsHelper() below.
-  WeakSessionList GetCurrentSessions() const;
-
   // Close only the currently existing SpdySessions with |error|.  Let
   // any new ones created while this method is running continue to
   // live. If |idle_only| is true only idle sessions are closed.
@@ -494,6 +560,17 @@ class NET_EXPORT SpdySessionPool
 
   raw_ptr<NetworkQualityEstimator> network_quality_estimator_;
 
+  int32_t max_auto_tuned_recv_window_size_ = 0;
+  int max_read_buffer_size_ = 0;
+  base::TimeDelta window_update_batch_delay_;
+  bool rtt_sampling_enabled_ = false;
+  base::TimeDelta keepalive_interval_;
+  base::TimeDelta keepalive_max_timeout_;
+  base::TimeDelta keepalive_batch_slot_;
+  base::flat_set<std::string> hpack_unindexed_headers_;
+  base::RepeatingCallback<void(const SpdySessionKey&)>
+      session_draining_callback_;
+
   const bool cleanup_sessions_on_ip_address_changed_;
 
   base::WeakPtrFactory<SpdySessionPool> weak_ptr_factory_{this};
@@ -226,7 +226,7 @@ void SpdyStream::DecreaseSendWindowSize(int32_t delta_window_size) {
   // We only call this method when sending a frame. Therefore,
   // |delta_window_size| should be within the valid frame size range.
   DCHECK_GE(delta_window_size, 1);
-  DCHECK_LE(delta_window_size, kMaxSpdyFrameChunkSize);
+  DCHECK_LE(delta_window_size, session_->max_data_frame_size());
 
   // |send_window_size_| should have been at least |delta_window_size| for
   // this call to happen.
@@ -277,6 +277,14 @@ void SpdyStream::IncreaseRecvWindowSize(int32_t delta_window_size) {
       base::TimeTicks::Now() - last_recv_window_update_;
   if (unacked_recv_window_bytes_ > max_recv_window_size_ / 2 ||
       elapsed >= session_->TimeToBufferSmallWindowUpdates()) {
+    // The extra window is granted with this update.
+    int32_t new_max_recv_window_size =
+        session_->AutoTuneRecvWindowSize(max_recv_window_size_, elapsed);
+    int32_t growth = new_max_recv_window_size - max_recv_window_size_;
+    max_recv_window_size_ = new_max_recv_window_size;
+    recv_window_size_ += growth;
+    unacked_recv_window_bytes_ += growth;
+
     last_recv_window_update_ = base::TimeTicks::Now();
     session_->SendStreamWindowUpdate(
         stream_id_, static_cast<uint32_t>(unacked_recv_window_bytes_));
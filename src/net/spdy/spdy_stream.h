@@ -157,6 +157,9 @@ class NET_EXPORT_PRIVATE SpdyStream {
 
   SpdyStreamType type() const { return type_; }
 
+  // Null once the session is gone.
+  SpdySession* session() const { return session_.get(); }
+
   spdy::SpdyStreamId stream_id() const { return stream_id_; }
   void set_stream_id(spdy::SpdyStreamId stream_id) { stream_id_ = stream_id; }
 
@@ -215,7 +218,8 @@ class NET_EXPORT_PRIVATE SpdyStream {
 
   // If stream flow control is turned on, called by the session to
   // decrease this stream's send window size by |delta_window_size|,
-  // which must be at least 0 and at most kMaxSpdyFrameChunkSize.
+  // which must be at least 0 and at most the max_data_frame_size() of the
+  // session.
   // |delta_window_size| must not cause this stream's send window size
   // to go negative. Does nothing if the stream is already closed.
   //
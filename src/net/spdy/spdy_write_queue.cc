@@ -57,11 +57,7 @@ SpdyWriteQueue::~SpdyWriteQueue() {
 }
 
 bool SpdyWriteQueue::IsEmpty() const {
-  for (int i = MINIMUM_PRIORITY; i <= MAXIMUM_PRIORITY; i++) {
-    if (!queue_[i].empty())
-      return false;
-  }
-  return true;
+  return num_pending_writes_ == 0;
 }
 
 void SpdyWriteQueue::Enqueue(
@@ -73,11 +69,16 @@ void SpdyWriteQueue::Enqueue(
   CHECK(!removing_writes_);
   CHECK_GE(priority, MINIMUM_PRIORITY);
   CHECK_LE(priority, MAXIMUM_PRIORITY);
-  if (stream.get())
+  DCHECK(frame_producer);
+  if (stream.get()) {
     DCHECK_EQ(stream->priority(), priority);
+    stream_writes_[stream.get()].push_back({priority, next_seq_[priority]});
+  }
   queue_[priority].push_back(
       {frame_type, std::move(frame_producer), stream,
        MutableNetworkTrafficAnnotationTag(traffic_annotation)});
+  next_seq_[priority]++;
+  num_pending_writes_++;
   if (IsSpdyFrameTypeWriteCapped(frame_type)) {
     DCHECK_GE(num_queued_capped_frames_, 0);
     num_queued_capped_frames_++;
@@ -91,15 +92,36 @@ bool SpdyWriteQueue::Dequeue(
     MutableNetworkTrafficAnnotationTag* traffic_annotation) {
   CHECK(!removing_writes_);
   for (int i = MAXIMUM_PRIORITY; i >= MINIMUM_PRIORITY; --i) {
-    if (!queue_[i].empty()) {
+    while (!queue_[i].empty()) {
+      uint64_t seq = next_seq_[i] - queue_[i].size();
       PendingWrite pending_write = std::move(queue_[i].front());
       queue_[i].pop_front();
+      if (!pending_write.frame_producer) {
+        num_removed_writes_--;
+        continue;
+      }
+      num_pending_writes_--;
       *frame_type = pending_write.frame_type;
       *frame_producer = std::move(pending_write.frame_producer);
       *stream = pending_write.stream;
       *traffic_annotation = pending_write.traffic_annotation;
       if (pending_write.has_stream)
         DCHECK(stream->get());
+      if (stream->get()) {
+        auto it = stream_writes_.find(stream->get());
+        CHECK(it != stream_writes_.end());
+        base::circular_deque<Slot>& slots = it->second;
+        // Slots of writes that were dequeued after their stream was gone
+        // may come first.
+        while (!slots.empty() && (slots.front().priority != i ||
+                                  slots.front().seq != seq)) {
+          slots.pop_front();
+        }
+        CHECK(!slots.empty());
+        slots.pop_front();
+        if (slots.empty())
+          stream_writes_.erase(it);
+      }
       if (IsSpdyFrameTypeWriteCapped(*frame_type)) {
         num_queued_capped_frames_--;
         DCHECK_GE(num_queued_capped_frames_, 0);
@@ -117,33 +139,25 @@ void SpdyWriteQueue::RemovePendingWritesForStream(SpdyStream* stream) {
   CHECK_GE(priority, MINIMUM_PRIORITY);
   CHECK_LE(priority, MAXIMUM_PRIORITY);
 
-#if DCHECK_IS_ON()
-  // |stream| should not have pending writes in a queue not matching
-  // its priority.
-  for (int i = MINIMUM_PRIORITY; i <= MAXIMUM_PRIORITY; ++i) {
-    if (priority == i)
-      continue;
-    for (auto it = queue_[i].begin(); it != queue_[i].end(); ++it)
-      DCHECK_NE(it->stream.get(), stream);
-  }
-#endif
-
   // Defer deletion until queue iteration is complete, as
   // SpdyBuffer::~SpdyBuffer() can result in callbacks into SpdyWriteQueue.
   std::vector<std::unique_ptr<SpdyBufferProducer>> erased_buffer_producers;
-  base::circular_deque<PendingWrite>& queue = queue_[priority];
-  for (auto it = queue.begin(); it != queue.end();) {
-    if (it->stream.get() == stream) {
-      if (IsSpdyFrameTypeWriteCapped(it->frame_type)) {
-        num_queued_capped_frames_--;
-        DCHECK_GE(num_queued_capped_frames_, 0);
+  auto it = stream_writes_.find(stream);
+  if (it != stream_writes_.end()) {
+    for (const Slot& slot : it->second) {
+      PendingWrite* pending_write = FindWrite(slot);
+      if (!pending_write || !pending_write->frame_producer ||
+          pending_write->stream.get() != stream) {
+        continue;
       }
-      erased_buffer_producers.push_back(std::move(it->frame_producer));
-      it = queue.erase(it);
-    } else {
-      ++it;
+      // |stream| should not have pending writes in a queue not matching
+      // its priority.
+      DCHECK_EQ(slot.priority, priority);
+      RemoveWrite(pending_write, &erased_buffer_producers);
     }
+    stream_writes_.erase(it);
   }
+  MaybeCompact();
   removing_writes_ = false;
 
   // Iteration on |queue| is completed.  Now |erased_buffer_producers| goes out
@@ -159,21 +173,18 @@ void SpdyWriteQueue::RemovePendingWritesForStreamsAfter(
   // SpdyBuffer::~SpdyBuffer() can result in callbacks into SpdyWriteQueue.
   std::vector<std::unique_ptr<SpdyBufferProducer>> erased_buffer_producers;
   for (int i = MINIMUM_PRIORITY; i <= MAXIMUM_PRIORITY; ++i) {
-    base::circular_deque<PendingWrite>& queue = queue_[i];
-    for (auto it = queue.begin(); it != queue.end();) {
-      if (it->stream.get() && (it->stream->stream_id() > last_good_stream_id ||
-                               it->stream->stream_id() == 0)) {
-        if (IsSpdyFrameTypeWriteCapped(it->frame_type)) {
-          num_queued_capped_frames_--;
-          DCHECK_GE(num_queued_capped_frames_, 0);
-        }
-        erased_buffer_producers.push_back(std::move(it->frame_producer));
-        it = queue.erase(it);
-      } else {
-        ++it;
+    for (PendingWrite& pending_write : queue_[i]) {
+      SpdyStream* stream = pending_write.stream.get();
+      if (pending_write.frame_producer && stream &&
+          (stream->stream_id() > last_good_stream_id ||
+           stream->stream_id() == 0)) {
+        // All the writes of |stream| match.
+        stream_writes_.erase(stream);
+        RemoveWrite(&pending_write, &erased_buffer_producers);
       }
     }
   }
+  MaybeCompact();
   removing_writes_ = false;
 
   // Iteration on each |queue| is completed.  Now |erased_buffer_producers| goes
@@ -186,28 +197,29 @@ void SpdyWriteQueue::ChangePriorityOfWritesForStream(
     RequestPriority new_priority) {
   CHECK(!removing_writes_);
   DCHECK(stream);
+  if (old_priority == new_priority)
+    return;
 
-#if DCHECK_IS_ON()
-  // |stream| should not have pending writes in a queue not matching
-  // |old_priority|.
-  for (int i = MINIMUM_PRIORITY; i <= MAXIMUM_PRIORITY; ++i) {
-    if (i == old_priority)
-      continue;
-    for (auto it = queue_[i].begin(); it != queue_[i].end(); ++it)
-      DCHECK_NE(it->stream.get(), stream);
-  }
-#endif
-
-  base::circular_deque<PendingWrite>& old_queue = queue_[old_priority];
+  auto it = stream_writes_.find(stream);
+  if (it == stream_writes_.end())
+    return;
   base::circular_deque<PendingWrite>& new_queue = queue_[new_priority];
-  for (auto it = old_queue.begin(); it != old_queue.end();) {
-    if (it->stream.get() == stream) {
-      new_queue.push_back(std::move(*it));
-      it = old_queue.erase(it);
-    } else {
-      ++it;
+  for (Slot& slot : it->second) {
+    PendingWrite* pending_write = FindWrite(slot);
+    if (!pending_write || !pending_write->frame_producer ||
+        pending_write->stream.get() != stream) {
+      continue;
     }
+    // |stream| should not have pending writes in a queue not matching
+    // |old_priority|.
+    DCHECK_EQ(slot.priority, old_priority);
+    // The moved-from write is left as a hole.
+    new_queue.push_back(std::move(*pending_write));
+    pending_write->stream.reset();
+    num_removed_writes_++;
+    slot = {new_priority, next_seq_[new_priority]++};
   }
+  MaybeCompact();
 }
 
 void SpdyWriteQueue::Clear() {
@@ -217,13 +229,67 @@ void SpdyWriteQueue::Clear() {
 
   for (int i = MINIMUM_PRIORITY; i <= MAXIMUM_PRIORITY; ++i) {
     for (auto& pending_write : queue_[i]) {
-      erased_buffer_producers.push_back(
-          std::move(pending_write.frame_producer));
+      if (pending_write.frame_producer) {
+        erased_buffer_producers.push_back(
+            std::move(pending_write.frame_producer));
+      }
     }
     queue_[i].clear();
+    next_seq_[i] = 0;
   }
+  stream_writes_.clear();
   removing_writes_ = false;
   num_queued_capped_frames_ = 0;
+  num_pending_writes_ = 0;
+  num_removed_writes_ = 0;
+}
+
+SpdyWriteQueue::PendingWrite* SpdyWriteQueue::FindWrite(const Slot& slot) {
+  base::circular_deque<PendingWrite>& queue = queue_[slot.priority];
+  uint64_t first_seq = next_seq_[slot.priority] - queue.size();
+  if (slot.seq < first_seq)
+    return nullptr;
+  DCHECK_LT(slot.seq - first_seq, queue.size());
+  return &queue[slot.seq - first_seq];
+}
+
+void SpdyWriteQueue::RemoveWrite(
+    PendingWrite* pending_write,
+    std::vector<std::unique_ptr<SpdyBufferProducer>>*
+        erased_buffer_producers) {
+  DCHECK(pending_write->frame_producer);
+  if (IsSpdyFrameTypeWriteCapped(pending_write->frame_type)) {
+    num_queued_capped_frames_--;
+    DCHECK_GE(num_queued_capped_frames_, 0);
+  }
+  erased_buffer_producers->push_back(std::move(pending_write->frame_producer));
+  pending_write->stream.reset();
+  num_pending_writes_--;
+  num_removed_writes_++;
+}
+
+void SpdyWriteQueue::MaybeCompact() {
+  // Keeps the cost of compacting below that of the removals that made the
+  // holes.
+  if (num_removed_writes_ < 64 || num_removed_writes_ < num_pending_writes_)
+    return;
+  stream_writes_.clear();
+  for (int i = MINIMUM_PRIORITY; i <= MAXIMUM_PRIORITY; ++i) {
+    base::circular_deque<PendingWrite>& queue = queue_[i];
+    base::circular_deque<PendingWrite> compacted;
+    for (PendingWrite& pending_write : queue) {
+      if (!pending_write.frame_producer)
+        continue;
+      if (SpdyStream* stream = pending_write.stream.get()) {
+        stream_writes_[stream].push_back(
+            {static_cast<RequestPriority>(i), compacted.size()});
+      }
+      compacted.push_back(std::move(pending_write));
+    }
+    queue.swap(compacted);
+    next_seq_[i] = queue.size();
+  }
+  num_removed_writes_ = 0;
 }
 
 }  // namespace net
@@ -5,7 +5,10 @@
 #ifndef NET_SPDY_SPDY_WRITE_QUEUE_H_
 #define NET_SPDY_SPDY_WRITE_QUEUE_H_
 
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "base/containers/circular_deque.h"
 #include "base/memory/weak_ptr.h"
@@ -25,7 +28,10 @@ class SpdyBufferProducer;
 class SpdyStream;
 
 // A queue of SpdyBufferProducers to produce frames to write. Ordered
-// by priority, and then FIFO.
+// by priority, and then FIFO. The writes of each stream are indexed, so
+// removing or reprioritizing them does not scan the writes of the other
+// streams; removed writes are left as holes that are skipped or compacted
+// away later.
 class NET_EXPORT_PRIVATE SpdyWriteQueue {
  public:
   SpdyWriteQueue();
@@ -85,6 +91,7 @@ class NET_EXPORT_PRIVATE SpdyWriteQueue {
   // A struct holding a frame producer and its associated stream.
   struct PendingWrite {
     spdy::SpdyFrameType frame_type;
+    // Null only once the write is removed from the middle of its queue.
     std::unique_ptr<SpdyBufferProducer> frame_producer;
     base::WeakPtr<SpdyStream> stream;
     MutableNetworkTrafficAnnotationTag traffic_annotation;
@@ -106,13 +113,43 @@ class NET_EXPORT_PRIVATE SpdyWriteQueue {
     ~PendingWrite();
   };
 
+  // Where a write is: its priority, and its sequence number in the queue of
+  // that priority.
+  struct Slot {
+    RequestPriority priority;
+    uint64_t seq;
+  };
+
+  // Returns the write at |slot|, or null if it was dequeued already.
+  PendingWrite* FindWrite(const Slot& slot);
+
+  // Leaves a hole in place of |pending_write|, keeping its frame producer
+  // in |erased_buffer_producers|.
+  void RemoveWrite(PendingWrite* pending_write,
+                   std::vector<std::unique_ptr<SpdyBufferProducer>>*
+                       erased_buffer_producers);
+
+  // Drops the holes once they outnumber the writes, renumbering the
+  // writes and rebuilding |stream_writes_|.
+  void MaybeCompact();
+
   bool removing_writes_ = false;
 
   // Number of currently queued capped frames including all priorities.
   int num_queued_capped_frames_ = 0;
 
-  // The actual write queue, binned by priority.
+  // Number of writes and of holes queued, including all priorities.
+  size_t num_pending_writes_ = 0;
+  size_t num_removed_writes_ = 0;
+
+  // The actual write queue, binned by priority. The front of |queue_[i]|
+  // has the sequence number |next_seq_[i] - queue_[i].size()|.
   base::circular_deque<PendingWrite> queue_[NUM_PRIORITIES];
+  uint64_t next_seq_[NUM_PRIORITIES] = {};
+
+  // The queued writes of each stream, in order.
+  std::unordered_map<const SpdyStream*, base::circular_deque<Slot>>
+      stream_writes_;
 };
 
 }  // namespace net
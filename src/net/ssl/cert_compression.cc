@@ -12,6 +12,10 @@
 #include "third_party/brotli/include/brotli/decode.h"
 #endif
 
+#if !defined(NET_DISABLE_ZSTD)
+#include "third_party/zstd/src/lib/zstd.h"
+#endif
+
 namespace net {
 namespace {
 
@@ -40,6 +44,32 @@ int DecompressBrotliCert(SSL* ssl,
 }
 #endif
 
+#if !defined(NET_DISABLE_ZSTD)
+// RFC 8879 assigns zstd this codepoint. BoringSSL does not name it.
+constexpr uint16_t kCertCompressionZstd = 3;
+
+int DecompressZstdCert(SSL* ssl,
+                       CRYPTO_BUFFER** out,
+                       size_t uncompressed_len,
+                       const uint8_t* in,
+                       size_t in_len) {
+  uint8_t* data;
+  bssl::UniquePtr<CRYPTO_BUFFER> decompressed(
+      CRYPTO_BUFFER_alloc(&data, uncompressed_len));
+  if (!decompressed) {
+    return 0;
+  }
+
+  size_t output_size = ZSTD_decompress(data, uncompressed_len, in, in_len);
+  if (ZSTD_isError(output_size) || output_size != uncompressed_len) {
+    return 0;
+  }
+
+  *out = decompressed.release();
+  return 1;
+}
+#endif
+
 }  // namespace
 
 void ConfigureCertificateCompression(SSL_CTX* ctx) {
@@ -48,6 +78,11 @@ void ConfigureCertificateCompression(SSL_CTX* ctx) {
                                    nullptr /* compression not supported */,
                                    DecompressBrotliCert);
 #endif
+#if !defined(NET_DISABLE_ZSTD)
+  SSL_CTX_add_cert_compression_alg(ctx, kCertCompressionZstd,
+                                   nullptr /* compression not supported */,
+                                   DecompressZstdCert);
+#endif
 
   // Avoid "unused argument" errors in case no algorithms are supported.
   (void)(ctx);
@@ -74,7 +74,7 @@ bssl::UniquePtr<SSL_SESSION> SSLClientSessionCache::Lookup(
 
   auto iter = cache_.Get(cache_key);
   if (iter == cache_.end())
-    return nullptr;
+    return store_ ? store_->Take(cache_key) : nullptr;
 
   time_t now = clock_->Now().ToTimeT();
   bssl::UniquePtr<SSL_SESSION> session = iter->second.Pop();
@@ -89,6 +89,8 @@ bssl::UniquePtr<SSL_SESSION> SSLClientSessionCache::Lookup(
 
 void SSLClientSessionCache::Insert(const Key& cache_key,
                                    bssl::UniquePtr<SSL_SESSION> session) {
+  if (store_)
+    store_->Save(cache_key, session.get());
   auto iter = cache_.Get(cache_key);
   if (iter == cache_.end())
     iter = cache_.Put(cache_key, Entry());
@@ -56,6 +56,18 @@ class NET_EXPORT SSLClientSessionCache {
     PrivacyMode privacy_mode = PRIVACY_MODE_DISABLED;
   };
 
+  // Keeps sessions beyond the life of the cache, as across restarts. It is
+  // given every session inserted and serves lookups that miss the cache.
+  class NET_EXPORT Store {
+   public:
+    virtual ~Store() = default;
+
+    virtual void Save(const Key& cache_key, const SSL_SESSION* session) = 0;
+    // Returns an unexpired session for |cache_key| and removes it from the
+    // store, or nullptr if there is none.
+    virtual bssl::UniquePtr<SSL_SESSION> Take(const Key& cache_key) = 0;
+  };
+
   explicit SSLClientSessionCache(const Config& config);
 
   SSLClientSessionCache(const SSLClientSessionCache&) = delete;
@@ -90,6 +102,10 @@ class NET_EXPORT SSLClientSessionCache {
 
   void SetClockForTesting(base::Clock* clock);
 
+  // Sets the store backing the cache, or nullptr for none. |store| must
+  // outlive the cache.
+  void set_store(Store* store) { store_ = store; }
+
  private:
   struct Entry {
     Entry();
@@ -119,6 +135,7 @@ class NET_EXPORT SSLClientSessionCache {
       base::MemoryPressureListener::MemoryPressureLevel memory_pressure_level);
 
   raw_ptr<base::Clock> clock_;
+  raw_ptr<Store> store_ = nullptr;
   Config config_;
   base::LRUCache<Key, Entry> cache_;
   size_t lookups_since_flush_ = 0;
@@ -71,6 +71,18 @@ struct NET_EXPORT SSLConfig {
   // If unsure, do not enable this option.
   bool early_data_enabled = false;
 
+  // If true, on Linux, once a TLS 1.3 handshake with an AES-GCM cipher is
+  // done over a plain TCP socket, records are written by the kernel, which
+  // encrypts the data of Write() itself. Reading stays in BoringSSL. A
+  // KeyUpdate requested by the server is not supported, and fails the
+  // connection.
+  bool kernel_tls_enabled = false;
+
+  // If true, and the SSLClientContext has an SSLKeyShareTuner, it chooses
+  // whether the ClientHello offers the post-quantum key share, by the
+  // handshake times it measured with the server.
+  bool tune_key_shares = false;
+
   // If true, causes only ECDHE cipher suites to be enabled.
   bool require_ecdhe = false;
 
@@ -7,7 +7,9 @@
 #include <stdio.h>
 
 #include <algorithm>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "base/files/file_util.h"
 #include "base/files/scoped_file.h"
@@ -61,12 +63,15 @@ class SSLKeyLoggerImpl::Core
   }
 
   void WriteLine(const std::string& line) {
+    // Copies the line before taking the lock, so handshakes on other threads
+    // only wait for the move.
+    std::string copy = line;
     bool was_empty;
     {
       base::AutoLock lock(lock_);
       was_empty = buffer_.empty();
       if (buffer_.size() < kMaxOutstandingLines) {
-        buffer_.push_back(line);
+        buffer_.push_back(std::move(copy));
       } else {
         lines_dropped_ = true;
       }
@@ -91,27 +96,34 @@ class SSLKeyLoggerImpl::Core
   void Flush() {
     DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
+    // Swaps in the buffer of the last flush, so `buffer_` keeps its
+    // capacity and the lines are freed here rather than on the writers.
     bool lines_dropped = false;
-    std::vector<std::string> buffer;
+    flushing_.clear();
     {
       base::AutoLock lock(lock_);
       std::swap(lines_dropped, lines_dropped_);
-      std::swap(buffer, buffer_);
+      std::swap(flushing_, buffer_);
     }
 
     if (file_) {
-      for (const auto& line : buffer) {
-        fprintf(file_.get(), "%s\n", line.c_str());
+      // Writes the batch at once rather than line by line.
+      std::string data;
+      for (const auto& line : flushing_) {
+        data += line;
+        data += '\n';
       }
       if (lines_dropped) {
-        fprintf(file_.get(), "# Some lines were dropped due to slow writes.\n");
+        data += "# Some lines were dropped due to slow writes.\n";
       }
+      fwrite(data.data(), 1, data.size(), file_.get());
       fflush(file_.get());
     }
   }
 
   scoped_refptr<base::SequencedTaskRunner> task_runner_;
   base::ScopedFILE file_;
+  std::vector<std::string> flushing_;
   SEQUENCE_CHECKER(sequence_checker_);
 
   base::Lock lock_;
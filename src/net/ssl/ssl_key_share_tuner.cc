@@ -0,0 +1,63 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/ssl/ssl_key_share_tuner.h"
+
+namespace net {
+
+namespace {
+
+// Servers are few, so this only bounds a misuse.
+constexpr size_t kMaxServers = 64;
+
+}  // namespace
+
+SSLKeyShareTuner::SSLKeyShareTuner() : servers_(kMaxServers) {}
+
+SSLKeyShareTuner::~SSLKeyShareTuner() = default;
+
+bool SSLKeyShareTuner::ShouldOfferPostQuantum(const HostPortPair& server) {
+  auto it = servers_.Get(server);
+  if (it == servers_.end())
+    it = servers_.Put(server, ServerState());
+  ServerState& state = it->second;
+
+  bool post_quantum;
+  if (state.post_quantum.samples < kMinSamples ||
+      state.classical.samples < kMinSamples) {
+    // Counts the handshakes still running, so a burst of them is split too.
+    post_quantum = state.post_quantum.offers <= state.classical.offers;
+  } else {
+    post_quantum = PrefersPostQuantum(state);
+    if (++state.handshakes % kProbeInterval == 0)
+      post_quantum = !post_quantum;
+  }
+  ++(post_quantum ? state.post_quantum : state.classical).offers;
+  return post_quantum;
+}
+
+void SSLKeyShareTuner::OnHandshakeComplete(const HostPortPair& server,
+                                           bool post_quantum,
+                                           base::TimeDelta time) {
+  auto it = servers_.Get(server);
+  if (it == servers_.end())
+    return;
+  Choice& choice =
+      post_quantum ? it->second.post_quantum : it->second.classical;
+  if (choice.samples == 0) {
+    choice.smoothed_time = time;
+  } else {
+    choice.smoothed_time +=
+        (time - choice.smoothed_time) / kHandshakeTimeSmoothing;
+  }
+  ++choice.samples;
+}
+
+// static
+bool SSLKeyShareTuner::PrefersPostQuantum(const ServerState& state) {
+  return state.classical.smoothed_time >=
+         state.post_quantum.smoothed_time * kClassicalMargin;
+}
+
+}  // namespace net
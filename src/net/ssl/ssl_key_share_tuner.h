@@ -0,0 +1,71 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SSL_SSL_KEY_SHARE_TUNER_H_
+#define NET_SSL_SSL_KEY_SHARE_TUNER_H_
+
+#include "base/containers/lru_cache.h"
+#include "base/time/time.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_export.h"
+
+namespace net {
+
+// Chooses, per server, whether TLS connections offer the post-quantum key
+// share, by the handshake times measured with and without it. The
+// post-quantum share adds about 1 KiB to the ClientHello, which on some paths
+// splits it over two packets and meets middlebox delays.
+//
+// A server starts with the post-quantum share, as Chrome sends, and the two
+// are taken in turn until each has kMinSamples handshakes. From then on the
+// classical share is only offered if its smoothed handshake time is below
+// kClassicalMargin of the post-quantum one, and the other choice is probed
+// every kProbeInterval handshakes so the choice follows the path. It is owned
+// by the HttpNetworkSession and, like it, used on one thread.
+class NET_EXPORT_PRIVATE SSLKeyShareTuner {
+ public:
+  static constexpr int kMinSamples = 3;
+  static constexpr int kProbeInterval = 16;
+  static constexpr double kClassicalMargin = 0.9;
+  static constexpr int kHandshakeTimeSmoothing = 8;
+
+  SSLKeyShareTuner();
+
+  SSLKeyShareTuner(const SSLKeyShareTuner&) = delete;
+  SSLKeyShareTuner& operator=(const SSLKeyShareTuner&) = delete;
+
+  ~SSLKeyShareTuner();
+
+  // Returns whether a new handshake with `server` offers the post-quantum key
+  // share.
+  bool ShouldOfferPostQuantum(const HostPortPair& server);
+
+  // Records the time from the first ClientHello to the end of a successful
+  // handshake with `server`.
+  void OnHandshakeComplete(const HostPortPair& server,
+                           bool post_quantum,
+                           base::TimeDelta time);
+
+ private:
+  struct Choice {
+    // Handshakes started, and completed, with this choice.
+    int offers = 0;
+    int samples = 0;
+    base::TimeDelta smoothed_time;
+  };
+
+  struct ServerState {
+    Choice post_quantum;
+    Choice classical;
+    int handshakes = 0;
+  };
+
+  static bool PrefersPostQuantum(const ServerState& state);
+
+  base::LRUCache<HostPortPair, ServerState> servers_;
+};
+
+}  // namespace net
+
+#endif  // NET_SSL_SSL_KEY_SHARE_TUNER_H_
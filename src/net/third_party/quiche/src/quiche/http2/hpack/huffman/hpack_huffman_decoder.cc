@@ -346,6 +346,53 @@ struct ShortCodeInfo {
     {0x7a, 7},  // Match: 0b1111011, Symbol: z
 };
 
+// Number of leading bits of the bit buffer looked up in the multi-code table,
+// which decodes up to two codes that fit in them at once. The codes of most
+// header characters are 5 or 6 bits long, so a lookup usually yields two
+// symbols.
+constexpr HuffmanAccumulatorBitCount kMultiCodeBitCount = 12;
+constexpr size_t kMultiCodeTableSize = size_t{1} << kMultiCodeBitCount;
+
+struct MultiCodeInfo {
+  char symbols[2];
+  // Number of symbols decoded, zero if the leading code is longer than
+  // kMultiCodeBitCount bits.
+  uint8_t count;
+  // Total length of their codes.
+  uint8_t length;
+};
+
+const MultiCodeInfo* BuildMultiCodeTable() {
+  auto* table = new MultiCodeInfo[kMultiCodeTableSize]();
+  for (size_t index = 0; index < kMultiCodeTableSize; ++index) {
+    MultiCodeInfo& info = table[index];
+    // The bits past the index are zero. Since the codes of each length span
+    // whole ranges of their prefixes, that does not change the length of a
+    // code which ends within the index.
+    HuffmanCode bits = static_cast<HuffmanCode>(index)
+                       << (kHuffmanCodeBitCount - kMultiCodeBitCount);
+    while (info.count < 2) {
+      PrefixInfo prefix_info = PrefixToInfo(bits);
+      if (info.length + prefix_info.code_length > kMultiCodeBitCount) {
+        break;
+      }
+      // The EOS code is 30 bits long, so it never fits.
+      uint32_t canonical = prefix_info.DecodeToCanonical(bits);
+      QUICHE_DCHECK_LT(canonical, 256u);
+      info.symbols[info.count++] =
+          static_cast<char>(kCanonicalToSymbol[canonical]);
+      info.length += prefix_info.code_length;
+      bits <<= prefix_info.code_length;
+    }
+  }
+  return table;
+}
+
+const MultiCodeInfo* GetMultiCodeTable() {
+  static const MultiCodeInfo* const table = BuildMultiCodeTable();
+  return table;
+}
+
 }  // namespace
 
 HuffmanBitBuffer::HuffmanBitBuffer() { Reset(); }
@@ -416,36 +463,65 @@ HpackHuffmanDecoder::~HpackHuffmanDecoder() = default;
 bool HpackHuffmanDecoder::Decode(absl::string_view input, std::string* output) {
   QUICHE_DVLOG(1) << "HpackHuffmanDecoder::Decode";
 
-  // Fill bit_buffer_ from input.
-  input.remove_prefix(bit_buffer_.AppendBytes(input));
+  const MultiCodeInfo* multi_code_table = GetMultiCodeTable();
+  // Decodes into room for the most symbols that the buffered bits and
+  // |input| can hold, and into a copy of bit_buffer_, which the compiler can
+  // then keep in registers while storing the symbols.
+  size_t output_size = output->size();
+  output->resize(output_size +
+                 (bit_buffer_.count() + input.size() * 8) / kMinCodeBitCount);
+  char* out = output->data() + output_size;
+  HuffmanBitBuffer bit_buffer = bit_buffer_;
+  auto finish = [&]() {
+    output->resize(static_cast<size_t>(out - output->data()));
+    bit_buffer_ = bit_buffer;
+  };
+
+  // Fill bit_buffer from input.
+  input.remove_prefix(bit_buffer.AppendBytes(input));
 
   while (true) {
-    QUICHE_DVLOG(3) << "Enter Decode Loop, bit_buffer_: " << bit_buffer_;
-    if (bit_buffer_.count() >= 7) {
-      // Get high 7 bits of the bit buffer, see if that contains a complete
-      // code of 5, 6 or 7 bits.
-      uint8_t short_code =
-          bit_buffer_.value() >> (kHuffmanAccumulatorBitCount - 7);
-      QUICHE_DCHECK_LT(short_code, 128);
-      if (short_code < kShortCodeTableSize) {
-        ShortCodeInfo info = kShortCodeTable[short_code];
-        bit_buffer_.ConsumeBits(info.length);
-        output->push_back(static_cast<char>(info.symbol));
+    QUICHE_DVLOG(3) << "Enter Decode Loop, bit_buffer: " << bit_buffer;
+    if (bit_buffer.count() >= kMultiCodeBitCount) {
+      // Get high 12 bits of the bit buffer, see if they start with one or two
+      // complete codes.
+      MultiCodeInfo info =
+          multi_code_table[bit_buffer.value() >>
+                           (kHuffmanAccumulatorBitCount - kMultiCodeBitCount)];
+      if (info.count > 0) {
+        bit_buffer.ConsumeBits(info.length);
+        // There is room for two, since at least 12 bits remain.
+        out[0] = info.symbols[0];
+        out[1] = info.symbols[1];
+        out += info.count;
         continue;
       }
-      // The code is more than 7 bits long. Use PrefixToInfo, etc. to decode
+      // The code is more than 12 bits long. Use PrefixToInfo, etc. to decode
       // longer codes.
     } else {
-      // We may have (mostly) drained bit_buffer_. If we can top it up, try
+      // We may have (mostly) drained bit_buffer. If we can top it up, try
       // using the table decoder above.
-      size_t byte_count = bit_buffer_.AppendBytes(input);
+      size_t byte_count = bit_buffer.AppendBytes(input);
       if (byte_count > 0) {
         input.remove_prefix(byte_count);
         continue;
       }
+      if (bit_buffer.count() >= 7) {
+        // At the end of the input. Get high 7 bits of the bit buffer, see if
+        // that contains a complete code of 5, 6 or 7 bits.
+        uint8_t short_code =
+            bit_buffer.value() >> (kHuffmanAccumulatorBitCount - 7);
+        QUICHE_DCHECK_LT(short_code, 128);
+        if (short_code < kShortCodeTableSize) {
+          ShortCodeInfo info = kShortCodeTable[short_code];
+          bit_buffer.ConsumeBits(info.length);
+          *out++ = static_cast<char>(info.symbol);
+          continue;
+        }
+      }
     }
 
-    HuffmanCode code_prefix = bit_buffer_.value() >> kExtraAccumulatorBitCount;
+    HuffmanCode code_prefix = bit_buffer.value() >> kExtraAccumulatorBitCount;
     QUICHE_DVLOG(3) << "code_prefix: " << HuffmanCodeBitSet(code_prefix);
 
     PrefixInfo prefix_info = PrefixToInfo(code_prefix);
@@ -453,26 +529,28 @@ bool HpackHuffmanDecoder::Decode(absl::string_view input, std::string* output) {
     QUICHE_DCHECK_LE(kMinCodeBitCount, prefix_info.code_length);
     QUICHE_DCHECK_LE(prefix_info.code_length, kMaxCodeBitCount);
 
-    if (prefix_info.code_length <= bit_buffer_.count()) {
+    if (prefix_info.code_length <= bit_buffer.count()) {
       // We have enough bits for one code.
       uint32_t canonical = prefix_info.DecodeToCanonical(code_prefix);
       if (canonical < 256) {
         // Valid code.
         char c = kCanonicalToSymbol[canonical];
-        output->push_back(c);
-        bit_buffer_.ConsumeBits(prefix_info.code_length);
+        *out++ = c;
+        bit_buffer.ConsumeBits(prefix_info.code_length);
         continue;
       }
       // Encoder is not supposed to explicity encode the EOS symbol.
-      QUICHE_DLOG(ERROR) << "EOS explicitly encoded!\n " << bit_buffer_ << "\n "
+      QUICHE_DLOG(ERROR) << "EOS explicitly encoded!\n " << bit_buffer << "\n "
                          << prefix_info;
+      finish();
       return false;
     }
-    // bit_buffer_ doesn't have enough bits in it to decode the next symbol.
+    // bit_buffer doesn't have enough bits in it to decode the next symbol.
     // Append to it as many bytes as are available AND fit.
-    size_t byte_count = bit_buffer_.AppendBytes(input);
+    size_t byte_count = bit_buffer.AppendBytes(input);
     if (byte_count == 0) {
       QUICHE_DCHECK_EQ(input.size(), 0u);
+      finish();
       return true;
     }
     input.remove_prefix(byte_count);
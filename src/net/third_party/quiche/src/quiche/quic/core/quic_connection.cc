@@ -3559,6 +3559,9 @@ bool QuicConnection::WritePacket(SerializedPacket* packet) {
 
   stats_.bytes_sent += encrypted_length;
   ++stats_.packets_sent;
+  if (packet->has_ack) {
+    stats_.num_ack_frames_sent++;
+  }
   if (packet->has_ack_ecn) {
     stats_.num_ack_frames_sent_with_ecn++;
   }
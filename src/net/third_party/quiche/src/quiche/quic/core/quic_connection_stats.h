@@ -193,6 +193,9 @@ struct QUICHE_EXPORT QuicConnectionStats {
   // all packet number spaces.
   QuicEcnCounts num_ecn_marks_received;
 
+  // Counts the number of ACK frames sent.
+  QuicPacketCount num_ack_frames_sent = 0;
+
   // Counts the number of ACK frames sent with ECN counts.
   QuicPacketCount num_ack_frames_sent_with_ecn = 0;
 
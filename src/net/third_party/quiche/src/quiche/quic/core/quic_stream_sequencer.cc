@@ -288,6 +288,10 @@ size_t QuicStreamSequencer::NumBytesBuffered() const {
   return buffered_frames_.BytesBuffered();
 }
 
+size_t QuicStreamSequencer::NumBytesAllocated() const {
+  return buffered_frames_.BytesAllocated();
+}
+
 QuicStreamOffset QuicStreamSequencer::NumBytesConsumed() const {
   return buffered_frames_.BytesConsumed();
 }
@@ -136,6 +136,9 @@ class QUICHE_EXPORT QuicStreamSequencer final {
   // Number of bytes in the buffer right now.
   size_t NumBytesBuffered() const;
 
+  // Number of bytes allocated for the buffer right now.
+  size_t NumBytesAllocated() const;
+
   // Number of bytes has been consumed.
   QuicStreamOffset NumBytesConsumed() const;
 
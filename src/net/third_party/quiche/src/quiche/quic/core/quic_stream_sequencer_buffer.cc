@@ -453,6 +453,16 @@ size_t QuicStreamSequencerBuffer::BytesBuffered() const {
   return num_bytes_buffered_;
 }
 
+size_t QuicStreamSequencerBuffer::BytesAllocated() const {
+  size_t bytes = current_blocks_count_ * sizeof(BufferBlock*);
+  for (size_t i = 0; i < current_blocks_count_; ++i) {
+    if (blocks_[i] != nullptr) {
+      bytes += sizeof(BufferBlock);
+    }
+  }
+  return bytes;
+}
+
 size_t QuicStreamSequencerBuffer::GetBlockIndex(QuicStreamOffset offset) const {
   return (offset % max_buffer_capacity_bytes_) / kBlockSizeBytes;
 }
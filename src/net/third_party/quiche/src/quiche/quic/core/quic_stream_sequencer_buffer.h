@@ -156,6 +156,9 @@ class QUICHE_EXPORT QuicStreamSequencerBuffer {
   // Count how many bytes are in buffer at this moment.
   size_t BytesBuffered() const;
 
+  // Count how many bytes are allocated for blocks and the block pointers.
+  size_t BytesAllocated() const;
+
   // Returns number of bytes available to be read out.
   size_t ReadableBytes() const;
 
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+# Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+'''
+Converts a NetLog file saved by naive with --log-net-log-binary to the JSON
+format of FileNetLogObserver, which netlog-viewer reads. The format is
+described in net/tools/naive/naive_binary_net_log_observer.h.
+'''
+
+import json
+import struct
+import sys
+
+
+USAGE = '''Usage: binary_net_log_to_json.py <INPUT_PATH> <OUTPUT_PATH>
+
+Converts the binary NetLog file at <INPUT_PATH> to a JSON NetLog file at
+<OUTPUT_PATH>. A file cut short is converted up to its last complete event.
+'''
+
+MAGIC = b'NLB1'
+# Must match NaiveBinaryNetLogObserver::kMaxKeys.
+MAX_KEYS = 4096
+
+TAG_NONE = 0
+TAG_FALSE = 1
+TAG_TRUE = 2
+TAG_INT = 3
+TAG_DOUBLE = 4
+TAG_STRING = 5
+TAG_BINARY = 6
+TAG_DICT = 7
+TAG_LIST = 8
+
+
+class Truncated(Exception):
+  pass
+
+
+class Reader(object):
+  def __init__(self, data):
+    self.data = data
+    self.pos = 0
+    self.keys = []
+
+  def at_end(self):
+    return self.pos >= len(self.data)
+
+  def read_bytes(self, size):
+    if self.pos + size > len(self.data):
+      raise Truncated()
+    value = self.data[self.pos:self.pos + size]
+    self.pos += size
+    return value
+
+  def read_varint(self):
+    value = 0
+    shift = 0
+    while True:
+      byte = self.read_bytes(1)[0]
+      value |= (byte & 0x7f) << shift
+      if byte < 0x80:
+        return value
+      shift += 7
+
+  def read_signed_varint(self):
+    value = self.read_varint()
+    return (value >> 1) ^ -(value & 1)
+
+  def read_string(self):
+    return self.read_bytes(self.read_varint()).decode('utf-8', 'replace')
+
+  def read_key(self):
+    index = self.read_varint()
+    if index > 0:
+      return self.keys[index - 1]
+    key = self.read_string()
+    if len(self.keys) < MAX_KEYS:
+      self.keys.append(key)
+    return key
+
+  def read_dict(self):
+    result = {}
+    for _ in range(self.read_varint()):
+      key = self.read_key()
+      result[key] = self.read_value()
+    return result
+
+  def read_value(self):
+    tag = self.read_bytes(1)[0]
+    if tag == TAG_NONE:
+      return None
+    if tag == TAG_FALSE:
+      return False
+    if tag == TAG_TRUE:
+      return True
+    if tag == TAG_INT:
+      return self.read_signed_varint()
+    if tag == TAG_DOUBLE:
+      return struct.unpack('<d', self.read_bytes(8))[0]
+    if tag == TAG_STRING:
+      return self.read_string()
+    if tag == TAG_BINARY:
+      # Like base::Value, which JSONWriter does not write.
+      return self.read_bytes(self.read_varint()).hex()
+    if tag == TAG_DICT:
+      return self.read_dict()
+    if tag == TAG_LIST:
+      return [self.read_value() for _ in range(self.read_varint())]
+    raise ValueError('Unknown value tag %d at %d' % (tag, self.pos - 1))
+
+
+def convert(data, output):
+  if data[:len(MAGIC)] != MAGIC:
+    raise ValueError('Not a binary NetLog file')
+  reader = Reader(data)
+  reader.pos = len(MAGIC)
+  constants = reader.read_string()
+  output.write('{"constants":%s,\n"events": [\n' % constants)
+
+  time_ms = 0
+  num_events = 0
+  while not reader.at_end():
+    try:
+      event_type = reader.read_varint()
+      phase = reader.read_varint()
+      source_id = reader.read_varint()
+      source_type = reader.read_varint()
+      time_ms += reader.read_signed_varint()
+      start_time_ms = time_ms - reader.read_signed_varint()
+      params = reader.read_dict()
+    except Truncated:
+      sys.stderr.write('Truncated after %d events\n' % num_events)
+      break
+    event = {
+        'phase': phase,
+        'source': {
+            'id': source_id,
+            'start_time': str(start_time_ms),
+            'type': source_type,
+        },
+        'time': str(time_ms),
+        'type': event_type,
+    }
+    if params:
+      event['params'] = params
+    if num_events > 0:
+      output.write(',\n')
+    output.write(json.dumps(event, separators=(',', ':')))
+    num_events += 1
+
+  output.write(']}\n')
+
+
+def main():
+  if len(sys.argv) != 3:
+    sys.stderr.write(USAGE)
+    sys.exit(1)
+
+  with open(sys.argv[1], 'rb') as f:
+    data = f.read()
+  with open(sys.argv[2], 'w') as output:
+    convert(data, output)
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,961 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/http2_proxy_server_session.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "base/check.h"
+#include "base/containers/span.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/task/single_thread_task_runner.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/cert/x509_certificate.h"
+#include "net/http/http_request_headers.h"
+#include "net/socket/ssl_server_socket.h"
+#include "net/ssl/ssl_server_config.h"
+#include "net/third_party/quiche/src/quiche/http2/adapter/http2_protocol.h"
+#include "net/third_party/quiche/src/quiche/spdy/core/spdy_protocol.h"
+#include "net/tools/naive/naive_buffer_pool.h"
+#include "net/tools/naive/naive_proxy_delegate.h"
+#include "net/tools/naive/naive_random.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "third_party/boringssl/src/include/openssl/bio.h"
+#include "third_party/boringssl/src/include/openssl/evp.h"
+#include "third_party/boringssl/src/include/openssl/pem.h"
+
+namespace net {
+
+namespace {
+using http2::adapter::Header;
+using http2::adapter::HeaderRep;
+using http2::adapter::Http2ErrorCode;
+using http2::adapter::Http2StreamId;
+
+// As the padding header of the replies of HttpProxyServerSocket.
+constexpr int kMinPaddingSize = 30;
+constexpr int kMaxPaddingSize = kMinPaddingSize + 32;
+}  // namespace
+
+std::unique_ptr<SSLServerContext> CreateHttp2ProxySSLServerContext(
+    std::string_view cert_pem,
+    std::string_view key_pem) {
+  CertificateList certs = X509Certificate::CreateCertificateListFromBytes(
+      base::as_byte_span(cert_pem), X509Certificate::FORMAT_PEM_CERT_SEQUENCE);
+  if (certs.empty())
+    return nullptr;
+  // The intermediates are sent with the leaf.
+  std::vector<bssl::UniquePtr<CRYPTO_BUFFER>> intermediates;
+  for (size_t i = 1; i < certs.size(); ++i) {
+    intermediates.push_back(bssl::UpRef(certs[i]->cert_buffer()));
+  }
+  scoped_refptr<X509Certificate> cert = X509Certificate::CreateFromBuffer(
+      bssl::UpRef(certs[0]->cert_buffer()), std::move(intermediates));
+  if (!cert)
+    return nullptr;
+
+  bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(key_pem.data(), key_pem.size()));
+  if (!bio)
+    return nullptr;
+  bssl::UniquePtr<EVP_PKEY> key(
+      PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
+  if (!key)
+    return nullptr;
+
+  SSLServerConfig ssl_config;
+  ssl_config.alpn_protos = {kProtoHTTP2};
+  return CreateSSLServerContext(cert.get(), key.get(), ssl_config);
+}
+
+Http2ProxyServerStream::Http2ProxyServerStream(
+    base::WeakPtr<Http2ProxyServerSession> session,
+    Http2StreamId stream_id,
+    const HostPortPair& request_endpoint,
+    const std::string& user,
+    PaddingType padding_type,
+    const PaddingLimits& padding_limits,
+    const NetLogWithSource& net_log)
+    : session_(std::move(session)),
+      stream_id_(stream_id),
+      request_endpoint_(request_endpoint),
+      user_(user),
+      padding_type_(padding_type),
+      padding_limits_(padding_limits),
+      net_log_(net_log) {}
+
+Http2ProxyServerStream::~Http2ProxyServerStream() {
+  Disconnect();
+}
+
+int Http2ProxyServerStream::Connect(CompletionOnceCallback callback) {
+  // The session answered the CONNECT already.
+  return error_;
+}
+
+void Http2ProxyServerStream::Disconnect() {
+  read_buf_ = nullptr;
+  read_callback_.Reset();
+  write_buf_ = nullptr;
+  write_callback_.Reset();
+  if (session_) {
+    if (stream_closed_) {
+      session_->OnStreamDestroyed(stream_id_, /*reset=*/false, std::nullopt);
+    } else if (error_ == OK && write_fin_ && read_eof_) {
+      // Ended both ways. The rest of the writes and the END_STREAM are
+      // still sent.
+      session_->OnStreamDestroyed(stream_id_, /*reset=*/false,
+                                  std::move(write_buffer_));
+    } else {
+      session_->OnStreamDestroyed(stream_id_, /*reset=*/true, std::nullopt);
+    }
+    session_ = nullptr;
+  }
+  if (error_ == OK)
+    error_ = ERR_SOCKET_NOT_CONNECTED;
+}
+
+int Http2ProxyServerStream::ShutdownWrite() {
+  if (error_ != OK)
+    return error_;
+  if (write_fin_)
+    return OK;
+  write_fin_ = true;
+  session_->ResumeStream(stream_id_);
+  return OK;
+}
+
+bool Http2ProxyServerStream::IsConnected() const {
+  return error_ == OK;
+}
+
+bool Http2ProxyServerStream::IsConnectedAndIdle() const {
+  return error_ == OK && read_offset_ == read_buffer_.size() && !read_eof_;
+}
+
+const NetLogWithSource& Http2ProxyServerStream::NetLog() const {
+  return net_log_;
+}
+
+bool Http2ProxyServerStream::WasEverUsed() const {
+  return was_ever_used_;
+}
+
+NextProto Http2ProxyServerStream::GetNegotiatedProtocol() const {
+  return kProtoUnknown;
+}
+
+bool Http2ProxyServerStream::GetSSLInfo(SSLInfo* ssl_info) {
+  return false;
+}
+
+int64_t Http2ProxyServerStream::GetTotalReceivedBytes() const {
+  return total_received_bytes_;
+}
+
+void Http2ProxyServerStream::ApplySocketTag(const SocketTag& tag) {}
+
+int Http2ProxyServerStream::Read(IOBuffer* buf,
+                                 int buf_len,
+                                 CompletionOnceCallback callback) {
+  DCHECK(!read_callback_);
+  int rv = ReadBuffered(buf, buf_len);
+  if (rv == ERR_IO_PENDING) {
+    read_buf_ = buf;
+    read_buf_len_ = buf_len;
+    read_callback_ = std::move(callback);
+    read_if_ready_ = false;
+  }
+  return rv;
+}
+
+int Http2ProxyServerStream::ReadIfReady(IOBuffer* buf,
+                                        int buf_len,
+                                        CompletionOnceCallback callback) {
+  DCHECK(!read_callback_);
+  int rv = ReadBuffered(buf, buf_len);
+  if (rv == ERR_IO_PENDING) {
+    read_callback_ = std::move(callback);
+    read_if_ready_ = true;
+  }
+  return rv;
+}
+
+int Http2ProxyServerStream::CancelReadIfReady() {
+  DCHECK(read_if_ready_ || !read_callback_);
+  read_callback_.Reset();
+  return OK;
+}
+
+int Http2ProxyServerStream::Write(
+    IOBuffer* buf,
+    int buf_len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  DCHECK(!write_callback_);
+  DCHECK(!write_fin_);
+  if (error_ != OK)
+    return error_;
+  was_ever_used_ = true;
+  if (write_buffer_.size() >= kMaxWriteBufferSize) {
+    write_buf_ = buf;
+    write_buf_len_ = buf_len;
+    write_callback_ = std::move(callback);
+    return ERR_IO_PENDING;
+  }
+  write_buffer_.append(buf->data(), buf_len);
+  session_->ResumeStream(stream_id_);
+  return buf_len;
+}
+
+int Http2ProxyServerStream::SetReceiveBufferSize(int32_t size) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int Http2ProxyServerStream::SetSendBufferSize(int32_t size) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int Http2ProxyServerStream::GetPeerAddress(IPEndPoint* address) const {
+  if (!session_)
+    return ERR_SOCKET_NOT_CONNECTED;
+  return session_->GetPeerAddress(address);
+}
+
+int Http2ProxyServerStream::GetLocalAddress(IPEndPoint* address) const {
+  if (!session_)
+    return ERR_SOCKET_NOT_CONNECTED;
+  return session_->GetLocalAddress(address);
+}
+
+bool Http2ProxyServerStream::OnData(std::string_view data) {
+  // Up to a stream window may be buffered, so the read part is dropped
+  // only once it is the larger part.
+  if (read_offset_ > 0 && read_offset_ >= read_buffer_.size() / 2) {
+    read_buffer_.erase(0, read_offset_);
+    read_offset_ = 0;
+  }
+  read_buffer_.append(data);
+  total_received_bytes_ += data.size();
+  return MarkReadable();
+}
+
+bool Http2ProxyServerStream::OnEndStream() {
+  read_eof_ = true;
+  return MarkReadable();
+}
+
+bool Http2ProxyServerStream::OnClosed(int error) {
+  stream_closed_ = true;
+  if (error_ == OK && error != OK)
+    error_ = error;
+  if (error != OK) {
+    write_buffer_.clear();
+    // Fails a write waiting for room.
+    if (write_callback_) {
+      base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+          FROM_HERE,
+          base::BindOnce(&Http2ProxyServerStream::CompletePendingWrite,
+                         weak_ptr_factory_.GetWeakPtr()));
+    }
+  }
+  return MarkReadable();
+}
+
+bool Http2ProxyServerStream::MarkReadable() {
+  if (!read_callback_ || read_notify_pending_)
+    return false;
+  read_notify_pending_ = true;
+  return true;
+}
+
+void Http2ProxyServerStream::OnReadable() {
+  read_notify_pending_ = false;
+  if (!read_callback_)
+    return;
+  int rv;
+  if (read_if_ready_) {
+    rv = OK;
+  } else {
+    rv = ReadBuffered(read_buf_.get(), read_buf_len_);
+    if (rv == ERR_IO_PENDING)
+      return;
+    read_buf_ = nullptr;
+  }
+  std::move(read_callback_).Run(rv);
+}
+
+int Http2ProxyServerStream::ReadBuffered(IOBuffer* buf, int buf_len) {
+  if (read_offset_ < read_buffer_.size()) {
+    size_t length = std::min(read_buffer_.size() - read_offset_,
+                             static_cast<size_t>(buf_len));
+    std::memcpy(buf->data(), read_buffer_.data() + read_offset_, length);
+    read_offset_ += length;
+    if (read_offset_ == read_buffer_.size()) {
+      read_buffer_.clear();
+      read_offset_ = 0;
+    }
+    was_ever_used_ = true;
+    // Opens the flow control windows for more.
+    if (session_)
+      session_->ConsumeData(stream_id_, length);
+    return static_cast<int>(length);
+  }
+  if (read_eof_)
+    return 0;
+  if (error_ != OK)
+    return error_;
+  return ERR_IO_PENDING;
+}
+
+bool Http2ProxyServerStream::has_write_data() const {
+  return !write_buffer_.empty() || write_fin_;
+}
+
+http2::adapter::Http2VisitorInterface::DataFrameHeaderInfo
+Http2ProxyServerStream::GetDataFrameInfo(size_t max_length) const {
+  size_t length = std::min(write_buffer_.size(), max_length);
+  bool end_stream = write_fin_ && length == write_buffer_.size();
+  return {static_cast<int64_t>(length), end_stream, end_stream};
+}
+
+void Http2ProxyServerStream::TakeWriteData(size_t length, std::string* out) {
+  out->append(write_buffer_, 0, length);
+  write_buffer_.erase(0, length);
+  if (write_callback_ && write_buffer_.size() < kMaxWriteBufferSize) {
+    // Not run from the callbacks of the adapter.
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&Http2ProxyServerStream::CompletePendingWrite,
+                       weak_ptr_factory_.GetWeakPtr()));
+  }
+}
+
+void Http2ProxyServerStream::CompletePendingWrite() {
+  if (!write_callback_)
+    return;
+  int rv = error_;
+  if (rv == OK) {
+    write_buffer_.append(write_buf_->data(), write_buf_len_);
+    session_->ResumeStream(stream_id_);
+    rv = write_buf_len_;
+  }
+  write_buf_ = nullptr;
+  std::move(write_callback_).Run(rv);
+}
+
+Http2ProxyServerSession::Http2ProxyServerSession(
+    std::unique_ptr<StreamSocket> socket,
+    scoped_refptr<const NaiveUserTable> users,
+    const std::vector<PaddingType>& supported_padding_types,
+    const PaddingLimits& padding_limits,
+    const NetworkTrafficAnnotationTag& traffic_annotation,
+    StreamCallback stream_callback,
+    base::OnceClosure close_callback)
+    : socket_(std::move(socket)),
+      users_(std::move(users)),
+      supported_padding_types_(supported_padding_types),
+      padding_limits_(padding_limits),
+      traffic_annotation_(traffic_annotation),
+      stream_callback_(std::move(stream_callback)),
+      close_callback_(std::move(close_callback)),
+      net_log_(socket_->NetLog()),
+      read_buf_(base::MakeRefCounted<IOBufferWithSize>(kReadBufferSize)) {}
+
+Http2ProxyServerSession::~Http2ProxyServerSession() {
+  // The streams may outlive the session.
+  for (const auto& [stream_id, stream] : streams_) {
+    stream->session_ = nullptr;
+    stream->OnClosed(ERR_CONNECTION_CLOSED);
+  }
+}
+
+void Http2ProxyServerSession::Start() {
+  int rv = static_cast<SSLServerSocket*>(socket_.get())->Handshake(
+      base::BindOnce(&Http2ProxyServerSession::OnHandshakeComplete,
+                     weak_ptr_factory_.GetWeakPtr()));
+  if (rv != ERR_IO_PENDING)
+    OnHandshakeComplete(rv);
+}
+
+void Http2ProxyServerSession::StartCleartext(std::string_view received) {
+  StartHttp2();
+  if (!received.empty() && !ProcessReceived(received))
+    return;
+  DoRead();
+}
+
+void Http2ProxyServerSession::Shutdown() {
+  if (closed_ || shutting_down_)
+    return;
+  shutting_down_ = true;
+  if (!adapter_) {
+    Close(ERR_CONNECTION_CLOSED);
+    return;
+  }
+  // Streams after the last one seen are left for the client to retry.
+  adapter_->SubmitGoAway(last_stream_id_, Http2ErrorCode::HTTP2_NO_ERROR, "");
+  MaybeSend();
+  MaybeCloseAfterShutdown();
+}
+
+void Http2ProxyServerSession::OnHandshakeComplete(int result) {
+  if (result != OK) {
+    Close(result);
+    return;
+  }
+  if (socket_->GetNegotiatedProtocol() != kProtoHTTP2) {
+    Close(ERR_ALPN_NEGOTIATION_FAILED);
+    return;
+  }
+  StartHttp2();
+  DoRead();
+}
+
+void Http2ProxyServerSession::StartHttp2() {
+  http2::adapter::OgHttp2Adapter::Options options;
+  options.perspective = http2::adapter::Perspective::kServer;
+  options.allow_extended_connect = false;
+  adapter_ = http2::adapter::OgHttp2Adapter::Create(*this, options);
+  adapter_->SubmitSettings({
+      {http2::adapter::MAX_CONCURRENT_STREAMS, kMaxConcurrentStreams},
+      {http2::adapter::INITIAL_WINDOW_SIZE, kStreamWindowSize},
+  });
+  adapter_->SubmitWindowUpdate(
+      0, kSessionWindowSize - http2::adapter::kInitialFlowControlWindowSize);
+  MaybeSend();
+}
+
+void Http2ProxyServerSession::DoRead() {
+  for (int reads = 0; !closed_; ++reads) {
+    if (reads == kMaxReadsPerTask) {
+      base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+          FROM_HERE, base::BindOnce(&Http2ProxyServerSession::DoRead,
+                                    weak_ptr_factory_.GetWeakPtr()));
+      return;
+    }
+    int rv = socket_->Read(
+        read_buf_.get(), kReadBufferSize,
+        base::BindOnce(&Http2ProxyServerSession::OnReadComplete,
+                       weak_ptr_factory_.GetWeakPtr()));
+    if (rv == ERR_IO_PENDING)
+      return;
+    if (!HandleReadResult(rv))
+      return;
+  }
+}
+
+void Http2ProxyServerSession::OnReadComplete(int result) {
+  if (HandleReadResult(result))
+    DoRead();
+}
+
+bool Http2ProxyServerSession::HandleReadResult(int result) {
+  if (closed_)
+    return false;
+  if (result <= 0) {
+    Close(result == 0 ? ERR_CONNECTION_CLOSED : result);
+    return false;
+  }
+  return ProcessReceived(std::string_view(read_buf_->data(), result));
+}
+
+bool Http2ProxyServerSession::ProcessReceived(std::string_view remaining) {
+  while (!remaining.empty()) {
+    int64_t processed = adapter_->ProcessBytes(remaining);
+    if (processed < 0) {
+      Close(ERR_HTTP2_PROTOCOL_ERROR);
+      return false;
+    }
+    remaining.remove_prefix(processed);
+  }
+  MaybeSend();
+  if (!closed_)
+    RunStreamCallbacks();
+  return !closed_;
+}
+
+void Http2ProxyServerSession::RunStreamCallbacks() {
+  auto weak_this = weak_ptr_factory_.GetWeakPtr();
+  for (auto& stream : std::exchange(new_streams_, {})) {
+    stream_callback_.Run(std::move(stream));
+  }
+  for (Http2StreamId stream_id : std::exchange(readable_streams_, {})) {
+    if (!weak_this)
+      return;
+    auto it = streams_.find(stream_id);
+    if (it != streams_.end())
+      it->second->OnReadable();
+  }
+}
+
+void Http2ProxyServerSession::HandleRequest(Http2StreamId stream_id,
+                                            const Request& request) {
+  // Probes get what a web server without the page would answer.
+  if (request.method != HttpRequestHeaders::kConnectMethod) {
+    SendResponse(stream_id, "404", "", /*end_stream=*/true);
+    return;
+  }
+  const std::string* user = nullptr;
+  if (RequiresAuth(users_.get())) {
+    user = users_->FindByBasicAuth(request.proxy_authorization.value_or(""));
+    if (!user) {
+      LOG(WARNING) << "Invalid Proxy-Authorization: "
+                   << request.proxy_authorization.value_or("");
+      SendResponse(stream_id, "404", "", /*end_stream=*/true);
+      return;
+    }
+  }
+  std::optional<PaddingType> padding_type = SelectClientPaddingType(
+      request.has_padding, request.padding_type_request,
+      supported_padding_types_);
+  if (!padding_type.has_value()) {
+    adapter_->SubmitRst(stream_id, Http2ErrorCode::PROTOCOL_ERROR);
+    return;
+  }
+  PaddingLimits padding_limits = SelectClientPaddingLimits(
+      *padding_type, request.padding_type_request,
+      request.padding_compression_request, padding_limits_);
+  std::string padding_type_reply;
+  if (request.padding_type_request.has_value()) {
+    padding_type_reply = ToPaddingTypeReply(*padding_type, padding_limits);
+  }
+  SendResponse(stream_id, "200", padding_type_reply, /*end_stream=*/false);
+
+  auto stream = std::make_unique<Http2ProxyServerStream>(
+      weak_ptr_factory_.GetWeakPtr(), stream_id,
+      HostPortPair::FromString(request.authority), user ? *user : "",
+      *padding_type, padding_limits, net_log_);
+  streams_[stream_id] = stream.get();
+  new_streams_.push_back(std::move(stream));
+}
+
+void Http2ProxyServerSession::SendResponse(Http2StreamId stream_id,
+                                           std::string_view status,
+                                           std::string_view padding_type_reply,
+                                           bool end_stream) {
+  int padding_size = NaiveRandInt(kMinPaddingSize, kMaxPaddingSize);
+  std::string padding(padding_size, '\0');
+  FillNonindexHeaderValue(NaiveRandUint64(), padding.data(), padding_size);
+  std::vector<Header> headers;
+  headers.emplace_back(HeaderRep(std::string(":status")),
+                       HeaderRep(std::string(status)));
+  headers.emplace_back(HeaderRep(std::string(kPaddingHeader)),
+                       HeaderRep(std::move(padding)));
+  if (!padding_type_reply.empty()) {
+    headers.emplace_back(HeaderRep(std::string(kPaddingTypeReplyHeader)),
+                         HeaderRep(std::string(padding_type_reply)));
+  }
+  adapter_->SubmitResponse(stream_id, headers, /*data_source=*/nullptr,
+                           end_stream);
+}
+
+void Http2ProxyServerSession::ConsumeData(Http2StreamId stream_id,
+                                          size_t length) {
+  if (closed_)
+    return;
+  adapter_->MarkDataConsumedForStream(stream_id, length);
+  MaybeSend();
+}
+
+void Http2ProxyServerSession::ResumeStream(Http2StreamId stream_id) {
+  if (closed_)
+    return;
+  adapter_->ResumeStream(stream_id);
+  MaybeSend();
+}
+
+void Http2ProxyServerSession::OnStreamDestroyed(
+    Http2StreamId stream_id,
+    bool reset,
+    std::optional<std::string> unsent_writes) {
+  streams_.erase(stream_id);
+  if (closed_)
+    return;
+  if (reset) {
+    adapter_->SubmitRst(stream_id, Http2ErrorCode::CANCEL);
+    MaybeSend();
+  } else if (unsent_writes.has_value()) {
+    unsent_writes_[stream_id] = std::move(*unsent_writes);
+    ResumeStream(stream_id);
+  }
+  MaybeCloseAfterShutdown();
+}
+
+int Http2ProxyServerSession::GetPeerAddress(IPEndPoint* address) const {
+  return socket_->GetPeerAddress(address);
+}
+
+int Http2ProxyServerSession::GetLocalAddress(IPEndPoint* address) const {
+  return socket_->GetLocalAddress(address);
+}
+
+void Http2ProxyServerSession::MaybeSend() {
+  if (closed_ || sending_)
+    return;
+  if (adapter_->want_write()) {
+    sending_ = true;
+    int rv = adapter_->Send();
+    sending_ = false;
+    if (rv != 0) {
+      Close(ERR_HTTP2_PROTOCOL_ERROR);
+      return;
+    }
+  }
+  DoWrite();
+}
+
+void Http2ProxyServerSession::DoWrite() {
+  while (!closed_ && !write_pending_) {
+    if (!write_buf_) {
+      if (write_buffer_.empty())
+        return;
+      size_t size = write_buffer_.size();
+      write_buf_ = base::MakeRefCounted<DrainableIOBuffer>(
+          base::MakeRefCounted<StringIOBuffer>(std::move(write_buffer_)),
+          size);
+      write_buffer_.clear();
+      if (send_blocked_) {
+        // The frames held back fit in write_buffer_ now.
+        send_blocked_ = false;
+        for (const auto& [stream_id, stream] : streams_) {
+          if (stream->has_write_data())
+            adapter_->ResumeStream(stream_id);
+        }
+        for (const auto& [stream_id, unsent] : unsent_writes_) {
+          adapter_->ResumeStream(stream_id);
+        }
+        // Writes write_buf_ if it has not been.
+        MaybeSend();
+        continue;
+      }
+    }
+    int rv = socket_->Write(
+        write_buf_.get(), write_buf_->BytesRemaining(),
+        base::BindOnce(&Http2ProxyServerSession::OnWriteComplete,
+                       weak_ptr_factory_.GetWeakPtr()),
+        traffic_annotation_);
+    if (rv == ERR_IO_PENDING) {
+      write_pending_ = true;
+      return;
+    }
+    if (!HandleWriteResult(rv))
+      return;
+  }
+}
+
+void Http2ProxyServerSession::OnWriteComplete(int result) {
+  write_pending_ = false;
+  if (HandleWriteResult(result))
+    DoWrite();
+}
+
+bool Http2ProxyServerSession::HandleWriteResult(int result) {
+  if (closed_)
+    return false;
+  if (result < 0) {
+    Close(result);
+    return false;
+  }
+  write_buf_->DidConsume(result);
+  if (write_buf_->BytesRemaining() == 0) {
+    write_buf_ = nullptr;
+    MaybeCloseAfterShutdown();
+  }
+  return !closed_;
+}
+
+void Http2ProxyServerSession::MaybeCloseAfterShutdown() {
+  // After the GOAWAY and the ends of the streams are written.
+  if (shutting_down_ && requests_.empty() && streams_.empty() &&
+      unsent_writes_.empty() && !write_buf_ && write_buffer_.empty()) {
+    Close(OK);
+  }
+}
+
+void Http2ProxyServerSession::Close(int error) {
+  if (closed_)
+    return;
+  closed_ = true;
+  close_error_ = error;
+  // Streams and callers up the stack learn of it from a task of its own.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&Http2ProxyServerSession::DoClose,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+void Http2ProxyServerSession::DoClose() {
+  socket_->Disconnect();
+  new_streams_.clear();
+  int error = close_error_ == OK ? ERR_CONNECTION_CLOSED : close_error_;
+  auto weak_this = weak_ptr_factory_.GetWeakPtr();
+  for (auto& [stream_id, stream] : std::exchange(streams_, {})) {
+    stream->session_ = nullptr;
+    if (stream->OnClosed(error))
+      stream->OnReadable();
+    if (!weak_this)
+      return;
+  }
+  std::move(close_callback_).Run();
+}
+
+int64_t Http2ProxyServerSession::OnReadyToSend(std::string_view serialized) {
+  if (write_buffer_.size() >= kMaxWriteBufferSize) {
+    send_blocked_ = true;
+    return kSendBlocked;
+  }
+  write_buffer_.append(serialized);
+  return serialized.size();
+}
+
+http2::adapter::Http2VisitorInterface::DataFrameHeaderInfo
+Http2ProxyServerSession::OnReadyToSendDataForStream(Http2StreamId stream_id,
+                                                    size_t max_length) {
+  if (write_buffer_.size() >= kMaxWriteBufferSize) {
+    send_blocked_ = true;
+    return {0, false, false};
+  }
+  auto it = streams_.find(stream_id);
+  if (it != streams_.end())
+    return it->second->GetDataFrameInfo(max_length);
+  auto unsent_it = unsent_writes_.find(stream_id);
+  if (unsent_it == unsent_writes_.end())
+    return {0, false, false};
+  size_t length = std::min(unsent_it->second.size(), max_length);
+  bool end_stream = length == unsent_it->second.size();
+  return {static_cast<int64_t>(length), end_stream, end_stream};
+}
+
+bool Http2ProxyServerSession::SendDataFrame(Http2StreamId stream_id,
+                                            std::string_view frame_header,
+                                            size_t payload_bytes) {
+  write_buffer_.append(frame_header);
+  auto it = streams_.find(stream_id);
+  if (it != streams_.end()) {
+    it->second->TakeWriteData(payload_bytes, &write_buffer_);
+    return true;
+  }
+  std::string& unsent = unsent_writes_[stream_id];
+  write_buffer_.append(unsent, 0, payload_bytes);
+  unsent.erase(0, payload_bytes);
+  return true;
+}
+
+void Http2ProxyServerSession::OnConnectionError(ConnectionError error) {
+  Close(ERR_HTTP2_PROTOCOL_ERROR);
+}
+
+bool Http2ProxyServerSession::OnFrameHeader(Http2StreamId stream_id,
+                                            size_t length,
+                                            uint8_t type,
+                                            uint8_t flags) {
+  return true;
+}
+
+bool Http2ProxyServerSession::OnBeginHeadersForStream(
+    Http2StreamId stream_id) {
+  last_stream_id_ = std::max(last_stream_id_, stream_id);
+  requests_.emplace(stream_id, Request());
+  return true;
+}
+
+http2::adapter::Http2VisitorInterface::OnHeaderResult
+Http2ProxyServerSession::OnHeaderForStream(Http2StreamId stream_id,
+                                           std::string_view key,
+                                           std::string_view value) {
+  auto it = requests_.find(stream_id);
+  if (it == requests_.end())
+    return HEADER_OK;
+  Request& request = it->second;
+  // Names are lowercase in HTTP/2.
+  if (key == http2::adapter::kHttp2MethodPseudoHeader) {
+    request.method = value;
+  } else if (key == http2::adapter::kHttp2AuthorityPseudoHeader) {
+    request.authority = value;
+  } else if (key == "proxy-authorization") {
+    request.proxy_authorization = std::string(value);
+  } else if (key == kPaddingHeader) {
+    request.has_padding = true;
+  } else if (key == kPaddingTypeRequestHeader) {
+    request.padding_type_request = std::string(value);
+  } else if (key == kPaddingCompressionRequestHeader) {
+    request.padding_compression_request = std::string(value);
+  }
+  return HEADER_OK;
+}
+
+bool Http2ProxyServerSession::OnEndHeadersForStream(Http2StreamId stream_id) {
+  auto it = requests_.find(stream_id);
+  if (it == requests_.end())
+    return true;
+  Request request = std::move(it->second);
+  requests_.erase(it);
+  HandleRequest(stream_id, request);
+  return true;
+}
+
+bool Http2ProxyServerSession::OnBeginDataForStream(Http2StreamId stream_id,
+                                                   size_t payload_length) {
+  return true;
+}
+
+bool Http2ProxyServerSession::OnDataPaddingLength(Http2StreamId stream_id,
+                                                  size_t padding_length) {
+  adapter_->MarkDataConsumedForStream(stream_id, padding_length);
+  return true;
+}
+
+bool Http2ProxyServerSession::OnDataForStream(Http2StreamId stream_id,
+                                              std::string_view data) {
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end()) {
+    // Not a tunnel, or one already gone.
+    adapter_->MarkDataConsumedForStream(stream_id, data.size());
+    return true;
+  }
+  if (it->second->OnData(data))
+    readable_streams_.push_back(stream_id);
+  return true;
+}
+
+bool Http2ProxyServerSession::OnEndStream(Http2StreamId stream_id) {
+  auto it = streams_.find(stream_id);
+  if (it != streams_.end() && it->second->OnEndStream())
+    readable_streams_.push_back(stream_id);
+  return true;
+}
+
+void Http2ProxyServerSession::OnRstStream(Http2StreamId stream_id,
+                                          Http2ErrorCode error_code) {
+  auto it = streams_.find(stream_id);
+  if (it != streams_.end() && it->second->OnClosed(ERR_CONNECTION_RESET))
+    readable_streams_.push_back(stream_id);
+}
+
+bool Http2ProxyServerSession::OnCloseStream(Http2StreamId stream_id,
+                                            Http2ErrorCode error_code) {
+  requests_.erase(stream_id);
+  unsent_writes_.erase(stream_id);
+  auto it = streams_.find(stream_id);
+  if (it != streams_.end()) {
+    // Both directions ended, or the stream was reset. The stream keeps its
+    // buffered data until it is destroyed.
+    int error =
+        error_code == Http2ErrorCode::HTTP2_NO_ERROR ? OK
+                                                     : ERR_CONNECTION_RESET;
+    if (it->second->OnClosed(error))
+      readable_streams_.push_back(stream_id);
+    return true;
+  }
+  MaybeCloseAfterShutdown();
+  return true;
+}
+
+bool Http2ProxyServerSession::OnGoAway(Http2StreamId last_accepted_stream_id,
+                                       Http2ErrorCode error_code,
+                                       std::string_view opaque_data) {
+  return true;
+}
+
+int Http2ProxyServerSession::OnBeforeFrameSent(uint8_t frame_type,
+                                               Http2StreamId stream_id,
+                                               size_t length,
+                                               uint8_t flags) {
+  return 0;
+}
+
+int Http2ProxyServerSession::OnFrameSent(uint8_t frame_type,
+                                         Http2StreamId stream_id,
+                                         size_t length,
+                                         uint8_t flags,
+                                         uint32_t error_code) {
+  return 0;
+}
+
+bool Http2ProxyServerSession::OnInvalidFrame(Http2StreamId stream_id,
+                                             InvalidFrameError error) {
+  return true;
+}
+
+bool Http2ProxyServerSession::OnMetadataForStream(Http2StreamId stream_id,
+                                                  std::string_view metadata) {
+  return true;
+}
+
+bool Http2ProxyServerSession::OnMetadataEndForStream(
+    Http2StreamId stream_id) {
+  return true;
+}
+
+Http2PrefaceReader::Http2PrefaceReader(std::unique_ptr<StreamSocket> socket,
+                                       base::TimeDelta timeout,
+                                       Callback callback)
+    : socket_(std::move(socket)),
+      callback_(std::move(callback)),
+      timeout_(timeout) {}
+
+Http2PrefaceReader::~Http2PrefaceReader() = default;
+
+void Http2PrefaceReader::Start() {
+  if (timeout_.is_positive()) {
+    timer_.Start(FROM_HERE, timeout_, this, &Http2PrefaceReader::OnTimeout);
+  }
+  DoRead();
+}
+
+void Http2PrefaceReader::DoRead() {
+  while (true) {
+    // Most HTTP/1 requests fit, and are handed over whole.
+    read_buf_ = NaiveBufferPool::Acquire(NaiveBufferPool::kMinBufferSize);
+    int rv = socket_->Read(
+        read_buf_.get(), NaiveBufferPool::kMinBufferSize,
+        base::BindOnce(&Http2PrefaceReader::OnReadComplete,
+                       weak_ptr_factory_.GetWeakPtr()));
+    if (rv == ERR_IO_PENDING)
+      return;
+    if (!HandleReadResult(rv))
+      return;
+  }
+}
+
+void Http2PrefaceReader::OnReadComplete(int result) {
+  if (HandleReadResult(result))
+    DoRead();
+}
+
+bool Http2PrefaceReader::HandleReadResult(int result) {
+  if (result <= 0) {
+    timer_.Stop();
+    socket_.reset();
+    std::move(callback_).Run(nullptr, std::string(), false);
+    return false;
+  }
+  received_.append(read_buf_->data(), result);
+  read_buf_ = nullptr;
+  const std::string_view preface(spdy::kHttp2ConnectionHeaderPrefix,
+                                 spdy::kHttp2ConnectionHeaderPrefixSize);
+  size_t compared = std::min(received_.size(), preface.size());
+  bool is_http2 = std::string_view(received_).substr(0, compared) ==
+                  preface.substr(0, compared);
+  // "PRI * HTTP/2.0" is not a valid HTTP/1 request line, so a prefix of the
+  // preface is read on until it is whole.
+  if (is_http2 && received_.size() < preface.size())
+    return true;
+  timer_.Stop();
+  std::move(callback_).Run(std::move(socket_), std::move(received_),
+                           is_http2);
+  return false;
+}
+
+void Http2PrefaceReader::OnTimeout() {
+  weak_ptr_factory_.InvalidateWeakPtrs();
+  socket_.reset();
+  read_buf_ = nullptr;
+  std::move(callback_).Run(nullptr, std::string(), false);
+}
+
+}  // namespace net
@@ -0,0 +1,407 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_HTTP2_PROXY_SERVER_SESSION_H_
+#define NET_TOOLS_NAIVE_HTTP2_PROXY_SERVER_SESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base/functional/callback.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/completion_once_callback.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/io_buffer.h"
+#include "net/log/net_log_with_source.h"
+#include "net/socket/next_proto.h"
+#include "net/socket/stream_socket.h"
+#include "net/third_party/quiche/src/quiche/http2/adapter/http2_visitor_interface.h"
+#include "net/third_party/quiche/src/quiche/http2/adapter/oghttp2_adapter.h"
+#include "net/tools/naive/naive_protocol.h"
+#include "net/tools/naive/naive_user_table.h"
+
+namespace net {
+
+class SSLServerContext;
+class SSLServerSocket;
+struct NetworkTrafficAnnotationTag;
+
+// Returns the context of an https listener serving the certificate chain
+// and private key in `cert_pem` and `key_pem`, with ALPN h2 only. Returns
+// null if they cannot be parsed.
+std::unique_ptr<SSLServerContext> CreateHttp2ProxySSLServerContext(
+    std::string_view cert_pem,
+    std::string_view key_pem);
+
+class Http2ProxyServerSession;
+
+// The client side of a tunnel: a CONNECT stream of an
+// Http2ProxyServerSession, already answered with 200. Reads return the DATA
+// of the stream and 0 after its END_STREAM. ShutdownWrite() ends the stream
+// once the buffered writes are sent. Destroying it before the stream closes
+// resets the stream.
+class Http2ProxyServerStream : public StreamSocket {
+ public:
+  Http2ProxyServerStream(base::WeakPtr<Http2ProxyServerSession> session,
+                         http2::adapter::Http2StreamId stream_id,
+                         const HostPortPair& request_endpoint,
+                         const std::string& user,
+                         PaddingType padding_type,
+                         const PaddingLimits& padding_limits,
+                         const NetLogWithSource& net_log);
+  Http2ProxyServerStream(const Http2ProxyServerStream&) = delete;
+  Http2ProxyServerStream& operator=(const Http2ProxyServerStream&) = delete;
+  ~Http2ProxyServerStream() override;
+
+  const HostPortPair& request_endpoint() const { return request_endpoint_; }
+  // The user the CONNECT request authenticated as, or empty.
+  const std::string& user() const { return user_; }
+
+  // Negotiated with the padding headers of the CONNECT request.
+  PaddingType padding_type() const { return padding_type_; }
+  const PaddingLimits& padding_limits() const { return padding_limits_; }
+
+  // StreamSocket implementation.
+  int Connect(CompletionOnceCallback callback) override;
+  void Disconnect() override;
+  int ShutdownWrite() override;
+  bool IsConnected() const override;
+  bool IsConnectedAndIdle() const override;
+  const NetLogWithSource& NetLog() const override;
+  bool WasEverUsed() const override;
+  NextProto GetNegotiatedProtocol() const override;
+  bool GetSSLInfo(SSLInfo* ssl_info) override;
+  int64_t GetTotalReceivedBytes() const override;
+  void ApplySocketTag(const SocketTag& tag) override;
+
+  // Socket implementation.
+  int Read(IOBuffer* buf,
+           int buf_len,
+           CompletionOnceCallback callback) override;
+  int ReadIfReady(IOBuffer* buf,
+                  int buf_len,
+                  CompletionOnceCallback callback) override;
+  int CancelReadIfReady() override;
+  int Write(IOBuffer* buf,
+            int buf_len,
+            CompletionOnceCallback callback,
+            const NetworkTrafficAnnotationTag& traffic_annotation) override;
+  int SetReceiveBufferSize(int32_t size) override;
+  int SetSendBufferSize(int32_t size) override;
+  int GetPeerAddress(IPEndPoint* address) const override;
+  int GetLocalAddress(IPEndPoint* address) const override;
+
+ private:
+  friend class Http2ProxyServerSession;
+
+  // Bytes buffered by Write() before it waits for them to be sent.
+  static constexpr size_t kMaxWriteBufferSize = 64 * 1024;
+
+  // Called by the session. These return true if a reader waits for
+  // OnReadable().
+  bool OnData(std::string_view data);
+  bool OnEndStream();
+  bool OnClosed(int error);
+  void OnReadable();
+  // Returns true if a reader waits and is not yet due for OnReadable().
+  bool MarkReadable();
+
+  bool has_write_data() const;
+  // Returns the length and end of the next DATA frame of at most
+  // `max_length` bytes.
+  http2::adapter::Http2VisitorInterface::DataFrameHeaderInfo
+  GetDataFrameInfo(size_t max_length) const;
+  // Moves `length` bytes of the buffered writes to `out`.
+  void TakeWriteData(size_t length, std::string* out);
+
+  int ReadBuffered(IOBuffer* buf, int buf_len);
+  void CompletePendingWrite();
+
+  base::WeakPtr<Http2ProxyServerSession> session_;
+  const http2::adapter::Http2StreamId stream_id_;
+  const HostPortPair request_endpoint_;
+  const std::string user_;
+  const PaddingType padding_type_;
+  const PaddingLimits padding_limits_;
+  NetLogWithSource net_log_;
+
+  // Received data, read up to read_offset_.
+  std::string read_buffer_;
+  size_t read_offset_ = 0;
+  bool read_eof_ = false;
+  // Set when the stream or its session closed, with the result of later
+  // reads and writes.
+  int error_ = OK;
+  // Set once the session no longer has the stream.
+  bool stream_closed_ = false;
+  bool read_notify_pending_ = false;
+  scoped_refptr<IOBuffer> read_buf_;
+  int read_buf_len_ = 0;
+  CompletionOnceCallback read_callback_;
+  // Whether read_callback_ is of ReadIfReady().
+  bool read_if_ready_ = false;
+
+  std::string write_buffer_;
+  bool write_fin_ = false;
+  scoped_refptr<IOBuffer> write_buf_;
+  int write_buf_len_ = 0;
+  CompletionOnceCallback write_callback_;
+
+  int64_t total_received_bytes_ = 0;
+  bool was_ever_used_ = false;
+
+  base::WeakPtrFactory<Http2ProxyServerStream> weak_ptr_factory_{this};
+};
+
+// The server side of an HTTP/2 connection from a proxy client, over TLS
+// for https listeners, or in cleartext with prior knowledge (h2c) for http
+// listeners with the h2c option.
+// Each CONNECT stream with the credentials of the listener is answered with
+// 200 and the padding headers, as HttpProxyServerSocket answers a CONNECT
+// before its tunnel connects, and handed out as an Http2ProxyServerStream.
+// Other requests get 404, as from a web server.
+class Http2ProxyServerSession : public http2::adapter::Http2VisitorInterface {
+ public:
+  using StreamCallback =
+      base::RepeatingCallback<void(std::unique_ptr<Http2ProxyServerStream>)>;
+
+  // Runs `stream_callback` for each tunnel, and `close_callback` once the
+  // connection closes, from a task of its own. Open streams then fail
+  // their reads and writes.
+  Http2ProxyServerSession(
+      std::unique_ptr<StreamSocket> socket,
+      scoped_refptr<const NaiveUserTable> users,
+      const std::vector<PaddingType>& supported_padding_types,
+      const PaddingLimits& padding_limits,
+      const NetworkTrafficAnnotationTag& traffic_annotation,
+      StreamCallback stream_callback,
+      base::OnceClosure close_callback);
+  Http2ProxyServerSession(const Http2ProxyServerSession&) = delete;
+  Http2ProxyServerSession& operator=(const Http2ProxyServerSession&) = delete;
+  ~Http2ProxyServerSession() override;
+
+  // Starts the TLS handshake. `socket` must be an SSLServerSocket.
+  void Start();
+  // Starts HTTP/2 over a cleartext `socket`, from which the client bytes
+  // `received` were already read, starting with the connection preface.
+  void StartCleartext(std::string_view received);
+
+  // Sends GOAWAY and closes the connection once its streams have closed.
+  void Shutdown();
+
+  // http2::adapter::Http2VisitorInterface:
+  int64_t OnReadyToSend(std::string_view serialized) override;
+  DataFrameHeaderInfo OnReadyToSendDataForStream(
+      http2::adapter::Http2StreamId stream_id,
+      size_t max_length) override;
+  bool SendDataFrame(http2::adapter::Http2StreamId stream_id,
+                     std::string_view frame_header,
+                     size_t payload_bytes) override;
+  void OnConnectionError(ConnectionError error) override;
+  bool OnFrameHeader(http2::adapter::Http2StreamId stream_id,
+                     size_t length,
+                     uint8_t type,
+                     uint8_t flags) override;
+  void OnSettingsStart() override {}
+  void OnSetting(http2::adapter::Http2Setting setting) override {}
+  void OnSettingsEnd() override {}
+  void OnSettingsAck() override {}
+  bool OnBeginHeadersForStream(
+      http2::adapter::Http2StreamId stream_id) override;
+  OnHeaderResult OnHeaderForStream(http2::adapter::Http2StreamId stream_id,
+                                   std::string_view key,
+                                   std::string_view value) override;
+  bool OnEndHeadersForStream(http2::adapter::Http2StreamId stream_id) override;
+  bool OnBeginDataForStream(http2::adapter::Http2StreamId stream_id,
+                            size_t payload_length) override;
+  bool OnDataPaddingLength(http2::adapter::Http2StreamId stream_id,
+                           size_t padding_length) override;
+  bool OnDataForStream(http2::adapter::Http2StreamId stream_id,
+                       std::string_view data) override;
+  bool OnEndStream(http2::adapter::Http2StreamId stream_id) override;
+  void OnRstStream(http2::adapter::Http2StreamId stream_id,
+                   http2::adapter::Http2ErrorCode error_code) override;
+  bool OnCloseStream(http2::adapter::Http2StreamId stream_id,
+                     http2::adapter::Http2ErrorCode error_code) override;
+  void OnPriorityForStream(http2::adapter::Http2StreamId stream_id,
+                           http2::adapter::Http2StreamId parent_stream_id,
+                           int weight,
+                           bool exclusive) override {}
+  void OnPing(http2::adapter::Http2PingId ping_id, bool is_ack) override {}
+  void OnPushPromiseForStream(
+      http2::adapter::Http2StreamId stream_id,
+      http2::adapter::Http2StreamId promised_stream_id) override {}
+  bool OnGoAway(http2::adapter::Http2StreamId last_accepted_stream_id,
+                http2::adapter::Http2ErrorCode error_code,
+                std::string_view opaque_data) override;
+  void OnWindowUpdate(http2::adapter::Http2StreamId stream_id,
+                      int window_increment) override {}
+  int OnBeforeFrameSent(uint8_t frame_type,
+                        http2::adapter::Http2StreamId stream_id,
+                        size_t length,
+                        uint8_t flags) override;
+  int OnFrameSent(uint8_t frame_type,
+                  http2::adapter::Http2StreamId stream_id,
+                  size_t length,
+                  uint8_t flags,
+                  uint32_t error_code) override;
+  bool OnInvalidFrame(http2::adapter::Http2StreamId stream_id,
+                      InvalidFrameError error) override;
+  void OnBeginMetadataForStream(http2::adapter::Http2StreamId stream_id,
+                                size_t payload_length) override {}
+  bool OnMetadataForStream(http2::adapter::Http2StreamId stream_id,
+                           std::string_view metadata) override;
+  bool OnMetadataEndForStream(http2::adapter::Http2StreamId stream_id) override;
+  void OnErrorDebug(std::string_view message) override {}
+
+ private:
+  friend class Http2ProxyServerStream;
+
+  // Matches the receive windows of SpdySession.
+  static constexpr int32_t kStreamWindowSize = 6 * 1024 * 1024;
+  static constexpr int32_t kSessionWindowSize = 15 * 1024 * 1024;
+  static constexpr uint32_t kMaxConcurrentStreams = 1024;
+  static constexpr int kReadBufferSize = 32 * 1024;
+  // Reads handled in one task before yielding to the tunnels.
+  static constexpr int kMaxReadsPerTask = 8;
+  // Serialized frames buffered while the socket is writing.
+  static constexpr size_t kMaxWriteBufferSize = 64 * 1024;
+
+  // Headers of a request that the proxy acts on.
+  struct Request {
+    std::string method;
+    std::string authority;
+    std::optional<std::string> proxy_authorization;
+    bool has_padding = false;
+    std::optional<std::string> padding_type_request;
+    std::optional<std::string> padding_compression_request;
+  };
+
+  void OnHandshakeComplete(int result);
+  // Creates the adapter and queues the server SETTINGS.
+  void StartHttp2();
+
+  void DoRead();
+  void OnReadComplete(int result);
+  // Returns false if reading stops.
+  bool HandleReadResult(int result);
+  bool ProcessReceived(std::string_view remaining);
+
+  // Answers the request of `stream_id`, adding its tunnel to new_streams_.
+  void HandleRequest(http2::adapter::Http2StreamId stream_id,
+                     const Request& request);
+  void SendResponse(http2::adapter::Http2StreamId stream_id,
+                    std::string_view status,
+                    std::string_view padding_type_reply,
+                    bool end_stream);
+
+  // Hands out new streams and notifies the waiting readers, outside the
+  // callbacks of the adapter.
+  void RunStreamCallbacks();
+
+  // Called by the streams.
+  void ConsumeData(http2::adapter::Http2StreamId stream_id, size_t length);
+  void ResumeStream(http2::adapter::Http2StreamId stream_id);
+  // Resets the stream if `reset`, or else sends `unsent_writes` and ends it
+  // if given.
+  void OnStreamDestroyed(http2::adapter::Http2StreamId stream_id,
+                         bool reset,
+                         std::optional<std::string> unsent_writes);
+  int GetPeerAddress(IPEndPoint* address) const;
+  int GetLocalAddress(IPEndPoint* address) const;
+
+  // Sends what the adapter has, then writes it out.
+  void MaybeSend();
+  void DoWrite();
+  void OnWriteComplete(int result);
+  // Returns false if writing stops.
+  bool HandleWriteResult(int result);
+
+  void MaybeCloseAfterShutdown();
+  void Close(int error);
+  void DoClose();
+
+  std::unique_ptr<StreamSocket> socket_;
+  const scoped_refptr<const NaiveUserTable> users_;
+  const std::vector<PaddingType> supported_padding_types_;
+  // Offered with kVariant2.
+  const PaddingLimits padding_limits_;
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+  StreamCallback stream_callback_;
+  base::OnceClosure close_callback_;
+  NetLogWithSource net_log_;
+
+  std::unique_ptr<http2::adapter::OgHttp2Adapter> adapter_;
+  std::map<http2::adapter::Http2StreamId, Request> requests_;
+  std::map<http2::adapter::Http2StreamId, Http2ProxyServerStream*> streams_;
+  std::vector<std::unique_ptr<Http2ProxyServerStream>> new_streams_;
+  // Writes of ended streams destroyed before they were sent.
+  std::map<http2::adapter::Http2StreamId, std::string> unsent_writes_;
+  std::vector<http2::adapter::Http2StreamId> readable_streams_;
+  // The last stream the client opened.
+  http2::adapter::Http2StreamId last_stream_id_ = 0;
+
+  scoped_refptr<IOBufferWithSize> read_buf_;
+  // Frames not yet given to the socket.
+  std::string write_buffer_;
+  scoped_refptr<DrainableIOBuffer> write_buf_;
+  bool write_pending_ = false;
+  // Set when frames were held back for a full write_buffer_.
+  bool send_blocked_ = false;
+  bool sending_ = false;
+  bool shutting_down_ = false;
+  bool closed_ = false;
+  int close_error_ = OK;
+
+  base::WeakPtrFactory<Http2ProxyServerSession> weak_ptr_factory_{this};
+};
+
+// Reads the first bytes of a connection to an http listener with the h2c
+// option until they tell the HTTP/2 connection preface from an HTTP/1
+// request.
+class Http2PrefaceReader {
+ public:
+  // Gets the socket back with the bytes read from it, or null if it failed
+  // or sent nothing within the timeout.
+  using Callback = base::OnceCallback<void(std::unique_ptr<StreamSocket>,
+                                           std::string received,
+                                           bool is_http2)>;
+
+  // A zero `timeout` disables the timeout.
+  Http2PrefaceReader(std::unique_ptr<StreamSocket> socket,
+                     base::TimeDelta timeout,
+                     Callback callback);
+  Http2PrefaceReader(const Http2PrefaceReader&) = delete;
+  Http2PrefaceReader& operator=(const Http2PrefaceReader&) = delete;
+  ~Http2PrefaceReader();
+
+  void Start();
+
+ private:
+  void DoRead();
+  void OnReadComplete(int result);
+  // Returns false once the callback has run.
+  bool HandleReadResult(int result);
+  void OnTimeout();
+
+  std::unique_ptr<StreamSocket> socket_;
+  Callback callback_;
+  scoped_refptr<IOBuffer> read_buf_;
+  std::string received_;
+  base::TimeDelta timeout_;
+  base::OneShotTimer timer_;
+
+  base::WeakPtrFactory<Http2PrefaceReader> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_HTTP2_PROXY_SERVER_SESSION_H_
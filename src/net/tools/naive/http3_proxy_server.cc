@@ -0,0 +1,919 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/http3_proxy_server.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <utility>
+
+#include "base/check.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/rand_util.h"
+#include "base/task/single_thread_task_runner.h"
+#include "net/base/net_errors.h"
+#include "net/http/http_request_headers.h"
+#include "net/quic/address_utils.h"
+#include "net/quic/platform/impl/quic_chromium_clock.h"
+#include "net/quic/quic_chromium_alarm_factory.h"
+#include "net/quic/quic_chromium_connection_helper.h"
+#include "net/socket/udp_server_socket.h"
+#include "net/third_party/quiche/src/quiche/quic/core/crypto/certificate_view.h"
+#include "net/third_party/quiche/src/quiche/quic/core/crypto/proof_source_x509.h"
+#include "net/third_party/quiche/src/quiche/quic/core/crypto/quic_random.h"
+#include "net/third_party/quiche/src/quiche/quic/core/http/quic_server_session_base.h"
+#include "net/third_party/quiche/src/quiche/quic/core/http/quic_spdy_server_stream_base.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_connection.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_crypto_server_stream_base.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_dispatcher.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_packet_writer.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_packets.h"
+#include "net/third_party/quiche/src/quiche/spdy/core/http2_header_block.h"
+#include "net/tools/naive/naive_proxy_delegate.h"
+#include "net/tools/naive/naive_random.h"
+
+namespace net {
+
+namespace {
+// As the padding header of the replies of HttpProxyServerSocket.
+constexpr int kMinPaddingSize = 30;
+constexpr int kMaxPaddingSize = kMinPaddingSize + 32;
+
+// Matches Http2ProxyServerSession.
+constexpr uint32_t kMaxConcurrentStreams = 1024;
+
+// As QuicChromiumPacketWriter: the largest UDP payload, and the most
+// segments the kernel takes in one write.
+constexpr size_t kMaxBatchSize = 65507;
+constexpr int kMaxBatchPackets = 64;
+
+const quic::QuicClock* GetClock() {
+  return quic::QuicChromiumClock::GetInstance();
+}
+}  // namespace
+
+std::unique_ptr<quic::ProofSource> CreateHttp3ProxyProofSource(
+    std::string_view cert_pem,
+    std::string_view key_pem) {
+  std::istringstream cert_stream{std::string(cert_pem)};
+  std::vector<std::string> certs =
+      quic::CertificateView::LoadPemFromStream(&cert_stream);
+  if (certs.empty())
+    return nullptr;
+  std::istringstream key_stream{std::string(key_pem)};
+  std::unique_ptr<quic::CertificatePrivateKey> key =
+      quic::CertificatePrivateKey::LoadPemFromStream(&key_stream);
+  if (!key)
+    return nullptr;
+  // Fails if the key does not match the leaf.
+  return quic::ProofSourceX509::Create(
+      quiche::QuicheReferenceCountedPointer<quic::ProofSource::Chain>(
+          new quic::ProofSource::Chain(certs)),
+      std::move(*key));
+}
+
+// The request stream of a tunnel. It answers the CONNECT and then carries
+// the data of its Http3ProxyServerStream.
+class Http3ProxyRequestStream : public quic::QuicSpdyServerStreamBase {
+ public:
+  Http3ProxyRequestStream(quic::QuicStreamId id,
+                          quic::QuicSpdySession* session,
+                          Http3ProxyServer* server)
+      : quic::QuicSpdyServerStreamBase(id, session, quic::BIDIRECTIONAL),
+        server_(server) {}
+  Http3ProxyRequestStream(quic::PendingStream* pending,
+                          quic::QuicSpdySession* session,
+                          Http3ProxyServer* server)
+      : quic::QuicSpdyServerStreamBase(pending, session), server_(server) {}
+  Http3ProxyRequestStream(const Http3ProxyRequestStream&) = delete;
+  Http3ProxyRequestStream& operator=(const Http3ProxyRequestStream&) = delete;
+  ~Http3ProxyRequestStream() override {
+    if (socket_)
+      std::exchange(socket_, nullptr)->OnStreamClosed(ERR_CONNECTION_CLOSED);
+  }
+
+  // Called by the socket when it is destroyed.
+  void DetachSocket() { socket_ = nullptr; }
+
+  // quic::QuicSpdyStream:
+  void OnInitialHeadersComplete(
+      bool fin,
+      size_t frame_len,
+      const quic::QuicHeaderList& header_list) override {
+    quic::QuicSpdyServerStreamBase::OnInitialHeadersComplete(fin, frame_len,
+                                                             header_list);
+    // Invalid headers reset the stream already.
+    if (!rst_sent() && !write_side_closed())
+      HandleRequest(fin, header_list);
+    ConsumeHeaderList();
+  }
+
+  void OnBodyAvailable() override {
+    if (socket_)
+      socket_->OnStreamReadable();
+  }
+
+  void OnCanWriteNewData() override {
+    if (socket_)
+      socket_->OnStreamWritable();
+  }
+
+  void OnStreamReset(const quic::QuicRstStreamFrame& frame) override {
+    quic::QuicSpdyServerStreamBase::OnStreamReset(frame);
+    if (socket_)
+      socket_->OnStreamReadable();
+  }
+
+  bool OnStopSending(quic::QuicResetStreamError error) override {
+    bool result = quic::QuicSpdyServerStreamBase::OnStopSending(error);
+    if (socket_)
+      socket_->OnStreamWritable();
+    return result;
+  }
+
+ protected:
+  void OnClose() override {
+    if (socket_) {
+      // Both directions ended, or the stream or connection was reset.
+      int error = stream_error() == quic::QUIC_STREAM_NO_ERROR &&
+                          connection_error() == quic::QUIC_NO_ERROR
+                      ? OK
+                      : ERR_CONNECTION_RESET;
+      std::exchange(socket_, nullptr)->OnStreamClosed(error);
+    }
+    quic::QuicSpdyServerStreamBase::OnClose();
+  }
+
+ private:
+  void HandleRequest(bool fin, const quic::QuicHeaderList& header_list) {
+    std::string method;
+    std::string authority;
+    std::optional<std::string> proxy_authorization;
+    bool has_padding = false;
+    std::optional<std::string> padding_type_request;
+    std::optional<std::string> padding_compression_request;
+    // Names are lowercase in HTTP/3.
+    for (const auto& [key, value] : header_list) {
+      if (key == ":method") {
+        method = value;
+      } else if (key == ":authority") {
+        authority = value;
+      } else if (key == "proxy-authorization") {
+        proxy_authorization = value;
+      } else if (key == kPaddingHeader) {
+        has_padding = true;
+      } else if (key == kPaddingTypeRequestHeader) {
+        padding_type_request = value;
+      } else if (key == kPaddingCompressionRequestHeader) {
+        padding_compression_request = value;
+      }
+    }
+
+    // Probes get what a web server without the page would answer.
+    if (method != HttpRequestHeaders::kConnectMethod || fin) {
+      SendResponse("404", "", /*fin=*/true);
+      StopReading();
+      return;
+    }
+    const std::string* user = nullptr;
+    if (RequiresAuth(server_->users_.get())) {
+      user = server_->users_->FindByBasicAuth(proxy_authorization.value_or(""));
+      if (!user) {
+        LOG(WARNING) << "Invalid Proxy-Authorization: "
+                     << proxy_authorization.value_or("");
+        SendResponse("404", "", /*fin=*/true);
+        StopReading();
+        return;
+      }
+    }
+    std::optional<PaddingType> padding_type = SelectClientPaddingType(
+        has_padding, padding_type_request, server_->supported_padding_types_);
+    if (!padding_type.has_value()) {
+      Reset(quic::QUIC_BAD_APPLICATION_PAYLOAD);
+      return;
+    }
+    PaddingLimits padding_limits = SelectClientPaddingLimits(
+        *padding_type, padding_type_request, padding_compression_request,
+        server_->padding_limits_);
+    std::string padding_type_reply;
+    if (padding_type_request.has_value()) {
+      padding_type_reply = ToPaddingTypeReply(*padding_type, padding_limits);
+    }
+    SendResponse("200", padding_type_reply, /*fin=*/false);
+    if (rst_sent() || write_side_closed())
+      return;
+
+    auto socket = std::make_unique<Http3ProxyServerStream>(
+        this, ToIPEndPoint(spdy_session()->peer_address()),
+        ToIPEndPoint(spdy_session()->self_address()),
+        HostPortPair::FromString(authority), user ? *user : "", *padding_type,
+        padding_limits, server_->net_log_);
+    socket_ = socket.get();
+    // Not handed out from the processing of the packet.
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&Http3ProxyServer::OnStream,
+                       server_->weak_ptr_factory_.GetWeakPtr(),
+                       std::move(socket)));
+  }
+
+  void SendResponse(std::string_view status,
+                    std::string_view padding_type_reply,
+                    bool fin) {
+    int padding_size = NaiveRandInt(kMinPaddingSize, kMaxPaddingSize);
+    std::string padding(padding_size, '\0');
+    FillNonindexHeaderValue(NaiveRandUint64(), padding.data(), padding_size);
+    spdy::Http2HeaderBlock headers;
+    headers[":status"] = status;
+    headers[kPaddingHeader] = padding;
+    if (!padding_type_reply.empty())
+      headers[kPaddingTypeReplyHeader] = padding_type_reply;
+    WriteHeaders(std::move(headers), fin, nullptr);
+  }
+
+  Http3ProxyServer* const server_;
+  // Null until the CONNECT is answered, and once the socket is destroyed.
+  Http3ProxyServerStream* socket_ = nullptr;
+};
+
+Http3ProxyServerStream::Http3ProxyServerStream(
+    Http3ProxyRequestStream* stream,
+    const IPEndPoint& peer_address,
+    const IPEndPoint& local_address,
+    const HostPortPair& request_endpoint,
+    const std::string& user,
+    PaddingType padding_type,
+    const PaddingLimits& padding_limits,
+    const NetLogWithSource& net_log)
+    : stream_(stream),
+      peer_address_(peer_address),
+      local_address_(local_address),
+      request_endpoint_(request_endpoint),
+      user_(user),
+      padding_type_(padding_type),
+      padding_limits_(padding_limits),
+      net_log_(net_log) {}
+
+Http3ProxyServerStream::~Http3ProxyServerStream() {
+  Disconnect();
+}
+
+int Http3ProxyServerStream::Connect(CompletionOnceCallback callback) {
+  // The stream answered the CONNECT already.
+  return error_;
+}
+
+void Http3ProxyServerStream::Disconnect() {
+  read_buf_ = nullptr;
+  read_callback_.Reset();
+  write_buf_ = nullptr;
+  write_callback_.Reset();
+  if (stream_) {
+    Http3ProxyRequestStream* stream = std::exchange(stream_, nullptr);
+    stream->DetachSocket();
+    // Ended both ways, the rest of the writes and the FIN are still sent.
+    // Otherwise the stream is reset, which may close it right away.
+    if (!write_fin_ || !read_eof_)
+      stream->Reset(quic::QUIC_STREAM_CANCELLED);
+  }
+  if (error_ == OK)
+    error_ = ERR_SOCKET_NOT_CONNECTED;
+}
+
+int Http3ProxyServerStream::ShutdownWrite() {
+  DCHECK(!write_callback_);
+  if (error_ != OK)
+    return error_;
+  if (write_fin_)
+    return OK;
+  write_fin_ = true;
+  if (stream_ && !stream_->write_side_closed() && !stream_->fin_buffered())
+    stream_->WriteOrBufferBody("", /*fin=*/true);
+  return OK;
+}
+
+bool Http3ProxyServerStream::IsConnected() const {
+  return error_ == OK;
+}
+
+bool Http3ProxyServerStream::IsConnectedAndIdle() const {
+  return error_ == OK && stream_ && !stream_->HasBytesToRead() && !read_eof_;
+}
+
+const NetLogWithSource& Http3ProxyServerStream::NetLog() const {
+  return net_log_;
+}
+
+bool Http3ProxyServerStream::WasEverUsed() const {
+  return was_ever_used_;
+}
+
+NextProto Http3ProxyServerStream::GetNegotiatedProtocol() const {
+  return kProtoUnknown;
+}
+
+bool Http3ProxyServerStream::GetSSLInfo(SSLInfo* ssl_info) {
+  return false;
+}
+
+int64_t Http3ProxyServerStream::GetTotalReceivedBytes() const {
+  return total_received_bytes_;
+}
+
+void Http3ProxyServerStream::ApplySocketTag(const SocketTag& tag) {}
+
+int Http3ProxyServerStream::Read(IOBuffer* buf,
+                                 int buf_len,
+                                 CompletionOnceCallback callback) {
+  DCHECK(!read_callback_);
+  int rv = ReadFromStream(buf, buf_len);
+  if (rv == ERR_IO_PENDING) {
+    read_buf_ = buf;
+    read_buf_len_ = buf_len;
+    read_callback_ = std::move(callback);
+    read_if_ready_ = false;
+  }
+  return rv;
+}
+
+int Http3ProxyServerStream::ReadIfReady(IOBuffer* buf,
+                                        int buf_len,
+                                        CompletionOnceCallback callback) {
+  DCHECK(!read_callback_);
+  int rv = ReadFromStream(buf, buf_len);
+  if (rv == ERR_IO_PENDING) {
+    read_callback_ = std::move(callback);
+    read_if_ready_ = true;
+  }
+  return rv;
+}
+
+int Http3ProxyServerStream::CancelReadIfReady() {
+  DCHECK(read_if_ready_ || !read_callback_);
+  read_callback_.Reset();
+  return OK;
+}
+
+int Http3ProxyServerStream::Write(
+    IOBuffer* buf,
+    int buf_len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  DCHECK(!write_callback_);
+  DCHECK(!write_fin_);
+  int rv = WriteToStream(buf, buf_len);
+  if (rv == ERR_IO_PENDING) {
+    write_buf_ = buf;
+    write_buf_len_ = buf_len;
+    write_callback_ = std::move(callback);
+  }
+  return rv;
+}
+
+int Http3ProxyServerStream::SetReceiveBufferSize(int32_t size) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int Http3ProxyServerStream::SetSendBufferSize(int32_t size) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int Http3ProxyServerStream::GetPeerAddress(IPEndPoint* address) const {
+  if (error_ != OK)
+    return ERR_SOCKET_NOT_CONNECTED;
+  *address = peer_address_;
+  return OK;
+}
+
+int Http3ProxyServerStream::GetLocalAddress(IPEndPoint* address) const {
+  if (error_ != OK)
+    return ERR_SOCKET_NOT_CONNECTED;
+  *address = local_address_;
+  return OK;
+}
+
+void Http3ProxyServerStream::OnStreamReadable() {
+  if (!read_callback_ || read_notify_pending_)
+    return;
+  read_notify_pending_ = true;
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&Http3ProxyServerStream::DoReadCallback,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+void Http3ProxyServerStream::OnStreamWritable() {
+  if (!write_callback_ || write_notify_pending_)
+    return;
+  write_notify_pending_ = true;
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&Http3ProxyServerStream::DoWriteCallback,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+void Http3ProxyServerStream::OnStreamClosed(int error) {
+  stream_ = nullptr;
+  // Closing without an error takes reading the FIN.
+  if (error == OK) {
+    read_eof_ = true;
+  } else if (error_ == OK) {
+    error_ = error;
+  }
+  OnStreamReadable();
+  OnStreamWritable();
+}
+
+int Http3ProxyServerStream::ReadFromStream(IOBuffer* buf, int buf_len) {
+  if (read_eof_)
+    return 0;
+  if (!stream_)
+    return error_ == OK ? ERR_CONNECTION_CLOSED : error_;
+  if (stream_->rst_received())
+    return ERR_CONNECTION_RESET;
+  if (stream_->IsDoneReading()) {
+    read_eof_ = true;
+    // Closes the read side, and the stream if the FIN was sent.
+    stream_->OnFinRead();
+    return 0;
+  }
+  if (!stream_->HasBytesToRead())
+    return ERR_IO_PENDING;
+  iovec iov;
+  iov.iov_base = buf->data();
+  iov.iov_len = buf_len;
+  size_t bytes_read = stream_->Readv(&iov, 1);
+  // Since HasBytesToRead is true, Readv() must of read some data.
+  DCHECK_NE(0u, bytes_read);
+  total_received_bytes_ += bytes_read;
+  was_ever_used_ = true;
+  return static_cast<int>(bytes_read);
+}
+
+int Http3ProxyServerStream::WriteToStream(IOBuffer* buf, int buf_len) {
+  if (!stream_)
+    return error_ == OK ? ERR_CONNECTION_CLOSED : error_;
+  if (stream_->write_side_closed() || stream_->fin_buffered())
+    return ERR_CONNECTION_RESET;
+  // Waits for the send buffer to drain below its threshold.
+  if (!stream_->CanWriteNewData())
+    return ERR_IO_PENDING;
+  was_ever_used_ = true;
+  stream_->WriteOrBufferBody(std::string_view(buf->data(), buf_len),
+                             /*fin=*/false);
+  return buf_len;
+}
+
+void Http3ProxyServerStream::DoReadCallback() {
+  read_notify_pending_ = false;
+  if (!read_callback_)
+    return;
+  int rv;
+  if (read_if_ready_) {
+    rv = OK;
+  } else {
+    rv = ReadFromStream(read_buf_.get(), read_buf_len_);
+    if (rv == ERR_IO_PENDING)
+      return;
+    read_buf_ = nullptr;
+  }
+  std::move(read_callback_).Run(rv);
+}
+
+void Http3ProxyServerStream::DoWriteCallback() {
+  write_notify_pending_ = false;
+  if (!write_callback_)
+    return;
+  int rv = WriteToStream(write_buf_.get(), write_buf_len_);
+  if (rv == ERR_IO_PENDING)
+    return;
+  write_buf_ = nullptr;
+  std::move(write_callback_).Run(rv);
+}
+
+class Http3ProxyServer::Session : public quic::QuicServerSessionBase {
+ public:
+  Session(Http3ProxyServer* server,
+          const quic::QuicConfig& config,
+          const quic::ParsedQuicVersionVector& supported_versions,
+          quic::QuicConnection* connection,
+          quic::QuicSession::Visitor* visitor,
+          quic::QuicCryptoServerStreamBase::Helper* helper,
+          const quic::QuicCryptoServerConfig* crypto_config,
+          quic::QuicCompressedCertsCache* compressed_certs_cache)
+      : quic::QuicServerSessionBase(config,
+                                    supported_versions,
+                                    connection,
+                                    visitor,
+                                    helper,
+                                    crypto_config,
+                                    compressed_certs_cache),
+        server_(server) {
+    server_->sessions_.insert(this);
+  }
+  Session(const Session&) = delete;
+  Session& operator=(const Session&) = delete;
+  ~Session() override { server_->sessions_.erase(this); }
+
+ protected:
+  // quic::QuicServerSessionBase:
+  std::unique_ptr<quic::QuicCryptoServerStreamBase>
+  CreateQuicCryptoServerStream(
+      const quic::QuicCryptoServerConfig* crypto_config,
+      quic::QuicCompressedCertsCache* compressed_certs_cache) override {
+    return quic::CreateCryptoServerStream(crypto_config, compressed_certs_cache,
+                                          this, stream_helper());
+  }
+
+  // quic::QuicSpdySession:
+  quic::QuicSpdyStream* CreateIncomingStream(quic::QuicStreamId id) override {
+    if (!ShouldCreateIncomingStream(id))
+      return nullptr;
+    auto* stream = new Http3ProxyRequestStream(id, this, server_);
+    ActivateStream(base::WrapUnique(stream));
+    return stream;
+  }
+  quic::QuicSpdyStream* CreateIncomingStream(
+      quic::PendingStream* pending) override {
+    auto* stream = new Http3ProxyRequestStream(pending, this, server_);
+    ActivateStream(base::WrapUnique(stream));
+    return stream;
+  }
+  // The server opens no request streams of its own.
+  quic::QuicSpdyStream* CreateOutgoingBidirectionalStream() override {
+    return nullptr;
+  }
+  quic::QuicSpdyStream* CreateOutgoingUnidirectionalStream() override {
+    return nullptr;
+  }
+
+ private:
+  Http3ProxyServer* const server_;
+};
+
+class Http3ProxyServer::SessionHelper
+    : public quic::QuicCryptoServerStreamBase::Helper {
+ public:
+  bool CanAcceptClientHello(const quic::CryptoHandshakeMessage& message,
+                            const quic::QuicSocketAddress& client_address,
+                            const quic::QuicSocketAddress& peer_address,
+                            const quic::QuicSocketAddress& self_address,
+                            std::string* error_details) const override {
+    return true;
+  }
+};
+
+class Http3ProxyServer::Dispatcher : public quic::QuicDispatcher {
+ public:
+  Dispatcher(Http3ProxyServer* server,
+             const quic::QuicConfig* config,
+             const quic::QuicCryptoServerConfig* crypto_config,
+             quic::QuicVersionManager* version_manager,
+             quic::ConnectionIdGeneratorInterface& connection_id_generator)
+      : quic::QuicDispatcher(
+            config,
+            crypto_config,
+            version_manager,
+            std::make_unique<QuicChromiumConnectionHelper>(
+                GetClock(),
+                quic::QuicRandom::GetInstance()),
+            std::make_unique<SessionHelper>(),
+            std::make_unique<QuicChromiumAlarmFactory>(
+                base::SingleThreadTaskRunner::GetCurrentDefault().get(),
+                GetClock()),
+            quic::kQuicDefaultConnectionIdLength,
+            connection_id_generator),
+        server_(server) {}
+
+ protected:
+  // quic::QuicDispatcher:
+  std::unique_ptr<quic::QuicSession> CreateQuicSession(
+      quic::QuicConnectionId server_connection_id,
+      const quic::QuicSocketAddress& self_address,
+      const quic::QuicSocketAddress& peer_address,
+      std::string_view alpn,
+      const quic::ParsedQuicVersion& version,
+      const quic::ParsedClientHello& parsed_chlo,
+      quic::ConnectionIdGeneratorInterface& connection_id_generator) override {
+    // The session takes ownership of the connection.
+    auto* connection = new quic::QuicConnection(
+        server_connection_id, self_address, peer_address, helper(),
+        alarm_factory(), writer(), /*owns_writer=*/false,
+        quic::Perspective::IS_SERVER, quic::ParsedQuicVersionVector{version},
+        connection_id_generator);
+    auto session = std::make_unique<Session>(
+        server_, config(), GetSupportedVersions(), connection, this,
+        session_helper(), crypto_config(), compressed_certs_cache());
+    session->Initialize();
+    return session;
+  }
+
+ private:
+  Http3ProxyServer* const server_;
+};
+
+// Writes the packets of all connections. Packets of the same size to the
+// same peer are buffered back to back and written with one GSO write, as
+// QuicChromiumPacketWriter does for a client connection.
+class Http3ProxyServer::PacketWriter : public quic::QuicPacketWriter {
+ public:
+  PacketWriter(UDPServerSocket* socket, quic::QuicDispatcher* dispatcher)
+      : socket_(socket),
+        dispatcher_(dispatcher),
+        batch_mode_(socket->SupportsSegmentedWrites()) {}
+  PacketWriter(const PacketWriter&) = delete;
+  PacketWriter& operator=(const PacketWriter&) = delete;
+
+  // quic::QuicPacketWriter:
+  quic::WriteResult WritePacket(
+      const char* buffer,
+      size_t buf_len,
+      const quic::QuicIpAddress& self_address,
+      const quic::QuicSocketAddress& peer_address,
+      quic::PerPacketOptions* options,
+      const quic::QuicPacketWriterParams& params) override {
+    DCHECK(!IsWriteBlocked());
+    IPEndPoint peer = ToIPEndPoint(peer_address);
+    // A packet of another peer, a packet longer than the segments, or one
+    // that does not fit starts a new batch. If the flush blocks, the
+    // connection keeps the packet.
+    if (batch_packets_ > 0 &&
+        (peer != batch_peer_address_ || buf_len > batch_segment_size_ ||
+         batch_size_ + buf_len > kMaxBatchSize)) {
+      quic::WriteResult result = FlushBatch();
+      if (result.status != quic::WRITE_STATUS_OK)
+        return result;
+    }
+
+    PrepareBatchBuffer();
+    // |buffer| is at the end of the batch if it came from
+    // GetNextWriteLocation(), and may overlap it after a flush.
+    char* location = batch_buf_->data() + batch_size_;
+    if (buffer != location)
+      std::memmove(location, buffer, buf_len);
+    if (batch_packets_ == 0) {
+      batch_segment_size_ = buf_len;
+      batch_peer_address_ = peer;
+    }
+    batch_size_ += buf_len;
+    ++batch_packets_;
+
+    if (batch_mode_ && buf_len == batch_segment_size_ &&
+        batch_packets_ < kMaxBatchPackets &&
+        batch_size_ + batch_segment_size_ <= kMaxBatchSize) {
+      return quic::WriteResult(quic::WRITE_STATUS_OK, 0);
+    }
+    quic::WriteResult result = FlushBatch();
+    // The packet is part of the write in flight.
+    if (result.status == quic::WRITE_STATUS_BLOCKED)
+      result.status = quic::WRITE_STATUS_BLOCKED_DATA_BUFFERED;
+    return result;
+  }
+
+  bool IsWriteBlocked() const override { return write_pending_; }
+
+  // The dispatcher calls this for each blocked connection it resumes, so
+  // writing resumes only once the write in flight completes.
+  void SetWritable() override {}
+
+  std::optional<int> MessageTooBigErrorCode() const override {
+    return ERR_MSG_TOO_BIG;
+  }
+
+  quic::QuicByteCount GetMaxPacketSize(
+      const quic::QuicSocketAddress& peer_address) const override {
+    return quic::kMaxOutgoingPacketSize;
+  }
+
+  bool SupportsReleaseTime() const override { return false; }
+
+  bool IsBatchMode() const override { return batch_mode_; }
+
+  bool SupportsEcn() const override { return false; }
+
+  quic::QuicPacketBuffer GetNextWriteLocation(
+      const quic::QuicIpAddress& self_address,
+      const quic::QuicSocketAddress& peer_address) override {
+    if (!batch_mode_ || IsWriteBlocked())
+      return {nullptr, nullptr};
+    PrepareBatchBuffer();
+    // Packets are written here only if one of any size still fits.
+    if (batch_size_ + quic::kMaxOutgoingPacketSize > kMaxBatchSize)
+      return {nullptr, nullptr};
+    return {batch_buf_->data() + batch_size_, nullptr};
+  }
+
+  quic::WriteResult Flush() override { return FlushBatch(); }
+
+ private:
+  // Makes batch_buf_ free for a batch, unless one is being buffered.
+  void PrepareBatchBuffer() {
+    if (batch_packets_ > 0)
+      return;
+    // A write in flight holds the buffer of its batch.
+    if (!batch_buf_ || !batch_buf_->HasOneRef())
+      batch_buf_ = base::MakeRefCounted<IOBufferWithSize>(kMaxBatchSize);
+  }
+
+  // Writes the packets buffered in batch_buf_ and starts a new batch.
+  quic::WriteResult FlushBatch() {
+    if (batch_packets_ == 0)
+      return quic::WriteResult(quic::WRITE_STATUS_OK, 0);
+    int size = static_cast<int>(batch_size_);
+    int segment_size =
+        batch_packets_ > 1 ? static_cast<int>(batch_segment_size_) : 0;
+    batch_size_ = 0;
+    batch_segment_size_ = 0;
+    batch_packets_ = 0;
+    auto callback = base::BindOnce(&PacketWriter::OnWriteComplete,
+                                   weak_ptr_factory_.GetWeakPtr());
+    int rv;
+    if (segment_size > 0) {
+      rv = socket_->SendToSegmented(batch_buf_.get(), size, segment_size,
+                                    batch_peer_address_, std::move(callback));
+    } else {
+      rv = socket_->SendTo(batch_buf_.get(), size, batch_peer_address_,
+                           std::move(callback));
+    }
+    if (rv == ERR_IO_PENDING) {
+      // The write in flight holds the packets, so nothing is left to buffer.
+      write_pending_ = true;
+      return quic::WriteResult(quic::WRITE_STATUS_BLOCKED, ERR_IO_PENDING);
+    }
+    if (rv < 0)
+      return quic::WriteResult(quic::WRITE_STATUS_ERROR, rv);
+    return quic::WriteResult(quic::WRITE_STATUS_OK, rv);
+  }
+
+  void OnWriteComplete(int rv) {
+    DCHECK_NE(rv, ERR_IO_PENDING);
+    write_pending_ = false;
+    // Connections learn of errors from their later writes.
+    dispatcher_->OnCanWrite();
+  }
+
+  UDPServerSocket* const socket_;
+  quic::QuicDispatcher* const dispatcher_;
+  const bool batch_mode_;
+  scoped_refptr<IOBufferWithSize> batch_buf_;
+  // The batch being buffered in batch_buf_. All its packets are
+  // batch_segment_size_ bytes except possibly the last.
+  size_t batch_size_ = 0;
+  size_t batch_segment_size_ = 0;
+  int batch_packets_ = 0;
+  IPEndPoint batch_peer_address_;
+  bool write_pending_ = false;
+
+  base::WeakPtrFactory<PacketWriter> weak_ptr_factory_{this};
+};
+
+Http3ProxyServer::Http3ProxyServer(
+    std::unique_ptr<UDPServerSocket> socket,
+    std::unique_ptr<quic::ProofSource> proof_source,
+    const quic::QuicConfig& config)
+    : socket_(std::move(socket)),
+      config_(config),
+      version_manager_(quic::CurrentSupportedHttp3Versions()),
+      // Source address tokens only matter for QUIC crypto, not TLS.
+      crypto_config_(base::RandBytesAsString(32),
+                     quic::QuicRandom::GetInstance(),
+                     std::move(proof_source),
+                     quic::KeyExchangeSource::Default()),
+      connection_id_generator_(quic::kQuicDefaultConnectionIdLength),
+      net_log_(socket_->NetLog()),
+      read_buf_(base::MakeRefCounted<IOBufferWithSize>(kReadBufferSize)) {
+  config_.SetMaxBidirectionalStreamsToSend(kMaxConcurrentStreams);
+  socket_->GetLocalAddress(&local_address_);
+  dispatcher_ = std::make_unique<Dispatcher>(this, &config_, &crypto_config_,
+                                             &version_manager_,
+                                             connection_id_generator_);
+  // The dispatcher owns the writer.
+  dispatcher_->InitializeWithWriter(
+      new PacketWriter(socket_.get(), dispatcher_.get()));
+}
+
+Http3ProxyServer::~Http3ProxyServer() {
+  // The sessions remove themselves from sessions_.
+  dispatcher_.reset();
+}
+
+void Http3ProxyServer::Start(
+    scoped_refptr<const NaiveUserTable> users,
+    const std::vector<PaddingType>& supported_padding_types,
+    const PaddingLimits& padding_limits,
+    StreamCallback stream_callback) {
+  SetAuth(std::move(users));
+  supported_padding_types_ = supported_padding_types;
+  padding_limits_ = padding_limits;
+  stream_callback_ = std::move(stream_callback);
+  coalesced_reads_ = socket_->EnableCoalescedReads() == OK;
+  DoRead();
+}
+
+void Http3ProxyServer::SetAuth(scoped_refptr<const NaiveUserTable> users) {
+  users_ = std::move(users);
+}
+
+void Http3ProxyServer::Shutdown() {
+  if (shutting_down_)
+    return;
+  shutting_down_ = true;
+  dispatcher_->StopAcceptingNewConnections();
+  for (Session* session : sessions_) {
+    if (session->connection()->connected())
+      session->SendHttp3GoAway(quic::QUIC_PEER_GOING_AWAY, "Server shutdown");
+  }
+}
+
+void Http3ProxyServer::DoRead() {
+  // Connections of buffered handshakes are set up once per task.
+  dispatcher_->ProcessBufferedChlos(kMaxChlosPerRead);
+  for (int reads = 0;; ++reads) {
+    if (reads == kMaxReadsPerTask) {
+      base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+          FROM_HERE, base::BindOnce(&Http3ProxyServer::DoRead,
+                                    weak_ptr_factory_.GetWeakPtr()));
+      return;
+    }
+    auto callback = base::BindOnce(&Http3ProxyServer::OnReadComplete,
+                                   weak_ptr_factory_.GetWeakPtr());
+    int rv;
+    if (coalesced_reads_) {
+      rv = socket_->RecvFromCoalesced(read_buf_.get(), read_buf_->size(),
+                                      &read_segment_size_, &read_peer_address_,
+                                      std::move(callback));
+    } else {
+      rv = socket_->RecvFrom(read_buf_.get(), read_buf_->size(),
+                             &read_peer_address_, std::move(callback));
+    }
+    if (rv == ERR_IO_PENDING) {
+      // No more packets for now, so the buffered handshakes go on in a task.
+      if (dispatcher_->HasChlosBuffered() && !chlo_task_pending_) {
+        chlo_task_pending_ = true;
+        base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+            FROM_HERE,
+            base::BindOnce(&Http3ProxyServer::ProcessBufferedChlos,
+                           weak_ptr_factory_.GetWeakPtr()));
+      }
+      return;
+    }
+    if (!HandleReadResult(rv))
+      return;
+  }
+}
+
+void Http3ProxyServer::OnReadComplete(int result) {
+  if (HandleReadResult(result))
+    DoRead();
+}
+
+bool Http3ProxyServer::HandleReadResult(int result) {
+  if (result < 0) {
+    // As QuicSimpleServer: a datagram too long for the buffer, or an ICMP
+    // error, leaves the socket usable.
+    if (result == ERR_MSG_TOO_BIG || result == ERR_CONNECTION_RESET ||
+        result == ERR_CONNECTION_REFUSED) {
+      return true;
+    }
+    LOG(ERROR) << "Read error on quic listener: "
+               << ErrorToShortString(result);
+    return false;
+  }
+  quic::QuicSocketAddress self_address = ToQuicSocketAddress(local_address_);
+  quic::QuicSocketAddress peer_address =
+      ToQuicSocketAddress(read_peer_address_);
+  quic::QuicTime now = GetClock()->Now();
+  // A coalesced read holds datagrams of read_segment_size_ bytes, the last
+  // of which may be shorter.
+  int segment_size = coalesced_reads_ && read_segment_size_ > 0
+                         ? read_segment_size_
+                         : result;
+  for (int offset = 0; offset < result; offset += segment_size) {
+    int length = std::min(segment_size, result - offset);
+    quic::QuicReceivedPacket packet(read_buf_->data() + offset, length, now,
+                                    /*owns_buffer=*/false);
+    dispatcher_->ProcessPacket(self_address, peer_address, packet);
+  }
+  return true;
+}
+
+void Http3ProxyServer::ProcessBufferedChlos() {
+  chlo_task_pending_ = false;
+  dispatcher_->ProcessBufferedChlos(kMaxChlosPerRead);
+  if (dispatcher_->HasChlosBuffered()) {
+    chlo_task_pending_ = true;
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE, base::BindOnce(&Http3ProxyServer::ProcessBufferedChlos,
+                                  weak_ptr_factory_.GetWeakPtr()));
+  }
+}
+
+void Http3ProxyServer::OnStream(
+    std::unique_ptr<Http3ProxyServerStream> stream) {
+  stream_callback_.Run(std::move(stream));
+}
+
+}  // namespace net
@@ -0,0 +1,238 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_HTTP3_PROXY_SERVER_H_
+#define NET_TOOLS_NAIVE_HTTP3_PROXY_SERVER_H_
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base/functional/callback.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "net/base/completion_once_callback.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/log/net_log_with_source.h"
+#include "net/socket/next_proto.h"
+#include "net/socket/stream_socket.h"
+#include "net/third_party/quiche/src/quiche/quic/core/crypto/proof_source.h"
+#include "net/third_party/quiche/src/quiche/quic/core/crypto/quic_crypto_server_config.h"
+#include "net/third_party/quiche/src/quiche/quic/core/deterministic_connection_id_generator.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_config.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_version_manager.h"
+#include "net/tools/naive/naive_protocol.h"
+#include "net/tools/naive/naive_user_table.h"
+
+namespace quic {
+class QuicDispatcher;
+}  // namespace quic
+
+namespace net {
+
+class Http3ProxyRequestStream;
+class UDPServerSocket;
+struct NetworkTrafficAnnotationTag;
+
+// Returns the proof source of a quic listener serving the certificate chain
+// and private key in `cert_pem` and `key_pem`. Returns null if they cannot
+// be parsed.
+std::unique_ptr<quic::ProofSource> CreateHttp3ProxyProofSource(
+    std::string_view cert_pem,
+    std::string_view key_pem);
+
+// The client side of a tunnel: a CONNECT stream of an HTTP/3 connection to
+// an Http3ProxyServer, already answered with 200. Reads return the body of
+// the stream and 0 after its FIN. ShutdownWrite() sends the FIN once the
+// buffered writes are sent. Destroying it before the stream closes resets
+// the stream.
+class Http3ProxyServerStream : public StreamSocket {
+ public:
+  Http3ProxyServerStream(Http3ProxyRequestStream* stream,
+                         const IPEndPoint& peer_address,
+                         const IPEndPoint& local_address,
+                         const HostPortPair& request_endpoint,
+                         const std::string& user,
+                         PaddingType padding_type,
+                         const PaddingLimits& padding_limits,
+                         const NetLogWithSource& net_log);
+  Http3ProxyServerStream(const Http3ProxyServerStream&) = delete;
+  Http3ProxyServerStream& operator=(const Http3ProxyServerStream&) = delete;
+  ~Http3ProxyServerStream() override;
+
+  const HostPortPair& request_endpoint() const { return request_endpoint_; }
+  // The user the CONNECT request authenticated as, or empty.
+  const std::string& user() const { return user_; }
+
+  // Negotiated with the padding headers of the CONNECT request.
+  PaddingType padding_type() const { return padding_type_; }
+  const PaddingLimits& padding_limits() const { return padding_limits_; }
+
+  // StreamSocket implementation.
+  int Connect(CompletionOnceCallback callback) override;
+  void Disconnect() override;
+  int ShutdownWrite() override;
+  bool IsConnected() const override;
+  bool IsConnectedAndIdle() const override;
+  const NetLogWithSource& NetLog() const override;
+  bool WasEverUsed() const override;
+  NextProto GetNegotiatedProtocol() const override;
+  bool GetSSLInfo(SSLInfo* ssl_info) override;
+  int64_t GetTotalReceivedBytes() const override;
+  void ApplySocketTag(const SocketTag& tag) override;
+
+  // Socket implementation.
+  int Read(IOBuffer* buf,
+           int buf_len,
+           CompletionOnceCallback callback) override;
+  int ReadIfReady(IOBuffer* buf,
+                  int buf_len,
+                  CompletionOnceCallback callback) override;
+  int CancelReadIfReady() override;
+  int Write(IOBuffer* buf,
+            int buf_len,
+            CompletionOnceCallback callback,
+            const NetworkTrafficAnnotationTag& traffic_annotation) override;
+  int SetReceiveBufferSize(int32_t size) override;
+  int SetSendBufferSize(int32_t size) override;
+  int GetPeerAddress(IPEndPoint* address) const override;
+  int GetLocalAddress(IPEndPoint* address) const override;
+
+ private:
+  friend class Http3ProxyRequestStream;
+
+  // Called by the stream, from the processing of packets. The callbacks of
+  // the socket run from tasks of their own.
+  void OnStreamReadable();
+  void OnStreamWritable();
+  void OnStreamClosed(int error);
+
+  int ReadFromStream(IOBuffer* buf, int buf_len);
+  int WriteToStream(IOBuffer* buf, int buf_len);
+  void DoReadCallback();
+  void DoWriteCallback();
+
+  // Null once the stream is closed.
+  Http3ProxyRequestStream* stream_;
+  const IPEndPoint peer_address_;
+  const IPEndPoint local_address_;
+  const HostPortPair request_endpoint_;
+  const std::string user_;
+  const PaddingType padding_type_;
+  const PaddingLimits padding_limits_;
+  NetLogWithSource net_log_;
+
+  bool read_eof_ = false;
+  // Set when the stream closed with an error, or the socket disconnected,
+  // with the result of later reads and writes.
+  int error_ = OK;
+  bool read_notify_pending_ = false;
+  scoped_refptr<IOBuffer> read_buf_;
+  int read_buf_len_ = 0;
+  CompletionOnceCallback read_callback_;
+  // Whether read_callback_ is of ReadIfReady().
+  bool read_if_ready_ = false;
+
+  bool write_fin_ = false;
+  bool write_notify_pending_ = false;
+  scoped_refptr<IOBuffer> write_buf_;
+  int write_buf_len_ = 0;
+  CompletionOnceCallback write_callback_;
+
+  int64_t total_received_bytes_ = 0;
+  bool was_ever_used_ = false;
+
+  base::WeakPtrFactory<Http3ProxyServerStream> weak_ptr_factory_{this};
+};
+
+// Serves HTTP/3 over a UDP socket to proxy clients. Each CONNECT stream with
+// the credentials of the listener is answered with 200 and the padding
+// headers, as Http2ProxyServerSession answers them, and handed out as an
+// Http3ProxyServerStream. Other requests get 404, as from a web server.
+//
+// Where the kernel supports it, received datagrams are coalesced with GRO
+// and packets of a connection sent back to back are written with GSO.
+class Http3ProxyServer {
+ public:
+  using StreamCallback =
+      base::RepeatingCallback<void(std::unique_ptr<Http3ProxyServerStream>)>;
+
+  Http3ProxyServer(std::unique_ptr<UDPServerSocket> socket,
+                   std::unique_ptr<quic::ProofSource> proof_source,
+                   const quic::QuicConfig& config);
+  Http3ProxyServer(const Http3ProxyServer&) = delete;
+  Http3ProxyServer& operator=(const Http3ProxyServer&) = delete;
+  ~Http3ProxyServer();
+
+  // Starts reading packets. Runs `stream_callback` for each tunnel, from a
+  // task of its own.
+  void Start(scoped_refptr<const NaiveUserTable> users,
+             const std::vector<PaddingType>& supported_padding_types,
+             const PaddingLimits& padding_limits,
+             StreamCallback stream_callback);
+
+  // Applies to streams opened from now on.
+  void SetAuth(scoped_refptr<const NaiveUserTable> users);
+
+  // Turns away new connections and sends GOAWAY on the open ones, which are
+  // served until they close.
+  void Shutdown();
+
+  bool has_sessions() const { return !sessions_.empty(); }
+
+ private:
+  friend class Http3ProxyRequestStream;
+  class Dispatcher;
+  class PacketWriter;
+  class Session;
+  class SessionHelper;
+
+  // Sized for a coalesced read of full size datagrams.
+  static constexpr int kReadBufferSize = 64 * 1024;
+  // Reads handled in one task before yielding to the tunnels.
+  static constexpr int kMaxReadsPerTask = 32;
+  // New connections set up per read of buffered handshakes.
+  static constexpr size_t kMaxChlosPerRead = 16;
+
+  void DoRead();
+  void OnReadComplete(int result);
+  // Returns false if reading stops.
+  bool HandleReadResult(int result);
+  void ProcessBufferedChlos();
+
+  void OnStream(std::unique_ptr<Http3ProxyServerStream> stream);
+
+  std::unique_ptr<UDPServerSocket> socket_;
+  IPEndPoint local_address_;
+  quic::QuicConfig config_;
+  quic::QuicVersionManager version_manager_;
+  quic::QuicCryptoServerConfig crypto_config_;
+  quic::DeterministicConnectionIdGenerator connection_id_generator_;
+  std::unique_ptr<Dispatcher> dispatcher_;
+  std::set<Session*> sessions_;
+
+  scoped_refptr<const NaiveUserTable> users_;
+  std::vector<PaddingType> supported_padding_types_;
+  // Offered with kVariant2.
+  PaddingLimits padding_limits_;
+  StreamCallback stream_callback_;
+  NetLogWithSource net_log_;
+
+  scoped_refptr<IOBufferWithSize> read_buf_;
+  IPEndPoint read_peer_address_;
+  // Size of the datagrams of a coalesced read.
+  int read_segment_size_ = 0;
+  bool coalesced_reads_ = false;
+  bool chlo_task_pending_ = false;
+  bool shutting_down_ = false;
+
+  base::WeakPtrFactory<Http3ProxyServer> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_HTTP3_PROXY_SERVER_H_
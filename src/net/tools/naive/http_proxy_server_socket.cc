@@ -11,61 +11,93 @@
 
 #include <algorithm>
 #include <cstring>
+#include <optional>
+#include <string_view>
 #include <utility>
 #include <vector>
 
-#include "base/base64.h"
 #include "base/functional/bind.h"
 #include "base/functional/callback_helpers.h"
 #include "base/logging.h"
-#include "base/rand_util.h"
-#include "base/strings/string_split.h"
+#include "base/strings/strcat.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
 #include "base/sys_byteorder.h"
 #include "net/base/ip_address.h"
 #include "net/base/net_errors.h"
 #include "net/base/url_util.h"
 #include "net/http/http_request_headers.h"
+#include "net/http/http_util.h"
 #include "net/log/net_log.h"
 #include "net/third_party/quiche/src/quiche/spdy/core/hpack/hpack_constants.h"
+#include "net/tools/naive/naive_buffer_pool.h"
+#include "net/tools/naive/naive_http_cache.h"
 #include "net/tools/naive/naive_protocol.h"
 #include "net/tools/naive/naive_proxy_delegate.h"
+#include "net/tools/naive/naive_random.h"
 #include "url/gurl.h"
 
 namespace net {
 
 namespace {
-constexpr int kBufferSize = 64 * 1024;
 constexpr size_t kMaxHeaderSize = 64 * 1024;
 constexpr char kResponseHeader[] = "HTTP/1.1 200 OK\r\nPadding: ";
 constexpr int kResponseHeaderSize = sizeof(kResponseHeader) - 1;
+constexpr char kCRLF[] = "\r\n";
+constexpr int kCRLFSize = sizeof(kCRLF) - 1;
+constexpr char kHeaderSeparator[] = ": ";
+constexpr int kHeaderSeparatorSize = sizeof(kHeaderSeparator) - 1;
 // A plain 200 is 10 bytes. Expected 48 bytes. "Padding" uses up 7 bytes.
 constexpr int kMinPaddingSize = 30;
 constexpr int kMaxPaddingSize = kMinPaddingSize + 32;
+
+// Splits the request line into its method, target, and version.
+bool SplitRequestLine(std::string_view line,
+                      std::string_view* method,
+                      std::string_view* uri,
+                      std::string_view* version) {
+  size_t first_space = line.find(' ');
+  if (first_space == std::string_view::npos || first_space + 1 >= line.size())
+    return false;
+  size_t second_space = line.find(' ', first_space + 1);
+  if (second_space == std::string_view::npos)
+    return false;
+  *method = line.substr(0, first_space);
+  *uri = line.substr(first_space + 1, second_space - (first_space + 1));
+  *version = line.substr(second_space + 1);
+  return true;
+}
 }  // namespace
 
 HttpProxyServerSocket::HttpProxyServerSocket(
     std::unique_ptr<StreamSocket> transport_socket,
-    const std::string& user,
-    const std::string& pass,
+    scoped_refptr<const NaiveUserTable> users,
     ClientPaddingDetectorDelegate* padding_detector_delegate,
     const NetworkTrafficAnnotationTag& traffic_annotation,
-    const std::vector<PaddingType>& supported_padding_types)
+    const std::vector<PaddingType>& supported_padding_types,
+    const PaddingLimits& padding_limits,
+    const NaiveHttpCache* http_cache,
+    std::string initial_data)
     : io_callback_(base::BindRepeating(&HttpProxyServerSocket::OnIOComplete,
                                        base::Unretained(this))),
       transport_(std::move(transport_socket)),
       padding_detector_delegate_(padding_detector_delegate),
       next_state_(STATE_NONE),
+      header_scan_offset_(0),
+      forward_state_(kForwardNone),
+      body_remaining_(0),
+      forward_read_buf_len_(0),
       completed_handshake_(false),
       was_ever_used_(false),
       header_write_size_(-1),
+      header_read_size_(NaiveBufferPool::kMinBufferSize),
+      users_(std::move(users)),
       net_log_(transport_->NetLog()),
       traffic_annotation_(traffic_annotation),
-      supported_padding_types_(supported_padding_types) {
-  if (!user.empty() || !pass.empty()) {
-    basic_auth_ =
-        std::string("Basic ").append(base::Base64Encode(user + ":" + pass));
-  }
-}
+      supported_padding_types_(supported_padding_types),
+      padding_limits_(padding_limits),
+      http_cache_(http_cache),
+      initial_data_(std::move(initial_data)) {}
 
 HttpProxyServerSocket::~HttpProxyServerSocket() {
   Disconnect();
@@ -86,6 +118,7 @@ int HttpProxyServerSocket::Connect(CompletionOnceCallback callback) {
 
   next_state_ = STATE_HEADER_READ;
   buffer_.clear();
+  header_scan_offset_ = 0;
 
   int rv = DoLoop(OK);
   if (rv == ERR_IO_PENDING) {
@@ -102,6 +135,12 @@ void HttpProxyServerSocket::Disconnect() {
   // These are the states initialized by Connect().
   next_state_ = STATE_NONE;
   user_callback_.Reset();
+  forward_read_buf_ = nullptr;
+  forward_read_callback_.Reset();
+}
+
+int HttpProxyServerSocket::ShutdownWrite() {
+  return transport_->ShutdownWrite();
 }
 
 bool HttpProxyServerSocket::IsConnected() const {
@@ -154,6 +193,16 @@ int HttpProxyServerSocket::Read(IOBuffer* buf,
   DCHECK(!user_callback_);
   DCHECK(callback);
 
+  if (forward_state_ != kForwardNone) {
+    DCHECK(!forward_read_callback_);
+    forward_read_buf_ = buf;
+    forward_read_buf_len_ = buf_len;
+    int rv = DoForwardRead();
+    if (rv == ERR_IO_PENDING)
+      forward_read_callback_ = std::move(callback);
+    return rv;
+  }
+
   if (!buffer_.empty()) {
     was_ever_used_ = true;
     int data_len = buffer_.size();
@@ -163,7 +212,7 @@ int HttpProxyServerSocket::Read(IOBuffer* buf,
       return data_len;
     } else {
       std::memcpy(buf->data(), buffer_.data(), buf_len);
-      buffer_ = buffer_.substr(buf_len);
+      buffer_.erase(0, buf_len);
       return buf_len;
     }
   }
@@ -177,6 +226,32 @@ int HttpProxyServerSocket::Read(IOBuffer* buf,
   return rv;
 }
 
+int HttpProxyServerSocket::ReadIfReady(IOBuffer* buf,
+                                      int buf_len,
+                                      CompletionOnceCallback callback) {
+  DCHECK(completed_handshake_);
+  DCHECK_EQ(STATE_NONE, next_state_);
+  DCHECK(!user_callback_);
+  DCHECK(callback);
+
+  // Rewriting plain HTTP requests may need more input than is ready.
+  if (forward_state_ != kForwardNone)
+    return ERR_READ_IF_READY_NOT_IMPLEMENTED;
+
+  // Data left over from the header read is always ready.
+  if (!buffer_.empty())
+    return Read(buf, buf_len, std::move(callback));
+
+  int rv = transport_->ReadIfReady(buf, buf_len, std::move(callback));
+  if (rv > 0)
+    was_ever_used_ = true;
+  return rv;
+}
+
+int HttpProxyServerSocket::CancelReadIfReady() {
+  return transport_->CancelReadIfReady();
+}
+
 // Write is called by the transport layer. This can only be done if the
 // HTTP CONNECT request is complete.
 int HttpProxyServerSocket::Write(
@@ -267,44 +342,18 @@ int HttpProxyServerSocket::DoLoop(int last_io_result) {
 int HttpProxyServerSocket::DoHeaderRead() {
   next_state_ = STATE_HEADER_READ_COMPLETE;
 
-  handshake_buf_ = base::MakeRefCounted<IOBufferWithSize>(kBufferSize);
-  return transport_->Read(handshake_buf_.get(), kBufferSize, io_callback_);
-}
-
-std::optional<PaddingType> HttpProxyServerSocket::ParsePaddingHeaders(
-    const HttpRequestHeaders& headers) {
-  bool has_padding = headers.HasHeader(kPaddingHeader);
-  std::string padding_type_request;
-  bool has_padding_type_request =
-      headers.GetHeader(kPaddingTypeRequestHeader, &padding_type_request);
-
-  if (!has_padding_type_request) {
-    // Backward compatibility with before kVariant1 when the padding-version
-    // header does not exist.
-    if (has_padding) {
-      return PaddingType::kVariant1;
-    } else {
-      return PaddingType::kNone;
-    }
+  if (!initial_data_.empty()) {
+    int size = initial_data_.size();
+    handshake_buf_ =
+        base::MakeRefCounted<StringIOBuffer>(std::move(initial_data_));
+    initial_data_.clear();
+    return size;
   }
 
-  std::vector<std::string_view> padding_type_strs = base::SplitStringPiece(
-      padding_type_request, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
-  for (std::string_view padding_type_str : padding_type_strs) {
-    std::optional<PaddingType> padding_type =
-        ParsePaddingType(padding_type_str);
-    if (!padding_type.has_value()) {
-      LOG(ERROR) << "Invalid padding type: " << padding_type_str;
-      return std::nullopt;
-    }
-    if (std::find(supported_padding_types_.begin(),
-                  supported_padding_types_.end(),
-                  *padding_type) != supported_padding_types_.end()) {
-      return padding_type;
-    }
-  }
-  LOG(ERROR) << "No padding type is supported: " << padding_type_request;
-  return std::nullopt;
+  // Most requests fit in the smallest pooled buffer.
+  handshake_buf_ = NaiveBufferPool::Acquire(header_read_size_);
+  return transport_->Read(handshake_buf_.get(), header_read_size_,
+                          io_callback_);
 }
 
 int HttpProxyServerSocket::DoHeaderReadComplete(int result) {
@@ -316,34 +365,34 @@ int HttpProxyServerSocket::DoHeaderReadComplete(int result) {
   }
 
   buffer_.append(handshake_buf_->data(), result);
+  handshake_buf_ = nullptr;
+  if (result == header_read_size_) {
+    header_read_size_ =
+        std::min(header_read_size_ * 2, NaiveBufferPool::kBufferSize);
+  }
   if (buffer_.size() > kMaxHeaderSize) {
     return ERR_MSG_TOO_BIG;
   }
 
-  size_t header_end = buffer_.find("\r\n\r\n");
+  // Only the new bytes and a terminator split across reads are scanned.
+  size_t header_end = buffer_.find("\r\n\r\n", header_scan_offset_);
   if (header_end == std::string::npos) {
+    header_scan_offset_ = buffer_.size() - std::min<size_t>(buffer_.size(), 3);
     next_state_ = STATE_HEADER_READ;
     return OK;
   }
 
-  size_t first_line_end = buffer_.find("\r\n");
-  size_t first_space = buffer_.find(' ');
-  bool is_http_1_0 = false;
-  if (first_space == std::string::npos || first_space + 1 >= first_line_end) {
-    LOG(WARNING) << "Invalid request: " << buffer_.substr(0, first_line_end);
-    return ERR_INVALID_ARGUMENT;
-  }
-  size_t second_space = buffer_.find(' ', first_space + 1);
-  if (second_space == std::string::npos || second_space >= first_line_end) {
-    LOG(WARNING) << "Invalid request: " << buffer_.substr(0, first_line_end);
+  std::string_view header(buffer_.data(), header_end);
+  size_t first_line_end = std::min(header.find("\r\n"), header.size());
+  std::string_view first_line = header.substr(0, first_line_end);
+  std::string_view method;
+  std::string_view uri;
+  std::string_view version;
+  if (!SplitRequestLine(first_line, &method, &uri, &version)) {
+    LOG(WARNING) << "Invalid request: " << first_line;
     return ERR_INVALID_ARGUMENT;
   }
-
-  std::string method = buffer_.substr(0, first_space);
-  std::string uri =
-      buffer_.substr(first_space + 1, second_space - (first_space + 1));
-  std::string version =
-      buffer_.substr(second_space + 1, first_line_end - (second_space + 1));
+  bool is_http_1_0 = false;
   if (method == HttpRequestHeaders::kConnectMethod) {
     request_endpoint_ = HostPortPair::FromString(uri);
   } else {
@@ -351,108 +400,393 @@ int HttpProxyServerSocket::DoHeaderReadComplete(int result) {
     is_http_1_0 = true;
   }
 
+  // Picks out the headers used here without copying them.
+  ProxyHeaders proxy_headers;
   size_t second_line = first_line_end + 2;
-  HttpRequestHeaders headers;
-  std::string headers_str;
   if (second_line < header_end) {
-    headers_str = buffer_.substr(second_line, header_end - second_line);
-    headers.AddHeadersFromString(headers_str);
+    HttpUtil::HeadersIterator it(buffer_.begin() + second_line,
+                                 buffer_.begin() + header_end, "\r\n");
+    while (it.GetNext()) {
+      std::string_view name = it.name_piece();
+      if (base::EqualsCaseInsensitiveASCII(
+              name, HttpRequestHeaders::kProxyAuthorization)) {
+        proxy_headers.proxy_authorization = it.values_piece();
+      } else if (base::EqualsCaseInsensitiveASCII(name, kPaddingHeader)) {
+        proxy_headers.has_padding = true;
+      } else if (base::EqualsCaseInsensitiveASCII(
+                     name, kPaddingTypeRequestHeader)) {
+        proxy_headers.padding_type_request = it.values_piece();
+      } else if (base::EqualsCaseInsensitiveASCII(
+                     name, kPaddingCompressionRequestHeader)) {
+        proxy_headers.padding_compression_request = it.values_piece();
+      }
+    }
   }
 
-  if (!basic_auth_.empty()) {
-    std::string proxy_auth;
-    headers.GetHeader(HttpRequestHeaders::kProxyAuthorization, &proxy_auth);
-    if (proxy_auth != basic_auth_) {
+  if (RequiresAuth(users_.get())) {
+    std::string_view proxy_auth =
+        proxy_headers.proxy_authorization.value_or(std::string_view());
+    const std::string* user = users_->FindByBasicAuth(proxy_auth);
+    if (!user) {
       LOG(WARNING) << "Invalid Proxy-Authorization: " << proxy_auth;
       return ERR_INVALID_ARGUMENT;
     }
+    user_ = *user;
+  }
+
+  std::optional<PaddingType> padding_type = SelectClientPaddingType(
+      proxy_headers.has_padding, proxy_headers.padding_type_request,
+      supported_padding_types_);
+  if (!padding_type.has_value()) {
+    return ERR_INVALID_ARGUMENT;
+  }
+  PaddingLimits padding_limits = SelectClientPaddingLimits(
+      *padding_type, proxy_headers.padding_type_request,
+      proxy_headers.padding_compression_request, padding_limits_);
+  padding_detector_delegate_->SetClientPaddingType(*padding_type,
+                                                   padding_limits);
+  if (proxy_headers.padding_type_request.has_value()) {
+    padding_type_reply_ = ToPaddingTypeReply(*padding_type, padding_limits);
   }
 
   if (is_http_1_0) {
-    GURL url(uri);
-    if (!url.is_valid()) {
-      LOG(WARNING) << "Invalid URI: " << uri;
-      return ERR_INVALID_ARGUMENT;
+    std::string_view header_lines;
+    if (second_line < header_end) {
+      header_lines = header.substr(second_line);
+    }
+    // Padded clients only expect padding in tunnels.
+    if (http_cache_ && method == HttpRequestHeaders::kGetMethod &&
+        *padding_type == PaddingType::kNone &&
+        TakeCacheRequest(uri, header_lines)) {
+      buffer_.clear();
+      completed_handshake_ = true;
+      next_state_ = STATE_NONE;
+      return OK;
     }
+    int rv = ForwardRequest(method, uri, version, header_lines);
+    if (rv != OK)
+      return rv;
+    buffer_.erase(0, header_end + 4);
+    // Skips padding write for raw http proxy
+    completed_handshake_ = true;
+    next_state_ = STATE_NONE;
+    return OK;
+  }
 
-    std::string host;
-    int port;
+  buffer_.erase(0, header_end + 4);
 
-    std::string host_str;
-    if (headers.GetHeader(HttpRequestHeaders::kHost, &host_str)) {
-      if (!ParseHostAndPort(host_str, &host, &port)) {
-        LOG(WARNING) << "Invalid Host: " << host_str;
-        return ERR_INVALID_ARGUMENT;
-      }
-      if (port == -1) {
-        port = 80;
-      }
-    } else {
-      if (!url.has_host()) {
-        LOG(WARNING) << "Missing host: " << uri;
-        return ERR_INVALID_ARGUMENT;
-      }
-      host = url.host();
-      port = url.EffectiveIntPort();
+  next_state_ = STATE_HEADER_WRITE;
+  return OK;
+}
 
-      host_str = url.host();
-      if (url.has_port()) {
-        host_str.append(":").append(url.port());
-      }
-      headers.SetHeader(HttpRequestHeaders::kHost, host_str);
+int HttpProxyServerSocket::ForwardRequest(std::string_view method,
+                                          std::string_view uri,
+                                          std::string_view version,
+                                          std::string_view header_lines) {
+  GURL url(uri);
+  if (!url.is_valid()) {
+    LOG(WARNING) << "Invalid URI: " << uri;
+    return ERR_INVALID_ARGUMENT;
+  }
+
+  // The whole header is forwarded, so only this path materializes it.
+  HttpRequestHeaders headers;
+  headers.AddHeadersFromString(header_lines);
+
+  std::string host;
+  int port;
+
+  std::string host_str;
+  if (headers.GetHeader(HttpRequestHeaders::kHost, &host_str)) {
+    if (!ParseHostAndPort(host_str, &host, &port)) {
+      LOG(WARNING) << "Invalid Host: " << host_str;
+      return ERR_INVALID_ARGUMENT;
     }
-    // Host is already known. Converts any absolute URI to relative.
-    uri = url.path();
-    if (url.has_query()) {
-      uri.append("?").append(url.query());
+    if (port == -1) {
+      port = 80;
     }
+  } else {
+    if (!url.has_host()) {
+      LOG(WARNING) << "Missing host: " << uri;
+      return ERR_INVALID_ARGUMENT;
+    }
+    host = url.host();
+    port = url.EffectiveIntPort();
 
-    request_endpoint_.set_host(host);
-    request_endpoint_.set_port(port);
+    host_str = url.host();
+    if (url.has_port()) {
+      host_str.append(":").append(url.port());
+    }
+    headers.SetHeader(HttpRequestHeaders::kHost, host_str);
   }
 
-  std::optional<PaddingType> padding_type = ParsePaddingHeaders(headers);
-  if (!padding_type.has_value()) {
-    return ERR_INVALID_ARGUMENT;
+  HostPortPair endpoint(host, port);
+  if (forward_state_ == kForwardNone) {
+    request_endpoint_ = endpoint;
+  } else if (!endpoint.Equals(request_endpoint_)) {
+    // The tunnel only reaches request_endpoint_. Ending the requests here
+    // lets the earlier responses finish, and the client sends this one
+    // again on a new connection.
+    forward_state_ = kForwardEnded;
+    return OK;
   }
-  padding_detector_delegate_->SetClientPaddingType(*padding_type);
 
-  if (is_http_1_0) {
-    // Regenerates http header to make sure don't leak them to end servers
-    HttpRequestHeaders sanitized_headers = headers;
-    sanitized_headers.RemoveHeader(HttpRequestHeaders::kProxyConnection);
-    sanitized_headers.RemoveHeader(HttpRequestHeaders::kProxyAuthorization);
-    std::ostringstream ss;
-    ss << method << " " << uri << " " << version << "\r\n"
-       << sanitized_headers.ToString();
-    if (buffer_.size() > header_end + 4) {
-      ss << buffer_.substr(header_end + 4);
+  // Finds where the next request starts. Chunked bodies and upgrades are
+  // relayed as is to the end of the connection.
+  std::string content_length;
+  if (headers.HasHeader(HttpRequestHeaders::kTransferEncoding) ||
+      headers.HasHeader("Upgrade")) {
+    forward_state_ = kForwardTunnel;
+  } else if (headers.GetHeader(HttpRequestHeaders::kContentLength,
+                               &content_length)) {
+    int64_t body_size;
+    if (!base::StringToInt64(content_length, &body_size) || body_size < 0) {
+      LOG(WARNING) << "Invalid Content-Length: " << content_length;
+      return ERR_INVALID_ARGUMENT;
     }
-    buffer_ = ss.str();
-    // Skips padding write for raw http proxy
-    completed_handshake_ = true;
-    next_state_ = STATE_NONE;
-    return OK;
+    body_remaining_ = body_size;
+    forward_state_ = body_size > 0 ? kForwardBody : kForwardHeader;
+  } else {
+    forward_state_ = kForwardHeader;
   }
 
-  buffer_ = buffer_.substr(header_end + 4);
+  // Host is already known. Converts any absolute URI to relative.
+  std::string path = url.path();
+  if (url.has_query()) {
+    path.append("?").append(url.query());
+  }
 
-  next_state_ = STATE_HEADER_WRITE;
+  // Regenerates http header to make sure don't leak them to end servers
+  headers.RemoveHeader(HttpRequestHeaders::kProxyConnection);
+  headers.RemoveHeader(HttpRequestHeaders::kProxyAuthorization);
+  base::StrAppend(&output_, {method, " ", path, " ", version, "\r\n",
+                             headers.ToString()});
   return OK;
 }
 
+bool HttpProxyServerSocket::TakeCacheRequest(std::string_view uri,
+                                             std::string_view header_lines) {
+  GURL url(uri);
+  if (!url.is_valid() || !http_cache_->ShouldCache(url)) {
+    return false;
+  }
+  HttpRequestHeaders headers;
+  headers.AddHeadersFromString(header_lines);
+  std::string content_length;
+  if (headers.HasHeader(HttpRequestHeaders::kTransferEncoding) ||
+      headers.HasHeader("Upgrade") ||
+      (headers.GetHeader(HttpRequestHeaders::kContentLength,
+                         &content_length) &&
+       content_length != "0")) {
+    return false;
+  }
+  const std::string_view removed_headers[] = {
+      HttpRequestHeaders::kHost,
+      HttpRequestHeaders::kProxyConnection,
+      HttpRequestHeaders::kProxyAuthorization,
+      HttpRequestHeaders::kConnection,
+      HttpRequestHeaders::kContentLength,
+      "Keep-Alive",
+      "TE",
+      kPaddingHeader,
+      kPaddingTypeRequestHeader,
+      kPaddingCompressionRequestHeader,
+  };
+  for (std::string_view name : removed_headers) {
+    headers.RemoveHeader(name);
+  }
+  request_endpoint_ = HostPortPair::FromURL(url);
+  cache_url_ = std::move(url);
+  cache_headers_ = std::move(headers);
+  // Later requests are sent again on new connections.
+  forward_state_ = kForwardEnded;
+  return true;
+}
+
+int HttpProxyServerSocket::ProcessForwardInput() {
+  while (!buffer_.empty()) {
+    if (forward_state_ == kForwardEnded) {
+      buffer_.clear();
+      break;
+    }
+    if (forward_state_ == kForwardTunnel) {
+      output_.append(buffer_);
+      buffer_.clear();
+      break;
+    }
+    if (forward_state_ == kForwardBody) {
+      size_t size = static_cast<size_t>(
+          std::min<uint64_t>(buffer_.size(), body_remaining_));
+      output_.append(buffer_, 0, size);
+      buffer_.erase(0, size);
+      body_remaining_ -= size;
+      if (body_remaining_ == 0)
+        forward_state_ = kForwardHeader;
+      continue;
+    }
+
+    DCHECK_EQ(forward_state_, kForwardHeader);
+    // Ignores empty lines before a request, as RFC 9112 allows.
+    if (buffer_.starts_with("\r\n")) {
+      buffer_.erase(0, 2);
+      continue;
+    }
+    size_t header_end = buffer_.find("\r\n\r\n", header_scan_offset_);
+    if (header_end == std::string::npos) {
+      if (buffer_.size() > kMaxHeaderSize)
+        return ERR_MSG_TOO_BIG;
+      header_scan_offset_ =
+          buffer_.size() - std::min<size_t>(buffer_.size(), 3);
+      break;
+    }
+    header_scan_offset_ = 0;
+
+    std::string_view header(buffer_.data(), header_end);
+    size_t first_line_end = std::min(header.find("\r\n"), header.size());
+    std::string_view first_line = header.substr(0, first_line_end);
+    std::string_view method;
+    std::string_view uri;
+    std::string_view version;
+    if (!SplitRequestLine(first_line, &method, &uri, &version)) {
+      LOG(WARNING) << "Invalid request: " << first_line;
+      return ERR_INVALID_ARGUMENT;
+    }
+    if (method == HttpRequestHeaders::kConnectMethod) {
+      // Needs a new tunnel like any other endpoint.
+      forward_state_ = kForwardEnded;
+      continue;
+    }
+    std::string_view header_lines;
+    if (first_line_end + 2 < header.size()) {
+      header_lines = header.substr(first_line_end + 2);
+    }
+    int rv = ForwardRequest(method, uri, version, header_lines);
+    if (rv != OK)
+      return rv;
+    buffer_.erase(0, header_end + 4);
+  }
+  return OK;
+}
+
+int HttpProxyServerSocket::DoForwardRead() {
+  for (;;) {
+    int rv = ProcessForwardInput();
+    if (rv != OK) {
+      forward_read_buf_ = nullptr;
+      return rv;
+    }
+
+    if (!output_.empty()) {
+      was_ever_used_ = true;
+      size_t size =
+          std::min(output_.size(), static_cast<size_t>(forward_read_buf_len_));
+      std::memcpy(forward_read_buf_->data(), output_.data(), size);
+      output_.erase(0, size);
+      forward_read_buf_ = nullptr;
+      return size;
+    }
+
+    if (forward_state_ == kForwardEnded) {
+      forward_read_buf_ = nullptr;
+      return 0;
+    }
+
+    if (forward_state_ == kForwardHeader) {
+      handshake_buf_ = NaiveBufferPool::Acquire(header_read_size_);
+      rv = transport_->Read(
+          handshake_buf_.get(), header_read_size_,
+          base::BindOnce(&HttpProxyServerSocket::OnForwardReadComplete,
+                         base::Unretained(this)));
+    } else {
+      // Bodies need no rewriting, so they are read in place.
+      int size = forward_read_buf_len_;
+      if (forward_state_ == kForwardBody) {
+        size = static_cast<int>(std::min<uint64_t>(size, body_remaining_));
+      }
+      rv = transport_->Read(
+          forward_read_buf_.get(), size,
+          base::BindOnce(&HttpProxyServerSocket::OnForwardReadComplete,
+                         base::Unretained(this)));
+    }
+    if (rv == ERR_IO_PENDING)
+      return rv;
+    rv = DoForwardReadComplete(rv);
+    if (rv != ERR_IO_PENDING)
+      return rv;
+  }
+}
+
+int HttpProxyServerSocket::DoForwardReadComplete(int result) {
+  if (!handshake_buf_) {
+    if (result > 0) {
+      was_ever_used_ = true;
+      if (forward_state_ == kForwardBody) {
+        body_remaining_ -= result;
+        if (body_remaining_ == 0)
+          forward_state_ = kForwardHeader;
+      }
+    }
+    forward_read_buf_ = nullptr;
+    return result;
+  }
+
+  if (result <= 0) {
+    handshake_buf_ = nullptr;
+    forward_read_buf_ = nullptr;
+    return result;
+  }
+  buffer_.append(handshake_buf_->data(), result);
+  handshake_buf_ = nullptr;
+  if (result == header_read_size_) {
+    header_read_size_ =
+        std::min(header_read_size_ * 2, NaiveBufferPool::kBufferSize);
+  }
+  return ERR_IO_PENDING;
+}
+
+void HttpProxyServerSocket::OnForwardReadComplete(int result) {
+  DCHECK_NE(ERR_IO_PENDING, result);
+  DCHECK(forward_read_callback_);
+
+  int rv = DoForwardReadComplete(result);
+  if (rv == ERR_IO_PENDING)
+    rv = DoForwardRead();
+  if (rv != ERR_IO_PENDING)
+    std::move(forward_read_callback_).Run(rv);
+}
+
 int HttpProxyServerSocket::DoHeaderWrite() {
   next_state_ = STATE_HEADER_WRITE_COMPLETE;
 
-  // Adds padding.
-  int padding_size = base::RandInt(kMinPaddingSize, kMaxPaddingSize);
-  header_write_size_ = kResponseHeaderSize + padding_size + 4;
+  // Adds padding. Formats the reply in place from the constant parts.
+  int padding_size = NaiveRandInt(kMinPaddingSize, kMaxPaddingSize);
+  const std::string_view reply_name = kPaddingTypeReplyHeader;
+  int reply_size = padding_type_reply_.size();
+  header_write_size_ = kResponseHeaderSize + padding_size + kCRLFSize;
+  if (reply_size > 0) {
+    header_write_size_ += reply_name.size() + kHeaderSeparatorSize +
+                          reply_size + kCRLFSize;
+  }
+  header_write_size_ += kCRLFSize;
   handshake_buf_ = base::MakeRefCounted<IOBufferWithSize>(header_write_size_);
   char* p = handshake_buf_->data();
   std::memcpy(p, kResponseHeader, kResponseHeaderSize);
-  FillNonindexHeaderValue(base::RandUint64(), p + kResponseHeaderSize,
-                          padding_size);
-  std::memcpy(p + kResponseHeaderSize + padding_size, "\r\n\r\n", 4);
+  p += kResponseHeaderSize;
+  FillNonindexHeaderValue(NaiveRandUint64(), p, padding_size);
+  p += padding_size;
+  std::memcpy(p, kCRLF, kCRLFSize);
+  p += kCRLFSize;
+  if (reply_size > 0) {
+    std::memcpy(p, reply_name.data(), reply_name.size());
+    p += reply_name.size();
+    std::memcpy(p, kHeaderSeparator, kHeaderSeparatorSize);
+    p += kHeaderSeparatorSize;
+    std::memcpy(p, padding_type_reply_.data(), reply_size);
+    p += reply_size;
+    std::memcpy(p, kCRLF, kCRLFSize);
+    p += kCRLFSize;
+  }
+  std::memcpy(p, kCRLF, kCRLFSize);
 
   return transport_->Write(handshake_buf_.get(), header_write_size_,
                            io_callback_, traffic_annotation_);
@@ -465,6 +799,7 @@ int HttpProxyServerSocket::DoHeaderWriteComplete(int result) {
   if (result != header_write_size_) {
     return ERR_FAILED;
   }
+  handshake_buf_ = nullptr;
 
   completed_handshake_ = true;
   next_state_ = STATE_NONE;
@@ -9,7 +9,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "base/memory/scoped_refptr.h"
@@ -25,21 +27,29 @@
 #include "net/socket/stream_socket.h"
 #include "net/ssl/ssl_info.h"
 #include "net/tools/naive/naive_protocol.h"
+#include "net/tools/naive/naive_user_table.h"
+#include "url/gurl.h"
 
 namespace net {
 struct NetworkTrafficAnnotationTag;
 class ClientPaddingDetectorDelegate;
+class NaiveHttpCache;
 
 // This StreamSocket is used to setup a HTTP CONNECT tunnel.
 class HttpProxyServerSocket : public StreamSocket {
  public:
+  // If `http_cache` is not null, a first request that it caches is kept for
+  // it rather than forwarded. `initial_data` is the start of the request
+  // already read from `transport_socket`, if any.
   HttpProxyServerSocket(
       std::unique_ptr<StreamSocket> transport_socket,
-      const std::string& user,
-      const std::string& pass,
+      scoped_refptr<const NaiveUserTable> users,
       ClientPaddingDetectorDelegate* padding_detector_delegate,
       const NetworkTrafficAnnotationTag& traffic_annotation,
-      const std::vector<PaddingType>& supported_padding_types);
+      const std::vector<PaddingType>& supported_padding_types,
+      const PaddingLimits& padding_limits,
+      const NaiveHttpCache* http_cache,
+      std::string initial_data);
   HttpProxyServerSocket(const HttpProxyServerSocket&) = delete;
   HttpProxyServerSocket& operator=(const HttpProxyServerSocket&) = delete;
 
@@ -48,10 +58,32 @@ class HttpProxyServerSocket : public StreamSocket {
 
   const HostPortPair& request_endpoint() const;
 
+  // The user the request authenticated as, or empty.
+  const std::string& user() const { return user_; }
+
+  const StreamSocket* transport_socket() const { return transport_.get(); }
+
+  // Whether bytes received after the request header are still buffered here
+  // and not yet returned by Read().
+  bool has_buffered_data() const {
+    return !buffer_.empty() || !output_.empty();
+  }
+
+  // Whether Read() rewrites the plain HTTP requests that follow the first.
+  bool is_forwarding() const { return forward_state_ != kForwardNone; }
+
+  // Whether the first request is a GET to serve through the HTTP cache, in
+  // which case Read() discards what follows it.
+  bool is_cache_request() const { return cache_url_.is_valid(); }
+  const GURL& cache_url() const { return cache_url_; }
+  // The headers of the request without the hop-by-hop and proxy headers.
+  const HttpRequestHeaders& cache_headers() const { return cache_headers_; }
+
   // StreamSocket implementation.
 
   int Connect(CompletionOnceCallback callback) override;
   void Disconnect() override;
+  int ShutdownWrite() override;
   bool IsConnected() const override;
   bool IsConnectedAndIdle() const override;
   const NetLogWithSource& NetLog() const override;
@@ -65,6 +97,10 @@ class HttpProxyServerSocket : public StreamSocket {
   int Read(IOBuffer* buf,
            int buf_len,
            CompletionOnceCallback callback) override;
+  int ReadIfReady(IOBuffer* buf,
+                  int buf_len,
+                  CompletionOnceCallback callback) override;
+  int CancelReadIfReady() override;
   int Write(IOBuffer* buf,
             int buf_len,
             CompletionOnceCallback callback,
@@ -85,6 +121,20 @@ class HttpProxyServerSocket : public StreamSocket {
     STATE_NONE,
   };
 
+  // Position in the client stream of a plain HTTP proxy connection.
+  enum ForwardState {
+    // Tunneling a CONNECT request.
+    kForwardNone,
+    // Expecting the next request header.
+    kForwardHeader,
+    // Relaying body_remaining_ bytes of a request body.
+    kForwardBody,
+    // Relaying the rest of the connection without parsing it.
+    kForwardTunnel,
+    // A request for another endpoint was read. No more requests are relayed.
+    kForwardEnded,
+  };
+
   void DoCallback(int result);
   void OnIOComplete(int result);
   void OnReadWriteComplete(CompletionOnceCallback callback, int result);
@@ -95,8 +145,32 @@ class HttpProxyServerSocket : public StreamSocket {
   int DoHeaderRead();
   int DoHeaderReadComplete(int result);
 
-  std::optional<PaddingType> ParsePaddingHeaders(
-      const HttpRequestHeaders& headers);
+  // Request headers that the proxy acts on, viewing into buffer_.
+  struct ProxyHeaders {
+    std::optional<std::string_view> proxy_authorization;
+    bool has_padding = false;
+    std::optional<std::string_view> padding_type_request;
+    std::optional<std::string_view> padding_compression_request;
+  };
+
+  // Rewrites a plain HTTP request for request_endpoint_ into output_ and
+  // sets forward_state_ for what follows it. `header_lines` are the header
+  // fields between the request line and the empty line.
+  int ForwardRequest(std::string_view method,
+                     std::string_view uri,
+                     std::string_view version,
+                     std::string_view header_lines);
+  // Keeps a GET for the HTTP cache if it caches `uri` and the request has no
+  // body. Returns false if the request is forwarded instead.
+  bool TakeCacheRequest(std::string_view uri, std::string_view header_lines);
+  // Moves complete requests from buffer_ to output_.
+  int ProcessForwardInput();
+  // Completes a Read() of plain HTTP requests into forward_read_buf_.
+  // Internally ERR_IO_PENDING from DoForwardReadComplete() means more input
+  // is needed.
+  int DoForwardRead();
+  int DoForwardReadComplete(int result);
+  void OnForwardReadComplete(int result);
 
   CompletionRepeatingCallback io_callback_;
 
@@ -115,11 +189,23 @@ class HttpProxyServerSocket : public StreamSocket {
   scoped_refptr<IOBuffer> handshake_buf_;
 
   std::string buffer_;
+  // Where the search for the end of the header resumes in buffer_.
+  size_t header_scan_offset_;
+  // Rewritten plain HTTP requests not yet returned by Read().
+  std::string output_;
+  ForwardState forward_state_;
+  uint64_t body_remaining_;
+  scoped_refptr<IOBuffer> forward_read_buf_;
+  int forward_read_buf_len_;
+  CompletionOnceCallback forward_read_callback_;
   bool completed_handshake_;
   bool was_ever_used_;
   int header_write_size_;
+  // Grows while header reads fill the buffer.
+  int header_read_size_;
 
-  std::string basic_auth_;
+  scoped_refptr<const NaiveUserTable> users_;
+  std::string user_;
 
   HostPortPair request_endpoint_;
 
@@ -129,6 +215,23 @@ class HttpProxyServerSocket : public StreamSocket {
   const NetworkTrafficAnnotationTag& traffic_annotation_;
 
   std::vector<PaddingType> supported_padding_types_;
+
+  // Offered with kVariant2.
+  PaddingLimits padding_limits_;
+
+  // Value of the padding-type-reply header, if the client requested padding
+  // types.
+  std::string padding_type_reply_;
+
+  const NaiveHttpCache* http_cache_;
+
+  // Bytes of the request read from `transport_` before it was handed here,
+  // returned by the first header read.
+  std::string initial_data_;
+
+  // Invalid unless the first request is served through the cache.
+  GURL cache_url_;
+  HttpRequestHeaders cache_headers_;
 };
 
 }  // namespace net
@@ -0,0 +1,244 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_accept_balancer.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "base/check_op.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/task/sequenced_task_runner.h"
+#include "net/base/net_errors.h"
+#include "net/socket/stream_socket.h"
+#include "net/socket/tcp_client_socket.h"
+#include "net/socket/tcp_server_socket.h"
+
+namespace net {
+
+namespace {
+constexpr base::TimeDelta kMinAcceptRetryDelay = base::Milliseconds(250);
+constexpr base::TimeDelta kMaxAcceptRetryDelay = base::Seconds(8);
+// Connections accepted for all threads in one task before yielding.
+constexpr int kMaxAcceptsPerTask = 64;
+}  // namespace
+
+NaiveThreadLoads::NaiveThreadLoads(int num_threads) : loads_(num_threads) {
+  DCHECK_GE(num_threads, 1);
+}
+
+NaiveThreadLoads::~NaiveThreadLoads() = default;
+
+void NaiveThreadLoads::Report(int thread,
+                              int64_t connections,
+                              int64_t bytes_per_second) {
+  loads_[thread].connections.store(connections, std::memory_order_relaxed);
+  loads_[thread].bytes_per_second.store(bytes_per_second,
+                                        std::memory_order_relaxed);
+}
+
+void NaiveThreadLoads::AddConnection(int thread) {
+  loads_[thread].connections.fetch_add(1, std::memory_order_relaxed);
+}
+
+int64_t NaiveThreadLoads::GetLoad(int thread) const {
+  const Load& load = loads_[thread];
+  return load.bytes_per_second.load(std::memory_order_relaxed) +
+         load.connections.load(std::memory_order_relaxed) * kConnectionLoad;
+}
+
+NaiveAcceptBalancer::Target::Target() = default;
+NaiveAcceptBalancer::Target::Target(const Target&) = default;
+NaiveAcceptBalancer::Target& NaiveAcceptBalancer::Target::operator=(
+    const Target&) = default;
+NaiveAcceptBalancer::Target::~Target() = default;
+
+NaiveAcceptBalancer::NaiveAcceptBalancer(scoped_refptr<NaiveThreadLoads> loads)
+    : loads_(std::move(loads)), targets_(loads_->num_threads()) {}
+
+NaiveAcceptBalancer::~NaiveAcceptBalancer() = default;
+
+void NaiveAcceptBalancer::Register(
+    int thread,
+    base::WeakPtr<NaiveBalancedServerSocket> socket) {
+  base::AutoLock lock(lock_);
+  targets_[thread].task_runner = base::SequencedTaskRunner::GetCurrentDefault();
+  targets_[thread].socket = std::move(socket);
+}
+
+void NaiveAcceptBalancer::Unregister(int thread) {
+  base::AutoLock lock(lock_);
+  targets_[thread] = Target();
+}
+
+std::unique_ptr<TCPSocket> NaiveAcceptBalancer::HandOff(
+    int thread,
+    std::unique_ptr<TCPSocket> socket,
+    const IPEndPoint& peer_address) {
+  int picked = thread;
+  Target target;
+  {
+    base::AutoLock lock(lock_);
+    int64_t best_load = std::numeric_limits<int64_t>::max();
+    for (size_t i = 0; i < targets_.size(); ++i) {
+      int candidate =
+          static_cast<int>((next_tie_break_ + i) % targets_.size());
+      if (!targets_[candidate].task_runner) {
+        continue;
+      }
+      int64_t load = loads_->GetLoad(candidate);
+      if (load < best_load) {
+        best_load = load;
+        picked = candidate;
+      }
+    }
+    next_tie_break_ = (next_tie_break_ + 1) % targets_.size();
+    target = targets_[picked];
+  }
+  loads_->AddConnection(picked);
+  if (picked == thread) {
+    return socket;
+  }
+  // A connection posted to a socket destroyed meanwhile is closed with the
+  // task.
+  socket->DetachFromThread();
+  target.task_runner->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveBalancedServerSocket::Deliver,
+                                target.socket, std::move(socket),
+                                peer_address));
+  return nullptr;
+}
+
+NaiveBalancedServerSocket::NaiveBalancedServerSocket(
+    scoped_refptr<NaiveAcceptBalancer> balancer,
+    int thread,
+    std::unique_ptr<TCPServerSocket> listen_socket)
+    : balancer_(std::move(balancer)),
+      thread_(thread),
+      listen_socket_(std::move(listen_socket)),
+      accept_retry_delay_(kMinAcceptRetryDelay) {}
+
+NaiveBalancedServerSocket::~NaiveBalancedServerSocket() {
+  if (registered_) {
+    balancer_->Unregister(thread_);
+  }
+}
+
+int NaiveBalancedServerSocket::Listen(const IPEndPoint& address,
+                                      int backlog,
+                                      std::optional<bool> ipv6_only) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int NaiveBalancedServerSocket::GetLocalAddress(IPEndPoint* address) const {
+  if (!listen_socket_) {
+    return ERR_NOT_IMPLEMENTED;
+  }
+  return listen_socket_->GetLocalAddress(address);
+}
+
+int NaiveBalancedServerSocket::Accept(std::unique_ptr<StreamSocket>* socket,
+                                      CompletionOnceCallback callback) {
+  return Accept(socket, std::move(callback), nullptr);
+}
+
+int NaiveBalancedServerSocket::Accept(std::unique_ptr<StreamSocket>* socket,
+                                      CompletionOnceCallback callback,
+                                      IPEndPoint* peer_address) {
+  DCHECK(!accept_callback_);
+  if (!registered_) {
+    registered_ = true;
+    balancer_->Register(thread_, weak_ptr_factory_.GetWeakPtr());
+    if (listen_socket_) {
+      DoAcceptLoop();
+    }
+  }
+  if (TakeConnection(socket, peer_address)) {
+    return OK;
+  }
+  accept_socket_ = socket;
+  accept_peer_address_ = peer_address;
+  accept_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
+void NaiveBalancedServerSocket::Deliver(std::unique_ptr<TCPSocket> socket,
+                                        const IPEndPoint& peer_address) {
+  queue_.emplace_back(std::move(socket), peer_address);
+  if (!accept_callback_) {
+    return;
+  }
+  bool taken = TakeConnection(accept_socket_, accept_peer_address_);
+  DCHECK(taken);
+  accept_socket_ = nullptr;
+  accept_peer_address_ = nullptr;
+  std::move(accept_callback_).Run(OK);
+}
+
+void NaiveBalancedServerSocket::DoAcceptLoop() {
+  for (int i = 0; i < kMaxAcceptsPerTask; ++i) {
+    int result = listen_socket_->AcceptSocket(
+        &accepted_socket_,
+        base::BindOnce(&NaiveBalancedServerSocket::OnAcceptComplete,
+                       weak_ptr_factory_.GetWeakPtr()),
+        &accepted_peer_address_);
+    if (result == ERR_IO_PENDING || !HandleAcceptResult(result)) {
+      return;
+    }
+  }
+  base::SequencedTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveBalancedServerSocket::DoAcceptLoop,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+void NaiveBalancedServerSocket::OnAcceptComplete(int result) {
+  if (HandleAcceptResult(result)) {
+    DoAcceptLoop();
+  }
+}
+
+bool NaiveBalancedServerSocket::HandleAcceptResult(int result) {
+  if (result != OK) {
+    // Only the first of a run of failures is logged.
+    if (accept_retry_delay_ == kMinAcceptRetryDelay) {
+      LOG(ERROR) << "Accept error: " << ErrorToShortString(result);
+    }
+    // The connection stays in the backlog until the retry.
+    accept_retry_timer_.Start(FROM_HERE, accept_retry_delay_, this,
+                              &NaiveBalancedServerSocket::DoAcceptLoop);
+    accept_retry_delay_ =
+        std::min(accept_retry_delay_ * 2, kMaxAcceptRetryDelay);
+    return false;
+  }
+  accept_retry_delay_ = kMinAcceptRetryDelay;
+  std::unique_ptr<TCPSocket> socket = balancer_->HandOff(
+      thread_, std::move(accepted_socket_), accepted_peer_address_);
+  if (!socket) {
+    return true;
+  }
+  // The proxy may stop listening, destroying this, when given the
+  // connection.
+  base::WeakPtr<NaiveBalancedServerSocket> self =
+      weak_ptr_factory_.GetWeakPtr();
+  Deliver(std::move(socket), accepted_peer_address_);
+  return !!self;
+}
+
+bool NaiveBalancedServerSocket::TakeConnection(
+    std::unique_ptr<StreamSocket>* socket,
+    IPEndPoint* peer_address) {
+  if (queue_.empty()) {
+    return false;
+  }
+  auto& [tcp_socket, address] = queue_.front();
+  if (peer_address) {
+    *peer_address = address;
+  }
+  *socket = std::make_unique<TCPClientSocket>(std::move(tcp_socket), address);
+  queue_.pop_front();
+  return true;
+}
+
+}  // namespace net
@@ -0,0 +1,175 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_ACCEPT_BALANCER_H_
+#define NET_TOOLS_NAIVE_NAIVE_ACCEPT_BALANCER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "base/containers/circular_deque.h"
+#include "base/memory/raw_ptr.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/task/sequenced_task_runner.h"
+#include "base/thread_annotations.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/completion_once_callback.h"
+#include "net/base/ip_endpoint.h"
+#include "net/socket/server_socket.h"
+#include "net/socket/tcp_socket.h"
+
+namespace net {
+
+class NaiveBalancedServerSocket;
+class StreamSocket;
+class TCPServerSocket;
+
+// The load of each IO thread, as reported by the thread every
+// kReportInterval: its open connections and the bytes per second they
+// relay. Shared by the threads through the configuration.
+class NaiveThreadLoads : public base::RefCountedThreadSafe<NaiveThreadLoads> {
+ public:
+  static constexpr base::TimeDelta kReportInterval = base::Seconds(1);
+  // The load of a connection beyond the bytes it relays, in bytes per
+  // second, so idle tunnels with their buffers and timers still count.
+  static constexpr int64_t kConnectionLoad = 16 * 1024;
+
+  explicit NaiveThreadLoads(int num_threads);
+  NaiveThreadLoads(const NaiveThreadLoads&) = delete;
+  NaiveThreadLoads& operator=(const NaiveThreadLoads&) = delete;
+
+  int num_threads() const { return static_cast<int>(loads_.size()); }
+
+  void Report(int thread, int64_t connections, int64_t bytes_per_second);
+  // Counts a connection handed to `thread` until its next report, so a
+  // burst of connections is not all handed to the same thread.
+  void AddConnection(int thread);
+  // In bytes per second.
+  int64_t GetLoad(int thread) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<NaiveThreadLoads>;
+  ~NaiveThreadLoads();
+
+  struct Load {
+    std::atomic<int64_t> connections{0};
+    std::atomic<int64_t> bytes_per_second{0};
+  };
+
+  std::vector<Load> loads_;
+};
+
+// Hands the connections accepted on the listen socket of a listener to the
+// least loaded thread, instead of leaving it to SO_REUSEPORT hashing of
+// per-thread listen sockets, which can pile long-lived heavy tunnels onto
+// one thread. Each thread of the listener has a NaiveBalancedServerSocket,
+// and the one of thread 0 accepts for all.
+class NaiveAcceptBalancer
+    : public base::RefCountedThreadSafe<NaiveAcceptBalancer> {
+ public:
+  explicit NaiveAcceptBalancer(scoped_refptr<NaiveThreadLoads> loads);
+  NaiveAcceptBalancer(const NaiveAcceptBalancer&) = delete;
+  NaiveAcceptBalancer& operator=(const NaiveAcceptBalancer&) = delete;
+
+  // Called on `thread` by its socket once it accepts, and when it is
+  // destroyed. Connections are only handed to registered threads.
+  void Register(int thread, base::WeakPtr<NaiveBalancedServerSocket> socket);
+  void Unregister(int thread);
+
+  // Hands `socket` to the least loaded registered thread, and counts it
+  // there. Returns `socket` back if that is the calling `thread`.
+  std::unique_ptr<TCPSocket> HandOff(int thread,
+                                     std::unique_ptr<TCPSocket> socket,
+                                     const IPEndPoint& peer_address);
+
+ private:
+  friend class base::RefCountedThreadSafe<NaiveAcceptBalancer>;
+  ~NaiveAcceptBalancer();
+
+  struct Target {
+    Target();
+    Target(const Target&);
+    Target& operator=(const Target&);
+    ~Target();
+
+    scoped_refptr<base::SequencedTaskRunner> task_runner;
+    base::WeakPtr<NaiveBalancedServerSocket> socket;
+  };
+
+  const scoped_refptr<NaiveThreadLoads> loads_;
+  base::Lock lock_;
+  // Indexed by thread. Without a task runner while not registered.
+  std::vector<Target> targets_ GUARDED_BY(lock_);
+  // Rotates the thread that wins ties, as between idle threads.
+  size_t next_tie_break_ GUARDED_BY(lock_) = 0;
+};
+
+// The listen socket of one thread of a balanced listener. Accept() gives
+// the connections handed to the thread. The socket of thread 0 also owns
+// the listen socket and keeps accepting from it, whether or not its own
+// thread accepts, so the other threads are not held up by it.
+class NaiveBalancedServerSocket : public ServerSocket {
+ public:
+  // `listen_socket` is only given to the socket of thread 0.
+  NaiveBalancedServerSocket(scoped_refptr<NaiveAcceptBalancer> balancer,
+                            int thread,
+                            std::unique_ptr<TCPServerSocket> listen_socket);
+  NaiveBalancedServerSocket(const NaiveBalancedServerSocket&) = delete;
+  NaiveBalancedServerSocket& operator=(const NaiveBalancedServerSocket&) =
+      delete;
+  ~NaiveBalancedServerSocket() override;
+
+  // ServerSocket implementation.
+  int Listen(const IPEndPoint& address,
+             int backlog,
+             std::optional<bool> ipv6_only) override;
+  int GetLocalAddress(IPEndPoint* address) const override;
+  int Accept(std::unique_ptr<StreamSocket>* socket,
+             CompletionOnceCallback callback) override;
+  int Accept(std::unique_ptr<StreamSocket>* socket,
+             CompletionOnceCallback callback,
+             IPEndPoint* peer_address) override;
+
+  // Queues a connection handed to this thread. Called on the thread.
+  void Deliver(std::unique_ptr<TCPSocket> socket,
+               const IPEndPoint& peer_address);
+
+ private:
+  void DoAcceptLoop();
+  void OnAcceptComplete(int result);
+  // Returns true if accepting goes on.
+  bool HandleAcceptResult(int result);
+  bool TakeConnection(std::unique_ptr<StreamSocket>* socket,
+                      IPEndPoint* peer_address);
+
+  const scoped_refptr<NaiveAcceptBalancer> balancer_;
+  const int thread_;
+  std::unique_ptr<TCPServerSocket> listen_socket_;
+  bool registered_ = false;
+
+  std::unique_ptr<TCPSocket> accepted_socket_;
+  IPEndPoint accepted_peer_address_;
+  base::OneShotTimer accept_retry_timer_;
+  // Doubles while accepting keeps failing.
+  base::TimeDelta accept_retry_delay_;
+
+  base::circular_deque<std::pair<std::unique_ptr<TCPSocket>, IPEndPoint>>
+      queue_;
+  raw_ptr<std::unique_ptr<StreamSocket>> accept_socket_ = nullptr;
+  raw_ptr<IPEndPoint> accept_peer_address_ = nullptr;
+  CompletionOnceCallback accept_callback_;
+
+  base::WeakPtrFactory<NaiveBalancedServerSocket> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_ACCEPT_BALANCER_H_
@@ -0,0 +1,160 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_access_log.h"
+
+#include <atomic>
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/functional/bind.h"
+#include "base/json/string_escape.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/memory/ref_counted.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/task/sequenced_task_runner.h"
+#include "base/task/thread_pool.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_errors.h"
+
+namespace net {
+
+namespace {
+// A batch is handed over once it reaches this size, or this old.
+constexpr size_t kFlushBytes = 16 * 1024;
+constexpr int kFlushDelaySeconds = 1;
+// Batches are dropped while this many bytes wait to be written.
+constexpr size_t kMaxPendingBytes = 4 * 1024 * 1024;
+}  // namespace
+
+class NaiveAccessLog::Core : public base::RefCountedThreadSafe<Core> {
+ public:
+  explicit Core(base::File file) : file_(std::move(file)) {}
+  Core(const Core&) = delete;
+  Core& operator=(const Core&) = delete;
+
+  // Returns false if the lines are to be dropped.
+  bool Reserve(size_t size) {
+    size_t pending = pending_bytes_.fetch_add(size, std::memory_order_relaxed);
+    if (pending + size > kMaxPendingBytes) {
+      pending_bytes_.fetch_sub(size, std::memory_order_relaxed);
+      uint64_t dropped =
+          dropped_batches_.fetch_add(1, std::memory_order_relaxed);
+      if (dropped == 0)
+        LOG(WARNING) << "Access log falling behind, dropping entries";
+      return false;
+    }
+    return true;
+  }
+
+  void Write(std::string lines) {
+    if (file_.WriteAtCurrentPos(lines.data(), lines.size()) < 0 &&
+        !write_failed_) {
+      write_failed_ = true;
+      LOG(WARNING) << "Failed to write access log: "
+                   << base::File::ErrorToString(base::File::GetLastFileError());
+    }
+    pending_bytes_.fetch_sub(lines.size(), std::memory_order_relaxed);
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<Core>;
+  ~Core() = default;
+
+  // Only used on the writing sequence.
+  base::File file_;
+  bool write_failed_ = false;
+
+  std::atomic<size_t> pending_bytes_ = 0;
+  std::atomic<uint64_t> dropped_batches_ = 0;
+};
+
+NaiveAccessLog::Buffer::Buffer(NaiveAccessLog* log, int sample_rate)
+    : log_(log), sample_rate_(sample_rate) {
+  DCHECK(log_);
+  DCHECK_GT(sample_rate_, 0);
+}
+
+NaiveAccessLog::Buffer::~Buffer() {
+  Flush();
+}
+
+bool NaiveAccessLog::Buffer::Sample() {
+  return num_closed_++ % sample_rate_ == 0;
+}
+
+void NaiveAccessLog::Buffer::Add(const Entry& entry) {
+  base::StringAppendF(
+      &lines_, "{\"time\":%lld,\"id\":%llu,\"proto\":\"%s\",\"origin\":",
+      static_cast<long long>(
+          base::Time::Now().InMillisecondsSinceUnixEpoch()),
+      static_cast<unsigned long long>(entry.id), ToString(entry.protocol));
+  if (entry.origin && !entry.origin->IsEmpty()) {
+    base::EscapeJSONString(entry.origin->ToString(), /*put_in_quotes=*/true,
+                           &lines_);
+  } else {
+    lines_ += "null";
+  }
+  if (entry.user && !entry.user->empty()) {
+    lines_ += ",\"user\":";
+    base::EscapeJSONString(*entry.user, /*put_in_quotes=*/true, &lines_);
+  }
+  base::StringAppendF(&lines_, ",\"result\":\"%s\"",
+                      ErrorToShortString(entry.result).c_str());
+  if (!entry.connect_time.is_negative()) {
+    base::StringAppendF(&lines_, ",\"connect_ms\":%lld",
+                        static_cast<long long>(
+                            entry.connect_time.InMilliseconds()));
+  }
+  base::StringAppendF(
+      &lines_, ",\"duration_ms\":%lld,\"up\":%lld,\"down\":%lld}\n",
+      static_cast<long long>(entry.duration.InMilliseconds()),
+      static_cast<long long>(entry.bytes_up),
+      static_cast<long long>(entry.bytes_down));
+
+  if (lines_.size() >= kFlushBytes) {
+    Flush();
+  } else if (!flush_timer_.IsRunning()) {
+    flush_timer_.Start(FROM_HERE, base::Seconds(kFlushDelaySeconds),
+                       base::BindOnce(&Buffer::Flush, base::Unretained(this)));
+  }
+}
+
+void NaiveAccessLog::Buffer::Flush() {
+  flush_timer_.Stop();
+  if (lines_.empty())
+    return;
+  log_->Append(std::move(lines_));
+  lines_.clear();
+}
+
+// static
+std::unique_ptr<NaiveAccessLog> NaiveAccessLog::Open(
+    const base::FilePath& path) {
+  base::File file(path, base::File::FLAG_OPEN_ALWAYS | base::File::FLAG_APPEND);
+  if (!file.IsValid()) {
+    LOG(ERROR) << "Failed to open " << path << ": "
+               << base::File::ErrorToString(file.error_details());
+    return nullptr;
+  }
+  return base::WrapUnique(new NaiveAccessLog(std::move(file)));
+}
+
+NaiveAccessLog::NaiveAccessLog(base::File file)
+    : core_(base::MakeRefCounted<Core>(std::move(file))),
+      task_runner_(base::ThreadPool::CreateSequencedTaskRunner(
+          {base::MayBlock(), base::TaskPriority::BEST_EFFORT,
+           base::TaskShutdownBehavior::BLOCK_SHUTDOWN})) {}
+
+NaiveAccessLog::~NaiveAccessLog() = default;
+
+void NaiveAccessLog::Append(std::string lines) {
+  if (!core_->Reserve(lines.size()))
+    return;
+  task_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&Core::Write, core_, std::move(lines)));
+}
+
+}  // namespace net
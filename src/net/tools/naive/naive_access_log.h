@@ -0,0 +1,95 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_ACCESS_LOG_H_
+#define NET_TOOLS_NAIVE_NAIVE_ACCESS_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/tools/naive/naive_protocol.h"
+
+namespace base {
+class SequencedTaskRunner;
+}  // namespace base
+
+namespace net {
+
+class HostPortPair;
+
+// Appends one JSON line per closed connection to a file, written on a
+// ThreadPool sequence so the IO threads never wait for the disk. Each IO
+// thread collects its lines in its own Buffer without locking, and hands
+// them over in batches.
+class NaiveAccessLog {
+ public:
+  struct Entry {
+    uint64_t id = 0;
+    ClientProtocol protocol = ClientProtocol::kSocks5;
+    // Empty for SOCKS5 UDP associations.
+    const HostPortPair* origin = nullptr;
+    // The user the client authenticated as. Null or empty if none.
+    const std::string* user = nullptr;
+    int result = 0;
+    // Negative if the server side never connected.
+    base::TimeDelta connect_time = base::TimeDelta::Min();
+    base::TimeDelta duration;
+    // Read from the client and from the server.
+    int64_t bytes_up = 0;
+    int64_t bytes_down = 0;
+  };
+
+  // Batches the lines of one thread. Must be used and destroyed on the
+  // thread that created it.
+  class Buffer {
+   public:
+    // Records one in `sample_rate` closed connections.
+    Buffer(NaiveAccessLog* log, int sample_rate);
+    ~Buffer();
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    // Counts a closed connection, and returns whether it is sampled.
+    bool Sample();
+    // Adds the line of a sampled connection.
+    void Add(const Entry& entry);
+
+   private:
+    void Flush();
+
+    NaiveAccessLog* log_;
+    const int sample_rate_;
+    uint64_t num_closed_ = 0;
+    std::string lines_;
+    base::OneShotTimer flush_timer_;
+  };
+
+  // Returns null if `path` cannot be opened for appending.
+  static std::unique_ptr<NaiveAccessLog> Open(const base::FilePath& path);
+
+  ~NaiveAccessLog();
+  NaiveAccessLog(const NaiveAccessLog&) = delete;
+  NaiveAccessLog& operator=(const NaiveAccessLog&) = delete;
+
+  // Can be called on any thread. Drops `lines` if too many bytes are still
+  // waiting to be written.
+  void Append(std::string lines);
+
+ private:
+  class Core;
+
+  explicit NaiveAccessLog(base::File file);
+
+  scoped_refptr<Core> core_;
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_ACCESS_LOG_H_
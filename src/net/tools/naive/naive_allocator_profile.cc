@@ -0,0 +1,87 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_allocator_profile.h"
+
+#include <atomic>
+
+#include "partition_alloc/partition_alloc_buildflags.h"
+
+#if PA_BUILDFLAG(USE_PARTITION_ALLOC_AS_MALLOC)
+#include "partition_alloc/partition_alloc_config.h"
+#include "partition_alloc/partition_stats.h"
+#include "partition_alloc/thread_cache.h"
+#endif
+
+namespace net {
+namespace {
+// Set by ApplyAllocatorProfile() before the IO threads start.
+std::atomic_bool g_purge_when_idle = false;
+}  // namespace
+
+std::optional<NaiveAllocatorProfile> ParseAllocatorProfile(
+    std::string_view str) {
+  if (str == "default") {
+    return NaiveAllocatorProfile::kDefault;
+  } else if (str == "throughput") {
+    return NaiveAllocatorProfile::kThroughput;
+  } else if (str == "low-memory") {
+    return NaiveAllocatorProfile::kLowMemory;
+  }
+  return std::nullopt;
+}
+
+void ApplyAllocatorProfile(NaiveAllocatorProfile profile) {
+#if PA_BUILDFLAG(USE_PARTITION_ALLOC_AS_MALLOC) && \
+    PA_CONFIG(THREAD_CACHE_SUPPORTED)
+  using partition_alloc::ThreadCache;
+  using partition_alloc::ThreadCacheRegistry;
+  using partition_alloc::internal::base::Seconds;
+  ThreadCacheRegistry& registry = ThreadCacheRegistry::Instance();
+  switch (profile) {
+    case NaiveAllocatorProfile::kDefault:
+      break;
+    case NaiveAllocatorProfile::kThroughput:
+      // Up to 32 KiB, which covers the read buffers of TLS and HTTP/2
+      // frames.
+      ThreadCache::SetLargestCachedSize(ThreadCache::kLargeSizeThreshold);
+      registry.SetThreadCacheMultiplier(ThreadCache::kDefaultMultiplier * 2);
+      registry.SetPurgingConfiguration(Seconds(5), Seconds(60), Seconds(10),
+                                       2 * 1024 * 1024);
+      break;
+    case NaiveAllocatorProfile::kLowMemory:
+      ThreadCache::SetLargestCachedSize(ThreadCache::kDefaultSizeThreshold);
+      registry.SetThreadCacheMultiplier(ThreadCache::kDefaultMultiplier / 2);
+      registry.SetPurgingConfiguration(Seconds(1), Seconds(10), Seconds(1),
+                                       100 * 1024);
+      g_purge_when_idle.store(true, std::memory_order_relaxed);
+      break;
+  }
+#endif
+}
+
+void OnAllocatorIdle() {
+#if PA_BUILDFLAG(USE_PARTITION_ALLOC_AS_MALLOC) && \
+    PA_CONFIG(THREAD_CACHE_SUPPORTED)
+  if (g_purge_when_idle.load(std::memory_order_relaxed))
+    partition_alloc::ThreadCache::PurgeCurrentThread();
+#endif
+}
+
+std::optional<NaiveAllocatorStats> GetAllocatorStatsForCurrentThread() {
+#if PA_BUILDFLAG(USE_PARTITION_ALLOC_AS_MALLOC) && \
+    PA_CONFIG(THREAD_CACHE_SUPPORTED)
+  partition_alloc::ThreadCacheStats thread_cache_stats;
+  partition_alloc::ThreadCacheRegistry::Instance().DumpStats(
+      /*my_thread_only=*/true, &thread_cache_stats);
+  NaiveAllocatorStats stats;
+  stats.hits = thread_cache_stats.alloc_hits;
+  stats.misses = thread_cache_stats.alloc_misses;
+  stats.cached_bytes = thread_cache_stats.bucket_total_memory;
+  return stats;
+#else
+  return std::nullopt;
+#endif
+}
+
+}  // namespace net
@@ -0,0 +1,57 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_ALLOCATOR_PROFILE_H_
+#define NET_TOOLS_NAIVE_NAIVE_ALLOCATOR_PROFILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace net {
+
+// Tunes the PartitionAlloc thread caches of all threads for how naive uses
+// memory, instead of for a browser process. Relay buffers are kept by
+// NaiveBufferPool; the thread caches hold the rest: IOBuffers, callbacks,
+// and the objects of each tunnel.
+enum class NaiveAllocatorProfile {
+  // Keeps the browser process configuration.
+  kDefault,
+  // Caches allocations up to the largest size thread caches take, with
+  // twice the default bucket depth, and purges them less often.
+  kThroughput,
+  // Caches small allocations only, with half the default bucket depth, and
+  // purges a thread cache whenever a listener of its thread has no tunnels
+  // left. Meant for routers with little memory.
+  kLowMemory,
+};
+
+// Parses "default", "throughput" or "low-memory". Returns empty if `str` is
+// invalid.
+std::optional<NaiveAllocatorProfile> ParseAllocatorProfile(
+    std::string_view str);
+
+// Applies `profile` to the thread caches of all threads. Called after
+// PartitionAllocSupport::ReconfigureAfterTaskRunnerInit(), which it
+// overrides. No effect without the PartitionAlloc thread cache.
+void ApplyAllocatorProfile(NaiveAllocatorProfile profile);
+
+// Called when a listener of the current thread has no tunnels left. Purges
+// the thread cache of the current thread if the profile asks for it.
+void OnAllocatorIdle();
+
+struct NaiveAllocatorStats {
+  // Allocations served by the thread cache of the current thread, and the
+  // ones it passed on to the central allocator.
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // Memory held by the thread cache of the current thread, in bytes.
+  size_t cached_bytes = 0;
+};
+
+// Returns empty without the PartitionAlloc thread cache.
+std::optional<NaiveAllocatorStats> GetAllocatorStatsForCurrentThread();
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_ALLOCATOR_PROFILE_H_
@@ -0,0 +1,214 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_bench.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/tools/naive/naive_buffer_pool.h"
+#include "net/tools/naive/naive_protocol.h"
+#include "net/tools/naive/naive_scheduler.h"
+#include "net/tools/naive/naive_stream_tunnel.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+
+namespace net {
+
+// One tunnel to the sink. Relays in one direction only, yielding to the
+// other tunnels of the thread as the connections do.
+class NaiveBench::Tunnel {
+ public:
+  explicit Tunnel(NaiveBench* bench)
+      : bench_(bench),
+        tunnel_(bench->session_,
+                bench->proxy_selector_,
+                bench->padding_profile_,
+                bench->traffic_annotation_),
+        buffer_(base::MakeRefCounted<IOBufferWithSize>(
+            NaiveBufferPool::kBufferSize)) {
+    // Uploads these bytes over and over.
+    std::ranges::fill(buffer_->span(), 0);
+  }
+
+  ~Tunnel() = default;
+
+  Tunnel(const Tunnel&) = delete;
+  Tunnel& operator=(const Tunnel&) = delete;
+
+  int64_t bytes() const { return bytes_; }
+
+  void Connect() {
+    int rv = tunnel_.Open(bench_->params_.target,
+                          base::BindOnce(&Tunnel::OnConnectComplete,
+                                         weak_ptr_factory_.GetWeakPtr()));
+    if (rv == ERR_IO_PENDING)
+      return;
+    OnConnectComplete(rv);
+  }
+
+ private:
+  void OnConnectComplete(int result) {
+    NaiveListenerMetrics& tunnels = bench_->result_.tunnels;
+    if (result != OK) {
+      LOG(ERROR) << "Bench tunnel failed: " << ErrorToShortString(result);
+      tunnels.connect_failures++;
+      return;
+    }
+    tunnels.accepted++;
+    tunnels.AddConnectLatency(tunnel_.connect_time());
+    deficit_ = NaiveScheduler::GetQuantum();
+    DoRelay();
+  }
+
+  void DoRelay() {
+    int rv;
+    do {
+      if (bench_->params_.upload) {
+        rv = tunnel_.Write(buffer_.get(), buffer_->size(),
+                           base::BindOnce(&Tunnel::OnRelayComplete,
+                                          weak_ptr_factory_.GetWeakPtr()));
+      } else {
+        rv = tunnel_.Read(buffer_.get(), buffer_->size(),
+                          base::BindOnce(&Tunnel::OnRelayComplete,
+                                         weak_ptr_factory_.GetWeakPtr()));
+      }
+      if (rv == ERR_IO_PENDING)
+        return;
+    } while (HandleRelayResult(rv));
+  }
+
+  void OnRelayComplete(int result) {
+    if (HandleRelayResult(result))
+      DoRelay();
+  }
+
+  // Returns true if the relay goes on synchronously.
+  bool HandleRelayResult(int result) {
+    if (result <= 0) {
+      if (result == 0)
+        result = ERR_CONNECTION_CLOSED;
+      LOG(ERROR) << "Bench tunnel closed: " << ErrorToShortString(result);
+      bench_->result_.closed_early++;
+      return false;
+    }
+    bytes_ += result;
+    deficit_ -= result;
+    if (deficit_ > 0)
+      return true;
+    deficit_ += NaiveScheduler::GetQuantum();
+    NaiveScheduler::Yield(
+        base::BindOnce(&Tunnel::DoRelay, weak_ptr_factory_.GetWeakPtr()));
+    return false;
+  }
+
+  NaiveBench* bench_;
+  NaiveStreamTunnel tunnel_;
+  scoped_refptr<IOBufferWithSize> buffer_;
+  int deficit_ = 0;
+  int64_t bytes_ = 0;
+
+  base::WeakPtrFactory<Tunnel> weak_ptr_factory_{this};
+};
+
+NaiveBench::Result::Result() = default;
+NaiveBench::Result::Result(const Result&) = default;
+NaiveBench::Result& NaiveBench::Result::operator=(const Result&) = default;
+NaiveBench::Result::~Result() = default;
+
+void NaiveBench::Result::Merge(const Result& other) {
+  tunnels.Merge(other.tunnels);
+  closed_early += other.closed_early;
+  elapsed = std::max(elapsed, other.elapsed);
+}
+
+std::string NaiveBench::Result::ToString() const {
+  std::string out;
+  base::StringAppendF(&out,
+                      "Tunnels: %llu connected, %llu failed, %llu closed "
+                      "early\n",
+                      static_cast<unsigned long long>(tunnels.accepted),
+                      static_cast<unsigned long long>(tunnels.connect_failures),
+                      static_cast<unsigned long long>(closed_early));
+  for (Direction from : {kServer, kClient}) {
+    uint64_t bytes = tunnels.relayed_bytes[from];
+    if (bytes == 0)
+      continue;
+    base::StringAppendF(&out, "%s: %.1f Mbit/s (%llu bytes in %.1f s)\n",
+                        from == kServer ? "Download" : "Upload",
+                        bytes * 8 / elapsed.InSecondsF() / 1e6,
+                        static_cast<unsigned long long>(bytes),
+                        elapsed.InSecondsF());
+  }
+  if (tunnels.accepted > 0) {
+    base::StringAppendF(
+        &out, "Setup latency: mean %.1f ms\n",
+        tunnels.connect_latency_sum.InMillisecondsF() / tunnels.accepted);
+    for (size_t i = 0; i < tunnels.connect_latency_counts.size(); ++i) {
+      if (i < NaiveListenerMetrics::kConnectLatencyBucketsMs.size()) {
+        base::StringAppendF(&out, "  <= %5d ms: ",
+                            NaiveListenerMetrics::kConnectLatencyBucketsMs[i]);
+      } else {
+        base::StringAppendF(&out, "   > %5d ms: ",
+                            NaiveListenerMetrics::kConnectLatencyBucketsMs
+                                .back());
+      }
+      base::StringAppendF(
+          &out, "%llu\n",
+          static_cast<unsigned long long>(tunnels.connect_latency_counts[i]));
+    }
+  }
+  base::StringAppendF(
+      &out, "Stalls: http2=%llu quic_blocked=%llu socket_pool=%llu\n",
+      static_cast<unsigned long long>(http2_stalls),
+      static_cast<unsigned long long>(quic_blocked_frames),
+      static_cast<unsigned long long>(socket_pool_stalls));
+  return out;
+}
+
+NaiveBench::NaiveBench(const Params& params,
+                       const NaivePaddingProfile& padding_profile,
+                       HttpNetworkSession* session,
+                       NaiveProxySelector* proxy_selector,
+                       const NetworkTrafficAnnotationTag& traffic_annotation)
+    : params_(params),
+      padding_profile_(padding_profile),
+      session_(session),
+      proxy_selector_(proxy_selector),
+      traffic_annotation_(traffic_annotation) {
+  DCHECK(session_);
+  DCHECK(proxy_selector_);
+}
+
+NaiveBench::~NaiveBench() = default;
+
+void NaiveBench::Run(base::OnceCallback<void(Result)> callback) {
+  callback_ = std::move(callback);
+  start_time_ = base::TimeTicks::Now();
+  finish_timer_.Start(
+      FROM_HERE, params_.duration,
+      base::BindOnce(&NaiveBench::Finish, weak_ptr_factory_.GetWeakPtr()));
+  for (int i = 0; i < params_.connections; ++i) {
+    auto tunnel = std::make_unique<Tunnel>(this);
+    Tunnel* raw_tunnel = tunnel.get();
+    tunnels_.insert(std::move(tunnel));
+    raw_tunnel->Connect();
+  }
+}
+
+void NaiveBench::Finish() {
+  result_.elapsed = base::TimeTicks::Now() - start_time_;
+  Direction from = params_.upload ? kClient : kServer;
+  for (const auto& tunnel : tunnels_) {
+    result_.tunnels.relayed_bytes[from] += tunnel->bytes();
+  }
+  tunnels_.clear();
+  std::move(callback_).Run(result_);
+}
+
+}  // namespace net
@@ -0,0 +1,97 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_BENCH_H_
+#define NET_TOOLS_NAIVE_NAIVE_BENCH_H_
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "base/containers/unique_ptr_adapters.h"
+#include "base/functional/callback.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/host_port_pair.h"
+#include "net/tools/naive/naive_metrics.h"
+#include "net/tools/naive/naive_padding_profile.h"
+
+namespace net {
+
+class HttpNetworkSession;
+class NaiveProxySelector;
+struct NetworkTrafficAnnotationTag;
+
+// Opens tunnels to a sink through the proxy chains of a thread, the same way
+// the connections of a listener do, including their padding, and pulls data
+// from the sink or pushes data to it for a while. The sink is expected to
+// send data as soon as it accepts, or to discard what it reads.
+class NaiveBench {
+ public:
+  struct Params {
+    HostPortPair target;
+    int connections = 0;
+    base::TimeDelta duration;
+    // Pushes data to the sink instead of pulling it.
+    bool upload = false;
+  };
+
+  struct Result {
+    Result();
+    Result(const Result&);
+    Result& operator=(const Result&);
+    ~Result();
+
+    void Merge(const Result& other);
+    std::string ToString() const;
+
+    // Tunnel setup latencies and failures, and the bytes relayed, as for a
+    // listener. Bytes pulled from the sink are counted as read from the
+    // server.
+    NaiveListenerMetrics tunnels;
+    // Tunnels that connected and then failed before the end.
+    uint64_t closed_early = 0;
+    base::TimeDelta elapsed;
+
+    // Process-wide, from NaiveStallCounter.
+    uint64_t http2_stalls = 0;
+    uint64_t quic_blocked_frames = 0;
+    uint64_t socket_pool_stalls = 0;
+  };
+
+  NaiveBench(const Params& params,
+             const NaivePaddingProfile& padding_profile,
+             HttpNetworkSession* session,
+             NaiveProxySelector* proxy_selector,
+             const NetworkTrafficAnnotationTag& traffic_annotation);
+  ~NaiveBench();
+  NaiveBench(const NaiveBench&) = delete;
+  NaiveBench& operator=(const NaiveBench&) = delete;
+
+  // Runs `callback` with the result once the duration has passed.
+  void Run(base::OnceCallback<void(Result)> callback);
+
+ private:
+  class Tunnel;
+
+  void Finish();
+
+  const Params params_;
+  const NaivePaddingProfile& padding_profile_;
+  HttpNetworkSession* session_;
+  NaiveProxySelector* proxy_selector_;
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+
+  std::set<std::unique_ptr<Tunnel>, base::UniquePtrComparator> tunnels_;
+  Result result_;
+  base::TimeTicks start_time_;
+  base::OneShotTimer finish_timer_;
+  base::OnceCallback<void(Result)> callback_;
+
+  base::WeakPtrFactory<NaiveBench> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_BENCH_H_
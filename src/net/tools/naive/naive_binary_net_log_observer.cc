@@ -0,0 +1,227 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_binary_net_log_observer.h"
+
+#include <atomic>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "base/files/file.h"
+#include "base/functional/bind.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/numerics/byte_conversions.h"
+#include "base/synchronization/lock.h"
+#include "base/task/sequenced_task_runner.h"
+#include "base/task/thread_pool.h"
+#include "base/thread_annotations.h"
+#include "net/log/net_log_entry.h"
+#include "net/log/net_log_source.h"
+
+namespace net {
+
+// Appends the batches to the file on the task runner.
+class NaiveBinaryNetLogObserver::FileWriter
+    : public base::RefCountedThreadSafe<FileWriter> {
+ public:
+  explicit FileWriter(const base::FilePath& path) : path_(path) {}
+  FileWriter(const FileWriter&) = delete;
+  FileWriter& operator=(const FileWriter&) = delete;
+
+  size_t pending_bytes() const {
+    return pending_bytes_.load(std::memory_order_relaxed);
+  }
+
+  // Returns whether no batch was pending, so the caller posts WritePending().
+  bool AddPending(std::string batch) {
+    pending_bytes_.fetch_add(batch.size(), std::memory_order_relaxed);
+    base::AutoLock lock(lock_);
+    pending_.push_back(std::move(batch));
+    return pending_.size() == 1;
+  }
+
+  void WritePending() {
+    std::vector<std::string> batches;
+    {
+      base::AutoLock lock(lock_);
+      batches.swap(pending_);
+    }
+    if (!file_.IsValid() && !failed_) {
+      file_.Initialize(path_,
+                       base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
+      if (!file_.IsValid()) {
+        LOG(ERROR) << "Failed to open " << path_ << ": "
+                   << base::File::ErrorToString(file_.error_details());
+        failed_ = true;
+      }
+    }
+    for (const std::string& batch : batches) {
+      if (file_.IsValid() && !file_.WriteAtCurrentPosAndCheck(
+                                 base::as_byte_span(batch))) {
+        LOG(ERROR) << "Failed to write " << path_;
+        file_.Close();
+        failed_ = true;
+      }
+      pending_bytes_.fetch_sub(batch.size(), std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<FileWriter>;
+  ~FileWriter() = default;
+
+  const base::FilePath path_;
+  std::atomic<size_t> pending_bytes_ = 0;
+  base::Lock lock_;
+  std::vector<std::string> pending_ GUARDED_BY(lock_);
+
+  // Only used on the task runner.
+  base::File file_;
+  bool failed_ = false;
+};
+
+NaiveBinaryNetLogObserver::NaiveBinaryNetLogObserver(
+    const base::FilePath& path,
+    const base::Value::Dict& constants)
+    : file_writer_(base::MakeRefCounted<FileWriter>(path)),
+      task_runner_(base::ThreadPool::CreateSequencedTaskRunner(
+          {base::MayBlock(), base::TaskPriority::USER_VISIBLE,
+           base::TaskShutdownBehavior::BLOCK_SHUTDOWN})) {
+  buffer_.append(kMagic, std::strlen(kMagic));
+  std::string json;
+  base::JSONWriter::Write(constants, &json);
+  AppendString(json);
+  Flush();
+}
+
+NaiveBinaryNetLogObserver::~NaiveBinaryNetLogObserver() {
+  if (net_log())
+    net_log()->RemoveObserver(this);
+  Flush();
+  if (num_dropped_ > 0) {
+    LOG(WARNING) << "Net log dropped " << num_dropped_
+                 << " events waiting for the disk";
+  }
+}
+
+void NaiveBinaryNetLogObserver::StartObserving(NetLog* net_log,
+                                               NetLogCaptureMode capture_mode) {
+  net_log->AddObserver(this, capture_mode);
+}
+
+void NaiveBinaryNetLogObserver::OnAddEntry(const NetLogEntry& entry) {
+  // Drops whole events, so the keys they would intern are not lost.
+  if (file_writer_->pending_bytes() + buffer_.size() > kMaxPendingBytes) {
+    ++num_dropped_;
+    return;
+  }
+
+  AppendVarint(static_cast<uint64_t>(entry.type));
+  AppendVarint(static_cast<uint64_t>(entry.phase));
+  AppendVarint(entry.source.id);
+  AppendVarint(static_cast<uint64_t>(entry.source.type));
+  int64_t time_ms = entry.time.since_origin().InMilliseconds();
+  AppendSignedVarint(time_ms - last_time_ms_);
+  last_time_ms_ = time_ms;
+  AppendSignedVarint(time_ms -
+                     entry.source.start_time.since_origin().InMilliseconds());
+  AppendDict(entry.params);
+
+  if (buffer_.size() >= kFlushBytes)
+    Flush();
+}
+
+void NaiveBinaryNetLogObserver::Flush() {
+  if (buffer_.empty())
+    return;
+  std::string batch;
+  batch.swap(buffer_);
+  buffer_.reserve(kFlushBytes);
+  if (file_writer_->AddPending(std::move(batch))) {
+    task_runner_->PostTask(
+        FROM_HERE, base::BindOnce(&FileWriter::WritePending, file_writer_));
+  }
+}
+
+void NaiveBinaryNetLogObserver::AppendVarint(uint64_t value) {
+  while (value >= 0x80) {
+    buffer_.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  buffer_.push_back(static_cast<char>(value));
+}
+
+void NaiveBinaryNetLogObserver::AppendSignedVarint(int64_t value) {
+  AppendVarint((static_cast<uint64_t>(value) << 1) ^
+               static_cast<uint64_t>(value >> 63));
+}
+
+void NaiveBinaryNetLogObserver::AppendString(std::string_view value) {
+  AppendVarint(value.size());
+  buffer_.append(value);
+}
+
+void NaiveBinaryNetLogObserver::AppendKey(std::string_view key) {
+  auto it = keys_.find(key);
+  if (it != keys_.end()) {
+    AppendVarint(it->second + 1);
+    return;
+  }
+  AppendVarint(0);
+  AppendString(key);
+  if (keys_.size() < kMaxKeys)
+    keys_.emplace(std::string(key), keys_.size());
+}
+
+void NaiveBinaryNetLogObserver::AppendValue(const base::Value& value) {
+  switch (value.type()) {
+    case base::Value::Type::NONE:
+      buffer_.push_back(static_cast<char>(ValueTag::kNone));
+      break;
+    case base::Value::Type::BOOLEAN:
+      buffer_.push_back(static_cast<char>(value.GetBool() ? ValueTag::kTrue
+                                                          : ValueTag::kFalse));
+      break;
+    case base::Value::Type::INTEGER:
+      buffer_.push_back(static_cast<char>(ValueTag::kInt));
+      AppendSignedVarint(value.GetInt());
+      break;
+    case base::Value::Type::DOUBLE: {
+      buffer_.push_back(static_cast<char>(ValueTag::kDouble));
+      auto bytes = base::DoubleToLittleEndian(value.GetDouble());
+      buffer_.append(bytes.begin(), bytes.end());
+      break;
+    }
+    case base::Value::Type::STRING:
+      buffer_.push_back(static_cast<char>(ValueTag::kString));
+      AppendString(value.GetString());
+      break;
+    case base::Value::Type::BINARY:
+      buffer_.push_back(static_cast<char>(ValueTag::kBinary));
+      AppendString(base::as_string_view(value.GetBlob()));
+      break;
+    case base::Value::Type::DICT:
+      buffer_.push_back(static_cast<char>(ValueTag::kDict));
+      AppendDict(value.GetDict());
+      break;
+    case base::Value::Type::LIST:
+      buffer_.push_back(static_cast<char>(ValueTag::kList));
+      AppendVarint(value.GetList().size());
+      for (const base::Value& item : value.GetList())
+        AppendValue(item);
+      break;
+  }
+}
+
+void NaiveBinaryNetLogObserver::AppendDict(const base::Value::Dict& dict) {
+  AppendVarint(dict.size());
+  for (const auto [key, value] : dict) {
+    AppendKey(key);
+    AppendValue(value);
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,103 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_BINARY_NET_LOG_OBSERVER_H_
+#define NET_TOOLS_NAIVE_NAIVE_BINARY_NET_LOG_OBSERVER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "base/files/file_path.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/values.h"
+#include "net/log/net_log.h"
+
+namespace base {
+class SequencedTaskRunner;
+}  // namespace base
+
+namespace net {
+
+// Saves NetLog events in a compact binary format instead of the JSON of
+// FileNetLogObserver, for captures under load. binary_net_log_to_json.py in
+// net/tools converts a file to the JSON that netlog-viewer reads. Events
+// are encoded as they come without building JSON, and appended to the file
+// on a ThreadPool sequence in batches of kFlushBytes. A file cut short by a
+// crash converts up to its last complete event.
+//
+// The file starts with kMagic, then the constants as JSON, prefixed with
+// their length. Each event follows as:
+//
+//   type, phase, source id, source type: varint
+//   time: zigzag varint of milliseconds since the previous event
+//   source start time: zigzag varint of milliseconds before the event
+//   params: dictionary
+//
+// Values are a tag byte, then for an int a zigzag varint, for a double 8
+// little-endian bytes, for a string its length and bytes, and for a list or
+// dictionary its length and items. Dictionary keys are interned: a key is
+// the varint 0 followed by the string the first time, up to kMaxKeys keys,
+// and its index plus one after that.
+//
+// Events are dropped while more than kMaxPendingBytes wait for the disk.
+class NaiveBinaryNetLogObserver : public NetLog::ThreadSafeObserver {
+ public:
+  static constexpr char kMagic[] = "NLB1";
+  static constexpr size_t kFlushBytes = 64 * 1024;
+  static constexpr size_t kMaxPendingBytes = 64 * 1024 * 1024;
+  static constexpr size_t kMaxKeys = 4096;
+
+  enum class ValueTag : uint8_t {
+    kNone = 0,
+    kFalse = 1,
+    kTrue = 2,
+    kInt = 3,
+    kDouble = 4,
+    kString = 5,
+    kBinary = 6,
+    kDict = 7,
+    kList = 8,
+  };
+
+  NaiveBinaryNetLogObserver(const base::FilePath& path,
+                            const base::Value::Dict& constants);
+  NaiveBinaryNetLogObserver(const NaiveBinaryNetLogObserver&) = delete;
+  NaiveBinaryNetLogObserver& operator=(const NaiveBinaryNetLogObserver&) =
+      delete;
+  // Writes the events still buffered.
+  ~NaiveBinaryNetLogObserver() override;
+
+  void StartObserving(NetLog* net_log, NetLogCaptureMode capture_mode);
+
+  // NetLog::ThreadSafeObserver:
+  void OnAddEntry(const NetLogEntry& entry) override;
+
+ private:
+  class FileWriter;
+
+  void Flush();
+
+  void AppendVarint(uint64_t value);
+  void AppendSignedVarint(int64_t value);
+  void AppendString(std::string_view value);
+  void AppendKey(std::string_view key);
+  void AppendValue(const base::Value& value);
+  void AppendDict(const base::Value::Dict& dict);
+
+  scoped_refptr<FileWriter> file_writer_;
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+  // Only used by OnAddEntry(), which NetLog serializes, and the constructor
+  // and destructor.
+  std::string buffer_;
+  int64_t last_time_ms_ = 0;
+  std::map<std::string, uint64_t, std::less<>> keys_;
+  uint64_t num_dropped_ = 0;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_BINARY_NET_LOG_OBSERVER_H_
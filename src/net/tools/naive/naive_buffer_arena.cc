@@ -0,0 +1,177 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_buffer_arena.h"
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/check_op.h"
+#include "base/logging.h"
+#include "build/build_config.h"
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace net {
+
+namespace {
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+// Maps a chunk aligned to its size. Sets `reserved_huge_page` if it comes
+// from the reserved huge pages.
+char* MapChunk(bool* reserved_huge_page) {
+  constexpr size_t kSize = NaiveBufferArena::kChunkSize;
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_2MB)
+  flags |= MAP_HUGE_2MB;
+#endif
+  void* addr = mmap(nullptr, kSize, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (addr != MAP_FAILED) {
+    *reserved_huge_page = true;
+    return static_cast<char*>(addr);
+  }
+
+  // Transparent huge pages only back aligned ranges, so maps twice the size
+  // and trims it around an aligned chunk.
+  addr = mmap(nullptr, 2 * kSize, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    DPLOG(ERROR) << "mmap";
+    return nullptr;
+  }
+  auto start = reinterpret_cast<uintptr_t>(addr);
+  uintptr_t aligned = (start + kSize - 1) & ~(kSize - 1);
+  if (aligned > start) {
+    munmap(addr, aligned - start);
+  }
+  uintptr_t end = aligned + kSize;
+  if (end < start + 2 * kSize) {
+    munmap(reinterpret_cast<void*>(end), start + 2 * kSize - end);
+  }
+  auto* chunk = reinterpret_cast<char*>(aligned);
+  // Without transparent huge pages, the chunk is still usable.
+  madvise(chunk, kSize, MADV_HUGEPAGE);
+  *reserved_huge_page = false;
+  return chunk;
+}
+
+// Makes the pages of `chunk`, not yet touched, prefer the NUMA node of the
+// current CPU. Returns the node, or -1.
+int BindToCurrentNode(char* chunk) {
+  unsigned cpu;
+  unsigned node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+    return -1;
+  }
+  constexpr unsigned kBitsPerLong = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> nodemask(node / kBitsPerLong + 1);
+  nodemask[node / kBitsPerLong] = 1UL << (node % kBitsPerLong);
+  // Preferred rather than bound, so the pages come from another node once
+  // this one runs out. Fails without NUMA support, which leaves the pages to
+  // the node of the CPU that touches them first.
+  if (syscall(SYS_mbind, chunk, NaiveBufferArena::kChunkSize, MPOL_PREFERRED,
+              nodemask.data(), nodemask.size() * kBitsPerLong + 1, 0) != 0) {
+    return -1;
+  }
+  return static_cast<int>(node);
+}
+#endif
+
+}  // namespace
+
+NaiveBufferArena::NaiveBufferArena() = default;
+
+NaiveBufferArena::~NaiveBufferArena() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK_EQ(stats_.slots_in_use, 0u);
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  for (const auto& [address, chunk] : chunks_) {
+    munmap(reinterpret_cast<void*>(address), kChunkSize);
+  }
+#endif
+}
+
+base::span<char> NaiveBufferArena::Allocate(int slot_size) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK_GT(slot_size, 0);
+  DCHECK_EQ(slot_size & (slot_size - 1), 0);
+  DCHECK_LE(static_cast<size_t>(slot_size), kChunkSize);
+
+  std::vector<char*>& free_slots = free_slots_[slot_size];
+  if (free_slots.empty() && !AddChunk(slot_size)) {
+    return {};
+  }
+  char* slot = free_slots.back();
+  free_slots.pop_back();
+  chunks_[reinterpret_cast<uintptr_t>(slot) & ~(kChunkSize - 1)].free_slots--;
+  stats_.slots_in_use++;
+  return base::span<char>(slot, static_cast<size_t>(slot_size));
+}
+
+void NaiveBufferArena::Free(base::span<char> slot) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+  auto it = chunks_.find(reinterpret_cast<uintptr_t>(slot.data()) &
+                         ~(kChunkSize - 1));
+  CHECK(it != chunks_.end());
+  DCHECK_EQ(static_cast<size_t>(it->second.slot_size), slot.size());
+  it->second.free_slots++;
+  free_slots_[it->second.slot_size].push_back(slot.data());
+  stats_.slots_in_use--;
+}
+
+void NaiveBufferArena::ReleaseFreeChunks() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  base::EraseIf(chunks_, [&](const auto& entry) {
+    const auto& [address, chunk] = entry;
+    if (chunk.free_slots != kChunkSize / chunk.slot_size) {
+      return false;
+    }
+    std::erase_if(free_slots_[chunk.slot_size], [&](char* slot) {
+      return (reinterpret_cast<uintptr_t>(slot) & ~(kChunkSize - 1)) ==
+             address;
+    });
+    munmap(reinterpret_cast<void*>(address), kChunkSize);
+    stats_.chunks--;
+    if (chunk.reserved_huge_page) {
+      stats_.reserved_huge_pages--;
+    }
+    return true;
+  });
+#endif
+}
+
+bool NaiveBufferArena::AddChunk(int slot_size) {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  bool reserved_huge_page;
+  char* address = MapChunk(&reserved_huge_page);
+  if (!address) {
+    return false;
+  }
+  stats_.node = BindToCurrentNode(address);
+  stats_.chunks++;
+  if (reserved_huge_page) {
+    stats_.reserved_huge_pages++;
+  }
+  size_t num_slots = kChunkSize / slot_size;
+  chunks_[reinterpret_cast<uintptr_t>(address)] =
+      Chunk{slot_size, num_slots, reserved_huge_page};
+  // Handed out from the start of the chunk, the end of the list.
+  std::vector<char*>& free_slots = free_slots_[slot_size];
+  for (size_t i = num_slots; i > 0; --i) {
+    free_slots.push_back(address + (i - 1) * slot_size);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace net
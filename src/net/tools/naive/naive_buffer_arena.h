@@ -0,0 +1,84 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_BUFFER_ARENA_H_
+#define NET_TOOLS_NAIVE_NAIVE_BUFFER_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "base/containers/flat_map.h"
+#include "base/containers/span.h"
+#include "base/memory/ref_counted.h"
+#include "base/sequence_checker.h"
+
+namespace net {
+
+// Relay buffer slots carved out of chunks of kChunkSize bytes, each backed by
+// one huge page, so that the buffers of a busy thread take few TLB entries.
+// A chunk is mapped with MAP_HUGETLB if the system has huge pages reserved,
+// and is otherwise aligned and marked with MADV_HUGEPAGE for transparent huge
+// pages. Each chunk prefers the NUMA node of the CPU the thread runs on when
+// it is mapped, so the buffers stay local to the thread relaying them and to
+// the NIC queues steered to it.
+//
+// A chunk holds slots of one size. Freed slots are kept for reuse, and
+// chunks are only unmapped by ReleaseFreeChunks() once all their slots are
+// free. The buffers handed out hold a reference, so the chunks outlive the
+// pool that owns the arena. Used on one thread only, Linux only.
+class NaiveBufferArena : public base::RefCounted<NaiveBufferArena> {
+ public:
+  static constexpr size_t kChunkSize = 2 * 1024 * 1024;
+
+  struct Stats {
+    // Chunks mapped, and of those, the ones backed by reserved huge pages
+    // rather than transparent ones.
+    size_t chunks = 0;
+    size_t reserved_huge_pages = 0;
+    // Slots handed out and not yet freed.
+    size_t slots_in_use = 0;
+    // NUMA node of the last chunk mapped, or -1 if unknown.
+    int node = -1;
+  };
+
+  NaiveBufferArena();
+  NaiveBufferArena(const NaiveBufferArena&) = delete;
+  NaiveBufferArena& operator=(const NaiveBufferArena&) = delete;
+
+  // Returns a slot of `slot_size` bytes, a power of two up to kChunkSize, or
+  // an empty span if no chunk could be mapped.
+  base::span<char> Allocate(int slot_size);
+
+  // Gives back a slot returned by Allocate().
+  void Free(base::span<char> slot);
+
+  // Unmaps the chunks whose slots are all free.
+  void ReleaseFreeChunks();
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  friend class base::RefCounted<NaiveBufferArena>;
+
+  struct Chunk {
+    int slot_size;
+    size_t free_slots;
+    bool reserved_huge_page;
+  };
+
+  ~NaiveBufferArena();
+
+  bool AddChunk(int slot_size);
+
+  // By the address of the chunk, which is aligned to kChunkSize.
+  base::flat_map<uintptr_t, Chunk> chunks_;
+  // By slot size.
+  base::flat_map<int, std::vector<char*>> free_slots_;
+  Stats stats_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_BUFFER_ARENA_H_
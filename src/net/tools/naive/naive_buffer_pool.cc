@@ -0,0 +1,165 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_buffer_pool.h"
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/check_op.h"
+#include "net/base/io_buffer.h"
+#include "third_party/abseil-cpp/absl/base/attributes.h"
+
+namespace net {
+
+namespace {
+ABSL_CONST_INIT thread_local NaiveBufferPool* current_pool = nullptr;
+}  // namespace
+
+class NaiveBufferPool::PooledIOBuffer : public IOBuffer {
+ public:
+  PooledIOBuffer(int size_class,
+                 base::HeapArray<char> storage,
+                 base::WeakPtr<NaiveBufferPool> pool)
+      : IOBuffer(storage.as_span()),
+        size_class_(size_class),
+        storage_(std::move(storage)),
+        pool_(std::move(pool)) {}
+
+ private:
+  ~PooledIOBuffer() override {
+    // Clear pointer before this destructor makes it dangle.
+    data_ = nullptr;
+    if (pool_) {
+      pool_->Recycle(size_class_, std::move(storage_));
+    }
+  }
+
+  int size_class_;
+  base::HeapArray<char> storage_;
+  base::WeakPtr<NaiveBufferPool> pool_;
+};
+
+// Holds a reference to the arena rather than to the pool, so the slot stays
+// mapped and goes back to the arena whenever it is dropped.
+class NaiveBufferPool::ArenaIOBuffer : public IOBuffer {
+ public:
+  ArenaIOBuffer(base::span<char> slot, scoped_refptr<NaiveBufferArena> arena)
+      : IOBuffer(slot), arena_(std::move(arena)) {}
+
+ private:
+  ~ArenaIOBuffer() override {
+    base::span<char> slot = span();
+    // Clear pointer before this destructor makes it dangle.
+    data_ = nullptr;
+    arena_->Free(slot);
+  }
+
+  scoped_refptr<NaiveBufferArena> arena_;
+};
+
+NaiveBufferPool::NaiveBufferPool(size_t max_cached_buffers,
+                                 int max_relay_buffer_size,
+                                 bool huge_pages)
+    : max_cached_buffers_(max_cached_buffers),
+      max_relay_buffer_size_(max_relay_buffer_size) {
+  if (huge_pages) {
+    arena_ = base::MakeRefCounted<NaiveBufferArena>();
+  }
+  DCHECK_EQ(kMinBufferSize << GetSizeClass(max_relay_buffer_size),
+            max_relay_buffer_size);
+  CHECK_EQ(current_pool, nullptr);
+  current_pool = this;
+}
+
+NaiveBufferPool::~NaiveBufferPool() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  DCHECK_EQ(current_pool, this);
+  current_pool = nullptr;
+}
+
+// static
+NaiveBufferPool* NaiveBufferPool::GetForCurrentThread() {
+  return current_pool;
+}
+
+// static
+scoped_refptr<IOBuffer> NaiveBufferPool::Acquire(int size) {
+  DCHECK_GT(size, 0);
+  if (current_pool == nullptr || size > kBufferSize) {
+    return base::MakeRefCounted<IOBufferWithSize>(size);
+  }
+  return current_pool->AcquireBuffer(GetSizeClass(size));
+}
+
+// static
+int NaiveBufferPool::GetMaxRelayBufferSize() {
+  if (current_pool == nullptr) {
+    return kBufferSize;
+  }
+  return current_pool->max_relay_buffer_size_;
+}
+
+// static
+int NaiveBufferPool::GetSizeClass(int size) {
+  int size_class = 0;
+  while ((kMinBufferSize << size_class) < size) {
+    ++size_class;
+  }
+  DCHECK_LT(size_class, kNumSizeClasses);
+  return size_class;
+}
+
+scoped_refptr<IOBuffer> NaiveBufferPool::AcquireBuffer(int size_class) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+  if (arena_) {
+    base::span<char> slot = arena_->Allocate(kMinBufferSize << size_class);
+    if (!slot.empty()) {
+      return base::MakeRefCounted<ArenaIOBuffer>(slot, arena_);
+    }
+  }
+
+  std::vector<base::HeapArray<char>>& free_list = free_lists_[size_class];
+  base::HeapArray<char> storage;
+  if (!free_list.empty()) {
+    storage = std::move(free_list.back());
+    free_list.pop_back();
+    ++stats_.reused;
+    --stats_.cached;
+  } else {
+    storage = base::HeapArray<char>::Uninit(kMinBufferSize << size_class);
+    ++stats_.allocated;
+  }
+  return base::MakeRefCounted<PooledIOBuffer>(
+      size_class, std::move(storage), weak_ptr_factory_.GetWeakPtr());
+}
+
+void NaiveBufferPool::ReleaseFreeBuffers() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+  for (std::vector<base::HeapArray<char>>& free_list : free_lists_) {
+    stats_.dropped += free_list.size();
+    stats_.cached -= free_list.size();
+    free_list.clear();
+    free_list.shrink_to_fit();
+  }
+  if (arena_) {
+    arena_->ReleaseFreeChunks();
+  }
+}
+
+void NaiveBufferPool::Recycle(int size_class, base::HeapArray<char> storage) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+  std::vector<base::HeapArray<char>>& free_list = free_lists_[size_class];
+  if (free_list.size() >= max_cached_buffers_) {
+    ++stats_.dropped;
+    return;
+  }
+  free_list.push_back(std::move(storage));
+  ++stats_.recycled;
+  ++stats_.cached;
+}
+
+}  // namespace net
@@ -0,0 +1,106 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_BUFFER_POOL_H_
+#define NET_TOOLS_NAIVE_NAIVE_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "base/containers/heap_array.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/threading/thread_checker.h"
+#include "net/tools/naive/naive_buffer_arena.h"
+
+namespace net {
+
+class IOBuffer;
+
+// Per-thread free lists of relay buffers, one per power-of-two size class
+// from kMinBufferSize to kBufferSize. Buffers handed out by Acquire() go back
+// to the free list of the pool of their thread when the last reference is
+// dropped, instead of returning the memory to the allocator.
+//
+// With huge pages, the buffers are slots of a NaiveBufferArena of the pool
+// instead, kept there when dropped, and come from the heap only if no chunk
+// can be mapped.
+//
+// At most one pool is installed per thread, for the lifetime of the pool.
+class NaiveBufferPool {
+ public:
+  static constexpr int kMinBufferSize = 4 * 1024;
+  static constexpr int kBufferSize = 64 * 1024;
+  static constexpr int kNumSizeClasses = 5;
+  static_assert(kMinBufferSize << (kNumSizeClasses - 1) == kBufferSize);
+
+  struct Stats {
+    // Buffers allocated from the heap.
+    uint64_t allocated = 0;
+    // Buffers served from the free list.
+    uint64_t reused = 0;
+    // Buffers put back on the free list.
+    uint64_t recycled = 0;
+    // Buffers freed because the free list was full.
+    uint64_t dropped = 0;
+    // Buffers currently on the free list.
+    size_t cached = 0;
+  };
+
+  // `max_cached_buffers`: Maximum number of free buffers kept by this pool
+  //   per size class.
+  // `max_relay_buffer_size`: Size up to which the relay buffers of tunnels
+  //   on this thread grow, a size class.
+  // `huge_pages`: Whether to take buffers from a NaiveBufferArena.
+  NaiveBufferPool(size_t max_cached_buffers,
+                  int max_relay_buffer_size,
+                  bool huge_pages = false);
+  ~NaiveBufferPool();
+  NaiveBufferPool(const NaiveBufferPool&) = delete;
+  NaiveBufferPool& operator=(const NaiveBufferPool&) = delete;
+
+  // Returns the pool installed on the current thread, or null.
+  static NaiveBufferPool* GetForCurrentThread();
+
+  // Returns a buffer of at least `size` bytes. If the current thread has a
+  // pool and `size` is at most kBufferSize, the buffer comes from the pool and
+  // its size is rounded up to the size class. Otherwise allocates a plain
+  // buffer of `size` bytes.
+  static scoped_refptr<IOBuffer> Acquire(int size);
+
+  // Returns the size up to which relay buffers grow on the current thread,
+  // kBufferSize without a pool.
+  static int GetMaxRelayBufferSize();
+
+  const Stats& stats() const { return stats_; }
+
+  // Null without huge pages.
+  const NaiveBufferArena* arena() const { return arena_.get(); }
+
+  // Frees the buffers on the free lists, and the chunks of the arena with no
+  // buffer in use, as under memory pressure.
+  void ReleaseFreeBuffers();
+
+ private:
+  class PooledIOBuffer;
+  class ArenaIOBuffer;
+
+  static int GetSizeClass(int size);
+
+  scoped_refptr<IOBuffer> AcquireBuffer(int size_class);
+  void Recycle(int size_class, base::HeapArray<char> storage);
+
+  const size_t max_cached_buffers_;
+  const int max_relay_buffer_size_;
+  std::vector<base::HeapArray<char>> free_lists_[kNumSizeClasses];
+  scoped_refptr<NaiveBufferArena> arena_;
+  Stats stats_;
+
+  THREAD_CHECKER(thread_checker_);
+
+  base::WeakPtrFactory<NaiveBufferPool> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_BUFFER_POOL_H_
@@ -0,0 +1,264 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_cert_verify_store.h"
+
+#include <algorithm>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "base/base64.h"
+#include "base/files/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/values.h"
+#include "net/base/hash_value.h"
+#include "net/cert/crl_set.h"
+#include "net/cert/ct_policy_status.h"
+#include "net/cert/x509_certificate.h"
+#include "net/cert/x509_util.h"
+
+namespace net {
+namespace {
+constexpr int kFileVersion = 1;
+
+// Returns the earliest expiry of the certificates of `cert`.
+base::Time ChainExpiry(const X509Certificate& cert) {
+  base::Time expiry = cert.valid_expiry();
+  for (const auto& buffer : cert.intermediate_buffers()) {
+    scoped_refptr<X509Certificate> intermediate =
+        X509Certificate::CreateFromBuffer(bssl::UpRef(buffer.get()), {});
+    if (!intermediate)
+      return base::Time();
+    expiry = std::min(expiry, intermediate->valid_expiry());
+  }
+  return expiry;
+}
+
+std::string TimeToString(base::Time time) {
+  return base::NumberToString(time.ToTimeT());
+}
+
+bool StringToTime(const std::string* str, base::Time* time) {
+  int64_t value;
+  if (!str || !base::StringToInt64(*str, &value))
+    return false;
+  *time = base::Time::FromTimeT(static_cast<time_t>(value));
+  return true;
+}
+
+std::optional<CertVerifyResult> ResultFromDict(const base::Value::Dict& dict) {
+  const base::Value::List* certs = dict.FindList("certs");
+  const base::Value::List* hashes = dict.FindList("public_key_hashes");
+  std::optional<int> cert_status = dict.FindInt("cert_status");
+  std::optional<int> policy_compliance = dict.FindInt("policy_compliance");
+  constexpr int kPolicyComplianceCount =
+      static_cast<int>(ct::CTPolicyCompliance::CT_POLICY_COUNT);
+  if (!certs || certs->empty() || !hashes || !cert_status ||
+      !policy_compliance || *policy_compliance < 0 ||
+      *policy_compliance >= kPolicyComplianceCount) {
+    return std::nullopt;
+  }
+
+  std::vector<std::string> der_certs;
+  for (const base::Value& value : *certs) {
+    std::string der_cert;
+    if (!value.is_string() || !base::Base64Decode(value.GetString(), &der_cert))
+      return std::nullopt;
+    der_certs.push_back(std::move(der_cert));
+  }
+  std::vector<std::string_view> der_cert_views(der_certs.begin(),
+                                               der_certs.end());
+
+  CertVerifyResult result;
+  result.verified_cert =
+      X509Certificate::CreateFromDERCertChain(der_cert_views);
+  if (!result.verified_cert ||
+      result.verified_cert->intermediate_buffers().size() + 1 !=
+          der_certs.size()) {
+    return std::nullopt;
+  }
+  for (const base::Value& value : *hashes) {
+    HashValue hash;
+    if (!value.is_string() || !hash.FromString(value.GetString()))
+      return std::nullopt;
+    result.public_key_hashes.push_back(hash);
+  }
+  result.cert_status = static_cast<CertStatus>(*cert_status);
+  result.has_sha1 = dict.FindBool("has_sha1").value_or(false);
+  result.is_issued_by_known_root =
+      dict.FindBool("is_issued_by_known_root").value_or(false);
+  result.is_issued_by_additional_trust_anchor =
+      dict.FindBool("is_issued_by_additional_trust_anchor").value_or(false);
+  result.policy_compliance =
+      static_cast<ct::CTPolicyCompliance>(*policy_compliance);
+  return result;
+}
+
+base::Value::Dict ResultToDict(const CertVerifyResult& result) {
+  base::Value::List certs;
+  certs.Append(base::Base64Encode(x509_util::CryptoBufferAsSpan(
+      result.verified_cert->cert_buffer())));
+  for (const auto& buffer : result.verified_cert->intermediate_buffers()) {
+    certs.Append(
+        base::Base64Encode(x509_util::CryptoBufferAsSpan(buffer.get())));
+  }
+  base::Value::List hashes;
+  for (const HashValue& hash : result.public_key_hashes) {
+    hashes.Append(hash.ToString());
+  }
+
+  base::Value::Dict dict;
+  dict.Set("certs", std::move(certs));
+  dict.Set("public_key_hashes", std::move(hashes));
+  dict.Set("cert_status", static_cast<int>(result.cert_status));
+  dict.Set("has_sha1", result.has_sha1);
+  dict.Set("is_issued_by_known_root", result.is_issued_by_known_root);
+  dict.Set("is_issued_by_additional_trust_anchor",
+           result.is_issued_by_additional_trust_anchor);
+  dict.Set("policy_compliance", static_cast<int>(result.policy_compliance));
+  return dict;
+}
+}  // namespace
+
+NaiveCertVerifyStore::Entry::Entry() = default;
+
+NaiveCertVerifyStore::Entry::Entry(const Entry&) = default;
+
+NaiveCertVerifyStore::Entry& NaiveCertVerifyStore::Entry::operator=(
+    const Entry&) = default;
+
+NaiveCertVerifyStore::Entry::~Entry() = default;
+
+NaiveCertVerifyStore::NaiveCertVerifyStore(const base::FilePath& path)
+    : path_(path),
+      writer_(path),
+      crl_set_sequence_(CRLSet::BuiltinCRLSet()->sequence()) {}
+
+NaiveCertVerifyStore::~NaiveCertVerifyStore() = default;
+
+size_t NaiveCertVerifyStore::Load() {
+  std::string data;
+  if (!base::ReadFileToString(path_, &data))
+    return 0;
+  std::optional<base::Value::Dict> dict = base::JSONReader::ReadDict(data);
+  if (!dict || dict->FindInt("version") != kFileVersion) {
+    LOG(WARNING) << "Ignoring invalid certificate verification file "
+                 << path_;
+    return 0;
+  }
+  // Verifications made before a CRLSet update may cover revoked certificates.
+  const std::string* crl_set_sequence = dict->FindString("crl_set_sequence");
+  if (!crl_set_sequence ||
+      *crl_set_sequence != base::NumberToString(crl_set_sequence_)) {
+    return 0;
+  }
+  const base::Value::Dict* verifications = dict->FindDict("verifications");
+  if (!verifications)
+    return 0;
+
+  base::Time now = base::Time::Now();
+  base::AutoLock lock(lock_);
+  for (const auto [key, value] : *verifications) {
+    const base::Value::Dict* entry_dict = value.GetIfDict();
+    if (!entry_dict || entries_.size() >= kMaxEntries)
+      continue;
+    const base::Value::Dict* result_dict = entry_dict->FindDict("result");
+    Entry entry;
+    if (!result_dict ||
+        !StringToTime(entry_dict->FindString("verification_time"),
+                      &entry.verification_time) ||
+        !StringToTime(entry_dict->FindString("expiration"),
+                      &entry.expiration)) {
+      continue;
+    }
+    if (now < entry.verification_time || now >= entry.expiration)
+      continue;
+    std::optional<CertVerifyResult> result = ResultFromDict(*result_dict);
+    if (!result)
+      continue;
+    entry.result = std::move(*result);
+    entries_[key] = std::move(entry);
+  }
+  LOG(INFO) << "Loaded " << entries_.size()
+            << " certificate verifications from " << path_;
+  return entries_.size();
+}
+
+void NaiveCertVerifyStore::Save(const CertVerifier::RequestParams& params,
+                                base::Time verification_time,
+                                const CertVerifyResult& result) {
+  if (!result.verified_cert)
+    return;
+
+  Entry entry;
+  entry.result = result;
+  entry.verification_time = verification_time;
+  entry.expiration = std::min(verification_time + kMaxAge,
+                              ChainExpiry(*result.verified_cert));
+  if (entry.expiration <= verification_time)
+    return;
+
+  base::AutoLock lock(lock_);
+  std::string key = base::HexEncode(params.key());
+  if (!entries_.contains(key) && entries_.size() >= kMaxEntries) {
+    auto oldest = std::min_element(
+        entries_.begin(), entries_.end(), [](const auto& a, const auto& b) {
+          return a.second.verification_time < b.second.verification_time;
+        });
+    entries_.erase(oldest);
+  }
+  entries_[key] = std::move(entry);
+  WriteLocked();
+}
+
+bool NaiveCertVerifyStore::Lookup(const CertVerifier::RequestParams& params,
+                                  base::Time now,
+                                  CertVerifyResult* result) {
+  base::AutoLock lock(lock_);
+  auto it = entries_.find(base::HexEncode(params.key()));
+  if (it == entries_.end())
+    return false;
+  // A clock set back past the verification voids it too.
+  if (now < it->second.verification_time || now >= it->second.expiration) {
+    entries_.erase(it);
+    WriteLocked();
+    return false;
+  }
+  *result = it->second.result;
+  return true;
+}
+
+void NaiveCertVerifyStore::Clear() {
+  base::AutoLock lock(lock_);
+  if (entries_.empty())
+    return;
+  entries_.clear();
+  WriteLocked();
+}
+
+void NaiveCertVerifyStore::WriteLocked() {
+  base::Value::Dict verifications;
+  for (const auto& [key, entry] : entries_) {
+    base::Value::Dict entry_dict;
+    entry_dict.Set("result", ResultToDict(entry.result));
+    entry_dict.Set("verification_time",
+                   TimeToString(entry.verification_time));
+    entry_dict.Set("expiration", TimeToString(entry.expiration));
+    verifications.Set(key, std::move(entry_dict));
+  }
+  base::Value::Dict dict;
+  dict.Set("version", kFileVersion);
+  dict.Set("crl_set_sequence", base::NumberToString(crl_set_sequence_));
+  dict.Set("verifications", std::move(verifications));
+
+  std::string data;
+  base::JSONWriter::Write(dict, &data);
+  writer_.Write(std::move(data));
+}
+
+}  // namespace net
@@ -0,0 +1,78 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_CERT_VERIFY_STORE_H_
+#define NET_TOOLS_NAIVE_NAIVE_CERT_VERIFY_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/time/time.h"
+#include "net/cert/caching_cert_verifier.h"
+#include "net/cert/cert_verify_result.h"
+#include "net/tools/naive/naive_file_writer.h"
+
+namespace net {
+
+// Keeps the successful certificate verifications of HTTPS proxies in a file,
+// so the first connections after a restart skip path building and any AIA
+// fetches for a chain already known to be good.
+//
+// Verifications are keyed by the hash of their request parameters, which
+// covers the chain and the hostname. One is good until the earliest expiry
+// in its verified chain, and for kMaxAge at most, so revocations that are not
+// in the CRLSet still reach it. The file is dropped if the CRLSet it was
+// verified with is not the current one. Like the session stores, it backs
+// the verifiers of all IO threads.
+class NaiveCertVerifyStore : public CachingCertVerifier::Store {
+ public:
+  static constexpr size_t kMaxEntries = 64;
+  static constexpr base::TimeDelta kMaxAge = base::Days(1);
+
+  explicit NaiveCertVerifyStore(const base::FilePath& path);
+  ~NaiveCertVerifyStore() override;
+  NaiveCertVerifyStore(const NaiveCertVerifyStore&) = delete;
+  NaiveCertVerifyStore& operator=(const NaiveCertVerifyStore&) = delete;
+
+  // Reads the verifications saved in the file that are still good. Returns
+  // the number of verifications read.
+  size_t Load();
+
+  // CachingCertVerifier::Store:
+  void Save(const CertVerifier::RequestParams& params,
+            base::Time verification_time,
+            const CertVerifyResult& result) override;
+  bool Lookup(const CertVerifier::RequestParams& params,
+              base::Time now,
+              CertVerifyResult* result) override;
+  void Clear() override;
+
+ private:
+  struct Entry {
+    Entry();
+    Entry(const Entry&);
+    Entry& operator=(const Entry&);
+    ~Entry();
+
+    CertVerifyResult result;
+    base::Time verification_time;
+    base::Time expiration;
+  };
+
+  void WriteLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const base::FilePath path_;
+  NaiveFileWriter writer_;
+  const uint32_t crl_set_sequence_;
+  base::Lock lock_;
+  // Keyed by the hex of CertVerifier::RequestParams::key().
+  std::map<std::string, Entry> entries_ GUARDED_BY(lock_);
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_CERT_VERIFY_STORE_H_
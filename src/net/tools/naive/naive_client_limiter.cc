@@ -0,0 +1,158 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_client_limiter.h"
+
+#include <algorithm>
+
+#include "base/check_op.h"
+#include "base/hash/hash.h"
+#include "base/logging.h"
+#include "net/base/ip_address.h"
+
+namespace net {
+
+namespace {
+constexpr size_t kMinSlots = 256;
+// Up to 64Ki clients per thread, 4 MiB. Clients beyond are not limited.
+constexpr size_t kMaxSlots = 128 * 1024;
+// Wait before scanning a full table again.
+constexpr base::TimeDelta kFullTableRetryDelay = base::Seconds(1);
+}  // namespace
+
+NaiveClientLimiter::NaiveClientLimiter(double rate,
+                                       int burst,
+                                       int max_connections)
+    : rate_(rate),
+      burst_(std::max(burst, 1)),
+      max_connections_(max_connections) {
+  DCHECK_GE(rate_, 0);
+  DCHECK_GE(max_connections_, 0);
+}
+
+NaiveClientLimiter::~NaiveClientLimiter() = default;
+
+bool NaiveClientLimiter::Admit(const IPAddress& address) {
+  if (!enabled())
+    return true;
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (slots_.empty() || (num_clients_ + 1) * 2 > slots_.size()) {
+    if (now < full_retry_time_)
+      return true;
+    if (!Compact(now)) {
+      LOG(WARNING) << "Too many clients to limit";
+      full_retry_time_ = now + kFullTableRetryDelay;
+      return true;
+    }
+  }
+
+  Key key = ToKey(address);
+  Entry& entry = slots_[FindSlot(key)];
+  if (entry.key == Key()) {
+    entry.key = key;
+    entry.last_refill = now;
+    entry.tokens = burst_;
+    entry.connections = 0;
+    num_clients_++;
+  } else if (rate_ > 0) {
+    Refill(entry, now);
+  }
+
+  if (max_connections_ > 0 && entry.connections >= max_connections_)
+    return false;
+  if (rate_ > 0) {
+    if (entry.tokens < 1)
+      return false;
+    entry.tokens -= 1;
+  }
+  entry.connections++;
+  return true;
+}
+
+void NaiveClientLimiter::Release(const IPAddress& address) {
+  if (slots_.empty())
+    return;
+  Entry& entry = slots_[FindSlot(ToKey(address))];
+  // Connections admitted while the table was full are not counted.
+  if (entry.key != Key() && entry.connections > 0)
+    entry.connections--;
+}
+
+// static
+NaiveClientLimiter::Key NaiveClientLimiter::ToKey(const IPAddress& address) {
+  IPAddress ip = address.IsIPv4MappedIPv6()
+                     ? ConvertIPv4MappedIPv6ToIPv4(address)
+                     : address;
+  Key key;
+  const IPAddressBytes& bytes = ip.bytes();
+  if (ip.IsIPv4()) {
+    // The IPv4-mapped form.
+    key.low = 0xffff00000000u | (uint64_t{bytes[0]} << 24) |
+              (uint64_t{bytes[1]} << 16) | (uint64_t{bytes[2]} << 8) |
+              bytes[3];
+  } else {
+    for (size_t i = 0; i < 8 && i < bytes.size(); ++i) {
+      key.high = (key.high << 8) | bytes[i];
+    }
+    // Tells the /64 prefixes apart from the IPv4 addresses.
+    key.low = 1;
+  }
+  return key;
+}
+
+size_t NaiveClientLimiter::FindSlot(const Key& key) const {
+  size_t mask = slots_.size() - 1;
+  for (size_t slot = base::HashInts64(key.high, key.low) & mask;;
+       slot = (slot + 1) & mask) {
+    const Key& slot_key = slots_[slot].key;
+    if (slot_key == key || slot_key == Key())
+      return slot;
+  }
+}
+
+bool NaiveClientLimiter::IsIdle(const Entry& entry,
+                                base::TimeTicks now) const {
+  if (entry.connections > 0)
+    return false;
+  if (rate_ == 0)
+    return true;
+  return entry.tokens + (now - entry.last_refill).InSecondsF() * rate_ >=
+         burst_;
+}
+
+void NaiveClientLimiter::Refill(Entry& entry, base::TimeTicks now) const {
+  double tokens =
+      entry.tokens + (now - entry.last_refill).InSecondsF() * rate_;
+  entry.tokens = static_cast<float>(std::min<double>(tokens, burst_));
+  entry.last_refill = now;
+}
+
+bool NaiveClientLimiter::Compact(base::TimeTicks now) {
+  std::vector<Entry> old_slots;
+  old_slots.swap(slots_);
+  size_t num_kept = 0;
+  for (const Entry& entry : old_slots) {
+    if (entry.key != Key() && !IsIdle(entry, now))
+      num_kept++;
+  }
+  // Keeps the table at most half full after adding one more.
+  size_t size = std::max(kMinSlots, old_slots.size());
+  while ((num_kept + 1) * 2 > size)
+    size *= 2;
+  if (size > kMaxSlots) {
+    slots_.swap(old_slots);
+    return false;
+  }
+
+  slots_.resize(size);
+  num_clients_ = 0;
+  for (const Entry& entry : old_slots) {
+    if (entry.key == Key() || IsIdle(entry, now))
+      continue;
+    slots_[FindSlot(entry.key)] = entry;
+    num_clients_++;
+  }
+  return true;
+}
+
+}  // namespace net
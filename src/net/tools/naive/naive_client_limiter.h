@@ -0,0 +1,76 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_CLIENT_LIMITER_H_
+#define NET_TOOLS_NAIVE_NAIVE_CLIENT_LIMITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "base/time/time.h"
+
+namespace net {
+
+class IPAddress;
+
+// Admission control per client address for the listeners of a thread: a
+// token bucket limits the rate of new connections of each client, and a cap
+// limits its open connections, so one client cannot take the tunnel
+// sessions and the accept loop from the others. IPv6 clients are counted
+// per /64 prefix. Checked right after accept, before any handshake state is
+// allocated. Must be used on one thread.
+class NaiveClientLimiter {
+ public:
+  // Allows `rate` new connections per second with bursts of `burst`, and
+  // `max_connections` open ones, per client. Zero disables either limit.
+  NaiveClientLimiter(double rate, int burst, int max_connections);
+  ~NaiveClientLimiter();
+  NaiveClientLimiter(const NaiveClientLimiter&) = delete;
+  NaiveClientLimiter& operator=(const NaiveClientLimiter&) = delete;
+
+  bool enabled() const { return rate_ > 0 || max_connections_ > 0; }
+  size_t num_clients() const { return num_clients_; }
+
+  // Returns false if a new connection from `address` is over its limits.
+  // Otherwise counts it open until Release().
+  bool Admit(const IPAddress& address);
+  void Release(const IPAddress& address);
+
+ private:
+  struct Key {
+    uint64_t high = 0;
+    uint64_t low = 0;
+    bool operator==(const Key&) const = default;
+  };
+
+  // 32 bytes per client, in open addressing with linear probing. No
+  // address has the empty key, which marks empty slots.
+  struct Entry {
+    Key key;
+    base::TimeTicks last_refill;
+    float tokens = 0;
+    int32_t connections = 0;
+  };
+
+  static Key ToKey(const IPAddress& address);
+  // Returns the slot of `key`, or the empty slot where it would be added.
+  size_t FindSlot(const Key& key) const;
+  // Whether `entry` would start over the same if forgotten now.
+  bool IsIdle(const Entry& entry, base::TimeTicks now) const;
+  void Refill(Entry& entry, base::TimeTicks now) const;
+  // Drops the idle entries, and doubles the table if still half full.
+  // Returns false if the table cannot grow.
+  bool Compact(base::TimeTicks now);
+
+  const double rate_;
+  const int burst_;
+  const int max_connections_;
+  std::vector<Entry> slots_;
+  size_t num_clients_ = 0;
+  // Admits new clients unlimited until then, once the table is full.
+  base::TimeTicks full_retry_time_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_CLIENT_LIMITER_H_
@@ -0,0 +1,117 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_client_socket_factory.h"
+
+#include <utility>
+
+#include "base/functional/bind.h"
+#include "net/base/address_list.h"
+#include "net/base/net_errors.h"
+#include "net/socket/datagram_client_socket.h"
+#include "net/socket/ssl_client_socket.h"
+#include "net/socket/tcp_client_socket.h"
+
+namespace net {
+namespace {
+int EnableFastOpenConnect(TCPClientSocket* socket) {
+  // Kernels without the option connect as usual, as do Multipath TCP
+  // sockets of kernels before 6.2, which do not support it.
+  int rv = socket->SetFastOpenConnect(true);
+  if (rv == ERR_NOT_IMPLEMENTED)
+    return OK;
+  return rv;
+}
+
+int BindToUplink(TCPClientSocket* socket,
+                 const scoped_refptr<NaiveUplinks>& uplinks,
+                 size_t uplink,
+                 AddressFamily family,
+                 bool tcp_fast_open) {
+  int rv = uplinks->Bind(uplink, socket->GetKernelSocketDescriptor(), family);
+  if (rv != OK || !tcp_fast_open)
+    return rv;
+  return EnableFastOpenConnect(socket);
+}
+}  // namespace
+
+NaiveClientSocketFactory::NaiveClientSocketFactory(
+    bool tcp_fast_open,
+    bool multipath,
+    scoped_refptr<NaiveUplinks> uplinks)
+    : factory_(ClientSocketFactory::GetDefaultFactory()),
+      tcp_fast_open_(tcp_fast_open),
+      multipath_(multipath),
+      uplinks_(std::move(uplinks)) {}
+
+NaiveClientSocketFactory::~NaiveClientSocketFactory() = default;
+
+std::unique_ptr<DatagramClientSocket>
+NaiveClientSocketFactory::CreateDatagramClientSocket(
+    DatagramSocket::BindType bind_type,
+    NetLog* net_log,
+    const NetLogSource& source) {
+  return factory_->CreateDatagramClientSocket(bind_type, net_log, source);
+}
+
+std::unique_ptr<TransportClientSocket>
+NaiveClientSocketFactory::CreateTransportClientSocket(
+    const AddressList& addresses,
+    std::unique_ptr<SocketPerformanceWatcher> socket_performance_watcher,
+    NetworkQualityEstimator* network_quality_estimator,
+    NetLog* net_log,
+    const NetLogSource& source) {
+  std::unique_ptr<TransportClientSocket> socket =
+      factory_->CreateTransportClientSocket(
+          addresses, std::move(socket_performance_watcher),
+          network_quality_estimator, net_log, source);
+  // The default factory creates plain TCP sockets.
+  auto* tcp_socket = static_cast<TCPClientSocket*>(socket.get());
+  if (multipath_) {
+    tcp_socket->SetMultipath(true);
+  }
+  if (tcp_fast_open_) {
+    // The descriptor only exists once connecting starts, when the callback
+    // runs.
+    tcp_socket->SetBeforeConnectCallback(
+        base::BindRepeating(&EnableFastOpenConnect,
+                            base::Unretained(tcp_socket)));
+  }
+  return socket;
+}
+
+std::unique_ptr<TransportClientSocket>
+NaiveClientSocketFactory::CreateTransportClientSocketForSession(
+    const AddressList& addresses,
+    std::unique_ptr<SocketPerformanceWatcher> socket_performance_watcher,
+    NetworkQualityEstimator* network_quality_estimator,
+    NetLog* net_log,
+    const NetLogSource& source,
+    const NetworkAnonymizationKey& network_anonymization_key) {
+  std::unique_ptr<TransportClientSocket> socket = CreateTransportClientSocket(
+      addresses, std::move(socket_performance_watcher),
+      network_quality_estimator, net_log, source);
+  // Only connections for sessions go over the uplinks. Others, as to DNS
+  // servers, may only be reachable over the default route.
+  if (!uplinks_)
+    return socket;
+  auto* tcp_socket = static_cast<TCPClientSocket*>(socket.get());
+  // Replaces the callback of TCP Fast Open, which it runs too.
+  tcp_socket->SetBeforeConnectCallback(base::BindRepeating(
+      &BindToUplink, base::Unretained(tcp_socket), uplinks_,
+      uplinks_->GetUplinkForKey(network_anonymization_key),
+      addresses.front().GetFamily(), tcp_fast_open_));
+  return socket;
+}
+
+std::unique_ptr<SSLClientSocket>
+NaiveClientSocketFactory::CreateSSLClientSocket(
+    SSLClientContext* context,
+    std::unique_ptr<StreamSocket> stream_socket,
+    const HostPortPair& host_and_port,
+    const SSLConfig& ssl_config) {
+  return factory_->CreateSSLClientSocket(context, std::move(stream_socket),
+                                         host_and_port, ssl_config);
+}
+
+}  // namespace net
@@ -0,0 +1,66 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_CLIENT_SOCKET_FACTORY_H_
+#define NET_TOOLS_NAIVE_NAIVE_CLIENT_SOCKET_FACTORY_H_
+
+#include <memory>
+
+#include "base/memory/raw_ptr.h"
+#include "base/memory/scoped_refptr.h"
+#include "net/socket/client_socket_factory.h"
+#include "net/tools/naive/naive_uplinks.h"
+
+namespace net {
+
+// Creates the sockets of the default factory, with TCP Fast Open on the
+// TCP ones if enabled, so the first flight of a connection, such as the TLS
+// ClientHello to a proxy, goes out in the SYN once the kernel has a cookie
+// for the server. With `multipath` the TCP ones are opened as Multipath TCP
+// where the kernel has it, so they may use several interfaces at once and
+// survive losing one. With `uplinks` the TCP ones made for sessions are
+// bound to the uplink of their session key, as NaiveUplinks decides.
+class NaiveClientSocketFactory : public ClientSocketFactory {
+ public:
+  NaiveClientSocketFactory(bool tcp_fast_open,
+                           bool multipath,
+                           scoped_refptr<NaiveUplinks> uplinks);
+  ~NaiveClientSocketFactory() override;
+  NaiveClientSocketFactory(const NaiveClientSocketFactory&) = delete;
+  NaiveClientSocketFactory& operator=(const NaiveClientSocketFactory&) =
+      delete;
+
+  // ClientSocketFactory implementation:
+  std::unique_ptr<DatagramClientSocket> CreateDatagramClientSocket(
+      DatagramSocket::BindType bind_type,
+      NetLog* net_log,
+      const NetLogSource& source) override;
+  std::unique_ptr<TransportClientSocket> CreateTransportClientSocket(
+      const AddressList& addresses,
+      std::unique_ptr<SocketPerformanceWatcher> socket_performance_watcher,
+      NetworkQualityEstimator* network_quality_estimator,
+      NetLog* net_log,
+      const NetLogSource& source) override;
+  std::unique_ptr<TransportClientSocket> CreateTransportClientSocketForSession(
+      const AddressList& addresses,
+      std::unique_ptr<SocketPerformanceWatcher> socket_performance_watcher,
+      NetworkQualityEstimator* network_quality_estimator,
+      NetLog* net_log,
+      const NetLogSource& source,
+      const NetworkAnonymizationKey& network_anonymization_key) override;
+  std::unique_ptr<SSLClientSocket> CreateSSLClientSocket(
+      SSLClientContext* context,
+      std::unique_ptr<StreamSocket> stream_socket,
+      const HostPortPair& host_and_port,
+      const SSLConfig& ssl_config) override;
+
+ private:
+  const raw_ptr<ClientSocketFactory> factory_;
+  const bool tcp_fast_open_;
+  const bool multipath_;
+  // Null without uplinks.
+  const scoped_refptr<NaiveUplinks> uplinks_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_CLIENT_SOCKET_FACTORY_H_
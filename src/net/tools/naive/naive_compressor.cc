@@ -0,0 +1,205 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_compressor.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/check_op.h"
+#include "net/base/net_errors.h"
+#include "third_party/zstd/src/lib/zstd.h"
+
+namespace net {
+
+namespace {
+static_assert(NaiveCompressor::kFrameHeaderSize +
+                  ZSTD_COMPRESSBOUND(NaiveCompressor::kMaxPayloadSize) <=
+              NaiveCompressor::kMaxFrameSize);
+static_assert(ZSTD_COMPRESSBOUND(NaiveCompressor::kMaxPayloadSize) <= 0xffff);
+
+// The header of a TLS record of a handshake, alert, change cipher spec or
+// application data.
+bool IsTlsRecord(base::span<const char> payload) {
+  if (payload.size() < 3) {
+    return false;
+  }
+  auto type = static_cast<uint8_t>(payload[0]);
+  return type >= 0x14 && type <= 0x17 && payload[1] == 0x03 &&
+         payload[2] >= 0x01 && payload[2] <= 0x04;
+}
+}  // namespace
+
+void NaiveCompressor::FreeContextDeleter::operator()(ZSTD_CCtx* cctx) const {
+  ZSTD_freeCCtx(cctx);
+}
+
+void NaiveCompressor::FreeContextDeleter::operator()(ZSTD_DCtx* dctx) const {
+  ZSTD_freeDCtx(dctx);
+}
+
+NaiveCompressor::NaiveCompressor() = default;
+
+NaiveCompressor::~NaiveCompressor() = default;
+
+// static
+int NaiveCompressor::GetMaxFrameSize(int payload_len) {
+  DCHECK_LE(payload_len, kMaxPayloadSize);
+  return kFrameHeaderSize + static_cast<int>(ZSTD_COMPRESSBOUND(payload_len));
+}
+
+bool NaiveCompressor::ShouldCompress(base::span<const char> payload) {
+  if (first_write_) {
+    first_write_ = false;
+    tls_ = IsTlsRecord(payload);
+  }
+  if (tls_) {
+    return false;
+  }
+  if (bypass_bytes_ > 0) {
+    bypass_bytes_ -= static_cast<int64_t>(payload.size());
+    return false;
+  }
+  return true;
+}
+
+int NaiveCompressor::Compress(base::span<const char> payload, char* frame) {
+  DCHECK_GT(payload.size(), 0u);
+  DCHECK_LE(payload.size(), static_cast<size_t>(kMaxPayloadSize));
+
+  char* data = frame + kFrameHeaderSize;
+  size_t data_size;
+  FrameType type = kRawFrame;
+  if (ShouldCompress(payload)) {
+    if (!cctx_) {
+      cctx_.reset(ZSTD_createCCtx());
+      if (!cctx_ ||
+          ZSTD_isError(ZSTD_CCtx_setParameter(
+              cctx_.get(), ZSTD_c_compressionLevel, kLevel)) ||
+          ZSTD_isError(ZSTD_CCtx_setParameter(cctx_.get(), ZSTD_c_windowLog,
+                                              kWindowLog))) {
+        return ERR_OUT_OF_MEMORY;
+      }
+    }
+    ZSTD_inBuffer in = {payload.data(), payload.size(), 0};
+    ZSTD_outBuffer out = {data, ZSTD_COMPRESSBOUND(payload.size()), 0};
+    size_t remaining;
+    do {
+      remaining = ZSTD_compressStream2(cctx_.get(), &out, &in, ZSTD_e_flush);
+      if (ZSTD_isError(remaining)) {
+        return ERR_UNEXPECTED;
+      }
+    } while (remaining > 0 && out.pos < out.size);
+    // The compression bound leaves room for all of the flush.
+    if (remaining > 0) {
+      return ERR_UNEXPECTED;
+    }
+    type = kZstdFrame;
+    data_size = out.pos;
+
+    // Skips the payloads that follow a frame that saved less than 1/8.
+    if (data_size * 8 > payload.size() * 7) {
+      bypass_bytes_ = next_bypass_bytes_;
+      next_bypass_bytes_ = std::min(next_bypass_bytes_ * 2,
+                                    static_cast<int64_t>(kMaxBypassBytes));
+    } else {
+      next_bypass_bytes_ = kMinBypassBytes;
+    }
+  } else {
+    std::memcpy(data, payload.data(), payload.size());
+    data_size = payload.size();
+  }
+
+  frame[0] = type;
+  frame[1] = static_cast<char>(data_size >> 8);
+  frame[2] = static_cast<char>(data_size & 0xff);
+  int frame_len = kFrameHeaderSize + static_cast<int>(data_size);
+  payload_bytes_written_ += payload.size();
+  frame_bytes_written_ += frame_len;
+  return frame_len;
+}
+
+int NaiveCompressor::Decompress(base::span<const char> input,
+                                int* input_used,
+                                char* payload,
+                                int payload_len) {
+  DCHECK_GT(payload_len, 0);
+
+  size_t in_pos = 0;
+  int out_pos = 0;
+  while (out_pos < payload_len) {
+    if (read_frame_remaining_ == 0 && !read_flush_pending_) {
+      if (in_pos == input.size()) {
+        break;
+      }
+      read_header_[read_header_len_++] = static_cast<uint8_t>(input[in_pos]);
+      in_pos++;
+      if (read_header_len_ < kFrameHeaderSize) {
+        continue;
+      }
+      read_header_len_ = 0;
+      read_frame_type_ = read_header_[0];
+      read_frame_remaining_ = (read_header_[1] << 8) | read_header_[2];
+      // Frames are never empty.
+      if ((read_frame_type_ != kRawFrame && read_frame_type_ != kZstdFrame) ||
+          read_frame_remaining_ == 0) {
+        return ERR_INVALID_RESPONSE;
+      }
+      continue;
+    }
+
+    size_t in_size = std::min(input.size() - in_pos,
+                              static_cast<size_t>(read_frame_remaining_));
+    if (read_frame_type_ == kRawFrame) {
+      int len = std::min(static_cast<int>(in_size), payload_len - out_pos);
+      if (len == 0) {
+        break;
+      }
+      std::memcpy(payload + out_pos, input.data() + in_pos, len);
+      in_pos += len;
+      out_pos += len;
+      read_frame_remaining_ -= len;
+      continue;
+    }
+
+    if (!dctx_) {
+      dctx_.reset(ZSTD_createDCtx());
+      if (!dctx_ || ZSTD_isError(ZSTD_DCtx_setParameter(
+                        dctx_.get(), ZSTD_d_windowLogMax, kWindowLog))) {
+        return ERR_OUT_OF_MEMORY;
+      }
+    }
+    ZSTD_inBuffer in = {input.data() + in_pos, in_size, 0};
+    ZSTD_outBuffer out = {payload + out_pos,
+                          static_cast<size_t>(payload_len - out_pos), 0};
+    size_t rv = ZSTD_decompressStream(dctx_.get(), &out, &in);
+    if (ZSTD_isError(rv)) {
+      return ERR_INVALID_RESPONSE;
+    }
+    in_pos += in.pos;
+    out_pos += static_cast<int>(out.pos);
+    read_frame_remaining_ -= static_cast<int>(in.pos);
+    read_flush_pending_ = out.pos == out.size;
+    if (in.pos == 0 && out.pos == 0 && read_frame_remaining_ > 0) {
+      break;
+    }
+  }
+
+  *input_used = static_cast<int>(in_pos);
+  payload_bytes_read_ += out_pos;
+  frame_bytes_read_ += in_pos;
+  return out_pos;
+}
+
+size_t NaiveCompressor::EstimateMemoryUsage() const {
+  size_t usage = 0;
+  if (cctx_) {
+    usage += ZSTD_sizeof_CCtx(cctx_.get());
+  }
+  if (dctx_) {
+    usage += ZSTD_sizeof_DCtx(dctx_.get());
+  }
+  return usage;
+}
+
+}  // namespace net
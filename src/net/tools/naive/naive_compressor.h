@@ -0,0 +1,117 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_COMPRESSOR_H_
+#define NET_TOOLS_NAIVE_NAIVE_COMPRESSOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "base/containers/span.h"
+#include "net/tools/naive/naive_buffer_pool.h"
+
+typedef struct ZSTD_CCtx_s ZSTD_CCtx;
+typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+
+namespace net {
+
+// Frames the payloads of a tunnel negotiated with Compression::kZstd, in
+// both directions, as
+// struct CompressedFrame {
+//   uint8_t type;  // kRawFrame or kZstdFrame
+//   uint16_t data_size;  // big-endian
+//   uint8_t data[data_size];
+// };
+// The kZstdFrames of a direction are the flushes of one zstd stream, so each
+// decodes to the payload it was written from, with the earlier ones as its
+// history. kRawFrames carry the payloads that are not compressed.
+//
+// Payloads bypass the compressor if the direction starts with a TLS record,
+// as encrypted data does not compress, or while the last compressed frame
+// saved too little. The bypass lasts from kMinBypassBytes, doubling up to
+// kMaxBypassBytes while the frames between keep saving too little.
+class NaiveCompressor {
+ public:
+  static constexpr int kFrameHeaderSize = 3;
+  // Fits a frame of the compression bound of a payload in a pooled buffer.
+  static constexpr int kMaxPayloadSize = NaiveBufferPool::kBufferSize - 1024;
+  static constexpr int kMaxFrameSize = NaiveBufferPool::kBufferSize;
+  // Favors speed over ratio, as the relay compresses on the IO thread.
+  static constexpr int kLevel = 1;
+  // Bounds the memory of the zstd streams of each tunnel, and the window a
+  // peer can make the decoder keep.
+  static constexpr int kWindowLog = 17;
+  static constexpr int kMinBypassBytes = 64 * 1024;
+  static constexpr int kMaxBypassBytes = 4 * 1024 * 1024;
+
+  NaiveCompressor();
+  NaiveCompressor(const NaiveCompressor&) = delete;
+  NaiveCompressor& operator=(const NaiveCompressor&) = delete;
+  ~NaiveCompressor();
+
+  // Returns the size of the frame of `payload_len` bytes of payload at most.
+  static int GetMaxFrameSize(int payload_len);
+
+  // Frames `payload` into `frame`, which has GetMaxFrameSize() bytes for it.
+  // `payload` is at most kMaxPayloadSize bytes. Returns the number of bytes
+  // written, or a net error.
+  int Compress(base::span<const char> payload, char* frame);
+
+  // Decodes the frames at the start of `input` into up to `payload_len` bytes
+  // of `payload`, and sets `*input_used` to the number of bytes of `input`
+  // they took. Returns the number of payload bytes decoded, zero if more
+  // input is needed, or a net error if the frames are invalid. Payload the
+  // decoder holds back for lack of room is returned by later calls even
+  // without input.
+  int Decompress(base::span<const char> input,
+                 int* input_used,
+                 char* payload,
+                 int payload_len);
+
+  uint64_t payload_bytes_written() const { return payload_bytes_written_; }
+  uint64_t frame_bytes_written() const { return frame_bytes_written_; }
+  uint64_t payload_bytes_read() const { return payload_bytes_read_; }
+  uint64_t frame_bytes_read() const { return frame_bytes_read_; }
+
+  // Returns the bytes held by the zstd streams.
+  size_t EstimateMemoryUsage() const;
+
+ private:
+  enum FrameType : uint8_t {
+    kRawFrame = 0,
+    kZstdFrame = 1,
+  };
+
+  struct FreeContextDeleter {
+    void operator()(ZSTD_CCtx* cctx) const;
+    void operator()(ZSTD_DCtx* dctx) const;
+  };
+
+  // Returns true if `payload` is to be compressed.
+  bool ShouldCompress(base::span<const char> payload);
+
+  // Created with the first frame of each type that needs them.
+  std::unique_ptr<ZSTD_CCtx, FreeContextDeleter> cctx_;
+  std::unique_ptr<ZSTD_DCtx, FreeContextDeleter> dctx_;
+
+  bool first_write_ = true;
+  bool tls_ = false;
+  int64_t bypass_bytes_ = 0;
+  int64_t next_bypass_bytes_ = kMinBypassBytes;
+
+  uint8_t read_header_[kFrameHeaderSize] = {};
+  int read_header_len_ = 0;
+  uint8_t read_frame_type_ = kRawFrame;
+  int read_frame_remaining_ = 0;
+  // The decoder filled the last payload buffer and may hold more.
+  bool read_flush_pending_ = false;
+
+  uint64_t payload_bytes_written_ = 0;
+  uint64_t frame_bytes_written_ = 0;
+  uint64_t payload_bytes_read_ = 0;
+  uint64_t frame_bytes_read_ = 0;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_COMPRESSOR_H_
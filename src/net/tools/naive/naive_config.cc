@@ -5,17 +5,50 @@
 
 #include <algorithm>
 #include <iostream>
+#include <string_view>
 
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
 #include "base/strings/escape.h"
+#include "base/strings/strcat.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_tokenizer.h"
+#include "base/strings/string_util.h"
+#include "build/build_config.h"
 #include "net/base/proxy_server.h"
 #include "net/base/proxy_string_util.h"
 #include "net/base/url_util.h"
+#include "net/socket/transport_connect_race.h"
+#include "net/third_party/quiche/src/quiche/quic/core/crypto/crypto_protocol.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_constants.h"
+#include "net/tools/naive/naive_trace_recorder.h"
 #include "url/gurl.h"
+#include "url/url_constants.h"
 
 namespace net {
 namespace {
+// SETTINGS_INITIAL_WINDOW_SIZE of RFC 9113 before any SETTINGS.
+constexpr int kHttp2DefaultWindow = 65535;
+// The read buffer size SpdySession starts with.
+constexpr int kHttp2MinReadBuffer = 8 * 1024;
+constexpr int kQuicMinWindow =
+    static_cast<int>(quic::kMinimumFlowControlSendWindow);
+
+// Parses an HTTP/2 receive window given as an int or a string. Below the
+// initial window of the protocol it would only throttle.
+bool ParseHttp2Window(const base::Value& v, int* window) {
+  if (std::optional<int> i = v.GetIfInt()) {
+    *window = *i;
+  } else if (const std::string* str = v.GetIfString()) {
+    if (!base::StringToInt(*str, window)) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  return *window >= kHttp2DefaultWindow;
+}
+
 ProxyServer MyProxyUriToProxyServer(std::string_view uri) {
   if (uri.compare(0, 7, "quic://") == 0) {
     return ProxySchemeHostAndPortToProxyServer(ProxyServer::SCHEME_QUIC,
@@ -29,18 +62,78 @@ NaiveListenConfig::NaiveListenConfig() = default;
 NaiveListenConfig::NaiveListenConfig(const NaiveListenConfig&) = default;
 NaiveListenConfig::~NaiveListenConfig() = default;
 
+bool NaiveListenConfig::IsSameListener(
+    const NaiveListenConfig& other) const {
+  return protocol == other.protocol && unix_socket == other.unix_socket &&
+         addr == other.addr && port == other.port;
+}
+
 bool NaiveListenConfig::Parse(const std::string& str) {
   GURL url(str);
-  if (url.scheme() == "socks") {
+  if (url.scheme() == "socks+unix" || url.scheme() == "http+unix") {
+#if BUILDFLAG(IS_POSIX)
+    // The socket path is taken out of the URI, as in
+    // "socks+unix://user:pass@/run/naive.sock?users=..", and the rest is
+    // parsed as http with a placeholder host.
+    size_t scheme_end = url.scheme().size() + 3;
+    size_t path_begin = str.find('/', scheme_end);
+    if (str.compare(url.scheme().size(), 3, "://") != 0 ||
+        path_begin == std::string::npos ||
+        (path_begin > scheme_end && str[path_begin - 1] != '@')) {
+      std::cerr << "Missing socket path in " << str << std::endl;
+      return false;
+    }
+    size_t path_end = std::min(str.find('?', path_begin), str.size());
+    protocol = url.scheme() == "socks+unix" ? ClientProtocol::kSocks5
+                                            : ClientProtocol::kHttp;
+    unix_socket = true;
+    addr = base::UnescapeBinaryURLComponent(
+        std::string_view(str).substr(path_begin, path_end - path_begin));
+    url = GURL(base::StrCat(
+        {"http://",
+         std::string_view(str).substr(scheme_end, path_begin - scheme_end),
+         "localhost", std::string_view(str).substr(path_end)}));
+#else
+    std::cerr << "Unix domain socket listeners only support POSIX."
+              << std::endl;
+    return false;
+#endif
+  } else if (url.scheme() == "quic") {
+    // Parsed as https for the authority and the default port.
+    url = GURL(std::string("https").append(str, 4));
+    protocol = ClientProtocol::kQuic;
+  } else if (url.scheme() == "socks") {
     protocol = ClientProtocol::kSocks5;
   } else if (url.scheme() == "http") {
     protocol = ClientProtocol::kHttp;
+  } else if (url.scheme() == "https") {
+    protocol = ClientProtocol::kHttps;
   } else if (url.scheme() == "redir") {
 #if BUILDFLAG(IS_LINUX)
     protocol = ClientProtocol::kRedir;
 #else
     std::cerr << "Redir protocol only supports Linux." << std::endl;
     return false;
+#endif
+  } else if (url.scheme() == "tproxy") {
+#if BUILDFLAG(IS_LINUX)
+    protocol = ClientProtocol::kTproxy;
+#else
+    std::cerr << "Tproxy protocol only supports Linux." << std::endl;
+    return false;
+#endif
+  } else if (url.scheme() == "tun") {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_ANDROID)
+    // Parsed as http for the device name in the host.
+    url = GURL(std::string("http").append(str, 3));
+    protocol = ClientProtocol::kTun;
+    if (url.host().empty()) {
+      std::cerr << "Missing device name in " << str << std::endl;
+      return false;
+    }
+#else
+    std::cerr << "Tun protocol only supports Linux and Android." << std::endl;
+    return false;
 #endif
   } else {
     std::cerr << "Invalid scheme in " << str << std::endl;
@@ -54,7 +147,7 @@ bool NaiveListenConfig::Parse(const std::string& str) {
     pass = base::UnescapeBinaryURLComponent(url.password());
   }
 
-  if (!url.host().empty()) {
+  if (!url.host().empty() && !unix_socket) {
     addr = url.HostNoBrackets();
   }
 
@@ -66,6 +159,169 @@ bool NaiveListenConfig::Parse(const std::string& str) {
   if (effective_port != url::PORT_UNSPECIFIED) {
     port = effective_port;
   }
+  // Tun listeners take connections to any port, and unix listeners have
+  // none.
+  if (protocol == ClientProtocol::kTun || unix_socket) {
+    port = 0;
+  }
+
+  // Set if the `users` option is given, as it may be empty.
+  std::optional<std::string> users_text;
+  std::optional<int64_t> user_rate;
+  for (QueryIterator it(url); !it.IsAtEnd(); it.Advance()) {
+    if (it.GetKey() == "priority") {
+      std::optional<TunnelPriority> value =
+          ParseTunnelPriority(it.GetUnescapedValue());
+      if (!value.has_value()) {
+        std::cerr << "Invalid listen option in " << str << std::endl;
+        return false;
+      }
+      priority = *value;
+      continue;
+    }
+    if (it.GetKey() == "fd") {
+      int value = 0;
+      if (protocol != ClientProtocol::kTun ||
+          !base::StringToInt(it.GetUnescapedValue(), &value) || value < 0) {
+        std::cerr << "Invalid listen option in " << str << std::endl;
+        return false;
+      }
+      tun_fd = value;
+      continue;
+    }
+    if (it.GetKey() == "sndbuf" || it.GetKey() == "notsent-lowat") {
+      int value = 0;
+      if (protocol == ClientProtocol::kTun ||
+          (unix_socket && it.GetKey() == "notsent-lowat") ||
+          !base::StringToInt(it.GetUnescapedValue(), &value) || value <= 0) {
+        std::cerr << "Invalid listen option in " << str << std::endl;
+        return false;
+      }
+      if (it.GetKey() == "sndbuf") {
+        relay_socket_options.send_buffer_size = value;
+      } else {
+        relay_socket_options.not_sent_lowat = value;
+      }
+      continue;
+    }
+    if (it.GetKey() == "zerocopy") {
+      if (protocol == ClientProtocol::kTun || unix_socket ||
+          it.GetUnescapedValue() != "1") {
+        std::cerr << "Invalid listen option in " << str << std::endl;
+        return false;
+      }
+      relay_socket_options.zero_copy = true;
+      continue;
+    }
+    if (it.GetKey() == "h2c") {
+      if (protocol != ClientProtocol::kHttp || it.GetUnescapedValue() != "1") {
+        std::cerr << "Invalid listen option in " << str << std::endl;
+        return false;
+      }
+      h2c = true;
+      continue;
+    }
+    if (it.GetKey() == "rate" || it.GetKey() == "user-rate") {
+      std::optional<int64_t> value =
+          NaiveRateLimiter::ParseRate(it.GetUnescapedValue());
+      if (!value.has_value()) {
+        std::cerr << "Invalid listen option in " << str << std::endl;
+        return false;
+      }
+      if (it.GetKey() == "rate") {
+        rate_limiter = base::MakeRefCounted<NaiveRateLimiter>(*value);
+      } else {
+        user_rate = value;
+      }
+      continue;
+    }
+    if (it.GetKey() == "users") {
+      if (protocol != ClientProtocol::kSocks5 &&
+          protocol != ClientProtocol::kHttp &&
+          protocol != ClientProtocol::kHttps &&
+          protocol != ClientProtocol::kQuic) {
+        std::cerr << "Invalid listen option in " << str << std::endl;
+        return false;
+      }
+      users_text.emplace();
+      if (!base::ReadFileToString(
+              base::FilePath::FromUTF8Unsafe(it.GetUnescapedValue()),
+              &*users_text)) {
+        std::cerr << "Failed to read users file in " << str << std::endl;
+        return false;
+      }
+      continue;
+    }
+    if (it.GetKey() == "cert" || it.GetKey() == "key") {
+      std::string* pem = it.GetKey() == "cert" ? &cert_pem : &key_pem;
+      if ((protocol != ClientProtocol::kHttps &&
+           protocol != ClientProtocol::kQuic) ||
+          !base::ReadFileToString(
+              base::FilePath::FromUTF8Unsafe(it.GetUnescapedValue()), pem)) {
+        std::cerr << "Invalid listen option in " << str << std::endl;
+        return false;
+      }
+      continue;
+    }
+    if (it.GetKey() == "compression") {
+      std::optional<Compression> compression =
+          ParseCompression(it.GetUnescapedValue());
+      if ((protocol != ClientProtocol::kHttp &&
+           protocol != ClientProtocol::kHttps &&
+           protocol != ClientProtocol::kQuic) ||
+          !compression.has_value()) {
+        std::cerr << "Invalid listen option in " << str << std::endl;
+        return false;
+      }
+      padding_limits.compression = *compression;
+      continue;
+    }
+    int value = 0;
+    if ((protocol != ClientProtocol::kHttp &&
+         protocol != ClientProtocol::kHttps &&
+         protocol != ClientProtocol::kQuic) ||
+        !base::StringToInt(it.GetUnescapedValue(), &value) || value < 0) {
+      std::cerr << "Invalid listen option in " << str << std::endl;
+      return false;
+    }
+    if (it.GetKey() == "padding-frames" &&
+        value <= PaddingLimits::kMaxFrames) {
+      padding_limits.frames = value;
+    } else if (it.GetKey() == "padding-budget") {
+      padding_limits.budget = value;
+    } else {
+      std::cerr << "Invalid listen option in " << str << std::endl;
+      return false;
+    }
+  }
+
+  if ((protocol == ClientProtocol::kHttps ||
+       protocol == ClientProtocol::kQuic) &&
+      (cert_pem.empty() || key_pem.empty())) {
+    std::cerr << "Missing cert or key in " << str << std::endl;
+    return false;
+  }
+
+  users = nullptr;
+  if (!user.empty() || !pass.empty() || users_text.has_value()) {
+    auto table = base::MakeRefCounted<NaiveUserTable>();
+    if (!user.empty() || !pass.empty()) {
+      table->Add(user, pass);
+    }
+    // An empty file would leave the listener open to anyone.
+    if (users_text.has_value() &&
+        (!table->AddLines(*users_text) || table->empty())) {
+      std::cerr << "Invalid users file in " << str << std::endl;
+      return false;
+    }
+    if (user_rate.has_value()) {
+      table->SetUserRate(*user_rate);
+    }
+    users = std::move(table);
+  } else if (user_rate.has_value()) {
+    std::cerr << "user-rate without users in " << str << std::endl;
+    return false;
+  }
 
   return true;
 }
@@ -74,7 +330,161 @@ NaiveConfig::NaiveConfig() = default;
 NaiveConfig::NaiveConfig(const NaiveConfig&) = default;
 NaiveConfig::~NaiveConfig() = default;
 
+void NaiveConfig::ApplyReloadable(const NaiveConfig& other) {
+  std::vector<NaiveListenConfig> new_listen;
+  for (const NaiveListenConfig& listen_config : other.listen) {
+    auto it = std::ranges::find_if(listen, [&](const NaiveListenConfig& old) {
+      return old.IsSameListener(listen_config);
+    });
+    if (it == listen.end()) {
+      new_listen.push_back(listen_config);
+      continue;
+    }
+    new_listen.push_back(*it);
+    new_listen.back().user = listen_config.user;
+    new_listen.back().pass = listen_config.pass;
+    new_listen.back().users = listen_config.users;
+  }
+  listen = std::move(new_listen);
+
+  insecure_concurrency = other.insecure_concurrency;
+  adaptive_concurrency = other.adaptive_concurrency;
+  extra_headers = other.extra_headers;
+  proxy_chains = other.proxy_chains;
+  proxy_selection = other.proxy_selection;
+  auth_store = other.auth_store;
+}
+
+bool NaiveConfig::ParseProxyChain(const std::string& str,
+                                  NaiveProxyChainConfig* chain_config) {
+  base::StringTokenizer proxy_uri_list(str, ",");
+  std::vector<ProxyServer> proxy_servers;
+  bool seen_tcp = false;
+  bool race_quic = false;
+  while (proxy_uri_list.GetNext()) {
+    std::string token(proxy_uri_list.token());
+    GURL url(token);
+
+    for (QueryIterator it(url); !it.IsAtEnd(); it.Advance()) {
+      if (it.GetKey() == "quic" && it.GetUnescapedValue() == "race" &&
+          url.SchemeIs(url::kHttpsScheme)) {
+        race_quic = true;
+        continue;
+      }
+      int weight = 0;
+      if (it.GetKey() != "weight" ||
+          !base::StringToInt(it.GetUnescapedValue(), &weight) || weight < 1 ||
+          weight > NaiveProxySelector::kMaxWeight) {
+        std::cerr << "Invalid proxy option in " << str << std::endl;
+        return false;
+      }
+      chain_config->weight = weight;
+    }
+
+    std::u16string proxy_user;
+    std::u16string proxy_pass;
+    net::GetIdentityFromURL(url, &proxy_user, &proxy_pass);
+    GURL::Replacements remove_auth;
+    remove_auth.ClearUsername();
+    remove_auth.ClearPassword();
+    GURL url_no_auth = url.ReplaceComponents(remove_auth);
+    std::string proxy_uri = url_no_auth.GetWithEmptyPath().spec();
+    if (proxy_uri.back() == '/') {
+      proxy_uri.pop_back();
+    }
+
+    proxy_servers.emplace_back(MyProxyUriToProxyServer(proxy_uri));
+    const ProxyServer& last = proxy_servers.back();
+    if (last.is_quic()) {
+      if (seen_tcp) {
+        std::cerr << "QUIC proxy cannot follow TCP-based proxies" << std::endl;
+        return false;
+      }
+      origins_to_force_quic_on.insert(HostPortPair::FromURL(url));
+    } else if (last.is_https() || last.is_http() || last.is_socks()) {
+      seen_tcp = true;
+    } else {
+      std::cerr << "Invalid proxy scheme" << std::endl;
+      return false;
+    }
+
+    AuthCredentials auth(proxy_user, proxy_pass);
+    if (!auth.Empty()) {
+      if (last.is_socks()) {
+        std::cerr << "SOCKS proxy with auth is not supported" << std::endl;
+      } else {
+        std::string proxy_url(token);
+        if (proxy_url.compare(0, 7, "quic://") == 0) {
+          proxy_url.replace(0, 4, "https");
+        }
+        auth_store[url::SchemeHostPort{GURL{proxy_url}}] = auth;
+      }
+    }
+  }
+
+  if (proxy_servers.size() > 1 &&
+      std::any_of(proxy_servers.begin(), proxy_servers.end(),
+                  [](const ProxyServer& s) { return s.is_socks(); })) {
+    // See net/socket/connect_job_params_factory.cc
+    // DCHECK(proxy_server.is_socks());
+    // DCHECK_EQ(1u, proxy_chain.length());
+    std::cerr << "Multi-proxy chain containing SOCKS proxies is not supported."
+              << std::endl;
+    return false;
+  }
+  if (race_quic) {
+    if (proxy_servers.size() > 1) {
+      std::cerr << "Racing QUIC is only supported by single-proxy chains"
+                << std::endl;
+      return false;
+    }
+    const HostPortPair& proxy = proxy_servers.front().host_port_pair();
+    origins_to_force_quic_on.insert(proxy);
+    chain_config->quic_chain = ProxyChain::ForIpProtection(
+        {ProxyServer(ProxyServer::SCHEME_QUIC, proxy)});
+  }
+  if (std::any_of(proxy_servers.begin(), proxy_servers.end(),
+                  [](const ProxyServer& s) { return s.is_quic(); })) {
+    chain_config->chain = ProxyChain::ForIpProtection(proxy_servers);
+  } else {
+    chain_config->chain = ProxyChain(proxy_servers);
+  }
+
+  if (!chain_config->chain.IsValid()) {
+    std::cerr << "Invalid proxy chain" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void NaiveConfig::ApplyEmbeddedProfile() {
+  threads = 1;
+  thread_pool_workers = 1;
+  allocator_profile = NaiveAllocatorProfile::kLowMemory;
+  buffer_pool_size = kLowMemoryBufferPoolSize;
+  relay_buffer = kEmbeddedRelayBuffer;
+  max_sockets_per_pool = kEmbeddedMaxSocketsPerPool;
+  max_sockets_per_group = kEmbeddedMaxSocketsPerGroup;
+  http2_session_window = kEmbeddedSessionWindow;
+  http2_stream_window = kEmbeddedStreamWindow;
+  http2_read_buffer = kLowMemoryHttp2ReadBuffer;
+  quic_session_window = kEmbeddedSessionWindow;
+  quic_stream_window = kEmbeddedStreamWindow;
+  quic_receive_buffer = kEmbeddedQuicReceiveBuffer;
+  min_log_level = logging::LOGGING_WARNING;
+}
+
 bool NaiveConfig::Parse(const base::Value::Dict& value) {
+  // Parsed first, so that the options given with it override its defaults.
+  if (const base::Value* v = value.Find("profile")) {
+    const std::string* str = v->GetIfString();
+    if (!str || *str != "embedded") {
+      std::cerr << "Invalid profile" << std::endl;
+      return false;
+    }
+    ApplyEmbeddedProfile();
+  }
+
   if (const base::Value* v = value.Find("listen")) {
     listen.clear();
     if (const std::string* str = v->GetIfString()) {
@@ -116,154 +526,1223 @@ bool NaiveConfig::Parse(const base::Value::Dict& value) {
     }
   }
 
-  if (const base::Value* v = value.Find("extra-headers")) {
-    if (const std::string* str = v->GetIfString()) {
-      extra_headers.AddHeadersFromString(*str);
+  if (const base::Value* v = value.Find("threads")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      threads = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &threads)) {
+        std::cerr << "Invalid threads" << std::endl;
+        return false;
+      }
     } else {
-      std::cerr << "Invalid extra-headers" << std::endl;
+      std::cerr << "Invalid threads" << std::endl;
+      return false;
+    }
+    if (threads < 1) {
+      std::cerr << "Invalid threads" << std::endl;
+      return false;
+    }
+#if !BUILDFLAG(IS_POSIX)
+    if (threads > 1) {
+      std::cerr << "Multiple threads require SO_REUSEPORT" << std::endl;
       return false;
     }
+#endif
   }
 
-  if (const base::Value* v = value.Find("proxy")) {
-    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
-      base::StringTokenizer proxy_uri_list(*str, ",");
-      std::vector<ProxyServer> proxy_servers;
-      bool seen_tcp = false;
-      while (proxy_uri_list.GetNext()) {
-        std::string token(proxy_uri_list.token());
-        GURL url(token);
-
-        std::u16string proxy_user;
-        std::u16string proxy_pass;
-        net::GetIdentityFromURL(url, &proxy_user, &proxy_pass);
-        GURL::Replacements remove_auth;
-        remove_auth.ClearUsername();
-        remove_auth.ClearPassword();
-        GURL url_no_auth = url.ReplaceComponents(remove_auth);
-        std::string proxy_uri = url_no_auth.GetWithEmptyPath().spec();
-        if (proxy_uri.back() == '/') {
-          proxy_uri.pop_back();
-        }
+  if (const base::Value* v = value.Find("thread-pool-workers")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      thread_pool_workers = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &thread_pool_workers)) {
+        std::cerr << "Invalid thread-pool-workers" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid thread-pool-workers" << std::endl;
+      return false;
+    }
+    if (thread_pool_workers < 1) {
+      std::cerr << "Invalid thread-pool-workers" << std::endl;
+      return false;
+    }
+  }
 
-        proxy_servers.emplace_back(MyProxyUriToProxyServer(proxy_uri));
-        const ProxyServer& last = proxy_servers.back();
-        if (last.is_quic()) {
-          if (seen_tcp) {
-            std::cerr << "QUIC proxy cannot follow TCP-based proxies"
-                      << std::endl;
-            return false;
-          }
-          origins_to_force_quic_on.insert(HostPortPair::FromURL(url));
-        } else if (last.is_https() || last.is_http() || last.is_socks()) {
-          seen_tcp = true;
-        } else {
-          std::cerr << "Invalid proxy scheme" << std::endl;
-          return false;
-        }
+  if (const base::Value* v = value.Find("allocator-profile")) {
+    std::optional<NaiveAllocatorProfile> profile;
+    if (const std::string* str = v->GetIfString()) {
+      profile = ParseAllocatorProfile(*str);
+    }
+    if (!profile.has_value()) {
+      std::cerr << "Invalid allocator-profile" << std::endl;
+      return false;
+    }
+    allocator_profile = *profile;
+    if (allocator_profile == NaiveAllocatorProfile::kLowMemory) {
+      buffer_pool_size = kLowMemoryBufferPoolSize;
+      http2_read_buffer = kLowMemoryHttp2ReadBuffer;
+    }
+  }
 
-        AuthCredentials auth(proxy_user, proxy_pass);
-        if (!auth.Empty()) {
-          if (last.is_socks()) {
-            std::cerr << "SOCKS proxy with auth is not supported" << std::endl;
-          } else {
-            std::string proxy_url(token);
-            if (proxy_url.compare(0, 7, "quic://") == 0) {
-              proxy_url.replace(0, 4, "https");
-            }
-            auth_store[url::SchemeHostPort{GURL{proxy_url}}] = auth;
-          }
-        }
+  if (const base::Value* v = value.Find("buffer-pool-size")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      buffer_pool_size = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &buffer_pool_size)) {
+        std::cerr << "Invalid buffer-pool-size" << std::endl;
+        return false;
       }
+    } else {
+      std::cerr << "Invalid buffer-pool-size" << std::endl;
+      return false;
+    }
+    if (buffer_pool_size < 0) {
+      std::cerr << "Invalid buffer-pool-size" << std::endl;
+      return false;
+    }
+  }
 
-      if (proxy_servers.size() > 1 &&
-          std::any_of(proxy_servers.begin(), proxy_servers.end(),
-                      [](const ProxyServer& s) { return s.is_socks(); })) {
-        // See net/socket/connect_job_params_factory.cc
-        // DCHECK(proxy_server.is_socks());
-        // DCHECK_EQ(1u, proxy_chain.length());
-        std::cerr
-            << "Multi-proxy chain containing SOCKS proxies is not supported."
-            << std::endl;
+  if (const base::Value* v = value.Find("relay-buffer")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      relay_buffer = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &relay_buffer)) {
+        std::cerr << "Invalid relay-buffer" << std::endl;
         return false;
       }
-      if (std::any_of(proxy_servers.begin(), proxy_servers.end(),
-                      [](const ProxyServer& s) { return s.is_quic(); })) {
-        proxy_chain = ProxyChain::ForIpProtection(proxy_servers);
-      } else {
-        proxy_chain = ProxyChain(proxy_servers);
-      }
+    } else {
+      std::cerr << "Invalid relay-buffer" << std::endl;
+      return false;
+    }
+    if (relay_buffer < NaiveBufferPool::kMinBufferSize ||
+        relay_buffer > NaiveBufferPool::kBufferSize ||
+        (relay_buffer & (relay_buffer - 1)) != 0) {
+      std::cerr << "Invalid relay-buffer" << std::endl;
+      return false;
+    }
+  }
+
+  if (value.contains("huge-page-buffers")) {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+    huge_page_buffers = true;
+#else
+    std::cerr << "Huge page buffers only support Linux." << std::endl;
+    return false;
+#endif
+  }
 
-      if (!proxy_chain.IsValid()) {
-        std::cerr << "Invalid proxy chain" << std::endl;
+  if (const base::Value* v = value.Find("accept-budget")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      accept_budget = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &accept_budget)) {
+        std::cerr << "Invalid accept-budget" << std::endl;
         return false;
       }
     } else {
-      std::cerr << "Invalid proxy argument" << std::endl;
+      std::cerr << "Invalid accept-budget" << std::endl;
+      return false;
+    }
+    if (accept_budget < 1) {
+      std::cerr << "Invalid accept-budget" << std::endl;
       return false;
     }
   }
 
-  if (const base::Value* v = value.Find("host-resolver-rules")) {
-    if (const std::string* str = v->GetIfString()) {
-      host_resolver_rules = *str;
+  if (const base::Value* v = value.Find("max-connections")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      max_connections = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &max_connections)) {
+        std::cerr << "Invalid max-connections" << std::endl;
+        return false;
+      }
     } else {
-      std::cerr << "Invalid host-resolver-rules" << std::endl;
+      std::cerr << "Invalid max-connections" << std::endl;
+      return false;
+    }
+    if (max_connections < 0) {
+      std::cerr << "Invalid max-connections" << std::endl;
       return false;
     }
   }
 
-  if (const base::Value* v = value.Find("resolver-range")) {
-    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
-      if (!net::ParseCIDRBlock(*str, &resolver_range, &resolver_prefix)) {
-        std::cerr << "Invalid resolver-range" << std::endl;
+  if (const base::Value* v = value.Find("memory-pressure")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      memory_pressure = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &memory_pressure)) {
+        std::cerr << "Invalid memory-pressure" << std::endl;
         return false;
       }
-      if (resolver_range.IsIPv6()) {
-        std::cerr << "IPv6 resolver range not supported" << std::endl;
+    } else {
+      std::cerr << "Invalid memory-pressure" << std::endl;
+      return false;
+    }
+    if (memory_pressure < 0) {
+      std::cerr << "Invalid memory-pressure" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("client-rate")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      client_rate = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &client_rate)) {
+        std::cerr << "Invalid client-rate" << std::endl;
         return false;
       }
     } else {
-      std::cerr << "Invalid resolver-range" << std::endl;
+      std::cerr << "Invalid client-rate" << std::endl;
+      return false;
+    }
+    if (client_rate < 0) {
+      std::cerr << "Invalid client-rate" << std::endl;
       return false;
     }
   }
 
-  if (const base::Value* v = value.Find("log")) {
-    if (const std::string* str = v->GetIfString()) {
-      if (!str->empty()) {
-        log.logging_dest = logging::LOG_TO_FILE;
-        log_file = base::FilePath::FromUTF8Unsafe(*str);
-        log.log_file_path = log_file.value().c_str();
-      } else {
-        log.logging_dest = logging::LOG_TO_STDERR;
+  if (const base::Value* v = value.Find("client-burst")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      client_burst = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &client_burst)) {
+        std::cerr << "Invalid client-burst" << std::endl;
+        return false;
       }
     } else {
-      std::cerr << "Invalid log" << std::endl;
+      std::cerr << "Invalid client-burst" << std::endl;
+      return false;
+    }
+    if (client_burst < 1) {
+      std::cerr << "Invalid client-burst" << std::endl;
       return false;
     }
+  } else {
+    client_burst = client_rate;
   }
 
-  if (const base::Value* v = value.Find("log-net-log")) {
-    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
-      log_net_log = base::FilePath::FromUTF8Unsafe(*str);
+  if (const base::Value* v = value.Find("client-max-connections")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      client_max_connections = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &client_max_connections)) {
+        std::cerr << "Invalid client-max-connections" << std::endl;
+        return false;
+      }
     } else {
-      std::cerr << "Invalid log-net-log" << std::endl;
+      std::cerr << "Invalid client-max-connections" << std::endl;
+      return false;
+    }
+    if (client_max_connections < 0) {
+      std::cerr << "Invalid client-max-connections" << std::endl;
       return false;
     }
   }
 
-  if (const base::Value* v = value.Find("ssl-key-log-file")) {
-    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
-      ssl_key_log_file = base::FilePath::FromUTF8Unsafe(*str);
+  if (const base::Value* v = value.Find("max-sockets-per-pool")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      max_sockets_per_pool = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &max_sockets_per_pool)) {
+        std::cerr << "Invalid max-sockets-per-pool" << std::endl;
+        return false;
+      }
     } else {
-      std::cerr << "Invalid ssl-key-log-file" << std::endl;
+      std::cerr << "Invalid max-sockets-per-pool" << std::endl;
+      return false;
+    }
+    if (max_sockets_per_pool < 1) {
+      std::cerr << "Invalid max-sockets-per-pool" << std::endl;
       return false;
     }
   }
 
-  if (value.contains("no-post-quantum")) {
-    no_post_quantum = true;
+  if (const base::Value* v = value.Find("max-sockets-per-group")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      max_sockets_per_group = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &max_sockets_per_group)) {
+        std::cerr << "Invalid max-sockets-per-group" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid max-sockets-per-group" << std::endl;
+      return false;
+    }
+    if (max_sockets_per_group < 1 ||
+        max_sockets_per_group > max_sockets_per_pool) {
+      std::cerr << "Invalid max-sockets-per-group" << std::endl;
+      return false;
+    }
+  } else {
+    max_sockets_per_group =
+        std::min(max_sockets_per_group, max_sockets_per_pool);
+  }
+
+  if (const base::Value* v = value.Find("scheduler-quantum")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      scheduler_quantum = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &scheduler_quantum)) {
+        std::cerr << "Invalid scheduler-quantum" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid scheduler-quantum" << std::endl;
+      return false;
+    }
+    if (scheduler_quantum < 1) {
+      std::cerr << "Invalid scheduler-quantum" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("scheduler-slice")) {
+    int slice_ms = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      slice_ms = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &slice_ms)) {
+        std::cerr << "Invalid scheduler-slice" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid scheduler-slice" << std::endl;
+      return false;
+    }
+    if (slice_ms < 1) {
+      std::cerr << "Invalid scheduler-slice" << std::endl;
+      return false;
+    }
+    scheduler_slice = base::Milliseconds(slice_ms);
+  }
+
+  if (const base::Value* v = value.Find("idle-timeout")) {
+    int seconds = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      seconds = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &seconds)) {
+        std::cerr << "Invalid idle-timeout" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid idle-timeout" << std::endl;
+      return false;
+    }
+    if (seconds < 0) {
+      std::cerr << "Invalid idle-timeout" << std::endl;
+      return false;
+    }
+    idle_timeout = base::Seconds(seconds);
+  }
+
+  if (const base::Value* v = value.Find("read-idle-timeout")) {
+    int seconds = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      seconds = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &seconds)) {
+        std::cerr << "Invalid read-idle-timeout" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid read-idle-timeout" << std::endl;
+      return false;
+    }
+    if (seconds < 0) {
+      std::cerr << "Invalid read-idle-timeout" << std::endl;
+      return false;
+    }
+    read_idle_timeout = base::Seconds(seconds);
+  }
+
+  if (const base::Value* v = value.Find("write-idle-timeout")) {
+    int seconds = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      seconds = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &seconds)) {
+        std::cerr << "Invalid write-idle-timeout" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid write-idle-timeout" << std::endl;
+      return false;
+    }
+    if (seconds < 0) {
+      std::cerr << "Invalid write-idle-timeout" << std::endl;
+      return false;
+    }
+    write_idle_timeout = base::Seconds(seconds);
+  }
+
+  if (const base::Value* v = value.Find("half-open-timeout")) {
+    int seconds = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      seconds = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &seconds)) {
+        std::cerr << "Invalid half-open-timeout" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid half-open-timeout" << std::endl;
+      return false;
+    }
+    if (seconds < 0) {
+      std::cerr << "Invalid half-open-timeout" << std::endl;
+      return false;
+    }
+    half_open_timeout = base::Seconds(seconds);
+  }
+
+  if (const base::Value* v = value.Find("proxy-keepalive")) {
+    int seconds = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      seconds = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &seconds)) {
+        std::cerr << "Invalid proxy-keepalive" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid proxy-keepalive" << std::endl;
+      return false;
+    }
+    if (seconds < 0) {
+      std::cerr << "Invalid proxy-keepalive" << std::endl;
+      return false;
+    }
+    proxy_keepalive = base::Seconds(seconds);
+  }
+
+  if (const base::Value* v = value.Find("busy-poll")) {
+    int usec = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      usec = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &usec)) {
+        std::cerr << "Invalid busy-poll" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid busy-poll" << std::endl;
+      return false;
+    }
+    if (usec < 0) {
+      std::cerr << "Invalid busy-poll" << std::endl;
+      return false;
+    }
+    busy_poll = base::Microseconds(usec);
+  }
+
+  if (value.contains("low-power")) {
+    low_power = true;
+  }
+
+  if (const base::Value* v = value.Find("http2-session-window")) {
+    if (!ParseHttp2Window(*v, &http2_session_window)) {
+      std::cerr << "Invalid http2-session-window" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("http2-stream-window")) {
+    if (!ParseHttp2Window(*v, &http2_stream_window)) {
+      std::cerr << "Invalid http2-stream-window" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("http2-auto-window")) {
+    if (!ParseHttp2Window(*v, &http2_auto_window)) {
+      std::cerr << "Invalid http2-auto-window" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("http2-read-buffer")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      http2_read_buffer = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &http2_read_buffer)) {
+        std::cerr << "Invalid http2-read-buffer" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid http2-read-buffer" << std::endl;
+      return false;
+    }
+    if (http2_read_buffer < kHttp2MinReadBuffer) {
+      std::cerr << "Invalid http2-read-buffer" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("http2-window-update-delay")) {
+    int delay_ms = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      delay_ms = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &delay_ms)) {
+        std::cerr << "Invalid http2-window-update-delay" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid http2-window-update-delay" << std::endl;
+      return false;
+    }
+    if (delay_ms < 0) {
+      std::cerr << "Invalid http2-window-update-delay" << std::endl;
+      return false;
+    }
+    http2_window_update_delay = base::Milliseconds(delay_ms);
+  }
+
+  if (const base::Value* v = value.Find("quic-congestion-control")) {
+    const std::string* str = v->GetIfString();
+    if (str && *str == "bbr") {
+      quic_connection_options.push_back(quic::kTBBR);
+    } else if (str && *str == "bbr2") {
+      quic_connection_options.push_back(quic::kB2ON);
+    } else if (str && *str == "cubic") {
+      quic_connection_options.push_back(quic::kBYTE);
+    } else if (str && *str == "reno") {
+      quic_connection_options.push_back(quic::kRENO);
+    } else {
+      std::cerr << "Invalid quic-congestion-control" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("quic-initial-window")) {
+    int packets = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      packets = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      base::StringToInt(*str, &packets);
+    }
+    // The only windows the connection options can force.
+    if (packets == 3) {
+      quic_connection_options.push_back(quic::kIW03);
+    } else if (packets == 10) {
+      quic_connection_options.push_back(quic::kIW10);
+    } else if (packets == 20) {
+      quic_connection_options.push_back(quic::kIW20);
+    } else if (packets == 50) {
+      quic_connection_options.push_back(quic::kIW50);
+    } else {
+      std::cerr << "Invalid quic-initial-window" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("quic-max-packet-size")) {
+    int size = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      size = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      base::StringToInt(*str, &size);
+    }
+    // QUIC requires 1200-byte datagrams.
+    if (size < 1200 || size > static_cast<int>(quic::kMaxOutgoingPacketSize)) {
+      std::cerr << "Invalid quic-max-packet-size" << std::endl;
+      return false;
+    }
+    quic_max_packet_size = size;
+  }
+
+  if (const base::Value* v = value.Find("quic-max-pacing-rate")) {
+    int mbps = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      mbps = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      base::StringToInt(*str, &mbps);
+    }
+    if (mbps <= 0) {
+      std::cerr << "Invalid quic-max-pacing-rate" << std::endl;
+      return false;
+    }
+    quic_max_pacing_rate = int64_t{mbps} * 1000 * 1000;
+  }
+
+  if (const base::Value* v = value.Find("quic-session-window")) {
+    int size = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      size = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      base::StringToInt(*str, &size);
+    }
+    // Below the minimum send window of quiche it would only throttle.
+    if (size < kQuicMinWindow) {
+      std::cerr << "Invalid quic-session-window" << std::endl;
+      return false;
+    }
+    quic_session_window = size;
+  }
+
+  if (const base::Value* v = value.Find("quic-stream-window")) {
+    int size = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      size = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      base::StringToInt(*str, &size);
+    }
+    if (size < kQuicMinWindow) {
+      std::cerr << "Invalid quic-stream-window" << std::endl;
+      return false;
+    }
+    quic_stream_window = size;
+  }
+
+  if (const base::Value* v = value.Find("quic-receive-buffer")) {
+    int size = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      size = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      base::StringToInt(*str, &size);
+    }
+    if (size <= 0) {
+      std::cerr << "Invalid quic-receive-buffer" << std::endl;
+      return false;
+    }
+    quic_receive_buffer = size;
+  }
+
+  if (const base::Value* v = value.Find("quic-max-receive-buffer")) {
+    int size = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      size = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      base::StringToInt(*str, &size);
+    }
+    if (size <= 0) {
+      std::cerr << "Invalid quic-max-receive-buffer" << std::endl;
+      return false;
+    }
+    quic_max_receive_buffer = size;
+  }
+
+  if (const base::Value* v = value.Find("quic-session-file")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      quic_session_file = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid quic-session-file" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("tls-session-file")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      tls_session_file = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid tls-session-file" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("cert-verify-file")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      cert_verify_file = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid cert-verify-file" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("host-cache-file")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      host_cache_file = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid host-cache-file" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("padding-profile")) {
+    std::optional<NaivePaddingProfile> profile;
+    if (const std::string* str = v->GetIfString()) {
+      profile = NaivePaddingProfile::Parse(*str);
+    }
+    if (!profile.has_value()) {
+      std::cerr << "Invalid padding-profile" << std::endl;
+      return false;
+    }
+    padding_profile = *profile;
+  }
+
+  if (const base::Value* v = value.Find("compression")) {
+    std::optional<Compression> compression_value;
+    if (const std::string* str = v->GetIfString()) {
+      compression_value = ParseCompression(*str);
+    }
+    if (!compression_value.has_value()) {
+      std::cerr << "Invalid compression" << std::endl;
+      return false;
+    }
+    compression = *compression_value;
+  }
+
+  if (const base::Value* v = value.Find("priority-rules")) {
+    std::optional<NaivePriorityRules> rules;
+    if (const std::string* str = v->GetIfString()) {
+      rules = NaivePriorityRules::Parse(*str);
+    }
+    if (!rules.has_value()) {
+      std::cerr << "Invalid priority-rules" << std::endl;
+      return false;
+    }
+    priority_rules = *rules;
+  }
+
+  if (const base::Value* v = value.Find("priority-rates")) {
+    std::optional<NaivePriorityRateLimiters> limiters;
+    if (const std::string* str = v->GetIfString()) {
+      limiters = ParsePriorityRateLimiters(*str);
+    }
+    if (!limiters.has_value()) {
+      std::cerr << "Invalid priority-rates" << std::endl;
+      return false;
+    }
+    priority_rate_limiters = std::move(*limiters);
+  }
+
+  if (const base::Value* v = value.Find("priority-dscp")) {
+    std::optional<NaivePriorityDscps> dscps;
+    if (const std::string* str = v->GetIfString()) {
+      dscps = ParsePriorityDscps(*str);
+    }
+    if (!dscps.has_value()) {
+      std::cerr << "Invalid priority-dscp" << std::endl;
+      return false;
+    }
+    priority_dscps = *dscps;
+    class_sessions = true;
+  }
+
+  if (value.contains("balance-accept")) {
+    balance_accept = true;
+  }
+
+  if (value.contains("cpu-affinity")) {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+    cpu_affinity = true;
+#else
+    std::cerr << "CPU affinity only supports Linux." << std::endl;
+    return false;
+#endif
+  }
+
+  if (value.contains("adaptive-concurrency")) {
+    adaptive_concurrency = true;
+  }
+
+  if (value.contains("no-quic-migration")) {
+    no_quic_migration = true;
+  }
+
+  if (value.contains("optimistic-connect")) {
+    optimistic_connect = true;
+  }
+
+  if (value.contains("tls-early-data")) {
+    tls_early_data = true;
+  }
+
+  if (value.contains("kernel-tls")) {
+    kernel_tls = true;
+  }
+
+  if (value.contains("socks-pipelining")) {
+    socks_pipelining = true;
+  }
+
+  if (value.contains("connect-while-resolving")) {
+    connect_while_resolving = true;
+  }
+
+  if (value.contains("tcp-fast-open")) {
+    tcp_fast_open = true;
+  }
+
+  if (value.contains("mptcp")) {
+    mptcp = true;
+  }
+
+  if (value.contains("network-quality")) {
+    network_quality = true;
+  }
+
+  if (value.contains("quic-mtu-discovery")) {
+    quic_mtu_discovery = true;
+  }
+
+  if (value.contains("quic-ecn")) {
+    quic_ecn = true;
+  }
+
+  if (value.contains("quic-ack-decimation")) {
+    quic_ack_decimation = true;
+  }
+
+  if (value.contains("preconnect")) {
+    preconnect = true;
+  }
+
+  if (const base::Value* v = value.Find("http1-standby")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      http1_standby = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &http1_standby)) {
+        std::cerr << "Invalid http1-standby" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid http1-standby" << std::endl;
+      return false;
+    }
+    if (http1_standby < 0) {
+      std::cerr << "Invalid http1-standby" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("spare-connections")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      spare_connections = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &spare_connections)) {
+        std::cerr << "Invalid spare-connections" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid spare-connections" << std::endl;
+      return false;
+    }
+    if (spare_connections < 0) {
+      std::cerr << "Invalid spare-connections" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("uplinks")) {
+    const std::string* str = v->GetIfString();
+    if (!str || str->empty()) {
+      std::cerr << "Invalid uplinks" << std::endl;
+      return false;
+    }
+    base::StringTokenizer names(*str, ",");
+    while (names.GetNext()) {
+      if (names.token_piece().empty()) {
+        std::cerr << "Invalid uplinks" << std::endl;
+        return false;
+      }
+      uplinks.push_back(names.token());
+    }
+    // One session per uplink at least, so that every uplink is used.
+    insecure_concurrency =
+        std::max(insecure_concurrency, static_cast<int>(uplinks.size()));
+  }
+
+  if (const base::Value* v = value.Find("http-cache")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      http_cache = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid http-cache" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("http-cache-size")) {
+    // In MiB, up to the int size of the disk cache.
+    int mib = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      mib = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      base::StringToInt(*str, &mib);
+    }
+    if (mib <= 0 || mib >= 2048) {
+      std::cerr << "Invalid http-cache-size" << std::endl;
+      return false;
+    }
+    http_cache_size = mib * 1024 * 1024;
+  }
+
+  if (const base::Value* v = value.Find("http-cache-hosts")) {
+    const std::string* str = v->GetIfString();
+    if (!str || str->empty()) {
+      std::cerr << "Invalid http-cache-hosts" << std::endl;
+      return false;
+    }
+    base::StringTokenizer hosts(*str, ",");
+    while (hosts.GetNext()) {
+      http_cache_hosts.push_back(base::ToLowerASCII(hosts.token_piece()));
+    }
+  }
+
+  if (const base::Value* v = value.Find("extra-headers")) {
+    if (const std::string* str = v->GetIfString()) {
+      extra_headers.AddHeadersFromString(*str);
+    } else {
+      std::cerr << "Invalid extra-headers" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("proxy")) {
+    proxy_chains.clear();
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      if (!ParseProxyChain(*str, &proxy_chains.emplace_back())) {
+        return false;
+      }
+    } else if (const base::Value::List* strs = v->GetIfList();
+               strs && !strs->empty()) {
+      for (const auto& str_e : *strs) {
+        const std::string* s = str_e.GetIfString();
+        if (!s || s->empty()) {
+          std::cerr << "Invalid proxy element" << std::endl;
+          return false;
+        }
+        if (!ParseProxyChain(*s, &proxy_chains.emplace_back())) {
+          return false;
+        }
+      }
+    } else {
+      std::cerr << "Invalid proxy argument" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("proxy-selection")) {
+    std::optional<ProxySelection> selection;
+    if (const std::string* str = v->GetIfString()) {
+      selection = ParseProxySelection(*str);
+    }
+    if (!selection.has_value()) {
+      std::cerr << "Invalid proxy-selection" << std::endl;
+      return false;
+    }
+    proxy_selection = *selection;
+  }
+
+  if (const base::Value* v = value.Find("health-check")) {
+    const std::string* str = v->GetIfString();
+    std::string host;
+    int port = 0;
+    if (!str || !ParseHostAndPort(*str, &host, &port) || port <= 0) {
+      std::cerr << "Invalid health-check" << std::endl;
+      return false;
+    }
+    health_check = HostPortPair(host, port);
+  }
+
+  if (const base::Value* v = value.Find("health-check-interval")) {
+    int seconds = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      seconds = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &seconds)) {
+        std::cerr << "Invalid health-check-interval" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid health-check-interval" << std::endl;
+      return false;
+    }
+    if (seconds <= 0) {
+      std::cerr << "Invalid health-check-interval" << std::endl;
+      return false;
+    }
+    health_check_interval = base::Seconds(seconds);
+  }
+
+  if (const base::Value* v = value.Find("connect-race")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      connect_race = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &connect_race)) {
+        std::cerr << "Invalid connect-race" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid connect-race" << std::endl;
+      return false;
+    }
+    if (connect_race < 1 ||
+        static_cast<size_t>(connect_race) > TransportConnectRace::kMaxWidth) {
+      std::cerr << "Invalid connect-race" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("host-resolver-rules")) {
+    if (const std::string* str = v->GetIfString()) {
+      host_resolver_rules = *str;
+    } else {
+      std::cerr << "Invalid host-resolver-rules" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("doh-server")) {
+    if (const std::string* str = v->GetIfString()) {
+      doh_config = DnsOverHttpsConfig::FromString(*str);
+    }
+    if (!doh_config) {
+      std::cerr << "Invalid doh-server" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("resolver-range")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      base::StringTokenizer range_list(*str, ",");
+      while (range_list.GetNext()) {
+        IPAddress range;
+        size_t prefix;
+        if (!net::ParseCIDRBlock(range_list.token_piece(), &range, &prefix)) {
+          std::cerr << "Invalid resolver-range" << std::endl;
+          return false;
+        }
+        if (range.IsIPv6()) {
+          resolver_range6 = range;
+          resolver_prefix6 = prefix;
+        } else {
+          resolver_range = range;
+          resolver_prefix = prefix;
+        }
+      }
+    } else {
+      std::cerr << "Invalid resolver-range" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("resolver-file")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      resolver_file = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid resolver-file" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("resolver-upstream")) {
+    if (const std::string* str = v->GetIfString()) {
+      resolver_upstream = GURL(*str);
+    }
+    if (!resolver_upstream.is_valid() ||
+        !resolver_upstream.SchemeIs(url::kHttpsScheme)) {
+      std::cerr << "Invalid resolver-upstream" << std::endl;
+      return false;
+    }
+  }
+
+  if (value.contains("resolver-all-listeners")) {
+    resolver_all_listeners = true;
+  }
+
+  if (const base::Value* v = value.Find("log")) {
+    if (const std::string* str = v->GetIfString()) {
+      if (!str->empty()) {
+        log.logging_dest = logging::LOG_TO_FILE;
+        log_file = base::FilePath::FromUTF8Unsafe(*str);
+        log.log_file_path = log_file.value().c_str();
+      } else {
+        log.logging_dest = logging::LOG_TO_STDERR;
+      }
+    } else {
+      std::cerr << "Invalid log" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("log-net-log")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      log_net_log = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid log-net-log" << std::endl;
+      return false;
+    }
+  }
+
+  if (value.contains("log-net-log-binary")) {
+    log_net_log_binary = true;
+  }
+
+  if (const base::Value* v = value.Find("log-net-log-sample")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      log_net_log_sample = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &log_net_log_sample)) {
+        std::cerr << "Invalid log-net-log-sample" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid log-net-log-sample" << std::endl;
+      return false;
+    }
+    if (log_net_log_sample < 1) {
+      std::cerr << "Invalid log-net-log-sample" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("metrics")) {
+    const std::string* str = v->GetIfString();
+    if (!str || !ParseHostAndPort(*str, &metrics_addr, &metrics_port) ||
+        metrics_port <= 0) {
+      std::cerr << "Invalid metrics" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("access-log")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      access_log = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid access-log" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("access-log-sample")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      access_log_sample = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &access_log_sample)) {
+        std::cerr << "Invalid access-log-sample" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid access-log-sample" << std::endl;
+      return false;
+    }
+    if (access_log_sample < 1) {
+      std::cerr << "Invalid access-log-sample" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("trace-file")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      trace_file = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid trace-file" << std::endl;
+      return false;
+    }
+    if (!NaiveTraceRecorder::IsSupported()) {
+      std::cerr << "trace-file needs a build with tracing" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("trace-duration")) {
+    int seconds = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      seconds = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &seconds)) {
+        std::cerr << "Invalid trace-duration" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid trace-duration" << std::endl;
+      return false;
+    }
+    if (seconds <= 0) {
+      std::cerr << "Invalid trace-duration" << std::endl;
+      return false;
+    }
+    trace_duration = base::Seconds(seconds);
+  }
+
+  if (const base::Value* v = value.Find("handoff")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      handoff = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid handoff" << std::endl;
+      return false;
+    }
+#if !BUILDFLAG(IS_POSIX)
+    std::cerr << "handoff requires Unix sockets" << std::endl;
+    return false;
+#endif
+  }
+
+  if (const base::Value* v = value.Find("bench")) {
+    const std::string* str = v->GetIfString();
+    std::string host;
+    int port = 0;
+    if (!str || !ParseHostAndPort(*str, &host, &port) || port <= 0) {
+      std::cerr << "Invalid bench" << std::endl;
+      return false;
+    }
+    bench = HostPortPair(host, port);
+    // The benchmark makes its own tunnels.
+    listen.clear();
+  }
+
+  if (const base::Value* v = value.Find("bench-connections")) {
+    if (std::optional<int> i = v->GetIfInt()) {
+      bench_connections = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &bench_connections)) {
+        std::cerr << "Invalid bench-connections" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid bench-connections" << std::endl;
+      return false;
+    }
+    if (bench_connections < 1) {
+      std::cerr << "Invalid bench-connections" << std::endl;
+      return false;
+    }
+  }
+
+  if (const base::Value* v = value.Find("bench-duration")) {
+    int seconds = 0;
+    if (std::optional<int> i = v->GetIfInt()) {
+      seconds = *i;
+    } else if (const std::string* str = v->GetIfString()) {
+      if (!base::StringToInt(*str, &seconds)) {
+        std::cerr << "Invalid bench-duration" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Invalid bench-duration" << std::endl;
+      return false;
+    }
+    if (seconds <= 0) {
+      std::cerr << "Invalid bench-duration" << std::endl;
+      return false;
+    }
+    bench_duration = base::Seconds(seconds);
+  }
+
+  if (value.contains("bench-upload")) {
+    bench_upload = true;
+  }
+
+  if (const base::Value* v = value.Find("ssl-key-log-file")) {
+    if (const std::string* str = v->GetIfString(); str && !str->empty()) {
+      ssl_key_log_file = base::FilePath::FromUTF8Unsafe(*str);
+    } else {
+      std::cerr << "Invalid ssl-key-log-file" << std::endl;
+      return false;
+    }
+  }
+
+  if (value.contains("no-post-quantum")) {
+    no_post_quantum = true;
+  }
+
+  if (value.contains("adaptive-post-quantum")) {
+    adaptive_post_quantum = true;
   }
 
   return true;
@@ -4,6 +4,7 @@
 #ifndef NET_TOOLS_NAIVE_NAIVE_CONFIG_H_
 #define NET_TOOLS_NAIVE_NAIVE_CONFIG_H_
 
+#include <cstdint>
 #include <map>
 #include <optional>
 #include <set>
@@ -12,13 +13,29 @@
 
 #include "base/files/file_path.h"
 #include "base/logging.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "net/base/auth.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/ip_address.h"
 #include "net/base/proxy_chain.h"
+#include "net/dns/public/dns_over_https_config.h"
 #include "net/http/http_request_headers.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_tag.h"
+#include "net/tools/naive/naive_accept_balancer.h"
+#include "net/tools/naive/naive_allocator_profile.h"
+#include "net/tools/naive/naive_buffer_pool.h"
+#include "net/tools/naive/naive_fd_budget.h"
+#include "net/tools/naive/naive_padding_profile.h"
+#include "net/tools/naive/naive_priority_rules.h"
 #include "net/tools/naive/naive_protocol.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+#include "net/tools/naive/naive_rate_limiter.h"
+#include "net/tools/naive/naive_scheduler.h"
+#include "net/tools/naive/naive_uplinks.h"
+#include "net/tools/naive/naive_user_table.h"
+#include "url/gurl.h"
 #include "url/scheme_host_port.h"
 
 namespace net {
@@ -29,43 +46,364 @@ struct NaiveListenConfig {
   std::string pass;
   std::string addr = "0.0.0.0";
   int port = 1080;
+  // Set for socks+unix and http+unix listeners, which are kSocks5 and kHttp
+  // listeners on the Unix domain socket file `addr`, without a port.
+  bool unix_socket = false;
+
+  // Padding offered by http, https and quic listeners to clients that request
+  // kVariant2. Zero frames disables padding on the listener. The compression
+  // is offered to clients that request it, with any padding type.
+  PaddingLimits padding_limits;
+
+  // Priority class of tunnels accepted by the listener, unless a priority
+  // rule of NaiveConfig covers their destination port.
+  TunnelPriority priority = TunnelPriority::kDefault;
+
+  RelaySocketOptions relay_socket_options;
+
+  // Whether an http listener also takes HTTP/2 with prior knowledge (h2c),
+  // given by the `h2c` option, with a CONNECT stream per tunnel.
+  bool h2c = false;
+
+  // PEM certificate chain and private key of https and quic listeners, read
+  // from the files given by the `cert` and `key` options.
+  std::string cert_pem;
+  std::string key_pem;
+
+  // Descriptor of an open TUN device a tun listener reads, given by the `fd`
+  // option, as by an Android VpnService. Otherwise the listener opens the
+  // device named by `addr`.
+  int tun_fd = -1;
+
+  // The users the listener accepts: `user` and `pass` if given, and those
+  // of the file given by the `users` option of socks, http, https and quic
+  // listeners. Null if the listener takes no authentication.
+  scoped_refptr<const NaiveUserTable> users;
+
+  // Shared by all tunnels of the listener, given by the `rate` option. Null
+  // if there is no limit.
+  scoped_refptr<NaiveRateLimiter> rate_limiter;
 
   NaiveListenConfig();
   NaiveListenConfig(const NaiveListenConfig&);
   ~NaiveListenConfig();
   bool Parse(const std::string& str);
+  // Whether `other` listens with the same protocol on the same address.
+  bool IsSameListener(const NaiveListenConfig& other) const;
 };
 
 struct NaiveConfig {
+  static constexpr int kLowMemoryBufferPoolSize = 8;
+  static constexpr int kLowMemoryHttp2ReadBuffer = 64 * 1024;
+
+  // Defaults of --profile=embedded, for routers with 64 to 128 MiB of
+  // memory. Each tunnel holds up to four relay buffers and the receive
+  // window of its stream.
+  static constexpr int kEmbeddedRelayBuffer = 16 * 1024;
+  static constexpr int kEmbeddedMaxSocketsPerPool = 256;
+  static constexpr int kEmbeddedMaxSocketsPerGroup = 248;
+  static constexpr int kEmbeddedSessionWindow = 1024 * 1024;
+  static constexpr int kEmbeddedStreamWindow = 256 * 1024;
+  static constexpr int kEmbeddedQuicReceiveBuffer = 256 * 1024;
+
   std::vector<NaiveListenConfig> listen = {NaiveListenConfig()};
 
+  // Maximum number of tunnel sessions per proxy chain.
   int insecure_concurrency = 1;
 
+  // Opens the tunnel sessions only when the existing ones are busy.
+  bool adaptive_concurrency = false;
+
+  // Number of IO threads, each with its own network session and its own
+  // SO_REUSEPORT listen sockets.
+  int threads = 1;
+
+  // With several threads, accepts the TCP connections of each listener on
+  // the main thread and hands each to the least loaded thread, instead of
+  // leaving them to the SO_REUSEPORT hashing of per-thread sockets.
+  bool balance_accept = false;
+  // Pins each IO thread to its share of the CPUs, and steers the TCP
+  // connections of each listener to the thread pinned to the CPU that
+  // received them. Linux only.
+  bool cpu_affinity = false;
+  // Created by main() if `balance_accept` applies.
+  scoped_refptr<NaiveThreadLoads> thread_loads;
+  // Created by main() on POSIX, once the file descriptor limit is raised.
+  scoped_refptr<NaiveFdBudget> fd_budget;
+  // Interfaces or local addresses the tunnel sessions are spread over.
+  // Raises `insecure_concurrency` to their number.
+  std::vector<std::string> uplinks;
+  // Created by main() from `uplinks` if not empty.
+  scoped_refptr<NaiveUplinks> uplink_set;
+
+  // Number of ThreadPool workers for disk and other blocking work. Zero for
+  // the base defaults.
+  int thread_pool_workers = 0;
+
+  // Thread cache tuning of the allocator.
+  NaiveAllocatorProfile allocator_profile = NaiveAllocatorProfile::kDefault;
+
+  // Maximum number of free relay buffers cached per thread.
+  // kLowMemoryBufferPoolSize by default with the low memory allocator
+  // profile.
+  int buffer_pool_size = 64;
+
+  // Size up to which relay buffers grow while reads fill them, a power of
+  // two from 4 KiB to 64 KiB.
+  int relay_buffer = NaiveBufferPool::kBufferSize;
+
+  // Takes the relay buffers of each IO thread from huge pages on its NUMA
+  // node. Linux only.
+  bool huge_page_buffers = false;
+
+  // Maximum number of connections accepted per listen socket before yielding
+  // to other tasks.
+  int accept_budget = 32;
+
+  // Maximum number of open connections, split evenly over the IO threads.
+  // Listeners stop accepting while a thread is at its share. Zero for no
+  // limit.
+  int max_connections = 0;
+
+  // Limits per client address, split evenly over the IO threads: new
+  // connections per second with bursts of `client_burst`, and open
+  // connections. Zero for no limit.
+  int client_rate = 0;
+  int client_burst = 0;
+  int client_max_connections = 0;
+
+  // Memory pressure is moderate while less than this many MiB are available,
+  // and critical below half of it. Zero disables the monitor.
+  int memory_pressure = 0;
+
+  // Socket pool limits of the network sessions. Tunnels ignore them, but
+  // the other requests of the sessions do not.
+  int max_sockets_per_pool = 2048;
+  int max_sockets_per_group = 2040;
+
+  // Bytes a tunnel direction may relay per scheduler round.
+  int scheduler_quantum = NaiveScheduler::kDefaultQuantum;
+
+  // Longest time the scheduler resumes tunnels in one task.
+  base::TimeDelta scheduler_slice =
+      base::Milliseconds(NaiveScheduler::kDefaultSliceMilliseconds);
+
+  // Closes tunnels that relayed nothing for this long. Zero disables.
+  base::TimeDelta idle_timeout;
+
+  // Close tunnels that read nothing from the client, or wrote nothing to it,
+  // for this long, whatever the other direction relayed. Zero disables.
+  base::TimeDelta read_idle_timeout;
+  base::TimeDelta write_idle_timeout;
+
+  // Closes tunnels with one side closed that relayed nothing for this long.
+  // Zero disables.
+  base::TimeDelta half_open_timeout = base::Seconds(60);
+
+  // Tunnel sessions send a PING after this long without reads, and are
+  // replaced if it goes unanswered. Zero disables.
+  base::TimeDelta proxy_keepalive;
+
+  // IO threads poll for network events this long before sleeping, and set
+  // SO_BUSY_POLL on the relay sockets likewise. Zero disables.
+  base::TimeDelta busy_poll;
+
+  // Aligns delayed work that can wait to shared wake-ups, and batches the
+  // keepalive PINGs of tunnel sessions, so that an idle proxy wakes the
+  // device less often.
+  bool low_power = false;
+
+  // HTTP/2 receive windows of tunnel sessions and of each stream, in bytes.
+  // Zero keeps the network stack defaults.
+  int http2_session_window = 0;
+  int http2_stream_window = 0;
+
+  // Lets receive windows grow up to this size when the proxy fills them
+  // within two round trips. Zero disables.
+  int http2_auto_window = 0;
+
+  // Largest read buffer of a tunnel session, which grows from 8 KiB while
+  // reads fill it. kLowMemoryHttp2ReadBuffer by default with the low memory
+  // allocator profile.
+  int http2_read_buffer = 256 * 1024;
+
+  // Holds WINDOW_UPDATE frames for this long to send those of all tunnels
+  // of a session in one write. Zero sends each right away.
+  base::TimeDelta http2_window_update_delay = base::Milliseconds(2);
+
+  // QUIC connection options selecting the congestion control and the
+  // initial window, for both this side and the proxy to use.
+  quic::QuicTagVector quic_connection_options;
+  // Zero for the default.
+  size_t quic_max_packet_size = 0;
+  // Probes the path MTU of QUIC proxy sessions, remembered per network.
+  bool quic_mtu_discovery = false;
+  // Reports the ECN marks of received QUIC packets to the proxy.
+  bool quic_ecn = false;
+  // Lets QUIC proxy sessions ACK less often on bulk transfers.
+  bool quic_ack_decimation = false;
+  // In bits per second. Zero for no limit.
+  int64_t quic_max_pacing_rate = 0;
+  // Receive windows of QUIC sessions and streams. Zero for the defaults.
+  int quic_session_window = 0;
+  int quic_stream_window = 0;
+  // Socket receive buffer of QUIC sessions. Zero for the default.
+  int quic_receive_buffer = 0;
+  // Lets the receive buffer double up to this size while the kernel drops
+  // datagrams for lack of room. Zero disables.
+  int quic_max_receive_buffer = 0;
+  // Empty if QUIC session tickets are only kept in memory.
+  base::FilePath quic_session_file;
+  // Empty if TLS sessions are only kept in memory.
+  base::FilePath tls_session_file;
+  // Empty if certificate verifications are only kept in memory.
+  base::FilePath cert_verify_file;
+  // Empty if resolved hosts are only kept in memory.
+  base::FilePath host_cache_file;
+  // Closes QUIC proxy sessions on network changes instead of migrating them.
+  bool no_quic_migration = false;
+
+  // Priority classes of tunnels by destination port, ahead of those of the
+  // listeners.
+  NaivePriorityRules priority_rules;
+  // Rate limits of the tunnels of each priority class, across listeners.
+  NaivePriorityRateLimiters priority_rate_limiters;
+  // DSCP marks of the upstream packets of each priority class. If any is
+  // set, each class gets tunnel sessions of its own.
+  NaivePriorityDscps priority_dscps = kNoPriorityDscps;
+  bool class_sessions = false;
+
+  // Padding sizes for kVariant2. If set, kVariant2 is also requested from the
+  // proxy server.
+  NaivePaddingProfile padding_profile;
+
+  // Requested from the proxy servers for their tunnels.
+  Compression compression = Compression::kNone;
+
+  // Uses Fast Open with the last negotiated padding type however old it is.
+  bool optimistic_connect = false;
+
+  // Sends the first CONNECT of resumed TLS sessions to HTTPS proxies as
+  // early data.
+  bool tls_early_data = false;
+  // Lets the kernel encrypt the records sent to HTTPS proxies, on Linux.
+  bool kernel_tls = false;
+  // Writes the CONNECT to SOCKS5 proxies with the greeting.
+  bool socks_pipelining = false;
+  // Connects direct tunnels over the first address family resolved.
+  bool connect_while_resolving = false;
+  // TCP Fast Open on outgoing connections and listen sockets.
+  bool tcp_fast_open = false;
+  // Multipath TCP on outgoing connections, on Linux.
+  bool mptcp = false;
+  // Adapts the tunnel sessions to the estimates of a
+  // NetworkQualityEstimator.
+  bool network_quality = false;
+
+  // Connects the tunnel sessions at startup and after losing them.
+  bool preconnect = false;
+  // Idle connections kept ready to each HTTP/1.1 proxy. Zero disables.
+  int http1_standby = 0;
+  // Spare connections kept to each of the most popular destinations of
+  // direct tunnels. Zero disables.
+  int spare_connections = 0;
+
+  // Serves the plain HTTP GETs of http listeners through a disk cache in
+  // this directory if not empty.
+  base::FilePath http_cache;
+  int http_cache_size = 256 * 1024 * 1024;
+  // Hosts whose GETs are cached, with their subdomains. Empty for all.
+  std::vector<std::string> http_cache_hosts;
+
   HttpRequestHeaders extra_headers;
 
-  // The last server is assumed to be Naive.
-  ProxyChain proxy_chain = ProxyChain::Direct();
+  // New connections are spread over these chains.
+  std::vector<NaiveProxyChainConfig> proxy_chains = {NaiveProxyChainConfig()};
+  ProxySelection proxy_selection = ProxySelection::kWeighted;
+  // Probes each chain with a tunnel to this destination every interval, if
+  // not empty.
+  HostPortPair health_check;
+  base::TimeDelta health_check_interval = base::Seconds(10);
+  // Races connects to this many addresses of an HTTPS proxy.
+  int connect_race = 1;
   std::set<HostPortPair> origins_to_force_quic_on;
   std::map<url::SchemeHostPort, AuthCredentials> auth_store;
 
   std::string host_resolver_rules;
+  // Resolves the destinations of direct connections with DoH if set.
+  std::optional<DnsOverHttpsConfig> doh_config;
 
   IPAddress resolver_range = {100, 64, 0, 0};
   size_t resolver_prefix = 10;
+  // Empty if AAAA queries get no answers.
+  IPAddress resolver_range6;
+  size_t resolver_prefix6 = 0;
+  // Empty if resolutions are only kept in memory.
+  base::FilePath resolver_file;
+  // Invalid if queries other than A and AAAA are not forwarded.
+  GURL resolver_upstream;
+  // Whether socks and http listeners translate artificial addresses too.
+  bool resolver_all_listeners = false;
 
   logging::LoggingSettings log = {.logging_dest = logging::LOG_NONE};
   base::FilePath log_file;
+  // Messages below this severity are not logged.
+  logging::LogSeverity min_log_level = logging::LOGGING_INFO;
 
   base::FilePath log_net_log;
+  // Saves NetLog in the format of NaiveBinaryNetLogObserver.
+  bool log_net_log_binary = false;
+  // Saves the events of one in this many NetLog sources, and counts the
+  // rest.
+  int log_net_log_sample = 1;
+
+  // Serves metrics over HTTP on this address. Zero port disables.
+  std::string metrics_addr;
+  int metrics_port = 0;
+
+  // Empty if closed connections are logged at INFO instead.
+  base::FilePath access_log;
+  // Records one in this many closed connections in the access log.
+  int access_log_sample = 1;
+
+  // Empty if trace events are not recorded.
+  base::FilePath trace_file;
+  base::TimeDelta trace_duration = base::Seconds(30);
+
+  // Takes the listen sockets of the instance serving handoffs at this Unix
+  // socket path, and serves the next one there. Empty disables.
+  base::FilePath handoff;
+
+  // Benchmarks the proxy chains against this sink instead of listening, if
+  // not empty.
+  HostPortPair bench;
+  int bench_connections = 16;
+  base::TimeDelta bench_duration = base::Seconds(10);
+  // Pushes data to the sink instead of pulling it.
+  bool bench_upload = false;
 
   base::FilePath ssl_key_log_file;
 
   std::optional<bool> no_post_quantum;
+  // Offers the post-quantum key share per proxy by measured handshake time.
+  bool adaptive_post_quantum = false;
 
   NaiveConfig();
   NaiveConfig(const NaiveConfig&);
   ~NaiveConfig();
   bool Parse(const base::Value::Dict& value);
+
+  // Takes the options of `other` that can change without a restart: the
+  // proxy chains and their selection, the extra headers, the proxy
+  // credentials, and the listeners. Listeners kept from this config only
+  // take the credentials of `other`.
+  void ApplyReloadable(const NaiveConfig& other);
+
+ private:
+  // Sets the defaults of --profile=embedded.
+  void ApplyEmbeddedProfile();
+  bool ParseProxyChain(const std::string& str,
+                       NaiveProxyChainConfig* chain_config);
 };
 
 }  // namespace net
@@ -9,88 +9,244 @@
 
 #include "net/tools/naive/naive_connection.h"
 
+#include <algorithm>
 #include <cstring>
 #include <utility>
 
+#include "base/containers/span.h"
 #include "base/functional/bind.h"
 #include "base/functional/callback_helpers.h"
 #include "base/logging.h"
+#include "base/notreached.h"
 #include "base/rand_util.h"
 #include "base/strings/strcat.h"
+#include "base/strings/string_util.h"
 #include "base/task/single_thread_task_runner.h"
 #include "base/time/time.h"
+#include "base/trace_event/base_tracing.h"
 #include "build/build_config.h"
 #include "net/base/io_buffer.h"
-#include "net/base/load_flags.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
-#include "net/base/privacy_mode.h"
 #include "net/base/url_util.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/http/proxy_client_socket.h"
 #include "net/proxy_resolution/proxy_info.h"
 #include "net/socket/client_socket_handle.h"
-#include "net/socket/client_socket_pool_manager.h"
+#include "net/socket/datagram_server_socket.h"
 #include "net/socket/stream_socket.h"
-#include "net/spdy/spdy_session.h"
+#include "net/socket/tcp_client_socket.h"
+#include "net/tools/naive/http2_proxy_server_session.h"
+#include "net/tools/naive/http3_proxy_server.h"
 #include "net/tools/naive/http_proxy_server_socket.h"
+#include "net/tools/naive/naive_buffer_pool.h"
+#include "net/tools/naive/naive_http_cache.h"
 #include "net/tools/naive/naive_padding_socket.h"
+#include "net/tools/naive/naive_scheduler.h"
+#include "net/tools/naive/naive_tunnel_connector.h"
+#include "net/tools/naive/naive_udp_association.h"
 #include "net/tools/naive/redirect_resolver.h"
 #include "net/tools/naive/socks5_server_socket.h"
+#include "third_party/abseil-cpp/absl/base/attributes.h"
 #include "url/scheme_host_port.h"
+#include "url/url_constants.h"
 
 #if BUILDFLAG(IS_LINUX)
 #include <linux/netfilter_ipv4.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 
-#include "net/base/ip_endpoint.h"
 #include "net/base/sockaddr_storage.h"
-#include "net/socket/tcp_client_socket.h"
+#include "net/socket/socket_descriptor.h"
+#include "net/tools/naive/naive_splice_relay.h"
 #endif
 
 namespace net {
 
 namespace {
-constexpr int kBufferSize = 64 * 1024;
+// A read that waits longer than this shrinks the relay buffer back to the
+// minimum size, so idle tunnels do not keep large buffers.
+constexpr int kBufferShrinkIdleSeconds = 10;
+// Room kept around payloads that are written as padding frames.
+constexpr int kFrameRoom =
+    NaivePaddingSocket::kWriteHeadroom + NaivePaddingSocket::kWriteTailroom;
+
+ABSL_CONST_INIT thread_local NaiveConnection::RelayStats current_relay_stats;
+
+// Whether `host` is an IPv4 literal in the dotted decimal form that the URL
+// canonicalizer gives it.
+bool IsCanonicalIPv4(std::string_view host) {
+  int parts = 0;
+  int value = 0;
+  int digits = 0;
+  for (size_t i = 0; i <= host.size(); ++i) {
+    if (i == host.size() || host[i] == '.') {
+      if (digits == 0 || value > 255 || ++parts > 4) {
+        return false;
+      }
+      value = 0;
+      digits = 0;
+    } else if (base::IsAsciiDigit(host[i]) && digits < 3 &&
+               !(digits == 1 && value == 0)) {
+      value = value * 10 + (host[i] - '0');
+      ++digits;
+    } else {
+      return false;
+    }
+  }
+  return parts == 4;
+}
+
+// Whether CanonicalizeHost() would return `host` unchanged, as it does for
+// lowercase ASCII host names and dotted decimal IPv4 literals, which most
+// tunnels ask for. A host whose last label starts with a digit may be an
+// IPv4 literal in another form, and is left to the canonicalizer, as are
+// IPv6 literals, punycode labels and anything with other characters.
+bool IsCanonicalHost(std::string_view host) {
+  std::string_view last_label = host;
+  if (!last_label.empty() && last_label.back() == '.') {
+    last_label.remove_suffix(1);
+  }
+  size_t dot = last_label.rfind('.');
+  if (dot != std::string_view::npos) {
+    last_label.remove_prefix(dot + 1);
+  }
+  if (last_label.empty()) {
+    return false;
+  }
+  if (!base::IsAsciiLower(last_label[0])) {
+    return IsCanonicalIPv4(host);
+  }
+  return host.find("xn--") == std::string_view::npos &&
+         std::all_of(host.begin(), host.end(), [](char c) {
+           return base::IsAsciiLower(c) || base::IsAsciiDigit(c) ||
+                  c == '-' || c == '.';
+         });
+}
 }  // namespace
 
+// Points at bytes lent from the receive buffer of a socket until Detach().
+class NaiveConnection::LentIOBuffer : public WrappedIOBuffer {
+ public:
+  explicit LentIOBuffer(base::span<const char> data) : WrappedIOBuffer(data) {}
+
+  // Copies the bytes out before they are consumed from the lender. Writers
+  // read through data() whenever they write, so a pending write sends the
+  // copy.
+  void Detach() {
+    copy_ = NaiveBufferPool::Acquire(size_);
+    memcpy(copy_->data(), data(), size_);
+    data_ = copy_->data();
+  }
+
+ private:
+  ~LentIOBuffer() override { data_ = nullptr; }
+
+  scoped_refptr<IOBuffer> copy_;
+};
+
 NaiveConnection::NaiveConnection(
-    unsigned int id,
+    uint64_t id,
     ClientProtocol protocol,
-    std::unique_ptr<PaddingDetectorDelegate> padding_detector_delegate,
+    NaiveProxyDelegate* naive_proxy_delegate,
     const ProxyInfo& proxy_info,
     RedirectResolver* resolver,
     HttpNetworkSession* session,
-    const NetworkAnonymizationKey& network_anonymization_key,
+    NaiveHttpCache* http_cache,
+    const NaiveProxySelector::ClassKeys& session_keys,
     const NetLogWithSource& net_log,
-    std::unique_ptr<StreamSocket> accepted_socket,
+    const NaivePaddingProfile& padding_profile,
+    TunnelPriority listen_priority,
+    const NaivePriorityRules& priority_rules,
+    const RelaySocketOptions& relay_socket_options,
     const NetworkTrafficAnnotationTag& traffic_annotation)
     : id_(id),
       protocol_(protocol),
-      padding_detector_delegate_(std::move(padding_detector_delegate)),
+      padding_detector_delegate_(naive_proxy_delegate,
+                                 proxy_info.proxy_chain(),
+                                 protocol),
       proxy_info_(proxy_info),
       resolver_(resolver),
       session_(session),
-      network_anonymization_key_(network_anonymization_key),
+      http_cache_(http_cache),
+      session_keys_(session_keys),
       net_log_(net_log),
+      padding_profile_(padding_profile),
+      priority_rules_(priority_rules),
+      traffic_annotation_(traffic_annotation),
+      relay_socket_options_(relay_socket_options),
+      priority_(listen_priority),
       next_state_(STATE_NONE),
-      client_socket_(std::move(accepted_socket)),
       server_socket_handle_(std::make_unique<ClientSocketHandle>()),
       sockets_{nullptr, nullptr},
+      read_transports_{nullptr, nullptr},
+      write_transports_{nullptr, nullptr},
+      relayed_bytes_{0, 0},
       errors_{OK, OK},
+      read_sizes_{NaiveBufferPool::kMinBufferSize,
+                  NaiveBufferPool::kMinBufferSize},
+      early_pull_result_(ERR_IO_PENDING),
+      server_connect_result_(ERR_IO_PENDING),
       write_pending_{false, false},
+      read_if_ready_pending_{false, false},
+      read_closed_{false, false},
+      write_closed_{false, false},
       early_pull_pending_(false),
       can_push_to_server_(false),
-      early_pull_result_(ERR_IO_PENDING),
       full_duplex_(false),
-      time_func_(&base::TimeTicks::Now),
-      traffic_annotation_(traffic_annotation) {
+      time_func_(&base::TimeTicks::Now) {
   io_callback_ = base::BindRepeating(&NaiveConnection::OnIOComplete,
                                      weak_ptr_factory_.GetWeakPtr());
+  for (Direction from : {kClient, kServer}) {
+    Direction to = from == kClient ? kServer : kClient;
+    pull_ready_callbacks_[from] =
+        base::BindRepeating(&NaiveConnection::OnPullReady,
+                            weak_ptr_factory_.GetWeakPtr(), from, to);
+    pull_complete_callbacks_[from] =
+        base::BindRepeating(&NaiveConnection::OnPullComplete,
+                            weak_ptr_factory_.GetWeakPtr(), from, to);
+    push_complete_callbacks_[from] =
+        base::BindRepeating(&NaiveConnection::OnPushComplete,
+                            weak_ptr_factory_.GetWeakPtr(), from, to);
+    resume_callbacks_[from] =
+        base::BindRepeating(&NaiveConnection::Resume,
+                            weak_ptr_factory_.GetWeakPtr(), from, to);
+  }
+  start_time_ = time_func_();
+  for (Direction from : {kClient, kServer}) {
+    last_activity_times_[from] = start_time_;
+  }
 }
 
 NaiveConnection::~NaiveConnection() {
   Disconnect();
 }
 
+void NaiveConnection::SetClientSocket(
+    std::unique_ptr<StreamSocket> client_socket) {
+  DCHECK(!client_socket_);
+  client_socket_ = std::move(client_socket);
+}
+
+// static
+void NaiveConnection::ApplyRelaySocketOptions(
+    const RelaySocketOptions& options,
+    TCPClientSocket* socket) {
+  // Relay sockets are read and written until they close.
+  socket->EnableEdgeTriggeredWatches();
+  socket->EnableCompletionPort();
+  // Failures leave the kernel defaults, which only buffer more.
+  if (options.send_buffer_size > 0)
+    socket->SetSendBufferSize(options.send_buffer_size);
+  if (options.not_sent_lowat > 0)
+    socket->SetNotSentLowWatermark(options.not_sent_lowat);
+  if (options.zero_copy)
+    socket->EnableZeroCopy();
+  if (options.busy_poll > 0)
+    socket->SetBusyPoll(options.busy_poll);
+}
+
 int NaiveConnection::Connect(CompletionOnceCallback callback) {
   DCHECK(client_socket_);
   DCHECK_EQ(next_state_, STATE_NONE);
@@ -110,10 +266,18 @@ int NaiveConnection::Connect(CompletionOnceCallback callback) {
 
 void NaiveConnection::Disconnect() {
   full_duplex_ = false;
+#if BUILDFLAG(IS_LINUX)
+  // Stops watching the descriptors before they are closed.
+  splice_relay_ = nullptr;
+#endif
+  udp_association_ = nullptr;
+  cache_fetch_ = nullptr;
   // Closes server side first because latency is higher.
   if (server_socket_handle_->socket())
     server_socket_handle_->socket()->Disconnect();
-  client_socket_->Disconnect();
+  // Null if the listener dropped the connection before handing it one.
+  if (client_socket_)
+    client_socket_->Disconnect();
 
   next_state_ = STATE_NONE;
   connect_callback_.Reset();
@@ -169,32 +333,68 @@ int NaiveConnection::DoLoop(int last_io_result) {
 
 int NaiveConnection::DoConnectClient() {
   next_state_ = STATE_CONNECT_CLIENT_COMPLETE;
+  TRACE_EVENT_NESTABLE_ASYNC_BEGIN0("naive", "NaiveConnection::ConnectClient",
+                                    TRACE_ID_LOCAL(this));
 
   return client_socket_->Connect(io_callback_);
 }
 
 int NaiveConnection::DoConnectClientComplete(int result) {
+  TRACE_EVENT_NESTABLE_ASYNC_END1("naive", "NaiveConnection::ConnectClient",
+                                  TRACE_ID_LOCAL(this), "result", result);
   if (result < 0)
     return result;
+  client_connect_end_time_ = time_func_();
 
   std::optional<PaddingType> client_padding_type =
-      padding_detector_delegate_->GetClientPaddingType();
+      padding_detector_delegate_.GetClientPaddingType();
   CHECK(client_padding_type.has_value());
 
   sockets_[kClient] = std::make_unique<NaivePaddingSocket>(
-      client_socket_.get(), *client_padding_type, kClient);
+      client_socket_.get(), *client_padding_type, kClient,
+      padding_detector_delegate_.GetClientPaddingLimits(), padding_profile_);
 
-  // For proxy client sockets, padding support detection is finished after the
-  // first server response which means there will be one missed early pull. For
-  // proxy server sockets (HttpProxyServerSocket), padding support detection is
-  // done during client connect, so there shouldn't be any missed early pull.
-  if (!padding_detector_delegate_->GetServerPaddingType().has_value()) {
-    early_pull_pending_ = false;
-    early_pull_result_ = 0;
-    next_state_ = STATE_CONNECT_SERVER;
-    return OK;
+  if (protocol_ == ClientProtocol::kSocks5) {
+    auto* socket = static_cast<Socks5ServerSocket*>(client_socket_.get());
+    if (socket->is_udp_associate()) {
+      IPEndPoint peer_endpoint;
+      int rv = socket->GetPeerAddress(&peer_endpoint);
+      if (rv != OK)
+        return rv;
+      LOG_IF(INFO, !access_logged_)
+          << "Connection " << id_ << " UDP associate";
+      udp_association_ = std::make_unique<NaiveUdpAssociation>(
+          id_, socket->TakeUdpSocket(), peer_endpoint.address(),
+          proxy_info_.proxy_chain(), session_,
+          session_keys_[static_cast<size_t>(priority_)], net_log_,
+          traffic_annotation_);
+      // Flows connect on demand, so there is no server side to connect.
+      full_duplex_ = true;
+      return OK;
+    }
   }
 
+  if (protocol_ == ClientProtocol::kHttp) {
+    const auto* socket =
+        static_cast<const HttpProxyServerSocket*>(client_socket_.get());
+    if (socket->is_cache_request()) {
+      DCHECK(http_cache_);
+      origin_ = socket->request_endpoint();
+      LOG_IF(INFO, !access_logged_) << "Connection " << id_ << " to "
+                                    << origin_.ToString() << " via cache";
+      cache_fetch_ = std::make_unique<NaiveHttpCacheFetch>(
+          http_cache_, socket->cache_url(), socket->cache_headers(),
+          client_socket_.get(), traffic_annotation_);
+      // The fetch makes its own connections through the context.
+      full_duplex_ = true;
+      return OK;
+    }
+  }
+
+  // Reads the first payload while the server side connects. It is pushed
+  // after the server socket and its padding type are known, so this does not
+  // wait for padding support detection, which for proxy client sockets may
+  // finish only with the server response.
   early_pull_pending_ = true;
   Pull(kClient, kServer);
   if (early_pull_result_ != ERR_IO_PENDING) {
@@ -220,10 +420,17 @@ int NaiveConnection::DoConnectServer() {
     const auto* socket =
         static_cast<const HttpProxyServerSocket*>(client_socket_.get());
     origin = socket->request_endpoint();
+  } else if (protocol_ == ClientProtocol::kHttps) {
+    const auto* socket =
+        static_cast<const Http2ProxyServerStream*>(client_socket_.get());
+    origin = socket->request_endpoint();
+  } else if (protocol_ == ClientProtocol::kQuic) {
+    const auto* socket =
+        static_cast<const Http3ProxyServerStream*>(client_socket_.get());
+    origin = socket->request_endpoint();
   } else if (protocol_ == ClientProtocol::kRedir) {
 #if BUILDFLAG(IS_LINUX)
-    const auto* socket =
-        static_cast<const TCPClientSocket*>(client_socket_.get());
+    const StreamSocket* socket = client_socket_.get();
     IPEndPoint peer_endpoint;
     int rv;
     rv = socket->GetPeerAddress(&peer_endpoint);
@@ -232,7 +439,11 @@ int NaiveConnection::DoConnectServer() {
                  << " cannot get peer address: " << ErrorToShortString(rv);
       return rv;
     }
-    int sd = socket->SocketDescriptorForTesting();
+    SocketDescriptor sd = socket->GetKernelSocketDescriptor();
+    if (sd == kInvalidSocket) {
+      LOG(ERROR) << "Connection " << id_ << " has no kernel socket";
+      return ERR_ADDRESS_INVALID;
+    }
     SockaddrStorage dst;
     if (peer_endpoint.GetFamily() == ADDRESS_FAMILY_IPV4 ||
         peer_endpoint.address().IsIPv4MappedIPv6()) {
@@ -243,58 +454,140 @@ int NaiveConnection::DoConnectServer() {
     if (rv == 0) {
       IPEndPoint ipe;
       if (ipe.FromSockAddr(dst.addr, dst.addr_len)) {
-        const auto& addr = ipe.address();
-        auto name = resolver_->FindNameByAddress(addr);
-        if (!name.empty()) {
-          origin = HostPortPair(name, ipe.port());
-        } else if (!resolver_->IsInResolvedRange(addr)) {
-          origin = HostPortPair::FromIPEndPoint(ipe);
-        } else {
-          LOG(ERROR) << "Connection " << id_ << " to unresolved name for "
-                     << addr.ToString();
-          return ERR_ADDRESS_INVALID;
-        }
+        rv = FindOriginByAddress(ipe, &origin);
+        if (rv != OK)
+          return rv;
       }
     } else {
       LOG(ERROR) << "Failed to get original destination address";
       return ERR_ADDRESS_INVALID;
     }
-#else
-    static_cast<void>(resolver_);
 #endif
+  } else if (protocol_ == ClientProtocol::kTun ||
+             protocol_ == ClientProtocol::kTproxy) {
+    // The local address of the terminated connection is the destination the
+    // application connected to. TPROXY rules deliver it to the listener
+    // without rewriting it.
+    IPEndPoint local_endpoint;
+    int rv = client_socket_->GetLocalAddress(&local_endpoint);
+    if (rv != OK) {
+      return rv;
+    }
+    if (local_endpoint.address().IsIPv4MappedIPv6()) {
+      local_endpoint =
+          IPEndPoint(ConvertIPv4MappedIPv6ToIPv4(local_endpoint.address()),
+                     local_endpoint.port());
+    }
+    if (resolver_) {
+      rv = FindOriginByAddress(local_endpoint, &origin);
+      if (rv != OK)
+        return rv;
+    } else {
+      origin = HostPortPair::FromIPEndPoint(local_endpoint);
+    }
+  }
+
+  if (resolver_ && protocol_ != ClientProtocol::kRedir &&
+      protocol_ != ClientProtocol::kTun &&
+      protocol_ != ClientProtocol::kTproxy) {
+    // Given only with --resolver-all-listeners, for clients that connect to
+    // the addresses the resolver gave them.
+    IPAddress address;
+    if (address.AssignFromIPLiteral(origin.host())) {
+      int rv = FindOriginByAddress(IPEndPoint(address, origin.port()), &origin);
+      if (rv != OK)
+        return rv;
+    }
   }
 
-  url::CanonHostInfo host_info;
-  url::SchemeHostPort endpoint(
-      "http", CanonicalizeHost(origin.HostForURL(), &host_info), origin.port(),
-      url::SchemeHostPort::ALREADY_CANONICALIZED);
+  std::string host;
+  if (IsCanonicalHost(origin.host())) {
+    host = origin.host();
+  } else {
+    url::CanonHostInfo host_info;
+    host = CanonicalizeHost(origin.HostForURL(), &host_info);
+  }
+  url::SchemeHostPort endpoint(url::kHttpScheme, std::move(host),
+                               origin.port(),
+                               url::SchemeHostPort::ALREADY_CANONICALIZED);
   if (!endpoint.IsValid()) {
     LOG(ERROR) << "Connection " << id_ << " to invalid origin "
                << origin.ToString();
     return ERR_ADDRESS_INVALID;
   }
 
-  LOG(INFO) << "Connection " << id_ << " to " << origin.ToString();
+  origin_ = std::move(origin);
+  LOG_IF(INFO, !access_logged_)
+      << "Connection " << id_ << " to " << origin_.ToString();
+  priority_ = priority_rules_.Find(origin_.port(), priority_);
+
+  server_connect_start_time_ = time_func_();
+  TRACE_EVENT_NESTABLE_ASYNC_BEGIN0("naive", "NaiveConnection::ConnectServer",
+                                    TRACE_ID_LOCAL(this));
+  // Secure DNS only takes effect if --doh-server sets it up. The policy also
+  // applies to proxies, whose DoH queries would go through themselves, so
+  // only direct connections allow it.
+  SecureDnsPolicy secure_dns_policy = proxy_info_.is_direct()
+                                          ? SecureDnsPolicy::kAllow
+                                          : SecureDnsPolicy::kDisable;
+  tunnel_connector_ =
+      std::make_unique<NaiveTunnelConnector>(session_, traffic_annotation_);
+  // Each class has tunnel sessions of its own if the selector split them.
+  return tunnel_connector_->Connect(
+      std::move(endpoint), proxy_info_,
+      session_keys_[static_cast<size_t>(priority_)], secure_dns_policy,
+      net_log_, server_socket_handle_.get(), io_callback_);
+}
 
-  // Ignores socket limit set by socket pool for this type of socket.
-  return InitSocketHandleForHttpRequest(
-      std::move(endpoint), LOAD_IGNORE_LIMITS, MAXIMUM_PRIORITY, session_,
-      proxy_info_, {}, PRIVACY_MODE_DISABLED,
-      network_anonymization_key_, SecureDnsPolicy::kDisable, SocketTag(),
-      net_log_, server_socket_handle_.get(), io_callback_,
-      ClientSocketPool::ProxyAuthCallback());
+int NaiveConnection::FindOriginByAddress(const IPEndPoint& address,
+                                         HostPortPair* origin) {
+  std::string name = resolver_->FindNameByAddress(address.address());
+  if (!name.empty()) {
+    *origin = HostPortPair(name, address.port());
+  } else if (!resolver_->IsInResolvedRange(address.address())) {
+    *origin = HostPortPair::FromIPEndPoint(address);
+  } else {
+    LOG(ERROR) << "Connection " << id_ << " to unresolved name for "
+               << address.address().ToString();
+    return ERR_ADDRESS_INVALID;
+  }
+  return OK;
 }
 
 int NaiveConnection::DoConnectServerComplete(int result) {
+  tunnel_connector_ = nullptr;
+  if (!server_connect_start_time_.is_null()) {
+    TRACE_EVENT_NESTABLE_ASYNC_END1("naive", "NaiveConnection::ConnectServer",
+                                    TRACE_ID_LOCAL(this), "result", result);
+    server_connect_result_ = result;
+    server_connect_time_ = time_func_() - server_connect_start_time_;
+  }
   if (result < 0)
     return result;
 
+  // Direct connections get a plain TCP socket from the transport pool.
+  if (proxy_info_.is_direct()) {
+    ApplyRelaySocketOptions(
+        relay_socket_options_,
+        static_cast<TCPClientSocket*>(server_socket_handle_->socket()));
+  }
+
+  // The socket pool is given MAXIMUM_PRIORITY to ignore its limits, and the
+  // tunnel stream is opened with the default priority whatever it is given.
+  // Only proxy client sockets have a tunnel stream.
+  if (priority_ != TunnelPriority::kDefault && !proxy_info_.is_direct() &&
+      proxy_info_.proxy_chain().Last().is_http_like()) {
+    static_cast<ProxyClientSocket*>(server_socket_handle_->socket())
+        ->SetStreamPriority(ToRequestPriority(priority_));
+  }
+
   std::optional<PaddingType> server_padding_type =
-      padding_detector_delegate_->GetServerPaddingType();
+      padding_detector_delegate_.GetServerPaddingType();
   CHECK(server_padding_type.has_value());
 
   sockets_[kServer] = std::make_unique<NaivePaddingSocket>(
-      server_socket_handle_->socket(), *server_padding_type, kServer);
+      server_socket_handle_->socket(), *server_padding_type, kServer,
+      padding_detector_delegate_.GetServerPaddingLimits(), padding_profile_);
 
   full_duplex_ = true;
   next_state_ = STATE_NONE;
@@ -302,7 +595,7 @@ int NaiveConnection::DoConnectServerComplete(int result) {
 }
 
 int NaiveConnection::Run(CompletionOnceCallback callback) {
-  DCHECK(sockets_[kServer]);
+  DCHECK(sockets_[kServer] || udp_association_ || cache_fetch_);
   DCHECK_EQ(next_state_, STATE_NONE);
   DCHECK(!connect_callback_);
 
@@ -315,19 +608,36 @@ int NaiveConnection::Run(CompletionOnceCallback callback) {
 
   run_callback_ = std::move(callback);
 
-  bytes_passed_without_yielding_[kClient] = 0;
-  bytes_passed_without_yielding_[kServer] = 0;
+  if (udp_association_)
+    return RunUdpAssociation();
+  if (cache_fetch_)
+    return RunCacheFetch();
 
-  yield_after_time_[kClient] =
-      time_func_() + base::Milliseconds(kYieldAfterDurationMilliseconds);
-  yield_after_time_[kServer] = yield_after_time_[kClient];
+  deficits_[kClient] = NaiveScheduler::GetQuantum();
+  deficits_[kServer] = deficits_[kClient];
 
   can_push_to_server_ = true;
-  // early_pull_result_ == 0 means the early pull was not started because
-  // padding support was not yet known.
-  if (!early_pull_pending_ && early_pull_result_ == 0) {
-    Pull(kClient, kServer);
-  } else if (!early_pull_pending_) {
+
+#if BUILDFLAG(IS_LINUX)
+  if (CanUseSpliceRelay()) {
+    splice_relay_ = std::make_unique<NaiveSpliceRelay>(
+        GetRawSocketDescriptor(kClient), GetRawSocketDescriptor(kServer));
+    int rv = splice_relay_->Init();
+    if (rv == OK) {
+      rv = StartSpliceRelay();
+      if (rv != ERR_IO_PENDING) {
+        run_callback_.Reset();
+      }
+      return rv;
+    }
+    // Falls back to relaying through user space.
+    LOG(WARNING) << "Connection " << id_
+                 << " cannot create splice pipes: " << ErrorToShortString(rv);
+    splice_relay_ = nullptr;
+  }
+#endif
+
+  if (!early_pull_pending_) {
     DCHECK_GT(early_pull_result_, 0);
     Push(kClient, kServer, early_pull_result_);
   }
@@ -336,50 +646,386 @@ int NaiveConnection::Run(CompletionOnceCallback callback) {
   return ERR_IO_PENDING;
 }
 
+base::TimeTicks NaiveConnection::GetLastActivityTime() {
+  if (udp_association_ || cache_fetch_) {
+    base::TimeTicks last_activity_time = std::max(
+        last_activity_times_[kClient], last_activity_times_[kServer]);
+    return std::max(last_activity_time,
+                    udp_association_ ? udp_association_->last_activity_time()
+                                     : cache_fetch_->last_activity_time());
+  }
+  return std::max(GetLastActivityTime(kClient), GetLastActivityTime(kServer));
+}
+
+base::TimeTicks NaiveConnection::GetLastActivityTime(Direction from) {
+  // UDP associations and cache fetches only track both directions at once.
+  if (udp_association_ || cache_fetch_)
+    return GetLastActivityTime();
+#if BUILDFLAG(IS_LINUX)
+  // The splice relay does not report progress, so polls its byte counters.
+  if (splice_relay_) {
+    int64_t bytes = splice_relay_->bytes_relayed(from);
+    if (bytes != splice_bytes_seen_[from]) {
+      splice_bytes_seen_[from] = bytes;
+      last_activity_times_[from] = time_func_();
+    }
+  }
+#endif
+  return last_activity_times_[from];
+}
+
+// static
+const NaiveConnection::RelayStats&
+NaiveConnection::GetRelayStatsForCurrentThread() {
+  return current_relay_stats;
+}
+
+int64_t NaiveConnection::GetRelayedBytes(Direction from) const {
+#if BUILDFLAG(IS_LINUX)
+  if (splice_relay_)
+    return relayed_bytes_[from] + splice_relay_->bytes_relayed(from);
+#endif
+  if (cache_fetch_ && from == kServer)
+    return relayed_bytes_[from] + cache_fetch_->bytes_written();
+  return relayed_bytes_[from];
+}
+
+base::TimeTicks NaiveConnection::GetFirstRelayTime(Direction from) const {
+#if BUILDFLAG(IS_LINUX)
+  if (splice_relay_ && first_relay_times_[from].is_null())
+    return splice_relay_->first_relay_time(from);
+#endif
+  return first_relay_times_[from];
+}
+
+void NaiveConnection::AddRateLimiter(
+    scoped_refptr<NaiveRateLimiter> rate_limiter) {
+  DCHECK(!run_callback_);
+  for (auto& entry : rate_limiters_) {
+    if (!entry) {
+      entry = std::move(rate_limiter);
+      return;
+    }
+  }
+  NOTREACHED();
+}
+
+const std::string& NaiveConnection::user() const {
+  if (client_socket_) {
+    if (protocol_ == ClientProtocol::kSocks5) {
+      return static_cast<const Socks5ServerSocket*>(client_socket_.get())
+          ->user();
+    }
+    if (protocol_ == ClientProtocol::kHttp) {
+      return static_cast<const HttpProxyServerSocket*>(client_socket_.get())
+          ->user();
+    }
+    if (protocol_ == ClientProtocol::kHttps) {
+      return static_cast<const Http2ProxyServerStream*>(client_socket_.get())
+          ->user();
+    }
+    if (protocol_ == ClientProtocol::kQuic) {
+      return static_cast<const Http3ProxyServerStream*>(client_socket_.get())
+          ->user();
+    }
+  }
+  return base::EmptyString();
+}
+
+bool NaiveConnection::GetServerSessionQuality(
+    StreamSocket::SessionQuality* quality) const {
+  if (!server_socket_handle_ || !server_socket_handle_->socket())
+    return false;
+  return server_socket_handle_->socket()->GetSessionQuality(quality);
+}
+
+int NaiveConnection::GetServerPeerAddress(IPEndPoint* address) const {
+  if (!server_socket_handle_ || !server_socket_handle_->socket())
+    return ERR_SOCKET_NOT_CONNECTED;
+  return server_socket_handle_->socket()->GetPeerAddress(address);
+}
+
+int NaiveConnection::SetServerDiffServCodePoint(DiffServCodePoint dscp) {
+  if (!server_socket_handle_ || !server_socket_handle_->socket())
+    return ERR_SOCKET_NOT_CONNECTED;
+  return server_socket_handle_->socket()->SetDiffServCodePoint(dscp);
+}
+
+NaiveConnection::MemoryUsage& NaiveConnection::MemoryUsage::operator+=(
+    const MemoryUsage& other) {
+  object += other.object;
+  padding += other.padding;
+  buffers += other.buffers;
+  stream += other.stream;
+  helpers += other.helpers;
+  return *this;
+}
+
+NaiveConnection::MemoryUsage NaiveConnection::GetMemoryUsage() const {
+  MemoryUsage usage;
+  usage.object = sizeof(*this);
+  for (Direction side : {kClient, kServer}) {
+    if (sockets_[side]) {
+      usage.padding += sockets_[side]->EstimateMemoryUsage();
+    }
+    // A read buffer is a view of the frame buffer around it, and lent bytes
+    // belong to the socket that lent them.
+    if (frame_buffers_[side]) {
+      usage.buffers += frame_buffers_[side]->size();
+    } else if (read_buffers_[side] && !lent_buffers_[side]) {
+      usage.buffers += read_buffers_[side]->size();
+    }
+    if (write_buffers_[side]) {
+      usage.buffers += write_buffers_[side]->size();
+    }
+  }
+  if (server_socket_handle_) {
+    usage.helpers += sizeof(ClientSocketHandle);
+    if (server_socket_handle_->socket()) {
+      usage.stream += server_socket_handle_->socket()->EstimateMemoryUsage();
+    }
+  }
+  if (tunnel_connector_) {
+    usage.helpers += sizeof(NaiveTunnelConnector);
+  }
+  if (udp_association_) {
+    usage.helpers += sizeof(NaiveUdpAssociation);
+  }
+  if (cache_fetch_) {
+    usage.helpers += sizeof(NaiveHttpCacheFetch);
+  }
+#if BUILDFLAG(IS_LINUX)
+  if (splice_relay_) {
+    usage.helpers += sizeof(NaiveSpliceRelay);
+  }
+#endif
+  return usage;
+}
+
+bool NaiveConnection::IsHalfOpen() const {
+  if (udp_association_ || cache_fetch_)
+    return false;
+  return IsConnected(kClient) != IsConnected(kServer) ||
+         read_closed_[kClient] != read_closed_[kServer];
+}
+
 void NaiveConnection::Pull(Direction from, Direction to) {
-  if (errors_[kClient] < 0 || errors_[kServer] < 0)
+  TRACE_EVENT("naive", "NaiveConnection::Pull", "id", id_, "from",
+              static_cast<int>(from));
+  pull_start_time_[from] = time_func_();
+  last_activity_times_[from] = pull_start_time_[from];
+  BypassUnframedSockets(from, to);
+  ReadForPull(from, to);
+}
+
+void NaiveConnection::BypassUnframedSockets(Direction from, Direction to) {
+  // Reads from `from` and writes to `to` are made by this direction only,
+  // and none is in progress between pulls.
+  if (!read_transports_[from] && sockets_[from])
+    read_transports_[from] = sockets_[from]->GetUnframedReadSocket();
+  if (!write_transports_[to] && sockets_[to] && !write_pending_[to])
+    write_transports_[to] = sockets_[to]->GetUnframedWriteSocket();
+}
+
+void NaiveConnection::Resume(Direction from, Direction to) {
+  deficits_[from] += NaiveScheduler::GetQuantum();
+  // Writes larger than the quantum may take more than one round to pay off.
+  if (deficits_[from] <= 0) {
+    current_relay_stats.yields++;
+    NaiveScheduler::Yield(resume_callbacks_[from]);
     return;
+  }
+  Pull(from, to);
+}
 
-  int read_size = kBufferSize;
-  read_buffers_[from] = base::MakeRefCounted<IOBufferWithSize>(kBufferSize);
+void NaiveConnection::ReadForPull(Direction from, Direction to) {
+  if (errors_[kClient] < 0 || errors_[kServer] < 0 || read_closed_[from])
+    return;
 
   DCHECK(sockets_[from]);
-  int rv = sockets_[from]->Read(
-      read_buffers_[from].get(), read_size,
-      base::BindRepeating(&NaiveConnection::OnPullComplete,
-                          weak_ptr_factory_.GetWeakPtr(), from, to));
+  frame_buffers_[from] = nullptr;
+  bool write_padded =
+      !write_transports_[to] && sockets_[to] && sockets_[to]->IsWritePadded();
+  StreamSocket* read_transport = read_transports_[from];
+
+  int rv = ERR_NOT_IMPLEMENTED;
+#if !BUILDFLAG(IS_WIN)
+  // Writes body straight from the receive buffers of QUIC proxy streams,
+  // saving a copy into a relay buffer. Overlapped writes on Windows keep the
+  // address of the buffer instead of reading through data(), so the copy is
+  // kept there. Zero-copy sends keep reading the buffer after the write, so
+  // they get relay buffers, which they keep from being reused.
+  if (!write_padded && !relay_socket_options_.zero_copy &&
+      (from == kServer || can_push_to_server_)) {
+    base::span<const char> data;
+    if (read_transport) {
+      rv = read_transport->LendReadBuffer(NaiveBufferPool::kBufferSize, &data,
+                                          pull_ready_callbacks_[from]);
+    } else {
+      rv = sockets_[from]->LendReadBuffer(NaiveBufferPool::kBufferSize, &data,
+                                          pull_ready_callbacks_[from]);
+    }
+    if (rv == ERR_IO_PENDING) {
+      read_if_ready_pending_[from] = true;
+    } else if (rv > 0) {
+      lent_buffers_[from] = base::MakeRefCounted<LentIOBuffer>(data);
+      read_buffers_[from] = lent_buffers_[from];
+    }
+  }
+#endif
+
+  // Writes the buffers that H2 proxy streams received DATA into, saving a
+  // copy into a relay buffer. Padding frames are built in relay buffers.
+  if (!write_padded && rv == ERR_NOT_IMPLEMENTED) {
+    if (read_transport) {
+      rv = read_transport->ReadBuffer(NaiveBufferPool::kBufferSize,
+                                      &read_buffers_[from],
+                                      pull_ready_callbacks_[from]);
+    } else {
+      rv = sockets_[from]->ReadBuffer(NaiveBufferPool::kBufferSize,
+                                      &read_buffers_[from],
+                                      pull_ready_callbacks_[from]);
+    }
+    if (rv == ERR_IO_PENDING)
+      read_if_ready_pending_[from] = true;
+  }
+
+  if (rv == ERR_NOT_IMPLEMENTED) {
+    int read_size = read_sizes_[from];
+    read_buffers_[from] = NaiveBufferPool::Acquire(read_size);
+    if (write_padded) {
+      // Reads the payload behind room for the padding frame header, so the
+      // frame is built around it without copying.
+      frame_buffers_[from] = std::move(read_buffers_[from]);
+      read_size -= kFrameRoom;
+      auto payload = base::MakeRefCounted<DrainableIOBuffer>(
+          frame_buffers_[from], NaivePaddingSocket::kWriteHeadroom + read_size);
+      payload->DidConsume(NaivePaddingSocket::kWriteHeadroom);
+      read_buffers_[from] = std::move(payload);
+    }
+
+    // Waits for readability without holding the buffer if the socket
+    // supports it, so idle tunnels hold no relay buffers.
+    if (read_transport) {
+      rv = read_transport->ReadIfReady(read_buffers_[from].get(), read_size,
+                                       pull_ready_callbacks_[from]);
+    } else {
+      rv = sockets_[from]->ReadIfReady(read_buffers_[from].get(), read_size,
+                                       pull_ready_callbacks_[from]);
+    }
+    if (rv == ERR_IO_PENDING) {
+      read_buffers_[from] = nullptr;
+      frame_buffers_[from] = nullptr;
+      read_if_ready_pending_[from] = true;
+    } else if (rv == ERR_READ_IF_READY_NOT_IMPLEMENTED) {
+      if (read_transport) {
+        rv = read_transport->Read(read_buffers_[from].get(), read_size,
+                                  pull_complete_callbacks_[from]);
+      } else {
+        rv = sockets_[from]->Read(read_buffers_[from].get(), read_size,
+                                  pull_complete_callbacks_[from]);
+      }
+    }
+  }
 
   if (from == kClient && early_pull_pending_)
     early_pull_result_ = rv;
 
-  if (rv != ERR_IO_PENDING)
-    OnPullComplete(from, to, rv);
+  if (rv == ERR_IO_PENDING) {
+    current_relay_stats.pulls_waited++;
+    return;
+  }
+  OnPullComplete(from, to, rv);
+}
+
+void NaiveConnection::OnPullReady(Direction from, Direction to, int result) {
+  read_if_ready_pending_[from] = false;
+  if (result < 0) {
+    OnPullComplete(from, to, result);
+    return;
+  }
+  ReadForPull(from, to);
 }
 
 void NaiveConnection::Push(Direction from, Direction to, int size) {
+  TRACE_EVENT("naive", "NaiveConnection::Push", "id", id_, "from",
+              static_cast<int>(from), "size", size);
+  current_relay_stats.chunks++;
+  if (lent_buffers_[from]) {
+    PushLent(from, to, size);
+    return;
+  }
+
   write_buffers_[to] = base::MakeRefCounted<DrainableIOBuffer>(
       std::move(read_buffers_[from]), size);
   write_pending_[to] = true;
   DCHECK(sockets_[to]);
-  int rv = sockets_[to]->Write(
-      write_buffers_[to].get(), write_buffers_[to]->BytesRemaining(),
-      base::BindRepeating(&NaiveConnection::OnPushComplete,
-                          weak_ptr_factory_.GetWeakPtr(), from, to),
-      traffic_annotation_);
+  int rv;
+  if (frame_buffers_[from]) {
+    rv = sockets_[to]->WriteInPlace(std::move(frame_buffers_[from]), size,
+                                    push_complete_callbacks_[from],
+                                    traffic_annotation_);
+  } else if (write_transports_[to]) {
+    rv = write_transports_[to]->Write(
+        write_buffers_[to].get(), write_buffers_[to]->BytesRemaining(),
+        push_complete_callbacks_[from], traffic_annotation_);
+  } else {
+    rv = sockets_[to]->Write(
+        write_buffers_[to].get(), write_buffers_[to]->BytesRemaining(),
+        push_complete_callbacks_[from], traffic_annotation_);
+  }
+
+  if (rv == ERR_IO_PENDING) {
+    current_relay_stats.pushes_waited++;
+    return;
+  }
+  OnPushComplete(from, to, rv);
+}
+
+void NaiveConnection::PushLent(Direction from, Direction to, int size) {
+  scoped_refptr<LentIOBuffer> buffer = std::move(lent_buffers_[from]);
+  read_buffers_[from] = nullptr;
+  DCHECK(sockets_[to]);
+  int rv;
+  if (write_transports_[to]) {
+    rv = write_transports_[to]->Write(buffer.get(), size,
+                                      push_complete_callbacks_[from],
+                                      traffic_annotation_);
+  } else {
+    rv = sockets_[to]->Write(buffer.get(), size,
+                             push_complete_callbacks_[from],
+                             traffic_annotation_);
+  }
+
+  if (rv == ERR_IO_PENDING) {
+    current_relay_stats.pushes_waited++;
+    // The write outlives the lending.
+    buffer->Detach();
+    sockets_[from]->ConsumeLentBuffer(size);
+    write_buffers_[to] =
+        base::MakeRefCounted<DrainableIOBuffer>(std::move(buffer), size);
+    write_pending_[to] = true;
+    return;
+  }
 
-  if (rv != ERR_IO_PENDING)
-    OnPushComplete(from, to, rv);
+  // Bytes not written stay with the socket for the next pull.
+  sockets_[from]->ConsumeLentBuffer(std::max(rv, 0));
+  if (rv > 0)
+    OnRelayed(from, rv);
+  OnPushComplete(from, to, rv);
 }
 
 void NaiveConnection::Disconnect(Direction side) {
   if (sockets_[side]) {
+    read_transports_[side] = nullptr;
+    write_transports_[side] = nullptr;
     sockets_[side]->Disconnect();
     sockets_[side] = nullptr;
     write_pending_[side] = false;
   }
 }
 
-bool NaiveConnection::IsConnected(Direction side) {
+bool NaiveConnection::IsConnected(Direction side) const {
   return sockets_[side] != nullptr;
 }
 
@@ -397,6 +1043,14 @@ void NaiveConnection::OnBothDisconnected() {
 void NaiveConnection::OnPullError(Direction from, Direction to, int error) {
   DCHECK_LT(error, 0);
 
+  // On EOF keeps relaying the other direction, as TCP half-close does.
+  if (error == ERR_CONNECTION_CLOSED && IsConnected(from) && IsConnected(to)) {
+    read_closed_[from] = true;
+    if (!write_pending_[to])
+      ShutdownWrite(from, to);
+    return;
+  }
+
   errors_[from] = error;
   Disconnect(from);
 
@@ -407,6 +1061,40 @@ void NaiveConnection::OnPullError(Direction from, Direction to, int error) {
     OnBothDisconnected();
 }
 
+void NaiveConnection::ShutdownWrite(Direction from, Direction to) {
+  DCHECK(read_closed_[from]);
+  DCHECK(!write_pending_[to]);
+
+  // Sends writes the padding socket completed early before the shutdown.
+  int rv = sockets_[to]->Flush(base::BindOnce(
+      &NaiveConnection::OnFlushComplete, weak_ptr_factory_.GetWeakPtr(), from,
+      to));
+  if (rv == ERR_IO_PENDING) {
+    write_pending_[to] = true;
+    return;
+  }
+  if (rv < 0) {
+    OnPushError(from, to, rv);
+    return;
+  }
+
+  if (sockets_[to]->ShutdownWrite() != OK) {
+    // Closes both sides as before if the other side cannot half-close.
+    errors_[from] = ERR_CONNECTION_CLOSED;
+    Disconnect(kServer);
+    Disconnect(kClient);
+    OnBothDisconnected();
+    return;
+  }
+  write_closed_[to] = true;
+
+  if (write_closed_[from]) {
+    Disconnect(kServer);
+    Disconnect(kClient);
+    OnBothDisconnected();
+  }
+}
+
 void NaiveConnection::OnPushError(Direction from, Direction to, int error) {
   DCHECK_LE(error, 0);
   DCHECK(!write_pending_[to]);
@@ -416,14 +1104,33 @@ void NaiveConnection::OnPushError(Direction from, Direction to, int error) {
     Disconnect(kServer);
     Disconnect(kClient);
   } else if (!IsConnected(from)) {
+    int rv = sockets_[to]->Flush(base::BindOnce(
+        &NaiveConnection::OnFlushComplete, weak_ptr_factory_.GetWeakPtr(),
+        from, to));
+    if (rv == ERR_IO_PENDING) {
+      write_pending_[to] = true;
+      return;
+    }
     Disconnect(to);
+  } else if (read_closed_[from]) {
+    ShutdownWrite(from, to);
+    return;
   }
 
   if (!IsConnected(from) && !IsConnected(to))
     OnBothDisconnected();
 }
 
+void NaiveConnection::OnFlushComplete(Direction from,
+                                      Direction to,
+                                      int result) {
+  write_pending_[to] = false;
+  OnPushError(from, to, result);
+}
+
 void NaiveConnection::OnPullComplete(Direction from, Direction to, int result) {
+  TRACE_EVENT("naive", "NaiveConnection::OnPullComplete", "id", id_, "from",
+              static_cast<int>(from), "result", result);
   if (from == kClient && early_pull_pending_) {
     early_pull_pending_ = false;
     early_pull_result_ = result ? result : ERR_CONNECTION_CLOSED;
@@ -434,6 +1141,16 @@ void NaiveConnection::OnPullComplete(Direction from, Direction to, int result) {
     return;
   }
 
+  // Grows the buffer while reads fill it, up to the pool's maximum size.
+  int read_size = read_sizes_[from] - (frame_buffers_[from] ? kFrameRoom : 0);
+  if (result >= read_size) {
+    read_sizes_[from] = std::min(read_sizes_[from] * 2,
+                                 NaiveBufferPool::GetMaxRelayBufferSize());
+  } else if (time_func_() - pull_start_time_[from] >
+             base::Seconds(kBufferShrinkIdleSeconds)) {
+    read_sizes_[from] = NaiveBufferPool::kMinBufferSize;
+  }
+
   if (from == kClient && !can_push_to_server_)
     return;
 
@@ -441,38 +1158,226 @@ void NaiveConnection::OnPullComplete(Direction from, Direction to, int result) {
 }
 
 void NaiveConnection::OnPushComplete(Direction from, Direction to, int result) {
+  TRACE_EVENT("naive", "NaiveConnection::OnPushComplete", "id", id_, "from",
+              static_cast<int>(from), "result", result);
   if (result >= 0 && write_buffers_[to] != nullptr) {
-    bytes_passed_without_yielding_[from] += result;
+    OnRelayed(from, result);
     write_buffers_[to]->DidConsume(result);
     int size = write_buffers_[to]->BytesRemaining();
     if (size > 0) {
-      int rv = sockets_[to]->Write(
-          write_buffers_[to].get(), size,
-          base::BindRepeating(&NaiveConnection::OnPushComplete,
-                              weak_ptr_factory_.GetWeakPtr(), from, to),
-          traffic_annotation_);
-      if (rv != ERR_IO_PENDING)
-        OnPushComplete(from, to, rv);
+      int rv;
+      if (write_transports_[to]) {
+        rv = write_transports_[to]->Write(write_buffers_[to].get(), size,
+                                          push_complete_callbacks_[from],
+                                          traffic_annotation_);
+      } else {
+        rv = sockets_[to]->Write(write_buffers_[to].get(), size,
+                                 push_complete_callbacks_[from],
+                                 traffic_annotation_);
+      }
+      if (rv == ERR_IO_PENDING) {
+        current_relay_stats.pushes_waited++;
+        return;
+      }
+      OnPushComplete(from, to, rv);
       return;
     }
   }
 
+  // Returns the relay buffer to the pool as soon as it is drained.
+  write_buffers_[to] = nullptr;
   write_pending_[to] = false;
   // Checks for termination even if result is OK.
   OnPushError(from, to, result >= 0 ? OK : result);
 
-  if (bytes_passed_without_yielding_[from] > kYieldAfterBytesRead ||
-      time_func_() > yield_after_time_[from]) {
-    bytes_passed_without_yielding_[from] = 0;
-    yield_after_time_[from] =
-        time_func_() + base::Milliseconds(kYieldAfterDurationMilliseconds);
-    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
-        FROM_HERE,
-        base::BindRepeating(&NaiveConnection::Pull,
-                            weak_ptr_factory_.GetWeakPtr(), from, to));
+  PullNext(from, to);
+}
+
+void NaiveConnection::OnRelayed(Direction from, int bytes) {
+  deficits_[from] -= bytes;
+  relayed_bytes_[from] += bytes;
+  if (first_relay_times_[from].is_null())
+    first_relay_times_[from] = time_func_();
+  if (!rate_limiters_[0])
+    return;
+  base::TimeTicks now = time_func_();
+  for (const auto& rate_limiter : rate_limiters_) {
+    if (!rate_limiter)
+      break;
+    rate_limiter->Consume(from, bytes, now);
+  }
+}
+
+void NaiveConnection::PullNext(Direction from, Direction to) {
+  if (rate_limiters_[0]) {
+    base::TimeTicks now = time_func_();
+    base::TimeDelta delay;
+    for (const auto& rate_limiter : rate_limiters_) {
+      if (!rate_limiter)
+        break;
+      delay = std::max(delay, rate_limiter->GetDelay(from, now));
+    }
+    // Reads nothing until then, so the sender is held back by flow control
+    // instead of the bytes piling up here.
+    if (delay.is_positive()) {
+      current_relay_stats.throttles++;
+      // Resume() starts the next round from one quantum.
+      deficits_[from] = std::min(deficits_[from], 0);
+      base::SingleThreadTaskRunner::GetCurrentDefault()->PostDelayedTask(
+          FROM_HERE, resume_callbacks_[from], delay);
+      return;
+    }
+  }
+  if (deficits_[from] <= 0) {
+    current_relay_stats.yields++;
+    NaiveScheduler::Yield(resume_callbacks_[from]);
   } else {
     Pull(from, to);
   }
 }
 
+int NaiveConnection::RunUdpAssociation() {
+  int rv = udp_association_->Run(
+      base::BindOnce(&NaiveConnection::OnUdpAssociationComplete,
+                     weak_ptr_factory_.GetWeakPtr()));
+  DCHECK_EQ(rv, ERR_IO_PENDING);
+  ReadUdpControl();
+  return ERR_IO_PENDING;
+}
+
+void NaiveConnection::ReadUdpControl() {
+  // Anything the client sends on the control connection is discarded.
+  for (;;) {
+    read_buffers_[kClient] =
+        NaiveBufferPool::Acquire(NaiveBufferPool::kMinBufferSize);
+    int rv = sockets_[kClient]->Read(
+        read_buffers_[kClient].get(), NaiveBufferPool::kMinBufferSize,
+        base::BindOnce(&NaiveConnection::OnUdpControlRead,
+                       weak_ptr_factory_.GetWeakPtr()));
+    if (rv == ERR_IO_PENDING)
+      return;
+    read_buffers_[kClient] = nullptr;
+    if (rv <= 0) {
+      OnUdpAssociationComplete(rv ? rv : ERR_CONNECTION_CLOSED);
+      return;
+    }
+  }
+}
+
+void NaiveConnection::OnUdpControlRead(int result) {
+  read_buffers_[kClient] = nullptr;
+  if (result <= 0) {
+    OnUdpAssociationComplete(result ? result : ERR_CONNECTION_CLOSED);
+    return;
+  }
+  ReadUdpControl();
+}
+
+void NaiveConnection::OnUdpAssociationComplete(int result) {
+  errors_[kClient] = result;
+  udp_association_ = nullptr;
+  Disconnect(kClient);
+  OnBothDisconnected();
+}
+
+int NaiveConnection::RunCacheFetch() {
+  int rv = cache_fetch_->Run(
+      base::BindOnce(&NaiveConnection::OnCacheFetchComplete,
+                     weak_ptr_factory_.GetWeakPtr()));
+  DCHECK_EQ(rv, ERR_IO_PENDING);
+  return ERR_IO_PENDING;
+}
+
+void NaiveConnection::OnCacheFetchComplete(int result) {
+  relayed_bytes_[kServer] += cache_fetch_->bytes_written();
+  errors_[kClient] = result;
+  cache_fetch_ = nullptr;
+  Disconnect(kClient);
+  OnBothDisconnected();
+}
+
+#if BUILDFLAG(IS_LINUX)
+int NaiveConnection::GetRawSocketDescriptor(Direction side) const {
+  const StreamSocket* socket = nullptr;
+  if (side == kServer) {
+    // Direct connections to http origins are plain TCP client sockets.
+    if (!proxy_info_.is_direct())
+      return kInvalidSocket;
+    socket = server_socket_handle_->socket();
+  } else if (protocol_ == ClientProtocol::kSocks5) {
+    const auto* socks_socket =
+        static_cast<const Socks5ServerSocket*>(client_socket_.get());
+    if (socks_socket->has_buffered_data())
+      return kInvalidSocket;
+    socket = socks_socket->transport_socket();
+  } else if (protocol_ == ClientProtocol::kHttp) {
+    const auto* http_socket =
+        static_cast<const HttpProxyServerSocket*>(client_socket_.get());
+    if (http_socket->has_buffered_data() || http_socket->is_forwarding())
+      return kInvalidSocket;
+    socket = http_socket->transport_socket();
+  } else if (protocol_ == ClientProtocol::kRedir ||
+             protocol_ == ClientProtocol::kTproxy) {
+    socket = client_socket_.get();
+  }
+  // Tunnels of https and quic listeners are streams of a shared
+  // connection.
+  if (socket == nullptr)
+    return kInvalidSocket;
+  // Only plain TCP sockets have one; sockets that frame the bytes have none.
+  return socket->GetKernelSocketDescriptor();
+}
+
+bool NaiveConnection::CanUseSpliceRelay() const {
+  // Rate limits are enforced between the reads of the relay loop.
+  if (rate_limiters_[0])
+    return false;
+  // Padding and compression need the payload in user space.
+  if (padding_detector_delegate_.GetClientPaddingType() !=
+          PaddingType::kNone ||
+      padding_detector_delegate_.GetServerPaddingType() !=
+          PaddingType::kNone ||
+      padding_detector_delegate_.GetClientPaddingLimits().compression !=
+          Compression::kNone ||
+      padding_detector_delegate_.GetServerPaddingLimits().compression !=
+          Compression::kNone) {
+    return false;
+  }
+  // A pending early pull can only be taken back if it is waiting for
+  // readability without a buffer.
+  if (early_pull_pending_ && !read_if_ready_pending_[kClient])
+    return false;
+  return GetRawSocketDescriptor(kClient) != kInvalidSocket &&
+         GetRawSocketDescriptor(kServer) != kInvalidSocket;
+}
+
+int NaiveConnection::StartSpliceRelay() {
+  DCHECK(splice_relay_);
+
+  scoped_refptr<DrainableIOBuffer> early_data;
+  if (early_pull_pending_) {
+    sockets_[kClient]->CancelReadIfReady();
+    read_if_ready_pending_[kClient] = false;
+    early_pull_pending_ = false;
+  } else if (early_pull_result_ > 0) {
+    early_data = base::MakeRefCounted<DrainableIOBuffer>(
+        std::move(read_buffers_[kClient]), early_pull_result_);
+  }
+
+  VLOG(1) << "Connection " << id_ << " relaying with splice";
+  return splice_relay_->Run(
+      std::move(early_data),
+      base::BindOnce(&NaiveConnection::OnSpliceRelayComplete,
+                     weak_ptr_factory_.GetWeakPtr()));
+}
+
+void NaiveConnection::OnSpliceRelayComplete(int result) {
+  if (result < 0)
+    errors_[kClient] = result;
+  Disconnect(kServer);
+  Disconnect(kClient);
+  OnBothDisconnected();
+}
+#endif  // BUILDFLAG(IS_LINUX)
+
 }  // namespace net
@@ -6,17 +6,28 @@
 #ifndef NET_TOOLS_NAIVE_NAIVE_CONNECTION_H_
 #define NET_TOOLS_NAIVE_NAIVE_CONNECTION_H_
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 
+#include "base/functional/callback.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/time/time.h"
+#include "build/build_config.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/completion_repeating_callback.h"
+#include "net/base/host_port_pair.h"
+#include "net/socket/stream_socket.h"
+#include "net/tools/naive/naive_padding_profile.h"
 #include "net/tools/naive/naive_padding_socket.h"
+#include "net/tools/naive/naive_priority_rules.h"
 #include "net/tools/naive/naive_protocol.h"
 #include "net/tools/naive/naive_proxy_delegate.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+#include "net/tools/naive/naive_rate_limiter.h"
 
 namespace net {
 
@@ -24,39 +35,166 @@ class ClientSocketHandle;
 class DrainableIOBuffer;
 class HttpNetworkSession;
 class IOBuffer;
+class IPEndPoint;
 class NetLogWithSource;
 class ProxyInfo;
 class StreamSocket;
+class TCPClientSocket;
 struct NetworkTrafficAnnotationTag;
 struct SSLConfig;
 class RedirectResolver;
-class NetworkAnonymizationKey;
+#if BUILDFLAG(IS_LINUX)
+class NaiveSpliceRelay;
+#endif
+
+class NaiveHttpCache;
+class NaiveHttpCacheFetch;
+class NaiveTunnelConnector;
+class NaiveUdpAssociation;
 
 class NaiveConnection {
  public:
   using TimeFunc = base::TimeTicks (*)();
 
-  NaiveConnection(
-      unsigned int id,
-      ClientProtocol protocol,
-      std::unique_ptr<PaddingDetectorDelegate> padding_detector_delegate,
-      const ProxyInfo& proxy_info,
-      RedirectResolver* resolver,
-      HttpNetworkSession* session,
-      const NetworkAnonymizationKey& network_anonymization_key,
-      const NetLogWithSource& net_log,
-      std::unique_ptr<StreamSocket> accepted_socket,
-      const NetworkTrafficAnnotationTag& traffic_annotation);
+  // `session_keys`, `padding_profile` and `priority_rules` must outlive the
+  // connection.
+  NaiveConnection(uint64_t id,
+                  ClientProtocol protocol,
+                  NaiveProxyDelegate* naive_proxy_delegate,
+                  const ProxyInfo& proxy_info,
+                  RedirectResolver* resolver,
+                  HttpNetworkSession* session,
+                  NaiveHttpCache* http_cache,
+                  const NaiveProxySelector::ClassKeys& session_keys,
+                  const NetLogWithSource& net_log,
+                  const NaivePaddingProfile& padding_profile,
+                  TunnelPriority listen_priority,
+                  const NaivePriorityRules& priority_rules,
+                  const RelaySocketOptions& relay_socket_options,
+                  const NetworkTrafficAnnotationTag& traffic_annotation);
   ~NaiveConnection();
+
+  static void ApplyRelaySocketOptions(const RelaySocketOptions& options,
+                                      TCPClientSocket* socket);
   NaiveConnection(const NaiveConnection&) = delete;
   NaiveConnection& operator=(const NaiveConnection&) = delete;
 
-  unsigned int id() const { return id_; }
+  uint64_t id() const { return id_; }
+
+  // Learns the padding type of the client, for the client socket to report
+  // it to.
+  PaddingDetectorDelegate* padding_detector_delegate() {
+    return &padding_detector_delegate_;
+  }
+  // Takes the socket accepted from the client. Must be called once before
+  // Connect().
+  void SetClientSocket(std::unique_ptr<StreamSocket> client_socket);
+
   int Connect(CompletionOnceCallback callback);
   void Disconnect();
   int Run(CompletionOnceCallback callback);
 
+  // Returns the last time bytes were relayed in either direction, or the
+  // creation time before that.
+  base::TimeTicks GetLastActivityTime();
+  // Same, for the bytes read from `from` only.
+  base::TimeTicks GetLastActivityTime(Direction from);
+
+  // Returns the bytes read from `from` and written to the other side.
+  int64_t GetRelayedBytes(Direction from) const;
+
+  // Returns the user the client authenticated as, or empty. Read from the
+  // client socket rather than kept here.
+  const std::string& user() const;
+  // The class of the tunnel, final once the server side connects.
+  TunnelPriority priority() const { return priority_; }
+
+  // The relay counts the bytes it relays on each limiter added before it
+  // runs, and waits out the longest delay of them before reading more. At
+  // most kMaxRateLimiters.
+  static constexpr size_t kMaxRateLimiters = 3;
+  void AddRateLimiter(scoped_refptr<NaiveRateLimiter> rate_limiter);
+
+  // Counters of the relays on the current thread, outside the splice relay.
+  struct RelayStats {
+    // Payloads pulled from one side and pushed to the other.
+    uint64_t chunks = 0;
+    // Pulls and pushes that did not complete synchronously.
+    uint64_t pulls_waited = 0;
+    uint64_t pushes_waited = 0;
+    // Times a direction spent its deficit and yielded to the scheduler.
+    uint64_t yields = 0;
+    // Times a direction waited for a rate limiter.
+    uint64_t throttles = 0;
+  };
+
+  static const RelayStats& GetRelayStatsForCurrentThread();
+
+  // Returns true if one side of a running tunnel has closed and the other is
+  // still connected.
+  bool IsHalfOpen() const;
+
+  // Returns the result of connecting the server side, or ERR_IO_PENDING if
+  // it has not finished.
+  int server_connect_result() const { return server_connect_result_; }
+  base::TimeDelta server_connect_time() const { return server_connect_time_; }
+
+  // Empty until the client asks for a destination, and for UDP associations.
+  const HostPortPair& origin() const { return origin_; }
+  base::TimeTicks start_time() const { return start_time_; }
+  // The steps of setting up the tunnel, null until they happen.
+  base::TimeTicks client_connect_end_time() const {
+    return client_connect_end_time_;
+  }
+  base::TimeTicks server_connect_start_time() const {
+    return server_connect_start_time_;
+  }
+  // When the first bytes read from `from` were written to the other side.
+  base::TimeTicks GetFirstRelayTime(Direction from) const;
+
+  // Leaves the destination out of the INFO log, as the access log records
+  // it instead.
+  void set_access_logged(bool access_logged) {
+    access_logged_ = access_logged;
+  }
+
+  // Copies the estimates of the proxy session carrying the server side.
+  // Returns false if the server side is not carried over one.
+  bool GetServerSessionQuality(StreamSocket::SessionQuality* quality) const;
+  // The address of the proxy, or of the destination of a direct tunnel.
+  int GetServerPeerAddress(IPEndPoint* address) const;
+  // Marks the packets carrying the server side with `dscp`, which are those
+  // of the whole proxy session if there is one. Call once the server side
+  // connects.
+  int SetServerDiffServCodePoint(DiffServCodePoint dscp);
+
+  // Bytes held by a connection, by component. Sockets of the network stack
+  // below the client socket and the socket handle are not counted.
+  struct MemoryUsage {
+    // The connection object, with what it keeps inline.
+    size_t object = 0;
+    // The padding sockets, their framers and the frames they hold.
+    size_t padding = 0;
+    // Relay buffers read into or being written.
+    size_t buffers = 0;
+    // The server socket, with its stream and the data it buffers if it is a
+    // tunnel over an HTTP/2 or QUIC session.
+    size_t stream = 0;
+    // The socket handle, and the tunnel connector, UDP association, cache
+    // fetch or splice relay while there is one.
+    size_t helpers = 0;
+
+    size_t total() const {
+      return object + padding + buffers + stream + helpers;
+    }
+    MemoryUsage& operator+=(const MemoryUsage& other);
+  };
+
+  MemoryUsage GetMemoryUsage() const;
+
  private:
+  class LentIOBuffer;
+
   enum State {
     STATE_CONNECT_CLIENT,
     STATE_CONNECT_CLIENT_COMPLETE,
@@ -65,14 +203,6 @@ class NaiveConnection {
     STATE_NONE,
   };
 
-  enum PaddingState {
-    STATE_READ_PAYLOAD_LENGTH_1,
-    STATE_READ_PAYLOAD_LENGTH_2,
-    STATE_READ_PADDING_LENGTH,
-    STATE_READ_PAYLOAD,
-    STATE_READ_PADDING,
-  };
-
   void DoCallback(int result);
   void OnIOComplete(int result);
   int DoLoop(int last_io_result);
@@ -80,52 +210,152 @@ class NaiveConnection {
   int DoConnectClientComplete(int result);
   int DoConnectServer();
   int DoConnectServerComplete(int result);
+  // Sets `origin` to the name the redirect resolver gave `address` for, or
+  // to the address itself if it is not one of the resolver's.
+  int FindOriginByAddress(const IPEndPoint& address, HostPortPair* origin);
   void Pull(Direction from, Direction to);
+  // Switches `from` and `to` to their transport sockets for reads and writes
+  // once padding no longer applies to them.
+  void BypassUnframedSockets(Direction from, Direction to);
+  void Resume(Direction from, Direction to);
+  void ReadForPull(Direction from, Direction to);
+  void OnPullReady(Direction from, Direction to, int result);
   void Push(Direction from, Direction to, int size);
   void Disconnect(Direction side);
-  bool IsConnected(Direction side);
+  bool IsConnected(Direction side) const;
   void OnBothDisconnected();
   void OnPullError(Direction from, Direction to, int error);
+  // Passes EOF read from `from` on to `to` once everything read before it
+  // has been written.
+  void ShutdownWrite(Direction from, Direction to);
   void OnPushError(Direction from, Direction to, int error);
+  void OnFlushComplete(Direction from, Direction to, int result);
   void OnPullComplete(Direction from, Direction to, int result);
   void OnPushComplete(Direction from, Direction to, int result);
+  // Writes the bytes in `lent_buffers_[from]` and consumes those written.
+  void PushLent(Direction from, Direction to, int size);
+  // Counts `bytes` written to the other side of `from`.
+  void OnRelayed(Direction from, int bytes);
+  // Pulls again now, after the scheduler, or after the rate limiters.
+  void PullNext(Direction from, Direction to);
+  // Runs a SOCKS5 UDP association, which lasts as long as the client keeps
+  // the TCP connection open.
+  int RunUdpAssociation();
+  void ReadUdpControl();
+  void OnUdpControlRead(int result);
+  void OnUdpAssociationComplete(int result);
+  // Serves a GET of an http listener through the HTTP cache, and closes the
+  // connection after the response.
+  int RunCacheFetch();
+  void OnCacheFetchComplete(int result);
+#if BUILDFLAG(IS_LINUX)
+  // Returns the descriptor of the plain TCP socket below `side`, or
+  // kInvalidSocket if that side is not a plain TCP socket.
+  int GetRawSocketDescriptor(Direction side) const;
+  bool CanUseSpliceRelay() const;
+  int StartSpliceRelay();
+  void OnSpliceRelayComplete(int result);
+#endif
 
-  unsigned int id_;
+  // Members are ordered by size so that the flags and small counters pack
+  // together. See GetMemoryUsage().
+  uint64_t id_;
   ClientProtocol protocol_;
-  std::unique_ptr<PaddingDetectorDelegate> padding_detector_delegate_;
+  PaddingDetectorDelegate padding_detector_delegate_;
   const ProxyInfo& proxy_info_;
   RedirectResolver* resolver_;
   HttpNetworkSession* session_;
-  const NetworkAnonymizationKey& network_anonymization_key_;
+  // Null if the HTTP cache is off.
+  NaiveHttpCache* http_cache_;
+  // Of the tunnel session for each class.
+  const NaiveProxySelector::ClassKeys& session_keys_;
   const NetLogWithSource& net_log_;
+  const NaivePaddingProfile& padding_profile_;
+  const NaivePriorityRules& priority_rules_;
+  // Traffic annotation for socket control.
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+  // For the server side of direct connections.
+  const RelaySocketOptions relay_socket_options_;
+  // Class of the tunnel, from the listener until the rules covering its
+  // destination port are applied.
+  TunnelPriority priority_;
+  State next_state_;
 
   CompletionRepeatingCallback io_callback_;
+  // Bound once for each direction, by the side it reads from, so relaying
+  // a chunk does not allocate callbacks.
+  CompletionRepeatingCallback pull_ready_callbacks_[kNumDirections];
+  CompletionRepeatingCallback pull_complete_callbacks_[kNumDirections];
+  CompletionRepeatingCallback push_complete_callbacks_[kNumDirections];
+  base::RepeatingClosure resume_callbacks_[kNumDirections];
   CompletionOnceCallback connect_callback_;
   CompletionOnceCallback run_callback_;
 
-  State next_state_;
-
   std::unique_ptr<StreamSocket> client_socket_;
   std::unique_ptr<ClientSocketHandle> server_socket_handle_;
+  // Until the server side is connected.
+  std::unique_ptr<NaiveTunnelConnector> tunnel_connector_;
+  // Replaces the server side for SOCKS5 UDP ASSOCIATE requests.
+  std::unique_ptr<NaiveUdpAssociation> udp_association_;
+  // Replaces the server side for GETs served through the HTTP cache.
+  std::unique_ptr<NaiveHttpCacheFetch> cache_fetch_;
+#if BUILDFLAG(IS_LINUX)
+  std::unique_ptr<NaiveSpliceRelay> splice_relay_;
+  // Bytes relayed by `splice_relay_` when its activity was last checked.
+  int64_t splice_bytes_seen_[kNumDirections] = {};
+#endif
+
+  // The first null entry ends the list.
+  std::array<scoped_refptr<NaiveRateLimiter>, kMaxRateLimiters>
+      rate_limiters_;
 
   std::unique_ptr<NaivePaddingSocket> sockets_[kNumDirections];
+  // The transport sockets under sockets_, once their reads or writes skip
+  // the padding socket, or null.
+  StreamSocket* read_transports_[kNumDirections];
+  StreamSocket* write_transports_[kNumDirections];
   scoped_refptr<IOBuffer> read_buffers_[kNumDirections];
+  // Whole buffers around read_buffers_ that are framed in place with padding,
+  // or null.
+  scoped_refptr<IOBuffer> frame_buffers_[kNumDirections];
   scoped_refptr<DrainableIOBuffer> write_buffers_[kNumDirections];
+  // Bytes lent by the socket of a direction as read_buffers_, or null.
+  scoped_refptr<LentIOBuffer> lent_buffers_[kNumDirections];
+  base::TimeTicks pull_start_time_[kNumDirections];
+  // Bytes written to the other side, without those of `splice_relay_`.
+  int64_t relayed_bytes_[kNumDirections];
+
   int errors_[kNumDirections];
-  bool write_pending_[kNumDirections];
-  int bytes_passed_without_yielding_[kNumDirections];
-  base::TimeTicks yield_after_time_[kNumDirections];
+  // Relay buffer size for the next read, adapted to observed read sizes.
+  int read_sizes_[kNumDirections];
+  // Bytes a direction may still relay before yielding to the scheduler.
+  int deficits_[kNumDirections];
+  int early_pull_result_;
+  int server_connect_result_;
 
+  bool write_pending_[kNumDirections];
+  bool read_if_ready_pending_[kNumDirections];
+  // EOF was read from this side.
+  bool read_closed_[kNumDirections];
+  // Writes to this side were shut down after relaying EOF.
+  bool write_closed_[kNumDirections];
   bool early_pull_pending_;
   bool can_push_to_server_;
-  int early_pull_result_;
-
   bool full_duplex_;
+  bool access_logged_ = false;
 
-  TimeFunc time_func_;
+  base::TimeTicks start_time_;
+  base::TimeTicks last_activity_times_[kNumDirections];
+  base::TimeTicks client_connect_end_time_;
+  // Without those of `splice_relay_`.
+  base::TimeTicks first_relay_times_[kNumDirections];
 
-  // Traffic annotation for socket control.
-  const NetworkTrafficAnnotationTag& traffic_annotation_;
+  // Null until the server side starts connecting to the proxy.
+  base::TimeTicks server_connect_start_time_;
+  base::TimeDelta server_connect_time_;
+  HostPortPair origin_;
+
+  TimeFunc time_func_;
 
   base::WeakPtrFactory<NaiveConnection> weak_ptr_factory_{this};
 };
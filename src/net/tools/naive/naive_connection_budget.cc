@@ -0,0 +1,60 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_connection_budget.h"
+
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/location.h"
+#include "base/task/single_thread_task_runner.h"
+
+namespace net {
+
+NaiveConnectionBudget::NaiveConnectionBudget(
+    int limit,
+    scoped_refptr<NaiveFdBudget> fd_budget)
+    : limit_(limit), fd_budget_(std::move(fd_budget)) {
+  DCHECK_GE(limit_, 0);
+}
+
+NaiveConnectionBudget::~NaiveConnectionBudget() = default;
+
+void NaiveConnectionBudget::Acquire() {
+  used_++;
+  if (fd_budget_)
+    fd_budget_->AddTunnel();
+}
+
+void NaiveConnectionBudget::Release() {
+  DCHECK_GT(used_, 0);
+  used_--;
+  if (fd_budget_)
+    fd_budget_->RemoveTunnel();
+  if (waiters_.empty())
+    return;
+  // Not run here, as the closing connection is still on the call stack.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, std::move(waiters_.front()));
+  waiters_.pop_front();
+}
+
+void NaiveConnectionBudget::Wait(base::OnceClosure resume) {
+  waiters_.push_back(std::move(resume));
+}
+
+void NaiveConnectionBudget::SetMemoryCritical(bool critical) {
+  if (critical == memory_critical_)
+    return;
+  memory_critical_ = critical;
+  if (critical)
+    return;
+  // Those still over the limit wait again.
+  while (!waiters_.empty()) {
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE, std::move(waiters_.front()));
+    waiters_.pop_front();
+  }
+}
+
+}  // namespace net
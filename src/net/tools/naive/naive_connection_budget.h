@@ -0,0 +1,58 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_CONNECTION_BUDGET_H_
+#define NET_TOOLS_NAIVE_NAIVE_CONNECTION_BUDGET_H_
+
+#include "base/containers/circular_deque.h"
+#include "base/functional/callback.h"
+#include "base/memory/scoped_refptr.h"
+#include "net/tools/naive/naive_fd_budget.h"
+
+namespace net {
+
+// Caps the open connections of the listeners of a thread. A listener that
+// finds the budget spent stops accepting until a connection closes, so new
+// connections wait in the listen backlog of the kernel instead of taking
+// file descriptors and buffers. The budget is also spent while memory is
+// critically low. Must be used on one thread.
+//
+// The connections are also counted as tunnels of the process-wide
+// `fd_budget`, if any, whose exhaustion listeners check with fds_low().
+class NaiveConnectionBudget {
+ public:
+  // Zero `limit` for no limit.
+  NaiveConnectionBudget(int limit, scoped_refptr<NaiveFdBudget> fd_budget);
+  ~NaiveConnectionBudget();
+  NaiveConnectionBudget(const NaiveConnectionBudget&) = delete;
+  NaiveConnectionBudget& operator=(const NaiveConnectionBudget&) = delete;
+
+  bool exhausted() const {
+    return memory_critical_ || (limit_ > 0 && used_ >= limit_);
+  }
+  int used() const { return used_; }
+  bool fds_low() const { return fd_budget_ && fd_budget_->low(); }
+
+  // Counts a new connection. Connections accepted while the budget was
+  // being spent may take it slightly over the limit.
+  void Acquire();
+  // Counts a closed connection, and resumes the longest waiting listener.
+  void Release();
+
+  // Runs `resume` in a new task after the next Release(), or after memory
+  // stops being critically low.
+  void Wait(base::OnceClosure resume);
+
+  // Resumes all waiting listeners once `critical` is false again.
+  void SetMemoryCritical(bool critical);
+
+ private:
+  const int limit_;
+  const scoped_refptr<NaiveFdBudget> fd_budget_;
+  int used_ = 0;
+  bool memory_critical_ = false;
+  base::circular_deque<base::OnceClosure> waiters_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_CONNECTION_BUDGET_H_
@@ -0,0 +1,73 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/naive/naive_connection_table.h"
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/check_op.h"
+#include "net/tools/naive/naive_connection.h"
+
+namespace net {
+
+NaiveConnectionTable::Slot::Slot() = default;
+NaiveConnectionTable::Slot::~Slot() = default;
+NaiveConnectionTable::Slot::Slot(Slot&&) = default;
+NaiveConnectionTable::Slot& NaiveConnectionTable::Slot::operator=(Slot&&) =
+    default;
+
+NaiveConnectionTable::NaiveConnectionTable() = default;
+
+NaiveConnectionTable::~NaiveConnectionTable() = default;
+
+uint64_t NaiveConnectionTable::NextId() const {
+  if (!free_slots_.empty()) {
+    uint32_t index = free_slots_.back();
+    return MakeId(index, slots_[index].generation);
+  }
+  if (slots_.size() >= kMaxSlots)
+    return 0;
+  return MakeId(static_cast<uint32_t>(slots_.size()), 1);
+}
+
+void NaiveConnectionTable::Insert(std::unique_ptr<NaiveConnection> connection) {
+  DCHECK(connection);
+  DCHECK_NE(connection->id(), 0u);
+  DCHECK_EQ(connection->id(), NextId());
+  if (!free_slots_.empty()) {
+    slots_[free_slots_.back()].connection = std::move(connection);
+    free_slots_.pop_back();
+  } else {
+    slots_.emplace_back();
+    slots_.back().connection = std::move(connection);
+  }
+  ++size_;
+}
+
+NaiveConnection* NaiveConnectionTable::Find(uint64_t id) const {
+  uint32_t index = static_cast<uint32_t>(id & kIndexMask);
+  if (index >= slots_.size())
+    return nullptr;
+  const Slot& slot = slots_[index];
+  if (slot.generation != id >> kIndexBits)
+    return nullptr;
+  return slot.connection.get();
+}
+
+std::unique_ptr<NaiveConnection> NaiveConnectionTable::Remove(uint64_t id) {
+  uint32_t index = static_cast<uint32_t>(id & kIndexMask);
+  if (index >= slots_.size())
+    return nullptr;
+  Slot& slot = slots_[index];
+  if (slot.generation != id >> kIndexBits || !slot.connection)
+    return nullptr;
+  // Takes 2^44 connections to wrap. Skips generation 0 so that no id is zero.
+  slot.generation = slot.generation == kMaxGeneration ? 1 : slot.generation + 1;
+  free_slots_.push_back(index);
+  --size_;
+  return std::move(slot.connection);
+}
+
+}  // namespace net
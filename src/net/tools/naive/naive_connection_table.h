@@ -0,0 +1,73 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_CONNECTION_TABLE_H_
+#define NET_TOOLS_NAIVE_NAIVE_CONNECTION_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace net {
+
+class NaiveConnection;
+
+// Owns the live connections of a NaiveProxy in a slab indexed by connection
+// id. An id packs the slot index in its low kIndexBits and the generation of
+// the slot in the remaining bits, so lookups are a bounds check and a
+// generation compare, and ids of closed connections stop resolving once their
+// slot is reused. The generation is wide enough never to wrap, so an old id
+// kept by a timer or a task cannot resolve to a later connection. Free slots
+// are reused in LIFO order to keep the slab dense.
+class NaiveConnectionTable {
+ public:
+  static constexpr int kIndexBits = 20;
+  static constexpr uint32_t kMaxSlots = 1u << kIndexBits;
+
+  NaiveConnectionTable();
+  ~NaiveConnectionTable();
+  NaiveConnectionTable(const NaiveConnectionTable&) = delete;
+  NaiveConnectionTable& operator=(const NaiveConnectionTable&) = delete;
+
+  // Returns the id the next inserted connection must have, or zero if the
+  // table is full and the connection must be refused.
+  uint64_t NextId() const;
+
+  // Takes ownership of `connection`, whose id must be NextId().
+  void Insert(std::unique_ptr<NaiveConnection> connection);
+
+  // Returns the connection with `id`, or null if it was removed.
+  NaiveConnection* Find(uint64_t id) const;
+
+  // Releases the connection with `id`, or returns null if it was removed.
+  std::unique_ptr<NaiveConnection> Remove(uint64_t id);
+
+  size_t size() const { return size_; }
+
+ private:
+  struct Slot {
+    Slot();
+    ~Slot();
+    Slot(Slot&&);
+    Slot& operator=(Slot&&);
+
+    std::unique_ptr<NaiveConnection> connection;
+    uint64_t generation = 1;
+  };
+
+  static constexpr uint32_t kIndexMask = kMaxSlots - 1;
+  static constexpr uint64_t kMaxGeneration =
+      static_cast<uint64_t>(-1) >> kIndexBits;
+
+  static uint64_t MakeId(uint32_t index, uint64_t generation) {
+    return (generation << kIndexBits) | index;
+  }
+
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_slots_;
+  size_t size_ = 0;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_CONNECTION_TABLE_H_
@@ -0,0 +1,103 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_fd_budget.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "base/check_op.h"
+#include "base/logging.h"
+#include "base/process/process_metrics.h"
+#include "build/build_config.h"
+
+#if BUILDFLAG(IS_APPLE)
+#include <limits.h>
+#endif
+
+namespace net {
+
+#if BUILDFLAG(IS_POSIX)
+namespace {
+#if BUILDFLAG(IS_APPLE)
+// setrlimit() fails above this even if the hard limit is unlimited.
+constexpr unsigned int kMaxLimit = OPEN_MAX;
+#else
+// The default of fs.nr_open on Linux.
+constexpr unsigned int kMaxLimit = 1024 * 1024;
+#endif
+}  // namespace
+#endif
+
+// static
+size_t NaiveFdBudget::RaiseLimit() {
+#if BUILDFLAG(IS_POSIX)
+  base::IncreaseFdLimitTo(kMaxLimit);
+#endif
+  return base::GetMaxFds();
+}
+
+NaiveFdBudget::NaiveFdBudget(size_t limit)
+    : limit_(static_cast<int64_t>(limit)),
+      reserve_(std::max(kMinReserve, limit_ / kReserveDivisor)) {
+  DCHECK_GT(limit_, 0);
+}
+
+NaiveFdBudget::~NaiveFdBudget() = default;
+
+bool NaiveFdBudget::low() const {
+  return EstimateOpen() + reserve_ >= limit_;
+}
+
+void NaiveFdBudget::AddListeners(int count) {
+  listeners_.fetch_add(count, std::memory_order_relaxed);
+}
+
+void NaiveFdBudget::AddTunnel() {
+  tunnels_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void NaiveFdBudget::RemoveTunnel() {
+  tunnels_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void NaiveFdBudget::Sample() {
+#if BUILDFLAG(IS_POSIX)
+  int open =
+      base::ProcessMetrics::CreateCurrentProcessMetrics()->GetOpenFdCount();
+  if (open < 0) {
+    return;
+  }
+  // The tunnels are read first, so those opened while counting are counted
+  // again rather than missed.
+  sampled_tunnels_.store(tunnels_.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+  sampled_open_.store(open, std::memory_order_relaxed);
+#endif
+  bool is_low = low();
+  if (is_low != was_low_) {
+    if (is_low) {
+      LOG(WARNING) << "File descriptors running out, pausing listeners: "
+                   << "open=" << EstimateOpen() << " limit=" << limit_;
+    } else {
+      LOG(INFO) << "File descriptors available again";
+    }
+    was_low_ = is_low;
+  }
+}
+
+void NaiveFdBudget::LogUsage() const {
+  VLOG(1) << "File descriptors: limit=" << limit_ << " reserve=" << reserve_
+          << " open=" << sampled_open_.load(std::memory_order_relaxed)
+          << " listeners=" << listeners_.load(std::memory_order_relaxed)
+          << " tunnels=" << tunnels_.load(std::memory_order_relaxed);
+}
+
+int64_t NaiveFdBudget::EstimateOpen() const {
+  int64_t new_tunnels = tunnels_.load(std::memory_order_relaxed) -
+                        sampled_tunnels_.load(std::memory_order_relaxed);
+  return sampled_open_.load(std::memory_order_relaxed) +
+         std::max<int64_t>(new_tunnels, 0) * kFdsPerTunnel;
+}
+
+}  // namespace net
@@ -0,0 +1,71 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_FD_BUDGET_H_
+#define NET_TOOLS_NAIVE_NAIVE_FD_BUDGET_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "base/memory/ref_counted.h"
+#include "base/time/time.h"
+
+namespace net {
+
+// The file descriptors of the process against its soft limit, shared by
+// the IO threads through the configuration. Open descriptors are sampled
+// from the process every kSampleInterval by the main thread, and the
+// subsystems count theirs as they go: the listen sockets, and the tunnels
+// of the listeners, which each hold up to kFdsPerTunnel. Tunnels opened
+// since the last sample are assumed to hold that many, so a burst of
+// connections is seen before the next sample. Listeners stop accepting
+// while the descriptors left are within the reserve, instead of failing
+// accepts with EMFILE.
+class NaiveFdBudget : public base::RefCountedThreadSafe<NaiveFdBudget> {
+ public:
+  static constexpr base::TimeDelta kSampleInterval = base::Seconds(1);
+  // The client socket and a direct connection to the destination.
+  static constexpr int64_t kFdsPerTunnel = 2;
+  // Kept for the sockets to proxies, DNS and files: the larger of these.
+  static constexpr int64_t kMinReserve = 32;
+  static constexpr int64_t kReserveDivisor = 20;
+
+  // Raises the soft limit of file descriptors to the hard limit, and
+  // returns the soft limit.
+  static size_t RaiseLimit();
+
+  explicit NaiveFdBudget(size_t limit);
+  NaiveFdBudget(const NaiveFdBudget&) = delete;
+  NaiveFdBudget& operator=(const NaiveFdBudget&) = delete;
+
+  // Whether the descriptors left are within the reserve.
+  bool low() const;
+
+  void AddListeners(int count);
+  void AddTunnel();
+  void RemoveTunnel();
+
+  // Counts the open descriptors of the process. Called on the main thread.
+  void Sample();
+  void LogUsage() const;
+
+ private:
+  friend class base::RefCountedThreadSafe<NaiveFdBudget>;
+  ~NaiveFdBudget();
+
+  int64_t EstimateOpen() const;
+
+  const int64_t limit_;
+  const int64_t reserve_;
+  std::atomic<int64_t> listeners_ = 0;
+  std::atomic<int64_t> tunnels_ = 0;
+  // As of the last sample.
+  std::atomic<int64_t> sampled_open_ = 0;
+  std::atomic<int64_t> sampled_tunnels_ = 0;
+  // Only used by Sample().
+  bool was_low_ = false;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_FD_BUDGET_H_
@@ -0,0 +1,80 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_file_writer.h"
+
+#include <optional>
+#include <utility>
+
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/functional/bind.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/task/sequenced_task_runner.h"
+#include "base/task/thread_pool.h"
+#include "base/thread_annotations.h"
+#include "build/build_config.h"
+
+namespace net {
+
+class NaiveFileWriter::Core : public base::RefCountedThreadSafe<Core> {
+ public:
+  explicit Core(const base::FilePath& path) : path_(path) {}
+  Core(const Core&) = delete;
+  Core& operator=(const Core&) = delete;
+
+  // Returns whether no write was pending, so the caller posts one.
+  bool SetPending(std::string data) {
+    base::AutoLock lock(lock_);
+    bool was_pending = pending_.has_value();
+    pending_ = std::move(data);
+    return !was_pending;
+  }
+
+  void WritePending() {
+    std::string data;
+    {
+      base::AutoLock lock(lock_);
+      if (!pending_)
+        return;
+      data = std::move(*pending_);
+      pending_.reset();
+    }
+    if (!base::ImportantFileWriter::WriteFileAtomically(path_, data)) {
+      LOG(WARNING) << "Failed to write " << path_;
+      return;
+    }
+#if BUILDFLAG(IS_POSIX)
+    base::SetPosixFilePermissions(
+        path_, base::FILE_PERMISSION_READ_BY_USER |
+                   base::FILE_PERMISSION_WRITE_BY_USER);
+#endif
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<Core>;
+  ~Core() = default;
+
+  const base::FilePath path_;
+  base::Lock lock_;
+  std::optional<std::string> pending_ GUARDED_BY(lock_);
+};
+
+NaiveFileWriter::NaiveFileWriter(const base::FilePath& path)
+    : core_(base::MakeRefCounted<Core>(path)),
+      task_runner_(base::ThreadPool::CreateSequencedTaskRunner(
+          {base::MayBlock(), base::TaskPriority::BEST_EFFORT,
+           base::TaskShutdownBehavior::BLOCK_SHUTDOWN})) {}
+
+NaiveFileWriter::~NaiveFileWriter() = default;
+
+void NaiveFileWriter::Write(std::string data) {
+  if (core_->SetPending(std::move(data))) {
+    task_runner_->PostTask(FROM_HERE,
+                           base::BindOnce(&Core::WritePending, core_));
+  }
+}
+
+}  // namespace net
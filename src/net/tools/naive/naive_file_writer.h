@@ -0,0 +1,41 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_FILE_WRITER_H_
+#define NET_TOOLS_NAIVE_NAIVE_FILE_WRITER_H_
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/memory/scoped_refptr.h"
+
+namespace base {
+class SequencedTaskRunner;
+}  // namespace base
+
+namespace net {
+
+// Writes the file of a session or verification store on a ThreadPool
+// sequence, so the handshakes that update the store on the IO threads do not
+// wait for the disk. A write replaces any still pending, so a burst of
+// handshakes costs one write. Only the user can read or write the file, as
+// its contents resume sessions or make chains trusted.
+class NaiveFileWriter {
+ public:
+  explicit NaiveFileWriter(const base::FilePath& path);
+  ~NaiveFileWriter();
+  NaiveFileWriter(const NaiveFileWriter&) = delete;
+  NaiveFileWriter& operator=(const NaiveFileWriter&) = delete;
+
+  // Can be called on any thread.
+  void Write(std::string data);
+
+ private:
+  class Core;
+
+  scoped_refptr<Core> core_;
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_FILE_WRITER_H_
@@ -0,0 +1,232 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_h2_datagram_socket.h"
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <utility>
+
+#include "base/check.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/task/single_thread_task_runner.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/http/http_request_headers.h"
+#include "net/http/http_request_info.h"
+#include "net/spdy/spdy_buffer.h"
+#include "net/spdy/spdy_http_utils.h"
+#include "net/third_party/quiche/src/quiche/common/quiche_data_reader.h"
+#include "net/third_party/quiche/src/quiche/common/simple_buffer_allocator.h"
+#include "net/third_party/quiche/src/quiche/spdy/core/spdy_protocol.h"
+
+namespace net {
+
+NaiveH2DatagramSocket::NaiveH2DatagramSocket(
+    base::WeakPtr<SpdyStream> stream,
+    const GURL& url,
+    const NetLogWithSource& net_log)
+    : stream_(std::move(stream)), url_(url), net_log_(net_log) {
+  DCHECK(stream_);
+  stream_->SetDelegate(this);
+}
+
+NaiveH2DatagramSocket::~NaiveH2DatagramSocket() {
+  if (stream_)
+    stream_->DetachDelegate();
+}
+
+int NaiveH2DatagramSocket::Connect(const HttpRequestHeaders& extra_headers,
+                                   CompletionOnceCallback callback) {
+  DCHECK(!connect_callback_);
+  if (!stream_)
+    return close_status_;
+
+  HttpRequestInfo request;
+  request.method = "CONNECT";
+  request.url = url_;
+  HttpRequestHeaders headers = extra_headers;
+  headers.SetHeader("capsule-protocol", "?1");
+  spdy::Http2HeaderBlock header_block;
+  CreateSpdyHeadersFromHttpRequestForExtendedConnect(
+      request, /*priority=*/std::nullopt, "connect-udp", headers,
+      &header_block);
+  int rv = stream_->SendRequestHeaders(std::move(header_block),
+                                       MORE_DATA_TO_SEND);
+  if (rv != ERR_IO_PENDING)
+    return rv;
+  connect_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
+int NaiveH2DatagramSocket::Read(IOBuffer* buf,
+                                int buf_len,
+                                CompletionOnceCallback callback) {
+  DCHECK(!read_callback_);
+  if (!read_queue_.empty()) {
+    std::string datagram = std::move(read_queue_.front());
+    read_queue_.pop();
+    if (datagram.size() > static_cast<size_t>(buf_len))
+      return ERR_MSG_TOO_BIG;
+    std::memcpy(buf->data(), datagram.data(), datagram.size());
+    return static_cast<int>(datagram.size());
+  }
+  if (close_status_ != OK)
+    return close_status_;
+  read_buf_ = buf;
+  read_buf_len_ = buf_len;
+  read_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
+int NaiveH2DatagramSocket::Write(std::string_view payload) {
+  DCHECK(open_);
+  if (close_status_ != OK)
+    return close_status_;
+
+  // The context ID 0 of UDP payloads, then the payload.
+  quiche::QuicheBuffer header = quiche::SerializeDatagramCapsuleHeader(
+      1 + payload.size(), quiche::SimpleBufferAllocator::Get());
+  size_t size = header.size() + 1 + payload.size();
+  if (pending_writes_.size() + size > kMaxPendingWriteBytes)
+    return OK;
+  pending_writes_.append(header.data(), header.size());
+  pending_writes_.push_back('\0');
+  pending_writes_.append(payload);
+  if (!write_buf_)
+    SendPendingWrites();
+  return OK;
+}
+
+void NaiveH2DatagramSocket::SendPendingWrites() {
+  if (!stream_ || write_buf_ || pending_writes_.empty())
+    return;
+  int size = static_cast<int>(pending_writes_.size());
+  write_buf_ = base::MakeRefCounted<StringIOBuffer>(std::move(pending_writes_));
+  pending_writes_.clear();
+  stream_->SendData(write_buf_.get(), size, MORE_DATA_TO_SEND);
+}
+
+void NaiveH2DatagramSocket::Fail(int error) {
+  if (close_status_ == OK)
+    close_status_ = error;
+  pending_writes_.clear();
+  read_queue_ = {};
+
+  base::WeakPtr<NaiveH2DatagramSocket> weak_ptr =
+      weak_ptr_factory_.GetWeakPtr();
+  if (connect_callback_) {
+    std::move(connect_callback_).Run(close_status_);
+    if (!weak_ptr)
+      return;
+  }
+  if (read_callback_) {
+    read_buf_ = nullptr;
+    read_buf_len_ = 0;
+    std::move(read_callback_).Run(close_status_);
+  }
+}
+
+void NaiveH2DatagramSocket::OnHeadersSent() {}
+
+void NaiveH2DatagramSocket::OnEarlyHintsReceived(
+    const spdy::Http2HeaderBlock& headers) {}
+
+void NaiveH2DatagramSocket::OnHeadersReceived(
+    const spdy::Http2HeaderBlock& response_headers) {
+  if (!connect_callback_)
+    return;
+  auto it = response_headers.find(spdy::kHttp2StatusHeader);
+  int status = 0;
+  if (it == response_headers.end() ||
+      !base::StringToInt(it->second, &status) || status / 100 != 2) {
+    // Not reported beyond that, so the proxy cannot impersonate the
+    // destination.
+    Fail(ERR_TUNNEL_CONNECTION_FAILED);
+    return;
+  }
+  open_ = true;
+  std::move(connect_callback_).Run(OK);
+}
+
+void NaiveH2DatagramSocket::OnDataReceived(std::unique_ptr<SpdyBuffer> buffer) {
+  if (!buffer) {
+    Fail(ERR_CONNECTION_CLOSED);
+    return;
+  }
+  if (capsule_parse_failed_)
+    return;
+  // The flow control window is returned as `buffer` is consumed.
+  capsule_parser_.IngestCapsuleFragment(
+      std::string_view(buffer->GetRemainingData(), buffer->GetRemainingSize()));
+}
+
+void NaiveH2DatagramSocket::OnDataSent() {
+  write_buf_ = nullptr;
+  // The stream must not be closed from here.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveH2DatagramSocket::SendPendingWrites,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+void NaiveH2DatagramSocket::OnTrailers(const spdy::Http2HeaderBlock& trailers) {
+}
+
+void NaiveH2DatagramSocket::OnClose(int status) {
+  stream_.reset();
+  write_buf_ = nullptr;
+  if (connect_callback_ && status == OK)
+    status = ERR_TUNNEL_CONNECTION_FAILED;
+  Fail(status < 0 ? status : ERR_CONNECTION_CLOSED);
+}
+
+bool NaiveH2DatagramSocket::CanGreaseFrameType() const {
+  return false;
+}
+
+NetLogSource NaiveH2DatagramSocket::source_dependency() const {
+  return net_log_.source();
+}
+
+bool NaiveH2DatagramSocket::OnCapsule(const quiche::Capsule& capsule) {
+  if (capsule.capsule_type() != quiche::CapsuleType::DATAGRAM)
+    return true;
+  quiche::QuicheDataReader reader(
+      capsule.datagram_capsule().http_datagram_payload);
+  uint64_t context_id;
+  if (!reader.ReadVarInt62(&context_id))
+    return false;
+  // Other contexts are not registered, as RFC 9298 leaves them to
+  // extensions.
+  if (context_id != 0)
+    return true;
+  std::string_view payload = reader.ReadRemainingPayload();
+
+  if (read_callback_) {
+    int rv = ERR_MSG_TOO_BIG;
+    if (payload.size() <= static_cast<size_t>(read_buf_len_)) {
+      std::memcpy(read_buf_->data(), payload.data(), payload.size());
+      rv = static_cast<int>(payload.size());
+    }
+    read_buf_ = nullptr;
+    read_buf_len_ = 0;
+    std::move(read_callback_).Run(rv);
+    return true;
+  }
+  if (read_queue_.size() < kMaxReadQueueSize)
+    read_queue_.emplace(payload);
+  return true;
+}
+
+void NaiveH2DatagramSocket::OnCapsuleParseFailure(
+    std::string_view error_message) {
+  VLOG(1) << "Invalid capsule from " << url_.host() << ": " << error_message;
+  capsule_parse_failed_ = true;
+  Fail(ERR_INVALID_RESPONSE);
+}
+
+}  // namespace net
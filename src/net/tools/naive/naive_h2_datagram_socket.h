@@ -0,0 +1,115 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_H2_DATAGRAM_SOCKET_H_
+#define NET_TOOLS_NAIVE_NAIVE_H2_DATAGRAM_SOCKET_H_
+
+#include <cstddef>
+#include <memory>
+#include <queue>
+#include <string>
+#include <string_view>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "net/base/completion_once_callback.h"
+#include "net/base/net_errors.h"
+#include "net/log/net_log_source.h"
+#include "net/log/net_log_with_source.h"
+#include "net/spdy/spdy_stream.h"
+#include "net/third_party/quiche/src/quiche/common/capsule.h"
+#include "url/gurl.h"
+
+namespace net {
+
+class HttpRequestHeaders;
+class IOBuffer;
+class SpdyBuffer;
+
+// Carries the datagrams of a CONNECT-UDP request (RFC 9298) as DATAGRAM
+// capsules (RFC 9297) on an extended CONNECT stream (RFC 8441) of the HTTP/2
+// session to the proxy, for proxies reached over HTTP/2, as when QUIC to them
+// is blocked. Each capsule carries one datagram with context ID 0, and other
+// capsules are ignored.
+//
+// The stream is reliable and ordered, so datagrams written while earlier
+// capsules are still being sent are queued up to kMaxPendingWriteBytes, and
+// dropped after that as UDP allows, rather than backing up behind a slow
+// stream. Received datagrams not yet read are likewise dropped after
+// kMaxReadQueueSize.
+class NaiveH2DatagramSocket : public SpdyStream::Delegate,
+                              public quiche::CapsuleParser::Visitor {
+ public:
+  static constexpr size_t kMaxPendingWriteBytes = 64 * 1024;
+  static constexpr size_t kMaxReadQueueSize = 16;
+
+  // Sets itself as the delegate of `stream`, a bidirectional stream opened
+  // for `url`, the URL of the CONNECT-UDP request.
+  NaiveH2DatagramSocket(base::WeakPtr<SpdyStream> stream,
+                        const GURL& url,
+                        const NetLogWithSource& net_log);
+  ~NaiveH2DatagramSocket() override;
+  NaiveH2DatagramSocket(const NaiveH2DatagramSocket&) = delete;
+  NaiveH2DatagramSocket& operator=(const NaiveH2DatagramSocket&) = delete;
+
+  // Sends the request with `extra_headers`. Returns ERR_IO_PENDING and runs
+  // `callback` once the proxy accepts or refuses it.
+  int Connect(const HttpRequestHeaders& extra_headers,
+              CompletionOnceCallback callback);
+
+  // Reads the next datagram into `buf`. Returns its size, ERR_MSG_TOO_BIG if
+  // it does not fit, ERR_IO_PENDING to run `callback` with either later, or
+  // a net error once the stream is closed.
+  int Read(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
+
+  // Sends `payload` as one datagram, or queues it behind the capsules being
+  // sent. Returns OK even if it is dropped, or a net error once the stream
+  // is closed.
+  int Write(std::string_view payload);
+
+  // SpdyStream::Delegate:
+  void OnHeadersSent() override;
+  void OnEarlyHintsReceived(const spdy::Http2HeaderBlock& headers) override;
+  void OnHeadersReceived(
+      const spdy::Http2HeaderBlock& response_headers) override;
+  void OnDataReceived(std::unique_ptr<SpdyBuffer> buffer) override;
+  void OnDataSent() override;
+  void OnTrailers(const spdy::Http2HeaderBlock& trailers) override;
+  void OnClose(int status) override;
+  bool CanGreaseFrameType() const override;
+  NetLogSource source_dependency() const override;
+
+  // quiche::CapsuleParser::Visitor:
+  bool OnCapsule(const quiche::Capsule& capsule) override;
+  void OnCapsuleParseFailure(std::string_view error_message) override;
+
+ private:
+  void SendPendingWrites();
+  // Ends the flow of datagrams with `error`, failing the pending callbacks.
+  void Fail(int error);
+
+  base::WeakPtr<SpdyStream> stream_;
+  const GURL url_;
+  const NetLogWithSource net_log_;
+
+  CompletionOnceCallback connect_callback_;
+  bool open_ = false;
+  // The error the stream was closed with, once it is.
+  int close_status_ = OK;
+
+  quiche::CapsuleParser capsule_parser_{this};
+  bool capsule_parse_failed_ = false;
+  std::queue<std::string> read_queue_;
+  scoped_refptr<IOBuffer> read_buf_;
+  int read_buf_len_ = 0;
+  CompletionOnceCallback read_callback_;
+
+  // Capsules waiting for the one being sent.
+  std::string pending_writes_;
+  scoped_refptr<IOBuffer> write_buf_;
+
+  base::WeakPtrFactory<NaiveH2DatagramSocket> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_H2_DATAGRAM_SOCKET_H_
@@ -0,0 +1,158 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_health_checker.h"
+
+#include <utility>
+
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/raw_ptr.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/task/single_thread_task_runner.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/http/http_network_session.h"
+#include "net/log/net_log_source_type.h"
+#include "net/proxy_resolution/proxy_info.h"
+#include "net/socket/client_socket_handle.h"
+#include "net/socket/stream_socket.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+#include "net/tools/naive/naive_tunnel_connector.h"
+#include "url/scheme_host_port.h"
+#include "url/url_constants.h"
+
+namespace net {
+namespace {
+constexpr int kProbeReadSize = 4096;
+}  // namespace
+
+// The probe of one chain. Tunnels may be opened with Fast Open, where the
+// connect completes before the proxy answers, so the probe also waits for
+// the first data from the destination, or for it to close, which only come
+// after the answer.
+class NaiveHealthChecker::Probe {
+ public:
+  Probe(HttpNetworkSession* session,
+        NaiveProxySelector* proxy_selector,
+        size_t chain,
+        const url::SchemeHostPort& destination,
+        const NetLogWithSource& net_log,
+        const NetworkTrafficAnnotationTag& traffic_annotation)
+      : session_(session),
+        proxy_selector_(proxy_selector),
+        chain_(chain),
+        destination_(destination),
+        net_log_(net_log),
+        traffic_annotation_(traffic_annotation) {}
+  ~Probe() = default;
+  Probe(const Probe&) = delete;
+  Probe& operator=(const Probe&) = delete;
+
+  void Start() {
+    // The timeout ends a probe before the next one is due.
+    if (running_)
+      return;
+    running_ = true;
+    selection_ = {chain_, 0, proxy_selector_->uses_quic(chain_)};
+    // The connector of the last probe may have run its callback only now.
+    connector_ =
+        std::make_unique<NaiveTunnelConnector>(session_, traffic_annotation_);
+    handle_ = std::make_unique<ClientSocketHandle>();
+    start_time_ = base::TimeTicks::Now();
+    timeout_timer_.Start(FROM_HERE, kProbeTimeout,
+                         base::BindOnce(&Probe::OnTimeout,
+                                        base::Unretained(this)));
+    int rv = connector_->Connect(
+        destination_, proxy_selector_->proxy_info(selection_),
+        proxy_selector_->network_anonymization_key(selection_),
+        SecureDnsPolicy::kDisable, net_log_, handle_.get(),
+        base::BindOnce(&Probe::OnConnectComplete, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnConnectComplete(rv);
+  }
+
+ private:
+  void OnConnectComplete(int result) {
+    if (result != OK) {
+      OnComplete(result);
+      return;
+    }
+    read_buffer_ = base::MakeRefCounted<IOBufferWithSize>(kProbeReadSize);
+    int rv = handle_->socket()->Read(
+        read_buffer_.get(), read_buffer_->size(),
+        base::BindOnce(&Probe::OnReadComplete, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnReadComplete(rv);
+  }
+
+  void OnReadComplete(int result) { OnComplete(result < 0 ? result : OK); }
+
+  void OnTimeout() {
+    connector_.reset();
+    OnComplete(ERR_TIMED_OUT);
+  }
+
+  void OnComplete(int result) {
+    timeout_timer_.Stop();
+    running_ = false;
+    base::TimeDelta time = base::TimeTicks::Now() - start_time_;
+    handle_.reset();
+    read_buffer_ = nullptr;
+    VLOG(1) << "Health probe of proxy chain "
+            << proxy_selector_->proxy_info(selection_)
+                   .proxy_chain()
+                   .ToDebugString()
+            << ": " << ErrorToShortString(result) << " in " << time;
+    proxy_selector_->OnProbeComplete(selection_, result, time);
+  }
+
+  const raw_ptr<HttpNetworkSession> session_;
+  const raw_ptr<NaiveProxySelector> proxy_selector_;
+  const size_t chain_;
+  const url::SchemeHostPort destination_;
+  const NetLogWithSource& net_log_;
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+
+  bool running_ = false;
+  NaiveProxySelector::Selection selection_;
+  std::unique_ptr<NaiveTunnelConnector> connector_;
+  std::unique_ptr<ClientSocketHandle> handle_;
+  scoped_refptr<IOBufferWithSize> read_buffer_;
+  base::TimeTicks start_time_;
+  base::OneShotTimer timeout_timer_;
+};
+
+NaiveHealthChecker::NaiveHealthChecker(
+    HttpNetworkSession* session,
+    NaiveProxySelector* proxy_selector,
+    const HostPortPair& destination,
+    base::TimeDelta interval,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : net_log_(
+          NetLogWithSource::Make(session->net_log(), NetLogSourceType::NONE)) {
+  url::SchemeHostPort endpoint(url::kHttpScheme, destination.host(),
+                               destination.port());
+  for (size_t chain = 0; chain < proxy_selector->num_chains(); ++chain) {
+    probes_.push_back(std::make_unique<Probe>(session, proxy_selector, chain,
+                                              endpoint, net_log_,
+                                              traffic_annotation));
+  }
+  probe_timer_.Start(FROM_HERE, interval, this,
+                     &NaiveHealthChecker::StartProbes);
+  // Leaves the first round to the next task, once the listeners are up.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveHealthChecker::StartProbes,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+NaiveHealthChecker::~NaiveHealthChecker() = default;
+
+void NaiveHealthChecker::StartProbes() {
+  for (const auto& probe : probes_)
+    probe->Start();
+}
+
+}  // namespace net
@@ -0,0 +1,60 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_HEALTH_CHECKER_H_
+#define NET_TOOLS_NAIVE_NAIVE_HEALTH_CHECKER_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/host_port_pair.h"
+#include "net/log/net_log_with_source.h"
+
+namespace net {
+
+class HttpNetworkSession;
+class NaiveProxySelector;
+struct NetworkTrafficAnnotationTag;
+
+// Probes each chain of NaiveProxySelector every `interval` by opening a
+// tunnel to `destination` over its first tunnel session, as a connection
+// from a listener would, and closing it once the destination sends data or
+// closes. The result and
+// duration go to the selector, so a chain whose proxy stops answering, or
+// answers slower than kProbeTimeout, is skipped within one interval rather
+// than after several tunnels failed, and is taken back once a probe
+// succeeds again. The durations count as tunnel connect times for
+// ProxySelection::kLowestLatency.
+//
+// A raced chain is probed over the protocol its tunnels use.
+class NaiveHealthChecker {
+ public:
+  static constexpr base::TimeDelta kProbeTimeout = base::Seconds(5);
+
+  // `session` and `proxy_selector` must outlive this.
+  NaiveHealthChecker(HttpNetworkSession* session,
+                     NaiveProxySelector* proxy_selector,
+                     const HostPortPair& destination,
+                     base::TimeDelta interval,
+                     const NetworkTrafficAnnotationTag& traffic_annotation);
+  ~NaiveHealthChecker();
+  NaiveHealthChecker(const NaiveHealthChecker&) = delete;
+  NaiveHealthChecker& operator=(const NaiveHealthChecker&) = delete;
+
+ private:
+  class Probe;
+
+  void StartProbes();
+
+  NetLogWithSource net_log_;
+  std::vector<std::unique_ptr<Probe>> probes_;
+  base::RepeatingTimer probe_timer_;
+
+  base::WeakPtrFactory<NaiveHealthChecker> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_HEALTH_CHECKER_H_
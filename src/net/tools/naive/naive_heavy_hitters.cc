@@ -0,0 +1,66 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_heavy_hitters.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace net {
+
+NaiveHeavyHitters::NaiveHeavyHitters() = default;
+NaiveHeavyHitters::NaiveHeavyHitters(const NaiveHeavyHitters&) = default;
+NaiveHeavyHitters& NaiveHeavyHitters::operator=(const NaiveHeavyHitters&) =
+    default;
+NaiveHeavyHitters::~NaiveHeavyHitters() = default;
+
+void NaiveHeavyHitters::Add(const std::string& key, uint64_t weight) {
+  if (weight == 0)
+    return;
+  auto it = counters_.find(key);
+  if (it != counters_.end()) {
+    it->second.count += weight;
+    return;
+  }
+  if (counters_.size() < kCapacity) {
+    counters_.emplace(key, Counter{weight, 0});
+    return;
+  }
+  // Linear, as kCapacity is small and most adds hit a counted key.
+  auto least = std::min_element(
+      counters_.begin(), counters_.end(),
+      [](const auto& a, const auto& b) {
+        return a.second.count < b.second.count;
+      });
+  uint64_t least_count = least->second.count;
+  counters_.erase(least);
+  counters_.emplace(key, Counter{least_count + weight, least_count});
+}
+
+void NaiveHeavyHitters::Merge(const NaiveHeavyHitters& other) {
+  for (const auto& [key, counter] : other.counters_) {
+    Counter& merged = counters_[key];
+    merged.count += counter.count;
+    merged.error += counter.error;
+  }
+  Trim();
+}
+
+void NaiveHeavyHitters::Trim() {
+  if (counters_.size() <= kCapacity)
+    return;
+  std::vector<std::pair<std::string, Counter>> counters(counters_.begin(),
+                                                        counters_.end());
+  std::nth_element(counters.begin(), counters.begin() + kCapacity,
+                   counters.end(), [](const auto& a, const auto& b) {
+                     return a.second.count > b.second.count;
+                   });
+  counters.resize(kCapacity);
+  counters_ = std::map<std::string, Counter>(
+      std::make_move_iterator(counters.begin()),
+      std::make_move_iterator(counters.end()));
+}
+
+}  // namespace net
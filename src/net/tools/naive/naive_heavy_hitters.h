@@ -0,0 +1,51 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_HEAVY_HITTERS_H_
+#define NET_TOOLS_NAIVE_NAIVE_HEAVY_HITTERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace net {
+
+// The keys with the largest sums of weights added, by the Space-Saving
+// algorithm: at most kCapacity keys are counted, and a key that is not
+// replaces the one with the least count and takes its count over. Memory
+// does not grow with the number of keys. A count is over by at most its
+// `error`, and every key whose sum is above the total over kCapacity is
+// counted.
+//
+// The summaries of threads are merged by adding the counts of each key and
+// keeping the kCapacity largest.
+class NaiveHeavyHitters {
+ public:
+  static constexpr size_t kCapacity = 64;
+
+  struct Counter {
+    uint64_t count = 0;
+    // Taken over from the key that was replaced.
+    uint64_t error = 0;
+  };
+
+  NaiveHeavyHitters();
+  NaiveHeavyHitters(const NaiveHeavyHitters&);
+  NaiveHeavyHitters& operator=(const NaiveHeavyHitters&);
+  ~NaiveHeavyHitters();
+
+  void Add(const std::string& key, uint64_t weight);
+  void Merge(const NaiveHeavyHitters& other);
+
+  const std::map<std::string, Counter>& counters() const { return counters_; }
+
+ private:
+  // Drops the keys with the least counts down to kCapacity.
+  void Trim();
+
+  std::map<std::string, Counter> counters_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_HEAVY_HITTERS_H_
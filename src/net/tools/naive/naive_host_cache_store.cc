@@ -0,0 +1,78 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_host_cache_store.h"
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/files/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+
+namespace net {
+namespace {
+constexpr int kFileVersion = 1;
+}  // namespace
+
+NaiveHostCacheStore::NaiveHostCacheStore(const base::FilePath& path)
+    : path_(path), writer_(path) {}
+
+NaiveHostCacheStore::~NaiveHostCacheStore() = default;
+
+size_t NaiveHostCacheStore::Load() {
+  std::string data;
+  if (!base::ReadFileToString(path_, &data))
+    return 0;
+  std::optional<base::Value::Dict> dict = base::JSONReader::ReadDict(data);
+  if (!dict || dict->FindInt("version") != kFileVersion) {
+    LOG(WARNING) << "Ignoring invalid host cache file " << path_;
+    return 0;
+  }
+  base::Value::List* entries = dict->FindList("entries");
+  if (!entries)
+    return 0;
+
+  size_t count = entries->size();
+  base::AutoLock lock(lock_);
+  loaded_entries_ = std::move(*entries);
+  LOG(INFO) << "Loaded " << count << " host cache entries from " << path_;
+  return count;
+}
+
+base::Value::List NaiveHostCacheStore::GetLoadedEntries() const {
+  base::AutoLock lock(lock_);
+  return loaded_entries_.Clone();
+}
+
+size_t NaiveHostCacheStore::AddSlot() {
+  base::AutoLock lock(lock_);
+  slots_.emplace_back();
+  return slots_.size() - 1;
+}
+
+void NaiveHostCacheStore::Save(size_t slot, base::Value::List entries) {
+  base::AutoLock lock(lock_);
+  CHECK_LT(slot, slots_.size());
+  slots_[slot] = std::move(entries);
+
+  // The same host in several slots is restored once, from the first.
+  base::Value::List all_entries;
+  for (const base::Value::List& slot_entries : slots_) {
+    for (const base::Value& entry : slot_entries) {
+      all_entries.Append(entry.Clone());
+    }
+  }
+  base::Value::Dict dict;
+  dict.Set("version", kFileVersion);
+  dict.Set("entries", std::move(all_entries));
+
+  std::string data;
+  base::JSONWriter::Write(dict, &data);
+  writer_.Write(std::move(data));
+}
+
+}  // namespace net
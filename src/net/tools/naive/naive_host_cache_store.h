@@ -0,0 +1,52 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_HOST_CACHE_STORE_H_
+#define NET_TOOLS_NAIVE_NAIVE_HOST_CACHE_STORE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/values.h"
+#include "net/tools/naive/naive_file_writer.h"
+
+namespace net {
+
+// Keeps the host caches of the IO threads in a file, so the first
+// connections after a restart can use the addresses resolved before it. See
+// NaiveStaleHostResolver.
+//
+// Each IO thread saves the entries of its own cache in a slot, and the file
+// holds those of all slots. Entries are in the restorable serialization of
+// HostCache, so those of transient NetworkAnonymizationKeys are not kept.
+class NaiveHostCacheStore {
+ public:
+  explicit NaiveHostCacheStore(const base::FilePath& path);
+  ~NaiveHostCacheStore();
+  NaiveHostCacheStore(const NaiveHostCacheStore&) = delete;
+  NaiveHostCacheStore& operator=(const NaiveHostCacheStore&) = delete;
+
+  // Reads the entries saved in the file. Returns the number of entries read.
+  size_t Load();
+
+  // Returns the entries read by Load(), for HostCache::RestoreFromListValue().
+  base::Value::List GetLoadedEntries() const;
+
+  // Returns a new slot for the cache of an IO thread.
+  size_t AddSlot();
+  // Replaces the entries of `slot` and rewrites the file.
+  void Save(size_t slot, base::Value::List entries);
+
+ private:
+  const base::FilePath path_;
+  NaiveFileWriter writer_;
+  mutable base::Lock lock_;
+  base::Value::List loaded_entries_ GUARDED_BY(lock_);
+  std::vector<base::Value::List> slots_ GUARDED_BY(lock_);
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_HOST_CACHE_STORE_H_
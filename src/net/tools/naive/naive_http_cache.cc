@@ -0,0 +1,229 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_http_cache.h"
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+#include "base/check.h"
+#include "base/containers/flat_set.h"
+#include "base/functional/bind.h"
+#include "base/strings/strcat.h"
+#include "base/strings/string_util.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/request_priority.h"
+#include "net/filter/source_stream.h"
+#include "net/http/http_response_headers.h"
+#include "net/socket/stream_socket.h"
+#include "net/tools/naive/naive_buffer_pool.h"
+#include "net/url_request/redirect_info.h"
+#include "net/url_request/url_request_context.h"
+#include "url/url_constants.h"
+
+namespace net {
+
+namespace {
+// Framing of the connection to the client, which the response is not sent
+// with.
+constexpr std::string_view kHopByHopHeaders[] = {
+    "Connection", "Keep-Alive", "Proxy-Connection", "Transfer-Encoding"};
+
+bool IsHopByHopHeader(std::string_view name) {
+  return std::ranges::any_of(kHopByHopHeaders, [&](std::string_view header) {
+    return base::EqualsCaseInsensitiveASCII(name, header);
+  });
+}
+}  // namespace
+
+NaiveHttpCache::NaiveHttpCache(const URLRequestContext* context,
+                               std::vector<std::string> hosts)
+    : context_(context), hosts_(std::move(hosts)) {}
+
+NaiveHttpCache::~NaiveHttpCache() = default;
+
+bool NaiveHttpCache::ShouldCache(const GURL& url) const {
+  if (!url.SchemeIs(url::kHttpScheme)) {
+    return false;
+  }
+  return hosts_.empty() ||
+         std::ranges::any_of(hosts_, [&](const std::string& host) {
+           return url.DomainIs(host);
+         });
+}
+
+NaiveHttpCacheFetch::NaiveHttpCacheFetch(
+    NaiveHttpCache* cache,
+    const GURL& url,
+    const HttpRequestHeaders& headers,
+    StreamSocket* client_socket,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : cache_(cache),
+      client_socket_(client_socket),
+      traffic_annotation_(traffic_annotation),
+      last_activity_time_(base::TimeTicks::Now()) {
+  request_ = cache_->context()->CreateRequest(url, DEFAULT_PRIORITY, this,
+                                              traffic_annotation);
+  // The cookies and credentials of the client are its own headers.
+  request_->set_allow_credentials(false);
+  // The body is passed on as received, in an encoding the client accepts.
+  request_->set_accepted_stream_types(
+      base::flat_set<SourceStream::SourceType>());
+  request_->SetExtraRequestHeaders(headers);
+}
+
+NaiveHttpCacheFetch::~NaiveHttpCacheFetch() = default;
+
+int NaiveHttpCacheFetch::Run(CompletionOnceCallback callback) {
+  DCHECK(!callback_);
+  callback_ = std::move(callback);
+  cache_->stats_.requests++;
+  request_->Start();
+  return ERR_IO_PENDING;
+}
+
+void NaiveHttpCacheFetch::OnReceivedRedirect(URLRequest* request,
+                                             const RedirectInfo& redirect_info,
+                                             bool* defer_redirect) {
+  *defer_redirect = true;
+  WriteHead(/*with_body=*/false);
+}
+
+void NaiveHttpCacheFetch::OnResponseStarted(URLRequest* request,
+                                            int net_error) {
+  if (net_error != OK) {
+    Finish(net_error);
+    return;
+  }
+  WriteHead(/*with_body=*/true);
+}
+
+void NaiveHttpCacheFetch::OnReadCompleted(URLRequest* request,
+                                          int bytes_read) {
+  if (bytes_read <= 0) {
+    Finish(bytes_read);
+    return;
+  }
+  body_bytes_ += bytes_read;
+  write_buffer_ = base::MakeRefCounted<DrainableIOBuffer>(
+      std::move(read_buffer_), bytes_read);
+  if (Write()) {
+    ReadBody();
+  }
+}
+
+void NaiveHttpCacheFetch::WriteHead(bool with_body) {
+  const HttpResponseHeaders* headers = request_->response_headers();
+  if (!headers) {
+    Finish(ERR_EMPTY_RESPONSE);
+    return;
+  }
+  std::string head = base::StrCat({headers->GetStatusLine(), "\r\n"});
+  size_t iter = 0;
+  std::string name;
+  std::string value;
+  while (headers->EnumerateHeaderLines(&iter, &name, &value)) {
+    if (IsHopByHopHeader(name) ||
+        (!with_body && base::EqualsCaseInsensitiveASCII(
+                           name, HttpRequestHeaders::kContentLength))) {
+      continue;
+    }
+    base::StrAppend(&head, {name, ": ", value, "\r\n"});
+  }
+  if (!with_body) {
+    head.append("Content-Length: 0\r\n");
+  }
+  // Without Transfer-Encoding the body runs to the end of the connection
+  // unless it has a Content-Length.
+  head.append("Connection: close\r\n\r\n");
+
+  with_body_ = with_body;
+  auto buffer = base::MakeRefCounted<StringIOBuffer>(std::move(head));
+  int size = buffer->size();
+  write_buffer_ =
+      base::MakeRefCounted<DrainableIOBuffer>(std::move(buffer), size);
+  if (Write()) {
+    OnWritten();
+  }
+}
+
+void NaiveHttpCacheFetch::ReadBody() {
+  for (;;) {
+    read_buffer_ = NaiveBufferPool::Acquire(NaiveBufferPool::kBufferSize);
+    int rv = request_->Read(read_buffer_.get(), NaiveBufferPool::kBufferSize);
+    if (rv == ERR_IO_PENDING) {
+      return;
+    }
+    if (rv <= 0) {
+      read_buffer_ = nullptr;
+      Finish(rv);
+      return;
+    }
+    body_bytes_ += rv;
+    write_buffer_ = base::MakeRefCounted<DrainableIOBuffer>(
+        std::move(read_buffer_), rv);
+    if (!Write()) {
+      return;
+    }
+  }
+}
+
+bool NaiveHttpCacheFetch::Write() {
+  while (write_buffer_->BytesRemaining() > 0) {
+    int result = client_socket_->Write(
+        write_buffer_.get(), write_buffer_->BytesRemaining(),
+        base::BindOnce(&NaiveHttpCacheFetch::OnWriteComplete,
+                       base::Unretained(this)),
+        traffic_annotation_);
+    if (result == ERR_IO_PENDING) {
+      return false;
+    }
+    if (result < 0) {
+      Finish(result);
+      return false;
+    }
+    DidWrite(result);
+  }
+  write_buffer_ = nullptr;
+  return true;
+}
+
+void NaiveHttpCacheFetch::DidWrite(int result) {
+  bytes_written_ += result;
+  last_activity_time_ = base::TimeTicks::Now();
+  write_buffer_->DidConsume(result);
+}
+
+void NaiveHttpCacheFetch::OnWriteComplete(int result) {
+  if (result < 0) {
+    Finish(result);
+    return;
+  }
+  DidWrite(result);
+  if (Write()) {
+    OnWritten();
+  }
+}
+
+void NaiveHttpCacheFetch::OnWritten() {
+  if (!with_body_) {
+    Finish(OK);
+    return;
+  }
+  ReadBody();
+}
+
+void NaiveHttpCacheFetch::Finish(int result) {
+  if (result == OK && request_->was_cached()) {
+    cache_->stats_.hits++;
+    cache_->stats_.saved_bytes += static_cast<uint64_t>(std::max<int64_t>(
+        body_bytes_ - request_->GetTotalReceivedBytes(), 0));
+  }
+  // Destroying the request here keeps it from calling back.
+  request_ = nullptr;
+  std::move(callback_).Run(result);
+}
+
+}  // namespace net
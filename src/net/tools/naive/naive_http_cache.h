@@ -0,0 +1,124 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_HTTP_CACHE_H_
+#define NET_TOOLS_NAIVE_NAIVE_HTTP_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/time/time.h"
+#include "net/base/completion_once_callback.h"
+#include "net/http/http_request_headers.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "net/url_request/url_request.h"
+#include "url/gurl.h"
+
+namespace net {
+
+class DrainableIOBuffer;
+class IOBuffer;
+class StreamSocket;
+class URLRequestContext;
+
+// Serves the plain HTTP GETs of http listeners through the HTTP cache of a
+// URLRequestContext, instead of relaying them over a tunnel of their own.
+// The context stores responses in a size capped disk cache, which evicts
+// the least recently used entries.
+class NaiveHttpCache {
+ public:
+  struct Stats {
+    uint64_t requests = 0;
+    // Responses served from the cache, including those revalidated with the
+    // origin.
+    uint64_t hits = 0;
+    // Bytes of the hits not received from the network.
+    uint64_t saved_bytes = 0;
+  };
+
+  // Only GETs to `hosts` and their subdomains are cached, or all if empty.
+  NaiveHttpCache(const URLRequestContext* context,
+                 std::vector<std::string> hosts);
+  NaiveHttpCache(const NaiveHttpCache&) = delete;
+  NaiveHttpCache& operator=(const NaiveHttpCache&) = delete;
+  ~NaiveHttpCache();
+
+  // Returns true if a GET of `url` is served through the cache.
+  bool ShouldCache(const GURL& url) const;
+
+  const URLRequestContext* context() const { return context_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  friend class NaiveHttpCacheFetch;
+
+  const URLRequestContext* const context_;
+  const std::vector<std::string> hosts_;
+  Stats stats_;
+};
+
+// Fetches one GET through a NaiveHttpCache and writes the response to the
+// client, with "Connection: close". The client sends any request after it
+// again on a new connection.
+class NaiveHttpCacheFetch : public URLRequest::Delegate {
+ public:
+  // `headers` are those of the client without the hop-by-hop and proxy
+  // headers. `client_socket` must outlive the fetch.
+  NaiveHttpCacheFetch(NaiveHttpCache* cache,
+                      const GURL& url,
+                      const HttpRequestHeaders& headers,
+                      StreamSocket* client_socket,
+                      const NetworkTrafficAnnotationTag& traffic_annotation);
+  NaiveHttpCacheFetch(const NaiveHttpCacheFetch&) = delete;
+  NaiveHttpCacheFetch& operator=(const NaiveHttpCacheFetch&) = delete;
+  ~NaiveHttpCacheFetch() override;
+
+  // Starts the request. Returns ERR_IO_PENDING and invokes `callback` with
+  // OK once the response is written, or with the error.
+  int Run(CompletionOnceCallback callback);
+
+  base::TimeTicks last_activity_time() const { return last_activity_time_; }
+  // Bytes of the response written to the client.
+  int64_t bytes_written() const { return bytes_written_; }
+
+  // URLRequest::Delegate implementation:
+  void OnReceivedRedirect(URLRequest* request,
+                          const RedirectInfo& redirect_info,
+                          bool* defer_redirect) override;
+  void OnResponseStarted(URLRequest* request, int net_error) override;
+  void OnReadCompleted(URLRequest* request, int bytes_read) override;
+
+ private:
+  // Writes the status line and headers of the response. Redirects are
+  // passed on to the client without their body, rather than followed.
+  void WriteHead(bool with_body);
+  void ReadBody();
+  // Writes the bytes left in write_buffer_. Returns true if all of them were
+  // written synchronously. Otherwise OnWriteComplete() or Finish() follows.
+  bool Write();
+  void DidWrite(int result);
+  void OnWriteComplete(int result);
+  // Reads the body once the head is written, and each chunk of it.
+  void OnWritten();
+  void Finish(int result);
+
+  NaiveHttpCache* const cache_;
+  StreamSocket* const client_socket_;
+  const NetworkTrafficAnnotationTag traffic_annotation_;
+  std::unique_ptr<URLRequest> request_;
+  CompletionOnceCallback callback_;
+
+  scoped_refptr<IOBuffer> read_buffer_;
+  scoped_refptr<DrainableIOBuffer> write_buffer_;
+  // Whether the body follows the head being written.
+  bool with_body_ = false;
+  int64_t body_bytes_ = 0;
+  int64_t bytes_written_ = 0;
+  base::TimeTicks last_activity_time_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_HTTP_CACHE_H_
@@ -0,0 +1,150 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_memory_pressure_monitor.h"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/functional/bind.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/task/thread_pool.h"
+#include "build/build_config.h"
+
+namespace net {
+namespace {
+
+// Returns the cgroup v2 directory of the process, or an empty path.
+base::FilePath GetCgroupDir() {
+  std::string cgroup;
+  if (!base::ReadFileToString(base::FilePath("/proc/self/cgroup"), &cgroup))
+    return base::FilePath();
+  // The cgroup v2 line is "0::<path>".
+  for (std::string_view line : base::SplitStringPiece(
+           cgroup, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    if (base::StartsWith(line, "0::")) {
+      std::string_view path = line.substr(3);
+      base::FilePath dir("/sys/fs/cgroup");
+      if (path != "/")
+        dir = dir.Append(path.substr(1));
+      return dir;
+    }
+  }
+  return base::FilePath();
+}
+
+std::optional<uint64_t> ReadAvailableBytes(const base::FilePath& cgroup_dir) {
+  std::string meminfo;
+  if (!base::ReadFileToString(base::FilePath("/proc/meminfo"), &meminfo))
+    return std::nullopt;
+  std::optional<uint64_t> available;
+  for (std::string_view line : base::SplitStringPiece(
+           meminfo, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    // "MemAvailable:    123456 kB"
+    if (!base::StartsWith(line, "MemAvailable:"))
+      continue;
+    std::vector<std::string_view> fields = base::SplitStringPiece(
+        line, " ", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+    uint64_t kb;
+    if (fields.size() == 3 && base::StringToUint64(fields[1], &kb))
+      available = kb * 1024;
+    break;
+  }
+  if (!available)
+    return std::nullopt;
+
+  if (cgroup_dir.empty())
+    return available;
+  std::string max_str;
+  std::string current_str;
+  uint64_t max;
+  uint64_t current;
+  // memory.max is "max" without a limit.
+  if (base::ReadFileToString(cgroup_dir.Append("memory.max"), &max_str) &&
+      base::ReadFileToString(cgroup_dir.Append("memory.current"),
+                             &current_str) &&
+      base::StringToUint64(base::TrimWhitespaceASCII(max_str, base::TRIM_ALL),
+                           &max) &&
+      base::StringToUint64(
+          base::TrimWhitespaceASCII(current_str, base::TRIM_ALL), &current)) {
+    available = std::min(*available, max > current ? max - current : 0);
+  }
+  return available;
+}
+
+}  // namespace
+
+NaiveMemoryPressureMonitor::NaiveMemoryPressureMonitor(uint64_t moderate_bytes)
+    : moderate_bytes_(moderate_bytes) {
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, {base::MayBlock()}, base::BindOnce(&GetCgroupDir),
+      base::BindOnce(&NaiveMemoryPressureMonitor::OnCgroupDir,
+                     weak_ptr_factory_.GetWeakPtr()));
+}
+
+NaiveMemoryPressureMonitor::~NaiveMemoryPressureMonitor() = default;
+
+// static
+bool NaiveMemoryPressureMonitor::IsSupported() {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void NaiveMemoryPressureMonitor::OnCgroupDir(base::FilePath cgroup_dir) {
+  cgroup_dir_ = std::move(cgroup_dir);
+  poll_timer_.Start(FROM_HERE, kPollInterval, this,
+                    &NaiveMemoryPressureMonitor::Poll);
+}
+
+void NaiveMemoryPressureMonitor::Poll() {
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, {base::MayBlock(), base::TaskPriority::USER_BLOCKING},
+      base::BindOnce(&ReadAvailableBytes, cgroup_dir_),
+      base::BindOnce(&NaiveMemoryPressureMonitor::OnAvailableBytes,
+                     weak_ptr_factory_.GetWeakPtr()));
+}
+
+void NaiveMemoryPressureMonitor::OnAvailableBytes(
+    std::optional<uint64_t> available) {
+  using Listener = base::MemoryPressureListener;
+  if (!available)
+    return;
+  Listener::MemoryPressureLevel level = Listener::MEMORY_PRESSURE_LEVEL_NONE;
+  if (*available < moderate_bytes_ / 2) {
+    level = Listener::MEMORY_PRESSURE_LEVEL_CRITICAL;
+  } else if (*available < moderate_bytes_) {
+    level = Listener::MEMORY_PRESSURE_LEVEL_MODERATE;
+  }
+  if (level != level_) {
+    LOG(WARNING) << "Memory pressure "
+                 << (level == Listener::MEMORY_PRESSURE_LEVEL_CRITICAL
+                         ? "critical"
+                     : level == Listener::MEMORY_PRESSURE_LEVEL_MODERATE
+                         ? "moderate"
+                         : "none")
+                 << ": available=" << *available;
+  }
+  base::TimeTicks now = base::TimeTicks::Now();
+  bool notify = level == Listener::MEMORY_PRESSURE_LEVEL_CRITICAL;
+  if (level == Listener::MEMORY_PRESSURE_LEVEL_MODERATE) {
+    notify = level_ != level ||
+             now - last_notify_time_ >= kModerateRenotifyInterval;
+  }
+  level_ = level;
+  if (!notify)
+    return;
+  last_notify_time_ = now;
+  Listener::NotifyMemoryPressure(level);
+}
+
+}  // namespace net
@@ -0,0 +1,57 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_MEMORY_PRESSURE_MONITOR_H_
+#define NET_TOOLS_NAIVE_NAIVE_MEMORY_PRESSURE_MONITOR_H_
+
+#include <cstdint>
+#include <optional>
+
+#include "base/files/file_path.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+
+namespace net {
+
+// Notifies base::MemoryPressureListener of memory pressure, which nothing
+// reports to it on Linux, from the memory available to the process:
+// MemAvailable of /proc/meminfo, or less if the cgroup v2 of the process
+// has a memory.max. Pressure is moderate below `moderate_bytes` and
+// critical below half of it. Moderate pressure is notified again every
+// kModerateRenotifyInterval while it lasts, and critical pressure at every
+// poll, so listeners can tell when it ends. The files are read on the
+// ThreadPool. Only supported on Linux.
+class NaiveMemoryPressureMonitor {
+ public:
+  static constexpr base::TimeDelta kPollInterval = base::Seconds(1);
+  static constexpr base::TimeDelta kModerateRenotifyInterval =
+      base::Seconds(10);
+
+  explicit NaiveMemoryPressureMonitor(uint64_t moderate_bytes);
+  ~NaiveMemoryPressureMonitor();
+  NaiveMemoryPressureMonitor(const NaiveMemoryPressureMonitor&) = delete;
+  NaiveMemoryPressureMonitor& operator=(const NaiveMemoryPressureMonitor&) =
+      delete;
+
+  static bool IsSupported();
+
+ private:
+  void OnCgroupDir(base::FilePath cgroup_dir);
+  void Poll();
+  void OnAvailableBytes(std::optional<uint64_t> available);
+
+  const uint64_t moderate_bytes_;
+  // Empty if the process is not in a cgroup v2.
+  base::FilePath cgroup_dir_;
+  base::MemoryPressureListener::MemoryPressureLevel level_ =
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE;
+  base::TimeTicks last_notify_time_;
+  base::RepeatingTimer poll_timer_;
+
+  base::WeakPtrFactory<NaiveMemoryPressureMonitor> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_MEMORY_PRESSURE_MONITOR_H_
@@ -0,0 +1,513 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_metrics.h"
+
+#include <map>
+#include <string_view>
+
+#include "base/notreached.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "net/log/net_log_capture_mode.h"
+#include "net/log/net_log_entry.h"
+#include "net/log/net_log_event_type.h"
+
+namespace net {
+
+namespace {
+std::string EscapeLabel(std::string_view value) {
+  std::string escaped;
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+void AppendHeader(std::string* out,
+                  const char* name,
+                  const char* type,
+                  const char* help) {
+  base::StringAppendF(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name,
+                      type);
+}
+
+void AppendSample(std::string* out,
+                  const char* name,
+                  const std::string& labels,
+                  uint64_t value) {
+  *out += name;
+  if (!labels.empty()) {
+    *out += '{';
+    *out += labels;
+    *out += '}';
+  }
+  *out += ' ';
+  *out += base::NumberToString(value);
+  *out += '\n';
+}
+
+NetLogEventTypeSet GetStallEventTypes() {
+  NetLogEventTypeSet event_types;
+  for (NetLogEventType type : {
+           NetLogEventType::SOCKET_POOL_STALLED_MAX_SOCKETS,
+           NetLogEventType::SOCKET_POOL_STALLED_MAX_SOCKETS_PER_GROUP,
+           NetLogEventType::
+               HTTP2_SESSION_STREAM_STALLED_BY_SESSION_SEND_WINDOW,
+           NetLogEventType::
+               HTTP2_SESSION_STREAM_STALLED_BY_STREAM_SEND_WINDOW,
+           NetLogEventType::HTTP2_SESSION_STALLED_MAX_STREAMS,
+           NetLogEventType::QUIC_SESSION_BLOCKED_FRAME_RECEIVED,
+           NetLogEventType::QUIC_SESSION_BLOCKED_FRAME_SENT,
+       }) {
+    event_types.set(static_cast<size_t>(type));
+  }
+  return event_types;
+}
+
+void AppendHeavyHitters(
+    std::string* out,
+    const char* name,
+    const char* help,
+    const char* key_label,
+    const std::map<std::string, NaiveListenerMetrics>& listeners,
+    NaiveHeavyHitters NaiveListenerMetrics::*field) {
+  AppendHeader(out, name, "gauge", help);
+  for (const auto& [listener_name, listener] : listeners) {
+    for (const auto& [key, counter] : (listener.*field).counters()) {
+      AppendSample(out, name,
+                   "listener=\"" + EscapeLabel(listener_name) + "\"," +
+                       key_label + "=\"" + EscapeLabel(key) + "\"",
+                   counter.count);
+    }
+  }
+}
+}  // namespace
+
+// static
+base::TimeDelta NaiveLatencyHistogram::GetBound(size_t i) {
+  size_t octave = i / kSubBuckets;
+  size_t sub_bucket = i % kSubBuckets;
+  return base::Microseconds((int64_t{1000} << octave) *
+                            static_cast<int64_t>(kSubBuckets + sub_bucket + 1) /
+                            static_cast<int64_t>(kSubBuckets));
+}
+
+void NaiveLatencyHistogram::Add(base::TimeDelta latency) {
+  size_t i = 0;
+  while (i < kNumBounds && latency > GetBound(i)) {
+    ++i;
+  }
+  counts[i]++;
+  sum += latency;
+}
+
+void NaiveLatencyHistogram::Merge(const NaiveLatencyHistogram& other) {
+  for (size_t i = 0; i < counts.size(); ++i) {
+    counts[i] += other.counts[i];
+  }
+  sum += other.sum;
+}
+
+// static
+const char* NaiveListenerMetrics::GetSetupPhaseName(SetupPhase phase) {
+  switch (phase) {
+    case kClientHandshake:
+      return "client_handshake";
+    case kRequest:
+      return "request";
+    case kConnect:
+      return "connect";
+    case kFirstUpload:
+      return "first_upload";
+    case kFirstDownload:
+      return "first_download";
+    case kNumSetupPhases:
+      break;
+  }
+  NOTREACHED();
+  return "";
+}
+
+NaiveListenerMetrics::NaiveListenerMetrics() = default;
+NaiveListenerMetrics::NaiveListenerMetrics(const NaiveListenerMetrics&) =
+    default;
+NaiveListenerMetrics& NaiveListenerMetrics::operator=(
+    const NaiveListenerMetrics&) = default;
+NaiveListenerMetrics::~NaiveListenerMetrics() = default;
+
+void NaiveListenerMetrics::AddConnectLatency(base::TimeDelta latency) {
+  size_t i = 0;
+  while (i < kConnectLatencyBucketsMs.size() &&
+         latency > base::Milliseconds(kConnectLatencyBucketsMs[i])) {
+    ++i;
+  }
+  connect_latency_counts[i]++;
+  connect_latency_sum += latency;
+}
+
+void NaiveListenerMetrics::Merge(const NaiveListenerMetrics& other) {
+  accepted += other.accepted;
+  cpu_checked_accepted += other.cpu_checked_accepted;
+  cross_cpu_accepted += other.cross_cpu_accepted;
+  active += other.active;
+  connect_failures += other.connect_failures;
+  for (size_t i = 0; i < relayed_bytes.size(); ++i) {
+    relayed_bytes[i] += other.relayed_bytes[i];
+  }
+  for (size_t i = 0; i < connect_latency_counts.size(); ++i) {
+    connect_latency_counts[i] += other.connect_latency_counts[i];
+  }
+  connect_latency_sum += other.connect_latency_sum;
+  for (size_t i = 0; i < setup_phase_latencies.size(); ++i) {
+    setup_phase_latencies[i].Merge(other.setup_phase_latencies[i]);
+  }
+  for (const auto& [name, user] : other.users) {
+    UserMetrics& merged = users[name];
+    merged.connections += user.connections;
+    for (size_t i = 0; i < merged.relayed_bytes.size(); ++i) {
+      merged.relayed_bytes[i] += user.relayed_bytes[i];
+    }
+  }
+  top_destination_bytes.Merge(other.top_destination_bytes);
+  top_destination_tunnels.Merge(other.top_destination_tunnels);
+  top_user_bytes.Merge(other.top_user_bytes);
+  top_user_tunnels.Merge(other.top_user_tunnels);
+}
+
+NaiveMetrics::NaiveMetrics() = default;
+NaiveMetrics::NaiveMetrics(NaiveMetrics&&) = default;
+NaiveMetrics& NaiveMetrics::operator=(NaiveMetrics&&) = default;
+NaiveMetrics::~NaiveMetrics() = default;
+
+void NaiveMetrics::Merge(const NaiveMetrics& other) {
+  for (const auto& [name, listener] : other.listeners) {
+    listeners[name].Merge(listener);
+  }
+  for (const auto& [chain, sessions] : other.session_connections) {
+    for (const auto& [session, connections] : sessions) {
+      session_connections[chain][session] += connections;
+    }
+  }
+  padding_bytes_written += other.padding_bytes_written;
+  padding_bytes_read += other.padding_bytes_read;
+  compressed_tunnels += other.compressed_tunnels;
+  compression_ratio_sum += other.compression_ratio_sum;
+  compression_payload_bytes += other.compression_payload_bytes;
+  compression_frame_bytes += other.compression_frame_bytes;
+  idle_pool_sockets += other.idle_pool_sockets;
+  stalled_pools += other.stalled_pools;
+  resolver_mappings += other.resolver_mappings;
+  dns_udp_queries += other.dns_udp_queries;
+  dns_udp_sockets += other.dns_udp_sockets;
+  tcp_rtt_samples += other.tcp_rtt_samples;
+  tcp_rtt_sum += other.tcp_rtt_sum;
+  tcp_segments_sent += other.tcp_segments_sent;
+  tcp_segments_retransmitted += other.tcp_segments_retransmitted;
+  tcp_congestion_window += other.tcp_congestion_window;
+  quic_ack_frames_sent += other.quic_ack_frames_sent;
+  quic_bytes_received += other.quic_bytes_received;
+  http_cache_requests += other.http_cache_requests;
+  http_cache_hits += other.http_cache_hits;
+  http_cache_saved_bytes += other.http_cache_saved_bytes;
+  http2_stalls += other.http2_stalls;
+  quic_blocked_frames += other.quic_blocked_frames;
+  socket_pool_stalls += other.socket_pool_stalls;
+}
+
+std::string NaiveMetrics::ToPrometheusText() const {
+  std::string out;
+
+  AppendHeader(&out, "naive_connections_accepted_total", "counter",
+               "Connections accepted by the listener.");
+  for (const auto& [name, listener] : listeners) {
+    AppendSample(&out, "naive_connections_accepted_total",
+                 "listener=\"" + EscapeLabel(name) + "\"", listener.accepted);
+  }
+  AppendHeader(&out, "naive_connections_cpu_checked_total", "counter",
+               "Accepted connections whose incoming CPU is known.");
+  for (const auto& [name, listener] : listeners) {
+    AppendSample(&out, "naive_connections_cpu_checked_total",
+                 "listener=\"" + EscapeLabel(name) + "\"",
+                 listener.cpu_checked_accepted);
+  }
+  AppendHeader(&out, "naive_connections_cross_cpu_total", "counter",
+               "Accepted connections whose packets were received on another "
+               "CPU than the one accepting them.");
+  for (const auto& [name, listener] : listeners) {
+    AppendSample(&out, "naive_connections_cross_cpu_total",
+                 "listener=\"" + EscapeLabel(name) + "\"",
+                 listener.cross_cpu_accepted);
+  }
+  AppendHeader(&out, "naive_connections_active", "gauge",
+               "Open connections of the listener.");
+  for (const auto& [name, listener] : listeners) {
+    AppendSample(&out, "naive_connections_active",
+                 "listener=\"" + EscapeLabel(name) + "\"", listener.active);
+  }
+  AppendHeader(&out, "naive_connect_failures_total", "counter",
+               "Tunnels whose server side failed to connect.");
+  for (const auto& [name, listener] : listeners) {
+    AppendSample(&out, "naive_connect_failures_total",
+                 "listener=\"" + EscapeLabel(name) + "\"",
+                 listener.connect_failures);
+  }
+  AppendHeader(&out, "naive_relayed_bytes_total", "counter",
+               "Bytes relayed, by the side they were read from.");
+  for (const auto& [name, listener] : listeners) {
+    std::string label = "listener=\"" + EscapeLabel(name) + "\"";
+    AppendSample(&out, "naive_relayed_bytes_total",
+                 label + ",direction=\"upload\"",
+                 listener.relayed_bytes[kClient]);
+    AppendSample(&out, "naive_relayed_bytes_total",
+                 label + ",direction=\"download\"",
+                 listener.relayed_bytes[kServer]);
+  }
+  AppendHeader(&out, "naive_connect_latency_seconds", "histogram",
+               "Time to connect the server side of tunnels.");
+  for (const auto& [name, listener] : listeners) {
+    std::string label = "listener=\"" + EscapeLabel(name) + "\"";
+    uint64_t count = 0;
+    for (size_t i = 0; i < listener.connect_latency_counts.size(); ++i) {
+      count += listener.connect_latency_counts[i];
+      std::string le =
+          i < NaiveListenerMetrics::kConnectLatencyBucketsMs.size()
+              ? base::NumberToString(
+                    NaiveListenerMetrics::kConnectLatencyBucketsMs[i] /
+                    1000.0)
+              : "+Inf";
+      AppendSample(&out, "naive_connect_latency_seconds_bucket",
+                   label + ",le=\"" + le + "\"", count);
+    }
+    base::StringAppendF(&out, "naive_connect_latency_seconds_sum{%s} %f\n",
+                        label.c_str(),
+                        listener.connect_latency_sum.InSecondsF());
+    AppendSample(&out, "naive_connect_latency_seconds_count", label, count);
+  }
+
+  AppendHeader(&out, "naive_setup_phase_seconds", "histogram",
+               "Time of each step of setting up tunnels that connected.");
+  for (const auto& [name, listener] : listeners) {
+    for (size_t phase = 0; phase < listener.setup_phase_latencies.size();
+         ++phase) {
+      const NaiveLatencyHistogram& histogram =
+          listener.setup_phase_latencies[phase];
+      std::string label =
+          "listener=\"" + EscapeLabel(name) + "\",phase=\"" +
+          NaiveListenerMetrics::GetSetupPhaseName(
+              static_cast<NaiveListenerMetrics::SetupPhase>(phase)) +
+          "\"";
+      uint64_t count = 0;
+      for (size_t i = 0; i < histogram.counts.size(); ++i) {
+        count += histogram.counts[i];
+        std::string le =
+            i < NaiveLatencyHistogram::kNumBounds
+                ? base::NumberToString(
+                      NaiveLatencyHistogram::GetBound(i).InSecondsF())
+                : "+Inf";
+        AppendSample(&out, "naive_setup_phase_seconds_bucket",
+                     label + ",le=\"" + le + "\"", count);
+      }
+      base::StringAppendF(&out, "naive_setup_phase_seconds_sum{%s} %f\n",
+                          label.c_str(), histogram.sum.InSecondsF());
+      AppendSample(&out, "naive_setup_phase_seconds_count", label, count);
+    }
+  }
+
+  AppendHeader(&out, "naive_user_connections_total", "counter",
+               "Connections of each authenticated user.");
+  for (const auto& [name, listener] : listeners) {
+    for (const auto& [user_name, user] : listener.users) {
+      AppendSample(&out, "naive_user_connections_total",
+                   "listener=\"" + EscapeLabel(name) + "\",user=\"" +
+                       EscapeLabel(user_name) + "\"",
+                   user.connections);
+    }
+  }
+  AppendHeader(&out, "naive_user_relayed_bytes_total", "counter",
+               "Bytes relayed for each authenticated user, by the side they "
+               "were read from.");
+  for (const auto& [name, listener] : listeners) {
+    for (const auto& [user_name, user] : listener.users) {
+      std::string label = "listener=\"" + EscapeLabel(name) + "\",user=\"" +
+                          EscapeLabel(user_name) + "\"";
+      AppendSample(&out, "naive_user_relayed_bytes_total",
+                   label + ",direction=\"upload\"",
+                   user.relayed_bytes[kClient]);
+      AppendSample(&out, "naive_user_relayed_bytes_total",
+                   label + ",direction=\"download\"",
+                   user.relayed_bytes[kServer]);
+    }
+  }
+
+  AppendHeavyHitters(&out, "naive_top_destination_bytes",
+                     "Estimated bytes relayed for the destination hosts with "
+                     "the most, both ways.",
+                     "destination", listeners,
+                     &NaiveListenerMetrics::top_destination_bytes);
+  AppendHeavyHitters(&out, "naive_top_destination_tunnels",
+                     "Estimated tunnels to the destination hosts with the "
+                     "most.",
+                     "destination", listeners,
+                     &NaiveListenerMetrics::top_destination_tunnels);
+  AppendHeavyHitters(&out, "naive_top_user_bytes",
+                     "Estimated bytes relayed for the authenticated users "
+                     "with the most, both ways.",
+                     "user", listeners,
+                     &NaiveListenerMetrics::top_user_bytes);
+  AppendHeavyHitters(&out, "naive_top_user_tunnels",
+                     "Estimated tunnels of the authenticated users with the "
+                     "most.",
+                     "user", listeners,
+                     &NaiveListenerMetrics::top_user_tunnels);
+
+  AppendHeader(&out, "naive_session_connections", "gauge",
+               "Open connections carried over each tunnel session.");
+  for (const auto& [chain, sessions] : session_connections) {
+    for (const auto& [session, connections] : sessions) {
+      AppendSample(&out, "naive_session_connections",
+                   "chain=\"" + EscapeLabel(chain) + "\",session=\"" +
+                       base::NumberToString(session) + "\"",
+                   connections);
+    }
+  }
+
+  AppendHeader(&out, "naive_padding_bytes_total", "counter",
+               "Padding bytes of closed padded connections.");
+  AppendSample(&out, "naive_padding_bytes_total", "direction=\"written\"",
+               padding_bytes_written);
+  AppendSample(&out, "naive_padding_bytes_total", "direction=\"read\"",
+               padding_bytes_read);
+
+  AppendHeader(&out, "naive_compression_ratio", "summary",
+               "Payload over compressed bytes of closed compressed tunnels.");
+  base::StringAppendF(&out, "naive_compression_ratio_sum %f\n",
+                      compression_ratio_sum);
+  AppendSample(&out, "naive_compression_ratio_count", "", compressed_tunnels);
+  AppendHeader(&out, "naive_compression_bytes_total", "counter",
+               "Bytes of closed compressed tunnels, both ways.");
+  AppendSample(&out, "naive_compression_bytes_total", "stage=\"payload\"",
+               compression_payload_bytes);
+  AppendSample(&out, "naive_compression_bytes_total", "stage=\"compressed\"",
+               compression_frame_bytes);
+
+  AppendHeader(&out, "naive_http2_stalls_total", "counter",
+               "HTTP/2 streams stalled by flow control or stream limits.");
+  AppendSample(&out, "naive_http2_stalls_total", "", http2_stalls);
+  AppendHeader(&out, "naive_quic_blocked_frames_total", "counter",
+               "QUIC BLOCKED frames sent and received.");
+  AppendSample(&out, "naive_quic_blocked_frames_total", "",
+               quic_blocked_frames);
+
+  AppendHeader(&out, "naive_tcp_rtt_seconds", "summary",
+               "RTTs of TCP connections, sampled from TCP_INFO.");
+  base::StringAppendF(&out, "naive_tcp_rtt_seconds_sum %f\n",
+                      tcp_rtt_sum.InSecondsF());
+  AppendSample(&out, "naive_tcp_rtt_seconds_count", "", tcp_rtt_samples);
+  AppendHeader(&out, "naive_tcp_segments_total", "counter",
+               "Segments sent and retransmitted by TCP connections.");
+  AppendSample(&out, "naive_tcp_segments_total", "type=\"sent\"",
+               tcp_segments_sent);
+  AppendSample(&out, "naive_tcp_segments_total", "type=\"retransmitted\"",
+               tcp_segments_retransmitted);
+  AppendHeader(&out, "naive_tcp_congestion_window_segments", "gauge",
+               "Congestion windows of the open TCP connections, summed.");
+  AppendSample(&out, "naive_tcp_congestion_window_segments", "",
+               tcp_congestion_window);
+
+  AppendHeader(&out, "naive_quic_ack_frames_sent_total", "counter",
+               "ACK frames sent by QUIC proxy sessions.");
+  AppendSample(&out, "naive_quic_ack_frames_sent_total", "",
+               quic_ack_frames_sent);
+  AppendHeader(&out, "naive_quic_received_bytes_total", "counter",
+               "Bytes received by QUIC proxy sessions.");
+  AppendSample(&out, "naive_quic_received_bytes_total", "",
+               quic_bytes_received);
+
+  AppendHeader(&out, "naive_socket_pool_stalls_total", "counter",
+               "Socket requests stalled by the socket pool limits.");
+  AppendSample(&out, "naive_socket_pool_stalls_total", "", socket_pool_stalls);
+  AppendHeader(&out, "naive_socket_pool_idle_sockets", "gauge",
+               "Idle sockets in the socket pools.");
+  AppendSample(&out, "naive_socket_pool_idle_sockets", "", idle_pool_sockets);
+  AppendHeader(&out, "naive_socket_pools_stalled", "gauge",
+               "Socket pools with requests waiting on their limits.");
+  AppendSample(&out, "naive_socket_pools_stalled", "", stalled_pools);
+
+  AppendHeader(&out, "naive_resolver_mappings", "gauge",
+               "Names held by the redirect resolver.");
+  AppendSample(&out, "naive_resolver_mappings", "", resolver_mappings);
+
+  AppendHeader(&out, "naive_dns_udp_queries_total", "counter",
+               "Queries of the built-in resolver over UDP.");
+  AppendSample(&out, "naive_dns_udp_queries_total", "", dns_udp_queries);
+  AppendHeader(&out, "naive_dns_udp_sockets_total", "counter",
+               "UDP sockets opened for queries of the built-in resolver.");
+  AppendSample(&out, "naive_dns_udp_sockets_total", "", dns_udp_sockets);
+  AppendHeader(&out, "naive_dns_udp_queries_per_socket", "gauge",
+               "Queries over UDP per socket opened for them.");
+  base::StringAppendF(
+      &out, "naive_dns_udp_queries_per_socket %f\n",
+      dns_udp_sockets > 0
+          ? static_cast<double>(dns_udp_queries) / dns_udp_sockets
+          : 0.0);
+
+  AppendHeader(&out, "naive_http_cache_requests_total", "counter",
+               "GETs served through the HTTP cache.");
+  AppendSample(&out, "naive_http_cache_requests_total", "",
+               http_cache_requests);
+  AppendHeader(&out, "naive_http_cache_hits_total", "counter",
+               "GETs answered from the HTTP cache.");
+  AppendSample(&out, "naive_http_cache_hits_total", "", http_cache_hits);
+  AppendHeader(&out, "naive_http_cache_saved_bytes_total", "counter",
+               "Response bytes of cache hits not fetched from the network.");
+  AppendSample(&out, "naive_http_cache_saved_bytes_total", "",
+               http_cache_saved_bytes);
+
+  return out;
+}
+
+NaiveStallCounter::NaiveStallCounter() = default;
+
+NaiveStallCounter::~NaiveStallCounter() {
+  if (net_log())
+    net_log()->RemoveObserver(this);
+}
+
+void NaiveStallCounter::StartObserving(NetLog* net_log) {
+  net_log->AddObserver(this, NetLogCaptureMode::kDefault,
+                       GetStallEventTypes());
+}
+
+void NaiveStallCounter::GetCounts(NaiveMetrics* metrics) const {
+  metrics->http2_stalls = http2_stalls_.load(std::memory_order_relaxed);
+  metrics->quic_blocked_frames =
+      quic_blocked_frames_.load(std::memory_order_relaxed);
+  metrics->socket_pool_stalls =
+      socket_pool_stalls_.load(std::memory_order_relaxed);
+}
+
+void NaiveStallCounter::OnAddEntry(const NetLogEntry& entry) {
+  switch (entry.type) {
+    case NetLogEventType::SOCKET_POOL_STALLED_MAX_SOCKETS:
+    case NetLogEventType::SOCKET_POOL_STALLED_MAX_SOCKETS_PER_GROUP:
+      socket_pool_stalls_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    case NetLogEventType::QUIC_SESSION_BLOCKED_FRAME_RECEIVED:
+    case NetLogEventType::QUIC_SESSION_BLOCKED_FRAME_SENT:
+      quic_blocked_frames_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    default:
+      http2_stalls_.fetch_add(1, std::memory_order_relaxed);
+      break;
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,192 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_METRICS_H_
+#define NET_TOOLS_NAIVE_NAIVE_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "base/time/time.h"
+#include "net/log/net_log.h"
+#include "net/tools/naive/naive_heavy_hitters.h"
+#include "net/tools/naive/naive_protocol.h"
+
+namespace net {
+
+// Latencies in buckets whose bounds double every kSubBuckets buckets, as in
+// HDR histograms, so the relative error is the same from milliseconds to
+// minutes.
+struct NaiveLatencyHistogram {
+  static constexpr size_t kSubBuckets = 2;
+  // The bounds go from 1.5 ms up to 2^kOctaves ms.
+  static constexpr size_t kOctaves = 17;
+  static constexpr size_t kNumBounds = kSubBuckets * kOctaves;
+
+  // Returns the upper bound of bucket `i`, below kNumBounds.
+  static base::TimeDelta GetBound(size_t i);
+
+  void Add(base::TimeDelta latency);
+  void Merge(const NaiveLatencyHistogram& other);
+
+  // The last bucket counts latencies above the largest bound.
+  std::array<uint64_t, kNumBounds + 1> counts = {};
+  base::TimeDelta sum;
+};
+
+// Counters of one listener. Each NaiveProxy keeps its own with plain
+// integers, written on its thread only, and copies them out on request.
+struct NaiveListenerMetrics {
+  // Upper bounds of the connect latency buckets.
+  static constexpr std::array<int, 9> kConnectLatencyBucketsMs = {
+      10, 25, 50, 100, 250, 500, 1000, 2500, 5000};
+
+  // Counters of the connections of one authenticated user, closed and open.
+  struct UserMetrics {
+    uint64_t connections = 0;
+    // Indexed by the side the bytes were read from.
+    std::array<uint64_t, kNumDirections> relayed_bytes = {};
+  };
+
+  // The steps of setting up a tunnel, each timed from the end of the one
+  // before.
+  enum SetupPhase {
+    // From accepting the connection to the end of the client handshake,
+    // which reads the request and detects padding.
+    kClientHandshake,
+    // To starting to connect the server side.
+    kRequest,
+    // To the tunnel being up: socket pool, proxy CONNECT or origin connect.
+    kConnect,
+    // From the tunnel being up to the first bytes written to each side.
+    kFirstUpload,
+    kFirstDownload,
+    kNumSetupPhases,
+  };
+  static const char* GetSetupPhaseName(SetupPhase phase);
+
+  NaiveListenerMetrics();
+  NaiveListenerMetrics(const NaiveListenerMetrics&);
+  NaiveListenerMetrics& operator=(const NaiveListenerMetrics&);
+  ~NaiveListenerMetrics();
+
+  void AddConnectLatency(base::TimeDelta latency);
+  void Merge(const NaiveListenerMetrics& other);
+
+  uint64_t accepted = 0;
+  // Of the accepted connections whose incoming CPU is known, and of those,
+  // the ones received on another CPU than the one accepting them.
+  uint64_t cpu_checked_accepted = 0;
+  uint64_t cross_cpu_accepted = 0;
+  uint64_t active = 0;
+  // Tunnels whose server side failed to connect.
+  uint64_t connect_failures = 0;
+  // Indexed by the side the bytes were read from.
+  std::array<uint64_t, kNumDirections> relayed_bytes = {};
+  // The last bucket counts latencies above the largest bound.
+  std::array<uint64_t, kConnectLatencyBucketsMs.size() + 1>
+      connect_latency_counts = {};
+  base::TimeDelta connect_latency_sum;
+  // Of tunnels that connected. The first bytes are counted as tunnels
+  // close.
+  std::array<NaiveLatencyHistogram, kNumSetupPhases> setup_phase_latencies;
+  // Keyed by user name. Only users that connected are present.
+  std::map<std::string, UserMetrics> users;
+  // The destination hosts and authenticated users with the most bytes
+  // relayed both ways, and with the most tunnels, in bounded memory.
+  NaiveHeavyHitters top_destination_bytes;
+  NaiveHeavyHitters top_destination_tunnels;
+  NaiveHeavyHitters top_user_bytes;
+  NaiveHeavyHitters top_user_tunnels;
+};
+
+// A snapshot of the metrics of one IO thread, or of all of them once merged.
+struct NaiveMetrics {
+  NaiveMetrics();
+  NaiveMetrics(NaiveMetrics&&);
+  NaiveMetrics& operator=(NaiveMetrics&&);
+  ~NaiveMetrics();
+
+  void Merge(const NaiveMetrics& other);
+
+  // Formats the metrics in the Prometheus text exposition format.
+  std::string ToPrometheusText() const;
+
+  // Keyed by the listen URL, the same on every thread sharing a listener.
+  std::map<std::string, NaiveListenerMetrics> listeners;
+  // Active connections keyed by proxy chain and then tunnel session index.
+  std::map<std::string, std::map<size_t, uint64_t>> session_connections;
+
+  uint64_t padding_bytes_written = 0;
+  uint64_t padding_bytes_read = 0;
+
+  // Of closed compressed tunnels. The ratio of a tunnel is its payload
+  // bytes over its compressed frame bytes.
+  uint64_t compressed_tunnels = 0;
+  double compression_ratio_sum = 0;
+  uint64_t compression_payload_bytes = 0;
+  uint64_t compression_frame_bytes = 0;
+
+  uint64_t idle_pool_sockets = 0;
+  uint64_t stalled_pools = 0;
+
+  uint64_t resolver_mappings = 0;
+
+  // Process-wide, from DnsUdpSocketPool, of the queries of the built-in
+  // resolver over UDP and of the sockets opened for them.
+  uint64_t dns_udp_queries = 0;
+  uint64_t dns_udp_sockets = 0;
+
+  // From NaiveSocketWatcherFactory, of the TCP connections of the contexts.
+  uint64_t tcp_rtt_samples = 0;
+  base::TimeDelta tcp_rtt_sum;
+  uint64_t tcp_segments_sent = 0;
+  uint64_t tcp_segments_retransmitted = 0;
+  uint64_t tcp_congestion_window = 0;
+
+  // Of the QUIC proxy sessions of the contexts, closed and open. ACK frames
+  // sent per received megabyte measure the reverse path packet rate.
+  uint64_t quic_ack_frames_sent = 0;
+  uint64_t quic_bytes_received = 0;
+
+  // From NaiveHttpCache. The hit ratio is hits over requests.
+  uint64_t http_cache_requests = 0;
+  uint64_t http_cache_hits = 0;
+  uint64_t http_cache_saved_bytes = 0;
+
+  // Process-wide, from NaiveStallCounter.
+  uint64_t http2_stalls = 0;
+  uint64_t quic_blocked_frames = 0;
+  uint64_t socket_pool_stalls = 0;
+};
+
+// Counts the NetLog events of HTTP/2 and QUIC flow control stalls and of
+// socket pool stalls. Only these event types are observed, so NetLog builds
+// no parameters for the others.
+class NaiveStallCounter : public NetLog::ThreadSafeObserver {
+ public:
+  NaiveStallCounter();
+  NaiveStallCounter(const NaiveStallCounter&) = delete;
+  NaiveStallCounter& operator=(const NaiveStallCounter&) = delete;
+  ~NaiveStallCounter() override;
+
+  void StartObserving(NetLog* net_log);
+
+  // Copies the counts into `metrics`.
+  void GetCounts(NaiveMetrics* metrics) const;
+
+  // NetLog::ThreadSafeObserver:
+  void OnAddEntry(const NetLogEntry& entry) override;
+
+ private:
+  std::atomic<uint64_t> http2_stalls_ = 0;
+  std::atomic<uint64_t> quic_blocked_frames_ = 0;
+  std::atomic<uint64_t> socket_pool_stalls_ = 0;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_METRICS_H_
@@ -0,0 +1,210 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_metrics_server.h"
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/socket/server_socket.h"
+#include "net/socket/stream_socket.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+
+namespace net {
+
+namespace {
+constexpr int kMaxRequestSize = 4096;
+constexpr int kRequestTimeoutSeconds = 10;
+constexpr std::string_view kHeaderEnd = "\r\n\r\n";
+}  // namespace
+
+// Reads one request, ignoring its contents beyond the end of its header, and
+// writes the metrics back.
+class NaiveMetricsServer::Request {
+ public:
+  Request(std::unique_ptr<StreamSocket> socket,
+          NaiveMetricsServer* server,
+          const NetworkTrafficAnnotationTag& traffic_annotation)
+      : socket_(std::move(socket)),
+        server_(server),
+        traffic_annotation_(traffic_annotation),
+        read_buffer_(base::MakeRefCounted<GrowableIOBuffer>()) {
+    read_buffer_->SetCapacity(kMaxRequestSize);
+  }
+  ~Request() = default;
+  Request(const Request&) = delete;
+  Request& operator=(const Request&) = delete;
+
+  void Start() {
+    timeout_timer_.Start(FROM_HERE, base::Seconds(kRequestTimeoutSeconds),
+                         base::BindOnce(&Request::Finish,
+                                        weak_ptr_factory_.GetWeakPtr()));
+    DoRead();
+  }
+
+ private:
+  void DoRead() {
+    int rv;
+    do {
+      rv = socket_->Read(read_buffer_.get(), read_buffer_->RemainingCapacity(),
+                         base::BindOnce(&Request::OnReadComplete,
+                                        weak_ptr_factory_.GetWeakPtr()));
+      if (rv == ERR_IO_PENDING)
+        return;
+    } while (HandleReadResult(rv));
+  }
+
+  void OnReadComplete(int result) {
+    if (HandleReadResult(result))
+      DoRead();
+  }
+
+  // Returns true if more of the request is to be read.
+  bool HandleReadResult(int result) {
+    if (result <= 0) {
+      Finish();
+      return false;
+    }
+    read_buffer_->set_offset(read_buffer_->offset() + result);
+    std::string_view request(read_buffer_->StartOfBuffer(),
+                             read_buffer_->offset());
+    if (request.find(kHeaderEnd) == std::string_view::npos &&
+        read_buffer_->RemainingCapacity() > 0) {
+      return true;
+    }
+    server_->collect_callback_.Run(base::BindOnce(
+        &Request::OnMetricsCollected, weak_ptr_factory_.GetWeakPtr()));
+    return false;
+  }
+
+  void OnMetricsCollected(NaiveMetrics metrics) {
+    std::string body = metrics.ToPrometheusText();
+    std::string response =
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " +
+        base::NumberToString(body.size()) +
+        "\r\n"
+        "Connection: close\r\n"
+        "\r\n" +
+        body;
+    int size = response.size();
+    write_buffer_ = base::MakeRefCounted<DrainableIOBuffer>(
+        base::MakeRefCounted<StringIOBuffer>(std::move(response)), size);
+    DoWrite();
+  }
+
+  void DoWrite() {
+    int rv;
+    do {
+      rv = socket_->Write(write_buffer_.get(),
+                          write_buffer_->BytesRemaining(),
+                          base::BindOnce(&Request::OnWriteComplete,
+                                         weak_ptr_factory_.GetWeakPtr()),
+                          traffic_annotation_);
+      if (rv == ERR_IO_PENDING)
+        return;
+    } while (HandleWriteResult(rv));
+  }
+
+  void OnWriteComplete(int result) {
+    if (HandleWriteResult(result))
+      DoWrite();
+  }
+
+  // Returns true if more of the response is to be written.
+  bool HandleWriteResult(int result) {
+    if (result < 0) {
+      Finish();
+      return false;
+    }
+    write_buffer_->DidConsume(result);
+    if (write_buffer_->BytesRemaining() > 0)
+      return true;
+    Finish();
+    return false;
+  }
+
+  void Finish() {
+    weak_ptr_factory_.InvalidateWeakPtrs();
+    timeout_timer_.Stop();
+    // The call stack still holds this request, so it is deleted later.
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&NaiveMetricsServer::OnRequestComplete,
+                       server_->weak_ptr_factory_.GetWeakPtr(), this));
+  }
+
+  std::unique_ptr<StreamSocket> socket_;
+  NaiveMetricsServer* server_;
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+  scoped_refptr<GrowableIOBuffer> read_buffer_;
+  scoped_refptr<DrainableIOBuffer> write_buffer_;
+  base::OneShotTimer timeout_timer_;
+
+  base::WeakPtrFactory<Request> weak_ptr_factory_{this};
+};
+
+NaiveMetricsServer::NaiveMetricsServer(
+    std::unique_ptr<ServerSocket> listen_socket,
+    CollectCallback collect_callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : listen_socket_(std::move(listen_socket)),
+      collect_callback_(std::move(collect_callback)),
+      traffic_annotation_(traffic_annotation) {
+  DCHECK(listen_socket_);
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveMetricsServer::DoAcceptLoop,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+NaiveMetricsServer::~NaiveMetricsServer() = default;
+
+void NaiveMetricsServer::DoAcceptLoop() {
+  int result;
+  do {
+    result = listen_socket_->Accept(
+        &accepted_socket_,
+        base::BindOnce(&NaiveMetricsServer::OnAcceptComplete,
+                       weak_ptr_factory_.GetWeakPtr()));
+    if (result == ERR_IO_PENDING)
+      return;
+    HandleAcceptResult(result);
+  } while (result == OK);
+}
+
+void NaiveMetricsServer::OnAcceptComplete(int result) {
+  HandleAcceptResult(result);
+  if (result == OK)
+    DoAcceptLoop();
+}
+
+void NaiveMetricsServer::HandleAcceptResult(int result) {
+  if (result != OK) {
+    LOG(ERROR) << "Metrics accept error: " << ErrorToShortString(result);
+    return;
+  }
+  auto request = std::make_unique<Request>(std::move(accepted_socket_), this,
+                                           traffic_annotation_);
+  Request* raw_request = request.get();
+  requests_.insert(std::move(request));
+  raw_request->Start();
+}
+
+void NaiveMetricsServer::OnRequestComplete(Request* request) {
+  auto it = requests_.find(request);
+  CHECK(it != requests_.end());
+  requests_.erase(it);
+}
+
+}  // namespace net
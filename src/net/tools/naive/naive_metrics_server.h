@@ -0,0 +1,59 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_METRICS_SERVER_H_
+#define NET_TOOLS_NAIVE_NAIVE_METRICS_SERVER_H_
+
+#include <memory>
+#include <set>
+
+#include "base/containers/unique_ptr_adapters.h"
+#include "base/functional/callback.h"
+#include "base/memory/weak_ptr.h"
+#include "net/tools/naive/naive_metrics.h"
+
+namespace net {
+
+class ServerSocket;
+class StreamSocket;
+struct NetworkTrafficAnnotationTag;
+
+// Answers HTTP requests on a listen socket with the metrics of all IO threads
+// in the Prometheus text format. Any request path gets the metrics, and the
+// connection is closed after each response. Counters are only gathered and
+// merged when a request comes in.
+class NaiveMetricsServer {
+ public:
+  // Gathers the metrics of every IO thread and runs the callback with them
+  // merged, possibly later.
+  using CollectCallback = base::RepeatingCallback<void(
+      base::OnceCallback<void(NaiveMetrics)>)>;
+
+  NaiveMetricsServer(std::unique_ptr<ServerSocket> listen_socket,
+                     CollectCallback collect_callback,
+                     const NetworkTrafficAnnotationTag& traffic_annotation);
+  ~NaiveMetricsServer();
+  NaiveMetricsServer(const NaiveMetricsServer&) = delete;
+  NaiveMetricsServer& operator=(const NaiveMetricsServer&) = delete;
+
+ private:
+  class Request;
+
+  void DoAcceptLoop();
+  void OnAcceptComplete(int result);
+  void HandleAcceptResult(int result);
+  // Deletes `request`.
+  void OnRequestComplete(Request* request);
+
+  std::unique_ptr<ServerSocket> listen_socket_;
+  CollectCallback collect_callback_;
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+
+  std::unique_ptr<StreamSocket> accepted_socket_;
+  std::set<std::unique_ptr<Request>, base::UniquePtrComparator> requests_;
+
+  base::WeakPtrFactory<NaiveMetricsServer> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_METRICS_SERVER_H_
@@ -0,0 +1,58 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_mtu_store.h"
+
+#include "base/logging.h"
+#include "net/quic/quic_session_pool.h"
+#include "net/tools/naive/naive_proxy_racer.h"
+
+namespace net {
+
+NaiveMtuStore::NaiveMtuStore(QuicSessionPool* quic_session_pool)
+    : quic_session_pool_(quic_session_pool),
+      network_(NaiveProxyRacer::GetCurrentNetwork()) {
+  NetworkChangeNotifier::AddNetworkChangeObserver(this);
+  sample_timer_.Start(FROM_HERE, kSampleInterval, this,
+                      &NaiveMtuStore::Sample);
+}
+
+NaiveMtuStore::~NaiveMtuStore() {
+  NetworkChangeNotifier::RemoveNetworkChangeObserver(this);
+}
+
+void NaiveMtuStore::OnNetworkChanged(
+    NetworkChangeNotifier::ConnectionType type) {
+  if (type == NetworkChangeNotifier::CONNECTION_NONE)
+    return;
+  Sample();
+  network_ = NaiveProxyRacer::GetCurrentNetwork();
+  quic::QuicByteCount length = 0;
+  auto it = length_by_network_.find(network_);
+  if (it != length_by_network_.end())
+    length = it->second;
+  quic_session_pool_->set_proxy_max_packet_length(length);
+  sample_timer_.Reset();
+}
+
+void NaiveMtuStore::Sample() {
+  quic::QuicByteCount length =
+      quic_session_pool_->GetDiscoveredProxyMaxPacketLength();
+  if (length == 0) {
+    // Still trusted unless the pool forgot it.
+    length = quic_session_pool_->proxy_max_packet_length();
+  }
+  if (length == 0) {
+    length_by_network_.erase(network_);
+    return;
+  }
+  auto [it, inserted] = length_by_network_.insert({network_, length});
+  if (inserted || it->second != length) {
+    VLOG(1) << "QUIC proxy max packet length " << length << " on "
+            << network_;
+  }
+  it->second = length;
+  quic_session_pool_->set_proxy_max_packet_length(length);
+}
+
+}  // namespace net
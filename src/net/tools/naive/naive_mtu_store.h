@@ -0,0 +1,50 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_MTU_STORE_H_
+#define NET_TOOLS_NAIVE_NAIVE_MTU_STORE_H_
+
+#include <map>
+#include <string>
+
+#include "base/memory/raw_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/network_change_notifier.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_types.h"
+
+namespace net {
+
+class QuicSessionPool;
+
+// Remembers the max packet length that path MTU discovery reached on the
+// QUIC proxy sessions of a thread on each network, so that new sessions on
+// a network seen before start at it instead of probing up again. Networks
+// are told apart as NaiveProxyRacer tells them apart. The length is
+// sampled every kSampleInterval and also applied to the later sessions on
+// the same network. Once the session pool forgets it, after a session
+// started at it blackholed, the sessions probe again.
+class NaiveMtuStore : public NetworkChangeNotifier::NetworkChangeObserver {
+ public:
+  static constexpr base::TimeDelta kSampleInterval = base::Seconds(30);
+
+  // `quic_session_pool` must outlive this.
+  explicit NaiveMtuStore(QuicSessionPool* quic_session_pool);
+  ~NaiveMtuStore() override;
+  NaiveMtuStore(const NaiveMtuStore&) = delete;
+  NaiveMtuStore& operator=(const NaiveMtuStore&) = delete;
+
+ private:
+  // NetworkChangeNotifier::NetworkChangeObserver:
+  void OnNetworkChanged(NetworkChangeNotifier::ConnectionType type) override;
+
+  void Sample();
+
+  const raw_ptr<QuicSessionPool> quic_session_pool_;
+  std::string network_;
+  std::map<std::string, quic::QuicByteCount> length_by_network_;
+  base::RepeatingTimer sample_timer_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_MTU_STORE_H_
@@ -0,0 +1,69 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_net_log_sampler.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/check_op.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "net/log/net_log_entry.h"
+#include "net/log/net_log_source.h"
+
+namespace net {
+
+NaiveNetLogSampler::NaiveNetLogSampler(
+    NetLog::ThreadSafeObserver* file_observer,
+    uint32_t sample_rate)
+    : file_observer_(file_observer), sample_rate_(sample_rate) {
+  DCHECK_GT(sample_rate_, 0u);
+}
+
+NaiveNetLogSampler::~NaiveNetLogSampler() {
+  if (net_log())
+    net_log()->RemoveObserver(this);
+}
+
+void NaiveNetLogSampler::StartObserving(NetLog* net_log,
+                                        NetLogCaptureMode capture_mode) {
+  net_log->AddObserver(this, capture_mode);
+}
+
+void NaiveNetLogSampler::LogCounts() const {
+  std::vector<std::pair<uint64_t, size_t>> counts;
+  for (size_t i = 0; i < kNumEventTypes; ++i) {
+    uint64_t count = counts_[i].load(std::memory_order_relaxed);
+    if (count > 0)
+      counts.emplace_back(count, i);
+  }
+  size_t num_logged = std::min(counts.size(), kNumLoggedTypes);
+  std::partial_sort(counts.begin(), counts.begin() + num_logged, counts.end(),
+                    [](const auto& a, const auto& b) { return a > b; });
+
+  std::string top;
+  for (size_t i = 0; i < num_logged; ++i) {
+    top += ' ';
+    top += NetLogEventTypeToString(
+        static_cast<NetLogEventType>(counts[i].second));
+    top += '=';
+    top += base::NumberToString(counts[i].first);
+  }
+  VLOG(1) << "Net log: saved=" << num_saved_.load(std::memory_order_relaxed)
+          << " counted:" << top;
+}
+
+void NaiveNetLogSampler::OnAddEntry(const NetLogEntry& entry) {
+  if (!entry.source.IsValid() || entry.source.id % sample_rate_ == 0) {
+    num_saved_.fetch_add(1, std::memory_order_relaxed);
+    file_observer_->OnAddEntry(entry);
+    return;
+  }
+  counts_[static_cast<size_t>(entry.type)].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+}  // namespace net
@@ -0,0 +1,56 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_NET_LOG_SAMPLER_H_
+#define NET_TOOLS_NAIVE_NAIVE_NET_LOG_SAMPLER_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "base/memory/raw_ptr.h"
+#include "net/log/net_log.h"
+#include "net/log/net_log_event_type.h"
+
+namespace net {
+
+// Saves the events of one in `sample_rate` NetLog sources, e.g. tunnels or
+// sockets, to a FileNetLogObserver or NaiveBinaryNetLogObserver, and only
+// counts the events of the other
+// sources. Events without a source are always saved.
+//
+// Counting takes no lock of its own and builds no JSON, so most events cost
+// little beyond what NetLog itself does to dispatch them.
+class NaiveNetLogSampler : public NetLog::ThreadSafeObserver {
+ public:
+  // `file_observer` must not be observing; the sampler passes events on to
+  // it instead. It must outlive this.
+  NaiveNetLogSampler(NetLog::ThreadSafeObserver* file_observer,
+                     uint32_t sample_rate);
+  NaiveNetLogSampler(const NaiveNetLogSampler&) = delete;
+  NaiveNetLogSampler& operator=(const NaiveNetLogSampler&) = delete;
+  ~NaiveNetLogSampler() override;
+
+  void StartObserving(NetLog* net_log, NetLogCaptureMode capture_mode);
+
+  // Logs the event types counted most so far, and the number of events
+  // saved, at verbosity 1.
+  void LogCounts() const;
+
+  // NetLog::ThreadSafeObserver:
+  void OnAddEntry(const NetLogEntry& entry) override;
+
+ private:
+  static constexpr size_t kNumEventTypes =
+      static_cast<size_t>(NetLogEventType::COUNT);
+  static constexpr size_t kNumLoggedTypes = 5;
+
+  const raw_ptr<NetLog::ThreadSafeObserver> file_observer_;
+  const uint32_t sample_rate_;
+  std::atomic<uint64_t> num_saved_ = 0;
+  std::array<std::atomic<uint64_t>, kNumEventTypes> counts_ = {};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_NET_LOG_SAMPLER_H_
@@ -0,0 +1,140 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_network_change_debouncer.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "base/check.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/task/thread_pool.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_interfaces.h"
+#include "net/http/http_network_session.h"
+#include "net/log/net_log_source.h"
+#include "net/socket/client_socket_factory.h"
+#include "net/socket/datagram_client_socket.h"
+#include "net/spdy/spdy_session.h"
+#include "net/spdy/spdy_session_pool.h"
+
+namespace net {
+namespace {
+
+struct SessionRoute {
+  IPEndPoint peer;
+  IPAddress local;
+};
+
+// Returns the local address the routing table picks for `peer`, or an empty
+// one if there is no route.
+IPAddress GetRouteSource(const IPEndPoint& peer) {
+  // Connecting a datagram socket only looks up the route.
+  std::unique_ptr<DatagramClientSocket> socket =
+      ClientSocketFactory::GetDefaultFactory()->CreateDatagramClientSocket(
+          DatagramSocket::DEFAULT_BIND, /*net_log=*/nullptr, NetLogSource());
+  IPEndPoint local;
+  if (socket->Connect(peer) != OK || socket->GetLocalAddress(&local) != OK)
+    return IPAddress();
+  return local.address();
+}
+
+// Returns whether the route of each of `routes` changed.
+std::vector<bool> CheckRoutes(const std::vector<SessionRoute>& routes,
+                              bool check_routes) {
+  NetworkInterfaceList networks;
+  bool has_networks =
+      GetNetworkList(&networks, INCLUDE_HOST_SCOPE_VIRTUAL_INTERFACES);
+  std::vector<bool> changed;
+  for (const SessionRoute& route : routes) {
+    if (has_networks &&
+        std::ranges::none_of(networks, [&](const NetworkInterface& n) {
+          return n.address == route.local;
+        })) {
+      changed.push_back(true);
+    } else if (check_routes) {
+      changed.push_back(GetRouteSource(route.peer) != route.local);
+    } else {
+      changed.push_back(false);
+    }
+  }
+  return changed;
+}
+
+}  // namespace
+
+NaiveNetworkChangeDebouncer::NaiveNetworkChangeDebouncer(
+    HttpNetworkSession* session,
+    bool check_routes)
+    : session_(session), check_routes_(check_routes) {
+  DCHECK(session_);
+  DCHECK(session_->params().ignore_ip_address_changes);
+  NetworkChangeNotifier::AddIPAddressObserver(this);
+}
+
+NaiveNetworkChangeDebouncer::~NaiveNetworkChangeDebouncer() {
+  NetworkChangeNotifier::RemoveIPAddressObserver(this);
+}
+
+void NaiveNetworkChangeDebouncer::OnIPAddressChanged() {
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (first_change_time_.is_null())
+    first_change_time_ = now;
+  base::TimeDelta delay =
+      std::min(kQuietPeriod, first_change_time_ + kMaxDelay - now);
+  timer_.Start(FROM_HERE, delay, this,
+               &NaiveNetworkChangeDebouncer::CheckSessions);
+}
+
+void NaiveNetworkChangeDebouncer::CheckSessions() {
+  first_change_time_ = base::TimeTicks();
+
+  std::vector<base::WeakPtr<SpdySession>> sessions;
+  std::vector<SessionRoute> routes;
+  for (base::WeakPtr<SpdySession>& session :
+       session_->spdy_session_pool()->GetCurrentSessions()) {
+    SessionRoute route;
+    IPEndPoint local;
+    // A session whose socket cannot tell is left to fail on its own.
+    if (!session || session->IsGoingAway() ||
+        session->GetPeerAddress(&route.peer) != OK ||
+        session->GetLocalAddress(&local) != OK) {
+      continue;
+    }
+    route.local = local.address();
+    sessions.push_back(std::move(session));
+    routes.push_back(std::move(route));
+  }
+  if (sessions.empty())
+    return;
+
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, {base::MayBlock()},
+      base::BindOnce(&CheckRoutes, std::move(routes), check_routes_),
+      base::BindOnce(&NaiveNetworkChangeDebouncer::OnSessionsChecked,
+                     weak_ptr_factory_.GetWeakPtr(), std::move(sessions)));
+}
+
+void NaiveNetworkChangeDebouncer::OnSessionsChecked(
+    std::vector<base::WeakPtr<SpdySession>> sessions,
+    std::vector<bool> changed) {
+  size_t num_changed = 0;
+  for (size_t i = 0; i < sessions.size(); ++i) {
+    if (!changed[i] || !sessions[i] || sessions[i]->IsGoingAway())
+      continue;
+    session_->spdy_session_pool()->MakeSessionGoingAway(sessions[i].get(),
+                                                        ERR_NETWORK_CHANGED);
+    ++num_changed;
+  }
+  VLOG(1) << "Network changed: " << num_changed << " of " << sessions.size()
+          << " HTTP/2 sessions changed route";
+  if (num_changed > 0)
+    session_->CloseIdleConnections("Network changed");
+}
+
+}  // namespace net
@@ -0,0 +1,65 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_NETWORK_CHANGE_DEBOUNCER_H_
+#define NET_TOOLS_NAIVE_NAIVE_NETWORK_CHANGE_DEBOUNCER_H_
+
+#include <vector>
+
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/network_change_notifier.h"
+
+namespace net {
+
+class HttpNetworkSession;
+class SpdySession;
+
+// Handles IP address changes for an HttpNetworkSession built with
+// ignore_ip_address_changes. Left to itself, the session closes its idle
+// sockets and makes every HTTP/2 session go away on each change, however
+// brief, such as address churn on mobile, a VPN interface flapping, or an
+// IPv6 privacy address rotating, and every tunnel after it waits for a new
+// handshake.
+//
+// Changes are taken once they settle for kQuietPeriod, or kMaxDelay after
+// the first of a burst. The HTTP/2 sessions are then checked on the
+// ThreadPool, and only those whose route changed go away: their local
+// address is gone, or the route to their peer now leaves from another one.
+// With `check_routes` false, as when sockets are bound to uplinks whatever
+// the routing table says, only the local address is checked. If any session
+// went away, idle connections are closed too, as the session would have
+// done. QUIC sessions are left to their own migration.
+class NaiveNetworkChangeDebouncer
+    : public NetworkChangeNotifier::IPAddressObserver {
+ public:
+  static constexpr base::TimeDelta kQuietPeriod = base::Seconds(2);
+  static constexpr base::TimeDelta kMaxDelay = base::Seconds(10);
+
+  // `session` must outlive this.
+  NaiveNetworkChangeDebouncer(HttpNetworkSession* session, bool check_routes);
+  ~NaiveNetworkChangeDebouncer() override;
+  NaiveNetworkChangeDebouncer(const NaiveNetworkChangeDebouncer&) = delete;
+  NaiveNetworkChangeDebouncer& operator=(const NaiveNetworkChangeDebouncer&) =
+      delete;
+
+  // NetworkChangeNotifier::IPAddressObserver:
+  void OnIPAddressChanged() override;
+
+ private:
+  void CheckSessions();
+  void OnSessionsChecked(std::vector<base::WeakPtr<SpdySession>> sessions,
+                         std::vector<bool> changed);
+
+  HttpNetworkSession* const session_;
+  const bool check_routes_;
+  // The first change of the current burst.
+  base::TimeTicks first_change_time_;
+  base::OneShotTimer timer_;
+
+  base::WeakPtrFactory<NaiveNetworkChangeDebouncer> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_NETWORK_CHANGE_DEBOUNCER_H_
@@ -18,11 +18,24 @@
 #include "base/check_op.h"
 
 namespace net {
-NaivePaddingFramer::NaivePaddingFramer(std::optional<int> max_read_frames)
-    : max_read_frames_(max_read_frames) {
-  if (max_read_frames.has_value()) {
-    CHECK_GE(*max_read_frames, 0);
+NaivePaddingFramer::NaivePaddingFramer(std::optional<int> max_read_frames,
+                                       std::optional<int> max_read_padding)
+    : max_read_frames_(
+          max_read_frames.value_or(std::numeric_limits<int>::max())),
+      max_read_padding_(max_read_padding.has_value()
+                            ? *max_read_padding
+                            : std::numeric_limits<int64_t>::max()),
+      read_framed_(max_read_frames_ > 0 && max_read_padding_ > 0) {
+  CHECK_GE(max_read_frames_, 0);
+  CHECK_GE(max_read_padding_, 0);
+}
+
+void NaivePaddingFramer::OnFrameRead() {
+  if (num_read_frames_ < std::numeric_limits<int>::max() - 1) {
+    ++num_read_frames_;
   }
+  read_framed_ = num_read_frames_ < max_read_frames_ &&
+                 num_read_padding_ < max_read_padding_;
 }
 
 int NaivePaddingFramer::Read(const char* padded,
@@ -32,19 +45,38 @@ int NaivePaddingFramer::Read(const char* padded,
   // This check guarantees write_ptr does not overflow.
   CHECK_GE(payload_buf_capacity, padded_len);
 
+  // Payloads are moved with memmove because `payload_buf` may alias `padded`.
+  // The write pointer never passes the read pointer.
   char* write_ptr = payload_buf;
   while (padded_len > 0) {
     int copy_size;
     switch (state_) {
       case ReadState::kPayloadLength1:
-        if (max_read_frames_.has_value() &&
-            num_read_frames_ >= *max_read_frames_) {
-          std::memcpy(write_ptr, padded, padded_len);
+        if (!read_framed_) {
+          std::memmove(write_ptr, padded, padded_len);
           padded += padded_len;
           write_ptr += padded_len;
           padded_len = 0;
           break;
         }
+        // Fast path for a whole frame, skipping the per-byte states.
+        if (padded_len >= frame_header_size()) {
+          int payload_length = static_cast<uint8_t>(padded[0]) * 256 +
+                               static_cast<uint8_t>(padded[1]);
+          int padding_length = static_cast<uint8_t>(padded[2]);
+          int frame_length =
+              frame_header_size() + payload_length + padding_length;
+          if (padded_len >= frame_length) {
+            std::memmove(write_ptr, padded + frame_header_size(),
+                         payload_length);
+            write_ptr += payload_length;
+            padded += frame_length;
+            padded_len -= frame_length;
+            num_read_padding_ += padding_length;
+            OnFrameRead();
+            break;
+          }
+        }
         read_payload_length_ = static_cast<uint8_t>(padded[0]);
         ++padded;
         --padded_len;
@@ -59,6 +91,8 @@ int NaivePaddingFramer::Read(const char* padded,
         break;
       case ReadState::kPaddingLength1:
         read_padding_length_ = static_cast<uint8_t>(padded[0]);
+        // Only checked at frame boundaries, so it can be counted early.
+        num_read_padding_ += read_padding_length_;
         ++padded;
         --padded_len;
         state_ = ReadState::kPayload;
@@ -70,7 +104,7 @@ int NaivePaddingFramer::Read(const char* padded,
           state_ = ReadState::kPadding;
         }
 
-        std::memcpy(write_ptr, padded, copy_size);
+        std::memmove(write_ptr, padded, copy_size);
         padded += copy_size;
         write_ptr += copy_size;
         padded_len -= copy_size;
@@ -79,9 +113,7 @@ int NaivePaddingFramer::Read(const char* padded,
         copy_size = std::min(read_padding_length_, padded_len);
         read_padding_length_ -= copy_size;
         if (read_padding_length_ == 0) {
-          if (num_read_frames_ < std::numeric_limits<int>::max() - 1) {
-            ++num_read_frames_;
-          }
+          OnFrameRead();
           state_ = ReadState::kPayloadLength1;
         }
 
@@ -105,19 +137,27 @@ int NaivePaddingFramer::Write(const char* payload_buf,
 
   payload_consumed_len = std::min(
       payload_buf_len, padded_capacity - frame_header_size() - padding_size);
-  int padded_buf_len =
-      frame_header_size() + payload_consumed_len + padding_size;
-
-  padded[0] = payload_consumed_len / 256;
-  padded[1] = payload_consumed_len % 256;
-  padded[2] = padding_size;
   std::memcpy(padded + frame_header_size(), payload_buf, payload_consumed_len);
-  std::memset(padded + frame_header_size() + payload_consumed_len, '\0',
-              padding_size);
+  return WriteInPlace(padded, payload_consumed_len, padding_size);
+}
+
+int NaivePaddingFramer::WriteInPlace(char* frame,
+                                     int payload_len,
+                                     int padding_size) {
+  CHECK_GE(payload_len, 0);
+  CHECK_LE(payload_len, max_payload_size());
+  CHECK_LE(padding_size, max_padding_size());
+  CHECK_GE(padding_size, 0);
+
+  frame[0] = payload_len / 256;
+  frame[1] = payload_len % 256;
+  frame[2] = padding_size;
+  std::memset(frame + frame_header_size() + payload_len, '\0', padding_size);
 
+  num_written_padding_ += padding_size;
   if (num_written_frames_ < std::numeric_limits<int>::max() - 1) {
     ++num_written_frames_;
   }
-  return padded_buf_len;
+  return frame_header_size() + payload_len + padding_size;
 }
 }  // namespace net
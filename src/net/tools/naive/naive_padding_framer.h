@@ -19,23 +19,40 @@ namespace net {
 // };
 class NaivePaddingFramer {
  public:
+  static constexpr int kFrameHeaderSize = 3;
+  static constexpr int kMaxPaddingSize = std::numeric_limits<uint8_t>::max();
+
   // `max_read_frames`: Assumes the byte stream stops using the padding
-  //   framing after `max_read_frames` frames. If -1, it means
+  //   framing after `max_read_frames` frames. If unset, it means
   //   the byte stream always uses the padding framing.
-  explicit NaivePaddingFramer(std::optional<int> max_read_frames);
+  // `max_read_padding`: If set, also assumes the byte stream stops using the
+  //   padding framing after the frame that brings the padding bytes read to
+  //   `max_read_padding`.
+  explicit NaivePaddingFramer(
+      std::optional<int> max_read_frames,
+      std::optional<int> max_read_padding = std::nullopt);
 
-  int max_payload_size() const { return std::numeric_limits<uint16_t>::max(); }
+  static constexpr int max_payload_size() {
+    return std::numeric_limits<uint16_t>::max();
+  }
 
-  int max_padding_size() const { return std::numeric_limits<uint8_t>::max(); }
+  static constexpr int max_padding_size() { return kMaxPaddingSize; }
 
-  int frame_header_size() const { return 3; }
+  static constexpr int frame_header_size() { return kFrameHeaderSize; }
 
   int num_read_frames() const { return num_read_frames_; }
 
   int num_written_frames() const { return num_written_frames_; }
 
+  int64_t num_written_padding() const { return num_written_padding_; }
+
+  int64_t num_read_padding() const { return num_read_padding_; }
+
+  // Returns true if the bytes read next are framed.
+  bool IsReadFramed() const { return read_framed_; }
+
   // Reads `padded` for `padded_len` bytes and extracts unpadded payload to
-  // `payload_buf`.
+  // `payload_buf`, which may be `padded` itself to decode in place.
   // Returns the number of payload bytes extracted.
   // Returning zero indicates a pure padding instead of EOF.
   int Read(const char* padded,
@@ -54,6 +71,12 @@ class NaivePaddingFramer {
             int padded_capacity,
             int& payload_consumed_len);
 
+  // Frames `payload_len` bytes already placed at `frame` + frame_header_size()
+  // in place, writing the header before them and `padding_size` zeros after
+  // them. `frame` must have room for the whole frame.
+  // Returns the number of padded bytes written.
+  int WriteInPlace(char* frame, int payload_len, int padding_size);
+
  private:
   enum class ReadState {
     kPayloadLength1,
@@ -63,14 +86,23 @@ class NaivePaddingFramer {
     kPadding,
   };
 
-  std::optional<int> max_read_frames_;
+  // Counts a frame read in full, whose padding is already counted.
+  void OnFrameRead();
+
+  // The limits are kept as plain numbers and only compared once per frame,
+  // caching the result in `read_framed_`.
+  const int max_read_frames_;
+  const int64_t max_read_padding_;
+  bool read_framed_;
 
   ReadState state_ = ReadState::kPayloadLength1;
   int read_payload_length_ = 0;
   int read_padding_length_ = 0;
   int num_read_frames_ = 0;
+  int64_t num_read_padding_ = 0;
 
   int num_written_frames_ = 0;
+  int64_t num_written_padding_ = 0;
 };
 }  // namespace net
 #endif  // NET_TOOLS_NAIVE_NAIVE_PADDING_FRAMER_H_
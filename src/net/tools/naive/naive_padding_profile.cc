@@ -0,0 +1,56 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_padding_profile.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/check.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "net/tools/naive/naive_padding_framer.h"
+#include "net/tools/naive/naive_random.h"
+
+namespace net {
+
+NaivePaddingProfile::NaivePaddingProfile() = default;
+
+// static
+std::optional<NaivePaddingProfile> NaivePaddingProfile::Parse(
+    std::string_view str) {
+  std::vector<std::string_view> range_strs = base::SplitStringPiece(
+      str, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+  if (range_strs.empty() || range_strs.size() > kMaxRanges) {
+    return std::nullopt;
+  }
+
+  NaivePaddingProfile profile;
+  for (std::string_view range_str : range_strs) {
+    std::vector<std::string_view> bounds = base::SplitStringPiece(
+        range_str, "-", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+    if (bounds.empty() || bounds.size() > 2) {
+      return std::nullopt;
+    }
+    Range range;
+    if (!base::StringToInt(bounds.front(), &range.min) ||
+        !base::StringToInt(bounds.back(), &range.max)) {
+      return std::nullopt;
+    }
+    if (range.min < 0 || range.min > range.max ||
+        range.max > NaivePaddingFramer::kMaxPaddingSize) {
+      return std::nullopt;
+    }
+    profile.ranges_[profile.num_ranges_++] = range;
+  }
+  return profile;
+}
+
+int NaivePaddingProfile::GetPaddingSize(int frame_index) const {
+  DCHECK(!empty());
+  const Range& range = ranges_[std::min(frame_index, num_ranges_ - 1)];
+  return NaiveRandInt(range.min, range.max);
+}
+
+}  // namespace net
@@ -0,0 +1,45 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_PADDING_PROFILE_H_
+#define NET_TOOLS_NAIVE_NAIVE_PADDING_PROFILE_H_
+
+#include <array>
+#include <optional>
+#include <string_view>
+
+namespace net {
+
+// Padding size ranges for the padded frames written with
+// PaddingType::kVariant2, by frame index. The last range applies to the
+// remaining padded frames. Only the sender uses it; the receiver reads the
+// padding size from each frame header.
+class NaivePaddingProfile {
+ public:
+  static constexpr int kMaxRanges = 8;
+
+  struct Range {
+    int min = 0;
+    int max = 0;
+  };
+
+  // Constructs an empty profile.
+  NaivePaddingProfile();
+
+  // Parses `str` in the form of <MIN>["-"<MAX>][","...], with at most
+  // kMaxRanges ranges in [0, 255]. Returns empty if `str` is invalid.
+  static std::optional<NaivePaddingProfile> Parse(std::string_view str);
+
+  bool empty() const { return num_ranges_ == 0; }
+
+  // Returns a random padding size for the frame at `frame_index`.
+  // Must not be empty.
+  int GetPaddingSize(int frame_index) const;
+
+ private:
+  std::array<Range, kMaxRanges> ranges_;
+  int num_ranges_ = 0;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_PADDING_PROFILE_H_
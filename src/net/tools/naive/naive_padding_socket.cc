@@ -9,81 +9,184 @@
 #include <tuple>
 #include <utility>
 
-#include "base/rand_util.h"
 #include "base/task/single_thread_task_runner.h"
+#include "base/trace_event/base_tracing.h"
 #include "net/base/io_buffer.h"
+#include "net/tools/naive/naive_buffer_pool.h"
+#include "net/tools/naive/naive_random.h"
+#include "third_party/abseil-cpp/absl/base/attributes.h"
 
 namespace net {
 
 namespace {
-constexpr int kMaxBufferSize = 64 * 1024;
-constexpr int kFirstPaddings = 8;
+constexpr int kMaxBufferSize = NaiveBufferPool::kBufferSize;
+// kVariant2 completes padded writes up to this size before they are sent.
+constexpr int kMaxEarlyWriteSize = 1024;
+// Fits a coalesced padding frame in the smallest pooled buffer.
+constexpr int kMaxCoalescedSize = NaiveBufferPool::kMinBufferSize -
+                                  NaivePaddingSocket::kWriteHeadroom -
+                                  NaivePaddingSocket::kWriteTailroom;
+
+ABSL_CONST_INIT thread_local NaivePaddingSocket::Stats current_stats;
 }  // namespace
 
-NaivePaddingSocket::NaivePaddingSocket(StreamSocket* transport_socket,
-                                       PaddingType padding_type,
-                                       Direction direction)
+NaivePaddingSocket::NaivePaddingSocket(
+    StreamSocket* transport_socket,
+    PaddingType padding_type,
+    Direction direction,
+    const PaddingLimits& padding_limits,
+    const NaivePaddingProfile& padding_profile)
     : transport_socket_(transport_socket),
       padding_type_(padding_type),
       direction_(direction),
-      read_buf_(base::MakeRefCounted<IOBufferWithSize>(kMaxBufferSize)),
-      framer_(kFirstPaddings) {}
+      padding_limits_(padding_limits),
+      padding_profile_(padding_profile) {
+  if (padding_type_ != PaddingType::kNone) {
+    framer_ = std::make_unique<NaivePaddingFramer>(
+        padding_limits.frames, padding_limits.budget > 0
+                                   ? std::optional<int>(padding_limits.budget)
+                                   : std::nullopt);
+  }
+  if (padding_limits.compression != Compression::kNone) {
+    compressor_ = std::make_unique<NaiveCompressor>();
+  }
+}
 
 NaivePaddingSocket::~NaivePaddingSocket() {
+  if (framer_) {
+    current_stats.frames_written += framer_->num_written_frames();
+    current_stats.frames_read += framer_->num_read_frames();
+    current_stats.padding_bytes_written += framer_->num_written_padding();
+    current_stats.padding_bytes_read += framer_->num_read_padding();
+  }
+  if (compressor_) {
+    uint64_t payload_bytes = compressor_->payload_bytes_written() +
+                             compressor_->payload_bytes_read();
+    uint64_t frame_bytes = compressor_->frame_bytes_written() +
+                           compressor_->frame_bytes_read();
+    current_stats.compressed_tunnels++;
+    current_stats.compression_payload_bytes += payload_bytes;
+    current_stats.compression_frame_bytes += frame_bytes;
+    if (frame_bytes > 0) {
+      current_stats.compression_ratio_sum +=
+          static_cast<double>(payload_bytes) / frame_bytes;
+    }
+  }
   Disconnect();
 }
 
+// static
+const NaivePaddingSocket::Stats&
+NaivePaddingSocket::GetStatsForCurrentThread() {
+  return current_stats;
+}
+
 void NaivePaddingSocket::Disconnect() {
   transport_socket_->Disconnect();
 }
 
+int NaivePaddingSocket::ShutdownWrite() {
+  DCHECK(write_buf_ == nullptr);
+  return transport_socket_->ShutdownWrite();
+}
+
+int NaivePaddingSocket::Flush(CompletionOnceCallback callback) {
+  DCHECK(!write_callback_);
+  DCHECK(!held_callback_);
+
+  if (write_buf_ == nullptr) {
+    return write_error_;
+  }
+  flush_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
 int NaivePaddingSocket::Read(IOBuffer* buf,
                              int buf_len,
                              CompletionOnceCallback callback) {
   DCHECK(!callback.is_null());
 
-  switch (padding_type_) {
-    case PaddingType::kNone:
-      return ReadNoPadding(buf, buf_len, std::move(callback));
-    case PaddingType::kVariant1:
-      if (framer_.num_read_frames() < kFirstPaddings) {
-        return ReadPaddingV1(buf, buf_len, std::move(callback));
-      } else {
-        return ReadNoPadding(buf, buf_len, std::move(callback));
-      }
-    default:
-      NOTREACHED();
+  if (compressor_) {
+    return ReadCompressed(buf, buf_len, std::move(callback));
   }
+  return ReadFrames(buf, buf_len, std::move(callback));
 }
 
-int NaivePaddingSocket::ReadNoPadding(IOBuffer* buf,
-                                      int buf_len,
-                                      CompletionOnceCallback callback) {
-  int rv = transport_socket_->Read(
-      buf, buf_len,
-      base::BindOnce(&NaivePaddingSocket::OnReadNoPaddingComplete,
-                     base::Unretained(this), std::move(callback)));
-  return rv;
+int NaivePaddingSocket::ReadFrames(IOBuffer* buf,
+                                   int buf_len,
+                                   CompletionOnceCallback callback) {
+  if (IsReadFramed()) {
+    return ReadPaddingV1(buf, buf_len, std::move(callback));
+  }
+  return ReadNoPadding(buf, buf_len, std::move(callback));
 }
 
-void NaivePaddingSocket::OnReadNoPaddingComplete(
-    CompletionOnceCallback callback,
-    int rv) {
-  DCHECK_NE(ERR_IO_PENDING, rv);
-  DCHECK(callback);
+int NaivePaddingSocket::ReadIfReady(IOBuffer* buf,
+                                    int buf_len,
+                                    CompletionOnceCallback callback) {
+  DCHECK(!callback.is_null());
 
-  std::move(callback).Run(rv);
+  if (compressor_) {
+    return ReadIfReadyCompressed(buf, buf_len, std::move(callback));
+  }
+  return ReadIfReadyFrames(buf, buf_len, std::move(callback));
+}
+
+int NaivePaddingSocket::ReadIfReadyFrames(IOBuffer* buf,
+                                          int buf_len,
+                                          CompletionOnceCallback callback) {
+  if (IsReadFramed()) {
+    return ReadIfReadyPaddingV1(buf, buf_len, std::move(callback));
+  }
+  return transport_socket_->ReadIfReady(buf, buf_len, std::move(callback));
+}
+
+int NaivePaddingSocket::CancelReadIfReady() {
+  read_callback_.Reset();
+  compressed_read_callback_.Reset();
+  return transport_socket_->CancelReadIfReady();
+}
+
+int NaivePaddingSocket::ReadBuffer(int max_len,
+                                   scoped_refptr<IOBuffer>* buf,
+                                   CompletionOnceCallback callback) {
+  DCHECK(!callback.is_null());
+
+  if (compressor_ || IsReadFramed()) {
+    return ERR_NOT_IMPLEMENTED;
+  }
+  return transport_socket_->ReadBuffer(max_len, buf, std::move(callback));
+}
+
+int NaivePaddingSocket::LendReadBuffer(int max_len,
+                                       base::span<const char>* data,
+                                       CompletionOnceCallback callback) {
+  DCHECK(!callback.is_null());
+
+  if (compressor_ || IsReadFramed()) {
+    return ERR_NOT_IMPLEMENTED;
+  }
+  return transport_socket_->LendReadBuffer(max_len, data, std::move(callback));
+}
+
+void NaivePaddingSocket::ConsumeLentBuffer(int len) {
+  transport_socket_->ConsumeLentBuffer(len);
+}
+
+int NaivePaddingSocket::ReadNoPadding(IOBuffer* buf,
+                                      int buf_len,
+                                      CompletionOnceCallback callback) {
+  // Passes the callback through, as there is nothing to unframe.
+  return transport_socket_->Read(buf, buf_len, std::move(callback));
 }
 
 int NaivePaddingSocket::ReadPaddingV1(IOBuffer* buf,
                                       int buf_len,
                                       CompletionOnceCallback callback) {
+  TRACE_EVENT("naive", "NaivePaddingSocket::ReadPaddingV1", "size", buf_len);
   DCHECK(!callback.is_null());
   DCHECK(read_user_buf_ == nullptr);
 
-  // Truncates user requested buf len if it is too large for the padding
-  // buffer.
-  buf_len = std::min(buf_len, kMaxBufferSize);
   read_user_buf_ = buf;
   read_user_buf_len_ = buf_len;
 
@@ -105,7 +208,7 @@ void NaivePaddingSocket::OnReadPaddingV1Complete(int rv) {
   DCHECK(read_user_buf_ != nullptr);
 
   if (rv > 0) {
-    rv = framer_.Read(read_buf_->data(), rv, read_user_buf_->data(),
+    rv = framer_->Read(read_user_buf_->data(), rv, read_user_buf_->data(),
                       read_user_buf_len_);
     if (rv == 0) {
       rv = ReadPaddingV1Payload();
@@ -124,13 +227,15 @@ void NaivePaddingSocket::OnReadPaddingV1Complete(int rv) {
 int NaivePaddingSocket::ReadPaddingV1Payload() {
   for (;;) {
     int rv = transport_socket_->Read(
-        read_buf_.get(), read_user_buf_len_,
+        read_user_buf_, read_user_buf_len_,
         base::BindOnce(&NaivePaddingSocket::OnReadPaddingV1Complete,
                        base::Unretained(this)));
     if (rv <= 0) {
       return rv;
     }
-    rv = framer_.Read(read_buf_->data(), rv, read_user_buf_->data(),
+    // Payloads are never longer than their frames, so they are decoded in
+    // the user buffer.
+    rv = framer_->Read(read_user_buf_->data(), rv, read_user_buf_->data(),
                       read_user_buf_len_);
     if (rv > 0) {
       return rv;
@@ -138,17 +243,77 @@ int NaivePaddingSocket::ReadPaddingV1Payload() {
   }
 }
 
+int NaivePaddingSocket::ReadIfReadyPaddingV1(IOBuffer* buf,
+                                             int buf_len,
+                                             CompletionOnceCallback callback) {
+  DCHECK(!read_callback_);
+
+  for (;;) {
+    int rv = transport_socket_->ReadIfReady(
+        buf, buf_len,
+        base::BindOnce(&NaivePaddingSocket::OnReadIfReadyPaddingV1Complete,
+                       base::Unretained(this)));
+    if (rv == ERR_IO_PENDING) {
+      read_callback_ = std::move(callback);
+      return rv;
+    }
+    if (rv <= 0) {
+      return rv;
+    }
+    rv = framer_->Read(buf->data(), rv, buf->data(), buf_len);
+    // Reads again after a pure padding so this does not return zero for a
+    // non-EOF condition.
+    if (rv > 0) {
+      return rv;
+    }
+  }
+}
+
+void NaivePaddingSocket::OnReadIfReadyPaddingV1Complete(int rv) {
+  DCHECK_NE(ERR_IO_PENDING, rv);
+  DCHECK(read_callback_);
+
+  std::move(read_callback_).Run(rv);
+}
+
 int NaivePaddingSocket::Write(
     IOBuffer* buf,
     int buf_len,
     CompletionOnceCallback callback,
     const NetworkTrafficAnnotationTag& traffic_annotation) {
+  if (compressor_) {
+    return WriteCompressed(buf, buf_len, std::move(callback),
+                           traffic_annotation);
+  }
+  return WriteFrames(buf, buf_len, std::move(callback), traffic_annotation);
+}
+
+int NaivePaddingSocket::WriteFrames(
+    IOBuffer* buf,
+    int buf_len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
   switch (padding_type_) {
     case PaddingType::kNone:
       return WriteNoPadding(buf, buf_len, std::move(callback),
                             traffic_annotation);
     case PaddingType::kVariant1:
-      if (framer_.num_written_frames() < kFirstPaddings) {
+      if (IsWriteFramed()) {
+        return WritePaddingV1(buf, buf_len, std::move(callback),
+                              traffic_annotation);
+      } else {
+        return WriteNoPadding(buf, buf_len, std::move(callback),
+                              traffic_annotation);
+      }
+    case PaddingType::kVariant2:
+      if (write_error_ != OK) {
+        return write_error_;
+      }
+      if (write_buf_ != nullptr) {
+        return WritePaddingV2Coalesced(buf, buf_len, /*in_place=*/false,
+                                       std::move(callback), traffic_annotation);
+      }
+      if (IsWriteFramed()) {
         return WritePaddingV1(buf, buf_len, std::move(callback),
                               traffic_annotation);
       } else {
@@ -165,22 +330,91 @@ int NaivePaddingSocket::WriteNoPadding(
     int buf_len,
     CompletionOnceCallback callback,
     const NetworkTrafficAnnotationTag& traffic_annotation) {
-  return transport_socket_->Write(
-      buf, buf_len,
-      base::BindOnce(&NaivePaddingSocket::OnWriteNoPaddingComplete,
-                     base::Unretained(this), std::move(callback),
-                     traffic_annotation),
-      traffic_annotation);
+  return transport_socket_->Write(buf, buf_len, std::move(callback),
+                                  traffic_annotation);
 }
 
-void NaivePaddingSocket::OnWriteNoPaddingComplete(
-    CompletionOnceCallback callback,
-    const NetworkTrafficAnnotationTag& traffic_annotation,
-    int rv) {
-  DCHECK_NE(ERR_IO_PENDING, rv);
-  DCHECK(callback);
+bool NaivePaddingSocket::IsReadFramed() const {
+  return framer_ && framer_->IsReadFramed();
+}
 
-  std::move(callback).Run(rv);
+bool NaivePaddingSocket::IsWriteFramed() const {
+  if (framer_->num_written_frames() >= padding_limits_.frames) {
+    return false;
+  }
+  if (padding_limits_.budget > 0 &&
+      framer_->num_written_padding() >= padding_limits_.budget) {
+    return false;
+  }
+  return true;
+}
+
+bool NaivePaddingSocket::IsWritePadded() const {
+  if (compressor_) {
+    return false;
+  }
+  switch (padding_type_) {
+    case PaddingType::kVariant1:
+      return IsWriteFramed();
+    case PaddingType::kVariant2:
+      if (coalesced_len_ == 0) {
+        return IsWriteFramed();
+      }
+      // The coalesced payloads take the next frame, with up to the maximum
+      // padding.
+      return framer_->num_written_frames() + 1 < padding_limits_.frames &&
+             (padding_limits_.budget == 0 ||
+              framer_->num_written_padding() + framer_->max_padding_size() <
+                  padding_limits_.budget);
+    default:
+      return false;
+  }
+}
+
+StreamSocket* NaivePaddingSocket::GetUnframedReadSocket() const {
+  if (compressor_ || IsReadFramed()) {
+    return nullptr;
+  }
+  return transport_socket_;
+}
+
+size_t NaivePaddingSocket::EstimateMemoryUsage() const {
+  size_t usage = sizeof(*this);
+  if (framer_) {
+    usage += sizeof(NaivePaddingFramer);
+  }
+  if (compressor_) {
+    usage += sizeof(NaiveCompressor) + compressor_->EstimateMemoryUsage();
+  }
+  for (const IOBuffer* buf :
+       {static_cast<const IOBuffer*>(write_buf_.get()), coalesced_buf_.get(),
+        held_buf_.get(), compressed_read_buf_.get(),
+        static_cast<const IOBuffer*>(compressed_input_.get()),
+        static_cast<const IOBuffer*>(compressed_write_buf_.get())}) {
+    if (buf) {
+      usage += buf->size();
+    }
+  }
+  return usage;
+}
+
+StreamSocket* NaivePaddingSocket::GetUnframedWriteSocket() const {
+  if (compressor_ || IsWritePadded() || write_buf_ != nullptr ||
+      held_buf_ != nullptr || coalesced_len_ > 0 || write_error_ != OK) {
+    return nullptr;
+  }
+  return transport_socket_;
+}
+
+int NaivePaddingSocket::GetWritePaddingSize(int payload_len) {
+  if (padding_type_ == PaddingType::kVariant2 && !padding_profile_.empty()) {
+    return padding_profile_.GetPaddingSize(framer_->num_written_frames());
+  }
+  if (direction_ == kServer && payload_len < 100) {
+    return NaiveRandInt(framer_->max_padding_size() - payload_len,
+                        framer_->max_padding_size());
+  }
+  return NaiveRandInt(0, framer_->max_padding_size());
 }
 
 int NaivePaddingSocket::WritePaddingV1(
@@ -188,30 +422,71 @@ int NaivePaddingSocket::WritePaddingV1(
     int buf_len,
     CompletionOnceCallback callback,
     const NetworkTrafficAnnotationTag& traffic_annotation) {
+  TRACE_EVENT("naive", "NaivePaddingSocket::WritePaddingV1", "size", buf_len);
   DCHECK(write_buf_ == nullptr);
 
-  auto padded = base::MakeRefCounted<IOBufferWithSize>(kMaxBufferSize);
-  int padding_size;
-  if (direction_ == kServer) {
-    if (buf_len < 100) {
-      padding_size = base::RandInt(framer_.max_padding_size() - buf_len,
-                                   framer_.max_padding_size());
-    } else {
-      padding_size = base::RandInt(0, framer_.max_padding_size());
-    }
-  } else {
-    padding_size = base::RandInt(0, framer_.max_padding_size());
-  }
+  int padding_size = GetWritePaddingSize(buf_len);
+  // Sizes the padded buffer to the frame instead of the maximum so small
+  // writes use small pooled buffers.
+  scoped_refptr<IOBuffer> padded = NaiveBufferPool::Acquire(std::min(
+      buf_len + framer_->frame_header_size() + padding_size, kMaxBufferSize));
+  current_stats.buffers_acquired++;
   int write_buf_len =
-      framer_.Write(buf->data(), buf_len, padding_size, padded->data(),
-                    kMaxBufferSize, write_user_payload_len_);
+      framer_->Write(buf->data(), buf_len, padding_size, padded->data(),
+                    padded->size(), write_user_payload_len_);
   // Using DrainableIOBuffer here because we do not want to
   // repeatedly encode the padding frames when short writes happen.
   write_buf_ =
       base::MakeRefCounted<DrainableIOBuffer>(std::move(padded), write_buf_len);
+  return WritePaddingV1Frame(write_user_payload_len_, std::move(callback),
+                             traffic_annotation);
+}
+
+int NaivePaddingSocket::WriteInPlace(
+    scoped_refptr<IOBuffer> frame_buf,
+    int payload_len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  TRACE_EVENT("naive", "NaivePaddingSocket::WriteInPlace", "size",
+              payload_len);
+  DCHECK(IsWritePadded());
+  if (padding_type_ == PaddingType::kVariant2) {
+    if (write_error_ != OK) {
+      return write_error_;
+    }
+    if (write_buf_ != nullptr) {
+      return WritePaddingV2Coalesced(std::move(frame_buf), payload_len,
+                                     /*in_place=*/true, std::move(callback),
+                                     traffic_annotation);
+    }
+  }
+  DCHECK(write_buf_ == nullptr);
+  static_assert(kWriteHeadroom == NaivePaddingFramer::kFrameHeaderSize);
+  static_assert(kWriteTailroom == NaivePaddingFramer::kMaxPaddingSize);
+  CHECK_GE(frame_buf->size(), kWriteHeadroom + payload_len + kWriteTailroom);
 
+  int padding_size = GetWritePaddingSize(payload_len);
+  int write_buf_len =
+      framer_->WriteInPlace(frame_buf->data(), payload_len, padding_size);
+  write_buf_ = base::MakeRefCounted<DrainableIOBuffer>(std::move(frame_buf),
+                                                       write_buf_len);
+  return WritePaddingV1Frame(payload_len, std::move(callback),
+                             traffic_annotation);
+}
+
+int NaivePaddingSocket::WritePaddingV1Frame(
+    int payload_len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  write_user_payload_len_ = payload_len;
   int rv = WritePaddingV1Drain(traffic_annotation);
   if (rv == ERR_IO_PENDING) {
+    // Lets the next writes coalesce into one frame while this one is sent,
+    // instead of each becoming its own frame after it.
+    if (padding_type_ == PaddingType::kVariant2 &&
+        payload_len <= kMaxEarlyWriteSize) {
+      return payload_len;
+    }
     write_callback_ = std::move(callback);
     return rv;
   }
@@ -226,7 +501,6 @@ void NaivePaddingSocket::OnWritePaddingV1Complete(
     const NetworkTrafficAnnotationTag& traffic_annotation,
     int rv) {
   DCHECK_NE(ERR_IO_PENDING, rv);
-  DCHECK(write_callback_);
   DCHECK(write_buf_ != nullptr);
 
   if (rv > 0) {
@@ -241,6 +515,15 @@ void NaivePaddingSocket::OnWritePaddingV1Complete(
   write_buf_ = nullptr;
   write_user_payload_len_ = 0;
 
+  if (!write_callback_) {
+    // The write completed early.
+    if (rv < 0) {
+      write_error_ = rv;
+    }
+    FlushCoalescedWrites(traffic_annotation);
+    return;
+  }
+
   std::move(write_callback_).Run(rv);
 }
 
@@ -252,7 +535,7 @@ int NaivePaddingSocket::WritePaddingV1Drain(
     int remaining = write_buf_->BytesRemaining();
     if (direction_ == kServer && write_user_payload_len_ > 400 &&
         write_user_payload_len_ < 1024) {
-      remaining = std::min(remaining, base::RandInt(200, 300));
+      remaining = std::min(remaining, NaiveRandInt(200, 300));
     }
     int rv = transport_socket_->Write(
         write_buf_.get(), remaining,
@@ -268,4 +551,296 @@ int NaivePaddingSocket::WritePaddingV1Drain(
   return write_user_payload_len_;
 }
 
+int NaivePaddingSocket::WritePaddingV2Coalesced(
+    scoped_refptr<IOBuffer> buf,
+    int buf_len,
+    bool in_place,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  DCHECK(write_buf_ != nullptr);
+  DCHECK(!write_callback_);
+  DCHECK(!held_callback_);
+
+  // The coalesced payloads must still be sent as a padding frame.
+  if (IsWriteFramed() && buf_len <= kMaxCoalescedSize - coalesced_len_) {
+    if (!coalesced_buf_) {
+      coalesced_buf_ = NaiveBufferPool::Acquire(
+          kWriteHeadroom + kMaxCoalescedSize + kWriteTailroom);
+      current_stats.buffers_acquired++;
+    }
+    const char* data = buf->data() + (in_place ? kWriteHeadroom : 0);
+    std::memcpy(coalesced_buf_->data() + kWriteHeadroom + coalesced_len_,
+                data, buf_len);
+    coalesced_len_ += buf_len;
+    current_stats.coalesced_writes++;
+    return buf_len;
+  }
+
+  held_buf_ = std::move(buf);
+  held_len_ = buf_len;
+  held_in_place_ = in_place;
+  held_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
+void NaivePaddingSocket::FlushCoalescedWrites(
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  TRACE_EVENT("naive", "NaivePaddingSocket::FlushCoalescedWrites", "size",
+              coalesced_len_);
+  DCHECK(write_buf_ == nullptr);
+
+  while (write_error_ == OK && coalesced_len_ > 0) {
+    int payload_len = coalesced_len_;
+    coalesced_len_ = 0;
+    int padding_size = GetWritePaddingSize(payload_len);
+    int write_buf_len = framer_->WriteInPlace(coalesced_buf_->data(),
+                                             payload_len, padding_size);
+    write_buf_ = base::MakeRefCounted<DrainableIOBuffer>(
+        std::move(coalesced_buf_), write_buf_len);
+    write_user_payload_len_ = payload_len;
+    int rv = WritePaddingV1Drain(traffic_annotation);
+    if (rv == ERR_IO_PENDING) {
+      // Comes back through OnWritePaddingV1Complete().
+      return;
+    }
+    write_buf_ = nullptr;
+    write_user_payload_len_ = 0;
+    if (rv < 0) {
+      write_error_ = rv;
+    }
+  }
+  coalesced_buf_ = nullptr;
+  coalesced_len_ = 0;
+
+  if (held_callback_) {
+    scoped_refptr<IOBuffer> buf = std::move(held_buf_);
+    int rv = write_error_;
+    if (rv == OK) {
+      CompletionOnceCallback callback = base::BindOnce(
+          &NaivePaddingSocket::OnHeldWriteComplete, base::Unretained(this));
+      if (held_in_place_) {
+        rv = WriteInPlace(std::move(buf), held_len_, std::move(callback),
+                          traffic_annotation);
+      } else {
+        rv = WriteFrames(buf.get(), held_len_, std::move(callback),
+                         traffic_annotation);
+      }
+    }
+    if (rv != ERR_IO_PENDING) {
+      OnHeldWriteComplete(rv);
+    }
+    return;
+  }
+
+  if (flush_callback_) {
+    std::move(flush_callback_).Run(write_error_);
+  }
+}
+
+void NaivePaddingSocket::OnHeldWriteComplete(int rv) {
+  DCHECK_NE(ERR_IO_PENDING, rv);
+  DCHECK(held_callback_);
+
+  std::move(held_callback_).Run(rv);
+}
+
+int NaivePaddingSocket::ReadCompressed(IOBuffer* buf,
+                                       int buf_len,
+                                       CompletionOnceCallback callback) {
+  TRACE_EVENT("naive", "NaivePaddingSocket::ReadCompressed", "size", buf_len);
+  DCHECK(compressed_read_user_buf_ == nullptr);
+
+  compressed_read_user_buf_ = buf;
+  compressed_read_user_buf_len_ = buf_len;
+
+  int rv = ReadCompressedPayload();
+
+  if (rv == ERR_IO_PENDING) {
+    compressed_read_callback_ = std::move(callback);
+    return rv;
+  }
+
+  compressed_read_user_buf_ = nullptr;
+
+  return rv;
+}
+
+int NaivePaddingSocket::ReadCompressedPayload() {
+  for (;;) {
+    int rv = DecompressInput(compressed_read_user_buf_,
+                             compressed_read_user_buf_len_);
+    if (rv != 0) {
+      return rv;
+    }
+    compressed_read_buf_ = NaiveBufferPool::Acquire(kMaxBufferSize);
+    current_stats.buffers_acquired++;
+    rv = ReadFrames(
+        compressed_read_buf_.get(), compressed_read_buf_->size(),
+        base::BindOnce(&NaivePaddingSocket::OnReadCompressedComplete,
+                       base::Unretained(this)));
+    if (rv == ERR_IO_PENDING) {
+      return rv;
+    }
+    if (rv <= 0) {
+      compressed_read_buf_ = nullptr;
+      return rv;
+    }
+    compressed_input_ = base::MakeRefCounted<DrainableIOBuffer>(
+        std::move(compressed_read_buf_), rv);
+  }
+}
+
+void NaivePaddingSocket::OnReadCompressedComplete(int rv) {
+  DCHECK_NE(ERR_IO_PENDING, rv);
+  DCHECK(compressed_read_callback_);
+  DCHECK(compressed_read_user_buf_ != nullptr);
+
+  if (rv > 0) {
+    compressed_input_ = base::MakeRefCounted<DrainableIOBuffer>(
+        std::move(compressed_read_buf_), rv);
+    rv = ReadCompressedPayload();
+    if (rv == ERR_IO_PENDING)
+      return;
+  }
+  compressed_read_buf_ = nullptr;
+
+  // Must reset compressed_read_user_buf_ before invoking
+  // compressed_read_callback_, which may reenter Read().
+  compressed_read_user_buf_ = nullptr;
+
+  std::move(compressed_read_callback_).Run(rv);
+}
+
+int NaivePaddingSocket::ReadIfReadyCompressed(IOBuffer* buf,
+                                              int buf_len,
+                                              CompletionOnceCallback callback) {
+  DCHECK(!compressed_read_callback_);
+
+  for (;;) {
+    int rv = DecompressInput(buf, buf_len);
+    if (rv != 0) {
+      return rv;
+    }
+    // Acquired only for the frames ready to be read, so an idle tunnel holds
+    // no buffer.
+    scoped_refptr<IOBuffer> read_buf =
+        NaiveBufferPool::Acquire(kMaxBufferSize);
+    current_stats.buffers_acquired++;
+    rv = ReadIfReadyFrames(
+        read_buf.get(), read_buf->size(),
+        base::BindOnce(&NaivePaddingSocket::OnReadIfReadyCompressedComplete,
+                       base::Unretained(this)));
+    if (rv == ERR_IO_PENDING) {
+      compressed_read_callback_ = std::move(callback);
+      return rv;
+    }
+    if (rv <= 0) {
+      return rv;
+    }
+    compressed_input_ =
+        base::MakeRefCounted<DrainableIOBuffer>(std::move(read_buf), rv);
+  }
+}
+
+void NaivePaddingSocket::OnReadIfReadyCompressedComplete(int rv) {
+  DCHECK_NE(ERR_IO_PENDING, rv);
+  DCHECK(compressed_read_callback_);
+
+  std::move(compressed_read_callback_).Run(rv);
+}
+
+int NaivePaddingSocket::DecompressInput(IOBuffer* buf, int buf_len) {
+  base::span<const char> input;
+  if (compressed_input_) {
+    input = base::span<const char>(compressed_input_->data(),
+                                   compressed_input_->BytesRemaining());
+  }
+  int input_used = 0;
+  int rv = compressor_->Decompress(input, &input_used, buf->data(), buf_len);
+  if (compressed_input_) {
+    compressed_input_->DidConsume(input_used);
+    if (compressed_input_->BytesRemaining() == 0) {
+      compressed_input_ = nullptr;
+    }
+  }
+  return rv;
+}
+
+int NaivePaddingSocket::WriteCompressed(
+    IOBuffer* buf,
+    int buf_len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  TRACE_EVENT("naive", "NaivePaddingSocket::WriteCompressed", "size",
+              buf_len);
+  DCHECK(compressed_write_buf_ == nullptr);
+
+  // Longer writes are taken in part, as short writes are.
+  int payload_len = std::min(buf_len, NaiveCompressor::kMaxPayloadSize);
+  scoped_refptr<IOBuffer> frame =
+      NaiveBufferPool::Acquire(NaiveCompressor::GetMaxFrameSize(payload_len));
+  current_stats.buffers_acquired++;
+  int rv = compressor_->Compress(
+      base::span<const char>(buf->data(), static_cast<size_t>(payload_len)),
+      frame->data());
+  if (rv < 0) {
+    return rv;
+  }
+  compressed_write_buf_ =
+      base::MakeRefCounted<DrainableIOBuffer>(std::move(frame), rv);
+  compressed_write_payload_len_ = payload_len;
+
+  rv = WriteCompressedDrain(traffic_annotation);
+  if (rv == ERR_IO_PENDING) {
+    compressed_write_callback_ = std::move(callback);
+    return rv;
+  }
+
+  compressed_write_buf_ = nullptr;
+  compressed_write_payload_len_ = 0;
+
+  return rv;
+}
+
+int NaivePaddingSocket::WriteCompressedDrain(
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  DCHECK(compressed_write_buf_ != nullptr);
+
+  // Reports the payload written once all of its frame is, as part of a
+  // frame stands for no part of the payload.
+  while (compressed_write_buf_->BytesRemaining() > 0) {
+    int rv = WriteFrames(
+        compressed_write_buf_.get(), compressed_write_buf_->BytesRemaining(),
+        base::BindOnce(&NaivePaddingSocket::OnWriteCompressedComplete,
+                       base::Unretained(this), traffic_annotation),
+        traffic_annotation);
+    if (rv <= 0) {
+      return rv;
+    }
+    compressed_write_buf_->DidConsume(rv);
+  }
+  return compressed_write_payload_len_;
+}
+
+void NaivePaddingSocket::OnWriteCompressedComplete(
+    const NetworkTrafficAnnotationTag& traffic_annotation,
+    int rv) {
+  DCHECK_NE(ERR_IO_PENDING, rv);
+  DCHECK(compressed_write_buf_ != nullptr);
+
+  if (rv > 0) {
+    compressed_write_buf_->DidConsume(rv);
+    rv = WriteCompressedDrain(traffic_annotation);
+    if (rv == ERR_IO_PENDING)
+      return;
+  }
+
+  // Must reset these before invoking compressed_write_callback_, which may
+  // reenter Write().
+  compressed_write_buf_ = nullptr;
+  compressed_write_payload_len_ = 0;
+
+  std::move(compressed_write_callback_).Run(rv);
+}
+
 }  // namespace net
@@ -5,10 +5,12 @@
 #define NET_TOOLS_NAIVE_NAIVE_PADDING_SOCKET_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
 
+#include "base/containers/span.h"
 #include "base/memory/scoped_refptr.h"
 #include "net/base/address_list.h"
 #include "net/base/completion_once_callback.h"
@@ -18,18 +20,53 @@
 #include "net/base/net_errors.h"
 #include "net/base/net_export.h"
 #include "net/socket/stream_socket.h"
+#include "net/tools/naive/naive_compressor.h"
 #include "net/tools/naive/naive_padding_framer.h"
+#include "net/tools/naive/naive_padding_profile.h"
 #include "net/tools/naive/naive_protocol.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
 #include "url/gurl.h"
 
 namespace net {
 
+// With PaddingLimits::compression, the payloads are framed and compressed
+// by a NaiveCompressor before they are padded, and the compressed frames are
+// decoded after the padding is removed.
 class NaivePaddingSocket {
  public:
+  // Bytes a caller of WriteInPlace() keeps free before and after the payload
+  // for the frame header and the padding.
+  static constexpr int kWriteHeadroom = 3;
+  static constexpr int kWriteTailroom = 255;
+
+  // Counters of the padding sockets on the current thread. Frames are counted
+  // when their socket is destroyed.
+  struct Stats {
+    uint64_t frames_written = 0;
+    uint64_t frames_read = 0;
+    uint64_t padding_bytes_written = 0;
+    uint64_t padding_bytes_read = 0;
+    // Writes copied into the frame of an earlier write, with kVariant2.
+    uint64_t coalesced_writes = 0;
+    // Pooled buffers acquired to copy payloads into frames. Writes framed
+    // in place acquire none.
+    uint64_t buffers_acquired = 0;
+    // Of the sockets negotiated with compression. The ratio of each is its
+    // payload bytes over its compressed frame bytes, both ways.
+    uint64_t compressed_tunnels = 0;
+    double compression_ratio_sum = 0;
+    uint64_t compression_payload_bytes = 0;
+    uint64_t compression_frame_bytes = 0;
+  };
+
+  static const Stats& GetStatsForCurrentThread();
+
+  // `padding_profile` must outlive the socket.
   NaivePaddingSocket(StreamSocket* transport_socket,
                      PaddingType padding_type,
-                     Direction direction);
+                     Direction direction,
+                     const PaddingLimits& padding_limits,
+                     const NaivePaddingProfile& padding_profile);
 
   NaivePaddingSocket(const NaivePaddingSocket&) = delete;
   NaivePaddingSocket& operator=(const NaivePaddingSocket&) = delete;
@@ -39,14 +76,103 @@ class NaivePaddingSocket {
 
   void Disconnect();
 
+  // Same semantics as StreamSocket::ShutdownWrite(). Must not be called
+  // before Flush() completes.
+  int ShutdownWrite();
+
+  // Waits for writes that completed early to be sent. Returns OK if there are
+  // none, or the error of sending them, which later writes also return.
+  int Flush(CompletionOnceCallback callback);
+
   int Read(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
 
+  // Same semantics as StreamSocket::ReadIfReady(). Returns
+  // ERR_READ_IF_READY_NOT_IMPLEMENTED if the transport socket does not
+  // support it, in which case the caller should use Read().
+  int ReadIfReady(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
+  int CancelReadIfReady();
+
+  // Same semantics as StreamSocket::ReadBuffer(). Returns ERR_NOT_IMPLEMENTED
+  // while reads are framed or compressed, as the payload has to be parsed out
+  // of them.
+  int ReadBuffer(int max_len,
+                 scoped_refptr<IOBuffer>* buf,
+                 CompletionOnceCallback callback);
+  // Same semantics as StreamSocket::LendReadBuffer(), and likewise
+  // unavailable while reads are framed or compressed.
+  int LendReadBuffer(int max_len,
+                     base::span<const char>* data,
+                     CompletionOnceCallback callback);
+  void ConsumeLentBuffer(int len);
+
+  // With kVariant2, small padded writes may complete before they are sent,
+  // and the writes that follow are coalesced into the next padding frame
+  // until then. A failure to send them is returned by the next write or
+  // Flush().
   int Write(IOBuffer* buf,
             int buf_len,
             CompletionOnceCallback callback,
             const NetworkTrafficAnnotationTag& traffic_annotation);
 
+  // Returns true if the next write is sent as a padding frame of its own
+  // payload, which WriteInPlace() can build. False while compressing.
+  bool IsWritePadded() const;
+
+  // Return the transport socket once reads from it are no longer framed, or
+  // once writes are no longer padded and none is left in this socket, so
+  // the caller can use it directly from then on. Null until then, and
+  // always while compressing.
+  StreamSocket* GetUnframedReadSocket() const;
+  StreamSocket* GetUnframedWriteSocket() const;
+
+  // Same as Write() but the payload is framed in `frame_buf` without being
+  // copied. The payload starts at kWriteHeadroom and `frame_buf` has at least
+  // kWriteTailroom bytes after it. Writes all of the payload or fails.
+  // Only valid while IsWritePadded().
+  int WriteInPlace(scoped_refptr<IOBuffer> frame_buf,
+                   int payload_len,
+                   CompletionOnceCallback callback,
+                   const NetworkTrafficAnnotationTag& traffic_annotation);
+
+  // Returns the bytes held by this socket, with its framer, its compressor
+  // and the frames waiting to be sent.
+  size_t EstimateMemoryUsage() const;
+
  private:
+  // Read(), ReadIfReady() and Write() under the compressor: of the
+  // compressed frames, or of the payload without compression.
+  int ReadFrames(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
+  int ReadIfReadyFrames(IOBuffer* buf,
+                        int buf_len,
+                        CompletionOnceCallback callback);
+  int WriteFrames(IOBuffer* buf,
+                  int buf_len,
+                  CompletionOnceCallback callback,
+                  const NetworkTrafficAnnotationTag& traffic_annotation);
+
+  int ReadCompressed(IOBuffer* buf,
+                     int buf_len,
+                     CompletionOnceCallback callback);
+  // Reads compressed frames until some payload is decoded.
+  int ReadCompressedPayload();
+  void OnReadCompressedComplete(int rv);
+  int ReadIfReadyCompressed(IOBuffer* buf,
+                            int buf_len,
+                            CompletionOnceCallback callback);
+  void OnReadIfReadyCompressedComplete(int rv);
+  // Decodes compressed_input_ into `buf`. Returns zero if more is needed.
+  int DecompressInput(IOBuffer* buf, int buf_len);
+
+  int WriteCompressed(IOBuffer* buf,
+                      int buf_len,
+                      CompletionOnceCallback callback,
+                      const NetworkTrafficAnnotationTag& traffic_annotation);
+  int WriteCompressedDrain(
+      const NetworkTrafficAnnotationTag& traffic_annotation);
+  void OnWriteCompressedComplete(
+      const NetworkTrafficAnnotationTag& traffic_annotation,
+      int rv);
+
   int ReadNoPadding(IOBuffer* buf,
                     int buf_len,
                     CompletionOnceCallback callback);
@@ -54,11 +180,6 @@ class NaivePaddingSocket {
                      int buf_len,
                      CompletionOnceCallback callback,
                      const NetworkTrafficAnnotationTag& traffic_annotation);
-  void OnReadNoPaddingComplete(CompletionOnceCallback callback, int rv);
-  void OnWriteNoPaddingComplete(
-      CompletionOnceCallback callback,
-      const NetworkTrafficAnnotationTag& traffic_annotation,
-      int rv);
 
   int ReadPaddingV1(IOBuffer* buf,
                     int buf_len,
@@ -68,6 +189,10 @@ class NaivePaddingSocket {
                      CompletionOnceCallback callback,
                      const NetworkTrafficAnnotationTag& traffic_annotation);
   void OnReadPaddingV1Complete(int rv);
+  int ReadIfReadyPaddingV1(IOBuffer* buf,
+                           int buf_len,
+                           CompletionOnceCallback callback);
+  void OnReadIfReadyPaddingV1Complete(int rv);
   void OnWritePaddingV1Complete(
       const NetworkTrafficAnnotationTag& traffic_annotation,
       int rv);
@@ -76,9 +201,40 @@ class NaivePaddingSocket {
   // so this does not return zero for non-EOF condition.
   int ReadPaddingV1Payload();
 
+  // Returns true if the bytes read next are framed. Both variants read the
+  // same frames, so this does not depend on `padding_type_`.
+  bool IsReadFramed() const;
+
+  // Returns true if the next frame the framer writes is padded.
+  bool IsWriteFramed() const;
+
+  int GetWritePaddingSize(int payload_len);
+
+  // Writes the padding frame in write_buf_, for `payload_len` bytes of
+  // payload.
+  int WritePaddingV1Frame(int payload_len,
+                          CompletionOnceCallback callback,
+                          const NetworkTrafficAnnotationTag& traffic_annotation);
+
   int WritePaddingV1Drain(
       const NetworkTrafficAnnotationTag& traffic_annotation);
 
+  // Coalesces a write into `coalesced_buf_` while the write of an earlier
+  // frame completed early is still in progress, or holds it until then if
+  // it does not fit. `in_place` is as in WriteInPlace().
+  int WritePaddingV2Coalesced(
+      scoped_refptr<IOBuffer> buf,
+      int buf_len,
+      bool in_place,
+      CompletionOnceCallback callback,
+      const NetworkTrafficAnnotationTag& traffic_annotation);
+
+  // Sends the coalesced frame after the write completed early finishes, then
+  // resumes the held write or the flush.
+  void FlushCoalescedWrites(
+      const NetworkTrafficAnnotationTag& traffic_annotation);
+  void OnHeldWriteComplete(int rv);
+
   // Stores the underlying socket.
   // Non-owning because this socket does not take part in the client socket pool
   // handling and making it owning the transport socket may interfere badly
@@ -87,17 +243,51 @@ class NaivePaddingSocket {
 
   PaddingType padding_type_;
   Direction direction_;
+  PaddingLimits padding_limits_;
+  const NaivePaddingProfile& padding_profile_;
 
   IOBuffer* read_user_buf_ = nullptr;
   int read_user_buf_len_ = 0;
   CompletionOnceCallback read_callback_;
-  scoped_refptr<IOBuffer> read_buf_;
 
   int write_user_payload_len_ = 0;
   CompletionOnceCallback write_callback_;
   scoped_refptr<DrainableIOBuffer> write_buf_;
 
-  NaivePaddingFramer framer_;
+  // Payloads of writes completed early, framed in place once write_buf_ is
+  // sent.
+  scoped_refptr<IOBuffer> coalesced_buf_;
+  int coalesced_len_ = 0;
+
+  // A write that did not fit coalesced_buf_.
+  scoped_refptr<IOBuffer> held_buf_;
+  int held_len_ = 0;
+  bool held_in_place_ = false;
+  CompletionOnceCallback held_callback_;
+
+  CompletionOnceCallback flush_callback_;
+
+  // The error of a write completed early, returned by the next write.
+  int write_error_ = OK;
+
+  // Only for padding types other than kNone.
+  std::unique_ptr<NaivePaddingFramer> framer_;
+
+  // Only with compression.
+  std::unique_ptr<NaiveCompressor> compressor_;
+
+  IOBuffer* compressed_read_user_buf_ = nullptr;
+  int compressed_read_user_buf_len_ = 0;
+  CompletionOnceCallback compressed_read_callback_;
+  // Being read into from the frames, then kept as compressed_input_ until
+  // decoded.
+  scoped_refptr<IOBuffer> compressed_read_buf_;
+  scoped_refptr<DrainableIOBuffer> compressed_input_;
+
+  // The frame of the payload being written.
+  scoped_refptr<DrainableIOBuffer> compressed_write_buf_;
+  int compressed_write_payload_len_ = 0;
+  CompletionOnceCallback compressed_write_callback_;
 };
 
 }  // namespace net
@@ -0,0 +1,90 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_popular_hosts.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "base/hash/hash.h"
+
+namespace net {
+
+NaivePopularHosts::NaivePopularHosts(size_t top_size) : top_size_(top_size) {}
+
+NaivePopularHosts::~NaivePopularHosts() = default;
+
+std::array<size_t, NaivePopularHosts::kDepth> NaivePopularHosts::Cells(
+    const std::string& key) const {
+  // Double hashing gives the rows independent enough cells.
+  size_t h1 = base::FastHash(key);
+  size_t h2 = base::PersistentHash(key) | 1;
+  std::array<size_t, kDepth> cells;
+  for (size_t i = 0; i < kDepth; ++i)
+    cells[i] = (h1 + i * h2) % kWidth;
+  return cells;
+}
+
+bool NaivePopularHosts::Record(const std::string& key) {
+  std::array<size_t, kDepth> cells = Cells(key);
+  uint32_t estimate = std::numeric_limits<uint32_t>::max();
+  for (size_t i = 0; i < kDepth; ++i)
+    estimate = std::min(estimate, counts_[i][cells[i]]);
+  if (estimate == std::numeric_limits<uint32_t>::max())
+    return top_.contains(key);
+  // Conservative update: only the cells that gave the estimate grow, which
+  // keeps the other hosts sharing them from being overestimated.
+  for (size_t i = 0; i < kDepth; ++i) {
+    if (counts_[i][cells[i]] == estimate)
+      ++counts_[i][cells[i]];
+  }
+  ++estimate;
+
+  auto it = top_.find(key);
+  if (it != top_.end()) {
+    it->second = estimate;
+    return true;
+  }
+  if (top_.size() < top_size_) {
+    top_.emplace(key, estimate);
+    return true;
+  }
+  auto least = std::min_element(
+      top_.begin(), top_.end(),
+      [](const auto& a, const auto& b) { return a.second < b.second; });
+  if (least == top_.end() || least->second >= estimate)
+    return false;
+  top_.erase(least);
+  top_.emplace(key, estimate);
+  return true;
+}
+
+void NaivePopularHosts::Decay() {
+  for (auto& row : counts_) {
+    for (uint32_t& count : row)
+      count /= 2;
+  }
+  // Hosts not looked up since the last decays have nothing to prefer them.
+  for (auto it = top_.begin(); it != top_.end();) {
+    it->second /= 2;
+    if (it->second == 0)
+      it = top_.erase(it);
+    else
+      ++it;
+  }
+}
+
+std::vector<std::string> NaivePopularHosts::GetTop() const {
+  std::vector<std::string> top;
+  top.reserve(top_.size());
+  for (const auto& [key, count] : top_)
+    top.push_back(key);
+  return top;
+}
+
+uint32_t NaivePopularHosts::GetCount(const std::string& key) const {
+  auto it = top_.find(key);
+  return it != top_.end() ? it->second : 0;
+}
+
+}  // namespace net
@@ -0,0 +1,49 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_POPULAR_HOSTS_H_
+#define NET_TOOLS_NAIVE_NAIVE_POPULAR_HOSTS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace net {
+
+// Estimates how often hosts are looked up, and keeps the `top_size` most
+// looked up ones. Counts are kept in a count-min sketch, so memory does not
+// grow with the number of hosts, and halved by Decay() so hosts no longer
+// looked up drop out.
+class NaivePopularHosts {
+ public:
+  static constexpr size_t kDepth = 4;
+  static constexpr size_t kWidth = 4096;
+
+  explicit NaivePopularHosts(size_t top_size);
+  ~NaivePopularHosts();
+  NaivePopularHosts(const NaivePopularHosts&) = delete;
+  NaivePopularHosts& operator=(const NaivePopularHosts&) = delete;
+
+  // Counts a lookup of `key`. Returns whether it is now one of the top.
+  bool Record(const std::string& key);
+  // Halves all counts. Top hosts whose count becomes 0 are dropped.
+  void Decay();
+  // In no particular order.
+  std::vector<std::string> GetTop() const;
+  // Returns the estimated count of `key` if it is one of the top, or 0.
+  uint32_t GetCount(const std::string& key) const;
+
+ private:
+  std::array<size_t, kDepth> Cells(const std::string& key) const;
+
+  const size_t top_size_;
+  std::array<std::array<uint32_t, kWidth>, kDepth> counts_ = {};
+  // Estimated counts of the top hosts.
+  std::map<std::string, uint32_t> top_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_POPULAR_HOSTS_H_
@@ -0,0 +1,115 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_priority_rules.h"
+
+#include <limits>
+
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "net/http/http_proxy_connect_job.h"
+
+namespace net {
+
+std::optional<TunnelPriority> ParseTunnelPriority(std::string_view str) {
+  if (str == "bulk") {
+    return TunnelPriority::kBulk;
+  } else if (str == "default") {
+    return TunnelPriority::kDefault;
+  } else if (str == "interactive") {
+    return TunnelPriority::kInteractive;
+  }
+  return std::nullopt;
+}
+
+RequestPriority ToRequestPriority(TunnelPriority value) {
+  switch (value) {
+    case TunnelPriority::kBulk:
+      return IDLE;
+    case TunnelPriority::kDefault:
+      return HttpProxyConnectJob::kH2QuicTunnelPriority;
+    case TunnelPriority::kInteractive:
+      return HIGHEST;
+  }
+}
+
+std::optional<NaivePriorityDscps> ParsePriorityDscps(std::string_view str) {
+  NaivePriorityDscps dscps = kNoPriorityDscps;
+  for (std::string_view dscp_str : base::SplitStringPiece(
+           str, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL)) {
+    size_t colon = dscp_str.find(':');
+    if (colon == std::string_view::npos) {
+      return std::nullopt;
+    }
+    std::optional<TunnelPriority> priority =
+        ParseTunnelPriority(dscp_str.substr(0, colon));
+    int dscp = 0;
+    if (!priority.has_value() ||
+        !base::StringToInt(dscp_str.substr(colon + 1), &dscp) || dscp < 0 ||
+        dscp > 63) {
+      return std::nullopt;
+    }
+    dscps[static_cast<size_t>(*priority)] =
+        static_cast<DiffServCodePoint>(dscp);
+  }
+  return dscps;
+}
+
+NaivePriorityRules::NaivePriorityRules() = default;
+
+NaivePriorityRules::NaivePriorityRules(const NaivePriorityRules&) = default;
+
+NaivePriorityRules& NaivePriorityRules::operator=(const NaivePriorityRules&) =
+    default;
+
+NaivePriorityRules::~NaivePriorityRules() = default;
+
+// static
+std::optional<NaivePriorityRules> NaivePriorityRules::Parse(
+    std::string_view str) {
+  std::vector<std::string_view> rule_strs = base::SplitStringPiece(
+      str, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+
+  NaivePriorityRules rules;
+  for (std::string_view rule_str : rule_strs) {
+    size_t colon = rule_str.find(':');
+    if (colon == std::string_view::npos) {
+      return std::nullopt;
+    }
+    std::optional<TunnelPriority> priority =
+        ParseTunnelPriority(rule_str.substr(colon + 1));
+    if (!priority.has_value()) {
+      return std::nullopt;
+    }
+    std::vector<std::string_view> bounds =
+        base::SplitStringPiece(rule_str.substr(0, colon), "-",
+                               base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+    if (bounds.empty() || bounds.size() > 2) {
+      return std::nullopt;
+    }
+    int min_port = 0;
+    int max_port = 0;
+    if (!base::StringToInt(bounds.front(), &min_port) ||
+        !base::StringToInt(bounds.back(), &max_port)) {
+      return std::nullopt;
+    }
+    if (min_port < 1 || min_port > max_port ||
+        max_port > std::numeric_limits<uint16_t>::max()) {
+      return std::nullopt;
+    }
+    rules.rules_.push_back({static_cast<uint16_t>(min_port),
+                            static_cast<uint16_t>(max_port), *priority});
+  }
+  return rules;
+}
+
+TunnelPriority NaivePriorityRules::Find(uint16_t port,
+                                        TunnelPriority fallback) const {
+  for (const Rule& rule : rules_) {
+    if (port >= rule.min_port && port <= rule.max_port)
+      return rule.priority;
+  }
+  return fallback;
+}
+
+}  // namespace net
@@ -0,0 +1,78 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_PRIORITY_RULES_H_
+#define NET_TOOLS_NAIVE_NAIVE_PRIORITY_RULES_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "net/base/request_priority.h"
+#include "net/socket/diff_serv_code_point.h"
+
+namespace net {
+
+// Priority class of a tunnel. It becomes the HTTP/2 or HTTP/3 priority of
+// the tunnel stream, so the writes of interactive tunnels go ahead of bulk
+// ones sharing the tunnel session, and the proxy is asked to do the same.
+enum class TunnelPriority {
+  kBulk,
+  // Keeps the priority the network stack opens tunnels with.
+  kDefault,
+  kInteractive,
+};
+
+inline constexpr size_t kNumTunnelPriorities = 3;
+
+// Parses "bulk", "default" or "interactive". Returns empty if `str` is
+// invalid.
+std::optional<TunnelPriority> ParseTunnelPriority(std::string_view str);
+
+RequestPriority ToRequestPriority(TunnelPriority value);
+
+// DSCP marks of the packets carrying the tunnels of each priority class,
+// indexed by TunnelPriority. DSCP_NO_CHANGE for the classes left unmarked.
+using NaivePriorityDscps = std::array<DiffServCodePoint, kNumTunnelPriorities>;
+
+inline constexpr NaivePriorityDscps kNoPriorityDscps = {
+    DSCP_NO_CHANGE, DSCP_NO_CHANGE, DSCP_NO_CHANGE};
+
+// Parses <CLASS>":"<DSCP>[","...], e.g. "interactive:46,bulk:8", with DSCP
+// in [0, 63]. Returns empty if `str` is invalid.
+std::optional<NaivePriorityDscps> ParsePriorityDscps(std::string_view str);
+
+// Priority classes of tunnels by destination port.
+class NaivePriorityRules {
+ public:
+  // Constructs empty rules.
+  NaivePriorityRules();
+  NaivePriorityRules(const NaivePriorityRules&);
+  NaivePriorityRules& operator=(const NaivePriorityRules&);
+  ~NaivePriorityRules();
+
+  // Parses `str` in the form of <PORT>["-"<PORT>]":"<CLASS>[","...].
+  // Returns empty if `str` is invalid.
+  static std::optional<NaivePriorityRules> Parse(std::string_view str);
+
+  bool empty() const { return rules_.empty(); }
+
+  // Returns the class of the first rule covering `port`, or `fallback` if
+  // none does.
+  TunnelPriority Find(uint16_t port, TunnelPriority fallback) const;
+
+ private:
+  struct Rule {
+    uint16_t min_port = 0;
+    uint16_t max_port = 0;
+    TunnelPriority priority = TunnelPriority::kDefault;
+  };
+
+  std::vector<Rule> rules_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_PRIORITY_RULES_H_
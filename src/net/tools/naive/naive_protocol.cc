@@ -3,10 +3,16 @@
 // found in the LICENSE file.
 #include "net/tools/naive/naive_protocol.h"
 
+#include <algorithm>
 #include <optional>
 #include <string>
+#include <vector>
 
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_piece.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
 
 namespace net {
 const char* ToString(ClientProtocol value) {
@@ -17,6 +23,14 @@ const char* ToString(ClientProtocol value) {
       return "http";
     case ClientProtocol::kRedir:
       return "redir";
+    case ClientProtocol::kHttps:
+      return "https";
+    case ClientProtocol::kQuic:
+      return "quic";
+    case ClientProtocol::kTun:
+      return "tun";
+    case ClientProtocol::kTproxy:
+      return "tproxy";
     default:
       return "";
   }
@@ -27,6 +41,8 @@ std::optional<PaddingType> ParsePaddingType(std::string_view str) {
     return PaddingType::kNone;
   } else if (str == "1") {
     return PaddingType::kVariant1;
+  } else if (str == "2") {
+    return PaddingType::kVariant2;
   } else {
     return std::nullopt;
   }
@@ -38,6 +54,8 @@ const char* ToString(PaddingType value) {
       return "0";
     case PaddingType::kVariant1:
       return "1";
+    case PaddingType::kVariant2:
+      return "2";
     default:
       return "";
   }
@@ -49,9 +67,143 @@ const char* ToReadableString(PaddingType value) {
       return "None";
     case PaddingType::kVariant1:
       return "Variant1";
+    case PaddingType::kVariant2:
+      return "Variant2";
     default:
       return "";
   }
 }
 
+std::optional<Compression> ParseCompression(std::string_view str) {
+  if (str == "zstd") {
+    return Compression::kZstd;
+  } else {
+    return std::nullopt;
+  }
+}
+
+const char* ToString(Compression value) {
+  switch (value) {
+    case Compression::kNone:
+      return "none";
+    case Compression::kZstd:
+      return "zstd";
+    default:
+      return "";
+  }
+}
+
+std::optional<std::pair<PaddingType, PaddingLimits>> ParsePaddingTypeReply(
+    std::string_view str) {
+  std::vector<std::string_view> parts = base::SplitStringPiece(
+      str, ";", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+  std::optional<PaddingType> padding_type = ParsePaddingType(parts.front());
+  if (!padding_type.has_value()) {
+    return std::nullopt;
+  }
+
+  PaddingLimits limits;
+  for (size_t i = 1; i < parts.size(); ++i) {
+    size_t eq = parts[i].find('=');
+    std::string_view key = parts[i].substr(0, eq);
+    std::string_view value_str =
+        eq == std::string_view::npos ? "" : parts[i].substr(eq + 1);
+    int value = 0;
+    if (key == "compression") {
+      std::optional<Compression> compression = ParseCompression(value_str);
+      if (!compression.has_value()) {
+        return std::nullopt;
+      }
+      limits.compression = *compression;
+    } else if (*padding_type != PaddingType::kVariant2) {
+      // Other padding types use the default extent.
+    } else if (key == "frames") {
+      if (!base::StringToInt(value_str, &value) || value < 0 ||
+          value > PaddingLimits::kMaxFrames) {
+        return std::nullopt;
+      }
+      limits.frames = value;
+    } else if (key == "budget") {
+      if (!base::StringToInt(value_str, &value) || value < 0) {
+        return std::nullopt;
+      }
+      limits.budget = value;
+    }
+    // Ignores unknown parameters from newer servers.
+  }
+  return std::make_pair(*padding_type, limits);
+}
+
+std::string ToPaddingTypeReply(PaddingType padding_type,
+                               const PaddingLimits& limits) {
+  std::string reply = ToString(padding_type);
+  if (padding_type == PaddingType::kVariant2) {
+    base::StringAppendF(&reply, "; frames=%d; budget=%d", limits.frames,
+                        limits.budget);
+  }
+  if (limits.compression != Compression::kNone) {
+    base::StringAppendF(&reply, "; compression=%s",
+                        ToString(limits.compression));
+  }
+  return reply;
+}
+
+std::optional<PaddingType> SelectClientPaddingType(
+    bool has_padding,
+    std::optional<std::string_view> padding_type_request,
+    const std::vector<PaddingType>& supported_padding_types) {
+  if (!padding_type_request.has_value()) {
+    // Backward compatibility with before kVariant1 when the padding-version
+    // header does not exist.
+    if (has_padding) {
+      return PaddingType::kVariant1;
+    } else {
+      return PaddingType::kNone;
+    }
+  }
+
+  std::vector<std::string_view> padding_type_strs = base::SplitStringPiece(
+      *padding_type_request, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+  for (std::string_view padding_type_str : padding_type_strs) {
+    std::optional<PaddingType> padding_type =
+        ParsePaddingType(padding_type_str);
+    if (!padding_type.has_value()) {
+      LOG(ERROR) << "Invalid padding type: " << padding_type_str;
+      return std::nullopt;
+    }
+    if (std::find(supported_padding_types.begin(),
+                  supported_padding_types.end(),
+                  *padding_type) != supported_padding_types.end()) {
+      return padding_type;
+    }
+  }
+  LOG(ERROR) << "No padding type is supported: " << *padding_type_request;
+  return std::nullopt;
+}
+
+PaddingLimits SelectClientPaddingLimits(
+    PaddingType padding_type,
+    std::optional<std::string_view> padding_type_request,
+    std::optional<std::string_view> compression_request,
+    const PaddingLimits& listen_limits) {
+  PaddingLimits limits = padding_type == PaddingType::kVariant2
+                             ? listen_limits
+                             : PaddingLimits();
+  limits.compression = Compression::kNone;
+  if (!padding_type_request.has_value() || !compression_request.has_value() ||
+      listen_limits.compression == Compression::kNone) {
+    return limits;
+  }
+  for (std::string_view compression_str :
+       base::SplitStringPiece(*compression_request, ",",
+                              base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL)) {
+    // Ignores compressions unknown to this server.
+    if (ParseCompression(compression_str) == listen_limits.compression) {
+      limits.compression = listen_limits.compression;
+      break;
+    }
+  }
+  return limits;
+}
+
 }  // namespace net
@@ -7,12 +7,23 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace net {
 enum class ClientProtocol {
   kSocks5,
   kHttp,
   kRedir,
+  // HTTP/2 over TLS, with a tunnel per CONNECT stream.
+  kHttps,
+  // HTTP/3, with a tunnel per CONNECT stream.
+  kQuic,
+  // TCP connections read off a TUN device, to their original destination.
+  kTun,
+  // TCP connections and UDP datagrams delivered by TPROXY rules, to their
+  // original destination.
+  kTproxy,
 };
 
 const char* ToString(ClientProtocol value);
@@ -41,6 +52,13 @@ enum class PaddingType {
   // };
   // Wire format: "1".
   kVariant1 = 1,
+
+  // Same frames as kVariant1, for as many reads and writes as the
+  // negotiated PaddingLimits allow. The writer picks padding sizes from its
+  // padding profile and may coalesce several small writes into one frame, so
+  // the reader must not assume frames line up with the peer's writes.
+  // Wire format: "2".
+  kVariant2 = 2,
 };
 
 // Returns empty if `str` is invalid.
@@ -50,14 +68,97 @@ const char* ToString(PaddingType value);
 
 const char* ToReadableString(PaddingType value);
 
+enum class Compression {
+  kNone = 0,
+
+  // The payloads of both directions are framed by NaiveCompressor, and
+  // compressed with zstd unless they do not compress.
+  // Wire format: "zstd".
+  kZstd = 1,
+};
+
+// Returns empty if `str` is invalid.
+std::optional<Compression> ParseCompression(std::string_view str);
+
+const char* ToString(Compression value);
+
+// Extent of the padding frames at the start of each direction, and the
+// compression of the payloads inside them. Only kVariant2 negotiates the
+// extent, in the reply: "2; frames=<N>; budget=<BYTES>". Other padding types
+// use the defaults. Compression is negotiated for any padding type, by
+// appending "; compression=zstd" to the reply.
+struct PaddingLimits {
+  static constexpr int kDefaultFrames = 8;
+  static constexpr int kMaxFrames = 1024;
+
+  // Number of padded frames.
+  int frames = kDefaultFrames;
+
+  // Stops after the frame that brings the padding bytes to this many.
+  // Zero means no limit.
+  int budget = 0;
+
+  Compression compression = Compression::kNone;
+
+  bool operator==(const PaddingLimits&) const = default;
+};
+
+// Parses the value of kPaddingTypeReplyHeader. Returns empty if `str` is
+// invalid.
+// Kernel send buffering of the relay sockets of a listener: the accepted
+// ones, and the server sides of direct connections. Less buffering lets
+// backpressure reach the other side sooner. Zero keeps the kernel default.
+struct RelaySocketOptions {
+  // SO_SNDBUF, in bytes.
+  int send_buffer_size = 0;
+  // TCP_NOTSENT_LOWAT, in bytes. No effect where the kernel lacks it.
+  int not_sent_lowat = 0;
+  // MSG_ZEROCOPY for large writes. No effect outside Linux.
+  bool zero_copy = false;
+  // SO_BUSY_POLL, in microseconds. No effect outside Linux.
+  int busy_poll = 0;
+};
+
+std::optional<std::pair<PaddingType, PaddingLimits>> ParsePaddingTypeReply(
+    std::string_view str);
+
+// Returns the value of kPaddingTypeReplyHeader.
+std::string ToPaddingTypeReply(PaddingType padding_type,
+                               const PaddingLimits& limits);
+
+// Picks the padding type of a tunnel from the padding headers of its
+// request: the first of `padding_type_request` in `supported_padding_types`,
+// or without that header, kVariant1 if there is a kPaddingHeader. Returns
+// empty if no requested type is supported or one is invalid.
+std::optional<PaddingType> SelectClientPaddingType(
+    bool has_padding,
+    std::optional<std::string_view> padding_type_request,
+    const std::vector<PaddingType>& supported_padding_types);
+
+// Returns the limits of a tunnel of `padding_type` on a listener offering
+// `listen_limits`, compressed if the request asks for the compression of the
+// listener in `compression_request`. Only requests with a
+// `padding_type_request` get a reply to confirm the compression.
+PaddingLimits SelectClientPaddingLimits(
+    PaddingType padding_type,
+    std::optional<std::string_view> padding_type_request,
+    std::optional<std::string_view> compression_request,
+    const PaddingLimits& listen_limits);
+
 constexpr const char* kPaddingHeader = "padding";
 
 // Contains a comma separated list of requested padding types.
 // Preferred types come first.
 constexpr const char* kPaddingTypeRequestHeader = "padding-type-request";
 
+// Contains a comma separated list of requested compressions. Sent apart from
+// kPaddingTypeRequestHeader, which older servers reject unknown values of.
+constexpr const char* kPaddingCompressionRequestHeader =
+    "padding-compression-request";
+
 // Contains a single number representing the negotiated padding type.
-// Must be one of PaddingType.
+// Must be one of PaddingType. Followed by the PaddingLimits for kVariant2,
+// and the negotiated compression if any.
 constexpr const char* kPaddingTypeReplyHeader = "padding-type-reply";
 
 }  // namespace net
@@ -5,6 +5,7 @@
 
 #include "net/tools/naive/naive_proxy.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
@@ -12,59 +13,182 @@
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/task/single_thread_task_runner.h"
+#include "base/trace_event/base_tracing.h"
 #include "net/base/load_flags.h"
 #include "net/base/net_errors.h"
 #include "net/http/http_network_session.h"
-#include "net/proxy_resolution/configured_proxy_resolution_service.h"
-#include "net/proxy_resolution/proxy_config.h"
-#include "net/proxy_resolution/proxy_list.h"
 #include "net/socket/client_socket_pool_manager.h"
 #include "net/socket/server_socket.h"
+#include "net/socket/ssl_server_socket.h"
 #include "net/socket/stream_socket.h"
+#include "net/socket/tcp_client_socket.h"
+#include "net/tools/naive/http2_proxy_server_session.h"
+#include "net/tools/naive/http3_proxy_server.h"
 #include "net/tools/naive/http_proxy_server_socket.h"
+#include "net/tools/naive/naive_allocator_profile.h"
 #include "net/tools/naive/naive_proxy_delegate.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+#include "net/tools/naive/naive_socket_watcher.h"
+#include "net/tools/naive/naive_udp_association.h"
 #include "net/tools/naive/socks5_server_socket.h"
 
+#if BUILDFLAG(IS_LINUX)
+#include "net/tools/naive/naive_tproxy.h"
+#endif
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+#include <sched.h>
+#endif
+
 namespace net {
+namespace {
+constexpr int kIdleTimerTickSeconds = 1;
+constexpr size_t kIdleTimerSlots = 64;
+// Retry delay of accepting after running out of file descriptors or memory,
+// which other threads may free. It doubles while accepting keeps failing.
+constexpr base::TimeDelta kMinAcceptRetryDelay = base::Milliseconds(250);
+constexpr base::TimeDelta kMaxAcceptRetryDelay = base::Seconds(8);
+
+bool IsResourceError(int result) {
+  return result == ERR_INSUFFICIENT_RESOURCES ||
+         result == ERR_OUT_OF_MEMORY || result == ERR_NO_BUFFER_SPACE;
+}
+
+// Counts `connection` and its relayed bytes for its destination and for the
+// user it authenticated as, if any.
+void AddConnectionCounts(const NaiveConnection& connection,
+                       NaiveListenerMetrics* metrics) {
+  uint64_t bytes = 0;
+  for (Direction from : {kClient, kServer}) {
+    bytes += connection.GetRelayedBytes(from);
+  }
+  const HostPortPair& origin = connection.origin();
+  if (!origin.IsEmpty()) {
+    metrics->top_destination_bytes.Add(origin.host(), bytes);
+    metrics->top_destination_tunnels.Add(origin.host(), 1);
+  }
+
+  const std::string& user = connection.user();
+  if (user.empty())
+    return;
+  metrics->top_user_bytes.Add(user, bytes);
+  metrics->top_user_tunnels.Add(user, 1);
+  NaiveListenerMetrics::UserMetrics& user_metrics = metrics->users[user];
+  user_metrics.connections++;
+  for (Direction from : {kClient, kServer}) {
+    user_metrics.relayed_bytes[from] += connection.GetRelayedBytes(from);
+  }
+}
+
+// Times the steps of setting up the tunnel of `connection` up to its server
+// side connecting.
+void AddConnectPhases(const NaiveConnection& connection,
+                      NaiveListenerMetrics* metrics) {
+  auto& latencies = metrics->setup_phase_latencies;
+  latencies[NaiveListenerMetrics::kClientHandshake].Add(
+      connection.client_connect_end_time() - connection.start_time());
+  latencies[NaiveListenerMetrics::kRequest].Add(
+      connection.server_connect_start_time() -
+      connection.client_connect_end_time());
+  latencies[NaiveListenerMetrics::kConnect].Add(
+      connection.server_connect_time());
+}
+
+// Times the first bytes relayed each way after the tunnel of `connection`
+// connected, if there were any.
+void AddFirstRelayPhases(const NaiveConnection& connection,
+                         NaiveListenerMetrics* metrics) {
+  base::TimeTicks connected_time = connection.server_connect_start_time() +
+                                   connection.server_connect_time();
+  for (Direction from : {kClient, kServer}) {
+    base::TimeTicks first_relay_time = connection.GetFirstRelayTime(from);
+    if (first_relay_time.is_null())
+      continue;
+    metrics
+        ->setup_phase_latencies[from == kClient
+                                    ? NaiveListenerMetrics::kFirstUpload
+                                    : NaiveListenerMetrics::kFirstDownload]
+        .Add(first_relay_time - connected_time);
+  }
+}
+}  // namespace
 
 NaiveProxy::NaiveProxy(std::unique_ptr<ServerSocket> listen_socket,
                        ClientProtocol protocol,
-                       const std::string& listen_user,
-                       const std::string& listen_pass,
-                       int concurrency,
+                       bool h2c,
+                       std::unique_ptr<SSLServerContext> ssl_server_context,
+                       std::unique_ptr<Http3ProxyServer> http3_server,
+                       scoped_refptr<const NaiveUserTable> users,
+                       int accept_budget,
+                       base::TimeDelta idle_timeout,
+                       base::TimeDelta read_idle_timeout,
+                       base::TimeDelta write_idle_timeout,
+                       base::TimeDelta half_open_timeout,
+                       NaiveProxySelector* proxy_selector,
                        RedirectResolver* resolver,
                        HttpNetworkSession* session,
+                       NaiveHttpCache* http_cache,
                        const NetworkTrafficAnnotationTag& traffic_annotation,
-                       const std::vector<PaddingType>& supported_padding_types)
+                       const std::vector<PaddingType>& supported_padding_types,
+                       const PaddingLimits& padding_limits,
+                       const NaivePaddingProfile& padding_profile,
+                       TunnelPriority priority,
+                       const NaivePriorityRules& priority_rules,
+                       const RelaySocketOptions& relay_socket_options,
+                       scoped_refptr<NaiveRateLimiter> rate_limiter,
+                       const NaivePriorityRateLimiters& priority_rate_limiters,
+                       const NaivePriorityDscps& priority_dscps,
+                       NaiveConnectionBudget* connection_budget,
+                       NaiveClientLimiter* client_limiter,
+                       NaiveAccessLog::Buffer* access_log)
     : listen_socket_(std::move(listen_socket)),
       protocol_(protocol),
-      listen_user_(listen_user),
-      listen_pass_(listen_pass),
-      concurrency_(concurrency),
+      h2c_(h2c),
+      ssl_server_context_(std::move(ssl_server_context)),
+      http3_server_(std::move(http3_server)),
+      users_(std::move(users)),
+      accept_budget_(accept_budget),
+      idle_timeout_(idle_timeout),
+      read_idle_timeout_(read_idle_timeout),
+      write_idle_timeout_(write_idle_timeout),
+      half_open_timeout_(half_open_timeout),
+      proxy_selector_(proxy_selector),
       resolver_(resolver),
       session_(session),
+      http_cache_(http_cache),
       net_log_(
           NetLogWithSource::Make(session->net_log(), NetLogSourceType::NONE)),
-      last_id_(0),
+      idle_timers_(base::Seconds(kIdleTimerTickSeconds),
+                   kIdleTimerSlots,
+                   base::BindRepeating(&NaiveProxy::OnIdleCheck,
+                                       base::Unretained(this))),
       traffic_annotation_(traffic_annotation),
-      supported_padding_types_(supported_padding_types) {
-  const auto& proxy_config = static_cast<ConfiguredProxyResolutionService*>(
-                                 session_->proxy_resolution_service())
-                                 ->config();
-  DCHECK(proxy_config);
-  const ProxyList& proxy_list =
-      proxy_config.value().value().proxy_rules().single_proxies;
-  DCHECK(!proxy_list.IsEmpty());
-  proxy_info_.UseProxyList(proxy_list);
-  proxy_info_.set_traffic_annotation(
-      net::MutableNetworkTrafficAnnotationTag(traffic_annotation_));
-
-  for (int i = 0; i < concurrency_; i++) {
-    network_anonymization_keys_.push_back(
-        NetworkAnonymizationKey::CreateTransient());
-  }
-
-  DCHECK(listen_socket_);
+      supported_padding_types_(supported_padding_types),
+      padding_limits_(padding_limits),
+      padding_profile_(padding_profile),
+      priority_(priority),
+      priority_rules_(priority_rules),
+      relay_socket_options_(relay_socket_options),
+      rate_limiter_(std::move(rate_limiter)),
+      priority_rate_limiters_(priority_rate_limiters),
+      priority_dscps_(priority_dscps),
+      connection_budget_(connection_budget),
+      client_limiter_(client_limiter),
+      accept_retry_delay_(kMinAcceptRetryDelay),
+      access_log_(access_log) {
+  DCHECK(proxy_selector_);
+  DCHECK(connection_budget_);
+  DCHECK(client_limiter_);
+  DCHECK_EQ(protocol_ == ClientProtocol::kHttps, !!ssl_server_context_);
+  DCHECK(!h2c_ || protocol_ == ClientProtocol::kHttp);
+  DCHECK_EQ(protocol_ == ClientProtocol::kQuic, !!http3_server_);
+  DCHECK_NE(!!listen_socket_, !!http3_server_);
+  if (http3_server_) {
+    // Streams are handed out from tasks of their own.
+    http3_server_->Start(users_, supported_padding_types_, padding_limits_,
+                         base::BindRepeating(&NaiveProxy::OnHttp3Stream,
+                                             weak_ptr_factory_.GetWeakPtr()));
+  }
   // Start accepting connections in next run loop in case when delegate is not
   // ready to get callbacks.
   base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
@@ -74,66 +198,367 @@ NaiveProxy::NaiveProxy(std::unique_ptr<ServerSocket> listen_socket,
 
 NaiveProxy::~NaiveProxy() = default;
 
+void NaiveProxy::SetProxySelector(NaiveProxySelector* proxy_selector) {
+  DCHECK(proxy_selector);
+  proxy_selector_ = proxy_selector;
+#if BUILDFLAG(IS_LINUX)
+  if (tproxy_udp_server_)
+    tproxy_udp_server_->SetProxySelector(proxy_selector);
+#endif
+}
+
+void NaiveProxy::SetListenAuth(scoped_refptr<const NaiveUserTable> users) {
+  users_ = std::move(users);
+  if (http3_server_)
+    http3_server_->SetAuth(users_);
+}
+
+void NaiveProxy::StopListening() {
+  // Cancels the pending accept.
+  listen_socket_.reset();
+  accepted_socket_.reset();
+  accept_paused_ = false;
+  accept_retry_timer_.Stop();
+  for (const auto& [session_id, session] : http2_sessions_) {
+    session->Shutdown();
+  }
+  if (http3_server_)
+    http3_server_->Shutdown();
+#if BUILDFLAG(IS_LINUX)
+  if (tproxy_udp_server_)
+    tproxy_udp_server_->StopListening();
+#endif
+}
+
+bool NaiveProxy::has_connections() const {
+#if BUILDFLAG(IS_LINUX)
+  if (tproxy_udp_server_ && tproxy_udp_server_->has_clients())
+    return true;
+#endif
+  return connections_.size() > 0 || !http2_sessions_.empty() ||
+         !preface_readers_.empty() ||
+         (http3_server_ && http3_server_->has_sessions());
+}
+
+#if BUILDFLAG(IS_LINUX)
+bool NaiveProxy::ServeTproxyUdp(base::ScopedFD fd) {
+  DCHECK_EQ(protocol_, ClientProtocol::kTproxy);
+  DCHECK(!tproxy_udp_server_);
+  tproxy_udp_server_ = std::make_unique<NaiveTproxyUdpServer>(
+      std::move(fd), proxy_selector_, resolver_, session_, idle_timeout_,
+      net_log_, traffic_annotation_);
+  return tproxy_udp_server_->Start();
+}
+#endif
+
 void NaiveProxy::DoAcceptLoop() {
+  TRACE_EVENT("naive", "NaiveProxy::DoAcceptLoop");
+  DCHECK_GE(accept_budget_, 1);
+  if (!listen_socket_)
+    return;
+  int batch = 0;
   int result;
   do {
+    if (batch == accept_budget_) {
+      // Lets established tunnels run before draining the rest of the backlog.
+      accept_stats_.budget_exhausted++;
+      base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+          FROM_HERE, base::BindOnce(&NaiveProxy::DoAcceptLoop,
+                                    weak_ptr_factory_.GetWeakPtr()));
+      break;
+    }
+    if (connection_budget_->exhausted()) {
+      accept_stats_.connection_limit_waits++;
+      PauseAccept(/*retry_later=*/false);
+      break;
+    }
+    // Other threads may be the ones to free them.
+    if (connection_budget_->fds_low()) {
+      accept_stats_.fd_waits++;
+      PauseAccept(/*retry_later=*/true);
+      break;
+    }
     result = listen_socket_->Accept(
-        &accepted_socket_, base::BindRepeating(&NaiveProxy::OnAcceptComplete,
-                                               weak_ptr_factory_.GetWeakPtr()));
+        &accepted_socket_,
+        base::BindOnce(&NaiveProxy::OnAcceptComplete,
+                       weak_ptr_factory_.GetWeakPtr()),
+        &accepted_peer_address_);
     if (result == ERR_IO_PENDING)
-      return;
-    HandleAcceptResult(result);
-  } while (result == OK);
+      break;
+    ++batch;
+  } while (HandleAcceptResult(result));
+  accept_stats_.max_batch = std::max(accept_stats_.max_batch, batch);
 }
 
 void NaiveProxy::OnAcceptComplete(int result) {
-  HandleAcceptResult(result);
-  if (result == OK)
+  if (HandleAcceptResult(result) && listen_socket_)
     DoAcceptLoop();
 }
 
-void NaiveProxy::HandleAcceptResult(int result) {
+bool NaiveProxy::HandleAcceptResult(int result) {
   if (result != OK) {
-    LOG(ERROR) << "Accept error: " << ErrorToShortString(result);
+    // The connection stays in the backlog, to be accepted once there is
+    // room for it. Only the first of a run of failures is logged.
+    if (IsResourceError(result)) {
+      if (accept_retry_delay_ == kMinAcceptRetryDelay) {
+        LOG(ERROR) << "Accept error: " << ErrorToShortString(result);
+      }
+      accept_stats_.resource_waits++;
+      PauseAccept(/*retry_later=*/true);
+    } else {
+      LOG(ERROR) << "Accept error: " << ErrorToShortString(result);
+    }
+    return false;
+  }
+  accept_stats_.accepted++;
+  accept_retry_delay_ = kMinAcceptRetryDelay;
+  // Turns away clients over their limits before allocating anything for
+  // the connection. The tunnels of https connections are admitted one by
+  // one instead. Connections of unix listeners have no address to limit.
+  if (protocol_ != ClientProtocol::kHttps &&
+      !accepted_peer_address_.address().empty() &&
+      !client_limiter_->Admit(accepted_peer_address_.address())) {
+    accept_stats_.client_limit_refusals++;
+    accepted_socket_.reset();
+    return true;
+  }
+  // Accepted sockets of TCPServerSocket are plain TCP sockets. Those of tun
+  // listeners are terminated in user space and have no socket options.
+  if (protocol_ != ClientProtocol::kTun) {
+    auto* tcp_socket = static_cast<TCPClientSocket*>(accepted_socket_.get());
+    NaiveConnection::ApplyRelaySocketOptions(relay_socket_options_,
+                                             tcp_socket);
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+    int incoming_cpu;
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && tcp_socket->GetIncomingCpu(&incoming_cpu) == OK) {
+      accept_stats_.cpu_checked++;
+      if (incoming_cpu != cpu) {
+        accept_stats_.cross_cpu++;
+      }
+    }
+#endif
+  }
+  if (protocol_ == ClientProtocol::kHttps) {
+    StartHttp2Session();
+    return true;
+  }
+  if (h2c_) {
+    StartPrefaceReader();
+    return true;
+  }
+  DoConnect(std::move(accepted_socket_), accepted_peer_address_.address(),
+            protocol_, std::string());
+  return true;
+}
+
+void NaiveProxy::PauseAccept(bool retry_later) {
+  accept_paused_ = true;
+  if (!waiting_for_budget_) {
+    waiting_for_budget_ = true;
+    connection_budget_->Wait(
+        base::BindOnce(&NaiveProxy::OnConnectionBudgetReleased,
+                       weak_ptr_factory_.GetWeakPtr()));
+  }
+  if (retry_later) {
+    accept_retry_timer_.Start(FROM_HERE, accept_retry_delay_, this,
+                              &NaiveProxy::ResumeAccept);
+    accept_retry_delay_ =
+        std::min(accept_retry_delay_ * 2, kMaxAcceptRetryDelay);
+  }
+}
+
+void NaiveProxy::OnConnectionBudgetReleased() {
+  waiting_for_budget_ = false;
+  ResumeAccept();
+}
+
+void NaiveProxy::ResumeAccept() {
+  if (!accept_paused_)
+    return;
+  accept_paused_ = false;
+  accept_retry_timer_.Stop();
+  DoAcceptLoop();
+}
+
+void NaiveProxy::StartHttp2Session() {
+  AddHttp2Session(
+      ssl_server_context_->CreateSSLServerSocket(std::move(accepted_socket_)),
+      accepted_peer_address_.address(), std::nullopt);
+}
+
+void NaiveProxy::StartPrefaceReader() {
+  unsigned int reader_id = next_preface_reader_id_++;
+  auto reader = std::make_unique<Http2PrefaceReader>(
+      std::move(accepted_socket_), idle_timeout_,
+      base::BindOnce(&NaiveProxy::OnPrefaceRead,
+                     weak_ptr_factory_.GetWeakPtr(), reader_id,
+                     accepted_peer_address_.address()));
+  Http2PrefaceReader* reader_ptr = reader.get();
+  preface_readers_[reader_id] = std::move(reader);
+  reader_ptr->Start();
+}
+
+void NaiveProxy::OnPrefaceRead(unsigned int reader_id,
+                               const IPAddress& client_address,
+                               std::unique_ptr<StreamSocket> socket,
+                               std::string received,
+                               bool is_http2) {
+  auto it = preface_readers_.find(reader_id);
+  DCHECK(it != preface_readers_.end());
+  // The reader is still on the call stack.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->DeleteSoon(
+      FROM_HERE, std::move(it->second));
+  preface_readers_.erase(it);
+  if (!socket) {
+    client_limiter_->Release(client_address);
+    return;
+  }
+  if (!is_http2) {
+    DoConnect(std::move(socket), client_address, protocol_,
+              std::move(received));
+    return;
+  }
+  // The tunnels of the session are admitted one by one instead.
+  client_limiter_->Release(client_address);
+  AddHttp2Session(std::move(socket), client_address, std::move(received));
+}
+
+void NaiveProxy::AddHttp2Session(
+    std::unique_ptr<StreamSocket> socket,
+    const IPAddress& client_address,
+    std::optional<std::string> cleartext_received) {
+  unsigned int session_id = next_http2_session_id_++;
+  auto session = std::make_unique<Http2ProxyServerSession>(
+      std::move(socket), users_, supported_padding_types_, padding_limits_,
+      traffic_annotation_,
+      base::BindRepeating(&NaiveProxy::OnHttp2Stream,
+                          weak_ptr_factory_.GetWeakPtr(), client_address),
+      base::BindOnce(&NaiveProxy::OnHttp2SessionClosed,
+                     weak_ptr_factory_.GetWeakPtr(), session_id));
+  Http2ProxyServerSession* session_ptr = session.get();
+  http2_sessions_[session_id] = std::move(session);
+  if (!cleartext_received.has_value()) {
+    session_ptr->Start();
     return;
   }
-  DoConnect();
+  session_ptr->StartCleartext(*cleartext_received);
+  // The session closes from a task of its own. One of a listener stopped
+  // while the preface was read is shut down like the others.
+  if (!listen_socket_)
+    session_ptr->Shutdown();
 }
 
-void NaiveProxy::DoConnect() {
+void NaiveProxy::OnHttp2Stream(const IPAddress& client_address,
+                               std::unique_ptr<Http2ProxyServerStream> stream) {
+  // Destroying the stream resets it.
+  if (connection_budget_->exhausted() ||
+      !client_limiter_->Admit(client_address)) {
+    accept_stats_.client_limit_refusals++;
+    return;
+  }
+  DoConnect(std::move(stream), client_address, ClientProtocol::kHttps,
+            std::string());
+}
+
+void NaiveProxy::OnHttp2SessionClosed(unsigned int session_id) {
+  auto it = http2_sessions_.find(session_id);
+  if (it == http2_sessions_.end())
+    return;
+  // The session is still on the call stack.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->DeleteSoon(
+      FROM_HERE, std::move(it->second));
+  http2_sessions_.erase(it);
+}
+
+void NaiveProxy::OnHttp3Stream(
+    std::unique_ptr<Http3ProxyServerStream> stream) {
+  IPEndPoint peer_address;
+  if (stream->GetPeerAddress(&peer_address) != OK)
+    return;
+  // Destroying the stream resets it.
+  if (connection_budget_->exhausted() ||
+      !client_limiter_->Admit(peer_address.address())) {
+    accept_stats_.client_limit_refusals++;
+    return;
+  }
+  DoConnect(std::move(stream), peer_address.address(), protocol_,
+            std::string());
+}
+
+void NaiveProxy::DoConnect(std::unique_ptr<StreamSocket> accepted_socket,
+                           const IPAddress& client_address,
+                           ClientProtocol protocol,
+                           std::string initial_data) {
+  TRACE_EVENT("naive", "NaiveProxy::DoConnect");
+  // Only with about a million connections open at once. Destroying the
+  // accepted socket refuses the connection.
+  uint64_t connection_id = connections_.NextId();
+  if (connection_id == 0) {
+    LOG(WARNING) << "Connection table full, refusing connection";
+    accept_stats_.client_limit_refusals++;
+    client_limiter_->Release(client_address);
+    return;
+  }
   std::unique_ptr<StreamSocket> socket;
   auto* proxy_delegate =
       static_cast<NaiveProxyDelegate*>(session_->context().proxy_delegate);
   DCHECK(proxy_delegate);
-  DCHECK(!proxy_info_.is_empty());
-  const ProxyChain& proxy_server = proxy_info_.proxy_chain();
-  auto padding_detector_delegate = std::make_unique<PaddingDetectorDelegate>(
-      proxy_delegate, proxy_server, protocol_);
-
-  if (protocol_ == ClientProtocol::kSocks5) {
-    socket = std::make_unique<Socks5ServerSocket>(std::move(accepted_socket_),
-                                                  listen_user_, listen_pass_,
-                                                  traffic_annotation_);
-  } else if (protocol_ == ClientProtocol::kHttp) {
+  NaiveProxySelector::Selection selection = proxy_selector_->Select();
+  const ProxyInfo& proxy_info = proxy_selector_->proxy_info(selection);
+  const ProxyChain& proxy_server = proxy_info.proxy_chain();
+  const auto& session_keys =
+      proxy_selector_->class_network_anonymization_keys(selection);
+  // The client socket is wrapped below with the padding detector the
+  // connection keeps inline.
+  auto connection_ptr = std::make_unique<NaiveConnection>(
+      connection_id, protocol, proxy_delegate, proxy_info, resolver_,
+      session_, http_cache_, session_keys, net_log_, padding_profile_,
+      priority_, priority_rules_, relay_socket_options_, traffic_annotation_);
+  PaddingDetectorDelegate* padding_detector_delegate =
+      connection_ptr->padding_detector_delegate();
+
+  if (protocol == ClientProtocol::kSocks5) {
+    socket = std::make_unique<Socks5ServerSocket>(
+        std::move(accepted_socket), users_,
+        NaiveUdpAssociation::IsSupported(proxy_server), traffic_annotation_);
+  } else if (protocol == ClientProtocol::kHttp) {
     socket = std::make_unique<HttpProxyServerSocket>(
-        std::move(accepted_socket_), listen_user_, listen_pass_,
-        padding_detector_delegate.get(), traffic_annotation_,
-        supported_padding_types_);
-  } else if (protocol_ == ClientProtocol::kRedir) {
-    socket = std::move(accepted_socket_);
+        std::move(accepted_socket), users_, padding_detector_delegate,
+        traffic_annotation_, supported_padding_types_, padding_limits_,
+        http_cache_, std::move(initial_data));
+  } else if (protocol == ClientProtocol::kHttps) {
+    // The session negotiated the padding with the CONNECT.
+    const auto* stream =
+        static_cast<const Http2ProxyServerStream*>(accepted_socket.get());
+    padding_detector_delegate->SetClientPaddingType(stream->padding_type(),
+                                                    stream->padding_limits());
+    socket = std::move(accepted_socket);
+  } else if (protocol == ClientProtocol::kQuic) {
+    const auto* stream =
+        static_cast<const Http3ProxyServerStream*>(accepted_socket.get());
+    padding_detector_delegate->SetClientPaddingType(stream->padding_type(),
+                                                    stream->padding_limits());
+    socket = std::move(accepted_socket);
+  } else if (protocol == ClientProtocol::kRedir ||
+             protocol == ClientProtocol::kTun ||
+             protocol == ClientProtocol::kTproxy) {
+    socket = std::move(accepted_socket);
   } else {
+    proxy_selector_->OnConnectionClosed(selection);
+    client_limiter_->Release(client_address);
     return;
   }
 
-  last_id_++;
-  int tunnel_session_id = last_id_ % concurrency_;
-  const auto& nak = network_anonymization_keys_[tunnel_session_id];
-  auto connection_ptr = std::make_unique<NaiveConnection>(
-      last_id_, protocol_, std::move(padding_detector_delegate), proxy_info_,
-      resolver_, session_, nak, net_log_, std::move(socket),
-      traffic_annotation_);
+  connection_ptr->SetClientSocket(std::move(socket));
   auto* connection = connection_ptr.get();
-  connection_by_id_[connection->id()] = std::move(connection_ptr);
+  connection->set_access_logged(access_log_ != nullptr);
+  connections_.Insert(std::move(connection_ptr));
+  connection_budget_->Acquire();
+  TRACE_COUNTER1("naive", "NaiveProxy::Connections", connections_.size());
+  connection_chains_[connection->id()] = {proxy_selector_, selection,
+                                          client_address};
+  ScheduleIdleCheck(connection, /*half_open=*/false);
   int result = connection->Connect(
       base::BindRepeating(&NaiveProxy::OnConnectComplete,
                           weak_ptr_factory_.GetWeakPtr(), connection->id()));
@@ -142,7 +567,7 @@ void NaiveProxy::DoConnect() {
   HandleConnectResult(connection, result);
 }
 
-void NaiveProxy::OnConnectComplete(unsigned int connection_id, int result) {
+void NaiveProxy::OnConnectComplete(uint64_t connection_id, int result) {
   auto* connection = FindConnection(connection_id);
   if (!connection)
     return;
@@ -150,13 +575,63 @@ void NaiveProxy::OnConnectComplete(unsigned int connection_id, int result) {
 }
 
 void NaiveProxy::HandleConnectResult(NaiveConnection* connection, int result) {
+  // Client errors before or during the tunnel connect are not counted.
+  if (connection->server_connect_result() != ERR_IO_PENDING) {
+    const ConnectionChain& chain = connection_chains_[connection->id()];
+    chain.proxy_selector->OnConnectComplete(
+        chain.selection, connection->server_connect_result(),
+        connection->server_connect_time());
+    if (connection->server_connect_result() == OK) {
+      metrics_.AddConnectLatency(connection->server_connect_time());
+      AddConnectPhases(*connection, &metrics_);
+    } else {
+      metrics_.connect_failures++;
+    }
+    StreamSocket::SessionQuality quality;
+    if (connection->GetServerSessionQuality(&quality)) {
+      // Until the session samples its own RTT, the TCP RTT to the proxy
+      // stands in for it.
+      auto* socket_watcher_factory = static_cast<NaiveSocketWatcherFactory*>(
+          session_->context().socket_performance_watcher_factory.get());
+      IPEndPoint peer;
+      if (quality.smoothed_rtt.is_zero() && socket_watcher_factory &&
+          connection->GetServerPeerAddress(&peer) == OK) {
+        quality.smoothed_rtt =
+            socket_watcher_factory->GetPeerRtt(peer.address());
+      }
+      chain.proxy_selector->OnSessionQuality(chain.selection, quality);
+    }
+  }
   if (result != OK) {
     Close(connection->id(), result);
     return;
   }
+  AddRateLimiters(connection);
+  // Marks the session the tunnel is carried over, which only carries
+  // tunnels of this class if the selector split the sessions by class.
+  DiffServCodePoint dscp =
+      priority_dscps_[static_cast<size_t>(connection->priority())];
+  if (dscp != DSCP_NO_CHANGE)
+    connection->SetServerDiffServCodePoint(dscp);
   DoRun(connection);
 }
 
+void NaiveProxy::AddRateLimiters(NaiveConnection* connection) {
+  if (rate_limiter_)
+    connection->AddRateLimiter(rate_limiter_);
+  // Looked up in the users of now, which a reload may have replaced since
+  // the client authenticated.
+  const std::string& user = connection->user();
+  if (!user.empty() && users_) {
+    if (NaiveRateLimiter* user_rate_limiter = users_->GetRateLimiter(user))
+      connection->AddRateLimiter(user_rate_limiter);
+  }
+  const scoped_refptr<NaiveRateLimiter>& priority_rate_limiter =
+      priority_rate_limiters_[static_cast<size_t>(connection->priority())];
+  if (priority_rate_limiter)
+    connection->AddRateLimiter(priority_rate_limiter);
+}
+
 void NaiveProxy::DoRun(NaiveConnection* connection) {
   int result = connection->Run(
       base::BindRepeating(&NaiveProxy::OnRunComplete,
@@ -166,7 +641,7 @@ void NaiveProxy::DoRun(NaiveConnection* connection) {
   HandleRunResult(connection, result);
 }
 
-void NaiveProxy::OnRunComplete(unsigned int connection_id, int result) {
+void NaiveProxy::OnRunComplete(uint64_t connection_id, int result) {
   auto* connection = FindConnection(connection_id);
   if (!connection)
     return;
@@ -177,28 +652,151 @@ void NaiveProxy::HandleRunResult(NaiveConnection* connection, int result) {
   Close(connection->id(), result);
 }
 
-void NaiveProxy::Close(unsigned int connection_id, int reason) {
-  auto it = connection_by_id_.find(connection_id);
-  if (it == connection_by_id_.end())
+void NaiveProxy::Close(uint64_t connection_id, int reason) {
+  std::unique_ptr<NaiveConnection> connection =
+      connections_.Remove(connection_id);
+  if (!connection)
     return;
 
-  LOG(INFO) << "Connection " << connection_id
-            << " closed: " << ErrorToShortString(reason);
+  auto it = connection_chains_.find(connection_id);
+  CHECK(it != connection_chains_.end());
+  it->second.proxy_selector->OnConnectionClosed(it->second.selection);
+  client_limiter_->Release(it->second.client_address);
+  connection_chains_.erase(it);
+  connection_budget_->Release();
+  TRACE_COUNTER1("naive", "NaiveProxy::Connections", connections_.size());
+
+  for (Direction from : {kClient, kServer}) {
+    metrics_.relayed_bytes[from] += connection->GetRelayedBytes(from);
+  }
+  AddConnectionCounts(*connection, &metrics_);
+  if (connection->server_connect_result() == OK) {
+    AddFirstRelayPhases(*connection, &metrics_);
+  }
+
+  if (!access_log_) {
+    LOG(INFO) << "Connection " << connection_id
+              << " closed: " << ErrorToShortString(reason);
+  } else if (access_log_->Sample()) {
+    NaiveAccessLog::Entry entry;
+    entry.id = connection_id;
+    entry.protocol = protocol_;
+    entry.origin = &connection->origin();
+    entry.user = &connection->user();
+    entry.result = reason;
+    if (connection->server_connect_result() == OK) {
+      entry.connect_time = connection->server_connect_time();
+    }
+    entry.duration = base::TimeTicks::Now() - connection->start_time();
+    entry.bytes_up = connection->GetRelayedBytes(kClient);
+    entry.bytes_down = connection->GetRelayedBytes(kServer);
+    access_log_->Add(entry);
+  }
 
   // The call stack might have callbacks which still have the pointer of
   // connection. Instead of referencing connection with ID all the time,
   // destroys the connection in next run loop to make sure any pending
   // callbacks in the call stack return.
   base::SingleThreadTaskRunner::GetCurrentDefault()->DeleteSoon(
-      FROM_HERE, std::move(it->second));
-  connection_by_id_.erase(it);
+      FROM_HERE, std::move(connection));
+  // After the connection is destroyed, so its memory is in the thread cache.
+  if (connections_.size() == 0) {
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE, base::BindOnce(&OnAllocatorIdle));
+  }
+}
+
+void NaiveProxy::ScheduleIdleCheck(NaiveConnection* connection,
+                                   bool half_open) {
+  base::TimeTicks last_activity_time = connection->GetLastActivityTime();
+  base::TimeTicks deadline = base::TimeTicks::Max();
+  if (idle_timeout_.is_positive()) {
+    deadline = last_activity_time + idle_timeout_;
+  }
+  if (read_idle_timeout_.is_positive()) {
+    deadline = std::min(deadline, connection->GetLastActivityTime(kClient) +
+                                      read_idle_timeout_);
+  }
+  if (write_idle_timeout_.is_positive()) {
+    deadline = std::min(deadline, connection->GetLastActivityTime(kServer) +
+                                      write_idle_timeout_);
+  }
+  if (half_open_timeout_.is_positive()) {
+    if (half_open) {
+      deadline = std::min(deadline, last_activity_time + half_open_timeout_);
+    } else {
+      // Checks again in time to notice the tunnel becoming half-open.
+      deadline =
+          std::min(deadline, base::TimeTicks::Now() + half_open_timeout_);
+    }
+  }
+  if (deadline.is_max())
+    return;
+  idle_timers_.Schedule(connection->id(), deadline);
+}
+
+void NaiveProxy::OnIdleCheck(uint64_t connection_id) {
+  auto* connection = FindConnection(connection_id);
+  if (!connection)
+    return;
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  base::TimeDelta idle_time = now - connection->GetLastActivityTime();
+  bool half_open = connection->IsHalfOpen();
+  if ((idle_timeout_.is_positive() && idle_time >= idle_timeout_) ||
+      (read_idle_timeout_.is_positive() &&
+       now - connection->GetLastActivityTime(kClient) >= read_idle_timeout_) ||
+      (write_idle_timeout_.is_positive() &&
+       now - connection->GetLastActivityTime(kServer) >=
+           write_idle_timeout_) ||
+      (half_open && half_open_timeout_.is_positive() &&
+       idle_time >= half_open_timeout_)) {
+    Close(connection_id, ERR_TIMED_OUT);
+    return;
+  }
+  ScheduleIdleCheck(connection, half_open);
+}
+
+NaiveListenerMetrics NaiveProxy::GetMetrics() const {
+  NaiveListenerMetrics metrics = metrics_;
+  metrics.accepted = accept_stats_.accepted;
+  metrics.cpu_checked_accepted = accept_stats_.cpu_checked;
+  metrics.cross_cpu_accepted = accept_stats_.cross_cpu;
+  metrics.active = connections_.size();
+  for (const auto& [connection_id, chain] : connection_chains_) {
+    const NaiveConnection* connection = connections_.Find(connection_id);
+    for (Direction from : {kClient, kServer}) {
+      metrics.relayed_bytes[from] += connection->GetRelayedBytes(from);
+    }
+    AddConnectionCounts(*connection, &metrics);
+  }
+  return metrics;
+}
+
+uint64_t NaiveProxy::GetRelayedBytes() const {
+  uint64_t bytes = 0;
+  for (Direction from : {kClient, kServer}) {
+    bytes += metrics_.relayed_bytes[from];
+  }
+  for (const auto& [connection_id, chain] : connection_chains_) {
+    const NaiveConnection* connection = connections_.Find(connection_id);
+    for (Direction from : {kClient, kServer}) {
+      bytes += connection->GetRelayedBytes(from);
+    }
+  }
+  return bytes;
+}
+
+NaiveConnection::MemoryUsage NaiveProxy::GetConnectionMemoryUsage() const {
+  NaiveConnection::MemoryUsage usage;
+  for (const auto& [connection_id, chain] : connection_chains_) {
+    usage += connections_.Find(connection_id)->GetMemoryUsage();
+  }
+  return usage;
 }
 
-NaiveConnection* NaiveProxy::FindConnection(unsigned int connection_id) {
-  auto it = connection_by_id_.find(connection_id);
-  if (it == connection_by_id_.end())
-    return nullptr;
-  return it->second.get();
+NaiveConnection* NaiveProxy::FindConnection(uint64_t connection_id) {
+  return connections_.Find(connection_id);
 }
 
 }  // namespace net
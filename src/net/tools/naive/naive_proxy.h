@@ -5,84 +5,285 @@
 #ifndef NET_TOOLS_NAIVE_NAIVE_PROXY_H_
 #define NET_TOOLS_NAIVE_NAIVE_PROXY_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "base/files/scoped_file.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "build/build_config.h"
 #include "net/base/completion_repeating_callback.h"
-#include "net/base/network_isolation_key.h"
+#include "net/base/ip_endpoint.h"
 #include "net/log/net_log_with_source.h"
-#include "net/proxy_resolution/proxy_info.h"
 #include "net/ssl/ssl_config.h"
+#include "net/tools/naive/naive_access_log.h"
+#include "net/tools/naive/naive_client_limiter.h"
 #include "net/tools/naive/naive_connection.h"
+#include "net/tools/naive/naive_connection_budget.h"
+#include "net/tools/naive/naive_connection_table.h"
+#include "net/tools/naive/naive_metrics.h"
+#include "net/tools/naive/naive_padding_profile.h"
+#include "net/tools/naive/naive_priority_rules.h"
 #include "net/tools/naive/naive_protocol.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+#include "net/tools/naive/naive_rate_limiter.h"
+#include "net/tools/naive/naive_timer_wheel.h"
+#include "net/tools/naive/naive_user_table.h"
 
 namespace net {
 
 class ClientSocketHandle;
+class Http2PrefaceReader;
+class Http2ProxyServerSession;
+class Http2ProxyServerStream;
+class Http3ProxyServer;
+class Http3ProxyServerStream;
 class HttpNetworkSession;
 class NaiveConnection;
+class NaiveHttpCache;
+class NaiveTproxyUdpServer;
 class ServerSocket;
+class SSLServerContext;
 class StreamSocket;
 struct NetworkTrafficAnnotationTag;
 class RedirectResolver;
 
 class NaiveProxy {
  public:
+  struct AcceptStats {
+    // Connections accepted.
+    uint64_t accepted = 0;
+    // Accept loops that yielded after reaching the budget.
+    uint64_t budget_exhausted = 0;
+    // Largest number of connections found waiting in the listen backlog in
+    // one wakeup, capped by the budget.
+    int max_batch = 0;
+    // Times accepting paused for the connection budget, for accept
+    // failures for lack of file descriptors or memory, and for file
+    // descriptors running out in the process.
+    uint64_t connection_limit_waits = 0;
+    uint64_t resource_waits = 0;
+    uint64_t fd_waits = 0;
+    // Connections closed right after accept for being over the limits of
+    // their client or of the connection table, and for https and quic
+    // listeners, tunnels reset for being over the limits of their client or
+    // the connection budget.
+    uint64_t client_limit_refusals = 0;
+    // Connections accepted whose incoming CPU is known, and of those, the
+    // ones whose packets were received on another CPU than the one accepting
+    // them, whose cache lines bounce between the two.
+    uint64_t cpu_checked = 0;
+    uint64_t cross_cpu = 0;
+  };
+
+  // `h2c` is only for kHttp, and `ssl_server_context` only for kHttps.
+  // kQuic has `http3_server` instead of `server_socket`.
   NaiveProxy(std::unique_ptr<ServerSocket> server_socket,
              ClientProtocol protocol,
-             const std::string& listen_user,
-             const std::string& listen_pass,
-             int concurrency,
+             bool h2c,
+             std::unique_ptr<SSLServerContext> ssl_server_context,
+             std::unique_ptr<Http3ProxyServer> http3_server,
+             scoped_refptr<const NaiveUserTable> users,
+             int accept_budget,
+             base::TimeDelta idle_timeout,
+             base::TimeDelta read_idle_timeout,
+             base::TimeDelta write_idle_timeout,
+             base::TimeDelta half_open_timeout,
+             NaiveProxySelector* proxy_selector,
              RedirectResolver* resolver,
              HttpNetworkSession* session,
+             NaiveHttpCache* http_cache,
              const NetworkTrafficAnnotationTag& traffic_annotation,
-             const std::vector<PaddingType>& supported_padding_types);
+             const std::vector<PaddingType>& supported_padding_types,
+             const PaddingLimits& padding_limits,
+             const NaivePaddingProfile& padding_profile,
+             TunnelPriority priority,
+             const NaivePriorityRules& priority_rules,
+             const RelaySocketOptions& relay_socket_options,
+             scoped_refptr<NaiveRateLimiter> rate_limiter,
+             const NaivePriorityRateLimiters& priority_rate_limiters,
+             const NaivePriorityDscps& priority_dscps,
+             NaiveConnectionBudget* connection_budget,
+             NaiveClientLimiter* client_limiter,
+             NaiveAccessLog::Buffer* access_log);
   ~NaiveProxy();
   NaiveProxy(const NaiveProxy&) = delete;
   NaiveProxy& operator=(const NaiveProxy&) = delete;
 
+  const AcceptStats& accept_stats() const { return accept_stats_; }
+
+  // Returns the counters of the listener, with the bytes relayed so far by
+  // the open connections.
+  NaiveListenerMetrics GetMetrics() const;
+  // Returns the bytes relayed in both directions, by closed and open
+  // connections, without copying the rest of the metrics.
+  uint64_t GetRelayedBytes() const;
+
+  // Returns the bytes held by the open connections.
+  NaiveConnection::MemoryUsage GetConnectionMemoryUsage() const;
+  size_t num_connections() const { return connections_.size(); }
+
+  // These apply to connections accepted from now on. Open connections keep
+  // the selector they were given, which must outlive them.
+  void SetProxySelector(NaiveProxySelector* proxy_selector);
+  void SetListenAuth(scoped_refptr<const NaiveUserTable> users);
+
+  // Closes the listen socket and lets the open connections finish. The
+  // HTTP/2 sessions of https listeners and the HTTP/3 connections of quic
+  // listeners get GOAWAY.
+  void StopListening();
+  bool has_connections() const;
+
+#if BUILDFLAG(IS_LINUX)
+  // Relays the datagrams of a tproxy listener read from `fd`, an
+  // NaiveTproxyUdpServer::OpenSocket(). Returns false on failure.
+  bool ServeTproxyUdp(base::ScopedFD fd);
+#endif
+
  private:
   void DoAcceptLoop();
   void OnAcceptComplete(int result);
-  void HandleAcceptResult(int result);
+  // Returns true if accepting goes on.
+  bool HandleAcceptResult(int result);
+  // Stops accepting until a connection of the thread closes, or until
+  // kAcceptRetryDelay has passed if `retry_later`.
+  void PauseAccept(bool retry_later);
+  void OnConnectionBudgetReleased();
+  void ResumeAccept();
+
+  // Starts the HTTP/2 session of a connection to an https listener.
+  void StartHttp2Session();
+  // Reads the first bytes of a connection to an http listener with h2c,
+  // which then starts an HTTP/2 session or goes on as HTTP/1.
+  void StartPrefaceReader();
+  void OnPrefaceRead(unsigned int reader_id,
+                     const IPAddress& client_address,
+                     std::unique_ptr<StreamSocket> socket,
+                     std::string received,
+                     bool is_http2);
+  void AddHttp2Session(std::unique_ptr<StreamSocket> socket,
+                       const IPAddress& client_address,
+                       std::optional<std::string> cleartext_received);
+  void OnHttp2Stream(const IPAddress& client_address,
+                     std::unique_ptr<Http2ProxyServerStream> stream);
+  void OnHttp2SessionClosed(unsigned int session_id);
+
+  void OnHttp3Stream(std::unique_ptr<Http3ProxyServerStream> stream);
 
-  void DoConnect();
-  void OnConnectComplete(unsigned int connection_id, int result);
+  // `protocol` is kHttps for the streams of h2c sessions of http
+  // listeners, and protocol_ otherwise. `initial_data` is the start of the
+  // request read from an http connection.
+  void DoConnect(std::unique_ptr<StreamSocket> accepted_socket,
+                 const IPAddress& client_address,
+                 ClientProtocol protocol,
+                 std::string initial_data);
+  void OnConnectComplete(uint64_t connection_id, int result);
   void HandleConnectResult(NaiveConnection* connection, int result);
+  // Adds the rate limiters of the listener, of the user and of the class of
+  // `connection`.
+  void AddRateLimiters(NaiveConnection* connection);
 
   void DoRun(NaiveConnection* connection);
-  void OnRunComplete(unsigned int connection_id, int result);
+  void OnRunComplete(uint64_t connection_id, int result);
   void HandleRunResult(NaiveConnection* connection, int result);
 
-  void Close(unsigned int connection_id, int reason);
+  void Close(uint64_t connection_id, int reason);
 
-  NaiveConnection* FindConnection(unsigned int connection_id);
+  // Schedules the next idle check of `connection`, as of its last activity.
+  void ScheduleIdleCheck(NaiveConnection* connection, bool half_open);
+  void OnIdleCheck(uint64_t connection_id);
+
+  NaiveConnection* FindConnection(uint64_t connection_id);
 
   std::unique_ptr<ServerSocket> listen_socket_;
   ClientProtocol protocol_;
-  std::string listen_user_;
-  std::string listen_pass_;
-  int concurrency_;
-  ProxyInfo proxy_info_;
+  bool h2c_;
+  std::unique_ptr<SSLServerContext> ssl_server_context_;
+  std::map<unsigned int, std::unique_ptr<Http2ProxyServerSession>>
+      http2_sessions_;
+  unsigned int next_http2_session_id_ = 0;
+  // Connections to an http listener with h2c not yet told apart.
+  std::map<unsigned int, std::unique_ptr<Http2PrefaceReader>>
+      preface_readers_;
+  unsigned int next_preface_reader_id_ = 0;
+  std::unique_ptr<Http3ProxyServer> http3_server_;
+  // Null if the listener takes no authentication.
+  scoped_refptr<const NaiveUserTable> users_;
+  int accept_budget_;
+  // Zero disables the timeout.
+  base::TimeDelta idle_timeout_;
+  base::TimeDelta read_idle_timeout_;
+  base::TimeDelta write_idle_timeout_;
+  base::TimeDelta half_open_timeout_;
+  NaiveProxySelector* proxy_selector_;
+  struct ConnectionChain {
+    NaiveProxySelector* proxy_selector;
+    NaiveProxySelector::Selection selection;
+    IPAddress client_address;
+  };
+  // Proxy chains and tunnel sessions of open connections, and their
+  // clients for the client limiter.
+  std::map<uint64_t, ConnectionChain> connection_chains_;
   RedirectResolver* resolver_;
   HttpNetworkSession* session_;
+  // Serves the GETs of http listeners it caches, if not null.
+  NaiveHttpCache* http_cache_;
   NetLogWithSource net_log_;
 
-  unsigned int last_id_;
-
   std::unique_ptr<StreamSocket> accepted_socket_;
+  IPEndPoint accepted_peer_address_;
 
-  std::vector<NetworkAnonymizationKey> network_anonymization_keys_;
+  AcceptStats accept_stats_;
 
-  std::map<unsigned int, std::unique_ptr<NaiveConnection>> connection_by_id_;
+  // Bytes relayed by closed connections, and connect results.
+  NaiveListenerMetrics metrics_;
+
+  NaiveConnectionTable connections_;
+
+  NaiveTimerWheel idle_timers_;
 
   const NetworkTrafficAnnotationTag& traffic_annotation_;
 
   std::vector<PaddingType> supported_padding_types_;
 
+  // Offered to clients that request kVariant2.
+  PaddingLimits padding_limits_;
+
+  NaivePaddingProfile padding_profile_;
+
+  TunnelPriority priority_;
+  NaivePriorityRules priority_rules_;
+
+  RelaySocketOptions relay_socket_options_;
+
+  // Null if the listener has no rate limit.
+  scoped_refptr<NaiveRateLimiter> rate_limiter_;
+  NaivePriorityRateLimiters priority_rate_limiters_;
+  NaivePriorityDscps priority_dscps_;
+
+  NaiveConnectionBudget* connection_budget_;
+  NaiveClientLimiter* client_limiter_;
+  bool accept_paused_ = false;
+  bool waiting_for_budget_ = false;
+  base::OneShotTimer accept_retry_timer_;
+  // Of the next retry after an accept failure or with few file descriptors.
+  base::TimeDelta accept_retry_delay_;
+
+  // Null if closed connections are logged at INFO instead.
+  NaiveAccessLog::Buffer* access_log_;
+
+#if BUILDFLAG(IS_LINUX)
+  // UDP of tproxy listeners. Uses the members above.
+  std::unique_ptr<NaiveTproxyUdpServer> tproxy_udp_server_;
+#endif
+
   base::WeakPtrFactory<NaiveProxy> weak_ptr_factory_{this};
 };
 
@@ -3,25 +3,38 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "base/allocator/allocator_check.h"
 #include "base/allocator/partition_alloc_support.h"
 #include "base/allocator/partition_allocator/src/partition_alloc/shim/allocator_shim.h"
 #include "base/at_exit.h"
+#include "base/barrier_callback.h"
 #include "base/check.h"
 #include "base/command_line.h"
+#include "base/containers/flat_set.h"
 #include "base/feature_list.h"
 #include "base/files/file_path.h"
+#include "base/functional/bind.h"
 #include "base/json/json_file_value_serializer.h"
 #include "base/json/json_writer.h"
 #include "base/logging.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/message_loop/message_pump.h"
+#include "base/metrics/histogram_base.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/metrics/statistics_recorder.h"
 #include "base/process/memory.h"
+#include "base/process/process_metrics.h"
 #include "base/rand_util.h"
 #include "base/run_loop.h"
 #include "base/strings/escape.h"
@@ -29,18 +42,33 @@
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/system/sys_info.h"
+#include "base/task/bind_post_task.h"
 #include "base/task/single_thread_task_executor.h"
 #include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/threading/sequence_bound.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "base/timer/timer.h"
 #include "base/values.h"
 #include "build/build_config.h"
 #include "components/version_info/version_info.h"
 #include "net/base/auth.h"
+#include "net/base/network_change_notifier.h"
 #include "net/base/network_isolation_key.h"
+#include "net/base/proxy_chain.h"
+#include "net/base/proxy_server.h"
 #include "net/base/url_util.h"
+#include "net/cert/caching_cert_verifier.h"
 #include "net/cert/cert_verifier.h"
+#include "net/cert/coalescing_cert_verifier.h"
 #include "net/cert_net/cert_net_fetcher_url_request.h"
+#include "net/dns/dns_udp_socket_pool.h"
+#include "net/dns/host_cache.h"
 #include "net/dns/host_resolver.h"
 #include "net/dns/mapped_host_resolver.h"
+#include "net/dns/public/dns_config_overrides.h"
+#include "net/dns/public/secure_dns_mode.h"
 #include "net/http/http_auth.h"
 #include "net/http/http_auth_cache.h"
 #include "net/http/http_network_session.h"
@@ -53,22 +81,65 @@
 #include "net/log/net_log_event_type.h"
 #include "net/log/net_log_source.h"
 #include "net/log/net_log_util.h"
+#include "net/nqe/network_quality_estimator.h"
+#include "net/nqe/network_quality_estimator_params.h"
 #include "net/proxy_resolution/configured_proxy_resolution_service.h"
 #include "net/proxy_resolution/proxy_config.h"
 #include "net/proxy_resolution/proxy_config_service_fixed.h"
 #include "net/proxy_resolution/proxy_config_with_annotation.h"
+#include "net/quic/quic_context.h"
+#include "net/quic/quic_session_pool.h"
+#include "net/socket/client_socket_pool.h"
 #include "net/socket/client_socket_pool_manager.h"
 #include "net/socket/ssl_client_socket.h"
+#include "net/socket/ssl_server_socket.h"
 #include "net/socket/tcp_server_socket.h"
 #include "net/socket/udp_server_socket.h"
+#include "net/spdy/spdy_session_pool.h"
 #include "net/ssl/ssl_config_service.h"
 #include "net/ssl/ssl_key_logger_impl.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_config.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_versions.h"
+#include "net/tools/naive/http2_proxy_server_session.h"
+#include "net/tools/naive/http3_proxy_server.h"
+#include "net/tools/naive/naive_access_log.h"
+#include "net/tools/naive/naive_allocator_profile.h"
+#include "net/tools/naive/naive_bench.h"
+#include "net/tools/naive/naive_binary_net_log_observer.h"
+#include "net/tools/naive/naive_buffer_pool.h"
+#include "net/tools/naive/naive_cert_verify_store.h"
+#include "net/tools/naive/naive_client_limiter.h"
+#include "net/tools/naive/naive_client_socket_factory.h"
 #include "net/tools/naive/naive_command_line.h"
 #include "net/tools/naive/naive_config.h"
+#include "net/tools/naive/naive_connection.h"
+#include "net/tools/naive/naive_connection_budget.h"
+#include "net/tools/naive/naive_health_checker.h"
+#include "net/tools/naive/naive_host_cache_store.h"
+#include "net/tools/naive/naive_http_cache.h"
+#include "net/tools/naive/naive_memory_pressure_monitor.h"
+#include "net/tools/naive/naive_metrics.h"
+#include "net/tools/naive/naive_metrics_server.h"
+#include "net/tools/naive/naive_mtu_store.h"
+#include "net/tools/naive/naive_net_log_sampler.h"
+#include "net/tools/naive/naive_network_change_debouncer.h"
+#include "net/tools/naive/naive_padding_socket.h"
 #include "net/tools/naive/naive_protocol.h"
 #include "net/tools/naive/naive_proxy.h"
 #include "net/tools/naive/naive_proxy_delegate.h"
+#include "net/tools/naive/naive_proxy_racer.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+#include "net/tools/naive/naive_quality_adapter.h"
+#include "net/tools/naive/naive_quic_session_store.h"
+#include "net/tools/naive/naive_scheduler.h"
+#include "net/tools/naive/naive_session_warmer.h"
+#include "net/tools/naive/naive_shared_host_cache.h"
+#include "net/tools/naive/naive_socket_watcher.h"
+#include "net/tools/naive/naive_spare_pool.h"
+#include "net/tools/naive/naive_ssl_session_store.h"
+#include "net/tools/naive/naive_stale_host_resolver.h"
+#include "net/tools/naive/naive_standby_pool.h"
+#include "net/tools/naive/naive_trace_recorder.h"
 #include "net/tools/naive/redirect_resolver.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
 #include "net/url_request/url_request_context.h"
@@ -77,6 +148,28 @@
 #include "url/scheme_host_port.h"
 #include "url/url_util.h"
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+#include <sched.h>
+
+#include "base/message_loop/message_pump_epoll.h"
+#endif
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_ANDROID)
+#include "net/tools/naive/naive_tun_stack.h"
+#endif
+
+#if BUILDFLAG(IS_LINUX)
+#include "net/tools/naive/naive_tproxy.h"
+#endif
+
+#if BUILDFLAG(IS_POSIX)
+#include <sys/socket.h>
+
+#include "net/tools/naive/naive_reload_signal.h"
+#include "net/tools/naive/naive_socket_handoff.h"
+#include "net/tools/naive/naive_unix_server_socket.h"
+#endif
+
 #if BUILDFLAG(IS_APPLE)
 #include "base/allocator/early_zone_registration_apple.h"
 #include "base/apple/scoped_nsautorelease_pool.h"
@@ -85,12 +178,105 @@
 namespace {
 
 constexpr int kListenBackLog = 512;
-constexpr int kDefaultMaxSocketsPerPool = 256;
-constexpr int kDefaultMaxSocketsPerGroup = 255;
-constexpr int kExpectedMaxUsers = 8;
+constexpr int kMetricsListenBackLog = 16;
+// Connections with data in their SYN waiting to be accepted.
+constexpr int kTcpFastOpenQueueLength = 256;
+constexpr int kStatsIntervalSeconds = 60;
+constexpr int kDrainCheckIntervalSeconds = 10;
+// How often QUIC proxy streams holding no data free their receive buffers.
+constexpr int kStreamBufferReleaseIntervalSeconds = 10;
+// Listeners accept again once critical memory pressure was not notified for
+// this long.
+constexpr base::TimeDelta kMemoryCriticalHold = base::Seconds(3);
+// Until the RTT of a tunnel session is known, and as the RTT grows, a
+// keepalive PING goes unanswered this long before the session is replaced.
+constexpr base::TimeDelta kMaxKeepaliveTimeout = base::Seconds(10);
+// With --low-power, delayed work that can wait runs at multiples of
+// kLowPowerLeeway, and the keepalive PINGs of tunnel sessions are batched in
+// slots of a quarter of the keepalive interval.
+constexpr base::TimeDelta kLowPowerLeeway = base::Milliseconds(250);
+constexpr int kLowPowerKeepaliveSlotDivisor = 4;
 constexpr net::NetworkTrafficAnnotationTag kTrafficAnnotation =
     net::DefineNetworkTrafficAnnotation("naive", "");
 
+// The pumps of all IO threads record into the same histogram, so it is
+// logged once, from the main thread.
+void LogBusyPollStats() {
+  base::HistogramBase* histogram = base::StatisticsRecorder::FindHistogram(
+      "MessagePumpEpoll.BusyPollTimeToEvent");
+  if (!histogram) {
+    return;
+  }
+  std::unique_ptr<base::HistogramSamples> samples =
+      histogram->SnapshotSamples();
+  const int count = samples->TotalCount();
+  VLOG(1) << "Busy poll: events_without_wakeup=" << count
+          << " mean_usec=" << (count > 0 ? samples->sum() / count : 0);
+}
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+// Logs the wake-ups of all IO threads since the last call, made every
+// minute.
+class WakeUpLogger {
+ public:
+  void Log() {
+    uint64_t count = base::MessagePumpEpoll::GetWakeUpCount();
+    VLOG(1) << "Wakeups: per_minute=" << count - last_count_;
+    last_count_ = count;
+  }
+
+ private:
+  uint64_t last_count_ = 0;
+};
+#endif
+
+// Logs the most memory a busy tunnel holds with `config`: the connection,
+// a read and a write buffer each way, and the receive window of its stream
+// over a tunnel session, whose HTTP/2 and QUIC defaults are both 6 MiB.
+void LogTunnelMemoryBound(const net::NaiveConfig& config) {
+  constexpr int kDefaultStreamWindow = net::kQuicStreamMaxRecvWindowSize;
+  size_t relay = sizeof(net::NaiveConnection) + 4 * config.relay_buffer;
+  int http2_window = config.http2_stream_window > 0
+                         ? config.http2_stream_window
+                         : kDefaultStreamWindow;
+  int quic_window = config.quic_stream_window > 0 ? config.quic_stream_window
+                                                  : kDefaultStreamWindow;
+  LOG(INFO) << "Tunnel memory bound: relay=" << relay
+            << " http2_tunnel=" << relay + http2_window
+            << " quic_tunnel=" << relay + quic_window;
+}
+
+// Reads the switches, or the config file if no switches are given. Returns
+// false if the config file cannot be read.
+bool ReadConfigDict(const base::CommandLine& proc,
+                    base::Value::Dict* config_dict) {
+  const auto& args = proc.GetArgs();
+  if (args.empty() && proc.argv().size() >= 2) {
+    *config_dict = GetSwitchesAsValue(proc);
+    return true;
+  }
+  base::FilePath config_file;
+  if (!args.empty()) {
+    config_file = base::FilePath(args[0]);
+  } else {
+    config_file = base::FilePath::FromUTF8Unsafe("config.json");
+  }
+  JSONFileValueDeserializer reader(config_file);
+  int error_code;
+  std::string error_message;
+  std::unique_ptr<base::Value> value =
+      reader.Deserialize(&error_code, &error_message);
+  if (value == nullptr) {
+    std::cerr << "Error reading " << config_file << ": (" << error_code
+              << ") " << error_message << std::endl;
+    return false;
+  }
+  if (const base::Value::Dict* dict = value->GetIfDict()) {
+    *config_dict = dict->Clone();
+  }
+  return true;
+}
+
 std::unique_ptr<base::Value::Dict> GetConstants() {
   base::Value::Dict constants_dict = net::GetNetConstants();
   base::Value::Dict dict;
@@ -102,6 +288,37 @@ std::unique_ptr<base::Value::Dict> GetConstants() {
   constants_dict.Set("clientInfo", std::move(dict));
   return std::make_unique<base::Value::Dict>(std::move(constants_dict));
 }
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+// Pins IO thread i of `threads` to the allowed CPUs whose number modulo the
+// number of threads is i, matching the reuseport CPU steering of the
+// listeners. The main thread is pinned last, as threads created later inherit
+// its affinity.
+void PinIoThreads(const std::vector<base::PlatformThreadId>& threads) {
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    PLOG(WARNING) << "sched_getaffinity";
+    return;
+  }
+  int num_threads = static_cast<int>(threads.size());
+  for (int i = num_threads - 1; i >= 0; --i) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu = i; cpu < CPU_SETSIZE; cpu += num_threads) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        CPU_SET(cpu, &cpus);
+      }
+    }
+    if (CPU_COUNT(&cpus) == 0) {
+      LOG(WARNING) << "No CPU to pin IO thread " << i << " to";
+      continue;
+    }
+    if (sched_setaffinity(threads[i], sizeof(cpus), &cpus) != 0) {
+      PLOG(WARNING) << "Failed to pin IO thread " << i;
+    }
+  }
+}
+#endif
 }  // namespace
 
 namespace net {
@@ -119,19 +336,27 @@ class PrintingLogObserver : public NetLog::ThreadSafeObserver {
     net_log()->RemoveObserver(this);
   }
 
+  // The only event types printed. NetLog drops the others before building
+  // their parameters.
+  static NetLogEventTypeSet GetEventTypes() {
+    NetLogEventTypeSet event_types;
+    for (NetLogEventType type : {
+             NetLogEventType::SOCKET_POOL_STALLED_MAX_SOCKETS,
+             NetLogEventType::SOCKET_POOL_STALLED_MAX_SOCKETS_PER_GROUP,
+             NetLogEventType::
+                 HTTP2_SESSION_STREAM_STALLED_BY_SESSION_SEND_WINDOW,
+             NetLogEventType::
+                 HTTP2_SESSION_STREAM_STALLED_BY_STREAM_SEND_WINDOW,
+             NetLogEventType::HTTP2_SESSION_STALLED_MAX_STREAMS,
+             NetLogEventType::HTTP2_STREAM_FLOW_CONTROL_UNSTALLED,
+         }) {
+      event_types.set(static_cast<size_t>(type));
+    }
+    return event_types;
+  }
+
   // NetLog::ThreadSafeObserver implementation:
   void OnAddEntry(const NetLogEntry& entry) override {
-    switch (entry.type) {
-      case NetLogEventType::SOCKET_POOL_STALLED_MAX_SOCKETS:
-      case NetLogEventType::SOCKET_POOL_STALLED_MAX_SOCKETS_PER_GROUP:
-      case NetLogEventType::HTTP2_SESSION_STREAM_STALLED_BY_SESSION_SEND_WINDOW:
-      case NetLogEventType::HTTP2_SESSION_STREAM_STALLED_BY_STREAM_SEND_WINDOW:
-      case NetLogEventType::HTTP2_SESSION_STALLED_MAX_STREAMS:
-      case NetLogEventType::HTTP2_STREAM_FLOW_CONTROL_UNSTALLED:
-        break;
-      default:
-        return;
-    }
     const char* source_type = NetLog::SourceTypeToString(entry.source.type);
     const char* event_type = NetLogEventTypeToString(entry.type);
     const char* event_phase = NetLog::EventPhaseToString(entry.phase);
@@ -146,6 +371,9 @@ class PrintingLogObserver : public NetLog::ThreadSafeObserver {
 };
 }  // namespace
 
+// Only defined where listen sockets can be inherited.
+class NaiveInheritedSockets;
+
 namespace {
 std::unique_ptr<URLRequestContext> BuildCertURLRequestContext(NetLog* net_log) {
   URLRequestContextBuilder builder;
@@ -165,21 +393,164 @@ std::unique_ptr<URLRequestContext> BuildCertURLRequestContext(NetLog* net_log) {
   return builder.Build();
 }
 
+// Whether the context makes TLS connections, to HTTPS or QUIC proxies, or to
+// DoH servers. A server with only direct chains makes none.
+bool MakesTlsConnections(const NaiveConfig& config) {
+  if (config.doh_config || config.resolver_upstream.is_valid())
+    return true;
+  for (const NaiveProxyChainConfig& chain_config : config.proxy_chains) {
+    for (const ProxyServer& server : chain_config.chain.proxy_servers()) {
+      if (server.is_secure_http_like())
+        return true;
+    }
+  }
+  return false;
+}
+
+// Replaces the credentials of proxies already in the cache.
+void AddProxyCredentials(const NaiveConfig& config,
+                         HttpNetworkSession* session) {
+  auto* auth_cache = session->http_auth_cache();
+  for (const auto& [k, v] : config.auth_store) {
+    auth_cache->Add(k, HttpAuth::AUTH_PROXY,
+                    /*realm=*/{}, HttpAuth::AUTH_SCHEME_BASIC, {},
+                    /*challenge=*/"Basic", v, /*path=*/"/");
+  }
+}
+
+// Sets the congestion control, packet size and pacing options of the QUIC
+// proxy sessions. Only takes effect on the params of a QuicContext given to
+// the builder, as QuicSessionPool copies them in Build().
+void SetQuicCongestionControlParams(const NaiveConfig& config,
+                                    QuicParams* quic) {
+  // Options of this side are client options, those sent to the proxy
+  // connection options.
+  for (quic::QuicTag tag : config.quic_connection_options) {
+    quic->connection_options.push_back(tag);
+    quic->client_connection_options.push_back(tag);
+  }
+  if (config.quic_max_packet_size > 0) {
+    quic->max_packet_length = config.quic_max_packet_size;
+    // Proxy sessions are not tunneled through CONNECT-UDP here.
+    quic->additional_proxy_packet_length = 0;
+  }
+  quic->max_pacing_rate =
+      quic::QuicBandwidth::FromBitsPerSecond(config.quic_max_pacing_rate);
+}
+
+// Sets the socket receive buffer of the QUIC proxy sessions and how far it
+// grows on kernel drops. Like SetQuicCongestionControlParams(), only for the
+// params of a QuicContext given to the builder.
+void SetQuicReceiveBufferParams(const NaiveConfig& config, QuicParams* quic) {
+  if (config.quic_receive_buffer > 0) {
+    quic->socket_receive_buffer_size = config.quic_receive_buffer;
+  }
+  quic->max_socket_receive_buffer_size = config.quic_max_receive_buffer;
+}
+
+// Sets how the QUIC proxy sessions follow network changes.
+void SetQuicMigrationParams(const NaiveConfig& config, QuicParams* quic) {
+  // New tunnels get new sessions on the new network.
+  if (config.no_quic_migration) {
+    quic->allow_port_migration = false;
+    quic->migrate_sessions_on_network_change_v2 = false;
+    quic->goaway_sessions_on_ip_change = true;
+    return;
+  }
+  // Proxy sessions carry every tunnel, so they move to the new path on
+  // network changes rather than taking the tunnels down. Idle ones move
+  // too, as they are kept for the next tunnels.
+  quic->allow_port_migration = true;
+  quic->migrate_idle_sessions = true;
+  quic->idle_session_migration_period = quic->idle_connection_timeout;
+  if (NetworkChangeNotifier::AreNetworkHandlesSupported()) {
+    quic->migrate_sessions_on_network_change_v2 = true;
+    quic->migrate_sessions_early_v2 = true;
+    quic->retry_on_alternate_network_before_handshake = true;
+  } else {
+    quic->migrate_sessions_on_network_change_v2 = false;
+    quic->migrate_sessions_on_ip_change = true;
+  }
+}
+
 // Builds a URLRequestContext assuming there's only a single loop.
 std::unique_ptr<URLRequestContext> BuildURLRequestContext(
     const NaiveConfig& config,
     scoped_refptr<CertNetFetcherURLRequest> cert_net_fetcher,
+    NaiveCertVerifyStore* cert_verify_store,
+    NaiveHostCacheStore* host_cache_store,
+    NaiveSharedHostCache* shared_host_cache,
+    NaiveSocketWatcherFactory* socket_watcher_factory,
+    NetworkQualityEstimator* network_quality_estimator,
+    const base::FilePath& http_cache_path,
     NetLog* net_log) {
+  // The proxies are always resolved from the cache if possible, so a new
+  // tunnel does not wait for DNS when the entry is stale. Only used while
+  // building.
+  // A server, with only direct chains, resolves the destinations of all its
+  // clients. It gets a larger cache, and keeps popular ones in it.
+  base::flat_set<std::string> proxy_hosts;
+  bool is_server = true;
+  for (const NaiveProxyChainConfig& chain_config : config.proxy_chains) {
+    for (const ProxyServer& server : chain_config.chain.proxy_servers()) {
+      proxy_hosts.insert(server.host_port_pair().host());
+    }
+    if (!chain_config.chain.is_direct())
+      is_server = false;
+  }
+  HostResolver::ManagerOptions resolver_options;
+  if (is_server) {
+    resolver_options.host_cache_size =
+        NaiveStaleHostResolver::kServerHostCacheSize;
+    resolver_options.dns_udp_socket_pool_size =
+        NaiveStaleHostResolver::kServerDnsUdpSockets;
+  }
+  if (config.doh_config) {
+    // Only the destinations of direct connections allow secure DNS. The
+    // queries are requests of this context, multiplexed over its pooled
+    // HTTP/2 or HTTP/3 session to the DoH server.
+    resolver_options.dns_config_overrides =
+        DnsConfigOverrides::CreateOverridingEverythingWithDefaults();
+    resolver_options.dns_config_overrides.dns_over_https_config =
+        *config.doh_config;
+    resolver_options.dns_config_overrides.secure_dns_mode =
+        SecureDnsMode::kSecure;
+  }
+  if (config.connect_while_resolving) {
+    // The system resolver only answers once both families are resolved.
+    resolver_options.insecure_dns_client_enabled = true;
+  }
+  NaiveStaleHostResolver::Factory host_resolver_factory(
+      std::move(resolver_options), std::move(proxy_hosts),
+      /*prefetch_popular_hosts=*/is_server, host_cache_store,
+      shared_host_cache);
   URLRequestContextBuilder builder;
 
-  builder.DisableHttpCache();
+  // Tunnels do not go through the HTTP cache, only requests of the context.
+  if (http_cache_path.empty()) {
+    builder.DisableHttpCache();
+  } else {
+    URLRequestContextBuilder::HttpCacheParams cache_params;
+    cache_params.type = URLRequestContextBuilder::HttpCacheParams::DISK_SIMPLE;
+    cache_params.path = http_cache_path;
+    cache_params.max_size = config.http_cache_size;
+    builder.EnableHttpCache(cache_params);
+  }
   builder.set_net_log(net_log);
 
   ProxyConfig proxy_config;
   proxy_config.proxy_rules().type =
       net::ProxyConfig::ProxyRules::Type::PROXY_LIST;
-  proxy_config.proxy_rules().single_proxies.SetSingleProxyChain(
-      config.proxy_chain);
+  // Requests made by the context itself fall back over the chains in order.
+  // Tunnels are spread over them by NaiveProxySelector.
+  for (const NaiveProxyChainConfig& chain_config : config.proxy_chains) {
+    if (chain_config.quic_chain.IsValid()) {
+      proxy_config.proxy_rules().single_proxies.AddProxyChain(
+          chain_config.quic_chain);
+    }
+    proxy_config.proxy_rules().single_proxies.AddProxyChain(
+        chain_config.chain);
+  }
   LOG(INFO) << "Proxying via "
             << proxy_config.proxy_rules().single_proxies.ToDebugString();
   auto proxy_service =
@@ -193,13 +564,58 @@ std::unique_ptr<URLRequestContext> BuildURLRequestContext(
   if (!config.host_resolver_rules.empty()) {
     builder.set_host_mapping_rules(config.host_resolver_rules);
   }
+  builder.set_host_resolver_factory(&host_resolver_factory);
+  builder.set_socket_performance_watcher_factory(socket_watcher_factory);
+  if (network_quality_estimator) {
+    builder.set_network_quality_estimator(network_quality_estimator);
+  }
 
-  builder.SetCertVerifier(
-      CertVerifier::CreateDefault(std::move(cert_net_fetcher)));
+  if (config.tcp_fast_open || config.mptcp || config.uplink_set) {
+    builder.set_client_socket_factory(
+        std::make_unique<NaiveClientSocketFactory>(
+            config.tcp_fast_open, config.mptcp, config.uplink_set));
+  }
 
+  {
+    HttpNetworkSessionParams params;
+    params.proxy_connect_race_width = config.connect_race;
+    params.enable_proxy_key_share_tuning = config.adaptive_post_quantum;
+    params.enable_proxy_early_data = config.tls_early_data;
+    params.enable_proxy_kernel_tls = config.kernel_tls;
+    params.enable_socks5_pipelining = config.socks_pipelining;
+    params.enable_connect_while_resolving = config.connect_while_resolving;
+    if (config.http2_session_window > 0) {
+      params.spdy_session_max_recv_window_size = config.http2_session_window;
+    }
+    if (config.http2_stream_window > 0) {
+      params.http2_settings[spdy::SETTINGS_INITIAL_WINDOW_SIZE] =
+          config.http2_stream_window;
+    }
+    // NaiveNetworkChangeDebouncer takes IP address changes instead.
+    params.ignore_ip_address_changes = true;
+    builder.set_http_network_session_params(params);
+  }
+
+  // As CertVerifier::CreateDefault(), with the cache backed by the store.
+  auto cert_verifier = std::make_unique<CachingCertVerifier>(
+      std::make_unique<CoalescingCertVerifier>(
+          CertVerifier::CreateDefaultWithoutCaching(
+              std::move(cert_net_fetcher))));
+  if (cert_verify_store) {
+    cert_verifier->set_store(cert_verify_store);
+  }
+  builder.SetCertVerifier(std::move(cert_verifier));
+
+  // Older servers reject padding types they do not know, so kVariant2 is
+  // only requested when it is configured.
+  std::vector<PaddingType> padding_types = {PaddingType::kVariant1,
+                                            PaddingType::kNone};
+  if (!config.padding_profile.empty()) {
+    padding_types.insert(padding_types.begin(), PaddingType::kVariant2);
+  }
   builder.set_proxy_delegate(std::make_unique<NaiveProxyDelegate>(
-      config.extra_headers, 
-      std::vector<PaddingType>{PaddingType::kVariant1, PaddingType::kNone}));
+      config.extra_headers, padding_types, config.compression,
+      config.optimistic_connect));
 
   if (config.no_post_quantum == true) {
     struct NoPostQuantum : public SSLConfigService {
@@ -216,26 +632,1276 @@ std::unique_ptr<URLRequestContext> BuildURLRequestContext(
     builder.set_ssl_config_service(std::make_unique<NoPostQuantum>());
   }
 
-  auto context = builder.Build();
-
+  // The session pool copies the QUIC params when the context is built.
+  // Without QUIC proxies the default QuicContext of the builder is kept.
   if (!config.origins_to_force_quic_on.empty()) {
-    auto* quic = context->quic_context()->params();
+    auto quic_context = std::make_unique<QuicContext>();
+    auto* quic = quic_context->params();
     quic->supported_versions = {quic::ParsedQuicVersion::RFCv1()};
     quic->origins_to_force_quic_on.insert(
         config.origins_to_force_quic_on.begin(),
         config.origins_to_force_quic_on.end());
+    SetQuicCongestionControlParams(config, quic);
+    if (config.quic_session_window > 0) {
+      quic->session_max_recv_window_size = config.quic_session_window;
+    }
+    if (config.quic_stream_window > 0) {
+      quic->stream_max_recv_window_size = config.quic_stream_window;
+    }
+    SetQuicReceiveBufferParams(config, quic);
+    quic->proxy_keep_alive_interval = config.proxy_keepalive;
+    quic->proxy_mtu_discovery = config.quic_mtu_discovery;
+    quic->report_ecn = config.quic_ecn;
+    quic->proxy_ack_decimation = config.quic_ack_decimation;
+    SetQuicMigrationParams(config, quic);
+    builder.set_quic_context(std::move(quic_context));
   }
 
-  for (const auto& [k, v] : config.auth_store) {
+  auto context = builder.Build();
+
+  if (config.http2_auto_window > 0) {
     auto* session = context->http_transaction_factory()->GetSession();
-    auto* auth_cache = session->http_auth_cache();
-    auth_cache->Add(k, HttpAuth::AUTH_PROXY,
-                    /*realm=*/{}, HttpAuth::AUTH_SCHEME_BASIC, {},
-                    /*challenge=*/"Basic", v, /*path=*/"/");
+    session->spdy_session_pool()->set_max_auto_tuned_recv_window_size(
+        config.http2_auto_window);
+  }
+  {
+    auto* session = context->http_transaction_factory()->GetSession();
+    session->spdy_session_pool()->set_max_read_buffer_size(
+        config.http2_read_buffer);
+    session->spdy_session_pool()->set_window_update_batch_delay(
+        config.http2_window_update_delay);
   }
 
+  // Padding values never repeat, so indexing them would only evict the
+  // headers that do from the HPACK table.
+  {
+    auto* session = context->http_transaction_factory()->GetSession();
+    session->spdy_session_pool()->set_hpack_unindexed_headers(
+        {kPaddingHeader});
+  }
+
+  if (config.proxy_keepalive.is_positive()) {
+    auto* session = context->http_transaction_factory()->GetSession();
+    base::TimeDelta batch_slot;
+    if (config.low_power) {
+      batch_slot = config.proxy_keepalive / kLowPowerKeepaliveSlotDivisor;
+    }
+    session->spdy_session_pool()->set_keepalive(
+        config.proxy_keepalive, kMaxKeepaliveTimeout, batch_slot);
+  }
+
+  // PINGs differ from a browser, so RTTs are only sampled when they are of
+  // use.
+  if (config.proxy_selection == ProxySelection::kLowestLatency &&
+      config.proxy_chains.size() > 1) {
+    auto* session = context->http_transaction_factory()->GetSession();
+    session->spdy_session_pool()->set_rtt_sampling_enabled(true);
+  }
+
+  AddProxyCredentials(config,
+                      context->http_transaction_factory()->GetSession());
+
   return context;
 }
+
+// Holds `socket` for TCP listeners, `udp_socket` for quic listeners and
+// `tun_socket` for tun listeners. A balanced TCP listener has `balancer` on
+// every thread, and `socket` on thread 0 only.
+struct NaiveListenSocket {
+  NaiveListenConfig config;
+  std::unique_ptr<TCPServerSocket> socket;
+  scoped_refptr<NaiveAcceptBalancer> balancer;
+  std::unique_ptr<UDPServerSocket> udp_socket;
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_ANDROID)
+  std::unique_ptr<NaiveTunServerSocket> tun_socket;
+#endif
+#if BUILDFLAG(IS_LINUX)
+  // UDP of a tproxy listener, not handed off.
+  base::ScopedFD tproxy_udp_fd;
+#endif
+#if BUILDFLAG(IS_POSIX)
+  std::unique_ptr<NaiveUnixServerSocket> unix_socket;
+#endif
+};
+
+// As in logs and metrics.
+std::string GetListenName(const NaiveListenConfig& listen_config) {
+  if (listen_config.unix_socket) {
+    return base::StringPrintf("%s+unix://%s", ToString(listen_config.protocol),
+                              listen_config.addr.c_str());
+  }
+  return base::StringPrintf("%s://%s:%d", ToString(listen_config.protocol),
+                            listen_config.addr.c_str(), listen_config.port);
+}
+
+// In order of preference. Padding is off without padding frames.
+std::vector<PaddingType> GetListenPaddingTypes(
+    const NaiveListenConfig& listen_config) {
+  if (listen_config.padding_limits.frames == 0) {
+    return {PaddingType::kNone};
+  }
+  return {PaddingType::kVariant2, PaddingType::kVariant1, PaddingType::kNone};
+}
+
+// The quic listeners share the flow control windows of the QUIC proxies.
+// Connection options are those sent by the clients.
+quic::QuicConfig CreateHttp3ProxyConfig(const NaiveConfig& config) {
+  quic::QuicConfig quic_config;
+  if (config.quic_session_window > 0) {
+    quic_config.SetInitialSessionFlowControlWindowToSend(
+        config.quic_session_window);
+  }
+  if (config.quic_stream_window > 0) {
+    quic_config.SetInitialStreamFlowControlWindowToSend(
+        config.quic_stream_window);
+  }
+  return quic_config;
+}
+
+std::unique_ptr<NaiveProxySelector> CreateProxySelector(
+    const NaiveConfig& config) {
+  return std::make_unique<NaiveProxySelector>(
+      config.proxy_chains, config.proxy_selection, config.insecure_concurrency,
+      config.adaptive_concurrency, config.class_sessions, config.uplink_set,
+      kTrafficAnnotation);
+}
+
+bool HasSameProxySelection(const NaiveConfig& a, const NaiveConfig& b) {
+  return std::ranges::equal(a.proxy_chains, b.proxy_chains,
+                            [](const NaiveProxyChainConfig& x,
+                               const NaiveProxyChainConfig& y) {
+                              return x.chain == y.chain &&
+                                     x.quic_chain == y.quic_chain &&
+                                     x.weight == y.weight;
+                            }) &&
+         a.proxy_selection == b.proxy_selection &&
+         a.insecure_concurrency == b.insecure_concurrency &&
+         a.adaptive_concurrency == b.adaptive_concurrency;
+}
+
+// Owns the network stack of one IO thread: its URLRequestContext, and thus its
+// HttpNetworkSession and socket pools, plus the proxies accepting on the listen
+// sockets assigned to the thread. Must be created and destroyed on the thread
+// it serves.
+class NaiveWorker {
+ public:
+  // Only the main worker is given `http_cache_path`, as the disk cache is
+  // not shared between contexts. `thread` is 0 for the main worker.
+  NaiveWorker(int thread,
+              const NaiveConfig& config,
+              std::vector<NaiveListenSocket> listen_sockets,
+              std::unique_ptr<RedirectResolver> resolver,
+              const base::FilePath& http_cache_path,
+              NaiveQuicSessionStore* quic_session_store,
+              NaiveSslSessionStore* ssl_session_store,
+              NaiveCertVerifyStore* cert_verify_store,
+              NaiveHostCacheStore* host_cache_store,
+              NaiveSharedHostCache* shared_host_cache,
+              NaiveAccessLog* access_log)
+      : thread_(thread),
+        buffer_pool_(config.buffer_pool_size,
+                     config.relay_buffer,
+                     config.huge_page_buffers),
+        scheduler_(config.scheduler_quantum, config.scheduler_slice),
+        connection_budget_(
+            (config.max_connections + config.threads - 1) / config.threads,
+            config.fd_budget),
+        client_limiter_(
+            static_cast<double>(config.client_rate) / config.threads,
+            (config.client_burst + config.threads - 1) / config.threads,
+            (config.client_max_connections + config.threads - 1) /
+                config.threads),
+        proxy_selector_(CreateProxySelector(config)),
+        resolver_(std::move(resolver)),
+        config_(config) {
+    NetLog* net_log = NetLog::Get();
+    scoped_refptr<CertNetFetcherURLRequest> cert_net_fetcher;
+    // The builtin verifier is supported but not enabled by default on Mac,
+    // falling back to CreateSystemVerifyProc() which drops the net fetcher,
+    // causing a DCHECK in ~CertNetFetcherURLRequest().
+    // See CertVerifier::CreateDefaultWithoutCaching() and
+    // CertVerifyProc::CreateSystemVerifyProc() for the build flags.
+#if BUILDFLAG(CHROME_ROOT_STORE_SUPPORTED) || BUILDFLAG(IS_FUCHSIA) || \
+    BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+    // The fetcher only fetches intermediates for certificates of TLS
+    // connections. TLS chains added by a reload verify without it.
+    if (MakesTlsConnections(config)) {
+      cert_context_ = BuildCertURLRequestContext(net_log);
+      cert_net_fetcher = base::MakeRefCounted<CertNetFetcherURLRequest>();
+      cert_net_fetcher->SetURLRequestContext(cert_context_.get());
+    }
+#endif
+    if (config.network_quality) {
+      network_quality_estimator_ = std::make_unique<NetworkQualityEstimator>(
+          std::make_unique<NetworkQualityEstimatorParams>(
+              std::map<std::string, std::string>()),
+          net_log);
+      // Its watchers are fed by those of this thread.
+      socket_watcher_factory_.set_next_factory(
+          network_quality_estimator_->GetSocketPerformanceWatcherFactory());
+    }
+    context_ = BuildURLRequestContext(
+        config, std::move(cert_net_fetcher), cert_verify_store,
+        host_cache_store, shared_host_cache, &socket_watcher_factory_,
+        network_quality_estimator_.get(), http_cache_path, net_log);
+    if (!http_cache_path.empty()) {
+      http_cache_ = std::make_unique<NaiveHttpCache>(context_.get(),
+                                                     config.http_cache_hosts);
+    }
+    auto* session = context_->http_transaction_factory()->GetSession();
+    if (quic_session_store) {
+      session->quic_session_pool()->set_session_cache_factory(
+          base::BindRepeating(&NaiveQuicSessionStore::CreateSessionCache,
+                              base::Unretained(quic_session_store)));
+      // The saved tickets come from QUIC sessions that worked. Otherwise
+      // the first sessions wait for the handshake, without 0-RTT.
+      if (quic_session_store->loaded_sessions()) {
+        session->quic_session_pool()
+            ->set_is_quic_known_to_work_on_current_network(true);
+      }
+    }
+    if (ssl_session_store) {
+      session->ssl_client_session_cache()->set_store(ssl_session_store);
+    }
+    if (config.quic_mtu_discovery) {
+      mtu_store_ =
+          std::make_unique<NaiveMtuStore>(session->quic_session_pool());
+    }
+    // Sockets bound to uplinks leave from them whatever the routes say.
+    network_change_debouncer_ = std::make_unique<NaiveNetworkChangeDebouncer>(
+        session, /*check_routes=*/!config.uplink_set);
+    if (resolver_ && config.resolver_upstream.is_valid()) {
+      resolver_->SetUpstream(config.resolver_upstream, context_.get(),
+                             kTrafficAnnotation);
+    }
+
+    if (access_log) {
+      access_log_buffer_ = std::make_unique<NaiveAccessLog::Buffer>(
+          access_log, config.access_log_sample);
+    }
+
+    for (NaiveListenSocket& listen_socket : listen_sockets) {
+      AddListener(std::move(listen_socket));
+    }
+
+    StartSessionWarmer();
+    // Only taken by direct tunnels, so it is kept across reloads of the
+    // proxy chains.
+    if (config.spare_connections > 0) {
+      spare_pool_ = std::make_unique<NaiveSparePool>(
+          session, config.spare_connections, config.fd_budget);
+    }
+
+    if (VLOG_IS_ON(1)) {
+      stats_timer_.Start(FROM_HERE, base::Seconds(kStatsIntervalSeconds),
+                         this, &NaiveWorker::LogStats);
+    }
+    if (config_.thread_loads) {
+      load_timer_.Start(FROM_HERE, NaiveThreadLoads::kReportInterval, this,
+                        &NaiveWorker::ReportLoad);
+    }
+    stream_buffer_timer_.Start(
+        FROM_HERE, base::Seconds(kStreamBufferReleaseIntervalSeconds), this,
+        &NaiveWorker::ReleaseStreamBuffers);
+    memory_pressure_listener_ = std::make_unique<base::MemoryPressureListener>(
+        FROM_HERE, base::BindRepeating(&NaiveWorker::OnMemoryPressure,
+                                       base::Unretained(this)));
+  }
+
+  NaiveWorker(const NaiveWorker&) = delete;
+  NaiveWorker& operator=(const NaiveWorker&) = delete;
+
+  ~NaiveWorker() = default;
+
+  // Copies the counters of this thread, adding the bytes relayed so far by
+  // open connections.
+  NaiveMetrics CollectMetrics() {
+    NaiveMetrics metrics;
+    for (size_t i = 0; i < naive_proxies_.size(); ++i) {
+      metrics.listeners[listen_names_[i]].Merge(
+          naive_proxies_[i]->GetMetrics());
+    }
+    auto* session = context_->http_transaction_factory()->GetSession();
+    for (size_t chain = 0; chain < proxy_selector_->num_chains(); ++chain) {
+      const ProxyChain& proxy_chain =
+          proxy_selector_->proxy_info({.chain = chain}).proxy_chain();
+      const std::vector<int>& connections =
+          proxy_selector_->session_connections(chain);
+      for (size_t i = 0; i < connections.size(); ++i) {
+        metrics.session_connections[proxy_chain.ToDebugString()][i] +=
+            connections[i];
+      }
+      ClientSocketPool* pool = session->GetSocketPool(
+          HttpNetworkSession::NORMAL_SOCKET_POOL, proxy_chain);
+      metrics.idle_pool_sockets += pool->IdleSocketCount();
+      if (pool->IsStalled()) {
+        metrics.stalled_pools++;
+      }
+    }
+    const NaivePaddingSocket::Stats& padding_stats =
+        NaivePaddingSocket::GetStatsForCurrentThread();
+    metrics.padding_bytes_written = padding_stats.padding_bytes_written;
+    metrics.padding_bytes_read = padding_stats.padding_bytes_read;
+    metrics.compressed_tunnels = padding_stats.compressed_tunnels;
+    metrics.compression_ratio_sum = padding_stats.compression_ratio_sum;
+    metrics.compression_payload_bytes = padding_stats.compression_payload_bytes;
+    metrics.compression_frame_bytes = padding_stats.compression_frame_bytes;
+    if (resolver_) {
+      metrics.resolver_mappings = resolver_->num_resolutions();
+    }
+    const NaiveSocketWatcherFactory::Stats& tcp_stats =
+        socket_watcher_factory_.stats();
+    metrics.tcp_rtt_samples = tcp_stats.rtt_samples;
+    metrics.tcp_rtt_sum = tcp_stats.rtt_sum;
+    metrics.tcp_segments_sent = tcp_stats.segments_sent;
+    metrics.tcp_segments_retransmitted = tcp_stats.segments_retransmitted;
+    metrics.tcp_congestion_window = tcp_stats.congestion_window;
+    QuicSessionPool::ProxyAckStats ack_stats =
+        session->quic_session_pool()->GetProxyAckStats();
+    metrics.quic_ack_frames_sent = ack_stats.ack_frames_sent;
+    metrics.quic_bytes_received = ack_stats.bytes_received;
+    if (http_cache_) {
+      const NaiveHttpCache::Stats& cache_stats = http_cache_->stats();
+      metrics.http_cache_requests = cache_stats.requests;
+      metrics.http_cache_hits = cache_stats.hits;
+      metrics.http_cache_saved_bytes = cache_stats.saved_bytes;
+    }
+    return metrics;
+  }
+
+  // Benchmarks the proxy chains of this thread.
+  void RunBench(const NaiveBench::Params& params,
+                base::OnceCallback<void(NaiveBench::Result)> callback) {
+    auto* session = context_->http_transaction_factory()->GetSession();
+    bench_ = std::make_unique<NaiveBench>(
+        params, config_.padding_profile, session, proxy_selector_.get(),
+        kTrafficAnnotation);
+    bench_->Run(std::move(callback));
+  }
+
+  // Applies the reloadable options of `new_config`, and starts accepting on
+  // `added_sockets`. New connections use the new proxy chains, while open
+  // ones keep theirs until they close. Removed listeners stop accepting and
+  // are freed once their connections are closed.
+  void Reload(const NaiveConfig& new_config,
+              std::vector<NaiveListenSocket> added_sockets) {
+    bool same_proxy_selection = HasSameProxySelection(config_, new_config);
+    config_.ApplyReloadable(new_config);
+
+    auto* session = context_->http_transaction_factory()->GetSession();
+    if (!same_proxy_selection) {
+      session_warmer_.reset();
+      standby_pool_.reset();
+      quality_adapter_.reset();
+      health_checker_.reset();
+      proxy_racer_.reset();
+      retired_proxy_selectors_.push_back(std::move(proxy_selector_));
+      proxy_selector_ = CreateProxySelector(config_);
+      for (const auto& naive_proxy : naive_proxies_) {
+        naive_proxy->SetProxySelector(proxy_selector_.get());
+      }
+      StartSessionWarmer();
+    }
+    auto* proxy_delegate =
+        static_cast<NaiveProxyDelegate*>(session->context().proxy_delegate);
+    proxy_delegate->SetExtraHeaders(config_.extra_headers);
+    AddProxyCredentials(config_, session);
+
+    for (size_t i = 0; i < naive_proxies_.size();) {
+      auto it = std::ranges::find_if(
+          config_.listen, [&](const NaiveListenConfig& listen_config) {
+            return listen_config.IsSameListener(listen_configs_[i]);
+          });
+      if (it != config_.listen.end()) {
+        naive_proxies_[i]->SetListenAuth(it->users);
+        listen_configs_[i] = *it;
+        ++i;
+        continue;
+      }
+      LOG(INFO) << "Stopped listening on " << listen_names_[i];
+      naive_proxies_[i]->StopListening();
+      draining_proxies_.push_back(std::move(naive_proxies_[i]));
+      naive_proxies_.erase(naive_proxies_.begin() + i);
+      listen_configs_.erase(listen_configs_.begin() + i);
+      listen_names_.erase(listen_names_.begin() + i);
+    }
+    for (NaiveListenSocket& listen_socket : added_sockets) {
+      AddListener(std::move(listen_socket));
+    }
+
+    FreeDrained();
+    if (!retired_proxy_selectors_.empty() || !draining_proxies_.empty()) {
+      drain_timer_.Start(FROM_HERE, base::Seconds(kDrainCheckIntervalSeconds),
+                         this, &NaiveWorker::FreeDrained);
+    }
+  }
+
+  // Stops accepting and answering resolver queries, once another process
+  // has taken over the listen sockets. Open connections go on.
+  void StopListening() {
+    for (const auto& naive_proxy : naive_proxies_) {
+      naive_proxy->StopListening();
+    }
+    if (resolver_) {
+      resolver_->StopAnswering();
+    }
+  }
+
+  bool HasConnections() const {
+    auto has_connections = [](const auto& naive_proxy) {
+      return naive_proxy->has_connections();
+    };
+    return std::ranges::any_of(naive_proxies_, has_connections) ||
+           std::ranges::any_of(draining_proxies_, has_connections);
+  }
+
+ private:
+  void AddListener(NaiveListenSocket listen_socket) {
+    const NaiveListenConfig& listen_config = listen_socket.config;
+    RelaySocketOptions relay_socket_options =
+        listen_config.relay_socket_options;
+    relay_socket_options.busy_poll =
+        static_cast<int>(config_.busy_poll.InMicroseconds());
+    RedirectResolver* resolver =
+        listen_config.protocol == ClientProtocol::kRedir ||
+                listen_config.protocol == ClientProtocol::kTun ||
+                listen_config.protocol == ClientProtocol::kTproxy ||
+                config_.resolver_all_listeners
+            ? resolver_.get()
+            : nullptr;
+    std::unique_ptr<SSLServerContext> ssl_server_context;
+    std::unique_ptr<Http3ProxyServer> http3_server;
+    if (listen_config.protocol == ClientProtocol::kQuic) {
+      std::unique_ptr<quic::ProofSource> proof_source =
+          CreateHttp3ProxyProofSource(listen_config.cert_pem,
+                                      listen_config.key_pem);
+      if (!proof_source) {
+        LOG(ERROR) << "Invalid certificate or key for quic://"
+                   << listen_config.addr << ":" << listen_config.port;
+        return;
+      }
+      http3_server = std::make_unique<Http3ProxyServer>(
+          std::move(listen_socket.udp_socket), std::move(proof_source),
+          CreateHttp3ProxyConfig(config_));
+    }
+    if (listen_config.protocol == ClientProtocol::kHttps) {
+      ssl_server_context = CreateHttp2ProxySSLServerContext(
+          listen_config.cert_pem, listen_config.key_pem);
+      if (!ssl_server_context) {
+        LOG(ERROR) << "Invalid certificate or key for https://"
+                   << listen_config.addr << ":" << listen_config.port;
+        return;
+      }
+    }
+    std::unique_ptr<ServerSocket> server_socket;
+    if (listen_socket.balancer) {
+      server_socket = std::make_unique<NaiveBalancedServerSocket>(
+          listen_socket.balancer, thread_, std::move(listen_socket.socket));
+    } else {
+      server_socket = std::move(listen_socket.socket);
+    }
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_ANDROID)
+    if (listen_socket.tun_socket) {
+      server_socket = std::move(listen_socket.tun_socket);
+    }
+#endif
+#if BUILDFLAG(IS_POSIX)
+    if (listen_socket.unix_socket) {
+      server_socket = std::move(listen_socket.unix_socket);
+    }
+#endif
+    auto* session = context_->http_transaction_factory()->GetSession();
+    naive_proxies_.push_back(std::make_unique<NaiveProxy>(
+        std::move(server_socket), listen_config.protocol, listen_config.h2c,
+        std::move(ssl_server_context), std::move(http3_server),
+        listen_config.users, config_.accept_budget, config_.idle_timeout,
+        config_.read_idle_timeout, config_.write_idle_timeout,
+        config_.half_open_timeout, proxy_selector_.get(), resolver, session,
+        listen_config.protocol == ClientProtocol::kHttp ? http_cache_.get()
+                                                        : nullptr,
+        kTrafficAnnotation,
+        GetListenPaddingTypes(listen_config), listen_config.padding_limits,
+        config_.padding_profile, listen_config.priority,
+        config_.priority_rules, relay_socket_options,
+        listen_config.rate_limiter, config_.priority_rate_limiters,
+        config_.priority_dscps, &connection_budget_, &client_limiter_,
+        access_log_buffer_.get()));
+#if BUILDFLAG(IS_LINUX)
+    if (listen_socket.tproxy_udp_fd.is_valid() &&
+        !naive_proxies_.back()->ServeTproxyUdp(
+            std::move(listen_socket.tproxy_udp_fd))) {
+      LOG(ERROR) << "No UDP on tproxy://" << listen_config.addr << ":"
+                 << listen_config.port;
+    }
+#endif
+    listen_configs_.push_back(listen_config);
+    listen_names_.push_back(GetListenName(listen_config));
+  }
+
+  void StartSessionWarmer() {
+    // Adaptive sessions start with one per chain.
+    size_t num_warm_sessions = 0;
+    if (config_.preconnect) {
+      num_warm_sessions =
+          config_.adaptive_concurrency ? 1 : config_.insecure_concurrency;
+    }
+    auto* session = context_->http_transaction_factory()->GetSession();
+    session_warmer_ = std::make_unique<NaiveSessionWarmer>(
+        session, *proxy_selector_, config_.proxy_chains.size(),
+        config_.insecure_concurrency, num_warm_sessions, kTrafficAnnotation);
+    if (config_.http1_standby > 0) {
+      standby_pool_ = std::make_unique<NaiveStandbyPool>(
+          session, *proxy_selector_, config_.proxy_chains.size(),
+          config_.http1_standby, kTrafficAnnotation);
+    }
+    proxy_racer_ = std::make_unique<NaiveProxyRacer>(
+        session, proxy_selector_.get(), kTrafficAnnotation);
+    // A single chain has nothing to fail over to.
+    if (!config_.health_check.IsEmpty() && config_.proxy_chains.size() > 1) {
+      health_checker_ = std::make_unique<NaiveHealthChecker>(
+          session, proxy_selector_.get(), config_.health_check,
+          config_.health_check_interval, kTrafficAnnotation);
+    }
+    if (network_quality_estimator_) {
+      quality_adapter_ = std::make_unique<NaiveQualityAdapter>(
+          network_quality_estimator_.get(), session, proxy_selector_.get(),
+          proxy_racer_.get(), config_.http2_auto_window);
+    }
+  }
+
+  // Frees the listeners and proxy selectors left by reloads once their
+  // connections are closed.
+  void FreeDrained() {
+    std::erase_if(draining_proxies_, [](const auto& naive_proxy) {
+      return !naive_proxy->has_connections();
+    });
+    std::erase_if(retired_proxy_selectors_, [](const auto& proxy_selector) {
+      return !proxy_selector->HasActiveConnections();
+    });
+    if (retired_proxy_selectors_.empty() && draining_proxies_.empty()) {
+      drain_timer_.Stop();
+    }
+  }
+
+  // Reports the open connections of the thread and the bytes per second
+  // they relayed since the last report, for the accept balancers.
+  void ReportLoad() {
+    int64_t connections = 0;
+    uint64_t relayed_bytes = 0;
+    for (const auto* proxies : {&naive_proxies_, &draining_proxies_}) {
+      for (const auto& naive_proxy : *proxies) {
+        connections += naive_proxy->num_connections();
+        relayed_bytes += naive_proxy->GetRelayedBytes();
+      }
+    }
+    // Draining listeners freed since the last report take their bytes away.
+    int64_t delta = relayed_bytes > last_relayed_bytes_
+                        ? static_cast<int64_t>(relayed_bytes -
+                                               last_relayed_bytes_)
+                        : 0;
+    last_relayed_bytes_ = relayed_bytes;
+    config_.thread_loads->Report(
+        thread_, connections,
+        delta / NaiveThreadLoads::kReportInterval.InSeconds());
+  }
+
+  // A QUIC stream keeps the block index of its receive buffer sized for the
+  // largest window it filled, up to 16 KB, even once it is idle, where an
+  // HTTP/2 stream holds nothing.
+  void ReleaseStreamBuffers() {
+    context_->http_transaction_factory()
+        ->GetSession()
+        ->quic_session_pool()
+        ->ReleaseEmptyProxyStreamBuffers();
+  }
+
+  // Frees what the thread keeps cached. Under critical pressure, also spends
+  // the connection budget until the pressure stops being notified.
+  void OnMemoryPressure(
+      base::MemoryPressureListener::MemoryPressureLevel level) {
+    buffer_pool_.ReleaseFreeBuffers();
+    HttpNetworkSession* session =
+        context_->http_transaction_factory()->GetSession();
+    session->spdy_session_pool()->ReleaseFreeBuffers();
+    session->quic_session_pool()->ReleaseEmptyProxyStreamBuffers();
+    if (HostCache* host_cache = context_->host_resolver()->GetHostCache()) {
+      host_cache->ClearStaleEntries();
+    }
+    if (resolver_) {
+      resolver_->ReleaseCaches();
+    }
+    if (spare_pool_) {
+      spare_pool_->Clear();
+    }
+    if (level != base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL) {
+      return;
+    }
+    connection_budget_.SetMemoryCritical(true);
+    memory_critical_timer_.Start(
+        FROM_HERE, kMemoryCriticalHold,
+        base::BindOnce(&NaiveConnectionBudget::SetMemoryCritical,
+                       base::Unretained(&connection_budget_), false));
+  }
+
+  void LogStats() {
+    const NaiveBufferPool::Stats& stats = buffer_pool_.stats();
+    VLOG(1) << "Buffer pool: allocated=" << stats.allocated
+            << " reused=" << stats.reused << " recycled=" << stats.recycled
+            << " dropped=" << stats.dropped << " cached=" << stats.cached;
+    if (const NaiveBufferArena* arena = buffer_pool_.arena()) {
+      const NaiveBufferArena::Stats& arena_stats = arena->stats();
+      VLOG(1) << "Buffer arena: chunks=" << arena_stats.chunks
+              << " reserved_huge_pages=" << arena_stats.reserved_huge_pages
+              << " slots_in_use=" << arena_stats.slots_in_use
+              << " node=" << arena_stats.node;
+    }
+    std::optional<NaiveAllocatorStats> allocator_stats =
+        GetAllocatorStatsForCurrentThread();
+    if (allocator_stats) {
+      VLOG(1) << "Thread cache: hits=" << allocator_stats->hits
+              << " misses=" << allocator_stats->misses
+              << " cached_bytes=" << allocator_stats->cached_bytes;
+    }
+    LogRelayStats(allocator_stats);
+    const NaiveScheduler::Stats& scheduler_stats = scheduler_.stats();
+    VLOG(1) << "Scheduler: slices=" << scheduler_stats.slices
+            << " resumed=" << scheduler_stats.resumed
+            << " max_queued=" << scheduler_stats.max_queued;
+    const NaivePaddingSocket::Stats& padding_stats =
+        NaivePaddingSocket::GetStatsForCurrentThread();
+    VLOG(1) << "Padding: frames_written=" << padding_stats.frames_written
+            << " frames_read=" << padding_stats.frames_read
+            << " coalesced_writes=" << padding_stats.coalesced_writes
+            << " buffers_acquired=" << padding_stats.buffers_acquired;
+    if (padding_stats.compressed_tunnels > 0) {
+      VLOG(1) << "Compression: tunnels=" << padding_stats.compressed_tunnels
+              << " mean_ratio="
+              << padding_stats.compression_ratio_sum /
+                     padding_stats.compressed_tunnels
+              << " payload_bytes=" << padding_stats.compression_payload_bytes
+              << " compressed_bytes=" << padding_stats.compression_frame_bytes;
+    }
+    LogConnectionMemoryUsage();
+    if (spare_pool_) {
+      const NaiveSparePool::Stats& spare_stats = spare_pool_->stats();
+      VLOG(1) << "Spare connections: hits=" << spare_stats.hits
+              << " misses=" << spare_stats.misses
+              << " connects=" << spare_stats.connects
+              << " failures=" << spare_stats.failures
+              << " expired=" << spare_stats.expired;
+    }
+    for (const auto& naive_proxy : naive_proxies_) {
+      const NaiveProxy::AcceptStats& accept_stats =
+          naive_proxy->accept_stats();
+      VLOG(1) << "Accept: accepted=" << accept_stats.accepted
+              << " budget_exhausted=" << accept_stats.budget_exhausted
+              << " max_batch=" << accept_stats.max_batch << "/"
+              << kListenBackLog
+              << " connection_limit_waits="
+              << accept_stats.connection_limit_waits
+              << " resource_waits=" << accept_stats.resource_waits
+              << " fd_waits=" << accept_stats.fd_waits
+              << " client_limit_refusals="
+              << accept_stats.client_limit_refusals
+              << " cross_cpu=" << accept_stats.cross_cpu << "/"
+              << accept_stats.cpu_checked;
+    }
+    if (http_cache_) {
+      const NaiveHttpCache::Stats& cache_stats = http_cache_->stats();
+      VLOG(1) << "HTTP cache: requests=" << cache_stats.requests
+              << " hits=" << cache_stats.hits
+              << " saved_bytes=" << cache_stats.saved_bytes;
+    }
+  }
+
+  // Logs the bytes held per open connection of the thread, by component.
+  void LogConnectionMemoryUsage() {
+    NaiveConnection::MemoryUsage usage;
+    size_t connections = 0;
+    for (const auto* proxies : {&naive_proxies_, &draining_proxies_}) {
+      for (const auto& naive_proxy : *proxies) {
+        usage += naive_proxy->GetConnectionMemoryUsage();
+        connections += naive_proxy->num_connections();
+      }
+    }
+    if (connections == 0) {
+      return;
+    }
+    VLOG(1) << "Connection memory: connections=" << connections
+            << " bytes_per_connection=" << usage.total() / connections
+            << " object=" << usage.object / connections
+            << " padding=" << usage.padding / connections
+            << " buffers=" << usage.buffers / connections
+            << " stream=" << usage.stream / connections
+            << " helpers=" << usage.helpers / connections;
+  }
+
+  // Logs the relay counters, and the thread CPU time and allocations per
+  // relayed chunk since the last call. Both include whatever else the thread
+  // did, such as TLS and QUIC, so they are best read under a steady load.
+  void LogRelayStats(
+      const std::optional<NaiveAllocatorStats>& allocator_stats) {
+    const NaiveConnection::RelayStats& relay_stats =
+        NaiveConnection::GetRelayStatsForCurrentThread();
+    VLOG(1) << "Relay: chunks=" << relay_stats.chunks
+            << " pulls_waited=" << relay_stats.pulls_waited
+            << " pushes_waited=" << relay_stats.pushes_waited
+            << " yields=" << relay_stats.yields
+            << " throttles=" << relay_stats.throttles;
+    uint64_t chunks = relay_stats.chunks - last_relay_stats_.chunks;
+    uint64_t allocations =
+        allocator_stats ? allocator_stats->hits + allocator_stats->misses : 0;
+    base::ThreadTicks thread_ticks;
+    if (base::ThreadTicks::IsSupported()) {
+      thread_ticks = base::ThreadTicks::Now();
+    }
+    if (chunks > 0 && !last_thread_ticks_.is_null()) {
+      VLOG(1) << "Relay cost: cpu_ns_per_chunk="
+              << (thread_ticks - last_thread_ticks_).InNanoseconds() / chunks
+              << " allocations_per_chunk="
+              << static_cast<double>(allocations - last_allocations_) /
+                     chunks
+              << " yields_per_chunk="
+              << static_cast<double>(relay_stats.yields -
+                                     last_relay_stats_.yields) /
+                     chunks;
+    }
+    last_relay_stats_ = relay_stats;
+    last_thread_ticks_ = thread_ticks;
+    last_allocations_ = allocations;
+  }
+
+  const int thread_;
+  // Outlives the connections of this thread so their buffers are recycled.
+  NaiveBufferPool buffer_pool_;
+  NaiveScheduler scheduler_;
+  // Outlives the proxies, which release it as their connections close.
+  NaiveConnectionBudget connection_budget_;
+  NaiveClientLimiter client_limiter_;
+  std::unique_ptr<NaiveProxySelector> proxy_selector_;
+  // Selectors replaced by reloads, still used by open connections.
+  std::vector<std::unique_ptr<NaiveProxySelector>> retired_proxy_selectors_;
+  std::unique_ptr<URLRequestContext> cert_context_;
+  // Null without --network-quality. Outlives `context_`, whose requests and
+  // sockets feed it.
+  std::unique_ptr<NetworkQualityEstimator> network_quality_estimator_;
+  // Outlives the sockets of `context_`.
+  NaiveSocketWatcherFactory socket_watcher_factory_;
+  std::unique_ptr<URLRequestContext> context_;
+  // Null without --quic-mtu-discovery.
+  std::unique_ptr<NaiveMtuStore> mtu_store_;
+  std::unique_ptr<NaiveNetworkChangeDebouncer> network_change_debouncer_;
+  // Destroyed before `context_` as its upstream queries use it.
+  std::unique_ptr<RedirectResolver> resolver_;
+  // Outlives the proxies. Null on other than the main worker, or if the
+  // HTTP cache is off.
+  std::unique_ptr<NaiveHttpCache> http_cache_;
+  // Outlives the proxies, and flushes their last lines when destroyed.
+  std::unique_ptr<NaiveAccessLog::Buffer> access_log_buffer_;
+  std::vector<std::unique_ptr<NaiveProxy>> naive_proxies_;
+  // Configs and metrics labels of `naive_proxies_`.
+  std::vector<NaiveListenConfig> listen_configs_;
+  std::vector<std::string> listen_names_;
+  // Listeners removed by reloads, until their connections are closed.
+  std::vector<std::unique_ptr<NaiveProxy>> draining_proxies_;
+  base::RepeatingTimer drain_timer_;
+  std::unique_ptr<NaiveSessionWarmer> session_warmer_;
+  std::unique_ptr<NaiveStandbyPool> standby_pool_;
+  std::unique_ptr<NaiveSparePool> spare_pool_;
+  std::unique_ptr<NaiveProxyRacer> proxy_racer_;
+  std::unique_ptr<NaiveQualityAdapter> quality_adapter_;
+  std::unique_ptr<NaiveHealthChecker> health_checker_;
+  base::RepeatingTimer stats_timer_;
+  // Counters at the last LogRelayStats().
+  NaiveConnection::RelayStats last_relay_stats_;
+  base::ThreadTicks last_thread_ticks_;
+  uint64_t last_allocations_ = 0;
+  base::RepeatingTimer load_timer_;
+  base::RepeatingTimer stream_buffer_timer_;
+  std::unique_ptr<base::MemoryPressureListener> memory_pressure_listener_;
+  base::OneShotTimer memory_critical_timer_;
+  // Bytes relayed by the listeners at the last ReportLoad().
+  uint64_t last_relayed_bytes_ = 0;
+  // The reloadable options are updated by Reload().
+  NaiveConfig config_;
+  // Destroyed first, as its tunnels use the session and the selector.
+  std::unique_ptr<NaiveBench> bench_;
+};
+
+// Merges the metrics of the main worker with those of the other workers,
+// which reply on this thread.
+void CollectMetrics(NaiveWorker* main_worker,
+                    std::vector<base::SequenceBound<NaiveWorker>>* workers,
+                    const NaiveStallCounter* stall_counter,
+                    base::OnceCallback<void(NaiveMetrics)> callback) {
+  NaiveMetrics metrics = main_worker->CollectMetrics();
+  stall_counter->GetCounts(&metrics);
+  const DnsUdpSocketPool::Stats dns_udp_stats = DnsUdpSocketPool::GetStats();
+  metrics.dns_udp_queries = dns_udp_stats.queries;
+  metrics.dns_udp_sockets = dns_udp_stats.sockets;
+  auto barrier = base::BarrierCallback<NaiveMetrics>(
+      workers->size(),
+      base::BindOnce(
+          [](NaiveMetrics metrics,
+             base::OnceCallback<void(NaiveMetrics)> callback,
+             std::vector<NaiveMetrics> worker_metrics) {
+            for (const NaiveMetrics& other : worker_metrics) {
+              metrics.Merge(other);
+            }
+            std::move(callback).Run(std::move(metrics));
+          },
+          std::move(metrics), std::move(callback)));
+  for (base::SequenceBound<NaiveWorker>& worker : *workers) {
+    worker.AsyncCall(&NaiveWorker::CollectMetrics).Then(barrier);
+  }
+}
+
+// Splits the tunnels of the benchmark over the workers, waits for them to
+// finish, and prints the merged result.
+int RunBench(const NaiveConfig& config,
+             NaiveWorker* main_worker,
+             std::vector<base::SequenceBound<NaiveWorker>>* workers,
+             NetLog* net_log) {
+  NaiveStallCounter stall_counter;
+  stall_counter.StartObserving(net_log);
+
+  LOG(INFO) << "Benchmarking " << config.bench_connections << " tunnels to "
+            << config.bench.ToString() << " for "
+            << config.bench_duration.InSeconds() << " seconds";
+  NaiveBench::Result result;
+  base::RunLoop run_loop;
+  int num_workers = workers->size() + 1;
+  auto barrier = base::BarrierCallback<NaiveBench::Result>(
+      num_workers,
+      base::BindOnce(
+          [](NaiveBench::Result* result, base::OnceClosure quit_closure,
+             std::vector<NaiveBench::Result> worker_results) {
+            for (const NaiveBench::Result& other : worker_results) {
+              result->Merge(other);
+            }
+            std::move(quit_closure).Run();
+          },
+          &result, run_loop.QuitClosure()));
+  for (int i = 0; i < num_workers; ++i) {
+    NaiveBench::Params params = {
+        .target = config.bench,
+        .connections = config.bench_connections / num_workers +
+                       (i < config.bench_connections % num_workers ? 1 : 0),
+        .duration = config.bench_duration,
+        .upload = config.bench_upload,
+    };
+    if (i == 0) {
+      main_worker->RunBench(params, barrier);
+    } else {
+      (*workers)[i - 1]
+          .AsyncCall(&NaiveWorker::RunBench)
+          .WithArgs(params, base::BindPostTaskToCurrentDefault(barrier));
+    }
+  }
+  run_loop.Run();
+
+  NaiveMetrics stalls;
+  stall_counter.GetCounts(&stalls);
+  result.http2_stalls = stalls.http2_stalls;
+  result.quic_blocked_frames = stalls.quic_blocked_frames;
+  result.socket_pool_stalls = stalls.socket_pool_stalls;
+  std::cout << result.ToString() << std::flush;
+  return result.tunnels.accepted > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#if BUILDFLAG(IS_LINUX)
+// Opens the TCP socket of a tproxy listener. Returns null on failure.
+std::unique_ptr<TCPServerSocket> ListenTproxy(
+    const NaiveListenConfig& listen_config,
+    NetLog* net_log) {
+  std::optional<IPAddress> address =
+      IPAddress::FromIPLiteral(listen_config.addr);
+  if (!address) {
+    LOG(ERROR) << "Tproxy listener needs an IP address: "
+               << listen_config.addr;
+    return nullptr;
+  }
+  IPEndPoint endpoint(*address, listen_config.port);
+  base::ScopedFD fd = CreateTransparentSocket(endpoint, SOCK_STREAM);
+  if (!fd.is_valid()) {
+    LOG(ERROR) << "Failed to listen on tproxy://" << listen_config.addr << ":"
+               << listen_config.port;
+    return nullptr;
+  }
+  auto listen_socket =
+      std::make_unique<TCPServerSocket>(net_log, NetLogSource());
+  int result = listen_socket->AdoptSocket(fd.release());
+  if (result == OK) {
+    result = listen_socket->Listen(endpoint, kListenBackLog, std::nullopt);
+  }
+  if (result != OK) {
+    LOG(ERROR) << "Failed to listen on tproxy://" << listen_config.addr << ":"
+               << listen_config.port << ": " << ErrorToShortString(result);
+    return nullptr;
+  }
+  return listen_socket;
+}
+#endif
+
+// Whether a listener sets up the redirect resolver.
+bool HasRedirListener(const NaiveConfig& config) {
+  return std::ranges::any_of(
+      config.listen, [](const NaiveListenConfig& listen_config) {
+        return listen_config.protocol == ClientProtocol::kRedir ||
+               listen_config.protocol == ClientProtocol::kTun;
+      });
+}
+
+// Opens the UDP socket of a quic listener, taking it from `inherited_sockets`
+// first if not null. Returns null on failure.
+std::unique_ptr<UDPServerSocket> OpenQuicListenSocket(
+    const NaiveConfig& config,
+    const NaiveListenConfig& listen_config,
+    NaiveInheritedSockets* inherited_sockets,
+    NetLog* net_log) {
+  IPAddress listen_addr;
+  if (!listen_addr.AssignFromIPLiteral(listen_config.addr)) {
+    LOG(ERROR) << "Failed to listen on quic://" << listen_config.addr;
+    return nullptr;
+  }
+  IPEndPoint address(listen_addr, listen_config.port);
+  std::unique_ptr<UDPServerSocket> socket;
+#if BUILDFLAG(IS_POSIX)
+  if (inherited_sockets) {
+    socket = inherited_sockets->TakeUdp(address, net_log);
+  }
+#endif
+  if (!socket) {
+    socket = std::make_unique<UDPServerSocket>(net_log, NetLogSource());
+    socket->AllowAddressReuse();
+    int result = socket->Listen(address);
+    if (result != OK) {
+      LOG(ERROR) << "Failed to listen on quic://" << listen_config.addr << " "
+                 << listen_config.port << ": " << ErrorToShortString(result);
+      return nullptr;
+    }
+  }
+  if (config.quic_receive_buffer > 0) {
+    int result = socket->SetReceiveBufferSize(config.quic_receive_buffer);
+    if (result != OK) {
+      LOG(WARNING) << "No receive buffer size on quic://" << listen_config.addr
+                   << " " << listen_config.port << ": "
+                   << ErrorToShortString(result);
+    }
+  }
+  return socket;
+}
+
+// Opens a listen socket for each IO thread that serves `listen_config`,
+// taking them from `inherited_sockets` first if not null.
+bool OpenListenSockets(
+    const NaiveConfig& config,
+    const NaiveListenConfig& listen_config,
+    NaiveInheritedSockets* inherited_sockets,
+    NetLog* net_log,
+    std::vector<std::vector<NaiveListenSocket>>* listen_sockets_by_thread) {
+  // The connections of a quic listener are all served by the thread reading
+  // its socket.
+  if (listen_config.protocol == ClientProtocol::kQuic) {
+    std::unique_ptr<UDPServerSocket> socket = OpenQuicListenSocket(
+        config, listen_config, inherited_sockets, net_log);
+    if (!socket) {
+      return false;
+    }
+    (*listen_sockets_by_thread)[0].push_back(
+        {listen_config, nullptr, std::move(socket)});
+    LOG(INFO) << "Listening on quic://" << listen_config.addr << ":"
+              << listen_config.port;
+    return true;
+  }
+
+  // A TUN device has one queue, read by the thread of the redirect resolver.
+  if (listen_config.protocol == ClientProtocol::kTun) {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_ANDROID)
+    base::ScopedFD fd(listen_config.tun_fd);
+    if (!fd.is_valid()) {
+      fd = NaiveTunServerSocket::OpenDevice(listen_config.addr);
+    }
+    if (!fd.is_valid()) {
+      LOG(ERROR) << "Failed to listen on tun://" << listen_config.addr;
+      return false;
+    }
+    NaiveListenSocket listen_socket{listen_config};
+    listen_socket.tun_socket =
+        std::make_unique<NaiveTunServerSocket>(std::move(fd));
+    (*listen_sockets_by_thread)[0].push_back(std::move(listen_socket));
+    LOG(INFO) << "Listening on tun://" << listen_config.addr;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // A socket file cannot be bound by a socket per thread.
+  if (listen_config.unix_socket) {
+#if BUILDFLAG(IS_POSIX)
+    auto unix_socket = std::make_unique<NaiveUnixServerSocket>(net_log);
+    int result = unix_socket->ListenWithPath(listen_config.addr,
+                                             kListenBackLog);
+    if (result != OK) {
+      LOG(ERROR) << "Failed to listen on " << GetListenName(listen_config)
+                 << ": " << ErrorToShortString(result);
+      return false;
+    }
+    NaiveListenSocket listen_socket{listen_config};
+    listen_socket.unix_socket = std::move(unix_socket);
+    (*listen_sockets_by_thread)[0].push_back(std::move(listen_socket));
+    LOG(INFO) << "Listening on " << GetListenName(listen_config);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // The redirect resolver keeps its fake address mapping on the main thread,
+  // so redir and tproxy listeners, and the others that use it, are not
+  // sharded. So is the HTTP cache, and the http listeners it serves.
+  int num_threads =
+      listen_config.protocol == ClientProtocol::kRedir ||
+              listen_config.protocol == ClientProtocol::kTproxy ||
+              (HasRedirListener(config) && config.resolver_all_listeners) ||
+              (listen_config.protocol == ClientProtocol::kHttp &&
+               !config.http_cache.empty())
+          ? 1
+          : config.threads;
+  scoped_refptr<NaiveAcceptBalancer> balancer;
+  if (config.thread_loads && num_threads > 1) {
+    balancer = base::MakeRefCounted<NaiveAcceptBalancer>(config.thread_loads);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    // The other threads of a balanced listener are handed the connections
+    // accepted on the socket of thread 0.
+    if (balancer && i > 0) {
+      NaiveListenSocket entry{listen_config};
+      entry.balancer = balancer;
+      (*listen_sockets_by_thread)[i].push_back(std::move(entry));
+      continue;
+    }
+    std::unique_ptr<TCPServerSocket> listen_socket;
+#if BUILDFLAG(IS_POSIX)
+    IPAddress listen_addr;
+    if (inherited_sockets &&
+        listen_addr.AssignFromIPLiteral(listen_config.addr)) {
+      listen_socket = inherited_sockets->TakeTcp(
+          IPEndPoint(listen_addr, listen_config.port), net_log);
+    }
+#endif
+#if BUILDFLAG(IS_LINUX)
+    if (!listen_socket && listen_config.protocol == ClientProtocol::kTproxy) {
+      listen_socket = ListenTproxy(listen_config, net_log);
+      if (!listen_socket) {
+        return false;
+      }
+    }
+#endif
+    if (!listen_socket) {
+      listen_socket =
+          std::make_unique<TCPServerSocket>(net_log, NetLogSource());
+
+      // SO_REUSEPORT is set by default on the listen socket so every thread
+      // can bind its own socket to the same address.
+      int result = listen_socket->ListenWithAddressAndPort(
+          listen_config.addr, listen_config.port, kListenBackLog);
+      if (result != OK) {
+        LOG(ERROR) << "Failed to listen on "
+                   << ToString(listen_config.protocol) << "://"
+                   << listen_config.addr << " " << listen_config.port << ": "
+                   << ErrorToShortString(result);
+        return false;
+      }
+    }
+    if (config.tcp_fast_open) {
+      int result = listen_socket->SetFastOpen(kTcpFastOpenQueueLength);
+      if (result != OK) {
+        LOG(WARNING) << "No TCP Fast Open on " << listen_config.addr << " "
+                     << listen_config.port << ": "
+                     << ErrorToShortString(result);
+      }
+    }
+    if (i > 0) {
+      listen_socket->DetachFromThread();
+    }
+    NaiveListenSocket entry{listen_config, std::move(listen_socket), balancer};
+#if BUILDFLAG(IS_LINUX)
+    if (listen_config.protocol == ClientProtocol::kTproxy) {
+      entry.tproxy_udp_fd = NaiveTproxyUdpServer::OpenSocket(
+          IPEndPoint(*IPAddress::FromIPLiteral(listen_config.addr),
+                     listen_config.port));
+      if (!entry.tproxy_udp_fd.is_valid()) {
+        LOG(ERROR) << "Failed to listen on tproxy://" << listen_config.addr
+                   << ":" << listen_config.port << " for UDP";
+        return false;
+      }
+    }
+#endif
+    (*listen_sockets_by_thread)[i].push_back(std::move(entry));
+  }
+  // The program applies to the whole SO_REUSEPORT group, whose sockets are
+  // indexed by thread as they joined it in order. Connections it steers past
+  // the group, as when another instance shares it, fall back to hashing.
+  if (config.cpu_affinity && !balancer && num_threads > 1) {
+    int result =
+        (*listen_sockets_by_thread)[0].back().socket->SetReusePortCpuSteering(
+            num_threads);
+    if (result != OK) {
+      LOG(WARNING) << "No CPU steering on " << listen_config.addr << " "
+                   << listen_config.port << ": " << ErrorToShortString(result);
+    }
+  }
+  LOG(INFO) << "Listening on " << ToString(listen_config.protocol) << "://"
+            << listen_config.addr << ":" << listen_config.port;
+  return true;
+}
+
+#if BUILDFLAG(IS_POSIX)
+// Keeps duplicates of the listen sockets for the next instance.
+void AddHandoffSockets(
+    const std::vector<std::vector<NaiveListenSocket>>& listen_sockets_by_thread,
+    NaiveHandoffServer* handoff_server) {
+  for (const auto& listen_sockets : listen_sockets_by_thread) {
+    for (const NaiveListenSocket& listen_socket : listen_sockets) {
+      // The TUN device is not handed off, as its connections are
+      // terminated in this process.
+      if (listen_socket.socket) {
+        handoff_server->AddSocket(listen_socket.socket->GetSocketDescriptor());
+      } else if (listen_socket.udp_socket) {
+        handoff_server->AddSocket(
+            listen_socket.udp_socket->GetSocketDescriptor());
+      }
+    }
+  }
+}
+
+// Reads the configuration again and applies the options that can change
+// without a restart to all workers. Keeps the current configuration if the
+// new one cannot be applied as a whole.
+void ReloadConfig(NaiveConfig* config,
+                  NaiveWorker* main_worker,
+                  std::vector<base::SequenceBound<NaiveWorker>>* workers,
+                  NaiveHandoffServer* handoff_server,
+                  NetLog* net_log) {
+  // The listeners belong to the next instance now.
+  if (handoff_server->handed_off()) {
+    LOG(INFO) << "Not reloading configuration while draining";
+    return;
+  }
+  LOG(INFO) << "Reloading configuration";
+  base::Value::Dict config_dict;
+  NaiveConfig new_config;
+  if (!ReadConfigDict(*base::CommandLine::ForCurrentProcess(),
+                      &config_dict) ||
+      !new_config.Parse(config_dict)) {
+    LOG(ERROR) << "Failed to reload configuration";
+    return;
+  }
+  // The QUIC session pools only know the QUIC proxies given at startup.
+  if (!std::includes(config->origins_to_force_quic_on.begin(),
+                     config->origins_to_force_quic_on.end(),
+                     new_config.origins_to_force_quic_on.begin(),
+                     new_config.origins_to_force_quic_on.end())) {
+    LOG(ERROR) << "Failed to reload configuration: new QUIC proxies need a "
+                  "restart";
+    return;
+  }
+
+  std::vector<NaiveListenConfig> added;
+  for (const NaiveListenConfig& listen_config : new_config.listen) {
+    if (std::ranges::any_of(config->listen,
+                            [&](const NaiveListenConfig& old) {
+                              return old.IsSameListener(listen_config);
+                            })) {
+      continue;
+    }
+    // The redirect resolver is only set up at startup.
+    if (listen_config.protocol == ClientProtocol::kRedir ||
+        listen_config.protocol == ClientProtocol::kTun) {
+      LOG(ERROR) << "Failed to reload configuration: new "
+                 << ToString(listen_config.protocol)
+                 << " listeners need a restart";
+      return;
+    }
+    added.push_back(listen_config);
+  }
+  std::vector<std::vector<NaiveListenSocket>> added_sockets_by_thread(
+      config->threads);
+  for (const NaiveListenConfig& listen_config : added) {
+    if (!OpenListenSockets(*config, listen_config, nullptr, net_log,
+                           &added_sockets_by_thread)) {
+      LOG(ERROR) << "Failed to reload configuration";
+      return;
+    }
+  }
+
+  if (!config->handoff.empty()) {
+    AddHandoffSockets(added_sockets_by_thread, handoff_server);
+    for (const NaiveListenConfig& listen_config : config->listen) {
+      IPAddress listen_addr;
+      if (std::ranges::none_of(new_config.listen,
+                               [&](const NaiveListenConfig& kept) {
+                                 return kept.IsSameListener(listen_config);
+                               }) &&
+          listen_addr.AssignFromIPLiteral(listen_config.addr)) {
+        handoff_server->RemoveSockets(
+            listen_config.protocol == ClientProtocol::kQuic ? SOCK_DGRAM
+                                                            : SOCK_STREAM,
+            IPEndPoint(listen_addr, listen_config.port));
+      }
+    }
+  }
+
+  config->ApplyReloadable(new_config);
+  main_worker->Reload(*config, std::move(added_sockets_by_thread[0]));
+  for (size_t i = 0; i < workers->size(); ++i) {
+    (*workers)[i]
+        .AsyncCall(&NaiveWorker::Reload)
+        .WithArgs(*config, std::move(added_sockets_by_thread[i + 1]));
+  }
+  LOG(INFO) << "Reloaded configuration";
+}
+
+// Runs `quit_closure` once no thread has open connections.
+void QuitIfDrained(NaiveWorker* main_worker,
+                   std::vector<base::SequenceBound<NaiveWorker>>* workers,
+                   base::RepeatingClosure quit_closure) {
+  auto barrier = base::BarrierCallback<bool>(
+      workers->size() + 1,
+      base::BindOnce(
+          [](base::RepeatingClosure quit_closure,
+             std::vector<bool> has_connections) {
+            if (std::ranges::none_of(has_connections, std::identity())) {
+              LOG(INFO) << "All connections closed";
+              quit_closure.Run();
+            }
+          },
+          std::move(quit_closure)));
+  for (auto& worker : *workers) {
+    worker.AsyncCall(&NaiveWorker::HasConnections).Then(barrier);
+  }
+  barrier.Run(main_worker->HasConnections());
+}
+
+// Stops listening on all threads once the next instance has taken over the
+// listen sockets, and quits once the open connections are closed.
+void DrainAfterHandoff(NaiveWorker* main_worker,
+                       std::vector<base::SequenceBound<NaiveWorker>>* workers,
+                       base::RepeatingTimer* drain_timer,
+                       base::RepeatingClosure quit_closure) {
+  LOG(INFO) << "Stopped listening, exiting once connections are closed";
+  main_worker->StopListening();
+  for (auto& worker : *workers) {
+    worker.AsyncCall(&NaiveWorker::StopListening);
+  }
+  drain_timer->Start(
+      FROM_HERE, base::Seconds(kDrainCheckIntervalSeconds),
+      base::BindRepeating(&QuitIfDrained, main_worker, workers,
+                          std::move(quit_closure)));
+}
+#endif  // BUILDFLAG(IS_POSIX)
 }  // namespace
 }  // namespace net
 
@@ -260,6 +1926,9 @@ int main(int argc, char* argv[]) {
   allocator_shim::InitializeAllocatorShim();
 #endif
 
+  // Times the startup phases, logged with verbose logging.
+  base::ElapsedTimer startup_timer;
+
   // content/app/content_main.cc: RunContentProcess()
   base::EnableTerminationOnOutOfMemory();
 
@@ -288,14 +1957,20 @@ int main(int argc, char* argv[]) {
 
   // content/app/content_main.cc: RunContentProcess()
   //   content/app/content_main_runner_impl.cc: Run()
-  base::FeatureList::InitInstance("PartitionConnectionsByNetworkIsolationKey",
-                                  std::string());
+  // The config is not parsed yet. UseServiceEndpointRequest only lets the
+  // built-in DNS client give the answers of its queries as they come, which
+  // is used with --connect-while-resolving.
+  base::FeatureList::InitInstance(
+      "PartitionConnectionsByNetworkIsolationKey,UseServiceEndpointRequest",
+      std::string());
 
   base::allocator::PartitionAllocSupport::Get()
       ->ReconfigureAfterFeatureListInit(/*process_type=*/"");
 
   base::SingleThreadTaskExecutor io_task_executor(base::MessagePumpType::IO);
-  base::ThreadPoolInstance::CreateAndStartWithDefaultParams("naive");
+  // Started once the config gives the number of workers. Tasks posted before
+  // wait for it.
+  base::ThreadPoolInstance::Create("naive");
 
   base::allocator::PartitionAllocSupport::Get()->ReconfigureAfterTaskRunnerInit(
       process_type);
@@ -305,41 +1980,12 @@ int main(int argc, char* argv[]) {
   url::AddStandardScheme("socks",
                          url::SCHEME_WITH_HOST_PORT_AND_USER_INFORMATION);
   url::AddStandardScheme("redir", url::SCHEME_WITH_HOST_AND_PORT);
-  net::ClientSocketPoolManager::set_max_sockets_per_pool(
-      net::HttpNetworkSession::NORMAL_SOCKET_POOL,
-      kDefaultMaxSocketsPerPool * kExpectedMaxUsers);
-  net::ClientSocketPoolManager::set_max_sockets_per_proxy_chain(
-      net::HttpNetworkSession::NORMAL_SOCKET_POOL,
-      kDefaultMaxSocketsPerPool * kExpectedMaxUsers);
-  net::ClientSocketPoolManager::set_max_sockets_per_group(
-      net::HttpNetworkSession::NORMAL_SOCKET_POOL,
-      kDefaultMaxSocketsPerGroup * kExpectedMaxUsers);
+  url::AddStandardScheme("tproxy", url::SCHEME_WITH_HOST_AND_PORT);
 
   const auto& proc = *base::CommandLine::ForCurrentProcess();
-  const auto& args = proc.GetArgs();
   base::Value::Dict config_dict;
-  if (args.empty() && proc.argv().size() >= 2) {
-    config_dict = GetSwitchesAsValue(proc);
-  } else {
-    base::FilePath config_file;
-    if (!args.empty()) {
-      config_file = base::FilePath(args[0]);
-    } else {
-      config_file = base::FilePath::FromUTF8Unsafe("config.json");
-    }
-    JSONFileValueDeserializer reader(config_file);
-    int error_code;
-    std::string error_message;
-    std::unique_ptr<base::Value> value =
-        reader.Deserialize(&error_code, &error_message);
-    if (value == nullptr) {
-      std::cerr << "Error reading " << config_file << ": (" << error_code
-                << ") " << error_message << std::endl;
-      return EXIT_FAILURE;
-    }
-    if (const base::Value::Dict* dict = value->GetIfDict()) {
-      config_dict = dict->Clone();
-    }
+  if (!ReadConfigDict(proc, &config_dict)) {
+    return EXIT_FAILURE;
   }
 
   if (config_dict.contains("h") || config_dict.contains("help")) {
@@ -351,16 +1997,118 @@ int main(int argc, char* argv[]) {
                  "--listen=<proto>://[addr][:port] [--listen=...]\n"
                  "                           proto: socks, http\n"
                  "                                  redir (Linux only)\n"
+                 "                                  tproxy (Linux only)\n"
+                 "                                  tun (?fd=..)\n"
+                 "                                  https (?cert=..&key=..)\n"
+                 "                                  quic (?cert=..&key=..)\n"
                  "--proxy=<proto>://[<user>:<pass>@]<hostname>[:<port>]\n"
                  "                           proto: https, quic\n"
+                 "                           [--proxy=...] Spread over chains\n"
+                 "--proxy-selection=<policy> weighted, least-conn,\n"
+                 "                           lowest-latency\n"
+                 "--connect-race=<N>         Race N proxy addresses\n"
                  "--insecure-concurrency=<N> Use N connections, insecure\n"
+                 "--adaptive-concurrency     Open the N only as needed\n"
+                 "--profile=embedded         Defaults for small routers\n"
+                 "--threads=<N>              Use N IO threads\n"
+                 "--balance-accept           Balance accepts by thread load\n"
+                 "--cpu-affinity             Pin threads, steer accepts\n"
+                 "--thread-pool-workers=<N>  Use N blocking work threads\n"
+                 "--allocator-profile=<default|throughput|low-memory>\n"
+                 "                           Tune allocator thread caches\n"
+                 "--buffer-pool-size=<N>     Cache N relay buffers per thread\n"
+                 "--relay-buffer=<N>         Grow relay buffers up to N bytes\n"
+                 "--huge-page-buffers        Relay buffers in huge pages\n"
+                 "--accept-budget=<N>        Accept N connections per wakeup\n"
+                 "--max-connections=<N>      Pause accepting at N connections\n"
+                 "--client-rate=<N>          New connections/s per client\n"
+                 "--client-burst=<N>         Burst of new connections\n"
+                 "--client-max-connections=<N>\n"
+                 "                           Open connections per client\n"
+                 "--max-sockets-per-pool=<N> Socket pool limit\n"
+                 "--max-sockets-per-group=<N>\n"
+                 "                           Socket pool limit per host\n"
+                 "--scheduler-quantum=<N>    Relay N bytes per round\n"
+                 "--scheduler-slice=<ms>     Resume tunnels for ms per task\n"
+                 "--idle-timeout=<seconds>   Close idle tunnels\n"
+                 "--read-idle-timeout=<seconds>\n"
+                 "                           Close tunnels idle from client\n"
+                 "--write-idle-timeout=<seconds>\n"
+                 "                           Close tunnels idle to client\n"
+                 "--half-open-timeout=<seconds>\n"
+                 "                           Close idle half-open tunnels\n"
+                 "--busy-poll=<usec>         Poll before sleeping, on Linux\n"
+                 "--low-power                Coalesce wake-ups\n"
+                 "--http2-session-window=<N> HTTP/2 session receive window\n"
+                 "--http2-stream-window=<N>  HTTP/2 stream receive window\n"
+                 "--http2-auto-window=<N>    Grow receive windows up to N\n"
+                 "--http2-read-buffer=<N>    Grow session reads up to N\n"
+                 "--http2-window-update-delay=<ms>\n"
+                 "                           Batch window updates for ms\n"
+                 "--quic-congestion-control=<cc>\n"
+                 "                           bbr, bbr2, cubic, reno\n"
+                 "--quic-initial-window=<N>  N packets: 3, 10, 20, 50\n"
+                 "--quic-max-packet-size=<N> QUIC packets up to N bytes\n"
+                 "--quic-max-pacing-rate=<Mbps>\n"
+                 "                           Pace QUIC sending below Mbps\n"
+                 "--quic-session-window=<N>  QUIC session receive window\n"
+                 "--quic-stream-window=<N>   QUIC stream receive window\n"
+                 "--quic-receive-buffer=<N>  QUIC socket receive buffer\n"
+                 "--quic-max-receive-buffer=<N>\n"
+                 "                           Grow it up to N on drops\n"
+                 "--quic-session-file=<path> Save QUIC tickets for 0-RTT\n"
+                 "--no-quic-migration        No QUIC session migration\n"
+                 "--tls-session-file=<path>  Save TLS sessions to resume\n"
+                 "--tls-early-data           CONNECT in TLS 0-RTT data\n"
+                 "--kernel-tls               Kernel encrypts TLS records\n"
+                 "--socks-pipelining         Pipeline SOCKS5 CONNECT\n"
+                 "--tcp-fast-open            Data in SYN, out and in\n"
+                 "--mptcp                    Multipath TCP out, Linux\n"
+                 "--uplinks=<if|addr>[,...]  Stripe sessions over links\n"
+                 "--cert-verify-file=<path>  Save cert verifications\n"
+                 "--host-cache-file=<path>   Save resolved hosts\n"
+                 "--priority-rules=<port>[-<port>]:<class>[,...]\n"
+                 "                           interactive, default, bulk\n"
+                 "--priority-rates=<class>:<bytes>[,...]\n"
+                 "                           Cap bytes/s of each class\n"
+                 "--priority-dscp=<class>:<dscp>[,...]\n"
+                 "                           Sessions per class, marked\n"
+                 "--padding-profile=<min>[-<max>][,...]\n"
+                 "                           Padding sizes of padded frames\n"
+                 "--compression=zstd         Compress tunnels if offered\n"
+                 "--optimistic-connect       Send data with every CONNECT\n"
+                 "--preconnect               Connect tunnel sessions early\n"
+                 "--http1-standby=<N>        Ready HTTP/1.1 connections\n"
+                 "--spare-connections=<N>    Ready connections to popular\n"
+                 "                           destinations\n"
+                 "--connect-while-resolving  Connect on the first DNS answer\n"
+                 "--http-cache=<dir>         Cache GETs of http listeners\n"
+                 "--http-cache-size=<MiB>    Size of the HTTP cache\n"
+                 "--http-cache-hosts=<host>[,...]\n"
+                 "                           Only cache GETs to these hosts\n"
                  "--extra-headers=...        Extra headers split by CRLF\n"
                  "--host-resolver-rules=...  Resolver rules\n"
+                 "--doh-server=<url>         Resolve destinations with DoH\n"
                  "--resolver-range=...       Redirect resolver range\n"
+                 "--resolver-file=<path>     Save redirect resolver mappings\n"
+                 "--resolver-upstream=<url>  Forward other DNS queries to DoH\n"
+                 "--resolver-all-listeners   Socks and http use resolver too\n"
                  "--log[=<path>]             Log to stderr, or file\n"
                  "--log-net-log=<path>       Save NetLog\n"
+                 "--log-net-log-sample=<N>   Save 1 in N NetLog sources\n"
+                 "--metrics=<addr>:<port>    Serve Prometheus metrics\n"
+                 "--access-log=<path>        Log connections as JSON lines\n"
+                 "--access-log-sample=<N>    Log 1 in N connections\n"
+                 "--trace-file=<path>        Save a trace of the relay path\n"
+                 "--trace-duration=<sec>     Trace for this long\n"
+                 "--handoff=<path>           Pass listeners on upgrades\n"
+                 "--bench=<host>:<port>      Benchmark the proxy to a sink\n"
+                 "--bench-connections=<N>    Benchmark tunnels\n"
+                 "--bench-duration=<sec>     Benchmark for this long\n"
+                 "--bench-upload             Push to the sink instead\n"
                  "--ssl-key-log-file=<path>  Save SSL keys for Wireshark\n"
                  "--no-post-quantum          No post-quantum key agreement\n"
+                 "--adaptive-post-quantum    Offer it only where not slower\n"
               << std::endl;
     exit(EXIT_SUCCESS);
   }
@@ -375,22 +2123,208 @@ int main(int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
   CHECK(logging::InitLogging(config.log));
+  LogTunnelMemoryBound(config);
+  logging::SetMinLogLevel(config.min_log_level);
+  net::ApplyAllocatorProfile(config.allocator_profile);
+
+  if (config.thread_pool_workers > 0) {
+    base::ThreadPoolInstance::Get()->Start(
+        base::ThreadPoolInstance::InitParams(config.thread_pool_workers));
+  } else {
+    base::ThreadPoolInstance::Get()->StartWithDefaultParams();
+  }
+
+  // The limits are checked against each other as they are set, so the
+  // per-group one is lowered first.
+  net::ClientSocketPoolManager::set_max_sockets_per_group(
+      net::HttpNetworkSession::NORMAL_SOCKET_POOL, 1);
+  net::ClientSocketPoolManager::set_max_sockets_per_pool(
+      net::HttpNetworkSession::NORMAL_SOCKET_POOL,
+      config.max_sockets_per_pool);
+  net::ClientSocketPoolManager::set_max_sockets_per_proxy_chain(
+      net::HttpNetworkSession::NORMAL_SOCKET_POOL,
+      config.max_sockets_per_pool);
+  net::ClientSocketPoolManager::set_max_sockets_per_group(
+      net::HttpNetworkSession::NORMAL_SOCKET_POOL,
+      config.max_sockets_per_group);
+
+  // Binds the listen sockets first, so connections wait in their backlogs
+  // rather than being refused while the rest starts up.
+  net::NetLog* net_log = net::NetLog::Get();
+  net::NaiveInheritedSockets* inherited = nullptr;
+#if BUILDFLAG(IS_POSIX)
+  // Raised before any socket is opened. The usual soft limit of 1024 runs
+  // out at a few hundred tunnels.
+  size_t fd_limit = net::NaiveFdBudget::RaiseLimit();
+  LOG(INFO) << "File descriptor limit: " << fd_limit;
+  config.fd_budget = base::MakeRefCounted<net::NaiveFdBudget>(fd_limit);
+  // Takes the listen sockets passed by systemd or handed over by the running
+  // instance before binding any.
+  auto inherited_sockets = std::make_unique<net::NaiveInheritedSockets>();
+  inherited_sockets->TakeSystemdSockets();
+  // A benchmark would not serve what it took over.
+  if (!config.handoff.empty() && config.bench.IsEmpty()) {
+    inherited_sockets->ReceiveHandoff(config.handoff);
+  }
+  inherited = inherited_sockets.get();
+  net::NaiveHandoffServer handoff_server;
+#endif
+  if (config.balance_accept && config.threads > 1) {
+    config.thread_loads =
+        base::MakeRefCounted<net::NaiveThreadLoads>(config.threads);
+  }
+  if (!config.uplinks.empty()) {
+    config.uplink_set = net::NaiveUplinks::Create(config.uplinks);
+    if (!config.uplink_set) {
+      return EXIT_FAILURE;
+    }
+  }
+  std::vector<std::vector<net::NaiveListenSocket>> listen_sockets_by_thread(
+      config.threads);
+  std::unique_ptr<net::RedirectResolver> resolver;
+  for (const net::NaiveListenConfig& listen_config : config.listen) {
+    if (listen_config.protocol == net::ClientProtocol::kHttps &&
+        !net::CreateHttp2ProxySSLServerContext(listen_config.cert_pem,
+                                               listen_config.key_pem)) {
+      LOG(ERROR) << "Invalid certificate or key for https://"
+                 << listen_config.addr << ":" << listen_config.port;
+      return EXIT_FAILURE;
+    }
+    if (listen_config.protocol == net::ClientProtocol::kQuic &&
+        !net::CreateHttp3ProxyProofSource(listen_config.cert_pem,
+                                          listen_config.key_pem)) {
+      LOG(ERROR) << "Invalid certificate or key for quic://"
+                 << listen_config.addr << ":" << listen_config.port;
+      return EXIT_FAILURE;
+    }
+    if (!net::OpenListenSockets(config, listen_config, inherited, net_log,
+                                &listen_sockets_by_thread)) {
+      return EXIT_FAILURE;
+    }
+
+    if (resolver == nullptr &&
+        listen_config.protocol == net::ClientProtocol::kRedir) {
+      net::IPAddress listen_addr;
+      if (!listen_addr.AssignFromIPLiteral(listen_config.addr)) {
+        LOG(ERROR) << "Failed to open resolver: " << listen_config.addr;
+        return EXIT_FAILURE;
+      }
+      net::IPEndPoint resolver_addr(listen_addr, listen_config.port);
+
+      std::unique_ptr<net::UDPServerSocket> resolver_socket;
+#if BUILDFLAG(IS_POSIX)
+      resolver_socket = inherited_sockets->TakeUdp(resolver_addr, net_log);
+#endif
+      if (!resolver_socket) {
+        resolver_socket = std::make_unique<net::UDPServerSocket>(
+            net_log, net::NetLogSource());
+        resolver_socket->AllowAddressReuse();
+        int result = resolver_socket->Listen(resolver_addr);
+        if (result != net::OK) {
+          LOG(ERROR) << "Failed to open resolver: "
+                     << net::ErrorToShortString(result);
+          return EXIT_FAILURE;
+        }
+      }
+#if BUILDFLAG(IS_POSIX)
+      if (!config.handoff.empty()) {
+        handoff_server.AddSocket(resolver_socket->GetSocketDescriptor());
+      }
+#endif
+
+      resolver = std::make_unique<net::RedirectResolver>(
+          std::move(resolver_socket), config.resolver_range,
+          config.resolver_prefix, config.resolver_range6,
+          config.resolver_prefix6);
+      if (!config.resolver_file.empty() &&
+          !resolver->OpenMappingFile(config.resolver_file)) {
+        LOG(ERROR) << "Failed to open resolver file: "
+                   << config.resolver_file;
+        return EXIT_FAILURE;
+      }
+    }
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_ANDROID)
+    // Applications behind the TUN device send their DNS queries through it,
+    // unless a redir listener came first.
+    if (resolver == nullptr &&
+        listen_config.protocol == net::ClientProtocol::kTun) {
+      resolver = std::make_unique<net::RedirectResolver>(
+          listen_sockets_by_thread[0].back().tun_socket->CreateDnsSocket(),
+          config.resolver_range, config.resolver_prefix,
+          config.resolver_range6, config.resolver_prefix6);
+      if (!config.resolver_file.empty() &&
+          !resolver->OpenMappingFile(config.resolver_file)) {
+        LOG(ERROR) << "Failed to open resolver file: "
+                   << config.resolver_file;
+        return EXIT_FAILURE;
+      }
+    }
+#endif
+  }
+#if BUILDFLAG(IS_POSIX)
+  // Closes the inherited sockets no listener took.
+  inherited_sockets.reset();
+  if (!config.handoff.empty()) {
+    net::AddHandoffSockets(listen_sockets_by_thread, &handoff_server);
+  }
+  for (const auto& listen_sockets : listen_sockets_by_thread) {
+    config.fd_budget->AddListeners(static_cast<int>(listen_sockets.size()));
+  }
+  config.fd_budget->Sample();
+#endif
+
+  VLOG(1) << "Startup: listening after "
+          << startup_timer.Elapsed().InMilliseconds() << " ms";
 
   if (!config.ssl_key_log_file.empty()) {
     net::SSLClientSocket::SetSSLKeyLogger(
         std::make_unique<net::SSLKeyLoggerImpl>(config.ssl_key_log_file));
   }
 
+  if (config.busy_poll.is_positive()) {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+    base::MessagePumpEpoll::SetBusyPollDuration(config.busy_poll);
+#else
+    LOG(WARNING) << "No busy polling on this platform";
+#endif
+  }
+
+  // Latency-sensitive timers, such as those of QUIC and of the TCP stack of
+  // the TUN device, stay precise.
+  if (config.low_power) {
+    base::MessagePump::OverrideAlignWakeUpsState(true, kLowPowerLeeway);
+  }
+
   // The declaration order for net_log and printing_log_observer is
   // important. The destructor of PrintingLogObserver removes itself
   // from net_log, so net_log must be available for entire lifetime of
   // printing_log_observer.
-  net::NetLog* net_log = net::NetLog::Get();
   std::unique_ptr<net::FileNetLogObserver> observer;
+  std::unique_ptr<net::NaiveBinaryNetLogObserver> binary_observer;
+  std::unique_ptr<net::NaiveNetLogSampler> net_log_sampler;
   if (!config.log_net_log.empty()) {
-    observer = net::FileNetLogObserver::CreateUnbounded(
-        config.log_net_log, net::NetLogCaptureMode::kDefault, GetConstants());
-    observer->StartObserving(net_log);
+    net::NetLog::ThreadSafeObserver* file_observer;
+    if (config.log_net_log_binary) {
+      binary_observer = std::make_unique<net::NaiveBinaryNetLogObserver>(
+          config.log_net_log, *GetConstants());
+      file_observer = binary_observer.get();
+    } else {
+      observer = net::FileNetLogObserver::CreateUnbounded(
+          config.log_net_log, net::NetLogCaptureMode::kDefault,
+          GetConstants());
+      file_observer = observer.get();
+    }
+    if (config.log_net_log_sample > 1) {
+      net_log_sampler = std::make_unique<net::NaiveNetLogSampler>(
+          file_observer, static_cast<uint32_t>(config.log_net_log_sample));
+      net_log_sampler->StartObserving(net_log,
+                                      net::NetLogCaptureMode::kDefault);
+    } else if (binary_observer) {
+      binary_observer->StartObserving(net_log,
+                                      net::NetLogCaptureMode::kDefault);
+    } else {
+      observer->StartObserving(net_log);
+    }
   }
 
   // Avoids net log overhead if verbose logging is disabled.
@@ -398,78 +2332,222 @@ int main(int argc, char* argv[]) {
   if (config.log.logging_dest != logging::LOG_NONE && VLOG_IS_ON(1)) {
     printing_log_observer = std::make_unique<net::PrintingLogObserver>();
     net_log->AddObserver(printing_log_observer.get(),
-                         net::NetLogCaptureMode::kDefault);
+                         net::NetLogCaptureMode::kDefault,
+                         net::PrintingLogObserver::GetEventTypes());
   }
 
-  auto cert_context = net::BuildCertURLRequestContext(net_log);
-  scoped_refptr<net::CertNetFetcherURLRequest> cert_net_fetcher;
-  // The builtin verifier is supported but not enabled by default on Mac,
-  // falling back to CreateSystemVerifyProc() which drops the net fetcher,
-  // causing a DCHECK in ~CertNetFetcherURLRequest().
-  // See CertVerifier::CreateDefaultWithoutCaching() and
-  // CertVerifyProc::CreateSystemVerifyProc() for the build flags.
-#if BUILDFLAG(CHROME_ROOT_STORE_SUPPORTED) || BUILDFLAG(IS_FUCHSIA) || \
-    BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
-  cert_net_fetcher = base::MakeRefCounted<net::CertNetFetcherURLRequest>();
-  cert_net_fetcher->SetURLRequestContext(cert_context.get());
+  // Lets the session warmers and standby pools reconnect after network
+  // changes, the proxy racers race again, and QUIC sessions migrate. The
+  // HTTP/2 session pools also close their sessions of the old network.
+  std::unique_ptr<net::NetworkChangeNotifier> network_change_notifier;
+  if (config.preconnect || config.http1_standby > 0 ||
+      config.spare_connections > 0 ||
+      !config.origins_to_force_quic_on.empty()) {
+    network_change_notifier = net::NetworkChangeNotifier::CreateIfNeeded();
+  }
+
+  // Shared by the workers, so it outlives them. With several threads, the
+  // session stores are kept without a file too, so a session ticket got by
+  // one thread resumes on the others.
+  std::unique_ptr<net::NaiveQuicSessionStore> quic_session_store;
+  if (!config.quic_session_file.empty() || config.threads > 1) {
+    quic_session_store =
+        std::make_unique<net::NaiveQuicSessionStore>(config.quic_session_file);
+    quic_session_store->Load();
+  }
+  std::unique_ptr<net::NaiveSslSessionStore> ssl_session_store;
+  if (!config.tls_session_file.empty() || config.threads > 1) {
+    ssl_session_store =
+        std::make_unique<net::NaiveSslSessionStore>(config.tls_session_file);
+    ssl_session_store->Load();
+  }
+  std::unique_ptr<net::NaiveCertVerifyStore> cert_verify_store;
+  if (!config.cert_verify_file.empty()) {
+    cert_verify_store =
+        std::make_unique<net::NaiveCertVerifyStore>(config.cert_verify_file);
+    cert_verify_store->Load();
+  }
+  std::unique_ptr<net::NaiveHostCacheStore> host_cache_store;
+  if (!config.host_cache_file.empty()) {
+    host_cache_store =
+        std::make_unique<net::NaiveHostCacheStore>(config.host_cache_file);
+    host_cache_store->Load();
+  }
+  std::unique_ptr<net::NaiveSharedHostCache> shared_host_cache;
+  if (config.threads > 1) {
+    shared_host_cache = std::make_unique<net::NaiveSharedHostCache>(
+        net::NaiveStaleHostResolver::kServerHostCacheSize);
+  }
+
+  std::unique_ptr<net::NaiveAccessLog> access_log;
+  if (!config.access_log.empty()) {
+    access_log = net::NaiveAccessLog::Open(config.access_log);
+    if (!access_log) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  VLOG(1) << "Startup: stores loaded after "
+          << startup_timer.Elapsed().InMilliseconds() << " ms";
+
+  net::NaiveWorker main_worker(/*thread=*/0, config,
+                               std::move(listen_sockets_by_thread[0]),
+                               std::move(resolver), config.http_cache,
+                               quic_session_store.get(),
+                               ssl_session_store.get(),
+                               cert_verify_store.get(),
+                               host_cache_store.get(),
+                               shared_host_cache.get(), access_log.get());
+
+  std::vector<std::unique_ptr<base::Thread>> worker_threads;
+  std::vector<base::SequenceBound<net::NaiveWorker>> workers;
+  for (int i = 1; i < config.threads; ++i) {
+    auto thread =
+        std::make_unique<base::Thread>(base::StringPrintf("naive_io%d", i));
+    CHECK(thread->StartWithOptions(
+        base::Thread::Options(base::MessagePumpType::IO, 0)));
+    workers.emplace_back(thread->task_runner(), i, config,
+                         std::move(listen_sockets_by_thread[i]),
+                         std::unique_ptr<net::RedirectResolver>(),
+                         base::FilePath(), quic_session_store.get(),
+                         ssl_session_store.get(),
+                         cert_verify_store.get(), host_cache_store.get(),
+                         shared_host_cache.get(), access_log.get());
+    worker_threads.push_back(std::move(thread));
+  }
+  if (config.threads > 1) {
+    LOG(INFO) << "Running " << config.threads << " IO threads";
+  }
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  if (config.cpu_affinity) {
+    std::vector<base::PlatformThreadId> io_threads = {
+        base::PlatformThread::CurrentId()};
+    for (const auto& thread : worker_threads) {
+      io_threads.push_back(thread->GetThreadId());
+    }
+    PinIoThreads(io_threads);
+  }
+#endif
+  VLOG(1) << "Startup: main thread ready after "
+          << startup_timer.Elapsed().InMilliseconds() << " ms";
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  // The resident memory before any tunnel, the baseline of small routers.
+  VLOG(1) << "Startup: resident memory "
+          << base::ProcessMetrics::CreateCurrentProcessMetrics()
+                     ->GetResidentSetSize() /
+                 1024
+          << " KiB";
 #endif
-  auto context =
-      net::BuildURLRequestContext(config, std::move(cert_net_fetcher), net_log);
-  auto* session = context->http_transaction_factory()->GetSession();
 
-  std::vector<std::unique_ptr<net::NaiveProxy>> naive_proxies;
-  std::unique_ptr<net::RedirectResolver> resolver;
+  if (!config.bench.IsEmpty()) {
+    return net::RunBench(config, &main_worker, &workers, net_log);
+  }
 
-  for (const net::NaiveListenConfig& listen_config : config.listen) {
-    auto listen_socket =
+  // Counts from the NetLog only while metrics are served.
+  std::unique_ptr<net::NaiveStallCounter> stall_counter;
+  std::unique_ptr<net::NaiveMetricsServer> metrics_server;
+  if (config.metrics_port > 0) {
+    stall_counter = std::make_unique<net::NaiveStallCounter>();
+    stall_counter->StartObserving(net_log);
+    auto metrics_socket =
         std::make_unique<net::TCPServerSocket>(net_log, net::NetLogSource());
-
-    int result = listen_socket->ListenWithAddressAndPort(
-        listen_config.addr, listen_config.port, kListenBackLog);
+    int result = metrics_socket->ListenWithAddressAndPort(
+        config.metrics_addr, config.metrics_port, kMetricsListenBackLog);
     if (result != net::OK) {
-      LOG(ERROR) << "Failed to listen on "
-                 << net::ToString(listen_config.protocol) << "://"
-                 << listen_config.addr << " " << listen_config.port << ": "
+      LOG(ERROR) << "Failed to serve metrics on " << config.metrics_addr
+                 << " " << config.metrics_port << ": "
                  << net::ErrorToShortString(result);
       return EXIT_FAILURE;
     }
-    LOG(INFO) << "Listening on " << net::ToString(listen_config.protocol)
-              << "://" << listen_config.addr << ":" << listen_config.port;
+    metrics_server = std::make_unique<net::NaiveMetricsServer>(
+        std::move(metrics_socket),
+        base::BindRepeating(&net::CollectMetrics, &main_worker, &workers,
+                            stall_counter.get()),
+        kTrafficAnnotation);
+    LOG(INFO) << "Serving metrics on http://" << config.metrics_addr << ":"
+              << config.metrics_port << "/metrics";
+  }
 
-    if (resolver == nullptr &&
-        listen_config.protocol == net::ClientProtocol::kRedir) {
-      auto resolver_socket =
-          std::make_unique<net::UDPServerSocket>(net_log, net::NetLogSource());
-      resolver_socket->AllowAddressReuse();
-      net::IPAddress listen_addr;
-      if (!listen_addr.AssignFromIPLiteral(listen_config.addr)) {
-        LOG(ERROR) << "Failed to open resolver: " << listen_config.addr;
-        return EXIT_FAILURE;
-      }
+  std::unique_ptr<net::NaiveTraceRecorder> trace_recorder;
+  if (!config.trace_file.empty()) {
+    trace_recorder = std::make_unique<net::NaiveTraceRecorder>(
+        config.trace_file);
+    trace_recorder->Start(config.trace_duration);
+  }
 
-      result = resolver_socket->Listen(
-          net::IPEndPoint(listen_addr, listen_config.port));
-      if (result != net::OK) {
-        LOG(ERROR) << "Failed to open resolver: "
-                   << net::ErrorToShortString(result);
-        return EXIT_FAILURE;
-      }
+  base::RunLoop run_loop;
+#if BUILDFLAG(IS_POSIX)
+  net::NaiveReloadSignal reload_signal(
+      base::BindRepeating(&net::ReloadConfig, &config, &main_worker, &workers,
+                          &handoff_server, net_log));
+  if (!reload_signal.Start()) {
+    LOG(WARNING) << "No configuration reload on SIGHUP";
+  }
 
-      resolver = std::make_unique<net::RedirectResolver>(
-          std::move(resolver_socket), config.resolver_range,
-          config.resolver_prefix);
-    }
+  base::RepeatingTimer handoff_drain_timer;
+  if (!config.handoff.empty() &&
+      !handoff_server.Start(
+          config.handoff,
+          base::BindOnce(&net::DrainAfterHandoff, &main_worker, &workers,
+                         &handoff_drain_timer, run_loop.QuitClosure()))) {
+    LOG(WARNING) << "No handoff to the next instance";
+  }
+#endif
 
-    auto naive_proxy = std::make_unique<net::NaiveProxy>(
-        std::move(listen_socket), listen_config.protocol, listen_config.user,
-        listen_config.pass, config.insecure_concurrency, resolver.get(),
-        session, kTrafficAnnotation,
-        std::vector<net::PaddingType>{net::PaddingType::kVariant1,
-                                      net::PaddingType::kNone});
-    naive_proxies.push_back(std::move(naive_proxy));
+  base::RepeatingTimer net_log_stats_timer;
+  if (VLOG_IS_ON(1) && net_log_sampler) {
+    net_log_stats_timer.Start(
+        FROM_HERE, base::Seconds(kStatsIntervalSeconds),
+        base::BindRepeating(&net::NaiveNetLogSampler::LogCounts,
+                            base::Unretained(net_log_sampler.get())));
+  }
+  std::unique_ptr<net::NaiveMemoryPressureMonitor> memory_pressure_monitor;
+  if (config.memory_pressure > 0) {
+    if (net::NaiveMemoryPressureMonitor::IsSupported()) {
+      memory_pressure_monitor =
+          std::make_unique<net::NaiveMemoryPressureMonitor>(
+              static_cast<uint64_t>(config.memory_pressure) << 20);
+    } else {
+      LOG(WARNING) << "No memory pressure monitor on this platform";
+    }
+  }
+  base::RepeatingTimer fd_sample_timer;
+  base::RepeatingTimer fd_stats_timer;
+  if (config.fd_budget) {
+    fd_sample_timer.Start(
+        FROM_HERE, net::NaiveFdBudget::kSampleInterval,
+        base::BindRepeating(&net::NaiveFdBudget::Sample, config.fd_budget));
+    if (VLOG_IS_ON(1)) {
+      fd_stats_timer.Start(
+          FROM_HERE, base::Seconds(kStatsIntervalSeconds),
+          base::BindRepeating(&net::NaiveFdBudget::LogUsage,
+                              config.fd_budget));
+    }
+  }
+  base::RepeatingTimer uplink_sample_timer;
+  if (config.uplink_set) {
+    uplink_sample_timer.Start(
+        FROM_HERE, net::NaiveUplinks::kSampleInterval,
+        base::BindRepeating(&net::NaiveUplinks::Sample, config.uplink_set));
   }
+  base::RepeatingTimer busy_poll_stats_timer;
+  if (VLOG_IS_ON(1) && config.busy_poll.is_positive()) {
+    busy_poll_stats_timer.Start(FROM_HERE,
+                                base::Seconds(kStatsIntervalSeconds),
+                                base::BindRepeating(&LogBusyPollStats));
+  }
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  WakeUpLogger wake_up_logger;
+  base::RepeatingTimer wake_up_stats_timer;
+  if (VLOG_IS_ON(1)) {
+    wake_up_stats_timer.Start(
+        FROM_HERE, base::Seconds(kStatsIntervalSeconds),
+        base::BindRepeating(&WakeUpLogger::Log,
+                            base::Unretained(&wake_up_logger)));
+  }
+#endif
 
-  base::RunLoop().Run();
+  run_loop.Run();
 
   return EXIT_SUCCESS;
 }
@@ -12,18 +12,35 @@
 #include <string>
 #include <string_view>
 
+#include "base/functional/bind.h"
 #include "base/logging.h"
-#include "base/rand_util.h"
 #include "base/strings/string_util.h"
+#include "base/task/sequenced_task_runner.h"
+#include "base/time/time.h"
 #include "net/base/proxy_string_util.h"
 #include "net/http/http_request_headers.h"
 #include "net/http/http_response_headers.h"
 #include "net/third_party/quiche/src/quiche/spdy/core/hpack/hpack_constants.h"
+#include "net/tools/naive/naive_random.h"
 
 namespace net {
 namespace {
 bool g_nonindex_codes_initialized;
 uint8_t g_nonindex_codes[17];
+
+constexpr base::TimeDelta kPaddingTypeTtl = base::Minutes(10);
+
+constexpr size_t kPaddingValuePoolSize = 16;
+
+// SETTINGS_MAX_FRAME_SIZE announced to naive servers, so bulk transfers take
+// fewer DATA frames.
+constexpr uint32_t kNaiveMaxFrameSize = 256 * 1024;
+
+std::string GeneratePaddingValue() {
+  std::string padding(NaiveRandInt(16, 32), '~');
+  FillNonindexHeaderValue(NaiveRandUint64(), &padding[0], padding.size());
+  return padding;
+}
 }  // namespace
 
 void InitializeNonindexCodes() {
@@ -55,8 +72,10 @@ void FillNonindexHeaderValue(uint64_t unique_bits, char* buf, int len) {
 
 NaiveProxyDelegate::NaiveProxyDelegate(
     const HttpRequestHeaders& extra_headers,
-    const std::vector<PaddingType>& supported_padding_types)
-    : extra_headers_(extra_headers) {
+    const std::vector<PaddingType>& supported_padding_types,
+    Compression compression,
+    bool optimistic_connect)
+    : extra_headers_(extra_headers), optimistic_connect_(optimistic_connect) {
   InitializeNonindexCodes();
 
   std::vector<std::string_view> padding_type_strs;
@@ -65,10 +84,30 @@ NaiveProxyDelegate::NaiveProxyDelegate(
   }
   extra_headers_.SetHeader(kPaddingTypeRequestHeader,
                            base::JoinString(padding_type_strs, ", "));
+  if (compression != Compression::kNone) {
+    extra_headers_.SetHeader(kPaddingCompressionRequestHeader,
+                             ToString(compression));
+  }
+
+  RefillPaddingValues();
 }
 
 NaiveProxyDelegate::~NaiveProxyDelegate() = default;
 
+void NaiveProxyDelegate::SetExtraHeaders(
+    const HttpRequestHeaders& extra_headers) {
+  std::string padding_types;
+  extra_headers_.GetHeader(kPaddingTypeRequestHeader, &padding_types);
+  std::string compressions;
+  bool has_compressions =
+      extra_headers_.GetHeader(kPaddingCompressionRequestHeader, &compressions);
+  extra_headers_ = extra_headers;
+  extra_headers_.SetHeader(kPaddingTypeRequestHeader, padding_types);
+  if (has_compressions) {
+    extra_headers_.SetHeader(kPaddingCompressionRequestHeader, compressions);
+  }
+}
+
 Error NaiveProxyDelegate::OnBeforeTunnelRequest(
     const ProxyChain& proxy_chain,
     size_t chain_index,
@@ -87,13 +126,15 @@ Error NaiveProxyDelegate::OnBeforeTunnelRequest(
     return OK;
 
   // Sends client-side padding header regardless of server support
-  std::string padding(base::RandInt(16, 32), '~');
-  FillNonindexHeaderValue(base::RandUint64(), &padding[0], padding.size());
-  extra_headers->SetHeader(kPaddingHeader, padding);
+  extra_headers->SetHeader(kPaddingHeader, TakePaddingValue());
 
   // Enables Fast Open in H2/H3 proxy client socket once the state of server
-  // padding support is known.
-  if (padding_type_by_server_[proxy_server].has_value()) {
+  // padding support is known and recent, or known at all if optimistic.
+  // The first payload is then sent right after the request headers.
+  const ServerPadding& padding = padding_by_server_[proxy_server];
+  if (padding.type.has_value() &&
+      (optimistic_connect_ ||
+       base::TimeTicks::Now() - padding.negotiated_time < kPaddingTypeTtl)) {
     extra_headers->SetHeader("fastopen", "1");
   }
   extra_headers->MergeFrom(extra_headers_);
@@ -101,8 +142,30 @@ Error NaiveProxyDelegate::OnBeforeTunnelRequest(
   return OK;
 }
 
-std::optional<PaddingType> NaiveProxyDelegate::ParsePaddingHeaders(
-    const HttpResponseHeaders& headers) {
+std::string NaiveProxyDelegate::TakePaddingValue() {
+  if (padding_values_.size() <= kPaddingValuePoolSize / 2 && !refill_pending_) {
+    refill_pending_ = true;
+    base::SequencedTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE, base::BindOnce(&NaiveProxyDelegate::RefillPaddingValues,
+                                  weak_ptr_factory_.GetWeakPtr()));
+  }
+  if (padding_values_.empty()) {
+    return GeneratePaddingValue();
+  }
+  std::string padding = std::move(padding_values_.back());
+  padding_values_.pop_back();
+  return padding;
+}
+
+void NaiveProxyDelegate::RefillPaddingValues() {
+  refill_pending_ = false;
+  while (padding_values_.size() < kPaddingValuePoolSize) {
+    padding_values_.push_back(GeneratePaddingValue());
+  }
+}
+
+std::optional<std::pair<PaddingType, PaddingLimits>>
+NaiveProxyDelegate::ParsePaddingHeaders(const HttpResponseHeaders& headers) {
   bool has_padding = headers.HasHeader(kPaddingHeader);
   std::string padding_type_reply;
   bool has_padding_type_reply =
@@ -112,17 +175,17 @@ std::optional<PaddingType> NaiveProxyDelegate::ParsePaddingHeaders(
     // Backward compatibility with before kVariant1 when the padding-version
     // header does not exist.
     if (has_padding) {
-      return PaddingType::kVariant1;
+      return std::make_pair(PaddingType::kVariant1, PaddingLimits());
     } else {
-      return PaddingType::kNone;
+      return std::make_pair(PaddingType::kNone, PaddingLimits());
     }
   }
-  std::optional<PaddingType> padding_type =
-      ParsePaddingType(padding_type_reply);
-  if (!padding_type.has_value()) {
+  std::optional<std::pair<PaddingType, PaddingLimits>> padding =
+      ParsePaddingTypeReply(padding_type_reply);
+  if (!padding.has_value()) {
     LOG(ERROR) << "Received invalid padding type: " << padding_type_reply;
   }
-  return padding_type;
+  return padding;
 }
 
 Error NaiveProxyDelegate::OnTunnelHeadersReceived(
@@ -143,22 +206,48 @@ Error NaiveProxyDelegate::OnTunnelHeadersReceived(
     return OK;
 
   // Detects server padding support, even if it changes dynamically.
-  std::optional<PaddingType> new_padding_type =
+  std::optional<std::pair<PaddingType, PaddingLimits>> new_padding =
       ParsePaddingHeaders(response_headers);
-  if (!new_padding_type.has_value()) {
+  if (!new_padding.has_value()) {
     return ERR_INVALID_RESPONSE;
   }
-  std::optional<PaddingType>& padding_type =
-      padding_type_by_server_[proxy_server];
-  if (!padding_type.has_value() || padding_type != new_padding_type) {
+  auto [new_padding_type, new_padding_limits] = *new_padding;
+  ServerPadding& padding = padding_by_server_[proxy_server];
+  padding.negotiated_time = base::TimeTicks::Now();
+  std::optional<PaddingType> old_padding_type = padding.type;
+  bool was_known = old_padding_type.has_value();
+  if (!was_known || padding.type != new_padding_type ||
+      padding.limits != new_padding_limits) {
     LOG(INFO) << ProxyServerToProxyUri(proxy_server)
               << " negotiated padding type: "
-              << ToReadableString(*new_padding_type);
-    padding_type = new_padding_type;
+              << ToReadableString(new_padding_type) << " ("
+              << ToPaddingTypeReply(new_padding_type, new_padding_limits)
+              << ")";
+    padding.type = new_padding_type;
+    padding.limits = new_padding_limits;
+  }
+  if (was_known && old_padding_type != new_padding_type) {
+    // The tunnel may have sent its first payload with Fast Open, padded with
+    // the old type, which the server reads with the new one.
+    return ERR_TUNNEL_CONNECTION_FAILED;
   }
   return OK;
 }
 
+uint32_t NaiveProxyDelegate::GetTunnelMaxFrameSize(
+    const ProxyChain& proxy_chain,
+    size_t chain_index) {
+  if (chain_index != proxy_chain.length() - 1)
+    return 0;
+  // Servers without padding support may be any frontend, which should see
+  // the frames of a browser.
+  std::optional<PaddingType> padding_type =
+      padding_by_server_[proxy_chain.Last()].type;
+  if (!padding_type.has_value() || *padding_type == PaddingType::kNone)
+    return 0;
+  return kNaiveMaxFrameSize;
+}
+
 std::optional<PaddingType> NaiveProxyDelegate::GetProxyChainPaddingType(
     const ProxyChain& proxy_chain) {
   // Not possible to negotiate padding capability given the underlying
@@ -167,7 +256,16 @@ std::optional<PaddingType> NaiveProxyDelegate::GetProxyChainPaddingType(
     return PaddingType::kNone;
   if (proxy_chain.Last().is_socks())
     return PaddingType::kNone;
-  return padding_type_by_server_[proxy_chain.Last()];
+  return padding_by_server_[proxy_chain.Last()].type;
+}
+
+PaddingLimits NaiveProxyDelegate::GetProxyChainPaddingLimits(
+    const ProxyChain& proxy_chain) {
+  if (proxy_chain.is_direct())
+    return PaddingLimits();
+  if (proxy_chain.Last().is_socks())
+    return PaddingLimits();
+  return padding_by_server_[proxy_chain.Last()].limits;
 }
 
 PaddingDetectorDelegate::PaddingDetectorDelegate(
@@ -180,8 +278,11 @@ PaddingDetectorDelegate::PaddingDetectorDelegate(
 
 PaddingDetectorDelegate::~PaddingDetectorDelegate() = default;
 
-void PaddingDetectorDelegate::SetClientPaddingType(PaddingType padding_type) {
+void PaddingDetectorDelegate::SetClientPaddingType(
+    PaddingType padding_type,
+    const PaddingLimits& padding_limits) {
   detected_client_padding_type_ = padding_type;
+  detected_client_padding_limits_ = padding_limits;
 }
 
 std::optional<PaddingType> PaddingDetectorDelegate::GetClientPaddingType() {
@@ -191,6 +292,10 @@ std::optional<PaddingType> PaddingDetectorDelegate::GetClientPaddingType() {
     return PaddingType::kNone;
   } else if (client_protocol_ == ClientProtocol::kRedir) {
     return PaddingType::kNone;
+  } else if (client_protocol_ == ClientProtocol::kTun) {
+    return PaddingType::kNone;
+  } else if (client_protocol_ == ClientProtocol::kTproxy) {
+    return PaddingType::kNone;
   }
 
   return detected_client_padding_type_;
@@ -201,7 +306,18 @@ std::optional<PaddingType> PaddingDetectorDelegate::GetServerPaddingType() {
     return cached_server_padding_type_;
   cached_server_padding_type_ =
       naive_proxy_delegate_->GetProxyChainPaddingType(proxy_chain_);
+  cached_server_padding_limits_ =
+      naive_proxy_delegate_->GetProxyChainPaddingLimits(proxy_chain_);
   return cached_server_padding_type_;
 }
 
+PaddingLimits PaddingDetectorDelegate::GetClientPaddingLimits() {
+  return detected_client_padding_limits_;
+}
+
+PaddingLimits PaddingDetectorDelegate::GetServerPaddingLimits() {
+  DCHECK(cached_server_padding_type_.has_value());
+  return cached_server_padding_limits_;
+}
+
 }  // namespace net
@@ -8,9 +8,12 @@
 #include <map>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "base/memory/weak_ptr.h"
 #include "base/strings/string_piece.h"
+#include "base/time/time.h"
 #include "net/base/net_errors.h"
 #include "net/base/proxy_chain.h"
 #include "net/base/proxy_delegate.h"
@@ -29,8 +32,12 @@ class ProxyInfo;
 
 class NaiveProxyDelegate : public ProxyDelegate {
  public:
+  // Requests `compression` of the tunnels from the proxy servers, unless it
+  // is Compression::kNone.
   NaiveProxyDelegate(const HttpRequestHeaders& extra_headers,
-                     const std::vector<PaddingType>& supported_padding_types);
+                     const std::vector<PaddingType>& supported_padding_types,
+                     Compression compression,
+                     bool optimistic_connect);
   ~NaiveProxyDelegate() override;
 
   void OnResolveProxy(const GURL& url,
@@ -52,28 +59,66 @@ class NaiveProxyDelegate : public ProxyDelegate {
       size_t chain_index,
       const HttpResponseHeaders& response_headers) override;
 
+  // Returns a larger frame size only for naive servers, known from their
+  // padding support.
+  uint32_t GetTunnelMaxFrameSize(const ProxyChain& proxy_chain,
+                                 size_t chain_index) override;
+
   void SetProxyResolutionService(
       ProxyResolutionService* proxy_resolution_service) override {}
 
+  // Replaces the extra headers of tunnel requests from now on.
+  void SetExtraHeaders(const HttpRequestHeaders& extra_headers);
+
   // Returns empty if the padding type has not been negotiated.
   std::optional<PaddingType> GetProxyChainPaddingType(
       const ProxyChain& proxy_chain);
 
+  // Returns the limits negotiated with the padding type.
+  PaddingLimits GetProxyChainPaddingLimits(const ProxyChain& proxy_chain);
+
  private:
-  std::optional<PaddingType> ParsePaddingHeaders(
+  std::optional<std::pair<PaddingType, PaddingLimits>> ParsePaddingHeaders(
       const HttpResponseHeaders& headers);
 
+  // Returns a value for kPaddingHeader, from padding_values_ if possible.
+  std::string TakePaddingValue();
+  void RefillPaddingValues();
+
   HttpRequestHeaders extra_headers_;
 
-  // Empty value means padding type has not been negotiated.
-  std::map<ProxyServer, std::optional<PaddingType>> padding_type_by_server_;
+  // Uses Fast Open regardless of kPaddingTypeTtl. A reply that changes the
+  // known padding type then fails its tunnel, whose data was already sent
+  // with the old type.
+  bool optimistic_connect_;
+
+  // Values for kPaddingHeader generated in a separate task ahead of the
+  // tunnel requests that use them.
+  std::vector<std::string> padding_values_;
+  bool refill_pending_ = false;
+
+  struct ServerPadding {
+    // Empty value means padding type has not been negotiated.
+    std::optional<PaddingType> type;
+    PaddingLimits limits;
+    base::TimeTicks negotiated_time;
+  };
+
+  // Kept across connections. New connections keep using the negotiated type,
+  // but only use Fast Open with it for kPaddingTypeTtl after the last reply
+  // unless optimistic_connect_, so a server that changes support is noticed
+  // before data is sent.
+  std::map<ProxyServer, ServerPadding> padding_by_server_;
+
+  base::WeakPtrFactory<NaiveProxyDelegate> weak_ptr_factory_{this};
 };
 
 class ClientPaddingDetectorDelegate {
  public:
   virtual ~ClientPaddingDetectorDelegate() = default;
 
-  virtual void SetClientPaddingType(PaddingType padding_type) = 0;
+  virtual void SetClientPaddingType(PaddingType padding_type,
+                                    const PaddingLimits& padding_limits) = 0;
 };
 
 class PaddingDetectorDelegate : public ClientPaddingDetectorDelegate {
@@ -85,7 +130,11 @@ class PaddingDetectorDelegate : public ClientPaddingDetectorDelegate {
 
   std::optional<PaddingType> GetClientPaddingType();
   std::optional<PaddingType> GetServerPaddingType();
-  void SetClientPaddingType(PaddingType padding_type) override;
+  // Only valid once the corresponding padding type is known.
+  PaddingLimits GetClientPaddingLimits();
+  PaddingLimits GetServerPaddingLimits();
+  void SetClientPaddingType(PaddingType padding_type,
+                            const PaddingLimits& padding_limits) override;
 
  private:
   NaiveProxyDelegate* naive_proxy_delegate_;
@@ -93,9 +142,13 @@ class PaddingDetectorDelegate : public ClientPaddingDetectorDelegate {
   ClientProtocol client_protocol_;
 
   std::optional<PaddingType> detected_client_padding_type_;
+  PaddingLimits detected_client_padding_limits_;
   // The result is only cached during one connection, so it's still dynamically
   // updated in the following connections after server changes support.
+  // Must not be read before the server connect completes, which is after the
+  // reply unless Fast Open is used.
   std::optional<PaddingType> cached_server_padding_type_;
+  PaddingLimits cached_server_padding_limits_;
 };
 
 }  // namespace net
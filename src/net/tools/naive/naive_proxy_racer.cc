@@ -0,0 +1,311 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_proxy_racer.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/raw_ptr.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/notreached.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/types/expected.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_error_details.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_interfaces.h"
+#include "net/base/privacy_mode.h"
+#include "net/base/proxy_chain.h"
+#include "net/base/session_usage.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_proxy_connect_job.h"
+#include "net/log/net_log_source_type.h"
+#include "net/proxy_resolution/proxy_info.h"
+#include "net/quic/quic_context.h"
+#include "net/quic/quic_session_key.h"
+#include "net/quic/quic_session_pool.h"
+#include "net/socket/connect_job_factory.h"
+#include "net/socket/connect_job_params.h"
+#include "net/socket/connect_job_params_factory.h"
+#include "net/socket/next_proto.h"
+#include "net/socket/socket_tag.h"
+#include "net/socket/ssl_connect_job.h"
+#include "net/socket/stream_socket.h"
+#include "net/spdy/spdy_session.h"
+#include "net/spdy/spdy_session_key.h"
+#include "net/spdy/spdy_session_pool.h"
+#include "net/ssl/ssl_config.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "url/scheme_host_port.h"
+#include "url/url_constants.h"
+
+namespace net {
+namespace {
+
+// Connect job params for the session to the last proxy of `selection`,
+// connected as HttpProxyConnectJob connects it for a tunnel.
+scoped_refptr<HttpProxySocketParams> CreateParams(
+    const NaiveProxySelector& proxy_selector,
+    const NaiveProxySelector::Selection& selection,
+    const CommonConnectJobParams* common_connect_job_params,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  const ProxyChain& proxy_chain =
+      proxy_selector.proxy_info(selection).proxy_chain();
+  // The endpoint only names the target of the CONNECT, which is never sent.
+  const HostPortPair& last = proxy_chain.Last().host_port_pair();
+  ConnectJobParams params = ConstructConnectJobParams(
+      url::SchemeHostPort(url::kHttpScheme, last.host(), last.port()),
+      proxy_chain, traffic_annotation, /*allowed_bad_certs=*/{},
+      ConnectJobFactory::AlpnMode::kHttpAll, /*force_tunnel=*/true,
+      PRIVACY_MODE_DISABLED, OnHostResolutionCallback(),
+      proxy_selector.network_anonymization_key(selection),
+      SecureDnsPolicy::kDisable, /*disable_cert_network_fetches=*/false,
+      common_connect_job_params, NetworkAnonymizationKey());
+  return params.take_http_proxy();
+}
+
+}  // namespace
+
+// The race of one chain. Both sessions are connected as NaiveSessionWarmer
+// connects them, and the winner is left in the session pool for the tunnels
+// to find.
+class NaiveProxyRacer::Race : public ConnectJob::Delegate {
+ public:
+  Race(const CommonConnectJobParams* common_connect_job_params,
+       const NetLogWithSource& net_log,
+       NaiveProxySelector* proxy_selector,
+       size_t chain,
+       const NetworkTrafficAnnotationTag& traffic_annotation)
+      : common_connect_job_params_(common_connect_job_params),
+        net_log_(net_log),
+        proxy_selector_(proxy_selector),
+        chain_(chain) {
+    spdy_params_ = CreateParams(*proxy_selector_, {chain_, 0, false},
+                                common_connect_job_params_,
+                                traffic_annotation);
+    quic_params_ =
+        CreateParams(*proxy_selector_, {chain_, 0, true},
+                     common_connect_job_params_, traffic_annotation);
+    DCHECK(quic_params_->is_over_quic());
+    proxy_ = quic_params_->proxy_server().host_port_pair();
+    spdy_key_ = SpdySessionKey(
+        proxy_, PRIVACY_MODE_DISABLED, ProxyChain::Direct(),
+        SessionUsage::kProxy, SocketTag(),
+        spdy_params_->network_anonymization_key(),
+        spdy_params_->secure_dns_policy(),
+        /*disable_cert_verification_network_fetches=*/true);
+    destination_ =
+        url::SchemeHostPort(url::kHttpsScheme, proxy_.host(), proxy_.port());
+  }
+  ~Race() override = default;
+  Race(const Race&) = delete;
+  Race& operator=(const Race&) = delete;
+
+  void Start() {
+    if (connect_job_ || quic_request_)
+      return;
+    start_time_ = base::TimeTicks::Now();
+    ConnectSpdy();
+    if (!decided_)
+      ConnectQuic();
+  }
+
+  // Remembers the protocol used on `old_network`, and applies the one last
+  // used on `new_network`, if any.
+  void OnNetworkChanged(const std::string& old_network,
+                        const std::string& new_network) {
+    connect_job_.reset();
+    quic_request_.reset();
+    quic_by_network_[old_network] = proxy_selector_->uses_quic(chain_);
+    auto it = quic_by_network_.find(new_network);
+    if (it != quic_by_network_.end())
+      proxy_selector_->SetUseQuic(chain_, it->second);
+  }
+
+ private:
+  void ConnectSpdy() {
+    decided_ = false;
+    connect_job_ = std::make_unique<SSLConnectJob>(
+        MAXIMUM_PRIORITY, SocketTag(), common_connect_job_params_,
+        spdy_params_->ssl_params(), this, /*net_log=*/nullptr);
+    int rv = connect_job_->Connect();
+    if (rv != ERR_IO_PENDING)
+      OnConnectJobComplete(rv, connect_job_.get());
+  }
+
+  // An existing QUIC session wins at once, as it shows QUIC gets through.
+  void ConnectQuic() {
+    const SSLConfig& ssl_config = *quic_params_->quic_ssl_config();
+    quic_request_ = std::make_unique<QuicSessionRequest>(
+        common_connect_job_params_->quic_session_pool);
+    int rv = quic_request_->Request(
+        destination_, SupportedQuicVersionForProxying(), ProxyChain::Direct(),
+        quic_params_->traffic_annotation(),
+        common_connect_job_params_->http_user_agent_settings,
+        SessionUsage::kProxy, ssl_config.privacy_mode,
+        HttpProxyConnectJob::kH2QuicTunnelPriority, SocketTag(),
+        quic_params_->network_anonymization_key(),
+        quic_params_->secure_dns_policy(),
+        /*require_dns_https_alpn=*/false, ssl_config.GetCertVerifyFlags(),
+        destination_.GetURL(), net_log_, &quic_net_error_details_,
+        /*failed_on_default_network_callback=*/CompletionOnceCallback(),
+        base::BindOnce(&Race::OnQuicRequestComplete, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnQuicRequestComplete(rv);
+  }
+
+  // ConnectJob::Delegate:
+  void OnConnectJobComplete(int result, ConnectJob* job) override {
+    DCHECK_EQ(job, connect_job_.get());
+    std::unique_ptr<ConnectJob> connect_job = std::move(connect_job_);
+    // A proxy without HTTP/2 still shows that TCP gets through, and its
+    // tunnels take a connection each.
+    if (result == OK) {
+      std::unique_ptr<StreamSocket> socket = connect_job->PassSocket();
+      if (socket->GetNegotiatedProtocol() == kProtoHTTP2) {
+        base::expected<base::WeakPtr<SpdySession>, int> spdy_session =
+            common_connect_job_params_->spdy_session_pool
+                ->CreateAvailableSessionFromSocket(
+                    spdy_key_, std::move(socket),
+                    connect_job->connect_timing(), connect_job->net_log());
+        if (!spdy_session.has_value())
+          result = spdy_session.error();
+      }
+    }
+    OnComplete(/*quic=*/false, result);
+  }
+
+  void OnNeedsProxyAuth(const HttpResponseInfo& response,
+                        HttpAuthController* auth_controller,
+                        base::OnceClosure restart_with_auth_callback,
+                        ConnectJob* job) override {
+    // Only proxy connect jobs ask for credentials.
+    NOTREACHED();
+  }
+
+  void OnQuicRequestComplete(int result) {
+    // Releases the handle only. The session stays in the pool.
+    if (result == OK)
+      quic_request_->ReleaseSessionHandle();
+    quic_request_.reset();
+    OnComplete(/*quic=*/true, result);
+  }
+
+  void OnComplete(bool quic, int result) {
+    const char* protocol = quic ? "QUIC" : "HTTP/2";
+    if (result != OK) {
+      VLOG(1) << protocol << " to " << proxy_.ToString()
+              << " failed: " << ErrorToShortString(result);
+      if (!connect_job_ && !quic_request_) {
+        LOG(WARNING) << "Both QUIC and HTTP/2 to " << proxy_.ToString()
+                     << " failed";
+      }
+      return;
+    }
+    // Cancels the loser.
+    connect_job_.reset();
+    quic_request_.reset();
+    decided_ = true;
+    VLOG(1) << protocol << " to " << proxy_.ToString() << " won in "
+            << base::TimeTicks::Now() - start_time_;
+    proxy_selector_->SetUseQuic(chain_, quic);
+  }
+
+  raw_ptr<const CommonConnectJobParams> common_connect_job_params_;
+  const NetLogWithSource& net_log_;
+  raw_ptr<NaiveProxySelector> proxy_selector_;
+  const size_t chain_;
+  scoped_refptr<HttpProxySocketParams> spdy_params_;
+  scoped_refptr<HttpProxySocketParams> quic_params_;
+  HostPortPair proxy_;
+  SpdySessionKey spdy_key_;
+  url::SchemeHostPort destination_;
+
+  std::unique_ptr<ConnectJob> connect_job_;
+  std::unique_ptr<QuicSessionRequest> quic_request_;
+  NetErrorDetails quic_net_error_details_;
+  base::TimeTicks start_time_;
+  // Set once a protocol has won the current race.
+  bool decided_ = false;
+
+  // Whether QUIC was used last on each network.
+  std::map<std::string, bool> quic_by_network_;
+};
+
+// static
+std::string NaiveProxyRacer::GetCurrentNetwork() {
+  return std::string(NetworkChangeNotifier::ConnectionTypeToString(
+             NetworkChangeNotifier::GetConnectionType())) +
+         " " + GetWifiSSID();
+}
+
+NaiveProxyRacer::NaiveProxyRacer(
+    HttpNetworkSession* session,
+    NaiveProxySelector* proxy_selector,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : common_connect_job_params_(session->CreateCommonConnectJobParams()),
+      net_log_(
+          NetLogWithSource::Make(session->net_log(), NetLogSourceType::NONE)) {
+  for (size_t chain = 0; chain < proxy_selector->num_chains(); ++chain) {
+    if (!proxy_selector->is_raced(chain))
+      continue;
+    races_.push_back(std::make_unique<Race>(&common_connect_job_params_,
+                                            net_log_, proxy_selector, chain,
+                                            traffic_annotation));
+  }
+  if (races_.empty())
+    return;
+
+  network_ = GetCurrentNetwork();
+  NetworkChangeNotifier::AddNetworkChangeObserver(this);
+  race_timer_.Start(FROM_HERE, kRaceInterval, this,
+                    &NaiveProxyRacer::StartRaces);
+  // Leaves the first round to the next task, once the listeners are up.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveProxyRacer::StartRaces,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+NaiveProxyRacer::~NaiveProxyRacer() {
+  if (!races_.empty())
+    NetworkChangeNotifier::RemoveNetworkChangeObserver(this);
+}
+
+void NaiveProxyRacer::OnNetworkChanged(
+    NetworkChangeNotifier::ConnectionType type) {
+  if (type == NetworkChangeNotifier::CONNECTION_NONE)
+    return;
+  std::string network = GetCurrentNetwork();
+  for (const auto& race : races_)
+    race->OnNetworkChanged(network_, network);
+  network_ = std::move(network);
+  // Gives the session pools time to close the sessions of the old network.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&NaiveProxyRacer::StartRaces,
+                     weak_ptr_factory_.GetWeakPtr()),
+      kNetworkChangeDelay);
+  race_timer_.Reset();
+}
+
+void NaiveProxyRacer::RaceNow() {
+  if (races_.empty())
+    return;
+  race_timer_.Reset();
+  StartRaces();
+}
+
+void NaiveProxyRacer::StartRaces() {
+  for (const auto& race : races_)
+    race->Start();
+}
+
+}  // namespace net
@@ -0,0 +1,74 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_PROXY_RACER_H_
+#define NET_TOOLS_NAIVE_NAIVE_PROXY_RACER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/network_change_notifier.h"
+#include "net/log/net_log_with_source.h"
+#include "net/socket/connect_job.h"
+
+namespace net {
+
+class HttpNetworkSession;
+class NaiveProxySelector;
+struct NetworkTrafficAnnotationTag;
+
+// Races a QUIC session against an HTTP/2 session to the proxy of each chain
+// of NaiveProxySelector that has a QUIC chain, and points the new tunnels of
+// the chain at the first one to connect. The loser is canceled. A race where
+// both fail changes nothing.
+//
+// The chains are raced again every kRaceInterval, as a network that throttled
+// UDP may stop, and soon after network changes. The outcome on each network
+// is remembered, counting the fallbacks of the selector, so that a network
+// seen before gets its protocol right away instead of after the next race.
+// Networks are told apart by connection type and Wi-Fi SSID.
+class NaiveProxyRacer : public NetworkChangeNotifier::NetworkChangeObserver {
+ public:
+  static constexpr base::TimeDelta kRaceInterval = base::Minutes(5);
+  static constexpr base::TimeDelta kNetworkChangeDelay = base::Seconds(1);
+
+  // `session` and `proxy_selector` must outlive this.
+  NaiveProxyRacer(HttpNetworkSession* session,
+                  NaiveProxySelector* proxy_selector,
+                  const NetworkTrafficAnnotationTag& traffic_annotation);
+  ~NaiveProxyRacer() override;
+  NaiveProxyRacer(const NaiveProxyRacer&) = delete;
+  NaiveProxyRacer& operator=(const NaiveProxyRacer&) = delete;
+
+  // Races the chains again now rather than at the next interval, as when the
+  // network got much slower or faster.
+  void RaceNow();
+
+  // Names the current network by its connection type and Wi-Fi SSID.
+  static std::string GetCurrentNetwork();
+
+ private:
+  class Race;
+
+  // NetworkChangeNotifier::NetworkChangeObserver:
+  void OnNetworkChanged(NetworkChangeNotifier::ConnectionType type) override;
+
+  void StartRaces();
+
+  // Referenced by the connect jobs of the races.
+  const CommonConnectJobParams common_connect_job_params_;
+  NetLogWithSource net_log_;
+  std::vector<std::unique_ptr<Race>> races_;
+  // The network the races were last run on.
+  std::string network_;
+  base::RepeatingTimer race_timer_;
+
+  base::WeakPtrFactory<NaiveProxyRacer> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_PROXY_RACER_H_
@@ -0,0 +1,405 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_proxy_selector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#include "base/check.h"
+#include "base/logging.h"
+#include "base/trace_event/base_tracing.h"
+#include "net/base/net_errors.h"
+#include "net/http/proxy_fallback.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+
+namespace net {
+namespace {
+constexpr base::TimeDelta kMinBackoff = base::Seconds(5);
+constexpr base::TimeDelta kMaxBackoff = base::Minutes(5);
+// Weight of a new sample in the smoothed connect time, as for TCP SRTT.
+constexpr int kConnectTimeSmoothing = 8;
+// Packets a session sends before its loss rate is sampled again.
+constexpr uint64_t kLossSamplePackets = 1000;
+constexpr int kLossSmoothing = 4;
+// A session is avoided once its loss rate is both above kMinLossyRate and
+// kLossyRateMargin above that of the best other session of the chain.
+constexpr double kMinLossyRate = 0.02;
+constexpr double kLossyRateMargin = 0.02;
+}  // namespace
+
+std::optional<ProxySelection> ParseProxySelection(std::string_view str) {
+  if (str == "weighted") {
+    return ProxySelection::kWeighted;
+  } else if (str == "least-conn") {
+    return ProxySelection::kLeastConnections;
+  } else if (str == "lowest-latency") {
+    return ProxySelection::kLowestLatency;
+  }
+  return std::nullopt;
+}
+
+NaiveProxySelector::ChainState::ChainState() = default;
+
+NaiveProxySelector::ChainState::ChainState(ChainState&&) = default;
+
+NaiveProxySelector::ChainState::~ChainState() = default;
+
+NaiveProxySelector::NaiveProxySelector(
+    const std::vector<NaiveProxyChainConfig>& chains,
+    ProxySelection selection,
+    int max_sessions,
+    bool adaptive_sessions,
+    bool class_sessions,
+    scoped_refptr<NaiveUplinks> uplinks,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : uplinks_(std::move(uplinks)),
+      selection_(selection),
+      adaptive_sessions_(adaptive_sessions),
+      next_tie_break_(0) {
+  DCHECK(!chains.empty());
+  DCHECK_GE(max_sessions, 1);
+  for (int i = 0; i < max_sessions; ++i) {
+    ClassKeys& keys = network_anonymization_keys_.emplace_back();
+    keys.fill(NetworkAnonymizationKey::CreateTransient());
+    if (class_sessions) {
+      for (NetworkAnonymizationKey& key : keys)
+        key = NetworkAnonymizationKey::CreateTransient();
+    }
+    if (uplinks_) {
+      size_t uplink = static_cast<size_t>(i) % uplinks_->size();
+      for (const NetworkAnonymizationKey& key : keys)
+        uplinks_->SetKeyUplink(key, uplink);
+    }
+  }
+  for (const NaiveProxyChainConfig& chain : chains) {
+    ProxyInfo& proxy_info = proxy_infos_.emplace_back();
+    proxy_info.UseProxyChain(chain.chain);
+    proxy_info.set_traffic_annotation(
+        MutableNetworkTrafficAnnotationTag(traffic_annotation));
+    ProxyInfo& quic_proxy_info = quic_proxy_infos_.emplace_back();
+    if (chain.quic_chain.IsValid()) {
+      quic_proxy_info.UseProxyChain(chain.quic_chain);
+      quic_proxy_info.set_traffic_annotation(
+          MutableNetworkTrafficAnnotationTag(traffic_annotation));
+    }
+    ChainState& state = states_.emplace_back();
+    state.weight = chain.weight;
+    state.session_connections.resize(max_sessions);
+    state.session_losses.resize(max_sessions);
+    state.open_sessions = adaptive_sessions_ ? 1 : max_sessions;
+  }
+}
+
+NaiveProxySelector::~NaiveProxySelector() {
+  if (!uplinks_)
+    return;
+  for (const ClassKeys& keys : network_anonymization_keys_) {
+    for (const NetworkAnonymizationKey& key : keys)
+      uplinks_->SetKeyUplink(key, std::nullopt);
+  }
+}
+
+NaiveProxySelector::Selection NaiveProxySelector::Select() {
+  TRACE_EVENT("naive", "NaiveProxySelector::Select");
+  size_t index = 0;
+  if (states_.size() > 1) {
+    base::TimeTicks now = base::TimeTicks::Now();
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < states_.size(); ++i) {
+      if (states_[i].down_until <= now)
+        candidates.push_back(i);
+    }
+    // Keeps trying all chains rather than failing every connection.
+    if (candidates.empty()) {
+      for (size_t i = 0; i < states_.size(); ++i)
+        candidates.push_back(i);
+    }
+
+    switch (selection_) {
+      case ProxySelection::kWeighted:
+        index = SelectWeighted(candidates);
+        break;
+      case ProxySelection::kLeastConnections:
+        index = SelectLeastConnections(candidates);
+        break;
+      case ProxySelection::kLowestLatency:
+        index = SelectLowestLatency(candidates);
+        break;
+    }
+    ++next_tie_break_;
+  }
+  ChainState& state = states_[index];
+  size_t session = SelectSession(state);
+  ++state.active_connections;
+  ++state.session_connections[session];
+  return {index, session, state.use_quic};
+}
+
+void NaiveProxySelector::SetUseQuic(size_t chain, bool use_quic) {
+  DCHECK(is_raced(chain));
+  ChainState& state = states_[chain];
+  if (state.use_quic == use_quic)
+    return;
+  state.use_quic = use_quic;
+  // The latencies of the other protocol do not carry over.
+  state.smoothed_connect_time = base::TimeDelta();
+  state.session_rtt = base::TimeDelta();
+  LOG(INFO) << "Proxy chain "
+            << proxy_infos_[chain].proxy_chain().ToDebugString() << " uses "
+            << (use_quic ? "QUIC" : "HTTP/2");
+}
+
+void NaiveProxySelector::OnConnectComplete(const Selection& selection,
+                                           int result,
+                                           base::TimeDelta time) {
+  RecordConnectResult(selection, result, time, kMaxConsecutiveFailures);
+}
+
+void NaiveProxySelector::OnProbeComplete(const Selection& selection,
+                                         int result,
+                                         base::TimeDelta time) {
+  RecordConnectResult(selection, result, time, /*max_failures=*/1);
+}
+
+void NaiveProxySelector::RecordConnectResult(const Selection& selection,
+                                             int result,
+                                             base::TimeDelta time,
+                                             int max_failures) {
+  ChainState& state = states_[selection.chain];
+  const ProxyChain& chain = proxy_info(selection).proxy_chain();
+  if (result == OK) {
+    if (state.down_until > base::TimeTicks()) {
+      LOG(INFO) << "Proxy chain " << chain.ToDebugString() << " is back up";
+    }
+    state.consecutive_failures = 0;
+    state.backoff = base::TimeDelta();
+    state.down_until = base::TimeTicks();
+    if (state.smoothed_connect_time.is_zero()) {
+      state.smoothed_connect_time = time;
+    } else {
+      state.smoothed_connect_time +=
+          (time - state.smoothed_connect_time) / kConnectTimeSmoothing;
+    }
+    return;
+  }
+
+  // Errors of the origin, such as a refused tunnel, say nothing about the
+  // chain.
+  int final_error;
+  if (!CanFalloverToNextProxy(chain, result, &final_error,
+                              chain.is_for_ip_protection())) {
+    return;
+  }
+  // QUIC may be blocked while HTTP/2 to the same proxy works, so the chain
+  // falls back to it before counting failures.
+  if (selection.quic) {
+    if (state.use_quic) {
+      LOG(WARNING) << "Proxy chain " << chain.ToDebugString()
+                   << " failed with " << ErrorToShortString(result)
+                   << ", falling back to HTTP/2";
+      SetUseQuic(selection.chain, false);
+    }
+    return;
+  }
+  if (++state.consecutive_failures < max_failures)
+    return;
+  state.backoff = std::clamp(state.backoff * 2, kMinBackoff, kMaxBackoff);
+  state.down_until = base::TimeTicks::Now() + state.backoff;
+  state.consecutive_failures = 0;
+  LOG(WARNING) << "Proxy chain " << chain.ToDebugString() << " failed with "
+               << ErrorToShortString(result) << ", skipping it for "
+               << state.backoff;
+}
+
+void NaiveProxySelector::OnSessionQuality(
+    const Selection& selection,
+    const StreamSocket::SessionQuality& quality) {
+  ChainState& state = states_[selection.chain];
+  if (!quality.smoothed_rtt.is_zero())
+    state.session_rtt = quality.smoothed_rtt;
+  if (quality.packets_sent > 0)
+    UpdateSessionLoss(state, selection.session, quality);
+}
+
+void NaiveProxySelector::UpdateSessionLoss(
+    ChainState& state,
+    size_t session,
+    const StreamSocket::SessionQuality& quality) {
+  SessionLoss& loss = state.session_losses[session];
+  // The counts start over when the key gets a new session.
+  if (quality.packets_sent < loss.packets_sent ||
+      quality.packets_lost < loss.packets_lost) {
+    loss = SessionLoss();
+  }
+  uint64_t sent = quality.packets_sent - loss.packets_sent;
+  if (sent < kLossSamplePackets)
+    return;
+  double rate =
+      static_cast<double>(quality.packets_lost - loss.packets_lost) / sent;
+  loss.packets_sent = quality.packets_sent;
+  loss.packets_lost = quality.packets_lost;
+  if (loss.loss_rate < 0) {
+    loss.loss_rate = rate;
+  } else {
+    loss.loss_rate += (rate - loss.loss_rate) / kLossSmoothing;
+  }
+
+  double best_other_rate = -1;
+  for (size_t i = 0; i < state.open_sessions; ++i) {
+    const SessionLoss& other = state.session_losses[i];
+    if (i == session || other.loss_rate < 0)
+      continue;
+    if (best_other_rate < 0 || other.loss_rate < best_other_rate)
+      best_other_rate = other.loss_rate;
+  }
+  if (best_other_rate < 0 || loss.loss_rate < kMinLossyRate ||
+      loss.loss_rate < best_other_rate + kLossyRateMargin) {
+    return;
+  }
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (loss.avoid_until > now)
+    return;
+  loss.avoid_until = now + kLossyAvoidTime;
+  LOG(INFO) << "Tunnel session " << session << " loses "
+            << static_cast<int>(loss.loss_rate * 100) << "% of packets, "
+            << "avoiding it for " << kLossyAvoidTime;
+}
+
+void NaiveProxySelector::OnConnectionClosed(const Selection& selection) {
+  ChainState& state = states_[selection.chain];
+  DCHECK_GT(state.active_connections, 0);
+  DCHECK_GT(state.session_connections[selection.session], 0);
+  --state.active_connections;
+  if (--state.session_connections[selection.session] == 0 &&
+      selection.session + 1 == state.open_sessions) {
+    state.last_session_idle_time = base::TimeTicks::Now();
+  }
+}
+
+bool NaiveProxySelector::HasActiveConnections() const {
+  for (const ChainState& state : states_) {
+    if (state.active_connections > 0)
+      return true;
+  }
+  return false;
+}
+
+size_t NaiveProxySelector::SelectSession(ChainState& state) {
+  if (adaptive_sessions_) {
+    // Stops using an idle last session. Its key is taken up again if the
+    // load comes back.
+    if (state.open_sessions > 1 &&
+        state.session_connections[state.open_sessions - 1] == 0 &&
+        base::TimeTicks::Now() - state.last_session_idle_time >=
+            kSessionIdleTime) {
+      --state.open_sessions;
+      // Gives the new last session its own idle time.
+      state.last_session_idle_time = base::TimeTicks::Now();
+      VLOG(1) << "Tunnel sessions decreased to " << state.open_sessions;
+    }
+  }
+
+  // Ties go to the first sessions, so later ones drain when load drops.
+  // Lossy sessions are only used if all are.
+  base::TimeTicks now = base::TimeTicks::Now();
+  std::optional<size_t> best;
+  for (size_t i = 0; i < state.open_sessions; ++i) {
+    if (state.session_losses[i].avoid_until > now)
+      continue;
+    if (!best || IsLessLoaded(state, i, *best))
+      best = i;
+  }
+  bool all_lossy = !best;
+  if (all_lossy) {
+    best = 0;
+    for (size_t i = 1; i < state.open_sessions; ++i) {
+      if (IsLessLoaded(state, i, *best))
+        best = i;
+    }
+  }
+
+  if (adaptive_sessions_ &&
+      (all_lossy ||
+       state.session_connections[*best] >= session_stream_target_) &&
+      state.open_sessions < state.session_connections.size()) {
+    best = state.open_sessions++;
+    VLOG(1) << "Tunnel sessions increased to " << state.open_sessions;
+  }
+  return *best;
+}
+
+bool NaiveProxySelector::IsLessLoaded(const ChainState& state,
+                                      size_t a,
+                                      size_t b) const {
+  if (!uplinks_)
+    return state.session_connections[a] < state.session_connections[b];
+  // Compares (connections + 1) / weight without division, so the next
+  // connection goes where it leaves the least per weight.
+  int64_t weight_a = uplinks_->GetWeight(a % uplinks_->size());
+  int64_t weight_b = uplinks_->GetWeight(b % uplinks_->size());
+  return (state.session_connections[a] + 1) * weight_b <
+         (state.session_connections[b] + 1) * weight_a;
+}
+
+size_t NaiveProxySelector::SelectWeighted(
+    const std::vector<size_t>& candidates) {
+  int total_weight = 0;
+  size_t best = candidates.front();
+  for (size_t i : candidates) {
+    ChainState& state = states_[i];
+    state.current_weight += state.weight;
+    total_weight += state.weight;
+    if (state.current_weight > states_[best].current_weight)
+      best = i;
+  }
+  states_[best].current_weight -= total_weight;
+  return best;
+}
+
+size_t NaiveProxySelector::SelectLeastConnections(
+    const std::vector<size_t>& candidates) const {
+  size_t best = candidates[next_tie_break_ % candidates.size()];
+  for (size_t i : candidates) {
+    const ChainState& state = states_[i];
+    const ChainState& best_state = states_[best];
+    // Compares active_connections / weight without division.
+    if (int64_t{state.active_connections} * best_state.weight <
+        int64_t{best_state.active_connections} * state.weight) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+size_t NaiveProxySelector::SelectLowestLatency(
+    const std::vector<size_t>& candidates) const {
+  size_t best = candidates[next_tie_break_ % candidates.size()];
+  double best_cost = 0;
+  bool has_best_cost = false;
+  for (size_t i : candidates) {
+    const ChainState& state = states_[i];
+    // Chains that have not connected yet are tried first to measure them.
+    if (state.smoothed_connect_time.is_zero()) {
+      if (states_[best].smoothed_connect_time.is_zero())
+        return best;
+      return i;
+    }
+    // A tunnel connect on an open session takes about one RTT, so the two
+    // compare across chains.
+    base::TimeDelta latency = state.session_rtt.is_zero()
+                                  ? state.smoothed_connect_time
+                                  : state.session_rtt;
+    double cost = latency.InMicrosecondsF() * (state.active_connections + 1) /
+                  state.weight;
+    if (!has_best_cost || cost < best_cost) {
+      best = i;
+      best_cost = cost;
+      has_best_cost = true;
+    }
+  }
+  return best;
+}
+
+}  // namespace net
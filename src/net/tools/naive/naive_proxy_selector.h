@@ -0,0 +1,241 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_PROXY_SELECTOR_H_
+#define NET_TOOLS_NAIVE_NAIVE_PROXY_SELECTOR_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/time/time.h"
+#include "net/base/network_anonymization_key.h"
+#include "net/base/proxy_chain.h"
+#include "net/proxy_resolution/proxy_info.h"
+#include "net/socket/stream_socket.h"
+#include "net/tools/naive/naive_priority_rules.h"
+#include "net/tools/naive/naive_uplinks.h"
+
+namespace net {
+
+struct NetworkTrafficAnnotationTag;
+
+enum class ProxySelection {
+  // Smooth weighted round robin.
+  kWeighted,
+  // Fewest active connections per weight.
+  kLeastConnections,
+  // Lowest smoothed RTT of the tunnel sessions, or tunnel connect time if
+  // not sampled, scaled by active connections per weight so one fast chain
+  // is not flooded.
+  kLowestLatency,
+};
+
+std::optional<ProxySelection> ParseProxySelection(std::string_view str);
+
+struct NaiveProxyChainConfig {
+  // The last server is assumed to be Naive.
+  ProxyChain chain = ProxyChain::Direct();
+  // For an HTTPS proxy raced against QUIC, the QUIC chain to the same
+  // server. Invalid otherwise.
+  ProxyChain quic_chain;
+  int weight = 1;
+};
+
+// Chooses the proxy chain and the tunnel session of each new connection of a
+// thread. A chain whose tunnels keep failing for reasons of the proxy, or
+// whose health probe fails, is skipped for a backoff period, unless all
+// chains are.
+//
+// Tunnels of a chain are spread over up to `max_sessions` tunnel sessions,
+// told apart by transient NetworkAnonymizationKeys. Each connection goes to
+// the session of the chain with the fewest active connections. In adaptive
+// mode a chain starts with one session and opens the next one once all of
+// its sessions carry kSessionStreamTarget connections, or the target set
+// since, well below the usual limit of 100 concurrent HTTP/2 streams. The
+// last session stops taking new connections after kSessionIdleTime without
+// any. The keys are reused, so
+// at most `max_sessions` sessions per chain are ever opened.
+//
+// With `class_sessions`, each session is split into one per priority class,
+// so the sessions of interactive tunnels can be marked apart from bulk ones.
+// The split sessions are counted as one for the above.
+//
+// Sessions that count lost packets, as QUIC ones do, are compared by their
+// recent loss rate. A session losing clearly more than the others of its
+// chain, as when an ISP polices its flow, takes no new connections for
+// kLossyAvoidTime, so they go to the other sessions. It is sampled again
+// when taken back.
+//
+// With `uplinks`, session i of each chain goes over uplink i modulo their
+// number, and each connection goes to the session with the fewest active
+// connections per weight of its uplink instead.
+//
+// A chain with a `quic_chain` sends its tunnels over QUIC or over HTTP/2 to
+// the same proxy, as NaiveProxyRacer decides. It falls back to HTTP/2 as
+// soon as a tunnel over QUIC fails because of the proxy, as when UDP is
+// blocked.
+class NaiveProxySelector {
+ public:
+  static constexpr int kMaxWeight = 1000;
+  // Failures in a row of tunnels after which a chain is skipped.
+  static constexpr int kMaxConsecutiveFailures = 3;
+  static constexpr int kSessionStreamTarget = 64;
+  static constexpr base::TimeDelta kSessionIdleTime = base::Seconds(30);
+  static constexpr base::TimeDelta kLossyAvoidTime = base::Seconds(30);
+
+  struct Selection {
+    size_t chain = 0;
+    size_t session = 0;
+    // Over the QUIC chain of a raced chain.
+    bool quic = false;
+  };
+
+  // The keys of the sessions of a Selection, indexed by TunnelPriority.
+  using ClassKeys = std::array<NetworkAnonymizationKey, kNumTunnelPriorities>;
+
+  NaiveProxySelector(const std::vector<NaiveProxyChainConfig>& chains,
+                     ProxySelection selection,
+                     int max_sessions,
+                     bool adaptive_sessions,
+                     bool class_sessions,
+                     scoped_refptr<NaiveUplinks> uplinks,
+                     const NetworkTrafficAnnotationTag& traffic_annotation);
+  ~NaiveProxySelector();
+  NaiveProxySelector(const NaiveProxySelector&) = delete;
+  NaiveProxySelector& operator=(const NaiveProxySelector&) = delete;
+
+  // Returns the chain and session for a new connection and counts the
+  // connection as active on them.
+  Selection Select();
+
+  // These stay valid for the lifetime of the selector.
+  const ProxyInfo& proxy_info(const Selection& selection) const {
+    return selection.quic ? quic_proxy_infos_[selection.chain]
+                          : proxy_infos_[selection.chain];
+  }
+  // The key of the session of the default class.
+  const NetworkAnonymizationKey& network_anonymization_key(
+      const Selection& selection) const {
+    return network_anonymization_keys_[selection.session]
+        [static_cast<size_t>(TunnelPriority::kDefault)];
+  }
+  const ClassKeys& class_network_anonymization_keys(
+      const Selection& selection) const {
+    return network_anonymization_keys_[selection.session];
+  }
+
+  // Records the result and duration of connecting a tunnel.
+  void OnConnectComplete(const Selection& selection,
+                         int result,
+                         base::TimeDelta time);
+  // Records the result and duration of a health probe, a tunnel opened only
+  // to check the chain and not counted as active. A probe that fails
+  // because of the proxy skips the chain at once rather than after
+  // kMaxConsecutiveFailures, and one that succeeds brings it back.
+  void OnProbeComplete(const Selection& selection,
+                       int result,
+                       base::TimeDelta time);
+  // Records the estimates of the session a tunnel of the chain is carried
+  // over. Its smoothed RTT replaces the connect time for kLowestLatency, and
+  // its packet counts update the loss rate of the session.
+  void OnSessionQuality(const Selection& selection,
+                        const StreamSocket::SessionQuality& quality);
+  // Counts a connection from Select() as no longer active.
+  void OnConnectionClosed(const Selection& selection);
+
+  // Whether `chain` races QUIC against HTTP/2, and which one its new
+  // connections use.
+  bool is_raced(size_t chain) const {
+    return !quic_proxy_infos_[chain].is_empty();
+  }
+  bool uses_quic(size_t chain) const { return states_[chain].use_quic; }
+  void SetUseQuic(size_t chain, bool use_quic);
+
+  // Sets the connections per session beyond which adaptive mode opens the
+  // next session. Open sessions are kept as they are.
+  void set_session_stream_target(int target) {
+    session_stream_target_ = target;
+  }
+
+  size_t num_chains() const { return states_.size(); }
+  // Returns true while a connection from Select() is active.
+  bool HasActiveConnections() const;
+  // Active connections of each tunnel session of `chain`.
+  const std::vector<int>& session_connections(size_t chain) const {
+    return states_[chain].session_connections;
+  }
+
+ private:
+  struct SessionLoss {
+    // Packet counts at the start of the current sample.
+    uint64_t packets_sent = 0;
+    uint64_t packets_lost = 0;
+    // Smoothed loss rate of the samples, or negative before the first.
+    double loss_rate = -1;
+    // Until when the session takes no new connections.
+    base::TimeTicks avoid_until;
+  };
+
+  struct ChainState {
+    ChainState();
+    ChainState(ChainState&&);
+    ~ChainState();
+
+    int weight = 1;
+    int active_connections = 0;
+    // Active connections of each session.
+    std::vector<int> session_connections;
+    std::vector<SessionLoss> session_losses;
+    // Sessions taking new connections, a prefix of `session_connections`.
+    size_t open_sessions = 1;
+    // When the last open session last became empty.
+    base::TimeTicks last_session_idle_time;
+    // Zero until the first tunnel connects.
+    base::TimeDelta smoothed_connect_time;
+    // Smoothed RTT of the last session reported, or zero.
+    base::TimeDelta session_rtt;
+    int consecutive_failures = 0;
+    base::TimeDelta backoff;
+    base::TimeTicks down_until;
+    // For smooth weighted round robin.
+    int current_weight = 0;
+    // For raced chains.
+    bool use_quic = false;
+  };
+
+  void RecordConnectResult(const Selection& selection,
+                           int result,
+                           base::TimeDelta time,
+                           int max_failures);
+  size_t SelectWeighted(const std::vector<size_t>& candidates);
+  size_t SelectLeastConnections(const std::vector<size_t>& candidates) const;
+  size_t SelectLowestLatency(const std::vector<size_t>& candidates) const;
+  size_t SelectSession(ChainState& state);
+  // Whether session `a` of `state` takes a new connection before `b`.
+  bool IsLessLoaded(const ChainState& state, size_t a, size_t b) const;
+  void UpdateSessionLoss(ChainState& state,
+                         size_t session,
+                         const StreamSocket::SessionQuality& quality);
+
+  std::vector<ProxyInfo> proxy_infos_;
+  // Empty for chains that are not raced.
+  std::vector<ProxyInfo> quic_proxy_infos_;
+  std::vector<ChainState> states_;
+  // The same key for all classes without `class_sessions`.
+  std::vector<ClassKeys> network_anonymization_keys_;
+  // Null without uplinks.
+  const scoped_refptr<NaiveUplinks> uplinks_;
+  const ProxySelection selection_;
+  const bool adaptive_sessions_;
+  int session_stream_target_ = kSessionStreamTarget;
+  // Rotates the order in which ties are broken.
+  size_t next_tie_break_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_PROXY_SELECTOR_H_
@@ -0,0 +1,90 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_quality_adapter.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "net/http/http_network_session.h"
+#include "net/nqe/network_quality.h"
+#include "net/nqe/network_quality_estimator.h"
+#include "net/spdy/spdy_session_pool.h"
+#include "net/tools/naive/naive_proxy_racer.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+
+namespace net {
+
+NaiveQualityAdapter::NaiveQualityAdapter(NetworkQualityEstimator* estimator,
+                                         HttpNetworkSession* session,
+                                         NaiveProxySelector* proxy_selector,
+                                         NaiveProxyRacer* proxy_racer,
+                                         int32_t max_auto_window)
+    : estimator_(estimator),
+      session_(session),
+      proxy_selector_(proxy_selector),
+      proxy_racer_(proxy_racer),
+      max_auto_window_(max_auto_window > 0
+                           ? std::max(max_auto_window, kMinAutoWindow)
+                           : kDefaultMaxAutoWindow),
+      session_stream_target_(NaiveProxySelector::kSessionStreamTarget) {
+  estimator_->AddRTTAndThroughputEstimatesObserver(this);
+}
+
+NaiveQualityAdapter::~NaiveQualityAdapter() {
+  estimator_->RemoveRTTAndThroughputEstimatesObserver(this);
+}
+
+void NaiveQualityAdapter::OnRTTOrThroughputEstimatesComputed(
+    base::TimeDelta http_rtt,
+    base::TimeDelta transport_rtt,
+    int32_t downstream_throughput_kbps) {
+  if (transport_rtt == nqe::internal::InvalidRTT() ||
+      !transport_rtt.is_positive()) {
+    return;
+  }
+
+  int target = NaiveProxySelector::kSessionStreamTarget;
+  if (transport_rtt > kReferenceRtt) {
+    target = std::max(
+        kMinSessionStreamTarget,
+        static_cast<int>(target * (kReferenceRtt / transport_rtt)));
+  }
+  if (target != session_stream_target_) {
+    session_stream_target_ = target;
+    proxy_selector_->set_session_stream_target(target);
+    VLOG(1) << "Session stream target " << target << " at transport RTT "
+            << transport_rtt;
+  }
+
+  if (downstream_throughput_kbps != nqe::internal::INVALID_RTT_THROUGHPUT) {
+    double bdp_bytes = downstream_throughput_kbps * 1000.0 / 8 *
+                       transport_rtt.InSecondsF();
+    int32_t window = static_cast<int32_t>(
+        std::clamp<double>(2 * bdp_bytes, kMinAutoWindow, max_auto_window_));
+    if (window != auto_window_) {
+      auto_window_ = window;
+      session_->spdy_session_pool()->set_max_auto_tuned_recv_window_size(
+          window);
+      VLOG(1) << "HTTP/2 auto-tuned window " << window << " at "
+              << downstream_throughput_kbps << " kbps";
+    }
+  }
+
+  if (!proxy_racer_)
+    return;
+  if (race_rtt_.is_zero()) {
+    // The first race was started with the racer.
+    race_rtt_ = transport_rtt;
+    return;
+  }
+  if (transport_rtt >= race_rtt_ * kRaceRttFactor ||
+      transport_rtt * kRaceRttFactor <= race_rtt_) {
+    LOG(INFO) << "Transport RTT changed from " << race_rtt_ << " to "
+              << transport_rtt << ", racing QUIC against HTTP/2 again";
+    race_rtt_ = transport_rtt;
+    proxy_racer_->RaceNow();
+  }
+}
+
+}  // namespace net
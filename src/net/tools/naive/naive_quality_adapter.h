@@ -0,0 +1,71 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_QUALITY_ADAPTER_H_
+#define NET_TOOLS_NAIVE_NAIVE_QUALITY_ADAPTER_H_
+
+#include <cstdint>
+
+#include "base/time/time.h"
+#include "net/nqe/rtt_throughput_estimates_observer.h"
+
+namespace net {
+
+class HttpNetworkSession;
+class NaiveProxyRacer;
+class NaiveProxySelector;
+class NetworkQualityEstimator;
+
+// Adapts the tunnel sessions of an IO thread to the estimates of the
+// NetworkQualityEstimator of its context, instead of tuning them by hand for
+// each network. The transport RTT is estimated from the TCP and QUIC
+// connections of the context. The throughput is only estimated from its own
+// requests, such as DNS-over-HTTPS queries, as tunnels are not URLRequests.
+//
+// - Adaptive sessions take fewer tunnels each as the transport RTT grows
+//   above kReferenceRtt, down to kMinSessionStreamTarget, so a long path
+//   spreads tunnels over more sessions, each with its own congestion window.
+// - HTTP/2 receive windows of new sessions auto-tune up to twice the
+//   bandwidth-delay product, within kMinAutoWindow and `max_auto_window`,
+//   or kDefaultMaxAutoWindow if zero, once the throughput is estimated.
+// - Raced chains race QUIC against HTTP/2 again once the transport RTT is
+//   kRaceRttFactor times larger or smaller than at the last race.
+class NaiveQualityAdapter : public RTTAndThroughputEstimatesObserver {
+ public:
+  static constexpr base::TimeDelta kReferenceRtt = base::Milliseconds(100);
+  static constexpr int kMinSessionStreamTarget = 16;
+  static constexpr int32_t kMinAutoWindow = 1 << 20;
+  static constexpr int32_t kDefaultMaxAutoWindow = 32 << 20;
+  static constexpr int kRaceRttFactor = 2;
+
+  // The pointers must outlive this. `proxy_racer` may be null.
+  NaiveQualityAdapter(NetworkQualityEstimator* estimator,
+                      HttpNetworkSession* session,
+                      NaiveProxySelector* proxy_selector,
+                      NaiveProxyRacer* proxy_racer,
+                      int32_t max_auto_window);
+  ~NaiveQualityAdapter() override;
+  NaiveQualityAdapter(const NaiveQualityAdapter&) = delete;
+  NaiveQualityAdapter& operator=(const NaiveQualityAdapter&) = delete;
+
+  // RTTAndThroughputEstimatesObserver:
+  void OnRTTOrThroughputEstimatesComputed(
+      base::TimeDelta http_rtt,
+      base::TimeDelta transport_rtt,
+      int32_t downstream_throughput_kbps) override;
+
+ private:
+  NetworkQualityEstimator* const estimator_;
+  HttpNetworkSession* const session_;
+  NaiveProxySelector* const proxy_selector_;
+  NaiveProxyRacer* const proxy_racer_;
+  const int32_t max_auto_window_;
+
+  int session_stream_target_;
+  int32_t auto_window_ = 0;
+  // The transport RTT at the last race, or zero.
+  base::TimeDelta race_rtt_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_QUALITY_ADAPTER_H_
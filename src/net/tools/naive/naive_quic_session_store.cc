@@ -0,0 +1,239 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_quic_session_store.h"
+
+#include <optional>
+#include <utility>
+
+#include "base/base64.h"
+#include "base/files/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/memory/raw_ptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "net/third_party/quiche/src/quiche/quic/core/crypto/transport_parameters.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_versions.h"
+
+namespace net {
+namespace {
+constexpr int kFileVersion = 1;
+
+class StoreSessionCache : public quic::QuicClientSessionCache {
+ public:
+  explicit StoreSessionCache(NaiveQuicSessionStore* store) : store_(store) {}
+
+  void Insert(const quic::QuicServerId& server_id,
+              bssl::UniquePtr<SSL_SESSION> session,
+              const quic::TransportParameters& params,
+              const quic::ApplicationState* application_state) override {
+    store_->Save(server_id, session.get(), params, application_state);
+  }
+
+  std::unique_ptr<quic::QuicResumptionState> Lookup(
+      const quic::QuicServerId& server_id,
+      quic::QuicWallTime now,
+      const SSL_CTX* ctx) override {
+    return store_->Take(server_id, now, ctx);
+  }
+
+ private:
+  raw_ptr<NaiveQuicSessionStore> store_;
+};
+}  // namespace
+
+NaiveQuicSessionStore::Entry::Entry() = default;
+
+NaiveQuicSessionStore::Entry::Entry(Entry&&) = default;
+
+NaiveQuicSessionStore::Entry& NaiveQuicSessionStore::Entry::operator=(
+    Entry&&) = default;
+
+NaiveQuicSessionStore::Entry::~Entry() = default;
+
+NaiveQuicSessionStore::NaiveQuicSessionStore(const base::FilePath& path)
+    : path_(path), writer_(path) {}
+
+NaiveQuicSessionStore::~NaiveQuicSessionStore() = default;
+
+// static
+std::string NaiveQuicSessionStore::ServerKey(
+    const quic::QuicServerId& server_id) {
+  std::string key = server_id.ToHostPortString();
+  if (server_id.privacy_mode_enabled())
+    key += "/private";
+  return key;
+}
+
+size_t NaiveQuicSessionStore::Load() {
+  std::string data;
+  if (!base::ReadFileToString(path_, &data))
+    return 0;
+  std::optional<base::Value::Dict> dict = base::JSONReader::ReadDict(data);
+  if (!dict || dict->FindInt("version") != kFileVersion) {
+    LOG(WARNING) << "Ignoring invalid QUIC session file " << path_;
+    return 0;
+  }
+  const base::Value::Dict* servers = dict->FindDict("servers");
+  if (!servers)
+    return 0;
+
+  uint64_t now = static_cast<uint64_t>(base::Time::Now().ToTimeT());
+  size_t count = 0;
+  base::AutoLock lock(lock_);
+  for (const auto [key, list] : *servers) {
+    if (!list.is_list())
+      continue;
+    std::vector<Entry>& entries = entries_[key];
+    for (const base::Value& value : list.GetList()) {
+      const base::Value::Dict* entry_dict = value.GetIfDict();
+      if (!entry_dict)
+        continue;
+      const std::string* session = entry_dict->FindString("session");
+      const std::string* params = entry_dict->FindString("params");
+      const std::string* expiration = entry_dict->FindString("expiration");
+      const std::string* application_state =
+          entry_dict->FindString("application_state");
+      Entry entry;
+      if (!session || !params || !expiration ||
+          !base::Base64Decode(*session, &entry.session) ||
+          !base::Base64Decode(*params, &entry.params) ||
+          !base::StringToUint64(*expiration, &entry.expiration)) {
+        continue;
+      }
+      if (application_state) {
+        if (!base::Base64Decode(*application_state, &entry.application_state))
+          continue;
+        entry.has_application_state = true;
+      }
+      if (entry.expiration <= now ||
+          entries.size() >= kMaxSessionsPerServer) {
+        continue;
+      }
+      entries.push_back(std::move(entry));
+      ++count;
+    }
+    if (entries.empty())
+      entries_.erase(key);
+  }
+  LOG(INFO) << "Loaded " << count << " QUIC session tickets from " << path_;
+  loaded_sessions_ = count > 0;
+  return count;
+}
+
+std::unique_ptr<quic::QuicClientSessionCache>
+NaiveQuicSessionStore::CreateSessionCache() {
+  return std::make_unique<StoreSessionCache>(this);
+}
+
+void NaiveQuicSessionStore::Save(
+    const quic::QuicServerId& server_id,
+    const SSL_SESSION* session,
+    const quic::TransportParameters& params,
+    const quic::ApplicationState* application_state) {
+  Entry entry;
+  uint8_t* session_bytes = nullptr;
+  size_t session_size = 0;
+  if (!SSL_SESSION_to_bytes(session, &session_bytes, &session_size))
+    return;
+  entry.session.assign(reinterpret_cast<const char*>(session_bytes),
+                       session_size);
+  OPENSSL_free(session_bytes);
+  std::vector<uint8_t> params_bytes;
+  if (!quic::SerializeTransportParameters(params, &params_bytes))
+    return;
+  entry.params.assign(params_bytes.begin(), params_bytes.end());
+  if (application_state) {
+    entry.has_application_state = true;
+    entry.application_state.assign(application_state->begin(),
+                                   application_state->end());
+  }
+  entry.expiration =
+      SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session);
+
+  base::AutoLock lock(lock_);
+  std::vector<Entry>& entries = entries_[ServerKey(server_id)];
+  if (entries.size() >= kMaxSessionsPerServer)
+    entries.erase(entries.begin());
+  entries.push_back(std::move(entry));
+  WriteLocked();
+}
+
+std::unique_ptr<quic::QuicResumptionState> NaiveQuicSessionStore::Take(
+    const quic::QuicServerId& server_id,
+    quic::QuicWallTime now,
+    const SSL_CTX* ctx) {
+  base::AutoLock lock(lock_);
+  auto it = entries_.find(ServerKey(server_id));
+  if (it == entries_.end())
+    return nullptr;
+  std::vector<Entry>& entries = it->second;
+  std::unique_ptr<quic::QuicResumptionState> state;
+  while (!entries.empty() && !state) {
+    Entry entry = std::move(entries.back());
+    entries.pop_back();
+    if (entry.expiration <= now.ToUNIXSeconds())
+      continue;
+
+    bssl::UniquePtr<SSL_SESSION> session(SSL_SESSION_from_bytes(
+        reinterpret_cast<const uint8_t*>(entry.session.data()),
+        entry.session.size(), ctx));
+    if (!session)
+      continue;
+    auto params = std::make_unique<quic::TransportParameters>();
+    std::string error_details;
+    // Proxy sessions only use RFC v1.
+    if (!quic::ParseTransportParameters(
+            quic::ParsedQuicVersion::RFCv1(), quic::Perspective::IS_SERVER,
+            reinterpret_cast<const uint8_t*>(entry.params.data()),
+            entry.params.size(), params.get(), &error_details)) {
+      continue;
+    }
+    quic::DegreaseTransportParameters(*params);
+
+    state = std::make_unique<quic::QuicResumptionState>();
+    state->tls_session = std::move(session);
+    state->transport_params = std::move(params);
+    if (entry.has_application_state) {
+      state->application_state = std::make_unique<quic::ApplicationState>(
+          entry.application_state.begin(), entry.application_state.end());
+    }
+  }
+  if (entries.empty())
+    entries_.erase(it);
+  WriteLocked();
+  return state;
+}
+
+void NaiveQuicSessionStore::WriteLocked() {
+  if (path_.empty())
+    return;
+  base::Value::Dict servers;
+  for (const auto& [key, entries] : entries_) {
+    base::Value::List list;
+    for (const Entry& entry : entries) {
+      base::Value::Dict entry_dict;
+      entry_dict.Set("session", base::Base64Encode(entry.session));
+      entry_dict.Set("params", base::Base64Encode(entry.params));
+      if (entry.has_application_state) {
+        entry_dict.Set("application_state",
+                       base::Base64Encode(entry.application_state));
+      }
+      entry_dict.Set("expiration", base::NumberToString(entry.expiration));
+      list.Append(std::move(entry_dict));
+    }
+    servers.Set(key, std::move(list));
+  }
+  base::Value::Dict dict;
+  dict.Set("version", kFileVersion);
+  dict.Set("servers", std::move(servers));
+
+  std::string data;
+  base::JSONWriter::Write(dict, &data);
+  writer_.Write(std::move(data));
+}
+
+}  // namespace net
@@ -0,0 +1,93 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_QUIC_SESSION_STORE_H_
+#define NET_TOOLS_NAIVE_NAIVE_QUIC_SESSION_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "net/third_party/quiche/src/quiche/quic/core/crypto/quic_client_session_cache.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_server_id.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_types.h"
+#include "net/tools/naive/naive_file_writer.h"
+#include "third_party/boringssl/src/include/openssl/ssl.h"
+
+namespace net {
+
+// Keeps the TLS session tickets of QUIC proxy sessions in a file, with the
+// transport parameters and the HTTP/3 settings that 0-RTT needs, so the
+// first sessions after a restart resume instead of doing a full handshake.
+//
+// The session caches of all IO threads keep their tickets here, so a ticket
+// from any thread resumes a session on any other, and none is used twice,
+// as TLS 1.3 expects. Up to kMaxSessionsPerServer tickets are kept per
+// server, and the file is rewritten whenever they change. With an empty
+// path, the tickets are only shared between the IO threads.
+class NaiveQuicSessionStore {
+ public:
+  static constexpr size_t kMaxSessionsPerServer = 4;
+
+  explicit NaiveQuicSessionStore(const base::FilePath& path);
+  ~NaiveQuicSessionStore();
+  NaiveQuicSessionStore(const NaiveQuicSessionStore&) = delete;
+  NaiveQuicSessionStore& operator=(const NaiveQuicSessionStore&) = delete;
+
+  // Reads the tickets saved in the file that have not expired. Returns
+  // the number of tickets read.
+  size_t Load();
+  // Whether Load() read any tickets.
+  bool loaded_sessions() const { return loaded_sessions_; }
+
+  // Returns a cache for quic::QuicCryptoClientConfig that keeps its tickets
+  // in this store. The store must outlive it.
+  std::unique_ptr<quic::QuicClientSessionCache> CreateSessionCache();
+
+  void Save(const quic::QuicServerId& server_id,
+            const SSL_SESSION* session,
+            const quic::TransportParameters& params,
+            const quic::ApplicationState* application_state);
+  // Returns the newest unexpired ticket of `server_id` and removes it, or
+  // null if there is none.
+  std::unique_ptr<quic::QuicResumptionState> Take(
+      const quic::QuicServerId& server_id,
+      quic::QuicWallTime now,
+      const SSL_CTX* ctx);
+
+ private:
+  struct Entry {
+    Entry();
+    Entry(Entry&&);
+    Entry& operator=(Entry&&);
+    ~Entry();
+
+    std::string session;
+    std::string params;
+    bool has_application_state = false;
+    std::string application_state;
+    // In UNIX seconds.
+    uint64_t expiration = 0;
+  };
+
+  static std::string ServerKey(const quic::QuicServerId& server_id);
+
+  void WriteLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const base::FilePath path_;
+  NaiveFileWriter writer_;
+  bool loaded_sessions_ = false;
+  base::Lock lock_;
+  // Keyed by ServerKey(), oldest first.
+  std::map<std::string, std::vector<Entry>> entries_ GUARDED_BY(lock_);
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_QUIC_SESSION_STORE_H_
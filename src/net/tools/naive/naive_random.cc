@@ -0,0 +1,49 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_random.h"
+
+#include <limits>
+
+#include "base/check_op.h"
+#include "base/containers/span.h"
+#include "base/rand_util.h"
+#include "third_party/abseil-cpp/absl/base/attributes.h"
+
+namespace net {
+
+namespace {
+struct RandomPool {
+  uint64_t values[kRandomPoolSize];
+  int next;
+};
+
+ABSL_CONST_INIT thread_local RandomPool pool = {{}, kRandomPoolSize};
+}  // namespace
+
+uint64_t NaiveRandUint64() {
+  if (pool.next == kRandomPoolSize) {
+    base::RandBytes(base::as_writable_byte_span(pool.values));
+    pool.next = 0;
+  }
+  uint64_t value = pool.values[pool.next];
+  pool.values[pool.next] = 0;
+  ++pool.next;
+  return value;
+}
+
+int NaiveRandInt(int min, int max) {
+  DCHECK_LE(min, max);
+  uint64_t range = static_cast<uint64_t>(max) - static_cast<uint64_t>(min) + 1;
+  // Discards the values above the largest multiple of `range`, which would
+  // make the result non-uniform, as base::RandGenerator() does.
+  uint64_t max_acceptable_value =
+      (std::numeric_limits<uint64_t>::max() / range) * range - 1;
+  uint64_t value;
+  do {
+    value = NaiveRandUint64();
+  } while (value > max_acceptable_value);
+  return static_cast<int>(min + static_cast<int64_t>(value % range));
+}
+
+}  // namespace net
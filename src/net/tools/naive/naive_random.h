@@ -0,0 +1,25 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_RANDOM_H_
+#define NET_TOOLS_NAIVE_NAIVE_RANDOM_H_
+
+#include <cstdint>
+
+namespace net {
+
+// Like base::RandUint64() and base::RandInt(), for the padding sizes and
+// padding headers made for every tunnel and write. Values come from a
+// per-thread pool of kRandomPoolSize values that base::RandBytes() refills
+// in one call once used up, instead of a call to the OS for each value.
+// They are as unpredictable, and each is erased from the pool as it is
+// taken. Not for keys, which should come straight from base::RandBytes().
+inline constexpr int kRandomPoolSize = 64;
+
+uint64_t NaiveRandUint64();
+
+// Returns a uniformly distributed integer in [min, max].
+int NaiveRandInt(int min, int max);
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_RANDOM_H_
@@ -0,0 +1,94 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_rate_limiter.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "base/check_op.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+
+namespace net {
+
+NaiveRateLimiter::NaiveRateLimiter(int64_t rate)
+    : rate_(rate), burst_(base::Seconds(1)) {
+  DCHECK_GT(rate_, 0);
+}
+
+NaiveRateLimiter::~NaiveRateLimiter() = default;
+
+// static
+std::optional<int64_t> NaiveRateLimiter::ParseRate(std::string_view str) {
+  int shift = 0;
+  if (!str.empty()) {
+    switch (str.back()) {
+      case 'k':
+        shift = 10;
+        break;
+      case 'm':
+        shift = 20;
+        break;
+      case 'g':
+        shift = 30;
+        break;
+    }
+    if (shift) {
+      str.remove_suffix(1);
+    }
+  }
+  int64_t value = 0;
+  if (!base::StringToInt64(str, &value) || value <= 0 ||
+      value > (std::numeric_limits<int64_t>::max() >> shift)) {
+    return std::nullopt;
+  }
+  return value << shift;
+}
+
+void NaiveRateLimiter::Consume(Direction from,
+                               int64_t bytes,
+                               base::TimeTicks now) {
+  int64_t now_us = (now - base::TimeTicks()).InMicroseconds();
+  int64_t cost_us = bytes * base::Time::kMicrosecondsPerSecond / rate_;
+  std::atomic<int64_t>& paid_until = paid_until_[from];
+  int64_t old_value = paid_until.load(std::memory_order_relaxed);
+  // An idle bucket starts paying from now, so idle time is not saved up
+  // beyond the burst GetDelay() allows.
+  while (!paid_until.compare_exchange_weak(
+      old_value, std::max(old_value, now_us) + cost_us,
+      std::memory_order_relaxed)) {
+  }
+}
+
+base::TimeDelta NaiveRateLimiter::GetDelay(Direction from,
+                                           base::TimeTicks now) const {
+  base::TimeTicks paid_until =
+      base::TimeTicks() +
+      base::Microseconds(paid_until_[from].load(std::memory_order_relaxed));
+  return std::max(paid_until - now - burst_, base::TimeDelta());
+}
+
+std::optional<NaivePriorityRateLimiters> ParsePriorityRateLimiters(
+    std::string_view str) {
+  NaivePriorityRateLimiters limiters;
+  for (std::string_view limit_str : base::SplitStringPiece(
+           str, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL)) {
+    size_t colon = limit_str.find(':');
+    if (colon == std::string_view::npos) {
+      return std::nullopt;
+    }
+    std::optional<TunnelPriority> priority =
+        ParseTunnelPriority(limit_str.substr(0, colon));
+    std::optional<int64_t> rate =
+        NaiveRateLimiter::ParseRate(limit_str.substr(colon + 1));
+    if (!priority.has_value() || !rate.has_value()) {
+      return std::nullopt;
+    }
+    limiters[static_cast<size_t>(*priority)] =
+        base::MakeRefCounted<NaiveRateLimiter>(*rate);
+  }
+  return limiters;
+}
+
+}  // namespace net
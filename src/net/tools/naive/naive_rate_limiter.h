@@ -0,0 +1,68 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_RATE_LIMITER_H_
+#define NET_TOOLS_NAIVE_NAIVE_RATE_LIMITER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/time/time.h"
+#include "net/tools/naive/naive_priority_rules.h"
+#include "net/tools/naive/naive_protocol.h"
+
+namespace net {
+
+// A token bucket over the bytes relayed in each direction by the tunnels
+// sharing it, which may be on any thread. Kept as the time at which the
+// bytes counted so far are paid for (GCRA), so counting is one
+// compare-and-swap. Tunnels count the bytes they relay, and wait out the
+// delay before reading more, so the sockets they do not read from push
+// back through TCP and HTTP/2 or HTTP/3 flow control.
+class NaiveRateLimiter : public base::RefCountedThreadSafe<NaiveRateLimiter> {
+ public:
+  // Allows `rate` bytes per second in each direction, with bursts of one
+  // second's worth.
+  explicit NaiveRateLimiter(int64_t rate);
+  NaiveRateLimiter(const NaiveRateLimiter&) = delete;
+  NaiveRateLimiter& operator=(const NaiveRateLimiter&) = delete;
+
+  // Parses a rate in bytes per second, with an optional "k", "m" or "g"
+  // suffix for powers of 1024. Returns empty if `str` is invalid.
+  static std::optional<int64_t> ParseRate(std::string_view str);
+
+  int64_t rate() const { return rate_; }
+
+  // Counts `bytes` relayed from `from` at `now`.
+  void Consume(Direction from, int64_t bytes, base::TimeTicks now);
+  // Returns how long `from` should wait at `now` before relaying more, or
+  // zero.
+  base::TimeDelta GetDelay(Direction from, base::TimeTicks now) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<NaiveRateLimiter>;
+  ~NaiveRateLimiter();
+
+  const int64_t rate_;
+  const base::TimeDelta burst_;
+  // In microseconds since the TimeTicks origin.
+  std::array<std::atomic<int64_t>, kNumDirections> paid_until_ = {};
+};
+
+// Rate limiters of the tunnels of each priority class, indexed by
+// TunnelPriority. Null for the classes without a limit.
+using NaivePriorityRateLimiters =
+    std::array<scoped_refptr<NaiveRateLimiter>, kNumTunnelPriorities>;
+
+// Parses <CLASS>":"<RATE>[","...], e.g. "bulk:1m". Returns empty if `str`
+// is invalid.
+std::optional<NaivePriorityRateLimiters> ParsePriorityRateLimiters(
+    std::string_view str);
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_RATE_LIMITER_H_
@@ -0,0 +1,90 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_reload_signal.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/files/file_util.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/notreached.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/task/current_thread.h"
+
+namespace net {
+
+namespace {
+// The write end of the pipe, for the signal handler.
+int g_reload_pipe_write = -1;
+
+void OnSighup(int) {
+  int saved_errno = errno;
+  char c = 0;
+  // A full pipe means a reload is pending already.
+  (void)HANDLE_EINTR(write(g_reload_pipe_write, &c, 1));
+  errno = saved_errno;
+}
+}  // namespace
+
+NaiveReloadSignal::NaiveReloadSignal(base::RepeatingClosure callback)
+    : callback_(std::move(callback)) {}
+
+NaiveReloadSignal::~NaiveReloadSignal() {
+  if (!pipe_write_.is_valid())
+    return;
+  signal(SIGHUP, SIG_DFL);
+  g_reload_pipe_write = -1;
+}
+
+bool NaiveReloadSignal::Start() {
+  DCHECK_EQ(g_reload_pipe_write, -1);
+  int fds[2];
+  if (!base::CreateLocalNonBlockingPipe(fds)) {
+    PLOG(ERROR) << "Failed to create the reload pipe";
+    return false;
+  }
+  pipe_read_.reset(fds[0]);
+  pipe_write_.reset(fds[1]);
+
+  if (!base::CurrentIOThread::Get()->WatchFileDescriptor(
+          pipe_read_.get(), /*persistent=*/true,
+          base::MessagePumpForIO::WATCH_READ, &controller_, this)) {
+    LOG(ERROR) << "WatchFileDescriptor failed on reload pipe";
+    pipe_write_.reset();
+    return false;
+  }
+
+  g_reload_pipe_write = pipe_write_.get();
+  struct sigaction action = {};
+  action.sa_handler = OnSighup;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGHUP, &action, nullptr) != 0) {
+    PLOG(ERROR) << "sigaction failed";
+    g_reload_pipe_write = -1;
+    controller_.StopWatchingFileDescriptor();
+    pipe_write_.reset();
+    return false;
+  }
+  return true;
+}
+
+void NaiveReloadSignal::OnFileCanReadWithoutBlocking(int fd) {
+  // Coalesces the signals received so far into one reload.
+  char buf[64];
+  while (HANDLE_EINTR(read(fd, buf, sizeof(buf))) > 0) {
+  }
+  callback_.Run();
+}
+
+void NaiveReloadSignal::OnFileCanWriteWithoutBlocking(int fd) {
+  NOTREACHED();
+}
+
+}  // namespace net
@@ -0,0 +1,39 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_RELOAD_SIGNAL_H_
+#define NET_TOOLS_NAIVE_NAIVE_RELOAD_SIGNAL_H_
+
+#include "base/files/scoped_file.h"
+#include "base/functional/callback.h"
+#include "base/message_loop/message_pump_for_io.h"
+
+namespace net {
+
+// Runs a callback on the current IO thread each time the process receives
+// SIGHUP. The signal handler only writes a byte to a pipe watched by the
+// message pump, so the callback runs as a regular task. There can be only
+// one instance per process.
+class NaiveReloadSignal : public base::MessagePumpForIO::FdWatcher {
+ public:
+  explicit NaiveReloadSignal(base::RepeatingClosure callback);
+  ~NaiveReloadSignal() override;
+  NaiveReloadSignal(const NaiveReloadSignal&) = delete;
+  NaiveReloadSignal& operator=(const NaiveReloadSignal&) = delete;
+
+  // Installs the signal handler. Returns false if it cannot be installed.
+  bool Start();
+
+  // base::MessagePumpForIO::FdWatcher implementation.
+  void OnFileCanReadWithoutBlocking(int fd) override;
+  void OnFileCanWriteWithoutBlocking(int fd) override;
+
+ private:
+  base::RepeatingClosure callback_;
+  base::ScopedFD pipe_read_;
+  base::ScopedFD pipe_write_;
+  base::MessagePumpForIO::FdWatchController controller_{FROM_HERE};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_RELOAD_SIGNAL_H_
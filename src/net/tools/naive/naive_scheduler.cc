@@ -0,0 +1,100 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/check.h"
+#include "base/check_op.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/trace_event/base_tracing.h"
+#include "third_party/abseil-cpp/absl/base/attributes.h"
+
+namespace net {
+
+namespace {
+ABSL_CONST_INIT thread_local NaiveScheduler* current_scheduler = nullptr;
+}  // namespace
+
+NaiveScheduler::NaiveScheduler(int quantum, base::TimeDelta slice)
+    : quantum_(quantum), slice_(slice) {
+  DCHECK_GT(quantum_, 0);
+  CHECK_EQ(current_scheduler, nullptr);
+  current_scheduler = this;
+}
+
+NaiveScheduler::~NaiveScheduler() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  DCHECK_EQ(current_scheduler, this);
+  current_scheduler = nullptr;
+}
+
+// static
+NaiveScheduler* NaiveScheduler::GetForCurrentThread() {
+  return current_scheduler;
+}
+
+// static
+int NaiveScheduler::GetQuantum() {
+  if (current_scheduler == nullptr) {
+    return kDefaultQuantum;
+  }
+  return current_scheduler->quantum_;
+}
+
+// static
+void NaiveScheduler::Yield(base::OnceClosure resume) {
+  TRACE_EVENT_INSTANT("naive", "NaiveScheduler::Yield");
+  if (current_scheduler == nullptr) {
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE, std::move(resume));
+    return;
+  }
+  current_scheduler->Enqueue(std::move(resume));
+}
+
+void NaiveScheduler::Enqueue(base::OnceClosure resume) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  queue_.push_back(std::move(resume));
+  stats_.max_queued = std::max(stats_.max_queued, queue_.size());
+  if (!slice_pending_) {
+    slice_pending_ = true;
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE, base::BindOnce(&NaiveScheduler::RunSlice,
+                                  weak_ptr_factory_.GetWeakPtr()));
+  }
+}
+
+void NaiveScheduler::RunSlice() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  slice_pending_ = false;
+  stats_.slices++;
+  TRACE_EVENT("naive", "NaiveScheduler::RunSlice", "queued", queue_.size());
+
+  const base::TimeTicks deadline = base::TimeTicks::Now() + slice_;
+  // Directions yielding again during this round wait for the next round.
+  size_t round = queue_.size();
+  while (round > 0 && !queue_.empty()) {
+    base::OnceClosure resume = std::move(queue_.front());
+    queue_.pop_front();
+    --round;
+    stats_.resumed++;
+    std::move(resume).Run();
+    if (base::TimeTicks::Now() >= deadline) {
+      break;
+    }
+  }
+
+  if (!queue_.empty() && !slice_pending_) {
+    slice_pending_ = true;
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE, base::BindOnce(&NaiveScheduler::RunSlice,
+                                  weak_ptr_factory_.GetWeakPtr()));
+  }
+}
+
+}  // namespace net
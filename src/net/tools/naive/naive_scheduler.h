@@ -0,0 +1,81 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_SCHEDULER_H_
+#define NET_TOOLS_NAIVE_NAIVE_SCHEDULER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "base/containers/circular_deque.h"
+#include "base/functional/callback.h"
+#include "base/memory/weak_ptr.h"
+#include "base/threading/thread_checker.h"
+#include "base/time/time.h"
+
+namespace net {
+
+// Per-thread deficit round robin over the relay directions of the tunnels of
+// a thread. A direction may keep relaying synchronously while its deficit,
+// refilled by one quantum per round, is positive. Once the deficit is spent
+// it calls Yield() and waits behind the other directions that spent theirs.
+// Interactive tunnels that never spend a quantum between two reads are never
+// queued.
+//
+// Queued directions are resumed in rounds from one task at a time. A task
+// stops after its time slice and posts the rest, so other IO callbacks on the
+// thread run at least once per slice.
+//
+// At most one scheduler is installed per thread, for the lifetime of the
+// scheduler.
+class NaiveScheduler {
+ public:
+  static constexpr int kDefaultQuantum = 64 * 1024;
+  static constexpr int kDefaultSliceMilliseconds = 20;
+
+  struct Stats {
+    // Tasks run to resume queued directions.
+    uint64_t slices = 0;
+    // Directions resumed.
+    uint64_t resumed = 0;
+    // Largest number of directions waiting at once.
+    size_t max_queued = 0;
+  };
+
+  // `quantum`: Bytes added to the deficit of a direction per round.
+  // `slice`: Time after which a task resuming directions yields.
+  NaiveScheduler(int quantum, base::TimeDelta slice);
+  ~NaiveScheduler();
+  NaiveScheduler(const NaiveScheduler&) = delete;
+  NaiveScheduler& operator=(const NaiveScheduler&) = delete;
+
+  // Returns the scheduler installed on the current thread, or null.
+  static NaiveScheduler* GetForCurrentThread();
+
+  // Returns the quantum of the scheduler of the current thread, or
+  // kDefaultQuantum if there is none.
+  static int GetQuantum();
+
+  // Runs `resume` after the directions already waiting on the current
+  // thread. Without a scheduler, posts it as a task.
+  static void Yield(base::OnceClosure resume);
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  void Enqueue(base::OnceClosure resume);
+  void RunSlice();
+
+  const int quantum_;
+  const base::TimeDelta slice_;
+  base::circular_deque<base::OnceClosure> queue_;
+  bool slice_pending_ = false;
+  Stats stats_;
+
+  THREAD_CHECKER(thread_checker_);
+
+  base::WeakPtrFactory<NaiveScheduler> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_SCHEDULER_H_
@@ -0,0 +1,346 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_session_warmer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/raw_ptr.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/types/expected.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_error_details.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_anonymization_key.h"
+#include "net/base/privacy_mode.h"
+#include "net/base/proxy_chain.h"
+#include "net/base/proxy_server.h"
+#include "net/base/session_usage.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_proxy_connect_job.h"
+#include "net/log/net_log_source_type.h"
+#include "net/proxy_resolution/proxy_info.h"
+#include "net/quic/quic_context.h"
+#include "net/quic/quic_session_key.h"
+#include "net/quic/quic_session_pool.h"
+#include "net/socket/connect_job_factory.h"
+#include "net/socket/connect_job_params.h"
+#include "net/socket/connect_job_params_factory.h"
+#include "net/socket/next_proto.h"
+#include "net/socket/socket_tag.h"
+#include "net/socket/ssl_connect_job.h"
+#include "net/socket/stream_socket.h"
+#include "net/spdy/spdy_session.h"
+#include "net/spdy/spdy_session_key.h"
+#include "net/spdy/spdy_session_pool.h"
+#include "net/ssl/ssl_config.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "url/scheme_host_port.h"
+#include "url/url_constants.h"
+
+namespace net {
+
+// One tunnel session of a chain. The session to the last proxy is connected
+// the way HttpProxyConnectJob connects it for a tunnel, and is then left in
+// the session pool for the tunnels to find.
+class NaiveSessionWarmer::Target : public ConnectJob::Delegate {
+ public:
+  Target(const CommonConnectJobParams* common_connect_job_params,
+         const NetLogWithSource& net_log,
+         scoped_refptr<HttpProxySocketParams> params,
+         bool keep_warm)
+      : common_connect_job_params_(common_connect_job_params),
+        net_log_(net_log),
+        params_(std::move(params)),
+        keep_warm_(keep_warm) {
+    const HostPortPair& proxy = params_->proxy_server().host_port_pair();
+    // The key of the session depends on the proxies it is connected
+    // through. See HttpProxyConnectJob::CreateSpdySessionKey().
+    ProxyChain prefix =
+        params_->proxy_chain().Prefix(params_->proxy_chain_index());
+    if (params_->is_over_quic()) {
+      destination_ =
+          url::SchemeHostPort(url::kHttpsScheme, proxy.host(), proxy.port());
+      quic_key_ = QuicSessionKey(
+          proxy, params_->quic_ssl_config()->privacy_mode, prefix,
+          SessionUsage::kProxy, SocketTag(),
+          params_->network_anonymization_key(), params_->secure_dns_policy(),
+          /*require_dns_https_alpn=*/false);
+    } else {
+      spdy_key_ = SpdySessionKey(
+          proxy, PRIVACY_MODE_DISABLED, prefix, SessionUsage::kProxy,
+          SocketTag(), params_->network_anonymization_key(),
+          params_->secure_dns_policy(),
+          /*disable_cert_verification_network_fetches=*/true);
+    }
+  }
+  ~Target() override = default;
+  Target(const Target&) = delete;
+  Target& operator=(const Target&) = delete;
+
+  // Connects the session if it is missing and not backing off.
+  void Check() {
+    if (!keep_warm_ || disabled_ || connect_job_ || quic_request_)
+      return;
+    if (HasSession()) {
+      had_session_ = true;
+      return;
+    }
+    if (had_session_) {
+      had_session_ = false;
+      BackOff();
+    }
+    if (base::TimeTicks::Now() < next_attempt_time_)
+      return;
+    if (params_->is_over_quic()) {
+      ConnectQuic();
+    } else {
+      ConnectSpdy();
+    }
+  }
+
+  // Connects a replacement if the draining session is the one of this
+  // target. Draining is no failure of the proxy, so it takes no backoff.
+  void OnSessionDraining(const SpdySessionKey& key) {
+    if (params_->is_over_quic() || key != spdy_key_)
+      return;
+    if (disabled_ || connect_job_ || HasSession())
+      return;
+    if (base::TimeTicks::Now() < next_attempt_time_)
+      return;
+    // Keeps Check() from counting the drained session as lost again.
+    had_session_ = false;
+    VLOG(1) << "Replacing draining session to " << params_->proxy_server();
+    ConnectSpdy();
+  }
+
+  void ResetBackoff() {
+    backoff_ = base::TimeDelta();
+    next_attempt_time_ = base::TimeTicks();
+  }
+
+ private:
+  bool HasSession() const {
+    if (params_->is_over_quic()) {
+      return common_connect_job_params_->quic_session_pool
+          ->CanUseExistingSession(quic_key_, destination_);
+    }
+    return common_connect_job_params_->spdy_session_pool->HasAvailableSession(
+        spdy_key_, /*is_websocket=*/false);
+  }
+
+  void BackOff() {
+    next_attempt_time_ = base::TimeTicks::Now() + backoff_;
+    backoff_ = std::clamp(backoff_ * 2, kMinBackoff, kMaxBackoff);
+  }
+
+  void ConnectSpdy() {
+    connect_job_ = std::make_unique<SSLConnectJob>(
+        MAXIMUM_PRIORITY, SocketTag(), common_connect_job_params_,
+        params_->ssl_params(), this, /*net_log=*/nullptr);
+    int rv = connect_job_->Connect();
+    if (rv != ERR_IO_PENDING)
+      OnConnectJobComplete(rv, connect_job_.get());
+  }
+
+  void ConnectQuic() {
+    const SSLConfig& ssl_config = *params_->quic_ssl_config();
+    quic_request_ = std::make_unique<QuicSessionRequest>(
+        common_connect_job_params_->quic_session_pool);
+    int rv = quic_request_->Request(
+        destination_, SupportedQuicVersionForProxying(),
+        params_->proxy_chain().Prefix(params_->proxy_chain_index()),
+        params_->traffic_annotation(),
+        common_connect_job_params_->http_user_agent_settings,
+        SessionUsage::kProxy, ssl_config.privacy_mode,
+        HttpProxyConnectJob::kH2QuicTunnelPriority, SocketTag(),
+        params_->network_anonymization_key(), params_->secure_dns_policy(),
+        /*require_dns_https_alpn=*/false, ssl_config.GetCertVerifyFlags(),
+        destination_.GetURL(), net_log_, &quic_net_error_details_,
+        /*failed_on_default_network_callback=*/CompletionOnceCallback(),
+        base::BindOnce(&Target::OnQuicRequestComplete,
+                       base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnQuicRequestComplete(rv);
+  }
+
+  // ConnectJob::Delegate:
+  void OnConnectJobComplete(int result, ConnectJob* job) override {
+    DCHECK_EQ(job, connect_job_.get());
+    std::unique_ptr<ConnectJob> connect_job = std::move(connect_job_);
+    if (result == OK) {
+      std::unique_ptr<StreamSocket> socket = connect_job->PassSocket();
+      if (socket->GetNegotiatedProtocol() != kProtoHTTP2) {
+        // Tunnels over HTTP/1.1 take a connection each, so there is no
+        // session to keep.
+        LOG(INFO) << "Not preconnecting " << params_->proxy_server()
+                  << " without HTTP/2";
+        disabled_ = true;
+        return;
+      }
+      base::expected<base::WeakPtr<SpdySession>, int> spdy_session =
+          common_connect_job_params_->spdy_session_pool
+              ->CreateAvailableSessionFromSocket(
+                  spdy_key_, std::move(socket), connect_job->connect_timing(),
+                  connect_job->net_log());
+      if (!spdy_session.has_value())
+        result = spdy_session.error();
+    }
+    OnConnectComplete(result);
+  }
+
+  void OnNeedsProxyAuth(const HttpResponseInfo& response,
+                        HttpAuthController* auth_controller,
+                        base::OnceClosure restart_with_auth_callback,
+                        ConnectJob* job) override {
+    // The credentials of the proxies are already in the auth cache, so a
+    // challenge means they are wrong.
+    DCHECK_EQ(job, connect_job_.get());
+    connect_job_.reset();
+    OnConnectComplete(ERR_PROXY_AUTH_REQUESTED);
+  }
+
+  void OnQuicRequestComplete(int result) {
+    // Releases the handle only. The session stays in the pool.
+    if (result == OK)
+      quic_request_->ReleaseSessionHandle();
+    quic_request_.reset();
+    OnConnectComplete(result);
+  }
+
+  void OnConnectComplete(int result) {
+    if (result == OK) {
+      VLOG(1) << "Preconnected " << params_->proxy_server();
+      had_session_ = true;
+      return;
+    }
+    LOG(WARNING) << "Failed to preconnect " << params_->proxy_server() << ": "
+                 << ErrorToShortString(result);
+    BackOff();
+  }
+
+  raw_ptr<const CommonConnectJobParams> common_connect_job_params_;
+  const NetLogWithSource& net_log_;
+  scoped_refptr<HttpProxySocketParams> params_;
+  const bool keep_warm_;
+  SpdySessionKey spdy_key_;
+  QuicSessionKey quic_key_;
+  url::SchemeHostPort destination_;
+
+  std::unique_ptr<ConnectJob> connect_job_;
+  std::unique_ptr<QuicSessionRequest> quic_request_;
+  NetErrorDetails quic_net_error_details_;
+
+  // The session was there at the last check or connect.
+  bool had_session_ = false;
+  // Set for proxies without HTTP/2.
+  bool disabled_ = false;
+  base::TimeDelta backoff_;
+  base::TimeTicks next_attempt_time_;
+};
+
+NaiveSessionWarmer::NaiveSessionWarmer(
+    HttpNetworkSession* session,
+    const NaiveProxySelector& proxy_selector,
+    size_t num_chains,
+    size_t num_sessions,
+    size_t num_warm_sessions,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : common_connect_job_params_(session->CreateCommonConnectJobParams()),
+      net_log_(
+          NetLogWithSource::Make(session->net_log(), NetLogSourceType::NONE)) {
+  for (size_t chain = 0; chain < num_chains; ++chain) {
+    // Raced chains keep the sessions of both protocols, so tunnels find one
+    // ready whichever they use.
+    for (bool quic : {false, true}) {
+      if (quic && !proxy_selector.is_raced(chain))
+        continue;
+      const ProxyChain& proxy_chain =
+          proxy_selector.proxy_info({chain, 0, quic}).proxy_chain();
+      // Only HTTP/2 and QUIC proxies have tunnel sessions. Plaintext hops
+      // after the last of them travel in its tunnels.
+      if (proxy_chain.is_direct() ||
+          std::ranges::none_of(proxy_chain.proxy_servers(),
+                               &ProxyServer::is_secure_http_like)) {
+        continue;
+      }
+      // The endpoint only names the target of the CONNECT, which is never
+      // sent.
+      const HostPortPair& last = proxy_chain.Last().host_port_pair();
+      for (size_t index = 0; index < num_sessions; ++index) {
+        NaiveProxySelector::Selection selection{chain, index, quic};
+        ConnectJobParams params = ConstructConnectJobParams(
+            url::SchemeHostPort(url::kHttpScheme, last.host(), last.port()),
+            proxy_chain, traffic_annotation, /*allowed_bad_certs=*/{},
+            ConnectJobFactory::AlpnMode::kHttpAll, /*force_tunnel=*/true,
+            PRIVACY_MODE_DISABLED, OnHostResolutionCallback(),
+            proxy_selector.network_anonymization_key(selection),
+            SecureDnsPolicy::kDisable, /*disable_cert_network_fetches=*/false,
+            &common_connect_job_params_, NetworkAnonymizationKey());
+        scoped_refptr<HttpProxySocketParams> http_params =
+            params.take_http_proxy();
+        while (http_params->is_over_http())
+          http_params = http_params->http_params();
+        bool keep_warm = index < num_warm_sessions;
+        has_warm_targets_ |= keep_warm;
+        targets_.push_back(std::make_unique<Target>(
+            &common_connect_job_params_, net_log_, std::move(http_params),
+            keep_warm));
+      }
+    }
+  }
+  if (targets_.empty())
+    return;
+
+  session->spdy_session_pool()->set_session_draining_callback(
+      base::BindRepeating(&NaiveSessionWarmer::OnSessionDraining,
+                          weak_ptr_factory_.GetWeakPtr()));
+  if (!has_warm_targets_)
+    return;
+
+  NetworkChangeNotifier::AddNetworkChangeObserver(this);
+  check_timer_.Start(FROM_HERE, kCheckInterval, this,
+                     &NaiveSessionWarmer::CheckTargets);
+  // Leaves the first round to the next task, once the listeners are up.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveSessionWarmer::CheckTargets,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+NaiveSessionWarmer::~NaiveSessionWarmer() {
+  if (has_warm_targets_)
+    NetworkChangeNotifier::RemoveNetworkChangeObserver(this);
+}
+
+void NaiveSessionWarmer::OnNetworkChanged(
+    NetworkChangeNotifier::ConnectionType type) {
+  if (type == NetworkChangeNotifier::CONNECTION_NONE)
+    return;
+  for (const auto& target : targets_)
+    target->ResetBackoff();
+  // Gives the session pools time to close the sessions of the old network.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&NaiveSessionWarmer::CheckTargets,
+                     weak_ptr_factory_.GetWeakPtr()),
+      kNetworkChangeDelay);
+}
+
+void NaiveSessionWarmer::CheckTargets() {
+  for (const auto& target : targets_)
+    target->Check();
+}
+
+void NaiveSessionWarmer::OnSessionDraining(const SpdySessionKey& key) {
+  for (const auto& target : targets_)
+    target->OnSessionDraining(key);
+}
+
+}  // namespace net
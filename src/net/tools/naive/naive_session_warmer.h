@@ -0,0 +1,82 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_SESSION_WARMER_H_
+#define NET_TOOLS_NAIVE_NAIVE_SESSION_WARMER_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/network_change_notifier.h"
+#include "net/log/net_log_with_source.h"
+#include "net/socket/connect_job.h"
+
+namespace net {
+
+class HttpNetworkSession;
+class NaiveProxySelector;
+class SpdySessionKey;
+struct NetworkTrafficAnnotationTag;
+
+// Connects the tunnel sessions of the proxy chains before tunnels need them,
+// so the first tunnels only wait for their CONNECT. A tunnel session is the
+// HTTP/2 or QUIC session to the last HTTPS or QUIC proxy of a chain, keyed as
+// the tunnels look it up. The proxies before it are connected through as
+// usual, and plaintext HTTP proxies after it are reached in its tunnels.
+//
+// Sessions kept warm are checked every kCheckInterval and soon after network
+// changes, and lost ones are connected again. Each loss or failure pushes the
+// next attempt further back, from none up to kMaxBackoff, so a proxy that
+// closes idle sessions is not redialed in a loop. Network changes reset the
+// backoff.
+//
+// Any tunnel session that gets a graceful GOAWAY while its tunnels still
+// drain, as when the frontend of the proxy reloads, is replaced right away,
+// so new tunnels do not wait for a new session.
+class NaiveSessionWarmer
+    : public NetworkChangeNotifier::NetworkChangeObserver {
+ public:
+  static constexpr base::TimeDelta kCheckInterval = base::Seconds(5);
+  static constexpr base::TimeDelta kNetworkChangeDelay = base::Seconds(1);
+  static constexpr base::TimeDelta kMinBackoff = base::Seconds(5);
+  static constexpr base::TimeDelta kMaxBackoff = base::Minutes(5);
+
+  // Replaces the first `num_sessions` tunnel sessions of each of the
+  // `num_chains` chains of `proxy_selector` when they drain, and keeps the
+  // first `num_warm_sessions` of them warm. `session` and `proxy_selector`
+  // must outlive this.
+  NaiveSessionWarmer(HttpNetworkSession* session,
+                     const NaiveProxySelector& proxy_selector,
+                     size_t num_chains,
+                     size_t num_sessions,
+                     size_t num_warm_sessions,
+                     const NetworkTrafficAnnotationTag& traffic_annotation);
+  ~NaiveSessionWarmer() override;
+  NaiveSessionWarmer(const NaiveSessionWarmer&) = delete;
+  NaiveSessionWarmer& operator=(const NaiveSessionWarmer&) = delete;
+
+ private:
+  class Target;
+
+  // NetworkChangeNotifier::NetworkChangeObserver:
+  void OnNetworkChanged(NetworkChangeNotifier::ConnectionType type) override;
+
+  void CheckTargets();
+  void OnSessionDraining(const SpdySessionKey& key);
+
+  // Referenced by the connect jobs of the targets.
+  const CommonConnectJobParams common_connect_job_params_;
+  NetLogWithSource net_log_;
+  std::vector<std::unique_ptr<Target>> targets_;
+  bool has_warm_targets_ = false;
+  base::RepeatingTimer check_timer_;
+
+  base::WeakPtrFactory<NaiveSessionWarmer> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_SESSION_WARMER_H_
@@ -0,0 +1,68 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_shared_host_cache.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+#include "url/scheme_host_port.h"
+
+namespace net {
+
+NaiveSharedHostCache::NaiveSharedHostCache(size_t max_entries)
+    : max_entries_per_shard_(std::max<size_t>(max_entries / kNumShards, 1)) {}
+
+NaiveSharedHostCache::~NaiveSharedHostCache() = default;
+
+NaiveSharedHostCache::Shard& NaiveSharedHostCache::GetShard(
+    const HostCache::Key& key) {
+  const std::string* host;
+  if (absl::holds_alternative<url::SchemeHostPort>(key.host)) {
+    host = &absl::get<url::SchemeHostPort>(key.host).host();
+  } else {
+    host = &absl::get<std::string>(key.host);
+  }
+  return shards_[std::hash<std::string>()(*host) % kNumShards];
+}
+
+void NaiveSharedHostCache::Save(const HostCache::Key& key,
+                                const HostCache::Entry& entry) {
+  Shard& shard = GetShard(key);
+  base::AutoLock lock(shard.lock);
+  auto it = shard.entries.find(key);
+  if (it != shard.entries.end()) {
+    it->second = entry;
+    return;
+  }
+  if (shard.entries.size() >= max_entries_per_shard_) {
+    // The entry that expires first is the least likely to be served, even
+    // stale.
+    shard.entries.erase(std::ranges::min_element(
+        shard.entries, {}, [](const auto& key_and_entry) {
+          return key_and_entry.second.expires();
+        }));
+  }
+  shard.entries.emplace(key, entry);
+}
+
+std::optional<HostCache::Entry> NaiveSharedHostCache::Find(
+    const HostCache::Key& key) {
+  Shard& shard = GetShard(key);
+  base::AutoLock lock(shard.lock);
+  auto it = shard.entries.find(key);
+  if (it == shard.entries.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void NaiveSharedHostCache::Clear() {
+  for (Shard& shard : shards_) {
+    base::AutoLock lock(shard.lock);
+    shard.entries.clear();
+  }
+}
+
+}  // namespace net
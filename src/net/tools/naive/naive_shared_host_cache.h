@@ -0,0 +1,53 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_SHARED_HOST_CACHE_H_
+#define NET_TOOLS_NAIVE_NAIVE_SHARED_HOST_CACHE_H_
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <optional>
+
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "net/dns/host_cache.h"
+
+namespace net {
+
+// Shares the host cache entries of the IO threads, so an address resolved
+// by one thread is found in the cache by the others, instead of each
+// thread resolving every host once. Each thread copies an entry from here
+// into its own HostCache on a miss.
+//
+// The entries are split over kNumShards by host name, each with its own
+// lock, so the threads rarely wait for each other.
+class NaiveSharedHostCache : public HostCache::Store {
+ public:
+  static constexpr size_t kNumShards = 16;
+
+  // Keeps up to about `max_entries`.
+  explicit NaiveSharedHostCache(size_t max_entries);
+  ~NaiveSharedHostCache() override;
+  NaiveSharedHostCache(const NaiveSharedHostCache&) = delete;
+  NaiveSharedHostCache& operator=(const NaiveSharedHostCache&) = delete;
+
+  // HostCache::Store:
+  void Save(const HostCache::Key& key, const HostCache::Entry& entry) override;
+  std::optional<HostCache::Entry> Find(const HostCache::Key& key) override;
+  void Clear() override;
+
+ private:
+  struct Shard {
+    base::Lock lock;
+    std::map<HostCache::Key, HostCache::Entry> entries GUARDED_BY(lock);
+  };
+
+  Shard& GetShard(const HostCache::Key& key);
+
+  const size_t max_entries_per_shard_;
+  std::array<Shard, kNumShards> shards_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_SHARED_HOST_CACHE_H_
@@ -0,0 +1,335 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_socket_handoff.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "base/check.h"
+#include "base/files/file_util.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/notreached.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/task/current_thread.h"
+#include "net/base/net_errors.h"
+#include "net/base/sockaddr_storage.h"
+#include "net/log/net_log_source.h"
+#include "net/socket/tcp_server_socket.h"
+#include "net/socket/udp_server_socket.h"
+
+namespace net {
+
+namespace {
+// See sd_listen_fds(3).
+constexpr int kSystemdFirstFd = 3;
+// Handed over in one message, well under the SCM_RIGHTS limit of Linux.
+constexpr size_t kMaxHandoffSockets = 64;
+constexpr int kHandoffTimeoutSeconds = 5;
+constexpr int kHandoffListenBackLog = 1;
+
+// Returns false if `path` does not fit in a sockaddr_un.
+bool ToUnixAddress(const base::FilePath& path, sockaddr_un* address) {
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  const std::string& value = path.value();
+  if (value.empty() || value.size() >= sizeof(address->sun_path)) {
+    return false;
+  }
+  memcpy(address->sun_path, value.data(), value.size());
+  return true;
+}
+}  // namespace
+
+NaiveInheritedSockets::NaiveInheritedSockets() = default;
+
+NaiveInheritedSockets::~NaiveInheritedSockets() {
+  for (const Socket& socket : sockets_) {
+    LOG(WARNING) << "Closing unused inherited "
+                 << (socket.type == SOCK_STREAM ? "TCP" : "UDP")
+                 << " socket on " << socket.address.ToString();
+  }
+}
+
+void NaiveInheritedSockets::TakeSystemdSockets() {
+  const char* pid = getenv("LISTEN_PID");
+  const char* fds = getenv("LISTEN_FDS");
+  int listen_pid = 0;
+  int listen_fds = 0;
+  if (pid && fds && base::StringToInt(pid, &listen_pid) &&
+      listen_pid == getpid() && base::StringToInt(fds, &listen_fds)) {
+    for (int i = 0; i < listen_fds; ++i) {
+      int fd = kSystemdFirstFd + i;
+      if (!base::SetCloseOnExec(fd)) {
+        PLOG(WARNING) << "Ignoring socket " << fd << " from systemd";
+        continue;
+      }
+      Add(base::ScopedFD(fd));
+    }
+  }
+  unsetenv("LISTEN_PID");
+  unsetenv("LISTEN_FDS");
+  unsetenv("LISTEN_FDNAMES");
+}
+
+void NaiveInheritedSockets::ReceiveHandoff(const base::FilePath& path) {
+  sockaddr_un address;
+  if (!ToUnixAddress(path, &address)) {
+    LOG(ERROR) << "Invalid handoff path: " << path;
+    return;
+  }
+  base::ScopedFD fd(socket(AF_UNIX, SOCK_STREAM, 0));
+  if (!fd.is_valid()) {
+    PLOG(ERROR) << "socket failed";
+    return;
+  }
+  if (HANDLE_EINTR(connect(fd.get(), reinterpret_cast<sockaddr*>(&address),
+                           sizeof(address))) != 0) {
+    if (errno == ENOENT || errno == ECONNREFUSED) {
+      LOG(INFO) << "No running instance to take over from at " << path;
+    } else {
+      PLOG(ERROR) << "Failed to connect to " << path;
+    }
+    return;
+  }
+  timeval timeout = {.tv_sec = kHandoffTimeoutSeconds};
+  setsockopt(fd.get(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  char byte;
+  iovec iov = {.iov_base = &byte, .iov_len = 1};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxHandoffSockets)];
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  ssize_t rv = HANDLE_EINTR(recvmsg(fd.get(), &msg, 0));
+  if (rv <= 0) {
+    PLOG_IF(ERROR, rv < 0) << "Failed to receive sockets from " << path;
+    LOG_IF(ERROR, rv == 0) << "No sockets received from " << path;
+    return;
+  }
+  if (msg.msg_flags & MSG_CTRUNC) {
+    LOG(WARNING) << "Some sockets handed over from " << path << " were lost";
+  }
+  size_t num_received = 0;
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+      continue;
+    }
+    size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    for (size_t i = 0; i < count; ++i) {
+      int received_fd;
+      memcpy(&received_fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+      base::ScopedFD received(received_fd);
+      if (!base::SetCloseOnExec(received.get())) {
+        PLOG(WARNING) << "Ignoring handed over socket";
+        continue;
+      }
+      Add(std::move(received));
+      num_received++;
+    }
+  }
+  LOG(INFO) << "Took over " << num_received << " sockets from " << path;
+}
+
+std::unique_ptr<TCPServerSocket> NaiveInheritedSockets::TakeTcp(
+    const IPEndPoint& address,
+    NetLog* net_log) {
+  base::ScopedFD fd = Take(SOCK_STREAM, address);
+  if (!fd.is_valid()) {
+    return nullptr;
+  }
+  auto socket = std::make_unique<TCPServerSocket>(net_log, NetLogSource());
+  int result = socket->AdoptSocket(fd.release());
+  if (result != OK) {
+    LOG(ERROR) << "Failed to adopt socket on " << address.ToString() << ": "
+               << ErrorToShortString(result);
+    return nullptr;
+  }
+  return socket;
+}
+
+std::unique_ptr<UDPServerSocket> NaiveInheritedSockets::TakeUdp(
+    const IPEndPoint& address,
+    NetLog* net_log) {
+  base::ScopedFD fd = Take(SOCK_DGRAM, address);
+  if (!fd.is_valid()) {
+    return nullptr;
+  }
+  auto socket = std::make_unique<UDPServerSocket>(net_log, NetLogSource());
+  int result = socket->AdoptOpenedSocket(address.GetFamily(), fd.release());
+  if (result != OK) {
+    LOG(ERROR) << "Failed to adopt socket on " << address.ToString() << ": "
+               << ErrorToShortString(result);
+    return nullptr;
+  }
+  return socket;
+}
+
+void NaiveInheritedSockets::Add(base::ScopedFD fd) {
+  int type = 0;
+  socklen_t type_len = sizeof(type);
+  SockaddrStorage storage;
+  IPEndPoint address;
+  if (getsockopt(fd.get(), SOL_SOCKET, SO_TYPE, &type, &type_len) != 0 ||
+      (type != SOCK_STREAM && type != SOCK_DGRAM) ||
+      getsockname(fd.get(), storage.addr, &storage.addr_len) != 0 ||
+      !address.FromSockAddr(storage.addr, storage.addr_len)) {
+    LOG(WARNING) << "Ignoring inherited descriptor " << fd.get()
+                 << ", which is not an IP socket";
+    return;
+  }
+  sockets_.push_back({type, address, std::move(fd)});
+}
+
+base::ScopedFD NaiveInheritedSockets::Take(int type,
+                                           const IPEndPoint& address) {
+  auto it = std::ranges::find_if(sockets_, [&](const Socket& socket) {
+    return socket.type == type && socket.address == address;
+  });
+  if (it == sockets_.end()) {
+    return base::ScopedFD();
+  }
+  base::ScopedFD fd = std::move(it->fd);
+  sockets_.erase(it);
+  return fd;
+}
+
+NaiveHandoffServer::NaiveHandoffServer() = default;
+
+NaiveHandoffServer::~NaiveHandoffServer() {
+  if (path_.empty()) {
+    return;
+  }
+  // Leaves the path alone once the next instance has bound it.
+  struct stat st;
+  if (stat(path_.value().c_str(), &st) == 0 && st.st_ino == inode_) {
+    unlink(path_.value().c_str());
+  }
+}
+
+void NaiveHandoffServer::AddSocket(int fd) {
+  base::ScopedFD dup_fd(fcntl(fd, F_DUPFD_CLOEXEC, 0));
+  if (!dup_fd.is_valid()) {
+    PLOG(WARNING) << "Socket " << fd << " cannot be handed over";
+    return;
+  }
+  fds_.push_back(std::move(dup_fd));
+}
+
+void NaiveHandoffServer::RemoveSockets(int type, const IPEndPoint& address) {
+  std::erase_if(fds_, [&](const base::ScopedFD& fd) {
+    int fd_type = 0;
+    socklen_t type_len = sizeof(fd_type);
+    SockaddrStorage storage;
+    IPEndPoint bound_address;
+    return getsockopt(fd.get(), SOL_SOCKET, SO_TYPE, &fd_type, &type_len) ==
+               0 &&
+           fd_type == type &&
+           getsockname(fd.get(), storage.addr, &storage.addr_len) == 0 &&
+           bound_address.FromSockAddr(storage.addr, storage.addr_len) &&
+           bound_address == address;
+  });
+}
+
+bool NaiveHandoffServer::Start(const base::FilePath& path,
+                               base::OnceClosure on_handed_off) {
+  sockaddr_un address;
+  if (!ToUnixAddress(path, &address)) {
+    LOG(ERROR) << "Invalid handoff path: " << path;
+    return false;
+  }
+  listen_fd_.reset(socket(AF_UNIX, SOCK_STREAM, 0));
+  if (!listen_fd_.is_valid() || !base::SetNonBlocking(listen_fd_.get()) ||
+      !base::SetCloseOnExec(listen_fd_.get())) {
+    PLOG(ERROR) << "socket failed";
+    return false;
+  }
+  // The previous instance, if any, has handed over already.
+  unlink(path.value().c_str());
+  struct stat st;
+  if (bind(listen_fd_.get(), reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      chmod(path.value().c_str(), S_IRUSR | S_IWUSR) != 0 ||
+      listen(listen_fd_.get(), kHandoffListenBackLog) != 0 ||
+      stat(path.value().c_str(), &st) != 0) {
+    PLOG(ERROR) << "Failed to serve handoffs at " << path;
+    listen_fd_.reset();
+    return false;
+  }
+  path_ = path;
+  inode_ = st.st_ino;
+
+  if (!base::CurrentIOThread::Get()->WatchFileDescriptor(
+          listen_fd_.get(), /*persistent=*/true,
+          base::MessagePumpForIO::WATCH_READ, &controller_, this)) {
+    LOG(ERROR) << "WatchFileDescriptor failed on handoff socket";
+    listen_fd_.reset();
+    return false;
+  }
+  on_handed_off_ = std::move(on_handed_off);
+  return true;
+}
+
+void NaiveHandoffServer::OnFileCanReadWithoutBlocking(int fd) {
+  base::ScopedFD conn(HANDLE_EINTR(accept(fd, nullptr, nullptr)));
+  if (!conn.is_valid()) {
+    return;
+  }
+
+  size_t count = std::min(fds_.size(), kMaxHandoffSockets);
+  if (count < fds_.size()) {
+    LOG(WARNING) << "Handing over only " << count << " of " << fds_.size()
+                 << " sockets";
+  }
+  char byte = 0;
+  iovec iov = {.iov_base = &byte, .iov_len = 1};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxHandoffSockets)];
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  if (count > 0) {
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    for (size_t i = 0; i < count; ++i) {
+      int raw_fd = fds_[i].get();
+      memcpy(CMSG_DATA(cmsg) + i * sizeof(int), &raw_fd, sizeof(int));
+    }
+  }
+  if (HANDLE_EINTR(sendmsg(conn.get(), &msg, 0)) != 1) {
+    // Keeps serving, so the next instance can try again.
+    PLOG(ERROR) << "Failed to hand over sockets";
+    return;
+  }
+
+  LOG(INFO) << "Handed over " << count << " sockets";
+  handed_off_ = true;
+  controller_.StopWatchingFileDescriptor();
+  listen_fd_.reset();
+  fds_.clear();
+  std::move(on_handed_off_).Run();
+}
+
+void NaiveHandoffServer::OnFileCanWriteWithoutBlocking(int fd) {
+  NOTREACHED();
+}
+
+}  // namespace net
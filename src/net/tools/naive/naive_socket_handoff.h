@@ -0,0 +1,103 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_SOCKET_HANDOFF_H_
+#define NET_TOOLS_NAIVE_NAIVE_SOCKET_HANDOFF_H_
+
+#include <sys/types.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/scoped_file.h"
+#include "base/functional/callback.h"
+#include "base/message_loop/message_pump_for_io.h"
+#include "net/base/ip_endpoint.h"
+
+namespace net {
+
+class NetLog;
+class TCPServerSocket;
+class UDPServerSocket;
+
+// Listen sockets opened by another process: passed by systemd socket
+// activation, or handed over by a running instance being replaced. The
+// listeners adopt them instead of binding their addresses again, so no
+// connection is refused across an upgrade. Sockets left untaken are closed
+// when this is destroyed.
+class NaiveInheritedSockets {
+ public:
+  NaiveInheritedSockets();
+  ~NaiveInheritedSockets();
+  NaiveInheritedSockets(const NaiveInheritedSockets&) = delete;
+  NaiveInheritedSockets& operator=(const NaiveInheritedSockets&) = delete;
+
+  // Takes the sockets given with LISTEN_FDS if they are meant for this
+  // process, and clears the variables so child processes do not see them.
+  void TakeSystemdSockets();
+
+  // Takes the sockets of the instance serving handoffs at `path`, which
+  // then stops accepting. Does nothing if no instance serves there.
+  void ReceiveHandoff(const base::FilePath& path);
+
+  // Returns a socket listening on `address`, or null if there is none left.
+  std::unique_ptr<TCPServerSocket> TakeTcp(const IPEndPoint& address,
+                                           NetLog* net_log);
+  std::unique_ptr<UDPServerSocket> TakeUdp(const IPEndPoint& address,
+                                           NetLog* net_log);
+
+ private:
+  struct Socket {
+    int type;
+    IPEndPoint address;
+    base::ScopedFD fd;
+  };
+
+  void Add(base::ScopedFD fd);
+  base::ScopedFD Take(int type, const IPEndPoint& address);
+
+  std::vector<Socket> sockets_;
+};
+
+// Hands duplicates of the listen sockets of this process to the next
+// instance started with the same handoff path. Serves a single handoff,
+// after which this process is expected to stop accepting and exit once its
+// connections are closed.
+class NaiveHandoffServer : public base::MessagePumpForIO::FdWatcher {
+ public:
+  NaiveHandoffServer();
+  ~NaiveHandoffServer() override;
+  NaiveHandoffServer(const NaiveHandoffServer&) = delete;
+  NaiveHandoffServer& operator=(const NaiveHandoffServer&) = delete;
+
+  // Keeps a duplicate of the listen socket `fd` to hand over.
+  void AddSocket(int fd);
+  // Drops the sockets of `type`, SOCK_STREAM or SOCK_DGRAM, bound to
+  // `address`, whose listener was removed.
+  void RemoveSockets(int type, const IPEndPoint& address);
+
+  // Listens on the Unix socket `path`, replacing any stale one, and runs
+  // `on_handed_off` once the sockets are handed over. Returns false if the
+  // path cannot be bound.
+  bool Start(const base::FilePath& path, base::OnceClosure on_handed_off);
+
+  bool handed_off() const { return handed_off_; }
+
+  // base::MessagePumpForIO::FdWatcher implementation.
+  void OnFileCanReadWithoutBlocking(int fd) override;
+  void OnFileCanWriteWithoutBlocking(int fd) override;
+
+ private:
+  std::vector<base::ScopedFD> fds_;
+  base::FilePath path_;
+  // Of `path_`, which is only unlinked if it is still this server's.
+  ino_t inode_ = 0;
+  base::ScopedFD listen_fd_;
+  base::OnceClosure on_handed_off_;
+  bool handed_off_ = false;
+  base::MessagePumpForIO::FdWatchController controller_{FROM_HERE};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_SOCKET_HANDOFF_H_
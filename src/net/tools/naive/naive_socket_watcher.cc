@@ -0,0 +1,150 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_socket_watcher.h"
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/memory/raw_ptr.h"
+#include "net/socket/socket_performance_watcher.h"
+
+namespace net {
+
+namespace {
+// As the smoothed RTT of TCP.
+constexpr int kRttSmoothing = 8;
+}  // namespace
+
+class NaiveSocketWatcherFactory::Watcher : public SocketPerformanceWatcher {
+ public:
+  Watcher(NaiveSocketWatcherFactory* factory,
+          bool sampled,
+          const IPAddress& address,
+          std::unique_ptr<SocketPerformanceWatcher> next)
+      : factory_(factory),
+        sampled_(sampled),
+        address_(address),
+        next_(std::move(next)) {
+    factory_->AddWatcher(address_);
+  }
+
+  ~Watcher() override {
+    factory_->stats_.congestion_window -= congestion_window_;
+    factory_->RemoveWatcher(address_);
+  }
+
+  Watcher(const Watcher&) = delete;
+  Watcher& operator=(const Watcher&) = delete;
+
+  // SocketPerformanceWatcher implementation.
+  bool ShouldNotifyUpdatedRTT() const override {
+    return IsSampleDue() || (next_ && next_->ShouldNotifyUpdatedRTT());
+  }
+
+  void OnUpdatedRTTAvailable(const base::TimeDelta& rtt) override {
+    if (next_ && next_->ShouldNotifyUpdatedRTT())
+      next_->OnUpdatedRTTAvailable(rtt);
+    if (!IsSampleDue())
+      return;
+    last_sample_time_ = base::TimeTicks::Now();
+    factory_->OnRttSample(address_, rtt);
+  }
+
+  void OnUpdatedTcpStats(const TcpStats& stats) override {
+    Stats& total = factory_->stats_;
+    // The counts start over if the socket is reused for a new connection.
+    if (stats.segments_sent >= segments_sent_ &&
+        stats.segments_retransmitted >= segments_retransmitted_) {
+      total.segments_sent += stats.segments_sent - segments_sent_;
+      total.segments_retransmitted +=
+          stats.segments_retransmitted - segments_retransmitted_;
+    }
+    segments_sent_ = stats.segments_sent;
+    segments_retransmitted_ = stats.segments_retransmitted;
+    total.congestion_window -= congestion_window_;
+    congestion_window_ = stats.congestion_window;
+    total.congestion_window += congestion_window_;
+  }
+
+  void OnConnectionChanged() override {
+    if (next_)
+      next_->OnConnectionChanged();
+    last_sample_time_ = base::TimeTicks();
+    segments_sent_ = 0;
+    segments_retransmitted_ = 0;
+    factory_->stats_.congestion_window -= congestion_window_;
+    congestion_window_ = 0;
+  }
+
+ private:
+  bool IsSampleDue() const {
+    if (!sampled_)
+      return false;
+    return last_sample_time_.is_null() ||
+           base::TimeTicks::Now() - last_sample_time_ >= kSampleInterval;
+  }
+
+  const raw_ptr<NaiveSocketWatcherFactory> factory_;
+  const bool sampled_;
+  const IPAddress address_;
+  const std::unique_ptr<SocketPerformanceWatcher> next_;
+
+  base::TimeTicks last_sample_time_;
+  // Of the last sample.
+  uint64_t segments_sent_ = 0;
+  uint64_t segments_retransmitted_ = 0;
+  uint32_t congestion_window_ = 0;
+};
+
+NaiveSocketWatcherFactory::NaiveSocketWatcherFactory() = default;
+
+NaiveSocketWatcherFactory::~NaiveSocketWatcherFactory() = default;
+
+std::unique_ptr<SocketPerformanceWatcher>
+NaiveSocketWatcherFactory::CreateSocketPerformanceWatcher(
+    const Protocol protocol,
+    const IPAddress& ip_address) {
+  std::unique_ptr<SocketPerformanceWatcher> next;
+  if (next_factory_) {
+    next = next_factory_->CreateSocketPerformanceWatcher(protocol, ip_address);
+  }
+  // A watcher is still required of QUIC sessions, which only feed the next
+  // one.
+  return std::make_unique<Watcher>(this, protocol == PROTOCOL_TCP, ip_address,
+                                   std::move(next));
+}
+
+base::TimeDelta NaiveSocketWatcherFactory::GetPeerRtt(
+    const IPAddress& address) const {
+  auto it = peers_.find(address);
+  if (it == peers_.end())
+    return base::TimeDelta();
+  return it->second.smoothed_rtt;
+}
+
+void NaiveSocketWatcherFactory::AddWatcher(const IPAddress& address) {
+  peers_[address].watchers++;
+}
+
+void NaiveSocketWatcherFactory::RemoveWatcher(const IPAddress& address) {
+  auto it = peers_.find(address);
+  CHECK(it != peers_.end());
+  if (--it->second.watchers == 0) {
+    peers_.erase(it);
+  }
+}
+
+void NaiveSocketWatcherFactory::OnRttSample(const IPAddress& address,
+                                            base::TimeDelta rtt) {
+  stats_.rtt_samples++;
+  stats_.rtt_sum += rtt;
+  Peer& peer = peers_[address];
+  if (peer.smoothed_rtt.is_zero()) {
+    peer.smoothed_rtt = rtt;
+  } else {
+    peer.smoothed_rtt += (rtt - peer.smoothed_rtt) / kRttSmoothing;
+  }
+}
+
+}  // namespace net
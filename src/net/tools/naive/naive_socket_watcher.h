@@ -0,0 +1,88 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_SOCKET_WATCHER_H_
+#define NET_TOOLS_NAIVE_NAIVE_SOCKET_WATCHER_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include "base/memory/raw_ptr.h"
+#include "base/time/time.h"
+#include "net/base/ip_address.h"
+#include "net/socket/socket_performance_watcher_factory.h"
+
+namespace net {
+
+class SocketPerformanceWatcher;
+
+// Samples TCP_INFO of the TCP connections of the context of an IO thread,
+// to proxies and to destinations alike. A connection is sampled on a read
+// or write at most once per kSampleInterval, so a busy connection costs one
+// getsockopt() per interval rather than one per read. QUIC sessions keep
+// their own estimates and are not sampled.
+//
+// The samples add up to counters of the thread, which tell a network that
+// delays or loses packets apart from stalls of flow control or of the
+// relay. The RTT of the open connections to each peer is kept too, so a
+// tunnel session can be estimated by the RTT to its proxy before it has
+// sampled its own. The sessions to the same proxy address share it.
+//
+// The watchers of a next factory, such as that of the
+// NetworkQualityEstimator of the context, are fed the same RTTs as they ask
+// for them.
+//
+// Must be used on one thread, and outlive the context it is given to.
+class NaiveSocketWatcherFactory : public SocketPerformanceWatcherFactory {
+ public:
+  static constexpr base::TimeDelta kSampleInterval = base::Seconds(1);
+
+  struct Stats {
+    uint64_t rtt_samples = 0;
+    base::TimeDelta rtt_sum;
+    // Of the connections, closed and open, since they were opened.
+    uint64_t segments_sent = 0;
+    uint64_t segments_retransmitted = 0;
+    // The last sampled congestion windows of the open connections, summed.
+    uint64_t congestion_window = 0;
+  };
+
+  NaiveSocketWatcherFactory();
+  ~NaiveSocketWatcherFactory() override;
+
+  // SocketPerformanceWatcherFactory implementation.
+  std::unique_ptr<SocketPerformanceWatcher> CreateSocketPerformanceWatcher(
+      const Protocol protocol,
+      const IPAddress& ip_address) override;
+
+  // `next_factory` must outlive the watchers created from now on.
+  void set_next_factory(SocketPerformanceWatcherFactory* next_factory) {
+    next_factory_ = next_factory;
+  }
+
+  const Stats& stats() const { return stats_; }
+
+  // Returns the smoothed RTT of the open connections to `address`, or zero
+  // if none of them has been sampled.
+  base::TimeDelta GetPeerRtt(const IPAddress& address) const;
+
+ private:
+  class Watcher;
+
+  struct Peer {
+    int watchers = 0;
+    base::TimeDelta smoothed_rtt;
+  };
+
+  void AddWatcher(const IPAddress& address);
+  void RemoveWatcher(const IPAddress& address);
+  void OnRttSample(const IPAddress& address, base::TimeDelta rtt);
+
+  raw_ptr<SocketPerformanceWatcherFactory> next_factory_ = nullptr;
+  Stats stats_;
+  std::map<IPAddress, Peer> peers_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_SOCKET_WATCHER_H_
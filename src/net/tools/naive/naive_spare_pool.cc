@@ -0,0 +1,241 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_spare_pool.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/check_op.h"
+#include "base/containers/flat_set.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/raw_ptr.h"
+#include "base/notreached.h"
+#include "base/task/single_thread_task_runner.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_anonymization_key.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/http/http_network_session.h"
+#include "net/socket/socket_tag.h"
+#include "net/socket/stream_socket.h"
+#include "net/socket/transport_connect_job.h"
+#include "third_party/abseil-cpp/absl/base/attributes.h"
+#include "url/scheme_host_port.h"
+
+namespace net {
+
+namespace {
+ABSL_CONST_INIT thread_local NaiveSparePool* current_pool = nullptr;
+}  // namespace
+
+// The spare connections to one destination, connected the way direct
+// tunnels are connected by the transport pool, one at a time.
+class NaiveSparePool::Target : public ConnectJob::Delegate {
+ public:
+  Target(NaiveSparePool* pool, const url::SchemeHostPort& endpoint)
+      : pool_(pool),
+        params_(base::MakeRefCounted<TransportSocketParams>(
+            endpoint, NetworkAnonymizationKey(), SecureDnsPolicy::kAllow,
+            OnHostResolutionCallback(),
+            /*supported_alpns=*/base::flat_set<std::string>())) {}
+  ~Target() override { pool_->stats_.expired += connections_.size(); }
+  Target(const Target&) = delete;
+  Target& operator=(const Target&) = delete;
+
+  std::unique_ptr<StreamSocket> Take() {
+    DropStale();
+    if (connections_.empty())
+      return nullptr;
+    // The oldest first, so that the others stay within kMaxIdleTime for
+    // longer.
+    std::unique_ptr<StreamSocket> socket =
+        std::move(connections_.front().socket);
+    connections_.erase(connections_.begin());
+    Check();
+    return socket;
+  }
+
+  // Connects another connection if there are too few and it is not
+  // backing off.
+  void Check() {
+    DropStale();
+    if (connect_job_ || connections_.size() >= pool_->num_connections_)
+      return;
+    if (base::TimeTicks::Now() < next_attempt_time_ || !pool_->CanConnect())
+      return;
+    Connect();
+  }
+
+  void Reset() {
+    pool_->stats_.expired += connections_.size();
+    connections_.clear();
+    connect_job_.reset();
+    backoff_ = base::TimeDelta();
+    next_attempt_time_ = base::TimeTicks();
+  }
+
+ private:
+  struct Connection {
+    std::unique_ptr<StreamSocket> socket;
+    base::TimeTicks connect_time;
+  };
+
+  // Drops the connections the destination may have closed, and those it
+  // has.
+  void DropStale() {
+    base::TimeTicks now = base::TimeTicks::Now();
+    pool_->stats_.expired +=
+        std::erase_if(connections_, [&](const Connection& connection) {
+          return now - connection.connect_time >= kMaxIdleTime ||
+                 !connection.socket->IsConnectedAndIdle();
+        });
+  }
+
+  void BackOff() {
+    backoff_ = std::clamp(backoff_ * 2, kMinBackoff, kMaxBackoff);
+    next_attempt_time_ = base::TimeTicks::Now() + backoff_;
+  }
+
+  void Connect() {
+    pool_->stats_.connects++;
+    connect_job_ = std::make_unique<TransportConnectJob>(
+        IDLE, SocketTag(), &pool_->common_connect_job_params_, params_, this,
+        /*net_log=*/nullptr);
+    int rv = connect_job_->Connect();
+    if (rv != ERR_IO_PENDING)
+      OnConnectJobComplete(rv, connect_job_.get());
+  }
+
+  // ConnectJob::Delegate:
+  void OnConnectJobComplete(int result, ConnectJob* job) override {
+    DCHECK_EQ(job, connect_job_.get());
+    std::unique_ptr<ConnectJob> connect_job = std::move(connect_job_);
+    if (result != OK) {
+      VLOG(1) << "Failed to connect spare connection: "
+              << ErrorToShortString(result);
+      pool_->stats_.failures++;
+      BackOff();
+      return;
+    }
+    backoff_ = base::TimeDelta();
+    connections_.push_back(
+        {connect_job->PassSocket(), base::TimeTicks::Now()});
+    Check();
+  }
+
+  void OnNeedsProxyAuth(const HttpResponseInfo& response,
+                        HttpAuthController* auth_controller,
+                        base::OnceClosure restart_with_auth_callback,
+                        ConnectJob* job) override {
+    // Only proxy connect jobs ask for credentials.
+    NOTREACHED();
+  }
+
+  const raw_ptr<NaiveSparePool> pool_;
+  const scoped_refptr<TransportSocketParams> params_;
+
+  std::vector<Connection> connections_;
+  std::unique_ptr<ConnectJob> connect_job_;
+
+  base::TimeDelta backoff_;
+  base::TimeTicks next_attempt_time_;
+};
+
+NaiveSparePool::NaiveSparePool(HttpNetworkSession* session,
+                               size_t num_connections,
+                               scoped_refptr<NaiveFdBudget> fd_budget)
+    : common_connect_job_params_(session->CreateCommonConnectJobParams()),
+      num_connections_(num_connections),
+      fd_budget_(std::move(fd_budget)),
+      popular_hosts_(kMaxHosts),
+      last_decay_time_(base::TimeTicks::Now()) {
+  DCHECK_GT(num_connections_, 0u);
+  CHECK_EQ(current_pool, nullptr);
+  current_pool = this;
+
+  NetworkChangeNotifier::AddNetworkChangeObserver(this);
+  check_timer_.Start(FROM_HERE, kCheckInterval, this,
+                     &NaiveSparePool::CheckTargets);
+}
+
+NaiveSparePool::~NaiveSparePool() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  DCHECK_EQ(current_pool, this);
+  current_pool = nullptr;
+  NetworkChangeNotifier::RemoveNetworkChangeObserver(this);
+  // The targets count their connections in `stats_`.
+  targets_.clear();
+}
+
+// static
+NaiveSparePool* NaiveSparePool::GetForCurrentThread() {
+  return current_pool;
+}
+
+std::unique_ptr<StreamSocket> NaiveSparePool::Take(
+    const url::SchemeHostPort& endpoint) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  std::string key = HostPortPair::FromSchemeHostPort(endpoint).ToString();
+  bool is_top = popular_hosts_.Record(key);
+
+  auto it = targets_.find(key);
+  if (it == targets_.end()) {
+    stats_.misses++;
+    if (is_top && popular_hosts_.GetCount(key) >= kMinTunnels) {
+      it = targets_.emplace(key, std::make_unique<Target>(this, endpoint))
+               .first;
+      it->second->Check();
+    }
+    return nullptr;
+  }
+
+  std::unique_ptr<StreamSocket> socket = it->second->Take();
+  if (socket)
+    stats_.hits++;
+  else
+    stats_.misses++;
+  return socket;
+}
+
+void NaiveSparePool::Clear() {
+  for (const auto& [key, target] : targets_)
+    target->Reset();
+}
+
+bool NaiveSparePool::CanConnect() const {
+  return !fd_budget_ || !fd_budget_->low();
+}
+
+void NaiveSparePool::OnNetworkChanged(
+    NetworkChangeNotifier::ConnectionType type) {
+  if (type == NetworkChangeNotifier::CONNECTION_NONE)
+    return;
+  // The connections of the old network may be gone without notice.
+  Clear();
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&NaiveSparePool::CheckTargets,
+                     weak_ptr_factory_.GetWeakPtr()),
+      kNetworkChangeDelay);
+}
+
+void NaiveSparePool::CheckTargets() {
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (now - last_decay_time_ >= kPopularityHalfLife) {
+    popular_hosts_.Decay();
+    last_decay_time_ = now;
+  }
+  // Destinations that fell out of the top keep no spare connections.
+  std::erase_if(targets_, [&](const auto& item) {
+    return popular_hosts_.GetCount(item.first) == 0;
+  });
+  for (const auto& [key, target] : targets_)
+    target->Check();
+}
+
+}  // namespace net
@@ -0,0 +1,119 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_SPARE_POOL_H_
+#define NET_TOOLS_NAIVE_NAIVE_SPARE_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/threading/thread_checker.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/network_change_notifier.h"
+#include "net/socket/connect_job.h"
+#include "net/tools/naive/naive_fd_budget.h"
+#include "net/tools/naive/naive_popular_hosts.h"
+
+namespace url {
+class SchemeHostPort;
+}  // namespace url
+
+namespace net {
+
+class HttpNetworkSession;
+class StreamSocket;
+
+// Keeps spare TCP connections to the destinations of direct tunnels that
+// are opened the most, so a tunnel to one of them takes a connected socket
+// instead of waiting for the handshake with the destination. A replacement
+// is connected right away.
+//
+// Destinations are counted by NaivePopularHosts as tunnels are opened, and
+// the counts are halved every kPopularityHalfLife. Up to kMaxHosts of the
+// top ones that have been counted kMinTunnels times get spare connections.
+// Spare connections idle for kMaxIdleTime are replaced, as servers close
+// connections on which nothing is sent. Failures push the next attempt to
+// that destination further back, from kMinBackoff up to kMaxBackoff. No
+// connection is made while file descriptors are low. Network changes and
+// memory pressure drop the spare connections.
+//
+// At most one pool is installed per thread, for the lifetime of the pool.
+class NaiveSparePool : public NetworkChangeNotifier::NetworkChangeObserver {
+ public:
+  static constexpr size_t kMaxHosts = 16;
+  static constexpr uint32_t kMinTunnels = 3;
+  static constexpr base::TimeDelta kCheckInterval = base::Seconds(5);
+  static constexpr base::TimeDelta kPopularityHalfLife = base::Minutes(1);
+  static constexpr base::TimeDelta kNetworkChangeDelay = base::Seconds(1);
+  static constexpr base::TimeDelta kMaxIdleTime = base::Seconds(10);
+  static constexpr base::TimeDelta kMinBackoff = base::Seconds(5);
+  static constexpr base::TimeDelta kMaxBackoff = base::Minutes(5);
+
+  struct Stats {
+    // Direct tunnels that took a spare connection, or found none ready.
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t connects = 0;
+    uint64_t failures = 0;
+    // Spare connections dropped unused.
+    uint64_t expired = 0;
+  };
+
+  // Keeps `num_connections` connections to each popular destination.
+  // `session` must outlive this. `fd_budget` may be null.
+  NaiveSparePool(HttpNetworkSession* session,
+                 size_t num_connections,
+                 scoped_refptr<NaiveFdBudget> fd_budget);
+  ~NaiveSparePool() override;
+  NaiveSparePool(const NaiveSparePool&) = delete;
+  NaiveSparePool& operator=(const NaiveSparePool&) = delete;
+
+  // Returns the pool installed on the current thread, or null.
+  static NaiveSparePool* GetForCurrentThread();
+
+  // Counts a direct tunnel to `endpoint`, and returns a connected socket to
+  // it on which nothing has been sent, or null if there is none ready.
+  std::unique_ptr<StreamSocket> Take(const url::SchemeHostPort& endpoint);
+
+  // Drops the spare connections, which are connected again at the next
+  // check.
+  void Clear();
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  class Target;
+
+  // NetworkChangeNotifier::NetworkChangeObserver:
+  void OnNetworkChanged(NetworkChangeNotifier::ConnectionType type) override;
+
+  // Whether the targets may connect more.
+  bool CanConnect() const;
+
+  void CheckTargets();
+
+  // Referenced by the connect jobs of the targets.
+  const CommonConnectJobParams common_connect_job_params_;
+  const size_t num_connections_;
+  const scoped_refptr<NaiveFdBudget> fd_budget_;
+
+  NaivePopularHosts popular_hosts_;
+  base::TimeTicks last_decay_time_;
+  // By the key of NaivePopularHosts.
+  std::map<std::string, std::unique_ptr<Target>> targets_;
+  base::RepeatingTimer check_timer_;
+  Stats stats_;
+
+  THREAD_CHECKER(thread_checker_);
+
+  base::WeakPtrFactory<NaiveSparePool> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_SPARE_POOL_H_
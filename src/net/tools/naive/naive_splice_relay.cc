@@ -0,0 +1,244 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_splice_relay.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/check_op.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/task/current_thread.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+
+namespace net {
+
+namespace {
+// Upper bound of bytes moved by one splice() call, the default pipe capacity.
+constexpr size_t kSpliceSize = 64 * 1024;
+}  // namespace
+
+NaiveSpliceRelay::Channel::Channel(NaiveSpliceRelay* relay,
+                                   int from_fd,
+                                   int to_fd)
+    : relay_(relay),
+      from_fd_(from_fd),
+      to_fd_(to_fd),
+      read_watcher_(FROM_HERE),
+      write_watcher_(FROM_HERE) {}
+
+NaiveSpliceRelay::Channel::~Channel() {
+  StopWatching();
+}
+
+int NaiveSpliceRelay::Channel::Init() {
+  int fds[2];
+  if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+    return MapSystemError(errno);
+  }
+  pipe_read_.reset(fds[0]);
+  pipe_write_.reset(fds[1]);
+  return OK;
+}
+
+void NaiveSpliceRelay::Channel::set_early_data(
+    scoped_refptr<DrainableIOBuffer> early_data) {
+  early_data_ = std::move(early_data);
+}
+
+int NaiveSpliceRelay::Channel::DoRelay() {
+  if (early_data_) {
+    int rv = WriteEarlyData();
+    if (rv != OK) {
+      return rv;
+    }
+  }
+
+  for (;;) {
+    if (pipe_bytes_ > 0) {
+      ssize_t n = HANDLE_EINTR(splice(pipe_read_.get(), nullptr, to_fd_,
+                                      nullptr, pipe_bytes_,
+                                      SPLICE_F_MOVE | SPLICE_F_NONBLOCK));
+      if (n < 0) {
+        if (errno == EAGAIN) {
+          return WatchWritable();
+        }
+        return MapSystemError(errno);
+      }
+      pipe_bytes_ -= n;
+      CountRelayed(n);
+      continue;
+    }
+
+    ssize_t n = HANDLE_EINTR(splice(from_fd_, nullptr, pipe_write_.get(),
+                                    nullptr, kSpliceSize,
+                                    SPLICE_F_MOVE | SPLICE_F_NONBLOCK));
+    if (n < 0) {
+      if (errno == EAGAIN) {
+        return WatchReadable();
+      }
+      return MapSystemError(errno);
+    }
+    if (n == 0) {
+      return OK;
+    }
+    pipe_bytes_ += n;
+  }
+}
+
+int NaiveSpliceRelay::Channel::WriteEarlyData() {
+  while (early_data_->BytesRemaining() > 0) {
+    ssize_t n =
+        HANDLE_EINTR(send(to_fd_, early_data_->data(),
+                          early_data_->BytesRemaining(), MSG_NOSIGNAL));
+    if (n < 0) {
+      if (errno == EAGAIN) {
+        return WatchWritable();
+      }
+      return MapSystemError(errno);
+    }
+    early_data_->DidConsume(n);
+    CountRelayed(n);
+  }
+  early_data_ = nullptr;
+  return OK;
+}
+
+void NaiveSpliceRelay::Channel::CountRelayed(int64_t bytes) {
+  if (bytes_relayed_ == 0 && bytes > 0) {
+    first_relay_time_ = base::TimeTicks::Now();
+  }
+  bytes_relayed_ += bytes;
+}
+
+int NaiveSpliceRelay::Channel::WatchReadable() {
+  if (!base::CurrentIOThread::Get()->WatchFileDescriptor(
+          from_fd_, /*persistent=*/false, base::MessagePumpForIO::WATCH_READ,
+          &read_watcher_, this)) {
+    PLOG(ERROR) << "WatchFileDescriptor failed on splice read";
+    return MapSystemError(errno);
+  }
+  return ERR_IO_PENDING;
+}
+
+int NaiveSpliceRelay::Channel::WatchWritable() {
+  if (!base::CurrentIOThread::Get()->WatchFileDescriptor(
+          to_fd_, /*persistent=*/false, base::MessagePumpForIO::WATCH_WRITE,
+          &write_watcher_, this)) {
+    PLOG(ERROR) << "WatchFileDescriptor failed on splice write";
+    return MapSystemError(errno);
+  }
+  return ERR_IO_PENDING;
+}
+
+void NaiveSpliceRelay::Channel::StopWatching() {
+  read_watcher_.StopWatchingFileDescriptor();
+  write_watcher_.StopWatchingFileDescriptor();
+}
+
+int NaiveSpliceRelay::Channel::ShutdownWrite() {
+  if (shutdown(to_fd_, SHUT_WR) != 0) {
+    return MapSystemError(errno);
+  }
+  done_ = true;
+  return OK;
+}
+
+void NaiveSpliceRelay::Channel::OnFileCanReadWithoutBlocking(int fd) {
+  OnReady();
+}
+
+void NaiveSpliceRelay::Channel::OnFileCanWriteWithoutBlocking(int fd) {
+  OnReady();
+}
+
+void NaiveSpliceRelay::Channel::OnReady() {
+  int rv = DoRelay();
+  if (rv != ERR_IO_PENDING) {
+    relay_->OnChannelDone(this, rv);
+  }
+}
+
+NaiveSpliceRelay::NaiveSpliceRelay(int client_fd, int server_fd) {
+  channels_[kClient] = std::make_unique<Channel>(this, client_fd, server_fd);
+  channels_[kServer] = std::make_unique<Channel>(this, server_fd, client_fd);
+}
+
+NaiveSpliceRelay::~NaiveSpliceRelay() = default;
+
+int NaiveSpliceRelay::Init() {
+  for (auto& channel : channels_) {
+    int rv = channel->Init();
+    if (rv != OK) {
+      return rv;
+    }
+  }
+  return OK;
+}
+
+int NaiveSpliceRelay::Run(scoped_refptr<DrainableIOBuffer> early_data,
+                          CompletionOnceCallback callback) {
+  DCHECK(!callback_);
+
+  callback_ = std::move(callback);
+  if (early_data) {
+    channels_[kClient]->set_early_data(std::move(early_data));
+  }
+  for (auto& channel : channels_) {
+    int rv = HandleChannelResult(channel.get(), channel->DoRelay());
+    if (rv != ERR_IO_PENDING) {
+      callback_.Reset();
+      return rv;
+    }
+  }
+  return ERR_IO_PENDING;
+}
+
+int64_t NaiveSpliceRelay::bytes_relayed(Direction from) const {
+  return channels_[from]->bytes_relayed();
+}
+
+base::TimeTicks NaiveSpliceRelay::first_relay_time(Direction from) const {
+  return channels_[from]->first_relay_time();
+}
+
+int NaiveSpliceRelay::HandleChannelResult(Channel* channel, int result) {
+  if (result == ERR_IO_PENDING) {
+    return result;
+  }
+  if (result == OK) {
+    // Passes the EOF on and keeps relaying the other direction.
+    result = channel->ShutdownWrite();
+    if (result == OK) {
+      for (auto& other : channels_) {
+        if (!other->done()) {
+          return ERR_IO_PENDING;
+        }
+      }
+      return OK;
+    }
+  }
+  for (auto& other : channels_) {
+    other->StopWatching();
+  }
+  return result;
+}
+
+void NaiveSpliceRelay::OnChannelDone(Channel* channel, int result) {
+  DCHECK_NE(result, ERR_IO_PENDING);
+
+  int rv = HandleChannelResult(channel, result);
+  if (rv != ERR_IO_PENDING && callback_) {
+    std::move(callback_).Run(rv);
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,111 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_SPLICE_RELAY_H_
+#define NET_TOOLS_NAIVE_NAIVE_SPLICE_RELAY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "base/files/scoped_file.h"
+#include "base/memory/raw_ptr.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/message_loop/message_pump_for_io.h"
+#include "base/time/time.h"
+#include "net/base/completion_once_callback.h"
+#include "net/tools/naive/naive_protocol.h"
+
+namespace net {
+
+class DrainableIOBuffer;
+
+// Relays bytes between two connected TCP sockets with splice(2) through one
+// pipe per direction, so the payload is never copied into user space.
+//
+// The relay borrows the socket descriptors. Their owners must keep them open
+// and must not start any IO on them while the relay runs.
+class NaiveSpliceRelay {
+ public:
+  NaiveSpliceRelay(int client_fd, int server_fd);
+  ~NaiveSpliceRelay();
+  NaiveSpliceRelay(const NaiveSpliceRelay&) = delete;
+  NaiveSpliceRelay& operator=(const NaiveSpliceRelay&) = delete;
+
+  // Creates the pipes. Returns a net error code.
+  int Init();
+
+  // Starts relaying. `early_data` holds client bytes already read that are
+  // written to the server first, or is null. EOF in one direction is passed
+  // on by shutting down writes on the other socket, and the other direction
+  // keeps relaying. Returns ERR_IO_PENDING and invokes `callback` once both
+  // directions reach EOF, with OK, or once either fails, with the error.
+  // Returns the result directly if that happens synchronously.
+  int Run(scoped_refptr<DrainableIOBuffer> early_data,
+          CompletionOnceCallback callback);
+
+  int64_t bytes_relayed(Direction from) const;
+  // When the first bytes read from `from` were written, or null.
+  base::TimeTicks first_relay_time(Direction from) const;
+
+ private:
+  // Moves bytes from `from_fd` to `to_fd` through a pipe.
+  class Channel : public base::MessagePumpForIO::FdWatcher {
+   public:
+    Channel(NaiveSpliceRelay* relay, int from_fd, int to_fd);
+    ~Channel() override;
+
+    int Init();
+
+    void set_early_data(scoped_refptr<DrainableIOBuffer> early_data);
+
+    // Moves bytes until the sockets would block. Returns ERR_IO_PENDING while
+    // waiting for readiness, OK when EOF has been relayed, or an error.
+    int DoRelay();
+
+    void StopWatching();
+
+    // Shuts down writes on the destination after EOF has been relayed.
+    int ShutdownWrite();
+
+    bool done() const { return done_; }
+    int64_t bytes_relayed() const { return bytes_relayed_; }
+    base::TimeTicks first_relay_time() const { return first_relay_time_; }
+
+    // base::MessagePumpForIO::FdWatcher implementation.
+    void OnFileCanReadWithoutBlocking(int fd) override;
+    void OnFileCanWriteWithoutBlocking(int fd) override;
+
+   private:
+    int WriteEarlyData();
+    void CountRelayed(int64_t bytes);
+    int WatchReadable();
+    int WatchWritable();
+    void OnReady();
+
+    raw_ptr<NaiveSpliceRelay> relay_;
+    int from_fd_;
+    int to_fd_;
+    base::ScopedFD pipe_read_;
+    base::ScopedFD pipe_write_;
+    scoped_refptr<DrainableIOBuffer> early_data_;
+    // Bytes moved into the pipe but not yet out of it.
+    size_t pipe_bytes_ = 0;
+    int64_t bytes_relayed_ = 0;
+    base::TimeTicks first_relay_time_;
+    bool done_ = false;
+    base::MessagePumpForIO::FdWatchController read_watcher_;
+    base::MessagePumpForIO::FdWatchController write_watcher_;
+  };
+
+  // Takes the result of DoRelay() of `channel`. Returns ERR_IO_PENDING while
+  // any direction is still relaying, or the result of the relay.
+  int HandleChannelResult(Channel* channel, int result);
+  void OnChannelDone(Channel* channel, int result);
+
+  std::unique_ptr<Channel> channels_[kNumDirections];
+  CompletionOnceCallback callback_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_SPLICE_RELAY_H_
@@ -0,0 +1,163 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_ssl_session_store.h"
+
+#include <optional>
+#include <utility>
+
+#include "base/base64.h"
+#include "base/files/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "net/cert/x509_util.h"
+
+namespace net {
+namespace {
+constexpr int kFileVersion = 1;
+}  // namespace
+
+NaiveSslSessionStore::NaiveSslSessionStore(const base::FilePath& path)
+    : path_(path),
+      writer_(path),
+      ssl_ctx_(SSL_CTX_new(TLS_with_buffers_method())) {
+  // Shares certificate buffers with the sockets, as their context does.
+  SSL_CTX_set0_buffer_pool(ssl_ctx_.get(), x509_util::GetBufferPool());
+}
+
+NaiveSslSessionStore::~NaiveSslSessionStore() = default;
+
+// static
+std::string NaiveSslSessionStore::ServerKey(
+    const SSLClientSessionCache::Key& cache_key) {
+  std::string key = cache_key.server.ToString();
+  if (cache_key.privacy_mode != PRIVACY_MODE_DISABLED)
+    key += "/private";
+  return key;
+}
+
+size_t NaiveSslSessionStore::Load() {
+  std::string data;
+  if (!base::ReadFileToString(path_, &data))
+    return 0;
+  std::optional<base::Value::Dict> dict = base::JSONReader::ReadDict(data);
+  if (!dict || dict->FindInt("version") != kFileVersion) {
+    LOG(WARNING) << "Ignoring invalid TLS session file " << path_;
+    return 0;
+  }
+  const base::Value::Dict* servers = dict->FindDict("servers");
+  if (!servers)
+    return 0;
+
+  uint64_t now = static_cast<uint64_t>(base::Time::Now().ToTimeT());
+  size_t count = 0;
+  base::AutoLock lock(lock_);
+  for (const auto [key, list] : *servers) {
+    if (!list.is_list())
+      continue;
+    std::vector<Entry>& entries = entries_[key];
+    for (const base::Value& value : list.GetList()) {
+      const base::Value::Dict* entry_dict = value.GetIfDict();
+      if (!entry_dict)
+        continue;
+      const std::string* session = entry_dict->FindString("session");
+      const std::string* expiration = entry_dict->FindString("expiration");
+      Entry entry;
+      if (!session || !expiration ||
+          !base::Base64Decode(*session, &entry.session) ||
+          !base::StringToUint64(*expiration, &entry.expiration)) {
+        continue;
+      }
+      if (entry.expiration <= now ||
+          entries.size() >= kMaxSessionsPerServer) {
+        continue;
+      }
+      entries.push_back(std::move(entry));
+      ++count;
+    }
+    if (entries.empty())
+      entries_.erase(key);
+  }
+  LOG(INFO) << "Loaded " << count << " TLS sessions from " << path_;
+  return count;
+}
+
+void NaiveSslSessionStore::Save(const SSLClientSessionCache::Key& cache_key,
+                                const SSL_SESSION* session) {
+  if (cache_key.dest_ip_addr)
+    return;
+
+  Entry entry;
+  uint8_t* session_bytes = nullptr;
+  size_t session_size = 0;
+  if (!SSL_SESSION_to_bytes(session, &session_bytes, &session_size))
+    return;
+  entry.session.assign(reinterpret_cast<const char*>(session_bytes),
+                       session_size);
+  OPENSSL_free(session_bytes);
+  entry.expiration =
+      SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session);
+
+  base::AutoLock lock(lock_);
+  std::vector<Entry>& entries = entries_[ServerKey(cache_key)];
+  if (entries.size() >= kMaxSessionsPerServer)
+    entries.erase(entries.begin());
+  entries.push_back(std::move(entry));
+  WriteLocked();
+}
+
+bssl::UniquePtr<SSL_SESSION> NaiveSslSessionStore::Take(
+    const SSLClientSessionCache::Key& cache_key) {
+  if (cache_key.dest_ip_addr)
+    return nullptr;
+
+  uint64_t now = static_cast<uint64_t>(base::Time::Now().ToTimeT());
+  base::AutoLock lock(lock_);
+  auto it = entries_.find(ServerKey(cache_key));
+  if (it == entries_.end())
+    return nullptr;
+  std::vector<Entry>& entries = it->second;
+  bssl::UniquePtr<SSL_SESSION> session;
+  while (!entries.empty() && !session) {
+    Entry entry = std::move(entries.back());
+    entries.pop_back();
+    if (entry.expiration <= now)
+      continue;
+    session.reset(SSL_SESSION_from_bytes(
+        reinterpret_cast<const uint8_t*>(entry.session.data()),
+        entry.session.size(), ssl_ctx_.get()));
+  }
+  if (entries.empty())
+    entries_.erase(it);
+  WriteLocked();
+  return session;
+}
+
+void NaiveSslSessionStore::WriteLocked() {
+  if (path_.empty())
+    return;
+  base::Value::Dict servers;
+  for (const auto& [key, entries] : entries_) {
+    base::Value::List list;
+    for (const Entry& entry : entries) {
+      base::Value::Dict entry_dict;
+      entry_dict.Set("session", base::Base64Encode(entry.session));
+      entry_dict.Set("expiration", base::NumberToString(entry.expiration));
+      list.Append(std::move(entry_dict));
+    }
+    servers.Set(key, std::move(list));
+  }
+  base::Value::Dict dict;
+  dict.Set("version", kFileVersion);
+  dict.Set("servers", std::move(servers));
+
+  std::string data;
+  base::JSONWriter::Write(dict, &data);
+  writer_.Write(std::move(data));
+}
+
+}  // namespace net
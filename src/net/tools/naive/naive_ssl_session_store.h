@@ -0,0 +1,72 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_SSL_SESSION_STORE_H_
+#define NET_TOOLS_NAIVE_NAIVE_SSL_SESSION_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "net/ssl/ssl_client_session_cache.h"
+#include "net/tools/naive/naive_file_writer.h"
+#include "third_party/boringssl/src/include/openssl/ssl.h"
+
+namespace net {
+
+// Keeps the TLS sessions of HTTPS proxies in a file, so the first
+// connections after a restart resume instead of doing a full handshake and
+// verifying the certificate again.
+//
+// Like NaiveQuicSessionStore, it backs the session caches of all IO
+// threads, and each session is used once. Sessions are keyed by server and
+// privacy mode only, as the NetworkAnonymizationKeys of tunnel sessions are
+// transient. Sessions keyed by IP address, of RSA key exchange, are not
+// kept. With an empty path, the sessions are only shared between the IO
+// threads.
+class NaiveSslSessionStore : public SSLClientSessionCache::Store {
+ public:
+  static constexpr size_t kMaxSessionsPerServer = 4;
+
+  explicit NaiveSslSessionStore(const base::FilePath& path);
+  ~NaiveSslSessionStore() override;
+  NaiveSslSessionStore(const NaiveSslSessionStore&) = delete;
+  NaiveSslSessionStore& operator=(const NaiveSslSessionStore&) = delete;
+
+  // Reads the sessions saved in the file that have not expired. Returns
+  // the number of sessions read.
+  size_t Load();
+
+  // SSLClientSessionCache::Store:
+  void Save(const SSLClientSessionCache::Key& cache_key,
+            const SSL_SESSION* session) override;
+  bssl::UniquePtr<SSL_SESSION> Take(
+      const SSLClientSessionCache::Key& cache_key) override;
+
+ private:
+  struct Entry {
+    std::string session;
+    // In UNIX seconds.
+    uint64_t expiration = 0;
+  };
+
+  static std::string ServerKey(const SSLClientSessionCache::Key& cache_key);
+
+  void WriteLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const base::FilePath path_;
+  NaiveFileWriter writer_;
+  // Parses the saved sessions.
+  bssl::UniquePtr<SSL_CTX> ssl_ctx_;
+  base::Lock lock_;
+  // Keyed by ServerKey(), oldest first.
+  std::map<std::string, std::vector<Entry>> entries_ GUARDED_BY(lock_);
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_SSL_SESSION_STORE_H_
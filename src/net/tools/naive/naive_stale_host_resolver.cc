@@ -0,0 +1,503 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_stale_host_resolver.h"
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/functional/bind.h"
+#include "base/functional/callback_helpers.h"
+#include "net/base/address_family.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/dns/public/host_resolver_results.h"
+#include "net/dns/public/host_resolver_source.h"
+#include "net/dns/public/resolve_error_info.h"
+#include "net/tools/naive/naive_host_cache_store.h"
+#include "net/tools/naive/naive_popular_hosts.h"
+#include "net/tools/naive/naive_shared_host_cache.h"
+
+namespace net {
+
+// Answers from the cache, stale or not, if it can, or else waits for the
+// wrapped resolver.
+class NaiveStaleHostResolver::Request
+    : public HostResolver::ResolveHostRequest {
+ public:
+  Request(base::WeakPtr<NaiveStaleHostResolver> resolver,
+          std::string key,
+          std::unique_ptr<ResolveHostRequest> stale_request,
+          std::unique_ptr<ResolveHostRequest> request)
+      : resolver_(std::move(resolver)),
+        key_(std::move(key)),
+        stale_request_(std::move(stale_request)),
+        request_(std::move(request)) {}
+  Request(const Request&) = delete;
+  Request& operator=(const Request&) = delete;
+  ~Request() override = default;
+
+  int Start(CompletionOnceCallback callback) override {
+    // Lookups of the cache only complete synchronously, unless they wait for
+    // an IPv6 probe, and then are not worth waiting for.
+    int rv = stale_request_->Start(base::DoNothing());
+    bool refresh = false;
+    if (rv != ERR_IO_PENDING &&
+        UsesCachedResult(rv, stale_request_->GetStaleInfo(), &refresh)) {
+      result_ = stale_request_.get();
+      if (refresh && resolver_)
+        resolver_->Refresh(key_, std::move(request_));
+      return rv;
+    }
+
+    result_ = request_.get();
+    stale_request_.reset();
+    return request_->Start(std::move(callback));
+  }
+
+  const AddressList* GetAddressResults() const override {
+    return result_->GetAddressResults();
+  }
+  const std::vector<HostResolverEndpointResult>* GetEndpointResults()
+      const override {
+    return result_->GetEndpointResults();
+  }
+  const std::vector<std::string>* GetTextResults() const override {
+    return result_->GetTextResults();
+  }
+  const std::vector<HostPortPair>* GetHostnameResults() const override {
+    return result_->GetHostnameResults();
+  }
+  const std::set<std::string>* GetDnsAliasResults() const override {
+    return result_->GetDnsAliasResults();
+  }
+  ResolveErrorInfo GetResolveErrorInfo() const override {
+    return result_->GetResolveErrorInfo();
+  }
+  const std::optional<HostCache::EntryStaleness>& GetStaleInfo()
+      const override {
+    return result_->GetStaleInfo();
+  }
+  void ChangeRequestPriority(RequestPriority priority) override {
+    if (request_ && result_ == request_.get())
+      request_->ChangeRequestPriority(priority);
+  }
+
+ private:
+  base::WeakPtr<NaiveStaleHostResolver> resolver_;
+  const std::string key_;
+  std::unique_ptr<ResolveHostRequest> stale_request_;
+  std::unique_ptr<ResolveHostRequest> request_;
+  // Whichever of the two answered.
+  raw_ptr<ResolveHostRequest> result_ = nullptr;
+};
+
+// Answers from the cache as Request does, or else passes on the endpoints of
+// the wrapped resolver as they are resolved.
+class NaiveStaleHostResolver::EndpointRequest
+    : public HostResolver::ServiceEndpointRequest {
+ public:
+  EndpointRequest(base::WeakPtr<NaiveStaleHostResolver> resolver,
+                  std::string key,
+                  std::unique_ptr<ResolveHostRequest> stale_request,
+                  std::unique_ptr<ResolveHostRequest> refresh_request,
+                  std::unique_ptr<ServiceEndpointRequest> request)
+      : resolver_(std::move(resolver)),
+        key_(std::move(key)),
+        stale_request_(std::move(stale_request)),
+        refresh_request_(std::move(refresh_request)),
+        request_(std::move(request)) {}
+  EndpointRequest(const EndpointRequest&) = delete;
+  EndpointRequest& operator=(const EndpointRequest&) = delete;
+  ~EndpointRequest() override = default;
+
+  int Start(Delegate* delegate) override {
+    int rv = stale_request_->Start(base::DoNothing());
+    bool refresh = false;
+    if (rv != ERR_IO_PENDING &&
+        UsesCachedResult(rv, stale_request_->GetStaleInfo(), &refresh)) {
+      if (const auto* results = stale_request_->GetEndpointResults()) {
+        for (const HostResolverEndpointResult& result : *results)
+          endpoints_.push_back(ToServiceEndpoint(result));
+      }
+      if (const auto* aliases = stale_request_->GetDnsAliasResults())
+        dns_aliases_ = *aliases;
+      resolve_error_info_ = stale_request_->GetResolveErrorInfo();
+      stale_request_.reset();
+      request_.reset();
+      if (refresh && resolver_)
+        resolver_->Refresh(key_, std::move(refresh_request_));
+      return rv;
+    }
+
+    stale_request_.reset();
+    refresh_request_.reset();
+    return request_->Start(delegate);
+  }
+
+  const std::vector<ServiceEndpoint>& GetEndpointResults() override {
+    return request_ ? request_->GetEndpointResults() : endpoints_;
+  }
+  const std::set<std::string>& GetDnsAliasResults() override {
+    return request_ ? request_->GetDnsAliasResults() : dns_aliases_;
+  }
+  bool EndpointsCryptoReady() override {
+    return request_ ? request_->EndpointsCryptoReady() : true;
+  }
+  ResolveErrorInfo GetResolveErrorInfo() override {
+    return request_ ? request_->GetResolveErrorInfo() : resolve_error_info_;
+  }
+  void ChangeRequestPriority(RequestPriority priority) override {
+    if (request_)
+      request_->ChangeRequestPriority(priority);
+  }
+
+ private:
+  static ServiceEndpoint ToServiceEndpoint(
+      const HostResolverEndpointResult& result) {
+    ServiceEndpoint endpoint;
+    for (const IPEndPoint& ip_endpoint : result.ip_endpoints) {
+      if (ip_endpoint.GetFamily() == ADDRESS_FAMILY_IPV6)
+        endpoint.ipv6_endpoints.push_back(ip_endpoint);
+      else
+        endpoint.ipv4_endpoints.push_back(ip_endpoint);
+    }
+    endpoint.metadata = result.metadata;
+    return endpoint;
+  }
+
+  base::WeakPtr<NaiveStaleHostResolver> resolver_;
+  const std::string key_;
+  std::unique_ptr<ResolveHostRequest> stale_request_;
+  std::unique_ptr<ResolveHostRequest> refresh_request_;
+  // Null if the cache answered.
+  std::unique_ptr<ServiceEndpointRequest> request_;
+  // What the cache answered.
+  std::vector<ServiceEndpoint> endpoints_;
+  std::set<std::string> dns_aliases_;
+  ResolveErrorInfo resolve_error_info_;
+};
+
+NaiveStaleHostResolver::Factory::Factory(
+    ManagerOptions options,
+    base::flat_set<std::string> stale_hosts,
+    bool prefetch_popular_hosts,
+    NaiveHostCacheStore* store,
+    NaiveSharedHostCache* shared_cache)
+    : options_(std::move(options)),
+      stale_hosts_(std::move(stale_hosts)),
+      prefetch_popular_hosts_(prefetch_popular_hosts),
+      store_(store),
+      shared_cache_(shared_cache) {}
+
+NaiveStaleHostResolver::Factory::~Factory() = default;
+
+std::unique_ptr<HostResolver>
+NaiveStaleHostResolver::Factory::CreateStandaloneResolver(
+    NetLog* net_log,
+    const ManagerOptions& options,
+    std::string_view host_mapping_rules,
+    bool enable_caching) {
+  return std::make_unique<NaiveStaleHostResolver>(
+      HostResolver::Factory::CreateStandaloneResolver(
+          net_log, options_, host_mapping_rules, enable_caching),
+      stale_hosts_, prefetch_popular_hosts_, store_, shared_cache_);
+}
+
+NaiveStaleHostResolver::NaiveStaleHostResolver(
+    std::unique_ptr<HostResolver> impl,
+    base::flat_set<std::string> stale_hosts,
+    bool prefetch_popular_hosts,
+    NaiveHostCacheStore* store,
+    NaiveSharedHostCache* shared_cache)
+    : impl_(std::move(impl)),
+      stale_hosts_(std::move(stale_hosts)),
+      store_(store),
+      shared_cache_(shared_cache) {
+  if (store_)
+    slot_ = store_->AddSlot();
+  if (prefetch_popular_hosts)
+    popular_hosts_ = std::make_unique<NaivePopularHosts>(kPrefetchHosts);
+}
+
+NaiveStaleHostResolver::~NaiveStaleHostResolver() {
+  HostCache* cache = impl_->GetHostCache();
+  if (store_ && cache)
+    cache->set_persistence_delegate(nullptr);
+}
+
+void NaiveStaleHostResolver::OnShutdown() {
+  prefetch_timer_.Stop();
+  prefetch_targets_.clear();
+  refreshes_.clear();
+  impl_->OnShutdown();
+}
+
+std::unique_ptr<HostResolver::ResolveHostRequest>
+NaiveStaleHostResolver::CreateRequest(
+    url::SchemeHostPort host,
+    NetworkAnonymizationKey network_anonymization_key,
+    NetLogWithSource net_log,
+    std::optional<ResolveHostParameters> optional_parameters) {
+  network_anonymization_key = CacheKey(network_anonymization_key);
+  std::string key = host.Serialize();
+  RecordLookup(key, host, network_anonymization_key, optional_parameters);
+  if (!CanServeStale(host.host(), optional_parameters)) {
+    return impl_->CreateRequest(
+        std::move(host), std::move(network_anonymization_key),
+        std::move(net_log), std::move(optional_parameters));
+  }
+  auto stale_request =
+      impl_->CreateRequest(host, network_anonymization_key, net_log,
+                           StaleParameters(optional_parameters));
+  auto request = impl_->CreateRequest(
+      std::move(host), std::move(network_anonymization_key),
+      std::move(net_log), RefreshParameters(optional_parameters));
+  return std::make_unique<Request>(weak_ptr_factory_.GetWeakPtr(),
+                                   std::move(key), std::move(stale_request),
+                                   std::move(request));
+}
+
+std::unique_ptr<HostResolver::ResolveHostRequest>
+NaiveStaleHostResolver::CreateRequest(
+    const HostPortPair& host,
+    const NetworkAnonymizationKey& network_anonymization_key,
+    const NetLogWithSource& net_log,
+    const std::optional<ResolveHostParameters>& optional_parameters) {
+  NetworkAnonymizationKey cache_key = CacheKey(network_anonymization_key);
+  if (!CanServeStale(host.host(), optional_parameters)) {
+    return impl_->CreateRequest(host, cache_key, net_log, optional_parameters);
+  }
+  return std::make_unique<Request>(
+      weak_ptr_factory_.GetWeakPtr(), host.ToString(),
+      impl_->CreateRequest(host, cache_key, net_log,
+                           StaleParameters(optional_parameters)),
+      impl_->CreateRequest(host, cache_key, net_log,
+                           RefreshParameters(optional_parameters)));
+}
+
+std::unique_ptr<HostResolver::ServiceEndpointRequest>
+NaiveStaleHostResolver::CreateServiceEndpointRequest(
+    Host host,
+    NetworkAnonymizationKey network_anonymization_key,
+    NetLogWithSource net_log,
+    ResolveHostParameters parameters) {
+  network_anonymization_key = CacheKey(network_anonymization_key);
+  std::string key = host.ToString();
+  if (host.HasScheme()) {
+    RecordLookup(key, host.AsSchemeHostPort(), network_anonymization_key,
+                 parameters);
+  }
+  if (!CanServeStale(host.GetHostnameWithoutBrackets(), parameters)) {
+    return impl_->CreateServiceEndpointRequest(
+        std::move(host), std::move(network_anonymization_key),
+        std::move(net_log), std::move(parameters));
+  }
+  auto create_request = [&](ResolveHostParameters request_parameters) {
+    if (host.HasScheme()) {
+      return impl_->CreateRequest(host.AsSchemeHostPort(),
+                                  network_anonymization_key, net_log,
+                                  std::move(request_parameters));
+    }
+    return impl_->CreateRequest(
+        HostPortPair(host.GetHostnameWithoutBrackets(), host.GetPort()),
+        network_anonymization_key, net_log, std::move(request_parameters));
+  };
+  auto stale_request = create_request(StaleParameters(parameters));
+  auto refresh_request = create_request(RefreshParameters(parameters));
+  auto request = impl_->CreateServiceEndpointRequest(
+      std::move(host), network_anonymization_key, std::move(net_log),
+      parameters);
+  return std::make_unique<EndpointRequest>(
+      weak_ptr_factory_.GetWeakPtr(), std::move(key), std::move(stale_request),
+      std::move(refresh_request), std::move(request));
+}
+
+std::unique_ptr<HostResolver::ProbeRequest>
+NaiveStaleHostResolver::CreateDohProbeRequest() {
+  return impl_->CreateDohProbeRequest();
+}
+
+HostCache* NaiveStaleHostResolver::GetHostCache() {
+  return impl_->GetHostCache();
+}
+
+base::Value::Dict NaiveStaleHostResolver::GetDnsConfigAsValue() const {
+  return impl_->GetDnsConfigAsValue();
+}
+
+void NaiveStaleHostResolver::SetRequestContext(
+    URLRequestContext* request_context) {
+  impl_->SetRequestContext(request_context);
+
+  if (popular_hosts_) {
+    last_decay_time_ = base::TimeTicks::Now();
+    prefetch_timer_.Start(FROM_HERE, kPrefetchInterval, this,
+                          &NaiveStaleHostResolver::Prefetch);
+  }
+
+  HostCache* cache = impl_->GetHostCache();
+  if (shared_cache_ && cache)
+    cache->set_store(shared_cache_);
+  if (!store_ || !cache)
+    return;
+  cache->RestoreFromListValue(store_->GetLoadedEntries());
+  cache->set_persistence_delegate(this);
+}
+
+HostResolverManager* NaiveStaleHostResolver::GetManagerForTesting() {
+  return impl_->GetManagerForTesting();
+}
+
+void NaiveStaleHostResolver::ScheduleWrite() {
+  if (save_timer_.IsRunning())
+    return;
+  save_timer_.Start(FROM_HERE, kSaveDelay,
+                    base::BindOnce(&NaiveStaleHostResolver::Save,
+                                   base::Unretained(this)));
+}
+
+bool NaiveStaleHostResolver::CanServeStale(
+    std::string_view host,
+    const std::optional<ResolveHostParameters>& p) const {
+  if (!store_ && !stale_hosts_.contains(host))
+    return false;
+  return UsesCache(p);
+}
+
+// static
+bool NaiveStaleHostResolver::UsesCachedResult(
+    int rv,
+    const std::optional<HostCache::EntryStaleness>& stale_info,
+    bool* refresh) {
+  if (!stale_info) {
+    // IP literals and the hosts file.
+    *refresh = false;
+    return rv == OK;
+  }
+  if (!stale_info->is_stale()) {
+    // Fresh entries, including those of errors.
+    *refresh = rv == OK && stale_info->expired_by > -kRefreshAhead;
+    return true;
+  }
+  *refresh = rv == OK && stale_info->expired_by <= kMaxStaleness;
+  return *refresh;
+}
+
+// static
+bool NaiveStaleHostResolver::UsesCache(
+    const std::optional<ResolveHostParameters>& p) {
+  return !p || (p->source == HostResolverSource::ANY &&
+                p->cache_usage == ResolveHostParameters::CacheUsage::ALLOWED);
+}
+
+// static
+NetworkAnonymizationKey NaiveStaleHostResolver::CacheKey(
+    const NetworkAnonymizationKey& network_anonymization_key) {
+  if (network_anonymization_key.IsTransient())
+    return NetworkAnonymizationKey();
+  return network_anonymization_key;
+}
+
+// static
+HostResolver::ResolveHostParameters NaiveStaleHostResolver::StaleParameters(
+    const std::optional<ResolveHostParameters>& p) {
+  ResolveHostParameters parameters = p.value_or(ResolveHostParameters());
+  parameters.source = HostResolverSource::LOCAL_ONLY;
+  parameters.cache_usage = ResolveHostParameters::CacheUsage::STALE_ALLOWED;
+  return parameters;
+}
+
+// static
+HostResolver::ResolveHostParameters NaiveStaleHostResolver::RefreshParameters(
+    const std::optional<ResolveHostParameters>& p) {
+  // The entry may still be fresh. Results are cached all the same.
+  ResolveHostParameters parameters = p.value_or(ResolveHostParameters());
+  parameters.cache_usage = ResolveHostParameters::CacheUsage::DISALLOWED;
+  return parameters;
+}
+
+void NaiveStaleHostResolver::Refresh(
+    const std::string& key,
+    std::unique_ptr<ResolveHostRequest> request) {
+  if (refreshes_.contains(key))
+    return;
+  ResolveHostRequest* raw_request = request.get();
+  refreshes_[key] = std::move(request);
+  int rv = raw_request->Start(
+      base::BindOnce(&NaiveStaleHostResolver::OnRefreshComplete,
+                     weak_ptr_factory_.GetWeakPtr(), key));
+  if (rv != ERR_IO_PENDING)
+    refreshes_.erase(key);
+}
+
+void NaiveStaleHostResolver::OnRefreshComplete(const std::string& key,
+                                               int result) {
+  // The resolver put the result in the cache.
+  refreshes_.erase(key);
+}
+
+void NaiveStaleHostResolver::RecordLookup(
+    const std::string& key,
+    const url::SchemeHostPort& host,
+    const NetworkAnonymizationKey& network_anonymization_key,
+    const std::optional<ResolveHostParameters>& parameters) {
+  if (!popular_hosts_ || !UsesCache(parameters))
+    return;
+  if (!popular_hosts_->Record(key) || prefetch_targets_.contains(key))
+    return;
+  prefetch_targets_.emplace(
+      key, PrefetchTarget{host, network_anonymization_key, parameters});
+}
+
+void NaiveStaleHostResolver::Prefetch() {
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (now - last_decay_time_ >= kPopularityHalfLife) {
+    popular_hosts_->Decay();
+    last_decay_time_ = now;
+  }
+
+  std::map<std::string, PrefetchTarget> targets;
+  for (std::string& key : popular_hosts_->GetTop()) {
+    auto it = prefetch_targets_.find(key);
+    if (it != prefetch_targets_.end())
+      targets.emplace(std::move(key), std::move(it->second));
+  }
+  prefetch_targets_ = std::move(targets);
+
+  for (const auto& [key, target] : prefetch_targets_) {
+    auto stale_request = impl_->CreateRequest(
+        target.host, target.network_anonymization_key, NetLogWithSource(),
+        StaleParameters(target.parameters));
+    int rv = stale_request->Start(base::DoNothing());
+    if (rv == ERR_IO_PENDING)
+      continue;
+    const std::optional<HostCache::EntryStaleness>& stale_info =
+        stale_request->GetStaleInfo();
+    // IP literals and the hosts file need no DNS.
+    if (rv == OK && !stale_info)
+      continue;
+    // Entries that expire before the next check are refreshed now, and
+    // evicted ones at once.
+    if (stale_info && !stale_info->is_stale() &&
+        stale_info->expired_by <= -(kPrefetchInterval + kRefreshAhead)) {
+      continue;
+    }
+    Refresh(key, impl_->CreateRequest(target.host,
+                                      target.network_anonymization_key,
+                                      NetLogWithSource(),
+                                      RefreshParameters(target.parameters)));
+  }
+}
+
+void NaiveStaleHostResolver::Save() {
+  base::Value::List entries;
+  impl_->GetHostCache()->GetList(entries, /*include_staleness=*/false,
+                                 HostCache::SerializationType::kRestorable);
+  store_->Save(slot_, std::move(entries));
+}
+
+}  // namespace net
@@ -0,0 +1,190 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_STALE_HOST_RESOLVER_H_
+#define NET_TOOLS_NAIVE_NAIVE_STALE_HOST_RESOLVER_H_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "base/containers/flat_set.h"
+#include "base/memory/raw_ptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "base/values.h"
+#include "net/base/network_anonymization_key.h"
+#include "net/dns/host_cache.h"
+#include "net/dns/host_resolver.h"
+#include "net/log/net_log_with_source.h"
+#include "url/scheme_host_port.h"
+
+namespace net {
+
+class NaiveHostCacheStore;
+class NaivePopularHosts;
+class NaiveSharedHostCache;
+
+// Resolves hosts from the host cache even when its entries are stale, and
+// refreshes a stale entry in the background instead of waiting for it. An
+// entry used within kRefreshAhead of its expiry is refreshed too, so a host
+// in steady use does not wait for DNS at all. Only a host without an entry,
+// or with one expired by more than kMaxStaleness, waits.
+//
+// This applies to `stale_hosts`, the proxies, and with a NaiveHostCacheStore
+// to all hosts. The cache is then restored from the store, whose entries are
+// all stale after a restart, and saved to it kSaveDelay after it changes, so
+// the first connections after a restart do not wait for DNS. Requests with a
+// `source` or `cache_usage` of their own go to the wrapped resolver as they
+// are.
+//
+// Transient NetworkAnonymizationKeys, which Naive gives its tunnel sessions,
+// are dropped from all requests, so the sessions share cache entries and
+// concurrent lookups of a host.
+//
+// With a NaiveSharedHostCache, the cache shares its entries with those of
+// the other IO threads.
+//
+// With `prefetch_popular_hosts`, the kPrefetchHosts most looked up hosts,
+// by NaivePopularHosts, are checked every kPrefetchInterval and refreshed
+// before they expire, so they are always found in the cache.
+class NaiveStaleHostResolver : public HostResolver,
+                               public HostCache::PersistenceDelegate {
+ public:
+  static constexpr base::TimeDelta kMaxStaleness = base::Days(1);
+  static constexpr base::TimeDelta kRefreshAhead = base::Seconds(10);
+  static constexpr base::TimeDelta kSaveDelay = base::Minutes(1);
+  // Cache entries of each resolver of a server, which resolves the many
+  // destinations of its clients.
+  static constexpr size_t kServerHostCacheSize = 1 << 16;
+  // UDP sockets per nameserver each resolver of a server keeps between
+  // queries, rather than opening one per query.
+  static constexpr size_t kServerDnsUdpSockets = 32;
+  static constexpr size_t kPrefetchHosts = 128;
+  static constexpr base::TimeDelta kPrefetchInterval = base::Seconds(10);
+  // Lookup counts are halved this often.
+  static constexpr base::TimeDelta kPopularityHalfLife = base::Minutes(1);
+
+  // Creates the standalone resolvers of URLRequestContextBuilder wrapped in
+  // NaiveStaleHostResolvers, with `options` instead of the builder's
+  // defaults. `store` and `shared_cache` may be null, and must outlive the
+  // resolvers.
+  class Factory : public HostResolver::Factory {
+   public:
+    Factory(ManagerOptions options,
+            base::flat_set<std::string> stale_hosts,
+            bool prefetch_popular_hosts,
+            NaiveHostCacheStore* store,
+            NaiveSharedHostCache* shared_cache);
+    ~Factory() override;
+
+    std::unique_ptr<HostResolver> CreateStandaloneResolver(
+        NetLog* net_log,
+        const ManagerOptions& options,
+        std::string_view host_mapping_rules,
+        bool enable_caching) override;
+
+   private:
+    const ManagerOptions options_;
+    const base::flat_set<std::string> stale_hosts_;
+    const bool prefetch_popular_hosts_;
+    raw_ptr<NaiveHostCacheStore> store_;
+    raw_ptr<NaiveSharedHostCache> shared_cache_;
+  };
+
+  NaiveStaleHostResolver(std::unique_ptr<HostResolver> impl,
+                         base::flat_set<std::string> stale_hosts,
+                         bool prefetch_popular_hosts,
+                         NaiveHostCacheStore* store,
+                         NaiveSharedHostCache* shared_cache);
+  ~NaiveStaleHostResolver() override;
+  NaiveStaleHostResolver(const NaiveStaleHostResolver&) = delete;
+  NaiveStaleHostResolver& operator=(const NaiveStaleHostResolver&) = delete;
+
+  // HostResolver:
+  void OnShutdown() override;
+  std::unique_ptr<ResolveHostRequest> CreateRequest(
+      url::SchemeHostPort host,
+      NetworkAnonymizationKey network_anonymization_key,
+      NetLogWithSource net_log,
+      std::optional<ResolveHostParameters> optional_parameters) override;
+  std::unique_ptr<ResolveHostRequest> CreateRequest(
+      const HostPortPair& host,
+      const NetworkAnonymizationKey& network_anonymization_key,
+      const NetLogWithSource& net_log,
+      const std::optional<ResolveHostParameters>& optional_parameters) override;
+  std::unique_ptr<ServiceEndpointRequest> CreateServiceEndpointRequest(
+      Host host,
+      NetworkAnonymizationKey network_anonymization_key,
+      NetLogWithSource net_log,
+      ResolveHostParameters parameters) override;
+  std::unique_ptr<ProbeRequest> CreateDohProbeRequest() override;
+  HostCache* GetHostCache() override;
+  base::Value::Dict GetDnsConfigAsValue() const override;
+  void SetRequestContext(URLRequestContext* request_context) override;
+  HostResolverManager* GetManagerForTesting() override;
+
+  // HostCache::PersistenceDelegate:
+  void ScheduleWrite() override;
+
+ private:
+  class Request;
+  class EndpointRequest;
+
+  struct PrefetchTarget {
+    url::SchemeHostPort host;
+    NetworkAnonymizationKey network_anonymization_key;
+    std::optional<ResolveHostParameters> parameters;
+  };
+
+  bool CanServeStale(std::string_view host,
+                     const std::optional<ResolveHostParameters>& p) const;
+  // Whether a cache lookup that returned `rv` answers the request, and
+  // whether the entry should then be refreshed.
+  static bool UsesCachedResult(
+      int rv,
+      const std::optional<HostCache::EntryStaleness>& stale_info,
+      bool* refresh);
+  // Whether a request with `p` uses the cache as by default.
+  static bool UsesCache(const std::optional<ResolveHostParameters>& p);
+  static NetworkAnonymizationKey CacheKey(
+      const NetworkAnonymizationKey& network_anonymization_key);
+  static ResolveHostParameters StaleParameters(
+      const std::optional<ResolveHostParameters>& p);
+  static ResolveHostParameters RefreshParameters(
+      const std::optional<ResolveHostParameters>& p);
+
+  // Starts `request` to refresh the entry of `key`, unless one is running.
+  void Refresh(const std::string& key,
+               std::unique_ptr<ResolveHostRequest> request);
+  void OnRefreshComplete(const std::string& key, int result);
+  // Counts a lookup for NaivePopularHosts.
+  void RecordLookup(const std::string& key,
+                    const url::SchemeHostPort& host,
+                    const NetworkAnonymizationKey& network_anonymization_key,
+                    const std::optional<ResolveHostParameters>& parameters);
+  void Prefetch();
+  void Save();
+
+  std::unique_ptr<HostResolver> impl_;
+  const base::flat_set<std::string> stale_hosts_;
+  raw_ptr<NaiveHostCacheStore> store_;
+  raw_ptr<NaiveSharedHostCache> shared_cache_;
+  size_t slot_ = 0;
+  base::OneShotTimer save_timer_;
+  std::map<std::string, std::unique_ptr<ResolveHostRequest>> refreshes_;
+  // Null unless prefetching.
+  std::unique_ptr<NaivePopularHosts> popular_hosts_;
+  // Of the top popular hosts, by key.
+  std::map<std::string, PrefetchTarget> prefetch_targets_;
+  base::RepeatingTimer prefetch_timer_;
+  base::TimeTicks last_decay_time_;
+  base::WeakPtrFactory<NaiveStaleHostResolver> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_STALE_HOST_RESOLVER_H_
@@ -0,0 +1,264 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_standby_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/raw_ptr.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/notreached.h"
+#include "base/task/single_thread_task_runner.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_anonymization_key.h"
+#include "net/base/privacy_mode.h"
+#include "net/base/proxy_chain.h"
+#include "net/base/proxy_server.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_proxy_connect_job.h"
+#include "net/proxy_resolution/proxy_info.h"
+#include "net/socket/connect_job_factory.h"
+#include "net/socket/connect_job_params.h"
+#include "net/socket/connect_job_params_factory.h"
+#include "net/socket/next_proto.h"
+#include "net/socket/socket_tag.h"
+#include "net/socket/ssl_connect_job.h"
+#include "net/socket/stream_socket.h"
+#include "net/socket/transport_connect_job.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "third_party/abseil-cpp/absl/base/attributes.h"
+#include "url/scheme_host_port.h"
+#include "url/url_constants.h"
+
+namespace net {
+
+namespace {
+ABSL_CONST_INIT thread_local NaiveStandbyPool* current_pool = nullptr;
+}  // namespace
+
+// The standby connections to the proxy of one chain, connected the way
+// HttpProxyConnectJob connects its nested socket, one at a time.
+class NaiveStandbyPool::Target : public ConnectJob::Delegate {
+ public:
+  Target(const CommonConnectJobParams* common_connect_job_params,
+         scoped_refptr<HttpProxySocketParams> params,
+         size_t num_connections)
+      : common_connect_job_params_(common_connect_job_params),
+        params_(std::move(params)),
+        num_connections_(num_connections) {}
+  ~Target() override = default;
+  Target(const Target&) = delete;
+  Target& operator=(const Target&) = delete;
+
+  const ProxyChain& proxy_chain() const { return params_->proxy_chain(); }
+
+  std::unique_ptr<StreamSocket> Take() {
+    DropStale();
+    if (connections_.empty())
+      return nullptr;
+    // The oldest first, so that the others stay within kMaxIdleTime for
+    // longer.
+    std::unique_ptr<StreamSocket> socket =
+        std::move(connections_.front().socket);
+    connections_.erase(connections_.begin());
+    Check();
+    return socket;
+  }
+
+  // Connects another connection if there are too few and it is not
+  // backing off.
+  void Check() {
+    DropStale();
+    if (disabled_ || connect_job_ || connections_.size() >= num_connections_)
+      return;
+    if (base::TimeTicks::Now() < next_attempt_time_)
+      return;
+    Connect();
+  }
+
+  void Reset() {
+    connections_.clear();
+    backoff_ = base::TimeDelta();
+    next_attempt_time_ = base::TimeTicks();
+  }
+
+ private:
+  struct Connection {
+    std::unique_ptr<StreamSocket> socket;
+    base::TimeTicks connect_time;
+  };
+
+  // Drops the connections the proxy may have closed, and those it has.
+  void DropStale() {
+    base::TimeTicks now = base::TimeTicks::Now();
+    std::erase_if(connections_, [&](const Connection& connection) {
+      return now - connection.connect_time >= kMaxIdleTime ||
+             !connection.socket->IsConnectedAndIdle();
+    });
+  }
+
+  void BackOff() {
+    backoff_ = std::clamp(backoff_ * 2, kMinBackoff, kMaxBackoff);
+    next_attempt_time_ = base::TimeTicks::Now() + backoff_;
+  }
+
+  void Connect() {
+    if (params_->is_over_ssl()) {
+      connect_job_ = std::make_unique<SSLConnectJob>(
+          IDLE, SocketTag(), common_connect_job_params_,
+          params_->ssl_params(), this, /*net_log=*/nullptr);
+    } else {
+      connect_job_ = std::make_unique<TransportConnectJob>(
+          IDLE, SocketTag(), common_connect_job_params_,
+          params_->transport_params(), this, /*net_log=*/nullptr);
+    }
+    int rv = connect_job_->Connect();
+    if (rv != ERR_IO_PENDING)
+      OnConnectJobComplete(rv, connect_job_.get());
+  }
+
+  // ConnectJob::Delegate:
+  void OnConnectJobComplete(int result, ConnectJob* job) override {
+    DCHECK_EQ(job, connect_job_.get());
+    std::unique_ptr<ConnectJob> connect_job = std::move(connect_job_);
+    if (result != OK) {
+      LOG(WARNING) << "Failed to connect standby connection to "
+                   << params_->proxy_server() << ": "
+                   << ErrorToShortString(result);
+      BackOff();
+      return;
+    }
+    std::unique_ptr<StreamSocket> socket = connect_job->PassSocket();
+    if (socket->GetNegotiatedProtocol() == kProtoHTTP2) {
+      // Tunnels share a session then, which NaiveSessionWarmer keeps.
+      LOG(INFO) << "Not keeping standby connections to "
+                << params_->proxy_server() << " with HTTP/2";
+      disabled_ = true;
+      return;
+    }
+    backoff_ = base::TimeDelta();
+    connections_.push_back({std::move(socket), base::TimeTicks::Now()});
+    Check();
+  }
+
+  void OnNeedsProxyAuth(const HttpResponseInfo& response,
+                        HttpAuthController* auth_controller,
+                        base::OnceClosure restart_with_auth_callback,
+                        ConnectJob* job) override {
+    // Only proxy connect jobs ask for credentials.
+    NOTREACHED();
+  }
+
+  raw_ptr<const CommonConnectJobParams> common_connect_job_params_;
+  scoped_refptr<HttpProxySocketParams> params_;
+  const size_t num_connections_;
+
+  std::vector<Connection> connections_;
+  std::unique_ptr<ConnectJob> connect_job_;
+
+  // Set for proxies with HTTP/2.
+  bool disabled_ = false;
+  base::TimeDelta backoff_;
+  base::TimeTicks next_attempt_time_;
+};
+
+NaiveStandbyPool::NaiveStandbyPool(
+    HttpNetworkSession* session,
+    const NaiveProxySelector& proxy_selector,
+    size_t num_chains,
+    size_t num_connections,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : common_connect_job_params_(session->CreateCommonConnectJobParams()) {
+  CHECK_EQ(current_pool, nullptr);
+  current_pool = this;
+
+  for (size_t chain = 0; chain < num_chains && num_connections > 0;
+       ++chain) {
+    NaiveProxySelector::Selection selection{chain, 0};
+    const ProxyChain& proxy_chain =
+        proxy_selector.proxy_info(selection).proxy_chain();
+    // Tunnels through longer chains are connected through the proxies
+    // before the last.
+    if (proxy_chain.length() != 1)
+      continue;
+    const ProxyServer& proxy_server = proxy_chain.First();
+    if (!proxy_server.is_http() && !proxy_server.is_https())
+      continue;
+    // The endpoint only names the target of the CONNECT, which is sent by
+    // the tunnel taking the connection.
+    const HostPortPair& proxy = proxy_server.host_port_pair();
+    ConnectJobParams params = ConstructConnectJobParams(
+        url::SchemeHostPort(url::kHttpScheme, proxy.host(), proxy.port()),
+        proxy_chain, traffic_annotation, /*allowed_bad_certs=*/{},
+        ConnectJobFactory::AlpnMode::kHttpAll, /*force_tunnel=*/true,
+        PRIVACY_MODE_DISABLED, OnHostResolutionCallback(),
+        proxy_selector.network_anonymization_key(selection),
+        SecureDnsPolicy::kDisable, /*disable_cert_network_fetches=*/false,
+        &common_connect_job_params_, NetworkAnonymizationKey());
+    targets_.push_back(std::make_unique<Target>(
+        &common_connect_job_params_, params.take_http_proxy(),
+        num_connections));
+  }
+  if (targets_.empty())
+    return;
+
+  NetworkChangeNotifier::AddNetworkChangeObserver(this);
+  check_timer_.Start(FROM_HERE, kCheckInterval, this,
+                     &NaiveStandbyPool::CheckTargets);
+  // Leaves the first round to the next task, once the listeners are up.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveStandbyPool::CheckTargets,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+NaiveStandbyPool::~NaiveStandbyPool() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  DCHECK_EQ(current_pool, this);
+  current_pool = nullptr;
+  if (!targets_.empty())
+    NetworkChangeNotifier::RemoveNetworkChangeObserver(this);
+}
+
+// static
+NaiveStandbyPool* NaiveStandbyPool::GetForCurrentThread() {
+  return current_pool;
+}
+
+std::unique_ptr<StreamSocket> NaiveStandbyPool::Take(
+    const ProxyChain& proxy_chain) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  for (const auto& target : targets_) {
+    if (target->proxy_chain() == proxy_chain)
+      return target->Take();
+  }
+  return nullptr;
+}
+
+void NaiveStandbyPool::OnNetworkChanged(
+    NetworkChangeNotifier::ConnectionType type) {
+  if (type == NetworkChangeNotifier::CONNECTION_NONE)
+    return;
+  // The connections of the old network may be gone without notice.
+  for (const auto& target : targets_)
+    target->Reset();
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&NaiveStandbyPool::CheckTargets,
+                     weak_ptr_factory_.GetWeakPtr()),
+      kNetworkChangeDelay);
+}
+
+void NaiveStandbyPool::CheckTargets() {
+  for (const auto& target : targets_)
+    target->Check();
+}
+
+}  // namespace net
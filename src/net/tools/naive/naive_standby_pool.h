@@ -0,0 +1,85 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_STANDBY_POOL_H_
+#define NET_TOOLS_NAIVE_NAIVE_STANDBY_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "base/memory/weak_ptr.h"
+#include "base/threading/thread_checker.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/network_change_notifier.h"
+#include "net/socket/connect_job.h"
+
+namespace net {
+
+class HttpNetworkSession;
+class NaiveProxySelector;
+class ProxyChain;
+class StreamSocket;
+struct NetworkTrafficAnnotationTag;
+
+// Keeps connections to HTTP/1.1 proxies connected ahead of the tunnels.
+// HttpProxyClientSocket sends one CONNECT per connection, so each tunnel
+// through such a proxy otherwise waits for the TCP and TLS handshakes of its
+// own connection. A tunnel that takes a standby connection only waits for
+// its CONNECT, and a replacement is connected right away.
+//
+// Covers the chains of a single HTTP or HTTPS proxy. HTTPS proxies that
+// negotiate HTTP/2 are left to the tunnel sessions. Standby connections idle
+// for kMaxIdleTime are replaced, as proxies close idle connections. Failures
+// push the next attempt further back, from kMinBackoff up to kMaxBackoff.
+// Network changes drop the standby connections and reset the backoff.
+//
+// At most one pool is installed per thread, for the lifetime of the pool.
+class NaiveStandbyPool : public NetworkChangeNotifier::NetworkChangeObserver {
+ public:
+  static constexpr base::TimeDelta kCheckInterval = base::Seconds(5);
+  static constexpr base::TimeDelta kNetworkChangeDelay = base::Seconds(1);
+  static constexpr base::TimeDelta kMaxIdleTime = base::Seconds(30);
+  static constexpr base::TimeDelta kMinBackoff = base::Seconds(5);
+  static constexpr base::TimeDelta kMaxBackoff = base::Minutes(5);
+
+  // Keeps `num_connections` connections to the proxy of each of the
+  // `num_chains` chains of `proxy_selector` that is an HTTP/1.1 proxy.
+  // `session` and `proxy_selector` must outlive this.
+  NaiveStandbyPool(HttpNetworkSession* session,
+                   const NaiveProxySelector& proxy_selector,
+                   size_t num_chains,
+                   size_t num_connections,
+                   const NetworkTrafficAnnotationTag& traffic_annotation);
+  ~NaiveStandbyPool() override;
+  NaiveStandbyPool(const NaiveStandbyPool&) = delete;
+  NaiveStandbyPool& operator=(const NaiveStandbyPool&) = delete;
+
+  // Returns the pool installed on the current thread, or null.
+  static NaiveStandbyPool* GetForCurrentThread();
+
+  // Returns a connected socket to the proxy of `proxy_chain` on which no
+  // request has been sent, or null if there is none ready.
+  std::unique_ptr<StreamSocket> Take(const ProxyChain& proxy_chain);
+
+ private:
+  class Target;
+
+  // NetworkChangeNotifier::NetworkChangeObserver:
+  void OnNetworkChanged(NetworkChangeNotifier::ConnectionType type) override;
+
+  void CheckTargets();
+
+  // Referenced by the connect jobs of the targets.
+  const CommonConnectJobParams common_connect_job_params_;
+  std::vector<std::unique_ptr<Target>> targets_;
+  base::RepeatingTimer check_timer_;
+
+  THREAD_CHECKER(thread_checker_);
+
+  base::WeakPtrFactory<NaiveStandbyPool> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_STANDBY_POOL_H_
@@ -0,0 +1,120 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_stream_tunnel.h"
+
+#include <optional>
+#include <utility>
+
+#include "base/check.h"
+#include "base/functional/bind.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/http/http_network_session.h"
+#include "net/proxy_resolution/proxy_info.h"
+#include "net/socket/client_socket_handle.h"
+#include "net/tools/naive/naive_padding_socket.h"
+#include "net/tools/naive/naive_protocol.h"
+#include "net/tools/naive/naive_proxy_delegate.h"
+#include "url/scheme_host_port.h"
+
+namespace net {
+
+NaiveStreamTunnel::NaiveStreamTunnel(
+    HttpNetworkSession* session,
+    NaiveProxySelector* proxy_selector,
+    const NaivePaddingProfile& padding_profile,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : session_(session),
+      proxy_selector_(proxy_selector),
+      padding_profile_(padding_profile),
+      traffic_annotation_(traffic_annotation),
+      selection_(proxy_selector->Select()),
+      connector_(session, traffic_annotation),
+      server_socket_handle_(std::make_unique<ClientSocketHandle>()) {}
+
+NaiveStreamTunnel::~NaiveStreamTunnel() {
+  // The padding socket refers to the socket of the handle.
+  socket_.reset();
+  server_socket_handle_.reset();
+  proxy_selector_->OnConnectionClosed(selection_);
+}
+
+int NaiveStreamTunnel::Open(const HostPortPair& destination,
+                            CompletionOnceCallback callback) {
+  DCHECK(!padding_detector_delegate_);
+  const ProxyInfo& proxy_info = proxy_selector_->proxy_info(selection_);
+  auto* proxy_delegate =
+      static_cast<NaiveProxyDelegate*>(session_->context().proxy_delegate);
+  DCHECK(proxy_delegate);
+  // There is no client side to pad.
+  padding_detector_delegate_ = std::make_unique<PaddingDetectorDelegate>(
+      proxy_delegate, proxy_info.proxy_chain(), ClientProtocol::kRedir);
+
+  url::SchemeHostPort endpoint("http", destination.host(),
+                               destination.port());
+  if (!endpoint.IsValid()) {
+    return ERR_ADDRESS_INVALID;
+  }
+  open_start_time_ = base::TimeTicks::Now();
+  int rv = connector_.Connect(
+      std::move(endpoint), proxy_info,
+      proxy_selector_->network_anonymization_key(selection_),
+      proxy_info.is_direct() ? SecureDnsPolicy::kAllow
+                             : SecureDnsPolicy::kDisable,
+      net_log_, server_socket_handle_.get(),
+      base::BindOnce(&NaiveStreamTunnel::OnOpenComplete,
+                     weak_ptr_factory_.GetWeakPtr()));
+  if (rv == ERR_IO_PENDING) {
+    open_callback_ = std::move(callback);
+    return rv;
+  }
+  return HandleOpenResult(rv);
+}
+
+void NaiveStreamTunnel::OnOpenComplete(int result) {
+  std::move(open_callback_).Run(HandleOpenResult(result));
+}
+
+int NaiveStreamTunnel::HandleOpenResult(int result) {
+  connect_time_ = base::TimeTicks::Now() - open_start_time_;
+  proxy_selector_->OnConnectComplete(selection_, result, connect_time_);
+  if (result != OK) {
+    return result;
+  }
+  std::optional<PaddingType> padding_type =
+      padding_detector_delegate_->GetServerPaddingType();
+  CHECK(padding_type.has_value());
+  socket_ = std::make_unique<NaivePaddingSocket>(
+      server_socket_handle_->socket(), *padding_type, kServer,
+      padding_detector_delegate_->GetServerPaddingLimits(), padding_profile_);
+  return OK;
+}
+
+int NaiveStreamTunnel::Read(IOBuffer* buf,
+                            int buf_len,
+                            CompletionOnceCallback callback) {
+  DCHECK(socket_);
+  return socket_->Read(buf, buf_len, std::move(callback));
+}
+
+int NaiveStreamTunnel::Write(IOBuffer* buf,
+                             int buf_len,
+                             CompletionOnceCallback callback) {
+  DCHECK(socket_);
+  return socket_->Write(buf, buf_len, std::move(callback),
+                        traffic_annotation_);
+}
+
+int NaiveStreamTunnel::Flush(CompletionOnceCallback callback) {
+  DCHECK(socket_);
+  return socket_->Flush(std::move(callback));
+}
+
+int NaiveStreamTunnel::ShutdownWrite() {
+  DCHECK(socket_);
+  return socket_->ShutdownWrite();
+}
+
+}  // namespace net
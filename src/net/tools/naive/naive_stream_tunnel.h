@@ -0,0 +1,80 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_STREAM_TUNNEL_H_
+#define NET_TOOLS_NAIVE_NAIVE_STREAM_TUNNEL_H_
+
+#include <memory>
+
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "net/base/completion_once_callback.h"
+#include "net/base/host_port_pair.h"
+#include "net/log/net_log_with_source.h"
+#include "net/tools/naive/naive_padding_profile.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+#include "net/tools/naive/naive_tunnel_connector.h"
+
+namespace net {
+
+class ClientSocketHandle;
+class HttpNetworkSession;
+class IOBuffer;
+class NaivePaddingSocket;
+class PaddingDetectorDelegate;
+struct NetworkTrafficAnnotationTag;
+
+// A tunnel opened in-process through the proxy chains of an IO thread, for
+// code that runs in naive instead of reaching it through a listener. It is
+// the server half of a NaiveConnection, with the same tunnel connector and
+// padding, without a client socket, handshake or relay in front of it.
+// Must be used on the thread of `session`, where its callbacks run too.
+class NaiveStreamTunnel {
+ public:
+  // `padding_profile` must outlive the tunnel.
+  NaiveStreamTunnel(HttpNetworkSession* session,
+                    NaiveProxySelector* proxy_selector,
+                    const NaivePaddingProfile& padding_profile,
+                    const NetworkTrafficAnnotationTag& traffic_annotation);
+  ~NaiveStreamTunnel();
+  NaiveStreamTunnel(const NaiveStreamTunnel&) = delete;
+  NaiveStreamTunnel& operator=(const NaiveStreamTunnel&) = delete;
+
+  // Opens the tunnel to `destination`. Runs `callback` if it returns
+  // ERR_IO_PENDING. Must be called once.
+  int Open(const HostPortPair& destination, CompletionOnceCallback callback);
+
+  // How long Open() took. Valid once it has completed.
+  base::TimeDelta connect_time() const { return connect_time_; }
+
+  // These have the semantics of NaivePaddingSocket, and are only valid once
+  // Open() has completed with OK.
+  int Read(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
+  int Write(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
+  int Flush(CompletionOnceCallback callback);
+  int ShutdownWrite();
+
+ private:
+  void OnOpenComplete(int result);
+  int HandleOpenResult(int result);
+
+  HttpNetworkSession* const session_;
+  NaiveProxySelector* const proxy_selector_;
+  const NaivePaddingProfile& padding_profile_;
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+  const NaiveProxySelector::Selection selection_;
+  const NetLogWithSource net_log_;
+
+  std::unique_ptr<PaddingDetectorDelegate> padding_detector_delegate_;
+  NaiveTunnelConnector connector_;
+  std::unique_ptr<ClientSocketHandle> server_socket_handle_;
+  std::unique_ptr<NaivePaddingSocket> socket_;
+  base::TimeTicks open_start_time_;
+  base::TimeDelta connect_time_;
+  CompletionOnceCallback open_callback_;
+
+  base::WeakPtrFactory<NaiveStreamTunnel> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_STREAM_TUNNEL_H_
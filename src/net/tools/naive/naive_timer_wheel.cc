@@ -0,0 +1,65 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_timer_wheel.h"
+
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+
+namespace net {
+
+NaiveTimerWheel::NaiveTimerWheel(base::TimeDelta tick,
+                                 size_t num_slots,
+                                 ExpireCallback expire_callback)
+    : tick_(tick),
+      expire_callback_(std::move(expire_callback)),
+      slots_(num_slots) {
+  DCHECK(tick_.is_positive());
+  DCHECK_GT(num_slots, 0u);
+}
+
+NaiveTimerWheel::~NaiveTimerWheel() = default;
+
+void NaiveTimerWheel::Schedule(uint64_t id, base::TimeTicks deadline) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  if (!timer_.IsRunning()) {
+    // The ring is empty, so it can restart at the current time.
+    next_tick_time_ = base::TimeTicks::Now() + tick_;
+    timer_.Start(FROM_HERE, tick_, this, &NaiveTimerWheel::OnTick);
+  }
+
+  size_t ticks = 0;
+  if (deadline > next_tick_time_) {
+    ticks = (deadline - next_tick_time_).IntDiv(tick_);
+    if (next_tick_time_ + tick_ * ticks < deadline) {
+      ++ticks;
+    }
+  }
+  if (ticks >= slots_.size()) {
+    ticks = slots_.size() - 1;
+  }
+  slots_[(current_slot_ + ticks) % slots_.size()].push_back(id);
+  ++size_;
+}
+
+void NaiveTimerWheel::OnTick() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  std::vector<uint64_t> expired = std::move(slots_[current_slot_]);
+  slots_[current_slot_].clear();
+  current_slot_ = (current_slot_ + 1) % slots_.size();
+  next_tick_time_ += tick_;
+  size_ -= expired.size();
+
+  for (uint64_t id : expired) {
+    expire_callback_.Run(id);
+  }
+
+  if (size_ == 0) {
+    timer_.Stop();
+  }
+}
+
+}  // namespace net
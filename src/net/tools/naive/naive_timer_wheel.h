@@ -0,0 +1,58 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_TIMER_WHEEL_H_
+#define NET_TOOLS_NAIVE_NAIVE_TIMER_WHEEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "base/functional/callback.h"
+#include "base/threading/thread_checker.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+
+namespace net {
+
+// Coarse timers for many ids sharing one repeating timer. Deadlines are
+// rounded up to the next tick and hashed into a ring of slots; a deadline
+// beyond the ring fires early, at the last slot. Scheduling is O(1) and
+// there is no cancellation: the expire callback must check whether the id
+// is still alive and whether its deadline really passed, and may schedule it
+// again.
+class NaiveTimerWheel {
+ public:
+  using ExpireCallback = base::RepeatingCallback<void(uint64_t id)>;
+
+  NaiveTimerWheel(base::TimeDelta tick,
+                  size_t num_slots,
+                  ExpireCallback expire_callback);
+  ~NaiveTimerWheel();
+  NaiveTimerWheel(const NaiveTimerWheel&) = delete;
+  NaiveTimerWheel& operator=(const NaiveTimerWheel&) = delete;
+
+  // Invokes the expire callback with `id` at or after `deadline`, or at the
+  // end of the ring, whichever is sooner.
+  void Schedule(uint64_t id, base::TimeTicks deadline);
+
+  size_t size() const { return size_; }
+
+ private:
+  void OnTick();
+
+  const base::TimeDelta tick_;
+  const ExpireCallback expire_callback_;
+  std::vector<std::vector<uint64_t>> slots_;
+  // Slot fired by the next tick.
+  size_t current_slot_ = 0;
+  // Time of the next tick.
+  base::TimeTicks next_tick_time_;
+  size_t size_ = 0;
+  base::RepeatingTimer timer_;
+
+  THREAD_CHECKER(thread_checker_);
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_TIMER_WHEEL_H_
@@ -0,0 +1,527 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifdef UNSAFE_BUFFERS_BUILD
+// TODO(crbug.com/40284755): Remove this and spanify to fix the errors.
+#pragma allow_unsafe_buffers
+#endif
+
+#include "net/tools/naive/naive_tproxy.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "base/check.h"
+#include "base/functional/bind.h"
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/task/current_thread.h"
+#include "base/task/single_thread_task_runner.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/sockaddr_storage.h"
+#include "net/socket/datagram_server_socket.h"
+#include "net/socket/diff_serv_code_point.h"
+#include "net/tools/naive/naive_udp_association.h"
+#include "net/tools/naive/redirect_resolver.h"
+
+namespace net {
+
+namespace {
+// Checked this often for idle clients.
+constexpr base::TimeDelta kIdleCheckInterval = base::Seconds(10);
+
+// Datagrams of IPv4 clients to a dual stack socket come from mapped
+// addresses, while their original destinations are plain IPv4.
+IPEndPoint ToComparableEndPoint(const IPEndPoint& endpoint) {
+  if (endpoint.address().IsIPv4MappedIPv6()) {
+    return IPEndPoint(ConvertIPv4MappedIPv6ToIPv4(endpoint.address()),
+                      endpoint.port());
+  }
+  return endpoint;
+}
+
+bool SetTransparent(int fd, AddressFamily family) {
+  int on = 1;
+  if (family == ADDRESS_FAMILY_IPV6) {
+    return setsockopt(fd, SOL_IPV6, IPV6_TRANSPARENT, &on, sizeof(on)) == 0;
+  }
+  return setsockopt(fd, SOL_IP, IP_TRANSPARENT, &on, sizeof(on)) == 0;
+}
+}  // namespace
+
+base::ScopedFD CreateTransparentSocket(const IPEndPoint& address, int type) {
+  AddressFamily family = address.GetFamily();
+  base::ScopedFD fd(socket(family == ADDRESS_FAMILY_IPV6 ? AF_INET6 : AF_INET,
+                           type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+  if (!fd.is_valid()) {
+    PLOG(ERROR) << "socket() failed";
+    return base::ScopedFD();
+  }
+  // Needs CAP_NET_ADMIN.
+  if (!SetTransparent(fd.get(), family)) {
+    PLOG(ERROR) << "Failed to set IP_TRANSPARENT";
+    return base::ScopedFD();
+  }
+  if (type != SOCK_DGRAM) {
+    return fd;
+  }
+  int on = 1;
+  setsockopt(fd.get(), SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  SockaddrStorage storage;
+  if (!address.ToSockAddr(storage.addr, &storage.addr_len) ||
+      bind(fd.get(), storage.addr, storage.addr_len) != 0) {
+    PLOG(ERROR) << "Failed to bind to " << address.ToString();
+    return base::ScopedFD();
+  }
+  return fd;
+}
+
+// Feeds the datagrams of one client to its NaiveUdpAssociation, framed by
+// the SOCKS5 UDP request header of their destination, and sends the replies
+// of the association from the destinations in their headers.
+class NaiveTproxyUdpServer::ClientSocket : public DatagramServerSocket {
+ public:
+  explicit ClientSocket(NaiveTproxyUdpServer* server)
+      : server_(server),
+        net_log_(NetLogWithSource::Make(NetLogSourceType::NONE)) {}
+  ClientSocket(const ClientSocket&) = delete;
+  ClientSocket& operator=(const ClientSocket&) = delete;
+  ~ClientSocket() override = default;
+
+  // Queues a datagram of the client to `destination`.
+  void OnDatagram(const IPEndPoint& client_address,
+                  const IPEndPoint& destination,
+                  const char* data,
+                  size_t size);
+
+  // DatagramServerSocket implementation.
+  int Listen(const IPEndPoint& address) override { return ERR_NOT_IMPLEMENTED; }
+  int RecvFrom(IOBuffer* buf,
+               int buf_len,
+               IPEndPoint* address,
+               CompletionOnceCallback callback) override;
+  int SendTo(IOBuffer* buf,
+             int buf_len,
+             const IPEndPoint& address,
+             CompletionOnceCallback callback) override;
+  int SetReceiveBufferSize(int32_t size) override { return OK; }
+  int SetSendBufferSize(int32_t size) override { return OK; }
+  void AllowAddressReuse() override {}
+  void AllowBroadcast() override {}
+  void AllowAddressSharingForMulticast() override {}
+  int JoinGroup(const IPAddress& group_address) const override {
+    return ERR_NOT_IMPLEMENTED;
+  }
+  int LeaveGroup(const IPAddress& group_address) const override {
+    return ERR_NOT_IMPLEMENTED;
+  }
+  int SetMulticastInterface(uint32_t interface_index) override {
+    return ERR_NOT_IMPLEMENTED;
+  }
+  int SetMulticastTimeToLive(int time_to_live) override {
+    return ERR_NOT_IMPLEMENTED;
+  }
+  int SetMulticastLoopbackMode(bool loopback) override {
+    return ERR_NOT_IMPLEMENTED;
+  }
+  int SetDiffServCodePoint(DiffServCodePoint dscp) override {
+    return ERR_NOT_IMPLEMENTED;
+  }
+  void DetachFromThread() override {}
+
+  // DatagramSocket implementation.
+  void Close() override {}
+  int GetPeerAddress(IPEndPoint* address) const override {
+    return ERR_SOCKET_NOT_CONNECTED;
+  }
+  int GetLocalAddress(IPEndPoint* address) const override {
+    return ERR_NOT_IMPLEMENTED;
+  }
+  void UseNonBlockingIO() override {}
+  int SetDoNotFragment() override { return OK; }
+  int SetRecvTos() override { return OK; }
+  int SetTos(DiffServCodePoint dscp, EcnCodePoint ecn) override { return OK; }
+  void SetMsgConfirm(bool confirm) override {}
+  const NetLogWithSource& NetLog() const override { return net_log_; }
+  DscpAndEcn GetLastTos() const override { return {DSCP_DEFAULT, ECN_DEFAULT}; }
+
+ private:
+  // Datagrams waiting for RecvFrom(), up to this many.
+  static constexpr size_t kMaxQueuedDatagrams = 64;
+  // Destinations relayed by name, up to this many.
+  static constexpr size_t kMaxNames = 256;
+
+  struct Datagram {
+    IPEndPoint client_address;
+    // With the SOCKS5 UDP request header.
+    std::string data;
+  };
+
+  void DoRecvCallback();
+
+  const raw_ptr<NaiveTproxyUdpServer> server_;
+  NetLogWithSource net_log_;
+  std::queue<Datagram> datagrams_;
+  // The fake address each name relayed for the client stands for, where
+  // the replies of the name are sent from.
+  std::map<HostPortPair, IPEndPoint> names_;
+
+  scoped_refptr<IOBuffer> recv_buf_;
+  int recv_buf_len_ = 0;
+  raw_ptr<IPEndPoint> recv_address_ = nullptr;
+  CompletionOnceCallback recv_callback_;
+  bool recv_notify_pending_ = false;
+
+  base::WeakPtrFactory<ClientSocket> weak_ptr_factory_{this};
+};
+
+void NaiveTproxyUdpServer::ClientSocket::OnDatagram(
+    const IPEndPoint& client_address,
+    const IPEndPoint& destination,
+    const char* data,
+    size_t size) {
+  if (datagrams_.size() >= kMaxQueuedDatagrams) {
+    return;
+  }
+  HostPortPair target = HostPortPair::FromIPEndPoint(destination);
+  if (RedirectResolver* resolver = server_->resolver_) {
+    std::string name = resolver->FindNameByAddress(destination.address());
+    if (!name.empty()) {
+      target = HostPortPair(name, destination.port());
+      if (names_.size() >= kMaxNames && !names_.contains(target)) {
+        names_.clear();
+      }
+      names_[target] = destination;
+    } else if (resolver->IsInResolvedRange(destination.address())) {
+      return;
+    }
+  }
+  std::string datagram = NaiveUdpAssociation::MakeSocksHeader(target);
+  datagram.append(data, size);
+  datagrams_.push({client_address, std::move(datagram)});
+  if (recv_callback_ && !recv_notify_pending_) {
+    recv_notify_pending_ = true;
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE, base::BindOnce(&ClientSocket::DoRecvCallback,
+                                  weak_ptr_factory_.GetWeakPtr()));
+  }
+}
+
+int NaiveTproxyUdpServer::ClientSocket::RecvFrom(
+    IOBuffer* buf,
+    int buf_len,
+    IPEndPoint* address,
+    CompletionOnceCallback callback) {
+  DCHECK(!recv_callback_);
+  if (!datagrams_.empty()) {
+    Datagram datagram = std::move(datagrams_.front());
+    datagrams_.pop();
+    if (datagram.data.size() > static_cast<size_t>(buf_len)) {
+      return ERR_MSG_TOO_BIG;
+    }
+    memcpy(buf->data(), datagram.data.data(), datagram.data.size());
+    *address = datagram.client_address;
+    return static_cast<int>(datagram.data.size());
+  }
+  recv_buf_ = buf;
+  recv_buf_len_ = buf_len;
+  recv_address_ = address;
+  recv_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
+int NaiveTproxyUdpServer::ClientSocket::SendTo(
+    IOBuffer* buf,
+    int buf_len,
+    const IPEndPoint& address,
+    CompletionOnceCallback callback) {
+  std::string_view datagram(buf->data(), buf_len);
+  HostPortPair source;
+  size_t offset = NaiveUdpAssociation::ParseSocksHeader(datagram, &source);
+  if (offset == 0) {
+    return ERR_INVALID_ARGUMENT;
+  }
+  IPEndPoint source_address;
+  IPAddress source_ip;
+  if (source_ip.AssignFromIPLiteral(source.host())) {
+    source_address = IPEndPoint(source_ip, source.port());
+  } else {
+    auto it = names_.find(source);
+    if (it == names_.end()) {
+      return ERR_ADDRESS_UNREACHABLE;
+    }
+    source_address = it->second;
+  }
+  server_->SendReply(source_address, address, datagram.data() + offset,
+                     datagram.size() - offset);
+  return buf_len;
+}
+
+void NaiveTproxyUdpServer::ClientSocket::DoRecvCallback() {
+  recv_notify_pending_ = false;
+  if (!recv_callback_ || datagrams_.empty()) {
+    return;
+  }
+  scoped_refptr<IOBuffer> buf = std::move(recv_buf_);
+  IPEndPoint* address = recv_address_;
+  recv_address_ = nullptr;
+  int rv = RecvFrom(buf.get(), recv_buf_len_, address,
+                    CompletionOnceCallback());
+  std::move(recv_callback_).Run(rv);
+}
+
+struct NaiveTproxyUdpServer::Client {
+  raw_ptr<NaiveProxySelector> proxy_selector;
+  NaiveProxySelector::Selection selection;
+  // Owned by `association`.
+  raw_ptr<ClientSocket> socket;
+  std::unique_ptr<NaiveUdpAssociation> association;
+};
+
+NaiveTproxyUdpServer::NaiveTproxyUdpServer(
+    base::ScopedFD fd,
+    NaiveProxySelector* proxy_selector,
+    RedirectResolver* resolver,
+    HttpNetworkSession* session,
+    base::TimeDelta idle_timeout,
+    const NetLogWithSource& net_log,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : fd_(std::move(fd)),
+      proxy_selector_(proxy_selector),
+      resolver_(resolver),
+      session_(session),
+      idle_timeout_(idle_timeout.is_positive() ? idle_timeout
+                                               : kDefaultIdleTimeout),
+      net_log_(net_log),
+      traffic_annotation_(traffic_annotation),
+      read_buffer_(NaiveUdpAssociation::kMaxDatagramSize) {}
+
+NaiveTproxyUdpServer::~NaiveTproxyUdpServer() {
+  for (auto& [client_address, client] : clients_) {
+    client->proxy_selector->OnConnectionClosed(client->selection);
+  }
+}
+
+// static
+base::ScopedFD NaiveTproxyUdpServer::OpenSocket(const IPEndPoint& address) {
+  base::ScopedFD fd = CreateTransparentSocket(address, SOCK_DGRAM);
+  if (!fd.is_valid()) {
+    return fd;
+  }
+  int on = 1;
+  // Lets the next instance of a --handoff bind its own.
+  setsockopt(fd.get(), SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+  bool ok;
+  if (address.GetFamily() == ADDRESS_FAMILY_IPV6) {
+    // IPv4 clients of a dual stack socket get the IPv4 option.
+    setsockopt(fd.get(), SOL_IP, IP_RECVORIGDSTADDR, &on, sizeof(on));
+    ok = setsockopt(fd.get(), SOL_IPV6, IPV6_RECVORIGDSTADDR, &on,
+                    sizeof(on)) == 0;
+  } else {
+    ok = setsockopt(fd.get(), SOL_IP, IP_RECVORIGDSTADDR, &on, sizeof(on)) ==
+         0;
+  }
+  if (!ok) {
+    PLOG(ERROR) << "Failed to set IP_RECVORIGDSTADDR";
+    return base::ScopedFD();
+  }
+  return fd;
+}
+
+bool NaiveTproxyUdpServer::Start() {
+  if (!base::CurrentIOThread::Get()->WatchFileDescriptor(
+          fd_.get(), /*persistent=*/true, base::MessagePumpForIO::WATCH_READ,
+          &controller_, this)) {
+    LOG(ERROR) << "WatchFileDescriptor failed on tproxy UDP socket";
+    return false;
+  }
+  idle_timer_.Start(FROM_HERE, kIdleCheckInterval, this,
+                    &NaiveTproxyUdpServer::OnIdleCheck);
+  return true;
+}
+
+void NaiveTproxyUdpServer::SetProxySelector(
+    NaiveProxySelector* proxy_selector) {
+  DCHECK(proxy_selector);
+  proxy_selector_ = proxy_selector;
+}
+
+void NaiveTproxyUdpServer::StopListening() {
+  controller_.StopWatchingFileDescriptor();
+  fd_.reset();
+}
+
+void NaiveTproxyUdpServer::OnFileCanReadWithoutBlocking(int fd) {
+  for (int i = 0; i < kMaxReadsPerTask && fd_.is_valid(); ++i) {
+    SockaddrStorage source;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sockaddr_in6))];
+    iovec iov = {read_buffer_.data(), read_buffer_.size()};
+    msghdr msg = {};
+    msg.msg_name = source.addr;
+    msg.msg_namelen = source.addr_len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t rv = HANDLE_EINTR(recvmsg(fd_.get(), &msg, 0));
+    if (rv < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        PLOG(ERROR) << "recvmsg() failed on tproxy UDP socket";
+      }
+      return;
+    }
+    // Too large for the flows, which drop them anyway.
+    if (msg.msg_flags & MSG_TRUNC) {
+      continue;
+    }
+    IPEndPoint client_address;
+    if (!client_address.FromSockAddr(source.addr, msg.msg_namelen)) {
+      continue;
+    }
+    IPEndPoint destination;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_ORIGDSTADDR) ||
+          (cmsg->cmsg_level == SOL_IPV6 &&
+           cmsg->cmsg_type == IPV6_ORIGDSTADDR)) {
+        destination.FromSockAddr(
+            reinterpret_cast<const sockaddr*>(CMSG_DATA(cmsg)),
+            cmsg->cmsg_len - CMSG_LEN(0));
+      }
+    }
+    if (destination.address().empty()) {
+      continue;
+    }
+    HandleDatagram(ToComparableEndPoint(client_address),
+                   ToComparableEndPoint(destination), read_buffer_.data(),
+                   rv);
+  }
+}
+
+void NaiveTproxyUdpServer::OnFileCanWriteWithoutBlocking(int fd) {}
+
+void NaiveTproxyUdpServer::HandleDatagram(const IPEndPoint& client_address,
+                                          const IPEndPoint& destination,
+                                          const char* data,
+                                          size_t size) {
+  Client* client = GetOrCreateClient(client_address);
+  if (!client) {
+    return;
+  }
+  client->socket->OnDatagram(client_address, destination, data, size);
+}
+
+NaiveTproxyUdpServer::Client* NaiveTproxyUdpServer::GetOrCreateClient(
+    const IPEndPoint& client_address) {
+  auto it = clients_.find(client_address);
+  if (it != clients_.end()) {
+    return it->second.get();
+  }
+
+  NaiveProxySelector::Selection selection = proxy_selector_->Select();
+  const ProxyChain& proxy_chain =
+      proxy_selector_->proxy_info(selection).proxy_chain();
+  if (!NaiveUdpAssociation::IsSupported(proxy_chain)) {
+    proxy_selector_->OnConnectionClosed(selection);
+    LOG_IF(WARNING, !unsupported_logged_)
+        << "Dropping tproxy UDP, which needs a single QUIC or HTTPS proxy";
+    unsupported_logged_ = true;
+    return nullptr;
+  }
+
+  if (clients_.size() >= kMaxClients) {
+    auto oldest = std::ranges::min_element(clients_, {}, [](const auto& i) {
+      return i.second->association->last_activity_time();
+    });
+    RemoveClient(oldest->first);
+  }
+
+  auto client = std::make_unique<Client>();
+  client->proxy_selector = proxy_selector_;
+  client->selection = selection;
+  auto socket = std::make_unique<ClientSocket>(this);
+  client->socket = socket.get();
+  client->association = std::make_unique<NaiveUdpAssociation>(
+      next_client_id_++, std::move(socket), client_address.address(),
+      proxy_chain, session_,
+      proxy_selector_->network_anonymization_key(selection), net_log_,
+      traffic_annotation_);
+  Client* client_ptr = client.get();
+  clients_[client_address] = std::move(client);
+  client_ptr->association->Run(
+      base::BindOnce(&NaiveTproxyUdpServer::OnClientError,
+                     weak_ptr_factory_.GetWeakPtr(), client_address));
+  return client_ptr;
+}
+
+void NaiveTproxyUdpServer::SendReply(const IPEndPoint& source,
+                                     const IPEndPoint& client_address,
+                                     const char* data,
+                                     size_t size) {
+  auto it = reply_sockets_.find(source);
+  if (it == reply_sockets_.end()) {
+    if (reply_sockets_.size() >= kMaxReplySockets) {
+      reply_sockets_.erase(reply_sockets_.begin());
+    }
+    base::ScopedFD fd = CreateTransparentSocket(source, SOCK_DGRAM);
+    if (!fd.is_valid()) {
+      return;
+    }
+    it = reply_sockets_.emplace(source, std::move(fd)).first;
+  }
+  // The reply socket is of the family of the destination the client sent
+  // to, which is that of the client.
+  SockaddrStorage storage;
+  if (!client_address.ToSockAddr(storage.addr, &storage.addr_len)) {
+    return;
+  }
+  // Replies the socket has no room for are dropped, as UDP allows.
+  ssize_t rv = HANDLE_EINTR(
+      sendto(it->second.get(), data, size, 0, storage.addr, storage.addr_len));
+  if (rv < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+    VLOG(1) << "Tproxy UDP reply from " << source.ToString() << " failed";
+  }
+}
+
+void NaiveTproxyUdpServer::OnClientError(const IPEndPoint& client_address,
+                                         int error) {
+  // Called by the association, which is destroyed out of its callback.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveTproxyUdpServer::RemoveClient,
+                                weak_ptr_factory_.GetWeakPtr(),
+                                client_address));
+}
+
+void NaiveTproxyUdpServer::RemoveClient(const IPEndPoint& client_address) {
+  auto it = clients_.find(client_address);
+  if (it == clients_.end()) {
+    return;
+  }
+  it->second->proxy_selector->OnConnectionClosed(it->second->selection);
+  clients_.erase(it);
+}
+
+void NaiveTproxyUdpServer::OnIdleCheck() {
+  base::TimeTicks now = base::TimeTicks::Now();
+  std::vector<IPEndPoint> idle;
+  for (const auto& [client_address, client] : clients_) {
+    if (now - client->association->last_activity_time() >= idle_timeout_) {
+      idle.push_back(client_address);
+    }
+  }
+  for (const IPEndPoint& client_address : idle) {
+    RemoveClient(client_address);
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,128 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_TPROXY_H_
+#define NET_TOOLS_NAIVE_NAIVE_TPROXY_H_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "base/files/scoped_file.h"
+#include "base/memory/raw_ptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_pump_for_io.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/log/net_log_with_source.h"
+#include "net/tools/naive/naive_proxy_selector.h"
+
+namespace net {
+
+class HttpNetworkSession;
+class RedirectResolver;
+struct NetworkTrafficAnnotationTag;
+
+// Opens a socket of `type` with IP_TRANSPARENT, which takes what a TPROXY
+// rule delivers to it whatever the destination, and may be bound to an
+// address that is not local. Datagram sockets are bound to `address`, and
+// stream sockets are left for TCPServerSocket::Listen(). Returns an invalid
+// descriptor on failure.
+base::ScopedFD CreateTransparentSocket(const IPEndPoint& address, int type);
+
+// Relays the UDP datagrams a TPROXY rule delivers to a tproxy listener, over
+// the CONNECT-UDP flows of NaiveUdpAssociation. Each client address gets an
+// association, fed with the datagrams of the client framed by the SOCKS5
+// UDP request header of their original destination. The replies of each
+// destination are sent from it, through a transparent socket bound to it.
+//
+// Names the redirect resolver handed out for its fake addresses are relayed
+// as names. Datagrams to fake addresses it does not know are dropped.
+class NaiveTproxyUdpServer : public base::MessagePumpForIO::FdWatcher {
+ public:
+  // `resolver` may be null. `net_log` must outlive the server.
+  NaiveTproxyUdpServer(base::ScopedFD fd,
+                       NaiveProxySelector* proxy_selector,
+                       RedirectResolver* resolver,
+                       HttpNetworkSession* session,
+                       base::TimeDelta idle_timeout,
+                       const NetLogWithSource& net_log,
+                       const NetworkTrafficAnnotationTag& traffic_annotation);
+  NaiveTproxyUdpServer(const NaiveTproxyUdpServer&) = delete;
+  NaiveTproxyUdpServer& operator=(const NaiveTproxyUdpServer&) = delete;
+  ~NaiveTproxyUdpServer() override;
+
+  // Opens the socket of a tproxy listener on `address`, which also gets the
+  // original destination of each datagram. Returns an invalid descriptor on
+  // failure.
+  static base::ScopedFD OpenSocket(const IPEndPoint& address);
+
+  // Starts reading. Returns false if the socket cannot be watched.
+  bool Start();
+
+  // Applies to clients from now on. Open clients keep the selector they
+  // were given, which must outlive them.
+  void SetProxySelector(NaiveProxySelector* proxy_selector);
+
+  // Closes the socket. Open clients are relayed until they go idle.
+  void StopListening();
+  bool has_clients() const { return !clients_.empty(); }
+
+  // base::MessagePumpForIO::FdWatcher implementation.
+  void OnFileCanReadWithoutBlocking(int fd) override;
+  void OnFileCanWriteWithoutBlocking(int fd) override;
+
+ private:
+  class ClientSocket;
+  struct Client;
+
+  // Datagrams handled in one task before yielding to the tunnels.
+  static constexpr int kMaxReadsPerTask = 32;
+  // The least recently active client is closed to make room for new ones.
+  static constexpr size_t kMaxClients = 256;
+  // Sockets of the destinations replies are sent from. One is closed to
+  // make room for new ones, and opened again as needed.
+  static constexpr size_t kMaxReplySockets = 256;
+  // Clients go idle after this if the listener has no idle timeout.
+  static constexpr base::TimeDelta kDefaultIdleTimeout = base::Seconds(300);
+
+  void HandleDatagram(const IPEndPoint& client_address,
+                      const IPEndPoint& destination,
+                      const char* data,
+                      size_t size);
+  // Returns null if the proxy chain cannot relay datagrams.
+  Client* GetOrCreateClient(const IPEndPoint& client_address);
+  // Sends `size` bytes of `data` to `client_address` from `source`.
+  void SendReply(const IPEndPoint& source,
+                 const IPEndPoint& client_address,
+                 const char* data,
+                 size_t size);
+  void OnClientError(const IPEndPoint& client_address, int error);
+  void RemoveClient(const IPEndPoint& client_address);
+  void OnIdleCheck();
+
+  base::ScopedFD fd_;
+  base::MessagePumpForIO::FdWatchController controller_{FROM_HERE};
+  raw_ptr<NaiveProxySelector> proxy_selector_;
+  const raw_ptr<RedirectResolver> resolver_;
+  const raw_ptr<HttpNetworkSession> session_;
+  const base::TimeDelta idle_timeout_;
+  const NetLogWithSource& net_log_;
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+
+  std::vector<char> read_buffer_;
+  std::map<IPEndPoint, std::unique_ptr<Client>> clients_;
+  unsigned int next_client_id_ = 1;
+  std::map<IPEndPoint, base::ScopedFD> reply_sockets_;
+  // Logged once, for proxy chains other than a single QUIC or HTTPS proxy.
+  bool unsupported_logged_ = false;
+
+  base::RepeatingTimer idle_timer_;
+
+  base::WeakPtrFactory<NaiveTproxyUdpServer> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_TPROXY_H_
@@ -0,0 +1,86 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_trace_recorder.h"
+
+#include <utility>
+
+#include "base/files/file_util.h"
+#include "base/functional/bind.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/task/thread_pool.h"
+#include "base/tracing_buildflags.h"
+
+#if BUILDFLAG(ENABLE_BASE_TRACING)
+#include "base/trace_event/trace_config.h"
+#include "base/trace_event/trace_log.h"
+#endif
+
+namespace net {
+
+namespace {
+void WriteTraceFile(const base::FilePath& path, const std::string& json) {
+  if (!base::WriteFile(path, json)) {
+    LOG(WARNING) << "Failed to write " << path;
+    return;
+  }
+  LOG(INFO) << "Saved trace to " << path;
+}
+}  // namespace
+
+NaiveTraceRecorder::NaiveTraceRecorder(const base::FilePath& path)
+    : path_(path) {}
+
+NaiveTraceRecorder::~NaiveTraceRecorder() = default;
+
+// static
+bool NaiveTraceRecorder::IsSupported() {
+  return BUILDFLAG(ENABLE_BASE_TRACING);
+}
+
+void NaiveTraceRecorder::Start(base::TimeDelta duration) {
+#if BUILDFLAG(ENABLE_BASE_TRACING)
+  base::trace_event::TraceLog::GetInstance()->SetEnabled(
+      base::trace_event::TraceConfig(kCategories, ""),
+      base::trace_event::TraceLog::RECORDING_MODE);
+  stop_timer_.Start(FROM_HERE, duration,
+                    base::BindOnce(&NaiveTraceRecorder::Stop,
+                                   weak_ptr_factory_.GetWeakPtr()));
+  LOG(INFO) << "Tracing for " << duration.InSeconds() << " seconds";
+#else
+  LOG(WARNING) << "No tracing in this build";
+#endif
+}
+
+void NaiveTraceRecorder::Stop() {
+#if BUILDFLAG(ENABLE_BASE_TRACING)
+  auto* trace_log = base::trace_event::TraceLog::GetInstance();
+  trace_log->SetDisabled();
+  json_ = "{\"traceEvents\":[";
+  trace_log->Flush(base::BindRepeating(&NaiveTraceRecorder::OnTraceData,
+                                       weak_ptr_factory_.GetWeakPtr()));
+#endif
+}
+
+void NaiveTraceRecorder::OnTraceData(
+    const scoped_refptr<base::RefCountedString>& events,
+    bool has_more_events) {
+#if BUILDFLAG(ENABLE_BASE_TRACING)
+  // Joins the fragments as TraceResultBuffer does.
+  if (!events->as_string().empty()) {
+    if (json_.back() != '[')
+      json_ += ',';
+    json_ += events->as_string();
+  }
+  if (has_more_events)
+    return;
+  json_ += "]}";
+  base::ThreadPool::PostTask(
+      FROM_HERE, {base::MayBlock(), base::TaskPriority::BEST_EFFORT},
+      base::BindOnce(&WriteTraceFile, path_, std::move(json_)));
+  json_.clear();
+#endif
+}
+
+}  // namespace net
@@ -0,0 +1,54 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_TRACE_RECORDER_H_
+#define NET_TOOLS_NAIVE_NAIVE_TRACE_RECORDER_H_
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+
+namespace base {
+class RefCountedString;
+}  // namespace base
+
+namespace net {
+
+// Records the trace events of the relay path, in the "naive" category, and
+// of the network stack for a while, then saves them as a JSON trace that
+// chrome://tracing and Perfetto UI can open. Only builds with
+// enable_base_tracing can record.
+class NaiveTraceRecorder {
+ public:
+  static constexpr char kCategories[] = "naive,net,base";
+
+  explicit NaiveTraceRecorder(const base::FilePath& path);
+  ~NaiveTraceRecorder();
+  NaiveTraceRecorder(const NaiveTraceRecorder&) = delete;
+  NaiveTraceRecorder& operator=(const NaiveTraceRecorder&) = delete;
+
+  // Returns whether tracing is built in.
+  static bool IsSupported();
+
+  // Records for `duration`, then saves the trace.
+  void Start(base::TimeDelta duration);
+
+ private:
+  void Stop();
+  void OnTraceData(const scoped_refptr<base::RefCountedString>& events,
+                   bool has_more_events);
+
+  const base::FilePath path_;
+  base::OneShotTimer stop_timer_;
+  // JSON of the fragments flushed so far.
+  std::string json_;
+
+  base::WeakPtrFactory<NaiveTraceRecorder> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_TRACE_RECORDER_H_
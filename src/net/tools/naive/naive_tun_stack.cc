@@ -0,0 +1,1523 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifdef UNSAFE_BUFFERS_BUILD
+// TODO(crbug.com/40284755): Remove this and spanify to fix the errors.
+#pragma allow_unsafe_buffers
+#endif
+
+#include "net/tools/naive/naive_tun_stack.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/if_tun.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "base/check.h"
+#include "base/files/file_util.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/rand_util.h"
+#include "base/task/current_thread.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/base/net_errors.h"
+#include "net/log/net_log_source_type.h"
+#include "net/socket/next_proto.h"
+
+namespace net {
+
+namespace {
+
+constexpr uint8_t kProtocolTcp = 6;
+constexpr uint8_t kProtocolUdp = 17;
+
+constexpr size_t kIPv4HeaderSize = 20;
+constexpr size_t kIPv6HeaderSize = 40;
+constexpr size_t kTcpHeaderSize = 20;
+constexpr size_t kUdpHeaderSize = 8;
+constexpr size_t kMaxIPPacketSize = 65535;
+
+constexpr uint8_t kFin = 0x01;
+constexpr uint8_t kSyn = 0x02;
+constexpr uint8_t kRst = 0x04;
+constexpr uint8_t kPsh = 0x08;
+constexpr uint8_t kAck = 0x10;
+
+constexpr uint16_t kDnsPort = 53;
+
+// Offered to the kernel, which lowers it to fit the MTU of the device.
+constexpr uint16_t kMaxSegmentSize =
+    kMaxIPPacketSize - kIPv6HeaderSize - kTcpHeaderSize;
+// Used when the SYN has no MSS option, as RFC 9293 has it.
+constexpr uint16_t kDefaultSegmentSize = 536;
+constexpr uint16_t kDefaultSegmentSize6 = 1220;
+constexpr uint16_t kMinSegmentSize = 64;
+
+constexpr base::TimeDelta kInitialRto = base::Seconds(1);
+constexpr base::TimeDelta kMaxRto = base::Seconds(60);
+// Timeouts in a row without an ACK before the connection is reset.
+constexpr int kMaxRetransmits = 8;
+// Time a closed connection has to deliver what is left of its data, reset
+// whenever the peer acknowledges some.
+constexpr base::TimeDelta kLingerTimeout = base::Seconds(60);
+
+uint16_t ReadU16(const uint8_t* p) {
+  return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t ReadU32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+void WriteU16(uint8_t* p, uint16_t value) {
+  p[0] = static_cast<uint8_t>(value >> 8);
+  p[1] = static_cast<uint8_t>(value);
+}
+
+void WriteU32(uint8_t* p, uint32_t value) {
+  WriteU16(p, static_cast<uint16_t>(value >> 16));
+  WriteU16(p + 2, static_cast<uint16_t>(value));
+}
+
+// Sequence number comparisons, modulo 2^32.
+bool SeqLt(uint32_t a, uint32_t b) {
+  return static_cast<int32_t>(a - b) < 0;
+}
+
+bool SeqLe(uint32_t a, uint32_t b) {
+  return static_cast<int32_t>(a - b) <= 0;
+}
+
+uint64_t ChecksumAdd(uint64_t sum, const uint8_t* data, size_t size) {
+  for (; size > 1; data += 2, size -= 2) {
+    sum += ReadU16(data);
+  }
+  if (size > 0) {
+    sum += static_cast<uint64_t>(data[0]) << 8;
+  }
+  return sum;
+}
+
+uint16_t ChecksumFold(uint64_t sum) {
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return static_cast<uint16_t>(~sum);
+}
+
+}  // namespace
+
+// The state of a TCP connection of NaiveTunServerSocket. It is owned by the
+// server socket, so it can finish sending once its NaiveTunTcpSocket is
+// destroyed. The callbacks of the socket run from tasks of their own.
+class NaiveTunTcpConnection {
+ public:
+  struct Segment {
+    uint32_t seq = 0;
+    uint32_t ack = 0;
+    uint8_t flags = 0;
+    uint16_t window = 0;
+    // Options of SYN segments. Zero and -1 if absent.
+    uint16_t mss = 0;
+    int window_scale = -1;
+    const uint8_t* payload = nullptr;
+    size_t payload_size = 0;
+  };
+
+  NaiveTunTcpConnection(NaiveTunServerSocket* stack,
+                        const IPEndPoint& peer_address,
+                        const IPEndPoint& local_address)
+      : stack_(stack),
+        peer_address_(peer_address),
+        local_address_(local_address) {}
+  NaiveTunTcpConnection(const NaiveTunTcpConnection&) = delete;
+  NaiveTunTcpConnection& operator=(const NaiveTunTcpConnection&) = delete;
+  ~NaiveTunTcpConnection() = default;
+
+  const IPEndPoint& peer_address() const { return peer_address_; }
+  const IPEndPoint& local_address() const { return local_address_; }
+  // Whether the connection is not handed out yet.
+  bool is_pending() const { return handle_ == Handle::kNone; }
+  bool is_closed() const { return state_ == State::kClosed; }
+  int64_t total_received_bytes() const { return total_received_bytes_; }
+  bool was_ever_used() const { return was_ever_used_; }
+
+  base::WeakPtr<NaiveTunTcpConnection> GetWeakPtr() {
+    return weak_ptr_factory_.GetWeakPtr();
+  }
+
+  // Answers the SYN that opened the connection.
+  void Open(const Segment& syn);
+  void OnSegment(const Segment& segment);
+  // Sends the ACK held back by OnSegment(), unless a later segment has
+  // carried it.
+  void FlushAck();
+  // Resets the connection, sending RST unless the peer reset it.
+  void Abort(int error, bool send_rst);
+
+  // Called as the connection is handed out, and as its socket is destroyed.
+  void Attach() { handle_ = Handle::kAttached; }
+  void Close();
+
+  int Read(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
+  int ReadIfReady(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
+  int CancelReadIfReady();
+  int Write(IOBuffer* buf, int buf_len, CompletionOnceCallback callback);
+  int ShutdownWrite();
+  bool IsConnected() const;
+  bool IsConnectedAndIdle() const;
+
+ private:
+  enum class State {
+    kSynReceived,
+    kEstablished,
+    kClosed,
+  };
+
+  enum class Handle {
+    kNone,
+    kAttached,
+    kClosed,
+  };
+
+  // Bytes buffered each way.
+  static constexpr size_t kReceiveBufferSize = 512 * 1024;
+  static constexpr size_t kSendBufferSize = 512 * 1024;
+  // Offered to peers that scale their window, to advertise the whole
+  // receive buffer.
+  static constexpr int kWindowScale = 4;
+
+  void OnAck(const Segment& segment);
+  void OnPayload(const Segment& segment);
+  // Sends what the window of the peer allows of the buffered data, then the
+  // FIN once the data is sent if ShutdownWrite() was called.
+  void SendData();
+  // Sends the oldest unacknowledged segment again.
+  void RetransmitHead();
+  // Sends `size` bytes from `offset` of send_buffer_ at `seq`, with ACK.
+  void SendSegment(uint8_t flags, uint32_t seq, size_t offset, size_t size);
+  void ScheduleAck();
+  void StartRetransmitTimer();
+  void OnRetransmitTimer();
+  void MaybeSendWindowUpdate();
+  // Removes the connection once its socket is gone and both FINs are
+  // acknowledged.
+  void MaybeFinish();
+
+  size_t receive_window() const {
+    return kReceiveBufferSize - (recv_buffer_.size() - recv_offset_);
+  }
+  // Data sent and not acknowledged yet.
+  size_t bytes_in_flight() const {
+    return snd_nxt_ - snd_una_ - (fin_sent_ && !fin_acked_ ? 1 : 0);
+  }
+  size_t bytes_unsent() const {
+    return send_buffer_.size() - send_offset_ - bytes_in_flight();
+  }
+
+  int ReadFromBuffer(IOBuffer* buf, int buf_len);
+  int WriteToBuffer(IOBuffer* buf, int buf_len);
+  void ScheduleReadCallback();
+  void ScheduleWriteCallback();
+  void DoReadCallback();
+  void DoWriteCallback();
+
+  const raw_ptr<NaiveTunServerSocket> stack_;
+  const IPEndPoint peer_address_;
+  const IPEndPoint local_address_;
+  State state_ = State::kSynReceived;
+  Handle handle_ = Handle::kNone;
+  // Set when the connection is reset or times out, with the result of later
+  // reads and writes.
+  int error_ = OK;
+
+  // Next sequence number expected from the peer.
+  uint32_t rcv_nxt_ = 0;
+  // Oldest unacknowledged and next sequence number to send.
+  uint32_t snd_una_ = 0;
+  uint32_t snd_nxt_ = 0;
+  // Segments up to this were outstanding when a loss was detected. ACKs
+  // below it send the next hole again.
+  uint32_t recover_ = 0;
+  // Window of the peer in bytes, and its scale.
+  uint32_t snd_wnd_ = 0;
+  int snd_wscale_ = 0;
+  // Our scale, zero unless the peer offered window scaling.
+  int rcv_wscale_ = 0;
+  size_t mss_ = kDefaultSegmentSize;
+  int duplicate_acks_ = 0;
+  bool ack_pending_ = false;
+  // Window last advertised, in bytes.
+  size_t advertised_window_ = 0;
+
+  // Data received and not read yet, from recv_offset_.
+  std::string recv_buffer_;
+  size_t recv_offset_ = 0;
+  bool peer_fin_ = false;
+
+  // Data from snd_una_ on, sent or not, from send_offset_.
+  std::string send_buffer_;
+  size_t send_offset_ = 0;
+  bool fin_queued_ = false;
+  bool fin_sent_ = false;
+  bool fin_acked_ = false;
+
+  // Precise, so that it is not put off with the wake-ups aligned by
+  // --low-power.
+  base::DeadlineTimer retransmit_timer_;
+  base::TimeDelta rto_ = kInitialRto;
+  int retransmits_ = 0;
+  base::OneShotTimer linger_timer_;
+
+  bool read_notify_pending_ = false;
+  scoped_refptr<IOBuffer> read_buf_;
+  int read_buf_len_ = 0;
+  CompletionOnceCallback read_callback_;
+  // Whether read_callback_ is of ReadIfReady().
+  bool read_if_ready_ = false;
+
+  bool write_notify_pending_ = false;
+  scoped_refptr<IOBuffer> write_buf_;
+  int write_buf_len_ = 0;
+  CompletionOnceCallback write_callback_;
+
+  int64_t total_received_bytes_ = 0;
+  bool was_ever_used_ = false;
+
+  base::WeakPtrFactory<NaiveTunTcpConnection> weak_ptr_factory_{this};
+};
+
+void NaiveTunTcpConnection::Open(const Segment& syn) {
+  rcv_nxt_ = syn.seq + 1;
+  if (syn.mss >= kMinSegmentSize) {
+    mss_ = std::min(syn.mss, kMaxSegmentSize);
+  } else if (!peer_address_.address().IsIPv4()) {
+    mss_ = kDefaultSegmentSize6;
+  }
+  if (syn.window_scale >= 0) {
+    snd_wscale_ = std::min(syn.window_scale, 14);
+    rcv_wscale_ = kWindowScale;
+  }
+  snd_wnd_ = syn.window;
+  snd_una_ = static_cast<uint32_t>(base::RandUint64());
+  // The SYN takes a sequence number.
+  snd_nxt_ = snd_una_ + 1;
+  recover_ = snd_una_;
+  SendSegment(kSyn, snd_una_, 0, 0);
+  StartRetransmitTimer();
+}
+
+void NaiveTunTcpConnection::OnSegment(const Segment& segment) {
+  if (state_ == State::kClosed) {
+    return;
+  }
+  if (segment.flags & kRst) {
+    // Only an RST in the window is taken, so a stale one is not.
+    if (SeqLe(rcv_nxt_, segment.seq) &&
+        SeqLt(segment.seq,
+              rcv_nxt_ + std::max<size_t>(advertised_window_, 1))) {
+      Abort(ERR_CONNECTION_RESET, /*send_rst=*/false);
+    }
+    return;
+  }
+  if (state_ == State::kSynReceived) {
+    if (segment.flags & kSyn) {
+      // The SYN-ACK was lost.
+      if (segment.seq + 1 == rcv_nxt_) {
+        SendSegment(kSyn, snd_una_, 0, 0);
+      }
+      return;
+    }
+    if (!(segment.flags & kAck) || segment.ack != snd_nxt_) {
+      return;
+    }
+    state_ = State::kEstablished;
+    snd_una_ = segment.ack;
+    recover_ = snd_una_;
+    snd_wnd_ = static_cast<uint32_t>(segment.window) << snd_wscale_;
+    retransmit_timer_.Stop();
+    rto_ = kInitialRto;
+    retransmits_ = 0;
+    stack_->OnEstablished(this);
+  } else if (segment.flags & kSyn) {
+    ScheduleAck();
+    return;
+  } else if (!(segment.flags & kAck)) {
+    return;
+  } else {
+    OnAck(segment);
+  }
+  OnPayload(segment);
+  MaybeFinish();
+}
+
+void NaiveTunTcpConnection::OnAck(const Segment& segment) {
+  // Acknowledges data not sent yet.
+  if (SeqLt(snd_nxt_, segment.ack)) {
+    ScheduleAck();
+    return;
+  }
+  uint32_t window = static_cast<uint32_t>(segment.window) << snd_wscale_;
+  // The peer is still there, even if it has no room.
+  retransmits_ = 0;
+  if (SeqLt(snd_una_, segment.ack)) {
+    uint32_t acked = segment.ack - snd_una_;
+    if (fin_sent_ && segment.ack == snd_nxt_) {
+      fin_acked_ = true;
+      --acked;
+    }
+    send_offset_ += acked;
+    if (send_offset_ == send_buffer_.size()) {
+      send_buffer_.clear();
+      send_offset_ = 0;
+    }
+    snd_una_ = segment.ack;
+    snd_wnd_ = window;
+    duplicate_acks_ = 0;
+    rto_ = kInitialRto;
+    retransmit_timer_.Stop();
+    if (SeqLt(snd_una_, recover_)) {
+      RetransmitHead();
+    }
+    if (handle_ == Handle::kClosed) {
+      linger_timer_.Reset();
+    }
+    if (write_callback_) {
+      ScheduleWriteCallback();
+    }
+  } else if (segment.ack == snd_una_ && snd_una_ != snd_nxt_ &&
+             segment.payload_size == 0 && !(segment.flags & kFin) &&
+             window == snd_wnd_) {
+    if (++duplicate_acks_ == 3 && !SeqLt(snd_una_, recover_)) {
+      recover_ = snd_nxt_;
+      RetransmitHead();
+    }
+  } else {
+    bool reopened = snd_wnd_ == 0 && window > 0;
+    snd_wnd_ = window;
+    // A zero window probe may have been dropped.
+    if (reopened && snd_una_ != snd_nxt_) {
+      RetransmitHead();
+    }
+  }
+  SendData();
+}
+
+void NaiveTunTcpConnection::OnPayload(const Segment& segment) {
+  const uint8_t* payload = segment.payload;
+  size_t size = segment.payload_size;
+  bool fin = segment.flags & kFin;
+  if (size == 0 && !fin) {
+    return;
+  }
+  if (peer_fin_) {
+    // The ACK of the FIN was lost.
+    ScheduleAck();
+    return;
+  }
+  uint32_t seq = segment.seq;
+  if (SeqLt(seq, rcv_nxt_)) {
+    uint32_t skip = rcv_nxt_ - seq;
+    if (skip > size) {
+      ScheduleAck();
+      return;
+    }
+    payload += skip;
+    size -= skip;
+    seq = rcv_nxt_;
+  }
+  // Out of order segments are sent again by the kernel, which keeps them
+  // queued until the duplicate ACKs tell it what is missing.
+  if (seq != rcv_nxt_) {
+    ScheduleAck();
+    return;
+  }
+  if (size > 0 && handle_ == Handle::kClosed) {
+    // No one reads it, which the peer is told as by a closed kernel socket.
+    Abort(ERR_CONNECTION_RESET, /*send_rst=*/true);
+    return;
+  }
+  size_t accepted = std::min(size, receive_window());
+  if (accepted > 0) {
+    if (recv_offset_ > 0 && recv_offset_ >= recv_buffer_.size() / 2) {
+      recv_buffer_.erase(0, recv_offset_);
+      recv_offset_ = 0;
+    }
+    recv_buffer_.append(reinterpret_cast<const char*>(payload), accepted);
+    rcv_nxt_ += accepted;
+    total_received_bytes_ += accepted;
+  }
+  if (fin && accepted == size) {
+    ++rcv_nxt_;
+    peer_fin_ = true;
+  }
+  if (read_callback_ && (accepted > 0 || peer_fin_)) {
+    ScheduleReadCallback();
+  }
+  ScheduleAck();
+}
+
+void NaiveTunTcpConnection::SendData() {
+  if (state_ != State::kEstablished) {
+    return;
+  }
+  while (!fin_sent_) {
+    size_t unsent = bytes_unsent();
+    if (unsent == 0) {
+      if (fin_queued_) {
+        SendSegment(kFin, snd_nxt_, 0, 0);
+        ++snd_nxt_;
+        fin_sent_ = true;
+      }
+      break;
+    }
+    size_t in_flight = bytes_in_flight();
+    if (in_flight >= snd_wnd_) {
+      break;
+    }
+    size_t size = std::min({unsent, snd_wnd_ - in_flight, mss_});
+    SendSegment(size == unsent ? kPsh : 0, snd_nxt_,
+                send_offset_ + in_flight, size);
+    snd_nxt_ += size;
+  }
+  // Also probes a zero window once it times out.
+  if (!retransmit_timer_.IsRunning() &&
+      (snd_una_ != snd_nxt_ || bytes_unsent() > 0)) {
+    StartRetransmitTimer();
+  }
+}
+
+void NaiveTunTcpConnection::RetransmitHead() {
+  size_t size = std::min(bytes_in_flight(), mss_);
+  if (size > 0) {
+    SendSegment(kPsh, snd_una_, send_offset_, size);
+  } else if (fin_sent_ && !fin_acked_) {
+    SendSegment(kFin, snd_una_, 0, 0);
+  }
+}
+
+void NaiveTunTcpConnection::SendSegment(uint8_t flags,
+                                        uint32_t seq,
+                                        size_t offset,
+                                        size_t size) {
+  uint8_t options[8];
+  size_t options_size = 0;
+  uint16_t window;
+  if (flags & kSyn) {
+    // The window of SYN segments is not scaled.
+    window = static_cast<uint16_t>(std::min<size_t>(receive_window(), 65535));
+    advertised_window_ = window;
+    options[0] = 2;
+    options[1] = 4;
+    WriteU16(options + 2, kMaxSegmentSize);
+    options_size = 4;
+    if (rcv_wscale_ > 0) {
+      options[4] = 1;
+      options[5] = 3;
+      options[6] = 3;
+      options[7] = static_cast<uint8_t>(rcv_wscale_);
+      options_size = 8;
+    }
+  } else {
+    window = static_cast<uint16_t>(
+        std::min<size_t>(receive_window() >> rcv_wscale_, 65535));
+    advertised_window_ = static_cast<size_t>(window) << rcv_wscale_;
+  }
+  stack_->SendTcp(local_address_, peer_address_, seq, rcv_nxt_,
+                  flags | kAck, window,
+                  base::span<const uint8_t>(options, options_size),
+                  send_buffer_.data() + offset, size);
+  ack_pending_ = false;
+}
+
+void NaiveTunTcpConnection::ScheduleAck() {
+  if (ack_pending_) {
+    return;
+  }
+  ack_pending_ = true;
+  stack_->ScheduleAck(this);
+}
+
+void NaiveTunTcpConnection::FlushAck() {
+  if (ack_pending_ && state_ != State::kClosed) {
+    SendSegment(0, snd_nxt_, 0, 0);
+  }
+}
+
+void NaiveTunTcpConnection::StartRetransmitTimer() {
+  retransmit_timer_.Start(FROM_HERE, base::TimeTicks::Now() + rto_, this,
+                          &NaiveTunTcpConnection::OnRetransmitTimer,
+                          base::subtle::DelayPolicy::kPrecise);
+}
+
+void NaiveTunTcpConnection::OnRetransmitTimer() {
+  if (++retransmits_ > kMaxRetransmits) {
+    Abort(ERR_TIMED_OUT, /*send_rst=*/true);
+    return;
+  }
+  rto_ = std::min(rto_ * 2, kMaxRto);
+  if (state_ == State::kSynReceived) {
+    SendSegment(kSyn, snd_una_, 0, 0);
+  } else if (snd_una_ != snd_nxt_) {
+    duplicate_acks_ = 0;
+    recover_ = snd_nxt_;
+    RetransmitHead();
+  } else if (bytes_unsent() > 0) {
+    // Probes the zero window of the peer with a byte past it.
+    SendSegment(kPsh, snd_nxt_, send_offset_, 1);
+    ++snd_nxt_;
+  }
+  StartRetransmitTimer();
+}
+
+void NaiveTunTcpConnection::Abort(int error, bool send_rst) {
+  if (state_ == State::kClosed) {
+    return;
+  }
+  if (send_rst) {
+    stack_->SendTcp(local_address_, peer_address_, snd_nxt_, rcv_nxt_,
+                    kRst | kAck, 0, {}, nullptr, 0);
+  }
+  state_ = State::kClosed;
+  error_ = error;
+  retransmit_timer_.Stop();
+  linger_timer_.Stop();
+  auto* task_runner = base::SingleThreadTaskRunner::GetCurrentDefault().get();
+  if (read_callback_) {
+    read_buf_ = nullptr;
+    task_runner->PostTask(FROM_HERE,
+                          base::BindOnce(std::move(read_callback_), error));
+  }
+  if (write_callback_) {
+    write_buf_ = nullptr;
+    task_runner->PostTask(FROM_HERE,
+                          base::BindOnce(std::move(write_callback_), error));
+  }
+  stack_->RemoveConnection(this);
+}
+
+void NaiveTunTcpConnection::Close() {
+  handle_ = Handle::kClosed;
+  read_buf_ = nullptr;
+  read_callback_.Reset();
+  write_buf_ = nullptr;
+  write_callback_.Reset();
+  if (state_ == State::kClosed) {
+    return;
+  }
+  if (recv_offset_ < recv_buffer_.size()) {
+    Abort(ERR_CONNECTION_RESET, /*send_rst=*/true);
+    return;
+  }
+  fin_queued_ = true;
+  SendData();
+  linger_timer_.Start(
+      FROM_HERE, kLingerTimeout,
+      base::BindOnce(&NaiveTunTcpConnection::Abort, base::Unretained(this),
+                     ERR_TIMED_OUT, /*send_rst=*/true));
+  MaybeFinish();
+}
+
+void NaiveTunTcpConnection::MaybeFinish() {
+  if (handle_ != Handle::kClosed || !peer_fin_ || !fin_acked_ ||
+      state_ == State::kClosed) {
+    return;
+  }
+  state_ = State::kClosed;
+  retransmit_timer_.Stop();
+  linger_timer_.Stop();
+  stack_->RemoveConnection(this);
+}
+
+int NaiveTunTcpConnection::Read(IOBuffer* buf,
+                                int buf_len,
+                                CompletionOnceCallback callback) {
+  DCHECK(!read_callback_);
+  int rv = ReadFromBuffer(buf, buf_len);
+  if (rv != ERR_IO_PENDING) {
+    return rv;
+  }
+  read_buf_ = buf;
+  read_buf_len_ = buf_len;
+  read_callback_ = std::move(callback);
+  read_if_ready_ = false;
+  return ERR_IO_PENDING;
+}
+
+int NaiveTunTcpConnection::ReadIfReady(IOBuffer* buf,
+                                       int buf_len,
+                                       CompletionOnceCallback callback) {
+  DCHECK(!read_callback_);
+  int rv = ReadFromBuffer(buf, buf_len);
+  if (rv != ERR_IO_PENDING) {
+    return rv;
+  }
+  read_callback_ = std::move(callback);
+  read_if_ready_ = true;
+  return ERR_IO_PENDING;
+}
+
+int NaiveTunTcpConnection::CancelReadIfReady() {
+  read_callback_.Reset();
+  read_buf_ = nullptr;
+  return OK;
+}
+
+int NaiveTunTcpConnection::ReadFromBuffer(IOBuffer* buf, int buf_len) {
+  if (error_ != OK) {
+    return error_;
+  }
+  size_t available = recv_buffer_.size() - recv_offset_;
+  if (available > 0) {
+    size_t size = std::min(available, static_cast<size_t>(buf_len));
+    memcpy(buf->data(), recv_buffer_.data() + recv_offset_, size);
+    recv_offset_ += size;
+    if (recv_offset_ == recv_buffer_.size()) {
+      recv_buffer_.clear();
+      recv_offset_ = 0;
+    }
+    was_ever_used_ = true;
+    MaybeSendWindowUpdate();
+    return static_cast<int>(size);
+  }
+  if (peer_fin_) {
+    return 0;
+  }
+  return ERR_IO_PENDING;
+}
+
+void NaiveTunTcpConnection::MaybeSendWindowUpdate() {
+  // Waits for a quarter of the buffer to free up, so reads of the relay do
+  // not each send an ACK.
+  if (state_ == State::kEstablished && !peer_fin_ &&
+      receive_window() >= advertised_window_ + kReceiveBufferSize / 4) {
+    SendSegment(0, snd_nxt_, 0, 0);
+  }
+}
+
+int NaiveTunTcpConnection::Write(IOBuffer* buf,
+                                 int buf_len,
+                                 CompletionOnceCallback callback) {
+  DCHECK(!write_callback_);
+  if (error_ != OK) {
+    return error_;
+  }
+  if (fin_queued_ || state_ != State::kEstablished) {
+    return ERR_SOCKET_NOT_CONNECTED;
+  }
+  int rv = WriteToBuffer(buf, buf_len);
+  if (rv != ERR_IO_PENDING) {
+    return rv;
+  }
+  write_buf_ = buf;
+  write_buf_len_ = buf_len;
+  write_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
+int NaiveTunTcpConnection::WriteToBuffer(IOBuffer* buf, int buf_len) {
+  size_t buffered = send_buffer_.size() - send_offset_;
+  if (buffered >= kSendBufferSize) {
+    return ERR_IO_PENDING;
+  }
+  if (send_offset_ > 0 && send_offset_ >= send_buffer_.size() / 2) {
+    send_buffer_.erase(0, send_offset_);
+    send_offset_ = 0;
+  }
+  size_t size =
+      std::min(static_cast<size_t>(buf_len), kSendBufferSize - buffered);
+  send_buffer_.append(buf->data(), size);
+  was_ever_used_ = true;
+  SendData();
+  return static_cast<int>(size);
+}
+
+int NaiveTunTcpConnection::ShutdownWrite() {
+  if (error_ != OK) {
+    return error_;
+  }
+  if (state_ != State::kEstablished) {
+    return ERR_SOCKET_NOT_CONNECTED;
+  }
+  fin_queued_ = true;
+  SendData();
+  return OK;
+}
+
+bool NaiveTunTcpConnection::IsConnected() const {
+  return state_ == State::kEstablished &&
+         (!peer_fin_ || recv_offset_ < recv_buffer_.size());
+}
+
+bool NaiveTunTcpConnection::IsConnectedAndIdle() const {
+  return state_ == State::kEstablished && !peer_fin_ &&
+         recv_offset_ == recv_buffer_.size();
+}
+
+void NaiveTunTcpConnection::ScheduleReadCallback() {
+  if (read_notify_pending_) {
+    return;
+  }
+  read_notify_pending_ = true;
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveTunTcpConnection::DoReadCallback,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+void NaiveTunTcpConnection::ScheduleWriteCallback() {
+  if (write_notify_pending_) {
+    return;
+  }
+  write_notify_pending_ = true;
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveTunTcpConnection::DoWriteCallback,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+void NaiveTunTcpConnection::DoReadCallback() {
+  read_notify_pending_ = false;
+  if (!read_callback_) {
+    return;
+  }
+  if (read_if_ready_) {
+    std::move(read_callback_).Run(OK);
+    return;
+  }
+  int rv = ReadFromBuffer(read_buf_.get(), read_buf_len_);
+  if (rv == ERR_IO_PENDING) {
+    return;
+  }
+  read_buf_ = nullptr;
+  std::move(read_callback_).Run(rv);
+}
+
+void NaiveTunTcpConnection::DoWriteCallback() {
+  write_notify_pending_ = false;
+  if (!write_callback_) {
+    return;
+  }
+  int rv = WriteToBuffer(write_buf_.get(), write_buf_len_);
+  if (rv == ERR_IO_PENDING) {
+    return;
+  }
+  write_buf_ = nullptr;
+  std::move(write_callback_).Run(rv);
+}
+
+NaiveTunTcpSocket::NaiveTunTcpSocket(
+    base::WeakPtr<NaiveTunTcpConnection> connection,
+    const IPEndPoint& peer_address,
+    const IPEndPoint& local_address)
+    : connection_(std::move(connection)),
+      peer_address_(peer_address),
+      local_address_(local_address),
+      net_log_(NetLogWithSource::Make(NetLogSourceType::NONE)) {}
+
+NaiveTunTcpSocket::~NaiveTunTcpSocket() {
+  Disconnect();
+}
+
+int NaiveTunTcpSocket::Connect(CompletionOnceCallback callback) {
+  return OK;
+}
+
+void NaiveTunTcpSocket::Disconnect() {
+  if (connection_) {
+    connection_->Close();
+    connection_ = nullptr;
+  }
+}
+
+int NaiveTunTcpSocket::ShutdownWrite() {
+  if (!connection_) {
+    return ERR_CONNECTION_RESET;
+  }
+  return connection_->ShutdownWrite();
+}
+
+bool NaiveTunTcpSocket::IsConnected() const {
+  return connection_ && connection_->IsConnected();
+}
+
+bool NaiveTunTcpSocket::IsConnectedAndIdle() const {
+  return connection_ && connection_->IsConnectedAndIdle();
+}
+
+const NetLogWithSource& NaiveTunTcpSocket::NetLog() const {
+  return net_log_;
+}
+
+bool NaiveTunTcpSocket::WasEverUsed() const {
+  return !connection_ || connection_->was_ever_used();
+}
+
+NextProto NaiveTunTcpSocket::GetNegotiatedProtocol() const {
+  return kProtoUnknown;
+}
+
+bool NaiveTunTcpSocket::GetSSLInfo(SSLInfo* ssl_info) {
+  return false;
+}
+
+int64_t NaiveTunTcpSocket::GetTotalReceivedBytes() const {
+  return connection_ ? connection_->total_received_bytes() : 0;
+}
+
+void NaiveTunTcpSocket::ApplySocketTag(const SocketTag& tag) {}
+
+int NaiveTunTcpSocket::Read(IOBuffer* buf,
+                            int buf_len,
+                            CompletionOnceCallback callback) {
+  if (!connection_) {
+    return ERR_CONNECTION_RESET;
+  }
+  return connection_->Read(buf, buf_len, std::move(callback));
+}
+
+int NaiveTunTcpSocket::ReadIfReady(IOBuffer* buf,
+                                   int buf_len,
+                                   CompletionOnceCallback callback) {
+  if (!connection_) {
+    return ERR_CONNECTION_RESET;
+  }
+  return connection_->ReadIfReady(buf, buf_len, std::move(callback));
+}
+
+int NaiveTunTcpSocket::CancelReadIfReady() {
+  if (!connection_) {
+    return OK;
+  }
+  return connection_->CancelReadIfReady();
+}
+
+int NaiveTunTcpSocket::Write(
+    IOBuffer* buf,
+    int buf_len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  if (!connection_) {
+    return ERR_CONNECTION_RESET;
+  }
+  return connection_->Write(buf, buf_len, std::move(callback));
+}
+
+int NaiveTunTcpSocket::SetReceiveBufferSize(int32_t size) {
+  return OK;
+}
+
+int NaiveTunTcpSocket::SetSendBufferSize(int32_t size) {
+  return OK;
+}
+
+int NaiveTunTcpSocket::GetPeerAddress(IPEndPoint* address) const {
+  *address = peer_address_;
+  return OK;
+}
+
+int NaiveTunTcpSocket::GetLocalAddress(IPEndPoint* address) const {
+  *address = local_address_;
+  return OK;
+}
+
+NaiveTunDnsSocket::NaiveTunDnsSocket(base::WeakPtr<NaiveTunServerSocket> stack)
+    : stack_(std::move(stack)),
+      net_log_(NetLogWithSource::Make(NetLogSourceType::NONE)) {}
+
+NaiveTunDnsSocket::~NaiveTunDnsSocket() {
+  Close();
+}
+
+int NaiveTunDnsSocket::Listen(const IPEndPoint& address) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int NaiveTunDnsSocket::RecvFrom(IOBuffer* buf,
+                                int buf_len,
+                                IPEndPoint* address,
+                                CompletionOnceCallback callback) {
+  DCHECK(!recv_callback_);
+  if (!queries_.empty()) {
+    Query& query = queries_.front();
+    int size = std::min(buf_len, static_cast<int>(query.data.size()));
+    memcpy(buf->data(), query.data.data(), size);
+    *address = query.client;
+    queries_.pop();
+    return size;
+  }
+  // Stays pending once closed, so the reader does not spin on errors.
+  recv_buf_ = buf;
+  recv_buf_len_ = buf_len;
+  recv_address_ = address;
+  recv_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
+int NaiveTunDnsSocket::SendTo(IOBuffer* buf,
+                              int buf_len,
+                              const IPEndPoint& address,
+                              CompletionOnceCallback callback) {
+  auto it = servers_.find(address);
+  if (!stack_ || it == servers_.end()) {
+    return ERR_ADDRESS_UNREACHABLE;
+  }
+  if (static_cast<size_t>(buf_len) >
+      kMaxIPPacketSize - kIPv6HeaderSize - kUdpHeaderSize) {
+    return ERR_MSG_TOO_BIG;
+  }
+  stack_->SendUdp(it->second, address, buf->data(), buf_len);
+  return buf_len;
+}
+
+int NaiveTunDnsSocket::SetReceiveBufferSize(int32_t size) {
+  return OK;
+}
+
+int NaiveTunDnsSocket::SetSendBufferSize(int32_t size) {
+  return OK;
+}
+
+void NaiveTunDnsSocket::AllowAddressReuse() {}
+
+void NaiveTunDnsSocket::AllowBroadcast() {}
+
+void NaiveTunDnsSocket::AllowAddressSharingForMulticast() {}
+
+int NaiveTunDnsSocket::JoinGroup(const IPAddress& group_address) const {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int NaiveTunDnsSocket::LeaveGroup(const IPAddress& group_address) const {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int NaiveTunDnsSocket::SetMulticastInterface(uint32_t interface_index) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int NaiveTunDnsSocket::SetMulticastTimeToLive(int time_to_live) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int NaiveTunDnsSocket::SetMulticastLoopbackMode(bool loopback) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int NaiveTunDnsSocket::SetDiffServCodePoint(DiffServCodePoint dscp) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+void NaiveTunDnsSocket::DetachFromThread() {}
+
+void NaiveTunDnsSocket::Close() {
+  if (stack_) {
+    stack_->dns_socket_ = nullptr;
+    stack_ = nullptr;
+  }
+  queries_ = {};
+  servers_.clear();
+}
+
+int NaiveTunDnsSocket::GetPeerAddress(IPEndPoint* address) const {
+  return ERR_SOCKET_NOT_CONNECTED;
+}
+
+int NaiveTunDnsSocket::GetLocalAddress(IPEndPoint* address) const {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+void NaiveTunDnsSocket::UseNonBlockingIO() {}
+
+int NaiveTunDnsSocket::SetDoNotFragment() {
+  return OK;
+}
+
+int NaiveTunDnsSocket::SetRecvTos() {
+  return OK;
+}
+
+int NaiveTunDnsSocket::SetTos(DiffServCodePoint dscp, EcnCodePoint ecn) {
+  return OK;
+}
+
+void NaiveTunDnsSocket::SetMsgConfirm(bool confirm) {}
+
+const NetLogWithSource& NaiveTunDnsSocket::NetLog() const {
+  return net_log_;
+}
+
+DscpAndEcn NaiveTunDnsSocket::GetLastTos() const {
+  return {DSCP_DEFAULT, ECN_DEFAULT};
+}
+
+void NaiveTunDnsSocket::OnQuery(const IPEndPoint& client,
+                                const IPEndPoint& server,
+                                const uint8_t* data,
+                                size_t size) {
+  if (queries_.size() >= kMaxQueuedQueries) {
+    return;
+  }
+  if (servers_.size() >= kMaxClients && !servers_.contains(client)) {
+    servers_.clear();
+  }
+  servers_[client] = server;
+  queries_.push({client, std::string(reinterpret_cast<const char*>(data),
+                                     size)});
+  if (recv_callback_ && !recv_notify_pending_) {
+    recv_notify_pending_ = true;
+    base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+        FROM_HERE, base::BindOnce(&NaiveTunDnsSocket::DoRecvCallback,
+                                  weak_ptr_factory_.GetWeakPtr()));
+  }
+}
+
+void NaiveTunDnsSocket::DoRecvCallback() {
+  recv_notify_pending_ = false;
+  if (!recv_callback_ || queries_.empty()) {
+    return;
+  }
+  scoped_refptr<IOBuffer> buf = std::move(recv_buf_);
+  IPEndPoint* address = recv_address_;
+  recv_address_ = nullptr;
+  int rv = RecvFrom(buf.get(), recv_buf_len_, address,
+                    CompletionOnceCallback());
+  std::move(recv_callback_).Run(rv);
+}
+
+NaiveTunServerSocket::NaiveTunServerSocket(base::ScopedFD fd)
+    : fd_(std::move(fd)), packet_buffer_(kPacketBufferSize) {
+  if (!base::SetNonBlocking(fd_.get())) {
+    PLOG(ERROR) << "Failed to set TUN device non-blocking";
+  }
+}
+
+NaiveTunServerSocket::~NaiveTunServerSocket() {
+  // The sockets handed out see ERR_CONNECTION_RESET.
+  auto connections = std::move(connections_);
+  connections_.clear();
+  for (auto& [key, connection] : connections) {
+    connection->Abort(ERR_CONNECTION_RESET, /*send_rst=*/true);
+  }
+}
+
+// static
+base::ScopedFD NaiveTunServerSocket::OpenDevice(const std::string& name) {
+  if (name.empty() || name.size() >= IFNAMSIZ) {
+    LOG(ERROR) << "Invalid TUN device name: " << name;
+    return base::ScopedFD();
+  }
+  base::ScopedFD fd(HANDLE_EINTR(open("/dev/net/tun", O_RDWR | O_CLOEXEC)));
+  if (!fd.is_valid()) {
+    PLOG(ERROR) << "Failed to open /dev/net/tun";
+    return base::ScopedFD();
+  }
+  struct ifreq ifr = {};
+  ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+  memcpy(ifr.ifr_name, name.data(), name.size());
+  if (ioctl(fd.get(), TUNSETIFF, &ifr) < 0) {
+    PLOG(ERROR) << "Failed to attach to TUN device " << name;
+    return base::ScopedFD();
+  }
+  return fd;
+}
+
+std::unique_ptr<NaiveTunDnsSocket> NaiveTunServerSocket::CreateDnsSocket() {
+  DCHECK(!dns_socket_);
+  auto dns_socket =
+      std::make_unique<NaiveTunDnsSocket>(weak_ptr_factory_.GetWeakPtr());
+  dns_socket_ = dns_socket.get();
+  return dns_socket;
+}
+
+int NaiveTunServerSocket::Listen(const IPEndPoint& address,
+                                 int backlog,
+                                 std::optional<bool> ipv6_only) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int NaiveTunServerSocket::GetLocalAddress(IPEndPoint* address) const {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int NaiveTunServerSocket::Accept(std::unique_ptr<StreamSocket>* socket,
+                                 CompletionOnceCallback callback) {
+  return Accept(socket, std::move(callback), nullptr);
+}
+
+int NaiveTunServerSocket::Accept(std::unique_ptr<StreamSocket>* socket,
+                                 CompletionOnceCallback callback,
+                                 IPEndPoint* peer_address) {
+  DCHECK(!accept_callback_);
+  if (!StartWatching()) {
+    return ERR_FAILED;
+  }
+  if (TakeConnection(socket, peer_address)) {
+    return OK;
+  }
+  accept_socket_ = socket;
+  accept_peer_address_ = peer_address;
+  accept_callback_ = std::move(callback);
+  return ERR_IO_PENDING;
+}
+
+bool NaiveTunServerSocket::StartWatching() {
+  if (watching_) {
+    return true;
+  }
+  watching_ = base::CurrentIOThread::Get()->WatchFileDescriptor(
+      fd_.get(), /*persistent=*/true, base::MessagePumpForIO::WATCH_READ,
+      &controller_, this);
+  if (!watching_) {
+    LOG(ERROR) << "WatchFileDescriptor failed on TUN device";
+  }
+  return watching_;
+}
+
+void NaiveTunServerSocket::OnFileCanReadWithoutBlocking(int fd) {
+  for (int i = 0; i < kMaxPacketsPerRead; ++i) {
+    ssize_t rv = HANDLE_EINTR(
+        read(fd_.get(), packet_buffer_.data(), packet_buffer_.size()));
+    if (rv < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        PLOG(ERROR) << "Failed to read from TUN device";
+        controller_.StopWatchingFileDescriptor();
+        watching_ = false;
+      }
+      break;
+    }
+    HandlePacket(packet_buffer_.data(), rv);
+  }
+  // Segments read together are acknowledged together.
+  std::vector<base::WeakPtr<NaiveTunTcpConnection>> ack_pending =
+      std::move(ack_pending_);
+  ack_pending_.clear();
+  for (const auto& connection : ack_pending) {
+    if (connection) {
+      connection->FlushAck();
+    }
+  }
+  CompleteAccept();
+}
+
+void NaiveTunServerSocket::OnFileCanWriteWithoutBlocking(int fd) {}
+
+void NaiveTunServerSocket::HandlePacket(const uint8_t* packet, size_t size) {
+  if (size == 0) {
+    return;
+  }
+  IPAddress source;
+  IPAddress destination;
+  uint8_t protocol;
+  size_t header_size;
+  size_t packet_size;
+  if (packet[0] >> 4 == 4) {
+    if (size < kIPv4HeaderSize) {
+      return;
+    }
+    header_size = (packet[0] & 0x0f) * 4;
+    packet_size = ReadU16(packet + 2);
+    if (header_size < kIPv4HeaderSize || packet_size < header_size ||
+        packet_size > size) {
+      return;
+    }
+    // Fragments are not reassembled.
+    if (ReadU16(packet + 6) & 0x3fff) {
+      return;
+    }
+    protocol = packet[9];
+    source = IPAddress(base::span<const uint8_t>(packet + 12, 4u));
+    destination = IPAddress(base::span<const uint8_t>(packet + 16, 4u));
+  } else if (packet[0] >> 4 == 6) {
+    if (size < kIPv6HeaderSize) {
+      return;
+    }
+    header_size = kIPv6HeaderSize;
+    packet_size = kIPv6HeaderSize + ReadU16(packet + 4);
+    if (packet_size > size) {
+      return;
+    }
+    // Extension headers are not followed.
+    protocol = packet[6];
+    source = IPAddress(base::span<const uint8_t>(packet + 8, 16u));
+    destination = IPAddress(base::span<const uint8_t>(packet + 24, 16u));
+  } else {
+    return;
+  }
+  // Checksums are not verified, as the packets come from the kernel.
+  if (protocol == kProtocolTcp) {
+    HandleTcp(source, destination, packet + header_size,
+              packet_size - header_size);
+  } else if (protocol == kProtocolUdp) {
+    HandleUdp(source, destination, packet + header_size,
+              packet_size - header_size);
+  }
+}
+
+void NaiveTunServerSocket::HandleTcp(const IPAddress& source,
+                                     const IPAddress& destination,
+                                     const uint8_t* data,
+                                     size_t size) {
+  if (size < kTcpHeaderSize) {
+    return;
+  }
+  size_t header_size = (data[12] >> 4) * 4;
+  if (header_size < kTcpHeaderSize || header_size > size) {
+    return;
+  }
+  IPEndPoint peer(source, ReadU16(data));
+  IPEndPoint local(destination, ReadU16(data + 2));
+  NaiveTunTcpConnection::Segment segment;
+  segment.seq = ReadU32(data + 4);
+  segment.ack = ReadU32(data + 8);
+  segment.flags = data[13];
+  segment.window = ReadU16(data + 14);
+  segment.payload = data + header_size;
+  segment.payload_size = size - header_size;
+  if (segment.flags & kSyn) {
+    for (size_t i = kTcpHeaderSize; i < header_size;) {
+      uint8_t kind = data[i];
+      if (kind == 0) {
+        break;
+      }
+      if (kind == 1) {
+        ++i;
+        continue;
+      }
+      if (i + 1 >= header_size) {
+        break;
+      }
+      size_t length = data[i + 1];
+      if (length < 2 || i + length > header_size) {
+        break;
+      }
+      if (kind == 2 && length == 4) {
+        segment.mss = ReadU16(data + i + 2);
+      } else if (kind == 3 && length == 3) {
+        segment.window_scale = data[i + 2];
+      }
+      i += length;
+    }
+  }
+
+  auto it = connections_.find({peer, local});
+  if (it != connections_.end()) {
+    it->second->OnSegment(segment);
+    return;
+  }
+  if (segment.flags & kRst) {
+    return;
+  }
+  if ((segment.flags & (kSyn | kAck | kFin)) == kSyn && local.port() != 0 &&
+      pending_connections_ < kMaxPendingConnections) {
+    auto connection =
+        std::make_unique<NaiveTunTcpConnection>(this, peer, local);
+    NaiveTunTcpConnection* connection_ptr = connection.get();
+    connections_[{peer, local}] = std::move(connection);
+    ++pending_connections_;
+    connection_ptr->Open(segment);
+    return;
+  }
+  // Segments of no connection are answered with RST, as RFC 9293 has it.
+  if (segment.flags & kAck) {
+    SendTcp(local, peer, segment.ack, 0, kRst, 0, {}, nullptr, 0);
+  } else {
+    uint32_t ack = segment.seq + segment.payload_size +
+                   (segment.flags & kSyn ? 1 : 0) +
+                   (segment.flags & kFin ? 1 : 0);
+    SendTcp(local, peer, 0, ack, kRst | kAck, 0, {}, nullptr, 0);
+  }
+}
+
+void NaiveTunServerSocket::HandleUdp(const IPAddress& source,
+                                     const IPAddress& destination,
+                                     const uint8_t* data,
+                                     size_t size) {
+  if (size < kUdpHeaderSize) {
+    return;
+  }
+  size_t length = ReadU16(data + 4);
+  if (length < kUdpHeaderSize || length > size) {
+    return;
+  }
+  uint16_t port = ReadU16(data + 2);
+  if (port != kDnsPort || !dns_socket_) {
+    return;
+  }
+  dns_socket_->OnQuery(IPEndPoint(source, ReadU16(data)),
+                       IPEndPoint(destination, port), data + kUdpHeaderSize,
+                       length - kUdpHeaderSize);
+}
+
+void NaiveTunServerSocket::SendTcp(const IPEndPoint& local,
+                                   const IPEndPoint& peer,
+                                   uint32_t seq,
+                                   uint32_t ack,
+                                   uint8_t flags,
+                                   uint16_t window,
+                                   base::span<const uint8_t> options,
+                                   const char* payload,
+                                   size_t payload_size) {
+  size_t header_size = kTcpHeaderSize + options.size();
+  uint8_t* header = BeginPacket(peer, header_size + payload_size);
+  WriteU16(header, local.port());
+  WriteU16(header + 2, peer.port());
+  WriteU32(header + 4, seq);
+  WriteU32(header + 8, ack);
+  header[12] = static_cast<uint8_t>((header_size / 4) << 4);
+  header[13] = flags;
+  WriteU16(header + 14, window);
+  WriteU32(header + 16, 0);
+  if (!options.empty()) {
+    memcpy(header + kTcpHeaderSize, options.data(), options.size());
+  }
+  if (payload_size > 0) {
+    memcpy(header + header_size, payload, payload_size);
+  }
+  FinishPacket(local, peer, kProtocolTcp, header_size + payload_size,
+               /*checksum_offset=*/16);
+}
+
+void NaiveTunServerSocket::SendUdp(const IPEndPoint& source,
+                                   const IPEndPoint& destination,
+                                   const char* payload,
+                                   size_t payload_size) {
+  size_t size = kUdpHeaderSize + payload_size;
+  uint8_t* header = BeginPacket(destination, size);
+  WriteU16(header, source.port());
+  WriteU16(header + 2, destination.port());
+  WriteU16(header + 4, static_cast<uint16_t>(size));
+  WriteU16(header + 6, 0);
+  memcpy(header + kUdpHeaderSize, payload, payload_size);
+  FinishPacket(source, destination, kProtocolUdp, size,
+               /*checksum_offset=*/6);
+}
+
+uint8_t* NaiveTunServerSocket::BeginPacket(const IPEndPoint& destination,
+                                           size_t size) {
+  size_t header_size =
+      destination.address().IsIPv4() ? kIPv4HeaderSize : kIPv6HeaderSize;
+  send_packet_.resize(header_size + size);
+  return send_packet_.data() + header_size;
+}
+
+void NaiveTunServerSocket::FinishPacket(const IPEndPoint& source,
+                                        const IPEndPoint& destination,
+                                        uint8_t protocol,
+                                        size_t size,
+                                        size_t checksum_offset) {
+  const IPAddressBytes& source_bytes = source.address().bytes();
+  const IPAddressBytes& destination_bytes = destination.address().bytes();
+  bool ipv4 = destination.address().IsIPv4();
+  size_t header_size = ipv4 ? kIPv4HeaderSize : kIPv6HeaderSize;
+  uint8_t* packet = send_packet_.data();
+  uint8_t* transport = packet + header_size;
+
+  // The pseudo header, then the transport header and payload.
+  uint64_t sum = ChecksumAdd(0, source_bytes.data(), source_bytes.size());
+  sum = ChecksumAdd(sum, destination_bytes.data(), destination_bytes.size());
+  sum += protocol;
+  sum += size;
+  sum = ChecksumAdd(sum, transport, size);
+  uint16_t checksum = ChecksumFold(sum);
+  // Zero means no checksum in UDP.
+  if (protocol == kProtocolUdp && checksum == 0) {
+    checksum = 0xffff;
+  }
+  WriteU16(transport + checksum_offset, checksum);
+
+  if (ipv4) {
+    packet[0] = 0x45;
+    packet[1] = 0;
+    WriteU16(packet + 2, static_cast<uint16_t>(header_size + size));
+    WriteU16(packet + 4, 0);
+    // Don't fragment.
+    WriteU16(packet + 6, 0x4000);
+    packet[8] = 64;
+    packet[9] = protocol;
+    WriteU16(packet + 10, 0);
+    memcpy(packet + 12, source_bytes.data(), 4);
+    memcpy(packet + 16, destination_bytes.data(), 4);
+    WriteU16(packet + 10, ChecksumFold(ChecksumAdd(0, packet, header_size)));
+  } else {
+    WriteU32(packet, 0x60000000);
+    WriteU16(packet + 4, static_cast<uint16_t>(size));
+    packet[6] = protocol;
+    packet[7] = 64;
+    memcpy(packet + 8, source_bytes.data(), 16);
+    memcpy(packet + 24, destination_bytes.data(), 16);
+  }
+  // Dropped if the device queue is full.
+  (void)HANDLE_EINTR(write(fd_.get(), packet, header_size + size));
+}
+
+void NaiveTunServerSocket::ScheduleAck(NaiveTunTcpConnection* connection) {
+  ack_pending_.push_back(connection->GetWeakPtr());
+}
+
+void NaiveTunServerSocket::OnEstablished(NaiveTunTcpConnection* connection) {
+  established_.push(connection->GetWeakPtr());
+}
+
+void NaiveTunServerSocket::RemoveConnection(
+    NaiveTunTcpConnection* connection) {
+  auto it = connections_.find(
+      {connection->peer_address(), connection->local_address()});
+  if (it == connections_.end()) {
+    return;
+  }
+  if (connection->is_pending()) {
+    --pending_connections_;
+  }
+  // The connection is on the call stack.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->DeleteSoon(
+      FROM_HERE, std::move(it->second));
+  connections_.erase(it);
+}
+
+bool NaiveTunServerSocket::TakeConnection(
+    std::unique_ptr<StreamSocket>* socket,
+    IPEndPoint* peer_address) {
+  while (!established_.empty()) {
+    base::WeakPtr<NaiveTunTcpConnection> connection =
+        std::move(established_.front());
+    established_.pop();
+    // Reset before it was handed out.
+    if (!connection || !connection->is_pending() || connection->is_closed()) {
+      continue;
+    }
+    --pending_connections_;
+    connection->Attach();
+    if (peer_address) {
+      *peer_address = connection->peer_address();
+    }
+    IPEndPoint peer = connection->peer_address();
+    IPEndPoint local = connection->local_address();
+    *socket = std::make_unique<NaiveTunTcpSocket>(std::move(connection),
+                                                  peer, local);
+    return true;
+  }
+  return false;
+}
+
+void NaiveTunServerSocket::CompleteAccept() {
+  if (!accept_callback_ ||
+      !TakeConnection(accept_socket_, accept_peer_address_)) {
+    return;
+  }
+  accept_socket_ = nullptr;
+  accept_peer_address_ = nullptr;
+  std::move(accept_callback_).Run(OK);
+}
+
+}  // namespace net
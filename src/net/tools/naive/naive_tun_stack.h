@@ -0,0 +1,300 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_TUN_STACK_H_
+#define NET_TOOLS_NAIVE_NAIVE_TUN_STACK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/containers/span.h"
+#include "base/files/scoped_file.h"
+#include "base/memory/raw_ptr.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_pump_for_io.h"
+#include "net/base/completion_once_callback.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/log/net_log_with_source.h"
+#include "net/socket/datagram_server_socket.h"
+#include "net/socket/server_socket.h"
+#include "net/socket/stream_socket.h"
+
+namespace net {
+
+class NaiveTunServerSocket;
+class NaiveTunTcpConnection;
+
+// A TCP connection terminated by NaiveTunServerSocket, as handed out by
+// Accept(). Its peer is the application that opened the connection, and its
+// local address is the destination the application connected to.
+//
+// The connection is kept by the server socket, which sends what is left of
+// the buffered data and the FIN once this is destroyed, like close() of a
+// kernel socket.
+class NaiveTunTcpSocket : public StreamSocket {
+ public:
+  NaiveTunTcpSocket(base::WeakPtr<NaiveTunTcpConnection> connection,
+                    const IPEndPoint& peer_address,
+                    const IPEndPoint& local_address);
+  NaiveTunTcpSocket(const NaiveTunTcpSocket&) = delete;
+  NaiveTunTcpSocket& operator=(const NaiveTunTcpSocket&) = delete;
+  ~NaiveTunTcpSocket() override;
+
+  // StreamSocket implementation.
+  int Connect(CompletionOnceCallback callback) override;
+  void Disconnect() override;
+  int ShutdownWrite() override;
+  bool IsConnected() const override;
+  bool IsConnectedAndIdle() const override;
+  const NetLogWithSource& NetLog() const override;
+  bool WasEverUsed() const override;
+  NextProto GetNegotiatedProtocol() const override;
+  bool GetSSLInfo(SSLInfo* ssl_info) override;
+  int64_t GetTotalReceivedBytes() const override;
+  void ApplySocketTag(const SocketTag& tag) override;
+
+  // Socket implementation.
+  int Read(IOBuffer* buf,
+           int buf_len,
+           CompletionOnceCallback callback) override;
+  int ReadIfReady(IOBuffer* buf,
+                  int buf_len,
+                  CompletionOnceCallback callback) override;
+  int CancelReadIfReady() override;
+  int Write(IOBuffer* buf,
+            int buf_len,
+            CompletionOnceCallback callback,
+            const NetworkTrafficAnnotationTag& traffic_annotation) override;
+  int SetReceiveBufferSize(int32_t size) override;
+  int SetSendBufferSize(int32_t size) override;
+  int GetPeerAddress(IPEndPoint* address) const override;
+  int GetLocalAddress(IPEndPoint* address) const override;
+
+ private:
+  // Null once the connection is reset.
+  base::WeakPtr<NaiveTunTcpConnection> connection_;
+  const IPEndPoint peer_address_;
+  const IPEndPoint local_address_;
+  NetLogWithSource net_log_;
+};
+
+// Datagrams sent through the TUN device to port 53 of any address, so a
+// RedirectResolver can answer the DNS queries of the applications. Replies
+// are sent from the address the query of the same client went to.
+class NaiveTunDnsSocket : public DatagramServerSocket {
+ public:
+  explicit NaiveTunDnsSocket(base::WeakPtr<NaiveTunServerSocket> stack);
+  NaiveTunDnsSocket(const NaiveTunDnsSocket&) = delete;
+  NaiveTunDnsSocket& operator=(const NaiveTunDnsSocket&) = delete;
+  ~NaiveTunDnsSocket() override;
+
+  // DatagramServerSocket implementation.
+  int Listen(const IPEndPoint& address) override;
+  int RecvFrom(IOBuffer* buf,
+               int buf_len,
+               IPEndPoint* address,
+               CompletionOnceCallback callback) override;
+  int SendTo(IOBuffer* buf,
+             int buf_len,
+             const IPEndPoint& address,
+             CompletionOnceCallback callback) override;
+  int SetReceiveBufferSize(int32_t size) override;
+  int SetSendBufferSize(int32_t size) override;
+  void AllowAddressReuse() override;
+  void AllowBroadcast() override;
+  void AllowAddressSharingForMulticast() override;
+  int JoinGroup(const IPAddress& group_address) const override;
+  int LeaveGroup(const IPAddress& group_address) const override;
+  int SetMulticastInterface(uint32_t interface_index) override;
+  int SetMulticastTimeToLive(int time_to_live) override;
+  int SetMulticastLoopbackMode(bool loopback) override;
+  int SetDiffServCodePoint(DiffServCodePoint dscp) override;
+  void DetachFromThread() override;
+
+  // DatagramSocket implementation.
+  void Close() override;
+  int GetPeerAddress(IPEndPoint* address) const override;
+  int GetLocalAddress(IPEndPoint* address) const override;
+  void UseNonBlockingIO() override;
+  int SetDoNotFragment() override;
+  int SetRecvTos() override;
+  int SetTos(DiffServCodePoint dscp, EcnCodePoint ecn) override;
+  void SetMsgConfirm(bool confirm) override;
+  const NetLogWithSource& NetLog() const override;
+  DscpAndEcn GetLastTos() const override;
+
+ private:
+  friend class NaiveTunServerSocket;
+
+  // Queries waiting for RecvFrom(), up to this many.
+  static constexpr size_t kMaxQueuedQueries = 64;
+  // Clients whose query address is remembered for the replies.
+  static constexpr size_t kMaxClients = 1024;
+
+  struct Query {
+    IPEndPoint client;
+    std::string data;
+  };
+
+  void OnQuery(const IPEndPoint& client,
+               const IPEndPoint& server,
+               const uint8_t* data,
+               size_t size);
+  void DoRecvCallback();
+
+  base::WeakPtr<NaiveTunServerSocket> stack_;
+  NetLogWithSource net_log_;
+  std::queue<Query> queries_;
+  // The address each client sent its last query to.
+  std::map<IPEndPoint, IPEndPoint> servers_;
+
+  scoped_refptr<IOBuffer> recv_buf_;
+  int recv_buf_len_ = 0;
+  raw_ptr<IPEndPoint> recv_address_ = nullptr;
+  CompletionOnceCallback recv_callback_;
+  bool recv_notify_pending_ = false;
+
+  base::WeakPtrFactory<NaiveTunDnsSocket> weak_ptr_factory_{this};
+};
+
+// A userspace TCP/IP stack on a TUN device. Terminates the TCP connections
+// of the IPv4 and IPv6 packets read from the device, and hands each out as a
+// NaiveTunTcpSocket once its handshake completes. UDP datagrams to port 53
+// go to the NaiveTunDnsSocket, if one was created. Other packets, and IP
+// fragments, are dropped.
+//
+// The stack only talks to the kernel over the device, so it keeps to what
+// that needs: in-order segments are taken and others dropped for the kernel
+// to send again, the window of the application is the only limit on
+// sending, and unacknowledged data is sent again with exponential backoff,
+// or after three duplicate ACKs.
+//
+// Destroying the server socket resets the connections.
+class NaiveTunServerSocket : public ServerSocket,
+                             public base::MessagePumpForIO::FdWatcher {
+ public:
+  // `fd` is a TUN device without packet information.
+  explicit NaiveTunServerSocket(base::ScopedFD fd);
+  NaiveTunServerSocket(const NaiveTunServerSocket&) = delete;
+  NaiveTunServerSocket& operator=(const NaiveTunServerSocket&) = delete;
+  ~NaiveTunServerSocket() override;
+
+  // Opens the TUN device `name`, creating it if it does not exist. Returns
+  // an invalid descriptor on failure.
+  static base::ScopedFD OpenDevice(const std::string& name);
+
+  // Returns the socket of the DNS queries. Must be called once at most.
+  std::unique_ptr<NaiveTunDnsSocket> CreateDnsSocket();
+
+  // ServerSocket implementation.
+  int Listen(const IPEndPoint& address,
+             int backlog,
+             std::optional<bool> ipv6_only) override;
+  int GetLocalAddress(IPEndPoint* address) const override;
+  int Accept(std::unique_ptr<StreamSocket>* socket,
+             CompletionOnceCallback callback) override;
+  int Accept(std::unique_ptr<StreamSocket>* socket,
+             CompletionOnceCallback callback,
+             IPEndPoint* peer_address) override;
+
+  // base::MessagePumpForIO::FdWatcher implementation.
+  void OnFileCanReadWithoutBlocking(int fd) override;
+  void OnFileCanWriteWithoutBlocking(int fd) override;
+
+ private:
+  friend class NaiveTunDnsSocket;
+  friend class NaiveTunTcpConnection;
+
+  using FlowKey = std::pair<IPEndPoint, IPEndPoint>;
+
+  // Larger than any packet of the device MTU.
+  static constexpr size_t kPacketBufferSize = 64 * 1024;
+  // Packets handled in one task before yielding to the tunnels.
+  static constexpr int kMaxPacketsPerRead = 64;
+  // Connections in their handshake or waiting for Accept(). SYNs beyond
+  // these are answered with RST.
+  static constexpr size_t kMaxPendingConnections = 128;
+
+  bool StartWatching();
+  void HandlePacket(const uint8_t* packet, size_t size);
+  void HandleTcp(const IPAddress& source,
+                 const IPAddress& destination,
+                 const uint8_t* data,
+                 size_t size);
+  void HandleUdp(const IPAddress& source,
+                 const IPAddress& destination,
+                 const uint8_t* data,
+                 size_t size);
+
+  // Sends a TCP segment from `local` to `peer`.
+  void SendTcp(const IPEndPoint& local,
+               const IPEndPoint& peer,
+               uint32_t seq,
+               uint32_t ack,
+               uint8_t flags,
+               uint16_t window,
+               base::span<const uint8_t> options,
+               const char* payload,
+               size_t payload_size);
+  void SendUdp(const IPEndPoint& source,
+               const IPEndPoint& destination,
+               const char* payload,
+               size_t payload_size);
+  // Returns where the transport header and payload of a packet to
+  // `destination` go, with `size` bytes of room.
+  uint8_t* BeginPacket(const IPEndPoint& destination, size_t size);
+  // Adds the IP header, fills in the checksum at `checksum_offset` of the
+  // transport header and writes the packet to the device. Packets the device
+  // has no room for are dropped, to be sent again by TCP.
+  void FinishPacket(const IPEndPoint& source,
+                    const IPEndPoint& destination,
+                    uint8_t protocol,
+                    size_t size,
+                    size_t checksum_offset);
+
+  // Called by connections as they go.
+  void ScheduleAck(NaiveTunTcpConnection* connection);
+  void OnEstablished(NaiveTunTcpConnection* connection);
+  void RemoveConnection(NaiveTunTcpConnection* connection);
+  // Hands out an established connection to the pending Accept().
+  void CompleteAccept();
+  // Returns false if no connection is waiting.
+  bool TakeConnection(std::unique_ptr<StreamSocket>* socket,
+                      IPEndPoint* peer_address);
+
+  base::ScopedFD fd_;
+  base::MessagePumpForIO::FdWatchController controller_{FROM_HERE};
+  bool watching_ = false;
+  std::vector<uint8_t> packet_buffer_;
+  // Reused for each packet written.
+  std::vector<uint8_t> send_packet_;
+
+  // Every connection, by peer and local address.
+  std::map<FlowKey, std::unique_ptr<NaiveTunTcpConnection>> connections_;
+  // Connections established but not handed out yet, in order.
+  std::queue<base::WeakPtr<NaiveTunTcpConnection>> established_;
+  // Connections in their handshake or in established_.
+  size_t pending_connections_ = 0;
+  // Connections with an ACK held back during the current read.
+  std::vector<base::WeakPtr<NaiveTunTcpConnection>> ack_pending_;
+  raw_ptr<NaiveTunDnsSocket> dns_socket_ = nullptr;
+
+  raw_ptr<std::unique_ptr<StreamSocket>> accept_socket_ = nullptr;
+  raw_ptr<IPEndPoint> accept_peer_address_ = nullptr;
+  CompletionOnceCallback accept_callback_;
+
+  base::WeakPtrFactory<NaiveTunServerSocket> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_TUN_STACK_H_
@@ -0,0 +1,249 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_tunnel_connector.h"
+
+#include <string>
+#include <utility>
+
+#include "base/check.h"
+#include "base/functional/bind.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/notreached.h"
+#include "net/base/load_flags.h"
+#include "net/base/net_errors.h"
+#include "net/base/privacy_mode.h"
+#include "net/base/proxy_server.h"
+#include "net/base/session_usage.h"
+#include "net/http/http_auth.h"
+#include "net/http/http_auth_controller.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_proxy_client_socket.h"
+#include "net/http/http_proxy_connect_job.h"
+#include "net/http/http_user_agent_settings.h"
+#include "net/log/net_log_with_source.h"
+#include "net/proxy_resolution/proxy_info.h"
+#include "net/socket/client_socket_handle.h"
+#include "net/socket/client_socket_pool_manager.h"
+#include "net/socket/socket_tag.h"
+#include "net/socket/stream_socket.h"
+#include "net/spdy/spdy_proxy_client_socket.h"
+#include "net/spdy/spdy_session.h"
+#include "net/spdy/spdy_session_key.h"
+#include "net/spdy/spdy_session_pool.h"
+#include "net/tools/naive/naive_spare_pool.h"
+#include "net/tools/naive/naive_standby_pool.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "url/gurl.h"
+
+namespace net {
+
+NaiveTunnelConnector::NaiveTunnelConnector(
+    HttpNetworkSession* session,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : session_(session), traffic_annotation_(traffic_annotation) {
+  DCHECK(session_);
+  io_callback_ = base::BindRepeating(&NaiveTunnelConnector::OnIOComplete,
+                                     weak_ptr_factory_.GetWeakPtr());
+}
+
+NaiveTunnelConnector::~NaiveTunnelConnector() = default;
+
+int NaiveTunnelConnector::Connect(
+    url::SchemeHostPort endpoint,
+    const ProxyInfo& proxy_info,
+    const NetworkAnonymizationKey& network_anonymization_key,
+    SecureDnsPolicy secure_dns_policy,
+    const NetLogWithSource& net_log,
+    ClientSocketHandle* handle,
+    CompletionOnceCallback callback) {
+  DCHECK_EQ(next_state_, STATE_NONE);
+  DCHECK(!callback_);
+
+  endpoint_ = HostPortPair::FromSchemeHostPort(endpoint);
+  scheme_host_port_ = std::move(endpoint);
+  proxy_info_ = proxy_info;
+  proxy_chain_ = proxy_info.proxy_chain();
+  network_anonymization_key_ = network_anonymization_key;
+  secure_dns_policy_ = secure_dns_policy;
+  net_log_ = &net_log;
+  handle_ = handle;
+
+  if (proxy_info.is_direct()) {
+    std::unique_ptr<StreamSocket> spare_socket = TakeSpareSocket();
+    if (spare_socket) {
+      handle_->SetSocket(std::move(spare_socket));
+      return OK;
+    }
+  }
+
+  base::WeakPtr<SpdySession> spdy_session = FindSpdySession(
+      proxy_info, network_anonymization_key, secure_dns_policy, net_log);
+  std::unique_ptr<StreamSocket> standby_socket;
+  if (!spdy_session)
+    standby_socket = TakeStandbySocket();
+
+  int rv;
+  if (spdy_session) {
+    next_state_ = STATE_REQUEST_STREAM_COMPLETE;
+    stream_request_ = std::make_unique<SpdyStreamRequest>();
+    // Opened as HttpProxyConnectJob opens tunnel streams.
+    rv = stream_request_->StartRequest(
+        SPDY_BIDIRECTIONAL_STREAM, spdy_session,
+        GURL("https://" + endpoint_.ToString()), /*can_send_early=*/false,
+        HttpProxyConnectJob::kH2QuicTunnelPriority, SocketTag(),
+        spdy_session->net_log(), io_callback_, traffic_annotation_);
+  } else if (standby_socket) {
+    next_state_ = STATE_STANDBY_CONNECT_COMPLETE;
+    // Sent as HttpProxyConnectJob sends it on its nested socket.
+    socket_ = std::make_unique<HttpProxyClientSocket>(
+        std::move(standby_socket), GetUserAgent(), endpoint_, proxy_chain_,
+        /*proxy_chain_index=*/0, CreateAuthController(),
+        session_->context().proxy_delegate, traffic_annotation_);
+    rv = socket_->Connect(io_callback_);
+  } else {
+    return ConnectThroughPool(std::move(callback));
+  }
+  rv = DoLoop(rv);
+  if (rv == ERR_IO_PENDING)
+    callback_ = std::move(callback);
+  return rv;
+}
+
+base::WeakPtr<SpdySession> NaiveTunnelConnector::FindSpdySession(
+    const ProxyInfo& proxy_info,
+    const NetworkAnonymizationKey& network_anonymization_key,
+    SecureDnsPolicy secure_dns_policy,
+    const NetLogWithSource& net_log) {
+  const ProxyChain& proxy_chain = proxy_info.proxy_chain();
+  if (proxy_chain.length() != 1 || !proxy_chain.Last().is_https())
+    return nullptr;
+  // The key of HttpProxyConnectJob for the first proxy of a chain.
+  SpdySessionKey key(proxy_chain.Last().host_port_pair(),
+                     PRIVACY_MODE_DISABLED, ProxyChain::Direct(),
+                     SessionUsage::kProxy, SocketTag(),
+                     network_anonymization_key, secure_dns_policy,
+                     /*disable_cert_verification_network_fetches=*/true);
+  return session_->spdy_session_pool()->FindAvailableSession(
+      key, /*enable_ip_based_pooling=*/false, /*is_websocket=*/false,
+      net_log);
+}
+
+std::unique_ptr<StreamSocket> NaiveTunnelConnector::TakeStandbySocket() {
+  NaiveStandbyPool* standby_pool = NaiveStandbyPool::GetForCurrentThread();
+  if (!standby_pool)
+    return nullptr;
+  return standby_pool->Take(proxy_chain_);
+}
+
+std::unique_ptr<StreamSocket> NaiveTunnelConnector::TakeSpareSocket() {
+  NaiveSparePool* spare_pool = NaiveSparePool::GetForCurrentThread();
+  if (!spare_pool)
+    return nullptr;
+  return spare_pool->Take(scheme_host_port_);
+}
+
+scoped_refptr<HttpAuthController> NaiveTunnelConnector::CreateAuthController()
+    const {
+  const ProxyServer& proxy_server = proxy_chain_.Last();
+  return base::MakeRefCounted<HttpAuthController>(
+      HttpAuth::AUTH_PROXY,
+      GURL((proxy_server.is_http() ? "http://" : "https://") +
+           proxy_server.host_port_pair().ToString()),
+      network_anonymization_key_, session_->http_auth_cache(),
+      session_->http_auth_handler_factory(), session_->host_resolver());
+}
+
+std::string NaiveTunnelConnector::GetUserAgent() const {
+  const HttpUserAgentSettings* user_agent_settings =
+      session_->context().http_user_agent_settings;
+  return user_agent_settings ? user_agent_settings->GetUserAgent()
+                             : std::string();
+}
+
+int NaiveTunnelConnector::ConnectThroughPool(CompletionOnceCallback callback) {
+  return InitSocketHandleForHttpRequest(
+      std::move(scheme_host_port_), LOAD_IGNORE_LIMITS, MAXIMUM_PRIORITY,
+      session_, proxy_info_, {}, PRIVACY_MODE_DISABLED,
+      network_anonymization_key_, secure_dns_policy_, SocketTag(), *net_log_,
+      handle_, std::move(callback), ClientSocketPool::ProxyAuthCallback());
+}
+
+void NaiveTunnelConnector::OnIOComplete(int result) {
+  int rv = DoLoop(result);
+  if (rv != ERR_IO_PENDING)
+    std::move(callback_).Run(rv);
+}
+
+int NaiveTunnelConnector::DoLoop(int last_io_result) {
+  int rv = last_io_result;
+  do {
+    State state = next_state_;
+    next_state_ = STATE_NONE;
+    switch (state) {
+      case STATE_REQUEST_STREAM_COMPLETE:
+        rv = DoRequestStreamComplete(rv);
+        break;
+      case STATE_CONNECT_COMPLETE:
+        rv = DoConnectComplete(rv);
+        break;
+      case STATE_STANDBY_CONNECT_COMPLETE:
+        rv = DoStandbyConnectComplete(rv);
+        break;
+      case STATE_POOL_CONNECT_COMPLETE:
+        rv = DoPoolConnectComplete(rv);
+        break;
+      default:
+        NOTREACHED() << "bad state";
+    }
+  } while (rv != ERR_IO_PENDING && next_state_ != STATE_NONE);
+  return rv;
+}
+
+int NaiveTunnelConnector::DoRequestStreamComplete(int result) {
+  if (result < 0) {
+    stream_request_ = nullptr;
+    return result;
+  }
+
+  base::WeakPtr<SpdyStream> stream = stream_request_->ReleaseStream();
+  stream_request_ = nullptr;
+  DCHECK(stream);
+
+  // The socket sets itself as the delegate of `stream`.
+  socket_ = std::make_unique<SpdyProxyClientSocket>(
+      stream, proxy_chain_, /*proxy_chain_index=*/0, GetUserAgent(),
+      endpoint_, *net_log_, CreateAuthController(),
+      session_->context().proxy_delegate);
+
+  next_state_ = STATE_CONNECT_COMPLETE;
+  return socket_->Connect(io_callback_);
+}
+
+int NaiveTunnelConnector::DoConnectComplete(int result) {
+  if (result < 0) {
+    socket_ = nullptr;
+    return result;
+  }
+
+  handle_->SetSocket(std::move(socket_));
+  return OK;
+}
+
+int NaiveTunnelConnector::DoStandbyConnectComplete(int result) {
+  // The proxy may have closed the connection just before it was taken, so
+  // that is retried on a new one.
+  if (result == ERR_CONNECTION_CLOSED || result == ERR_CONNECTION_RESET ||
+      result == ERR_EMPTY_RESPONSE) {
+    socket_ = nullptr;
+    next_state_ = STATE_POOL_CONNECT_COMPLETE;
+    return ConnectThroughPool(io_callback_);
+  }
+  return DoConnectComplete(result);
+}
+
+int NaiveTunnelConnector::DoPoolConnectComplete(int result) {
+  return result;
+}
+
+}  // namespace net
@@ -0,0 +1,115 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_TUNNEL_CONNECTOR_H_
+#define NET_TOOLS_NAIVE_NAIVE_TUNNEL_CONNECTOR_H_
+
+#include <memory>
+#include <string>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "net/base/completion_once_callback.h"
+#include "net/base/completion_repeating_callback.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/network_anonymization_key.h"
+#include "net/base/proxy_chain.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/proxy_resolution/proxy_info.h"
+#include "url/scheme_host_port.h"
+
+namespace net {
+
+class ClientSocketHandle;
+class HttpNetworkSession;
+class HttpAuthController;
+class NetLogWithSource;
+class ProxyClientSocket;
+class StreamSocket;
+class SpdySession;
+class SpdyStreamRequest;
+struct NetworkTrafficAnnotationTag;
+
+// Connects the server side of tunnels. Once the HTTP/2 session to a
+// single HTTPS proxy is up, opens each tunnel as a CONNECT stream of it
+// directly, without a socket pool group and a proxy connect job per tunnel.
+// Through a single HTTP/1.1 proxy, sends the CONNECT of a tunnel on a
+// connection of the NaiveStandbyPool of the thread if there is one ready.
+// Direct tunnels take a spare connection of the NaiveSparePool of the
+// thread if there is one ready. Other tunnels go through
+// InitSocketHandleForHttpRequest(), which also sets up the session.
+class NaiveTunnelConnector {
+ public:
+  NaiveTunnelConnector(HttpNetworkSession* session,
+                       const NetworkTrafficAnnotationTag& traffic_annotation);
+  ~NaiveTunnelConnector();
+  NaiveTunnelConnector(const NaiveTunnelConnector&) = delete;
+  NaiveTunnelConnector& operator=(const NaiveTunnelConnector&) = delete;
+
+  // Connects `handle` with a tunnel to `endpoint`, ignoring the socket pool
+  // limits. Runs `callback` if it returns ERR_IO_PENDING. Must be called
+  // once.
+  int Connect(url::SchemeHostPort endpoint,
+              const ProxyInfo& proxy_info,
+              const NetworkAnonymizationKey& network_anonymization_key,
+              SecureDnsPolicy secure_dns_policy,
+              const NetLogWithSource& net_log,
+              ClientSocketHandle* handle,
+              CompletionOnceCallback callback);
+
+ private:
+  enum State {
+    STATE_REQUEST_STREAM_COMPLETE,
+    STATE_CONNECT_COMPLETE,
+    STATE_STANDBY_CONNECT_COMPLETE,
+    STATE_POOL_CONNECT_COMPLETE,
+    STATE_NONE,
+  };
+
+  // Returns the established session carrying tunnels through `proxy_info`,
+  // or null.
+  base::WeakPtr<SpdySession> FindSpdySession(
+      const ProxyInfo& proxy_info,
+      const NetworkAnonymizationKey& network_anonymization_key,
+      SecureDnsPolicy secure_dns_policy,
+      const NetLogWithSource& net_log);
+
+  std::unique_ptr<StreamSocket> TakeStandbySocket();
+  std::unique_ptr<StreamSocket> TakeSpareSocket();
+
+  // Checks the auth cache for the credentials of the proxy.
+  scoped_refptr<HttpAuthController> CreateAuthController() const;
+  std::string GetUserAgent() const;
+
+  int ConnectThroughPool(CompletionOnceCallback callback);
+
+  void OnIOComplete(int result);
+  int DoLoop(int last_io_result);
+  int DoRequestStreamComplete(int result);
+  int DoConnectComplete(int result);
+  int DoStandbyConnectComplete(int result);
+  int DoPoolConnectComplete(int result);
+
+  HttpNetworkSession* const session_;
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+
+  State next_state_ = STATE_NONE;
+  url::SchemeHostPort scheme_host_port_;
+  HostPortPair endpoint_;
+  ProxyInfo proxy_info_;
+  ProxyChain proxy_chain_;
+  NetworkAnonymizationKey network_anonymization_key_;
+  SecureDnsPolicy secure_dns_policy_ = SecureDnsPolicy::kAllow;
+  const NetLogWithSource* net_log_ = nullptr;
+  ClientSocketHandle* handle_ = nullptr;
+  CompletionOnceCallback callback_;
+  CompletionRepeatingCallback io_callback_;
+
+  std::unique_ptr<SpdyStreamRequest> stream_request_;
+  std::unique_ptr<ProxyClientSocket> socket_;
+
+  base::WeakPtrFactory<NaiveTunnelConnector> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_TUNNEL_CONNECTOR_H_
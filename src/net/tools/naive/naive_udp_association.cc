@@ -0,0 +1,569 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifdef UNSAFE_BUFFERS_BUILD
+// TODO(crbug.com/40284755): Remove this and spanify to fix the errors.
+#pragma allow_unsafe_buffers
+#endif
+
+#include "net/tools/naive/naive_udp_association.h"
+
+#include <cstring>
+#include <utility>
+
+#include "base/base64.h"
+#include "base/containers/span.h"
+#include "base/functional/bind.h"
+#include "base/functional/callback_helpers.h"
+#include "base/logging.h"
+#include "base/strings/escape.h"
+#include "base/strings/strcat.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/sys_byteorder.h"
+#include "base/task/sequenced_task_runner.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/privacy_mode.h"
+#include "net/base/request_priority.h"
+#include "net/base/session_usage.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/http/http_auth.h"
+#include "net/http/http_auth_cache.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_proxy_connect_job.h"
+#include "net/quic/quic_context.h"
+#include "net/quic/quic_proxy_datagram_client_socket.h"
+#include "net/quic/quic_session_pool.h"
+#include "net/socket/datagram_server_socket.h"
+#include "net/socket/socket_tag.h"
+#include "net/spdy/spdy_session.h"
+#include "net/spdy/spdy_session_key.h"
+#include "net/spdy/spdy_session_pool.h"
+#include "net/tools/naive/naive_h2_datagram_socket.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "url/gurl.h"
+#include "url/scheme_host_port.h"
+#include "url/url_constants.h"
+
+namespace net {
+
+namespace {
+// RSV, FRAG and ATYP of the SOCKS5 UDP request header.
+constexpr int kUdpHeaderSize = 4;
+// Address length byte, domain, and port.
+constexpr int kMaxUdpHeaderSize = kUdpHeaderSize + 1 + 255 + 2;
+
+constexpr char kEndPointDomain = 0x03;
+constexpr char kEndPointResolvedIPv4 = 0x01;
+constexpr char kEndPointResolvedIPv6 = 0x04;
+
+IPAddress ToComparableAddress(const IPAddress& address) {
+  if (address.IsIPv4MappedIPv6())
+    return ConvertIPv4MappedIPv6ToIPv4(address);
+  return address;
+}
+}  // namespace
+
+NaiveUdpAssociation::Flow::Flow(NaiveUdpAssociation* association,
+                                const HostPortPair& destination)
+    : association_(association),
+      destination_(destination),
+      socks_header_(MakeSocksHeader(destination)),
+      state_(STATE_REQUEST_SESSION),
+      last_activity_time_(base::TimeTicks::Now()) {
+  io_callback_ = base::BindRepeating(&Flow::OnIOComplete,
+                                     weak_ptr_factory_.GetWeakPtr());
+}
+
+NaiveUdpAssociation::Flow::~Flow() = default;
+
+void NaiveUdpAssociation::Flow::Connect() {
+  int rv = DoLoop(OK);
+  if (rv == ERR_IO_PENDING)
+    return;
+  if (rv < 0) {
+    Close(rv);
+    return;
+  }
+  OnOpen();
+}
+
+void NaiveUdpAssociation::Flow::Write(std::string_view payload) {
+  if (state_ == STATE_CLOSED)
+    return;
+  last_activity_time_ = base::TimeTicks::Now();
+  if (state_ != STATE_OPEN) {
+    if (pending_datagrams_.size() < kMaxPendingDatagrams)
+      pending_datagrams_.emplace(payload);
+    return;
+  }
+
+  if (h2_socket_) {
+    int rv = h2_socket_->Write(payload);
+    if (rv < 0)
+      Close(rv);
+    return;
+  }
+  auto buf = base::MakeRefCounted<WrappedIOBuffer>(base::span(payload));
+  // Datagrams are sent synchronously.
+  int rv = socket_->Write(buf.get(), payload.size(), base::DoNothing(),
+                          association_->traffic_annotation_);
+  // Oversized datagrams are dropped alone.
+  if (rv < 0 && rv != ERR_MSG_TOO_BIG)
+    Close(rv);
+}
+
+void NaiveUdpAssociation::Flow::OnIOComplete(int result) {
+  int rv = DoLoop(result);
+  if (rv == ERR_IO_PENDING)
+    return;
+  if (rv < 0) {
+    Close(rv);
+    return;
+  }
+  OnOpen();
+}
+
+int NaiveUdpAssociation::Flow::DoLoop(int last_io_result) {
+  int rv = last_io_result;
+  do {
+    switch (state_) {
+      case STATE_REQUEST_SESSION:
+        DCHECK_EQ(rv, OK);
+        rv = DoRequestSession();
+        break;
+      case STATE_REQUEST_SESSION_COMPLETE:
+        rv = DoRequestSessionComplete(rv);
+        break;
+      case STATE_REQUEST_STREAM_COMPLETE:
+        rv = DoRequestStreamComplete(rv);
+        break;
+      case STATE_CONNECT_COMPLETE:
+        rv = DoConnectComplete(rv);
+        break;
+      default:
+        NOTREACHED() << "bad state";
+        rv = ERR_UNEXPECTED;
+        break;
+    }
+  } while (rv == OK && state_ != STATE_OPEN);
+  return rv;
+}
+
+int NaiveUdpAssociation::Flow::DoRequestSession() {
+  state_ = STATE_REQUEST_SESSION_COMPLETE;
+
+  // Shares the session to the proxy with the TCP tunnels.
+  const HostPortPair& proxy =
+      association_->proxy_chain_.Last().host_port_pair();
+  if (association_->proxy_chain_.Last().is_https()) {
+    // The key of HttpProxyConnectJob for the first proxy of a chain.
+    SpdySessionKey key(proxy, PRIVACY_MODE_DISABLED, ProxyChain::Direct(),
+                       SessionUsage::kProxy, SocketTag(),
+                       association_->network_anonymization_key_,
+                       SecureDnsPolicy::kDisable,
+                       /*disable_cert_verification_network_fetches=*/true);
+    base::WeakPtr<SpdySession> spdy_session =
+        association_->session_->spdy_session_pool()->FindAvailableSession(
+            key, /*enable_ip_based_pooling=*/false, /*is_websocket=*/false,
+            association_->net_log_);
+    // The flow fails until the tunnels bring up the session, and the next
+    // datagram to the destination tries again. Extended CONNECT needs the
+    // proxy to enable it in its settings.
+    if (!spdy_session)
+      return ERR_PROXY_CONNECTION_FAILED;
+    if (!spdy_session->support_websocket())
+      return ERR_NOT_IMPLEMENTED;
+
+    state_ = STATE_REQUEST_STREAM_COMPLETE;
+    stream_request_ = std::make_unique<SpdyStreamRequest>();
+    return stream_request_->StartRequest(
+        SPDY_BIDIRECTIONAL_STREAM, spdy_session, GetUrl(),
+        /*can_send_early=*/false, HttpProxyConnectJob::kH2QuicTunnelPriority,
+        SocketTag(), spdy_session->net_log(), io_callback_,
+        association_->traffic_annotation_);
+  }
+  session_request_ = std::make_unique<QuicSessionRequest>(
+      association_->session_->quic_session_pool());
+  return session_request_->Request(
+      url::SchemeHostPort(url::kHttpsScheme, proxy.host(), proxy.port()),
+      SupportedQuicVersionForProxying(), ProxyChain::Direct(),
+      association_->traffic_annotation_,
+      /*http_user_agent_settings=*/nullptr, SessionUsage::kProxy,
+      PRIVACY_MODE_DISABLED, MAXIMUM_PRIORITY, SocketTag(),
+      association_->network_anonymization_key_, SecureDnsPolicy::kDisable,
+      /*require_dns_https_alpn=*/false, /*cert_verify_flags=*/0,
+      GURL("https://" + proxy.ToString()), association_->net_log_,
+      &net_error_details_,
+      /*failed_on_default_network_callback=*/CompletionOnceCallback(),
+      io_callback_);
+}
+
+int NaiveUdpAssociation::Flow::DoRequestSessionComplete(int result) {
+  if (result < 0) {
+    session_request_ = nullptr;
+    return result;
+  }
+
+  state_ = STATE_REQUEST_STREAM_COMPLETE;
+  session_handle_ = session_request_->ReleaseSessionHandle();
+  session_request_ = nullptr;
+  return session_handle_->RequestStream(/*requires_confirmation=*/false,
+                                        io_callback_,
+                                        association_->traffic_annotation_);
+}
+
+int NaiveUdpAssociation::Flow::DoRequestStreamComplete(int result) {
+  if (stream_request_) {
+    if (result < 0) {
+      stream_request_ = nullptr;
+      return result;
+    }
+    base::WeakPtr<SpdyStream> spdy_stream = stream_request_->ReleaseStream();
+    stream_request_ = nullptr;
+    h2_socket_ = std::make_unique<NaiveH2DatagramSocket>(
+        spdy_stream, GetUrl(), association_->net_log_);
+    state_ = STATE_CONNECT_COMPLETE;
+    return h2_socket_->Connect(association_->request_headers_, io_callback_);
+  }
+
+  if (result < 0)
+    return result;
+
+  std::unique_ptr<QuicChromiumClientStream::Handle> stream =
+      session_handle_->ReleaseStream();
+  if (!stream->IsOpen())
+    return ERR_CONNECTION_CLOSED;
+
+  IPEndPoint local_address;
+  int rv = session_handle_->GetSelfAddress(&local_address);
+  if (rv != OK)
+    return rv;
+  IPEndPoint peer_address;
+  rv = session_handle_->GetPeerAddress(&peer_address);
+  if (rv != OK)
+    return rv;
+
+  // The proxy delegate would negotiate padding, which datagrams do not use.
+  socket_ = std::make_unique<QuicProxyDatagramClientSocket>(
+      GetUrl(), association_->proxy_chain_, /*user_agent=*/std::string(),
+      association_->net_log_, /*proxy_delegate=*/nullptr);
+  socket_->SetExtraRequestHeaders(association_->request_headers_);
+
+  state_ = STATE_CONNECT_COMPLETE;
+  return socket_->ConnectViaStream(local_address, peer_address,
+                                   std::move(stream), io_callback_);
+}
+
+int NaiveUdpAssociation::Flow::DoConnectComplete(int result) {
+  if (result < 0)
+    return result;
+
+  state_ = STATE_OPEN;
+  return OK;
+}
+
+GURL NaiveUdpAssociation::Flow::GetUrl() const {
+  // Uses the default URI template of RFC 9298.
+  const HostPortPair& proxy =
+      association_->proxy_chain_.Last().host_port_pair();
+  return GURL(base::StringPrintf(
+      "https://%s/.well-known/masque/udp/%s/%d/", proxy.ToString().c_str(),
+      base::EscapeQueryParamValue(destination_.host(), /*use_plus=*/false)
+          .c_str(),
+      destination_.port()));
+}
+
+void NaiveUdpAssociation::Flow::OnOpen() {
+  DCHECK_EQ(state_, STATE_OPEN);
+  while (!pending_datagrams_.empty() && state_ == STATE_OPEN) {
+    std::string datagram = std::move(pending_datagrams_.front());
+    pending_datagrams_.pop();
+    Write(datagram);
+  }
+  if (state_ == STATE_OPEN)
+    DoRead();
+}
+
+void NaiveUdpAssociation::Flow::DoRead() {
+  if (!read_buffer_) {
+    read_buffer_ = base::MakeRefCounted<IOBufferWithSize>(kMaxDatagramSize);
+  }
+  for (;;) {
+    auto callback =
+        base::BindOnce(&Flow::OnRead, weak_ptr_factory_.GetWeakPtr());
+    int rv = h2_socket_
+                 ? h2_socket_->Read(read_buffer_.get(), kMaxDatagramSize,
+                                    std::move(callback))
+                 : socket_->Read(read_buffer_.get(), kMaxDatagramSize,
+                                 std::move(callback));
+    if (rv == ERR_IO_PENDING)
+      return;
+    if (rv == ERR_MSG_TOO_BIG)
+      continue;
+    if (rv <= 0) {
+      Close(rv ? rv : ERR_CONNECTION_CLOSED);
+      return;
+    }
+    last_activity_time_ = base::TimeTicks::Now();
+    association_->SendToClient(socks_header_,
+                               std::string_view(read_buffer_->data(), rv));
+  }
+}
+
+void NaiveUdpAssociation::Flow::OnRead(int result) {
+  if (state_ == STATE_CLOSED)
+    return;
+  if (result <= 0 && result != ERR_MSG_TOO_BIG) {
+    Close(result ? result : ERR_CONNECTION_CLOSED);
+    return;
+  }
+  if (result > 0) {
+    last_activity_time_ = base::TimeTicks::Now();
+    association_->SendToClient(socks_header_,
+                               std::string_view(read_buffer_->data(), result));
+  }
+  DoRead();
+}
+
+void NaiveUdpAssociation::Flow::Close(int error) {
+  DCHECK_NE(state_, STATE_CLOSED);
+  state_ = STATE_CLOSED;
+  pending_datagrams_ = {};
+  LOG(INFO) << "Connection " << association_->connection_id_ << " UDP to "
+            << destination_.ToString() << " closed: "
+            << ErrorToShortString(error);
+  association_->OnFlowClosed(destination_);
+}
+
+NaiveUdpAssociation::NaiveUdpAssociation(
+    uint64_t connection_id,
+    std::unique_ptr<DatagramServerSocket> socket,
+    const IPAddress& client_address,
+    const ProxyChain& proxy_chain,
+    HttpNetworkSession* session,
+    const NetworkAnonymizationKey& network_anonymization_key,
+    const NetLogWithSource& net_log,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : connection_id_(connection_id),
+      socket_(std::move(socket)),
+      client_address_(ToComparableAddress(client_address)),
+      proxy_chain_(proxy_chain),
+      session_(session),
+      network_anonymization_key_(network_anonymization_key),
+      net_log_(net_log),
+      send_pending_(false),
+      last_activity_time_(base::TimeTicks::Now()),
+      traffic_annotation_(traffic_annotation) {
+  DCHECK(IsSupported(proxy_chain_));
+
+  // The datagram socket does not answer auth challenges, so sends the
+  // configured credentials preemptively as the TCP tunnels do.
+  const HostPortPair& proxy = proxy_chain_.Last().host_port_pair();
+  HttpAuthCache::Entry* entry = session_->http_auth_cache()->Lookup(
+      url::SchemeHostPort(url::kHttpsScheme, proxy.host(), proxy.port()),
+      HttpAuth::AUTH_PROXY, /*realm=*/std::string(),
+      HttpAuth::AUTH_SCHEME_BASIC, NetworkAnonymizationKey());
+  if (entry) {
+    const AuthCredentials& credentials = entry->credentials();
+    std::string user_pass =
+        base::StrCat({base::UTF16ToUTF8(credentials.username()), ":",
+                      base::UTF16ToUTF8(credentials.password())});
+    request_headers_.SetHeader(HttpRequestHeaders::kProxyAuthorization,
+                               "Basic " + base::Base64Encode(user_pass));
+  }
+}
+
+NaiveUdpAssociation::~NaiveUdpAssociation() = default;
+
+// static
+bool NaiveUdpAssociation::IsSupported(const ProxyChain& proxy_chain) {
+  return proxy_chain.is_single_proxy() &&
+         (proxy_chain.Last().is_quic() || proxy_chain.Last().is_https());
+}
+
+// static
+std::string NaiveUdpAssociation::MakeSocksHeader(
+    const HostPortPair& endpoint) {
+  std::string header(3, '\0');
+  IPAddress address;
+  if (address.AssignFromIPLiteral(endpoint.host())) {
+    header.push_back(address.IsIPv4() ? kEndPointResolvedIPv4
+                                      : kEndPointResolvedIPv6);
+    header.append(address.bytes().begin(), address.bytes().end());
+  } else {
+    header.push_back(kEndPointDomain);
+    header.push_back(static_cast<char>(endpoint.host().size()));
+    header.append(endpoint.host());
+  }
+  uint16_t port_net = base::HostToNet16(endpoint.port());
+  header.append(reinterpret_cast<const char*>(&port_net), sizeof(port_net));
+  return header;
+}
+
+// static
+size_t NaiveUdpAssociation::ParseSocksHeader(std::string_view datagram,
+                                             HostPortPair* endpoint) {
+  // Fragmented datagrams are not supported, which RFC 1928 allows.
+  const char* data = datagram.data();
+  int size = static_cast<int>(datagram.size());
+  if (size < kUdpHeaderSize || data[0] != 0 || data[1] != 0 || data[2] != 0)
+    return 0;
+  int offset = kUdpHeaderSize;
+  int address_size;
+  if (data[3] == kEndPointResolvedIPv4) {
+    address_size = IPAddress::kIPv4AddressSize;
+  } else if (data[3] == kEndPointResolvedIPv6) {
+    address_size = IPAddress::kIPv6AddressSize;
+  } else if (data[3] == kEndPointDomain && size > offset) {
+    address_size = static_cast<uint8_t>(data[offset]);
+    ++offset;
+    if (address_size == 0)
+      return 0;
+  } else {
+    return 0;
+  }
+  if (size < offset + address_size + static_cast<int>(sizeof(uint16_t)))
+    return 0;
+
+  uint16_t port_net;
+  std::memcpy(&port_net, data + offset + address_size, sizeof(port_net));
+  uint16_t port = base::NetToHost16(port_net);
+  if (data[3] == kEndPointDomain) {
+    *endpoint = HostPortPair(std::string(data + offset, address_size), port);
+  } else {
+    IPAddress address(base::span<const uint8_t>(
+        reinterpret_cast<const uint8_t*>(data + offset),
+        static_cast<size_t>(address_size)));
+    *endpoint = HostPortPair::FromIPEndPoint(IPEndPoint(address, port));
+  }
+  return offset + address_size + sizeof(uint16_t);
+}
+
+int NaiveUdpAssociation::Run(CompletionOnceCallback callback) {
+  DCHECK(!run_callback_);
+  run_callback_ = std::move(callback);
+  recv_buffer_ = base::MakeRefCounted<IOBufferWithSize>(kMaxDatagramSize);
+  send_buffer_ = base::MakeRefCounted<IOBufferWithSize>(kMaxUdpHeaderSize +
+                                                        kMaxDatagramSize);
+  DoRecv();
+  return ERR_IO_PENDING;
+}
+
+void NaiveUdpAssociation::DoRecv() {
+  for (;;) {
+    int rv = socket_->RecvFrom(recv_buffer_.get(), kMaxDatagramSize,
+                               &recv_address_,
+                               base::BindOnce(&NaiveUdpAssociation::OnRecv,
+                                              weak_ptr_factory_.GetWeakPtr()));
+    if (rv == ERR_IO_PENDING)
+      return;
+    if (rv < 0 && rv != ERR_MSG_TOO_BIG) {
+      std::move(run_callback_).Run(rv);
+      return;
+    }
+    if (rv > 0)
+      HandleDatagram(rv);
+  }
+}
+
+void NaiveUdpAssociation::OnRecv(int result) {
+  if (result < 0 && result != ERR_MSG_TOO_BIG) {
+    std::move(run_callback_).Run(result);
+    return;
+  }
+  if (result > 0)
+    HandleDatagram(result);
+  DoRecv();
+}
+
+void NaiveUdpAssociation::HandleDatagram(int size) {
+  if (ToComparableAddress(recv_address_.address()) != client_address_)
+    return;
+  if (client_endpoint_.address().empty()) {
+    client_endpoint_ = recv_address_;
+  } else if (recv_address_ != client_endpoint_) {
+    return;
+  }
+
+  std::string_view datagram(recv_buffer_->data(), size);
+  HostPortPair destination;
+  size_t offset = ParseSocksHeader(datagram, &destination);
+  if (offset == 0)
+    return;
+
+  last_activity_time_ = base::TimeTicks::Now();
+  GetOrCreateFlow(destination)->Write(datagram.substr(offset));
+}
+
+void NaiveUdpAssociation::SendToClient(std::string_view header,
+                                       std::string_view payload) {
+  // Drops the datagram while the previous one is still being sent.
+  if (send_pending_ || client_endpoint_.address().empty())
+    return;
+  if (payload.size() > static_cast<size_t>(kMaxDatagramSize))
+    return;
+
+  last_activity_time_ = base::TimeTicks::Now();
+  char* p = send_buffer_->data();
+  std::memcpy(p, header.data(), header.size());
+  std::memcpy(p + header.size(), payload.data(), payload.size());
+  int rv = socket_->SendTo(
+      send_buffer_.get(), header.size() + payload.size(), client_endpoint_,
+      base::BindOnce(&NaiveUdpAssociation::OnSend,
+                     weak_ptr_factory_.GetWeakPtr()));
+  if (rv == ERR_IO_PENDING) {
+    send_pending_ = true;
+    return;
+  }
+  OnSend(rv);
+}
+
+void NaiveUdpAssociation::OnSend(int result) {
+  send_pending_ = false;
+  if (result < 0) {
+    VLOG(1) << "Connection " << connection_id_
+            << " UDP send to client failed: " << ErrorToShortString(result);
+  }
+}
+
+NaiveUdpAssociation::Flow* NaiveUdpAssociation::GetOrCreateFlow(
+    const HostPortPair& destination) {
+  auto it = flows_.find(destination);
+  if (it != flows_.end())
+    return it->second.get();
+
+  if (flows_.size() >= kMaxFlows) {
+    auto oldest = flows_.begin();
+    for (auto i = flows_.begin(); i != flows_.end(); ++i) {
+      if (i->second->last_activity_time() <
+          oldest->second->last_activity_time()) {
+        oldest = i;
+      }
+    }
+    flows_.erase(oldest);
+  }
+
+  LOG(INFO) << "Connection " << connection_id_ << " UDP to "
+            << destination.ToString();
+  auto flow = std::make_unique<Flow>(this, destination);
+  Flow* flow_ptr = flow.get();
+  flows_.emplace(destination, std::move(flow));
+  flow_ptr->Connect();
+  return flow_ptr;
+}
+
+void NaiveUdpAssociation::OnFlowClosed(const HostPortPair& destination) {
+  base::SequencedTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&NaiveUdpAssociation::RemoveFlow,
+                                weak_ptr_factory_.GetWeakPtr(), destination));
+}
+
+void NaiveUdpAssociation::RemoveFlow(const HostPortPair& destination) {
+  auto it = flows_.find(destination);
+  if (it != flows_.end() && it->second->closed())
+    flows_.erase(it);
+}
+
+}  // namespace net
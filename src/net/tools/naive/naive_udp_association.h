@@ -0,0 +1,195 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_UDP_ASSOCIATION_H_
+#define NET_TOOLS_NAIVE_NAIVE_UDP_ASSOCIATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <string_view>
+
+#include "base/memory/raw_ptr.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "net/base/completion_once_callback.h"
+#include "net/base/completion_repeating_callback.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_error_details.h"
+#include "net/base/network_anonymization_key.h"
+#include "net/base/proxy_chain.h"
+#include "net/http/http_request_headers.h"
+#include "net/log/net_log_with_source.h"
+#include "net/quic/quic_chromium_client_session.h"
+#include "url/gurl.h"
+
+namespace net {
+
+class DatagramServerSocket;
+class HttpNetworkSession;
+class IOBufferWithSize;
+class NaiveH2DatagramSocket;
+class QuicProxyDatagramClientSocket;
+class QuicSessionRequest;
+class SpdyStreamRequest;
+struct NetworkTrafficAnnotationTag;
+
+// Relays the datagrams of one SOCKS5 UDP ASSOCIATE request. Each destination
+// of the client gets its own flow, a CONNECT-UDP stream (RFC 9298) on the
+// QUIC session to the proxy, so datagrams of different flows are not held
+// back by each other or by losses in TCP tunnels. Through an HTTPS proxy, as
+// when QUIC to the proxy is blocked, the stream is an extended CONNECT
+// stream on the HTTP/2 tunnel session instead, carrying the datagrams in
+// capsules. The session must be up and the proxy must allow extended
+// CONNECT.
+//
+// Datagrams are accepted only from the address of the SOCKS client. Datagrams
+// that cannot be relayed right away are dropped, as UDP allows.
+class NaiveUdpAssociation {
+ public:
+  // Most flows are DNS and QUIC, whose datagrams are well below this.
+  static constexpr int kMaxDatagramSize = 4 * 1024;
+  // The least recently active flow is closed to make room for new ones.
+  static constexpr size_t kMaxFlows = 64;
+  // Datagrams queued in a flow while its stream is being set up.
+  static constexpr size_t kMaxPendingDatagrams = 16;
+
+  NaiveUdpAssociation(uint64_t connection_id,
+                      std::unique_ptr<DatagramServerSocket> socket,
+                      const IPAddress& client_address,
+                      const ProxyChain& proxy_chain,
+                      HttpNetworkSession* session,
+                      const NetworkAnonymizationKey& network_anonymization_key,
+                      const NetLogWithSource& net_log,
+                      const NetworkTrafficAnnotationTag& traffic_annotation);
+  ~NaiveUdpAssociation();
+  NaiveUdpAssociation(const NaiveUdpAssociation&) = delete;
+  NaiveUdpAssociation& operator=(const NaiveUdpAssociation&) = delete;
+
+  // Returns true if datagrams can be relayed through `proxy_chain`.
+  static bool IsSupported(const ProxyChain& proxy_chain);
+
+  // Returns the SOCKS5 UDP request header of datagrams to or from
+  // `endpoint`.
+  static std::string MakeSocksHeader(const HostPortPair& endpoint);
+  // Parses the SOCKS5 UDP request header at the start of `datagram` into
+  // `endpoint`. Returns the size of the header, or 0 if it is invalid or of
+  // a fragment.
+  static size_t ParseSocksHeader(std::string_view datagram,
+                                 HostPortPair* endpoint);
+
+  // Starts relaying. Returns ERR_IO_PENDING and invokes `callback` with the
+  // error if the relay socket fails.
+  int Run(CompletionOnceCallback callback);
+
+  base::TimeTicks last_activity_time() const { return last_activity_time_; }
+
+ private:
+  // Connects one CONNECT-UDP stream and relays its datagrams.
+  class Flow {
+   public:
+    Flow(NaiveUdpAssociation* association, const HostPortPair& destination);
+    ~Flow();
+    Flow(const Flow&) = delete;
+    Flow& operator=(const Flow&) = delete;
+
+    void Connect();
+    // Sends the datagram, or queues it while connecting.
+    void Write(std::string_view payload);
+
+    bool closed() const { return state_ == STATE_CLOSED; }
+    base::TimeTicks last_activity_time() const { return last_activity_time_; }
+
+   private:
+    enum State {
+      STATE_REQUEST_SESSION,
+      STATE_REQUEST_SESSION_COMPLETE,
+      STATE_REQUEST_STREAM_COMPLETE,
+      STATE_CONNECT_COMPLETE,
+      STATE_OPEN,
+      STATE_CLOSED,
+    };
+
+    void OnIOComplete(int result);
+    int DoLoop(int last_io_result);
+    int DoRequestSession();
+    int DoRequestSessionComplete(int result);
+    int DoRequestStreamComplete(int result);
+    int DoConnectComplete(int result);
+    // Returns the URL of the CONNECT-UDP request.
+    GURL GetUrl() const;
+    void OnOpen();
+    void DoRead();
+    void OnRead(int result);
+    void Close(int error);
+
+    const raw_ptr<NaiveUdpAssociation> association_;
+    const HostPortPair destination_;
+    // SOCKS5 UDP request header of datagrams from `destination_`.
+    std::string socks_header_;
+    State state_;
+    CompletionRepeatingCallback io_callback_;
+
+    NetErrorDetails net_error_details_;
+    std::unique_ptr<QuicSessionRequest> session_request_;
+    std::unique_ptr<QuicChromiumClientSession::Handle> session_handle_;
+    std::unique_ptr<QuicProxyDatagramClientSocket> socket_;
+    // Through an HTTPS proxy.
+    std::unique_ptr<SpdyStreamRequest> stream_request_;
+    std::unique_ptr<NaiveH2DatagramSocket> h2_socket_;
+
+    std::queue<std::string> pending_datagrams_;
+    scoped_refptr<IOBufferWithSize> read_buffer_;
+
+    base::TimeTicks last_activity_time_;
+
+    base::WeakPtrFactory<Flow> weak_ptr_factory_{this};
+  };
+
+  void DoRecv();
+  void OnRecv(int result);
+  void HandleDatagram(int size);
+  void SendToClient(std::string_view header, std::string_view payload);
+  void OnSend(int result);
+  Flow* GetOrCreateFlow(const HostPortPair& destination);
+  // Closed flows are removed in a separate task, out of their callbacks.
+  void OnFlowClosed(const HostPortPair& destination);
+  void RemoveFlow(const HostPortPair& destination);
+
+  const uint64_t connection_id_;
+  std::unique_ptr<DatagramServerSocket> socket_;
+  const IPAddress client_address_;
+  // Set by the first datagram from `client_address_`.
+  IPEndPoint client_endpoint_;
+  const ProxyChain proxy_chain_;
+  const raw_ptr<HttpNetworkSession> session_;
+  const NetworkAnonymizationKey network_anonymization_key_;
+  const NetLogWithSource& net_log_;
+  // Sent with each CONNECT-UDP request.
+  HttpRequestHeaders request_headers_;
+
+  CompletionOnceCallback run_callback_;
+
+  scoped_refptr<IOBufferWithSize> recv_buffer_;
+  IPEndPoint recv_address_;
+  scoped_refptr<IOBufferWithSize> send_buffer_;
+  bool send_pending_;
+
+  std::map<HostPortPair, std::unique_ptr<Flow>> flows_;
+
+  base::TimeTicks last_activity_time_;
+
+  // Traffic annotation for socket control.
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+
+  base::WeakPtrFactory<NaiveUdpAssociation> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_UDP_ASSOCIATION_H_
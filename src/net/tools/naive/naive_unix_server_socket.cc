@@ -0,0 +1,101 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_unix_server_socket.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/functional/bind.h"
+#include "base/posix/eintr_wrapper.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/log/net_log_source.h"
+#include "net/socket/stream_socket.h"
+#include "net/socket/tcp_client_socket.h"
+#include "net/socket/tcp_socket.h"
+
+namespace net {
+
+namespace {
+// Access is left to the permissions of the socket file.
+bool AllowAnyPeer(const UnixDomainServerSocket::Credentials& credentials) {
+  return true;
+}
+}  // namespace
+
+NaiveUnixServerSocket::NaiveUnixServerSocket(NetLog* net_log)
+    : net_log_(net_log),
+      listen_socket_(base::BindRepeating(&AllowAnyPeer),
+                     /*use_abstract_namespace=*/false) {}
+
+NaiveUnixServerSocket::~NaiveUnixServerSocket() {
+  if (accepted_descriptor_ != kInvalidSocket) {
+    IGNORE_EINTR(close(accepted_descriptor_));
+  }
+}
+
+int NaiveUnixServerSocket::ListenWithPath(const std::string& path,
+                                          int backlog) {
+  // A socket file outlives its listener, and binding fails on it.
+  struct stat st;
+  if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+    unlink(path.c_str());
+  }
+  return listen_socket_.BindAndListen(path, backlog);
+}
+
+int NaiveUnixServerSocket::Listen(const IPEndPoint& address,
+                                  int backlog,
+                                  std::optional<bool> ipv6_only) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int NaiveUnixServerSocket::GetLocalAddress(IPEndPoint* address) const {
+  return ERR_ADDRESS_INVALID;
+}
+
+int NaiveUnixServerSocket::Accept(std::unique_ptr<StreamSocket>* socket,
+                                  CompletionOnceCallback callback) {
+  DCHECK(!accept_callback_);
+  accept_socket_ = socket;
+  // The listen socket is owned, so it does not run the callback after this
+  // is destroyed.
+  int result = listen_socket_.AcceptSocketDescriptor(
+      &accepted_descriptor_,
+      base::BindOnce(&NaiveUnixServerSocket::OnAcceptComplete,
+                     base::Unretained(this)));
+  if (result == ERR_IO_PENDING) {
+    accept_callback_ = std::move(callback);
+    return result;
+  }
+  return HandleAcceptResult(result);
+}
+
+void NaiveUnixServerSocket::OnAcceptComplete(int result) {
+  std::move(accept_callback_).Run(HandleAcceptResult(result));
+}
+
+int NaiveUnixServerSocket::HandleAcceptResult(int result) {
+  std::unique_ptr<StreamSocket>* socket = accept_socket_;
+  accept_socket_ = nullptr;
+  if (result != OK) {
+    return result;
+  }
+  auto tcp_socket =
+      std::make_unique<TCPSocket>(/*socket_performance_watcher=*/nullptr,
+                                  net_log_, NetLogSource());
+  result = tcp_socket->AdoptConnectedSocket(
+      std::exchange(accepted_descriptor_, kInvalidSocket), IPEndPoint());
+  if (result != OK) {
+    return result;
+  }
+  *socket =
+      std::make_unique<TCPClientSocket>(std::move(tcp_socket), IPEndPoint());
+  return OK;
+}
+
+}  // namespace net
@@ -0,0 +1,63 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_UNIX_SERVER_SOCKET_H_
+#define NET_TOOLS_NAIVE_NAIVE_UNIX_SERVER_SOCKET_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "base/memory/raw_ptr.h"
+#include "net/base/completion_once_callback.h"
+#include "net/socket/server_socket.h"
+#include "net/socket/socket_descriptor.h"
+#include "net/socket/unix_domain_server_socket_posix.h"
+
+namespace net {
+
+class IPEndPoint;
+class NetLog;
+class StreamSocket;
+
+// The listen socket of a socks+unix or http+unix listener, for clients on
+// the same host, which skip the TCP stack of loopback connections.
+//
+// Accepted connections are handed out as TCPClientSockets adopting their
+// descriptors, which work on any connected stream socket, so relaying,
+// splice(2) and the socket options of TCP listeners apply to them as they
+// are. They have no peer address.
+class NaiveUnixServerSocket : public ServerSocket {
+ public:
+  explicit NaiveUnixServerSocket(NetLog* net_log);
+  NaiveUnixServerSocket(const NaiveUnixServerSocket&) = delete;
+  NaiveUnixServerSocket& operator=(const NaiveUnixServerSocket&) = delete;
+  ~NaiveUnixServerSocket() override;
+
+  // Listens on the socket file `path`, replacing a socket file left there
+  // by an earlier instance.
+  int ListenWithPath(const std::string& path, int backlog);
+
+  // ServerSocket implementation.
+  int Listen(const IPEndPoint& address,
+             int backlog,
+             std::optional<bool> ipv6_only) override;
+  int GetLocalAddress(IPEndPoint* address) const override;
+  int Accept(std::unique_ptr<StreamSocket>* socket,
+             CompletionOnceCallback callback) override;
+
+ private:
+  void OnAcceptComplete(int result);
+  int HandleAcceptResult(int result);
+
+  NetLog* const net_log_;
+  UnixDomainServerSocket listen_socket_;
+
+  SocketDescriptor accepted_descriptor_ = kInvalidSocket;
+  raw_ptr<std::unique_ptr<StreamSocket>> accept_socket_ = nullptr;
+  CompletionOnceCallback accept_callback_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_UNIX_SERVER_SOCKET_H_
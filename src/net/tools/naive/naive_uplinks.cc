@@ -0,0 +1,215 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_uplinks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/functional/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/task/thread_pool.h"
+#include "build/build_config.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_interfaces.h"
+#include "net/base/sockaddr_storage.h"
+
+#if BUILDFLAG(IS_POSIX)
+#include <errno.h>
+#include <sys/socket.h>
+#endif
+
+namespace net {
+namespace {
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+std::optional<uint64_t> ReadCounter(const std::string& interface,
+                                    const char* name) {
+  std::string str;
+  uint64_t value;
+  if (!base::ReadFileToString(base::FilePath("/sys/class/net")
+                                  .Append(interface)
+                                  .Append("statistics")
+                                  .Append(name),
+                              &str) ||
+      !base::StringToUint64(base::TrimWhitespaceASCII(str, base::TRIM_ALL),
+                            &value)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+// The bytes received and sent on each of `interfaces`.
+std::vector<std::optional<uint64_t>> ReadInterfaceBytes(
+    const std::vector<std::string>& interfaces) {
+  std::vector<std::optional<uint64_t>> bytes;
+  for (const std::string& interface : interfaces) {
+    std::optional<uint64_t> rx = ReadCounter(interface, "rx_bytes");
+    std::optional<uint64_t> tx = ReadCounter(interface, "tx_bytes");
+    bytes.push_back(rx && tx ? std::optional<uint64_t>(*rx + *tx)
+                             : std::nullopt);
+  }
+  return bytes;
+}
+#endif
+
+}  // namespace
+
+// static
+scoped_refptr<NaiveUplinks> NaiveUplinks::Create(
+    const std::vector<std::string>& names) {
+#if BUILDFLAG(IS_POSIX)
+  NetworkInterfaceList networks;
+  if (!GetNetworkList(&networks, INCLUDE_HOST_SCOPE_VIRTUAL_INTERFACES)) {
+    LOG(ERROR) << "Failed to list the network interfaces for uplinks";
+    return nullptr;
+  }
+  std::vector<Uplink> uplinks;
+  for (const std::string& name : names) {
+    IPAddress address;
+    bool is_address = address.AssignFromIPLiteral(name);
+    auto it = std::ranges::find_if(networks, [&](const NetworkInterface& n) {
+      return is_address ? n.address == address : n.name == name;
+    });
+    if (it == networks.end()) {
+      LOG(ERROR) << "No network interface "
+                 << (is_address ? "has the address of uplink "
+                                : "for uplink ")
+                 << name;
+      return nullptr;
+    }
+    LOG(INFO) << "Uplink " << name << " on " << it->name;
+    uplinks.push_back({it->name, address});
+  }
+  return base::MakeRefCounted<NaiveUplinks>(std::move(uplinks));
+#else
+  LOG(ERROR) << "Uplinks are not supported on this platform";
+  return nullptr;
+#endif
+}
+
+NaiveUplinks::NaiveUplinks(std::vector<Uplink> uplinks)
+    : uplinks_(std::move(uplinks)),
+      weights_(uplinks_.size()),
+      current_weights_(uplinks_.size()),
+      last_bytes_(uplinks_.size()),
+      peaks_(uplinks_.size()) {
+  DCHECK(!uplinks_.empty());
+  for (std::atomic<int>& weight : weights_)
+    weight.store(kMaxWeight, std::memory_order_relaxed);
+}
+
+NaiveUplinks::~NaiveUplinks() = default;
+
+void NaiveUplinks::SetKeyUplink(const NetworkAnonymizationKey& key,
+                                std::optional<size_t> uplink) {
+  base::AutoLock lock(lock_);
+  if (uplink) {
+    DCHECK_LT(*uplink, uplinks_.size());
+    key_uplinks_[key] = *uplink;
+  } else {
+    key_uplinks_.erase(key);
+  }
+}
+
+size_t NaiveUplinks::GetUplinkForKey(const NetworkAnonymizationKey& key) {
+  base::AutoLock lock(lock_);
+  auto it = key_uplinks_.find(key);
+  if (it != key_uplinks_.end())
+    return it->second;
+
+  int total_weight = 0;
+  size_t best = 0;
+  for (size_t i = 0; i < uplinks_.size(); ++i) {
+    int weight = GetWeight(i);
+    current_weights_[i] += weight;
+    total_weight += weight;
+    if (current_weights_[i] > current_weights_[best])
+      best = i;
+  }
+  current_weights_[best] -= total_weight;
+  return best;
+}
+
+int NaiveUplinks::Bind(size_t uplink,
+                       SocketDescriptor fd,
+                       AddressFamily family) const {
+#if BUILDFLAG(IS_POSIX)
+  const Uplink& u = uplinks_[uplink];
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  // Routes the connection out of the interface whatever the routing table
+  // says, which a source address alone does not.
+  if (setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, u.interface.c_str(),
+                 u.interface.size()) != 0) {
+    int rv = MapSystemError(errno);
+    LOG(WARNING) << "Failed to bind to uplink " << u.interface << ": "
+                 << ErrorToShortString(rv);
+    return rv;
+  }
+#endif
+  if (!u.address.empty() && GetAddressFamily(u.address) == family) {
+    SockaddrStorage storage;
+    if (!IPEndPoint(u.address, 0).ToSockAddr(storage.addr,
+                                              &storage.addr_len)) {
+      return ERR_ADDRESS_INVALID;
+    }
+    if (bind(fd, storage.addr, storage.addr_len) != 0)
+      return MapSystemError(errno);
+  }
+  return OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+void NaiveUplinks::Sample() {
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+  std::vector<std::string> interfaces;
+  for (const Uplink& uplink : uplinks_)
+    interfaces.push_back(uplink.interface);
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, {base::MayBlock()},
+      base::BindOnce(&ReadInterfaceBytes, std::move(interfaces)),
+      base::BindOnce(&NaiveUplinks::OnInterfaceBytes, this));
+#endif
+}
+
+void NaiveUplinks::OnInterfaceBytes(
+    std::vector<std::optional<uint64_t>> bytes) {
+  base::TimeTicks now = base::TimeTicks::Now();
+  double seconds = (now - last_sample_time_).InSecondsF();
+  last_sample_time_ = now;
+  double decay = std::exp2(-seconds / kPeakHalfLife.InSecondsF());
+  double max_peak = 0;
+  for (size_t i = 0; i < uplinks_.size(); ++i) {
+    double rate = 0;
+    // The counters start over when the interface is recreated.
+    if (bytes[i] && last_bytes_[i] && *bytes[i] >= *last_bytes_[i])
+      rate = (*bytes[i] - *last_bytes_[i]) / seconds;
+    last_bytes_[i] = bytes[i];
+    peaks_[i] = std::max(rate, peaks_[i] * decay);
+    max_peak = std::max(max_peak, peaks_[i]);
+  }
+  for (size_t i = 0; i < uplinks_.size(); ++i) {
+    int weight = kMaxWeight;
+    if (max_peak > 0) {
+      weight = std::clamp(
+          static_cast<int>(std::lround(kMaxWeight * peaks_[i] / max_peak)),
+          kMinWeight, kMaxWeight);
+    }
+    if (weights_[i].exchange(weight, std::memory_order_relaxed) != weight) {
+      VLOG(2) << "Uplink " << uplinks_[i].interface << ": weight=" << weight
+              << " peak=" << static_cast<int64_t>(peaks_[i]) << " B/s";
+    }
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,109 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_UPLINKS_H_
+#define NET_TOOLS_NAIVE_NAIVE_UPLINKS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/time/time.h"
+#include "net/base/address_family.h"
+#include "net/base/ip_address.h"
+#include "net/base/network_anonymization_key.h"
+#include "net/socket/socket_descriptor.h"
+
+namespace net {
+
+// The network interfaces that outgoing TCP connections are spread over, as
+// to several WAN links of a router. Shared by the IO threads through the
+// configuration.
+//
+// NaiveProxySelector puts tunnel session i of each chain on uplink i modulo
+// their number by registering the keys of the session here, and weighs the
+// sessions by their uplinks. NaiveClientSocketFactory binds the sockets
+// made for a registered key to its uplink, and those made for other keys,
+// as of direct tunnels, to the uplinks in turn by weight.
+//
+// The weight of an uplink follows the peak throughput of its interface, the
+// bytes received and sent per second as counted by the kernel. The counters
+// are read on the ThreadPool every kSampleInterval for the main thread, and
+// the peak halves every kPeakHalfLife so that it follows a link that slows
+// down. Weights are relative to the fastest uplink, from kMaxWeight down to
+// kMinWeight, so a slow uplink still carries some tunnels to be measured
+// with. They stay equal outside Linux.
+class NaiveUplinks : public base::RefCountedThreadSafe<NaiveUplinks> {
+ public:
+  static constexpr base::TimeDelta kSampleInterval = base::Seconds(1);
+  static constexpr base::TimeDelta kPeakHalfLife = base::Minutes(5);
+  static constexpr int kMaxWeight = 100;
+  static constexpr int kMinWeight = 10;
+
+  struct Uplink {
+    std::string interface;
+    // If not empty, the source address of connections to the same family.
+    IPAddress address;
+  };
+
+  // Each of `names` is an interface, or a local IP address to use as the
+  // source address on its interface. Returns null after logging an error if
+  // one is not found.
+  static scoped_refptr<NaiveUplinks> Create(
+      const std::vector<std::string>& names);
+
+  explicit NaiveUplinks(std::vector<Uplink> uplinks);
+  NaiveUplinks(const NaiveUplinks&) = delete;
+  NaiveUplinks& operator=(const NaiveUplinks&) = delete;
+
+  size_t size() const { return uplinks_.size(); }
+  int GetWeight(size_t uplink) const {
+    return weights_[uplink].load(std::memory_order_relaxed);
+  }
+
+  // Sends the connections made for `key` over `uplink`, or over any if
+  // nullopt.
+  void SetKeyUplink(const NetworkAnonymizationKey& key,
+                    std::optional<size_t> uplink);
+  // Returns the uplink of `key`, or the next one by weight if it has none.
+  size_t GetUplinkForKey(const NetworkAnonymizationKey& key);
+
+  // Binds `fd`, an unconnected socket to a peer of `family`, to `uplink`.
+  // Returns a net error code.
+  int Bind(size_t uplink, SocketDescriptor fd, AddressFamily family) const;
+
+  // Reads the counters of the interfaces and updates the weights once they
+  // are read. Called on the main thread.
+  void Sample();
+
+ private:
+  friend class base::RefCountedThreadSafe<NaiveUplinks>;
+  ~NaiveUplinks();
+
+  void OnInterfaceBytes(std::vector<std::optional<uint64_t>> bytes);
+
+  const std::vector<Uplink> uplinks_;
+  std::vector<std::atomic<int>> weights_;
+
+  base::Lock lock_;
+  std::map<NetworkAnonymizationKey, size_t> key_uplinks_ GUARDED_BY(lock_);
+  // For smooth weighted round robin.
+  std::vector<int> current_weights_ GUARDED_BY(lock_);
+
+  // Only used on the main thread.
+  std::vector<std::optional<uint64_t>> last_bytes_;
+  // In bytes per second.
+  std::vector<double> peaks_;
+  base::TimeTicks last_sample_time_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_UPLINKS_H_
@@ -0,0 +1,72 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/naive_user_table.h"
+
+#include "base/base64.h"
+#include "base/strings/string_split.h"
+
+namespace net {
+
+NaiveUserTable::NaiveUserTable() = default;
+NaiveUserTable::~NaiveUserTable() = default;
+
+bool NaiveUserTable::Add(const std::string& user, const std::string& pass) {
+  if (!users_.emplace(user, User{pass, nullptr}).second) {
+    return false;
+  }
+  basic_auths_.emplace(
+      std::string("Basic ").append(base::Base64Encode(user + ":" + pass)),
+      user);
+  return true;
+}
+
+bool NaiveUserTable::AddLines(std::string_view text) {
+  for (std::string_view line : base::SplitStringPiece(
+           text, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    if (line.starts_with('#')) {
+      continue;
+    }
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos ||
+        !Add(std::string(line.substr(0, colon)),
+             std::string(line.substr(colon + 1)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void NaiveUserTable::SetUserRate(int64_t rate) {
+  for (auto& [name, user] : users_) {
+    user.rate_limiter = base::MakeRefCounted<NaiveRateLimiter>(rate);
+  }
+}
+
+const std::string* NaiveUserTable::FindByPassword(std::string_view user,
+                                                  std::string_view pass) const {
+  auto it = users_.find(user);
+  if (it == users_.end() || it->second.pass != pass) {
+    return nullptr;
+  }
+  return &it->first;
+}
+
+const std::string* NaiveUserTable::FindByBasicAuth(
+    std::string_view proxy_authorization) const {
+  auto it = basic_auths_.find(proxy_authorization);
+  if (it == basic_auths_.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+NaiveRateLimiter* NaiveUserTable::GetRateLimiter(std::string_view user) const {
+  auto it = users_.find(user);
+  if (it == users_.end()) {
+    return nullptr;
+  }
+  return it->second.rate_limiter.get();
+}
+
+}  // namespace net
@@ -0,0 +1,75 @@
+// Copyright 2026 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_NAIVE_USER_TABLE_H_
+#define NET_TOOLS_NAIVE_NAIVE_USER_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "net/tools/naive/naive_rate_limiter.h"
+#include "third_party/abseil-cpp/absl/container/flat_hash_map.h"
+
+namespace net {
+
+// The users a listener accepts, looked up in hash tables so one listener
+// can serve many users. The Proxy-Authorization value of each user is
+// computed once, when the user is added. Immutable once built, and shared
+// by the sockets and sessions of the listeners of every thread.
+class NaiveUserTable : public base::RefCountedThreadSafe<NaiveUserTable> {
+ public:
+  NaiveUserTable();
+  NaiveUserTable(const NaiveUserTable&) = delete;
+  NaiveUserTable& operator=(const NaiveUserTable&) = delete;
+
+  // Returns false if `user` was already added.
+  bool Add(const std::string& user, const std::string& pass);
+
+  // Adds the users of `text`, one "user:pass" per line. Blank lines and
+  // lines starting with '#' are skipped. Returns false on a line without
+  // ':', or with a user already added.
+  bool AddLines(std::string_view text);
+
+  // Gives each user added so far a rate limiter of its own.
+  void SetUserRate(int64_t rate);
+
+  bool empty() const { return users_.empty(); }
+  size_t size() const { return users_.size(); }
+
+  // Return the name of the user with these credentials, or null. The name
+  // lives as long as the table.
+  const std::string* FindByPassword(std::string_view user,
+                                    std::string_view pass) const;
+  // `proxy_authorization` is a Proxy-Authorization header value.
+  const std::string* FindByBasicAuth(
+      std::string_view proxy_authorization) const;
+
+  // Returns the rate limiter of `user`, or null if it has none.
+  NaiveRateLimiter* GetRateLimiter(std::string_view user) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<NaiveUserTable>;
+  ~NaiveUserTable();
+
+  struct User {
+    std::string pass;
+    scoped_refptr<NaiveRateLimiter> rate_limiter;
+  };
+
+  absl::flat_hash_map<std::string, User> users_;
+  // Keyed by "Basic " and the base64 of "user:pass".
+  absl::flat_hash_map<std::string, std::string> basic_auths_;
+};
+
+// Returns true if a listener with `users` requires authentication. Null
+// means it does not.
+inline bool RequiresAuth(const NaiveUserTable* users) {
+  return users && !users->empty();
+}
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_NAIVE_USER_TABLE_H_
@@ -4,29 +4,134 @@
 
 #include "net/tools/naive/redirect_resolver.h"
 
-#include <cstring>
-#include <iterator>
+#include <algorithm>
+#include <optional>
+#include <string_view>
 #include <utility>
 
+#include "base/containers/span.h"
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/hash/hash.h"
 #include "base/logging.h"
+#include "base/numerics/byte_conversions.h"
+#include "base/strings/string_util.h"
 #include "base/task/single_thread_task_runner.h"
+#include "base/task/thread_pool.h"
+#include "net/base/elements_upload_data_stream.h"
 #include "net/base/io_buffer.h"
+#include "net/base/load_flags.h"
 #include "net/base/net_errors.h"
+#include "net/base/request_priority.h"
+#include "net/base/upload_bytes_element_reader.h"
 #include "net/base/url_util.h"
 #include "net/dns/dns_names_util.h"
 #include "net/dns/dns_query.h"
 #include "net/dns/dns_response.h"
 #include "net/dns/dns_util.h"
+#include "net/http/http_request_headers.h"
 #include "net/socket/datagram_server_socket.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_context.h"
 #include "third_party/abseil-cpp/absl/types/optional.h"
 
 namespace {
 constexpr int kUdpReadBufferSize = 1024;
 constexpr int kResolutionTtl = 60;
-constexpr int kResolutionRecycleTime = 60 * 5;
+// Holds bursts of queries from a LAN while they are answered.
+constexpr int kSocketReceiveBufferSize = 256 * 1024;
+constexpr int kMaxReadsPerTask = 64;
+constexpr size_t kMaxQueuedResponses = 256;
+// Bounds the ring for large ranges.
+constexpr size_t kMaxResolutions = 1 << 20;
+constexpr size_t kMinNameIndexSize = 64;
+constexpr base::TimeDelta kOverwriteLogInterval = base::Minutes(1);
+
+constexpr char kDnsMessageType[] = "application/dns-message";
+// Queries beyond this get SERVFAIL, so a flood of lookups cannot pile up
+// streams in the tunnel.
+constexpr size_t kMaxUpstreamQueries = 64;
+constexpr size_t kMaxUpstreamResponseSize = 64 * 1024;
+constexpr size_t kMaxCachedResponses = 1024;
+// Upstream TTLs are capped so stale records do not linger.
+constexpr uint32_t kMaxCachedTtl = 300;
+
+// The mapping file starts with the magic and the ranges it was saved for.
+// Each record is a little-endian uint32_t ring index, a name length byte,
+// and the name. A later record for an index replaces earlier ones.
+constexpr char kMappingFileMagic[] = "naivemap";
+constexpr size_t kMappingRecordHeaderSize = sizeof(uint32_t) + 1;
+constexpr size_t kMinCompactedRecords = 1024;
+
+// Clears the host bits of `range`.
+net::IPAddress MaskRange(const net::IPAddress& range, size_t prefix) {
+  net::IPAddressBytes bytes = range.bytes();
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    size_t bits = i * 8 < prefix ? prefix - i * 8 : 0;
+    if (bits < 8)
+      bytes.data()[i] &= static_cast<uint8_t>(0xff00 >> bits);
+  }
+  return net::IPAddress(bytes);
+}
+
+size_t RangeCapacity(const net::IPAddress& range, size_t prefix) {
+  size_t host_bits = range.size() * 8 - prefix;
+  if (host_bits >= 20)
+    return kMaxResolutions;
+  return size_t{1} << host_bits;
+}
 
-std::string PackedIPv4ToString(uint32_t addr) {
-  return net::IPAddress(addr >> 24, addr >> 16, addr >> 8, addr).ToString();
+// Returns the `index`-th address of the masked `range`.
+net::IPAddress AddressAt(const net::IPAddress& range, size_t index) {
+  net::IPAddressBytes bytes = range.bytes();
+  for (size_t i = bytes.size(); i-- > 0 && index != 0; index >>= 8) {
+    bytes.data()[i] |= static_cast<uint8_t>(index);
+  }
+  return net::IPAddress(bytes);
+}
+
+// Returns the offset of `address` in the masked `range`, if it is in the
+// range and small enough to be a ring index.
+std::optional<size_t> IndexInRange(const net::IPAddress& address,
+                                   const net::IPAddress& range,
+                                   size_t prefix) {
+  if (range.empty() || address.size() != range.size() ||
+      !net::IPAddressMatchesPrefix(address, range, prefix)) {
+    return std::nullopt;
+  }
+  size_t index = 0;
+  for (size_t i = 0; i < address.size(); ++i) {
+    uint8_t host = address.bytes()[i] ^ range.bytes()[i];
+    if (i + sizeof(uint32_t) < address.size()) {
+      if (host != 0)
+        return std::nullopt;
+    } else {
+      index = (index << 8) | host;
+    }
+  }
+  return index;
+}
+
+void AppendMappingRecord(size_t index,
+                         std::string_view name,
+                         std::string* out) {
+  DCHECK_LE(name.size(), 255u);
+  auto index_bytes = base::U32ToLittleEndian(static_cast<uint32_t>(index));
+  out->append(index_bytes.begin(), index_bytes.end());
+  out->push_back(static_cast<char>(name.size()));
+  out->append(name);
+}
+
+// Replaces the file at `path` with `contents`.
+bool WriteMappingFile(const base::FilePath& path, std::string_view contents) {
+  base::FilePath temp_path = path.AddExtension(FILE_PATH_LITERAL("tmp"));
+  if (!base::WriteFile(temp_path, contents) ||
+      !base::ReplaceFile(temp_path, path, nullptr)) {
+    LOG(ERROR) << "Failed to write " << path;
+    return false;
+  }
+  return true;
 }
 }  // namespace
 
@@ -36,15 +141,188 @@ Resolution::Resolution() = default;
 
 Resolution::~Resolution() = default;
 
+// Forwards one query to the DoH server with the POST method of RFC 8484.
+class RedirectResolver::UpstreamQuery : public URLRequest::Delegate {
+ public:
+  UpstreamQuery(RedirectResolver* resolver,
+                const IPEndPoint& address,
+                uint16_t id,
+                std::string qname,
+                uint16_t qtype,
+                std::string cache_key)
+      : resolver_(resolver),
+        address_(address),
+        id_(id),
+        qname_(std::move(qname)),
+        qtype_(qtype),
+        cache_key_(std::move(cache_key)) {}
+  ~UpstreamQuery() override = default;
+  UpstreamQuery(const UpstreamQuery&) = delete;
+  UpstreamQuery& operator=(const UpstreamQuery&) = delete;
+
+  void Start(const GURL& url,
+             URLRequestContext* context,
+             const NetworkTrafficAnnotationTag& traffic_annotation,
+             const std::string& query) {
+    request_ = context->CreateRequest(url, DEFAULT_PRIORITY, this,
+                                      traffic_annotation);
+    request_->set_method("POST");
+    request_->set_allow_credentials(false);
+    // Responses are cached by the resolver according to their TTLs.
+    request_->SetLoadFlags(LOAD_DISABLE_CACHE);
+    request_->SetExtraRequestHeaderByName(HttpRequestHeaders::kAccept,
+                                          kDnsMessageType, true);
+    request_->SetExtraRequestHeaderByName(HttpRequestHeaders::kContentType,
+                                          kDnsMessageType, true);
+    request_->set_upload(ElementsUploadDataStream::CreateWithReader(
+        UploadOwnedBytesElementReader::CreateWithString(query), 0));
+    request_->Start();
+  }
+
+  const IPEndPoint& address() const { return address_; }
+  uint16_t id() const { return id_; }
+  const std::string& qname() const { return qname_; }
+  uint16_t qtype() const { return qtype_; }
+  const std::string& cache_key() const { return cache_key_; }
+
+  // URLRequest::Delegate implementation:
+  void OnResponseStarted(URLRequest* request, int net_error) override {
+    if (net_error != OK) {
+      Finish(net_error);
+      return;
+    }
+    if (request->GetResponseCode() != 200) {
+      LOG(INFO) << "Upstream DNS server returned HTTP "
+                << request->GetResponseCode();
+      Finish(ERR_FAILED);
+      return;
+    }
+    read_buffer_ = base::MakeRefCounted<IOBufferWithSize>(kUdpReadBufferSize);
+    Read();
+  }
+
+  void OnReadCompleted(URLRequest* request, int bytes_read) override {
+    if (bytes_read <= 0) {
+      Finish(bytes_read);
+      return;
+    }
+    if (!AppendResponse(bytes_read))
+      return;
+    Read();
+  }
+
+ private:
+  void Read() {
+    for (;;) {
+      int rv = request_->Read(read_buffer_.get(), read_buffer_->size());
+      if (rv == ERR_IO_PENDING)
+        return;
+      if (rv <= 0) {
+        Finish(rv);
+        return;
+      }
+      if (!AppendResponse(rv))
+        return;
+    }
+  }
+
+  // Returns false after finishing with an oversized response.
+  bool AppendResponse(int size) {
+    response_.append(read_buffer_->data(), size);
+    if (response_.size() > kMaxUpstreamResponseSize) {
+      Finish(ERR_MSG_TOO_BIG);
+      return false;
+    }
+    return true;
+  }
+
+  // Deletes `this`.
+  void Finish(int error) {
+    request_.reset();
+    resolver_->OnUpstreamQueryComplete(this, error, std::move(response_));
+  }
+
+  const raw_ptr<RedirectResolver> resolver_;
+  const IPEndPoint address_;
+  const uint16_t id_;
+  const std::string qname_;
+  const uint16_t qtype_;
+  const std::string cache_key_;
+
+  std::unique_ptr<URLRequest> request_;
+  scoped_refptr<IOBufferWithSize> read_buffer_;
+  std::string response_;
+};
+
+// Writes the mapping file on a ThreadPool sequence, so that resolving a new
+// name does not wait for the disk. After a failed write, records are
+// dropped until the next rewrite.
+class RedirectResolver::MappingFileWriter {
+ public:
+  explicit MappingFileWriter(const base::FilePath& path) : path_(path) {
+    Open();
+  }
+  MappingFileWriter(const MappingFileWriter&) = delete;
+  MappingFileWriter& operator=(const MappingFileWriter&) = delete;
+  ~MappingFileWriter() = default;
+
+  void Rewrite(const std::string& contents) {
+    file_.Close();
+    if (WriteMappingFile(path_, contents)) {
+      Open();
+    }
+  }
+
+  void Append(const std::string& record) {
+    if (!file_.IsValid())
+      return;
+    if (!file_.WriteAtCurrentPosAndCheck(base::as_byte_span(record))) {
+      LOG(ERROR) << "Failed to append to " << path_;
+      file_.Close();
+    }
+  }
+
+ private:
+  void Open() {
+    file_.Initialize(path_, base::File::FLAG_OPEN | base::File::FLAG_APPEND);
+    if (!file_.IsValid()) {
+      LOG(ERROR) << "Failed to open " << path_ << ": "
+                 << base::File::ErrorToString(file_.error_details());
+    }
+  }
+
+  const base::FilePath path_;
+  base::File file_;
+};
+
 RedirectResolver::RedirectResolver(std::unique_ptr<DatagramServerSocket> socket,
                                    const IPAddress& range,
-                                   size_t prefix)
+                                   size_t prefix,
+                                   const IPAddress& range6,
+                                   size_t prefix6)
     : socket_(std::move(socket)),
-      range_(range),
+      range_(MaskRange(range, prefix)),
       prefix_(prefix),
-      offset_(0),
-      buffer_(base::MakeRefCounted<IOBufferWithSize>(kUdpReadBufferSize)) {
+      prefix6_(prefix6),
+      buffer_(base::MakeRefCounted<IOBufferWithSize>(kUdpReadBufferSize)),
+      send_pending_(false),
+      read_paused_(false),
+      capacity_(RangeCapacity(range_, prefix_)),
+      next_(0),
+      overwrites_since_log_(0),
+      response_cache_(kMaxCachedResponses),
+      mapping_records_(0) {
   DCHECK(socket_);
+  if (!range6.empty()) {
+    range6_ = MaskRange(range6, prefix6);
+    capacity_ = std::min(capacity_, RangeCapacity(range6_, prefix6_));
+  }
+  GrowNameIndex();
+  int rv = socket_->SetReceiveBufferSize(kSocketReceiveBufferSize);
+  if (rv != OK) {
+    LOG(INFO) << "Failed to set resolver receive buffer size: "
+              << ErrorToShortString(rv);
+  }
   // Start accepting connections in next run loop in case when delegate is not
   // ready to get callbacks.
   base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
@@ -54,27 +332,44 @@ RedirectResolver::RedirectResolver(std::unique_ptr<DatagramServerSocket> socket,
 
 RedirectResolver::~RedirectResolver() = default;
 
+void RedirectResolver::StopAnswering() {
+  stopped_ = true;
+  socket_->Close();
+  send_queue_ = {};
+  upstream_queries_.clear();
+}
+
+void RedirectResolver::ReleaseCaches() {
+  response_cache_.Clear();
+}
+
 void RedirectResolver::DoRead() {
-  for (;;) {
+  if (stopped_)
+    return;
+  for (int i = 0; i < kMaxReadsPerTask; ++i) {
+    // Resumes once the clients read some responses.
+    if (send_queue_.size() >= kMaxQueuedResponses) {
+      read_paused_ = true;
+      return;
+    }
     int rv = socket_->RecvFrom(
         buffer_.get(), kUdpReadBufferSize, &recv_address_,
         base::BindOnce(&RedirectResolver::OnRecv, base::Unretained(this)));
     if (rv == ERR_IO_PENDING)
       return;
     rv = HandleReadResult(rv);
-    if (rv == ERR_IO_PENDING)
-      return;
     if (rv < 0) {
       LOG(INFO) << "DoRead: ignoring error " << ErrorToShortString(rv);
     }
   }
+  // Lets other tasks run between batches of queries.
+  base::SingleThreadTaskRunner::GetCurrentDefault()->PostTask(
+      FROM_HERE, base::BindOnce(&RedirectResolver::DoRead,
+                                weak_ptr_factory_.GetWeakPtr()));
 }
 
 void RedirectResolver::OnRecv(int result) {
-  int rv;
-  rv = HandleReadResult(result);
-  if (rv == ERR_IO_PENDING)
-    return;
+  int rv = HandleReadResult(result);
   if (rv < 0) {
     LOG(INFO) << "OnRecv: ignoring error " << ErrorToShortString(rv);
   }
@@ -82,12 +377,45 @@ void RedirectResolver::OnRecv(int result) {
   DoRead();
 }
 
+void RedirectResolver::QueueResponse(scoped_refptr<IOBuffer> buffer,
+                                     int size,
+                                     const IPEndPoint& address) {
+  if (stopped_)
+    return;
+  send_queue_.push({std::move(buffer), size, address});
+  DoSend();
+}
+
+void RedirectResolver::DoSend() {
+  while (!send_pending_ && !send_queue_.empty()) {
+    const PendingResponse& response = send_queue_.front();
+    int rv = socket_->SendTo(
+        response.buffer.get(), response.size, response.address,
+        base::BindOnce(&RedirectResolver::OnSend, base::Unretained(this)));
+    if (rv == ERR_IO_PENDING) {
+      send_pending_ = true;
+      return;
+    }
+    if (rv < 0) {
+      LOG(INFO) << "DoSend: ignoring error " << ErrorToShortString(rv);
+    }
+    send_queue_.pop();
+  }
+
+  if (read_paused_ && send_queue_.size() < kMaxQueuedResponses) {
+    read_paused_ = false;
+    DoRead();
+  }
+}
+
 void RedirectResolver::OnSend(int result) {
   if (result < 0) {
     LOG(INFO) << "OnSend: ignoring error " << ErrorToShortString(result);
   }
 
-  DoRead();
+  send_pending_ = false;
+  send_queue_.pop();
+  DoSend();
 }
 
 int RedirectResolver::HandleReadResult(int result) {
@@ -109,135 +437,380 @@ int RedirectResolver::HandleReadResult(int result) {
         DnsResponse(query.id(), /*is_authoritative=*/false, /*answers=*/{},
                     /*authority_records=*/{}, /*additional_records=*/{},
                     query_opt, dns_protocol::kRcodeFORMERR);
-  } else if (query.qtype() != dns_protocol::kTypeA) {
+  } else if (query.qtype() != dns_protocol::kTypeA &&
+             query.qtype() != dns_protocol::kTypeAAAA &&
+             upstream_context_) {
+    if (ForwardQuery(query, result))
+      return OK;
+    response =
+        DnsResponse(query.id(), /*is_authoritative=*/false, /*answers=*/{},
+                    /*authority_records=*/{}, /*additional_records=*/{},
+                    query_opt, dns_protocol::kRcodeSERVFAIL);
+  } else if (query.qtype() != dns_protocol::kTypeA &&
+             query.qtype() != dns_protocol::kTypeAAAA) {
     response =
         DnsResponse(query.id(), /*is_authoritative=*/false, /*answers=*/{},
                     /*authority_records=*/{}, /*additional_records=*/{},
                     query_opt, dns_protocol::kRcodeNOTIMP);
+  } else if (query.qtype() == dns_protocol::kTypeAAAA && range6_.empty()) {
+    // An empty answer lets clients use the A records right away.
+    response =
+        DnsResponse(query.id(), /*is_authoritative=*/false, /*answers=*/{},
+                    /*authority_records=*/{}, /*additional_records=*/{},
+                    query_opt);
   } else {
-    Resolution res;
-
     const auto& name = name_or.value();
-
-    auto by_name_lookup = resolution_by_name_.emplace(name, resolutions_.end());
-    auto by_name = by_name_lookup.first;
-    bool has_name = !by_name_lookup.second;
-    if (has_name) {
-      auto res_it = by_name->second;
-      auto by_addr = res_it->by_addr;
-      uint32_t addr = res_it->addr;
-
-      resolutions_.erase(res_it);
-      resolutions_.emplace_back();
-      res_it = std::prev(resolutions_.end());
-
-      by_name->second = res_it;
-      by_addr->second = res_it;
-      res_it->addr = addr;
-      res_it->name = name;
-      res_it->time = base::TimeTicks::Now();
-      res_it->by_name = by_name;
-      res_it->by_addr = by_addr;
-    } else {
-      uint32_t addr = (range_.bytes()[0] << 24) | (range_.bytes()[1] << 16) |
-                      (range_.bytes()[2] << 8) | range_.bytes()[3];
-      uint32_t subnet = ~0U >> prefix_;
-      addr &= ~subnet;
-      addr += offset_;
-      offset_ = (offset_ + 1) & subnet;
-
-      auto by_addr_lookup =
-          resolution_by_addr_.emplace(addr, resolutions_.end());
-      auto by_addr = by_addr_lookup.first;
-      bool has_addr = !by_addr_lookup.second;
-      if (has_addr) {
-        // Too few available addresses. Overwrites old one.
-        auto res_it = by_addr->second;
-
-        LOG(INFO) << "Overwrite " << res_it->name << " "
-                  << PackedIPv4ToString(res_it->addr) << " with " << name << " "
-                  << PackedIPv4ToString(addr);
-        resolution_by_name_.erase(res_it->by_name);
-        resolutions_.erase(res_it);
-        resolutions_.emplace_back();
-        res_it = std::prev(resolutions_.end());
-
-        by_name->second = res_it;
-        by_addr->second = res_it;
-        res_it->addr = addr;
-        res_it->name = name;
-        res_it->time = base::TimeTicks::Now();
-        res_it->by_name = by_name;
-        res_it->by_addr = by_addr;
-      } else {
-        LOG(INFO) << "Add " << name << " " << PackedIPv4ToString(addr);
-        resolutions_.emplace_back();
-        auto res_it = std::prev(resolutions_.end());
-
-        by_name->second = res_it;
-        by_addr->second = res_it;
-        res_it->addr = addr;
-        res_it->name = name;
-        res_it->time = base::TimeTicks::Now();
-        res_it->by_name = by_name;
-        res_it->by_addr = by_addr;
-
-        // Collects garbage.
-        auto now = base::TimeTicks::Now();
-        for (auto it = resolutions_.begin();
-             it != resolutions_.end() &&
-             (now - it->time).InSeconds() > kResolutionRecycleTime;) {
-          auto next = std::next(it);
-          LOG(INFO) << "Drop " << it->name << " "
-                    << PackedIPv4ToString(it->addr);
-          resolution_by_name_.erase(it->by_name);
-          resolution_by_addr_.erase(it->by_addr);
-          resolutions_.erase(it);
-          it = next;
-        }
-      }
-    }
+    size_t index = Resolve(name);
+    const IPAddress& range =
+        query.qtype() == dns_protocol::kTypeA ? range_ : range6_;
 
     DnsResourceRecord record;
     record.name = name;
-    record.type = dns_protocol::kTypeA;
+    record.type = query.qtype();
     record.klass = dns_protocol::kClassIN;
     record.ttl = kResolutionTtl;
-    uint32_t addr = by_name->second->addr;
-    record.SetOwnedRdata(IPAddressToPackedString(
-        IPAddress(addr >> 24, addr >> 16, addr >> 8, addr)));
+    record.SetOwnedRdata(IPAddressToPackedString(AddressAt(range, index)));
     response = DnsResponse(query.id(), /*is_authoritative=*/false,
                            /*answers=*/{std::move(record)},
                            /*authority_records=*/{}, /*additional_records=*/{},
                            query_opt);
   }
-  int size = response.io_buffer_size();
-  if (size > buffer_->size() || !response.io_buffer()) {
+  if (!response.io_buffer()) {
     return ERR_NO_BUFFER_SPACE;
   }
-  std::memcpy(buffer_->data(), response.io_buffer()->data(), size);
 
-  return socket_->SendTo(
-      buffer_.get(), size, recv_address_,
-      base::BindOnce(&RedirectResolver::OnSend, base::Unretained(this)));
+  // Sends the response buffer itself, so reading goes on while responses
+  // wait for the socket.
+  QueueResponse(base::WrapRefCounted(response.io_buffer()),
+                static_cast<int>(response.io_buffer_size()), recv_address_);
+  return OK;
 }
 
-bool RedirectResolver::IsInResolvedRange(const IPAddress& address) const {
-  if (!address.IsIPv4())
+void RedirectResolver::SetUpstream(
+    const GURL& url,
+    URLRequestContext* context,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  upstream_url_ = url;
+  upstream_context_ = context;
+  upstream_traffic_annotation_ = traffic_annotation;
+}
+
+bool RedirectResolver::ForwardQuery(const DnsQuery& query, int size) {
+  std::string cache_key =
+      base::ToLowerASCII(base::as_string_view(query.qname()));
+  auto qtype_bytes = base::U16ToBigEndian(query.qtype());
+  cache_key.append(qtype_bytes.begin(), qtype_bytes.end());
+
+  auto it = response_cache_.Get(cache_key);
+  if (it != response_cache_.end()) {
+    if (base::TimeTicks::Now() < it->second.expiration) {
+      std::string response = it->second.response;
+      auto id_bytes = base::U16ToBigEndian(query.id());
+      response.replace(0, id_bytes.size(),
+                       reinterpret_cast<const char*>(id_bytes.data()),
+                       id_bytes.size());
+      int response_size = static_cast<int>(response.size());
+      QueueResponse(base::MakeRefCounted<StringIOBuffer>(std::move(response)),
+                    response_size, recv_address_);
+      return true;
+    }
+    response_cache_.Erase(it);
+  }
+
+  if (upstream_queries_.size() >= kMaxUpstreamQueries)
     return false;
-  return IPAddressMatchesPrefix(address, range_, prefix_);
+
+  auto upstream_query = std::make_unique<UpstreamQuery>(
+      this, recv_address_, query.id(),
+      std::string(base::as_string_view(query.qname())), query.qtype(),
+      std::move(cache_key));
+  UpstreamQuery* raw_query = upstream_query.get();
+  upstream_queries_.insert(std::move(upstream_query));
+  // The query is forwarded as is, with its ID and EDNS options.
+  raw_query->Start(upstream_url_, upstream_context_,
+                   *upstream_traffic_annotation_,
+                   std::string(buffer_->data(), size));
+  return true;
+}
+
+void RedirectResolver::OnUpstreamQueryComplete(UpstreamQuery* query,
+                                               int error,
+                                               std::string response) {
+  auto it = upstream_queries_.find(query);
+  CHECK(it != upstream_queries_.end());
+  std::unique_ptr<UpstreamQuery> owned_query =
+      std::move(upstream_queries_.extract(it).value());
+
+  DnsResponse parsed(base::MakeRefCounted<StringIOBuffer>(response),
+                     response.size());
+  if (error != OK || !parsed.InitParseWithoutQuery(response.size()) ||
+      parsed.id() != query->id()) {
+    LOG(INFO) << "Upstream DNS query failed: " << ErrorToShortString(error);
+    // Fails right away, so clients need not wait for a timeout.
+    DnsResponse failure(
+        query->id(), /*is_authoritative=*/false, /*answers=*/{},
+        /*authority_records=*/{}, /*additional_records=*/{},
+        DnsQuery(query->id(), base::as_byte_span(query->qname()),
+                 query->qtype()),
+        dns_protocol::kRcodeSERVFAIL);
+    if (failure.io_buffer()) {
+      QueueResponse(base::WrapRefCounted(failure.io_buffer()),
+                    static_cast<int>(failure.io_buffer_size()),
+                    query->address());
+    }
+    return;
+  }
+
+  // Negative answers are cached like records. TTLs are not decreased on
+  // hits, so clients may keep records up to twice kMaxCachedTtl.
+  if (parsed.rcode() == dns_protocol::kRcodeNOERROR ||
+      parsed.rcode() == dns_protocol::kRcodeNXDOMAIN) {
+    uint32_t ttl = kMaxCachedTtl;
+    DnsRecordParser parser = parsed.Parser();
+    for (unsigned i = 0; i < parsed.answer_count(); ++i) {
+      DnsResourceRecord record;
+      if (!parser.ReadRecord(&record)) {
+        ttl = 0;
+        break;
+      }
+      ttl = std::min(ttl, record.ttl);
+    }
+    if (parsed.answer_count() == 0)
+      ttl = kResolutionTtl;
+    if (ttl > 0) {
+      response_cache_.Put(
+          query->cache_key(),
+          {response, base::TimeTicks::Now() + base::Seconds(ttl)});
+    }
+  }
+
+  int response_size = static_cast<int>(response.size());
+  QueueResponse(base::MakeRefCounted<StringIOBuffer>(std::move(response)),
+                response_size, query->address());
+}
+
+bool RedirectResolver::OpenMappingFile(const base::FilePath& path) {
+  base::MemoryMappedFile mapped;
+  if (mapped.Initialize(path)) {
+    std::string_view data(reinterpret_cast<const char*>(mapped.data()),
+                          mapped.length());
+    std::string header = MappingFileHeader();
+    if (data.starts_with(header)) {
+      data.remove_prefix(header.size());
+      size_t count = 0;
+      // Replays the records in order. A record cut short by a crash while
+      // appending ends the file.
+      while (data.size() >= kMappingRecordHeaderSize) {
+        uint32_t index =
+            base::U32FromLittleEndian(base::as_byte_span(data).first<4>());
+        size_t name_size = static_cast<uint8_t>(data[sizeof(uint32_t)]);
+        if (data.size() < kMappingRecordHeaderSize + name_size)
+          break;
+        std::string name(data.substr(kMappingRecordHeaderSize, name_size));
+        data.remove_prefix(kMappingRecordHeaderSize + name_size);
+        if (index >= capacity_ || name.empty())
+          continue;
+        Assign(index, name, base::FastHash(name));
+        next_ = (index + 1) % capacity_;
+        ++count;
+      }
+      LOG(INFO) << "Loaded " << count << " resolutions from " << path;
+    } else {
+      LOG(WARNING) << "Ignoring " << path << " saved for other ranges";
+    }
+  }
+
+  // Written here, before any query is answered, so that a file that cannot
+  // be written is reported.
+  if (!WriteMappingFile(path, CompactedMappingFile()))
+    return false;
+  mapping_writer_ = base::SequenceBound<MappingFileWriter>(
+      base::ThreadPool::CreateSequencedTaskRunner(
+          {base::MayBlock(), base::TaskPriority::BEST_EFFORT,
+           base::TaskShutdownBehavior::BLOCK_SHUTDOWN}),
+      path);
+  return true;
+}
+
+size_t RedirectResolver::Resolve(const std::string& name) {
+  size_t name_hash = base::FastHash(name);
+  size_t slot = FindNameSlot(name, name_hash);
+  if (name_index_[slot] != 0)
+    return name_index_[slot] - 1;
+
+  size_t index = next_;
+  next_ = (next_ + 1) % capacity_;
+  if (index < resolutions_.size() && !resolutions_[index].name.empty()) {
+    // Too few available addresses. Overwrites old one.
+    VLOG(1) << "Overwrite " << resolutions_[index].name << " with " << name
+            << " " << AddressAt(range_, index).ToString();
+    // A busy or small range overwrites on most queries, so they are only
+    // counted at INFO.
+    ++overwrites_since_log_;
+    base::TimeTicks now = base::TimeTicks::Now();
+    if (now - last_overwrite_log_time_ >= kOverwriteLogInterval) {
+      LOG(INFO) << "Overwrote " << overwrites_since_log_
+                << " old resolutions, the resolver range may be too small";
+      overwrites_since_log_ = 0;
+      last_overwrite_log_time_ = now;
+    }
+  } else {
+    VLOG(1) << "Add " << name << " " << AddressAt(range_, index).ToString();
+  }
+  Assign(index, name, name_hash);
+  AppendMapping(index);
+  return index;
+}
+
+void RedirectResolver::Assign(size_t index,
+                              const std::string& name,
+                              size_t name_hash) {
+  // A name has one resolution at a time.
+  size_t slot = FindNameSlot(name, name_hash);
+  if (name_index_[slot] != 0) {
+    size_t old_index = name_index_[slot] - 1;
+    if (old_index == index)
+      return;
+    RemoveFromNameIndex(old_index);
+    resolutions_[old_index].name.clear();
+  }
+
+  if (index < resolutions_.size()) {
+    if (!resolutions_[index].name.empty())
+      RemoveFromNameIndex(index);
+  } else {
+    resolutions_.resize(index + 1);
+    // Keeps the index at most half full.
+    while (resolutions_.size() * 2 > name_index_.size())
+      GrowNameIndex();
+  }
+  Resolution& res = resolutions_[index];
+  res.name = name;
+  res.name_hash = name_hash;
+  AddToNameIndex(index);
+}
+
+std::string RedirectResolver::MappingFileHeader() const {
+  std::string header(kMappingFileMagic);
+  for (auto [range, prefix] : {std::make_pair(&range_, prefix_),
+                               std::make_pair(&range6_, prefix6_)}) {
+    header.push_back(static_cast<char>(range->size()));
+    header.append(range->bytes().begin(), range->bytes().end());
+    header.push_back(static_cast<char>(prefix));
+  }
+  return header;
+}
+
+std::string RedirectResolver::CompactedMappingFile() {
+  std::string contents = MappingFileHeader();
+  mapping_records_ = 0;
+  // Oldest first, so the last record restores next_ when loaded.
+  for (size_t i = 0; i < resolutions_.size(); ++i) {
+    size_t index = (next_ + i) % resolutions_.size();
+    if (resolutions_[index].name.empty())
+      continue;
+    AppendMappingRecord(index, resolutions_[index].name, &contents);
+    ++mapping_records_;
+  }
+  return contents;
+}
+
+void RedirectResolver::CompactMappingFile() {
+  mapping_writer_.AsyncCall(&MappingFileWriter::Rewrite)
+      .WithArgs(CompactedMappingFile());
+}
+
+void RedirectResolver::AppendMapping(size_t index) {
+  if (mapping_writer_.is_null())
+    return;
+
+  // Drops overwritten records once they outnumber the live ones.
+  if (mapping_records_ >= 2 * resolutions_.size() + kMinCompactedRecords) {
+    CompactMappingFile();
+    return;
+  }
+
+  std::string record;
+  AppendMappingRecord(index, resolutions_[index].name, &record);
+  mapping_writer_.AsyncCall(&MappingFileWriter::Append)
+      .WithArgs(std::move(record));
+  ++mapping_records_;
+}
+
+std::optional<size_t> RedirectResolver::FindIndexByAddress(
+    const IPAddress& address) const {
+  IPAddress addr = address;
+  if (addr.IsIPv4MappedIPv6())
+    addr = ConvertIPv4MappedIPv6ToIPv4(addr);
+  std::optional<size_t> index = IndexInRange(addr, range_, prefix_);
+  if (!index.has_value())
+    index = IndexInRange(addr, range6_, prefix6_);
+  if (!index.has_value() || *index >= resolutions_.size())
+    return std::nullopt;
+  return index;
+}
+
+size_t RedirectResolver::FindNameSlot(std::string_view name,
+                                      size_t name_hash) const {
+  size_t mask = name_index_.size() - 1;
+  for (size_t slot = name_hash & mask;; slot = (slot + 1) & mask) {
+    uint32_t entry = name_index_[slot];
+    if (entry == 0)
+      return slot;
+    const Resolution& res = resolutions_[entry - 1];
+    if (res.name_hash == name_hash && res.name == name)
+      return slot;
+  }
+}
+
+void RedirectResolver::AddToNameIndex(size_t index) {
+  const Resolution& res = resolutions_[index];
+  size_t slot = FindNameSlot(res.name, res.name_hash);
+  DCHECK_EQ(name_index_[slot], 0u);
+  name_index_[slot] = index + 1;
+}
+
+void RedirectResolver::RemoveFromNameIndex(size_t index) {
+  const Resolution& res = resolutions_[index];
+  size_t mask = name_index_.size() - 1;
+  size_t hole = FindNameSlot(res.name, res.name_hash);
+  DCHECK_EQ(name_index_[hole], index + 1);
+  // Moves back later entries whose probe sequences pass the hole, so lookups
+  // need no tombstones.
+  for (size_t slot = (hole + 1) & mask; name_index_[slot] != 0;
+       slot = (slot + 1) & mask) {
+    size_t home = resolutions_[name_index_[slot] - 1].name_hash & mask;
+    if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+      name_index_[hole] = name_index_[slot];
+      hole = slot;
+    }
+  }
+  name_index_[hole] = 0;
+}
+
+void RedirectResolver::GrowNameIndex() {
+  name_index_.assign(std::max(kMinNameIndexSize, name_index_.size() * 2), 0);
+  for (size_t i = 0; i < resolutions_.size(); ++i) {
+    if (!resolutions_[i].name.empty())
+      AddToNameIndex(i);
+  }
+}
+
+bool RedirectResolver::IsInResolvedRange(const IPAddress& address) const {
+  IPAddress addr = address;
+  if (addr.IsIPv4MappedIPv6())
+    addr = ConvertIPv4MappedIPv6ToIPv4(addr);
+  if (addr.IsIPv4())
+    return IPAddressMatchesPrefix(addr, range_, prefix_);
+  return !range6_.empty() && IPAddressMatchesPrefix(addr, range6_, prefix6_);
 }
 
 std::string RedirectResolver::FindNameByAddress(
     const IPAddress& address) const {
-  if (!address.IsIPv4())
-    return {};
-  uint32_t addr = (address.bytes()[0] << 24) | (address.bytes()[1] << 16) |
-                  (address.bytes()[2] << 8) | address.bytes()[3];
-  auto by_addr = resolution_by_addr_.find(addr);
-  if (by_addr == resolution_by_addr_.end())
+  std::optional<size_t> index = FindIndexByAddress(address);
+  if (!index.has_value())
     return {};
-  return by_addr->second->name;
+  return resolutions_[*index].name;
 }
 
 }  // namespace net
@@ -5,62 +5,179 @@
 #ifndef NET_TOOLS_NAIVE_REDIRECT_RESOLVER_H_
 #define NET_TOOLS_NAIVE_REDIRECT_RESOLVER_H_
 
+#include <cstddef>
 #include <cstdint>
-#include <list>
-#include <map>
 #include <memory>
+#include <optional>
+#include <queue>
+#include <set>
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "base/containers/lru_cache.h"
+#include "base/containers/unique_ptr_adapters.h"
+#include "base/files/file_path.h"
+#include "base/memory/raw_ptr.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
+#include "base/threading/sequence_bound.h"
 #include "base/time/time.h"
+#include "net/base/io_buffer.h"
 #include "net/base/ip_address.h"
 #include "net/base/ip_endpoint.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "url/gurl.h"
 
 namespace net {
 
 class DatagramServerSocket;
-class IOBufferWithSize;
+class DnsQuery;
+class URLRequestContext;
 
 struct Resolution {
   Resolution();
   ~Resolution();
 
-  uint32_t addr;
+  // Empty if the entry is unused.
   std::string name;
-  base::TimeTicks time;
-  std::map<std::string, std::list<Resolution>::iterator>::iterator by_name;
-  std::map<uint32_t, std::list<Resolution>::iterator>::iterator by_addr;
+  size_t name_hash = 0;
 };
 
+// Answers A and AAAA queries with artificial addresses from `range` and
+// `range6` and translates them back to the names. Resolutions live in a ring
+// whose i-th entry has the i-th address of each range, so new names
+// overwrite the oldest ones once the ring is full.
+//
+// Queries of other types are forwarded to a DoH server if one is set.
 class RedirectResolver {
  public:
+  // `range6` may be empty to answer AAAA queries without records.
   RedirectResolver(std::unique_ptr<DatagramServerSocket> socket,
                    const IPAddress& range,
-                   size_t prefix);
+                   size_t prefix,
+                   const IPAddress& range6,
+                   size_t prefix6);
   ~RedirectResolver();
   RedirectResolver(const RedirectResolver&) = delete;
   RedirectResolver& operator=(const RedirectResolver&) = delete;
 
+  // Loads the resolutions saved in `path` and saves new ones there, so
+  // clients keep their cached addresses across restarts. Returns false if
+  // the file cannot be written.
+  bool OpenMappingFile(const base::FilePath& path);
+
+  // Forwards queries other than A and AAAA to the DoH server at `url`
+  // through `context`, which must outlive this.
+  void SetUpstream(const GURL& url,
+                   URLRequestContext* context,
+                   const NetworkTrafficAnnotationTag& traffic_annotation);
+
   bool IsInResolvedRange(const IPAddress& address) const;
   std::string FindNameByAddress(const IPAddress& address) const;
 
+  // Entries of the resolution ring, up to its capacity.
+  size_t num_resolutions() const { return resolutions_.size(); }
+
+  // Closes the socket once another process answers on it, keeping the
+  // resolutions for the connections still open.
+  void StopAnswering();
+
+  // Drops the cached upstream responses, as under memory pressure. The
+  // resolutions are kept, as clients still connect to their addresses.
+  void ReleaseCaches();
+
  private:
+  class MappingFileWriter;
+  class UpstreamQuery;
+
+  struct CachedResponse {
+    std::string response;
+    base::TimeTicks expiration;
+  };
+
   void DoRead();
   void OnRecv(int result);
+  void QueueResponse(scoped_refptr<IOBuffer> buffer,
+                     int size,
+                     const IPEndPoint& address);
+  void DoSend();
   void OnSend(int result);
   int HandleReadResult(int result);
 
+  // Answers from the cache or starts an upstream query. Returns false if
+  // the query cannot be forwarded now.
+  bool ForwardQuery(const DnsQuery& query, int size);
+  // Takes the result of `query` and deletes it.
+  void OnUpstreamQueryComplete(UpstreamQuery* query,
+                               int error,
+                               std::string response);
+
+  // Returns the ring index of the resolution of `name`, adding it if new.
+  size_t Resolve(const std::string& name);
+  // Gives entry `index` to `name`, clearing its previous entry.
+  void Assign(size_t index, const std::string& name, size_t name_hash);
+  // Returns the ring index that `address` was given for, if any.
+  std::optional<size_t> FindIndexByAddress(const IPAddress& address) const;
+  // Returns the position of `name` in name_index_, or the empty position
+  // where it would be inserted.
+  size_t FindNameSlot(std::string_view name, size_t name_hash) const;
+  void AddToNameIndex(size_t index);
+  void RemoveFromNameIndex(size_t index);
+  void GrowNameIndex();
+
+  std::string MappingFileHeader() const;
+  // Returns the contents of a mapping file with only the current
+  // resolutions, and counts them as its records.
+  std::string CompactedMappingFile();
+  // Rewrites the mapping file with only the current resolutions.
+  void CompactMappingFile();
+  void AppendMapping(size_t index);
+
   std::unique_ptr<DatagramServerSocket> socket_;
   IPAddress range_;
   size_t prefix_;
-  uint32_t offset_;
+  IPAddress range6_;
+  size_t prefix6_;
   scoped_refptr<IOBufferWithSize> buffer_;
   IPEndPoint recv_address_;
 
-  std::map<std::string, std::list<Resolution>::iterator> resolution_by_name_;
-  std::map<uint32_t, std::list<Resolution>::iterator> resolution_by_addr_;
-  std::list<Resolution> resolutions_;
+  struct PendingResponse {
+    scoped_refptr<IOBuffer> buffer;
+    int size;
+    IPEndPoint address;
+  };
+  // Responses are sent in order, one SendTo() at a time.
+  std::queue<PendingResponse> send_queue_;
+  bool send_pending_;
+  // Set while the queue is too full to read more queries.
+  bool read_paused_;
+  bool stopped_ = false;
+
+  // Grows up to `capacity_` and then wraps around at `next_`.
+  std::vector<Resolution> resolutions_;
+  size_t capacity_;
+  size_t next_;
+  size_t overwrites_since_log_;
+  base::TimeTicks last_overwrite_log_time_;
+
+  // Open addressing with linear probing. Holds ring indexes plus one, with
+  // zero for empty positions. Its size is a power of two.
+  std::vector<uint32_t> name_index_;
+
+  GURL upstream_url_;
+  raw_ptr<URLRequestContext> upstream_context_;
+  std::optional<NetworkTrafficAnnotationTag> upstream_traffic_annotation_;
+  std::set<std::unique_ptr<UpstreamQuery>, base::UniquePtrComparator>
+      upstream_queries_;
+  // Keyed by the lowercase query name and the query type. Responses keep
+  // the query ID they were received with.
+  base::LRUCache<std::string, CachedResponse> response_cache_;
+
+  // Null if the resolutions are not saved.
+  base::SequenceBound<MappingFileWriter> mapping_writer_;
+  // Records in the mapping file, including overwritten ones.
+  size_t mapping_records_;
 
   base::WeakPtrFactory<RedirectResolver> weak_ptr_factory_{this};
 };
@@ -9,7 +9,9 @@
 
 #include "net/tools/naive/socks5_server_socket.h"
 
+#include <algorithm>
 #include <cstring>
+#include <string_view>
 #include <utility>
 
 #include "base/functional/bind.h"
@@ -21,6 +23,7 @@
 #include "net/base/sys_addrinfo.h"
 #include "net/log/net_log.h"
 #include "net/log/net_log_event_type.h"
+#include "net/socket/udp_server_socket.h"
 
 namespace net {
 
@@ -33,6 +36,15 @@ enum SocksCommandType {
 static constexpr unsigned int kGreetReadHeaderSize = 2;
 static constexpr unsigned int kAuthReadHeaderSize = 2;
 static constexpr unsigned int kReadHeaderSize = 5;
+// Messages with every length field at its maximum.
+static constexpr size_t kMaxGreetSize = kGreetReadHeaderSize + 255;
+static constexpr size_t kMaxAuthSize = kAuthReadHeaderSize + 255 + 1 + 255;
+static constexpr size_t kMaxRequestSize =
+    kReadHeaderSize + 255 + sizeof(uint16_t);
+static constexpr size_t kMaxInputSize =
+    kMaxGreetSize + kMaxAuthSize + kMaxRequestSize;
+// Greeting, auth, and request replies, the last with an IPv6 address.
+static constexpr size_t kMaxRepliesSize = 2 + 2 + 4 + 16 + sizeof(uint16_t);
 static constexpr char kSOCKS5Version = '\x05';
 static constexpr char kSOCKS5Reserved = '\x00';
 static constexpr char kAuthMethodNone = '\x00';
@@ -42,6 +54,7 @@ static constexpr char kSubnegotiationVersion = '\x01';
 static constexpr char kAuthStatusSuccess = '\x00';
 static constexpr char kAuthStatusFailure = '\xff';
 static constexpr char kReplySuccess = '\x00';
+static constexpr char kReplyGeneralFailure = '\x01';
 static constexpr char kReplyCommandNotSupported = '\x07';
 
 static_assert(sizeof(struct in_addr) == 4, "incorrect system size of IPv4");
@@ -49,18 +62,24 @@ static_assert(sizeof(struct in6_addr) == 16, "incorrect system size of IPv6");
 
 Socks5ServerSocket::Socks5ServerSocket(
     std::unique_ptr<StreamSocket> transport_socket,
-    const std::string& user,
-    const std::string& pass,
+    scoped_refptr<const NaiveUserTable> users,
+    bool allow_udp_associate,
     const NetworkTrafficAnnotationTag& traffic_annotation)
     : io_callback_(base::BindRepeating(&Socks5ServerSocket::OnIOComplete,
                                        base::Unretained(this))),
       transport_(std::move(transport_socket)),
       next_state_(STATE_NONE),
-      completed_handshake_(false),
+      stage_(kStageGreet),
+      write_size_(0),
       bytes_sent_(0),
+      read_start_(0),
+      read_end_(0),
+      handshake_error_(OK),
+      completed_handshake_(false),
       was_ever_used_(false),
-      user_(user),
-      pass_(pass),
+      users_(std::move(users)),
+      allow_udp_associate_(allow_udp_associate),
+      udp_associate_(false),
       net_log_(transport_->NetLog()),
       traffic_annotation_(traffic_annotation) {}
 
@@ -72,6 +91,10 @@ const HostPortPair& Socks5ServerSocket::request_endpoint() const {
   return request_endpoint_;
 }
 
+std::unique_ptr<DatagramServerSocket> Socks5ServerSocket::TakeUdpSocket() {
+  return std::move(udp_socket_);
+}
+
 int Socks5ServerSocket::Connect(CompletionOnceCallback callback) {
   DCHECK(transport_);
   DCHECK_EQ(STATE_NONE, next_state_);
@@ -83,8 +106,15 @@ int Socks5ServerSocket::Connect(CompletionOnceCallback callback) {
 
   net_log_.BeginEvent(NetLogEventType::SOCKS5_CONNECT);
 
-  next_state_ = STATE_GREET_READ;
-  buffer_.clear();
+  next_state_ = STATE_HANDSHAKE_READ;
+  handshake_buf_ = base::MakeRefCounted<GrowableIOBuffer>();
+  handshake_buf_->SetCapacity(kMaxRepliesSize + kMaxInputSize);
+  stage_ = kStageGreet;
+  write_size_ = 0;
+  bytes_sent_ = 0;
+  read_start_ = 0;
+  read_end_ = 0;
+  handshake_error_ = OK;
 
   int rv = DoLoop(OK);
   if (rv == ERR_IO_PENDING) {
@@ -103,6 +133,13 @@ void Socks5ServerSocket::Disconnect() {
   // These are the states initialized by Connect().
   next_state_ = STATE_NONE;
   user_callback_.Reset();
+  handshake_buf_ = nullptr;
+  read_start_ = 0;
+  read_end_ = 0;
+}
+
+int Socks5ServerSocket::ShutdownWrite() {
+  return transport_->ShutdownWrite();
 }
 
 bool Socks5ServerSocket::IsConnected() const {
@@ -155,6 +192,19 @@ int Socks5ServerSocket::Read(IOBuffer* buf,
   DCHECK(!user_callback_);
   DCHECK(callback);
 
+  if (has_buffered_data()) {
+    was_ever_used_ = true;
+    size_t data_len =
+        std::min(static_cast<size_t>(buf_len), read_end_ - read_start_);
+    std::memcpy(buf->data(),
+                handshake_buf_->StartOfBuffer() + kMaxRepliesSize + read_start_,
+                data_len);
+    read_start_ += data_len;
+    if (read_start_ == read_end_)
+      handshake_buf_ = nullptr;
+    return data_len;
+  }
+
   int rv = transport_->Read(
       buf, buf_len,
       base::BindOnce(&Socks5ServerSocket::OnReadWriteComplete,
@@ -164,6 +214,28 @@ int Socks5ServerSocket::Read(IOBuffer* buf,
   return rv;
 }
 
+int Socks5ServerSocket::ReadIfReady(IOBuffer* buf,
+                                   int buf_len,
+                                   CompletionOnceCallback callback) {
+  DCHECK(completed_handshake_);
+  DCHECK_EQ(STATE_NONE, next_state_);
+  DCHECK(!user_callback_);
+  DCHECK(callback);
+
+  // Data left over from the handshake read is always ready.
+  if (has_buffered_data())
+    return Read(buf, buf_len, std::move(callback));
+
+  int rv = transport_->ReadIfReady(buf, buf_len, std::move(callback));
+  if (rv > 0)
+    was_ever_used_ = true;
+  return rv;
+}
+
+int Socks5ServerSocket::CancelReadIfReady() {
+  return transport_->CancelReadIfReady();
+}
+
 // Write is called by the transport layer. This can only be done if the
 // SOCKS handshake is complete.
 int Socks5ServerSocket::Write(
@@ -229,40 +301,6 @@ int Socks5ServerSocket::DoLoop(int last_io_result) {
     State state = next_state_;
     next_state_ = STATE_NONE;
     switch (state) {
-      case STATE_GREET_READ:
-        DCHECK_EQ(OK, rv);
-        net_log_.BeginEvent(NetLogEventType::SOCKS5_GREET_READ);
-        rv = DoGreetRead();
-        break;
-      case STATE_GREET_READ_COMPLETE:
-        rv = DoGreetReadComplete(rv);
-        net_log_.EndEventWithNetErrorCode(NetLogEventType::SOCKS5_GREET_READ,
-                                          rv);
-        break;
-      case STATE_GREET_WRITE:
-        DCHECK_EQ(OK, rv);
-        net_log_.BeginEvent(NetLogEventType::SOCKS5_GREET_WRITE);
-        rv = DoGreetWrite();
-        break;
-      case STATE_GREET_WRITE_COMPLETE:
-        rv = DoGreetWriteComplete(rv);
-        net_log_.EndEventWithNetErrorCode(NetLogEventType::SOCKS5_GREET_WRITE,
-                                          rv);
-        break;
-      case STATE_AUTH_READ:
-        DCHECK_EQ(OK, rv);
-        rv = DoAuthRead();
-        break;
-      case STATE_AUTH_READ_COMPLETE:
-        rv = DoAuthReadComplete(rv);
-        break;
-      case STATE_AUTH_WRITE:
-        DCHECK_EQ(OK, rv);
-        rv = DoAuthWrite();
-        break;
-      case STATE_AUTH_WRITE_COMPLETE:
-        rv = DoAuthWriteComplete(rv);
-        break;
       case STATE_HANDSHAKE_READ:
         DCHECK_EQ(OK, rv);
         net_log_.BeginEvent(NetLogEventType::SOCKS5_HANDSHAKE_READ);
@@ -292,365 +330,331 @@ int Socks5ServerSocket::DoLoop(int last_io_result) {
   return rv;
 }
 
-int Socks5ServerSocket::DoGreetRead() {
-  next_state_ = STATE_GREET_READ_COMPLETE;
-
-  if (buffer_.empty()) {
-    read_header_size_ = kGreetReadHeaderSize;
-  }
+int Socks5ServerSocket::DoHandshakeRead() {
+  next_state_ = STATE_HANDSHAKE_READ_COMPLETE;
 
-  int handshake_buf_len = read_header_size_ - buffer_.size();
-  DCHECK_LT(0, handshake_buf_len);
-  handshake_buf_ = base::MakeRefCounted<IOBufferWithSize>(handshake_buf_len);
-  return transport_->Read(handshake_buf_.get(), handshake_buf_len,
+  // Input before the end of the request always fits, so the read region
+  // only runs out after the handshake.
+  DCHECK_LT(read_end_, kMaxInputSize);
+  handshake_buf_->set_offset(kMaxRepliesSize + read_end_);
+  return transport_->Read(handshake_buf_.get(), kMaxInputSize - read_end_,
                           io_callback_);
 }
 
-int Socks5ServerSocket::DoGreetReadComplete(int result) {
+int Socks5ServerSocket::DoHandshakeReadComplete(int result) {
   if (result < 0)
     return result;
 
+  // The underlying socket closed unexpectedly.
   if (result == 0) {
-    net_log_.AddEvent(
-        NetLogEventType::SOCKS_UNEXPECTEDLY_CLOSED_DURING_GREETING);
-    return ERR_SOCKS_CONNECTION_FAILED;
-  }
-
-  buffer_.append(handshake_buf_->data(), result);
-
-  // When the first few bytes are read, check how many more are required
-  // and accordingly increase them
-  if (buffer_.size() == kGreetReadHeaderSize) {
-    if (buffer_[0] != kSOCKS5Version) {
-      net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_UNEXPECTED_VERSION,
-                                     "version", buffer_[0]);
-      return ERR_SOCKS_CONNECTION_FAILED;
-    }
-    int nmethods = buffer_[1];
-    if (nmethods == 0) {
-      net_log_.AddEvent(NetLogEventType::SOCKS_NO_REQUESTED_AUTH);
-      return ERR_SOCKS_CONNECTION_FAILED;
-    }
-
-    read_header_size_ += nmethods;
-    next_state_ = STATE_GREET_READ;
-    return OK;
-  }
-
-  if (buffer_.size() == read_header_size_) {
-    int nmethods = buffer_[1];
-    char expected_method = kAuthMethodNone;
-    if (!user_.empty() || !pass_.empty()) {
-      expected_method = kAuthMethodUserPass;
-    }
-    void* match =
-        std::memchr(&buffer_[kGreetReadHeaderSize], expected_method, nmethods);
-    if (match) {
-      auth_method_ = expected_method;
+    if (stage_ == kStageGreet) {
+      net_log_.AddEvent(
+          NetLogEventType::SOCKS_UNEXPECTEDLY_CLOSED_DURING_GREETING);
     } else {
-      auth_method_ = kAuthMethodNoAcceptable;
+      net_log_.AddEvent(
+          NetLogEventType::SOCKS_UNEXPECTEDLY_CLOSED_DURING_HANDSHAKE);
     }
-    buffer_.clear();
-    next_state_ = STATE_GREET_WRITE;
-    return OK;
-  }
-
-  next_state_ = STATE_GREET_READ;
-  return OK;
-}
-
-int Socks5ServerSocket::DoGreetWrite() {
-  if (buffer_.empty()) {
-    const char write_data[] = {kSOCKS5Version, auth_method_};
-    buffer_ = std::string(write_data, std::size(write_data));
-    bytes_sent_ = 0;
+    return ERR_SOCKS_CONNECTION_FAILED;
   }
 
-  next_state_ = STATE_GREET_WRITE_COMPLETE;
-  int handshake_buf_len = buffer_.size() - bytes_sent_;
-  DCHECK_LT(0, handshake_buf_len);
-  handshake_buf_ = base::MakeRefCounted<IOBufferWithSize>(handshake_buf_len);
-  std::memcpy(handshake_buf_->data(), &buffer_.data()[bytes_sent_],
-              handshake_buf_len);
-  return transport_->Write(handshake_buf_.get(), handshake_buf_len,
-                           io_callback_, traffic_annotation_);
-}
+  read_end_ += result;
+  int rv = ParseHandshake();
+  if (rv != OK)
+    return rv;
 
-int Socks5ServerSocket::DoGreetWriteComplete(int result) {
-  if (result < 0)
-    return result;
-
-  bytes_sent_ += result;
-  if (bytes_sent_ == buffer_.size()) {
-    buffer_.clear();
-    if (auth_method_ == kAuthMethodNone) {
-      next_state_ = STATE_HANDSHAKE_READ;
-    } else if (auth_method_ == kAuthMethodUserPass) {
-      next_state_ = STATE_AUTH_READ;
-    } else {
-      net_log_.AddEvent(NetLogEventType::SOCKS_NO_ACCEPTABLE_AUTH);
-      return ERR_SOCKS_CONNECTION_FAILED;
-    }
+  // Replies are flushed when the input runs out, as the client may wait for
+  // them before sending the next message.
+  if (write_size_ > 0) {
+    next_state_ = STATE_HANDSHAKE_WRITE;
   } else {
-    next_state_ = STATE_GREET_WRITE;
+    next_state_ = STATE_HANDSHAKE_READ;
   }
   return OK;
 }
 
-int Socks5ServerSocket::DoAuthRead() {
-  next_state_ = STATE_AUTH_READ_COMPLETE;
-
-  if (buffer_.empty()) {
-    read_header_size_ = kAuthReadHeaderSize;
-  }
+// Writes the queued SOCKS replies to the underlying socket connection.
+int Socks5ServerSocket::DoHandshakeWrite() {
+  next_state_ = STATE_HANDSHAKE_WRITE_COMPLETE;
 
-  int handshake_buf_len = read_header_size_ - buffer_.size();
-  DCHECK_LT(0, handshake_buf_len);
-  handshake_buf_ = base::MakeRefCounted<IOBufferWithSize>(handshake_buf_len);
-  return transport_->Read(handshake_buf_.get(), handshake_buf_len,
-                          io_callback_);
+  DCHECK_LT(bytes_sent_, write_size_);
+  handshake_buf_->set_offset(bytes_sent_);
+  return transport_->Write(handshake_buf_.get(), write_size_ - bytes_sent_,
+                           io_callback_, traffic_annotation_);
 }
 
-int Socks5ServerSocket::DoAuthReadComplete(int result) {
+int Socks5ServerSocket::DoHandshakeWriteComplete(int result) {
   if (result < 0)
     return result;
 
-  if (result == 0) {
-    return ERR_SOCKS_CONNECTION_FAILED;
-  }
-
-  buffer_.append(handshake_buf_->data(), result);
+  // We ignore the case when result is 0, since the underlying Write
+  // may return spurious writes while waiting on the socket.
 
-  // When the first few bytes are read, check how many more are required
-  // and accordingly increase them
-  if (buffer_.size() == kAuthReadHeaderSize) {
-    if (buffer_[0] != kSubnegotiationVersion) {
-      net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_UNEXPECTED_VERSION,
-                                     "version", buffer_[0]);
-      return ERR_SOCKS_CONNECTION_FAILED;
-    }
-    int username_len = buffer_[1];
-    read_header_size_ += username_len + 1;
-    next_state_ = STATE_AUTH_READ;
+  bytes_sent_ += result;
+  if (bytes_sent_ < write_size_) {
+    next_state_ = STATE_HANDSHAKE_WRITE;
     return OK;
   }
+  write_size_ = 0;
+  bytes_sent_ = 0;
 
-  if (buffer_.size() == read_header_size_) {
-    int username_len = buffer_[1];
-    int password_len = buffer_[kAuthReadHeaderSize + username_len];
-    size_t password_offset = kAuthReadHeaderSize + username_len + 1;
-    if (buffer_.size() == password_offset && password_len != 0) {
-      read_header_size_ += password_len;
-      next_state_ = STATE_AUTH_READ;
-      return OK;
-    }
+  if (handshake_error_ != OK)
+    return handshake_error_;
 
-    if (buffer_.compare(kAuthReadHeaderSize, username_len, user_) == 0 &&
-        buffer_.compare(password_offset, password_len, pass_) == 0) {
-      auth_status_ = kAuthStatusSuccess;
-    } else {
-      auth_status_ = kAuthStatusFailure;
-    }
-    buffer_.clear();
-    next_state_ = STATE_AUTH_WRITE;
+  if (stage_ != kStageDone) {
+    next_state_ = STATE_HANDSHAKE_READ;
     return OK;
   }
 
-  next_state_ = STATE_AUTH_READ;
+  completed_handshake_ = true;
+  if (!has_buffered_data())
+    handshake_buf_ = nullptr;
   return OK;
 }
 
-int Socks5ServerSocket::DoAuthWrite() {
-  if (buffer_.empty()) {
-    const char write_data[] = {kSubnegotiationVersion, auth_status_};
-    buffer_ = std::string(write_data, std::size(write_data));
-    bytes_sent_ = 0;
-  }
-
-  next_state_ = STATE_AUTH_WRITE_COMPLETE;
-  int handshake_buf_len = buffer_.size() - bytes_sent_;
-  DCHECK_LT(0, handshake_buf_len);
-  handshake_buf_ = base::MakeRefCounted<IOBufferWithSize>(handshake_buf_len);
-  std::memcpy(handshake_buf_->data(), &buffer_.data()[bytes_sent_],
-              handshake_buf_len);
-  return transport_->Write(handshake_buf_.get(), handshake_buf_len,
-                           io_callback_, traffic_annotation_);
-}
-
-int Socks5ServerSocket::DoAuthWriteComplete(int result) {
-  if (result < 0)
-    return result;
-
-  bytes_sent_ += result;
-  if (bytes_sent_ == buffer_.size()) {
-    buffer_.clear();
-    if (auth_status_ == kAuthStatusSuccess) {
-      next_state_ = STATE_HANDSHAKE_READ;
-    } else {
-      return ERR_SOCKS_CONNECTION_FAILED;
+int Socks5ServerSocket::ParseHandshake() {
+  while (stage_ != kStageDone && handshake_error_ == OK) {
+    const char* data =
+        handshake_buf_->StartOfBuffer() + kMaxRepliesSize + read_start_;
+    size_t size = read_end_ - read_start_;
+    int rv;
+    switch (stage_) {
+      case kStageGreet:
+        rv = ParseGreet(data, size);
+        break;
+      case kStageAuth:
+        rv = ParseAuth(data, size);
+        break;
+      case kStageRequest:
+        rv = ParseRequest(data, size);
+        break;
+      default:
+        NOTREACHED() << "bad stage";
+        rv = ERR_UNEXPECTED;
+        break;
     }
-  } else {
-    next_state_ = STATE_AUTH_WRITE;
+    if (rv < 0)
+      return rv;
+    if (rv == 0)
+      break;
+    read_start_ += rv;
   }
   return OK;
 }
 
-int Socks5ServerSocket::DoHandshakeRead() {
-  next_state_ = STATE_HANDSHAKE_READ_COMPLETE;
+int Socks5ServerSocket::ParseGreet(const char* data, size_t size) {
+  if (size < kGreetReadHeaderSize)
+    return 0;
 
-  if (buffer_.empty()) {
-    read_header_size_ = kReadHeaderSize;
+  if (data[0] != kSOCKS5Version) {
+    net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_UNEXPECTED_VERSION,
+                                   "version", data[0]);
+    return ERR_SOCKS_CONNECTION_FAILED;
   }
-
-  int handshake_buf_len = read_header_size_ - buffer_.size();
-  DCHECK_LT(0, handshake_buf_len);
-  handshake_buf_ = base::MakeRefCounted<IOBufferWithSize>(handshake_buf_len);
-  return transport_->Read(handshake_buf_.get(), handshake_buf_len,
-                          io_callback_);
-}
-
-int Socks5ServerSocket::DoHandshakeReadComplete(int result) {
-  if (result < 0)
-    return result;
-
-  // The underlying socket closed unexpectedly.
-  if (result == 0) {
-    net_log_.AddEvent(
-        NetLogEventType::SOCKS_UNEXPECTEDLY_CLOSED_DURING_HANDSHAKE);
+  size_t nmethods = static_cast<uint8_t>(data[1]);
+  if (nmethods == 0) {
+    net_log_.AddEvent(NetLogEventType::SOCKS_NO_REQUESTED_AUTH);
     return ERR_SOCKS_CONNECTION_FAILED;
   }
+  size_t greet_size = kGreetReadHeaderSize + nmethods;
+  if (size < greet_size)
+    return 0;
 
-  buffer_.append(handshake_buf_->data(), result);
-
-  // When the first few bytes are read, check how many more are required
-  // and accordingly increase them
-  if (buffer_.size() == kReadHeaderSize) {
-    if (buffer_[0] != kSOCKS5Version || buffer_[2] != kSOCKS5Reserved) {
-      net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_UNEXPECTED_VERSION,
-                                     "version", buffer_[0]);
-      return ERR_SOCKS_CONNECTION_FAILED;
-    }
-    SocksCommandType command = static_cast<SocksCommandType>(buffer_[1]);
-    if (command == kCommandConnect) {
-      // The proxy replies with success immediately without first connecting
-      // to the requested endpoint.
-      reply_ = kReplySuccess;
-    } else if (command == kCommandBind || command == kCommandUDPAssociate) {
-      reply_ = kReplyCommandNotSupported;
-    } else {
-      net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_UNEXPECTED_COMMAND,
-                                     "commmand", buffer_[1]);
-      return ERR_SOCKS_CONNECTION_FAILED;
-    }
-
-    // We check the type of IP/Domain the server returns and accordingly
-    // increase the size of the request. For domains, we need to read the
-    // size of the domain, so the initial request size is upto the domain
-    // size. Since for IPv4/IPv6 the size is fixed and hence no 'size' is
-    // read, we substract 1 byte from the additional request size.
-    address_type_ = static_cast<SocksEndPointAddressType>(buffer_[3]);
-    if (address_type_ == kEndPointDomain) {
-      address_size_ = static_cast<uint8_t>(buffer_[4]);
-      if (address_size_ == 0) {
-        net_log_.AddEvent(NetLogEventType::SOCKS_ZERO_LENGTH_DOMAIN);
-        return ERR_SOCKS_CONNECTION_FAILED;
-      }
-    } else if (address_type_ == kEndPointResolvedIPv4) {
-      address_size_ = sizeof(struct in_addr);
-      --read_header_size_;
-    } else if (address_type_ == kEndPointResolvedIPv6) {
-      address_size_ = sizeof(struct in6_addr);
-      --read_header_size_;
-    } else {
-      // Aborts connection on unspecified address type.
-      net_log_.AddEventWithIntParams(
-          NetLogEventType::SOCKS_UNKNOWN_ADDRESS_TYPE, "address_type",
-          buffer_[3]);
-      return ERR_SOCKS_CONNECTION_FAILED;
-    }
-
-    read_header_size_ += address_size_ + sizeof(uint16_t);
-    next_state_ = STATE_HANDSHAKE_READ;
-    return OK;
+  char expected_method = kAuthMethodNone;
+  if (RequiresAuth(users_.get())) {
+    expected_method = kAuthMethodUserPass;
   }
-
-  // When the final bytes are read, setup handshake.
-  if (buffer_.size() == read_header_size_) {
-    size_t port_start = read_header_size_ - sizeof(uint16_t);
-    uint16_t port_net;
-    std::memcpy(&port_net, &buffer_[port_start], sizeof(uint16_t));
-    uint16_t port_host = base::NetToHost16(port_net);
-
-    size_t address_start = port_start - address_size_;
-    if (address_type_ == kEndPointDomain) {
-      std::string domain(&buffer_[address_start], address_size_);
-      request_endpoint_ = HostPortPair(domain, port_host);
-    } else {
-      IPAddress ip_addr(base::span<const uint8_t>{
-          reinterpret_cast<const uint8_t*>(&buffer_[address_start]),
-          static_cast<size_t>(address_size_)});
-      IPEndPoint endpoint(ip_addr, port_host);
-      request_endpoint_ = HostPortPair::FromIPEndPoint(endpoint);
-    }
-    buffer_.clear();
-    next_state_ = STATE_HANDSHAKE_WRITE;
-    return OK;
+  char auth_method = kAuthMethodNoAcceptable;
+  if (std::memchr(&data[kGreetReadHeaderSize], expected_method, nmethods)) {
+    auth_method = expected_method;
   }
 
-  next_state_ = STATE_HANDSHAKE_READ;
-  return OK;
+  const char reply[] = {kSOCKS5Version, auth_method};
+  QueueReply(reply, std::size(reply));
+  if (auth_method == kAuthMethodNone) {
+    stage_ = kStageRequest;
+  } else if (auth_method == kAuthMethodUserPass) {
+    stage_ = kStageAuth;
+  } else {
+    net_log_.AddEvent(NetLogEventType::SOCKS_NO_ACCEPTABLE_AUTH);
+    handshake_error_ = ERR_SOCKS_CONNECTION_FAILED;
+  }
+  return greet_size;
 }
 
-// Writes the SOCKS handshake data to the underlying socket connection.
-int Socks5ServerSocket::DoHandshakeWrite() {
-  next_state_ = STATE_HANDSHAKE_WRITE_COMPLETE;
+int Socks5ServerSocket::ParseAuth(const char* data, size_t size) {
+  if (size < kAuthReadHeaderSize)
+    return 0;
 
-  if (buffer_.empty()) {
-    const char write_data[] = {
-        // clang-format off
-        kSOCKS5Version,
-        reply_,
-        kSOCKS5Reserved,
-        kEndPointResolvedIPv4,
-        0x00, 0x00, 0x00, 0x00,  // BND.ADDR
-        0x00, 0x00,  // BND.PORT
-        // clang-format on
-    };
-    buffer_ = std::string(write_data, std::size(write_data));
-    bytes_sent_ = 0;
+  if (data[0] != kSubnegotiationVersion) {
+    net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_UNEXPECTED_VERSION,
+                                   "version", data[0]);
+    return ERR_SOCKS_CONNECTION_FAILED;
+  }
+  size_t username_len = static_cast<uint8_t>(data[1]);
+  size_t password_offset = kAuthReadHeaderSize + username_len + 1;
+  if (size < password_offset)
+    return 0;
+  size_t password_len = static_cast<uint8_t>(data[password_offset - 1]);
+  size_t auth_size = password_offset + password_len;
+  if (size < auth_size)
+    return 0;
+
+  std::string_view username(&data[kAuthReadHeaderSize], username_len);
+  std::string_view password(&data[password_offset], password_len);
+  char auth_status = kAuthStatusFailure;
+  if (const std::string* user = users_->FindByPassword(username, password)) {
+    user_ = *user;
+    auth_status = kAuthStatusSuccess;
   }
 
-  int handshake_buf_len = buffer_.size() - bytes_sent_;
-  DCHECK_LT(0, handshake_buf_len);
-  handshake_buf_ = base::MakeRefCounted<IOBufferWithSize>(handshake_buf_len);
-  std::memcpy(handshake_buf_->data(), &buffer_[bytes_sent_], handshake_buf_len);
-  return transport_->Write(handshake_buf_.get(), handshake_buf_len,
-                           io_callback_, traffic_annotation_);
+  const char reply[] = {kSubnegotiationVersion, auth_status};
+  QueueReply(reply, std::size(reply));
+  if (auth_status == kAuthStatusSuccess) {
+    stage_ = kStageRequest;
+  } else {
+    handshake_error_ = ERR_SOCKS_CONNECTION_FAILED;
+  }
+  return auth_size;
 }
 
-int Socks5ServerSocket::DoHandshakeWriteComplete(int result) {
-  if (result < 0)
-    return result;
+int Socks5ServerSocket::ParseRequest(const char* data, size_t size) {
+  if (size < kReadHeaderSize)
+    return 0;
 
-  // We ignore the case when result is 0, since the underlying Write
-  // may return spurious writes while waiting on the socket.
+  if (data[0] != kSOCKS5Version || data[2] != kSOCKS5Reserved) {
+    net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_UNEXPECTED_VERSION,
+                                   "version", data[0]);
+    return ERR_SOCKS_CONNECTION_FAILED;
+  }
+  SocksCommandType command = static_cast<SocksCommandType>(data[1]);
+  char reply_code;
+  if (command == kCommandConnect) {
+    // The proxy replies with success immediately without first connecting
+    // to the requested endpoint.
+    reply_code = kReplySuccess;
+  } else if (command == kCommandUDPAssociate && allow_udp_associate_) {
+    // The relay socket is bound once the request is read.
+    reply_code = kReplySuccess;
+  } else if (command == kCommandBind || command == kCommandUDPAssociate) {
+    reply_code = kReplyCommandNotSupported;
+  } else {
+    net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_UNEXPECTED_COMMAND,
+                                   "commmand", data[1]);
+    return ERR_SOCKS_CONNECTION_FAILED;
+  }
 
-  bytes_sent_ += result;
-  if (bytes_sent_ == buffer_.size()) {
-    buffer_.clear();
-    if (reply_ == kReplySuccess) {
-      completed_handshake_ = true;
-      next_state_ = STATE_NONE;
-    } else {
-      net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_SERVER_ERROR,
-                                     "error_code", reply_);
+  // For domains, the size of the domain is the last byte of the header.
+  // Since for IPv4/IPv6 the size is fixed and hence no 'size' is read, the
+  // address starts one byte earlier.
+  SocksEndPointAddressType address_type =
+      static_cast<SocksEndPointAddressType>(data[3]);
+  size_t address_start = kReadHeaderSize - 1;
+  size_t address_size;
+  if (address_type == kEndPointDomain) {
+    address_size = static_cast<uint8_t>(data[4]);
+    if (address_size == 0) {
+      net_log_.AddEvent(NetLogEventType::SOCKS_ZERO_LENGTH_DOMAIN);
       return ERR_SOCKS_CONNECTION_FAILED;
     }
+    address_start = kReadHeaderSize;
+  } else if (address_type == kEndPointResolvedIPv4) {
+    address_size = sizeof(struct in_addr);
+  } else if (address_type == kEndPointResolvedIPv6) {
+    address_size = sizeof(struct in6_addr);
   } else {
-    next_state_ = STATE_HANDSHAKE_WRITE;
+    // Aborts connection on unspecified address type.
+    net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_UNKNOWN_ADDRESS_TYPE,
+                                   "address_type", data[3]);
+    return ERR_SOCKS_CONNECTION_FAILED;
+  }
+  size_t port_start = address_start + address_size;
+  size_t request_size = port_start + sizeof(uint16_t);
+  if (size < request_size)
+    return 0;
+
+  uint16_t port_net;
+  std::memcpy(&port_net, &data[port_start], sizeof(uint16_t));
+  uint16_t port_host = base::NetToHost16(port_net);
+
+  if (address_type == kEndPointDomain) {
+    std::string domain(&data[address_start], address_size);
+    request_endpoint_ = HostPortPair(domain, port_host);
+  } else {
+    IPAddress ip_addr(base::span<const uint8_t>{
+        reinterpret_cast<const uint8_t*>(&data[address_start]),
+        address_size});
+    IPEndPoint endpoint(ip_addr, port_host);
+    request_endpoint_ = HostPortPair::FromIPEndPoint(endpoint);
+  }
+  if (command == kCommandUDPAssociate && reply_code == kReplySuccess) {
+    udp_associate_ = true;
+    int rv = BindUdpSocket();
+    if (rv != OK) {
+      LOG(WARNING) << "Cannot bind UDP relay socket: "
+                   << ErrorToShortString(rv);
+      udp_socket_ = nullptr;
+      reply_code = kReplyGeneralFailure;
+    }
   }
 
-  return OK;
+  // BND.ADDR is all zeros unless a UDP relay socket is bound.
+  char reply[4 + sizeof(struct in6_addr) + sizeof(uint16_t)] = {
+      kSOCKS5Version,
+      reply_code,
+      kSOCKS5Reserved,
+  };
+  size_t reply_size = 4;
+  const IPAddress& address = bound_endpoint_.address();
+  if (address.IsIPv6()) {
+    reply[3] = kEndPointResolvedIPv6;
+    std::memcpy(&reply[reply_size], address.bytes().data(),
+                sizeof(struct in6_addr));
+    reply_size += sizeof(struct in6_addr);
+  } else {
+    reply[3] = kEndPointResolvedIPv4;
+    if (address.IsIPv4()) {
+      std::memcpy(&reply[reply_size], address.bytes().data(),
+                  sizeof(struct in_addr));
+    }
+    reply_size += sizeof(struct in_addr);
+  }
+  port_net = base::HostToNet16(bound_endpoint_.port());
+  std::memcpy(&reply[reply_size], &port_net, sizeof(port_net));
+  reply_size += sizeof(port_net);
+  QueueReply(reply, reply_size);
+
+  if (reply_code == kReplySuccess) {
+    stage_ = kStageDone;
+  } else {
+    net_log_.AddEventWithIntParams(NetLogEventType::SOCKS_SERVER_ERROR,
+                                   "error_code", reply_code);
+    handshake_error_ = ERR_SOCKS_CONNECTION_FAILED;
+  }
+  return request_size;
+}
+
+void Socks5ServerSocket::QueueReply(const char* data, size_t size) {
+  DCHECK_LE(write_size_ + size, kMaxRepliesSize);
+  std::memcpy(handshake_buf_->StartOfBuffer() + write_size_, data, size);
+  write_size_ += size;
+}
+
+int Socks5ServerSocket::BindUdpSocket() {
+  IPEndPoint local_endpoint;
+  int rv = transport_->GetLocalAddress(&local_endpoint);
+  if (rv != OK)
+    return rv;
+  // Answers IPv4 clients of dual-stack listeners with IPv4 addresses.
+  IPAddress address = local_endpoint.address();
+  if (address.IsIPv4MappedIPv6())
+    address = ConvertIPv4MappedIPv6ToIPv4(address);
+
+  udp_socket_ = std::make_unique<UDPServerSocket>(net_log_.net_log(),
+                                                  net_log_.source());
+  rv = udp_socket_->Listen(IPEndPoint(address, 0));
+  if (rv != OK)
+    return rv;
+  return udp_socket_->GetLocalAddress(&bound_endpoint_);
 }
 
 int Socks5ServerSocket::GetPeerAddress(IPEndPoint* address) const {
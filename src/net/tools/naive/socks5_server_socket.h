@@ -22,17 +22,22 @@
 #include "net/socket/next_proto.h"
 #include "net/socket/stream_socket.h"
 #include "net/ssl/ssl_info.h"
+#include "net/tools/naive/naive_user_table.h"
 
 namespace net {
+class DatagramServerSocket;
 struct NetworkTrafficAnnotationTag;
 
 // This StreamSocket is used to setup a SOCKSv5 handshake with a socks client.
 // Currently no SOCKSv5 authentication is supported.
 class Socks5ServerSocket : public StreamSocket {
  public:
+  // If `allow_udp_associate`, UDP ASSOCIATE requests are accepted with a UDP
+  // socket bound on the local address of `transport_socket`.
+  // `users` is null if the listener takes no authentication.
   Socks5ServerSocket(std::unique_ptr<StreamSocket> transport_socket,
-                     const std::string& user,
-                     const std::string& pass,
+                     scoped_refptr<const NaiveUserTable> users,
+                     bool allow_udp_associate,
                      const NetworkTrafficAnnotationTag& traffic_annotation);
 
   // On destruction Disconnect() is called.
@@ -43,11 +48,29 @@ class Socks5ServerSocket : public StreamSocket {
 
   const HostPortPair& request_endpoint() const;
 
+  // The user the client authenticated as, or empty.
+  const std::string& user() const { return user_; }
+
+  // Returns true if the handshake accepted a UDP ASSOCIATE request. The
+  // connection then only controls the lifetime of the association.
+  bool is_udp_associate() const { return udp_associate_; }
+
+  // Returns the UDP socket of the association once.
+  std::unique_ptr<DatagramServerSocket> TakeUdpSocket();
+
+  const StreamSocket* transport_socket() const { return transport_.get(); }
+
+  // Returns true if bytes after the request were read with it.
+  bool has_buffered_data() const {
+    return completed_handshake_ && read_start_ < read_end_;
+  }
+
   // StreamSocket implementation.
 
   // Does the SOCKS handshake and completes the protocol.
   int Connect(CompletionOnceCallback callback) override;
   void Disconnect() override;
+  int ShutdownWrite() override;
   bool IsConnected() const override;
   bool IsConnectedAndIdle() const override;
   const NetLogWithSource& NetLog() const override;
@@ -61,6 +84,10 @@ class Socks5ServerSocket : public StreamSocket {
   int Read(IOBuffer* buf,
            int buf_len,
            CompletionOnceCallback callback) override;
+  int ReadIfReady(IOBuffer* buf,
+                  int buf_len,
+                  CompletionOnceCallback callback) override;
+  int CancelReadIfReady() override;
   int Write(IOBuffer* buf,
             int buf_len,
             CompletionOnceCallback callback,
@@ -74,21 +101,21 @@ class Socks5ServerSocket : public StreamSocket {
 
  private:
   enum State {
-    STATE_GREET_READ,
-    STATE_GREET_READ_COMPLETE,
-    STATE_GREET_WRITE,
-    STATE_GREET_WRITE_COMPLETE,
-    STATE_AUTH_READ,
-    STATE_AUTH_READ_COMPLETE,
-    STATE_AUTH_WRITE,
-    STATE_AUTH_WRITE_COMPLETE,
-    STATE_HANDSHAKE_WRITE,
-    STATE_HANDSHAKE_WRITE_COMPLETE,
     STATE_HANDSHAKE_READ,
     STATE_HANDSHAKE_READ_COMPLETE,
+    STATE_HANDSHAKE_WRITE,
+    STATE_HANDSHAKE_WRITE_COMPLETE,
     STATE_NONE,
   };
 
+  // The next message expected from the client.
+  enum Stage {
+    kStageGreet,
+    kStageAuth,
+    kStageRequest,
+    kStageDone,
+  };
+
   // Addressing type that can be specified in requests or responses.
   enum SocksEndPointAddressType {
     kEndPointDomain = 0x03,
@@ -101,18 +128,19 @@ class Socks5ServerSocket : public StreamSocket {
   void OnReadWriteComplete(CompletionOnceCallback callback, int result);
 
   int DoLoop(int last_io_result);
-  int DoGreetRead();
-  int DoGreetReadComplete(int result);
-  int DoGreetWrite();
-  int DoGreetWriteComplete(int result);
-  int DoAuthRead();
-  int DoAuthReadComplete(int result);
-  int DoAuthWrite();
-  int DoAuthWriteComplete(int result);
   int DoHandshakeRead();
   int DoHandshakeReadComplete(int result);
   int DoHandshakeWrite();
   int DoHandshakeWriteComplete(int result);
+  // Parses all complete messages read so far and queues their replies.
+  int ParseHandshake();
+  // These return the size of the message parsed, 0 if it is incomplete, or
+  // a net error.
+  int ParseGreet(const char* data, size_t size);
+  int ParseAuth(const char* data, size_t size);
+  int ParseRequest(const char* data, size_t size);
+  void QueueReply(const char* data, size_t size);
+  int BindUdpSocket();
 
   CompletionRepeatingCallback io_callback_;
 
@@ -124,37 +152,41 @@ class Socks5ServerSocket : public StreamSocket {
   // Stores the callback to the layer above, called on completing Connect().
   CompletionOnceCallback user_callback_;
 
-  // This IOBuffer is used by the class to read and write
-  // SOCKS handshake data. The length contains the expected size to
-  // read or write.
-  scoped_refptr<IOBuffer> handshake_buf_;
+  // Holds the whole handshake. Replies are queued at the front and the input
+  // is read behind them, so pipelined messages are parsed from one read and
+  // answered with one write. Input read past the request is kept for Read().
+  scoped_refptr<GrowableIOBuffer> handshake_buf_;
+
+  Stage stage_;
+
+  // Queued reply bytes, of which `bytes_sent_` are written.
+  size_t write_size_;
+  size_t bytes_sent_;
+
+  // Input bytes read, of which `read_start_` are parsed.
+  size_t read_start_;
+  size_t read_end_;
 
-  // While writing, this buffer stores the complete write handshake data.
-  // While reading, it stores the handshake information received so far.
-  std::string buffer_;
+  // Returned once the reply reporting it is written.
+  int handshake_error_;
 
   // This becomes true when the SOCKS handshake has completed and the
   // overlying connection is free to communicate.
   bool completed_handshake_;
 
-  // Contains the bytes sent by the SOCKS handshake.
-  size_t bytes_sent_;
-
-  size_t read_header_size_;
-
   bool was_ever_used_;
 
-  SocksEndPointAddressType address_type_;
-  int address_size_;
-
+  scoped_refptr<const NaiveUserTable> users_;
   std::string user_;
-  std::string pass_;
-  char auth_method_;
-  char auth_status_;
-  char reply_;
 
   HostPortPair request_endpoint_;
 
+  bool allow_udp_associate_;
+  bool udp_associate_;
+  std::unique_ptr<DatagramServerSocket> udp_socket_;
+  // Sent as BND.ADDR and BND.PORT in the reply.
+  IPEndPoint bound_endpoint_;
+
   NetLogWithSource net_log_;
 
   // Traffic annotation for socket control.
@@ -11,6 +11,7 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
@@ -37,6 +38,9 @@
 #include "third_party/boringssl/src/include/openssl/bio.h"
 #include "third_party/boringssl/src/include/openssl/err.h"
 #include "third_party/boringssl/src/include/openssl/pem.h"
+#include "third_party/boringssl/src/include/openssl/pool.h"
+#include "third_party/boringssl/src/pki/cert_errors.h"
+#include "third_party/boringssl/src/pki/parsed_certificate.h"
 #include "third_party/protobuf/src/google/protobuf/text_format.h"
 
 using chrome_root_store::RootStore;
@@ -157,6 +161,35 @@ std::string VersionFromString(std::string_view version_str) {
   return base::StrCat({"\"", version_str, "\""});
 }
 
+// Appends `bytes` as the initializer list of a uint8_t array.
+void AppendByteArray(std::string_view bytes, std::string* out) {
+  *out += "{";
+  // Convert each character to hex representation, escaped.
+  for (auto c : bytes) {
+    base::StringAppendF(out, "0x%02xu,", static_cast<uint8_t>(c));
+  }
+  *out += "}";
+}
+
+// Returns the normalized subject of `der`, as TrustStoreChrome looks up
+// issuers by, or std::nullopt if it does not parse.
+std::optional<std::string> GetNormalizedSubject(const std::string& der) {
+  bssl::ParseCertificateOptions options;
+  // As x509_util::DefaultParseCertificateOptions().
+  options.allow_invalid_serial_numbers = true;
+  bssl::CertErrors errors;
+  std::shared_ptr<const bssl::ParsedCertificate> parsed =
+      bssl::ParsedCertificate::Create(
+          bssl::UniquePtr<CRYPTO_BUFFER>(CRYPTO_BUFFER_new(
+              reinterpret_cast<const uint8_t*>(der.data()), der.size(),
+              nullptr)),
+          options, &errors);
+  if (!parsed) {
+    return std::nullopt;
+  }
+  return std::string(parsed->normalized_subject().AsStringView());
+}
+
 // Returns true if file was correctly written, false otherwise.
 bool WriteRootCppFile(const RootStore& root_store,
                       const base::FilePath cpp_path) {
@@ -175,16 +208,20 @@ bool WriteRootCppFile(const RootStore& root_store,
     std::string der = anchor.der();
 
     base::StringAppendF(&string_to_write,
-                        "constexpr uint8_t kChromeRootCert%d[] = {", i);
-
-    // Convert each character to hex representation, escaped.
-    for (auto c : der) {
-      base::StringAppendF(&string_to_write, "0x%02xu,",
-                          static_cast<uint8_t>(c));
+                        "constexpr uint8_t kChromeRootCert%d[] = ", i);
+    AppendByteArray(der, &string_to_write);
+    string_to_write += ";\n";
+
+    // Lets the certificate be looked up without parsing it.
+    std::optional<std::string> subject = GetNormalizedSubject(der);
+    if (!subject) {
+      LOG(ERROR) << "Error parsing trust anchor " << i;
+      return false;
     }
-
-    // End struct
-    string_to_write += "};\n";
+    base::StringAppendF(&string_to_write,
+                        "constexpr uint8_t kChromeRootSubject%d[] = ", i);
+    AppendByteArray(*subject, &string_to_write);
+    string_to_write += ";\n";
 
     if (anchor.constraints_size() > 0) {
       base::StringAppendF(&string_to_write,
@@ -235,6 +272,7 @@ bool WriteRootCppFile(const RootStore& root_store,
     } else {
       string_to_write += "{}";
     }
+    base::StringAppendF(&string_to_write, ", kChromeRootSubject%d", i);
     string_to_write += "},\n";
   }
   string_to_write += "};";
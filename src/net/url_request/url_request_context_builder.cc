@@ -522,6 +522,10 @@ std::unique_ptr<URLRequestContext> URLRequestContextBuilder::Build() {
       context.get(), &network_session_context,
       suppress_setting_socket_performance_watcher_factory_for_testing_,
       client_socket_factory_raw_);
+  if (socket_performance_watcher_factory_) {
+    network_session_context.socket_performance_watcher_factory =
+        socket_performance_watcher_factory_;
+  }
 
   context->set_http_network_session(std::make_unique<HttpNetworkSession>(
       http_network_session_params_, network_session_context));
@@ -58,6 +58,7 @@ class HttpServerProperties;
 class HostResolverManager;
 class NetworkQualityEstimator;
 class ProxyConfigService;
+class SocketPerformanceWatcherFactory;
 class URLRequestContext;
 
 #if BUILDFLAG(ENABLE_REPORTING)
@@ -163,6 +164,14 @@ class NET_EXPORT URLRequestContextBuilder {
     network_quality_estimator_ = network_quality_estimator;
   }
 
+  // Sets the factory of the watchers of the sockets of the context, in place
+  // of that of the NetworkQualityEstimator. Not owned, and must outlive the
+  // context.
+  void set_socket_performance_watcher_factory(
+      SocketPerformanceWatcherFactory* socket_performance_watcher_factory) {
+    socket_performance_watcher_factory_ = socket_performance_watcher_factory;
+  }
+
   // These functions are mutually exclusive.  The ProxyConfigService, if
   // set, will be used to construct a ConfiguredProxyResolutionService.
   void set_proxy_config_service(
@@ -414,6 +423,8 @@ class NET_EXPORT URLRequestContextBuilder {
   bool check_cleartext_permitted_ = false;
   bool require_network_anonymization_key_ = false;
   raw_ptr<NetworkQualityEstimator> network_quality_estimator_ = nullptr;
+  raw_ptr<SocketPerformanceWatcherFactory> socket_performance_watcher_factory_ =
+      nullptr;
 
   std::string accept_language_;
   std::string user_agent_;
@@ -0,0 +1,570 @@
+#!/usr/bin/env python3
+# Measures a naive client in front of a naive or Caddy server: bulk
+# throughput each way, requests per second over open tunnels, new tunnel
+# latency, and CPU time per relayed byte, for each listener and chain.
+#
+#   python3 bench.py --naive=out/Release/naive [--caddy=./caddy]
+#       [--netns] [--netem='delay 20ms loss 0.1%'] [--output=result.json]
+#       [--baseline=previous.json]
+#
+# The http chain uses a naive server. The https and quic chains need a
+# Caddy built with the naive fork of forwardproxy, and certutil to make the
+# client trust its certificate. --netns, --netem and the redir listener
+# need root.
+import argparse
+import atexit
+import json
+import os
+import shutil
+import socket
+import socketserver
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--naive')
+parser.add_argument('--caddy')
+parser.add_argument('--listeners', default='socks,http,redir')
+parser.add_argument('--chains', default='http,https,quic')
+parser.add_argument('--netns', action='store_true',
+                    help='run the client side in its own network namespace')
+parser.add_argument('--netem', help='tc netem parameters between the sides')
+parser.add_argument('--bulk_size', type=int, default=256 << 20)
+parser.add_argument('--request_size', type=int, default=64)
+parser.add_argument('--concurrency', type=int, default=16)
+parser.add_argument('--duration', type=float, default=10)
+parser.add_argument('--connects', type=int, default=200)
+parser.add_argument('--output')
+parser.add_argument('--baseline')
+parser.add_argument('--tolerance', type=float, default=0.1)
+# Internal: runs one load test against a listener and prints its result.
+parser.add_argument('--load', help=argparse.SUPPRESS)
+argv = parser.parse_args()
+
+NETNS = 'naive-bench'
+SERVER_VETH = 'nbench0'
+CLIENT_VETH = 'nbench1'
+SERVER_NETNS_IP = '10.201.0.1'
+CLIENT_NETNS_IP = '10.201.0.2'
+HOSTNAME = 'bench.test'
+AUTH = 'bench:bench'
+
+# Sink commands: one byte and a 64-bit length.
+SINK_GET = b'G'
+SINK_PUT = b'P'
+SINK_HEADER = struct.Struct('!cQ')
+CHUNK = bytes(1 << 16)
+
+
+def recv_exact(sock, size):
+    buf = bytearray(size)
+    view = memoryview(buf)
+    while view:
+        n = sock.recv_into(view)
+        if n == 0:
+            raise ConnectionError('unexpected EOF')
+        view = view[n:]
+    return bytes(buf)
+
+
+def drain(sock, size):
+    buf = bytearray(1 << 16)
+    while size > 0:
+        n = sock.recv_into(buf, min(size, len(buf)))
+        if n == 0:
+            raise ConnectionError('unexpected EOF')
+        size -= n
+
+
+def send_zeros(sock, size):
+    while size > 0:
+        n = min(size, len(CHUNK))
+        sock.sendall(CHUNK[:n])
+        size -= n
+
+
+# Load generator, run as a subprocess so it has its own interpreter lock
+# and can be placed in the client network namespace.
+
+def open_tunnel(listener, proxy, target):
+    sock = socket.create_connection(target if listener == 'redir' else proxy)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    host, port = target
+    if listener == 'socks':
+        sock.sendall(b'\x05\x01\x00')
+        if recv_exact(sock, 2) != b'\x05\x00':
+            raise ConnectionError('socks greeting rejected')
+        sock.sendall(b'\x05\x01\x00\x01' + socket.inet_aton(host) +
+                     struct.pack('!H', port))
+        reply = recv_exact(sock, 4)
+        if reply[1] != 0:
+            raise ConnectionError(f'socks reply {reply[1]}')
+        if reply[3] == 1:
+            recv_exact(sock, 4 + 2)
+        elif reply[3] == 4:
+            recv_exact(sock, 16 + 2)
+        else:
+            recv_exact(sock, recv_exact(sock, 1)[0] + 2)
+    elif listener == 'http':
+        sock.sendall(f'CONNECT {host}:{port} HTTP/1.1\r\n'
+                     f'Host: {host}:{port}\r\n\r\n'.encode())
+        response = b''
+        while not response.endswith(b'\r\n\r\n'):
+            response += recv_exact(sock, 1)
+        if b' 200 ' not in response.split(b'\r\n', 1)[0]:
+            raise ConnectionError(response.split(b'\r\n', 1)[0].decode())
+    return sock
+
+
+def request(sock, size):
+    sock.sendall(SINK_HEADER.pack(SINK_GET, size))
+    drain(sock, size)
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return None
+    i = min(len(sorted_values) - 1, int(len(sorted_values) * p / 100))
+    return round(sorted_values[i], 3)
+
+
+def load_bulk(listener, proxy, target, spec):
+    sock = open_tunnel(listener, proxy, target)
+    request(sock, 1)
+    start = time.monotonic()
+    sock.sendall(SINK_HEADER.pack(SINK_GET, spec['size']))
+    drain(sock, spec['size'])
+    download = time.monotonic() - start
+    start = time.monotonic()
+    sock.sendall(SINK_HEADER.pack(SINK_PUT, spec['size']))
+    send_zeros(sock, spec['size'])
+    recv_exact(sock, 1)
+    upload = time.monotonic() - start
+    sock.close()
+    return {
+        'download_mbps': round(spec['size'] * 8 / download / 1e6, 1),
+        'upload_mbps': round(spec['size'] * 8 / upload / 1e6, 1),
+        'bytes': spec['size'] * 2,
+    }
+
+
+def load_rps(listener, proxy, target, spec):
+    counts = []
+    errors = []
+    deadline = time.monotonic() + spec['duration']
+
+    def run():
+        count = 0
+        try:
+            sock = open_tunnel(listener, proxy, target)
+            while time.monotonic() < deadline:
+                request(sock, spec['size'])
+                count += 1
+            sock.close()
+        except OSError as e:
+            errors.append(str(e))
+        counts.append(count)
+
+    threads = [threading.Thread(target=run)
+               for _ in range(spec['concurrency'])]
+    start = time.monotonic()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.monotonic() - start
+    return {'rps': round(sum(counts) / elapsed, 1), 'errors': len(errors)}
+
+
+def load_connect(listener, proxy, target, spec):
+    # Time to the first byte of a response through a new tunnel, which
+    # includes the tunnel setup however the listener acknowledges it.
+    latencies = []
+    errors = 0
+    for _ in range(spec['connects']):
+        start = time.monotonic()
+        try:
+            sock = open_tunnel(listener, proxy, target)
+            request(sock, 1)
+            latencies.append((time.monotonic() - start) * 1000)
+            sock.close()
+        except OSError:
+            errors += 1
+    latencies.sort()
+    return {
+        'connect_ms': {
+            'p50': percentile(latencies, 50),
+            'p90': percentile(latencies, 90),
+            'p99': percentile(latencies, 99),
+            'max': percentile(latencies, 100),
+        },
+        'errors': errors,
+    }
+
+
+if argv.load:
+    spec = json.loads(argv.load)
+    load = {'bulk': load_bulk, 'rps': load_rps, 'connect': load_connect}
+    print(json.dumps(load[spec['test']](spec['listener'], tuple(spec['proxy']),
+                                        tuple(spec['target']), spec)))
+    sys.exit(0)
+
+if not argv.naive:
+    parser.error('--naive is required')
+
+
+# Orchestration.
+
+def run(cmdline, check=True):
+    print('subprocess.run', ' '.join(cmdline))
+    subprocess.run(cmdline, check=check)
+
+
+def in_client_netns(cmdline):
+    if argv.netns:
+        return ['ip', 'netns', 'exec', NETNS] + cmdline
+    return cmdline
+
+
+cleanups = []
+
+
+@atexit.register
+def cleanup():
+    while cleanups:
+        cleanups.pop()()
+
+
+def setup_network():
+    if not argv.netns:
+        if argv.netem:
+            run(['tc', 'qdisc', 'add', 'dev', 'lo', 'root', 'netem'] +
+                argv.netem.split())
+            cleanups.append(lambda: run(
+                ['tc', 'qdisc', 'del', 'dev', 'lo', 'root'], check=False))
+        return '127.0.0.1', '127.0.0.1'
+
+    run(['ip', 'netns', 'add', NETNS])
+    cleanups.append(lambda: run(['ip', 'netns', 'del', NETNS], check=False))
+    run(['ip', 'link', 'add', SERVER_VETH, 'type', 'veth', 'peer', 'name',
+         CLIENT_VETH, 'netns', NETNS])
+    cleanups.append(lambda: run(['ip', 'link', 'del', SERVER_VETH],
+                                check=False))
+    run(['ip', 'addr', 'add', f'{SERVER_NETNS_IP}/24', 'dev', SERVER_VETH])
+    run(['ip', 'link', 'set', SERVER_VETH, 'up'])
+    run(in_client_netns(['ip', 'addr', 'add', f'{CLIENT_NETNS_IP}/24', 'dev',
+                         CLIENT_VETH]))
+    run(in_client_netns(['ip', 'link', 'set', CLIENT_VETH, 'up']))
+    run(in_client_netns(['ip', 'link', 'set', 'lo', 'up']))
+    if argv.netem:
+        # Half of the delay each way would need the netem values split, so
+        # both directions get the given parameters.
+        run(['tc', 'qdisc', 'add', 'dev', SERVER_VETH, 'root', 'netem'] +
+            argv.netem.split())
+        run(in_client_netns(['tc', 'qdisc', 'add', 'dev', CLIENT_VETH, 'root',
+                             'netem'] + argv.netem.split()))
+    return SERVER_NETNS_IP, '127.0.0.1'
+
+
+class SinkHandler(socketserver.BaseRequestHandler):
+    def handle(self):
+        sock = self.request
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        try:
+            while True:
+                command, size = SINK_HEADER.unpack(
+                    recv_exact(sock, SINK_HEADER.size))
+                if command == SINK_GET:
+                    send_zeros(sock, size)
+                elif command == SINK_PUT:
+                    drain(sock, size)
+                    sock.sendall(b'\x00')
+                else:
+                    return
+        except OSError:
+            pass
+
+
+class SinkServer(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+    request_queue_size = 1024
+
+
+def allocate_port(host, kind=socket.SOCK_STREAM):
+    with socket.socket(socket.AF_INET, kind) as s:
+        s.bind((host, 0))
+        return s.getsockname()[1]
+
+
+def cpu_seconds(pid):
+    with open(f'/proc/{pid}/stat') as f:
+        fields = f.read().rsplit(')', 1)[1].split()
+    # utime and stime, the 14th and 15th fields.
+    return (int(fields[11]) + int(fields[12])) / os.sysconf('SC_CLK_TCK')
+
+
+def drain_stderr(proc):
+    for line in proc.stderr:
+        pass
+
+
+def start_naive(naive_args, env=None, netns=False):
+    cmdline = [argv.naive] + naive_args
+    if netns:
+        cmdline = in_client_netns(cmdline)
+    proc = subprocess.Popen(cmdline, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE, text=True,
+                            encoding='utf-8', env=env)
+    print('subprocess.Popen', ' '.join(cmdline), 'pid:', proc.pid)
+    cleanups.append(lambda: proc.terminate())
+
+    timeout = threading.Timer(10, lambda: proc.terminate())
+    timeout.start()
+    while True:
+        line = proc.stderr.readline()
+        if not line:
+            timeout.cancel()
+            sys.exit(f'naive pid {proc.pid} exited')
+        print(line.strip())
+        if 'Listening on ' in line:
+            timeout.cancel()
+            break
+    # Keeps the pipe from filling up and blocking naive.
+    threading.Thread(target=drain_stderr, args=(proc,), daemon=True).start()
+    return proc
+
+
+def wait_for_port(host, port):
+    deadline = time.monotonic() + 10
+    while time.monotonic() < deadline:
+        try:
+            socket.create_connection((host, port), timeout=1).close()
+            return
+        except OSError:
+            time.sleep(0.1)
+    sys.exit(f'{host}:{port} not up')
+
+
+def start_caddy(workdir, server_ip, port, certfile):
+    caddyfile = os.path.join(workdir, 'Caddyfile')
+    user, password = AUTH.split(':')
+    with open(caddyfile, 'w') as f:
+        f.write(f'''{{
+  admin off
+  auto_https disable_redirects
+  order forward_proxy before file_server
+}}
+https://{HOSTNAME}:{port} {{
+  bind {server_ip}
+  tls {certfile} {certfile}
+  forward_proxy {{
+    basic_auth {user} {password}
+    hide_ip
+    hide_via
+    acl {{
+      allow all
+    }}
+  }}
+}}
+''')
+    cmdline = [argv.caddy, 'run', '--config', caddyfile, '--adapter',
+               'caddyfile']
+    proc = subprocess.Popen(cmdline, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.DEVNULL)
+    print('subprocess.Popen', ' '.join(cmdline), 'pid:', proc.pid)
+    cleanups.append(lambda: proc.terminate())
+    wait_for_port(server_ip, port)
+    return proc
+
+
+def make_client_home(workdir, certfile):
+    # Chromium on Linux takes extra trust anchors from the NSS database in
+    # $HOME.
+    home = os.path.join(workdir, 'home')
+    nssdb = os.path.join(home, '.pki', 'nssdb')
+    os.makedirs(nssdb)
+    run(['certutil', '-d', f'sql:{nssdb}', '-N', '--empty-password'])
+    run(['certutil', '-d', f'sql:{nssdb}', '-A', '-t', 'C,,', '-n', HOSTNAME,
+         '-i', certfile])
+    return home
+
+
+def run_load(spec):
+    cmdline = in_client_netns([sys.executable, os.path.abspath(__file__),
+                               '--load', json.dumps(spec)])
+    print('subprocess.run', spec['test'], spec['listener'])
+    result = subprocess.run(cmdline, capture_output=True, text=True,
+                            timeout=600)
+    if result.returncode != 0:
+        print(result.stderr, end='')
+        return None
+    return json.loads(result.stdout)
+
+
+def bench_one(listener, chain, client_ip, server_ip, sink_port, server_proc,
+              client_env, proxy_url):
+    listen_port = allocate_port('127.0.0.1')
+    client_args = ['--log', f'--listen={listener}://{client_ip}:{listen_port}',
+                   f'--proxy={proxy_url}']
+    if chain != 'http':
+        client_args.append(
+            f'--host-resolver-rules=MAP {HOSTNAME} {server_ip}')
+    client_proc = start_naive(client_args, env=client_env, netns=argv.netns)
+    if listener == 'redir':
+        rule = ['-p', 'tcp', '-d', server_ip, '--dport', str(sink_port), '-j',
+                'REDIRECT', '--to-ports', str(listen_port)]
+        run(in_client_netns(['iptables', '-t', 'nat', '-A', 'OUTPUT'] + rule))
+    base = {
+        'listener': listener,
+        'proxy': [client_ip, listen_port],
+        'target': [server_ip, sink_port],
+    }
+
+    result = {'listener': listener, 'chain': chain}
+    # The first tunnel sets up the session.
+    run_load(dict(base, test='connect', connects=1))
+
+    cpu_before = (cpu_seconds(client_proc.pid), cpu_seconds(server_proc.pid))
+    bulk = run_load(dict(base, test='bulk', size=argv.bulk_size))
+    cpu_after = (cpu_seconds(client_proc.pid), cpu_seconds(server_proc.pid))
+    if bulk:
+        result['download_mbps'] = bulk['download_mbps']
+        result['upload_mbps'] = bulk['upload_mbps']
+        result['client_cpu_ns_per_byte'] = round(
+            (cpu_after[0] - cpu_before[0]) * 1e9 / bulk['bytes'], 2)
+        result['server_cpu_ns_per_byte'] = round(
+            (cpu_after[1] - cpu_before[1]) * 1e9 / bulk['bytes'], 2)
+    rps = run_load(dict(base, test='rps', size=argv.request_size,
+                        concurrency=argv.concurrency, duration=argv.duration))
+    if rps:
+        result['rps'] = rps['rps']
+        result['rps_errors'] = rps['errors']
+    connect = run_load(dict(base, test='connect', connects=argv.connects))
+    if connect:
+        result['connect_ms'] = connect['connect_ms']
+        result['connect_errors'] = connect['errors']
+
+    if listener == 'redir':
+        run(in_client_netns(['iptables', '-t', 'nat', '-D', 'OUTPUT'] + rule),
+            check=False)
+    client_proc.terminate()
+    client_proc.wait()
+    print('** RESULT:', json.dumps(result), end='\n\n')
+    return result
+
+
+# Higher is better for these, and lower for the rest.
+HIGHER_BETTER = {'download_mbps', 'upload_mbps', 'rps'}
+COMPARED = ['download_mbps', 'upload_mbps', 'rps', 'connect_ms.p50',
+            'connect_ms.p99', 'client_cpu_ns_per_byte',
+            'server_cpu_ns_per_byte']
+
+
+def lookup(result, key):
+    for part in key.split('.'):
+        if not isinstance(result, dict) or part not in result:
+            return None
+        result = result[part]
+    return result
+
+
+def compare(results, baseline):
+    regressions = []
+    previous = {(r['listener'], r['chain']): r for r in baseline['results']}
+    for result in results:
+        old = previous.get((result['listener'], result['chain']))
+        if not old:
+            continue
+        for key in COMPARED:
+            new_value, old_value = lookup(result, key), lookup(old, key)
+            if not new_value or not old_value:
+                continue
+            if key in HIGHER_BETTER:
+                worse = new_value < old_value * (1 - argv.tolerance)
+            else:
+                worse = new_value > old_value * (1 + argv.tolerance)
+            if worse:
+                regressions.append(f'{result["listener"]} over '
+                                   f'{result["chain"]}: {key} {old_value} -> '
+                                   f'{new_value}')
+    return regressions
+
+
+def main():
+    listeners = argv.listeners.split(',')
+    chains = argv.chains.split(',')
+    if 'redir' in listeners and not argv.netns:
+        # Redirecting the sink port on loopback would catch the server's own
+        # connections to it too.
+        print('redir needs --netns, skipped')
+        listeners.remove('redir')
+    if not argv.caddy:
+        for chain in ('https', 'quic'):
+            if chain in chains:
+                print(f'{chain} needs --caddy, skipped')
+                chains.remove(chain)
+
+    workdir = tempfile.mkdtemp()
+    cleanups.append(lambda: shutil.rmtree(workdir, ignore_errors=True))
+    server_ip, client_ip = setup_network()
+
+    sink = SinkServer((server_ip, 0), SinkHandler)
+    threading.Thread(target=sink.serve_forever, daemon=True).start()
+    sink_port = sink.server_address[1]
+
+    client_env = None
+    certfile = os.path.join(workdir, 'cert.pem')
+    if 'https' in chains or 'quic' in chains:
+        run(['openssl', 'req', '-new', '-x509', '-keyout', certfile, '-out',
+             certfile, '-days', '1', '-nodes', '-subj', f'/CN={HOSTNAME}',
+             '-addext', f'subjectAltName=DNS:{HOSTNAME}'])
+        client_env = dict(os.environ, HOME=make_client_home(workdir, certfile))
+
+    results = []
+    for chain in chains:
+        if chain == 'http':
+            server_port = allocate_port(server_ip)
+            server_proc = start_naive(
+                ['--log', f'--listen=http://{AUTH}@{server_ip}:{server_port}'])
+            proxy_url = f'http://{AUTH}@{server_ip}:{server_port}'
+        else:
+            server_port = allocate_port(server_ip)
+            server_proc = start_caddy(workdir, server_ip, server_port, certfile)
+            proxy_url = f'{chain}://{AUTH}@{HOSTNAME}:{server_port}'
+        for listener in listeners:
+            results.append(bench_one(listener, chain, client_ip, server_ip,
+                                     sink_port, server_proc, client_env,
+                                     proxy_url))
+        server_proc.terminate()
+        server_proc.wait()
+
+    report = {
+        'time': time.strftime('%Y-%m-%dT%H:%M:%SZ', time.gmtime()),
+        'netns': argv.netns,
+        'netem': argv.netem,
+        'bulk_size': argv.bulk_size,
+        'request_size': argv.request_size,
+        'concurrency': argv.concurrency,
+        'results': results,
+    }
+    if argv.output:
+        with open(argv.output, 'w') as f:
+            json.dump(report, f, indent=2)
+    else:
+        print(json.dumps(report, indent=2))
+
+    if argv.baseline:
+        with open(argv.baseline) as f:
+            regressions = compare(results, json.load(f))
+        for regression in regressions:
+            print('** REGRESSION:', regression)
+        if regressions:
+            sys.exit(1)
+
+
+main()
@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+'''
+Replays traces printed by parse-pcap-stream.py through a socks listener of
+naive to a sink run by this script, and reports the throughput, the latency
+added to each write of the trace, and the padding overhead.
+
+Each trace line is a write at a time in units of half the RTT of the
+capture, of a size in bytes, positive from the client and negative from
+the server. The client side of each tunnel makes the client writes at their
+times, and the sink makes the server writes at theirs, counted from when
+the tunnel is connected. The latency of a write is from when it was made to
+when its last byte was read at the other end, both ends being in this
+process. Run it with --direct for the latency without naive.
+'''
+import argparse
+import asyncio
+import collections
+import struct
+import sys
+import time
+import urllib.request
+
+UP = 0
+DOWN = 1
+DIRECTION_NAMES = ('up', 'down')
+HEADER = struct.Struct('!I')
+READ_SIZE = 64 * 1024
+
+
+def parse_address(value):
+    host, _, port = value.rpartition(':')
+    if not host or not port.isdigit():
+        raise argparse.ArgumentTypeError(f'Invalid address: {value}')
+    return host.strip('[]'), int(port)
+
+
+def parse_trace(path):
+    writes = ([], [])
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if not fields or fields[0].startswith('#'):
+                continue
+            timestamp = float(fields[0])
+            size = int(fields[1])
+            if size > 0:
+                writes[UP].append((timestamp, size))
+            elif size < 0:
+                writes[DOWN].append((timestamp, -size))
+    return writes
+
+
+class Tunnel:
+    def __init__(self, trace, writes):
+        self.trace = trace
+        self.writes = writes
+        self.totals = tuple(sum(size for _, size in w) for w in writes)
+        self.start = None
+        # Per direction, the end offset and time of each write not yet read
+        # in full at the other end.
+        self.pending = (collections.deque(), collections.deque())
+        self.latencies = ([], [])
+
+
+async def send(writer, tunnel, direction, time_unit):
+    offset = 0
+    for timestamp, size in tunnel.writes[direction]:
+        delay = tunnel.start + timestamp * time_unit - time.monotonic()
+        if delay > 0:
+            await asyncio.sleep(delay)
+        offset += size
+        tunnel.pending[direction].append((offset, time.monotonic()))
+        writer.write(bytes(size))
+        await writer.drain()
+
+
+async def receive(reader, tunnel, direction):
+    received = 0
+    pending = tunnel.pending[direction]
+    while received < tunnel.totals[direction]:
+        data = await reader.read(READ_SIZE)
+        if not data:
+            raise ConnectionError(
+                f'{tunnel.trace}: closed after {received} bytes '
+                f'{DIRECTION_NAMES[direction]}')
+        received += len(data)
+        now = time.monotonic()
+        while pending and pending[0][0] <= received:
+            tunnel.latencies[direction].append(now - pending.popleft()[1])
+
+
+async def socks5_connect(reader, writer, host, port):
+    writer.write(b'\x05\x01\x00')
+    if await reader.readexactly(2) != b'\x05\x00':
+        raise ConnectionError('SOCKS5 greeting refused')
+    name = host.encode()
+    writer.write(b'\x05\x01\x00\x03' + bytes([len(name)]) + name +
+                 struct.pack('!H', port))
+    reply = await reader.readexactly(4)
+    if reply[1] != 0:
+        raise ConnectionError(f'SOCKS5 connect failed: {reply[1]}')
+    if reply[3] == 1:
+        await reader.readexactly(4 + 2)
+    elif reply[3] == 4:
+        await reader.readexactly(16 + 2)
+    else:
+        await reader.readexactly((await reader.readexactly(1))[0] + 2)
+
+
+async def run_client(tunnel, index, args):
+    if args.direct:
+        reader, writer = await asyncio.open_connection(*args.sink_connect)
+    else:
+        reader, writer = await asyncio.open_connection(*args.socks)
+        await socks5_connect(reader, writer, *args.sink_connect)
+    tunnel.start = time.monotonic()
+    writer.write(HEADER.pack(index))
+    await asyncio.gather(send(writer, tunnel, UP, args.time_unit),
+                         receive(reader, tunnel, DOWN))
+    writer.close()
+
+
+def make_sink_handler(tunnels, args):
+    async def handle(reader, writer):
+        try:
+            index, = HEADER.unpack(await reader.readexactly(HEADER.size))
+            tunnel = tunnels[index]
+            await asyncio.gather(send(writer, tunnel, DOWN, args.time_unit),
+                                 receive(reader, tunnel, UP))
+        finally:
+            writer.close()
+    return handle
+
+
+def read_padding_bytes(url):
+    with urllib.request.urlopen(url) as response:
+        text = response.read().decode()
+    total = 0
+    for line in text.splitlines():
+        if line.startswith('naive_padding_bytes_total'):
+            total += int(float(line.split()[-1]))
+    return total
+
+
+def percentile(values, fraction):
+    return values[min(len(values) - 1, int(len(values) * fraction))]
+
+
+def print_latencies(name, latencies):
+    if not latencies:
+        return
+    latencies = sorted(latencies)
+    print('  %s: writes=%d mean=%.2f p50=%.2f p99=%.2f max=%.2f ms' % (
+        name, len(latencies), 1000 * sum(latencies) / len(latencies),
+        1000 * percentile(latencies, 0.5), 1000 * percentile(latencies, 0.99),
+        1000 * latencies[-1]))
+
+
+async def replay(args):
+    tunnels = []
+    for path in args.traces:
+        writes = parse_trace(path)
+        for _ in range(args.tunnels):
+            tunnels.append(Tunnel(path, writes))
+
+    server = await asyncio.start_server(make_sink_handler(tunnels, args),
+                                        *args.sink_listen)
+    if args.sink_connect is None:
+        args.sink_connect = server.sockets[0].getsockname()[:2]
+
+    padding_before = read_padding_bytes(args.metrics) if args.metrics else 0
+    start = time.monotonic()
+    await asyncio.gather(*(run_client(tunnel, index, args)
+                           for index, tunnel in enumerate(tunnels)))
+    elapsed = time.monotonic() - start
+    server.close()
+    await server.wait_closed()
+
+    payload = 0
+    for path in dict.fromkeys(args.traces):
+        trace_tunnels = [t for t in tunnels if t.trace == path]
+        totals = [sum(t.totals[d] for t in trace_tunnels) for d in (UP, DOWN)]
+        payload += sum(totals)
+        print(f'{path}: tunnels={len(trace_tunnels)} bytes_up={totals[UP]} '
+              f'bytes_down={totals[DOWN]}')
+        for direction in (UP, DOWN):
+            print_latencies(DIRECTION_NAMES[direction],
+                            [latency for t in trace_tunnels
+                             for latency in t.latencies[direction]])
+    print('Total: bytes=%d elapsed=%.2f s throughput=%.2f Mbit/s' % (
+        payload, elapsed, payload * 8 / elapsed / 1e6))
+    if args.metrics:
+        padding = read_padding_bytes(args.metrics) - padding_before
+        print('Padding: bytes=%d overhead=%.2f%%' % (
+            padding, 100 * padding / payload if payload else 0))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Replays parse-pcap-stream.py traces through naive.')
+    parser.add_argument('traces', metavar='TRACE', nargs='+',
+                        help='output of parse-pcap-stream.py')
+    parser.add_argument('--socks', type=parse_address,
+                        default=('127.0.0.1', 1080),
+                        help='socks listener of naive (default: '
+                        '127.0.0.1:1080)')
+    parser.add_argument('--direct', action='store_true',
+                        help='connect to the sink without naive, for a '
+                        'baseline')
+    parser.add_argument('--sink-listen', type=parse_address,
+                        default=('127.0.0.1', 0),
+                        help='address the sink listens on (default: '
+                        '127.0.0.1 with any port)')
+    parser.add_argument('--sink-connect', type=parse_address,
+                        help='address of the sink as the proxy reaches it '
+                        '(default: the listen address)')
+    parser.add_argument('--tunnels', type=int, default=1,
+                        help='concurrent replays of each trace (default: 1)')
+    parser.add_argument('--time-unit-ms', type=float, default=10,
+                        help='milliseconds per time unit of the traces, half '
+                        'the RTT of the capture; 0 writes as fast as '
+                        'possible (default: 10)')
+    parser.add_argument('--metrics', metavar='URL',
+                        help='metrics of naive, e.g. '
+                        'http://127.0.0.1:9090/metrics, to report the padding '
+                        'overhead')
+    args = parser.parse_args()
+    if args.tunnels < 1:
+        parser.error('--tunnels must be positive')
+    args.time_unit = args.time_unit_ms / 1000
+
+    try:
+        asyncio.run(replay(args))
+    except (OSError, asyncio.IncompleteReadError) as e:
+        print(f'Replay failed: {e}', file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()